@@ -0,0 +1,103 @@
+# Lean AXI-Lite address path in place of a SmartConnect
+#
+# replace_smartconnect <smc> <name> swaps the SmartConnect <smc> of the open
+# block design for an AXI Interconnect <name> with the same masters, slaves,
+# clock, reset and address map, configured for the lowest latency of single
+# register accesses:
+#   - shared-address, shared-data crossbar (STRATEGY 1): one arbitration
+#     stage, no per-slave write/read channels, the minimum for AXI-Lite
+#     slaves that take one transaction at a time anyway
+#   - no register slices and no data FIFOs on any port
+#   - the AXI4 -> AXI4-Lite conversion per PS master done once, in the
+#     coupler, instead of SmartConnect's switchboard and its own slices
+# With one master and one slave it is a protocol converter only. Both
+# designs run the interconnect on the clock of its masters, so no clock
+# converter is inserted either.
+#
+# Sourced by the axi_xbar_bd.tcl variant scripts of gpio_led/PL and
+# myhdl/PL/interrupt_demo; their READMEs describe measuring the difference.
+
+proc xbar_peer {pin} {
+    # The interface pin at the other end of the net on pin
+    set net [get_bd_intf_nets -of_objects $pin]
+    foreach p [get_bd_intf_pins -of_objects $net] {
+        if {$p ne $pin} {
+            return $p
+        }
+    }
+    error "axi_xbar: $pin is not connected"
+}
+
+proc xbar_driver {pin} {
+    # The output pin driving the net on pin
+    set net [get_bd_nets -of_objects $pin]
+    return [get_bd_pins -of_objects $net -filter {DIR == O}]
+}
+
+proc replace_smartconnect {smc name} {
+    set cell [get_bd_cells $smc]
+    if {$cell eq ""} {
+        error "axi_xbar: no cell $smc in the block design"
+    }
+    set num_si [get_property CONFIG.NUM_SI $cell]
+    set num_mi [get_property CONFIG.NUM_MI $cell]
+
+    set masters {}
+    for {set i 0} {$i < $num_si} {incr i} {
+        lappend masters [xbar_peer [get_bd_intf_pins [format "%s/S%02d_AXI" $smc $i]]]
+    }
+    set slaves {}
+    for {set i 0} {$i < $num_mi} {incr i} {
+        lappend slaves [xbar_peer [get_bd_intf_pins [format "%s/M%02d_AXI" $smc $i]]]
+    }
+    set clk [xbar_driver [get_bd_pins $smc/aclk]]
+    set rstn [xbar_driver [get_bd_pins $smc/aresetn]]
+
+    # Address map of the masters, assigned again once the path is back
+    set segs {}
+    foreach space [get_bd_addr_spaces -of_objects [get_bd_intf_pins $masters]] {
+        foreach seg [get_bd_addr_segs -quiet -of_objects $space] {
+            lappend segs [list $space [get_bd_addr_segs -of_objects $seg] \
+                              [get_property OFFSET $seg] [get_property RANGE $seg]]
+        }
+    }
+    delete_bd_objs [get_bd_addr_segs -quiet -of_objects [get_bd_addr_spaces -of_objects \
+                        [get_bd_intf_pins $masters]]]
+    delete_bd_objs [get_bd_intf_nets -of_objects [get_bd_intf_pins -of_objects $cell]] \
+        [get_bd_nets -of_objects [get_bd_pins -of_objects $cell]] $cell
+
+    set ic [create_bd_cell -type ip -vlnv xilinx.com:ip:axi_interconnect:2.1 $name]
+    set props [list CONFIG.NUM_SI $num_si CONFIG.NUM_MI $num_mi CONFIG.STRATEGY {1}]
+    for {set i 0} {$i < $num_si} {incr i} {
+        lappend props [format "CONFIG.S%02d_HAS_REGSLICE" $i] {0} \
+                      [format "CONFIG.S%02d_HAS_DATA_FIFO" $i] {0}
+    }
+    for {set i 0} {$i < $num_mi} {incr i} {
+        lappend props [format "CONFIG.M%02d_HAS_REGSLICE" $i] {0} \
+                      [format "CONFIG.M%02d_HAS_DATA_FIFO" $i] {0}
+    }
+    set_property -dict $props $ic
+
+    set i 0
+    foreach m $masters {
+        connect_bd_intf_net $m [get_bd_intf_pins [format "%s/S%02d_AXI" $name $i]]
+        connect_bd_net $clk [get_bd_pins [format "%s/S%02d_ACLK" $name $i]]
+        connect_bd_net $rstn [get_bd_pins [format "%s/S%02d_ARESETN" $name $i]]
+        incr i
+    }
+    set i 0
+    foreach s $slaves {
+        connect_bd_intf_net [get_bd_intf_pins [format "%s/M%02d_AXI" $name $i]] $s
+        connect_bd_net $clk [get_bd_pins [format "%s/M%02d_ACLK" $name $i]]
+        connect_bd_net $rstn [get_bd_pins [format "%s/M%02d_ARESETN" $name $i]]
+        incr i
+    }
+    connect_bd_net $clk [get_bd_pins $name/ACLK]
+    connect_bd_net $rstn [get_bd_pins $name/ARESETN]
+
+    foreach s $segs {
+        lassign $s space slave offset range
+        assign_bd_address -offset $offset -range $range -target_address_space $space $slave
+    }
+    return $ic
+}
@@ -0,0 +1,48 @@
+# Block design variants on a copy of the project
+#
+# The variant scripts (the *_bd.tcl of gpio_led/PL and myhdl/PL/interrupt_demo)
+# never touch the tracked project. open_bd_variant <project_file> <bd> opens
+# the copy of the project in the variant directory, creating it from
+# <project_file> the first time (save_project_as, without run results), and
+# opens the block design <bd> in it; variants run one after another add up in
+# the same copy. save_bd_variant validates and saves the block design.
+#
+# The variant directory is $env(PL_VARIANT_DIR), which the CMake targets set
+# to <build dir>/variant, or build/variant next to the project directory when
+# a script is run by hand. Remove it to start again from the default design.
+
+proc bd_variant_dir {project_file} {
+    if {[info exists ::env(PL_VARIANT_DIR)] && $::env(PL_VARIANT_DIR) ne ""} {
+        return [file normalize $::env(PL_VARIANT_DIR)]
+    }
+    return [file normalize [file join [file dirname $project_file] .. build variant]]
+}
+
+proc open_bd_variant {project_file bd} {
+    set name [file rootname [file tail $project_file]]
+    set variant_dir [file join [bd_variant_dir $project_file] $name]
+    set variant_file [file join $variant_dir $name.xpr]
+
+    set current [current_project -quiet]
+    if {$current ne "" &&
+        [file normalize [get_property DIRECTORY $current]] ne $variant_dir} {
+        close_project
+        set current ""
+    }
+    if {$current eq ""} {
+        if {[file exists $variant_file]} {
+            open_project $variant_file
+        } else {
+            open_project $project_file
+            save_project_as -exclude_run_results $name $variant_dir
+            puts "bd_variant: copied [file tail $project_file] to $variant_dir"
+        }
+    }
+    open_bd_design [get_files $bd]
+    return $variant_file
+}
+
+proc save_bd_variant {} {
+    validate_bd_design
+    save_bd_design
+}
@@ -0,0 +1,185 @@
+#
+# FILE:
+#   kr260_overlay.py
+#
+# DESCRIPTION:
+#   Overlay() for the notebooks without the .hwh parse and, when the PL
+#   already runs the bitstream, without programming it again. Goes next to
+#   the notebook, with <name>.ovl.json (overlay_meta.py) next to the .bit:
+#
+#     import kr260_overlay
+#     overlay = kr260_overlay.load("gpio_led.bit")
+#     overlay.axi_gpio_0.channel1.write(0x3, 0x3)
+#
+#   load() takes the fast path when the .ovl.json matches the .bit and .hwh
+#   (size and .hwh SHA-1) and the record fw_loader keeps of the loaded
+#   bitstream (/run/fw_loader/pl) carries one of its fingerprints while the
+#   FPGA manager reports the PL operating: the description is read from the
+#   JSON, handed to PYNQ's device state (ip_dict, interrupt pins, so
+#   pynq.Interrupt works) and the IP are bound to PYNQ's drivers on first
+#   use. Otherwise, or with download=True, it is pynq.Overlay() as before,
+#   and the bitstream it programmed is recorded for fw_loader and the next
+#   load(). Either way load_ms tells how long it took.
+#
+#   The fast path binds top-level IP only (overlay.<instance>, as in both
+#   designs here); hierarchies come as ip_dict entries with a "/" in the name.
+#
+
+import json
+import os
+import time
+
+FINGERPRINT_PL = "/run/fw_loader/pl"
+FPGA_STATE = "/sys/class/fpga_manager/fpga0/state"
+FIRMWARE_DIR = "/lib/firmware"
+FORMAT = 1
+
+
+def _read(path):
+    try:
+        with open(path) as f:
+            return f.read().strip()
+    except OSError:
+        return ""
+
+
+def _locate(bitfile):
+    # As PYNQ: the path as given, else the firmware directory
+    if os.path.isfile(bitfile):
+        return os.path.abspath(bitfile)
+    path = os.path.join(FIRMWARE_DIR, os.path.basename(bitfile))
+    if os.path.isfile(path):
+        return path
+    raise IOError("Bitstream %s not found" % bitfile)
+
+
+def metadata(bitfile):
+    """The .ovl.json of bitfile if it describes this .bit and .hwh, else None"""
+    import hashlib
+
+    stem = os.path.splitext(bitfile)[0]
+    try:
+        with open(stem + ".ovl.json") as f:
+            meta = json.load(f)
+        with open(stem + ".hwh", "rb") as f:
+            hwh_sha1 = hashlib.sha1(f.read()).hexdigest()
+    except (OSError, ValueError):
+        return None
+    if meta.get("format") != FORMAT or meta.get("hwh_sha1") != hwh_sha1 or \
+            meta.get("bitstream_size") != os.path.getsize(bitfile):
+        return None
+    return meta
+
+
+def pl_loaded(meta):
+    """The PL runs the bitstream of meta, as fw_loader recorded it"""
+    record = _read(FINGERPRINT_PL).split()
+    return _read(FPGA_STATE) == "operating" and bool(record) and \
+        record[-1] in meta["fingerprints"]
+
+
+def _record(bitfile, meta):
+    # What fw_loader writes after a full load of the .bit (fw_loader.cpp
+    # save_fingerprint); the next load() and fw_loader both skip the PL then
+    try:
+        os.makedirs(os.path.dirname(FINGERPRINT_PL), exist_ok=True)
+        with open(FINGERPRINT_PL, "w") as f:
+            f.write("%s %s\n" % (os.path.basename(bitfile), meta["fingerprints"][0]))
+    except OSError:
+        pass
+
+
+def _int_keys(d):
+    return {int(k) if isinstance(k, str) and k.isdigit() else k: v for k, v in d.items()}
+
+
+class _Description:
+    """Parser-shaped view of the .ovl.json for pynq's Device.reset()"""
+
+    def __init__(self, meta, device):
+        self.ip_dict = meta["ip_dict"]
+        self.mem_dict = meta["mem_dict"]
+        self.gpio_dict = {}
+        self.interrupt_controllers = meta["interrupt_controllers"]
+        self.interrupt_pins = meta["interrupt_pins"]
+        self.hierarchy_dict = {}
+        self.clock_dict = _int_keys(meta["clock_dict"])
+        for entry in list(self.ip_dict.values()) + list(self.mem_dict.values()):
+            entry["device"] = device
+
+
+class CachedOverlay:
+    """The IP of a loaded bitstream, described by its .ovl.json"""
+
+    def __init__(self, bitfile, meta, device):
+        self.bitfile_name = bitfile
+        self.device = device
+        self.ip_dict = meta["ip_dict"]
+        self.mem_dict = meta["mem_dict"]
+        self.interrupt_controllers = meta["interrupt_controllers"]
+        self.interrupt_pins = meta["interrupt_pins"]
+        self.clock_dict = _int_keys(meta["clock_dict"])
+        self._drivers = {}
+        self.load_ms = 0.0
+
+    def __getattr__(self, name):
+        ip_dict = self.__dict__.get("ip_dict", {})
+        if name not in ip_dict:
+            raise AttributeError("Could not find IP or hierarchy %s in overlay" % name)
+        if name not in self._drivers:
+            from pynq.overlay import DefaultIP
+            import pynq.overlay
+
+            description = ip_dict[name]
+            drivers = getattr(pynq.overlay, "_ip_drivers", {})
+            driver = drivers.get(description["type"], DefaultIP)
+            self._drivers[name] = driver(description)
+        return self._drivers[name]
+
+    def __dir__(self):
+        return sorted(set(super().__dir__()) | set(self.ip_dict))
+
+    def is_loaded(self):
+        return True
+
+    def download(self):
+        """Program the bitstream again, the slow way"""
+        load(self.bitfile_name, download=True)
+
+
+def _set_clocks(clock_dict):
+    # What Overlay.download() does; the loader that programmed the PL may not
+    from pynq.ps import Clocks
+
+    for index, clk in clock_dict.items():
+        if clk["enable"]:
+            try:
+                setattr(Clocks, "fclk%d_mhz" % index, clk["frequency"])
+            except (AttributeError, ValueError):
+                pass
+
+
+def load(bitfile, download=None):
+    """Overlay of bitfile: from its .ovl.json when the PL already runs it
+    (download=None or False), else pynq.Overlay() (download=True forces it)"""
+    t0 = time.monotonic()
+    path = _locate(bitfile)
+    meta = metadata(path)
+
+    if meta is not None and download is not True and (download is False or pl_loaded(meta)):
+        from pynq.pl_server.device import Device
+
+        device = Device.active_device
+        description = _Description(meta, device)
+        stamp = time.strftime("%Y/%m/%d %H:%M:%S", time.localtime(os.path.getmtime(path)))
+        device.reset(description, stamp, path)
+        _set_clocks(description.clock_dict)
+        overlay = CachedOverlay(path, meta, device)
+    else:
+        from pynq import Overlay
+
+        overlay = Overlay(path)
+        if meta is not None:
+            _record(path, meta)
+    overlay.load_ms = (time.monotonic() - t0) * 1e3
+    return overlay
@@ -0,0 +1,38 @@
+# Pre-parsed overlay description (overlay_meta.py) for the PL CMake flows
+#
+# Included by gpio_led/PL/CMakeLists.txt after the output files are named
+# (BITSTREAM_FILE, HWH_FILE, OUTPUT_DIR): build_all writes <name>.ovl.json
+# next to the bitstream and HWH, and copies kr260_overlay.py, the notebook
+# helper that reads it, beside them. "make overlay_meta" redoes it for the
+# current outputs. Without Python 3 the notebooks fall back to Overlay().
+
+set(OVERLAY_META_DIR "${CMAKE_CURRENT_LIST_DIR}")
+set(OVERLAY_META_FILE "${OUTPUT_DIR}/${OUTPUT_BITSTREAM_NAME}.ovl.json")
+
+find_package(Python3 COMPONENTS Interpreter)
+
+if(Python3_Interpreter_FOUND)
+    set(OVERLAY_META_COMMAND
+        ${Python3_EXECUTABLE} ${OVERLAY_META_DIR}/overlay_meta.py ${BITSTREAM_FILE}
+            --hwh ${HWH_FILE} -o ${OVERLAY_META_FILE}
+    )
+    set(OVERLAY_HELPER_COMMAND
+        ${CMAKE_COMMAND} -E copy_if_different ${OVERLAY_META_DIR}/kr260_overlay.py ${OUTPUT_DIR}
+    )
+
+    add_custom_command(TARGET build_all POST_BUILD
+        COMMAND ${OVERLAY_META_COMMAND}
+        COMMAND ${OVERLAY_HELPER_COMMAND}
+        COMMENT "Writing the overlay description ${OUTPUT_BITSTREAM_NAME}.ovl.json"
+        VERBATIM
+    )
+
+    add_custom_target(overlay_meta
+        COMMAND ${OVERLAY_META_COMMAND}
+        COMMAND ${OVERLAY_HELPER_COMMAND}
+        COMMENT "Writing the overlay description ${OUTPUT_BITSTREAM_NAME}.ovl.json"
+        VERBATIM
+    )
+else()
+    message(STATUS "Python 3 not found: no overlay description (.ovl.json) for the notebooks")
+endif()
@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+#
+# FILE:
+#   overlay_meta.py
+#
+# DESCRIPTION:
+#   Pre-parses the .hwh of a bitstream into <name>.ovl.json next to it, for
+#   kr260_overlay.py on the board. PYNQ's Overlay() parses the whole .hwh on
+#   every start (the PS block alone has thousands of parameters) and programs
+#   the PL again; the JSON holds what the notebooks use of it, in the shape
+#   of PYNQ's dictionaries, plus the fingerprints fw_loader records for the
+#   bitstream, so the helper can tell that the PL already runs it.
+#
+#     overlay_meta.py gpio_led.bit              write gpio_led.ovl.json
+#     overlay_meta.py gpio_led.bit --hwh x.hwh  .hwh under another name
+#     overlay_meta.py gpio_led.bit -o out.json
+#
+#   Contents (FORMAT 1):
+#     bitstream     file name and size of the .bit
+#     hwh_sha1      of the .hwh it was parsed from (the helper checks it)
+#     fingerprints  "<size>:<FNV-1a 64>" of the .bit file and of its
+#                   configuration data (the .bin), as in /run/fw_loader/pl
+#     ip_dict       addressable IP: fullpath, type (VLNV), phys_addr,
+#                   addr_range, parameters, registers, interrupts
+#     mem_dict      memory ranges (MEMTYPE MEMORY) the same way
+#     interrupt_controllers, interrupt_pins   AXI interrupt controllers
+#                   behind pl_ps_irq0/1 and the pins they serve
+#     clock_dict    PL clocks: enable and frequency in MHz
+#
+# Standard library only: it runs in the PL CMake flow (build_utils/overlay/
+# overlay.cmake) and by hand for designs built in the Vivado GUI.
+#
+
+import argparse
+import hashlib
+import json
+import os
+import sys
+import xml.etree.ElementTree as ET
+
+FORMAT = 1
+
+FNV_OFFSET = 0xcbf29ce484222325
+FNV_PRIME = 0x100000001b3
+MASK64 = 0xFFFFFFFFFFFFFFFF
+
+
+def fnv1a(data):
+    # fw_loader.cpp fnv1a(), a byte at a time: slow in Python, build time only
+    h = FNV_OFFSET
+    for b in data:
+        h = ((h ^ b) * FNV_PRIME) & MASK64
+    return h
+
+
+def fingerprint(data):
+    return "%d:%016x" % (len(data), fnv1a(data))
+
+
+def bit_config_data(data):
+    # fw_loader.cpp parse_bit_header(): <u16 len> <len bytes> <u16 1>, fields
+    # 'a'..'d' as <key> <u16 len> <bytes>, then 'e' <u32 len> <data>
+    if len(data) < 2:
+        return None
+    pos = 2 + int.from_bytes(data[0:2], "big") + 2
+    while pos < len(data):
+        key = data[pos]
+        pos += 1
+        if key == ord("e"):
+            length = int.from_bytes(data[pos:pos + 4], "big")
+            start = pos + 4
+            return data[start:start + length] if start + length <= len(data) else None
+        if key < ord("a") or key > ord("d"):
+            return None
+        pos += 2 + int.from_bytes(data[pos:pos + 2], "big")
+    return None
+
+
+def params_of(module):
+    return {p.get("NAME"): p.get("VALUE") for p in module.findall("./PARAMETERS/PARAMETER")}
+
+
+def props_of(elem):
+    return {p.get("NAME"): p.get("VALUE") for p in elem.findall("./PROPERTY")}
+
+
+def registers_of(module, block_name):
+    # PYNQ's register dictionary of one address block
+    registers = {}
+    for block in module.findall("./ADDRESSBLOCKS/ADDRESSBLOCK"):
+        if block.get("NAME") != block_name:
+            continue
+        for reg in block.findall("./REGISTERS/REGISTER"):
+            props = props_of(reg)
+            fields = {}
+            for field in reg.findall("./FIELDS/FIELD"):
+                fp = props_of(field)
+                fields[field.get("NAME")] = {
+                    "bit_offset": int(fp.get("BIT_OFFSET", "0"), 0),
+                    "bit_width": int(fp.get("BIT_WIDTH", "1"), 0),
+                    "description": fp.get("DESCRIPTION", ""),
+                    "access": fp.get("ACCESS", ""),
+                }
+            registers[reg.get("NAME")] = {
+                "address_offset": int(props.get("ADDRESS_OFFSET", "0"), 0),
+                "size": int(props.get("SIZE", "32"), 0),
+                "access": props.get("ACCESS", ""),
+                "description": props.get("DESCRIPTION", ""),
+                "fields": fields,
+            }
+    return registers
+
+
+def interrupts(modules, ps):
+    # Nets: signal name -> [(instance, port, direction)]
+    nets = {}
+    for name, module in modules.items():
+        for port in module.findall("./PORTS/PORT"):
+            if port.get("SIGNAME"):
+                nets.setdefault(port.get("SIGNAME"), []).append(
+                    (name, port.get("NAME"), port.get("DIR")))
+
+    def port_net(inst, port_name):
+        for port in modules[inst].findall("./PORTS/PORT"):
+            if port.get("NAME") == port_name:
+                return port.get("SIGNAME")
+        return None
+
+    def drivers(net):
+        return [(i, p) for i, p, d in nets.get(net, []) if d == "O"]
+
+    def inputs_of(inst, port_name):
+        # Pins behind an interrupt input, in bit order (through xlconcat)
+        pins = []
+        for src, src_port in drivers(port_net(inst, port_name)):
+            module = modules[src]
+            if module.get("MODTYPE") == "xlconcat" and src_port == "dout":
+                params = params_of(module)
+                for i in range(int(params.get("NUM_PORTS", "2"))):
+                    width = int(params.get("IN%d_WIDTH" % i, "1"))
+                    found = inputs_of(src, "In%d" % i)
+                    pins.extend(found[:width] + [None] * (width - len(found[:width])))
+            else:
+                pins.append((src, src_port))
+        return pins
+
+    controllers, pins = {}, {}
+    intcs = [n for n, m in modules.items() if m.get("MODTYPE") == "axi_intc"]
+    for intc in intcs:
+        controllers[intc] = {"parent": "", "index": 0}
+    for intc in intcs:
+        for index, pin in enumerate(inputs_of(intc, "intr")):
+            if pin is None:
+                continue
+            src, src_port = pin
+            if src in controllers and src_port == "irq":
+                controllers[src] = {"parent": intc, "index": index}
+                continue
+            path = "%s/%s" % (src, src_port)
+            pins[path] = {"controller": intc, "index": index, "fullpath": path}
+    # Controllers that reach the PS keep parent ""; the PS lines are noted
+    for line in ("pl_ps_irq0", "pl_ps_irq1"):
+        if ps is not None and port_net(ps, line):
+            for index, pin in enumerate(inputs_of(ps, line)):
+                if pin and pin[0] in controllers:
+                    controllers[pin[0]]["ps_line"] = "%s[%d]" % (line, index)
+    return controllers, pins
+
+
+def clocks(ps_params):
+    clock_dict = {}
+    for i in range(4):
+        freq = ps_params.get("PSU__CRL_APB__PL%d_REF_CTRL__ACT_FREQMHZ" % i) or \
+            ps_params.get("PSU__CRL_APB__PL%d_REF_CTRL__FREQMHZ" % i)
+        enable = ps_params.get("PSU__FPGA_PL%d_ENABLE" % i, "0")
+        if freq is not None:
+            clock_dict[str(i)] = {"enable": int(enable == "1"), "frequency": float(freq)}
+    return clock_dict
+
+
+def parse_hwh(path):
+    root = ET.parse(path).getroot()
+    modules = {}
+    for module in root.findall("./MODULES/MODULE"):
+        full = module.get("FULLNAME", "/" + module.get("INSTANCE", ""))
+        modules[full.lstrip("/")] = module
+    ps = next((n for n, m in modules.items()
+               if m.get("MODTYPE") in ("zynq_ultra_ps_e", "processing_system7")), None)
+
+    ip_dict, mem_dict = {}, {}
+    if ps is not None:
+        for rng in modules[ps].findall("./MEMORYMAP/MEMRANGE"):
+            inst = rng.get("INSTANCE")
+            module = modules.get(inst)
+            if module is None:
+                continue
+            base = int(rng.get("BASEVALUE"), 0)
+            high = int(rng.get("HIGHVALUE"), 0)
+            entry = {
+                "fullpath": inst,
+                "type": module.get("VLNV"),
+                "bdtype": None,
+                "state": None,
+                "phys_addr": base,
+                "addr_range": high - base + 1,
+                "mem_id": rng.get("SLAVEBUSINTERFACE"),
+                "memtype": rng.get("MEMTYPE"),
+                "gpio": {},
+                "interrupts": {},
+                "parameters": params_of(module),
+                "registers": registers_of(module, rng.get("ADDRESSBLOCK")),
+            }
+            if rng.get("MEMTYPE") == "MEMORY":
+                mem_dict.setdefault(inst, entry)
+            else:
+                # An IP with several register ranges is listed by its first
+                ip_dict.setdefault(inst, entry)
+
+    controllers, pins = interrupts(modules, ps)
+    for path, pin in pins.items():
+        inst, port = path.rsplit("/", 1)
+        if inst in ip_dict:
+            ip_dict[inst]["interrupts"][port] = dict(pin)
+
+    return {
+        "ip_dict": ip_dict,
+        "mem_dict": mem_dict,
+        "interrupt_controllers": controllers,
+        "interrupt_pins": pins,
+        "clock_dict": clocks(params_of(modules[ps])) if ps is not None else {},
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pre-parse the .hwh of a bitstream into .ovl.json")
+    parser.add_argument("bitstream", help=".bit file")
+    parser.add_argument("--hwh", help="hardware handoff (default: <name>.hwh next to the .bit)")
+    parser.add_argument("-o", "--output", help="output (default: <name>.ovl.json next to the .bit)")
+    args = parser.parse_args()
+
+    stem = os.path.splitext(args.bitstream)[0]
+    hwh = args.hwh or stem + ".hwh"
+    output = args.output or stem + ".ovl.json"
+
+    with open(args.bitstream, "rb") as f:
+        bit = f.read()
+    with open(hwh, "rb") as f:
+        hwh_sha1 = hashlib.sha1(f.read()).hexdigest()
+
+    fingerprints = [fingerprint(bit)]
+    config = bit_config_data(bit)
+    if config is not None:
+        fingerprints.append(fingerprint(config))
+
+    meta = {
+        "format": FORMAT,
+        "bitstream": os.path.basename(args.bitstream),
+        "bitstream_size": len(bit),
+        "hwh_sha1": hwh_sha1,
+        "fingerprints": fingerprints,
+    }
+    meta.update(parse_hwh(hwh))
+
+    content = json.dumps(meta, indent=1, sort_keys=True) + "\n"
+    try:
+        with open(output) as f:
+            if f.read() == content:
+                return 0
+    except OSError:
+        pass
+    with open(output, "w") as f:
+        f.write(content)
+    print("overlay_meta: wrote %s (%d IP, %d interrupt pins)" %
+          (output, len(meta["ip_dict"]), len(meta["interrupt_pins"])))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,261 @@
+#!/usr/bin/python
+#
+# FILE:
+#   kr260_regmap.py
+#
+# DESCRIPTION:
+#   Register maps of the PL blocks and of the PS and AXI IP registers the
+#   firmware, the kernel modules and the APU tools touch, in one place.
+#   regmap_gen.py turns them into:
+#
+#     gpio_led/common/kr260_regs.h                C: <BLOCK>_<REG>_OFFSET,
+#                                                 _SHIFT/_MASK of the fields
+#     gpio_led/APU/apu_app/kr260hal/hw_regs.h     C++: Reg<> and Field<>
+#                                                 aliases per block
+#     <block>_regs.py                             MyHDL: register indices and
+#                                                 _B/_W fields, as before
+#
+# * Offsets are in bytes; the Python modules also carry the 32-bit register
+#    index (offset / 4) under the names the MyHDL blocks always used.
+# * 'bank' is a register bank repeated 'count' times at base + n * stride
+#    (the interrupt_gen channels); its registers are offsets within the bank.
+# * Registers are (name, offset, doc[, access]); access is "ro" for status
+#    and counters, "wo" for triggers and set/clear registers, "rw" if left out.
+#    It only types the C++ Reg<> aliases: MemMap refuses the other direction.
+# * Fields are (name, bit, width).
+# * After editing, run "make regmap" in myhdl/ (or reconfigure one of the
+#    CMake flows) and commit the regenerated files with the change.
+#
+
+BLOCKS = [
+    {
+        "name": "interrupt_gen",
+        "doc": "interrupt_gen (myhdl/PL/MyHDL/src/interrupt_gen/interrupt_gen.py)",
+        "size": 0x1000,
+        "consts": [
+            ("MAX_CHANNELS", 16, "Channels of the interrupt_out variant"),
+        ],
+        "regs": [
+            ("PERIOD1", 0x00, "PERIOD of channel 0"),
+            ("PERIOD2", 0x04, "PERIOD of channel 1"),
+            ("ISR", 0x08, "Bit n: channel n pending, write 1 to clear"),
+            ("IER", 0x0C, "Bit n: channel n enabled"),
+            ("TRIGGER", 0x10, "Write 1 to bit n to raise channel n", "wo"),
+            ("COUNTER_LO", 0x14, "Free-running PL clock count", "ro"),
+            ("COUNTER_HI", 0x18, None, "ro"),
+            ("CHANNELS", 0x1C, "Number of channels, 0 on the two-channel block", "ro"),
+            ("COMPARE_ARMED", 0x20, "Bit n: channel n compare armed, write 1 to disarm"),
+        ],
+        "fields": {
+            "ISR": [("INTERRUPT1", 0, 1), ("INTERRUPT2", 1, 1)],
+            "IER": [("INTERRUPT1", 0, 1), ("INTERRUPT2", 1, 1)],
+            "TRIGGER": [("INTERRUPT1", 0, 1), ("INTERRUPT2", 1, 1)],
+        },
+        "bank": {
+            "name": "CHANNEL",
+            "prefix": "CH",
+            "base": 0x80,
+            "stride": 0x20,
+            "count": 16,
+            "regs": [
+                ("PERIOD", 0x00, "Clocks between events, 0 stops the channel"),
+                ("TIMESTAMP_LO", 0x04, "Counter when the ISR bit was set", "ro"),
+                ("TIMESTAMP_HI", 0x08, None, "ro"),
+                ("EVENTS", 0x0C, "Free-running 32-bit event count", "ro"),
+                ("COALESCE_COUNT", 0x10, "Events per ISR bit, 0 or 1: every event"),
+                ("COALESCE_TIME", 0x14, "Clocks from the first pending event, 0: off"),
+                ("COMPARE_LO", 0x18, "COUNTER value of a one-shot event, disarms"),
+                ("COMPARE_HI", 0x1C, "Bits 63:32 of COMPARE; a write arms it"),
+            ],
+        },
+        "python": [
+            "myhdl/PL/MyHDL/src/interrupt_gen/interrupt_gen_regs.py",
+            "myhdl/APU/interrupt_gen_regs.py",
+        ],
+    },
+    {
+        "name": "pattern_out",
+        "doc": "pattern_out (myhdl/PL/MyHDL/src/pattern_out/pattern_out.py)",
+        "size": 0x1000,
+        "regs": [
+            ("CTRL", 0x00, None),
+            ("DIVIDER", 0x04, "Sample period in clock cycles"),
+            ("STATUS", 0x08, None, "ro"),
+            ("ISR", 0x0C, "Write 1 to clear"),
+            ("IER", 0x10, None),
+            ("COUNT", 0x14, "Samples output since ENABLE was set", "ro"),
+            ("UNDERRUNS", 0x18, "Ticks without a sample", "ro"),
+        ],
+        "fields": {
+            "CTRL": [("ENABLE", 0, 1)],
+            "STATUS": [("RUNNING", 0, 1), ("TVALID", 1, 1)],
+            "ISR": [("DONE", 0, 1), ("UNDERRUN", 1, 1)],
+            "IER": [("DONE", 0, 1), ("UNDERRUN", 1, 1)],
+        },
+        "python": [
+            "myhdl/PL/MyHDL/src/pattern_out/pattern_out_regs.py",
+            "gpio_led/APU/python/pattern_out_regs.py",
+        ],
+    },
+    {
+        "name": "stream_accel",
+        "doc": "stream_accel (myhdl/PL/MyHDL/src/stream_accel/stream_accel.py)",
+        "size": 0x1000,
+        "regs": [
+            ("CTRL", 0x00, None),
+            ("XOR", 0x04, "out = (in ^ XOR) + ADD while ENABLE is set"),
+            ("ADD", 0x08, None),
+            ("BEATS", 0x0C, "Samples handed to the sink", "ro"),
+            ("PACKETS", 0x10, "TLASTs handed to the sink", "ro"),
+        ],
+        "fields": {
+            "CTRL": [("ENABLE", 0, 1), ("CLEAR", 1, 1)],
+        },
+        "python": [
+            "myhdl/PL/MyHDL/src/stream_accel/stream_accel_regs.py",
+        ],
+    },
+    {
+        "name": "pwm_seq",
+        "doc": "pwm_seq (myhdl/PL/MyHDL/src/pwm_seq/pwm_seq.py)",
+        "size": 0x1000,
+        "consts": [
+            ("MAX_CHANNELS", 8, "Channels of the largest variant"),
+            ("STEP_DUTY_MASK", 0x00FFFFFF, "Sequence entry: high clocks of the period"),
+            ("STEP_HOLD_SHIFT", 24, "Sequence entry: periods the step lasts, minus 1"),
+        ],
+        "regs": [
+            ("CTRL", 0x00, None),
+            ("ISR", 0x04, "Bit n: sequence of channel n done, write 1 to clear"),
+            ("IER", 0x08, None),
+            ("CHANNELS", 0x0C, "Number of channels", "ro"),
+            ("SEQ_DEPTH", 0x10, "Sequence entries per channel", "ro"),
+            ("SEQ_ADDR", 0x14, "Entry SEQ_DATA writes: channel * SEQ_DEPTH + step"),
+            ("SEQ_DATA", 0x18, "Write an entry at SEQ_ADDR, which then increments", "wo"),
+        ],
+        "fields": {
+            "CTRL": [("ENABLE", 0, 1)],
+        },
+        "bank": {
+            "name": "CHANNEL",
+            "prefix": "CH",
+            "base": 0x40,
+            "stride": 0x20,
+            "count": 8,
+            "regs": [
+                ("PERIOD", 0x00, "PL clocks per PWM period, 0 holds the pin low"),
+                ("DUTY", 0x04, "High clocks per period without a sequence"),
+                ("SEQ_LEN", 0x08, "Steps of the sequence; a write restarts it, 0 stops it"),
+                ("SEQ_LOOPS", 0x0C, "Passes of the sequence, 0: until stopped"),
+                ("SEQ_STEP", 0x10, "Step playing, bit 31 while the sequence runs", "ro"),
+            ],
+        },
+        "python": [
+            "myhdl/PL/MyHDL/src/pwm_seq/pwm_seq_regs.py",
+        ],
+    },
+    {
+        "name": "mailbox",
+        "doc": "mailbox (myhdl/PL/MyHDL/src/mailbox/mailbox.py)",
+        "size": 0x1000,
+        "consts": [
+            ("MAX_DEPTH", 1024, "Largest FIFO depth, in messages"),
+        ],
+        "regs": [
+            ("A2R_DATA", 0x00, "APU -> RPU: write pushes, read is the oldest message"),
+            ("A2R_POP", 0x04, "Any write drops the oldest APU -> RPU message", "wo"),
+            ("A2R_COUNT", 0x08, "Messages in the APU -> RPU FIFO", "ro"),
+            ("A2R_THRESHOLD", 0x0C, "A2R_DATA pending while COUNT >= THRESHOLD (0: 1)"),
+            ("R2A_DATA", 0x10, "RPU -> APU: write pushes, read is the oldest message"),
+            ("R2A_POP", 0x14, "Any write drops the oldest RPU -> APU message", "wo"),
+            ("R2A_COUNT", 0x18, "Messages in the RPU -> APU FIFO", "ro"),
+            ("R2A_THRESHOLD", 0x1C, "R2A_DATA pending while COUNT >= THRESHOLD (0: 1)"),
+            ("ISR", 0x20, "Write 1 to clear"),
+            ("IER", 0x24, None),
+            ("CTRL", 0x28, "Write 1 to a FLUSH bit to empty that FIFO", "wo"),
+            ("DEPTH", 0x2C, "FIFO depth in messages", "ro"),
+        ],
+        "fields": {
+            "ISR": [("A2R_DATA", 0, 1), ("R2A_DATA", 1, 1),
+                    ("A2R_OVERFLOW", 2, 1), ("R2A_OVERFLOW", 3, 1)],
+            "IER": [("A2R_DATA", 0, 1), ("R2A_DATA", 1, 1),
+                    ("A2R_OVERFLOW", 2, 1), ("R2A_OVERFLOW", 3, 1)],
+            "CTRL": [("FLUSH_A2R", 0, 1), ("FLUSH_R2A", 1, 1)],
+        },
+        "python": [
+            "myhdl/PL/MyHDL/src/mailbox/mailbox_regs.py",
+        ],
+    },
+    {
+        "name": "gpio_atomic",
+        "doc": "gpio_atomic (myhdl/PL/MyHDL/src/gpio_atomic/gpio_atomic.py)",
+        "size": 0x1000,
+        "consts": [
+            ("MAX_WIDTH", 32, "Pins of the largest variant"),
+        ],
+        "regs": [
+            ("DATA", 0x00, "Output pins; a write replaces the bytes it strobes"),
+            ("SET", 0x04, "Write 1 to drive a pin high", "wo"),
+            ("CLEAR", 0x08, "Write 1 to drive a pin low", "wo"),
+            ("TOGGLE", 0x0C, "Write 1 to invert a pin", "wo"),
+            ("INPUT", 0x10, "Input pins, synchronised to the PL clock", "ro"),
+            ("WIDTH", 0x14, "Number of output pins", "ro"),
+        ],
+        "python": [
+            "myhdl/PL/MyHDL/src/gpio_atomic/gpio_atomic_regs.py",
+        ],
+    },
+    {
+        "name": "ipi",
+        "doc": "Zynq UltraScale+ IPI channel (UG1087, IPI module)",
+        "size": 0x1000,
+        "consts": [
+            ("APU_BASE", 0xFF300000, "APU IPI channel (source of the doorbell)"),
+        ],
+        "regs": [
+            ("TRIG", 0x00, "Write target bits to raise an IPI", "wo"),
+            ("OBS", 0x04, "Target bits still pending", "ro"),
+            ("ISR", 0x10, "Source bits pending, write 1 to clear"),
+            ("IMR", 0x14, "Masked source bits", "ro"),
+            ("IER", 0x18, "Write 1 to unmask a source", "wo"),
+            ("IDR", 0x1C, "Write 1 to mask a source", "wo"),
+        ],
+    },
+    {
+        "name": "axi_gpio",
+        "doc": "AXI GPIO (PG144)",
+        "size": 0x1000,
+        "regs": [
+            ("DATA", 0x000, "Channel 1 data"),
+            ("TRI", 0x004, "Channel 1 direction, 1: input"),
+            ("DATA2", 0x008, "Channel 2 data"),
+            ("TRI2", 0x00C, "Channel 2 direction, 1: input"),
+            ("GIER", 0x11C, "Global interrupt enable"),
+            ("IP_ISR", 0x120, "Channel interrupt status, write 1 to clear"),
+            ("IP_IER", 0x128, "Channel interrupt enable"),
+        ],
+        "fields": {
+            "GIER": [("ENABLE", 31, 1)],
+            "IP_ISR": [("CH1", 0, 1), ("CH2", 1, 1)],
+            "IP_IER": [("CH1", 0, 1), ("CH2", 1, 1)],
+        },
+    },
+    {
+        "name": "axi_intc",
+        "doc": "AXI interrupt controller (PG099)",
+        "size": 0x1000,
+        "regs": [
+            ("ISR", 0x00, "Pending"),
+            ("IPR", 0x04, "Pending and enabled", "ro"),
+            ("IER", 0x08, None),
+            ("IAR", 0x0C, "Write 1 to acknowledge", "wo"),
+            ("SIE", 0x10, "Write 1 to set IER bits", "wo"),
+            ("CIE", 0x14, "Write 1 to clear IER bits", "wo"),
+            ("IVR", 0x18, "Lowest pending and enabled input", "ro"),
+            ("MER", 0x1C, None),
+        ],
+        "fields": {
+            "MER": [("ME", 0, 1), ("HIE", 1, 1)],
+        },
+    },
+]
@@ -0,0 +1,39 @@
+# Register map generation (regmap_gen.py) for the CMake flows
+#
+# Included by gpio_led/PL/CMakeLists.txt and the RPU application: the headers
+# and Python modules are regenerated from kr260_regmap.py at configure time,
+# and CMake reconfigures when the description changes. "make regmap"
+# regenerates them on demand. Without Python 3 the committed files are used.
+
+set(REGMAP_DIR "${CMAKE_CURRENT_LIST_DIR}")
+
+find_package(Python3 COMPONENTS Interpreter)
+
+if(Python3_Interpreter_FOUND)
+    execute_process(
+        COMMAND ${Python3_EXECUTABLE} ${REGMAP_DIR}/regmap_gen.py
+        RESULT_VARIABLE REGMAP_RESULT
+        OUTPUT_VARIABLE REGMAP_OUTPUT
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+    )
+    if(NOT REGMAP_RESULT EQUAL 0)
+        message(FATAL_ERROR "regmap_gen.py failed (${REGMAP_RESULT})")
+    endif()
+    if(REGMAP_OUTPUT)
+        message(STATUS "${REGMAP_OUTPUT}")
+    endif()
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS
+        ${REGMAP_DIR}/kr260_regmap.py
+        ${REGMAP_DIR}/regmap_gen.py
+    )
+
+    if(NOT TARGET regmap)
+        add_custom_target(regmap
+            COMMAND ${Python3_EXECUTABLE} ${REGMAP_DIR}/regmap_gen.py
+            COMMENT "Generating the register map files"
+            VERBATIM
+        )
+    endif()
+else()
+    message(STATUS "Python 3 not found: using the committed register map files")
+endif()
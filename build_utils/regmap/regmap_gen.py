@@ -0,0 +1,330 @@
+#!/usr/bin/env python3
+#
+# FILE:
+#   regmap_gen.py
+#
+# DESCRIPTION:
+#   Generates the register map headers and Python modules from kr260_regmap.py
+#   (see there for the outputs). Files are only rewritten when their content
+#   changes, so build systems that run this on every build do not rebuild
+#   their users for nothing.
+#
+#     regmap_gen.py            write the outputs
+#     regmap_gen.py --check    exit 1 if an output is missing or out of date
+#
+# Standard library only: it runs from the MyHDL venv, the RPU CMake flow and
+# the PL CMake flow alike.
+#
+
+import argparse
+import os
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.normpath(os.path.join(HERE, "..", ".."))
+
+# No __pycache__ next to the description in the source tree
+sys.dont_write_bytecode = True
+sys.path.insert(0, HERE)
+from kr260_regmap import BLOCKS  # noqa: E402
+
+C_HEADER = "gpio_led/common/kr260_regs.h"
+CXX_HEADER = "gpio_led/APU/apu_app/kr260hal/hw_regs.h"
+
+GENERATED = "GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py"
+
+
+def camel(name):
+    return "".join(part.capitalize() for part in name.split("_"))
+
+
+def field_mask(bit, width):
+    return ((1 << width) - 1) << bit
+
+
+def reg_entry(entry):
+    # (name, offset, doc[, access]) -> name, offset, doc, access ("rw", "ro", "wo")
+    return entry[0], entry[1], entry[2], entry[3] if len(entry) > 3 else "rw"
+
+
+def cxx_reg(offset, access):
+    if access == "rw":
+        return "Reg<%s, uint32_t, SIZE>;" % offset
+    return "Reg<%s, uint32_t, SIZE, Access::%s>;" % (offset, access.upper())
+
+
+def const_literal(value):
+    return "0x%X" % value if value >= 0x10000 else "%d" % value
+
+
+def comment(text, start, end=""):
+    return "  %s %s%s" % (start, text, end) if text else ""
+
+
+def columns(rows, sep=" "):
+    # rows: (name, value, comment suffix) -> lines, names and values aligned
+    width = max(len(name) for name, _, _ in rows)
+    vwidth = max(len(value) for _, value, note in rows if note) if any(r[2] for r in rows) else 0
+    return [("%-*s%s%-*s%s" % (width, name, sep, vwidth if note else 0, value, note)).rstrip()
+            for name, value, note in rows]
+
+
+# ---------------------------------------------------------------------------
+# C
+
+def c_block(block):
+    prefix = block["name"].upper()
+    rows = [("#define %s_SIZE" % prefix, "0x%XU" % block["size"], "")]
+    for name, value, text in block.get("consts", []):
+        rows.append(("#define %s_%s" % (prefix, name), const_literal(value) + "U",
+                     comment(text, "/*", " */")))
+    for name, offset, text, _ in map(reg_entry, block["regs"]):
+        rows.append(("#define %s_%s_OFFSET" % (prefix, name), "0x%03XU" % offset,
+                     comment(text, "/*", " */")))
+    for reg, fields in block.get("fields", {}).items():
+        for name, bit, width in fields:
+            rows.append(("#define %s_%s_%s_SHIFT" % (prefix, reg, name), "%dU" % bit, ""))
+            rows.append(("#define %s_%s_%s_MASK" % (prefix, reg, name),
+                         "0x%08XU" % field_mask(bit, width), ""))
+    lines = ["/* %s */" % block["doc"]] + columns(rows)
+
+    bank = block.get("bank")
+    if bank:
+        b = "%s_%s" % (prefix, bank["name"])
+        p = "%s_%s" % (prefix, bank["prefix"])
+        lines.append("/* Bank n of %d at %s_OFFSET(n); registers relative to it */"
+                     % (bank["count"], b))
+        rows = [
+            ("#define %s_COUNT" % b, "%dU" % bank["count"], ""),
+            ("#define %s_STRIDE" % b, "0x%03XU" % bank["stride"], ""),
+            ("#define %s_OFFSET(n)" % b,
+             "(0x%03XU + (n) * 0x%03XU)" % (bank["base"], bank["stride"]), ""),
+        ]
+        for name, offset, text, _ in map(reg_entry, bank["regs"]):
+            rows.append(("#define %s_%s_OFFSET" % (p, name), "0x%03XU" % offset,
+                         comment(text, "/*", " */")))
+        lines += columns(rows)
+    return lines
+
+
+def c_header():
+    out = [
+        "/*",
+        " * Register maps of the KR260 designs: the MyHDL blocks of the PL and the",
+        " * PS and AXI IP registers used by the RPU firmware, the kernel modules and",
+        " * the APU tools. Offsets are bytes from the base of the block.",
+        " *",
+        " * %s," % GENERATED,
+        " * do not edit: change the description and run \"make regmap\" in myhdl/.",
+        " */",
+        "",
+        "#ifndef KR260_REGS_H",
+        "#define KR260_REGS_H",
+    ]
+    for block in BLOCKS:
+        out.append("")
+        out += c_block(block)
+    out += ["", "#endif /* KR260_REGS_H */", ""]
+    return "\n".join(out)
+
+
+# ---------------------------------------------------------------------------
+# C++
+
+def cxx_block(block):
+    ns = block["name"]
+    lines = ["// %s" % block["doc"], "namespace %s {" % ns, ""]
+    rows = [("constexpr size_t SIZE", "0x%X;" % block["size"], "")]
+    for name, value, text in block.get("consts", []):
+        ctype = "uintptr_t" if name.endswith("BASE") else "uint32_t"
+        rows.append(("constexpr %s %s" % (ctype, name), const_literal(value) + ";",
+                     comment(text, "//")))
+    lines += columns(rows, " = ") + [""]
+
+    rows = []
+    for name, offset, text, access in map(reg_entry, block["regs"]):
+        rows.append(("using %s" % camel(name), cxx_reg("0x%03X" % offset, access),
+                     comment(text, "//")))
+    lines += columns(rows, " = ")
+
+    fields = block.get("fields", {})
+    if fields:
+        rows = []
+        for regname, regfields in fields.items():
+            for name, bit, width in regfields:
+                args = "%s, %d" % (camel(regname), bit) + (", %d" % width if width > 1 else "")
+                rows.append(("using %s%s" % (camel(regname), camel(name)),
+                             "Field<%s>;" % args, ""))
+        lines += [""] + columns(rows, " = ")
+
+    bank = block.get("bank")
+    if bank:
+        lines += [
+            "",
+            "// Bank N of %d" % bank["count"],
+            "template <size_t N>",
+            "struct %s {" % camel(bank["name"]),
+            "    static_assert(N < %d, \"no such %s\");" % (bank["count"], bank["name"].lower()),
+            "    static constexpr size_t OFFSET = 0x%03X + N * 0x%03X;" % (bank["base"], bank["stride"]),
+            "",
+        ]
+        rows = []
+        for name, offset, text, access in map(reg_entry, bank["regs"]):
+            rows.append(("    using %s" % camel(name),
+                         cxx_reg("OFFSET + 0x%02X" % offset, access), comment(text, "//")))
+        lines += columns(rows, " = ") + ["};"]
+    lines += ["", "} // namespace %s" % ns]
+    return lines
+
+
+def cxx_header():
+    out = [
+        "/*",
+        " * Typed registers of the PL blocks and of the PS and AXI IP (kr260hal),",
+        " * for MemMap::read<R>() / write<R>() on a mapping of the block. Status",
+        " * and counters are read-only, triggers and set/clear registers write-only:",
+        " *",
+        " *   uint32_t pending = gen.read<interrupt_gen::Isr>();",
+        " *   uint32_t events = gen.read<interrupt_gen::Channel<1>::Events>();",
+        " *   bool running = pat.read_field<pattern_out::StatusRunning>();",
+        " *",
+        " * %s," % GENERATED,
+        " * do not edit: change the description and run \"make regmap\" in myhdl/.",
+        " */",
+        "",
+        "#ifndef KR260HAL_HW_REGS_H",
+        "#define KR260HAL_HW_REGS_H",
+        "",
+        "#include <cstddef>",
+        "#include <cstdint>",
+        "",
+        "#include \"reg.h\"",
+        "",
+        "namespace kr260hal {",
+    ]
+    for block in BLOCKS:
+        out.append("")
+        out += cxx_block(block)
+    out += ["", "} // namespace kr260hal", "", "#endif /* KR260HAL_HW_REGS_H */", ""]
+    return "\n".join(out)
+
+
+# ---------------------------------------------------------------------------
+# Python (MyHDL and the PYNQ notebooks)
+
+def pycolumns(rows):
+    return ["%s = %s%s" % (name, value, note) for name, value, note in rows]
+
+
+def py_module(block, path):
+    prefix = block["name"].upper()
+    out = [
+        "#!/usr/bin/python",
+        "#",
+        "# FILE:",
+        "#   %s" % os.path.basename(path),
+        "#",
+        "# DESCRIPTION:",
+        "#   Register map of %s," % block["doc"],
+        "#   %s," % GENERATED,
+        "#   do not edit. %s_<REG> is the 32-bit register index," % prefix,
+        "#   %s_<REG>_OFFSET the byte offset." % prefix,
+        "#",
+        "",
+    ]
+    consts = block.get("consts", [])
+    if consts:
+        out += pycolumns([("%s_%s" % (prefix, name), const_literal(value), comment(text, "#"))
+                        for name, value, text in consts]) + [""]
+
+    out.append("# Register indices")
+    rows = [("%s_%s" % (prefix, name), "%d" % (offset // 4), comment(text, "#"))
+            for name, offset, text, _ in map(reg_entry, block["regs"])]
+    bank = block.get("bank")
+    if bank:
+        b = "%s_%s" % (prefix, bank["name"])
+        rows.append(("%s_BASE" % b, "%d" % (bank["base"] // 4), ""))
+        rows.append(("%s_STRIDE" % b, "%d" % (bank["stride"] // 4), ""))
+    out += pycolumns(rows)
+    out.append("# Register byte offsets")
+    out += pycolumns([("%s_%s_OFFSET" % (prefix, name), "0x%02X" % offset, "")
+                    for name, offset, _, _ in map(reg_entry, block["regs"])])
+
+    if bank:
+        p = "%s_%s" % (prefix, bank["prefix"])
+        out.append("# Register indices within a %s bank" % bank["name"].lower())
+        out += pycolumns([("%s_%s" % (p, name), "%d" % (offset // 4), comment(text, "#"))
+                        for name, offset, text, _ in map(reg_entry, bank["regs"])])
+        out.append("# Register byte offsets within a %s bank" % bank["name"].lower())
+        out += pycolumns([("%s_%s_OFFSET" % (p, name), "0x%02X" % offset, "")
+                        for name, offset, _, _ in map(reg_entry, bank["regs"])])
+
+    fields = block.get("fields", {})
+    if fields:
+        out.append("# Register bit fields")
+        for reg, regfields in fields.items():
+            for name, bit, width in regfields:
+                out.append("%s_%s_%s_B = %d" % (prefix, reg, name, bit))
+                out.append("%s_%s_%s_W = %d" % (prefix, reg, name, width))
+
+    if bank:
+        b = "%s_%s" % (prefix, bank["name"])
+        out += [
+            "",
+            "",
+            "def %s_bank(%s):" % (block["name"], bank["name"].lower()),
+            "    \"\"\"Register index of the bank of %s (0-based)\"\"\"" % bank["name"].lower(),
+            "    return %s_BASE + %s * %s_STRIDE" % (b, bank["name"].lower(), b),
+            "",
+            "",
+            "def %s_bank_offset(%s):" % (block["name"], bank["name"].lower()),
+            "    \"\"\"Byte offset of the bank of %s (0-based)\"\"\"" % bank["name"].lower(),
+            "    return 4 * %s_bank(%s)" % (block["name"], bank["name"].lower()),
+        ]
+    out.append("")
+    return "\n".join(out)
+
+
+# ---------------------------------------------------------------------------
+
+def outputs():
+    files = {C_HEADER: c_header(), CXX_HEADER: cxx_header()}
+    for block in BLOCKS:
+        for path in block.get("python", []):
+            files[path] = py_module(block, path)
+    return files
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the KR260 register map files")
+    parser.add_argument("--check", action="store_true",
+                        help="only check that the generated files are up to date")
+    args = parser.parse_args()
+
+    stale = []
+    for path, content in outputs().items():
+        full = os.path.join(ROOT, path)
+        try:
+            with open(full) as f:
+                current = f.read()
+        except OSError:
+            current = None
+        if current == content:
+            continue
+        if args.check:
+            stale.append(path)
+            continue
+        with open(full, "w") as f:
+            f.write(content)
+        print("regmap: wrote %s" % path)
+
+    if stale:
+        for path in stale:
+            print("regmap: %s is out of date, run build_utils/regmap/regmap_gen.py" % path,
+                  file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+#
+# FILE:
+#   vitis_platform.py
+#
+# DESCRIPTION:
+#   Rebuilds the RPU platform (BSP) of a Vitis workspace, optionally from a new
+#   hardware export first. Run by the top-level superbuild (CMakeLists.txt at
+#   the repository root) after the PL build, through the Vitis Python API:
+#
+#     vitis -s vitis_platform.py --workspace gpio_led/RPU [--xsa <file.xsa>]
+#
+#   Without --xsa the platform keeps its current hardware and only the domain
+#   BSP is built.
+#
+
+import argparse
+import os
+
+import vitis
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Update and build the RPU platform of a Vitis workspace")
+    parser.add_argument("--workspace", required=True, help="Vitis workspace (gpio_led/RPU)")
+    parser.add_argument("--platform", default="platform", help="platform component name")
+    parser.add_argument("--xsa", help="hardware export to switch the platform to")
+    args = parser.parse_args()
+
+    client = vitis.create_client()
+    try:
+        client.set_workspace(path=os.path.abspath(args.workspace))
+        platform = client.get_component(name=args.platform)
+        if args.xsa:
+            print("Platform %s: hardware from %s" % (args.platform, args.xsa))
+            platform.update_hw(hw_design=os.path.abspath(args.xsa))
+        platform.build()
+    finally:
+        vitis.dispose()
+
+
+if __name__ == "__main__":
+    main()
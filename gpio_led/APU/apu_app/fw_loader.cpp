@@ -5,166 +5,1488 @@
 #include <unistd.h>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <map>
+#include <sstream>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
+#include <cerrno>
 #include <getopt.h>
+#include <fcntl.h>
+#include <elf.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
 #include <algorithm>
 
+#include "kr260hal/bulk.h"
+#include "kr260hal/ipi_transport.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/shm_regs.h"
+#include "kr260hal/sysfs.h"
+
 using namespace std;
 
 // --- Constants ---
-const string RPU_BASE = "/sys/class/remoteproc/remoteproc0/";
+// remoteproc<n> is R5 core n when the cluster is in split mode
+const string RPU_BASE_PREFIX = "/sys/class/remoteproc/remoteproc";
 const string PL_FIRMWARE_PATH = "/sys/class/fpga_manager/fpga0/firmware";
 const string PL_FLAGS_PATH = "/sys/class/fpga_manager/fpga0/flags";
 const string PL_STATE_PATH = "/sys/class/fpga_manager/fpga0/state";
+// Fingerprints of the loaded images; /run is cleared on reboot, like the PL and RPUs.
+// The notebooks' kr260_overlay.py (build_utils/overlay) reads and writes the
+// "pl" record too: keep its "<name> <size>:<FNV-1a 64>" format
+const string FINGERPRINT_DIR = "/run/fw_loader/";
+// Fingerprints of the image files already hashed, by path, size, mtime and
+// ctime: "<size> <mtime> <ctime> <fingerprint> <path>" per line
+const string HASH_CACHE_PATH = FINGERPRINT_DIR + "hashes";
+const string OVERLAY_CONFIGFS_PATH = "/sys/kernel/config/device-tree/overlays/";
+// Image cache of the daemon: tmpfs, searched by the kernel's firmware loader
+// before /lib/firmware through the firmware_class.path parameter
+const string CACHE_DIR = FINGERPRINT_DIR + "cache";
+const string CACHE_PREFIX = "fw_loader-";
+const string FW_CLASS_PATH = "/sys/module/firmware_class/parameters/path";
+const size_t DEFAULT_CACHE_MB = 256;
+// fpga_manager flags (FPGA_MGR_PARTIAL_RECONFIG is bit 0)
+const string PL_FLAGS_FULL = "0";
+const string PL_FLAGS_PARTIAL = "1";
 const string DEFAULT_RPU_FW = "gpio_app.elf";
+const string DEFAULT_RPU1_FW = "gpio_app_rpu1.elf";
 const string DEFAULT_PL_FW = "gpio_led.bit";
 
+// sysfs state polling (kr260hal::sysfs_wait_for backs off from 1 to 20 ms)
+const int PL_STATE_TIMEOUT_MS = 5000;
+const int RPU_STATE_TIMEOUT_MS = 2000;
+// A resuming image takes its handoff at the top of main()
+const int RPU_RESUME_TIMEOUT_MS = 500;
+// From the remoteproc start to the firmware's IPI task taking commands
+// (rpu_shm.h, "Ready word"), polled at a fraction of the usual boot time
+const int RPU_READY_TIMEOUT_MS = 2000;
+const int RPU_READY_POLL_US = 100;
+
+// PL and RPU bring-up run in parallel; keep their messages whole
+mutex log_mutex;
+
 // --- Helpers ---
 
+void log_line(ostream& os, const string& msg) {
+    lock_guard<mutex> lock(log_mutex);
+    os << msg << endl;
+}
+
 bool file_exists(const string& path) {
-    struct stat buffer;
-    return (stat(path.c_str(), &buffer) == 0);
+    return kr260hal::path_exists(path);
 }
 
 string read_sysfs(const string& path, bool silent = false) {
-    ifstream file(path);
-    if (!file.is_open()) {
-        if (!silent) cerr << "Error: Cannot open " << path << endl;
-        return "";
-    }
     string value;
-    getline(file, value);
+    if (!kr260hal::sysfs_read(path, value) && !silent) log_line(cerr, "Error: Cannot open " + path);
     return value;
 }
 
 bool write_sysfs(const string& path, const string& value) {
-    ofstream file(path);
-    if (!file.is_open()) {
-        cerr << "Error: Cannot open " << path << " for writing (Check permissions)." << endl;
+    if (kr260hal::sysfs_write(path, value)) return true;
+    log_line(cerr, "Error: Cannot write " + path + " (Check permissions).");
+    return false;
+}
+
+uint16_t be16(const unsigned char* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+uint32_t be32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Locates the configuration data in a Xilinx BIT file.
+// Header: <u16 len> <len bytes> <u16 1>, then fields 'a'..'d' (design, part,
+// date, time) as <key> <u16 len> <len bytes>, then 'e' <u32 len> <data>.
+bool parse_bit_header(const unsigned char* data, size_t size, size_t& offset, size_t& length) {
+    size_t pos = 0;
+
+    if (size < 2) return false;
+    pos = 2 + be16(data);
+    if (pos + 2 > size) return false;
+    pos += 2;
+
+    while (pos < size) {
+        unsigned char key = data[pos++];
+        if (key == 'e') {
+            if (pos + 4 > size) return false;
+            length = be32(data + pos);
+            offset = pos + 4;
+            return offset + length <= size;
+        }
+        if (key < 'a' || key > 'd' || pos + 2 > size) return false;
+        pos += 2 + be16(data + pos);
+    }
+    return false;
+}
+
+// Fallback for files without a usable header: the data starts at the sync
+// word (0xAA995566), including the 0xFF padding in front of it
+bool find_sync_word(const unsigned char* data, size_t size, size_t& offset, size_t& length) {
+    static const unsigned char sync_word[] = {0xAA, 0x99, 0x55, 0x66};
+    const unsigned char* end = data + size;
+    const unsigned char* sync = search(data, end, sync_word, sync_word + sizeof(sync_word));
+    if (sync == end) return false;
+
+    while (sync != data && *(sync - 1) == 0xFF) --sync;
+    offset = sync - data;
+    length = size - offset;
+    return true;
+}
+
+bool write_all(int fd, const unsigned char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) return false;
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+// Writes the file under a temporary name and renames it into place, so an
+// interrupted run never leaves a truncated image that looks valid.
+// 'times' (atime, mtime) is applied when given.
+bool write_file_atomic(const string& path, const unsigned char* data, size_t length,
+                       const struct timespec* times) {
+    string tmp_path = path + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = write_all(fd, data, length);
+    ok = ok && (!times || futimens(fd, times) == 0);
+    ok = (close(fd) == 0) && ok;
+    ok = ok && rename(tmp_path.c_str(), path.c_str()) == 0;
+    if (!ok) unlink(tmp_path.c_str());
+    return ok;
+}
+
+// Converts Xilinx BIT file to BIN (strips header).
+// The BIT file is mapped and its data written straight out of the mapping.
+// The BIN gets the mtime of the BIT, so a BIN with the same mtime and the
+// expected size is a previous conversion and is reused ('cached' set).
+bool convert_bit_to_bin(const string& bit_path, const string& bin_path, bool& cached) {
+    cached = false;
+
+    int bit_fd = open(bit_path.c_str(), O_RDONLY);
+    if (bit_fd < 0) return false;
+
+    struct stat bit_st;
+    if (fstat(bit_fd, &bit_st) != 0 || bit_st.st_size == 0) {
+        close(bit_fd);
+        return false;
+    }
+    size_t size = bit_st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, bit_fd, 0);
+    close(bit_fd);
+    if (map == MAP_FAILED) return false;
+    const unsigned char* data = (const unsigned char*)map;
+
+    size_t offset = 0, length = 0;
+    if (!parse_bit_header(data, size, offset, length) &&
+        !find_sync_word(data, size, offset, length)) {
+        munmap(map, size);
         return false;
     }
-    file << value;
-    return !file.fail();
+
+    struct stat bin_st;
+    if (stat(bin_path.c_str(), &bin_st) == 0 && (size_t)bin_st.st_size == length &&
+        bin_st.st_mtim.tv_sec == bit_st.st_mtim.tv_sec &&
+        bin_st.st_mtim.tv_nsec == bit_st.st_mtim.tv_nsec) {
+        munmap(map, size);
+        cached = true;
+        return true;
+    }
+
+    madvise(map, size, MADV_SEQUENTIAL);
+    struct timespec times[2] = {bit_st.st_atim, bit_st.st_mtim};
+    bool ok = write_file_atomic(bin_path, data + offset, length, times);
+    munmap(map, size);
+    return ok;
 }
 
-// Converts Xilinx BIT file to BIN (strips header)
-bool convert_bit_to_bin(const string& bit_path, const string& bin_path) {
-    ifstream bit_file(bit_path, ios::binary | ios::ate);
-    if (!bit_file.is_open()) return false;
-    
-    streamsize size = bit_file.tellg();
-    bit_file.seekg(0, ios::beg);
-
-    vector<unsigned char> buffer(size);
-    if (!bit_file.read((char*)buffer.data(), size)) return false;
-
-    // Strategy 1: Find Key 'e' (0x65) + 4-byte Length
-    for (size_t i = 0; i < buffer.size() - 5; ++i) {
-        if (buffer[i] == 0x65) {
-            uint32_t len = (buffer[i+1] << 24) | (buffer[i+2] << 16) | (buffer[i+3] << 8) | buffer[i+4];
-            if (i + 5 + len == buffer.size()) {
-                ofstream bin_file(bin_path, ios::binary);
-                bin_file.write((char*)&buffer[i+5], len);
-                return true;
-            }
+// --- Fingerprints ---
+
+uint64_t fnv1a(const unsigned char* data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+string fingerprint_of(size_t size, uint64_t hash) {
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%zu:%016llx", size, (unsigned long long)hash);
+    return buf;
+}
+
+// Size and times of a file; a file whose key is unchanged is not hashed again
+string stat_key(const struct stat& st) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%lld %lld.%09ld %lld.%09ld", (long long)st.st_size,
+             (long long)st.st_mtim.tv_sec, st.st_mtim.tv_nsec,
+             (long long)st.st_ctim.tv_sec, st.st_ctim.tv_nsec);
+    return buf;
+}
+
+// Fingerprint recorded for path with this stat key, "" if none
+string cached_hash(const string& path, const string& key) {
+    ifstream file(HASH_CACHE_PATH);
+    string line;
+    while (getline(file, line)) {
+        istringstream fields(line);
+        string size, mtime, ctime, fp, line_path;
+        if (!(fields >> size >> mtime >> ctime >> fp)) continue;
+        getline(fields >> ws, line_path);
+        if (line_path == path && size + " " + mtime + " " + ctime == key) return fp;
+    }
+    return "";
+}
+
+// Records the fingerprint of path, replacing an older line of the same path
+void save_hash(const string& path, const string& key, const string& fp) {
+    if (mkdir(FINGERPRINT_DIR.c_str(), 0755) != 0 && errno != EEXIST) return;
+    vector<string> lines;
+    {
+        ifstream file(HASH_CACHE_PATH);
+        string line;
+        while (getline(file, line)) {
+            istringstream fields(line);
+            string size, mtime, ctime, old_fp, line_path;
+            if (!(fields >> size >> mtime >> ctime >> old_fp)) continue;
+            getline(fields >> ws, line_path);
+            if (line_path != path) lines.push_back(line);
+        }
+    }
+    lines.push_back(key + " " + fp + " " + path);
+
+    string tmp_path = HASH_CACHE_PATH + ".tmp";
+    ofstream file(tmp_path);
+    for (auto& line : lines) file << line << endl;
+    file.close();
+    if (!file || rename(tmp_path.c_str(), HASH_CACHE_PATH.c_str()) != 0) unlink(tmp_path.c_str());
+}
+
+// "<size>:<FNV-1a 64 of the contents>" of a firmware file, "" if unreadable.
+// The contents are only read when the file changed since its last hash.
+string file_fingerprint(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return "";
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return "";
+    }
+    string key = stat_key(st);
+    string cached = cached_hash(path, key);
+    if (!cached.empty()) {
+        close(fd);
+        return cached;
+    }
+    uint64_t hash = fnv1a(nullptr, 0);
+    size_t size = st.st_size;
+    if (size > 0) {
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return "";
         }
+        madvise(map, size, MADV_SEQUENTIAL);
+        hash = fnv1a((const unsigned char*)map, size);
+        munmap(map, size);
+    }
+    close(fd);
+    string fp = fingerprint_of(size, hash);
+    save_hash(path, key, fp);
+    return fp;
+}
+
+// --- Image Cache ---
+
+// An image the daemon keeps on tmpfs, named after the hash of its source.
+// The mapping is locked so the pages stay resident for the next load.
+struct CachedImage {
+    string name;          // File name in CACHE_DIR
+    string fingerprint;   // Of the cached file, for the /run/fw_loader records
+    uint32_t sum = 0;     // Word sum of the source image, for manifest checksums
+    size_t size = 0;
+    void* map = nullptr;
+    uint64_t used = 0;    // Last request that used it
+};
+
+// A /lib/firmware file as it was when cached; a file whose size, mtime or
+// inode changed is hashed and validated again
+struct CachedSource {
+    dev_t dev = 0;
+    ino_t ino = 0;
+    off_t size = 0;
+    struct timespec mtime = {};
+    string name;
+};
+
+// PL bitstreams are cached as .bin, converted once per content; RPU images
+// must be 32-bit ARM ELF files. Overlays are not cached: their file name
+// names their configfs directory.
+class ImageCache {
+public:
+    explicit ImageCache(size_t limit) : limit_(limit) {}
+    ~ImageCache() {
+        for (auto& entry : images_) munmap(entry.second.map, entry.second.size);
+    }
+
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    // Starts a request; the images it uses are not evicted during it
+    void begin_request() { request_++; }
+    // Caches fw_name (in /lib/firmware) if needed and returns its cached name
+    bool add(const string& fw_name, string& name, string& error);
+    const CachedImage* find(const string& name) const {
+        auto it = images_.find(name);
+        return it == images_.end() ? nullptr : &it->second;
     }
+    void list(ostream& os) const;
+
+private:
+    bool store(const string& fw_name, const unsigned char* data, size_t size,
+               CachedImage& image, string& error);
+    void evict(size_t incoming);
 
-    // Strategy 2: Sync Word (0xAA995566)
-    const vector<unsigned char> sync_word = {0xAA, 0x99, 0x55, 0x66};
-    auto sync_it = search(buffer.begin(), buffer.end(), sync_word.begin(), sync_word.end());
-    if (sync_it == buffer.end()) return false;
+    map<string, CachedImage> images_;    // By cached name
+    map<string, CachedSource> sources_;  // By firmware name
+    size_t limit_;
+    size_t bytes_ = 0;
+    uint64_t request_ = 0;
+};
 
-    // Backtrack to include padding
-    auto start_it = sync_it;
-    while (start_it != buffer.begin() && *(start_it - 1) == 0xFF) --start_it;
+// Set by the daemon; firmware names of cached images then resolve to CACHE_DIR
+ImageCache* image_cache = nullptr;
 
-    ofstream bin_file(bin_path, ios::binary);
-    bin_file.write((char*)&(*start_it), distance(start_it, buffer.end()));
+bool has_suffix(const string& name, const string& suffix) {
+    return name.length() > suffix.length() &&
+           name.compare(name.length() - suffix.length(), suffix.length(), suffix) == 0;
+}
+
+string firmware_path(const string& fw_name) {
+    if (image_cache && image_cache->find(fw_name)) return CACHE_DIR + "/" + fw_name;
+    return "/lib/firmware/" + fw_name;
+}
+
+// R5 firmware: 32-bit little-endian ARM
+bool is_arm_elf(const unsigned char* data, size_t size) {
+    if (size < sizeof(Elf32_Ehdr) || memcmp(data, ELFMAG, SELFMAG) != 0) return false;
+    uint16_t machine = data[offsetof(Elf32_Ehdr, e_machine)] |
+                       (data[offsetof(Elf32_Ehdr, e_machine) + 1] << 8);
+    return data[EI_CLASS] == ELFCLASS32 && data[EI_DATA] == ELFDATA2LSB && machine == EM_ARM;
+}
+
+// Validates and writes the cached file of an image
+bool ImageCache::store(const string& fw_name, const unsigned char* data, size_t size,
+                       CachedImage& image, string& error) {
+    size_t offset = 0, length = size;
+    if (has_suffix(fw_name, ".bit")) {
+        if (!parse_bit_header(data, size, offset, length) &&
+            !find_sync_word(data, size, offset, length)) {
+            error = "no configuration data in the bitstream";
+            return false;
+        }
+    } else if (has_suffix(fw_name, ".bin")) {
+        size_t sync_offset, sync_length;
+        if (!find_sync_word(data, size, sync_offset, sync_length)) {
+            error = "no sync word in the bitstream";
+            return false;
+        }
+    } else if (has_suffix(fw_name, ".elf")) {
+        if (!is_arm_elf(data, size)) {
+            error = "not a 32-bit ARM ELF image";
+            return false;
+        }
+    } else {
+        error = "not a .bit, .bin or .elf image";
+        return false;
+    }
+
+    evict(length);
+    string path = CACHE_DIR + "/" + image.name;
+    if (!write_file_atomic(path, data + offset, length, nullptr)) {
+        error = string("cannot write ") + path + ": " + strerror(errno);
+        return false;
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = string("cannot open ") + path + ": " + strerror(errno);
+        return false;
+    }
+    void* map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = string("cannot map ") + path + ": " + strerror(errno);
+        unlink(path.c_str());
+        return false;
+    }
+    if (mlock(map, length) != 0) {
+        log_line(cerr, "Warning: Cannot lock " + image.name + " in memory: " + strerror(errno));
+    }
+    image.map = map;
+    image.size = length;
+    image.fingerprint = fingerprint_of(length, fnv1a(data + offset, length));
+    return true;
+}
+
+bool ImageCache::add(const string& fw_name, string& name, string& error) {
+    string path = "/lib/firmware/" + fw_name;
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        error = "cannot read " + path;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    // Unchanged since it was cached: no read at all
+    auto src = sources_.find(fw_name);
+    if (src != sources_.end() && src->second.dev == st.st_dev && src->second.ino == st.st_ino &&
+        src->second.size == st.st_size && src->second.mtime.tv_sec == st.st_mtim.tv_sec &&
+        src->second.mtime.tv_nsec == st.st_mtim.tv_nsec && images_.count(src->second.name)) {
+        close(fd);
+        name = src->second.name;
+        images_[name].used = request_;
+        return true;
+    }
+
+    size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    const unsigned char* data = (const unsigned char*)map;
+
+    // Keyed by the content: the same image under another name shares the entry
+    char key[24];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)fnv1a(data, size));
+    name = CACHE_PREFIX + key + (has_suffix(fw_name, ".elf") ? ".elf" : ".bin");
+
+    bool ok = true;
+    if (!images_.count(name)) {
+        CachedImage image;
+        image.name = name;
+        image.sum = kr260hal::word_sum(data, size);
+        ok = store(fw_name, data, size, image, error);
+        if (ok) {
+            bytes_ += image.size;
+            images_[name] = image;
+            log_line(cout, "Cached " + fw_name + " as " + name + " (" +
+                           to_string((image.size + 1023) / 1024) + " KB)");
+        }
+    }
+    munmap(map, size);
+    if (!ok) return false;
+
+    CachedSource& entry = sources_[fw_name];
+    entry.dev = st.st_dev;
+    entry.ino = st.st_ino;
+    entry.size = st.st_size;
+    entry.mtime = st.st_mtim;
+    entry.name = name;
+    images_[name].used = request_;
+    return true;
+}
+
+// Drops the least recently used images until 'incoming' fits; images of the
+// running request stay, so a single request may exceed the limit
+void ImageCache::evict(size_t incoming) {
+    while (bytes_ + incoming > limit_) {
+        auto lru = images_.end();
+        for (auto it = images_.begin(); it != images_.end(); ++it) {
+            if (it->second.used != request_ && (lru == images_.end() || it->second.used < lru->second.used))
+                lru = it;
+        }
+        if (lru == images_.end()) return;
+
+        log_line(cout, "Evicting " + lru->first);
+        munmap(lru->second.map, lru->second.size);
+        unlink((CACHE_DIR + "/" + lru->first).c_str());
+        bytes_ -= lru->second.size;
+        for (auto it = sources_.begin(); it != sources_.end();) {
+            it = it->second.name == lru->first ? sources_.erase(it) : next(it);
+        }
+        images_.erase(lru);
+    }
+}
+
+void ImageCache::list(ostream& os) const {
+    for (auto& src : sources_) {
+        const CachedImage& image = images_.at(src.second.name);
+        char line[160];
+        snprintf(line, sizeof(line), "%-24s %s %8zu KB sum=0x%08x", src.first.c_str(),
+                 image.name.c_str(), (image.size + 1023) / 1024, image.sum);
+        os << line << endl;
+    }
+    os << images_.size() << " image(s), " << (bytes_ + 1023) / 1024 << " of "
+       << limit_ / 1024 << " KB" << endl;
+}
+
+// Record line of a domain ("pl", "rpu0", "rpu1"): "<firmware name> <fingerprint>"
+string fingerprint_record(const string& fw_name) {
+    const CachedImage* cached = image_cache ? image_cache->find(fw_name) : nullptr;
+    string fp = cached ? cached->fingerprint : file_fingerprint(firmware_path(fw_name));
+    return fp.empty() ? "" : fw_name + " " + fp;
+}
+
+bool fingerprint_matches(const string& domain, const string& record) {
+    return !record.empty() && read_sysfs(FINGERPRINT_DIR + domain, true) == record;
+}
+
+void save_fingerprint(const string& domain, const string& record) {
+    if (record.empty()) return;
+    if (mkdir(FINGERPRINT_DIR.c_str(), 0755) != 0 && errno != EEXIST) return;
+    ofstream file(FINGERPRINT_DIR + domain);
+    file << record << endl;
+}
+
+void clear_fingerprint(const string& domain) {
+    unlink((FINGERPRINT_DIR + domain).c_str());
+}
+
+// --- Checksums ---
+
+// Word sum (kr260hal::word_sum) of a firmware file. With a bulk channel the
+// file is staged in the carveout a carveout-full at a time and the RPU sums
+// it with its CSU DMA; without one, or should the RPU fail, the APU does.
+bool image_checksum(const string& path, kr260hal::BulkChannel* bulk, uint32_t& sum) {
+    sum = 0;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    if (size == 0) {
+        close(fd);
+        return true;
+    }
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+    madvise(map, size, MADV_SEQUENTIAL);
+    const unsigned char* data = (const unsigned char*)map;
+
+    // Chunks are whole words, so their sums add up to the file's
+    const size_t chunk = bulk ? bulk->ddr_size() & ~(size_t)(BULK_ALIGN - 1) : size;
+    for (size_t pos = 0; pos < size; pos += chunk) {
+        size_t n = min(chunk, size - pos);
+        uint32_t part = 0;
+        if (bulk && bulk->put(0, data + pos, n) && bulk->checksum(0, n, part).acked) {
+            sum += part;
+        } else {
+            bulk = nullptr;
+            sum = kr260hal::word_sum(data + pos, n, sum);
+        }
+    }
+    munmap(map, size);
     return true;
 }
 
 // --- Loading Functions ---
 
-void manage_rpu(bool start) {
+string rpu_base(int core) {
+    return RPU_BASE_PREFIX + to_string(core) + "/";
+}
+
+bool manage_rpu(int core, bool start) {
     string action = start ? "start" : "stop";
-    string current = read_sysfs(RPU_BASE + "state", true);
+    string want = start ? "running" : "offline";
+    string state_path = rpu_base(core) + "state";
+    string current = read_sysfs(state_path, true);
     
-    if ((start && current == "running") || (!start && current == "offline")) {
+    if (current == want) {
         // Already in desired state
-        return;
+        return true;
+    }
+    log_line(cout, string(start ? "Starting" : "Stopping") + " RPU" + to_string(core) + "...");
+    if (!write_sysfs(state_path, action)) return false;
+
+    if (!kr260hal::sysfs_wait_for(state_path, want, RPU_STATE_TIMEOUT_MS, current)) {
+        log_line(cerr, "Warning: RPU" + to_string(core) + " state is " + current +
+                       " (expected " + want + ")");
+        return false;
+    }
+    return true;
+}
+
+// Asks the running firmware to save its state for the next image and to
+// hold its outputs until then (RPU_CMD_HANDOFF, rpu_shm.h). Returns true if
+// it did; otherwise the next image starts cold.
+bool handoff_rpu(int core) {
+    string name = "RPU" + to_string(core);
+    if (read_sysfs(rpu_base(core) + "state", true) != "running") return false;
+
+    kr260hal::IpiTransport ipi;
+    if (!ipi.open(core)) {
+        log_line(cerr, "Warning: Cannot open the " + name + " IPI channel, no state handoff");
+        return false;
+    }
+    uint32_t results[RPU_MSG_MAX_RESULTS] = {};
+    kr260hal::IpiResult result = ipi.send_msg(RPU_CMD_HANDOFF, {}, results);
+    if (result.acked && result.ack_val == RPU_CMD_STATUS_OK) {
+        log_line(cout, name + " state handed off to the next image");
+        return true;
+    }
+    if (!result.acked) {
+        log_line(cerr, "Warning: " + name + " did not answer the handoff, starting cold");
+    } else if (result.ack_val == RPU_CMD_STATUS_BADOP) {
+        log_line(cout, name + " firmware has no state handoff, starting cold");
+    } else {
+        log_line(cout, name + " refused the handoff (waveform playing), starting cold");
+    }
+    return false;
+}
+
+// Drops a saved state no image has taken, so the next start is cold
+void discard_handoff(int core) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(HANDOFF_ADDR(core), HANDOFF_SIZE)) return;
+    if (blk.read<kr260hal::handoff::Magic>() == HANDOFF_MAGIC) {
+        blk.write<kr260hal::handoff::Magic>(0);
+        kr260hal::barrier::complete();
+    }
+}
+
+// Reports how long the outputs were held once the new image took the state
+void report_resume(int core) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(HANDOFF_ADDR(core), HANDOFF_SIZE, false)) return;
+
+    string name = "RPU" + to_string(core);
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(RPU_RESUME_TIMEOUT_MS);
+    while (blk.read_acquire<kr260hal::handoff::Magic>() != HANDOFF_RESUMED) {
+        if (chrono::steady_clock::now() >= deadline) {
+            log_line(cerr, "Warning: " + name + " image did not resume the handed-off state");
+            return;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
     }
-    cout << (start ? "Starting" : "Stopping") << " RPU..." << endl;
-    write_sysfs(RPU_BASE + "state", action);
+    char line[96];
+    snprintf(line, sizeof(line), "%s resumed the handed-off state after %.1f ms",
+             name.c_str(), blk.read<kr260hal::handoff::GapUs>() / 1000.0);
+    log_line(cout, line);
 }
 
-void load_rpu(const string& fw_name) {
-    if (fw_name.empty()) return;
+// Stops the core and sets its firmware; the core is started by start_rpu().
+// With handoff the running firmware saves its state first (handed_off).
+bool stage_rpu(int core, const string& fw_name, bool handoff, bool& handed_off) {
+    handed_off = false;
+    if (fw_name.empty()) return false;
     
-    string fw_path = "/lib/firmware/" + fw_name;
-    if (!file_exists(fw_path)) cerr << "Warning: " << fw_name << " not found in /lib/firmware/" << endl;
+    string fw_path = firmware_path(fw_name);
+    if (!file_exists(fw_path)) log_line(cerr, "Warning: " + fw_name + " not found in /lib/firmware/");
+    if (!file_exists(rpu_base(core))) {
+        log_line(cerr, "Error: " + rpu_base(core) + " not found (RPU" + to_string(core) +
+                       " needs the R5 cluster in split mode)");
+        return false;
+    }
+
+    handed_off = handoff && handoff_rpu(core);
+    if (!handed_off) discard_handoff(core);
 
-    manage_rpu(false); // Stop
-    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    // remoteproc only accepts a new firmware name while the core is offline
+    if (!manage_rpu(core, false)) {
+        log_line(cerr, "Error: Cannot stop RPU" + to_string(core) + ", " + fw_name +
+                       " not loaded");
+        if (handed_off) discard_handoff(core);
+        handed_off = false;
+        return false;
+    }
     
-    cout << "Loading RPU Firmware: " << fw_name << endl;
-    if (write_sysfs(RPU_BASE + "firmware", fw_name)) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        manage_rpu(true); // Start
+    log_line(cout, "Loading RPU" + to_string(core) + " Firmware: " + fw_name);
+    return write_sysfs(rpu_base(core) + "firmware", fw_name);
+}
+
+// Waits for the ready word of the image just started; "running" only means
+// the core left reset. False after RPU_READY_TIMEOUT_MS: the image may be
+// stuck in its setup, or never publish the word (older images, and the
+// RPU_BENCH / RPU_MEMBENCH builds)
+bool wait_rpu_ready(int core, const kr260hal::MemMap& window,
+                    chrono::steady_clock::time_point start) {
+    string name = "RPU" + to_string(core);
+    auto deadline = start + chrono::milliseconds(RPU_READY_TIMEOUT_MS);
+    while (window.read_acquire<kr260hal::shm::Ready>() != SHM_READY_MAGIC) {
+        if (chrono::steady_clock::now() >= deadline) {
+            log_line(cerr, "Warning: " + name + " firmware not ready after " +
+                           to_string(RPU_READY_TIMEOUT_MS) +
+                           " ms (stuck in its setup, or built without the ready word)");
+            return false;
+        }
+        this_thread::sleep_for(chrono::microseconds(RPU_READY_POLL_US));
     }
+    uint32_t version = window.read<kr260hal::shm::ReadyVersion>();
+    char line[128];
+    snprintf(line, sizeof(line), "%s ready after %.1f ms (ABI %u.%u, features 0x%x)",
+             name.c_str(),
+             chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(),
+             (unsigned)SHM_ABI_VERSION_MAJOR(version), (unsigned)(version & 0xFFFF),
+             (unsigned)window.read<kr260hal::shm::ReadyFeatures>());
+    log_line(cout, line);
+    return true;
 }
 
-void load_pl(const string& fw_name) {
-    if (fw_name.empty()) return;
+bool start_rpu(int core, bool handed_off) {
+    // The ready word is in the default window, OCM or the IPI message RAM,
+    // which stays accessible while the core is stopped
+    kr260hal::MemMap window;
+    bool starting = read_sysfs(rpu_base(core) + "state", true) != "running";
+    bool wait_ready = starting && window.map_phys(SHARED_MEM_ADDR_CORE(core), SHARED_MEM_SIZE);
+    if (wait_ready) {
+        // The previous image's word must not count
+        window.write<kr260hal::shm::Ready>(0);
+        kr260hal::barrier::complete();
+    } else if (starting) {
+        log_line(cerr, "Warning: Cannot map the RPU" + to_string(core) +
+                       " window, trusting the remoteproc state");
+    }
+
+    auto start = chrono::steady_clock::now();
+    if (!manage_rpu(core, true)) return false;
+    if (wait_ready && !wait_rpu_ready(core, window, start)) {
+        // Without the word only remoteproc can tell whether the core runs
+        if (read_sysfs(rpu_base(core) + "state", true) != "running") {
+            log_line(cerr, "Error: RPU" + to_string(core) + " is not running");
+            return false;
+        }
+        log_line(cerr, "Warning: Trusting the remoteproc state of RPU" + to_string(core));
+    }
+    log_line(cout, "RPU" + to_string(core) + " Running.");
+    if (handed_off) report_resume(core);
+    return true;
+}
+
+// The recorded image is only trusted while the domain is still up with it
+bool pl_up_to_date(const string& record) {
+    return read_sysfs(PL_STATE_PATH, true) == "operating" && fingerprint_matches("pl", record);
+}
+
+bool rpu_up_to_date(int core, const string& fw_name, const string& record) {
+    return read_sysfs(rpu_base(core) + "state", true) == "running" &&
+           read_sysfs(rpu_base(core) + "firmware", true) == fw_name &&
+           fingerprint_matches("rpu" + to_string(core), record);
+}
+
+// fpga0 is one manager: its flags, firmware and state belong to one load at
+// a time
+mutex fpga_mutex;
+
+// Full reconfiguration reprograms the whole fabric; a partial bitstream
+// (DFX) only rewrites its reconfigurable region and the static logic,
+// including the AXI GPIO used by the RPU, keeps running
+bool load_pl(const string& fw_name, bool partial) {
+    if (fw_name.empty()) return false;
 
     string final_name = fw_name;
-    string fw_path = "/lib/firmware/" + fw_name;
+    string fw_path = firmware_path(fw_name);
     
-    if (!file_exists(fw_path)) cerr << "Warning: " << fw_name << " not found in /lib/firmware/" << endl;
+    if (!file_exists(fw_path)) log_line(cerr, "Warning: " + fw_name + " not found in /lib/firmware/");
 
     // Handle .bit conversion
     if (fw_name.length() > 4 && fw_name.substr(fw_name.length() - 4) == ".bit") {
         string bin_name = fw_name.substr(0, fw_name.length() - 4) + ".bin";
-        cout << "Converting " << fw_name << " to " << bin_name << "..." << endl;
-        if (convert_bit_to_bin(fw_path, "/lib/firmware/" + bin_name)) {
+        bool cached = false;
+        if (convert_bit_to_bin(fw_path, "/lib/firmware/" + bin_name, cached)) {
+            log_line(cout, (cached ? "Using cached " : "Converted " + fw_name + " to ") + bin_name);
             final_name = bin_name;
         } else {
-            cerr << "Failed to convert .bit. Trying original." << endl;
+            log_line(cerr, "Failed to convert .bit. Trying original.");
         }
     }
 
-    cout << "Loading PL Firmware: " << final_name << endl;
-    write_sysfs(PL_FLAGS_PATH, "0"); // Full reconfiguration
+    // A compressed bitstream (PL_BITSTREAM_COMPRESS) loads like any other: the
+    // size shows what the compression saved
+    struct stat st;
+    string size_note;
+    if (stat(firmware_path(final_name).c_str(), &st) == 0) {
+        size_note = " (" + to_string((st.st_size + 1023) / 1024) + " KB)";
+    }
+    lock_guard<mutex> lock(fpga_mutex);
+    log_line(cout, string("Loading PL ") + (partial ? "Partial " : "") + "Firmware: " + final_name + size_note);
+    write_sysfs(PL_FLAGS_PATH, partial ? PL_FLAGS_PARTIAL : PL_FLAGS_FULL);
     write_sysfs(PL_FIRMWARE_PATH, final_name);
     
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    string state = read_sysfs(PL_STATE_PATH);
-    if (state != "operating") cerr << "Warning: PL State is " << state << endl;
-    else cout << "PL Loaded Successfully." << endl;
+    string state;
+    if (!kr260hal::sysfs_wait_for(PL_STATE_PATH, "operating", PL_STATE_TIMEOUT_MS, state)) {
+        log_line(cerr, "Warning: PL State is " + state);
+        return false;
+    }
+    log_line(cout, "PL Loaded Successfully.");
+    return true;
+}
+
+// Partial bitstreams loaded by the RPU0 firmware (BULK_OP_PCAP, RPU_PCAP=1)
+// share its bulk channel, which serves one user at a time
+mutex pcap_mutex;
+
+// Loads a partial bitstream through the RPU0 firmware instead of
+// fpga_manager: the configuration data is staged in the bulk carveout a
+// carveout-full at a time and the RPU streams each piece into the PCAP with
+// its CSU DMA. fpga_manager is not involved, so its state does not change.
+// 'sent' tells whether anything reached the PCAP; if not, the caller may
+// still load through fpga_manager.
+bool load_pl_rpu(const string& fw_name, bool& sent) {
+    sent = false;
+    string fw_path = firmware_path(fw_name);
+    int fd = open(fw_path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        log_line(cerr, "Error: Cannot read " + fw_path);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        log_line(cerr, "Error: Cannot map " + fw_path);
+        return false;
+    }
+    const unsigned char* data = (const unsigned char*)map;
+
+    // A .bit file carries its data big-endian, the sync word as AA 99 55 66;
+    // a bootgen .bin has the bytes of each word swapped already
+    static const unsigned char sync_swapped[] = {0x66, 0x55, 0x99, 0xAA};
+    size_t offset = 0, length = size;
+    uint32_t flags = 0;
+    if (has_suffix(fw_name, ".bit")) {
+        if (!parse_bit_header(data, size, offset, length)) find_sync_word(data, size, offset, length);
+    }
+    size_t sync_offset, sync_length;
+    if (find_sync_word(data + offset, length, sync_offset, sync_length)) {
+        flags = BULK_PCAP_SWAP;
+    } else if (search(data + offset, data + offset + length, sync_swapped,
+                      sync_swapped + sizeof(sync_swapped)) == data + offset + length) {
+        log_line(cerr, "Error: No sync word in " + fw_name);
+        munmap(map, size);
+        return false;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    lock_guard<mutex> lock(pcap_mutex);
+    kr260hal::IpiTransport ipi;
+    kr260hal::BulkChannel bulk;
+    if (!ipi.open(0) || !bulk.open(ipi)) {
+        log_line(cerr, "Warning: No RPU0 bulk channel for the PCAP load");
+        munmap(map, size);
+        return false;
+    }
+
+    log_line(cout, "Loading PL Partial Firmware through RPU0: " + fw_name);
+    // Pieces are whole words, so a swapped word never straddles two of them
+    const size_t chunk = bulk.ddr_size() & ~(size_t)(BULK_ALIGN - 1);
+    auto t0 = chrono::steady_clock::now();
+    double dma_us = 0;
+    bool ok = true;
+    for (size_t pos = 0; ok && pos < length; pos += chunk) {
+        size_t n = min(chunk, length - pos);
+        kr260hal::IpiResult result;
+        if (!bulk.put(0, data + offset + pos, n)) {
+            ok = false;
+            break;
+        }
+        result = bulk.pcap(0, n, flags);
+        dma_us += bulk.dma_us();
+        if (!result.acked) {
+            if (result.ack_val == RPU_CMD_STATUS_BADOP) {
+                log_line(cerr, "Warning: The RPU0 firmware has no PCAP loader (RPU_PCAP=1)");
+            } else {
+                sent = true;
+                log_line(cerr, "Error: RPU0 PCAP load of " + fw_name + " failed (status " +
+                               to_string(result.ack_val) + ")");
+            }
+            ok = false;
+            break;
+        }
+        sent = true;
+    }
+    munmap(map, size);
+    if (!ok) return false;
+
+    char line[128];
+    snprintf(line, sizeof(line), "PL Partial Loaded by RPU0 in %.1f ms (PCAP %.1f ms)",
+             chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count(),
+             dma_us / 1000.0);
+    log_line(cout, line);
+    return true;
+}
+
+// configfs directory of an overlay: its file name without the extension
+string overlay_dir(const string& dtbo_name) {
+    string name = dtbo_name.substr(0, dtbo_name.rfind('.'));
+    replace(name.begin(), name.end(), '/', '_');
+    return OVERLAY_CONFIGFS_PATH + name;
+}
+
+// Applies a device-tree overlay (.dtbo in /lib/firmware) through configfs.
+// An overlay of the same name is removed first, so a region's devices can
+// be swapped together with its partial bitstream.
+bool apply_overlay(const string& dtbo_name) {
+    if (dtbo_name.empty()) return true;
+
+    if (!file_exists(OVERLAY_CONFIGFS_PATH)) {
+        log_line(cerr, "Error: " + OVERLAY_CONFIGFS_PATH + " not found (configfs not mounted?)");
+        return false;
+    }
+    if (!file_exists("/lib/firmware/" + dtbo_name))
+        log_line(cerr, "Warning: " + dtbo_name + " not found in /lib/firmware/");
+
+    string dir = overlay_dir(dtbo_name);
+    string name = dir.substr(OVERLAY_CONFIGFS_PATH.length());
+
+    if (file_exists(dir)) {
+        log_line(cout, "Removing Overlay: " + name);
+        if (rmdir(dir.c_str()) != 0) {
+            log_line(cerr, "Error: Cannot remove " + dir + ": " + strerror(errno));
+            return false;
+        }
+    }
+    if (mkdir(dir.c_str(), 0755) != 0) {
+        log_line(cerr, "Error: Cannot create " + dir + ": " + strerror(errno));
+        return false;
+    }
+
+    log_line(cout, "Applying Overlay: " + dtbo_name);
+    if (!write_sysfs(dir + "/path", dtbo_name)) {
+        rmdir(dir.c_str());
+        return false;
+    }
+    string status = read_sysfs(dir + "/status", true);
+    if (status != "applied") {
+        log_line(cerr, "Warning: Overlay status is " + status);
+        return false;
+    }
+    return true;
+}
+
+// --- Load Steps ---
+
+// One image to load. Steps whose dependencies ('after') are done run
+// concurrently, except that steps programming the PL (full or partial) run
+// one at a time whatever the manifest says; an RPU core is stopped and given
+// its firmware right away and only started once its dependencies are done.
+enum StepKind { STEP_PL, STEP_PARTIAL, STEP_RPU, STEP_OVERLAY };
+enum StepState { STEP_PENDING, STEP_DONE, STEP_FAILED };
+
+struct LoadStep {
+    string id;               // "pl", "rpu0", "partial <name>", "overlay <name>"
+    StepKind kind;
+    string firmware;
+    int core = 0;
+    vector<string> after;
+    bool verify = false;     // Manifest 'checksum': expected word sum of the image
+    uint32_t checksum = 0;
+    bool handoff = true;     // RPU: the running firmware hands its state over
+    bool rpu_pcap = false;   // Partial: loaded by the RPU0 firmware, not fpga_manager
+
+    bool reload = true;
+    string record;
+    bool handed_off = false;
+    StepState state = STEP_PENDING;
+    string result;
+    double ms = 0;
+};
+
+LoadStep make_step(const string& id, StepKind kind, const string& firmware, int core,
+                   const vector<string>& after) {
+    LoadStep step;
+    step.id = id;
+    step.kind = kind;
+    step.firmware = firmware;
+    step.core = core;
+    step.after = after;
+    return step;
+}
+
+// Full and partial bitstreams share the configuration port
+bool touches_pl(const LoadStep& step) {
+    return step.kind == STEP_PL || step.kind == STEP_PARTIAL;
+}
+
+LoadStep* find_step(vector<LoadStep>& steps, const string& id) {
+    for (auto& step : steps) {
+        if (step.id == id) return &step;
+    }
+    return nullptr;
+}
+
+string trim(const string& str) {
+    size_t first = str.find_first_not_of(" \t\r");
+    if (first == string::npos) return "";
+    size_t last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+}
+
+// Reads an INI manifest:
+//   [pl]              full bitstream        firmware = gpio_led.bit
+//   [rpu0] / [rpu1]   RPU core firmware     firmware = gpio_app.elf
+//   [partial <name>]  partial bitstream     firmware = rp0_partial.bit
+//   [overlay <name>]  device-tree overlay   firmware = rp0.dtbo
+// Each section may list the steps it waits for: after = pl, partial rp0,
+// and the word sum its image must have: checksum = 0x1234abcd.
+// Without 'after', RPUs and partials wait for [pl] and an overlay waits for
+// the partial of the same name, or for [pl].
+bool parse_manifest(const string& path, vector<LoadStep>& steps) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        cerr << "Error: Cannot open " << path << endl;
+        return false;
+    }
+
+    vector<char> has_after;
+    string line;
+    int line_no = 0;
+    while (getline(file, line)) {
+        line_no++;
+        line = trim(line.substr(0, line.find_first_of("#;")));
+        if (line.empty()) continue;
+
+        if (line.front() == '[' && line.back() == ']') {
+            LoadStep step;
+            string id = trim(line.substr(1, line.length() - 2));
+            string type = id.substr(0, id.find(' '));
+            string name = trim(id.substr(type.length()));
+            if (type == "pl" && name.empty()) {
+                step.kind = STEP_PL;
+            } else if ((type == "rpu0" || type == "rpu1") && name.empty()) {
+                step.kind = STEP_RPU;
+                step.core = type[3] - '0';
+            } else if (type == "partial" && !name.empty()) {
+                step.kind = STEP_PARTIAL;
+            } else if (type == "overlay" && !name.empty()) {
+                step.kind = STEP_OVERLAY;
+            } else {
+                cerr << path << ":" << line_no << ": unknown section [" << id << "]" << endl;
+                return false;
+            }
+            step.id = name.empty() ? type : type + " " + name;
+            if (find_step(steps, step.id)) {
+                cerr << path << ":" << line_no << ": duplicate section [" << step.id << "]" << endl;
+                return false;
+            }
+            steps.push_back(step);
+            has_after.push_back(0);
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == string::npos || steps.empty()) {
+            cerr << path << ":" << line_no << ": expected key = value in a section" << endl;
+            return false;
+        }
+        string key = trim(line.substr(0, eq));
+        string value = trim(line.substr(eq + 1));
+        if (key == "firmware") {
+            steps.back().firmware = value;
+        } else if (key == "after") {
+            size_t pos = 0;
+            while (pos <= value.length()) {
+                size_t comma = value.find(',', pos);
+                if (comma == string::npos) comma = value.length();
+                string dep = trim(value.substr(pos, comma - pos));
+                if (!dep.empty()) steps.back().after.push_back(dep);
+                pos = comma + 1;
+            }
+            has_after.back() = 1;
+        } else if (key == "checksum") {
+            char* end = nullptr;
+            errno = 0;
+            unsigned long sum = strtoul(value.c_str(), &end, 0);
+            if (value.empty() || *end != '\0' || errno != 0 || sum > 0xFFFFFFFFUL) {
+                cerr << path << ":" << line_no << ": bad checksum '" << value << "'" << endl;
+                return false;
+            }
+            steps.back().verify = true;
+            steps.back().checksum = (uint32_t)sum;
+        } else {
+            cerr << path << ":" << line_no << ": unknown key '" << key << "'" << endl;
+            return false;
+        }
+    }
+
+    bool have_pl = find_step(steps, "pl") != nullptr;
+    for (size_t i = 0; i < steps.size(); i++) {
+        LoadStep& step = steps[i];
+        if (step.firmware.empty()) {
+            cerr << path << ": [" << step.id << "] has no firmware" << endl;
+            return false;
+        }
+        if (has_after[i] || step.kind == STEP_PL) continue;
+        if (step.kind == STEP_OVERLAY && find_step(steps, "partial" + step.id.substr(7))) {
+            step.after.push_back("partial" + step.id.substr(7));
+        } else if (have_pl) {
+            step.after.push_back("pl");
+        }
+    }
+    return true;
+}
+
+// Rejects unknown dependencies and cycles; orders 'steps' so every step
+// comes after its dependencies
+bool sort_steps(vector<LoadStep>& steps) {
+    vector<LoadStep> sorted;
+    vector<char> placed(steps.size(), 0);
+
+    for (auto& step : steps) {
+        for (auto& dep : step.after) {
+            if (!find_step(steps, dep)) {
+                cerr << "Error: [" << step.id << "] depends on unknown step '" << dep << "'" << endl;
+                return false;
+            }
+        }
+    }
+    while (sorted.size() < steps.size()) {
+        bool progress = false;
+        for (size_t i = 0; i < steps.size(); i++) {
+            if (placed[i]) continue;
+            bool ready = all_of(steps[i].after.begin(), steps[i].after.end(),
+                                [&sorted](const string& dep) { return find_step(sorted, dep) != nullptr; });
+            if (!ready) continue;
+            sorted.push_back(steps[i]);
+            placed[i] = 1;
+            progress = true;
+        }
+        if (!progress) {
+            cerr << "Error: dependency cycle between the manifest steps" << endl;
+            return false;
+        }
+    }
+    steps = sorted;
+    return true;
+}
+
+// Daemon: moves the images of the steps into the cache and loads them from
+// there (dependency order). A step whose image cannot be cached, and the
+// steps waiting for it, fail before anything is touched.
+void cache_steps(vector<LoadStep>& steps) {
+    for (auto& step : steps) {
+        auto failed = find_if(step.after.begin(), step.after.end(), [&steps](const string& dep) {
+            return find_step(steps, dep)->state == STEP_FAILED;
+        });
+        if (failed != step.after.end()) {
+            step.reload = false;
+            step.state = STEP_FAILED;
+            step.result = "not run, " + *failed + " failed";
+            continue;
+        }
+        if (step.kind == STEP_OVERLAY) continue;
+        string name, error;
+        if (!image_cache->add(step.firmware, name, error)) {
+            log_line(cerr, "Error: " + step.firmware + ": " + error);
+            step.reload = false;
+            step.state = STEP_FAILED;
+            step.result = "not cached";
+            continue;
+        }
+        step.firmware = name;
+    }
+}
+
+// Decides which steps actually load (dependency order): unchanged images
+// that are still up are skipped, and a step waiting for a reloaded
+// bitstream is reloaded as well. Partial bitstreams always load.
+void plan_steps(vector<LoadStep>& steps, bool force) {
+    for (auto& step : steps) {
+        if (step.state == STEP_FAILED) continue;
+        bool dep_reload = any_of(step.after.begin(), step.after.end(), [&steps](const string& dep) {
+            LoadStep* d = find_step(steps, dep);
+            return touches_pl(*d) && d->reload;
+        });
+        switch (step.kind) {
+            case STEP_PL:
+                step.record = fingerprint_record(step.firmware);
+                step.reload = force || dep_reload || !pl_up_to_date(step.record);
+                break;
+            case STEP_RPU:
+                step.record = fingerprint_record(step.firmware);
+                step.reload = force || dep_reload ||
+                              !rpu_up_to_date(step.core, step.firmware, step.record);
+                break;
+            case STEP_PARTIAL:
+                step.reload = true;
+                break;
+            case STEP_OVERLAY:
+                step.reload = force || dep_reload || !file_exists(overlay_dir(step.firmware));
+                break;
+        }
+        if (!step.reload) {
+            step.state = STEP_DONE;
+            step.result = "up to date";
+        }
+    }
+}
+
+// Checks the images of the reloaded steps that carry a checksum before any
+// domain is touched (dependency order): a mismatching step and the steps
+// waiting for it are failed here, so no core is stopped for them
+void verify_steps(vector<LoadStep>& steps) {
+    bool any = any_of(steps.begin(), steps.end(),
+                      [](const LoadStep& step) { return step.reload && step.verify; });
+    if (!any) return;
+
+    // The RPU0 firmware still running serves the bulk channel, if it has one;
+    // opened for the first image that is not cached
+    kr260hal::IpiTransport ipi;
+    kr260hal::BulkChannel bulk;
+    kr260hal::BulkChannel* channel = nullptr;
+    bool channel_tried = false;
+
+    for (auto& step : steps) {
+        if (!step.reload) continue;
+        auto failed = find_if(step.after.begin(), step.after.end(), [&steps](const string& dep) {
+            return find_step(steps, dep)->state == STEP_FAILED;
+        });
+        if (failed != step.after.end()) {
+            step.reload = false;
+            step.state = STEP_FAILED;
+            step.result = "not run, " + *failed + " failed";
+            continue;
+        }
+        if (!step.verify) continue;
+
+        uint32_t sum = 0;
+        bool read = true;
+        auto t0 = chrono::steady_clock::now();
+        const CachedImage* cached = image_cache ? image_cache->find(step.firmware) : nullptr;
+        if (cached) {
+            sum = cached->sum;  // Summed from the source when it was cached
+        } else {
+            if (!channel_tried && ipi.open(0) && bulk.open(ipi)) channel = &bulk;
+            channel_tried = true;
+            read = image_checksum(firmware_path(step.firmware), channel, sum);
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        if (read && sum == step.checksum) {
+            char line[128];
+            snprintf(line, sizeof(line), "Checksum of %s: 0x%08x (%.1f ms%s)", step.firmware.c_str(), sum, ms,
+                     cached ? ", cached" : "");
+            log_line(cout, line);
+            continue;
+        }
+        if (read) {
+            char line[128];
+            snprintf(line, sizeof(line), "Error: %s has checksum 0x%08x, expected 0x%08x",
+                     step.firmware.c_str(), sum, step.checksum);
+            log_line(cerr, line);
+        } else {
+            log_line(cerr, "Error: Cannot read " + step.firmware + " to verify it");
+        }
+        step.reload = false;
+        step.state = STEP_FAILED;
+        step.result = read ? "checksum mismatch" : "unreadable";
+        step.ms = ms;
+    }
+}
+
+bool run_step(LoadStep& step, bool staged) {
+    switch (step.kind) {
+        case STEP_PL:
+            if (!load_pl(step.firmware, false)) return false;
+            save_fingerprint("pl", step.record);
+            return true;
+        case STEP_PARTIAL:
+            if (step.rpu_pcap) {
+                bool sent = false;
+                if (load_pl_rpu(step.firmware, sent)) return true;
+                if (sent) return false;
+                log_line(cerr, "Falling back to fpga_manager for " + step.firmware);
+            }
+            return load_pl(step.firmware, true);
+        case STEP_RPU:
+            if (!staged || !start_rpu(step.core, step.handed_off)) return false;
+            save_fingerprint("rpu" + to_string(step.core), step.record);
+            return true;
+        case STEP_OVERLAY:
+            return apply_overlay(step.firmware);
+    }
+    return false;
+}
+
+// Runs every step on its own thread as soon as its dependencies are done
+// and, for a PL step, no other PL step is running. A step whose dependency
+// failed is not run. Returns true if all succeeded.
+bool run_steps(vector<LoadStep>& steps) {
+    mutex state_mutex;
+    condition_variable state_changed;
+    bool pl_busy = false;
+    vector<thread> workers;
+    auto t_start = chrono::steady_clock::now();
+
+    for (auto& step : steps) {
+        if (!step.reload) continue;
+        // Records of reloaded domains are dropped until the load succeeds
+        if (touches_pl(step)) clear_fingerprint("pl");
+        if (step.kind == STEP_RPU) clear_fingerprint("rpu" + to_string(step.core));
+    }
+
+    for (auto& step : steps) {
+        if (!step.reload) continue;
+        workers.emplace_back([&steps, &step, &state_mutex, &state_changed, &pl_busy] {
+            auto t0 = chrono::steady_clock::now();
+            bool staged = step.kind == STEP_RPU &&
+                          stage_rpu(step.core, step.firmware, step.handoff, step.handed_off);
+
+            string failed_dep;
+            {
+                unique_lock<mutex> lock(state_mutex);
+                state_changed.wait(lock, [&] {
+                    for (auto& dep : step.after) {
+                        StepState dep_state = find_step(steps, dep)->state;
+                        if (dep_state == STEP_PENDING) return false;
+                        if (dep_state == STEP_FAILED) failed_dep = dep;
+                    }
+                    return !failed_dep.empty() || !touches_pl(step) || !pl_busy;
+                });
+                if (failed_dep.empty() && touches_pl(step)) pl_busy = true;
+            }
+
+            bool ok = false;
+            string result;
+            if (!failed_dep.empty()) {
+                result = "not run, " + failed_dep + " failed";
+            } else {
+                ok = run_step(step, staged);
+                result = ok ? "loaded" : "failed";
+            }
+
+            lock_guard<mutex> lock(state_mutex);
+            if (failed_dep.empty() && touches_pl(step)) pl_busy = false;
+            step.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+            step.result = result;
+            step.state = ok ? STEP_DONE : STEP_FAILED;
+            state_changed.notify_all();
+        });
+    }
+    for (auto& t : workers) t.join();
+
+    double total_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t_start).count();
+    bool all_ok = true;
+    cout << endl << "Step              Result                         Time" << endl;
+    for (auto& step : steps) {
+        char line[128];
+        snprintf(line, sizeof(line), "%-17s %-30s %8.1f ms", step.id.c_str(), step.result.c_str(), step.ms);
+        cout << line << endl;
+        if (step.state != STEP_DONE) all_ok = false;
+    }
+    char line[64];
+    snprintf(line, sizeof(line), "%-48s %8.1f ms", "Total", total_ms);
+    cout << line << endl;
+    return all_ok;
 }
 
 void print_usage(const char* prog) {
-    cout << "Usage: " << prog << " [firmware_files...]" << endl;
+    cout << "Usage: " << prog << " [--core <0|1>] [--split] [--partial [--rpu-pcap]] [--overlay <f.dtbo>] [--force] [--no-handoff] [--manifest <file>] [firmware_files...]" << endl;
+    cout << "       " << prog << " --checksum <file>" << endl;
+    cout << "       " << prog << " --daemon <socket> [--cache-mb <n>]" << endl;
     cout << "  Auto-detects .bit/.bin (PL) and .elf (RPU)." << endl;
+    cout << "  --core <n>  Load the .elf on RPU core n (default 0)" << endl;
+    cout << "  --split     Load both cores: the .elf on RPU0, " << DEFAULT_RPU1_FW << " on RPU1" << endl;
+    cout << "  --partial   Load the .bit/.bin as a partial bitstream; the RPUs keep running" << endl;
+    cout << "  --rpu-pcap  Have the RPU0 firmware load partial bitstreams through its PCAP" << endl;
+    cout << "              (RPU_PCAP=1) instead of fpga_manager" << endl;
+    cout << "  --overlay <f.dtbo>  Apply a device-tree overlay after the PL is loaded" << endl;
+    cout << "  --force     Reload even if the same images are already running" << endl;
+    cout << "  --no-handoff  Restart the RPU firmware cold instead of handing its state" << endl;
+    cout << "                (mode, LEDs, pattern schedule) to the new image" << endl;
+    cout << "  --manifest <file>   Load the images listed in an INI manifest instead" << endl;
+    cout << "  --checksum <file>   Print the word sum of an image, for a manifest 'checksum'" << endl;
+    cout << "  --daemon <socket>   Serve load requests (the options above, one request per line)" << endl;
+    cout << "                      on a UNIX socket, loading the images from a cache in RAM" << endl;
+    cout << "  --cache-mb <n>      Size of the daemon's image cache (default " << DEFAULT_CACHE_MB << ")" << endl;
     cout << "  Defaults: " << DEFAULT_RPU_FW << ", " << DEFAULT_PL_FW << endl;
 }
 
-// --- Main ---
-
-int main(int argc, char* argv[]) {
-    if (geteuid() != 0) cerr << "Warning: Run as root." << endl;
-
+// One load: the command line, or one request of the daemon
+int run_load(const vector<string>& args, const char* prog) {
     string rpu_fw = DEFAULT_RPU_FW;
     string pl_fw = DEFAULT_PL_FW;
+    int core = 0;
+    bool split = false;
+    bool partial = false;
+    bool force = false;
+    bool handoff = true;
+    bool rpu_pcap = false;
+    string overlay;
+    string manifest;
 
-    for (int i = 1; i < argc; i++) {
-        string arg = argv[i];
+    for (size_t i = 0; i < args.size(); i++) {
+        const string& arg = args[i];
+        bool has_value = i + 1 < args.size();
         if (arg == "-h" || arg == "--help") {
-            print_usage(argv[0]);
+            print_usage(prog);
             return 0;
         }
+        if (arg == "--core" && has_value) {
+            core = atoi(args[++i].c_str());
+            if (core != 0 && core != 1) {
+                print_usage(prog);
+                return 1;
+            }
+            if (core == 1 && rpu_fw == DEFAULT_RPU_FW) rpu_fw = DEFAULT_RPU1_FW;
+            continue;
+        }
+        if (arg == "--split") {
+            split = true;
+            continue;
+        }
+        if (arg == "--partial") {
+            partial = true;
+            continue;
+        }
+        if (arg == "--rpu-pcap") {
+            rpu_pcap = true;
+            continue;
+        }
+        if (arg == "--manifest" && has_value) {
+            manifest = args[++i];
+            continue;
+        }
+        if (arg == "--checksum" && has_value) {
+            const string& path = args[++i];
+            uint32_t sum = 0;
+            if (!image_checksum(path, nullptr, sum)) {
+                cerr << "Error: Cannot read " << path << endl;
+                return 1;
+            }
+            char line[64];
+            snprintf(line, sizeof(line), "0x%08x  ", sum);
+            cout << line << path << endl;
+            return 0;
+        }
+        if (arg == "--force") {
+            force = true;
+            continue;
+        }
+        if (arg == "--no-handoff") {
+            handoff = false;
+            continue;
+        }
+        if (arg == "--overlay" && has_value) {
+            overlay = args[++i];
+            continue;
+        }
         // Auto-detect based on extension
         if (arg.find(".bit") != string::npos || arg.find(".bin") != string::npos) {
             pl_fw = arg;
@@ -173,8 +1495,198 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    load_pl(pl_fw);
-    load_rpu(rpu_fw);
+    vector<LoadStep> steps;
+    if (!manifest.empty()) {
+        if (!parse_manifest(manifest, steps)) return 1;
+    } else if (partial) {
+        // Only the region is swapped: no default bitstream, no RPU restart
+        if (pl_fw == DEFAULT_PL_FW) {
+            cerr << "Error: --partial needs a partial .bit/.bin" << endl;
+            return 1;
+        }
+        steps.push_back(make_step("partial", STEP_PARTIAL, pl_fw, 0, {}));
+        if (!overlay.empty()) steps.push_back(make_step("overlay", STEP_OVERLAY, overlay, 0, {"partial"}));
+    } else {
+        // The cores are only started once the PL is up: the firmware touches
+        // the AXI GPIO straight away and an access to unconfigured PL never
+        // completes. They are stopped and staged while the PL is programmed.
+        steps.push_back(make_step("pl", STEP_PL, pl_fw, 0, {}));
+        if (split) {
+            steps.push_back(make_step("rpu0", STEP_RPU, rpu_fw, 0, {"pl"}));
+            steps.push_back(make_step("rpu1", STEP_RPU, DEFAULT_RPU1_FW, 1, {"pl"}));
+        } else {
+            steps.push_back(make_step("rpu" + to_string(core), STEP_RPU, rpu_fw, core, {"pl"}));
+        }
+        if (!overlay.empty()) steps.push_back(make_step("overlay", STEP_OVERLAY, overlay, 0, {"pl"}));
+    }
 
+    for (auto& step : steps) {
+        step.handoff = handoff;
+        step.rpu_pcap = rpu_pcap;
+    }
+
+    if (!sort_steps(steps)) return 1;
+    if (image_cache) cache_steps(steps);
+    // Skip the steps whose images already run; reprogramming the PL restarts
+    // the RPUs as well, since they must not run across it
+    plan_steps(steps, force);
+    verify_steps(steps);
+    return run_steps(steps) ? 0 : 1;
+}
+
+// --- Daemon ---
+
+volatile sig_atomic_t stop_requested = 0;
+
+void handle_stop(int) {
+    stop_requested = 1;
+}
+
+// One request line: "preload <images>", "cache", or the options of a load.
+// The output of the load goes to the client, followed by "OK" or "FAILED".
+void serve_request(const string& line, const char* prog, ostream& out) {
+    istringstream tokens(line);
+    vector<string> args;
+    string token;
+    while (tokens >> token) args.push_back(token);
+    if (args.empty()) return;
+
+    image_cache->begin_request();
+    if (args[0] == "cache") {
+        image_cache->list(out);
+        out << "OK" << endl;
+        return;
+    }
+
+    // Loads log through cout/cerr from their worker threads, all joined
+    // before run_load() returns; the client gets both
+    streambuf* saved_out = cout.rdbuf(out.rdbuf());
+    streambuf* saved_err = cerr.rdbuf(out.rdbuf());
+    bool ok = true;
+    if (args[0] == "preload") {
+        for (size_t i = 1; i < args.size(); i++) {
+            string name, error;
+            if (!image_cache->add(args[i], name, error)) {
+                cerr << "Error: " << args[i] << ": " << error << endl;
+                ok = false;
+            }
+        }
+    } else {
+        ok = run_load(args, prog) == 0;
+    }
+    cout.rdbuf(saved_out);
+    cerr.rdbuf(saved_err);
+    out << (ok ? "OK" : "FAILED") << endl;
+}
+
+// Keeps validated images on tmpfs and serves load requests on a UNIX stream
+// socket, one client at a time. The kernel finds the cached images through
+// firmware_class.path, which is left pointing at the cache on exit so the
+// loaded cores can still be restarted by remoteproc.
+int run_daemon(const string& socket_path, size_t cache_mb, const char* prog) {
+    if ((mkdir(FINGERPRINT_DIR.c_str(), 0755) != 0 && errno != EEXIST) ||
+        (mkdir(CACHE_DIR.c_str(), 0755) != 0 && errno != EEXIST)) {
+        cerr << "Error: Cannot create " << CACHE_DIR << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    struct statfs fs;
+    if (statfs(CACHE_DIR.c_str(), &fs) == 0 && fs.f_type != TMPFS_MAGIC) {
+        cerr << "Warning: " << CACHE_DIR << " is not on tmpfs" << endl;
+    }
+
+    // Another user of the search path would lose its images
+    string fw_path = read_sysfs(FW_CLASS_PATH);
+    if (!fw_path.empty() && fw_path != CACHE_DIR) {
+        cerr << "Error: firmware_class.path is already set to " << fw_path << endl;
+        return 1;
+    }
+    if (fw_path.empty() && !write_sysfs(FW_CLASS_PATH, CACHE_DIR)) return 1;
+
+    int srv = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (srv == -1) {
+        perror("Error creating socket");
+        return 1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socket_path.c_str());
+    if (bind(srv, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(srv, 1) == -1) {
+        perror("Error binding socket");
+        close(srv);
+        return 1;
+    }
+
+    // No SA_RESTART: SIGINT/SIGTERM interrupt accept() and read()
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    signal(SIGPIPE, SIG_IGN);  // Client hang-ups must not kill the daemon
+
+    ImageCache cache(cache_mb << 20);
+    image_cache = &cache;
+    cout << "Listening on " << socket_path << ", images cached in " << CACHE_DIR << endl;
+
+    while (!stop_requested) {
+        int client = accept(srv, nullptr, nullptr);
+        if (client == -1) {
+            if (errno == EINTR) continue;
+            perror("Error accepting connection");
+            break;
+        }
+
+        string pending;
+        char buf[256];
+        ssize_t n;
+        while (!stop_requested && (n = read(client, buf, sizeof(buf))) > 0) {
+            pending.append(buf, n);
+            size_t pos;
+            bool sent = true;
+            while (sent && (pos = pending.find('\n')) != string::npos) {
+                ostringstream reply;
+                serve_request(pending.substr(0, pos), prog, reply);
+                pending.erase(0, pos + 1);
+                const string r = reply.str();
+                sent = r.empty() || write_all(client, (const unsigned char*)r.data(), r.size());
+            }
+            if (!sent) break;
+        }
+        close(client);
+    }
+
+    image_cache = nullptr;
+    close(srv);
+    unlink(socket_path.c_str());
     return 0;
 }
+
+// --- Main ---
+
+int main(int argc, char* argv[]) {
+    if (geteuid() != 0) cerr << "Warning: Run as root." << endl;
+
+    string daemon_socket;
+    size_t cache_mb = DEFAULT_CACHE_MB;
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--daemon" && i + 1 < argc) {
+            daemon_socket = argv[++i];
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            cache_mb = strtoul(argv[++i], nullptr, 0);
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (daemon_socket.empty()) return run_load(args, argv[0]);
+
+    // The daemon loads nothing itself; clients send the load options
+    if (!args.empty() || cache_mb == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    return run_daemon(daemon_socket, cache_mb, argv[0]);
+}
@@ -0,0 +1,198 @@
+/*
+ * Python extension (pybind11) that plays a NumPy sample array onto the AXI
+ * GPIO of the PL, paced by the system counter.
+ *
+ * Usage (PYNQ notebook, built with `make gpio_stream` on the board):
+ *   import numpy as np, gpio_stream
+ *   leds = gpio_stream.GpioStream()            # axi_gpio_0 channel 1, LED0/LED1
+ *   r = leds.play(np.array([1, 2, 3, 2, 0], dtype=np.uint32), rate_hz=100000, loops=1000)
+ *   print(r)   # {'samples': 5000, 'late': 3, 'max_late_us': 41.2, 'elapsed_s': 0.05, ...}
+ *
+ * Writing overlay.axi_gpio_0.channel1 from Python costs a few microseconds of
+ * interpreter per sample. play() takes the whole array instead: it merges the
+ * samples with the bits outside the mask once (a plain loop the compiler
+ * vectorizes), releases the GIL and stores every word into the GPIO data
+ * register at its due time on the ZynqMP system counter (CNTVCT_EL0, 10 ns
+ * at 100 MHz). Due times are exact multiples of the sample period, so the
+ * pacing does not drift; a sample stored more than one period after its due
+ * time counts as late (the process was preempted, or the rate is above what
+ * the uncached AXI stores sustain). Waits longer than
+ * GPIO_STREAM_SLEEP_US sleep, shorter ones spin. Ctrl-C (KeyboardInterrupt)
+ * stops a long play within GPIO_STREAM_SIGNAL_MS.
+ *
+ * Above a few hundred kS/s, or for jitter-free output, use the DMA-fed
+ * pattern_out_0 of the PL variant (python/pattern_out_pynq.ipynb) instead:
+ * it needs no CPU per sample.
+ *
+ * Memory Map:
+ *   0x80000000: AXI GPIO (axi_gpio_0), data of channel 1 at 0x0, channel 2 at 0x8
+ */
+
+#include <cstdint>
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include "kr260hal/mem_map.h"
+#include "kr260hal/timebase.h"
+
+namespace py = pybind11;
+
+#define AXI_GPIO_BASE_ADDR     0x80000000UL
+#define AXI_GPIO_SIZE          0x1000
+#define AXI_GPIO_DATA(ch)      (((ch) - 1) * 0x8)   // GPIO_DATA / GPIO2_DATA
+#define GPIO_STREAM_SLEEP_US   200    // Sleep through longer waits, spin below
+#define GPIO_STREAM_SIGNAL_MS  100    // Python signal check period while playing
+
+struct PlayResult {
+    uint64_t samples = 0;
+    uint64_t late = 0;
+    uint64_t max_late_ticks = 0;
+    uint64_t elapsed_ticks = 0;
+};
+
+class GpioStream {
+public:
+    GpioStream(uintptr_t base, unsigned channel, uint32_t mask)
+        : channel_(channel), mask_(mask), hz_(kr260hal::counter_freq()) {
+        if (channel != 1 && channel != 2) {
+            throw std::invalid_argument("channel must be 1 or 2");
+        }
+        if (!gpio_.map_phys(base, AXI_GPIO_SIZE)) {
+            throw std::runtime_error(std::string("mapping the AXI GPIO through /dev/mem: ") +
+                                     std::strerror(errno));
+        }
+        data_ = gpio_.at(AXI_GPIO_DATA(channel));
+        // The output latch reads back on an output-only channel
+        shadow_ = *data_;
+    }
+
+    void write(uint32_t value) {
+        shadow_ = (shadow_ & ~mask_) | (value & mask_);
+        *data_ = shadow_;
+    }
+
+    uint32_t read() const { return *data_; }
+
+    py::dict play(py::array_t<uint32_t, py::array::c_style | py::array::forcecast> samples,
+                  uint32_t rate_hz, unsigned loops) {
+        auto in = samples.unchecked<1>();
+        const size_t n = in.shape(0);
+        PlayResult r;
+
+        if (n != 0 && loops != 0) {
+            // Merge once, outside the paced loop
+            std::vector<uint32_t> words(n);
+            const uint32_t keep = shadow_ & ~mask_;
+            for (size_t i = 0; i < n; i++) {
+                words[i] = keep | (in(i) & mask_);
+            }
+            {
+                py::gil_scoped_release release;
+                r = stream(words, rate_hz, loops);
+            }
+            shadow_ = words[n - 1];
+        }
+
+        const double us_per_tick = 1e6 / hz_;
+        py::dict d;
+        d["samples"] = r.samples;
+        d["late"] = r.late;
+        d["max_late_us"] = r.max_late_ticks * us_per_tick;
+        d["elapsed_s"] = r.elapsed_ticks * us_per_tick / 1e6;
+        d["rate_hz"] = r.elapsed_ticks ? (double)r.samples * hz_ / r.elapsed_ticks : 0.0;
+        return d;
+    }
+
+    unsigned channel() const { return channel_; }
+    uint32_t mask() const { return mask_; }
+    uint64_t counter_hz() const { return hz_; }
+
+private:
+    // The paced loop, without the GIL; rate_hz 0 writes back to back
+    PlayResult stream(const std::vector<uint32_t>& words, uint32_t rate_hz, unsigned loops) {
+        const uint64_t period = rate_hz ? hz_ / rate_hz : 0;
+        const uint64_t period_rem = rate_hz ? hz_ % rate_hz : 0;
+        const uint64_t sleep_ticks = hz_ * GPIO_STREAM_SLEEP_US / 1000000;
+        const uint64_t signal_ticks = hz_ * GPIO_STREAM_SIGNAL_MS / 1000;
+        const uint64_t start = kr260hal::counter_now();
+        uint64_t due = start;
+        uint64_t frac = 0;
+        uint64_t next_signal = start + signal_ticks;
+        PlayResult r;
+
+        for (unsigned loop = 0; loop < loops; loop++) {
+            for (uint32_t w : words) {
+                uint64_t now = kr260hal::counter_now();
+                if (rate_hz) {
+                    if ((int64_t)(due - now) > (int64_t)sleep_ticks) {
+                        wait_sleep(due - now - sleep_ticks / 2);
+                    }
+                    while ((int64_t)(due - (now = kr260hal::counter_now())) > 0) {
+                    }
+                }
+                *data_ = w;
+                if (rate_hz) {
+                    uint64_t late = now - due;
+                    if (late > period) r.late++;
+                    if (late > r.max_late_ticks) r.max_late_ticks = late;
+                    // Exact due times: period + period_rem / rate_hz ticks per sample
+                    due += period;
+                    frac += period_rem;
+                    if (frac >= rate_hz) {
+                        frac -= rate_hz;
+                        due++;
+                    }
+                }
+                r.samples++;
+                if ((int64_t)(now - next_signal) >= 0) {
+                    next_signal = now + signal_ticks;
+                    py::gil_scoped_acquire acquire;
+                    if (PyErr_CheckSignals() != 0) {
+                        throw py::error_already_set();
+                    }
+                }
+            }
+        }
+        r.elapsed_ticks = kr260hal::counter_now() - start;
+        return r;
+    }
+
+    void wait_sleep(uint64_t ticks) const {
+        uint64_t ns = kr260hal::ticks_to_ns(ticks, hz_);
+        struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+        clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, nullptr);
+    }
+
+    kr260hal::MemMap gpio_;
+    volatile uint32_t* data_ = nullptr;
+    unsigned channel_;
+    uint32_t mask_;
+    uint32_t shadow_ = 0;
+    uint64_t hz_;
+};
+
+PYBIND11_MODULE(gpio_stream, m) {
+    m.doc() = "Counter-paced sample playback onto the KR260 AXI GPIO";
+
+    py::class_<GpioStream>(m, "GpioStream")
+        .def(py::init<uintptr_t, unsigned, uint32_t>(),
+             py::arg("base") = AXI_GPIO_BASE_ADDR, py::arg("channel") = 1, py::arg("mask") = 0x3,
+             "Map the AXI GPIO data register of 'channel' through /dev/mem (needs root)")
+        .def("write", &GpioStream::write, py::arg("value"),
+             "Write the bits of 'mask' at once, keeping the others")
+        .def("read", &GpioStream::read, "Read the data register")
+        .def("play", &GpioStream::play, py::arg("samples"), py::arg("rate_hz") = 0,
+             py::arg("loops") = 1,
+             "Play a uint32 array 'loops' times at 'rate_hz' (0: as fast as the bus goes); "
+             "returns the counts of samples and late samples, the worst lateness and the rate")
+        .def_property_readonly("channel", &GpioStream::channel)
+        .def_property_readonly("mask", &GpioStream::mask)
+        .def_property_readonly("counter_hz", &GpioStream::counter_hz);
+}
@@ -2,141 +2,874 @@
  * APU Application to control LED Blink Mode on RPU via Shared Memory and IPI.
  *
  * Usage: ./ipi_app <mode>
+ *        ./ipi_app --session             (commands from stdin or a pipe)
+ *        ./ipi_app --socket <path>       (commands from a UNIX socket)
+ *        ./ipi_app --ring <mode>...      (queue modes on the command ring)
+ *        ./ipi_app --at <tick|+ms> <mode>...   (modes applied by the RPU at a counter tick)
+ *        ./ipi_app --urgent <mode>       (one mode on the urgent ring, ahead of queued commands)
+ *        ./ipi_app --wave <period_ns> <sample>...   (play a GPIO waveform)
+ *        ./ipi_app --wave 0              (stop the waveform)
+ *        ./ipi_app --pattern <program>   (run a LED pattern program, "stop" ends it)
+ *        ./ipi_app --msg <opcode> [param]...   (one command in the IPI message buffer)
+ *        ./ipi_app --bulk <bytes>        (loopback test of the bulk channel)
+ *        ./ipi_app --bulk <bytes> --bulk-crc   (the same, then with CRC32C checks)
+ *        ./ipi_app --mp <mode>...        (queue modes on the multi-producer channel)
+ * Waveform options:
+ *   --wave-loops <n>      Table repetitions, 0 = until stopped (default 0)
+ *   --wave-dma            Play from the RPU's DMA engine (no CPU per sample)
+ *   --wave-stream         Stream the table from the bulk carveout (longer tables)
+ * Wait options (any mode):
+ *   --spin-ns <ns>        Busy-poll window before sleeping (default 20000)
+ *   --max-sleep-us <us>   Ceiling of the exponential sleep back-off (default 1000)
+ * Target options (any mode):
+ *   --core <n>            RPU core to address, 0 or 1 (default 0)
+ *   --rpmsg               Send --msg and --ring over RPMsg (/dev/rpmsgN)
+ * Real-time options (any mode):
+ *   --rt <cpu>            Pin to an A53 core, SCHED_FIFO, mlockall, reverse IPI on that core
+ *   --rt-prio <prio>      SCHED_FIFO priority with --rt (default 49)
  * Modes:
  *   0: SLOW
  *   1: FAST
  *   2: RANDOM
  *   3+: Release control (RPU internal state machine)
  *
+ * In session mode the shared memory and IPI windows are mapped once and every
+ * input line carries one mode value. Each command is answered with a single
+ * result line including the round-trip latency, e.g.:
+ *   mode=1 ack=OK rtt_us=12.480
+ * A line with several modes is queued on the command ring behind a single
+ * doorbell. "status" prints the shared memory/IPI status, "quit" ends the
+ * session. With --ring every command uses the ring instead of the legacy
+ * CMD/ACK words. Only one ring producer may run at a time.
+ * "wave <period_ns> <loops> <sample>..." uploads and starts a waveform
+ * ("wave-dma ..." on the DMA engine), "wave stop" stops it.
+ * "pattern <program>" runs a LED pattern program, "pattern stop" ends it.
+ * "at <tick|+ms> <mode>..." queues modes the RPU applies at that tick.
+ * "msg <opcode> [param]..." sends one RPU_CMD_* opcode with up to
+ * SHM_IPI_MSG_DATA_WORDS parameters in the IPI message buffer and prints the
+ * status and results, e.g. "msg 3" (RPU_CMD_QUERY):
+ *   msg opcode=3 ack=OK rtt_us=6.120 status=1 results=0x1,0x1,0x0,0x0,0x0,0x0
+ *
+ * --bulk sends a test pattern through the bulk channel (common/rpu_shm.h):
+ * each buffer-full goes from the first half of the core's DDR carveout into
+ * the RPU's TCM buffer and back out to the second half, both ways by the
+ * RPU's DMA engine, and the copy is compared with the pattern:
+ *   Bulk loopback of 1048576 bytes: OK in 8020.400 us (261.5 MB/s), DMA 4410.120 us
+ * It needs the carveout of APU/dts/rpu_bulk.dtsi and /dev/mem (root).
+ * --bulk-crc runs it again with BULK_OP_F_CRC on every descriptor, the RPU
+ * checking the pieces it receives (table, R5) and this side the ones it gets
+ * back (CRC32C instructions, A53), and prints the cost of the checks, with
+ * the A53 rate of both CRC routines on a cached buffer of the same size:
+ *   Bulk loopback of 1048576 bytes with CRC32C: OK in 9650.210 us (217.3 MB/s), DMA 4410.120 us
+ *   CRC32C overhead: +1629.810 us (+20.3%)
+ *   APU CRC32C of 1048576 bytes: instructions 2870.4 MB/s, table 412.6 MB/s
+ *
+ * --mp queues the modes on the multi-producer command channel of a RPU0
+ * firmware built with RPU_MPCMD=1 (kr260hal/mpcmd.h). Unlike --ring any
+ * number of instances may do so at the same time:
+ *   Posted 4 command(s) on the multi-producer channel: OK in 14.220 us (doorbells 1, skipped 0)
+ * It maps the channel block through /dev/mem (root).
+ *
+ * --rpmsg talks to a firmware built with RPU_RPMSG=1 (kr260hal/rpmsg.h):
+ * --msg goes as one RPMsg payload and --ring packs the modes
+ * RPU_RPMSG_BATCH_MAX to a payload. It needs the vring carveouts of
+ * APU/dts/rpu_rpmsg.dtsi and the rpmsg_char driver, but no root.
+ *
+ * Waveforms are played by the RPU from a hardware timer: each sample (an AXI
+ * GPIO data value, e.g. 0x1/0x2 for the two LEDs) is output for period_ns,
+ * which must be at least RPU_WAVE_MIN_PERIOD_NS (RPU_WAVE_DMA_MIN_PERIOD_NS
+ * with the DMA engine). A table holds up to SHM_WAVE_MAX_SAMPLES samples;
+ * with --wave-stream it goes to the bulk carveout instead, up to
+ * RPU_WAVE_STREAM_MAX_SAMPLES, and the RPU fetches it in chunks as it plays
+ * with the timer (status shows the periods held for a late chunk).
+ *
+ * --at sends the modes on the ring for the RPU to hold until a tick of the
+ * system counter (rpu_shm.h, "Timed commands"), given as an absolute value
+ * or as "+ms" from now, so the change happens then regardless of the
+ * doorbell and scheduling latency; a tick that passed before they arrived
+ * reports status 5 (RPU_CMD_STATUS_LATE):
+ *   ./ipi_app --at +500 1
+ *   Queued 1 command(s) for tick 123456789012: OK in 8.410 us (status 1)
+ *
+ * Pattern programs (kr260hal/pattern.h) run in the RPU's blink task instead,
+ * one instruction per ';', e.g. a ten-times alternating blink:
+ *   ./ipi_app --pattern "set 1; again: wait 100; toggle 3; loop again 10; end"
+ * The previous mode resumes at END or "stop"; any mode command ends it too.
+ *
+ * When the rpu_ipi kernel module is loaded the shared window is mapped through
+ * /dev/rpu_ipi and the doorbell is rung with RPU_IPI_IOC_DOORBELL, so no
+ * /dev/mem access (and no root) is needed. Messages then go through
+ * RPU_IPI_IOC_MSG. Otherwise the generic-uio nodes of APU/dts/rpu_uio.dtso
+ * are used when they are bound, and waits block on the reverse IPI; the last
+ * resort is /dev/mem.
+ *
+ * --rt is meant for a long-running session or socket daemon on a core kept
+ * free with isolcpus= (kr260hal/rt.h): the process is pinned to that core,
+ * runs SCHED_FIFO with its memory locked, and the reverse IPI of the
+ * rpu_ipi module or the UIO node is steered to the same core, so a blocked
+ * wait wakes without crossing cores. It needs root.
+ *
+ * With the R5s in split mode, --core 1 talks to the RPU1 firmware: its own
+ * shared window (SHARED_MEM_ADDR_RPU1), IPI target bit and message buffers,
+ * through UIO or /dev/mem since the kernel module serves RPU0 only. Every
+ * core has its own sequence numbers and ring, so one instance per core can
+ * run at the same time.
+ *
  * Memory Map:
- *   0xFF990000: Shared Control Word (u32)
+ *   0xFF990000: Shared memory window (legacy CMD/ACK words + command ring,
+ *               see common/rpu_shm.h)
+ *   0xFFFC0000: Shared memory window of RPU1 (--core 1)
  *   0xFF300000: APU IPI Base (Trigger)
+ *   0xFFFC1000: Bulk control block (--bulk; RPU1 at 0xFFFC2000)
+ *   0xFFFC7000: Multi-producer command channel (--mp, RPU0 only)
+ *   0x3F100000: Bulk DDR carveout (--bulk; RPU1 at 0x3F300000)
+ *   0x3F500000: RPMsg vrings and buffers (--rpmsg; RPU1 at 0x3F600000)
  */
 
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <cstdint>
-#include <fcntl.h>
-#include <sys/mman.h>
+#include <cstring>
+#include <csignal>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <unistd.h>
 
-#define SHARED_MEM_ADDR 0xFF990000
-#define SHARED_MEM_SIZE 0x1000 // 4KB
-
 // Shared Memory Layout (following OpenAMP pattern)
-#define SHM_CMD_OFFSET     0x00  // Command/Mode (APU writes, RPU reads)
-#define SHM_ACK_OFFSET     0x04  // Acknowledgment (RPU writes, APU reads)
-#define SHM_ACK_MAGIC      0xDEADBEEF  // Magic value to indicate acknowledgment
-#define SHM_ACK_TIMEOUT_MS 1000  // Timeout for acknowledgment (1 second)
+#include "rpu_shm.h"
+#include "rpu_crc32c.h"
+#include "rpu_ipi_ioctl.h"
+#include "kr260hal/kr260hal.h"
 
-#define IPI_APU_BASE    0xFF300000
-#define IPI_TRIG_OFFSET 0x00
-#define IPI_OBS_OFFSET  0x04
+using kr260hal::IpiResult;
 
-// Target Masks (ZynqMP IPI bitmasks from device tree)
-#define MASK_CH1_RPU0 0x100    // 256 (bit 8) - IPI1 to RPU0
+// Transport plus the protocol selected on the command line
+struct IpiContext {
+    kr260hal::IpiTransport ipi;
+    bool use_ring = false;
+};
 
+/*
+ * Send one mode through the legacy CMD/ACK words.
+ * With verbose set, every protocol step is logged (one-shot mode).
+ */
+static IpiResult ipi_send_mode(IpiContext& ctx, int mode, bool verbose) {
+    const unsigned core = ctx.ipi.core();
+    if (verbose) {
+        const uint32_t abi = ctx.ipi.abi_version();
+        std::cout << "Shared window ABI " << SHM_ABI_VERSION_MAJOR(abi) << "." << (abi & 0xFFFF)
+                  << ", features 0x" << std::hex << ctx.ipi.features()
+                  << ", active 0x" << ctx.ipi.active() << std::dec << std::endl;
+        std::cout << "Writing mode " << mode << " to shared memory at 0x" << std::hex
+                  << (kr260hal::shm_window_addr(core) + SHM_CMD_OFFSET) << std::endl;
+        std::cout << "Triggering IPI to RPU" << std::dec << core << " (Mask 0x" << std::hex
+                  << RPU_IPI_MASK(core) << ") and waiting for acknowledgment..." << std::endl;
+    }
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <mode>" << std::endl;
-        std::cerr << "Modes: 0=SLOW, 1=FAST, 2=RANDOM, 3+=Release control" << std::endl;
+    IpiResult result = ctx.ipi.send_mode((uint32_t)mode);
+
+    if (verbose) {
+        if (result.acked) {
+            std::cout << "RPU acknowledged! Mode " << std::dec << mode << " processed successfully." << std::endl;
+        } else {
+            std::cerr << "ERROR: No valid RPU acknowledgment for seq " << std::dec << ctx.ipi.last_seq() << "!" << std::endl;
+            std::cerr << "Last ACK value: 0x" << std::hex << result.ack_val << std::endl;
+        }
+    }
+    return result;
+}
+
+// Parse message arguments: opcode, then at most SHM_IPI_MSG_DATA_WORDS parameters
+static bool parse_msg(std::istream& in, uint32_t& opcode, std::vector<uint32_t>& params) {
+    std::string tok;
+    char* end = nullptr;
+
+    if (!(in >> tok)) return false;
+    opcode = std::strtoul(tok.c_str(), &end, 0);
+    if (*end != '\0' || opcode > 0xFF) return false;
+    while (in >> tok) {
+        unsigned long v = std::strtoul(tok.c_str(), &end, 0);
+        if (*end != '\0' || params.size() == SHM_IPI_MSG_DATA_WORDS) return false;
+        params.push_back((uint32_t)v);
+    }
+    return true;
+}
+
+// "status=<n> results=0x..,0x.." part of a message reply
+static std::string format_msg_results(const IpiResult& result, const uint32_t* results) {
+    char buf[128];
+    int len = std::snprintf(buf, sizeof(buf), "status=%u results=", result.ack_val);
+    for (uint32_t i = 0; i < RPU_MSG_MAX_RESULTS && len < (int)sizeof(buf); i++) {
+        len += std::snprintf(buf + len, sizeof(buf) - len, i ? ",0x%X" : "0x%X", results[i]);
+    }
+    return buf;
+}
+
+// Parse waveform samples; false if any is malformed or there are more than max
+static bool parse_samples(std::istream& in, std::vector<uint32_t>& samples,
+                          size_t max = SHM_WAVE_MAX_SAMPLES) {
+    std::string tok;
+    while (in >> tok) {
+        char* end = nullptr;
+        unsigned long v = std::strtoul(tok.c_str(), &end, 0);
+        if (*end != '\0' || samples.size() == max) return false;
+        samples.push_back((uint32_t)v);
+    }
+    return true;
+}
+
+// Counter tick of --at / "at": absolute, or "+ms" from now; false if malformed
+static bool parse_at(const std::string& arg, uint64_t& tick) {
+    const bool relative = !arg.empty() && arg[0] == '+';
+    const char* s = arg.c_str() + (relative ? 1 : 0);
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(s, &end, 0);
+    if (end == s || *end != '\0') return false;
+    tick = relative ? kr260hal::counter_now() + v * kr260hal::counter_freq() / 1000 : v;
+    return true;
+}
+
+// Modes as timed SET_MODE commands
+static std::vector<kr260hal::RingCommand> mode_commands(const std::vector<uint32_t>& modes) {
+    std::vector<kr260hal::RingCommand> cmds;
+    for (uint32_t mode : modes) cmds.push_back(kr260hal::RingCommand{RPU_CMD_SET_MODE, mode});
+    return cmds;
+}
+
+// Assemble and start a pattern program, or stop it for "stop"; one result line
+static bool ipi_send_pattern(IpiContext& ctx, const std::string& program, std::ostream& out) {
+    std::vector<uint32_t> words;
+    std::string error;
+    if (program != "stop" && !kr260hal::assemble_pattern(program, words, error)) {
+        out << "error: pattern: " << error << std::endl;
+        return false;
+    }
+    IpiResult result = ctx.ipi.send_pattern(words);
+    char reply[96];
+    std::snprintf(reply, sizeof(reply), "pattern words=%zu ack=%s rtt_us=%.3f status=%u",
+                  words.size(), result.acked ? "OK" : "FAIL", result.rtt_us, result.ack_val);
+    out << reply << std::endl;
+    return result.acked;
+}
+
+static void ipi_print_status(IpiContext& ctx, std::ostream& out) {
+    namespace shm = kr260hal::shm;
+    const kr260hal::MemMap& win = ctx.ipi.shm();
+    const unsigned core = ctx.ipi.core();
+
+    out << "--- Status ---" << std::endl;
+    out << "Shared Mem CMD: " << std::dec << win.read<shm::Cmd>() << std::endl;
+    out << "Shared Mem ACK: 0x" << std::hex << win.read<shm::Ack>() << std::endl;
+    out << "Shared Mem SEQ/ACK_SEQ: " << std::dec << win.read<shm::Seq>() << "/" << win.read<shm::AckSeq>() << std::endl;
+    out << "Ring head/tail: " << std::dec << win.read<shm::RingHead>() << "/" << win.read<shm::RingTail>() << std::endl;
+    switch (win.read<shm::WaveState>()) {
+        case RPU_WAVE_STATE_RUNNING: out << "Waveform: running (timer)" << std::endl; break;
+        case RPU_WAVE_STATE_DMA:     out << "Waveform: running (DMA)" << std::endl; break;
+        case RPU_WAVE_STATE_STREAM:
+            out << "Waveform: running (timer, streamed, " << std::dec << win.read<shm::WaveUnderrun>()
+                << " period(s) held)" << std::endl;
+            break;
+        default:                     out << "Waveform: idle" << std::endl; break;
+    }
+    uint32_t obs_val = 0;
+    if (!ctx.ipi.read_ipi_obs(obs_val)) {
+        out << "APU IPI OBS: n/a (doorbell via /dev/" RPU_IPI_DEV_NAME ")" << std::endl;
+        return;
+    }
+    out << "APU IPI OBS (0xFF300004): 0x" << std::hex << obs_val;
+    out << " -> Ch" << std::dec << core + 1 << " (RPU" << core << ") "
+        << ((obs_val & RPU_IPI_MASK(core)) ? "PENDING" : "IDLE") << std::endl;
+    out << std::dec;
+}
+
+/*
+ * Handle one session command line. Returns false when the session should end.
+ */
+static bool session_command(IpiContext& ctx, const std::string& line, std::ostream& out) {
+    std::istringstream tokens(line);
+    std::string cmd;
+    if (!(tokens >> cmd)) return true; // Blank line
+
+    if (cmd == "quit" || cmd == "exit") return false;
+    if (cmd == "status") {
+        ipi_print_status(ctx, out);
+        return true;
+    }
+    if (cmd == "wave" || cmd == "wave-dma") {
+        std::string first;
+        uint32_t period_ns = 0, loops = 0;
+        std::vector<uint32_t> samples;
+        if (!(tokens >> first)) first = "stop";
+        if (first != "stop") {
+            period_ns = std::strtoul(first.c_str(), nullptr, 0);
+            if (!(tokens >> loops) || !parse_samples(tokens, samples) || samples.empty()) {
+                out << "error: usage: wave[-dma] <period_ns> <loops> <sample>... | wave stop" << std::endl;
+                return true;
+            }
+        }
+        IpiResult result = ctx.ipi.send_wave(period_ns, loops, samples, cmd == "wave-dma");
+        char reply[96];
+        std::snprintf(reply, sizeof(reply), "wave samples=%zu ack=%s rtt_us=%.3f status=%u",
+                      samples.size(), result.acked ? "OK" : "FAIL", result.rtt_us, result.ack_val);
+        out << reply << std::endl;
+        return true;
+    }
+
+    if (cmd == "pattern") {
+        std::string program;
+        std::getline(tokens >> std::ws, program);
+        if (program.empty()) {
+            out << "error: usage: pattern <program> | pattern stop" << std::endl;
+            return true;
+        }
+        ipi_send_pattern(ctx, program, out);
+        return true;
+    }
+
+    if (cmd == "at") {
+        std::string when;
+        uint64_t tick = 0;
+        std::vector<uint32_t> modes;
+        if (!(tokens >> when) || !parse_at(when, tick) || !parse_samples(tokens, modes) || modes.empty()) {
+            out << "error: usage: at <tick|+ms> <mode>..." << std::endl;
+            return true;
+        }
+        IpiResult result = ctx.ipi.send_at(tick, mode_commands(modes));
+        char reply[128];
+        std::snprintf(reply, sizeof(reply), "at tick=%llu count=%zu ack=%s rtt_us=%.3f status=%u",
+                      (unsigned long long)tick, modes.size(), result.acked ? "OK" : "FAIL",
+                      result.rtt_us, result.ack_val);
+        out << reply << std::endl;
+        return true;
+    }
+
+    if (cmd == "msg") {
+        uint32_t opcode = 0;
+        uint32_t results[RPU_MSG_MAX_RESULTS] = {};
+        std::vector<uint32_t> params;
+        if (!parse_msg(tokens, opcode, params)) {
+            out << "error: usage: msg <opcode> [param]... (at most "
+                << SHM_IPI_MSG_DATA_WORDS << " parameters)" << std::endl;
+            return true;
+        }
+        IpiResult result = ctx.ipi.send_msg(opcode, params, results);
+        char reply[64];
+        std::snprintf(reply, sizeof(reply), "msg opcode=%u ack=%s rtt_us=%.3f ",
+                      opcode, result.acked ? "OK" : "FAIL", result.rtt_us);
+        out << reply << format_msg_results(result, results) << std::endl;
+        return true;
+    }
+
+    std::vector<uint32_t> modes;
+    do {
+        char* end = nullptr;
+        long mode = std::strtol(cmd.c_str(), &end, 10);
+        if (*end != '\0' || mode < 0) {
+            out << "error: invalid command '" << cmd << "'" << std::endl;
+            return true;
+        }
+        modes.push_back((uint32_t)mode);
+    } while (tokens >> cmd);
+
+    char reply[96];
+    if (modes.size() == 1 && !ctx.use_ring) {
+        IpiResult result = ipi_send_mode(ctx, modes[0], false);
+        std::snprintf(reply, sizeof(reply), "mode=%u ack=%s rtt_us=%.3f ack_val=0x%08X",
+                      modes[0], result.acked ? "OK" : "TIMEOUT", result.rtt_us, result.ack_val);
+    } else {
+        IpiResult result = ctx.ipi.send_batch(RPU_CMD_SET_MODE, modes);
+        std::snprintf(reply, sizeof(reply), "ring count=%zu ack=%s rtt_us=%.3f status=%u",
+                      modes.size(), result.acked ? "OK" : "FAIL", result.rtt_us, result.ack_val);
+    }
+    out << reply << std::endl;
+    return true;
+}
+
+// Session over stdin (interactive, pipe or FIFO redirection)
+static int run_stdin_session(IpiContext& ctx) {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!session_command(ctx, line, std::cout)) break;
+    }
+    return 0;
+}
+
+// Session over a UNIX stream socket; clients are served one at a time
+static int run_socket_session(IpiContext& ctx, const char* path) {
+    int srv = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (srv == -1) {
+        std::perror("Error creating socket");
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+
+    if (bind(srv, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(srv, 1) == -1) {
+        std::perror("Error binding socket");
+        close(srv);
+        return 1;
+    }
+    std::cout << "Listening on " << path << std::endl;
+
+    bool running = true;
+    while (running) {
+        int client = accept(srv, nullptr, nullptr);
+        if (client == -1) {
+            std::perror("Error accepting connection");
+            break;
+        }
+
+        std::string pending;
+        char buf[256];
+        ssize_t n;
+        while (running && (n = read(client, buf, sizeof(buf))) > 0) {
+            pending.append(buf, n);
+            size_t pos;
+            while (running && (pos = pending.find('\n')) != std::string::npos) {
+                std::ostringstream reply;
+                running = session_command(ctx, pending.substr(0, pos), reply);
+                pending.erase(0, pos + 1);
+                const std::string r = reply.str();
+                if (!r.empty() && write(client, r.data(), r.size()) == -1) break;
+            }
+        }
+        close(client);
+    }
+
+    close(srv);
+    unlink(path);
+    return 0;
+}
+
+// One loopback pass of pattern, flags (BULK_OP_F_CRC) on every descriptor;
+// false after printing the failing transfer
+static bool bulk_pass(kr260hal::BulkChannel& bulk, const std::vector<uint8_t>& pattern,
+                      uint32_t flags, double& rtt_us, double& dma_us) {
+    const size_t half = bulk.ddr_size() / 2;
+    const size_t bytes = pattern.size();
+    std::vector<uint8_t> copy(bytes);
+
+    rtt_us = 0.0;
+    dma_us = 0.0;
+    for (size_t off = 0; off < bytes; off += bulk.buf_size()) {
+        size_t n = std::min<size_t>(bulk.buf_size(), bytes - off);
+        IpiResult out = bulk.transfer(BULK_OP_WRITE | flags, off, n);
+        dma_us += bulk.dma_us();
+        IpiResult in = out.acked ? bulk.transfer(BULK_OP_READ | flags, half + off, n) : out;
+        dma_us += out.acked ? bulk.dma_us() : 0.0;
+        rtt_us += out.rtt_us + (out.acked ? in.rtt_us : 0.0);
+        if (!in.acked) {
+            std::cerr << "Bulk transfer at offset " << off << " FAILED (status " << in.ack_val
+                      << ")" << std::endl;
+            return false;
+        }
+    }
+
+    bulk.get(half, copy.data(), bytes);
+    return copy == pattern;
+}
+
+// A53 rate of both CRC32C routines over data, in MB/s
+static void crc_rates(const std::vector<uint8_t>& data, double& hw_mbs, double& sw_mbs) {
+    volatile uint32_t sink;
+    uint64_t t0 = kr260hal::now_ns();
+    sink = rpu_crc32c(data.data(), data.size());
+    uint64_t t1 = kr260hal::now_ns();
+    sink = rpu_crc32c_final(rpu_crc32c_sw_update(RPU_CRC32C_INIT, data.data(), data.size()));
+    uint64_t t2 = kr260hal::now_ns();
+    (void)sink;
+    hw_mbs = t1 > t0 ? data.size() * 1e3 / (t1 - t0) : 0.0;
+    sw_mbs = t2 > t1 ? data.size() * 1e3 / (t2 - t1) : 0.0;
+}
+
+// --wave-stream: the table into the bulk carveout at offset 0, then started there
+static int run_wave_stream(IpiContext& ctx, uint32_t period_ns, uint32_t loops,
+                           const std::vector<uint32_t>& samples) {
+    kr260hal::BulkChannel bulk;
+    if (!bulk.open(ctx.ipi)) {
+        std::perror("Error mapping the bulk channel (is the carveout reserved?)");
+        return 1;
+    }
+    if (!bulk.put(0, samples.data(), samples.size() * sizeof(uint32_t))) {
+        std::cerr << "Error writing the waveform to the bulk carveout" << std::endl;
         return 1;
     }
-    
-    int mode = std::atoi(argv[1]);
 
-    // Open /dev/mem to access physical memory
-    int mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if (mem_fd == -1) {
-        std::perror("Error opening /dev/mem");
+    IpiResult result = ctx.ipi.send_wave_stream(period_ns, loops, 0, samples.size());
+    std::cout << "Streamed waveform of " << samples.size() << " sample(s) at " << period_ns << " ns: "
+              << (result.acked ? "started" : "FAILED")
+              << " (status " << result.ack_val << ")" << std::endl;
+    return result.acked ? 0 : 1;
+}
+
+/*
+ * Round trip 'bytes' of a test pattern through the RPU buffer of the bulk
+ * channel and verify it, then with crc once more with CRC32C checks.
+ * Returns the process exit code.
+ */
+static int run_bulk_loopback(IpiContext& ctx, size_t bytes, bool crc) {
+    kr260hal::BulkChannel bulk;
+    if (!bulk.open(ctx.ipi)) {
+        std::perror("Error mapping the bulk channel (is the carveout reserved?)");
         return 1;
     }
 
-    // Map the shared memory region
-    void* shared_base = mmap(0, SHARED_MEM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, SHARED_MEM_ADDR);
-    if (shared_base == MAP_FAILED) {
-        std::perror("Error mapping shared memory");
-        close(mem_fd);
+    const size_t half = bulk.ddr_size() / 2;
+    if (bytes == 0 || bytes > half) {
+        std::cerr << "Invalid size (1-" << half << " bytes)" << std::endl;
         return 1;
     }
 
-    // Map the IPI APU base region (Source)
-    void* ipi_apu_base = mmap(0, 0x1000, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, IPI_APU_BASE);
-    if (ipi_apu_base == MAP_FAILED) {
-        std::perror("Error mapping IPI APU memory");
-        munmap(shared_base, SHARED_MEM_SIZE);
-        close(mem_fd);
+    std::vector<uint8_t> pattern(bytes);
+    for (size_t i = 0; i < bytes; i++) pattern[i] = (uint8_t)(i * 7 + (i >> 8));
+    bulk.put(0, pattern.data(), bytes);
+
+    double rtt_us, dma_us;
+    bool ok = bulk_pass(bulk, pattern, 0, rtt_us, dma_us);
+    std::printf("Bulk loopback of %zu bytes: %s in %.3f us (%.1f MB/s), DMA %.3f us\n", bytes,
+                ok ? "OK" : "MISMATCH", rtt_us, rtt_us > 0 ? 2.0 * bytes / rtt_us : 0.0, dma_us);
+    if (!ok || !crc) return ok ? 0 : 1;
+
+    double crc_rtt_us, crc_dma_us, hw_mbs, sw_mbs;
+    ok = bulk_pass(bulk, pattern, BULK_OP_F_CRC, crc_rtt_us, crc_dma_us);
+    std::printf("Bulk loopback of %zu bytes with CRC32C: %s in %.3f us (%.1f MB/s), DMA %.3f us\n",
+                bytes, ok ? "OK" : "MISMATCH", crc_rtt_us,
+                crc_rtt_us > 0 ? 2.0 * bytes / crc_rtt_us : 0.0, crc_dma_us);
+    if (!ok) return 1;
+    std::printf("CRC32C overhead: %+.3f us (%+.1f%%)\n", crc_rtt_us - rtt_us,
+                rtt_us > 0 ? (crc_rtt_us - rtt_us) * 100.0 / rtt_us : 0.0);
+    crc_rates(pattern, hw_mbs, sw_mbs);
+    std::printf("APU CRC32C of %zu bytes: instructions %.1f MB/s, table %.1f MB/s\n", bytes,
+                hw_mbs, sw_mbs);
+    return 0;
+}
+
+/*
+ * --msg and --ring over the RPMsg endpoint of the core. The other modes
+ * need the shared window, which such a firmware still serves, but not its
+ * IPI message buffer (the kernel's IPI mailbox owns it).
+ */
+static int run_rpmsg(unsigned core, const kr260hal::WaitPolicy& wait, bool msg,
+                     const std::vector<std::string>& args) {
+    kr260hal::RpmsgChannel rpmsg;
+    rpmsg.wait = wait;
+    if (!rpmsg.open(core)) {
+        std::perror("Error opening the RPMsg endpoint (is the firmware built with RPU_RPMSG=1?)");
         return 1;
     }
 
-    // Accessors
-    volatile uint32_t* shared_cmd = (volatile uint32_t*)((char*)shared_base + SHM_CMD_OFFSET);
-    volatile uint32_t* shared_ack = (volatile uint32_t*)((char*)shared_base + SHM_ACK_OFFSET);
-    volatile uint32_t* ipi_trig = (volatile uint32_t*)((char*)ipi_apu_base + IPI_TRIG_OFFSET);
-    volatile uint32_t* ipi_obs  = (volatile uint32_t*)((char*)ipi_apu_base + IPI_OBS_OFFSET);
-
-    // Clear previous acknowledgment
-    *shared_ack = 0;
-    __sync_synchronize();
-    
-    // Step 1: Write message to shared memory FIRST
-    *shared_cmd = (uint32_t)mode;
-    std::cout << "Written mode " << mode << " to shared memory at 0x" 
-              << std::hex << (SHARED_MEM_ADDR + SHM_CMD_OFFSET) << std::endl;
-    
-    // Memory barrier to ensure write completes before triggering IPI
-    __sync_synchronize();
-    
-    // Step 2: Trigger IPI to notify RPU
-    std::cout << "Triggering IPI to RPU0 (Mask 0x" << std::hex << MASK_CH1_RPU0 << ")..." << std::endl;
-    *ipi_trig = MASK_CH1_RPU0;
-    
-    // Step 3: Poll for acknowledgment from RPU
-    std::cout << "Waiting for RPU acknowledgment..." << std::endl;
-    uint32_t ack_val = 0;
-    int timeout_count = 0;
-    const int max_timeout = SHM_ACK_TIMEOUT_MS * 1000; // Convert to microseconds
-    
-    while (timeout_count < max_timeout) {
-        __sync_synchronize();
-        ack_val = *shared_ack;
-        
-        // Check if acknowledgment matches expected value
-        // RPU writes: SHM_ACK_MAGIC | (mode & 0xFF)
-        if ((ack_val & 0xFFFFFF00) == (SHM_ACK_MAGIC & 0xFFFFFF00)) {
-            uint32_t ack_mode = ack_val & 0xFF;
-            if (ack_mode == (uint32_t)mode) {
-                std::cout << "RPU acknowledged! Mode " << mode << " processed successfully." << std::endl;
+    std::stringstream in;
+    for (const std::string& arg : args) in << arg << ' ';
+    if (msg) {
+        uint32_t opcode = 0;
+        uint32_t results[RPU_MSG_MAX_RESULTS] = {};
+        std::vector<uint32_t> params;
+        if (!parse_msg(in, opcode, params)) {
+            std::cerr << "Invalid message (opcode 0-255, at most " << SHM_IPI_MSG_DATA_WORDS
+                      << " parameters)" << std::endl;
+            return 1;
+        }
+        IpiResult result = rpmsg.send_msg(opcode, params, results);
+        std::cout << "RPMsg opcode " << opcode << " on " << rpmsg.device() << ": "
+                  << (result.acked ? "OK" : "FAILED") << " in " << result.rtt_us << " us, "
+                  << format_msg_results(result, results) << std::endl;
+        return result.acked ? 0 : 1;
+    }
+
+    std::vector<uint32_t> modes;
+    for (const std::string& arg : args) modes.push_back(std::atoi(arg.c_str()));
+    IpiResult result = rpmsg.send_batch(RPU_CMD_SET_MODE, modes);
+    std::cout << "Sent " << modes.size() << " command(s) over " << rpmsg.device() << ": "
+              << (result.acked ? "OK" : "FAILED") << " in " << result.rtt_us << " us (status "
+              << result.ack_val << ")" << std::endl;
+    return result.acked ? 0 : 1;
+}
+
+// Real-time setup of --rt, before any window is mapped (mlockall covers them)
+static bool setup_rt(kr260hal::RtPolicy& rt) {
+    if (rt.cpu < 0) return true;
+    std::string error, warning;
+    rt.irqs = kr260hal::ipi_irqs();
+    if (!kr260hal::apply_rt(rt, error, warning)) {
+        std::cerr << "Error " << error << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (!warning.empty()) std::cerr << "Warning: " << warning << std::endl;
+    std::cerr << "Real-time on core " << rt.cpu << ", SCHED_FIFO " << rt.prio << ", IRQs";
+    for (int irq : rt.irqs) std::cerr << " " << irq;
+    std::cerr << (rt.irqs.empty() ? " none (polled waits)" : "") << std::endl;
+    return true;
+}
+
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [wait options] <mode>" << std::endl;
+    std::cerr << "       " << prog << " [wait options] --session" << std::endl;
+    std::cerr << "       " << prog << " [wait options] --socket <path>" << std::endl;
+    std::cerr << "       " << prog << " [wait options] --ring <mode>..." << std::endl;
+    std::cerr << "       " << prog << " [wait options] --at <tick|+ms> <mode>..." << std::endl;
+    std::cerr << "       " << prog << " [wait options] --urgent <mode>" << std::endl;
+    std::cerr << "       " << prog << " [wait options] [--wave-loops <n>] [--wave-dma | --wave-stream] --wave <period_ns> <sample>..." << std::endl;
+    std::cerr << "       " << prog << " [wait options] --wave 0   (stop)" << std::endl;
+    std::cerr << "       " << prog << " [wait options] --pattern <program> | stop" << std::endl;
+    std::cerr << "       " << prog << " [wait options] --msg <opcode> [param]..." << std::endl;
+    std::cerr << "       " << prog << " [wait options] --bulk <bytes> [--bulk-crc]" << std::endl;
+    std::cerr << "       " << prog << " [wait options] --mp <mode>..." << std::endl;
+    std::cerr << "Modes: 0=SLOW, 1=FAST, 2=RANDOM, 3+=Release control" << std::endl;
+    std::cerr << "Wait options:" << std::endl;
+    std::cerr << "  --spin-ns <ns>        Busy-poll window (default " << kr260hal::WAIT_SPIN_NS_DEFAULT << ")" << std::endl;
+    std::cerr << "  --max-sleep-us <us>   Back-off ceiling (default " << kr260hal::WAIT_MAX_SLEEP_US_DEFAULT << ")" << std::endl;
+    std::cerr << "  --core <n>            RPU core, 0 or 1 in split mode (default 0)" << std::endl;
+    std::cerr << "  --rpmsg               --msg/--ring over the RPMsg endpoint (RPU_RPMSG=1)" << std::endl;
+    std::cerr << "  --rt <cpu>            Pin, SCHED_FIFO, mlockall, reverse IPI on that core" << std::endl;
+    std::cerr << "  --rt-prio <prio>      SCHED_FIFO priority with --rt (default " << kr260hal::RT_PRIO_DEFAULT << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    enum { OPT_SPIN_NS = 256, OPT_MAX_SLEEP_US, OPT_WAVE_LOOPS, OPT_WAVE_DMA, OPT_CORE, OPT_BULK,
+           OPT_BULK_CRC, OPT_RPMSG, OPT_MP, OPT_RT, OPT_RT_PRIO, OPT_PATTERN, OPT_AT,
+           OPT_URGENT, OPT_WAVE_STREAM };
+    static const struct option long_opts[] = {
+        {"session",      no_argument,       nullptr, 's'},
+        {"socket",       required_argument, nullptr, 'u'},
+        {"ring",         no_argument,       nullptr, 'r'},
+        {"wave",         required_argument, nullptr, 'w'},
+        {"wave-loops",   required_argument, nullptr, OPT_WAVE_LOOPS},
+        {"wave-dma",     no_argument,       nullptr, OPT_WAVE_DMA},
+        {"wave-stream",  no_argument,       nullptr, OPT_WAVE_STREAM},
+        {"pattern",      required_argument, nullptr, OPT_PATTERN},
+        {"at",           required_argument, nullptr, OPT_AT},
+        {"urgent",       required_argument, nullptr, OPT_URGENT},
+        {"msg",          no_argument,       nullptr, 'm'},
+        {"bulk",         required_argument, nullptr, OPT_BULK},
+        {"bulk-crc",     no_argument,       nullptr, OPT_BULK_CRC},
+        {"spin-ns",      required_argument, nullptr, OPT_SPIN_NS},
+        {"max-sleep-us", required_argument, nullptr, OPT_MAX_SLEEP_US},
+        {"core",         required_argument, nullptr, OPT_CORE},
+        {"rpmsg",        no_argument,       nullptr, OPT_RPMSG},
+        {"mp",           no_argument,       nullptr, OPT_MP},
+        {"rt",           required_argument, nullptr, OPT_RT},
+        {"rt-prio",      required_argument, nullptr, OPT_RT_PRIO},
+        {"help",         no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    IpiContext ctx;
+    unsigned core = 0;
+    bool session = false;
+    const char* socket_path = nullptr;
+    const char* wave_period = nullptr;
+    uint32_t wave_loops = 0;
+    bool wave_dma = false;
+    bool wave_stream = false;
+    const char* pattern = nullptr;
+    const char* at = nullptr;
+    const char* urgent = nullptr;
+    bool msg = false;
+    const char* bulk_bytes = nullptr;
+    bool bulk_crc = false;
+    bool rpmsg = false;
+    bool mp = false;
+    kr260hal::RtPolicy rt;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "su:rw:mh", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 's':
+                session = true;
                 break;
-            }
+            case 'u':
+                socket_path = optarg;
+                break;
+            case 'r':
+                ctx.use_ring = true;
+                break;
+            case 'w':
+                wave_period = optarg;
+                break;
+            case OPT_WAVE_LOOPS:
+                wave_loops = std::strtoul(optarg, nullptr, 0);
+                break;
+            case OPT_WAVE_DMA:
+                wave_dma = true;
+                break;
+            case OPT_WAVE_STREAM:
+                wave_stream = true;
+                break;
+            case OPT_PATTERN:
+                pattern = optarg;
+                break;
+            case OPT_AT:
+                at = optarg;
+                break;
+            case OPT_URGENT:
+                urgent = optarg;
+                break;
+            case 'm':
+                msg = true;
+                break;
+            case OPT_BULK:
+                bulk_bytes = optarg;
+                break;
+            case OPT_BULK_CRC:
+                bulk_crc = true;
+                break;
+            case OPT_SPIN_NS:
+                ctx.ipi.wait.spin_ns = std::strtoull(optarg, nullptr, 10);
+                break;
+            case OPT_MAX_SLEEP_US:
+                ctx.ipi.wait.max_sleep_us = std::max<uint32_t>(kr260hal::WAIT_MIN_SLEEP_US, std::strtoul(optarg, nullptr, 10));
+                break;
+            case OPT_CORE:
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core >= RPU_CORE_COUNT) {
+                    std::cerr << "Invalid core " << optarg << " (0-" << RPU_CORE_COUNT - 1 << ")" << std::endl;
+                    return 1;
+                }
+                break;
+            case OPT_RPMSG:
+                rpmsg = true;
+                break;
+            case OPT_MP:
+                mp = true;
+                break;
+            case OPT_RT:
+                rt.cpu = std::atoi(optarg);
+                break;
+            case OPT_RT_PRIO:
+                rt.prio = std::atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
         }
-        
-        usleep(100); // 100 microseconds
-        timeout_count += 100;
     }
-    
-    if (timeout_count >= max_timeout) {
-        std::cerr << "ERROR: Timeout waiting for RPU acknowledgment!" << std::endl;
-        std::cerr << "Last ACK value: 0x" << std::hex << ack_val << std::endl;
+
+    if (!session && !socket_path && !wave_period && !pattern && !bulk_bytes && optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
     }
 
-    // Status Read
-    uint32_t obs_val = *ipi_obs;
-    std::cout << "--- Status ---" << std::endl;
-    std::cout << "Shared Mem CMD: " << std::dec << *shared_cmd << std::endl;
-    std::cout << "Shared Mem ACK: 0x" << std::hex << *shared_ack << std::endl;
-    std::cout << "APU IPI OBS (0xFF300004): 0x" << std::hex << obs_val;
-    if (obs_val & MASK_CH1_RPU0) {
-        std::cout << " -> Ch1 (RPU0) PENDING" << std::endl;
-    } else {
-        std::cout << " -> Ch1 (RPU0) IDLE" << std::endl;
+    if (!setup_rt(rt)) return 1;
+
+    if (rpmsg) {
+        if (!msg && !ctx.use_ring) {
+            std::cerr << "--rpmsg applies to --msg and --ring" << std::endl;
+            return 1;
+        }
+        return run_rpmsg(core, ctx.ipi.wait, msg, std::vector<std::string>(argv + optind, argv + argc));
     }
 
-    // Cleanup
-    munmap(shared_base, SHARED_MEM_SIZE);
-    munmap(ipi_apu_base, 0x1000);
-    close(mem_fd);
+    if (!ctx.ipi.open(core)) {
+        std::perror("Error mapping the shared memory and IPI windows");
+        return 1;
+    }
 
-    return 0;
+    int ret = 0;
+    if (session) {
+        ret = run_stdin_session(ctx);
+    } else if (socket_path) {
+        std::signal(SIGPIPE, SIG_IGN); // Client hang-ups must not kill the daemon
+        ret = run_socket_session(ctx, socket_path);
+    } else if (wave_period) {
+        uint32_t period_ns = std::strtoul(wave_period, nullptr, 0);
+        const size_t max = wave_stream ? RPU_WAVE_STREAM_MAX_SAMPLES : SHM_WAVE_MAX_SAMPLES;
+        std::vector<uint32_t> samples;
+        std::stringstream args;
+        for (int i = optind; i < argc; i++) args << argv[i] << ' ';
+        if (!parse_samples(args, samples, max) || (period_ns != 0 && samples.empty())) {
+            std::cerr << "Invalid waveform (at most " << max << " samples)" << std::endl;
+            ret = 1;
+        } else if (wave_stream && period_ns != 0) {
+            ret = run_wave_stream(ctx, period_ns, wave_loops, samples);
+        } else {
+            if (period_ns == 0) samples.clear();
+            IpiResult result = ctx.ipi.send_wave(period_ns, wave_loops, samples, wave_dma);
+            if (samples.empty()) {
+                std::cout << "Waveform stop: " << (result.acked ? "OK" : "FAILED") << std::endl;
+            } else {
+                std::cout << "Waveform of " << samples.size() << " sample(s) at " << period_ns << " ns: "
+                          << (result.acked ? "started" : "FAILED")
+                          << " (status " << result.ack_val << ")" << std::endl;
+            }
+        }
+    } else if (pattern) {
+        ret = ipi_send_pattern(ctx, pattern, std::cout) ? 0 : 1;
+    } else if (at) {
+        uint64_t tick = 0;
+        std::vector<uint32_t> modes;
+        for (int i = optind; i < argc; i++) modes.push_back(std::atoi(argv[i]));
+        if (!parse_at(at, tick)) {
+            std::cerr << "Invalid tick '" << at << "' (counter value or +ms)" << std::endl;
+            ret = 1;
+        } else {
+            IpiResult result = ctx.ipi.send_at(tick, mode_commands(modes));
+            std::cout << "Queued " << modes.size() << " command(s) for tick " << tick << ": "
+                      << (result.acked && result.ack_val == RPU_CMD_STATUS_OK ? "OK" : "FAILED")
+                      << " in " << result.rtt_us << " us (status " << result.ack_val << ")" << std::endl;
+            ret = result.acked && result.ack_val == RPU_CMD_STATUS_OK ? 0 : 1;
+        }
+    } else if (urgent) {
+        IpiResult result = ctx.ipi.send_urgent(RPU_CMD_SET_MODE, std::strtoul(urgent, nullptr, 0));
+        std::cout << "Urgent mode " << urgent << ": " << (result.acked ? "OK" : "FAILED")
+                  << " in " << result.rtt_us << " us (status " << result.ack_val << ")" << std::endl;
+        ret = result.acked ? 0 : 1;
+    } else if (bulk_bytes) {
+        ret = run_bulk_loopback(ctx, std::strtoul(bulk_bytes, nullptr, 0), bulk_crc);
+    } else if (msg) {
+        uint32_t opcode = 0;
+        uint32_t results[RPU_MSG_MAX_RESULTS] = {};
+        std::vector<uint32_t> params;
+        std::stringstream args;
+        for (int i = optind; i < argc; i++) args << argv[i] << ' ';
+        if (!parse_msg(args, opcode, params)) {
+            std::cerr << "Invalid message (opcode 0-255, at most " << SHM_IPI_MSG_DATA_WORDS
+                      << " parameters)" << std::endl;
+            ret = 1;
+        } else {
+            IpiResult result = ctx.ipi.send_msg(opcode, params, results);
+            std::cout << "Message opcode " << opcode << ": " << (result.acked ? "OK" : "FAILED")
+                      << " in " << result.rtt_us << " us, " << format_msg_results(result, results)
+                      << std::endl;
+            ret = result.acked ? 0 : 1;
+        }
+    } else if (mp) {
+        kr260hal::MpCmdChannel channel;
+        std::vector<uint32_t> modes;
+        for (int i = optind; i < argc; i++) modes.push_back(std::atoi(argv[i]));
+        if (!channel.open(ctx.ipi)) {
+            std::perror("Error opening the multi-producer command channel");
+            ret = 1;
+        } else {
+            IpiResult result = channel.send_batch(RPU_CMD_SET_MODE, modes);
+            std::cout << "Posted " << modes.size() << " command(s) on the multi-producer channel: "
+                      << (result.acked ? "OK" : "FAILED") << " in " << result.rtt_us << " us (doorbells "
+                      << channel.doorbells() << ", skipped " << channel.doorbells_skipped() << ")"
+                      << std::endl;
+            ret = result.acked ? 0 : 1;
+        }
+    } else if (ctx.use_ring) {
+        std::vector<uint32_t> modes;
+        for (int i = optind; i < argc; i++) modes.push_back(std::atoi(argv[i]));
+        IpiResult result = ctx.ipi.send_batch(RPU_CMD_SET_MODE, modes);
+        std::cout << "Queued " << modes.size() << " command(s) on the ring: "
+                  << (result.acked ? "consumed" : "FAILED") << " in " << result.rtt_us << " us" << std::endl;
+        ipi_print_status(ctx, std::cout);
+    } else {
+        int mode = std::atoi(argv[optind]);
+        ipi_send_mode(ctx, mode, true);
+        // Status Read
+        ipi_print_status(ctx, std::cout);
+    }
+
+    return ret;
 }
@@ -0,0 +1,1496 @@
+/*
+ * APU benchmark of the APU <-> RPU command paths.
+ *
+ * Usage: ./ipi_bench                      (every transport that can be opened)
+ *        ./ipi_bench --transport mem-ring,dev-msg
+ *        ./ipi_bench --iterations 100000 --batch 1,8,32 --duration-ms 2000
+ *        ./ipi_bench --core 1             (RPU1 firmware in split mode)
+ *        ./ipi_bench --emulate            (no board: host-* against the RPU emulator)
+ *        ./ipi_bench --soak 72 --transport dev-ring --pl-every-min 60 --restart-every-min 15
+ *        ./ipi_bench --soak-print soak.log.1
+ *        ./ipi_bench --energy auto --energy-label power-profile --energy-csv energy.csv
+ * Options:
+ *   --transport <list>    Comma-separated transports below (default all)
+ *   --iterations <n>      Single commands for the latency percentiles (default 10000)
+ *   --batch <list>        Batch sizes of the throughput runs, 1-SHM_RING_SLOTS
+ *                         (default 1,4,16,32)
+ *   --duration-ms <ms>    Length of each throughput run (default 1000)
+ *   --spin-ns, --max-sleep-us   Wait policy, as for ipi_app
+ *   --rt <cpu>, --rt-prio <prio> Real-time setup, as for ipi_app
+ *   --emulate             Run the RPU emulator (kr260hal/host_rpu.h) in a thread
+ *                         of this process; the default transports are then the
+ *                         host ones
+ *   --soak <hours>        Soak mode instead of the benchmark, see below; its
+ *                         options are --soak-interval-s (default 60), --soak-rate
+ *                         (commands/s, default 1000), --soak-log (default soak.log),
+ *                         --soak-log-mb (per file, default 16), --soak-log-files
+ *                         (default 4), --pl-every-min with --pl-image (default
+ *                         gpio_led.bit) and --rpu-image, --restart-every-min
+ *   --soak-print <file>   Print the records of one soak log file
+ *   --energy <rails>      Energy mode instead of the benchmark, see below: "auto"
+ *                         or comma-separated hwmon power*_input files; with
+ *                         --energy-s (per workload, default 10), --energy-sample-ms
+ *                         (default 10), --energy-workloads (default
+ *                         idle,slow,fast,random,ipi,dma), --energy-label and
+ *                         --energy-csv (rows appended: label,core,workload,s,mW,J,
+ *                         delta_mW,msgs)
+ *
+ * Transports:
+ *   mem-cmd   mem-ring   mem-pipe   mem-msg    /dev/mem mapping (kr260hal IPI_BACKEND_MEM)
+ *   uio-cmd   uio-ring   uio-pipe   uio-msg    generic-uio mapping, waits on the reverse IPI
+ *   dev-cmd   dev-ring   dev-pipe   dev-msg    /dev/rpu_ipi mapping, doorbell and message ioctls
+ *   host-cmd  host-ring  host-pipe  host-msg   host files of the RPU emulator (IPI_BACKEND_HOST),
+ *                                              rpu_emu or --emulate; not in the default list
+ *   chardev                         /dev/rpu_ipi write()/read(), ring produced by the module
+ *   chardev-epoll                   the same through RingClient and EventLoop (non-blocking)
+ *   chardev-co                      the same with one coroutine per command (CoRing), a
+ *                                   batch being that many coroutines in flight
+ *   sysfs                           /sys/kernel/rpu_ipi/write, one blocking command per write
+ * "cmd" is the legacy CMD/ACK words, "ring" the command ring (RPU_CMD_NOP
+ * descriptors), "pipe" the ring through submit(), each batch queued before
+ * the previous one is waited for so the RPU never idles between batches
+ * (its latency is the time per command in that pipeline), "msg" the IPI
+ * message buffer (RPU_CMD_NOP, whose echoed
+ * parameter is checked). The dev, chardev and sysfs transports need the
+ * rpu_ipi module and serve RPU0 only.
+ *
+ * For each transport the latency test sends single commands back to back and
+ * reports the percentiles of the round trip seen by the caller, from the
+ * start of the call to the observed completion, system calls included. The
+ * throughput test then sends batches for --duration-ms and reports commands
+ * per second; transports that carry one command per doorbell (cmd, msg,
+ * sysfs) only run batch 1. Both report the CPU time of this process (user and
+ * system, getrusage) per command, so a transport that polls costs a core
+ * while one that sleeps in the kernel does not:
+ *   transport   n      p50_us   p99_us   p99.9_us  max_us   usr_us  sys_us
+ *   mem-ring    10000  4.180    6.020    11.740    31.200   4.12    0.01
+ *
+ *   transport   batch  cmds/s     usr_us  sys_us
+ *   mem-ring    32     2150000.0  0.45    0.00
+ *
+ * With --rt the percentiles are those of a pinned SCHED_FIFO caller whose
+ * reverse IPI lands on its own core; compare the tails with and without it
+ * (and with the core isolated) to see what the APU side adds.
+ *
+ * The RPU firmware is switched to echo mode (SHM_APU_FLAG_ECHO) for the run:
+ * legacy commands are acknowledged without changing the blink mode and the
+ * firmware skips its per-command UART log. The flag is cleared on exit.
+ *
+ * The soak mode sends paced single commands on the first transport of the
+ * list that opens, for hours, and once per interval appends a binary record
+ * to a log that rotates to <log>.1, <log>.2, ... when full: the interval's
+ * p50/p99/max and failures, the rpu_ipi timeout counters (debugfs), the
+ * RPU's heap and lowest task stack watermark (stats block), the SYSMON die
+ * temperatures (RPU_SYSMON=1) and this process's RSS and open fds. Between
+ * intervals it reprograms the PL through fw_loader (next to this binary or in
+ * PATH) and restarts the RPU through remoteproc at the periods given,
+ * reopening the transport once the firmware answers again. At the end it
+ * prints how each value moved from the first to the last interval; slow
+ * drifts show in --soak-print over the rotated files.
+ *
+ * The energy mode samples the board's power monitors (INA2xx through hwmon,
+ * "auto" sums every power*_input of the ina* devices) in a thread while the
+ * RPU runs each workload for --energy-s after a settling second: "idle"
+ * with control released and no traffic, "slow", "fast" and "random" in
+ * those blink modes, "ipi" as NOP batches back to back on the first
+ * transport of the list that opens (echo mode), "dma" as a 1 MHz waveform
+ * from the DMA engine. It reports mean power, energy, the power above idle
+ * and for "ipi" messages per joule of the board and of its power above idle:
+ *   workload s       power_mW   energy_J  delta_mW  msgs        msgs/J      msgs/J_idle
+ *   ipi      10.0    3410.2     34.102    289.8     21000000    615800      7246300
+ * The tick profile and the clock governor are build options of the firmware
+ * (RPU_PROFILE, RPU_GOVERNOR): run once per build with --energy-label and
+ * the same --energy-csv to compare them. The header says whether the
+ * governor block is live.
+ *
+ * The host transports measure the APU code paths and the shape of each
+ * protocol (doorbells per batch, pipelining, wait policy) between two cores
+ * of the machine running the benchmark, e.g. to compare changes in CI; their
+ * round trips are not those of the board.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "rpu_shm.h"
+#include "rpu_ipi_ioctl.h"
+#include "kr260hal/ipi_transport.h"
+#include "kr260hal/event_loop.h"
+#include "kr260hal/co_ring.h"
+#include "kr260hal/host_rpu.h"
+#include "kr260hal/rt.h"
+#include "kr260hal/sysfs.h"
+
+namespace shm = kr260hal::shm;
+
+#define BENCH_ITERATIONS_DEFAULT  10000
+#define BENCH_WARMUP              100
+#define BENCH_DURATION_MS_DEFAULT 1000
+#define BENCH_SYSFS_WRITE         "/sys/kernel/rpu_ipi/write"
+#define BENCH_MODE                3  // Legacy mode sent by cmd and sysfs (release control)
+
+#define SOAK_INTERVAL_S_DEFAULT   60
+#define SOAK_RATE_DEFAULT         1000  // Commands per second
+#define SOAK_LOG_DEFAULT          "soak.log"
+#define SOAK_LOG_MB_DEFAULT       16
+#define SOAK_LOG_FILES_DEFAULT    4
+#define SOAK_PL_IMAGE_DEFAULT     "gpio_led.bit"
+#define SOAK_RPROC_PREFIX         "/sys/class/remoteproc/remoteproc"  // <core>/state
+#define SOAK_RPROC_TIMEOUT_MS     2000
+#define SOAK_REOPEN_S             30    // Wait for the firmware after a restart or a failure
+#define SOAK_READ_RETRIES         10
+#define SOAK_KSTATS_PATH          "/sys/kernel/debug/rpu_ipi/stats"
+#define SOAK_LOG_MAGIC            0x4B414F53  // "SOAK"
+#define SOAK_LOG_VERSION          1
+#define SOAK_HAVE_KSTATS          0x1   // SoakRecord::flags
+#define SOAK_HAVE_STATS           0x2
+#define SOAK_HAVE_SYSMON          0x4
+
+#define ENERGY_DURATION_S_DEFAULT 10
+#define ENERGY_SAMPLE_MS_DEFAULT  10
+#define ENERGY_SETTLE_MS          1000
+#define ENERGY_POLL_MS            50   // Idle workloads: how often the window end is checked
+#define ENERGY_IPI_BATCH          32
+#define ENERGY_DMA_PERIOD_NS      1000  // 1 MHz DMA playback
+#define ENERGY_HWMON_DIR          "/sys/class/hwmon"
+#define ENERGY_MAX_CHANNELS       4     // power1_input .. power4_input per device
+#define ENERGY_MIN_DELTA_MW       1.0   // Below this above idle, msgs/J_idle is noise
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+/*-----------------------------------------------------------*/
+/* One way of getting commands to the RPU and waiting for their completion */
+class BenchTarget {
+public:
+    virtual ~BenchTarget() = default;
+
+    // false (errno set) if the transport is not available
+    virtual bool open(unsigned core) = 0;
+    // Several commands per doorbell
+    virtual bool batches() const { return false; }
+    // Send count commands and wait for all of them; false on a failure
+    virtual bool send(uint32_t count) = 0;
+};
+
+enum BenchProto { PROTO_CMD, PROTO_RING, PROTO_PIPE, PROTO_MSG };
+
+// Commands through libkr260hal on one backend
+class HalTarget : public BenchTarget {
+public:
+    HalTarget(kr260hal::IpiBackend backend, BenchProto proto, const kr260hal::WaitPolicy& wait)
+        : backend_(backend), proto_(proto) {
+        ipi_.wait = wait;
+    }
+    // The last pipelined batch, before the transport is closed
+    ~HalTarget() override {
+        if (pending_) ipi_.wait_done(ticket_);
+    }
+
+    bool open(unsigned core) override { return ipi_.open(core, backend_); }
+    bool batches() const override { return proto_ == PROTO_RING || proto_ == PROTO_PIPE; }
+
+    bool send(uint32_t count) override {
+        switch (proto_) {
+            case PROTO_CMD:
+                return ipi_.send_mode(BENCH_MODE).acked;
+            case PROTO_RING:
+                args_.resize(count);
+                for (uint32_t i = 0; i < count; i++) args_[i] = next_++;
+                return ipi_.send_batch(RPU_CMD_NOP, args_).acked;
+            case PROTO_PIPE: {
+                kr260hal::RingTicket previous = ticket_;
+                cmds_.resize(count);
+                for (uint32_t i = 0; i < count; i++) cmds_[i] = {RPU_CMD_NOP, next_++};
+                if (!ipi_.submit(cmds_, &ticket_)) return false;
+                bool ok = !pending_ || ipi_.wait_done(previous).acked;
+                pending_ = true;
+                return ok;
+            }
+            case PROTO_MSG: {
+                uint32_t results[RPU_MSG_MAX_RESULTS] = {0};
+                uint32_t param = next_++;
+                kr260hal::IpiResult r = ipi_.send_msg(RPU_CMD_NOP, {param}, results);
+                return r.acked && r.ack_val == RPU_CMD_STATUS_OK && results[0] == param;
+            }
+        }
+        return false;
+    }
+
+private:
+    kr260hal::IpiTransport ipi_;
+    kr260hal::IpiBackend backend_;
+    BenchProto proto_;
+    std::vector<uint32_t> args_;
+    std::vector<kr260hal::RingCommand> cmds_;
+    kr260hal::RingTicket ticket_;
+    bool pending_ = false;
+    uint32_t next_ = 0;
+};
+
+// Ring commands produced by the kernel module: write() then read() completions
+class ChardevTarget : public BenchTarget {
+public:
+    ~ChardevTarget() override {
+        if (fd_ != -1) close(fd_);
+    }
+
+    bool open(unsigned core) override {
+        if (core != 0) {
+            errno = EINVAL;
+            return false;
+        }
+        fd_ = ::open("/dev/" RPU_IPI_DEV_NAME, O_RDWR);
+        return fd_ != -1;
+    }
+    bool batches() const override { return true; }
+
+    bool send(uint32_t count) override {
+        cmds_.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            cmds_[i].opcode = RPU_CMD_NOP;
+            cmds_[i].arg = next_++;
+            cmds_[i].seq = 0;
+            cmds_[i].status = RPU_CMD_STATUS_PENDING;
+        }
+
+        // Blocks while the ring is full; returns the bytes queued
+        size_t sent = 0;
+        while (sent < count) {
+            ssize_t n = write(fd_, &cmds_[sent], (count - sent) * sizeof(rpu_ipi_cmd));
+            if (n <= 0) return false;
+            sent += n / sizeof(rpu_ipi_cmd);
+        }
+
+        bool ok = true;
+        size_t done = 0;
+        while (done < count) {
+            ssize_t n = read(fd_, &cmds_[done], (count - done) * sizeof(rpu_ipi_cmd));
+            if (n <= 0) return false;
+            for (size_t i = done; i < done + n / sizeof(rpu_ipi_cmd); i++) {
+                if (cmds_[i].status != RPU_CMD_STATUS_OK) ok = false;
+            }
+            done += n / sizeof(rpu_ipi_cmd);
+        }
+        return ok;
+    }
+
+private:
+    int fd_ = -1;
+    std::vector<rpu_ipi_cmd> cmds_;
+    uint32_t next_ = 0;
+};
+
+// The module's ring producer from an epoll loop, as an event-driven controller
+class EpollTarget : public BenchTarget {
+public:
+    bool open(unsigned core) override {
+        if (core != 0) {
+            errno = EINVAL;
+            return false;
+        }
+        if (!client_.open() || !loop_.open()) return false;
+        client_.on_complete = [this](const rpu_ipi_cmd& cmd) {
+            if (cmd.status != RPU_CMD_STATUS_OK) failed_ = true;
+        };
+        return loop_.watch(client_, [this] { error_ = true; });
+    }
+    bool batches() const override { return true; }
+
+    bool send(uint32_t count) override {
+        cmds_.resize(count);
+        for (uint32_t i = 0; i < count; i++) cmds_[i] = {RPU_CMD_NOP, next_++};
+
+        failed_ = false;
+        client_.submit(cmds_);
+        while (client_.outstanding() != 0 && !error_) {
+            if (loop_.run_once(BENCH_EPOLL_TIMEOUT_MS) <= 0) return false;
+        }
+        return !failed_ && !error_;
+    }
+
+private:
+    static constexpr int BENCH_EPOLL_TIMEOUT_MS = 1000;
+
+    kr260hal::RingClient client_;
+    kr260hal::EventLoop loop_;
+    std::vector<kr260hal::RingCommand> cmds_;
+    bool failed_ = false;
+    bool error_ = false;
+    uint32_t next_ = 0;
+};
+
+// The module's ring producer from coroutines, each awaiting its own command
+class CoTarget : public BenchTarget {
+public:
+    bool open(unsigned core) override {
+        if (core != 0) {
+            errno = EINVAL;
+            return false;
+        }
+        return loop_.open() && ring_.open(loop_);
+    }
+    bool batches() const override { return true; }
+
+    bool send(uint32_t count) override {
+        failed_ = false;
+        for (uint32_t i = 0; i < count; i++) nop(next_++);
+        while (ring_.outstanding() != 0) {
+            if (ring_.run_once(BENCH_EPOLL_TIMEOUT_MS) <= 0) return false;
+        }
+        return !failed_ && ring_.error() == 0;
+    }
+
+private:
+    static constexpr int BENCH_EPOLL_TIMEOUT_MS = 1000;
+
+    kr260hal::CoTask nop(uint32_t arg) {
+        rpu_ipi_cmd done = co_await ring_.send({RPU_CMD_NOP, arg});
+        if (done.status != RPU_CMD_STATUS_OK) failed_ = true;
+    }
+
+    // Declared first: the ring is closed before the loop it is registered with
+    kr260hal::EventLoop loop_;
+    kr260hal::CoRing ring_;
+    bool failed_ = false;
+    uint32_t next_ = 0;
+};
+
+// Legacy commands through the module's blocking sysfs attribute
+class SysfsTarget : public BenchTarget {
+public:
+    ~SysfsTarget() override {
+        if (fd_ != -1) close(fd_);
+    }
+
+    bool open(unsigned core) override {
+        if (core != 0) {
+            errno = EINVAL;
+            return false;
+        }
+        fd_ = ::open(BENCH_SYSFS_WRITE, O_WRONLY);
+        return fd_ != -1;
+    }
+
+    bool send(uint32_t) override {
+        // The store returns once the RPU has acknowledged (or with -ETIMEDOUT)
+        static const char buf[] = {'0' + BENCH_MODE, '\n'};
+        return pwrite(fd_, buf, sizeof(buf), 0) == (ssize_t)sizeof(buf);
+    }
+
+private:
+    int fd_ = -1;
+};
+
+/*-----------------------------------------------------------*/
+static const char* const ALL_TRANSPORTS[] = {
+    "mem-cmd", "mem-ring", "mem-pipe", "mem-msg",
+    "uio-cmd", "uio-ring", "uio-pipe", "uio-msg",
+    "dev-cmd", "dev-ring", "dev-pipe", "dev-msg",
+    "chardev", "chardev-epoll", "chardev-co", "sysfs",
+};
+
+// Default of --emulate
+static const char* const HOST_TRANSPORTS[] = {
+    "host-cmd", "host-ring", "host-pipe", "host-msg",
+};
+
+static std::unique_ptr<BenchTarget> make_target(const std::string& name,
+                                                const kr260hal::WaitPolicy& wait) {
+    if (name == "chardev") return std::unique_ptr<BenchTarget>(new ChardevTarget());
+    if (name == "chardev-epoll") return std::unique_ptr<BenchTarget>(new EpollTarget());
+    if (name == "chardev-co") return std::unique_ptr<BenchTarget>(new CoTarget());
+    if (name == "sysfs") return std::unique_ptr<BenchTarget>(new SysfsTarget());
+
+    size_t dash = name.find('-');
+    if (dash == std::string::npos) return nullptr;
+    const std::string backend = name.substr(0, dash);
+    const std::string proto = name.substr(dash + 1);
+
+    kr260hal::IpiBackend b;
+    if (backend == "mem") b = kr260hal::IPI_BACKEND_MEM;
+    else if (backend == "uio") b = kr260hal::IPI_BACKEND_UIO;
+    else if (backend == "dev") b = kr260hal::IPI_BACKEND_DEV;
+    else if (backend == "host") b = kr260hal::IPI_BACKEND_HOST;
+    else return nullptr;
+
+    BenchProto p;
+    if (proto == "cmd") p = PROTO_CMD;
+    else if (proto == "ring") p = PROTO_RING;
+    else if (proto == "pipe") p = PROTO_PIPE;
+    else if (proto == "msg") p = PROTO_MSG;
+    else return nullptr;
+
+    return std::unique_ptr<BenchTarget>(new HalTarget(b, p, wait));
+}
+
+// Set or clear SHM_APU_FLAG_ECHO through a short-lived mapping, so no
+// transport under test has to share the window (or /dev/rpu_ipi) with it;
+// in the emulator's window when only host transports run
+static bool set_echo(unsigned core, kr260hal::IpiBackend backend, bool on) {
+    kr260hal::IpiTransport ipi;
+    if (!ipi.open(core, backend)) return false;
+    uint32_t flags = ipi.shm().read<shm::ApuFlags>();
+    flags = on ? (flags | SHM_APU_FLAG_ECHO) : (flags & ~SHM_APU_FLAG_ECHO);
+    ipi.shm().write<shm::ApuFlags>(flags);
+    kr260hal::barrier::complete();  // Before the window is unmapped
+    return true;
+}
+
+// CPU time of this process (user, system) in microseconds
+static void cpu_time_us(double& usr, double& sys) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    usr = ru.ru_utime.tv_sec * 1e6 + ru.ru_utime.tv_usec;
+    sys = ru.ru_stime.tv_sec * 1e6 + ru.ru_stime.tv_usec;
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const std::vector<double>& sorted, double pct) {
+    size_t rank = (size_t)(pct / 100.0 * sorted.size() + 0.999999);
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+static bool run_latency(const std::string& name, BenchTarget& target, unsigned iterations) {
+    std::vector<double> rtt;
+    rtt.reserve(iterations);
+
+    for (unsigned i = 0; i < BENCH_WARMUP && !stop_requested; i++) {
+        if (!target.send(1)) {
+            std::printf("%-11s RPU did not answer\n", name.c_str());
+            return false;
+        }
+    }
+
+    double usr0, sys0, usr1, sys1;
+    cpu_time_us(usr0, sys0);
+    for (unsigned i = 0; i < iterations && !stop_requested; i++) {
+        uint64_t start = kr260hal::now_ns();
+        if (!target.send(1)) {
+            std::printf("%-11s RPU did not answer after %u commands\n", name.c_str(), i);
+            return false;
+        }
+        rtt.push_back((kr260hal::now_ns() - start) / 1000.0);
+    }
+    cpu_time_us(usr1, sys1);
+    if (rtt.empty()) return false;
+
+    std::sort(rtt.begin(), rtt.end());
+    std::printf("%-11s %-6zu %-8.3f %-8.3f %-9.3f %-8.3f %-7.2f %.2f\n",
+                name.c_str(), rtt.size(), percentile(rtt, 50), percentile(rtt, 99),
+                percentile(rtt, 99.9), rtt.back(),
+                (usr1 - usr0) / rtt.size(), (sys1 - sys0) / rtt.size());
+    return true;
+}
+
+static bool run_throughput(const std::string& name, BenchTarget& target, uint32_t batch,
+                           unsigned duration_ms) {
+    const uint64_t start = kr260hal::now_ns();
+    const uint64_t end = start + (uint64_t)duration_ms * 1000000ULL;
+    uint64_t cmds = 0;
+    uint64_t now = start;
+    double usr0, sys0, usr1, sys1;
+
+    cpu_time_us(usr0, sys0);
+    while (now < end && !stop_requested) {
+        if (!target.send(batch)) {
+            std::printf("%-11s %-6u RPU did not answer\n", name.c_str(), batch);
+            return false;
+        }
+        cmds += batch;
+        now = kr260hal::now_ns();
+    }
+    cpu_time_us(usr1, sys1);
+    if (cmds == 0) return false;
+
+    std::printf("%-11s %-6u %-10.1f %-7.2f %.2f\n", name.c_str(), batch,
+                cmds * 1e9 / (now - start), (usr1 - usr0) / cmds, (sys1 - sys0) / cmds);
+    return true;
+}
+
+static std::vector<std::string> split_list(const char* arg) {
+    std::vector<std::string> items;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// Real-time setup of --rt, before any window is mapped (mlockall covers them)
+static bool setup_rt(kr260hal::RtPolicy& rt) {
+    if (rt.cpu < 0) return true;
+    std::string error, warning;
+    rt.irqs = kr260hal::ipi_irqs();
+    if (!kr260hal::apply_rt(rt, error, warning)) {
+        std::cerr << "Error " << error << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (!warning.empty()) std::cerr << "Warning: " << warning << std::endl;
+    std::printf("Real-time on core %d, SCHED_FIFO %d, %zu reverse IPI IRQ(s) steered\n",
+                rt.cpu, rt.prio, rt.irqs.size());
+    return true;
+}
+
+/*-----------------------------------------------------------*/
+/* Soak mode: hours of paced commands, sampled once per interval into a rotating log */
+struct SoakOptions {
+    double hours = 0;
+    unsigned interval_s = SOAK_INTERVAL_S_DEFAULT;
+    unsigned rate = SOAK_RATE_DEFAULT;
+    std::string log = SOAK_LOG_DEFAULT;
+    unsigned log_mb = SOAK_LOG_MB_DEFAULT;
+    unsigned log_files = SOAK_LOG_FILES_DEFAULT;
+    unsigned pl_every_min = 0;
+    std::string pl_image = SOAK_PL_IMAGE_DEFAULT;
+    unsigned restart_every_min = 0;
+    std::string rpu_image;  // Image of the PL loads' RPU step, fw_loader's default if empty
+};
+
+// Log file layout: one SoakLogHeader, then SoakRecords, both little endian
+struct SoakLogHeader {
+    uint32_t magic;        // SOAK_LOG_MAGIC
+    uint32_t version;      // SOAK_LOG_VERSION
+    uint32_t record_size;  // sizeof(SoakRecord)
+    uint32_t core;
+};
+
+struct SoakRecord {
+    uint64_t wall_ns;         // CLOCK_REALTIME at the end of the interval
+    uint32_t interval;        // Since the start of the soak
+    uint32_t flags;           // SOAK_HAVE_*: which of the groups below were read
+    uint32_t commands;        // Answered in the interval
+    uint32_t failed;          // Not answered (transport reopened)
+    float p50_us;
+    float p99_us;
+    float max_us;
+    uint32_t k_timeouts;      // rpu_ipi counters (debugfs), since the module loaded
+    uint32_t k_msg_timeouts;
+    uint32_t k_bad_acks;
+    uint32_t heap_free;       // RPU run-time stats block
+    uint32_t heap_min;
+    uint32_t stack_min;       // Lowest stack high water mark of any task, bytes
+    char stack_task[SHM_STATS_NAME_LEN];
+    int32_t temp_lpd_mc;      // SYSMON block
+    int32_t temp_fpd_mc;
+    uint32_t temp_alarms;
+    uint32_t apu_rss_kb;      // This process, for leaks on the APU side
+    uint32_t apu_fds;
+    uint32_t rpu_restarts;    // Disruptions so far (a PL load restarts the RPU too)
+    uint32_t pl_loads;
+    uint32_t load_failures;
+};
+
+// Appends records, and moves the file to <path>.1 (.1 to .2, ...) once full
+class SoakLog {
+public:
+    ~SoakLog() {
+        if (fd_ != -1) ::close(fd_);
+    }
+
+    bool open(const SoakOptions& opts, unsigned core) {
+        path_ = opts.log;
+        max_bytes_ = std::max<uint64_t>(1, opts.log_mb) << 20;
+        files_ = std::max(1U, opts.log_files);
+        core_ = core;
+        return reopen();
+    }
+
+    bool append(const SoakRecord& rec) {
+        if (size_ + sizeof(rec) > max_bytes_ && !rotate()) return false;
+        if (::write(fd_, &rec, sizeof(rec)) != (ssize_t)sizeof(rec)) return false;
+        size_ += sizeof(rec);
+        // A record per interval: losing the last ones with the board is what a soak must avoid
+        fdatasync(fd_);
+        return true;
+    }
+
+private:
+    bool reopen() {
+        if (fd_ != -1) ::close(fd_);
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ == -1) return false;
+        const SoakLogHeader hdr = {SOAK_LOG_MAGIC, SOAK_LOG_VERSION, sizeof(SoakRecord), core_};
+        size_ = sizeof(hdr);
+        return ::write(fd_, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr);
+    }
+
+    bool rotate() {
+        for (unsigned i = files_ - 1; i > 0; i--) {
+            const std::string from = i == 1 ? path_ : path_ + "." + std::to_string(i - 1);
+            std::rename(from.c_str(), (path_ + "." + std::to_string(i)).c_str());
+        }
+        return reopen();
+    }
+
+    std::string path_;
+    uint64_t max_bytes_ = 0;
+    uint64_t size_ = 0;
+    unsigned files_ = 1;
+    unsigned core_ = 0;
+    int fd_ = -1;
+};
+
+static uint64_t wall_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Timeout counters of /sys/kernel/debug/rpu_ipi/stats
+static bool read_kernel_counters(SoakRecord& rec) {
+    std::ifstream in(SOAK_KSTATS_PATH);
+    std::string key;
+    unsigned long long value;
+    if (!in) return false;
+    while (in >> key) {
+        if (key == "timeouts:" && in >> value) rec.k_timeouts = value;
+        else if (key == "ipi_msg_timeouts:" && in >> value) rec.k_msg_timeouts = value;
+        else if (key == "bad_acks:" && in >> value) rec.k_bad_acks = value;
+        else in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return true;
+}
+
+// Heap and stack watermarks from the stats block, seqlock as in rpu_stats
+static bool read_rpu_watermarks(const kr260hal::MemMap& win, SoakRecord& rec) {
+    if (win.read<shm::StatsMagic>() != SHM_STATS_MAGIC) return false;
+    for (int tries = 0; tries < SOAK_READ_RETRIES; tries++) {
+        const uint32_t seq = win.read<shm::StatsSeq>();
+        if (seq & 1) {
+            usleep(100);
+            continue;
+        }
+        kr260hal::barrier::acquire();
+        rec.heap_free = win.read<shm::StatsHeap>();
+        rec.heap_min = win.read<shm::StatsHeapMin>();
+        rec.stack_min = UINT32_MAX;
+        const uint32_t count = std::min<uint32_t>(win.read<shm::StatsCount>(), SHM_STATS_MAX_TASKS);
+        for (uint32_t i = 0; i < count; i++) {
+            volatile uint32_t* src = win.at(SHM_STATS_ENTRY(i));
+            uint32_t words[SHM_STATS_ENTRY_SIZE / 4];
+            for (unsigned w = 0; w < SHM_STATS_ENTRY_SIZE / 4; w++) words[w] = src[w];
+            rpu_shm_task_stat t;
+            std::memcpy(&t, words, sizeof(t));
+            if (t.stack_free < rec.stack_min) {
+                rec.stack_min = t.stack_free;
+                std::memcpy(rec.stack_task, t.name, SHM_STATS_NAME_LEN);
+                rec.stack_task[SHM_STATS_NAME_LEN - 1] = '\0';
+            }
+        }
+        kr260hal::barrier::acquire();
+        if (win.read<shm::StatsSeq>() == seq) return true;
+    }
+    return false;
+}
+
+static bool read_sysmon_temps(const kr260hal::MemMap& blk, SoakRecord& rec) {
+    if (!blk.valid() || *blk.at(SYSMON_MAGIC_OFFSET) != SYSMON_MAGIC) return false;
+    for (int tries = 0; tries < SOAK_READ_RETRIES; tries++) {
+        const uint32_t seq = *blk.at(SYSMON_SEQ_OFFSET);
+        if (seq & 1) {
+            usleep(100);
+            continue;
+        }
+        kr260hal::barrier::acquire();
+        rec.temp_lpd_mc = (int32_t)*blk.at(SYSMON_CH(SYSMON_CH_TEMP_LPD));
+        rec.temp_fpd_mc = (int32_t)*blk.at(SYSMON_CH(SYSMON_CH_TEMP_FPD));
+        rec.temp_alarms = *blk.at(SYSMON_ALARMS_OFFSET);
+        kr260hal::barrier::acquire();
+        if (*blk.at(SYSMON_SEQ_OFFSET) == seq) return true;
+    }
+    return false;
+}
+
+static void read_apu_usage(SoakRecord& rec) {
+    unsigned long size, resident;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f != nullptr) {
+        if (std::fscanf(f, "%lu %lu", &size, &resident) == 2) {
+            rec.apu_rss_kb = resident * (sysconf(_SC_PAGESIZE) / 1024);
+        }
+        std::fclose(f);
+    }
+    DIR* dir = opendir("/proc/self/fd");
+    if (dir != nullptr) {
+        while (readdir(dir) != nullptr) rec.apu_fds++;
+        closedir(dir);
+        rec.apu_fds -= 3;  // ".", ".." and the directory's own fd
+    }
+}
+
+// fw_loader next to this binary, else from PATH; true if it exited with 0
+static bool run_fw_loader(const std::vector<std::string>& args) {
+    std::string loader = "fw_loader";
+    char self[PATH_MAX];
+    ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (n > 0) {
+        self[n] = '\0';
+        const std::string dir(self, std::strrchr(self, '/') - self);
+        if (access((dir + "/fw_loader").c_str(), X_OK) == 0) loader = dir + "/fw_loader";
+    }
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(loader.c_str()));
+    for (const std::string& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    if (pid == -1 || waitpid(pid, &status, 0) != pid) return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// remoteproc stop and start of the running image, as fw_loader does it
+static bool restart_rpu(unsigned core) {
+    const std::string state = SOAK_RPROC_PREFIX + std::to_string(core) + "/state";
+    std::string current;
+    std::printf("Restarting RPU%u\n", core);
+    return kr260hal::sysfs_write(state, "stop") &&
+           kr260hal::sysfs_wait_for(state, "offline", SOAK_RPROC_TIMEOUT_MS, current) &&
+           kr260hal::sysfs_write(state, "start") &&
+           kr260hal::sysfs_wait_for(state, "running", SOAK_RPROC_TIMEOUT_MS, current);
+}
+
+// The transport with echo mode, retried while the firmware comes back up
+static std::unique_ptr<BenchTarget> open_soak_target(const std::string& name, unsigned core,
+                                                     const kr260hal::WaitPolicy& wait,
+                                                     kr260hal::IpiBackend echo_backend) {
+    for (unsigned i = 0; i < SOAK_REOPEN_S && !stop_requested; i++) {
+        std::unique_ptr<BenchTarget> target = make_target(name, wait);
+        if (set_echo(core, echo_backend, true) && target->open(core)) return target;
+        sleep(1);
+    }
+    return nullptr;
+}
+
+// One row of the soak table, "-" for what the interval could not read
+static void print_soak_header() {
+    std::printf("%-20s %-9s %-8s %-7s %-9s %-9s %-8s %-10s %-10s %-11s %-8s %-8s %-5s %s\n",
+                "time_utc", "interval", "cmds", "failed", "p50_us", "p99_us", "k_tmo", "heap_min",
+                "stack_min", "task", "temp_C", "rss_kb", "fds", "restarts/pl/failed");
+}
+
+static void print_soak_row(const SoakRecord& rec) {
+    char when[32];
+    const time_t secs = rec.wall_ns / 1000000000ULL;
+    struct tm tm;
+    std::strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", gmtime_r(&secs, &tm));
+    std::printf("%-20s %-9u %-8u %-7u %-9.3f %-9.3f ", when, rec.interval, rec.commands,
+                rec.failed, rec.p50_us, rec.p99_us);
+    if (rec.flags & SOAK_HAVE_KSTATS) std::printf("%-8u ", rec.k_timeouts);
+    else std::printf("%-8s ", "-");
+    if (rec.flags & SOAK_HAVE_STATS) {
+        std::printf("%-10u %-10u %-11.*s ", rec.heap_min, rec.stack_min, SHM_STATS_NAME_LEN - 1,
+                    rec.stack_task);
+    } else {
+        std::printf("%-10s %-10s %-11s ", "-", "-", "-");
+    }
+    if (rec.flags & SOAK_HAVE_SYSMON) std::printf("%-8.1f ", rec.temp_lpd_mc / 1000.0);
+    else std::printf("%-8s ", "-");
+    std::printf("%-8u %-5u %u/%u/%u\n", rec.apu_rss_kb, rec.apu_fds, rec.rpu_restarts,
+                rec.pl_loads, rec.load_failures);
+}
+
+static bool run_soak(const std::string& name, unsigned core, const kr260hal::WaitPolicy& wait,
+                     kr260hal::IpiBackend echo_backend, const SoakOptions& opts) {
+    SoakLog log;
+    if (!log.open(opts, core)) {
+        std::perror(("Error creating " + opts.log).c_str());
+        return false;
+    }
+    // Optional: only an RPU0 firmware built with RPU_SYSMON=1 fills it
+    kr260hal::MemMap sysmon;
+    sysmon.map_phys(SYSMON_ADDR, SYSMON_SIZE, false);
+
+    const uint64_t start = kr260hal::now_ns();
+    const uint64_t end = start + (uint64_t)(opts.hours * 3600e9);
+    const uint64_t interval_ns = opts.interval_s * 1000000000ULL;
+    const uint64_t gap_ns = 1000000000ULL / std::max(1U, opts.rate);
+    const uint64_t pl_ns = opts.pl_every_min * 60000000000ULL;
+    const uint64_t restart_ns = opts.restart_every_min * 60000000000ULL;
+    uint64_t next_pl = start + pl_ns;
+    uint64_t next_restart = start + restart_ns;
+    SoakRecord first = {}, rec = {};
+    bool ok = true;
+
+    std::printf("Soak of %s on RPU%u for %g h: %u commands/s, a record every %u s to %s\n\n",
+                name.c_str(), core, opts.hours, opts.rate, opts.interval_s, opts.log.c_str());
+    print_soak_header();
+
+    for (uint32_t interval = 0; kr260hal::now_ns() < end && !stop_requested; interval++) {
+        std::unique_ptr<BenchTarget> target = open_soak_target(name, core, wait, echo_backend);
+        std::vector<double> rtt;
+        const bool opened = target != nullptr;
+        const SoakRecord prev = rec;
+        rec = SoakRecord();
+        rec.interval = interval;
+        rec.rpu_restarts = prev.rpu_restarts;
+        rec.pl_loads = prev.pl_loads;
+        rec.load_failures = prev.load_failures;
+
+        // Paced commands until the end of the interval; a failure reopens the transport
+        const uint64_t interval_end = std::min(end, kr260hal::now_ns() + interval_ns);
+        uint64_t next = kr260hal::now_ns();
+        while (target && !stop_requested) {
+            uint64_t now = kr260hal::now_ns();
+            if (now >= interval_end) break;
+            if (now < next) {
+                usleep(std::min<uint64_t>(next - now, interval_end - now) / 1000);
+                continue;
+            }
+            next += gap_ns;
+            if (next < now) next = now;  // No catch-up burst after a stall
+            if (target->send(1)) {
+                rtt.push_back((kr260hal::now_ns() - now) / 1000.0);
+            } else {
+                rec.failed++;
+                target = open_soak_target(name, core, wait, echo_backend);
+            }
+        }
+        if (!opened) rec.failed++;
+        // Sampling and fw_loader need the transport closed
+        target.reset();
+
+        rec.wall_ns = wall_ns();
+        rec.commands = rtt.size();
+        if (!rtt.empty()) {
+            std::sort(rtt.begin(), rtt.end());
+            rec.p50_us = percentile(rtt, 50);
+            rec.p99_us = percentile(rtt, 99);
+            rec.max_us = rtt.back();
+        }
+        if (read_kernel_counters(rec)) rec.flags |= SOAK_HAVE_KSTATS;
+        {
+            kr260hal::IpiTransport ipi;
+            if (ipi.open(core, echo_backend) && read_rpu_watermarks(ipi.shm(), rec)) {
+                rec.flags |= SOAK_HAVE_STATS;
+            }
+        }
+        if (read_sysmon_temps(sysmon, rec)) rec.flags |= SOAK_HAVE_SYSMON;
+        read_apu_usage(rec);
+        if (interval == 0) first = rec;
+
+        if (!log.append(rec)) {
+            std::perror(("Error writing " + opts.log).c_str());
+            ok = false;
+            break;
+        }
+        print_soak_row(rec);
+        std::fflush(stdout);
+        if (rec.failed != 0) ok = false;
+
+        // Disruptions between intervals, so each interval measures a settled system
+        const uint64_t now = kr260hal::now_ns();
+        if (pl_ns != 0 && now >= next_pl && now < end) {
+            next_pl += pl_ns;
+            // fw_loader restarts the core on the PL it programs, with the image given
+            std::vector<std::string> args = {"--force", "--core", std::to_string(core), opts.pl_image};
+            if (!opts.rpu_image.empty()) args.push_back(opts.rpu_image);
+            if (run_fw_loader(args)) rec.pl_loads++;
+            else rec.load_failures++;
+        }
+        if (restart_ns != 0 && now >= next_restart && now < end) {
+            next_restart += restart_ns;
+            if (restart_rpu(core)) rec.rpu_restarts++;
+            else rec.load_failures++;
+        }
+    }
+
+    // Drift over the run: what a field unit would see after days
+    if (rec.interval != 0) {
+        std::printf("\nFrom the first to the last interval: p99 %.3f -> %.3f us", first.p99_us, rec.p99_us);
+        if (first.flags & rec.flags & SOAK_HAVE_STATS) {
+            std::printf(", heap_min %u -> %u, stack_min %u -> %u (%.*s)", first.heap_min, rec.heap_min,
+                        first.stack_min, rec.stack_min, SHM_STATS_NAME_LEN - 1, rec.stack_task);
+        }
+        if (first.flags & rec.flags & SOAK_HAVE_SYSMON) {
+            std::printf(", temp_lpd %.1f -> %.1f C", first.temp_lpd_mc / 1000.0, rec.temp_lpd_mc / 1000.0);
+        }
+        std::printf(", rss %u -> %u kB, fds %u -> %u\n", first.apu_rss_kb, rec.apu_rss_kb,
+                    first.apu_fds, rec.apu_fds);
+        std::printf("%u RPU restart(s), %u PL load(s), %u failed load(s)", rec.rpu_restarts,
+                    rec.pl_loads, rec.load_failures);
+        if (first.flags & rec.flags & SOAK_HAVE_KSTATS) {
+            std::printf("; rpu_ipi timeouts %u -> %u", first.k_timeouts, rec.k_timeouts);
+        }
+        std::printf("\n");
+        if (rec.load_failures != 0) ok = false;
+    }
+    return ok;
+}
+
+// --soak-print: the records of one log file as a table
+static int print_soak_log(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    SoakLogHeader hdr;
+    if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) || hdr.magic != SOAK_LOG_MAGIC ||
+        hdr.version != SOAK_LOG_VERSION || hdr.record_size != sizeof(SoakRecord)) {
+        std::cerr << path << " is not a soak log of this version" << std::endl;
+        return 1;
+    }
+
+    print_soak_header();
+    SoakRecord rec;
+    while (in.read(reinterpret_cast<char*>(&rec), sizeof(rec))) print_soak_row(rec);
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+/* Energy mode: board rail power during each workload */
+struct EnergyOptions {
+    std::string rails;  // Comma-separated power*_input files, or "auto"
+    std::vector<std::string> workloads = {"idle", "slow", "fast", "random", "ipi", "dma"};
+    unsigned duration_s = ENERGY_DURATION_S_DEFAULT;
+    unsigned sample_ms = ENERGY_SAMPLE_MS_DEFAULT;
+    std::string label;
+    std::string csv;
+};
+
+// Sum of the rails' hwmon power readings, integrated over time by a thread of its own
+class PowerSampler {
+public:
+    ~PowerSampler() {
+        stop();
+        for (int fd : fds_) ::close(fd);
+    }
+
+    // "auto": every power*_input of the hwmon devices named ina* (the INA2xx
+    // monitors of the SOM and the carrier card)
+    bool open(const std::string& spec) {
+        std::vector<std::string> paths;
+        if (spec == "auto") {
+            DIR* dir = opendir(ENERGY_HWMON_DIR);
+            struct dirent* e;
+            while (dir != nullptr && (e = readdir(dir)) != nullptr) {
+                const std::string hwmon = std::string(ENERGY_HWMON_DIR "/") + e->d_name;
+                std::string name;
+                if (e->d_name[0] == '.' || !kr260hal::sysfs_read(hwmon + "/name", name) ||
+                    name.compare(0, 3, "ina") != 0) {
+                    continue;
+                }
+                for (int i = 1; i <= ENERGY_MAX_CHANNELS; i++) {
+                    const std::string p = hwmon + "/power" + std::to_string(i) + "_input";
+                    if (kr260hal::path_exists(p)) paths.push_back(p);
+                }
+            }
+            if (dir != nullptr) closedir(dir);
+        } else {
+            paths = split_list(spec.c_str());
+        }
+        for (const std::string& p : paths) {
+            int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1) {
+                std::perror(("Error opening " + p).c_str());
+                return false;
+            }
+            fds_.push_back(fd);
+            names_.push_back(p);
+        }
+        if (fds_.empty()) errno = ENOENT;
+        return !fds_.empty();
+    }
+
+    const std::vector<std::string>& rails() const { return names_; }
+
+    void start(unsigned period_ms) {
+        running_ = true;
+        thread_ = std::thread([this, period_ms] { run(period_ms); });
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        running_ = false;
+        thread_.join();
+    }
+
+    // Start a measurement window
+    void begin() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        energy_uj_ = 0;
+        window_ns_ = 0;
+        samples_ = 0;
+    }
+
+    // Energy in J and mean power in mW of the window; false without samples
+    bool end(double& joules, double& mw, unsigned& samples) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        samples = samples_;
+        if (samples_ == 0 || window_ns_ == 0) return false;
+        joules = energy_uj_ / 1e6;
+        mw = energy_uj_ / (window_ns_ / 1e9) / 1e3;
+        return true;
+    }
+
+private:
+    bool read_uw(double& total) {
+        char buf[32];
+        total = 0;
+        for (int fd : fds_) {
+            ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+            if (n <= 0) return false;
+            buf[n] = '\0';
+            total += std::strtod(buf, nullptr);
+        }
+        return true;
+    }
+
+    // Each reading holds until the next one (hwmon averages over its own
+    // conversion time, which bounds the useful sample period)
+    void run(unsigned period_ms) {
+        uint64_t last = kr260hal::now_ns();
+        double uw = 0;
+        bool have = read_uw(uw);
+        while (running_) {
+            usleep(period_ms * 1000);
+            const uint64_t now = kr260hal::now_ns();
+            double next;
+            const bool ok = read_uw(next);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (have) {
+                energy_uj_ += uw * ((now - last) / 1e9);
+                window_ns_ += now - last;
+                samples_++;
+            }
+            last = now;
+            have = ok;
+            uw = next;
+        }
+    }
+
+    std::vector<int> fds_;
+    std::vector<std::string> names_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex mutex_;
+    double energy_uj_ = 0;
+    uint64_t window_ns_ = 0;
+    unsigned samples_ = 0;
+};
+
+// Set up a workload other than "ipi" through a short-lived transport (echo mode off)
+static bool start_workload(const std::string& w, unsigned core, kr260hal::IpiBackend backend) {
+    kr260hal::IpiTransport ipi;
+    if (!ipi.open(core, backend)) return false;
+    if (w == "dma") {
+        return ipi.send_wave(ENERGY_DMA_PERIOD_NS, 0, {0x1, 0x2, 0x3, 0x0}, true).acked;
+    }
+    // SLOW, FAST and RANDOM are modes 0-2; the rest releases control
+    uint32_t mode = w == "slow" ? 0 : w == "fast" ? 1 : w == "random" ? 2 : BENCH_MODE;
+    return ipi.send_mode(mode).acked;
+}
+
+static void stop_workload(const std::string& w, unsigned core, kr260hal::IpiBackend backend) {
+    kr260hal::IpiTransport ipi;
+    if (!ipi.open(core, backend)) return;
+    if (w == "dma") ipi.send_wave(0, 0, {}, false);
+    ipi.send_mode(BENCH_MODE);
+}
+
+static bool run_energy(const std::string& name, unsigned core, const kr260hal::WaitPolicy& wait,
+                       kr260hal::IpiBackend backend, const EnergyOptions& opts) {
+    PowerSampler power;
+    if (!power.open(opts.rails)) {
+        std::perror("Error opening the power monitors (--energy auto needs ina* hwmon devices)");
+        return false;
+    }
+    FILE* csv = nullptr;
+    if (!opts.csv.empty() && (csv = std::fopen(opts.csv.c_str(), "a")) == nullptr) {
+        std::perror(("Error opening " + opts.csv).c_str());
+        return false;
+    }
+
+    // The idle features in effect: the governor publishes its block, the
+    // tick profile is only known from the build (--energy-label)
+    kr260hal::MemMap gov;
+    const bool governor = gov.map_phys(GOV_ADDR, GOV_SIZE, false) && *gov.at(GOV_MAGIC_OFFSET) == GOV_MAGIC;
+    std::printf("RPU%u, %zu rail(s), %u s per workload, sampled every %u ms, clock governor %s%s%s\n",
+                core, power.rails().size(), opts.duration_s, opts.sample_ms, governor ? "on" : "off",
+                opts.label.empty() ? "" : ", ", opts.label.c_str());
+    for (const std::string& r : power.rails()) std::printf("  %s\n", r.c_str());
+    std::printf("\n%-8s %-7s %-10s %-9s %-9s %-11s %-11s %s\n", "workload", "s", "power_mW",
+                "energy_J", "delta_mW", "msgs", "msgs/J", "msgs/J_idle");
+
+    power.start(opts.sample_ms);
+    double idle_mw = -1;
+    bool ok = true;
+    for (const std::string& w : opts.workloads) {
+        if (stop_requested) break;
+        const bool ipi = w == "ipi";
+        std::unique_ptr<BenchTarget> target;
+        if (ipi) {
+            target = make_target(name, wait);
+            if (!set_echo(core, backend, true) || !target->open(core)) {
+                std::printf("%-8s unavailable (%s)\n", w.c_str(), std::strerror(errno));
+                ok = false;
+                continue;
+            }
+        } else if (!start_workload(w, core, backend)) {
+            std::printf("%-8s RPU did not accept it\n", w.c_str());
+            ok = false;
+            continue;
+        }
+        // LEDs, clocks and the monitors' averaging settle before the window
+        usleep(ENERGY_SETTLE_MS * 1000);
+
+        const uint32_t batch = ipi && target->batches() ? ENERGY_IPI_BATCH : 1;
+        const uint64_t start = kr260hal::now_ns();
+        const uint64_t end = start + opts.duration_s * 1000000000ULL;
+        uint64_t msgs = 0;
+        power.begin();
+        while (kr260hal::now_ns() < end && !stop_requested) {
+            if (!ipi) {
+                usleep(ENERGY_POLL_MS * 1000);
+            } else if (target->send(batch)) {
+                msgs += batch;
+            } else {
+                std::printf("%-8s RPU did not answer\n", w.c_str());
+                ok = false;
+                break;
+            }
+        }
+        double joules = 0, mw = 0;
+        unsigned samples = 0;
+        const bool measured = power.end(joules, mw, samples);
+        const double secs = (kr260hal::now_ns() - start) / 1e9;
+
+        if (ipi) {
+            target.reset();
+            set_echo(core, backend, false);
+        } else {
+            stop_workload(w, core, backend);
+        }
+        if (!measured) {
+            std::printf("%-8s no power samples\n", w.c_str());
+            ok = false;
+            continue;
+        }
+        if (w == "idle") idle_mw = mw;
+
+        // Messages per joule of the board, and of what the workload adds to idle
+        const double delta_mw = idle_mw >= 0 ? mw - idle_mw : 0.0;
+        std::printf("%-8s %-7.1f %-10.1f %-9.3f %-9.1f ", w.c_str(), secs, mw, joules, delta_mw);
+        if (msgs != 0) {
+            std::printf("%-11llu %-11.0f ", (unsigned long long)msgs, msgs / joules);
+            if (idle_mw >= 0 && delta_mw >= ENERGY_MIN_DELTA_MW) std::printf("%.0f\n", msgs / (delta_mw / 1e3 * secs));
+            else std::printf("-\n");
+        } else {
+            std::printf("%-11s %-11s -\n", "-", "-");
+        }
+        if (csv != nullptr) {
+            std::fprintf(csv, "%s,%u,%s,%.3f,%.1f,%.4f,%.1f,%llu\n", opts.label.c_str(), core, w.c_str(),
+                         secs, mw, joules, delta_mw, (unsigned long long)msgs);
+        }
+    }
+    power.stop();
+    if (csv != nullptr) std::fclose(csv);
+    return ok;
+}
+
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--transport <list>] [--iterations <n>] [--batch <list>]"
+              << " [--duration-ms <ms>] [--core <0|1>] [--spin-ns <ns>] [--max-sleep-us <us>]"
+              << " [--rt <cpu>] [--rt-prio <prio>] [--emulate]" << std::endl;
+    std::cerr << "       " << prog << " --soak <hours> [--soak-interval-s <s>] [--soak-rate <cmds/s>]"
+              << " [--soak-log <file>] [--soak-log-mb <MB>] [--soak-log-files <n>]"
+              << " [--pl-every-min <min>] [--pl-image <bit>] [--restart-every-min <min>]"
+              << " [--rpu-image <elf>]" << std::endl;
+    std::cerr << "       " << prog << " --soak-print <file>" << std::endl;
+    std::cerr << "       " << prog << " --energy <auto|power*_input,...> [--energy-s <s>]"
+              << " [--energy-sample-ms <ms>] [--energy-workloads <list>] [--energy-label <name>]"
+              << " [--energy-csv <file>]" << std::endl;
+    std::cerr << "Transports:";
+    for (const char* t : ALL_TRANSPORTS) std::cerr << " " << t;
+    for (const char* t : HOST_TRANSPORTS) std::cerr << " " << t;
+    std::cerr << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    enum {
+        OPT_SPIN_NS = 256, OPT_MAX_SLEEP_US, OPT_CORE, OPT_RT, OPT_RT_PRIO, OPT_EMULATE,
+        OPT_SOAK, OPT_SOAK_INTERVAL_S, OPT_SOAK_RATE, OPT_SOAK_LOG, OPT_SOAK_LOG_MB,
+        OPT_SOAK_LOG_FILES, OPT_SOAK_PRINT, OPT_PL_EVERY_MIN, OPT_PL_IMAGE,
+        OPT_RESTART_EVERY_MIN, OPT_RPU_IMAGE, OPT_ENERGY, OPT_ENERGY_S, OPT_ENERGY_SAMPLE_MS,
+        OPT_ENERGY_LABEL, OPT_ENERGY_CSV, OPT_ENERGY_WORKLOADS
+    };
+    static const struct option long_opts[] = {
+        {"transport",    required_argument, nullptr, 't'},
+        {"iterations",   required_argument, nullptr, 'n'},
+        {"batch",        required_argument, nullptr, 'b'},
+        {"duration-ms",  required_argument, nullptr, 'd'},
+        {"spin-ns",      required_argument, nullptr, OPT_SPIN_NS},
+        {"max-sleep-us", required_argument, nullptr, OPT_MAX_SLEEP_US},
+        {"core",         required_argument, nullptr, OPT_CORE},
+        {"rt",           required_argument, nullptr, OPT_RT},
+        {"rt-prio",      required_argument, nullptr, OPT_RT_PRIO},
+        {"emulate",      no_argument,       nullptr, OPT_EMULATE},
+        {"soak",              required_argument, nullptr, OPT_SOAK},
+        {"soak-interval-s",   required_argument, nullptr, OPT_SOAK_INTERVAL_S},
+        {"soak-rate",         required_argument, nullptr, OPT_SOAK_RATE},
+        {"soak-log",          required_argument, nullptr, OPT_SOAK_LOG},
+        {"soak-log-mb",       required_argument, nullptr, OPT_SOAK_LOG_MB},
+        {"soak-log-files",    required_argument, nullptr, OPT_SOAK_LOG_FILES},
+        {"soak-print",        required_argument, nullptr, OPT_SOAK_PRINT},
+        {"pl-every-min",      required_argument, nullptr, OPT_PL_EVERY_MIN},
+        {"pl-image",          required_argument, nullptr, OPT_PL_IMAGE},
+        {"restart-every-min", required_argument, nullptr, OPT_RESTART_EVERY_MIN},
+        {"rpu-image",         required_argument, nullptr, OPT_RPU_IMAGE},
+        {"energy",            required_argument, nullptr, OPT_ENERGY},
+        {"energy-s",          required_argument, nullptr, OPT_ENERGY_S},
+        {"energy-sample-ms",  required_argument, nullptr, OPT_ENERGY_SAMPLE_MS},
+        {"energy-label",      required_argument, nullptr, OPT_ENERGY_LABEL},
+        {"energy-csv",        required_argument, nullptr, OPT_ENERGY_CSV},
+        {"energy-workloads",  required_argument, nullptr, OPT_ENERGY_WORKLOADS},
+        {"help",         no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    std::vector<std::string> transports(std::begin(ALL_TRANSPORTS), std::end(ALL_TRANSPORTS));
+    bool explicit_transports = false;
+    std::vector<uint32_t> batches = {1, 4, 16, 32};
+    unsigned iterations = BENCH_ITERATIONS_DEFAULT;
+    unsigned duration_ms = BENCH_DURATION_MS_DEFAULT;
+    unsigned core = 0;
+    bool emulate = false;
+    kr260hal::WaitPolicy wait;
+    kr260hal::RtPolicy rt;
+    SoakOptions soak;
+    EnergyOptions energy;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:n:b:d:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 't':
+                transports = split_list(optarg);
+                explicit_transports = true;
+                break;
+            case 'n':
+                iterations = std::max(1UL, std::strtoul(optarg, nullptr, 0));
+                break;
+            case 'b':
+                batches.clear();
+                for (const std::string& b : split_list(optarg)) {
+                    uint32_t n = std::strtoul(b.c_str(), nullptr, 0);
+                    if (n < 1 || n > SHM_RING_SLOTS) {
+                        std::cerr << "Invalid batch size " << b << " (1-" << SHM_RING_SLOTS << ")" << std::endl;
+                        return 1;
+                    }
+                    batches.push_back(n);
+                }
+                break;
+            case 'd':
+                duration_ms = std::strtoul(optarg, nullptr, 0);
+                break;
+            case OPT_SPIN_NS:
+                wait.spin_ns = std::strtoull(optarg, nullptr, 10);
+                break;
+            case OPT_MAX_SLEEP_US:
+                wait.max_sleep_us = std::max<uint32_t>(kr260hal::WAIT_MIN_SLEEP_US, std::strtoul(optarg, nullptr, 10));
+                break;
+            case OPT_CORE:
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core >= RPU_CORE_COUNT) {
+                    std::cerr << "Invalid core " << optarg << " (0-" << RPU_CORE_COUNT - 1 << ")" << std::endl;
+                    return 1;
+                }
+                break;
+            case OPT_RT:
+                rt.cpu = std::atoi(optarg);
+                break;
+            case OPT_RT_PRIO:
+                rt.prio = std::atoi(optarg);
+                break;
+            case OPT_EMULATE:
+                emulate = true;
+                break;
+            case OPT_SOAK: soak.hours = std::max(0.0, std::strtod(optarg, nullptr)); break;
+            case OPT_SOAK_INTERVAL_S: soak.interval_s = std::max(1UL, std::strtoul(optarg, nullptr, 0)); break;
+            case OPT_SOAK_RATE: soak.rate = std::max(1UL, std::strtoul(optarg, nullptr, 0)); break;
+            case OPT_SOAK_LOG: soak.log = optarg; break;
+            case OPT_SOAK_LOG_MB: soak.log_mb = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_SOAK_LOG_FILES: soak.log_files = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_SOAK_PRINT: return print_soak_log(optarg);
+            case OPT_PL_EVERY_MIN: soak.pl_every_min = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_PL_IMAGE: soak.pl_image = optarg; break;
+            case OPT_RESTART_EVERY_MIN: soak.restart_every_min = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_RPU_IMAGE: soak.rpu_image = optarg; break;
+            case OPT_ENERGY: energy.rails = optarg; break;
+            case OPT_ENERGY_S: energy.duration_s = std::max(1UL, std::strtoul(optarg, nullptr, 0)); break;
+            case OPT_ENERGY_SAMPLE_MS: energy.sample_ms = std::max(1UL, std::strtoul(optarg, nullptr, 0)); break;
+            case OPT_ENERGY_LABEL: energy.label = optarg; break;
+            case OPT_ENERGY_CSV: energy.csv = optarg; break;
+            case OPT_ENERGY_WORKLOADS:
+                energy.workloads = split_list(optarg);
+                for (const std::string& w : energy.workloads) {
+                    if (w != "idle" && w != "slow" && w != "fast" && w != "random" && w != "ipi" && w != "dma") {
+                        std::cerr << "Unknown workload " << w << " (idle, slow, fast, random, ipi, dma)" << std::endl;
+                        return 1;
+                    }
+                }
+                break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (emulate && !explicit_transports) {
+        transports.assign(std::begin(HOST_TRANSPORTS), std::end(HOST_TRANSPORTS));
+    }
+    // Echo mode goes to the emulator's window when nothing else is measured
+    bool host_only = true;
+    for (const std::string& t : transports) {
+        if (t.compare(0, 5, "host-") != 0) host_only = false;
+    }
+    const kr260hal::IpiBackend echo_backend = host_only ? kr260hal::IPI_BACKEND_HOST
+                                                        : kr260hal::IPI_BACKEND_AUTO;
+
+    for (const std::string& t : transports) {
+        if (!make_target(t, wait)) {
+            std::cerr << "Unknown transport " << t << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!setup_rt(rt)) return 1;
+
+    // The emulated RPU, on another core of this machine
+    kr260hal::HostRpu emu;
+    std::thread emu_thread;
+    if (emulate) {
+        if (!emu.open(core)) {
+            std::perror("Error creating the host window of the RPU emulator");
+            return 1;
+        }
+        emu_thread = std::thread([&emu] { emu.run(); });
+    }
+    auto stop_emulator = [&] {
+        if (!emulate) return;
+        emu.stop();
+        emu_thread.join();
+        emu.close(true);
+    };
+
+    if (!energy.rails.empty()) {
+        // The blink workloads need the modes applied: echo mode only for "ipi"
+        std::string name;
+        for (const std::string& t : transports) {
+            if (make_target(t, wait)->open(core)) {
+                name = t;
+                break;
+            }
+        }
+        std::signal(SIGINT, handle_sigint);
+        int ret = 1;
+        if (name.empty()) std::cerr << "None of the transports can be opened" << std::endl;
+        else if (run_energy(name, core, wait, echo_backend, energy)) ret = 0;
+        stop_emulator();
+        return ret;
+    }
+
+    if (!set_echo(core, echo_backend, true)) {
+        std::perror("Error mapping the shared memory window to enable echo mode");
+        stop_emulator();
+        return 1;
+    }
+    std::signal(SIGINT, handle_sigint);
+
+    if (soak.hours > 0) {
+        // The first transport of the list that opens
+        std::string name;
+        for (const std::string& t : transports) {
+            if (make_target(t, wait)->open(core)) {
+                name = t;
+                break;
+            }
+        }
+        int ret = 1;
+        if (name.empty()) std::cerr << "None of the transports can be opened" << std::endl;
+        else if (run_soak(name, core, wait, echo_backend, soak)) ret = 0;
+        set_echo(core, echo_backend, false);
+        stop_emulator();
+        return ret;
+    }
+
+    // Transports that passed the latency test, in the order given
+    std::vector<std::string> names;
+    int ret = 0;
+
+    std::printf("RPU%u, %u commands per latency test, %u ms per throughput run\n\n",
+                core, iterations, duration_ms);
+    std::printf("%-11s %-6s %-8s %-8s %-9s %-8s %-7s %s\n",
+                "transport", "n", "p50_us", "p99_us", "p99.9_us", "max_us", "usr_us", "sys_us");
+    for (const std::string& t : transports) {
+        if (stop_requested) break;
+        std::unique_ptr<BenchTarget> target = make_target(t, wait);
+        if (!target->open(core)) {
+            std::printf("%-11s unavailable (%s)\n", t.c_str(), std::strerror(errno));
+            if (explicit_transports) ret = 1;
+            continue;
+        }
+        if (!run_latency(t, *target, iterations)) {
+            ret = 1;
+            continue;
+        }
+        // Closed at the end of the iteration: only an idle ring can be mapped
+        names.push_back(t);
+    }
+
+    std::printf("\n%-11s %-6s %-10s %-7s %s\n", "transport", "batch", "cmds/s", "usr_us", "sys_us");
+    for (const std::string& t : names) {
+        if (stop_requested) break;
+        std::unique_ptr<BenchTarget> target = make_target(t, wait);
+        if (!target->open(core)) {
+            std::printf("%-11s unavailable (%s)\n", t.c_str(), std::strerror(errno));
+            ret = 1;
+            continue;
+        }
+        for (uint32_t b : batches) {
+            if (stop_requested) break;
+            if (b > 1 && !target->batches()) continue;
+            if (!run_throughput(t, *target, b, duration_ms)) {
+                ret = 1;
+                break;
+            }
+        }
+    }
+
+    if (!set_echo(core, echo_backend, false)) {
+        std::perror("Error clearing echo mode");
+        ret = 1;
+    }
+    stop_emulator();
+    return ret;
+}
@@ -0,0 +1,261 @@
+/*
+ * Python extension (pybind11) over the command transport of kr260hal
+ * (IpiTransport, kr260hal/ipi_transport.h), for the PYNQ notebooks.
+ *
+ * Usage (PYNQ notebook, built with `make kr260_ipi` on the board):
+ *   import numpy as np, kr260_ipi
+ *   rpu = kr260_ipi.Transport()                 # RPU0, first backend that opens
+ *   cmds = np.zeros(10000, dtype=kr260_ipi.command_dtype)
+ *   cmds["opcode"] = kr260_ipi.CMD_SET_MODE
+ *   cmds["arg"] = np.arange(10000) % 3
+ *   r = rpu.run(cmds)
+ *   print(r)   # {'ok': True, 'status': 1, 'commands': 10000, 'rtt_us': 4210.5, 'rate_hz': 2375000.0}
+ *
+ * Driving the RPU from Python otherwise means a process per command
+ * (ipi_app) or a sysfs write per mode (/sys/kernel/rpu_ipi/write). Here a
+ * whole structured array of (opcode, arg) commands is one call: submit()
+ * copies it into the command ring with one head update and doorbell per
+ * ring-full, and the waits, for free slots and for the completion, run with
+ * the GIL released, so other Python threads keep running and the command
+ * rate is the ring's, not the interpreter's.
+ *
+ *   run(cmds)        submit() and wait(), in one call
+ *   submit(cmds)     queue and return a Ticket at once (waits only while the
+ *                    ring is full), so the next batch can be built meanwhile
+ *   done(ticket)     the RPU consumed every command of the ticket
+ *   wait(ticket)     block until then; status is the first failed
+ *                    STATUS_* of the batch, STATUS_OK if none failed
+ *   send_mode(mode)  the legacy CMD/ACK words
+ *   send_msg(opcode, params)  one command in the IPI message buffer,
+ *                    returns (status, results)
+ *   status()         the firmware's status block (mode, LEDs, counters), read
+ *                    from the window without a command; None if it has none
+ *
+ * A Transport is one IpiTransport: its calls are serialized by a lock, and
+ * only one ring producer may run per core (rpu_ipi_ioctl.h clients included).
+ * Waits end after timeout_ms (1 s) without progress; a timed-out submit()
+ * raises TimeoutError.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "kr260hal/ipi_transport.h"
+
+namespace py = pybind11;
+
+using CommandArray = py::array_t<kr260hal::RingCommand, py::array::c_style | py::array::forcecast>;
+
+// Commands of a submit() and the ring indices they went to
+struct Ticket {
+    kr260hal::RingTicket ring;
+    size_t commands = 0;
+};
+
+static py::dict result_dict(const kr260hal::IpiResult& r, size_t commands) {
+    py::dict d;
+    d["ok"] = r.acked;
+    d["status"] = r.ack_val;
+    if (commands != 0) {
+        d["commands"] = commands;
+    }
+    d["rtt_us"] = r.rtt_us;
+    if (commands != 0) {
+        d["rate_hz"] = r.rtt_us > 0.0 ? commands * 1e6 / r.rtt_us : 0.0;
+    }
+    return d;
+}
+
+static kr260hal::IpiBackend parse_backend(const std::string& name) {
+    if (name == "auto") return kr260hal::IPI_BACKEND_AUTO;
+    if (name == "dev") return kr260hal::IPI_BACKEND_DEV;
+    if (name == "uio") return kr260hal::IPI_BACKEND_UIO;
+    if (name == "mem") return kr260hal::IPI_BACKEND_MEM;
+    if (name == "host") return kr260hal::IPI_BACKEND_HOST;
+    throw std::invalid_argument("backend must be auto, dev, uio, mem or host");
+}
+
+class Transport {
+public:
+    Transport(unsigned core, const std::string& backend) {
+        if (!ipi_.open(core, parse_backend(backend))) {
+            throw std::runtime_error("opening the RPU" + std::to_string(core) + " transport: " +
+                                     std::strerror(errno));
+        }
+    }
+
+    Ticket submit(const CommandArray& cmds) {
+        const kr260hal::RingCommand* data = check(cmds);
+        Ticket t;
+        bool ok;
+
+        t.commands = cmds.shape(0);
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(lock_);
+            ok = ipi_.submit(data, t.commands, &t.ring);
+        }
+        if (!ok) {
+            PyErr_SetString(PyExc_TimeoutError, "the RPU freed no ring slot within the timeout");
+            throw py::error_already_set();
+        }
+        return t;
+    }
+
+    bool done(const Ticket& t) {
+        std::lock_guard<std::mutex> lock(lock_);
+        return ipi_.done(t.ring);
+    }
+
+    py::dict wait(const Ticket& t) {
+        kr260hal::IpiResult r;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(lock_);
+            r = ipi_.wait_done(t.ring);
+        }
+        return result_dict(r, t.commands);
+    }
+
+    py::dict run(const CommandArray& cmds) {
+        const kr260hal::RingCommand* data = check(cmds);
+        const size_t count = cmds.shape(0);
+        kr260hal::RingTicket ticket;
+        kr260hal::IpiResult r;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(lock_);
+            if (ipi_.submit(data, count, &ticket)) {
+                r = ipi_.wait_done(ticket);
+            } else {
+                r.rtt_us = (kr260hal::now_ns() - ticket.start_ns) / 1000.0;
+            }
+        }
+        return result_dict(r, count);
+    }
+
+    py::dict send_mode(uint32_t mode) {
+        kr260hal::IpiResult r;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(lock_);
+            r = ipi_.send_mode(mode);
+        }
+        return result_dict(r, 0);
+    }
+
+    py::tuple send_msg(uint32_t opcode, const std::vector<uint32_t>& params) {
+        std::vector<uint32_t> results(RPU_MSG_MAX_RESULTS);
+        kr260hal::IpiResult r;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(lock_);
+            r = ipi_.send_msg(opcode, params, results.data());
+        }
+        return py::make_tuple(r.ack_val, results);
+    }
+
+    py::object status() {
+        kr260hal::RpuStatus st;
+
+        // Loads of the window only: no need to wait for a command in flight
+        if (!ipi_.status(&st)) {
+            return py::none();
+        }
+        py::dict d;
+        d["mode"] = st.mode;
+        d["override"] = (st.flags & SHM_STATUS_F_OVERRIDE) != 0;
+        d["pattern"] = (st.flags & SHM_STATUS_F_PATTERN) != 0;
+        d["wave"] = (st.flags & SHM_STATUS_F_WAVE) != 0;
+        d["led"] = st.led;
+        d["step"] = st.step;
+        d["frames"] = st.frames;
+        d["commands"] = st.commands;
+        d["stamp"] = st.stamp;
+        return d;
+    }
+
+    unsigned core() const { return ipi_.core(); }
+    std::string backend() const { return kr260hal::backend_name(ipi_.backend()); }
+    uint32_t abi_version() const { return ipi_.abi_version(); }
+    uint32_t features() const { return ipi_.features(); }
+    uint32_t timeout_ms() const { return ipi_.wait.timeout_ms; }
+    void set_timeout_ms(uint32_t ms) { ipi_.wait.timeout_ms = ms; }
+    uint64_t spin_ns() const { return ipi_.wait.spin_ns; }
+    void set_spin_ns(uint64_t ns) { ipi_.wait.spin_ns = ns; }
+
+private:
+    static const kr260hal::RingCommand* check(const CommandArray& cmds) {
+        if (cmds.ndim() != 1) {
+            throw std::invalid_argument("commands must be a 1-D array of command_dtype");
+        }
+        return cmds.data();
+    }
+
+    kr260hal::IpiTransport ipi_;
+    std::mutex lock_;
+};
+
+PYBIND11_MODULE(kr260_ipi, m) {
+    m.doc() = "Batched command submission to the KR260 RPU firmware";
+
+    PYBIND11_NUMPY_DTYPE(kr260hal::RingCommand, opcode, arg);
+    m.attr("command_dtype") = py::dtype::of<kr260hal::RingCommand>();
+
+    // Opcodes and statuses of common/rpu_shm.h
+    m.attr("CMD_NOP") = RPU_CMD_NOP;
+    m.attr("CMD_SET_MODE") = RPU_CMD_SET_MODE;
+    m.attr("CMD_WAVE") = RPU_CMD_WAVE;
+    m.attr("CMD_QUERY") = RPU_CMD_QUERY;
+    m.attr("CMD_PATTERN") = RPU_CMD_PATTERN;
+    m.attr("CMD_SEED") = RPU_CMD_SEED;
+    m.attr("STATUS_PENDING") = RPU_CMD_STATUS_PENDING;
+    m.attr("STATUS_OK") = RPU_CMD_STATUS_OK;
+    m.attr("STATUS_BADOP") = RPU_CMD_STATUS_BADOP;
+    m.attr("STATUS_BADARG") = RPU_CMD_STATUS_BADARG;
+    m.attr("STATUS_FAILED") = RPU_CMD_STATUS_FAILED;
+    m.attr("STATUS_LATE") = RPU_CMD_STATUS_LATE;
+    m.attr("STATUS_CRC") = RPU_CMD_STATUS_CRC;
+
+    py::class_<Ticket>(m, "Ticket")
+        .def_readonly("commands", &Ticket::commands)
+        .def_property_readonly("first", [](const Ticket& t) { return t.ring.first; })
+        .def_property_readonly("end", [](const Ticket& t) { return t.ring.end; });
+
+    py::class_<Transport>(m, "Transport")
+        .def(py::init<unsigned, const std::string&>(), py::arg("core") = 0,
+             py::arg("backend") = "auto",
+             "Open the transport of RPU 'core': auto, dev (/dev/rpu_ipi), uio, mem or host")
+        .def("run", &Transport::run, py::arg("cmds"),
+             "Submit an array of command_dtype and wait for it; returns ok, the first failed "
+             "status (STATUS_OK if none), the round trip and the command rate")
+        .def("submit", &Transport::submit, py::arg("cmds"),
+             "Queue an array of command_dtype without waiting for it; returns a Ticket")
+        .def("done", &Transport::done, py::arg("ticket"),
+             "True once the RPU consumed every command of the ticket")
+        .def("wait", &Transport::wait, py::arg("ticket"),
+             "Wait for a ticket; returns the same dict as run()")
+        .def("send_mode", &Transport::send_mode, py::arg("mode"),
+             "Legacy mode command: 0=SLOW 1=FAST 2=RANDOM 3=release")
+        .def("send_msg", &Transport::send_msg, py::arg("opcode"),
+             py::arg("params") = std::vector<uint32_t>(),
+             "One command in the IPI message buffer; returns (status, results)")
+        .def("status", &Transport::status,
+             "Status block of the firmware, read without a command: mode, override, pattern, "
+             "wave, led, step, frames, commands and the counter stamp; None if it has none")
+        .def_property_readonly("core", &Transport::core)
+        .def_property_readonly("backend", &Transport::backend)
+        .def_property_readonly("abi_version", &Transport::abi_version)
+        .def_property_readonly("features", &Transport::features)
+        .def_property("timeout_ms", &Transport::timeout_ms, &Transport::set_timeout_ms)
+        .def_property("spin_ns", &Transport::spin_ns, &Transport::set_spin_ns);
+}
@@ -0,0 +1,47 @@
+/*
+ * Memory barriers of the APU towards the RPU and the PL (kr260hal).
+ *
+ * The RPU, the PL and the IPI block are outside the inner shareable domain
+ * of the A53 cluster, so __sync_synchronize() (dmb ish, loads and stores in
+ * both directions, for the other A53 cores only) is both stronger than the
+ * protocols need and scoped to the wrong observers. These are the outer
+ * shareable barriers the kernel uses for the same job (dma_wmb() before a
+ * writel() doorbell, dma_rmb() after a readl() status):
+ *
+ *   release()   dmb oshst  earlier stores are observed before later ones:
+ *                          data, then the word or doorbell announcing it
+ *   acquire()   dmb oshld  earlier loads complete before later loads and
+ *                          stores: a completion word, then what it covers
+ *   full()      dmb osh    also orders earlier stores before later loads:
+ *                          publish an index, then read the consumer's state
+ *   complete()  dsb st     earlier stores have completed, e.g. an interrupt
+ *                          source cleared before the system call that
+ *                          unmasks it, or a flag before its mapping goes
+ *
+ * MemMap::write_release() and read_acquire() (mem_map.h) pair them with the
+ * access they order. Other architectures (host syntax checks) get the
+ * equivalent compiler fences.
+ */
+
+#ifndef KR260HAL_BARRIER_H
+#define KR260HAL_BARRIER_H
+
+namespace kr260hal {
+namespace barrier {
+
+#if defined(__aarch64__)
+inline void release()  { __asm__ __volatile__("dmb oshst" ::: "memory"); }
+inline void acquire()  { __asm__ __volatile__("dmb oshld" ::: "memory"); }
+inline void full()     { __asm__ __volatile__("dmb osh" ::: "memory"); }
+inline void complete() { __asm__ __volatile__("dsb st" ::: "memory"); }
+#else
+inline void release()  { __atomic_thread_fence(__ATOMIC_RELEASE); }
+inline void acquire()  { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+inline void full()     { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+inline void complete() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#endif
+
+} // namespace barrier
+} // namespace kr260hal
+
+#endif /* KR260HAL_BARRIER_H */
@@ -0,0 +1,393 @@
+/*
+ * APU side of the bulk data channel (see bulk.h, common/rpu_shm.h).
+ *
+ * The carveout is Device memory through /dev/mem, where memcpy() is not
+ * safe: libc uses unaligned accesses and DC ZVA, which fault there. Copies
+ * therefore go word by word with aligned 64-bit accesses, the widest single
+ * access the mapping allows. The BULK_OP_F_CRC CRCs are taken on the same
+ * 64-bit words, one crc32cx each, padding included.
+ *
+ * From BULK_DMA_MIN_LEN on, put() and get() hand the copy to the rpu_ipi
+ * module instead when its memory-region is the carveout (RPU_IPI_IOC_DMA):
+ * its FPD DMA channel moves the whole multiples of RPU_IPI_DMA_ALIGN, the
+ * CPU the rest. When the module refuses (no channel, a buffer the channel
+ * cannot address aligned), the CPU copies it all as before.
+ */
+
+#include "bulk.h"
+#include "timebase.h"
+#include "rpu_crc32c.h"
+
+#include "rpu_ipi_ioctl.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace kr260hal {
+
+// Below this a DMA copy costs more in pinning and setup than the CPU copy
+static constexpr size_t BULK_DMA_MIN_LEN = 64 * 1024;
+
+uint32_t word_sum(const void* data, size_t len, uint32_t sum) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    size_t words = len / 4;
+    for (size_t i = 0; i < words; i++) {
+        uint32_t w;
+        std::memcpy(&w, p + i * 4, 4);
+        sum += w;
+    }
+    if (len % 4 != 0) {
+        uint32_t w = 0;
+        std::memcpy(&w, p + words * 4, len % 4);
+        sum += w;
+    }
+    return sum;
+}
+
+// CRC32C of avail bytes at p followed by len - avail zero bytes (the padding
+// put() writes)
+static uint32_t crc_padded(const uint8_t* p, size_t avail, size_t len) {
+    uint32_t crc = rpu_crc32c_update(RPU_CRC32C_INIT, p, avail);
+    for (size_t i = avail; i < len; i++) {
+        crc = rpu_crc32c_byte(crc, 0);
+    }
+    return rpu_crc32c_final(crc);
+}
+
+bool BulkChannel::open(IpiTransport& ipi) {
+    close();
+    if (!ipi.is_open()) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (!ctrl_.map_phys(BULK_CTRL_ADDR(ipi.core()), BULK_CTRL_SIZE)) return false;
+    if (ctrl_.read<bulk::Magic>() != BULK_MAGIC) {
+        close();
+        errno = ENODEV;
+        return false;
+    }
+    if (!ddr_.map_phys(BULK_DDR_ADDR_CORE(ipi.core()), BULK_DDR_CORE_SIZE)) {
+        int saved_errno = errno;
+        close();
+        errno = saved_errno;
+        return false;
+    }
+
+    open_dma(ipi.core());
+    ipi_ = &ipi;
+    desc_ = ctrl_.at<rpu_bulk_desc>(BULK_DESC_OFFSET);
+    buf_size_ = ctrl_.read<bulk::BufSize>();
+    head_ = ctrl_.read<bulk::Head>();
+    done_ = head_;
+    return true;
+}
+
+// The rpu_ipi module's memory-region, if it holds the core's half of the
+// carveout; otherwise put() and get() copy with the CPU only
+void BulkChannel::open_dma(uint32_t core) {
+    dma_fd_ = ::open("/dev/" RPU_IPI_DEV_NAME, O_RDWR | O_CLOEXEC);
+    if (dma_fd_ == -1) return;
+
+    rpu_ipi_region region = {};
+    uint64_t addr = BULK_DDR_ADDR_CORE(core);
+    if (ioctl(dma_fd_, RPU_IPI_IOC_REGION, &region) != 0 || addr < region.phys ||
+        addr - region.phys > region.size || BULK_DDR_CORE_SIZE > region.size - (addr - region.phys)) {
+        ::close(dma_fd_);
+        dma_fd_ = -1;
+        return;
+    }
+    dma_base_ = addr - region.phys;
+}
+
+// Bytes of len at ddr_off the module copied with its DMA channel: a multiple
+// of RPU_IPI_DMA_ALIGN, 0 when it is not used or refused
+size_t BulkChannel::dma_copy(uint32_t ddr_off, const void* data, size_t len, uint32_t flags) const {
+    size_t dma_len = len & ~(size_t)(RPU_IPI_DMA_ALIGN - 1);
+    if (dma_fd_ == -1 || len < BULK_DMA_MIN_LEN) return 0;
+
+    rpu_ipi_dma dma = {};
+    dma.user = reinterpret_cast<uintptr_t>(data);
+    dma.offset = dma_base_ + ddr_off;
+    dma.len = dma_len;
+    dma.flags = flags;
+    return ioctl(dma_fd_, RPU_IPI_IOC_DMA, &dma) == 0 ? dma_len : 0;
+}
+
+void BulkChannel::close() {
+    ctrl_.unmap();
+    ddr_.unmap();
+    if (dma_fd_ != -1) ::close(dma_fd_);
+    dma_fd_ = -1;
+    dma_base_ = 0;
+    ipi_ = nullptr;
+    desc_ = nullptr;
+    buf_size_ = 0;
+}
+
+bool BulkChannel::put(uint32_t ddr_off, const void* data, size_t len) {
+    if (ddr_off % BULK_ALIGN != 0 || ddr_off > ddr_.size() || len > ddr_.size() - ddr_off) {
+        errno = EINVAL;
+        return false;
+    }
+
+    size_t done = dma_copy(ddr_off, data, len, 0);
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    volatile uint64_t* dst = ddr_.at<uint64_t>(ddr_off);
+    size_t words = len / 8;
+    for (size_t i = done / 8; i < words; i++) {
+        uint64_t w;
+        std::memcpy(&w, src + i * 8, 8);
+        dst[i] = w;
+    }
+    if (len % 8 != 0) {
+        uint64_t w = 0;
+        std::memcpy(&w, src + words * 8, len % 8);
+        dst[words] = w;
+    }
+    return true;
+}
+
+bool BulkChannel::get(uint32_t ddr_off, void* data, size_t len) const {
+    if (ddr_off % BULK_ALIGN != 0 || ddr_off > ddr_.size() || len > ddr_.size() - ddr_off) {
+        errno = EINVAL;
+        return false;
+    }
+
+    size_t done = dma_copy(ddr_off, data, len, RPU_IPI_DMA_F_READ);
+    uint8_t* dst = static_cast<uint8_t*>(data);
+    const volatile uint64_t* src = ddr_.at<uint64_t>(ddr_off);
+    size_t words = len / 8;
+    for (size_t i = done / 8; i < words; i++) {
+        uint64_t w = src[i];
+        std::memcpy(dst + i * 8, &w, 8);
+    }
+    if (len % 8 != 0) {
+        uint64_t w = src[words];
+        std::memcpy(dst + words * 8, &w, len % 8);
+    }
+    return true;
+}
+
+// CRC32C of len bytes (a multiple of 8) at ddr_off, the first avail of them
+// copied to dst when given
+uint32_t BulkChannel::crc_copy(uint32_t ddr_off, size_t len, uint8_t* dst, size_t avail) const {
+    const volatile uint64_t* src = ddr_.at<uint64_t>(ddr_off);
+    uint32_t crc = RPU_CRC32C_INIT;
+
+    for (size_t i = 0; i < len / 8; i++) {
+        uint64_t w = src[i];
+        crc = rpu_crc32c_dword(crc, w);
+        if (dst && i * 8 < avail) {
+            std::memcpy(dst + i * 8, &w, std::min<size_t>(8, avail - i * 8));
+        }
+    }
+    return rpu_crc32c_final(crc);
+}
+
+uint32_t BulkChannel::crc(uint32_t ddr_off, size_t len) const {
+    len = (len + BULK_ALIGN - 1) & ~(size_t)(BULK_ALIGN - 1);
+    if (!is_open() || ddr_off % BULK_ALIGN != 0 || ddr_off > ddr_.size() ||
+        len > ddr_.size() - ddr_off) {
+        return 0;
+    }
+    return crc_copy(ddr_off, len, nullptr, 0);
+}
+
+// Collect status and DMA time of the descriptors completed up to tail
+void BulkChannel::collect(uint32_t tail, IpiResult& result) {
+    for (; done_ != tail; done_++) {
+        volatile rpu_bulk_desc& desc = desc_[done_ & BULK_MASK];
+        uint32_t status = desc.status;
+
+        dma_ticks_ += desc.dma_ticks;
+        if (desc.op == (BULK_OP_READ | BULK_OP_F_CRC) && status == RPU_CMD_STATUS_OK) {
+            size_t off = desc.ddr_offset - crc_base_;
+            uint8_t* dst = crc_dst_ ? crc_dst_ + off : nullptr;
+            size_t avail = (crc_dst_ && off < crc_len_) ? std::min<size_t>(desc.length, crc_len_ - off) : 0;
+
+            if (crc_copy(desc.ddr_offset, desc.length, dst, avail) != desc.result) {
+                status = RPU_CMD_STATUS_CRC;
+            }
+        }
+        if (status != RPU_CMD_STATUS_OK && result.ack_val == RPU_CMD_STATUS_OK) {
+            result.ack_val = status;
+        }
+    }
+}
+
+/*
+ * Move len bytes at ddr_off of the carveout to or from the RPU buffer at
+ * buf_off, split into descriptors of at most buf_size() - buf_off bytes.
+ * The length is rounded up to BULK_ALIGN. Descriptors are published a
+ * ring-full at a time with one doorbell, as on the command ring.
+ */
+IpiResult BulkChannel::transfer(uint32_t op, uint32_t ddr_off, size_t len, uint32_t buf_off) {
+    return run(op, ddr_off, len, buf_off, nullptr, nullptr, 0);
+}
+
+// transfer() with the user buffer of write() (src) or read() (dst), data_len
+// bytes long, for the BULK_OP_F_CRC pass
+IpiResult BulkChannel::run(uint32_t op, uint32_t ddr_off, size_t len, uint32_t buf_off,
+                           const void* src, void* dst, size_t data_len) {
+    IpiResult result;
+    uint64_t start = now_ns();
+    uint64_t end = start;
+
+    len = (len + BULK_ALIGN - 1) & ~(size_t)(BULK_ALIGN - 1);
+    dma_ticks_ = 0;
+    if (!is_open() || len == 0 || buf_off >= buf_size_ || ddr_off > ddr_.size() ||
+        len > ddr_.size() - ddr_off) {
+        result.ack_val = RPU_CMD_STATUS_BADARG;
+        return result;
+    }
+
+    const size_t chunk = buf_size_ - buf_off;
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    size_t next = 0;
+
+    crc_base_ = ddr_off;
+    crc_dst_ = static_cast<uint8_t*>(dst);
+    crc_len_ = data_len;
+
+    result.acked = true;
+    result.ack_val = RPU_CMD_STATUS_OK;
+    while (next < len) {
+        // Wait for free slots if the RPU has not caught up yet
+        if (!ipi_->wait_for(now_ns(), [&] {
+                return (uint32_t)(head_ - ctrl_.read<bulk::Tail>()) < BULK_SLOTS;
+            }, &end)) {
+            result.acked = false;
+            break;
+        }
+        collect(ctrl_.read_acquire<bulk::Tail>(), result);
+
+        uint32_t free_slots = BULK_SLOTS - (uint32_t)(head_ - done_);
+        for (; free_slots > 0 && next < len; free_slots--) {
+            uint32_t size = (uint32_t)std::min(chunk, len - next);
+            volatile rpu_bulk_desc& desc = desc_[head_ & BULK_MASK];
+            uint32_t value = 0;
+            if (op == (BULK_OP_WRITE | BULK_OP_F_CRC)) {
+                size_t avail = next < data_len ? std::min<size_t>(size, data_len - next) : 0;
+                value = in ? crc_padded(in + next, avail, size)
+                           : crc_copy(ddr_off + (uint32_t)next, size, nullptr, 0);
+            }
+            desc.op = op;
+            desc.ddr_offset = ddr_off + (uint32_t)next;
+            desc.buf_offset = buf_off;
+            desc.length = size;
+            desc.seq = head_;
+            desc.status = RPU_CMD_STATUS_PENDING;
+            desc.dma_ticks = 0;
+            desc.result = value;
+            head_++;
+            next += size;
+        }
+
+        // Descriptors must be visible before the head that publishes them
+        ctrl_.write_release<bulk::Head>(head_);
+        ipi_->doorbell();
+    }
+
+    // Wait for the RPU to complete everything we published
+    if (result.acked) {
+        result.acked = ipi_->wait_for(start, [&] {
+            return ctrl_.read<bulk::Tail>() == head_;
+        }, &end);
+    }
+    collect(ctrl_.read_acquire<bulk::Tail>(), result);
+    if (result.ack_val != RPU_CMD_STATUS_OK) result.acked = false;
+    crc_dst_ = nullptr;
+
+    result.rtt_us = (end - start) / 1000.0;
+    return result;
+}
+
+/*
+ * One BULK_OP_CHECKSUM descriptor over the range: it is not limited by the
+ * RPU buffer, so the whole carveout can be summed at once.
+ */
+// One descriptor that runs on its own (checksum, PCAP), waited for
+IpiResult BulkChannel::single(uint32_t op, uint32_t ddr_off, size_t len, uint32_t buf_off,
+                              uint32_t* value) {
+    IpiResult result;
+    uint64_t start = now_ns();
+    uint64_t end = start;
+
+    len = (len + BULK_ALIGN - 1) & ~(size_t)(BULK_ALIGN - 1);
+    dma_ticks_ = 0;
+    if (!is_open() || len == 0 || ddr_off > ddr_.size() || len > ddr_.size() - ddr_off) {
+        result.ack_val = RPU_CMD_STATUS_BADARG;
+        return result;
+    }
+
+    result.ack_val = RPU_CMD_STATUS_OK;
+    if (!ipi_->wait_for(start, [&] {
+            return (uint32_t)(head_ - ctrl_.read<bulk::Tail>()) < BULK_SLOTS;
+        }, &end)) {
+        return result;
+    }
+    collect(ctrl_.read_acquire<bulk::Tail>(), result);
+
+    volatile rpu_bulk_desc& desc = desc_[head_ & BULK_MASK];
+    desc.op = op;
+    desc.ddr_offset = ddr_off;
+    desc.buf_offset = buf_off;
+    desc.length = (uint32_t)len;
+    desc.seq = head_;
+    desc.status = RPU_CMD_STATUS_PENDING;
+    desc.dma_ticks = 0;
+    desc.result = 0;
+    head_++;
+
+    ctrl_.write_release<bulk::Head>(head_);
+    ipi_->doorbell();
+
+    result.acked = ipi_->wait_for(start, [&] {
+        return ctrl_.read<bulk::Tail>() == head_;
+    }, &end);
+    collect(ctrl_.read_acquire<bulk::Tail>(), result);
+    if (result.ack_val != RPU_CMD_STATUS_OK) result.acked = false;
+    if (result.acked && value) *value = desc.result;
+
+    result.rtt_us = (end - start) / 1000.0;
+    return result;
+}
+
+IpiResult BulkChannel::checksum(uint32_t ddr_off, size_t len, uint32_t& sum) {
+    sum = 0;
+    return single(BULK_OP_CHECKSUM, ddr_off, len, 0, &sum);
+}
+
+IpiResult BulkChannel::pcap(uint32_t ddr_off, size_t len, uint32_t flags) {
+    return single(BULK_OP_PCAP, ddr_off, len, flags, nullptr);
+}
+
+// The RPU timestamps with the system counter, which CNTFRQ describes
+double BulkChannel::dma_us() const {
+    return dma_ticks_ * 1e6 / counter_freq();
+}
+
+IpiResult BulkChannel::write(const void* data, size_t len, bool crc) {
+    if (!put(0, data, len)) {
+        IpiResult result;
+        result.ack_val = RPU_CMD_STATUS_BADARG;
+        return result;
+    }
+    if (crc) return run(BULK_OP_WRITE | BULK_OP_F_CRC, 0, len, 0, data, nullptr, len);
+    return transfer(BULK_OP_WRITE, 0, len);
+}
+
+// With crc the data is copied out while each piece is checked
+IpiResult BulkChannel::read(void* data, size_t len, bool crc) {
+    if (crc) return run(BULK_OP_READ | BULK_OP_F_CRC, 0, len, 0, nullptr, data, len);
+    IpiResult result = transfer(BULK_OP_READ, 0, len);
+    if (result.acked) get(0, data, len);
+    return result;
+}
+
+} // namespace kr260hal
@@ -0,0 +1,131 @@
+/*
+ * APU side of the bulk data channel (kr260hal).
+ *
+ * BulkChannel maps the DDR carveout and the bulk control block of the core
+ * an IpiTransport is open on (common/rpu_shm.h) and queues descriptors that
+ * the RPU firmware executes with its DMA engine:
+ *
+ *   put() / get()   copy between user memory and the carveout, large
+ *                   copies with the rpu_ipi module's DMA channel when it
+ *                   serves the carveout (common/rpu_ipi_ioctl.h)
+ *   transfer()      move a carveout range to (BULK_OP_WRITE) or from
+ *                   (BULK_OP_READ) the RPU buffer, one descriptor per
+ *                   buffer-full, and wait for the last one
+ *   write() / read()  put() + transfer() and transfer() + get() at offset 0
+ *   checksum()      BULK_OP_CHECKSUM: the RPU sums a carveout range with its
+ *                   CSU DMA, to verify data placed there (word_sum() is the
+ *                   same sum on the APU)
+ *   pcap()          BULK_OP_PCAP: the RPU streams a carveout range into the
+ *                   PCAP, a partial bitstream or the next piece of one
+ *                   (firmware built with RPU_PCAP=1)
+ *
+ * BULK_OP_F_CRC in the op of transfer(), or crc in write() and read(), adds
+ * the CRC32C of each descriptor's piece (common/rpu_crc32c.h, with the A53
+ * CRC32C instructions): the RPU checks it on a write, this side on a read,
+ * and a mismatch fails the transfer with RPU_CMD_STATUS_CRC. write() and
+ * read() compute it in the same pass as their copy; transfer() alone reads
+ * the range back from the carveout for it.
+ *
+ * Doorbells and waits go through the transport, so they follow its backend
+ * and WaitPolicy (reverse IPI with UIO). The carveout must be reserved in
+ * the base device tree (APU/dts/rpu_bulk.dtsi) and is mapped through
+ * /dev/mem, which needs root. Only one BulkChannel may run per core.
+ */
+
+#ifndef KR260HAL_BULK_H
+#define KR260HAL_BULK_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rpu_shm.h"
+#include "ipi_transport.h"
+#include "mem_map.h"
+#include "reg.h"
+
+namespace kr260hal {
+
+namespace bulk {
+
+template <size_t Offset>
+using Word = Reg<Offset, uint32_t, BULK_CTRL_SIZE>;
+
+using Magic   = Word<BULK_MAGIC_OFFSET>;
+using BufSize = Word<BULK_BUF_SIZE_OFFSET>;
+using Head    = Word<BULK_HEAD_OFFSET>;
+using Tail    = Word<BULK_TAIL_OFFSET>;
+
+} // namespace bulk
+
+// Sum of the little-endian 32-bit words of data, a partial last word zero
+// padded; sums of consecutive word-aligned pieces add up to the whole
+uint32_t word_sum(const void* data, size_t len, uint32_t sum = 0);
+
+class BulkChannel {
+public:
+    BulkChannel() = default;
+
+    BulkChannel(const BulkChannel&) = delete;
+    BulkChannel& operator=(const BulkChannel&) = delete;
+
+    // Maps the channel of ipi.core(); false (errno set) if that failed,
+    // ENODEV when the firmware does not serve the channel
+    bool open(IpiTransport& ipi);
+    void close();
+
+    bool is_open() const { return ctrl_.valid(); }
+    size_t ddr_size() const { return ddr_.size(); }
+    uint32_t buf_size() const { return buf_size_; }
+
+    // True when put() and get() may copy with the kernel module's DMA channel
+    bool uses_dma() const { return dma_fd_ != -1; }
+
+    // Offsets are multiples of BULK_ALIGN; a partial last word is zero padded
+    bool put(uint32_t ddr_off, const void* data, size_t len);
+    bool get(uint32_t ddr_off, void* data, size_t len) const;
+
+    // result.ack_val is the first failing RPU_CMD_STATUS_*, or OK
+    IpiResult transfer(uint32_t op, uint32_t ddr_off, size_t len, uint32_t buf_off = 0);
+    IpiResult write(const void* data, size_t len, bool crc = false);
+    IpiResult read(void* data, size_t len, bool crc = false);
+    // Word sum of len bytes at ddr_off, rounded up to BULK_ALIGN
+    IpiResult checksum(uint32_t ddr_off, size_t len, uint32_t& sum);
+    // len bytes at ddr_off into the PCAP, with BULK_PCAP_* flags; ack_val is
+    // BADOP when the firmware has no PCAP loader
+    IpiResult pcap(uint32_t ddr_off, size_t len, uint32_t flags = 0);
+
+    // CRC32C of len bytes at ddr_off, rounded up to BULK_ALIGN, read from the carveout
+    uint32_t crc(uint32_t ddr_off, size_t len) const;
+
+    // DMA time of the last transfer(), checksum() or pcap(), in system counter ticks and in us
+    uint64_t dma_ticks() const { return dma_ticks_; }
+    double dma_us() const;
+
+private:
+    void open_dma(uint32_t core);
+    size_t dma_copy(uint32_t ddr_off, const void* data, size_t len, uint32_t flags) const;
+    void collect(uint32_t tail, IpiResult& result);
+    IpiResult run(uint32_t op, uint32_t ddr_off, size_t len, uint32_t buf_off, const void* src,
+                  void* dst, size_t data_len);
+    IpiResult single(uint32_t op, uint32_t ddr_off, size_t len, uint32_t buf_off, uint32_t* value);
+    uint32_t crc_copy(uint32_t ddr_off, size_t len, uint8_t* dst, size_t avail) const;
+
+    IpiTransport* ipi_ = nullptr;
+    MemMap ctrl_;  // Bulk control block in OCM
+    MemMap ddr_;   // The core's half of the carveout
+    volatile rpu_bulk_desc* desc_ = nullptr;
+    uint32_t buf_size_ = 0;
+    uint32_t head_ = 0;     // Local copy of the producer index
+    uint32_t done_ = 0;     // First descriptor whose status is not collected yet
+    uint64_t dma_ticks_ = 0;
+    int dma_fd_ = -1;        // /dev/rpu_ipi for RPU_IPI_IOC_DMA, -1 without
+    uint64_t dma_base_ = 0;  // Offset of ddr_ in the module's memory-region
+    // BULK_OP_F_CRC reads of the running transfer: copied to crc_dst_ while checked
+    uint32_t crc_base_ = 0;
+    uint8_t* crc_dst_ = nullptr;
+    size_t crc_len_ = 0;
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_BULK_H */
@@ -0,0 +1,156 @@
+/*
+ * Command traces of the APU -> RPU traffic (see cmd_trace.h).
+ */
+
+#include "cmd_trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace kr260hal {
+
+namespace {
+
+bool parse_u32(const std::string& token, uint32_t& value) {
+    char* end = nullptr;
+    unsigned long v = std::strtoul(token.c_str(), &end, 0);
+    if (token.empty() || *end != '\0' || v > UINT32_MAX) return false;
+    value = (uint32_t)v;
+    return true;
+}
+
+} // namespace
+
+std::string format_trace(const TraceRecord& rec) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%llu.%03llu", (unsigned long long)(rec.t_ns / 1000),
+                  (unsigned long long)(rec.t_ns % 1000));
+    std::string line = buf;
+
+    switch (rec.path) {
+        case TRACE_CMD:
+            line += " cmd " + std::to_string(rec.opcode);
+            break;
+        case TRACE_RING:
+            line += " ring";
+            for (const RingCommand& c : rec.ring) {
+                line += " " + std::to_string(c.opcode) + ":" + std::to_string(c.arg);
+            }
+            break;
+        case TRACE_MSG:
+            line += " msg " + std::to_string(rec.opcode);
+            for (uint32_t p : rec.params) line += " " + std::to_string(p);
+            break;
+    }
+    return line;
+}
+
+bool parse_trace(const std::string& line, TraceRecord& rec, std::string& error) {
+    std::istringstream in(line.substr(0, line.find('#')));
+    std::string t, path, token;
+    error.clear();
+    if (!(in >> t)) return false;
+
+    char* end = nullptr;
+    double t_us = std::strtod(t.c_str(), &end);
+    if (*end != '\0' || t_us < 0 || !(in >> path)) {
+        error = "expected <t_us> <cmd|ring|msg> ...";
+        return false;
+    }
+    rec = TraceRecord();
+    rec.t_ns = (uint64_t)(t_us * 1000.0 + 0.5);
+
+    if (path == "cmd") {
+        rec.path = TRACE_CMD;
+        if (!(in >> token) || !parse_u32(token, rec.opcode) || (in >> token)) {
+            error = "cmd takes one mode";
+            return false;
+        }
+    } else if (path == "ring") {
+        rec.path = TRACE_RING;
+        while (in >> token) {
+            size_t colon = token.find(':');
+            RingCommand c;
+            if (colon == std::string::npos || !parse_u32(token.substr(0, colon), c.opcode) ||
+                !parse_u32(token.substr(colon + 1), c.arg)) {
+                error = "bad ring command '" + token + "', expected <opcode>:<arg>";
+                return false;
+            }
+            rec.ring.push_back(c);
+        }
+        if (rec.ring.empty()) {
+            error = "ring takes at least one <opcode>:<arg>";
+            return false;
+        }
+    } else if (path == "msg") {
+        rec.path = TRACE_MSG;
+        if (!(in >> token) || !parse_u32(token, rec.opcode)) {
+            error = "msg takes an opcode";
+            return false;
+        }
+        uint32_t p;
+        while (in >> token) {
+            if (!parse_u32(token, p)) {
+                error = "bad msg parameter '" + token + "'";
+                return false;
+            }
+            rec.params.push_back(p);
+        }
+        if (rec.params.size() > SHM_IPI_MSG_DATA_WORDS) {
+            error = "msg takes at most " + std::to_string(SHM_IPI_MSG_DATA_WORDS) + " parameters";
+            return false;
+        }
+    } else {
+        error = "unknown path '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+bool load_trace(const std::string& path, std::vector<TraceRecord>& recs, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    int lineno = 0;
+    recs.clear();
+    while (std::getline(in, line)) {
+        lineno++;
+        TraceRecord rec;
+        if (parse_trace(line, rec, error)) {
+            recs.push_back(rec);
+        } else if (!error.empty()) {
+            error = "line " + std::to_string(lineno) + ": " + error;
+            return false;
+        }
+    }
+
+    // Writers of one file append in their own order only
+    std::stable_sort(recs.begin(), recs.end(),
+                     [](const TraceRecord& a, const TraceRecord& b) { return a.t_ns < b.t_ns; });
+    if (!recs.empty()) {
+        const uint64_t t0 = recs.front().t_ns;
+        for (TraceRecord& rec : recs) rec.t_ns -= t0;
+    }
+    return true;
+}
+
+int open_trace(const std::string& path) {
+    return ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+}
+
+bool append_trace(int fd, const TraceRecord& rec) {
+    const std::string line = format_trace(rec) + "\n";
+    return ::write(fd, line.data(), line.size()) == (ssize_t)line.size();
+}
+
+} // namespace kr260hal
@@ -0,0 +1,58 @@
+/*
+ * Command traces of the APU -> RPU traffic (kr260hal).
+ *
+ * A trace is a text file with one command or batch per line, in the
+ * order and with the time stamps they were sent:
+ *
+ *   <t_us> cmd <mode>                        legacy CMD/ACK word (send_mode())
+ *   <t_us> ring <opcode>:<arg> [...]         one submit() of the command ring
+ *   <t_us> msg <opcode> [<param> ...]        one IPI message (send_msg())
+ *
+ * '#' starts a comment. t_us is CLOCK_MONOTONIC_RAW (now_ns()) when
+ * recorded, so several processes appending to the same file share one
+ * timeline; load_trace() sorts the lines and makes the first one time 0.
+ *
+ * IpiTransport records what it sends once record() is called, or for every
+ * transport of a process started with KR260_IPI_RECORD=<file>. Lines are
+ * appended with one write() each, O_APPEND, so concurrent writers do not
+ * interleave within a line. Table uploads (waveforms, pattern programs) are
+ * not part of the trace, only the ring commands that start them.
+ */
+
+#ifndef KR260HAL_CMD_TRACE_H
+#define KR260HAL_CMD_TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ipi_transport.h"
+
+namespace kr260hal {
+
+enum TracePath { TRACE_CMD, TRACE_RING, TRACE_MSG };
+
+struct TraceRecord {
+    uint64_t t_ns = 0;
+    TracePath path = TRACE_CMD;
+    uint32_t opcode = 0;              // cmd: the mode; msg: the opcode
+    std::vector<uint32_t> params;     // msg: its parameters
+    std::vector<RingCommand> ring;    // ring: the batch
+};
+
+// The line of a record, without the newline
+std::string format_trace(const TraceRecord& rec);
+// Parse one line; false for a comment, a blank or a malformed line, with
+// error set for the latter
+bool parse_trace(const std::string& line, TraceRecord& rec, std::string& error);
+// The records of a file, sorted by time and from t_ns 0; false with a
+// "line N: ..." message in error
+bool load_trace(const std::string& path, std::vector<TraceRecord>& recs, std::string& error);
+
+// Open a trace for appending; -1 (errno set) if that failed
+int open_trace(const std::string& path);
+bool append_trace(int fd, const TraceRecord& rec);
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_CMD_TRACE_H */
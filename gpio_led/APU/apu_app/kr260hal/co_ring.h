@@ -0,0 +1,196 @@
+/*
+ * C++20 coroutine client of the rpu_ipi command ring (kr260hal).
+ *
+ * CoRing wraps a RingClient (ring_client.h) on an EventLoop (event_loop.h)
+ * so that an asynchronous controller reads as straight-line code:
+ *
+ *   kr260hal::CoTask blink(kr260hal::CoRing& ring) {
+ *       rpu_ipi_cmd done = co_await ring.send({RPU_CMD_SET_MODE, 1});
+ *       if (done.status != RPU_CMD_STATUS_OK) co_return;
+ *       co_await ring.send({RPU_CMD_SET_MODE, 2});
+ *   }
+ *
+ *   loop.open(); ring.open(loop);
+ *   blink(ring);                        // runs to its first co_await
+ *   while (ring.outstanding()) ring.run_once(-1);
+ *
+ * send() suspends the caller until the command's completion record comes
+ * back from the module, i.e. until the RPU has answered it on the ring and
+ * the reverse IPI (or the module's poll tick) has woken the file; no thread
+ * blocks and any number of coroutines can wait at once, the module's
+ * per-file queues and the RingClient backlog limiting only how many are on
+ * the ring. Sends are staged and written with one write() per wakeup: by
+ * run_once() before it waits, and after the coroutines a completion resumed
+ * have run to their next co_await, so a thousand coroutines in flight cost
+ * a system call per batch, not per command.
+ *
+ * Coroutines are resumed from the loop's handler of the ring fd, after the
+ * completions are drained, in completion (= submission) order. Drive the
+ * loop with run_once() rather than EventLoop::run_once(), or call flush()
+ * after other handlers that send, so staged sends are not left waiting.
+ *
+ * When the file fails (errno in error()) every waiting coroutine and every
+ * later send(), as after close(), gets its command back with status
+ * RPU_CMD_STATUS_PENDING. close() destroys the coroutines still suspended
+ * in send(). Header only and C++20 (-std=c++20; GCC 10 also needs
+ * -fcoroutines); the rest of the library stays C++17. Not thread safe,
+ * like the loop.
+ */
+
+#ifndef KR260HAL_CO_RING_H
+#define KR260HAL_CO_RING_H
+
+#if !defined(__cpp_impl_coroutine)
+#error "co_ring.h needs C++20 coroutines (-std=c++20)"
+#endif
+
+#include <cerrno>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <vector>
+
+#include "event_loop.h"
+#include "ring_client.h"
+
+namespace kr260hal {
+
+// Detached coroutine: runs at once up to its first co_await and frees its
+// frame when it returns. Errors travel as statuses, not exceptions.
+struct CoTask {
+    struct promise_type {
+        CoTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+class CoRing {
+public:
+    class Send;
+
+    CoRing() = default;
+    ~CoRing() { close(); }
+
+    CoRing(const CoRing&) = delete;
+    CoRing& operator=(const CoRing&) = delete;
+
+    // Opens /dev/rpu_ipi (RPU0 only) and registers it with loop, which must
+    // outlive the ring; false (errno set) if either failed
+    bool open(EventLoop& loop) {
+        close();
+        if (!client_.open()) return false;
+        client_.on_complete = [this](const rpu_ipi_cmd& cmd) { complete(cmd); };
+        if (!loop.add(client_.fd(), RingClient::EVENTS, [this](uint32_t revents) { handle(revents); })) {
+            int err = errno;
+            client_.close();
+            errno = err;
+            return false;
+        }
+        loop_ = &loop;
+        error_ = 0;
+        return true;
+    }
+
+    void close() {
+        if (loop_ != nullptr) loop_->remove(client_.fd());
+        loop_ = nullptr;
+        client_.close();
+        staged_.clear();
+        // Frames of the coroutines still waiting; a destroyed frame runs
+        // the destructors of its locals only
+        std::deque<Send*> waiting;
+        waiting.swap(waiting_);
+        ready_.clear();
+        for (Send* s : waiting) s->handle_.destroy();
+    }
+
+    bool is_open() const { return loop_ != nullptr; }
+    // errno of the failure that ended the file, 0 while it works
+    int error() const { return error_; }
+
+    // Awaitable: co_await send(cmd) gives the completion record (seq and
+    // status filled in)
+    Send send(const RingCommand& cmd) { return Send(*this, cmd); }
+
+    // Commands sent and not completed yet
+    size_t outstanding() const { return waiting_.size(); }
+    // Commands the module has not taken yet (staged or in the RingClient backlog)
+    size_t backlog() const { return staged_.size() + client_.backlog(); }
+
+    // Submits the staged sends, one write() for all of them
+    void flush() {
+        if (staged_.empty() || error_ != 0) return;
+        client_.submit(staged_);
+        staged_.clear();
+    }
+
+    // flush(), then EventLoop::run_once(timeout_ms)
+    int run_once(int timeout_ms) {
+        flush();
+        return loop_->run_once(timeout_ms);
+    }
+
+    class Send {
+    public:
+        bool await_ready() const noexcept { return ring_.error_ != 0 || ring_.loop_ == nullptr; }
+        void await_suspend(std::coroutine_handle<> h) {
+            handle_ = h;
+            ring_.staged_.push_back(RingCommand{cmd_.opcode, cmd_.arg});
+            ring_.waiting_.push_back(this);
+        }
+        rpu_ipi_cmd await_resume() const noexcept { return cmd_; }
+
+    private:
+        friend class CoRing;
+        Send(CoRing& ring, const RingCommand& cmd)
+            : ring_(ring), cmd_{cmd.opcode, cmd.arg, 0, RPU_CMD_STATUS_PENDING} {}
+
+        CoRing& ring_;
+        rpu_ipi_cmd cmd_;
+        std::coroutine_handle<> handle_;
+    };
+
+private:
+    void complete(const rpu_ipi_cmd& cmd) {
+        // Completions come back in submission order
+        if (waiting_.empty()) return;
+        Send* s = waiting_.front();
+        waiting_.pop_front();
+        s->cmd_.seq = cmd.seq;
+        s->cmd_.status = cmd.status;
+        ready_.push_back(s->handle_);
+    }
+
+    void handle(uint32_t revents) {
+        if (!client_.handle(revents) && error_ == 0) {
+            error_ = errno ? errno : EIO;
+            staged_.clear();
+            for (Send* s : waiting_) ready_.push_back(s->handle_);
+            waiting_.clear();
+        }
+        // Resumed after the drain, so their sends never nest in handle();
+        // once a resumed coroutine has closed the ring the rest are destroyed
+        std::vector<std::coroutine_handle<>> ready;
+        ready.swap(ready_);
+        for (std::coroutine_handle<> h : ready) {
+            if (loop_ != nullptr) h.resume();
+            else h.destroy();
+        }
+        if (loop_ != nullptr) flush();
+    }
+
+    RingClient client_;
+    EventLoop* loop_ = nullptr;
+    int error_ = 0;
+    std::vector<RingCommand> staged_;
+    std::deque<Send*> waiting_;  // Sent or staged, in submission order
+    std::vector<std::coroutine_handle<>> ready_;
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_CO_RING_H */
@@ -0,0 +1,73 @@
+/*
+ * Minimal epoll event loop (see event_loop.h).
+ */
+
+#include "event_loop.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+namespace kr260hal {
+
+// Events per epoll_wait()
+static constexpr int EVENT_LOOP_BATCH = 16;
+
+bool EventLoop::open() {
+    close();
+    epfd_ = epoll_create1(EPOLL_CLOEXEC);
+    return epfd_ != -1;
+}
+
+void EventLoop::close() {
+    if (epfd_ != -1) ::close(epfd_);
+    epfd_ = -1;
+    handlers_.clear();
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler handler) {
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) != 0) return false;
+    handlers_[fd] = std::make_shared<Handler>(std::move(handler));
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events) {
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    return epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+bool EventLoop::remove(int fd) {
+    if (handlers_.erase(fd) == 0) {
+        errno = ENOENT;
+        return false;
+    }
+    return epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr) == 0;
+}
+
+bool EventLoop::watch(RingClient& client, std::function<void()> on_error) {
+    RingClient* c = &client;
+    return add(client.fd(), RingClient::EVENTS, [c, on_error](uint32_t revents) {
+        if (!c->handle(revents) && on_error) on_error();
+    });
+}
+
+int EventLoop::run_once(int timeout_ms) {
+    struct epoll_event events[EVENT_LOOP_BATCH];
+
+    int n = epoll_wait(epfd_, events, EVENT_LOOP_BATCH, timeout_ms);
+    if (n < 0) return (errno == EINTR) ? 0 : -1;
+
+    for (int i = 0; i < n; i++) {
+        auto it = handlers_.find(events[i].data.fd);
+        if (it == handlers_.end()) continue;  // Removed by an earlier handler
+        std::shared_ptr<Handler> handler = it->second;
+        (*handler)(events[i].events);
+    }
+    return n;
+}
+
+} // namespace kr260hal
@@ -0,0 +1,63 @@
+/*
+ * Minimal epoll event loop (kr260hal).
+ *
+ * For control processes that serve the RPU next to sockets, timers or
+ * other file descriptors from one thread: each fd is registered with the
+ * events it waits for and a handler called with the events epoll_wait()
+ * reported. watch() registers a RingClient (ring_client.h) with the events
+ * it needs and runs its handle(). Handlers may add and remove fds, their
+ * own included; a removed fd gets no further events from the same
+ * run_once(). A loop is not thread safe.
+ */
+
+#ifndef KR260HAL_EVENT_LOOP_H
+#define KR260HAL_EVENT_LOOP_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+
+#include "ring_client.h"
+
+namespace kr260hal {
+
+class EventLoop {
+public:
+    using Handler = std::function<void(uint32_t revents)>;
+
+    EventLoop() = default;
+    ~EventLoop() { close(); }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Creates the epoll instance; false (errno set) if that failed
+    bool open();
+    void close();
+
+    bool is_open() const { return epfd_ != -1; }
+    int fd() const { return epfd_; }
+
+    // Registers fd for events (EPOLLIN, EPOLLOUT, EPOLLET, ...)
+    bool add(int fd, uint32_t events, Handler handler);
+    bool modify(int fd, uint32_t events);
+    bool remove(int fd);
+
+    // Registers client; on_error (if set) is called after a failed
+    // handle(), with errno set, and may remove or close the client
+    bool watch(RingClient& client, std::function<void()> on_error = nullptr);
+
+    // Waits up to timeout_ms (-1: forever) and runs the handlers of the
+    // ready fds; returns their number, -1 on an error other than EINTR
+    int run_once(int timeout_ms);
+
+private:
+    int epfd_ = -1;
+    // Handlers by fd, shared so that one removed while it runs stays alive
+    std::map<int, std::shared_ptr<Handler>> handlers_;
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_EVENT_LOOP_H */
@@ -0,0 +1,95 @@
+/*
+ * Host stand-in for the shared window and the IPI block (see host_ipi.h).
+ */
+
+#include "host_ipi.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace kr260hal {
+namespace host {
+
+std::string shm_path(unsigned core) {
+    const char* dir = std::getenv("KR260_HOST_SHM_DIR");
+    return std::string(dir != nullptr && dir[0] != '\0' ? dir : SHM_DIR) +
+           "/kr260_rpu" + std::to_string(core);
+}
+
+bool map(unsigned core, bool create, MemMap& window, MemMap& ipi) {
+    if (core >= RPU_CORE_COUNT) {
+        errno = EINVAL;
+        return false;
+    }
+    int fd = ::open(shm_path(core).c_str(), O_RDWR | (create ? O_CREAT : 0), 0600);
+    if (fd == -1) return false;
+
+    // A new file reads as zeroes: no ABI header yet, the doorbells idle
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size < (off_t)FILE_SIZE) {
+        ok = create && ftruncate(fd, FILE_SIZE) == 0;
+        if (!create) errno = ENODEV;  // Not (yet) set up by an emulator
+    }
+    ok = ok && window.map_fd(fd, 0, SHARED_MEM_SIZE) &&
+         ipi.map_fd(fd, IPI_OFFSET, FILE_SIZE - IPI_OFFSET);
+    int saved_errno = errno;
+    ::close(fd);
+    errno = saved_errno;
+    return ok;
+}
+
+void unlink(unsigned core) {
+    ::unlink(shm_path(core).c_str());
+}
+
+// Not FUTEX_PRIVATE_FLAG: the other side is another process as often as
+// another thread
+static long futex(volatile uint32_t* word, int op, uint32_t val, const struct timespec* timeout) {
+    return syscall(SYS_futex, const_cast<uint32_t*>(word), op, val, timeout, nullptr, 0);
+}
+
+void raise(volatile uint32_t* word, uint32_t bits) {
+    // Release: the stores the doorbell announces are seen before its bits
+    __atomic_fetch_or(const_cast<uint32_t*>(word), bits, __ATOMIC_RELEASE);
+    futex(word, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+uint32_t take(volatile uint32_t* word, uint32_t bits, int timeout_ms) {
+    struct timespec now, deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    for (;;) {
+        uint32_t val = __atomic_load_n(const_cast<uint32_t*>(word), __ATOMIC_ACQUIRE);
+        if (val & bits) {
+            return __atomic_fetch_and(const_cast<uint32_t*>(word), ~bits, __ATOMIC_ACQ_REL) & bits;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        struct timespec left = {deadline.tv_sec - now.tv_sec, deadline.tv_nsec - now.tv_nsec};
+        if (left.tv_nsec < 0) {
+            left.tv_sec--;
+            left.tv_nsec += 1000000000L;
+        }
+        if (left.tv_sec < 0) return 0;
+        // Sleeps only while the word still holds val: a raise() in between
+        // makes it return at once
+        futex(word, FUTEX_WAIT, val, &left);
+    }
+}
+
+} // namespace host
+} // namespace kr260hal
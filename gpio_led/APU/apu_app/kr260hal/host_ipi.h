@@ -0,0 +1,56 @@
+/*
+ * Host stand-in for the shared window and the IPI block (kr260hal).
+ *
+ * For running the APU side of the protocols on a development machine or in
+ * CI, against the RPU emulator of host_rpu.h instead of a board. Each core
+ * is one file, HOST_SHM_DIR/kr260_rpu<core> (KR260_HOST_SHM_DIR overrides
+ * the directory), holding:
+ *
+ *   0x0000  the shared window, same layout as SHARED_MEM_ADDR_CORE(core),
+ *           with the core's IPI message buffers at their SHM_IPI_REQ_ADDR()
+ *           offsets, as in RPU0's window
+ *   0x1000  a page standing in for the APU IPI registers (hw_regs.h,
+ *           ipi::): the doorbell to the RPU is ipi::Trig, the reverse IPI
+ *           ipi::Isr
+ *
+ * Mapping it shared gives the two sides the same coherent memory the window
+ * is on the board. A doorbell word is a futex: raise() ORs the target bits
+ * in and wakes the waiter, take() blocks until one of its bits is set and
+ * clears them, as the RPU's handler clears its ISR. Bits stay set until
+ * taken, so ipi::Trig reads as ipi::Obs does on the board.
+ */
+
+#ifndef KR260HAL_HOST_IPI_H
+#define KR260HAL_HOST_IPI_H
+
+#include <cstdint>
+#include <string>
+
+#include "rpu_shm.h"
+#include "mem_map.h"
+
+namespace kr260hal {
+namespace host {
+
+constexpr const char* SHM_DIR = "/dev/shm";
+constexpr size_t IPI_OFFSET = SHARED_MEM_SIZE;
+constexpr size_t FILE_SIZE = SHARED_MEM_SIZE + 0x1000;
+
+// File of the emulated core
+std::string shm_path(unsigned core);
+
+// Map the window and the IPI page of the emulated core; create: the
+// emulator's side, which makes the file (zeroed) if there is none
+bool map(unsigned core, bool create, MemMap& window, MemMap& ipi);
+// Remove the file; clients that still map it keep their memory
+void unlink(unsigned core);
+
+// Set bits in a doorbell word and wake its waiter
+void raise(volatile uint32_t* word, uint32_t bits);
+// Wait up to timeout_ms for one of bits, clear and return them; 0 on timeout
+uint32_t take(volatile uint32_t* word, uint32_t bits, int timeout_ms);
+
+} // namespace host
+} // namespace kr260hal
+
+#endif /* KR260HAL_HOST_IPI_H */
@@ -0,0 +1,360 @@
+/*
+ * RPU emulator for host runs of the APU side (see host_rpu.h).
+ *
+ * The functions follow their firmware counterparts one to one, so the
+ * ordering of the window accesses is the RPU's: the firmware's
+ * __sync_synchronize() is barrier::full() here.
+ */
+
+#include "host_rpu.h"
+
+#include <algorithm>
+
+#include "rpu_pattern_prog.h"
+#include "host_ipi.h"
+#include "hw_regs.h"
+#include "ipi_transport.h"
+#include "shm_regs.h"
+
+namespace kr260hal {
+
+// How often run() looks at stop() while no doorbell comes
+constexpr int HOST_RPU_STOP_POLL_MS = 100;
+
+bool HostRpu::open(unsigned core) {
+    close();
+    if (!host::map(core, true, shm_, ipi_)) return false;
+    core_ = core;
+    trig_ = ipi_.at(ipi::Trig::offset);
+    isr_ = ipi_.at(ipi::Isr::offset);
+    // The core's buffers at their offsets in RPU0's window, as for RPU0
+    msg_req_ = shm_.at(SHM_IPI_REQ_ADDR(core) - SHARED_MEM_ADDR);
+    msg_resp_ = shm_.at(SHM_IPI_RESP_ADDR(core) - SHARED_MEM_ADDR);
+    stop_.store(false, std::memory_order_relaxed);
+    stats_ = HostRpuStats();
+
+    // vRpuAbiInit(): hide the header while it changes, keep the legacy ACK
+    // words and what clients of the previous run negotiated
+    shm_.write<shm::AbiMagic>(0);
+    barrier::full();
+    active_ = 0;
+    shm_.write<shm::AbiVersion>(SHM_ABI_VERSION);
+    shm_.write<shm::AbiFeatures>(HOST_RPU_FEATURES);
+    shm_.write<shm::AbiAckSeq>(shm_.read<shm::AckSeq>());
+    shm_.write<shm::AbiAck>(shm_.read<shm::Ack>());
+    abi_grant(shm_.read<shm::AbiReqSeq>());
+    // A ring left behind by an earlier run is not replayed
+    shm_.write<shm::RingTail>(shm_.read<shm::RingHead>());
+    shm_.write<shm::UrgentTail>(shm_.read<shm::UrgentHead>());
+    shm_.write<shm::RingState>(SHM_RING_STATE_IDLE);
+    credit_ns_ = 0;
+    credit_window_ = SHM_RING_SLOTS;
+    shm_.write<shm::RingRate>(0);
+    shm_.write<shm::RingCredit>(shm_.read<shm::RingTail>() + SHM_RING_SLOTS);
+    __atomic_store_n(const_cast<uint32_t*>(trig_), 0, __ATOMIC_RELAXED);
+    barrier::full();
+    shm_.write<shm::AbiMagic>(SHM_ABI_MAGIC);
+    return true;
+}
+
+void HostRpu::close(bool remove) {
+    if (shm_.valid()) {
+        // As a firmware stop: clients must not take the header for a live one
+        shm_.write<shm::AbiMagic>(0);
+        barrier::full();
+    }
+    shm_.unmap();
+    ipi_.unmap();
+    trig_ = isr_ = msg_req_ = msg_resp_ = nullptr;
+    if (remove) host::unlink(core_);
+}
+
+/*
+ * The IPI task's loop: wait for the doorbell, then passes until the ring is
+ * empty and no doorbell came meanwhile (prvIpiPass()).
+ */
+void HostRpu::run() {
+    const uint32_t mask = RPU_IPI_MASK(core_);
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        if (host::take(trig_, mask, HOST_RPU_STOP_POLL_MS) == 0) continue;
+        stats_.doorbells++;
+
+        do {
+            pass_begin();
+            stats_.passes++;
+            const uint32_t flags = shm_.read<shm::ApuFlags>();
+
+            uint32_t drained = drain_urgent(flags);
+            drained += abi_poll();
+            drained += handle_message();
+            drained += drain_ring(flags);
+            drained += handle_legacy(flags);
+            stats_.commands += drained;
+
+            // Reverse IPI so an interrupt-driven APU waiter wakes without polling
+            if (drained != 0 && (flags & SHM_APU_FLAG_ACK_IRQ)) {
+                host::raise(isr_, mask);
+            }
+        } while (!rearm());
+    }
+}
+
+// prvIpiPollBegin(): take the doorbell and tell ring producers this polls
+void HostRpu::pass_begin() {
+    __atomic_fetch_and(const_cast<uint32_t*>(trig_), ~RPU_IPI_MASK(core_), __ATOMIC_ACQ_REL);
+    shm_.write<shm::RingState>(SHM_RING_STATE_POLLING);
+    barrier::full();
+}
+
+// prvIpiRearm(): false if work arrived meanwhile and another pass runs
+bool HostRpu::rearm() {
+    shm_.write<shm::RingState>(SHM_RING_STATE_IDLE);
+    // The state before the head read: a producer writes head before reading
+    // the state, so either it rings or this sees its descriptors
+    barrier::full();
+    return shm_.read<shm::RingHead>() == shm_.read<shm::RingTail>() &&
+           shm_.read<shm::UrgentHead>() == shm_.read<shm::UrgentTail>() &&
+           (__atomic_load_n(const_cast<uint32_t*>(trig_), __ATOMIC_ACQUIRE) & RPU_IPI_MASK(core_)) == 0;
+}
+
+// prvAbiGrant(): add the requested features, then echo the request served
+void HostRpu::abi_grant(uint32_t seq) {
+    barrier::full();
+    active_ |= shm_.read<shm::AbiReq>() & HOST_RPU_FEATURES;
+    shm_.write<shm::AbiActive>(active_);
+    barrier::full();
+    shm_.write<shm::AbiGrantSeq>(seq);
+}
+
+uint32_t HostRpu::abi_poll() {
+    uint32_t seq = shm_.read<shm::AbiReqSeq>();
+    if (seq == shm_.read<shm::AbiGrantSeq>()) return 0;
+    abi_grant(seq);
+    return 1;
+}
+
+// prvHandleMessage(): one message from the core's IPI request buffer
+uint32_t HostRpu::handle_message() {
+    uint32_t req[SHM_IPI_MSG_WORDS];
+    uint32_t resp[SHM_IPI_MSG_WORDS] = {};
+    const uint32_t hdr = msg_req_[0];
+
+    if (hdr == msg_resp_[0]) return 0;
+
+    // The header publishes the parameters, so read it before them
+    barrier::full();
+    for (uint32_t i = 0; i < SHM_IPI_MSG_WORDS; i++) req[i] = msg_req_[i];
+    if (req[0] != hdr) return 0;  // Rewritten while being read: its doorbell follows
+
+    const uint32_t nargs = RPU_MSG_HDR_LEN(hdr);
+    if (nargs > SHM_IPI_MSG_DATA_WORDS) {
+        resp[1] = RPU_CMD_STATUS_BADARG;
+    } else {
+        resp[1] = exec(RPU_MSG_HDR_OPCODE(hdr), &req[1], nargs, &resp[2]);
+    }
+
+    // Status and results first, then the header
+    for (uint32_t i = 1; i < SHM_IPI_MSG_WORDS; i++) msg_resp_[i] = resp[i];
+    barrier::full();
+    msg_resp_[0] = hdr;
+    return 1;
+}
+
+// prvDrainUrgentRing(): released and signalled ahead of the rest of the pass
+uint32_t HostRpu::drain_urgent(uint32_t flags) {
+    volatile rpu_shm_desc* ring = shm_.at<rpu_shm_desc>(SHM_URING_DESC_OFFSET);
+    uint32_t tail = shm_.read<shm::UrgentTail>();
+    const uint32_t head = shm_.read<shm::UrgentHead>();
+    uint32_t count = 0;
+
+    if (head == tail) return 0;
+    barrier::full();
+    if ((uint32_t)(head - tail) > SHM_URING_SLOTS) {
+        shm_.write<shm::UrgentTail>(head);
+        return 0;
+    }
+
+    for (; tail != head; tail++, count++) {
+        volatile rpu_shm_desc& desc = ring[tail & SHM_URING_MASK];
+        const uint32_t arg = desc.arg;
+        desc.status = exec(desc.opcode, &arg, 1, nullptr);
+    }
+
+    barrier::full();
+    shm_.write<shm::UrgentTail>(tail);
+    if (flags & SHM_APU_FLAG_ACK_IRQ) host::raise(isr_, RPU_IPI_MASK(core_));
+    return count;
+}
+
+// prvDrainCommandRing(), the urgent ring before each descriptor
+uint32_t HostRpu::drain_ring(uint32_t flags) {
+    volatile rpu_shm_desc* ring = shm_.at<rpu_shm_desc>(SHM_RING_DESC_OFFSET);
+    uint32_t tail = shm_.read<shm::RingTail>();
+    const uint32_t head = shm_.read<shm::RingHead>();
+    const uint64_t start = now_ns();
+    uint32_t count = 0;
+
+    // Head must be observed before the descriptors it publishes
+    barrier::full();
+
+    // A corrupted head (more than a ring ahead) is discarded rather than replayed
+    if ((uint32_t)(head - tail) > SHM_RING_SLOTS) {
+        shm_.write<shm::RingTail>(head);
+        credit_update(head, 0, 0);
+        return 0;
+    }
+
+    uint32_t urgent = 0;
+    for (; tail != head; tail++, count++) {
+        urgent += drain_urgent(flags);
+        volatile rpu_shm_desc& desc = ring[tail & SHM_RING_MASK];
+        const uint32_t arg = desc.arg;
+        desc.status = exec(desc.opcode, &arg, 1, nullptr);
+    }
+
+    if (count != 0) {
+        // Descriptor status must be visible before the slots are released
+        barrier::full();
+        shm_.write<shm::RingTail>(tail);
+        credit_update(tail, count, now_ns() - start);
+    }
+    return count + urgent;
+}
+
+// vRpuCreditUpdate(): EWMA of 1/8 per batch, window of the budget's worth
+void HostRpu::credit_update(uint32_t tail, uint32_t count, uint64_t ns) {
+    if (count != 0) {
+        const uint64_t sample = std::max<uint64_t>((ns << 4) / count, 1);
+        credit_ns_ = credit_ns_ == 0 ? sample : ((credit_ns_ << 3) - credit_ns_ + sample) >> 3;
+        const uint64_t fit = (HOST_RPU_CREDIT_BUDGET_NS << 4) / credit_ns_;
+        credit_window_ = (uint32_t)std::clamp<uint64_t>(fit, SHM_CREDIT_MIN_SLOTS, SHM_RING_SLOTS);
+        shm_.write<shm::RingRate>((uint32_t)std::min<uint64_t>((1000000000ULL << 4) / credit_ns_,
+                                                               UINT32_MAX));
+    }
+    shm_.write<shm::RingCredit>(tail + credit_window_);
+}
+
+// prvHandleLegacyWord(): pending while SEQ is ahead of ACK_SEQ, or ACK was cleared
+uint32_t HostRpu::handle_legacy(uint32_t flags) {
+    const uint32_t seq = shm_.read<shm::Seq>();
+    if (seq == shm_.read<shm::AckSeq>() && shm_.read<shm::Ack>() != 0) return 0;
+
+    // SEQ publishes CMD, so read it before the command word
+    barrier::full();
+    const uint32_t cmd = shm_.read<shm::Cmd>();
+    if ((flags & SHM_APU_FLAG_ECHO) == 0) {
+        const uint32_t arg = cmd;
+        exec(RPU_CMD_SET_MODE, &arg, 1, nullptr);
+    } else {
+        service();
+    }
+
+    // The sequence number first, then the acknowledgment
+    if (active_ & SHM_FEAT_ACK_LINE) {
+        shm_.write<shm::AbiAckSeq>(seq);
+        shm_.write<shm::AbiAck>(SHM_ACK_VALUE(cmd));
+    }
+    shm_.write<shm::AckSeq>(seq);
+    shm_.write<shm::Ack>(SHM_ACK_VALUE(cmd));
+    barrier::full();
+    return 1;
+}
+
+// The time a command takes, service_ns
+void HostRpu::service() const {
+    if (service_ns == 0) return;
+    const uint64_t end = now_ns() + service_ns;
+    while (now_ns() < end) cpu_relax();
+}
+
+// prvExecCommand(), for the commands this emulates
+uint32_t HostRpu::exec(uint32_t opcode, const uint32_t* args, uint32_t nargs, uint32_t* results) {
+    uint32_t status = RPU_CMD_STATUS_OK;
+
+    service();
+    if (nargs == 0 && opcode == RPU_CMD_SET_MODE) return RPU_CMD_STATUS_BADARG;
+
+    switch (opcode) {
+        case RPU_CMD_NOP:
+            if (results != nullptr) {
+                for (uint32_t i = 0; i < nargs && i < RPU_MSG_MAX_RESULTS; i++) results[i] = args[i];
+            }
+            break;
+        case RPU_CMD_SET_MODE:
+            // prvSetMode(): 0-2 under APU override, 3+ releases it
+            if (args[0] <= 2) {
+                mode_ = args[0];
+                override_ = 1;
+            } else {
+                override_ = 0;
+            }
+            break;
+        case RPU_CMD_PATTERN:
+            status = pattern(args[0]);
+            break;
+        case RPU_CMD_SEED:
+            seed_ = args[0];
+            break;
+        case RPU_CMD_QUERY:
+            if (results != nullptr) {
+                results[0] = mode_;
+                results[1] = override_;
+                results[2] = shm_.read<shm::WaveState>();
+            }
+            break;
+        default:
+            // RPU_CMD_WAVE, RPU_CMD_HANDOFF and RPU_CMD_AT need the hardware
+            status = RPU_CMD_STATUS_BADOP;
+            break;
+    }
+    return status;
+}
+
+// prvPattern() with the checks of ulRpuPatternLoad(); the program is not run
+uint32_t HostRpu::pattern(uint32_t arg) {
+    if (arg == RPU_PATTERN_STOP) {
+        if (mode_ == RPU_PATTERN_MODE) {
+            mode_ = prev_mode_;
+            override_ = prev_override_;
+        }
+        return RPU_CMD_STATUS_OK;
+    }
+    if (arg != RPU_PATTERN_START) return RPU_CMD_STATUS_BADARG;
+
+    const uint32_t count = shm_.read<shm::WaveCount>();
+    if (count == 0 || count > RPU_PAT_MAX_WORDS) return RPU_CMD_STATUS_BADARG;
+    const volatile uint32_t* prog = shm_.at(SHM_WAVE_SAMPLE_OFFSET);
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t insn = prog[i];
+        const uint32_t operand = RPU_PAT_OPERAND(insn);
+        switch (RPU_PAT_OP(insn)) {
+            case RPU_PAT_END:
+                break;
+            case RPU_PAT_SET:
+            case RPU_PAT_TOGGLE:
+            case RPU_PAT_RAND:
+                if (operand > RPU_PAT_VALUE_MASK) return RPU_CMD_STATUS_BADARG;
+                break;
+            case RPU_PAT_WAIT:
+                // The firmware's 1 ms tick turns 0 ms into no wait at all
+                if (operand == 0 || operand > RPU_PAT_MAX_WAIT_MS) return RPU_CMD_STATUS_BADARG;
+                break;
+            case RPU_PAT_LOOP:
+                if (RPU_PAT_LOOP_PC(insn) > i) return RPU_CMD_STATUS_BADARG;
+                break;
+            default:
+                return RPU_CMD_STATUS_BADARG;
+        }
+    }
+
+    if (mode_ != RPU_PATTERN_MODE) {
+        prev_mode_ = mode_;
+        prev_override_ = override_;
+    }
+    mode_ = RPU_PATTERN_MODE;
+    override_ = 1;
+    return RPU_CMD_STATUS_OK;
+}
+
+} // namespace kr260hal
@@ -0,0 +1,111 @@
+/*
+ * RPU emulator for host runs of the APU side (kr260hal).
+ *
+ * HostRpu serves the window of one core in the host files of host_ipi.h
+ * the way the firmware's IPI pass serves the real one (gpio_app/src/main.c,
+ * rpu_abi.c). It is written against the shared protocol headers
+ * (rpu_shm.h, rpu_pattern_prog.h), not built from the firmware sources,
+ * which need the Xilinx BSP and FreeRTOS:
+ *
+ *   - ABI header, features HOST_RPU_FEATURES, grants as rpu_abi.c
+ *   - legacy CMD/ACK words, with the SHM_FEAT_ACK_LINE copies once granted
+ *   - command ring with doorbell moderation (ring state word), and the
+ *     urgent ring ahead of it
+ *   - ring credits from the time batches take, as rpu_credit.c computes them
+ *   - IPI message buffer
+ *   - reverse IPI after a pass that served something, under
+ *     SHM_APU_FLAG_ACK_IRQ
+ *
+ * Commands: NOP, SET_MODE, QUERY, SEED and PATTERN, whose program is checked
+ * as rpu_pattern.c checks it and then only recorded; WAVE, HANDOFF and AT
+ * answer RPU_CMD_STATUS_BADOP, and SHM_FEAT_AT is not offered. service_ns
+ * adds a busy wait per command for a consumer slower than the host core.
+ *
+ * Round trips are then those of two host cores through the futex doorbell:
+ * they measure the APU code paths and the protocol's shape (doorbells per
+ * batch, pipelining, wait policy), not the board's absolute latency.
+ */
+
+#ifndef KR260HAL_HOST_RPU_H
+#define KR260HAL_HOST_RPU_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "rpu_shm.h"
+#include "mem_map.h"
+
+namespace kr260hal {
+
+constexpr uint32_t HOST_RPU_FEATURES = SHM_FEAT_RING | SHM_FEAT_RING_POLL | SHM_FEAT_ACK_IRQ |
+                                       SHM_FEAT_MSG | SHM_FEAT_ACK_LINE | SHM_FEAT_URGENT |
+                                       SHM_FEAT_CREDIT;
+// RPU_CREDIT_BUDGET_US of the firmware
+constexpr uint64_t HOST_RPU_CREDIT_BUDGET_NS = 1000000;
+
+struct HostRpuStats {
+    uint64_t doorbells = 0;  // Doorbells taken
+    uint64_t passes = 0;     // Passes over the window, several per doorbell while polling
+    uint64_t commands = 0;   // Legacy words, descriptors and messages served
+};
+
+class HostRpu {
+public:
+    HostRpu() = default;
+    ~HostRpu() { close(); }
+
+    HostRpu(const HostRpu&) = delete;
+    HostRpu& operator=(const HostRpu&) = delete;
+
+    // Create or take over the host window of 'core' and publish the ABI
+    // header; false (errno set) if it cannot be mapped
+    bool open(unsigned core = 0);
+    // Unmap; with remove, delete the host file too
+    void close(bool remove = false);
+
+    // Serve doorbells until stop(), from its own thread or process
+    void run();
+    // Safe from another thread and from a signal handler
+    void stop() { stop_.store(true, std::memory_order_relaxed); }
+
+    const HostRpuStats& stats() const { return stats_; }
+    uint32_t mode() const { return mode_; }
+
+    uint32_t service_ns = 0;  // Busy wait per command
+
+private:
+    void pass_begin();
+    bool rearm();
+    uint32_t abi_poll();
+    void abi_grant(uint32_t seq);
+    uint32_t handle_message();
+    uint32_t drain_ring(uint32_t flags);
+    uint32_t drain_urgent(uint32_t flags);
+    void credit_update(uint32_t tail, uint32_t count, uint64_t ns);
+    uint32_t handle_legacy(uint32_t flags);
+    void service() const;
+    uint32_t exec(uint32_t opcode, const uint32_t* args, uint32_t nargs, uint32_t* results);
+    uint32_t pattern(uint32_t arg);
+
+    MemMap shm_;
+    MemMap ipi_;
+    volatile uint32_t* trig_ = nullptr;  // Doorbell to this core (ipi::Trig)
+    volatile uint32_t* isr_ = nullptr;   // Reverse IPI (ipi::Isr)
+    volatile uint32_t* msg_req_ = nullptr;
+    volatile uint32_t* msg_resp_ = nullptr;
+    unsigned core_ = 0;
+    uint32_t active_ = 0;
+    uint32_t mode_ = 0;       // Blink mode and APU override, as prvSetMode() keeps them
+    uint32_t override_ = 0;
+    uint32_t prev_mode_ = 0;  // Restored when a pattern program stops
+    uint32_t prev_override_ = 0;
+    uint32_t seed_ = 0;       // Last RPU_CMD_SEED
+    uint64_t credit_ns_ = 0;  // Average ns per descriptor << 4, 0 until measured
+    uint32_t credit_window_ = SHM_RING_SLOTS;
+    HostRpuStats stats_;
+    std::atomic<bool> stop_{false};
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_HOST_RPU_H */
@@ -0,0 +1,241 @@
+/*
+ * Typed registers of the PL blocks and of the PS and AXI IP (kr260hal),
+ * for MemMap::read<R>() / write<R>() on a mapping of the block. Status
+ * and counters are read-only, triggers and set/clear registers write-only:
+ *
+ *   uint32_t pending = gen.read<interrupt_gen::Isr>();
+ *   uint32_t events = gen.read<interrupt_gen::Channel<1>::Events>();
+ *   bool running = pat.read_field<pattern_out::StatusRunning>();
+ *
+ * GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py,
+ * do not edit: change the description and run "make regmap" in myhdl/.
+ */
+
+#ifndef KR260HAL_HW_REGS_H
+#define KR260HAL_HW_REGS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "reg.h"
+
+namespace kr260hal {
+
+// interrupt_gen (myhdl/PL/MyHDL/src/interrupt_gen/interrupt_gen.py)
+namespace interrupt_gen {
+
+constexpr size_t SIZE           = 0x1000;
+constexpr uint32_t MAX_CHANNELS = 16;  // Channels of the interrupt_out variant
+
+using Period1      = Reg<0x000, uint32_t, SIZE>;              // PERIOD of channel 0
+using Period2      = Reg<0x004, uint32_t, SIZE>;              // PERIOD of channel 1
+using Isr          = Reg<0x008, uint32_t, SIZE>;              // Bit n: channel n pending, write 1 to clear
+using Ier          = Reg<0x00C, uint32_t, SIZE>;              // Bit n: channel n enabled
+using Trigger      = Reg<0x010, uint32_t, SIZE, Access::WO>;  // Write 1 to bit n to raise channel n
+using CounterLo    = Reg<0x014, uint32_t, SIZE, Access::RO>;  // Free-running PL clock count
+using CounterHi    = Reg<0x018, uint32_t, SIZE, Access::RO>;
+using Channels     = Reg<0x01C, uint32_t, SIZE, Access::RO>;  // Number of channels, 0 on the two-channel block
+using CompareArmed = Reg<0x020, uint32_t, SIZE>;              // Bit n: channel n compare armed, write 1 to disarm
+
+using IsrInterrupt1     = Field<Isr, 0>;
+using IsrInterrupt2     = Field<Isr, 1>;
+using IerInterrupt1     = Field<Ier, 0>;
+using IerInterrupt2     = Field<Ier, 1>;
+using TriggerInterrupt1 = Field<Trigger, 0>;
+using TriggerInterrupt2 = Field<Trigger, 1>;
+
+// Bank N of 16
+template <size_t N>
+struct Channel {
+    static_assert(N < 16, "no such channel");
+    static constexpr size_t OFFSET = 0x080 + N * 0x020;
+
+    using Period        = Reg<OFFSET + 0x00, uint32_t, SIZE>;              // Clocks between events, 0 stops the channel
+    using TimestampLo   = Reg<OFFSET + 0x04, uint32_t, SIZE, Access::RO>;  // Counter when the ISR bit was set
+    using TimestampHi   = Reg<OFFSET + 0x08, uint32_t, SIZE, Access::RO>;
+    using Events        = Reg<OFFSET + 0x0C, uint32_t, SIZE, Access::RO>;  // Free-running 32-bit event count
+    using CoalesceCount = Reg<OFFSET + 0x10, uint32_t, SIZE>;              // Events per ISR bit, 0 or 1: every event
+    using CoalesceTime  = Reg<OFFSET + 0x14, uint32_t, SIZE>;              // Clocks from the first pending event, 0: off
+    using CompareLo     = Reg<OFFSET + 0x18, uint32_t, SIZE>;              // COUNTER value of a one-shot event, disarms
+    using CompareHi     = Reg<OFFSET + 0x1C, uint32_t, SIZE>;              // Bits 63:32 of COMPARE; a write arms it
+};
+
+} // namespace interrupt_gen
+
+// pattern_out (myhdl/PL/MyHDL/src/pattern_out/pattern_out.py)
+namespace pattern_out {
+
+constexpr size_t SIZE = 0x1000;
+
+using Ctrl      = Reg<0x000, uint32_t, SIZE>;
+using Divider   = Reg<0x004, uint32_t, SIZE>;              // Sample period in clock cycles
+using Status    = Reg<0x008, uint32_t, SIZE, Access::RO>;
+using Isr       = Reg<0x00C, uint32_t, SIZE>;              // Write 1 to clear
+using Ier       = Reg<0x010, uint32_t, SIZE>;
+using Count     = Reg<0x014, uint32_t, SIZE, Access::RO>;  // Samples output since ENABLE was set
+using Underruns = Reg<0x018, uint32_t, SIZE, Access::RO>;  // Ticks without a sample
+
+using CtrlEnable    = Field<Ctrl, 0>;
+using StatusRunning = Field<Status, 0>;
+using StatusTvalid  = Field<Status, 1>;
+using IsrDone       = Field<Isr, 0>;
+using IsrUnderrun   = Field<Isr, 1>;
+using IerDone       = Field<Ier, 0>;
+using IerUnderrun   = Field<Ier, 1>;
+
+} // namespace pattern_out
+
+// stream_accel (myhdl/PL/MyHDL/src/stream_accel/stream_accel.py)
+namespace stream_accel {
+
+constexpr size_t SIZE = 0x1000;
+
+using Ctrl    = Reg<0x000, uint32_t, SIZE>;
+using Xor     = Reg<0x004, uint32_t, SIZE>;              // out = (in ^ XOR) + ADD while ENABLE is set
+using Add     = Reg<0x008, uint32_t, SIZE>;
+using Beats   = Reg<0x00C, uint32_t, SIZE, Access::RO>;  // Samples handed to the sink
+using Packets = Reg<0x010, uint32_t, SIZE, Access::RO>;  // TLASTs handed to the sink
+
+using CtrlEnable = Field<Ctrl, 0>;
+using CtrlClear  = Field<Ctrl, 1>;
+
+} // namespace stream_accel
+
+// pwm_seq (myhdl/PL/MyHDL/src/pwm_seq/pwm_seq.py)
+namespace pwm_seq {
+
+constexpr size_t SIZE              = 0x1000;
+constexpr uint32_t MAX_CHANNELS    = 8;         // Channels of the largest variant
+constexpr uint32_t STEP_DUTY_MASK  = 0xFFFFFF;  // Sequence entry: high clocks of the period
+constexpr uint32_t STEP_HOLD_SHIFT = 24;        // Sequence entry: periods the step lasts, minus 1
+
+using Ctrl     = Reg<0x000, uint32_t, SIZE>;
+using Isr      = Reg<0x004, uint32_t, SIZE>;              // Bit n: sequence of channel n done, write 1 to clear
+using Ier      = Reg<0x008, uint32_t, SIZE>;
+using Channels = Reg<0x00C, uint32_t, SIZE, Access::RO>;  // Number of channels
+using SeqDepth = Reg<0x010, uint32_t, SIZE, Access::RO>;  // Sequence entries per channel
+using SeqAddr  = Reg<0x014, uint32_t, SIZE>;              // Entry SEQ_DATA writes: channel * SEQ_DEPTH + step
+using SeqData  = Reg<0x018, uint32_t, SIZE, Access::WO>;  // Write an entry at SEQ_ADDR, which then increments
+
+using CtrlEnable = Field<Ctrl, 0>;
+
+// Bank N of 8
+template <size_t N>
+struct Channel {
+    static_assert(N < 8, "no such channel");
+    static constexpr size_t OFFSET = 0x040 + N * 0x020;
+
+    using Period   = Reg<OFFSET + 0x00, uint32_t, SIZE>;              // PL clocks per PWM period, 0 holds the pin low
+    using Duty     = Reg<OFFSET + 0x04, uint32_t, SIZE>;              // High clocks per period without a sequence
+    using SeqLen   = Reg<OFFSET + 0x08, uint32_t, SIZE>;              // Steps of the sequence; a write restarts it, 0 stops it
+    using SeqLoops = Reg<OFFSET + 0x0C, uint32_t, SIZE>;              // Passes of the sequence, 0: until stopped
+    using SeqStep  = Reg<OFFSET + 0x10, uint32_t, SIZE, Access::RO>;  // Step playing, bit 31 while the sequence runs
+};
+
+} // namespace pwm_seq
+
+// mailbox (myhdl/PL/MyHDL/src/mailbox/mailbox.py)
+namespace mailbox {
+
+constexpr size_t SIZE        = 0x1000;
+constexpr uint32_t MAX_DEPTH = 1024;  // Largest FIFO depth, in messages
+
+using A2rData      = Reg<0x000, uint32_t, SIZE>;              // APU -> RPU: write pushes, read is the oldest message
+using A2rPop       = Reg<0x004, uint32_t, SIZE, Access::WO>;  // Any write drops the oldest APU -> RPU message
+using A2rCount     = Reg<0x008, uint32_t, SIZE, Access::RO>;  // Messages in the APU -> RPU FIFO
+using A2rThreshold = Reg<0x00C, uint32_t, SIZE>;              // A2R_DATA pending while COUNT >= THRESHOLD (0: 1)
+using R2aData      = Reg<0x010, uint32_t, SIZE>;              // RPU -> APU: write pushes, read is the oldest message
+using R2aPop       = Reg<0x014, uint32_t, SIZE, Access::WO>;  // Any write drops the oldest RPU -> APU message
+using R2aCount     = Reg<0x018, uint32_t, SIZE, Access::RO>;  // Messages in the RPU -> APU FIFO
+using R2aThreshold = Reg<0x01C, uint32_t, SIZE>;              // R2A_DATA pending while COUNT >= THRESHOLD (0: 1)
+using Isr          = Reg<0x020, uint32_t, SIZE>;              // Write 1 to clear
+using Ier          = Reg<0x024, uint32_t, SIZE>;
+using Ctrl         = Reg<0x028, uint32_t, SIZE, Access::WO>;  // Write 1 to a FLUSH bit to empty that FIFO
+using Depth        = Reg<0x02C, uint32_t, SIZE, Access::RO>;  // FIFO depth in messages
+
+using IsrA2rData     = Field<Isr, 0>;
+using IsrR2aData     = Field<Isr, 1>;
+using IsrA2rOverflow = Field<Isr, 2>;
+using IsrR2aOverflow = Field<Isr, 3>;
+using IerA2rData     = Field<Ier, 0>;
+using IerR2aData     = Field<Ier, 1>;
+using IerA2rOverflow = Field<Ier, 2>;
+using IerR2aOverflow = Field<Ier, 3>;
+using CtrlFlushA2r   = Field<Ctrl, 0>;
+using CtrlFlushR2a   = Field<Ctrl, 1>;
+
+} // namespace mailbox
+
+// gpio_atomic (myhdl/PL/MyHDL/src/gpio_atomic/gpio_atomic.py)
+namespace gpio_atomic {
+
+constexpr size_t SIZE        = 0x1000;
+constexpr uint32_t MAX_WIDTH = 32;  // Pins of the largest variant
+
+using Data   = Reg<0x000, uint32_t, SIZE>;              // Output pins; a write replaces the bytes it strobes
+using Set    = Reg<0x004, uint32_t, SIZE, Access::WO>;  // Write 1 to drive a pin high
+using Clear  = Reg<0x008, uint32_t, SIZE, Access::WO>;  // Write 1 to drive a pin low
+using Toggle = Reg<0x00C, uint32_t, SIZE, Access::WO>;  // Write 1 to invert a pin
+using Input  = Reg<0x010, uint32_t, SIZE, Access::RO>;  // Input pins, synchronised to the PL clock
+using Width  = Reg<0x014, uint32_t, SIZE, Access::RO>;  // Number of output pins
+
+} // namespace gpio_atomic
+
+// Zynq UltraScale+ IPI channel (UG1087, IPI module)
+namespace ipi {
+
+constexpr size_t SIZE        = 0x1000;
+constexpr uintptr_t APU_BASE = 0xFF300000;  // APU IPI channel (source of the doorbell)
+
+using Trig = Reg<0x000, uint32_t, SIZE, Access::WO>;  // Write target bits to raise an IPI
+using Obs  = Reg<0x004, uint32_t, SIZE, Access::RO>;  // Target bits still pending
+using Isr  = Reg<0x010, uint32_t, SIZE>;              // Source bits pending, write 1 to clear
+using Imr  = Reg<0x014, uint32_t, SIZE, Access::RO>;  // Masked source bits
+using Ier  = Reg<0x018, uint32_t, SIZE, Access::WO>;  // Write 1 to unmask a source
+using Idr  = Reg<0x01C, uint32_t, SIZE, Access::WO>;  // Write 1 to mask a source
+
+} // namespace ipi
+
+// AXI GPIO (PG144)
+namespace axi_gpio {
+
+constexpr size_t SIZE = 0x1000;
+
+using Data  = Reg<0x000, uint32_t, SIZE>;  // Channel 1 data
+using Tri   = Reg<0x004, uint32_t, SIZE>;  // Channel 1 direction, 1: input
+using Data2 = Reg<0x008, uint32_t, SIZE>;  // Channel 2 data
+using Tri2  = Reg<0x00C, uint32_t, SIZE>;  // Channel 2 direction, 1: input
+using Gier  = Reg<0x11C, uint32_t, SIZE>;  // Global interrupt enable
+using IpIsr = Reg<0x120, uint32_t, SIZE>;  // Channel interrupt status, write 1 to clear
+using IpIer = Reg<0x128, uint32_t, SIZE>;  // Channel interrupt enable
+
+using GierEnable = Field<Gier, 31>;
+using IpIsrCh1   = Field<IpIsr, 0>;
+using IpIsrCh2   = Field<IpIsr, 1>;
+using IpIerCh1   = Field<IpIer, 0>;
+using IpIerCh2   = Field<IpIer, 1>;
+
+} // namespace axi_gpio
+
+// AXI interrupt controller (PG099)
+namespace axi_intc {
+
+constexpr size_t SIZE = 0x1000;
+
+using Isr = Reg<0x000, uint32_t, SIZE>;              // Pending
+using Ipr = Reg<0x004, uint32_t, SIZE, Access::RO>;  // Pending and enabled
+using Ier = Reg<0x008, uint32_t, SIZE>;
+using Iar = Reg<0x00C, uint32_t, SIZE, Access::WO>;  // Write 1 to acknowledge
+using Sie = Reg<0x010, uint32_t, SIZE, Access::WO>;  // Write 1 to set IER bits
+using Cie = Reg<0x014, uint32_t, SIZE, Access::WO>;  // Write 1 to clear IER bits
+using Ivr = Reg<0x018, uint32_t, SIZE, Access::RO>;  // Lowest pending and enabled input
+using Mer = Reg<0x01C, uint32_t, SIZE>;
+
+using MerMe  = Field<Mer, 0>;
+using MerHie = Field<Mer, 1>;
+
+} // namespace axi_intc
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_HW_REGS_H */
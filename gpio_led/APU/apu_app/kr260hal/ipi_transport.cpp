@@ -0,0 +1,711 @@
+/*
+ * APU side of the RPU command protocols (see ipi_transport.h).
+ */
+
+#include "ipi_transport.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "rpu_ipi_ioctl.h"
+#include "rpu_pattern_prog.h"
+#include "cmd_trace.h"
+#include "host_ipi.h"
+#include "timebase.h"
+
+namespace kr260hal {
+
+// Attempts of status() at a consistent copy
+static constexpr unsigned STATUS_READ_RETRIES = 1000;
+
+uintptr_t shm_window_addr(const MemMap& window, unsigned core) {
+    if (window.read<shm::RedirectMagic>() == SHM_REDIRECT_MAGIC &&
+        window.read<shm::RedirectAddr>() == SHARED_MEM_TCM_ADDR_CORE(core)) {
+        return SHARED_MEM_TCM_ADDR_CORE(core);
+    }
+    return SHARED_MEM_ADDR_CORE(core);
+}
+
+uintptr_t shm_window_addr(unsigned core) {
+    MemMap window;
+
+    // Without access to it, the default window is all there is to try
+    if (!window.map_phys(SHARED_MEM_ADDR_CORE(core), SHARED_MEM_SIZE, false)) {
+        return SHARED_MEM_ADDR_CORE(core);
+    }
+    return shm_window_addr(window, core);
+}
+
+const char* backend_name(IpiBackend backend) {
+    switch (backend) {
+        case IPI_BACKEND_DEV: return "dev";
+        case IPI_BACKEND_UIO: return "uio";
+        case IPI_BACKEND_MEM: return "mem";
+        case IPI_BACKEND_HOST: return "host";
+        default:              return "auto";
+    }
+}
+
+// Map the shared window through the rpu_ipi kernel module, if it is loaded
+bool IpiTransport::open_dev() {
+    dev_fd_ = ::open("/dev/" RPU_IPI_DEV_NAME, O_RDWR);
+    if (dev_fd_ == -1) return false;
+
+    if (!shm_.map_fd(dev_fd_, 0, SHARED_MEM_SIZE)) {
+        ::close(dev_fd_);
+        dev_fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+// UIO node names of the shared windows and of their TCM variants
+// (APU/dts/rpu_uio.dtso)
+static const char* const UIO_SHM_NAME[RPU_CORE_COUNT] = {"rpu-shm", "rpu-shm1"};
+static const char* const UIO_TCM_NAME[RPU_CORE_COUNT] = {"rpu-shm-tcm", "rpu-shm1-tcm"};
+
+bool IpiTransport::open_uio() {
+    if (!uio_ipi_.open("rpu-ipi") || !uio_ipi_.map(0, ipi_) ||
+        !uio_shm_.open(UIO_SHM_NAME[core_]) || !uio_shm_.map(0, shm_)) {
+        return false;
+    }
+    if (shm_window_addr(shm_, core_) != SHARED_MEM_ADDR_CORE(core_)) {
+        // TCM variant: RPU0's default window keeps only the message buffers
+        if (core_ == 0) msg_ram_ = std::move(shm_);
+        if (!uio_tcm_.open(UIO_TCM_NAME[core_]) || !uio_tcm_.map(0, shm_)) return false;
+    }
+    if (SHARED_MEM_ADDR_CORE(core_) != SHARED_MEM_ADDR &&
+        (!uio_msg_.open(UIO_SHM_NAME[0]) || !uio_msg_.map(0, msg_ram_))) {
+        return false;
+    }
+
+    // Reverse IPI from this core: clear, unmask, and ask the RPU to raise it
+    const uint32_t mask = RPU_IPI_MASK(core_);
+    ipi_.write<ipi::Isr>(mask);
+    ipi_.write<ipi::Ier>(mask);
+    shm_.write<shm::ApuFlags>(shm_.read<shm::ApuFlags>() | SHM_APU_FLAG_ACK_IRQ);
+    barrier::complete();
+    irq_ = uio_ipi_.enable_irq();
+    return true;
+}
+
+// Block until the reverse IPI or the deadline, then re-arm the interrupt.
+// The caller re-checks its condition after this, so an IPI that arrives
+// between the check and the re-arm is not lost.
+void IpiTransport::wait_irq(uint64_t deadline) {
+    uint64_t now = now_ns();
+    int timeout_ms = now < deadline ? (int)((deadline - now + 999999) / 1000000) : 0;
+
+    if (host_) {
+        // take() clears the bit as the Isr write below does
+        if (host::take(ipi_.at(ipi::Isr::offset), RPU_IPI_MASK(core_), timeout_ms) != 0) irq_count_++;
+        return;
+    }
+    if (uio_ipi_.wait_irq(timeout_ms, irq_count_)) {
+        ipi_.write<ipi::Isr>(RPU_IPI_MASK(core_));
+        // The clear reaches the IPI block before the GIC line is unmasked
+        barrier::complete();
+        uio_ipi_.enable_irq();
+    }
+}
+
+bool IpiTransport::open_mem() {
+    // Shared memory region of the selected core
+    const uintptr_t window = shm_window_addr(core_);
+    if (!shm_.map_phys(window, SHARED_MEM_SIZE)) return false;
+
+    // The message buffers are in the IPI message RAM, outside the window of
+    // RPU1 and of the TCM variant
+    if (window != SHARED_MEM_ADDR && !msg_ram_.map_phys(SHARED_MEM_ADDR, SHARED_MEM_SIZE)) {
+        return false;
+    }
+
+    // IPI APU base region (Source)
+    return ipi_.map_phys(ipi::APU_BASE, ipi::SIZE);
+}
+
+// Host files of the RPU emulator: the window, and the IPI page whose words
+// are the futex doorbells; the emulator raises the reverse one under ACK_IRQ
+bool IpiTransport::open_host() {
+    if (!host::map(core_, false, shm_, ipi_)) return false;
+    host_ = true;
+    shm_.write<shm::ApuFlags>(shm_.read<shm::ApuFlags>() | SHM_APU_FLAG_ACK_IRQ);
+    barrier::complete();
+    irq_ = true;
+    return true;
+}
+
+bool IpiTransport::open(unsigned core, IpiBackend backend) {
+    close();
+    if (core >= RPU_CORE_COUNT || (backend == IPI_BACKEND_DEV && core != 0)) {
+        errno = EINVAL;
+        return false;
+    }
+    core_ = core;
+
+    // The kernel module only serves RPU0; UIO and /dev/mem serve both cores
+    bool ok = false;
+    if (backend == IPI_BACKEND_AUTO || backend == IPI_BACKEND_DEV) {
+        ok = core_ == 0 && open_dev();
+        backend_ = IPI_BACKEND_DEV;
+    }
+    if (!ok && (backend == IPI_BACKEND_AUTO || backend == IPI_BACKEND_UIO)) {
+        ok = open_uio();
+        if (!ok) close_maps();  // Keep nothing of a partial UIO setup
+        backend_ = IPI_BACKEND_UIO;
+    }
+    if (!ok && (backend == IPI_BACKEND_AUTO || backend == IPI_BACKEND_MEM)) {
+        ok = open_mem();
+        backend_ = IPI_BACKEND_MEM;
+    }
+    if (backend == IPI_BACKEND_HOST) {
+        ok = open_host();
+        backend_ = IPI_BACKEND_HOST;
+    }
+    if (!ok) {
+        int saved_errno = errno;
+        close();
+        errno = saved_errno;
+        return false;
+    }
+
+    const MemMap& msg_ram = msg_ram_.valid() ? msg_ram_ : shm_;
+    msg_req_ = msg_ram.at(SHM_IPI_REQ_ADDR(core_) - SHARED_MEM_ADDR);
+    msg_resp_ = msg_ram.at(SHM_IPI_RESP_ADDR(core_) - SHARED_MEM_ADDR);
+    ring_desc_ = shm_.at<rpu_shm_desc>(SHM_RING_DESC_OFFSET);
+    urgent_desc_ = shm_.at<rpu_shm_desc>(SHM_URING_DESC_OFFSET);
+    seq_ = shm_.read<shm::Seq>();
+    head_ = shm_.read<shm::RingHead>();
+    urgent_head_ = shm_.read<shm::UrgentHead>();
+    retired_ = head_;
+    failed_.clear();
+    msg_seq_ = RPU_MSG_HDR_SEQ(msg_req_[0]);
+    if (!open_abi()) {
+        close();
+        errno = EPROTONOSUPPORT;
+        return false;
+    }
+    request_features(IPI_FEATURES);
+
+    // Capture of an unmodified program's traffic
+    const char* trace = std::getenv("KR260_IPI_RECORD");
+    if (record_fd_ == -1 && trace != nullptr && trace[0] != '\0') record(trace);
+    return true;
+}
+
+// ABI header of the firmware; false for a major version this code does not know
+bool IpiTransport::open_abi() {
+    abi_version_ = 0;
+    features_ = SHM_ABI_V0_FEATURES;
+    active_ = 0;
+    abi_pending_ = false;
+    if (shm_.read_acquire<shm::AbiMagic>() != SHM_ABI_MAGIC) return true;
+
+    abi_version_ = shm_.read<shm::AbiVersion>();
+    features_ = shm_.read<shm::AbiFeatures>();
+    active_ = shm_.read<shm::AbiActive>();
+    return SHM_ABI_VERSION_MAJOR(abi_version_) == SHM_ABI_VERSION_MAJOR(SHM_ABI_VERSION);
+}
+
+/*
+ * Seqlock read of the status block: the RPU holds seq odd for a dozen
+ * stores, so a busy block is retried at once rather than slept on.
+ */
+bool IpiTransport::status(RpuStatus* out) const {
+    if (shm_.read<shm::StatusMagic>() != SHM_STATUS_MAGIC) return false;
+
+    for (unsigned tries = 0; tries < STATUS_READ_RETRIES; tries++) {
+        const uint32_t seq = shm_.read<shm::StatusSeq>();
+        if (seq & 1) {
+            cpu_relax();
+            continue;
+        }
+        barrier::acquire();
+        out->mode = shm_.read<shm::StatusMode>();
+        out->flags = shm_.read<shm::StatusFlags>();
+        out->led = shm_.read<shm::StatusLed>();
+        out->step = shm_.read<shm::StatusStep>();
+        out->frames = shm_.read<shm::StatusFrames>();
+        out->commands = shm_.read<shm::StatusCommands>();
+        out->stamp = shm_.read<shm::StatusStampLo>() |
+                     (uint64_t)shm_.read<shm::StatusStampHi>() << 32;
+        barrier::acquire();
+        if (shm_.read<shm::StatusSeq>() == seq) return true;
+    }
+    return false;
+}
+
+uint32_t IpiTransport::active() {
+    if (abi_pending_ && shm_.read_acquire<shm::AbiGrantSeq>() == abi_req_seq_) {
+        active_ = shm_.read<shm::AbiActive>();
+        abi_pending_ = false;
+    }
+    return active_;
+}
+
+/*
+ * Requests of all clients accumulate in the request word, as the grants do
+ * on the RPU, so a restarted image grants every one of them again.
+ */
+void IpiTransport::request_features(uint32_t want) {
+    want &= features_;
+    if (abi_version_ == 0 || (want & ~active()) == 0) return;
+
+    shm_.write<shm::AbiReq>(shm_.read<shm::AbiReq>() | want);
+    // The request before the sequence number that publishes it
+    abi_req_seq_ = shm_.read<shm::AbiReqSeq>() + 1;
+    shm_.write_release<shm::AbiReqSeq>(abi_req_seq_);
+    abi_pending_ = true;
+    doorbell();
+}
+
+bool IpiTransport::negotiate(uint32_t want) {
+    uint64_t end;
+
+    request_features(want);
+    if (abi_pending_) {
+        wait_for(now_ns(), [&] {
+            return shm_.read<shm::AbiGrantSeq>() == abi_req_seq_;
+        }, &end);
+    }
+    return (active() & want) == want;
+}
+
+void IpiTransport::close_maps() {
+    ipi_.unmap();
+    msg_ram_.unmap();
+    shm_.unmap();
+    uio_ipi_.close();
+    uio_shm_.close();
+    uio_msg_.close();
+    uio_tcm_.close();
+}
+
+void IpiTransport::close() {
+    if (irq_) {
+        // Back to polling for other users of the window
+        shm_.write<shm::ApuFlags>(shm_.read<shm::ApuFlags>() & ~SHM_APU_FLAG_ACK_IRQ);
+        ipi_.write<ipi::Idr>(RPU_IPI_MASK(core_));
+        irq_ = false;
+    }
+    close_maps();
+    host_ = false;
+    if (dev_fd_ != -1) ::close(dev_fd_);
+    dev_fd_ = -1;
+    msg_req_ = msg_resp_ = nullptr;
+    ring_desc_ = urgent_desc_ = nullptr;
+    backend_ = IPI_BACKEND_AUTO;
+}
+
+bool IpiTransport::read_ipi_obs(uint32_t& obs) const {
+    if (!ipi_.valid()) return false;
+    // Host files: the doorbell bits stay in the trigger word until taken
+    obs = host_ ? *ipi_.at(ipi::Trig::offset) : ipi_.read<ipi::Obs>();
+    return true;
+}
+
+// Notify the RPU; the doorbell orders our earlier stores before the IPI,
+// in the ioctl, with the release barrier of the trigger write, or with the
+// release of the host futex word
+void IpiTransport::doorbell() {
+    if (dev_fd_ != -1) {
+        ioctl(dev_fd_, RPU_IPI_IOC_DOORBELL);
+    } else if (host_) {
+        host::raise(ipi_.at(ipi::Trig::offset), RPU_IPI_MASK(core_));
+    } else {
+        ipi_.write_release<ipi::Trig>(RPU_IPI_MASK(core_));
+    }
+}
+
+bool IpiTransport::record(const std::string& path) {
+    int fd = open_trace(path);
+    if (fd == -1) return false;
+    stop_recording();
+    record_fd_ = fd;
+    return true;
+}
+
+void IpiTransport::stop_recording() {
+    if (record_fd_ != -1) ::close(record_fd_);
+    record_fd_ = -1;
+}
+
+void IpiTransport::record_cmd(uint32_t mode) {
+    TraceRecord rec;
+    rec.t_ns = now_ns();
+    rec.path = TRACE_CMD;
+    rec.opcode = mode;
+    append_trace(record_fd_, rec);
+}
+
+void IpiTransport::record_ring(const RingCommand* cmds, size_t count) {
+    TraceRecord rec;
+    rec.t_ns = now_ns();
+    rec.path = TRACE_RING;
+    rec.ring.assign(cmds, cmds + count);
+    append_trace(record_fd_, rec);
+}
+
+void IpiTransport::record_msg(uint32_t opcode, const std::vector<uint32_t>& params) {
+    TraceRecord rec;
+    rec.t_ns = now_ns();
+    rec.path = TRACE_MSG;
+    rec.opcode = opcode;
+    rec.params = params;
+    append_trace(record_fd_, rec);
+}
+
+/*
+ * Send one mode through the legacy CMD/ACK words and wait for the ACK
+ * carrying its sequence number.
+ */
+IpiResult IpiTransport::send_mode(uint32_t mode) {
+    IpiResult result;
+    // Once granted, the copies in the RPU's line instead of ACK_SEQ/ACK
+    const bool ack_line = (active() & SHM_FEAT_ACK_LINE) != 0;
+
+    if (record_fd_ != -1) record_cmd(mode);
+    shm_.write<shm::Cmd>(mode);
+
+    // CMD must be visible before the sequence number publishing it
+    const uint32_t seq = ++seq_;
+    shm_.write_release<shm::Seq>(seq);
+
+    uint64_t start = now_ns();
+    result.seq = seq;
+    result.doorbell_cnt = counter_now();
+    doorbell();
+
+    uint64_t end = start;
+    // Only the ACK carrying our sequence number counts; a late ACK for an
+    // earlier command (ours or another sender's) cannot complete this wait
+    result.acked = wait_for(start, [&] {
+        return (ack_line ? shm_.read<shm::AbiAckSeq>() : shm_.read<shm::AckSeq>()) == seq;
+    }, &end);
+    result.done_cnt = counter_now();
+    result.ack_val = ack_line ? shm_.read<shm::AbiAck>() : shm_.read<shm::Ack>();
+
+    // RPU writes: SHM_ACK_VALUE(mode) = magic | (mode & 0xFF)
+    if (result.acked && result.ack_val != SHM_ACK_VALUE(mode)) {
+        result.acked = false;
+    }
+    result.rtt_us = (end - start) / 1000.0;
+    return result;
+}
+
+/*
+ * Queue commands (one opcode, one argument per descriptor) on the command
+ * ring and wait until the RPU consumed them: submit() and wait_done().
+ */
+IpiResult IpiTransport::send_batch(uint32_t opcode, const std::vector<uint32_t>& args) {
+    RingTicket ticket;
+
+    batch_.resize(args.size());
+    for (size_t i = 0; i < args.size(); i++) batch_[i] = RingCommand{opcode, args[i]};
+
+    if (!submit(batch_.data(), batch_.size(), &ticket)) {
+        IpiResult result;
+        result.rtt_us = (now_ns() - ticket.start_ns) / 1000.0;
+        return result;
+    }
+    return wait_done(ticket);
+}
+
+/*
+ * Descriptors are published with one head update and one doorbell per
+ * ring-full chunk (credit window with SHM_FEAT_CREDIT), so a batch that fits
+ * costs a single IPI; none while the RPU is still polling the ring
+ * (SHM_RING_NEED_DOORBELL). Before a slot is reused the status of the
+ * descriptor it held is retired, and kept if it failed, so a ticket can be
+ * waited for after later batches.
+ */
+bool IpiTransport::submit(const RingCommand* cmds, size_t count, RingTicket* ticket) {
+    uint64_t end;
+    size_t next = 0;
+
+    if (record_fd_ != -1 && count != 0) record_ring(cmds, count);
+    ticket->first = head_;
+    ticket->end = head_;
+    ticket->start_ns = now_ns();
+
+    while (next < count) {
+        // Wait for free slots (and credits) if the RPU has not caught up yet
+        if (!wait_for(now_ns(), [&] { return ring_space() != 0; }, &end)) {
+            return false;
+        }
+
+        // The RPU is done with the slots up to the tail before we reuse them
+        uint32_t free_slots = ring_space();
+        for (; free_slots > 0 && next < count; free_slots--, next++) {
+            volatile rpu_shm_desc& desc = ring_desc_[head_ & SHM_RING_MASK];
+            if (head_ - SHM_RING_SLOTS == retired_) {
+                uint32_t status = desc.status;
+                if (status != RPU_CMD_STATUS_OK) {
+                    if (failed_.size() == RING_FAILED_HISTORY) failed_.erase(failed_.begin());
+                    failed_.emplace_back(retired_, status);
+                }
+                retired_++;
+            }
+            desc.opcode = cmds[next].opcode;
+            desc.arg = cmds[next].arg;
+            desc.seq = head_;
+            desc.status = RPU_CMD_STATUS_PENDING;
+            head_++;
+        }
+
+        // Descriptors must be visible before the head that publishes them
+        shm_.write_release<shm::RingHead>(head_);
+        ticket->end = head_;
+        // Head before the state read, pairing with the RPU's re-arm
+        barrier::full();
+        if (SHM_RING_NEED_DOORBELL(shm_.read<shm::RingState>())) {
+            doorbell();
+        }
+    }
+    return true;
+}
+
+// Slots free up to the credit limit; the tail is read with acquire so the
+// slots it frees can be rewritten
+uint32_t IpiTransport::ring_space() const {
+    const uint32_t tail = shm_.read_acquire<shm::RingTail>();
+    if ((features_ & SHM_FEAT_CREDIT) == 0) return SHM_RING_FREE(head_, tail);
+    return SHM_RING_CREDITS(shm_.read<shm::RingCredit>(), head_, tail);
+}
+
+RingCredits IpiTransport::credits() const {
+    RingCredits c;
+    const uint32_t tail = shm_.read<shm::RingTail>();
+    c.free = ring_space();
+    c.window = SHM_RING_SLOTS;
+    if (features_ & SHM_FEAT_CREDIT) {
+        c.window = std::min<uint32_t>(shm_.read<shm::RingCredit>() - tail, SHM_RING_SLOTS);
+        c.rate = shm_.read<shm::RingRate>();
+    }
+    return c;
+}
+
+bool IpiTransport::done(const RingTicket& ticket) const {
+    if ((int32_t)(shm_.read<shm::RingTail>() - ticket.end) < 0) return false;
+    // The statuses after the tail that covers them
+    barrier::acquire();
+    return true;
+}
+
+IpiResult IpiTransport::wait_done(const RingTicket& ticket) {
+    IpiResult result;
+    uint64_t end;
+
+    result.acked = wait_for(now_ns(), [&] {
+        return (int32_t)(shm_.read<shm::RingTail>() - ticket.end) >= 0;
+    }, &end);
+
+    // The first failure of the batch
+    result.ack_val = result.acked ? ring_status(ticket) : RPU_CMD_STATUS_PENDING;
+    if (result.ack_val != RPU_CMD_STATUS_OK) {
+        result.acked = false;
+    }
+    result.rtt_us = (end - ticket.start_ns) / 1000.0;
+    return result;
+}
+
+// Status of a completed batch, from the ring or, for slots reused since, the
+// failures retired from them
+uint32_t IpiTransport::ring_status(const RingTicket& ticket) const {
+    for (uint32_t i = ticket.first; i != ticket.end; i++) {
+        if ((int32_t)(i - retired_) >= 0) {
+            uint32_t status = ring_desc_[i & SHM_RING_MASK].status;
+            if (status != RPU_CMD_STATUS_OK) return status;
+        } else {
+            for (const auto& f : failed_) {
+                if (f.first == i) return f.second;
+            }
+        }
+    }
+    return RPU_CMD_STATUS_OK;
+}
+
+/*
+ * One descriptor on the urgent ring (rpu_shm.h, "Urgent ring"): the RPU
+ * runs it at the start of its next pass or before the next descriptor of
+ * the batch it is draining, and releases it on its own. The doorbell rule
+ * is that of the command ring, whose state word it shares.
+ */
+IpiResult IpiTransport::send_urgent(uint32_t opcode, uint32_t arg) {
+    IpiResult result;
+    uint64_t start = now_ns();
+    uint64_t end;
+
+    if ((features_ & SHM_FEAT_URGENT) == 0) {
+        result.ack_val = RPU_CMD_STATUS_BADOP;
+        return result;
+    }
+
+    // Only while earlier urgent commands of another producer are still queued
+    if (!wait_for(start, [&] {
+            return (uint32_t)(urgent_head_ - shm_.read<shm::UrgentTail>()) < SHM_URING_SLOTS;
+        }, &end)) {
+        result.ack_val = RPU_CMD_STATUS_PENDING;
+        result.rtt_us = (end - start) / 1000.0;
+        return result;
+    }
+
+    volatile rpu_shm_desc& desc = urgent_desc_[urgent_head_ & SHM_URING_MASK];
+    desc.opcode = opcode;
+    desc.arg = arg;
+    desc.seq = urgent_head_;
+    desc.status = RPU_CMD_STATUS_PENDING;
+    const uint32_t index = urgent_head_++;
+
+    // Descriptor before head, head before the state read (as submit())
+    shm_.write_release<shm::UrgentHead>(urgent_head_);
+    barrier::full();
+    if (SHM_RING_NEED_DOORBELL(shm_.read<shm::RingState>())) {
+        doorbell();
+    }
+
+    result.acked = wait_for(start, [&] {
+        return (int32_t)(shm_.read<shm::UrgentTail>() - index) > 0;
+    }, &end);
+    result.ack_val = result.acked ? desc.status : RPU_CMD_STATUS_PENDING;
+    if (result.ack_val != RPU_CMD_STATUS_OK) {
+        result.acked = false;
+    }
+    result.rtt_us = (end - start) / 1000.0;
+    return result;
+}
+
+/*
+ * Send one command with parameters in the IPI message buffer and wait for
+ * the response. result.ack_val is the RPU_CMD_STATUS_* of the command and
+ * results receives RPU_MSG_MAX_RESULTS words. Through /dev/rpu_ipi the
+ * kernel module does the exchange (RPU_IPI_IOC_MSG) and applies its own
+ * timeout.
+ */
+IpiResult IpiTransport::send_msg(uint32_t opcode, const std::vector<uint32_t>& params,
+                                 uint32_t* results) {
+    IpiResult result;
+    uint64_t start = now_ns();
+    uint64_t end = start;
+
+    // RPMsg firmware: the kernel mailbox owns the IPI message buffers
+    if ((features_ & SHM_FEAT_MSG) == 0) {
+        result.ack_val = RPU_CMD_STATUS_BADOP;
+        return result;
+    }
+    if (record_fd_ != -1) record_msg(opcode, params);
+    if (dev_fd_ != -1) {
+        rpu_ipi_msg msg = {};
+        msg.opcode = opcode;
+        msg.len = params.size();
+        std::copy(params.begin(), params.end(), msg.data);
+        result.acked = ioctl(dev_fd_, RPU_IPI_IOC_MSG, &msg) == 0;
+        end = now_ns();
+        result.ack_val = msg.status;
+        std::copy(msg.result, msg.result + RPU_MSG_MAX_RESULTS, results);
+    } else {
+        for (size_t i = 0; i < params.size(); i++) msg_req_[1 + i] = params[i];
+
+        // Parameters must be visible before the header that publishes them
+        const uint32_t hdr = RPU_MSG_HDR(opcode, params.size(), ++msg_seq_);
+        barrier::release();
+        msg_req_[0] = hdr;
+
+        start = now_ns();
+        doorbell();
+        result.acked = wait_for(start, [&] {
+            return msg_resp_[0] == hdr;
+        }, &end);
+        result.ack_val = msg_resp_[1];
+        for (uint32_t i = 0; i < RPU_MSG_MAX_RESULTS; i++) results[i] = msg_resp_[2 + i];
+    }
+
+    if (result.acked && result.ack_val != RPU_CMD_STATUS_OK) {
+        result.acked = false;
+    }
+    result.rtt_us = (end - start) / 1000.0;
+    return result;
+}
+
+/*
+ * Upload a waveform table and start it, or stop playback when samples is
+ * empty. The RPU copies the table before it completes the descriptor.
+ */
+IpiResult IpiTransport::send_wave(uint32_t period_ns, uint32_t loops,
+                                  const std::vector<uint32_t>& samples, bool dma) {
+    if (samples.empty()) {
+        return send_batch(RPU_CMD_WAVE, {RPU_WAVE_STOP});
+    }
+
+    volatile uint32_t* table = shm_.at(SHM_WAVE_SAMPLE_OFFSET);
+    for (size_t i = 0; i < samples.size(); i++) table[i] = samples[i];
+    shm_.write<shm::WavePeriod>(period_ns);
+    shm_.write<shm::WaveCount>(samples.size());
+    shm_.write<shm::WaveLoops>(loops);
+
+    // The descriptor publish in send_batch orders the table before it
+    return send_batch(RPU_CMD_WAVE, {dma ? (uint32_t)RPU_WAVE_START_DMA : (uint32_t)RPU_WAVE_START});
+}
+
+/*
+ * Start a table already in the bulk carveout. The RPU fetches it a chunk
+ * at a time while it plays (rpu_shm.h, "Waveform"); SHM_WAVE_UNDERRUN_OFFSET
+ * counts the periods it had to hold a sample for a late chunk.
+ */
+IpiResult IpiTransport::send_wave_stream(uint32_t period_ns, uint32_t loops, uint32_t ddr_off,
+                                         uint32_t count) {
+    shm_.write<shm::WavePeriod>(period_ns);
+    shm_.write<shm::WaveCount>(count);
+    shm_.write<shm::WaveLoops>(loops);
+    shm_.write<shm::WaveDdrOffset>(ddr_off);
+    return send_batch(RPU_CMD_WAVE, {RPU_WAVE_START_STREAM});
+}
+
+/*
+ * Upload a pattern program (common/rpu_pattern_prog.h) into the waveform
+ * area and start it, or stop the running one when words is empty. As for
+ * waveforms, the RPU copies the program before it completes the descriptor.
+ */
+IpiResult IpiTransport::send_pattern(const std::vector<uint32_t>& words) {
+    if (words.empty()) {
+        return send_batch(RPU_CMD_PATTERN, {RPU_PATTERN_STOP});
+    }
+
+    volatile uint32_t* table = shm_.at(SHM_WAVE_SAMPLE_OFFSET);
+    for (size_t i = 0; i < words.size(); i++) table[i] = words[i];
+    shm_.write<shm::WaveCount>(words.size());
+
+    return send_batch(RPU_CMD_PATTERN, {RPU_PATTERN_START});
+}
+
+/*
+ * Each command goes behind an RPU_CMD_AT descriptor with the low word of
+ * the tick; the RPU resolves the high word as the one nearest to its now.
+ */
+IpiResult IpiTransport::send_at(uint64_t tick, const std::vector<RingCommand>& cmds) {
+    RingTicket ticket;
+
+    if ((features_ & SHM_FEAT_AT) == 0) {
+        IpiResult result;
+        result.ack_val = RPU_CMD_STATUS_BADOP;
+        return result;
+    }
+
+    batch_.clear();
+    for (const RingCommand& cmd : cmds) {
+        batch_.push_back(RingCommand{RPU_CMD_AT, (uint32_t)tick});
+        batch_.push_back(cmd);
+    }
+
+    if (!submit(batch_.data(), batch_.size(), &ticket)) {
+        IpiResult result;
+        result.rtt_us = (now_ns() - ticket.start_ns) / 1000.0;
+        return result;
+    }
+    return wait_done(ticket);
+}
+
+} // namespace kr260hal
@@ -0,0 +1,359 @@
+/*
+ * APU side of the RPU command protocols (kr260hal).
+ *
+ * IpiTransport maps the shared window of one RPU core and rings its
+ * doorbell, through the first of:
+ *   - the rpu_ipi kernel module (/dev/rpu_ipi, RPU0 only): no root needed,
+ *     messages through RPU_IPI_IOC_MSG
+ *   - the UIO nodes of APU/dts/rpu_uio.dtso: the windows are mapped from
+ *     /dev/uioN, and waits block on the reverse IPI instead of sleeping
+ *   - /dev/mem
+ * or, only when asked for (IPI_BACKEND_HOST), the host files of the RPU
+ * emulator (host_ipi.h, host_rpu.h), whose doorbells are futexes and whose
+ * waits block on the emulated reverse IPI as on UIO.
+ * On top of that it implements the protocols described in common/rpu_shm.h:
+ *
+ *   send_mode()   legacy CMD/ACK words, answered with the ACK per seq
+ *   send_batch()  command ring, one doorbell per ring-full of descriptors
+ *   submit()      command ring without waiting: a batch of any commands with
+ *                 one head update and doorbell, completed by its RingTicket
+ *                 (done(), wait_done()), so batches can be pipelined
+ *   credits()     ring slots the RPU takes now and its service rate
+ *   send_urgent() one command on the urgent ring, which the RPU serves ahead
+ *                 of the command ring, even in the middle of a batch
+ *   send_msg()    one command with parameters in the IPI message buffer
+ *   send_wave()   waveform table upload and start/stop over the ring
+ *   send_wave_stream()  start of a long table placed in the bulk carveout
+ *                 (BulkChannel::put()), streamed by the RPU as it plays
+ *   send_pattern()  LED pattern program upload and start/stop (pattern.h)
+ *   send_at()     ring commands the RPU holds for a system counter tick
+ *
+ * open() reads the ABI header of the window (version and SHM_FEAT_* fast
+ * paths the firmware serves) and refuses another major version; it then
+ * asks for IPI_FEATURES without waiting, and send_mode() moves to the ACK
+ * words of the RPU's line as soon as the grant shows. send_msg() and
+ * send_at() (and send_urgent()) fail at once with RPU_CMD_STATUS_BADOP when
+ * the firmware does not offer them. Reopen the transport after loading other firmware.
+ *
+ * With SHM_FEAT_CREDIT offered the ring is filled only up to the RPU's credit
+ * limit (rpu_shm.h, "Ring credits"): under overload submit() publishes what
+ * the window takes and sends the rest of the batch together as credit comes
+ * back, so a slow RPU throttles its producers rather than letting them fill
+ * the ring and time out.
+ *
+ * record() (or KR260_IPI_RECORD=<file> in the environment) appends each
+ * command sent to a command trace (cmd_trace.h) for rpu_replay.
+ *
+ * Every call waits for the RPU according to the WaitPolicy: it spins for
+ * spin_ns, then blocks on the UIO interrupt, or sleeps with exponential
+ * back-off up to max_sleep_us without UIO. A transport is not thread safe
+ * and only one ring producer may run per core.
+ */
+
+#ifndef KR260HAL_IPI_TRANSPORT_H
+#define KR260HAL_IPI_TRANSPORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+#include <unistd.h>
+
+#include "rpu_shm.h"
+#include "mem_map.h"
+#include "shm_regs.h"
+#include "uio.h"
+
+namespace kr260hal {
+
+constexpr uint32_t ACK_TIMEOUT_MS = 1000;              // Timeout for acknowledgment (1 second)
+constexpr uint64_t WAIT_SPIN_NS_DEFAULT = 20000;       // 20us covers a typical RPU round trip
+constexpr uint32_t WAIT_MIN_SLEEP_US = 1;
+constexpr uint32_t WAIT_MAX_SLEEP_US_DEFAULT = 1000;
+// Features open() asks for (rpu_shm.h, "ABI header")
+constexpr uint32_t IPI_FEATURES = SHM_FEAT_ACK_LINE;
+
+struct WaitPolicy {
+    uint64_t spin_ns = WAIT_SPIN_NS_DEFAULT;
+    uint32_t max_sleep_us = WAIT_MAX_SLEEP_US_DEFAULT;
+    uint32_t timeout_ms = ACK_TIMEOUT_MS;
+};
+
+// Outcome of a single command
+struct IpiResult {
+    bool acked = false;
+    uint32_t ack_val = 0;  // ACK word, or RPU_CMD_STATUS_* for ring and messages
+    double rtt_us = 0.0;   // Doorbell write to completion observed
+    // send_mode(): its sequence number (arg0 of the RPU's ACK trace event) and
+    // the system counter (timebase.h) at the doorbell and at the completion
+    // observed, to correlate with the RPU and rpu_ipi traces (rpu_e2e)
+    uint32_t seq = 0;
+    uint64_t doorbell_cnt = 0;
+    uint64_t done_cnt = 0;
+};
+
+// Status block of the firmware (rpu_shm.h, "Status block")
+struct RpuStatus {
+    uint32_t mode = 0;      // 0=SLOW 1=FAST 2=RANDOM 3=PATTERN
+    uint32_t flags = 0;     // SHM_STATUS_F_*
+    uint32_t led = 0;       // Value last written to the LEDs
+    uint32_t step = 0;      // Pattern program counter
+    uint32_t frames = 0;    // Free-running counters
+    uint32_t commands = 0;
+    uint64_t stamp = 0;     // System counter (timebase.h) at the update
+};
+
+// One command of submit(): opcode and argument of a ring descriptor
+struct RingCommand {
+    uint32_t opcode;
+    uint32_t arg;
+};
+
+// Flow control state of the command ring (credits())
+struct RingCredits {
+    uint32_t free = 0;    // Descriptors submit() may publish now
+    uint32_t window = 0;  // Slots the RPU grants past its tail
+    uint32_t rate = 0;    // Descriptors per second it served recently, 0 = unknown
+};
+
+// Completion token of submit(): the ring indices [first, end) of the batch
+struct RingTicket {
+    uint32_t first = 0;
+    uint32_t end = 0;
+    uint64_t start_ns = 0;  // Submission, for IpiResult::rtt_us
+};
+
+// Failed descriptors whose slots submit() reused, kept for wait_done()
+constexpr size_t RING_FAILED_HISTORY = 64;
+
+// Raw monotonic clock, not subject to NTP slewing
+inline uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Spin-loop hint so the polling core yields pipeline resources
+inline void cpu_relax() {
+#if defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/*
+ * Wait until done() returns true or the policy timeout expires.
+ * Busy-polls for the spin window (the RPU usually answers within a few
+ * microseconds), then falls back to sleeping with exponential back-off so
+ * long waits do not burn a core. On return *end holds the completion time
+ * and the loads of done() are ordered before the caller's (barrier::acquire),
+ * so the results a completion word covers can be read right after it.
+ */
+template <typename Pred>
+bool wait_until(const WaitPolicy& wait, uint64_t start, Pred done, uint64_t* end) {
+    const uint64_t spin_end = start + wait.spin_ns;
+    const uint64_t deadline = start + (uint64_t)wait.timeout_ms * 1000000ULL;
+    uint32_t sleep_us = WAIT_MIN_SLEEP_US;
+
+    for (;;) {
+        bool ok = done();
+        uint64_t now = now_ns();
+        if (ok || now >= deadline) {
+            barrier::acquire();
+            *end = now;
+            return ok;
+        }
+        if (now < spin_end) {
+            cpu_relax();
+        } else {
+            usleep(sleep_us);
+            sleep_us = std::min(sleep_us * 2, wait.max_sleep_us);
+        }
+    }
+}
+
+// Mapping and doorbell path of a transport, in the order open() tries them
+enum IpiBackend {
+    IPI_BACKEND_AUTO,  // First that works of the three below
+    IPI_BACKEND_DEV,   // /dev/rpu_ipi (RPU0 only)
+    IPI_BACKEND_UIO,   // generic-uio nodes
+    IPI_BACKEND_MEM,   // /dev/mem
+    IPI_BACKEND_HOST   // RPU emulator on this machine (host_rpu.h), never AUTO
+};
+
+const char* backend_name(IpiBackend backend);
+
+class IpiTransport {
+public:
+    IpiTransport() = default;
+    ~IpiTransport() {
+        close();
+        stop_recording();
+    }
+
+    IpiTransport(const IpiTransport&) = delete;
+    IpiTransport& operator=(const IpiTransport&) = delete;
+
+    // Maps the windows of RPU 'core'; false (errno set) if that failed
+    bool open(unsigned core = 0, IpiBackend backend = IPI_BACKEND_AUTO);
+    void close();
+
+    bool is_open() const { return shm_.valid(); }
+    unsigned core() const { return core_; }
+    IpiBackend backend() const { return backend_; }
+    bool uses_device() const { return dev_fd_ != -1; }  // Doorbell via /dev/rpu_ipi
+    bool uses_irq() const { return irq_; }              // Waits on the reverse IPI (UIO or host)
+    uint32_t irq_count() const { return irq_count_; }
+
+    // The shared window of the core, for status and protocol extensions
+    const MemMap& shm() const { return shm_; }
+    // Reads the observation word (pending bits of every target) into obs;
+    // false, obs untouched, when the doorbell goes through the module
+    bool read_ipi_obs(uint32_t& obs) const;
+
+    IpiResult send_mode(uint32_t mode);
+    IpiResult send_batch(uint32_t opcode, const std::vector<uint32_t>& args);
+
+    // Queue commands on the ring and return once they are published; waits
+    // only while the ring is full or out of credits. false if the RPU freed
+    // no slot within the timeout, with *ticket covering what was queued
+    bool submit(const RingCommand* cmds, size_t count, RingTicket* ticket);
+    bool submit(const std::vector<RingCommand>& cmds, RingTicket* ticket) {
+        return submit(cmds.data(), cmds.size(), ticket);
+    }
+#if __cplusplus >= 202002L
+    bool submit(std::span<const RingCommand> cmds, RingTicket* ticket) {
+        return submit(cmds.data(), cmds.size(), ticket);
+    }
+#endif
+    // Ring space against the RPU's credits; the whole free ring and rate 0
+    // without SHM_FEAT_CREDIT
+    RingCredits credits() const;
+    // The RPU consumed every command of the ticket
+    bool done(const RingTicket& ticket) const;
+    // Wait for done(); ack_val is the first failed RPU_CMD_STATUS_* of the
+    // batch, result.rtt_us covers submit() to the completion observed
+    IpiResult wait_done(const RingTicket& ticket);
+    // One command past everything queued on the ring (SHM_FEAT_URGENT), for
+    // control that must not wait behind a batch; ack_val as send_batch()
+    IpiResult send_urgent(uint32_t opcode, uint32_t arg);
+    IpiResult send_msg(uint32_t opcode, const std::vector<uint32_t>& params, uint32_t* results);
+    IpiResult send_wave(uint32_t period_ns, uint32_t loops, const std::vector<uint32_t>& samples,
+                        bool dma);
+    // count samples at byte offset ddr_off of the core's bulk carveout, read
+    // by the RPU while they play: leave them alone until the state is idle.
+    // send_wave() with no samples stops it; ack_val as send_batch()
+    IpiResult send_wave_stream(uint32_t period_ns, uint32_t loops, uint32_t ddr_off, uint32_t count);
+    // Program words of assemble_pattern(), empty to stop; ack_val as send_batch()
+    IpiResult send_pattern(const std::vector<uint32_t>& words);
+    // Commands run by the RPU at counter tick 'tick' (counter_now() timeline,
+    // at most RPU_CMD_AT_MAX_AHEAD ahead), in order. Completes once they are
+    // queued there; ack_val RPU_CMD_STATUS_LATE if the tick had passed
+    IpiResult send_at(uint64_t tick, const std::vector<RingCommand>& cmds);
+
+    uint32_t last_seq() const { return seq_; }  // Sequence number of the last send_mode()
+
+    // SHM_ABI_VERSION of the firmware, 0 if it predates the ABI header
+    uint32_t abi_version() const { return abi_version_; }
+    // SHM_FEAT_* it serves (SHM_ABI_V0_FEATURES without the header)
+    uint32_t features() const { return features_; }
+    // Consistent copy of the status block, read from the window without a
+    // command; false if the firmware does not publish it or kept writing it
+    bool status(RpuStatus* out) const;
+    // SHM_FEAT_* granted so far; picks up the answer to a request
+    uint32_t active();
+    // Ask for features without waiting; the grant shows in active()
+    void request_features(uint32_t want);
+    // Ask for features and wait for the grant; false if the RPU did not
+    // answer or does not offer all of them
+    bool negotiate(uint32_t want);
+
+    void doorbell();
+
+    // Append the commands sent from here on to the trace at path, across
+    // reopens; false (errno set) if it cannot be opened
+    bool record(const std::string& path);
+    void stop_recording();
+    bool recording() const { return record_fd_ != -1; }
+
+    // wait_until() that blocks on the reverse IPI after the spin window, for
+    // protocol extensions such as BulkChannel
+    template <typename Pred>
+    bool wait_for(uint64_t start, Pred done, uint64_t* end) {
+        if (!irq_) return wait_until(wait, start, done, end);
+
+        const uint64_t spin_end = start + wait.spin_ns;
+        const uint64_t deadline = start + (uint64_t)wait.timeout_ms * 1000000ULL;
+        for (;;) {
+            bool ok = done();
+            uint64_t now = now_ns();
+            if (ok || now >= deadline) {
+                barrier::acquire();
+                *end = now;
+                return ok;
+            }
+            if (now < spin_end) {
+                cpu_relax();
+            } else {
+                wait_irq(deadline);
+            }
+        }
+    }
+
+    WaitPolicy wait;
+
+private:
+    bool open_dev();
+    bool open_uio();
+    void close_maps();
+    bool open_mem();
+    bool open_host();
+    void wait_irq(uint64_t deadline);
+    uint32_t ring_status(const RingTicket& ticket) const;
+    uint32_t ring_space() const;
+    bool open_abi();
+    void record_cmd(uint32_t mode);
+    void record_ring(const RingCommand* cmds, size_t count);
+    void record_msg(uint32_t opcode, const std::vector<uint32_t>& params);
+
+    int dev_fd_ = -1;   // /dev/rpu_ipi when the kernel module owns the doorbell
+    UioDevice uio_ipi_;  // APU IPI registers and interrupt
+    UioDevice uio_shm_;  // Shared window of the core
+    UioDevice uio_msg_;  // RPU0 window holding RPU1's message buffers
+    UioDevice uio_tcm_;  // TCM window of the core, when the firmware redirects
+    bool irq_ = false;
+    bool host_ = false;  // Host files: futex doorbell and reverse IPI
+    uint32_t irq_count_ = 0;
+    MemMap shm_;
+    MemMap ipi_;        // APU IPI registers (/dev/mem only)
+    MemMap msg_ram_;    // IPI message RAM, when it is not the shared window
+    volatile uint32_t* msg_req_ = nullptr;   // IPI request buffer (header, parameters)
+    volatile uint32_t* msg_resp_ = nullptr;  // IPI response buffer (header, status, results)
+    volatile rpu_shm_desc* ring_desc_ = nullptr;
+    volatile rpu_shm_desc* urgent_desc_ = nullptr;
+    uint32_t seq_ = 0;      // Sequence number of the last legacy command
+    uint16_t msg_seq_ = 0;  // Sequence number of the last IPI message
+    uint32_t abi_version_ = 0;
+    uint32_t features_ = SHM_ABI_V0_FEATURES;
+    uint32_t active_ = 0;
+    uint32_t abi_req_seq_ = 0;   // Request waiting for its grant
+    bool abi_pending_ = false;
+    uint32_t head_ = 0;     // Local copy of the producer index
+    uint32_t urgent_head_ = 0;  // ...of the urgent ring
+    uint32_t retired_ = 0;  // Descriptors below this index had their slot reused
+    std::vector<std::pair<uint32_t, uint32_t>> failed_;  // Their failures (index, status)
+    std::vector<RingCommand> batch_;  // Commands of send_batch()
+    int record_fd_ = -1;  // Command trace (cmd_trace.h)
+    unsigned core_ = 0;
+    IpiBackend backend_ = IPI_BACKEND_AUTO;
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_IPI_TRANSPORT_H */
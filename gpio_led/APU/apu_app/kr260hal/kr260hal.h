@@ -0,0 +1,63 @@
+/*
+ * libkr260hal: APU-side access to the KR260 RPU firmware and PL.
+ *
+ * Shared by apu_app, ipi_app, fw_loader, rpu_trace, rpu_stats and rpu_clock,
+ * and meant to be linked into control processes that talk to the RPU
+ * directly instead of spawning those tools:
+ *
+ *   reg.h            Reg<Offset, Type, Window, Access>, Field<Reg, Shift, Width>:
+ *                    compile-time register offsets, access and bit fields
+ *   barrier.h        Outer shareable barriers towards the RPU and the PL
+ *   mem_map.h        MemMap: RAII /dev/mem or device mapping, typed accessors
+ *   hw_regs.h        Registers of the PL blocks, IPI, AXI GPIO and AXI INTC
+ *                    (generated, build_utils/regmap)
+ *   shm_regs.h       Registers of the shared window (rpu_shm.h)
+ *   ipi_transport.h  IpiTransport: doorbell, CMD/ACK, ring, message, waveform
+ *   sysfs.h          sysfs attribute read/write and state polling
+ *   uio.h            UioDevice: generic-uio mappings and interrupt waits
+ *   bulk.h           BulkChannel: DDR carveout transfers by the RPU's DMA
+ *   rpmsg.h          RpmsgChannel: messages over /dev/rpmsgN (RPU_RPMSG=1)
+ *   mpcmd.h          MpCmdChannel: multi-producer commands to RPU0 (RPU_MPCMD=1)
+ *   ring_client.h    RingClient: non-blocking /dev/rpu_ipi ring client for epoll
+ *                    or io_uring
+ *   event_loop.h     EventLoop: minimal epoll loop for RingClients and other fds
+ *   co_ring.h        CoRing: co_await of ring commands on an EventLoop (C++20,
+ *                    included here only when compiled as C++20)
+ *   pattern.h        Assembler for the RPU's LED pattern programs
+ *   timebase.h       System counter, CLOCK_MONOTONIC offset for the RPU
+ *   rt.h             Core pinning, SCHED_FIFO, mlockall and IRQ affinity
+ *   host_ipi.h       Host files standing in for the window and the IPI block
+ *   host_rpu.h       HostRpu: emulator of the firmware's command protocols
+ *   cmd_trace.h      Command traces: recording and loading APU -> RPU traffic
+ *
+ * Build with apu_app/Makefile (libkr260hal.a) and compile users with
+ * -I apu_app -I common, including "kr260hal/kr260hal.h".
+ */
+
+#ifndef KR260HAL_H
+#define KR260HAL_H
+
+#include "reg.h"
+#include "barrier.h"
+#include "mem_map.h"
+#include "hw_regs.h"
+#include "shm_regs.h"
+#include "ipi_transport.h"
+#include "sysfs.h"
+#include "uio.h"
+#include "bulk.h"
+#include "rpmsg.h"
+#include "mpcmd.h"
+#include "ring_client.h"
+#include "event_loop.h"
+#if defined(__cpp_impl_coroutine)
+#include "co_ring.h"
+#endif
+#include "pattern.h"
+#include "timebase.h"
+#include "rt.h"
+#include "host_ipi.h"
+#include "host_rpu.h"
+#include "cmd_trace.h"
+
+#endif /* KR260HAL_H */
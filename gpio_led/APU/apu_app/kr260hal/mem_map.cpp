@@ -0,0 +1,57 @@
+/*
+ * RAII mapping of a physical or device memory window (see mem_map.h).
+ */
+
+#include "mem_map.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace kr260hal {
+
+MemMap::MemMap(MemMap&& other) noexcept : base_(other.base_), size_(other.size_) {
+    other.base_ = nullptr;
+    other.size_ = 0;
+}
+
+MemMap& MemMap::operator=(MemMap&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        base_ = other.base_;
+        size_ = other.size_;
+        other.base_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+bool MemMap::map_phys(uintptr_t phys, size_t size, bool writable) {
+    int fd = open("/dev/mem", (writable ? O_RDWR : O_RDONLY) | O_SYNC);
+    if (fd == -1) return false;
+
+    bool ok = map_fd(fd, (off_t)phys, size, writable);
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return ok;
+}
+
+bool MemMap::map_fd(int fd, off_t offset, size_t size, bool writable) {
+    unmap();
+    void* base = mmap(nullptr, size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, offset);
+    if (base == MAP_FAILED) return false;
+
+    base_ = static_cast<volatile uint8_t*>(base);
+    size_ = size;
+    return true;
+}
+
+void MemMap::unmap() {
+    if (base_ != nullptr) munmap(const_cast<uint8_t*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+}
+
+} // namespace kr260hal
@@ -0,0 +1,90 @@
+/*
+ * RAII mapping of a physical or device memory window (kr260hal).
+ *
+ * map_phys() maps physical memory through /dev/mem with O_SYNC, which gives
+ * a non-cached (device) mapping on ZynqMP; map_fd() maps a driver's window
+ * such as /dev/rpu_ipi. The file descriptor is not kept: the mapping stays
+ * valid until unmap() or destruction. On failure both return false with
+ * errno set, so callers can perror() with their own context.
+ *
+ * write_release() and read_acquire() are the accesses of the protocols
+ * with the RPU: the store that publishes data (a sequence word, a ring
+ * index, a doorbell) after barrier::release(), and the load that observes
+ * completion followed by barrier::acquire() (barrier.h).
+ */
+
+#ifndef KR260HAL_MEM_MAP_H
+#define KR260HAL_MEM_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "barrier.h"
+#include "reg.h"
+
+namespace kr260hal {
+
+class MemMap {
+public:
+    MemMap() = default;
+    ~MemMap() { unmap(); }
+
+    MemMap(const MemMap&) = delete;
+    MemMap& operator=(const MemMap&) = delete;
+    MemMap(MemMap&& other) noexcept;
+    MemMap& operator=(MemMap&& other) noexcept;
+
+    bool map_phys(uintptr_t phys, size_t size, bool writable = true);
+    bool map_fd(int fd, off_t offset, size_t size, bool writable = true);
+    void unmap();
+
+    bool valid() const { return base_ != nullptr; }
+    size_t size() const { return size_; }
+    volatile uint8_t* base() const { return base_; }
+
+    template <typename T = uint32_t>
+    volatile T* at(size_t offset) const {
+        return reinterpret_cast<volatile T*>(base_ + offset);
+    }
+
+    template <class R>
+    typename R::type read() const {
+        static_assert(R::readable, "write-only register");
+        return *at<typename R::type>(R::offset);
+    }
+
+    template <class R>
+    void write(typename R::type value) const {
+        static_assert(R::writable, "read-only register");
+        *at<typename R::type>(R::offset) = value;
+    }
+
+    // Later accesses see what the other side wrote before R
+    template <class R>
+    typename R::type read_acquire() const {
+        typename R::type value = read<R>();
+        barrier::acquire();
+        return value;
+    }
+
+    // Earlier stores are observed before R
+    template <class R>
+    void write_release(typename R::type value) const {
+        barrier::release();
+        write<R>(value);
+    }
+
+    template <class F>
+    typename F::type read_field() const {
+        return F::get(read<typename F::reg>());
+    }
+
+private:
+    volatile uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_MEM_MAP_H */
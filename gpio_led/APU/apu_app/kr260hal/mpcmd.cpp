@@ -0,0 +1,119 @@
+/*
+ * APU side of the multi-producer command channel (see mpcmd.h,
+ * common/rpu_shm.h).
+ *
+ * The claim's LDXR/STXR go to a Device mapping of OCM, whose controller
+ * monitors exclusive accesses for every master; the A53 passes exclusives
+ * to non-cacheable memory to that global monitor.
+ */
+
+#include "mpcmd.h"
+#include "rpu_mpcmd_queue.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+namespace kr260hal {
+
+bool MpCmdChannel::open(IpiTransport& ipi) {
+    close();
+    if (!ipi.is_open() || ipi.core() != 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (!block_.map_phys(MPCMD_ADDR, MPCMD_SIZE)) return false;
+    if (*block_.at(MPCMD_MAGIC_OFFSET) != MPCMD_MAGIC ||
+        *block_.at(MPCMD_SLOTS_OFFSET) != MPCMD_SLOTS) {
+        close();
+        errno = ENODEV;
+        return false;
+    }
+
+    ipi_ = &ipi;
+    source_ = (uint32_t)getpid();
+    doorbells_ = 0;
+    skipped_ = 0;
+    return true;
+}
+
+void MpCmdChannel::close() {
+    block_.unmap();
+    ipi_ = nullptr;
+}
+
+int MpCmdChannel::post(uint32_t opcode, uint32_t arg, uint32_t& pos) {
+    return rpu_mpcmd_post(block_.base(), opcode, arg, source_, &pos);
+}
+
+void MpCmdChannel::kick() {
+    if (rpu_mpcmd_need_doorbell(block_.base())) {
+        ipi_->doorbell();
+        doorbells_++;
+    } else {
+        skipped_++;
+    }
+}
+
+uint32_t MpCmdChannel::status(uint32_t pos) const {
+    return rpu_mpcmd_status(block_.base(), pos);
+}
+
+IpiResult MpCmdChannel::send(uint32_t opcode, uint32_t arg) {
+    return send_batch(opcode, std::vector<uint32_t>(1, arg));
+}
+
+/*
+ * Post every command, one doorbell per run of successful posts; when the
+ * queue is full, kick and wait for RPU0 to free a slot (a contended claim
+ * just retries). result.rtt_us runs from the first post to the last status.
+ */
+IpiResult MpCmdChannel::send_batch(uint32_t opcode, const std::vector<uint32_t>& args) {
+    IpiResult result;
+    std::vector<uint32_t> posted;
+    uint64_t start = now_ns();
+    uint64_t end = start;
+    size_t next = 0;
+
+    result.acked = true;
+    while (next < args.size()) {
+        uint32_t pos;
+        int ret = post(opcode, args[next], pos);
+        if (ret == RPU_MPCMD_OK) {
+            posted.push_back(pos);
+            next++;
+            continue;
+        }
+
+        kick();
+        if (ret == RPU_MPCMD_FULL) {
+            // Wait for RPU0 to free a slot, whichever producer's it was
+            const uint32_t tail = *block_.at(MPCMD_TAIL_OFFSET);
+            if (!ipi_->wait_for(now_ns(), [&] { return *block_.at(MPCMD_TAIL_OFFSET) != tail; },
+                                &end)) {
+                result.acked = false;
+                break;
+            }
+        }
+    }
+    if (!posted.empty()) kick();
+
+    // Statuses in position order: the RPU consumes in that order
+    result.ack_val = RPU_CMD_STATUS_OK;
+    for (uint32_t pos : posted) {
+        uint32_t st = RPU_CMD_STATUS_PENDING;
+        if (!ipi_->wait_for(start, [&] { return (st = status(pos)) != RPU_CMD_STATUS_PENDING; },
+                            &end)) {
+            result.acked = false;
+            break;
+        }
+        if (st != RPU_CMD_STATUS_OK && result.ack_val == RPU_CMD_STATUS_OK) {
+            result.ack_val = st;
+            result.acked = false;
+        }
+    }
+    result.rtt_us = (end - start) / 1000.0;
+    return result;
+}
+
+} // namespace kr260hal
@@ -0,0 +1,72 @@
+/*
+ * APU side of the multi-producer command channel (kr260hal).
+ *
+ * MpCmdChannel maps the MPCMD block in OCM (common/rpu_shm.h) and queues
+ * RPU_CMD_* commands for the RPU0 firmware built with RPU_MPCMD=1. Unlike
+ * the command ring any number of processes, each with its own channel, may
+ * post at the same time: a post claims its slot with one compare-and-swap
+ * (common/rpu_mpcmd_queue.h) and rings the doorbell only when RPU0 is not
+ * polling already.
+ *
+ *   post()   queue one command, without waiting
+ *   send()   post() and wait for its status
+ *   send_batch()  post a batch behind one doorbell and wait for all of it
+ *
+ * The doorbell and waits go through the IpiTransport of RPU0 the channel is
+ * opened on; use it with the UIO or /dev/mem backend, since /dev/rpu_ipi
+ * admits one process only. The block is mapped through /dev/mem (root).
+ */
+
+#ifndef KR260HAL_MPCMD_H
+#define KR260HAL_MPCMD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "rpu_shm.h"
+#include "ipi_transport.h"
+#include "mem_map.h"
+
+namespace kr260hal {
+
+class MpCmdChannel {
+public:
+    MpCmdChannel() = default;
+
+    MpCmdChannel(const MpCmdChannel&) = delete;
+    MpCmdChannel& operator=(const MpCmdChannel&) = delete;
+
+    // Maps the block; false (errno set) if that failed, ENODEV when the
+    // firmware does not serve the channel, EINVAL for a transport of RPU1
+    bool open(IpiTransport& ipi);
+    void close();
+
+    bool is_open() const { return block_.valid(); }
+
+    // RPU_MPCMD_OK with the position in pos, RPU_MPCMD_FULL or RPU_MPCMD_BUSY;
+    // ring the doorbell with kick() unless several posts share one
+    int post(uint32_t opcode, uint32_t arg, uint32_t& pos);
+    void kick();
+    // RPU_CMD_STATUS_* of a posted command (RPU_MPCMD_STATUS_UNKNOWN when
+    // its status was overwritten before it was read)
+    uint32_t status(uint32_t pos) const;
+
+    // result.ack_val is the RPU_CMD_STATUS_* (first failure for a batch)
+    IpiResult send(uint32_t opcode, uint32_t arg);
+    IpiResult send_batch(uint32_t opcode, const std::vector<uint32_t>& args);
+
+    // Doorbells rung and skipped because RPU0 was polling, since open()
+    uint32_t doorbells() const { return doorbells_; }
+    uint32_t doorbells_skipped() const { return skipped_; }
+
+private:
+    IpiTransport* ipi_ = nullptr;
+    MemMap block_;
+    uint32_t source_ = 0;    // Process id, traced by the RPU
+    uint32_t doorbells_ = 0;
+    uint32_t skipped_ = 0;
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_MPCMD_H */
@@ -0,0 +1,112 @@
+/*
+ * Assembler for RPU LED pattern programs (see pattern.h,
+ * common/rpu_pattern_prog.h).
+ *
+ * Operands are checked against the same limits as the firmware's, so a
+ * program that assembles is only refused on the RPU for a wait shorter
+ * than its tick.
+ */
+
+#include "pattern.h"
+
+#include <cstdlib>
+#include <map>
+#include <sstream>
+
+namespace kr260hal {
+
+namespace {
+
+bool parse_number(const std::string& token, uint32_t max, uint32_t& value) {
+    char* end = nullptr;
+    unsigned long v = std::strtoul(token.c_str(), &end, 0);
+    if (token.empty() || *end != '\0' || v > max) return false;
+    value = (uint32_t)v;
+    return true;
+}
+
+bool is_number(const std::string& token) {
+    char* end = nullptr;
+    std::strtoul(token.c_str(), &end, 0);
+    return !token.empty() && *end == '\0';
+}
+
+} // namespace
+
+bool assemble_pattern(const std::string& src, std::vector<uint32_t>& words, std::string& error) {
+    std::map<std::string, uint32_t> labels;
+    std::istringstream lines(src);
+    std::string line;
+    int lineno = 0;
+
+    words.clear();
+    auto fail = [&](const std::string& what) {
+        error = "line " + std::to_string(lineno) + ": " + what;
+        return false;
+    };
+
+    while (std::getline(lines, line)) {
+        lineno++;
+        line = line.substr(0, line.find('#'));
+        for (char& c : line) {
+            if (c == ';') c = ' ';
+        }
+
+        std::istringstream tokens(line);
+        std::string op, arg;
+        while (tokens >> op) {
+            if (op.size() > 1 && op.back() == ':') {
+                op.pop_back();
+                if (!labels.emplace(op, (uint32_t)words.size()).second) {
+                    return fail("label '" + op + "' defined twice");
+                }
+                continue;
+            }
+            if (words.size() >= RPU_PAT_MAX_WORDS) {
+                return fail("more than " + std::to_string(RPU_PAT_MAX_WORDS) + " instructions");
+            }
+
+            uint32_t value = 0;
+            if (op == "end") {
+                words.push_back(RPU_PAT_INSN(RPU_PAT_END, 0));
+            } else if (op == "set" || op == "toggle" || op == "rand") {
+                if (!(tokens >> arg) || !parse_number(arg, RPU_PAT_VALUE_MASK, value)) {
+                    return fail(op + " needs a value up to " + std::to_string(RPU_PAT_VALUE_MASK));
+                }
+                uint32_t code = (op == "set") ? RPU_PAT_SET : (op == "toggle") ? RPU_PAT_TOGGLE : RPU_PAT_RAND;
+                words.push_back(RPU_PAT_INSN(code, value));
+            } else if (op == "wait") {
+                if (!(tokens >> arg) || !parse_number(arg, RPU_PAT_MAX_WAIT_MS, value) || value == 0) {
+                    return fail("wait needs 1 to " + std::to_string(RPU_PAT_MAX_WAIT_MS) + " ms");
+                }
+                words.push_back(RPU_PAT_INSN(RPU_PAT_WAIT, value));
+            } else if (op == "loop") {
+                if (!(tokens >> arg)) return fail("loop needs a label");
+                auto label = labels.find(arg);
+                if (label == labels.end()) {
+                    return fail("loop to '" + arg + "', not a label before it");
+                }
+                uint32_t count = 0;
+                std::streampos pos = tokens.tellg();
+                std::string next;
+                if (tokens >> next) {
+                    if (!is_number(next)) {
+                        tokens.seekg(pos);
+                    } else if (!parse_number(next, RPU_PAT_MAX_LOOP, count) || count == 0) {
+                        return fail("loop count must be 1 to " + std::to_string(RPU_PAT_MAX_LOOP));
+                    }
+                }
+                words.push_back(RPU_PAT_LOOP_INSN(count, label->second));
+            } else {
+                return fail("unknown instruction '" + op + "'");
+            }
+        }
+    }
+    if (words.empty()) {
+        error = "empty program";
+        return false;
+    }
+    return true;
+}
+
+} // namespace kr260hal
@@ -0,0 +1,37 @@
+/*
+ * Assembler for RPU LED pattern programs (kr260hal).
+ *
+ * Turns the text form of a program into the instruction words of
+ * common/rpu_pattern_prog.h, for IpiTransport::send_pattern(). One
+ * instruction per line or separated by ';', '#' starts a comment:
+ *
+ *   set <value>          LEDs = value
+ *   toggle <mask>        LEDs ^= mask
+ *   rand <mask>          LEDs = random value & mask
+ *   wait <ms>            hold for ms (at least one RPU tick)
+ *   <label>:             names the next instruction
+ *   loop <label> [n]     back to label until it ran n times, forever without n
+ *   end                  stop, the previous blink mode resumes
+ *
+ * For example "set 1; again: wait 100; toggle 3; loop again 10; end" blinks
+ * the two LEDs in turn ten times. Numbers take C prefixes (0x...), labels
+ * must come before the loops that use them.
+ */
+
+#ifndef KR260HAL_PATTERN_H
+#define KR260HAL_PATTERN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rpu_pattern_prog.h"
+
+namespace kr260hal {
+
+// Assemble src into words; false with a "line N: ..." message in error
+bool assemble_pattern(const std::string& src, std::vector<uint32_t>& words, std::string& error);
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_PATTERN_H */
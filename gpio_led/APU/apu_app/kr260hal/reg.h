@@ -0,0 +1,63 @@
+/*
+ * Typed register descriptors for memory-mapped windows (kr260hal).
+ *
+ * A register is a type carrying its offset, value type and access, so
+ * accesses through MemMap::read<R>() / write<R>() compile to a single
+ * volatile load or store at a constant offset, and a write to a read-only
+ * register (or a read of a write-only one) does not compile. With a window
+ * size the offset is checked at compile time as well:
+ *
+ *   using Ack = Reg<SHM_ACK_OFFSET, uint32_t, SHARED_MEM_SIZE>;
+ *   uint32_t ack = shm.read<Ack>();
+ *
+ * A Field is a bit range of a register:
+ *
+ *   using CtrlEnable = Field<Ctrl, 0>;
+ *   gen.write<Ctrl>(CtrlEnable::make(1));
+ *   bool on = gen.read_field<CtrlEnable>();
+ */
+
+#ifndef KR260HAL_REG_H
+#define KR260HAL_REG_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kr260hal {
+
+enum class Access {
+    RW,
+    RO,  // Status and counters
+    WO,  // Triggers, set/clear registers
+};
+
+template <size_t Offset, typename T = uint32_t, size_t Window = 0, Access A = Access::RW>
+struct Reg {
+    using type = T;
+    static constexpr size_t offset = Offset;
+    static constexpr bool readable = A != Access::WO;
+    static constexpr bool writable = A != Access::RO;
+
+    static_assert(Offset % alignof(T) == 0, "misaligned register");
+    static_assert(Window == 0 || Offset + sizeof(T) <= Window, "register outside its window");
+};
+
+template <class R, unsigned Shift, unsigned Width = 1>
+struct Field {
+    using reg = R;
+    using type = typename R::type;
+    static constexpr unsigned bits = sizeof(type) * 8;
+    static constexpr unsigned shift = Shift;
+    static constexpr type mask =
+        (Width >= bits ? type(~type(0)) : type((type(1) << (Width % bits)) - 1)) << Shift;
+
+    static_assert(Width > 0 && Shift + Width <= bits, "field outside its register");
+
+    static constexpr type get(type value) { return (value & mask) >> Shift; }
+    static constexpr type make(type value) { return type(value << Shift) & mask; }
+    static constexpr type update(type old, type value) { return (old & ~mask) | make(value); }
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_REG_H */
@@ -0,0 +1,91 @@
+/*
+ * Event-driven client of the rpu_ipi command ring (see ring_client.h).
+ */
+
+#include "ring_client.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace kr260hal {
+
+// Records per read() or write(), the size of the module's client queues
+static constexpr size_t RING_CLIENT_CHUNK = 2 * SHM_RING_SLOTS;
+
+bool RingClient::open() {
+    close();
+    fd_ = ::open("/dev/" RPU_IPI_DEV_NAME, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ == -1) return false;
+    buf_.resize(RING_CLIENT_CHUNK);
+    return true;
+}
+
+void RingClient::close() {
+    if (fd_ != -1) ::close(fd_);
+    fd_ = -1;
+    backlog_.clear();
+    next_seq_ = 0;
+    completed_ = 0;
+}
+
+uint32_t RingClient::submit(const RingCommand* cmds, size_t count) {
+    const uint32_t first = next_seq_;
+
+    for (size_t i = 0; i < count; i++) {
+        backlog_.push_back(rpu_ipi_cmd{cmds[i].opcode, cmds[i].arg, next_seq_++,
+                                       RPU_CMD_STATUS_PENDING});
+    }
+    // Straight to the module while it has room; errors surface in handle()
+    if (fd_ != -1) flush();
+    return first;
+}
+
+// Writes the backlog until the submission queue is full
+bool RingClient::flush() {
+    while (!backlog_.empty()) {
+        size_t n = std::min(backlog_.size(), RING_CLIENT_CHUNK);
+        std::copy(backlog_.begin(), backlog_.begin() + n, buf_.begin());
+
+        ssize_t written = ::write(fd_, buf_.data(), n * sizeof(rpu_ipi_cmd));
+        if (written < 0) return errno == EAGAIN;
+        backlog_.erase(backlog_.begin(), backlog_.begin() + written / sizeof(rpu_ipi_cmd));
+    }
+    return true;
+}
+
+// Reads completions until the completion queue is empty
+bool RingClient::drain() {
+    for (;;) {
+        ssize_t n = ::read(fd_, buf_.data(), buf_.size() * sizeof(rpu_ipi_cmd));
+        if (n < 0) return errno == EAGAIN;
+        complete(buf_.data(), n / sizeof(rpu_ipi_cmd));
+    }
+}
+
+void RingClient::complete(const rpu_ipi_cmd* done, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        completed_++;
+        if (on_complete) on_complete(done[i]);
+    }
+}
+
+/*
+ * Completions first: reading them frees completion queue space, which is
+ * what lets the module take more of this client's commands.
+ */
+bool RingClient::handle(uint32_t revents) {
+    if (fd_ == -1) {
+        errno = EBADF;
+        return false;
+    }
+    if (revents & EPOLLERR) {
+        errno = EIO;
+        return false;
+    }
+    if (!drain()) return false;
+    return flush();
+}
+
+} // namespace kr260hal
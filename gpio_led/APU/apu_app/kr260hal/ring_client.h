@@ -0,0 +1,98 @@
+/*
+ * Event-driven client of the rpu_ipi command ring (kr260hal).
+ *
+ * A RingClient is a non-blocking /dev/rpu_ipi file (common/rpu_ipi_ioctl.h)
+ * meant for a single-threaded event loop that also serves sockets and
+ * timers: submit() never sleeps, commands the module's submission queue
+ * cannot take yet stay in a local backlog, and completions are handed to
+ * on_complete as the loop reports the file readable.
+ *
+ *   fd(), EVENTS     register with epoll (edge-triggered, EPOLLIN and
+ *                    EPOLLOUT) once, no re-arming as the backlog changes
+ *   handle(revents)  on every event: flushes the backlog, drains completions
+ *   complete()       completion records read by other means, e.g. an
+ *                    io_uring IORING_OP_READ on fd()
+ *
+ * The module wakes the file's waiters on every reverse IPI (or poll tick
+ * without one) and whenever a client frees queue space, so with EPOLLET a
+ * wakeup that leaves work behind cannot be lost as long as handle() runs
+ * until EAGAIN, which it does. io_uring needs no support from the module:
+ * a read of a pollable file that would block is parked on its poll queue
+ * and completes with the records, which go to complete().
+ *
+ * Sequence numbers are those of the module, counted per file from 0 in
+ * submission order; completions come back in the same order. EventLoop
+ * (event_loop.h) is a minimal epoll loop to drive one or more clients.
+ * A client is not thread safe.
+ */
+
+#ifndef KR260HAL_RING_CLIENT_H
+#define KR260HAL_RING_CLIENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include <sys/epoll.h>
+
+#include "rpu_ipi_ioctl.h"
+#include "ipi_transport.h"
+
+namespace kr260hal {
+
+class RingClient {
+public:
+    // epoll events of fd()
+    static constexpr uint32_t EVENTS = EPOLLIN | EPOLLOUT | EPOLLET;
+
+    RingClient() = default;
+    ~RingClient() { close(); }
+
+    RingClient(const RingClient&) = delete;
+    RingClient& operator=(const RingClient&) = delete;
+
+    // Opens /dev/rpu_ipi (RPU0 only); false (errno set) if that failed
+    bool open();
+    void close();
+
+    bool is_open() const { return fd_ != -1; }
+    int fd() const { return fd_; }
+
+    // Queues commands; returns the sequence number of the first one. What
+    // the module does not take now is sent by later handle() calls, which
+    // also report a failed write
+    uint32_t submit(const RingCommand* cmds, size_t count);
+    uint32_t submit(const std::vector<RingCommand>& cmds) {
+        return submit(cmds.data(), cmds.size());
+    }
+
+    // Events of fd() as reported by epoll_wait(); false on an error of the
+    // file (errno set), for example EBUSY while the window is mmap()ed
+    bool handle(uint32_t revents);
+    // Completions read from fd() outside handle()
+    void complete(const rpu_ipi_cmd* done, size_t count);
+
+    // Commands in the backlog, not yet accepted by the module
+    size_t backlog() const { return backlog_.size(); }
+    // Commands submitted and not completed yet, backlog included
+    uint32_t outstanding() const { return next_seq_ - completed_; }
+
+    // Called for each completion, cmd.status is RPU_CMD_STATUS_*
+    std::function<void(const rpu_ipi_cmd& cmd)> on_complete;
+
+private:
+    bool flush();
+    bool drain();
+
+    int fd_ = -1;
+    std::deque<rpu_ipi_cmd> backlog_;
+    std::vector<rpu_ipi_cmd> buf_;
+    uint32_t next_seq_ = 0;   // Of the next submit()
+    uint32_t completed_ = 0;  // Completions handed out
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_RING_CLIENT_H */
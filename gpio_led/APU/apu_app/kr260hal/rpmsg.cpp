@@ -0,0 +1,203 @@
+/*
+ * APU side of the RPMsg transport (see rpmsg.h, common/rpu_shm.h).
+ */
+
+#include "rpmsg.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "sysfs.h"
+
+namespace kr260hal {
+
+static const char RPMSG_CLASS_DIR[] = "/sys/class/rpmsg/";
+static const char RPMSG_CORE_PREFIX[] = "/remoteproc";  // remoteproc<n> is R5 core n in split mode
+
+/*
+ * The endpoint devices (rpmsgN, not rpmsg_ctrlN) carry the channel name and
+ * the remote address; their sysfs path runs through the remoteproc device
+ * of the core that announced the channel.
+ */
+bool RpmsgChannel::open(unsigned core) {
+    close();
+    if (core >= RPU_CORE_COUNT) {
+        errno = EINVAL;
+        return false;
+    }
+
+    DIR* dir = opendir(RPMSG_CLASS_DIR);
+    if (dir == nullptr) return false;
+
+    const std::string core_dir = RPMSG_CORE_PREFIX + std::to_string(core) + "/";
+    std::string dev_name;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name, dst;
+        std::string candidate = entry->d_name;
+        if (candidate.compare(0, 5, "rpmsg") != 0 || candidate.compare(0, 10, "rpmsg_ctrl") == 0) {
+            continue;
+        }
+        const std::string attr_dir = RPMSG_CLASS_DIR + candidate;
+        if (!sysfs_read(attr_dir + "/name", name) || name != RPU_RPMSG_CMD_NAME) continue;
+        if (!sysfs_read(attr_dir + "/dst", dst) ||
+            std::strtoul(dst.c_str(), nullptr, 0) != RPU_RPMSG_CMD_ADDR) {
+            continue;
+        }
+
+        char real[PATH_MAX];
+        if (realpath(attr_dir.c_str(), real) != nullptr &&
+            std::string(real).find(core_dir) != std::string::npos) {
+            dev_name = candidate;
+            break;
+        }
+    }
+    closedir(dir);
+
+    if (dev_name.empty()) {
+        errno = ENODEV;
+        return false;
+    }
+    dev_path_ = "/dev/" + dev_name;
+    fd_ = ::open(dev_path_.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd_ == -1) {
+        dev_path_.clear();
+        return false;
+    }
+    core_ = core;
+    return true;
+}
+
+void RpmsgChannel::close() {
+    if (fd_ != -1) ::close(fd_);
+    fd_ = -1;
+    dev_path_.clear();
+}
+
+// One write() is one RPMsg message
+bool RpmsgChannel::write_payload(const std::vector<uint32_t>& payload) {
+    const size_t len = payload.size() * sizeof(uint32_t);
+    ssize_t ret;
+    do {
+        ret = ::write(fd_, payload.data(), len);
+    } while (ret == -1 && errno == EINTR);
+    return ret == (ssize_t)len;
+}
+
+// One read() returns one RPMsg message; payload is resized to it
+bool RpmsgChannel::read_payload(std::vector<uint32_t>& payload, uint64_t deadline) {
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= deadline) {
+            errno = ETIMEDOUT;
+            return false;
+        }
+        int ret = poll(&pfd, 1, (int)((deadline - now + 999999) / 1000000));
+        if (ret == -1 && errno == EINTR) continue;
+        if (ret <= 0) {
+            if (ret == 0) errno = ETIMEDOUT;
+            return false;
+        }
+        break;
+    }
+
+    payload.resize(RPU_RPMSG_BATCH_MAX * SHM_IPI_MSG_WORDS);
+    ssize_t ret;
+    do {
+        ret = ::read(fd_, payload.data(), payload.size() * sizeof(uint32_t));
+    } while (ret == -1 && errno == EINTR);
+    if (ret < 0) return false;
+    payload.resize(ret / sizeof(uint32_t));
+    return true;
+}
+
+IpiResult RpmsgChannel::send_msg(uint32_t opcode, const std::vector<uint32_t>& params,
+                                 uint32_t* results) {
+    IpiResult result;
+    if (!is_open() || params.size() > SHM_IPI_MSG_DATA_WORDS) {
+        result.ack_val = RPU_CMD_STATUS_BADARG;
+        return result;
+    }
+
+    std::vector<uint32_t> payload(SHM_IPI_MSG_WORDS, 0);
+    const uint32_t hdr = RPU_MSG_HDR(opcode, params.size(), ++seq_);
+    payload[0] = hdr;
+    for (size_t i = 0; i < params.size(); i++) payload[1 + i] = params[i];
+
+    uint64_t start = now_ns();
+    uint64_t deadline = start + (uint64_t)wait.timeout_ms * 1000000ULL;
+    std::vector<uint32_t> reply;
+    result.acked = write_payload(payload) && read_payload(reply, deadline) &&
+                   reply.size() >= SHM_IPI_MSG_WORDS && reply[0] == hdr;
+    uint64_t end = now_ns();
+
+    if (result.acked) {
+        result.ack_val = reply[1];
+        for (uint32_t i = 0; i < RPU_MSG_MAX_RESULTS; i++) results[i] = reply[2 + i];
+        if (result.ack_val != RPU_CMD_STATUS_OK) result.acked = false;
+    }
+    result.rtt_us = (end - start) / 1000.0;
+    return result;
+}
+
+/*
+ * Pack the commands RPU_RPMSG_BATCH_MAX to a payload and write all payloads
+ * first, so the RPU can work through one while the next is in flight; the
+ * replies then come back in order, one per payload.
+ */
+IpiResult RpmsgChannel::send_batch(uint32_t opcode, const std::vector<uint32_t>& args) {
+    IpiResult result;
+    if (!is_open() || args.empty()) {
+        result.ack_val = RPU_CMD_STATUS_BADARG;
+        return result;
+    }
+
+    uint64_t start = now_ns();
+    std::vector<uint32_t> headers;
+    std::vector<uint32_t> payload;
+    headers.reserve(args.size());
+    result.acked = true;
+    for (size_t next = 0; next < args.size() && result.acked;) {
+        payload.clear();
+        for (uint32_t n = 0; n < RPU_RPMSG_BATCH_MAX && next < args.size(); n++, next++) {
+            const uint32_t hdr = RPU_MSG_HDR(opcode, 1, ++seq_);
+            headers.push_back(hdr);
+            payload.push_back(hdr);
+            payload.push_back(args[next]);
+            payload.resize(payload.size() + SHM_IPI_MSG_WORDS - 2, 0);
+        }
+        result.acked = write_payload(payload);
+    }
+
+    uint64_t deadline = start + (uint64_t)wait.timeout_ms * 1000000ULL;
+    result.ack_val = RPU_CMD_STATUS_OK;
+    std::vector<uint32_t> reply;
+    for (size_t done = 0; done < headers.size() && result.acked;) {
+        if (!read_payload(reply, deadline)) {
+            result.acked = false;
+            break;
+        }
+        for (size_t i = 0; i + SHM_IPI_MSG_WORDS <= reply.size() && done < headers.size();
+             i += SHM_IPI_MSG_WORDS, done++) {
+            if (reply[i] != headers[done]) {
+                result.acked = false;
+                break;
+            }
+            if (reply[i + 1] != RPU_CMD_STATUS_OK && result.ack_val == RPU_CMD_STATUS_OK) {
+                result.ack_val = reply[i + 1];
+            }
+        }
+    }
+    uint64_t end = now_ns();
+
+    if (result.ack_val != RPU_CMD_STATUS_OK) result.acked = false;
+    result.rtt_us = (end - start) / 1000.0;
+    return result;
+}
+
+} // namespace kr260hal
@@ -0,0 +1,70 @@
+/*
+ * APU side of the RPMsg transport (kr260hal).
+ *
+ * With the firmware built with RPU_RPMSG=1 (RPU/gpio_app/src/rpu_rpmsg.h),
+ * Linux remoteproc brings up the virtio rings in RPMSG_SHM_ADDR_CORE(core)
+ * and the RPU announces the endpoint RPU_RPMSG_CMD_NAME. The rpmsg_char
+ * driver binds that name (Linux 5.18 and later) and exports it as
+ * /dev/rpmsgN; RpmsgChannel opens the node of a core and speaks the message
+ * protocol of common/rpu_shm.h over it:
+ *
+ *   send_msg()    one command with parameters, as IpiTransport::send_msg()
+ *   send_batch()  one command per argument, up to RPU_RPMSG_BATCH_MAX per
+ *                 RPMsg payload, all payloads written before the first reply
+ *                 is read
+ *
+ * The kernel owns the rings, the buffers and the IPI (through the zynqmp
+ * IPI mailbox), so no mapping nor root is needed; the IPI message path of
+ * IpiTransport is not served by such a firmware. Waits block in poll() up
+ * to WaitPolicy::timeout_ms. A channel is not thread safe.
+ */
+
+#ifndef KR260HAL_RPMSG_H
+#define KR260HAL_RPMSG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rpu_shm.h"
+#include "ipi_transport.h"
+
+namespace kr260hal {
+
+class RpmsgChannel {
+public:
+    RpmsgChannel() = default;
+    ~RpmsgChannel() { close(); }
+
+    RpmsgChannel(const RpmsgChannel&) = delete;
+    RpmsgChannel& operator=(const RpmsgChannel&) = delete;
+
+    // Opens the command endpoint of core; false (errno set) if that failed,
+    // ENODEV when the firmware does not announce it
+    bool open(unsigned core = 0);
+    void close();
+
+    bool is_open() const { return fd_ != -1; }
+    unsigned core() const { return core_; }
+    const std::string& device() const { return dev_path_; }
+
+    // results[] receives RPU_MSG_MAX_RESULTS words
+    IpiResult send_msg(uint32_t opcode, const std::vector<uint32_t>& params, uint32_t* results);
+    // result.ack_val is the first failing RPU_CMD_STATUS_*, or OK
+    IpiResult send_batch(uint32_t opcode, const std::vector<uint32_t>& args);
+
+    WaitPolicy wait;
+
+private:
+    bool write_payload(const std::vector<uint32_t>& payload);
+    bool read_payload(std::vector<uint32_t>& payload, uint64_t deadline);
+
+    int fd_ = -1;
+    unsigned core_ = 0;
+    std::string dev_path_;
+    uint16_t seq_ = 0;
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_RPMSG_H */
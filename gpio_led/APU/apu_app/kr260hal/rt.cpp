@@ -0,0 +1,111 @@
+/*
+ * Real-time setup (see rt.h).
+ */
+
+#include "rt.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "sysfs.h"
+
+namespace kr260hal {
+
+static const char CPU_ISOLATED[] = "/sys/devices/system/cpu/isolated";
+static const char RPU_IPI_ACK_IRQ[] = "/sys/module/rpu_ipi/parameters/ack_irq";
+static const char UIO_IPI_NAME[] = "rpu-ipi";   // APU/dts/rpu_uio.dtso
+
+// Whether 'cpu' is in a cpulist such as "2-3,5"
+static bool cpulist_has(const std::string& list, int cpu) {
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        char* end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        long last = (*end == '-') ? std::strtol(end + 1, nullptr, 10) : first;
+        if (cpu >= first && cpu <= last) return true;
+    }
+    return false;
+}
+
+// Touch the stack once so a deeper call chain later does not page fault
+__attribute__((noinline)) static void prefault_stack() {
+    volatile unsigned char stack[RT_STACK_PREFAULT];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) stack[i] = 0;
+}
+
+bool apply_rt(const RtPolicy& policy, std::string& error, std::string& warning) {
+    warning.clear();
+    if (policy.cpu < 0) return true;
+
+    std::string isolated;
+    if (!sysfs_read(CPU_ISOLATED, isolated) || !cpulist_has(isolated, policy.cpu)) {
+        warning = "core " + std::to_string(policy.cpu) +
+                  " is not isolated (isolcpus=), other tasks may run on it";
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(policy.cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        error = "pinning to core " + std::to_string(policy.cpu);
+        return false;
+    }
+
+    // Steer the IRQs first: they fire on this core as soon as it runs FIFO
+    for (int irq : policy.irqs) {
+        if (!sysfs_write("/proc/irq/" + std::to_string(irq) + "/smp_affinity_list",
+                         std::to_string(policy.cpu))) {
+            error = "setting the affinity of IRQ " + std::to_string(irq);
+            return false;
+        }
+    }
+
+    struct sched_param param = {};
+    param.sched_priority = policy.prio;
+    if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+        error = "switching to SCHED_FIFO " + std::to_string(policy.prio);
+        return false;
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        error = "locking the process memory";
+        return false;
+    }
+    prefault_stack();
+    return true;
+}
+
+std::vector<int> ipi_irqs() {
+    std::vector<int> irqs;
+    std::string value;
+    if (sysfs_read(RPU_IPI_ACK_IRQ, value)) {
+        int irq = std::atoi(value.c_str());
+        if (irq >= 0) irqs.push_back(irq);
+    }
+    int irq = find_irq(UIO_IPI_NAME);
+    if (irq >= 0) irqs.push_back(irq);
+    return irqs;
+}
+
+// Lines look like "  57:   1234  0  0  0  GICv2  61 Level  rpu-ipi"
+int find_irq(const std::string& name) {
+    std::ifstream file("/proc/interrupts");
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t colon = line.find(':');
+        size_t last = line.find_last_of(" \t");
+        if (colon == std::string::npos || last == std::string::npos) continue;
+        if (line.compare(last + 1, std::string::npos, name) != 0) continue;
+        char* end = nullptr;
+        long irq = std::strtol(line.c_str(), &end, 10);
+        if (end != line.c_str() && *end == ':') return (int)irq;
+    }
+    return -1;
+}
+
+} // namespace kr260hal
@@ -0,0 +1,50 @@
+/*
+ * Real-time setup of latency-sensitive APU processes (kr260hal).
+ *
+ * apply_rt() pins the calling process to one A53 core, switches it to
+ * SCHED_FIFO, locks its memory with mlockall() and prefaults its stack, and
+ * steers the given IRQs (the reverse IPI, ipi_irqs()) to the same core, so
+ * the wake-up of a blocked wait neither crosses cores nor queues behind
+ * other tasks. The windows of IpiTransport and MemMap need no prefaulting:
+ * /dev/mem, UIO and /dev/rpu_ipi populate their page tables at mmap() time.
+ *
+ * The core should be kept free of other work, e.g. isolcpus=3 on the kernel
+ * command line; apply_rt() only warns when it is not isolated. The default
+ * priority stays below the threaded IRQ handlers (SCHED_FIFO 50 with
+ * PREEMPT_RT or threadirqs, and the rpu_ipi reverse-IPI thread at its
+ * default ack_irq_prio), which follow their IRQs to the same core. All steps need
+ * root or CAP_SYS_NICE / CAP_IPC_LOCK.
+ */
+
+#ifndef KR260HAL_RT_H
+#define KR260HAL_RT_H
+
+#include <string>
+#include <vector>
+
+namespace kr260hal {
+
+constexpr int RT_PRIO_DEFAULT = 49;                  // Below the threaded IRQs
+constexpr size_t RT_STACK_PREFAULT = 256 * 1024;     // Stack depth touched once
+
+struct RtPolicy {
+    int cpu = -1;              // Core to run on, -1: leave the process as it is
+    int prio = RT_PRIO_DEFAULT;
+    std::vector<int> irqs;     // IRQs to steer to 'cpu'
+};
+
+// Applies the policy to the calling process. Returns false with 'error'
+// naming the failed step (errno set); a non-isolated core only adds a
+// 'warning'.
+bool apply_rt(const RtPolicy& policy, std::string& error, std::string& warning);
+
+// Linux IRQs of the reverse IPI from the RPU: the ack_irq of the rpu_ipi
+// module and the rpu-ipi UIO node, whichever are in use
+std::vector<int> ipi_irqs();
+
+// IRQ of the /proc/interrupts line whose handler is named 'name', -1 if none
+int find_irq(const std::string& name);
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_RT_H */
@@ -0,0 +1,138 @@
+/*
+ * Typed registers of the APU <-> RPU shared window (kr260hal). The layout
+ * itself is defined once, in common/rpu_shm.h; the APU IPI channel registers
+ * (ipi::) come with the other hardware registers from hw_regs.h. handoff::
+ * is the hot-swap block of a core, mapped on its own.
+ *
+ * shm_window_addr() is where to map a core's window: the default one or,
+ * with the TCM variant of the firmware, the BTCM one its redirect names.
+ */
+
+#ifndef KR260HAL_SHM_REGS_H
+#define KR260HAL_SHM_REGS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rpu_shm.h"
+#include "hw_regs.h"
+#include "reg.h"
+
+namespace kr260hal {
+
+namespace shm {
+
+template <size_t Offset>
+using Word = Reg<Offset, uint32_t, SHARED_MEM_SIZE>;
+
+// Legacy CMD/ACK words
+using Cmd        = Word<SHM_CMD_OFFSET>;
+using Ack        = Word<SHM_ACK_OFFSET>;
+using Seq        = Word<SHM_SEQ_OFFSET>;
+using AckSeq     = Word<SHM_ACK_SEQ_OFFSET>;
+using ApuFlags   = Word<SHM_APU_FLAGS_OFFSET>;
+
+// ABI request (APU's line) and header (RPU's line)
+using AbiReq       = Word<SHM_ABI_REQ_OFFSET>;
+using AbiReqSeq    = Word<SHM_ABI_REQ_SEQ_OFFSET>;
+using AbiMagic     = Word<SHM_ABI_MAGIC_OFFSET>;
+using AbiVersion   = Word<SHM_ABI_VERSION_OFFSET>;
+using AbiFeatures  = Word<SHM_ABI_FEATURES_OFFSET>;
+using AbiActive    = Word<SHM_ABI_ACTIVE_OFFSET>;
+using AbiGrantSeq  = Word<SHM_ABI_GRANT_SEQ_OFFSET>;
+using AbiAckSeq    = Word<SHM_ABI_ACK_SEQ_OFFSET>;
+using AbiAck       = Word<SHM_ABI_ACK_OFFSET>;
+
+// Redirect to the TCM window (default window only)
+using RedirectMagic = Word<SHM_REDIRECT_MAGIC_OFFSET>;
+using RedirectAddr  = Word<SHM_REDIRECT_ADDR_OFFSET>;
+
+// Ready word (default window only)
+using Ready         = Word<SHM_READY_OFFSET>;
+using ReadyVersion  = Word<SHM_READY_VERSION_OFFSET>;
+using ReadyFeatures = Word<SHM_READY_FEATURES_OFFSET>;
+
+// Command ring indices
+using RingHead   = Word<SHM_RING_HEAD_OFFSET>;
+using RingTail   = Word<SHM_RING_TAIL_OFFSET>;
+using RingState  = Word<SHM_RING_STATE_OFFSET>;
+using RingCredit = Word<SHM_RING_CREDIT_OFFSET>;
+using RingRate   = Word<SHM_RING_RATE_OFFSET>;
+
+// Urgent ring indices
+using UrgentHead = Word<SHM_URING_HEAD_OFFSET>;
+using UrgentTail = Word<SHM_URING_TAIL_OFFSET>;
+
+// Status block
+using StatusSeq      = Word<SHM_STATUS_SEQ_OFFSET>;
+using StatusMagic    = Word<SHM_STATUS_MAGIC_OFFSET>;
+using StatusMode     = Word<SHM_STATUS_MODE_OFFSET>;
+using StatusFlags    = Word<SHM_STATUS_FLAGS_OFFSET>;
+using StatusLed      = Word<SHM_STATUS_LED_OFFSET>;
+using StatusStep     = Word<SHM_STATUS_STEP_OFFSET>;
+using StatusFrames   = Word<SHM_STATUS_FRAMES_OFFSET>;
+using StatusCommands = Word<SHM_STATUS_COMMANDS_OFFSET>;
+using StatusStampLo  = Word<SHM_STATUS_STAMP_LO_OFFSET>;
+using StatusStampHi  = Word<SHM_STATUS_STAMP_HI_OFFSET>;
+
+// Waveform header
+using WavePeriod = Word<SHM_WAVE_PERIOD_OFFSET>;
+using WaveCount  = Word<SHM_WAVE_COUNT_OFFSET>;
+using WaveLoops  = Word<SHM_WAVE_LOOPS_OFFSET>;
+using WaveState  = Word<SHM_WAVE_STATE_OFFSET>;
+using WaveDdrOffset = Word<SHM_WAVE_DDR_OFFSET>;
+using WaveUnderrun  = Word<SHM_WAVE_UNDERRUN_OFFSET>;
+
+// Trace header
+using TraceMagic = Word<SHM_TRACE_MAGIC_OFFSET>;
+using TraceHead  = Word<SHM_TRACE_HEAD_OFFSET>;
+
+// Task stats header
+using StatsMagic   = Word<SHM_STATS_MAGIC_OFFSET>;
+using StatsSeq     = Word<SHM_STATS_SEQ_OFFSET>;
+using StatsCount   = Word<SHM_STATS_COUNT_OFFSET>;
+using StatsTotal   = Word<SHM_STATS_TOTAL_OFFSET>;
+using StatsHz      = Word<SHM_STATS_HZ_OFFSET>;
+using StatsTick    = Word<SHM_STATS_TICK_OFFSET>;
+using StatsHeap    = Word<SHM_STATS_HEAP_OFFSET>;
+using StatsHeapMin = Word<SHM_STATS_HEAP_MIN_OFFSET>;
+
+// Time base
+using TimeMagic    = Word<SHM_TIME_MAGIC_OFFSET>;
+using TimeHz       = Word<SHM_TIME_HZ_OFFSET>;
+using SyncMagic    = Word<SHM_SYNC_MAGIC_OFFSET>;
+using SyncSeq      = Word<SHM_SYNC_SEQ_OFFSET>;
+using SyncOffsetLo = Word<SHM_SYNC_OFFSET_LO>;
+using SyncOffsetHi = Word<SHM_SYNC_OFFSET_HI>;
+using SyncError    = Word<SHM_SYNC_ERROR_OFFSET>;
+using SyncTime     = Word<SHM_SYNC_TIME_OFFSET>;
+
+} // namespace shm
+
+class MemMap;
+
+// Physical address of the shared window of core: SHARED_MEM_ADDR_CORE(core),
+// or SHARED_MEM_TCM_ADDR_CORE(core) while its redirect is published. The
+// first form maps the default window for the look-up; the second reads a
+// mapping of it the caller has
+uintptr_t shm_window_addr(unsigned core);
+uintptr_t shm_window_addr(const MemMap& window, unsigned core);
+
+// Hot-swap state block of a core (HANDOFF_ADDR(core), a page of its own)
+namespace handoff {
+
+template <size_t Offset>
+using Word = Reg<Offset, uint32_t, HANDOFF_SIZE>;
+
+using Magic    = Word<HANDOFF_MAGIC_OFFSET>;
+using Version  = Word<HANDOFF_VERSION_OFFSET>;
+using Mode     = Word<HANDOFF_MODE_OFFSET>;
+using Override = Word<HANDOFF_OVERRIDE_OFFSET>;
+using Led      = Word<HANDOFF_LED_OFFSET>;
+using GapUs    = Word<HANDOFF_GAP_US_OFFSET>;
+
+} // namespace handoff
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_SHM_REGS_H */
@@ -0,0 +1,53 @@
+/*
+ * sysfs attribute helpers (see sysfs.h).
+ */
+
+#include "sysfs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <sys/stat.h>
+
+namespace kr260hal {
+
+static const int POLL_MIN_MS = 1;
+static const int POLL_MAX_MS = 20;
+
+bool path_exists(const std::string& path) {
+    struct stat buffer;
+    return stat(path.c_str(), &buffer) == 0;
+}
+
+bool sysfs_read(const std::string& path, std::string& value) {
+    std::ifstream file(path);
+    value.clear();
+    if (!file.is_open()) return false;
+    std::getline(file, value);
+    return !file.bad();
+}
+
+bool sysfs_write(const std::string& path, const std::string& value) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+    file << value;
+    file.flush();
+    return !file.fail();
+}
+
+bool sysfs_wait_for(const std::string& path, const std::string& want, int timeout_ms,
+                    std::string& state) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    int delay_ms = POLL_MIN_MS;
+
+    while (true) {
+        sysfs_read(path, state);
+        if (state == want) return true;
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        delay_ms = std::min(delay_ms * 2, POLL_MAX_MS);
+    }
+}
+
+} // namespace kr260hal
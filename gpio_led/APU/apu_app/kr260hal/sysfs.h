@@ -0,0 +1,27 @@
+/*
+ * sysfs attribute helpers (kr260hal).
+ *
+ * Attributes such as remoteproc<n>/state and fpga_manager/fpga0/state are
+ * read as their first line. The functions return false when the attribute
+ * cannot be opened, read or written; they print nothing.
+ */
+
+#ifndef KR260HAL_SYSFS_H
+#define KR260HAL_SYSFS_H
+
+#include <string>
+
+namespace kr260hal {
+
+bool path_exists(const std::string& path);
+bool sysfs_read(const std::string& path, std::string& value);
+bool sysfs_write(const std::string& path, const std::string& value);
+
+// Polls 'path' until it reads 'want', re-reading after 1 ms and doubling the
+// delay up to 20 ms. 'state' receives the last value read.
+bool sysfs_wait_for(const std::string& path, const std::string& want, int timeout_ms,
+                    std::string& state);
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_SYSFS_H */
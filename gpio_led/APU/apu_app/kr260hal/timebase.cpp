@@ -0,0 +1,104 @@
+/*
+ * System counter time base shared with the RPU (see timebase.h,
+ * common/rpu_shm.h).
+ */
+
+#include "timebase.h"
+#include "shm_regs.h"
+
+namespace kr260hal {
+
+constexpr uint64_t SCNTR_FREQ_DEFAULT = 100000000ULL;  // Used when CNTFRQ is not readable
+constexpr int SYNC_READ_RETRIES = 100;
+
+uint64_t counter_freq() {
+#if defined(__aarch64__)
+    uint64_t freq;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+    if (freq != 0) return freq;
+#endif
+    return SCNTR_FREQ_DEFAULT;
+}
+
+uint64_t counter_now() {
+#if defined(__aarch64__)
+    uint64_t cnt;
+    __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(cnt) :: "memory");
+    return cnt;
+#else
+    return 0;
+#endif
+}
+
+uint64_t window_counter_freq(const MemMap& win) {
+    if (win.read<shm::TimeMagic>() == SHM_TIME_MAGIC) {
+        uint32_t hz = win.read<shm::TimeHz>();
+        if (hz != 0) return hz;
+    }
+    return counter_freq();
+}
+
+uint64_t ticks_to_ns(uint64_t ticks, uint64_t hz) {
+    uint64_t sec = ticks / hz;
+    uint64_t rem = ticks % hz;
+    return sec * 1000000000ULL + rem * 1000000000ULL / hz;
+}
+
+ClockSync measure_clock_offset(uint64_t hz, clockid_t clock, int samples) {
+    ClockSync best;
+    uint64_t best_window = UINT64_MAX;
+
+    for (int i = 0; i < samples; i++) {
+        struct timespec ts;
+        uint64_t before = counter_now();
+        clock_gettime(clock, &ts);
+        uint64_t after = counter_now();
+
+        if (after - before >= best_window) continue;
+        best_window = after - before;
+
+        uint64_t clock_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        uint64_t mid = before + (after - before) / 2;
+        best.offset_ns = (int64_t)(clock_ns - ticks_to_ns(mid, hz));
+        best.error_ns = (uint32_t)(ticks_to_ns(after - before, hz) / 2 + 1);
+        best.time_s = (uint32_t)ts.tv_sec;
+    }
+    return best;
+}
+
+void publish_clock_sync(const MemMap& win, const ClockSync& sync) {
+    // Next even value; odd in between so readers retry
+    uint32_t seq = win.read<shm::SyncMagic>() == SHM_SYNC_MAGIC ? win.read<shm::SyncSeq>() : 0;
+    seq = (seq + 2) & ~1U;
+
+    win.write<shm::SyncSeq>(seq - 1);
+    barrier::release();
+    win.write<shm::SyncOffsetLo>((uint32_t)sync.offset_ns);
+    win.write<shm::SyncOffsetHi>((uint32_t)((uint64_t)sync.offset_ns >> 32));
+    win.write<shm::SyncError>(sync.error_ns);
+    win.write<shm::SyncTime>(sync.time_s);
+    barrier::release();
+    win.write<shm::SyncSeq>(seq);
+    win.write<shm::SyncMagic>(SHM_SYNC_MAGIC);
+}
+
+bool read_clock_sync(const MemMap& win, ClockSync& sync) {
+    if (win.read<shm::SyncMagic>() != SHM_SYNC_MAGIC) return false;
+
+    for (int i = 0; i < SYNC_READ_RETRIES; i++) {
+        uint32_t seq = win.read<shm::SyncSeq>();
+        barrier::acquire();
+        uint64_t lo = win.read<shm::SyncOffsetLo>();
+        uint64_t hi = win.read<shm::SyncOffsetHi>();
+        sync.error_ns = win.read<shm::SyncError>();
+        sync.time_s = win.read<shm::SyncTime>();
+        barrier::acquire();
+        if ((seq & 1) == 0 && seq == win.read<shm::SyncSeq>()) {
+            sync.offset_ns = (int64_t)((hi << 32) | lo);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace kr260hal
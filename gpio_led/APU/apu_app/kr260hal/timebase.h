@@ -0,0 +1,47 @@
+/*
+ * System counter time base shared with the RPU (kr260hal).
+ *
+ * The RPU timestamps with the ZynqMP system counter, which the A53 reads as
+ * CNTVCT_EL0. measure_clock_offset() relates a Linux clock to it: it reads
+ * the counter on both sides of clock_gettime() and keeps the sample with the
+ * narrowest bracket, whose half width is the error bound. The result is
+ * published in the time base block of the shared window (common/rpu_shm.h),
+ * where the RPU firmware picks it up (rpu_time.h).
+ */
+
+#ifndef KR260HAL_TIMEBASE_H
+#define KR260HAL_TIMEBASE_H
+
+#include <cstdint>
+#include <ctime>
+
+#include "mem_map.h"
+
+namespace kr260hal {
+
+// CNTFRQ_EL0, or 100 MHz when it is not readable (not aarch64)
+uint64_t counter_freq();
+uint64_t counter_now();
+
+// Counter frequency the RPU published, counter_freq() without a firmware
+uint64_t window_counter_freq(const MemMap& win);
+
+// Counter ticks to ns at 'hz', exact for any counter value
+uint64_t ticks_to_ns(uint64_t ticks, uint64_t hz);
+
+struct ClockSync {
+    int64_t offset_ns = 0;     // clock ns = ticks_to_ns(ticks, hz) + offset_ns
+    uint32_t error_ns = 0;     // Half width of the best bracket
+    uint32_t time_s = 0;       // Clock seconds at the measurement
+};
+
+ClockSync measure_clock_offset(uint64_t hz, clockid_t clock = CLOCK_MONOTONIC, int samples = 32);
+
+// Publish under the sync seq word (win must be writable) / read it back;
+// read_clock_sync() returns false while no offset has been published
+void publish_clock_sync(const MemMap& win, const ClockSync& sync);
+bool read_clock_sync(const MemMap& win, ClockSync& sync);
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_TIMEBASE_H */
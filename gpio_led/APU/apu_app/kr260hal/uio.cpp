@@ -0,0 +1,84 @@
+/*
+ * UIO device access (see uio.h).
+ */
+
+#include "uio.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "sysfs.h"
+
+namespace kr260hal {
+
+static const char UIO_CLASS_DIR[] = "/sys/class/uio/";
+
+bool UioDevice::open(const std::string& name) {
+    close();
+
+    DIR* dir = opendir(UIO_CLASS_DIR);
+    if (dir == nullptr) return false;
+
+    std::string dev_name;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string value;
+        std::string candidate = entry->d_name;
+        if (candidate.compare(0, 3, "uio") != 0) continue;
+        if (sysfs_read(UIO_CLASS_DIR + candidate + "/name", value) && value == name) {
+            dev_name = candidate;
+            break;
+        }
+    }
+    closedir(dir);
+
+    if (dev_name.empty()) {
+        errno = ENODEV;
+        return false;
+    }
+    fd_ = ::open(("/dev/" + dev_name).c_str(), O_RDWR | O_CLOEXEC);
+    if (fd_ == -1) return false;
+    sysfs_dir_ = UIO_CLASS_DIR + dev_name;
+    return true;
+}
+
+void UioDevice::close() {
+    if (fd_ != -1) ::close(fd_);
+    fd_ = -1;
+    sysfs_dir_.clear();
+}
+
+// Map N is selected with an mmap offset of N pages
+bool UioDevice::map(unsigned index, MemMap& map, bool writable) const {
+    std::string size_str;
+    if (!sysfs_read(sysfs_dir_ + "/maps/map" + std::to_string(index) + "/size", size_str)) {
+        return false;
+    }
+    size_t size = std::strtoul(size_str.c_str(), nullptr, 0);
+    if (size == 0) {
+        errno = EINVAL;
+        return false;
+    }
+    return map.map_fd(fd_, (off_t)index * sysconf(_SC_PAGESIZE), size, writable);
+}
+
+bool UioDevice::enable_irq() const {
+    int32_t enable = 1;
+    return write(fd_, &enable, sizeof(enable)) == sizeof(enable);
+}
+
+bool UioDevice::wait_irq(int timeout_ms, uint32_t& count) const {
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    int ret;
+    do {
+        ret = poll(&pfd, 1, timeout_ms);
+    } while (ret == -1 && errno == EINTR);
+    if (ret <= 0) return false;
+
+    return read(fd_, &count, sizeof(count)) == sizeof(count);
+}
+
+} // namespace kr260hal
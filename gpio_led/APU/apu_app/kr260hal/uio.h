@@ -0,0 +1,52 @@
+/*
+ * UIO device access (kr260hal).
+ *
+ * A UioDevice is a /dev/uioN node bound by uio_pdrv_genirq (see
+ * APU/dts/rpu_uio.dtso), looked up by its name. Its maps are mapped with
+ * MemMap, so register accesses need no system call; only waiting for the
+ * interrupt does. uio_pdrv_genirq masks the interrupt each time it fires:
+ * clear the source, then call enable_irq() before checking for more work.
+ */
+
+#ifndef KR260HAL_UIO_H
+#define KR260HAL_UIO_H
+
+#include <cstdint>
+#include <string>
+
+#include "mem_map.h"
+
+namespace kr260hal {
+
+class UioDevice {
+public:
+    UioDevice() = default;
+    ~UioDevice() { close(); }
+
+    UioDevice(const UioDevice&) = delete;
+    UioDevice& operator=(const UioDevice&) = delete;
+
+    // Opens the UIO device named 'name'; false (errno set) if there is none
+    bool open(const std::string& name);
+    void close();
+
+    bool is_open() const { return fd_ != -1; }
+    int fd() const { return fd_; }
+
+    // Maps UIO map 'index' (its whole size) into 'map'
+    bool map(unsigned index, MemMap& map, bool writable = true) const;
+
+    // Unmasks the interrupt
+    bool enable_irq() const;
+    // Blocks until the interrupt fires or timeout_ms passes (-1: forever).
+    // Returns true on an interrupt; 'count' is the total number so far.
+    bool wait_irq(int timeout_ms, uint32_t& count) const;
+
+private:
+    int fd_ = -1;
+    std::string sysfs_dir_;  // /sys/class/uio/uioN
+};
+
+} // namespace kr260hal
+
+#endif /* KR260HAL_UIO_H */
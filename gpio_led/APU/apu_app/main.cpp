@@ -2,66 +2,122 @@
  * APU Application to control LED Blink Mode on RPU via Legacy Shared Memory.
  *
  * Usage: ./apu_app <mode>
+ *        ./apu_app --doorbell <mode>   (ring the RPU0 IPI doorbell as well)
+ *        ./apu_app --no-wait <mode>    (do not wait for the RPU to pick it up)
  * Modes:
  *   0: SLOW
  *   1: FAST
  *   2: RANDOM
  *   3+: Release control (RPU internal state machine)
  *
+ * The legacy region is a mailbox (common/rpu_shm.h): the mode word, followed
+ * by a generation counter that publishes it and the generation the RPU
+ * processed last. The RPU polls the mailbox every LEGACY_MBOX_POLL ms (10 ms
+ * by default); with --doorbell it is served at once through the IPI task.
+ * The tool waits for the RPU to echo the generation and prints the latency:
+ *   Mode 1 applied by the RPU in 4.210 ms (gen 7, poll 10 ms)
+ * Firmware that predates the mailbox only samples the mode word on its 10 s
+ * mode timer; the tool then just writes it.
+ *
  * Memory Map:
- *   0x40000000: Shared Control Word (u32)
+ *   0x40000000: Legacy DDR mailbox (LEGACY_MBOX_*)
+ *   0xFF300000: APU IPI registers (--doorbell, through kr260hal)
  */
 
 #include <iostream>
-#include <fstream>
+#include <cstdio>
 #include <cstdlib>
 #include <cstdint>
 #include <cstring>
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <unistd.h>
 
-#define SHARED_MEM_ADDR 0x40000000
-#define SHARED_MEM_SIZE 0x1000 // 4KB
+#include "rpu_shm.h"
+#include "kr260hal/ipi_transport.h"
+#include "kr260hal/mem_map.h"
+
+namespace mbox {
+using Mode  = kr260hal::Reg<LEGACY_MBOX_MODE_OFFSET, uint32_t, LEGACY_MBOX_SIZE>;
+using Gen   = kr260hal::Reg<LEGACY_MBOX_GEN_OFFSET, uint32_t, LEGACY_MBOX_SIZE>;
+using Ack   = kr260hal::Reg<LEGACY_MBOX_ACK_OFFSET, uint32_t, LEGACY_MBOX_SIZE>;
+using Magic = kr260hal::Reg<LEGACY_MBOX_MAGIC_OFFSET, uint32_t, LEGACY_MBOX_SIZE>;
+using Poll  = kr260hal::Reg<LEGACY_MBOX_POLL_OFFSET, uint32_t, LEGACY_MBOX_SIZE>;
+}
+
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--doorbell] [--no-wait] <mode>" << std::endl;
+    std::cerr << "  0: SLOW" << std::endl;
+    std::cerr << "  1: FAST" << std::endl;
+    std::cerr << "  2: RANDOM" << std::endl;
+    std::cerr << "  3+: Auto (RPU Control)" << std::endl;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <mode>" << std::endl;
-        std::cerr << "  0: SLOW" << std::endl;
-        std::cerr << "  1: FAST" << std::endl;
-        std::cerr << "  2: RANDOM" << std::endl;
-        std::cerr << "  3+: Auto (RPU Control)" << std::endl;
+    bool doorbell = false;
+    bool wait = true;
+    int argi = 1;
+    for (; argi < argc && argv[argi][0] == '-'; argi++) {
+        if (std::strcmp(argv[argi], "--doorbell") == 0) {
+            doorbell = true;
+        } else if (std::strcmp(argv[argi], "--no-wait") == 0) {
+            wait = false;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argi != argc - 1) {
+        print_usage(argv[0]);
         return 1;
     }
 
-    int mode = std::atoi(argv[1]);
+    int mode = std::atoi(argv[argi]);
 
-    // Open /dev/mem to access physical memory
-    int mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if (mem_fd == -1) {
-        std::perror("Error opening /dev/mem");
+    // Map the legacy mailbox through /dev/mem
+    kr260hal::MemMap ctrl;
+    if (!ctrl.map_phys(LEGACY_MBOX_ADDR, LEGACY_MBOX_SIZE)) {
+        std::perror("Error mapping memory");
         return 1;
     }
 
-    // Map the shared memory region
-    void* mapped_base = mmap(0, SHARED_MEM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, SHARED_MEM_ADDR);
-    if (mapped_base == MAP_FAILED) {
-        std::perror("Error mapping memory");
-        close(mem_fd);
-        return 1;
+    // Mode first, then the generation that publishes it
+    uint32_t gen = ctrl.read<mbox::Gen>() + 1;
+    uint64_t start = kr260hal::now_ns();
+    ctrl.write<mbox::Mode>((uint32_t)mode);
+    ctrl.write_release<mbox::Gen>(gen);
+
+    if (doorbell) {
+        kr260hal::IpiTransport ipi;
+        if (!ipi.open(0)) {
+            std::perror("Error mapping the IPI registers");
+            return 1;
+        }
+        ipi.doorbell();
     }
 
-    // Write the mode to the shared memory address
-    volatile uint32_t* shared_ctrl = (volatile uint32_t*)mapped_base;
-    *shared_ctrl = (uint32_t)mode;
+    std::cout << "Written mode " << mode << " to legacy shared memory at 0x" << std::hex
+              << LEGACY_MBOX_ADDR << std::dec << std::endl;
 
-    std::cout << "Written mode " << mode << " to legacy shared memory at 0x" << std::hex << SHARED_MEM_ADDR << std::endl;
+    if (!wait) return 0;
+    if (ctrl.read<mbox::Magic>() != LEGACY_MBOX_MAGIC) {
+        std::cout << "RPU firmware has no mailbox; the mode is picked up by its 10 s timer" << std::endl;
+        return 0;
+    }
 
-    // Cleanup
-    if (munmap(mapped_base, SHARED_MEM_SIZE) == -1) {
-        std::perror("Error unmapping memory");
+    // Without its poll timer (power profile) the RPU only serves the doorbell
+    if (ctrl.read<mbox::Poll>() == 0 && !doorbell) {
+        std::cout << "RPU does not poll the mailbox; use --doorbell for an immediate change" << std::endl;
+        return 0;
+    }
+
+    // The RPU echoes the generation once it has processed the mode
+    kr260hal::WaitPolicy policy;
+    uint64_t end = start;
+    if (!kr260hal::wait_until(policy, start, [&] { return ctrl.read<mbox::Ack>() == gen; }, &end)) {
+        std::cerr << "RPU did not pick up generation " << gen << " within "
+                  << policy.timeout_ms << " ms" << std::endl;
+        return 1;
     }
-    close(mem_fd);
 
+    std::printf("Mode %d applied by the RPU in %.3f ms (gen %u, poll %u ms)\n",
+                mode, (end - start) / 1e6, gen, ctrl.read<mbox::Poll>());
     return 0;
 }
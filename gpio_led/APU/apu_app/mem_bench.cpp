@@ -0,0 +1,400 @@
+/*
+ * APU tool of the memory hierarchy benchmark: the same regions measured
+ * from the A53 and from the R5, side by side.
+ *
+ * Usage: sudo ./mem_bench           (APU tests, then an RPU pass, both tables)
+ *        sudo ./mem_bench --apu     (APU tests only)
+ *        sudo ./mem_bench --rpu     (request an RPU pass and print it)
+ *        sudo ./mem_bench --show    (print the last RPU pass, request nothing)
+ *        sudo ./mem_bench --cpu 3   (pin to a core under SCHED_FIFO first)
+ *        sudo ./mem_bench --apu --pl 0xB0000000   (pl row on another register)
+ *
+ * The RPU side needs the RPU0 firmware built with RPU_MEMBENCH=1
+ * (RPU/gpio_app/src/rpu_membench.h), which measures TCM, OCM, DDR and the
+ * PL under each MPU memory type. The APU tests run between its passes
+ * (MEMBENCH_DONE equal to MEMBENCH_GEN), on the same scratch ranges, with
+ * the memory types Linux gives them:
+ *
+ *   device   /dev/mem: TCM, OCM, the DDR scratch and the PL (Device-nGnRnE)
+ *   ncache   the DDR scratch through the rpu_ipi memory-region (Normal
+ *            non-cacheable), when the module has one
+ *   cached   a buffer of the APU's own DDR, the same size (Normal write-back);
+ *            the carveout itself has no cached mapping from user space
+ *
+ * Each test is the firmware's: one lap of a pointer chase through a
+ * full-period LCG order of the cache lines (MEMBENCH_CHASE_NEXT, 64-byte
+ * lines here), a 64-bit read and a write sweep, and 1000 reads then writes
+ * of one word. Cached ranges are cleaned and invalidated (DC CIVAC, allowed
+ * at EL0 on Linux) before each test, and the write sweep includes the clean.
+ *
+ *   side region type    bytes  chase_ns  rd_MB/s  wr_MB/s  word_rd_ns word_wr_ns
+ *   rpu  ocm    ncache  32768  142.1     201.3    502.8    112.4      7.5
+ *
+ * Memory Map:
+ *   0xFFFDB000: MEMBENCH block (rpu_shm.h)
+ *   0xFFFE0000: OCM scratch, 32 KB
+ *   0x3F100000: DDR scratch, 64 KB at the start of the RPU0 bulk carveout
+ *   0x80000000: AXI GPIO DATA (read and written back unchanged)
+ *
+ * --pl times the APU pl row on another PL register instead, read and
+ * written back unchanged the same way, e.g. PERIOD1 of the interrupt_demo
+ * interrupt generator (0xB0000000): comparing the word_rd_ns/word_wr_ns of
+ * the pl rows before and after PL/axi_xbar_bd.tcl gives the latency of the
+ * AXI path of each design.
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "rpu_shm.h"
+#include "rpu_ipi_ioctl.h"
+#include "kr260hal/barrier.h"
+#include "kr260hal/ipi_transport.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/rt.h"
+
+namespace barrier = kr260hal::barrier;
+
+#define APU_LINE               64      // A53 cache line: one chase load per line
+#define APU_WORD_OPS           1000
+#define MEMBENCH_READ_RETRIES  100
+#define MEMBENCH_PASS_TIMEOUT_MS 10000
+
+// Indexed by MEMBENCH_REGION_* and MEMBENCH_ATTR_*
+static const char* const REGION_NAMES[] = { "tcm", "ocm", "ddr", "pl" };
+static const char* const ATTR_NAMES[] = { "cached", "ncache", "strong" };
+
+// Memory types of the APU rows
+enum apu_type { APU_DEVICE, APU_NCACHE, APU_CACHED };
+static const char* const APU_TYPE_NAMES[] = { "device", "ncache", "cached" };
+
+// One row of either side, in ns and MB/s
+struct mem_row {
+    const char* side;
+    const char* region;
+    const char* type;
+    uint32_t bytes;
+    double chase_ns;       // < 0: not measured
+    double rd_mbs;
+    double wr_mbs;
+    double word_rd_ns;
+    double word_wr_ns;
+};
+
+static void print_header() {
+    std::printf("%-5s %-6s %-7s %-6s %-9s %-8s %-8s %-10s %s\n", "side", "region", "type",
+                "bytes", "chase_ns", "rd_MB/s", "wr_MB/s", "word_rd_ns", "word_wr_ns");
+}
+
+static void print_row(const mem_row& r) {
+    if (r.chase_ns >= 0) {
+        std::printf("%-5s %-6s %-7s %-6u %-9.1f %-8.1f %-8.1f %-10.1f %.1f\n", r.side, r.region,
+                    r.type, r.bytes, r.chase_ns, r.rd_mbs, r.wr_mbs, r.word_rd_ns, r.word_wr_ns);
+    } else {
+        std::printf("%-5s %-6s %-7s %-6s %-9s %-8s %-8s %-10.1f %.1f\n", r.side, r.region,
+                    r.type, "-", "-", "-", "-", r.word_rd_ns, r.word_wr_ns);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* APU tests */
+
+static void clean_range(volatile uint8_t* p, size_t len, apu_type type) {
+    if (type != APU_CACHED) return;
+#if defined(__aarch64__)
+    for (size_t off = 0; off < len; off += APU_LINE) {
+        __asm__ __volatile__("dc civac, %0" :: "r"(p + off) : "memory");
+    }
+    __asm__ __volatile__("dsb sy" ::: "memory");
+#else
+    (void)p;
+    (void)len;
+#endif
+}
+
+// The links are 32-bit offsets, so the chain is the same on every mapping
+static double chase_ns(volatile uint8_t* p, uint32_t bytes, apu_type type) {
+    const uint32_t lines = bytes / APU_LINE;
+    for (uint32_t i = 0; i < lines; i++) {
+        *(volatile uint32_t*)(p + i * APU_LINE) = MEMBENCH_CHASE_NEXT(i, lines) * APU_LINE;
+    }
+    clean_range(p, bytes, type);
+
+    uint32_t off = 0;
+    uint64_t start = kr260hal::now_ns();
+    for (uint32_t i = 0; i < lines; i++) {
+        off = *(volatile uint32_t*)(p + off);
+    }
+    uint64_t end = kr260hal::now_ns();
+    if (off != 0) std::cerr << "Chase did not close its lap" << std::endl;
+    return (double)(end - start) / lines;
+}
+
+static void sweep_mbs(volatile uint8_t* p, uint32_t bytes, apu_type type, double& rd, double& wr) {
+    volatile uint64_t* q = (volatile uint64_t*)p;
+    const uint32_t n = bytes / 8;
+    uint64_t sum = 0;
+
+    clean_range(p, bytes, type);
+    uint64_t start = kr260hal::now_ns();
+    for (uint32_t i = 0; i < n; i += 4) {
+        sum += q[i] ^ q[i + 1] ^ q[i + 2] ^ q[i + 3];
+    }
+    uint64_t end = kr260hal::now_ns();
+    rd = end > start ? bytes * 1e3 / (end - start) : 0.0;
+
+    clean_range(p, bytes, type);
+    start = kr260hal::now_ns();
+    for (uint32_t i = 0; i < n; i += 4) {
+        q[i] = sum;
+        q[i + 1] = sum;
+        q[i + 2] = sum;
+        q[i + 3] = sum;
+    }
+    clean_range(p, bytes, type);
+    barrier::complete();
+    end = kr260hal::now_ns();
+    wr = end > start ? bytes * 1e3 / (end - start) : 0.0;
+}
+
+// One word read, then written back unchanged: safe on the GPIO as well
+static void word_ns(volatile uint8_t* p, double& rd, double& wr) {
+    volatile uint32_t* w = (volatile uint32_t*)p;
+    uint32_t v = 0;
+
+    uint64_t start = kr260hal::now_ns();
+    for (int i = 0; i < APU_WORD_OPS; i++) v |= *w;
+    uint64_t end = kr260hal::now_ns();
+    rd = (double)(end - start) / APU_WORD_OPS;
+
+    v = *w;
+    start = kr260hal::now_ns();
+    for (int i = 0; i < APU_WORD_OPS; i++) *w = v;
+    barrier::complete();
+    end = kr260hal::now_ns();
+    wr = (double)(end - start) / APU_WORD_OPS;
+}
+
+static mem_row measure(const char* region, apu_type type, volatile uint8_t* p, uint32_t bytes) {
+    mem_row r = { "apu", region, APU_TYPE_NAMES[type], bytes, -1, 0, 0, 0, 0 };
+    if (bytes) {
+        r.chase_ns = chase_ns(p, bytes, type);
+        sweep_mbs(p, bytes, type, r.rd_mbs, r.wr_mbs);
+    }
+    word_ns(p, r.word_rd_ns, r.word_wr_ns);
+    return r;
+}
+
+// A /dev/mem window over [phys, phys + len), phys not necessarily page aligned
+static volatile uint8_t* map_range(kr260hal::MemMap& map, uintptr_t phys, size_t len) {
+    const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t base = phys & ~(page - 1);
+    if (!map.map_phys(base, (phys - base) + len)) return nullptr;
+    return map.base() + (phys - base);
+}
+
+static void run_apu(uint32_t tcm_addr, uintptr_t pl_addr) {
+    kr260hal::MemMap map;
+    volatile uint8_t* p;
+
+    if (tcm_addr && (p = map_range(map, tcm_addr, MEMBENCH_TCM_SIZE))) {
+        print_row(measure("tcm", APU_DEVICE, p, MEMBENCH_TCM_SIZE));
+    }
+    if ((p = map_range(map, MEMBENCH_OCM_ADDR, MEMBENCH_OCM_SIZE))) {
+        print_row(measure("ocm", APU_DEVICE, p, MEMBENCH_OCM_SIZE));
+    } else {
+        std::perror("Error mapping the OCM scratch");
+    }
+    if ((p = map_range(map, MEMBENCH_DDR_ADDR, MEMBENCH_DDR_SIZE))) {
+        print_row(measure("ddr", APU_DEVICE, p, MEMBENCH_DDR_SIZE));
+    } else {
+        std::perror("Error mapping the DDR scratch");
+    }
+
+    // Normal non-cacheable: the rpu_ipi memory-region, if it covers the scratch
+    int fd = ::open("/dev/" RPU_IPI_DEV_NAME, O_RDWR);
+    struct rpu_ipi_region region = {};
+    if (fd >= 0 && ioctl(fd, RPU_IPI_IOC_REGION, &region) == 0 &&
+        region.size && MEMBENCH_DDR_ADDR >= region.phys &&
+        MEMBENCH_DDR_ADDR + MEMBENCH_DDR_SIZE <= region.phys + region.size &&
+        map.map_fd(fd, RPU_IPI_MMAP_REGION_OFFSET + (MEMBENCH_DDR_ADDR - region.phys),
+                   MEMBENCH_DDR_SIZE)) {
+        print_row(measure("ddr", APU_NCACHE, map.base(), MEMBENCH_DDR_SIZE));
+    } else {
+        std::cerr << "(ddr ncache skipped: no rpu_ipi memory-region over the scratch)" << std::endl;
+    }
+    if (fd >= 0) ::close(fd);
+    map.unmap();
+
+    void* heap = aligned_alloc(APU_LINE, MEMBENCH_DDR_SIZE);
+    if (heap) {
+        std::memset(heap, 0, MEMBENCH_DDR_SIZE);
+        print_row(measure("ddr", APU_CACHED, (volatile uint8_t*)heap, MEMBENCH_DDR_SIZE));
+        std::free(heap);
+    }
+
+    if ((p = map_range(map, pl_addr, 4))) {
+        print_row(measure("pl", APU_DEVICE, p, 0));
+    } else {
+        std::perror("Error mapping the PL register");
+    }
+    std::fflush(stdout);
+}
+
+/*-----------------------------------------------------------*/
+/* RPU pass */
+
+// The entries of the last pass, under the seq word
+static bool read_rpu(const kr260hal::MemMap& blk, rpu_membench_entry* out, uint32_t& count,
+                     uint32_t& hz) {
+    for (int tries = 0; tries < MEMBENCH_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(MEMBENCH_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(10000);
+            continue;
+        }
+        barrier::acquire();
+        hz = *blk.at(MEMBENCH_HZ_OFFSET);
+        count = *blk.at(MEMBENCH_COUNT_OFFSET);
+        if (count > MEMBENCH_MAX_ENTRIES) count = MEMBENCH_MAX_ENTRIES;
+        for (uint32_t i = 0; i < count; i++) {
+            volatile uint32_t* src = blk.at(MEMBENCH_ENTRY(i));
+            uint32_t words[MEMBENCH_ENTRY_SIZE / 4];
+            for (unsigned w = 0; w < MEMBENCH_ENTRY_SIZE / 4; w++) words[w] = src[w];
+            std::memcpy(&out[i], words, sizeof(out[i]));
+        }
+        barrier::acquire();
+        if (*blk.at(MEMBENCH_SEQ_OFFSET) == s) return true;
+    }
+    return false;
+}
+
+static void print_rpu(const rpu_membench_entry* e, uint32_t count, uint32_t hz) {
+    const double ns = hz ? 1e9 / hz : 0.0;
+    for (uint32_t i = 0; i < count; i++) {
+        const rpu_membench_entry& x = e[i];
+        mem_row r = { "rpu", x.region < 4 ? REGION_NAMES[x.region] : "?",
+                      x.attr < 3 ? ATTR_NAMES[x.attr] : "?", x.bytes, -1, 0, 0, 0, 0 };
+        if (x.chase_loads) {
+            r.chase_ns = x.chase_cycles * ns / x.chase_loads;
+            r.rd_mbs = x.rd_cycles ? x.sweep_bytes * 1e3 / (x.rd_cycles * ns) : 0.0;
+            r.wr_mbs = x.wr_cycles ? x.sweep_bytes * 1e3 / (x.wr_cycles * ns) : 0.0;
+        }
+        if (x.word_ops) {
+            r.word_rd_ns = x.word_rd_cycles * ns / x.word_ops;
+            r.word_wr_ns = x.word_wr_cycles * ns / x.word_ops;
+        }
+        print_row(r);
+    }
+    std::fflush(stdout);
+}
+
+// Bumps the generation and waits for the firmware to echo it
+static bool request_pass(kr260hal::MemMap& blk) {
+    uint32_t gen = *blk.at(MEMBENCH_GEN_OFFSET) + 1;
+    *blk.at(MEMBENCH_GEN_OFFSET) = gen;
+    barrier::full();
+    for (int ms = 0; ms < MEMBENCH_PASS_TIMEOUT_MS; ms += 10) {
+        if (*blk.at(MEMBENCH_DONE_OFFSET) == gen) return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+// The firmware is between passes
+static bool wait_idle(const kr260hal::MemMap& blk) {
+    for (int ms = 0; ms < MEMBENCH_PASS_TIMEOUT_MS; ms += 10) {
+        if (*blk.at(MEMBENCH_DONE_OFFSET) == *blk.at(MEMBENCH_GEN_OFFSET)) return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    bool apu = true;
+    bool rpu = true;
+    bool request = true;
+    uintptr_t pl_addr = MEMBENCH_PL_ADDR;
+    kr260hal::RtPolicy rt;
+
+    static const struct option long_opts[] = {
+        {"apu",  no_argument,       nullptr, 'a'},
+        {"rpu",  no_argument,       nullptr, 'r'},
+        {"show", no_argument,       nullptr, 's'},
+        {"cpu",  required_argument, nullptr, 'c'},
+        {"pl",   required_argument, nullptr, 'p'},
+        {"help", no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "arsc:p:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'a': rpu = false; break;
+            case 'r': apu = false; break;
+            case 's': apu = false; request = false; break;
+            case 'c': rt.cpu = std::atoi(optarg); break;
+            case 'p': pl_addr = std::strtoul(optarg, nullptr, 0); break;
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] <<  " [--apu | --rpu | --show] [--cpu <n>] [--pl <addr>]"
+                          << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (rt.cpu >= 0) {
+        std::string error, warning;
+        if (!kr260hal::apply_rt(rt, error, warning)) {
+            std::cerr << "Real-time setup failed at " << error << ": " << std::strerror(errno)
+                      << std::endl;
+            return 1;
+        }
+        if (!warning.empty()) std::cerr << warning << std::endl;
+    }
+
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(MEMBENCH_ADDR, MEMBENCH_SIZE)) {
+        std::perror("Error mapping the MEMBENCH block");
+        return 1;
+    }
+    const bool have_fw = *blk.at(MEMBENCH_MAGIC_OFFSET) == MEMBENCH_MAGIC;
+    if (!have_fw && (rpu || !apu)) {
+        std::cerr << "No memory benchmark found; is the RPU0 firmware built with"
+                  << " RPU_MEMBENCH=1?" << std::endl;
+        if (!apu) return 1;
+        rpu = false;
+    }
+
+    print_header();
+    if (apu) {
+        // The firmware uses the same scratch ranges during a pass
+        if (have_fw && !wait_idle(blk)) {
+            std::cerr << "The RPU pass does not end" << std::endl;
+            return 1;
+        }
+        run_apu(have_fw ? *blk.at(MEMBENCH_TCM_OFFSET) : 0, pl_addr);
+    }
+    if (rpu) {
+        if (request && !request_pass(blk)) {
+            std::cerr << "No RPU pass within " << MEMBENCH_PASS_TIMEOUT_MS << " ms" << std::endl;
+            return 1;
+        }
+        rpu_membench_entry entries[MEMBENCH_MAX_ENTRIES];
+        uint32_t count = 0, hz = 0;
+        if (!read_rpu(blk, entries, count, hz)) {
+            std::cerr << "The MEMBENCH block kept changing" << std::endl;
+            return 1;
+        }
+        print_rpu(entries, count, hz);
+    }
+    return 0;
+}
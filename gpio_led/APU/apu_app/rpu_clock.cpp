@@ -0,0 +1,148 @@
+/*
+ * APU tool to put the RPU timestamps on the APU's CLOCK_MONOTONIC timeline.
+ *
+ * Usage: ./rpu_clock            (publish the offset once and exit)
+ *        ./rpu_clock --follow   (re-publish every 10 s until Ctrl-C)
+ *        ./rpu_clock --interval-s <s>   (follow period, default 10)
+ *        ./rpu_clock --show     (print what is published, write nothing)
+ *        ./rpu_clock --raw      (CLOCK_MONOTONIC_RAW instead: never slewed)
+ *        ./rpu_clock --core 1   (RPU1 firmware in split mode)
+ *
+ * RPU timestamps are system counter ticks (CNTVCT_EL0 on the A53). The tool
+ * measures the offset of CLOCK_MONOTONIC against the counter, keeping the
+ * narrowest of several clock_gettime() brackets, and publishes it in the time
+ * base block of the shared window (see common/rpu_shm.h). The firmware then
+ * converts its timestamps with xRpuTimeMonotonicNs() (rpu_time.h), and
+ * rpu_trace --monotonic prints the trace on the same timeline.
+ *
+ * NTP slews CLOCK_MONOTONIC, not the counter: --follow keeps the offset
+ * fresh and prints how far it moved since the previous update:
+ *   mono_s        offset_ns             error_ns  drift_ppm
+ *   812.402933    -3204112              21        +1.250
+ *
+ * Memory Map:
+ *   0xFF990000: Shared memory window (time base at SHM_TIME_HDR_OFFSET)
+ *   0xFFFC0000: Shared memory window of RPU1 (--core 1)
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <csignal>
+#include <ctime>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "rpu_shm.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/shm_regs.h"
+#include "kr260hal/timebase.h"
+
+namespace shm = kr260hal::shm;
+
+#define CLOCK_FOLLOW_S_DEFAULT 10
+#define CLOCK_SAMPLES          64
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+static void print_sync(const kr260hal::ClockSync& sync, double drift_ppm, bool have_drift) {
+    char drift[16] = "-";
+    if (have_drift) snprintf(drift, sizeof(drift), "%+.3f", drift_ppm);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    std::printf("%-13.6f %-21lld %-9u %s\n", ts.tv_sec + ts.tv_nsec / 1e9,
+                (long long)sync.offset_ns, sync.error_ns, drift);
+}
+
+int main(int argc, char* argv[]) {
+    bool follow = false;
+    bool show = false;
+    clockid_t clock = CLOCK_MONOTONIC;
+    unsigned interval_s = CLOCK_FOLLOW_S_DEFAULT;
+    unsigned core = 0;
+
+    static const struct option long_opts[] = {
+        {"follow",     no_argument,       nullptr, 'f'},
+        {"interval-s", required_argument, nullptr, 'i'},
+        {"show",       no_argument,       nullptr, 's'},
+        {"raw",        no_argument,       nullptr, 'r'},
+        {"core",       required_argument, nullptr, 'c'},
+        {"help",       no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "fi:src:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'f': follow = true; break;
+            case 'i': interval_s = std::strtoul(optarg, nullptr, 0); break;
+            case 's': show = true; break;
+            case 'r': clock = CLOCK_MONOTONIC_RAW; break;
+            case 'c':
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core < RPU_CORE_COUNT) break;
+                // fall through
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--follow] [--interval-s <s>] [--show] [--raw]"
+                          << " [--core <0|1>]" << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (interval_s == 0) interval_s = 1;
+
+    kr260hal::MemMap win;
+    if (!win.map_phys(kr260hal::shm_window_addr(core), SHARED_MEM_SIZE, !show)) {
+        std::perror("Error mapping shared memory");
+        return 1;
+    }
+
+    if (win.read<shm::TimeMagic>() != SHM_TIME_MAGIC) {
+        std::cerr << "No RPU time base found; is the RPU firmware running?"
+                  << " (publishing anyway, at CNTFRQ)" << std::endl;
+    }
+    const uint64_t hz = kr260hal::window_counter_freq(win);
+
+    std::printf("counter %llu Hz (CNTFRQ %llu Hz)\n",
+                (unsigned long long)hz, (unsigned long long)kr260hal::counter_freq());
+    std::printf("%-13s %-21s %-9s %s\n", "mono_s", "offset_ns", "error_ns", "drift_ppm");
+
+    kr260hal::ClockSync sync;
+    if (show) {
+        if (!kr260hal::read_clock_sync(win, sync)) {
+            std::cerr << "No clock offset published" << std::endl;
+            return 1;
+        }
+        print_sync(sync, 0, false);
+        return 0;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+
+    bool have_prev = false;
+    kr260hal::ClockSync prev;
+    while (!stop_requested) {
+        sync = kr260hal::measure_clock_offset(hz, clock, CLOCK_SAMPLES);
+        kr260hal::publish_clock_sync(win, sync);
+
+        // Offset change over the elapsed time, in parts per million
+        double drift = 0;
+        if (have_prev && sync.time_s != prev.time_s) {
+            drift = (sync.offset_ns - prev.offset_ns) / 1e3 / (double)(sync.time_s - prev.time_s);
+        }
+        print_sync(sync, drift, have_prev);
+        std::fflush(stdout);
+        prev = sync;
+        have_prev = true;
+
+        if (!follow) break;
+        for (unsigned i = 0; i < interval_s && !stop_requested; i++) sleep(1);
+    }
+
+    return 0;
+}
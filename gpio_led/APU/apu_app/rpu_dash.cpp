@@ -0,0 +1,502 @@
+/*
+ * APU tool to show live RPU performance counters on the DisplayPort output.
+ *
+ * Usage: ./rpu_dash                 (refresh every 500 ms until Ctrl-C)
+ *        ./rpu_dash --fb <dev>      (framebuffer device, default /dev/fb0)
+ *        ./rpu_dash --interval-ms <ms>   (refresh period, default 500)
+ *        ./rpu_dash --core 1        (RPU1 firmware in split mode)
+ *        ./rpu_dash --scale <n>     (font size, default 2: 10x14 pixel glyphs)
+ *        ./rpu_dash --pos <x>,<y>   (top left corner of the panel, default 16,16)
+ *
+ * Renders a small text panel with the counters the RPU firmware already
+ * publishes into the framebuffer of the ZynqMP display subsystem, so a
+ * headless bench with a monitor shows them without SSH or a UART:
+ *   RPU0  INTERVAL 0.50 S
+ *   CMDS/S     1204
+ *   QUEUE      0/32
+ *   IPI/S      1198
+ *   P99 US     <7.68
+ *   OCM MB/S   12.4 W  30.0 R
+ * The command rate and the queue depth come from the command ring of the
+ * shared window; the IPI pass rate and the 99th percentile of the IPI_Handler
+ * entry to pass completion time from the IRQ profile block (RPU_IRQ_PROF=1),
+ * as the log2 histogram bucket bound the percentile falls under for the
+ * passes of the interval; the bandwidth from the APM block (RPU0, RPU_APM=1).
+ * Counters of a block the firmware does not publish show "-".
+ *
+ * The panel is drawn into the hidden half of a framebuffer twice the screen
+ * height and shown with FBIOPAN_DISPLAY: the zynqmp-dpsub driver points the
+ * DPDMA descriptor of its graphics layer at that half on the next vertical
+ * blank, so frames are flipped, never copied, and a scanout never shows a
+ * half-drawn panel. Only the panel rectangle is redrawn; the rest of the
+ * buffer keeps what it had. The DRM fbdev emulation allocates the second
+ * half only when booted with drm_kms_helper.drm_fbdev_overalloc=200; without
+ * it the panel is drawn in place, at the risk of a torn frame. 16 and 32 bits
+ * per pixel are supported.
+ *
+ * Memory Map:
+ *   0xFF990000: Shared memory window (command ring head and tail)
+ *   0xFFFC0000: Shared memory window of RPU1 (--core 1)
+ *   0xFFFC3000: IRQ profile block (RPU1 at 0xFFFC4000)
+ *   0xFFFC5000: APM block
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/fb.h>
+
+#include "rpu_shm.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/shm_regs.h"
+#include "kr260hal/timebase.h"
+
+namespace shm = kr260hal::shm;
+namespace barrier = kr260hal::barrier;
+
+#define DASH_POLL_MS_DEFAULT    500
+#define DASH_READ_RETRIES       100
+#define DASH_GLYPH_W            5
+#define DASH_GLYPH_H            7
+#define DASH_CELL_W             (DASH_GLYPH_W + 1)
+#define DASH_CELL_H             (DASH_GLYPH_H + 2)
+#define DASH_PAD                4     /* Panel border, in glyph pixels */
+#define DASH_COLS               30
+#define DASH_ROWS               8
+
+static const char* const APM_PORT_NAMES[APM_MAX_PORTS] = {
+    "OCM", "LPD", "CCI", "?"
+};
+
+// 5x7 glyphs, bit 4 is the leftmost column; lowercase is drawn as uppercase
+struct glyph {
+    char c;
+    uint8_t rows[DASH_GLYPH_H];
+};
+
+static const glyph FONT[] = {
+    {' ', {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    {'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
+    {'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
+    {'3', {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}},
+    {'4', {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}},
+    {'5', {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}},
+    {'6', {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}},
+    {'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+    {'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
+    {'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+    {'A', {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11}},
+    {'B', {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}},
+    {'C', {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}},
+    {'D', {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}},
+    {'E', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}},
+    {'F', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}},
+    {'G', {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}},
+    {'H', {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}},
+    {'I', {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {'J', {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}},
+    {'K', {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}},
+    {'L', {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}},
+    {'M', {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}},
+    {'N', {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}},
+    {'O', {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+    {'P', {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}},
+    {'Q', {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}},
+    {'R', {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}},
+    {'S', {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}},
+    {'T', {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}},
+    {'U', {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+    {'V', {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}},
+    {'W', {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}},
+    {'X', {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}},
+    {'Y', {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}},
+    {'Z', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}},
+    {'%', {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}},
+    {'.', {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}},
+    {',', {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}},
+    {'/', {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}},
+    {':', {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}},
+    {'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
+    {'(', {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}},
+    {')', {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}},
+    {'<', {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}},
+    {'>', {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}},
+    {'=', {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}},
+    {'?', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}},
+};
+#define FONT_GLYPHS (sizeof(FONT) / sizeof(FONT[0]))
+
+static const uint8_t* glyph_rows(char c) {
+    if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+    for (unsigned i = 0; i < FONT_GLYPHS; i++) {
+        if (FONT[i].c == c) return FONT[i].rows;
+    }
+    return FONT[FONT_GLYPHS - 1].rows;
+}
+
+/*
+ * Double-buffered framebuffer: fill() and text() draw into the hidden half,
+ * flip() pans the display to it. With a single buffer both draw in place.
+ */
+class Framebuffer {
+public:
+    ~Framebuffer() {
+        if (mem_) munmap(mem_, len_);
+        if (fd_ >= 0) close(fd_);
+    }
+
+    bool open_dev(const char* path) {
+        fd_ = open(path, O_RDWR);
+        if (fd_ < 0) return false;
+        if (ioctl(fd_, FBIOGET_VSCREENINFO, &var_) < 0) return false;
+        if (var_.yres_virtual < 2 * var_.yres) {
+            fb_var_screeninfo want = var_;
+            want.yres_virtual = 2 * var_.yres;
+            want.yoffset = 0;
+            // Refused by drivers without the memory for it; then draw in place
+            if (ioctl(fd_, FBIOPUT_VSCREENINFO, &want) == 0) {
+                ioctl(fd_, FBIOGET_VSCREENINFO, &var_);
+            }
+        }
+        fb_fix_screeninfo fix;
+        if (ioctl(fd_, FBIOGET_FSCREENINFO, &fix) < 0) return false;
+        if (var_.bits_per_pixel != 16 && var_.bits_per_pixel != 32) {
+            errno = ENOTSUP;
+            return false;
+        }
+        stride_ = fix.line_length;
+        len_ = fix.smem_len;
+        double_ = var_.yres_virtual >= 2 * var_.yres &&
+                  (size_t)stride_ * 2 * var_.yres <= len_ &&
+                  fix.ypanstep != 0 && var_.yres % fix.ypanstep == 0;
+        void* p = mmap(nullptr, len_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            mem_ = nullptr;
+            return false;
+        }
+        mem_ = static_cast<uint8_t*>(p);
+        front_ = double_ && var_.yoffset >= var_.yres ? 1 : 0;
+        return true;
+    }
+
+    unsigned width() const { return var_.xres; }
+    unsigned height() const { return var_.yres; }
+    unsigned bpp() const { return var_.bits_per_pixel; }
+    bool double_buffered() const { return double_; }
+
+    uint32_t color(uint8_t r, uint8_t g, uint8_t b) const {
+        auto chan = [](uint8_t v, const fb_bitfield& f) {
+            return f.length ? ((uint32_t)v >> (8 - f.length)) << f.offset : 0;
+        };
+        return chan(r, var_.red) | chan(g, var_.green) | chan(b, var_.blue) |
+               chan(0xFF, var_.transp);
+    }
+
+    // Fill a rectangle of the buffer being drawn, clipped to the screen
+    void fill(unsigned x, unsigned y, unsigned w, unsigned h, uint32_t px) {
+        if (x >= var_.xres || y >= var_.yres) return;
+        if (w > var_.xres - x) w = var_.xres - x;
+        if (h > var_.yres - y) h = var_.yres - y;
+        for (unsigned j = 0; j < h; j++) {
+            uint8_t* line = row(y + j);
+            if (var_.bits_per_pixel == 32) {
+                uint32_t* p = reinterpret_cast<uint32_t*>(line) + x;
+                for (unsigned i = 0; i < w; i++) p[i] = px;
+            } else {
+                uint16_t* p = reinterpret_cast<uint16_t*>(line) + x;
+                for (unsigned i = 0; i < w; i++) p[i] = (uint16_t)px;
+            }
+        }
+    }
+
+    void text(unsigned x, unsigned y, unsigned scale, const std::string& s, uint32_t px) {
+        for (size_t n = 0; n < s.size(); n++, x += DASH_CELL_W * scale) {
+            const uint8_t* rows = glyph_rows(s[n]);
+            for (unsigned r = 0; r < DASH_GLYPH_H; r++) {
+                for (unsigned c = 0; c < DASH_GLYPH_W; c++) {
+                    if (rows[r] & (0x10 >> c)) {
+                        fill(x + c * scale, y + r * scale, scale, scale, px);
+                    }
+                }
+            }
+        }
+    }
+
+    // Show the buffer just drawn; the next draw goes to the other one
+    bool flip() {
+        if (!double_) return true;
+        fb_var_screeninfo pan = var_;
+        unsigned back = front_ ^ 1;
+        pan.xoffset = 0;
+        pan.yoffset = back * var_.yres;
+        if (ioctl(fd_, FBIOPAN_DISPLAY, &pan) < 0) return false;
+        front_ = back;
+        return true;
+    }
+
+private:
+    uint8_t* row(unsigned y) const {
+        unsigned draw = double_ ? front_ ^ 1 : 0;
+        return mem_ + (size_t)(draw * var_.yres + y) * stride_;
+    }
+
+    int fd_ = -1;
+    uint8_t* mem_ = nullptr;
+    size_t len_ = 0;
+    unsigned stride_ = 0;
+    unsigned front_ = 0;
+    bool double_ = false;
+    fb_var_screeninfo var_ = {};
+};
+
+// Counters of one refresh; valid flags for the optional blocks
+struct dash_sample {
+    double t = 0.0;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    bool irq = false;
+    uint32_t hz = 0;
+    uint32_t passes = 0;
+    uint32_t hist[IRQPROF_BUCKETS] = {};
+    bool apm = false;
+    uint32_t apm_samples = 0;
+    uint32_t apm_ticks = 0;
+    uint32_t apm_count = 0;
+    uint32_t wr[APM_MAX_PORTS] = {};
+    uint32_t rd[APM_MAX_PORTS] = {};
+};
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+static double now_s() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Seqlock copy of the pass count and the completion histogram
+static bool read_irqprof(const kr260hal::MemMap& blk, dash_sample& out) {
+    for (int tries = 0; tries < DASH_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(IRQPROF_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.hz = *blk.at(IRQPROF_HZ_OFFSET);
+        out.passes = *blk.at(IRQPROF_PASSES_OFFSET);
+        volatile uint32_t* hist = blk.at(IRQPROF_STAGE(IRQPROF_STAGE_DONE) + IRQPROF_STAGE_HIST);
+        for (unsigned b = 0; b < IRQPROF_BUCKETS; b++) out.hist[b] = hist[b];
+        barrier::acquire();
+        if (*blk.at(IRQPROF_SEQ_OFFSET) == s) return true;
+    }
+    return false;
+}
+
+// Same protocol for the byte counts of the last APM interval
+static bool read_apm(const kr260hal::MemMap& blk, dash_sample& out) {
+    for (int tries = 0; tries < DASH_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(APM_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.apm_samples = *blk.at(APM_SAMPLES_OFFSET);
+        out.apm_ticks = *blk.at(APM_TICKS_OFFSET);
+        out.apm_count = *blk.at(APM_COUNT_OFFSET);
+        if (out.apm_count > APM_MAX_PORTS - 1) out.apm_count = APM_MAX_PORTS - 1;
+        for (unsigned i = 0; i < out.apm_count; i++) {
+            out.wr[i] = *blk.at(APM_PORT(i) + offsetof(rpu_apm_port, wr_bytes));
+            out.rd[i] = *blk.at(APM_PORT(i) + offsetof(rpu_apm_port, rd_bytes));
+        }
+        barrier::acquire();
+        if (*blk.at(APM_SEQ_OFFSET) == s) return true;
+    }
+    return false;
+}
+
+// Bucket bound in us under which 99% of the passes between two samples ended
+static std::string p99_text(const dash_sample& cur, const dash_sample& prev) {
+    uint64_t total = 0;
+    uint32_t n[IRQPROF_BUCKETS];
+    for (unsigned b = 0; b < IRQPROF_BUCKETS; b++) {
+        n[b] = cur.hist[b] - prev.hist[b];
+        total += n[b];
+    }
+    if (total == 0 || cur.hz == 0) return "-";
+
+    uint64_t seen = 0;
+    unsigned b = 0;
+    for (; b < IRQPROF_BUCKETS - 1; b++) {
+        seen += n[b];
+        if (seen * 100 >= total * 99) break;
+    }
+    char buf[32];
+    const double us_per_cycle = 1e6 / cur.hz;
+    // The last bucket is open: only its lower bound is known
+    if (b == IRQPROF_BUCKETS - 1) {
+        std::snprintf(buf, sizeof(buf), ">=%.2f",
+                      (double)(1U << (b + IRQPROF_BUCKET_SHIFT - 1)) * us_per_cycle);
+    } else {
+        std::snprintf(buf, sizeof(buf), "<%.2f", (double)(1U << (b + IRQPROF_BUCKET_SHIFT)) * us_per_cycle);
+    }
+    return buf;
+}
+
+static std::vector<std::string> format_panel(unsigned core, const dash_sample& cur,
+                                             const dash_sample& prev) {
+    std::vector<std::string> lines;
+    char buf[64];
+    const double secs = cur.t - prev.t;
+
+    std::snprintf(buf, sizeof(buf), "RPU%u  INTERVAL %.2f S", core, secs);
+    lines.push_back(buf);
+    std::snprintf(buf, sizeof(buf), "%-10s %.0f", "CMDS/S", secs > 0 ? (cur.head - prev.head) / secs : 0.0);
+    lines.push_back(buf);
+    std::snprintf(buf, sizeof(buf), "%-10s %u/%u", "QUEUE", cur.head - cur.tail, SHM_RING_SLOTS);
+    lines.push_back(buf);
+    if (cur.irq && prev.irq && secs > 0) {
+        std::snprintf(buf, sizeof(buf), "%-10s %.0f", "IPI/S", (cur.passes - prev.passes) / secs);
+        lines.push_back(buf);
+        std::snprintf(buf, sizeof(buf), "%-10s %s", "P99 US", p99_text(cur, prev).c_str());
+    } else {
+        lines.push_back("IPI/S      -");
+        std::snprintf(buf, sizeof(buf), "%-10s -", "P99 US");
+    }
+    lines.push_back(buf);
+
+    // The APM interval is timed with the system counter on the RPU
+    const double apm_secs = (double)cur.apm_ticks / kr260hal::counter_freq();
+    for (unsigned i = 0; i < (cur.apm ? cur.apm_count : 1); i++) {
+        if (cur.apm && cur.apm_samples && apm_secs > 0) {
+            std::snprintf(buf, sizeof(buf), "%s MB/S   %.1f W  %.1f R", APM_PORT_NAMES[i],
+                          cur.wr[i] / apm_secs / 1e6, cur.rd[i] / apm_secs / 1e6);
+        } else {
+            std::snprintf(buf, sizeof(buf), "%-10s -", "APM MB/S");
+        }
+        lines.push_back(buf);
+    }
+    return lines;
+}
+
+static void draw_panel(Framebuffer& fb, unsigned x, unsigned y, unsigned scale,
+                       const std::vector<std::string>& lines) {
+    const uint32_t bg = fb.color(0x10, 0x14, 0x20);
+    const uint32_t title = fb.color(0x40, 0xD0, 0xFF);
+    const uint32_t fg = fb.color(0xF0, 0xF0, 0xF0);
+    const unsigned pad = DASH_PAD * scale;
+
+    // Fixed size, so a shorter line clears what a longer one left
+    fb.fill(x, y, DASH_COLS * DASH_CELL_W * scale + 2 * pad, DASH_ROWS * DASH_CELL_H * scale + 2 * pad, bg);
+    for (size_t i = 0; i < lines.size() && i < DASH_ROWS; i++) {
+        std::string s = lines[i].substr(0, DASH_COLS);
+        fb.text(x + pad, y + pad + i * DASH_CELL_H * scale, scale, s, i == 0 ? title : fg);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* fb_path = "/dev/fb0";
+    unsigned interval_ms = DASH_POLL_MS_DEFAULT;
+    unsigned core = 0;
+    unsigned scale = 2;
+    unsigned pos_x = 16, pos_y = 16;
+
+    static const struct option long_opts[] = {
+        {"fb",          required_argument, nullptr, 'f'},
+        {"interval-ms", required_argument, nullptr, 'i'},
+        {"core",        required_argument, nullptr, 'c'},
+        {"scale",       required_argument, nullptr, 's'},
+        {"pos",         required_argument, nullptr, 'p'},
+        {"help",        no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "f:i:c:s:p:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'f': fb_path = optarg; break;
+            case 'i': interval_ms = std::strtoul(optarg, nullptr, 0); break;
+            case 's':
+                scale = std::strtoul(optarg, nullptr, 0);
+                if (scale >= 1 && scale <= 8) break;
+                goto usage;
+            case 'p':
+                if (std::sscanf(optarg, "%u,%u", &pos_x, &pos_y) == 2) break;
+                goto usage;
+            case 'c':
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core < RPU_CORE_COUNT) break;
+                // fall through
+            case 'h':
+            default:
+            usage:
+                std::cerr << "Usage: " << argv[0] << " [--fb <dev>] [--interval-ms <ms>] [--core <0|1>]"
+                          << " [--scale <1-8>] [--pos <x>,<y>]" << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (interval_ms == 0) interval_ms = DASH_POLL_MS_DEFAULT;
+
+    kr260hal::MemMap win, irqblk, apmblk;
+    if (!win.map_phys(kr260hal::shm_window_addr(core), SHARED_MEM_SIZE, false)) {
+        std::perror("Error mapping the shared window");
+        return 1;
+    }
+    // The magic words of the optional blocks are checked at every refresh: a
+    // firmware restarted with them enabled shows up without restarting the tool
+    bool have_irq = irqblk.map_phys(IRQPROF_ADDR(core), IRQPROF_SIZE, false);
+    bool have_apm = core == 0 && apmblk.map_phys(APM_ADDR, APM_SIZE, false);
+
+    Framebuffer fb;
+    if (!fb.open_dev(fb_path)) {
+        std::perror("Error opening the framebuffer");
+        return 1;
+    }
+    std::cout << "Framebuffer " << fb_path << ": " << fb.width() << "x" << fb.height() << ", "
+              << fb.bpp() << " bpp, " << (fb.double_buffered() ? "page flipped" : "single buffer")
+              << std::endl;
+
+    std::signal(SIGINT, handle_sigint);
+    std::signal(SIGTERM, handle_sigint);
+    dash_sample prev, cur;
+    bool have_prev = false;
+    while (!stop_requested) {
+        cur = dash_sample();
+        cur.t = now_s();
+        cur.tail = win.read<shm::RingTail>();
+        cur.head = win.read<shm::RingHead>();
+        cur.irq = have_irq && *irqblk.at(IRQPROF_MAGIC_OFFSET) == IRQPROF_MAGIC && read_irqprof(irqblk, cur);
+        cur.apm = have_apm && *apmblk.at(APM_MAGIC_OFFSET) == APM_MAGIC && read_apm(apmblk, cur);
+
+        if (have_prev) {
+            std::vector<std::string> lines = format_panel(core, cur, prev);
+            draw_panel(fb, pos_x, pos_y, scale, lines);
+            if (!fb.flip()) {
+                std::perror("Error flipping the framebuffer");
+                return 1;
+            }
+        }
+        prev = cur;
+        have_prev = true;
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
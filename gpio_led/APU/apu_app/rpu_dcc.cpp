@@ -0,0 +1,120 @@
+/*
+ * APU tool to collect the RPU log and trace from the R5 debug channel (DCC).
+ *
+ * Usage: ./rpu_dcc                 (words to stdout until Ctrl-C)
+ *        ./rpu_dcc --out <file>    (words to a file instead)
+ *        ./rpu_dcc --poll-us <us>  (sleep when the channel is empty, default 50)
+ *        ./rpu_dcc --core 1        (RPU1 firmware in split mode)
+ *
+ * A firmware built with RPU_LOG_DCC=1 sends its RPU_LOG records and trace
+ * entries as frames of 32-bit words through the DCC transmit register of
+ * its R5 (gpio_app/src/rpu_dcc.h). The tool reads that register through the
+ * core's memory-mapped debug registers in the CoreSight APB space, the same
+ * way a JTAG debugger does, and writes the words little-endian, untouched;
+ * decode them with the firmware ELF:
+ *   sudo ./rpu_dcc | python3 rpu_dcc.py --elf gpio_app.elf
+ *
+ * The RPU gives up on a word the reader leaves for a millisecond, so keep
+ * the poll period well below that. Do not run it while a JTAG debugger
+ * reads the same channel: each word goes to whoever takes it first.
+ *
+ * Memory Map:
+ *   0xFEBF0000: RPU0 debug registers (RPU1 at 0xFEBF2000)
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <csignal>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "rpu_shm.h"
+#include "kr260hal/mem_map.h"
+
+// Cortex-R5 debug registers (ARMv7 debug, memory-mapped view)
+#define R5_DBG_ADDR(core)      (0xFEBF0000UL + (core) * 0x2000)
+#define R5_DBG_SIZE            0x1000
+#define R5_DBG_DSCR_OFFSET     0x088   // DBGDSCRext
+#define R5_DBG_DTRTX_OFFSET    0x08C   // DBGDTRTXext: reading it clears TXfull
+#define R5_DBG_LAR_OFFSET      0xFB0   // Software lock of memory-mapped accesses
+#define R5_DBG_LSR_OFFSET      0xFB4
+#define R5_DBG_DSCR_TXFULL     (1U << 29)
+#define R5_DBG_LSR_LOCKED      (1U << 1)
+#define R5_DBG_LAR_KEY         0xC5ACCE55
+
+#define DCC_POLL_US_DEFAULT    50
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned poll_us = DCC_POLL_US_DEFAULT;
+    unsigned core = 0;
+    const char* out_path = nullptr;
+
+    static const struct option long_opts[] = {
+        {"out",     required_argument, nullptr, 'o'},
+        {"poll-us", required_argument, nullptr, 'p'},
+        {"core",    required_argument, nullptr, 'c'},
+        {"help",    no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:p:c:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'o': out_path = optarg; break;
+            case 'p': poll_us = std::strtoul(optarg, nullptr, 0); break;
+            case 'c':
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core < RPU_CORE_COUNT) break;
+                // fall through
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--out <file>] [--poll-us <us>]"
+                          << " [--core <0|1>]" << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    FILE* out = stdout;
+    if (out_path && !(out = std::fopen(out_path, "wb"))) {
+        std::perror("Error opening the output file");
+        return 1;
+    }
+
+    kr260hal::MemMap dbg;
+    if (!dbg.map_phys(R5_DBG_ADDR(core), R5_DBG_SIZE)) {
+        std::perror("Error mapping the R5 debug registers");
+        return 1;
+    }
+    if (*dbg.at(R5_DBG_LSR_OFFSET) & R5_DBG_LSR_LOCKED) {
+        *dbg.at(R5_DBG_LAR_OFFSET) = R5_DBG_LAR_KEY;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    std::signal(SIGTERM, handle_sigint);
+
+    uint64_t words = 0;
+    while (!stop_requested) {
+        if ((*dbg.at(R5_DBG_DSCR_OFFSET) & R5_DBG_DSCR_TXFULL) == 0) {
+            std::fflush(out);
+            usleep(poll_us);
+            continue;
+        }
+        uint32_t w = *dbg.at(R5_DBG_DTRTX_OFFSET);
+        const unsigned char b[4] = { (unsigned char)w, (unsigned char)(w >> 8),
+                                     (unsigned char)(w >> 16), (unsigned char)(w >> 24) };
+        if (std::fwrite(b, 1, sizeof(b), out) != sizeof(b)) break;
+        words++;
+    }
+    std::fflush(out);
+    std::cerr << words << " words read" << std::endl;
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
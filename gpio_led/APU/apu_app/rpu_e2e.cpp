@@ -0,0 +1,509 @@
+/*
+ * APU tool to trace legacy commands end to end across the APU, the rpu_ipi
+ * module and the RPU firmware.
+ *
+ * Usage: ./rpu_e2e                        (200 commands through sysfs)
+ *        ./rpu_e2e --path dev --count 1000 --interval-ms 10
+ *        ./rpu_e2e --perfetto e2e.json     (trace for ui.perfetto.dev)
+ * Options:
+ *   --path <p>            sysfs: /sys/kernel/rpu_ipi/write (default)
+ *                         dev:   IpiTransport::send_mode() through /dev/rpu_ipi
+ *                         mem:   IpiTransport::send_mode() through /dev/mem
+ *   --count <n>           Commands to send (default 200)
+ *   --interval-ms <ms>    Gap after each command (default 20), long enough for
+ *                         the blink timer to write the new mode to the LEDs
+ *   --mode <m>            Mode sent every time (default: 0 and 1 alternately);
+ *                         mode 3 (release control) is sent at the end
+ *   --perfetto <file>     Write the commands as a Chrome JSON trace
+ *
+ * Every stage of a command is a system counter (CNTVCT) timestamp, the time
+ * base the RPU stamps its event trace with (common/rpu_shm.h, see
+ * rpu_trace): the APU stamps the call and its return (and, for dev and mem,
+ * IpiResult::doorbell_cnt), the module's rpu_ipi tracepoints carry cnt
+ * (kernel_module/rpu_ipi_trace.h; recorded in a tracefs instance of its
+ * own), and the firmware traces the IPI, the task pickup, the mode, the ACK
+ * and the next GPIO write:
+ *
+ *   submit       APU     call of the write() or send_mode()
+ *   k_send       kernel  rpu_ipi_cmd_send (sysfs)
+ *   doorbell     APU     library doorbell (dev, mem)
+ *   k_doorbell   kernel  rpu_ipi_doorbell (sysfs, dev)
+ *   ipi_rx       RPU     IPI interrupt taken
+ *   task         RPU     IPI task woke up (after the ACK when the FIQ path
+ *                        answers legacy words)
+ *   mode         RPU     blink mode applied
+ *   ack          RPU     ACK written, matched by sequence number
+ *   ack_irq      kernel  reverse IPI (with the module's ack_irq)
+ *   k_ack        kernel  rpu_ipi_cmd_ack, the writer woke up (sysfs)
+ *   wakeup       APU     call returned
+ *   gpio         RPU     first LED write after the mode, off the critical path
+ *
+ * Each stage's latency is measured from the latest earlier stage of the
+ * list that happened before it (gpio: from mode), and reported as
+ * percentiles and a log2 histogram in microseconds:
+ *   stage        from         n      p50_us    p99_us    max_us
+ *   k_doorbell   k_send       200    0.840     1.320     4.100
+ *
+ * With --perfetto the commands are slices on an APU track and the stages
+ * slices on the track of their domain, from the stage before them.
+ * Run it as root, with the firmware running; the commands change the blink
+ * mode, so the LEDs follow the test.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <getopt.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "rpu_shm.h"
+#include "kr260hal/ipi_transport.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/shm_regs.h"
+#include "kr260hal/sysfs.h"
+#include "kr260hal/timebase.h"
+
+namespace shm = kr260hal::shm;
+namespace barrier = kr260hal::barrier;
+using kr260hal::counter_now;
+
+#define E2E_SYSFS_WRITE      "/sys/kernel/rpu_ipi/write"
+#define E2E_INSTANCE         "rpu_e2e"
+#define E2E_COUNT_DEFAULT    200
+#define E2E_INTERVAL_DEFAULT 20
+#define E2E_MODE_RELEASE     3
+#define E2E_HIST_BUCKETS     16  // <1 us, then [2^(b-1), 2^b) us, the last open
+
+enum Stage {
+    ST_SUBMIT, ST_K_SEND, ST_DOORBELL, ST_K_DOORBELL, ST_IPI_RX, ST_TASK, ST_MODE,
+    ST_ACK, ST_ACK_IRQ, ST_K_ACK, ST_WAKEUP, ST_GPIO, ST_COUNT
+};
+
+enum Domain { DOM_APU = 1, DOM_KERNEL, DOM_RPU };
+
+struct StageInfo {
+    const char* name;
+    Domain domain;
+};
+
+static const StageInfo STAGES[ST_COUNT] = {
+    {"submit", DOM_APU},  {"k_send", DOM_KERNEL},  {"doorbell", DOM_APU},
+    {"k_doorbell", DOM_KERNEL}, {"ipi_rx", DOM_RPU}, {"task", DOM_RPU},
+    {"mode", DOM_RPU},    {"ack", DOM_RPU},        {"ack_irq", DOM_KERNEL},
+    {"k_ack", DOM_KERNEL}, {"wakeup", DOM_APU},    {"gpio", DOM_RPU},
+};
+
+// A timestamped event of the firmware or the module, in arrival order
+struct Event {
+    Stage stage;
+    uint64_t cnt;
+    uint32_t seq;  // ack and k_send; 0 if none
+};
+
+struct Command {
+    uint32_t mode = 0;
+    uint32_t seq = 0;       // 0 until known
+    bool ok = false;
+    uint64_t ts[ST_COUNT] = {};  // 0: stage not seen
+    Stage from[ST_COUNT] = {};   // Stage each latency is measured from
+    uint64_t next_submit = 0;    // End of the window its events belong to
+};
+
+/*-----------------------------------------------------------*/
+/* The firmware's trace, copied as rpu_trace does (seqlock per entry) */
+static bool read_entry(const kr260hal::MemMap& win, uint32_t idx, rpu_shm_trace& out) {
+    volatile uint32_t* entry = win.at(SHM_TRACE_ENTRY(idx));
+
+    if (entry[SHM_TRACE_SEQ / 4] != idx + 1) return false;
+    barrier::acquire();
+    out.event = entry[SHM_TRACE_EVENT / 4];
+    out.arg0  = entry[SHM_TRACE_ARG0 / 4];
+    out.arg1  = entry[SHM_TRACE_ARG1 / 4];
+    out.ts_lo = entry[SHM_TRACE_TS_LO / 4];
+    out.ts_hi = entry[SHM_TRACE_TS_HI / 4];
+    barrier::acquire();
+    out.seq = entry[SHM_TRACE_SEQ / 4];
+    return out.seq == idx + 1;
+}
+
+// New firmware events since *next; returns the number lost to a lap
+static uint32_t read_rpu_events(const kr260hal::MemMap& win, uint32_t* next,
+                                std::vector<Event>& events) {
+    uint32_t lost = 0;
+    uint32_t h = win.read_acquire<shm::TraceHead>();
+
+    if ((uint32_t)(h - *next) > SHM_TRACE_SLOTS) {
+        lost = h - SHM_TRACE_SLOTS - *next;
+        *next = h - SHM_TRACE_SLOTS;
+    }
+    for (; *next != h; (*next)++) {
+        rpu_shm_trace e;
+        if (!read_entry(win, *next, e)) {
+            lost++;
+            continue;
+        }
+        Event ev = {ST_COUNT, ((uint64_t)e.ts_hi << 32) | e.ts_lo, 0};
+        switch (e.event) {
+            case RPU_TRACE_IPI_RX:     ev.stage = ST_IPI_RX; break;
+            case RPU_TRACE_CMD_START:  ev.stage = ST_TASK; break;
+            case RPU_TRACE_MODE:       ev.stage = ST_MODE; break;
+            case RPU_TRACE_ACK:        ev.stage = ST_ACK; ev.seq = e.arg0; break;
+            case RPU_TRACE_GPIO_WRITE: ev.stage = ST_GPIO; break;
+            default: break;
+        }
+        if (ev.stage != ST_COUNT) events.push_back(ev);
+    }
+    return lost;
+}
+
+/*-----------------------------------------------------------*/
+/* rpu_ipi events through a tracefs instance, so the global tracer is left alone */
+class KernelTrace {
+public:
+    ~KernelTrace() { close(); }
+
+    bool open() {
+        for (const char* root : {"/sys/kernel/tracing", "/sys/kernel/debug/tracing"}) {
+            if (kr260hal::path_exists(std::string(root) + "/instances")) {
+                dir_ = std::string(root) + "/instances/" E2E_INSTANCE;
+                break;
+            }
+        }
+        if (dir_.empty()) return false;
+        if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (!kr260hal::sysfs_write(dir_ + "/events/rpu_ipi/enable", "1")) return false;
+        fd_ = ::open((dir_ + "/trace_pipe").c_str(), O_RDONLY | O_NONBLOCK);
+        return fd_ != -1;
+    }
+
+    void close() {
+        if (fd_ != -1) ::close(fd_);
+        fd_ = -1;
+        if (!dir_.empty()) {
+            kr260hal::sysfs_write(dir_ + "/events/rpu_ipi/enable", "0");
+            rmdir(dir_.c_str());
+        }
+        dir_.clear();
+    }
+
+    void read(std::vector<Event>& events) {
+        char buf[4096];
+        ssize_t n;
+
+        while (fd_ != -1 && (n = ::read(fd_, buf, sizeof(buf))) > 0) {
+            pending_.append(buf, n);
+            size_t eol;
+            while ((eol = pending_.find('\n')) != std::string::npos) {
+                parse(pending_.substr(0, eol), events);
+                pending_.erase(0, eol + 1);
+            }
+        }
+    }
+
+private:
+    static void parse(const std::string& line, std::vector<Event>& events) {
+        static const struct { const char* tag; Stage stage; } KERNEL_EVENTS[] = {
+            {"rpu_ipi_cmd_send:", ST_K_SEND},  {"rpu_ipi_doorbell:", ST_K_DOORBELL},
+            {"rpu_ipi_ack_irq:", ST_ACK_IRQ}, {"rpu_ipi_cmd_ack:", ST_K_ACK},
+        };
+        size_t cnt = line.find(" cnt=");
+        if (cnt == std::string::npos) return;
+
+        for (const auto& k : KERNEL_EVENTS) {
+            if (line.find(k.tag) == std::string::npos) continue;
+            Event ev = {k.stage, std::strtoull(line.c_str() + cnt + 5, nullptr, 10), 0};
+            size_t seq = line.find(" seq=");
+            if (seq != std::string::npos) ev.seq = std::strtoul(line.c_str() + seq + 5, nullptr, 10);
+            events.push_back(ev);
+            return;
+        }
+    }
+
+    std::string dir_;
+    std::string pending_;
+    int fd_ = -1;
+};
+
+/*-----------------------------------------------------------*/
+/*
+ * Events belong to the command whose window [submit, next submit) holds
+ * them; the first of each stage counts, the ACK only with the command's
+ * sequence number (when known) and gpio only after the mode.
+ */
+static void assign(std::vector<Command>& cmds, const std::vector<Event>& events) {
+    std::vector<Event> sorted(events);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const Event& a, const Event& b) { return a.cnt < b.cnt; });
+
+    size_t c = 0;
+    for (const Event& ev : sorted) {
+        while (c < cmds.size() && ev.cnt >= cmds[c].next_submit) c++;
+        if (c == cmds.size()) break;
+        Command& cmd = cmds[c];
+        if (ev.cnt < cmd.ts[ST_SUBMIT] || cmd.ts[ev.stage] != 0) continue;
+
+        if (ev.stage == ST_K_SEND && cmd.seq == 0) cmd.seq = ev.seq;
+        if (ev.stage == ST_ACK && cmd.seq != 0 && ev.seq != cmd.seq) continue;
+        if (ev.stage == ST_GPIO && (cmd.ts[ST_MODE] == 0 || ev.cnt < cmd.ts[ST_MODE])) continue;
+        cmd.ts[ev.stage] = ev.cnt;
+    }
+}
+
+// Each stage from the latest earlier stage that happened before it
+static void link_stages(Command& cmd) {
+    for (int s = ST_SUBMIT + 1; s < ST_COUNT; s++) {
+        if (cmd.ts[s] == 0) continue;
+        if (s == ST_GPIO) {
+            cmd.from[s] = ST_MODE;
+            continue;
+        }
+        cmd.from[s] = ST_SUBMIT;
+        for (int p = s - 1; p > ST_SUBMIT; p--) {
+            if (cmd.ts[p] != 0 && cmd.ts[p] <= cmd.ts[s]) {
+                cmd.from[s] = (Stage)p;
+                break;
+            }
+        }
+    }
+}
+
+static double percentile(std::vector<double>& v, double p) {
+    size_t idx = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + idx, v.end());
+    return v[idx];
+}
+
+static unsigned hist_bucket(double us) {
+    unsigned b = 0;
+    while (b + 1 < E2E_HIST_BUCKETS && us >= (double)(1U << b)) b++;
+    return b;
+}
+
+static void report(const std::vector<Command>& cmds, double ticks_per_us) {
+    std::printf("\n%-12s %-12s %-6s %-9s %-9s %-9s\n",
+                "stage", "from", "n", "p50_us", "p99_us", "max_us");
+
+    std::vector<std::vector<unsigned>> hist(ST_COUNT, std::vector<unsigned>(E2E_HIST_BUCKETS));
+    for (int s = ST_SUBMIT + 1; s < ST_COUNT; s++) {
+        std::vector<double> us;
+        Stage from = ST_SUBMIT;
+        for (const Command& cmd : cmds) {
+            if (!cmd.ok || cmd.ts[s] == 0) continue;
+            double d = (cmd.ts[s] - cmd.ts[cmd.from[s]]) / ticks_per_us;
+            us.push_back(d);
+            hist[s][hist_bucket(d)]++;
+            from = cmd.from[s];  // The most recent command's, for the label
+        }
+        if (us.empty()) continue;
+        double max = *std::max_element(us.begin(), us.end());
+        std::printf("%-12s %-12s %-6zu %-9.3f %-9.3f %-9.3f\n", STAGES[s].name, STAGES[from].name,
+                    us.size(), percentile(us, 50.0), percentile(us, 99.0), max);
+    }
+
+    std::printf("\n%-12s", "hist_us");
+    for (unsigned b = 0; b < E2E_HIST_BUCKETS; b++) {
+        char label[16];
+        if (b == 0) snprintf(label, sizeof(label), "<1");
+        else if (b + 1 == E2E_HIST_BUCKETS) snprintf(label, sizeof(label), "%u+", 1U << (b - 1));
+        else snprintf(label, sizeof(label), "%u", 1U << (b - 1));
+        std::printf(" %6s", label);
+    }
+    std::printf("\n");
+    for (int s = ST_SUBMIT + 1; s < ST_COUNT; s++) {
+        unsigned total = 0;
+        for (unsigned b = 0; b < E2E_HIST_BUCKETS; b++) total += hist[s][b];
+        if (total == 0) continue;
+        std::printf("%-12s", STAGES[s].name);
+        for (unsigned b = 0; b < E2E_HIST_BUCKETS; b++) std::printf(" %6u", hist[s][b]);
+        std::printf("\n");
+    }
+}
+
+/*
+ * Chrome JSON trace (ui.perfetto.dev and chrome://tracing open it): one
+ * process per domain, the commands on the APU's first thread, each stage a
+ * slice from the stage it is measured from on its domain's second thread.
+ */
+static bool write_perfetto(const char* path, const std::vector<Command>& cmds, double ticks_per_us) {
+    FILE* f = std::fopen(path, "w");
+    if (f == nullptr) return false;
+
+    const uint64_t t0 = cmds.empty() ? 0 : cmds.front().ts[ST_SUBMIT];
+    auto us = [&](uint64_t cnt) { return (double)(cnt - t0) / ticks_per_us; };
+    bool first = true;
+    auto sep = [&]() {
+        std::fprintf(f, first ? "\n" : ",\n");
+        first = false;
+    };
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    static const char* const DOMAIN_NAMES[] = {"", "APU", "Linux rpu_ipi", "RPU firmware"};
+    for (int d = DOM_APU; d <= DOM_RPU; d++) {
+        sep();
+        std::fprintf(f, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     d, DOMAIN_NAMES[d]);
+    }
+    for (size_t i = 0; i < cmds.size(); i++) {
+        const Command& cmd = cmds[i];
+        if (cmd.ts[ST_WAKEUP] == 0) continue;
+        sep();
+        std::fprintf(f, "{\"ph\":\"X\",\"name\":\"mode %u\",\"pid\":%d,\"tid\":1,\"ts\":%.3f,"
+                     "\"dur\":%.3f,\"args\":{\"index\":%zu,\"seq\":%u,\"ok\":%s}}",
+                     cmd.mode, DOM_APU, us(cmd.ts[ST_SUBMIT]),
+                     us(cmd.ts[ST_WAKEUP]) - us(cmd.ts[ST_SUBMIT]), i, cmd.seq,
+                     cmd.ok ? "true" : "false");
+        for (int s = ST_SUBMIT + 1; s < ST_COUNT; s++) {
+            if (cmd.ts[s] == 0 || s == ST_WAKEUP) continue;
+            sep();
+            std::fprintf(f, "{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":2,\"ts\":%.3f,"
+                         "\"dur\":%.3f,\"args\":{\"index\":%zu,\"from\":\"%s\"}}",
+                         STAGES[s].name, STAGES[s].domain, us(cmd.ts[cmd.from[s]]),
+                         us(cmd.ts[s]) - us(cmd.ts[cmd.from[s]]), i, STAGES[cmd.from[s]].name);
+        }
+    }
+    std::fprintf(f, "\n]}\n");
+    return std::fclose(f) == 0;
+}
+
+/*-----------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+    std::string path = "sysfs";
+    unsigned count = E2E_COUNT_DEFAULT;
+    unsigned interval_ms = E2E_INTERVAL_DEFAULT;
+    int fixed_mode = -1;
+    const char* perfetto = nullptr;
+
+    static const struct option long_opts[] = {
+        {"path",        required_argument, nullptr, 'p'},
+        {"count",       required_argument, nullptr, 'n'},
+        {"interval-ms", required_argument, nullptr, 'i'},
+        {"mode",        required_argument, nullptr, 'm'},
+        {"perfetto",    required_argument, nullptr, 'o'},
+        {"help",        no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:n:i:m:o:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'p': path = optarg; break;
+            case 'n': count = std::strtoul(optarg, nullptr, 0); break;
+            case 'i': interval_ms = std::strtoul(optarg, nullptr, 0); break;
+            case 'm': fixed_mode = (int)std::strtoul(optarg, nullptr, 0); break;
+            case 'o': perfetto = optarg; break;
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--path sysfs|dev|mem] [--count <n>]"
+                          << " [--interval-ms <ms>] [--mode <m>] [--perfetto <file>]" << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (path != "sysfs" && path != "dev" && path != "mem") {
+        std::cerr << "Unknown path '" << path << "'" << std::endl;
+        return 1;
+    }
+
+    // The firmware's trace, read-only
+    kr260hal::MemMap win;
+    if (!win.map_phys(kr260hal::shm_window_addr(0), SHARED_MEM_SIZE, false)) {
+        std::perror("Error mapping shared memory");
+        return 1;
+    }
+    if (win.read<shm::TraceMagic>() == SHM_TRACE_MAGIC_COMPACT) {
+        std::cerr << "The RPU firmware writes the compact trace (RPU_TRACE_COMPACT=1);"
+                  << " rpu_e2e needs the fixed entries" << std::endl;
+        return 1;
+    }
+    if (win.read<shm::TraceMagic>() != SHM_TRACE_MAGIC) {
+        std::cerr << "No RPU trace found; is the RPU firmware running?" << std::endl;
+        return 1;
+    }
+    const double ticks_per_us = kr260hal::window_counter_freq(win) / 1e6;
+
+    KernelTrace ktrace;
+    if (path != "mem" && !ktrace.open()) {
+        std::perror("Error setting up the rpu_ipi trace instance (tracefs, rpu_ipi module)");
+        return 1;
+    }
+
+    int sysfs_fd = -1;
+    kr260hal::IpiTransport ipi;
+    if (path == "sysfs") {
+        sysfs_fd = ::open(E2E_SYSFS_WRITE, O_WRONLY);
+        if (sysfs_fd == -1) {
+            std::perror("Error opening " E2E_SYSFS_WRITE);
+            return 1;
+        }
+    } else if (!ipi.open(0, path == "dev" ? kr260hal::IPI_BACKEND_DEV : kr260hal::IPI_BACKEND_MEM)) {
+        std::perror("Error opening the IPI transport");
+        return 1;
+    }
+
+    auto send = [&](uint32_t mode, Command& cmd) {
+        cmd.mode = mode;
+        cmd.ts[ST_SUBMIT] = counter_now();
+        if (sysfs_fd != -1) {
+            const char buf[] = {(char)('0' + mode), '\n'};
+            cmd.ok = pwrite(sysfs_fd, buf, sizeof(buf), 0) == (ssize_t)sizeof(buf);
+        } else {
+            kr260hal::IpiResult r = ipi.send_mode(mode);
+            cmd.ok = r.acked;
+            cmd.seq = r.seq;
+            cmd.ts[ST_DOORBELL] = r.doorbell_cnt;
+        }
+        cmd.ts[ST_WAKEUP] = counter_now();
+    };
+
+    std::vector<Command> cmds(count);
+    std::vector<Event> events;
+    uint32_t next = win.read_acquire<shm::TraceHead>();
+    uint32_t lost = 0;
+    ktrace.read(events);
+    events.clear();  // From before the first command
+
+    for (unsigned i = 0; i < count; i++) {
+        send(fixed_mode >= 0 ? (uint32_t)fixed_mode : (i & 1), cmds[i]);
+        usleep(interval_ms * 1000);
+
+        // Firmware and kernel events of this command
+        lost += read_rpu_events(win, &next, events);
+        ktrace.read(events);
+        cmds[i].next_submit = counter_now();
+        if (i > 0) cmds[i - 1].next_submit = cmds[i].ts[ST_SUBMIT];
+    }
+    Command release;
+    send(E2E_MODE_RELEASE, release);
+
+    assign(cmds, events);
+    unsigned failed = 0;
+    for (Command& cmd : cmds) {
+        link_stages(cmd);
+        if (!cmd.ok) failed++;
+    }
+
+    const uint64_t end_to_end = cmds.empty() ? 0 : cmds.back().ts[ST_WAKEUP] - cmds.front().ts[ST_SUBMIT];
+    std::printf("%u commands through %s in %.3f s, %u failed", count, path.c_str(),
+                end_to_end / ticks_per_us / 1e6, failed);
+    if (lost) std::printf(", %u firmware event(s) lost", lost);
+    std::printf("\n");
+    report(cmds, ticks_per_us);
+
+    if (perfetto != nullptr) {
+        if (!write_perfetto(perfetto, cmds, ticks_per_us)) {
+            std::perror("Error writing the trace");
+            return 1;
+        }
+        std::printf("\nTrace written to %s\n", perfetto);
+    }
+
+    if (sysfs_fd != -1) ::close(sysfs_fd);
+    return failed ? 1 : 0;
+}
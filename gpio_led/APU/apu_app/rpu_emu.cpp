@@ -0,0 +1,93 @@
+/*
+ * RPU emulator for running the APU tools on a development machine or in CI.
+ *
+ * Usage: ./rpu_emu                      (serve the host window of RPU0 until Ctrl-C)
+ *        ./rpu_emu --core 1             (the window of RPU1)
+ *        ./rpu_emu --service-ns 2000    (each command takes 2 us)
+ *        ./rpu_emu --keep               (leave the host file behind on exit)
+ *
+ * Serves the command protocols of common/rpu_shm.h (ABI header, legacy
+ * CMD/ACK words, command ring with doorbell moderation, IPI messages, reverse
+ * IPI) in the host file /dev/shm/kr260_rpu<core> (KR260_HOST_SHM_DIR
+ * overrides the directory), through kr260hal::HostRpu (host_rpu.h). Clients
+ * open it with IPI_BACKEND_HOST, e.g. in another shell:
+ *
+ *   ./ipi_bench --transport host-cmd,host-ring,host-pipe,host-msg
+ *
+ * or without this process, ipi_bench --emulate runs the same emulator in a
+ * thread of its own. The emulated firmware only keeps the state the command
+ * results report (blink mode, override, checked pattern programs): WAVE,
+ * HANDOFF and timed commands answer RPU_CMD_STATUS_BADOP.
+ *
+ * On exit it prints what it served:
+ *   doorbells  passes     commands
+ *   10234      10240      42101
+ */
+
+#include <iostream>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+
+#include "rpu_shm.h"
+#include "kr260hal/host_ipi.h"
+#include "kr260hal/host_rpu.h"
+
+static kr260hal::HostRpu emu;
+
+static void handle_sigint(int) {
+    emu.stop();
+}
+
+int main(int argc, char* argv[]) {
+    unsigned core = 0;
+    bool keep = false;
+
+    static const struct option long_opts[] = {
+        {"core",       required_argument, nullptr, 'c'},
+        {"service-ns", required_argument, nullptr, 's'},
+        {"keep",       no_argument,       nullptr, 'k'},
+        {"help",       no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "c:s:kh", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 's': emu.service_ns = std::strtoul(optarg, nullptr, 0); break;
+            case 'k': keep = true; break;
+            case 'c':
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core < RPU_CORE_COUNT) break;
+                // fall through
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--core <0|1>] [--service-ns <ns>] [--keep]"
+                          << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (!emu.open(core)) {
+        std::cerr << "Error creating " << kr260hal::host::shm_path(core) << ": "
+                  << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, handle_sigint);
+    std::signal(SIGTERM, handle_sigint);
+    std::printf("Emulating RPU%u in %s, %u ns per command; Ctrl-C to stop\n", core,
+                kr260hal::host::shm_path(core).c_str(), emu.service_ns);
+    std::fflush(stdout);
+
+    emu.run();
+
+    const kr260hal::HostRpuStats& stats = emu.stats();
+    std::printf("%-10s %-10s %s\n", "doorbells", "passes", "commands");
+    std::printf("%-10llu %-10llu %llu\n", (unsigned long long)stats.doorbells,
+                (unsigned long long)stats.passes, (unsigned long long)stats.commands);
+    emu.close(!keep);
+    return 0;
+}
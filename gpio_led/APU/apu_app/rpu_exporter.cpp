@@ -0,0 +1,881 @@
+/*
+ * APU daemon exporting the RPU telemetry as Prometheus / OpenMetrics text.
+ *
+ * Usage: ./rpu_exporter                      (port 9101, sample every 100 ms)
+ *        ./rpu_exporter --port <n>           (HTTP port)
+ *        ./rpu_exporter --listen <addr>      (IPv4 address to bind, default 0.0.0.0)
+ *        ./rpu_exporter --interval-ms <ms>   (sample period, default 100)
+ *        ./rpu_exporter --ipi-stats <path>   (rpu_ipi debugfs stats, "" = none;
+ *                                             default /sys/kernel/debug/rpu_ipi/stats)
+ *
+ *   curl http://kr260:9101/metrics
+ *
+ * Samples the blocks the RPU firmware already publishes, read-only from
+ * /dev/mem: nothing is written to the RPU and no doorbell is rung, so the
+ * firmware cannot tell the exporter is running. A sample is a handful of
+ * uncached loads per block with the seqlock protocol of rpu_stats, tried
+ * once: a block caught mid-update keeps its previous sample (counted in
+ * rpu_exporter_skipped_total) instead of spinning. The timerfd wake-up is
+ * the only system call per sample; the kernel's debugfs stats are read when
+ * a scrape comes in, not per sample.
+ *
+ * Between scrapes the samples feed:
+ *   rpu_task_cpu_seconds_total{core,task}  run time of each FreeRTOS task,
+ *       the 32-bit run time counters extended to 64 bits sample by sample
+ *   rpu_ring_queue_depth{core}, ..._max    command ring head - tail, now
+ *       and the deepest sample since the previous scrape
+ *   rpu_ring_commands_total, rpu_led_frames_total, rpu_commands_total
+ *   rpu_ipi_stage_seconds{core,stage}      IRQ profile histograms (RPU_IRQ_PROF=1),
+ *       the log2 cycle buckets as le bounds in seconds
+ *   rpu_apm_bytes_total{port,dir}, rpu_apm_bandwidth_bytes_per_second,
+ *       rpu_apm_read_latency_max_seconds    APM block (RPU0, RPU_APM=1)
+ *   rpu_temperature_celsius{sensor}, rpu_supply_volts{rail},
+ *       rpu_thermal_alarm, rpu_thermal_alarms_total   SYSMON block (RPU0)
+ *   rpu_ipi_ack_latency_seconds            doorbell to ACK histogram of rpu_ipi
+ *   rpu_ipi_messages_total, ..._timeouts_total, ...  rpu_ipi counters
+ * A block the firmware does not publish (magic not set) is left out of the
+ * output; the magic words are checked at every sample, so a firmware
+ * restarted with them enabled shows up without restarting the exporter.
+ *
+ * A scrape whose Accept header names application/openmetrics-text gets the
+ * OpenMetrics 1.0 exposition (unit metadata, # EOF), anything else the
+ * Prometheus 0.0.4 text format. Only GET /metrics is served, one request per
+ * connection.
+ *
+ * Memory Map:
+ *   0xFF990000: Shared memory window of RPU0 (ring, status, task stats)
+ *   0xFFFC0000: Shared memory window of RPU1
+ *   0xFFFC3000: IRQ profile block (RPU1 at 0xFFFC4000)
+ *   0xFFFC5000: APM block
+ *   0xFFFC6000: SYSMON block
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <strings.h>
+#include <cerrno>
+#include <csignal>
+#include <map>
+#include <memory>
+#include <string>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#include "rpu_shm.h"
+#include "kr260hal/event_loop.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/shm_regs.h"
+#include "kr260hal/timebase.h"
+
+namespace shm = kr260hal::shm;
+namespace barrier = kr260hal::barrier;
+
+#define EXPORTER_PORT_DEFAULT      9101
+#define EXPORTER_INTERVAL_DEFAULT  100
+#define EXPORTER_MAX_CLIENTS       16
+#define EXPORTER_REQUEST_MAX       8192
+#define EXPORTER_CLIENT_TIMEOUT_S  10
+#define EXPORTER_KSTATS_PATH       "/sys/kernel/debug/rpu_ipi/stats"
+#define EXPORTER_KHIST_BUCKETS     32    /* LAT_HIST_BUCKETS of rpu_ipi.c */
+
+static const char* const STAGE_NAMES[IRQPROF_STAGES] = {
+    "isr_exit", "task", "ack", "done"
+};
+
+static const char* const APM_PORT_NAMES[APM_MAX_PORTS] = {
+    "ocm", "lpd", "cci", "?"
+};
+
+static const char* const SUPPLY_NAMES[] = {
+    "vcc_psintlp", "vcc_psintfp", "vcc_psaux", "vcc_psddr"
+};
+
+// Extends a wrapping 32-bit counter to 64 bits, one sample at a time
+struct counter64 {
+    uint64_t total = 0;
+    uint32_t last = 0;
+
+    void update(uint32_t now) {
+        total += (uint32_t)(now - last);
+        last = now;
+    }
+    // Firmware restarted: the counter counts again from zero
+    void restart(uint32_t now) {
+        total += now;
+        last = now;
+    }
+};
+
+struct task_state {
+    std::string name;
+    uint8_t priority = 0;
+    uint32_t stack_free = 0;
+    counter64 run;
+};
+
+struct core_state {
+    kr260hal::MemMap win, irq;
+    bool have_irq = false;
+
+    // Command ring
+    counter64 ring_commands;
+    bool ring_started = false;
+    uint32_t depth = 0, depth_max = 0;
+
+    // Status block
+    bool status_ok = false;
+    uint32_t mode = 0;
+    uint32_t status_seq = 0;
+    counter64 frames, commands;
+
+    // Task stats, keyed by task number
+    bool stats_ok = false;
+    uint32_t stats_tick = 0;
+    uint32_t stats_hz = 0;
+    uint32_t heap = 0, heap_min = 0;
+    std::map<unsigned, task_state> tasks;
+
+    // IRQ profile
+    bool irq_ok = false;
+    uint32_t irq_hz = 0, passes = 0;
+    rpu_irqprof_stage stages[IRQPROF_STAGES] = {};
+};
+
+struct soc_state {
+    kr260hal::MemMap apm, sysmon;
+    bool have_apm = false, have_sysmon = false;
+
+    bool apm_ok = false;
+    uint32_t apm_ticks = 0, apm_count = 0;
+    rpu_apm_port ports[APM_MAX_PORTS] = {};
+
+    bool sysmon_ok = false;
+    uint32_t sysmon_count = 0, sysmon_flags = 0, sysmon_alarms = 0;
+    rpu_sysmon_channel ch[SYSMON_MAX_CHANNELS] = {};
+};
+
+struct exporter_stats {
+    uint64_t samples = 0;
+    uint64_t skipped = 0;
+    uint64_t scrapes = 0;
+};
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+static double now_s() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ----------------------------------------------------------------------------
+// Sampling: loads only, every seqlock tried once
+// ----------------------------------------------------------------------------
+
+static void copy_words(const kr260hal::MemMap& blk, uintptr_t off, void* dst, size_t size) {
+    volatile uint32_t* src = blk.at(off);
+    uint32_t words[32];
+    for (size_t w = 0; w < size / 4; w++) words[w] = src[w];
+    std::memcpy(dst, words, size);
+}
+
+static void sample_ring(core_state& c) {
+    const uint32_t head = c.win.read<shm::RingHead>();
+    const uint32_t tail = c.win.read<shm::RingTail>();
+    // A head that went back is a ring reset by a new firmware
+    if (!c.ring_started || (uint32_t)(head - c.ring_commands.last) > (1u << 31))
+        c.ring_commands.restart(head);
+    else
+        c.ring_commands.update(head);
+    c.ring_started = true;
+    c.depth = head - tail;
+    if (c.depth > SHM_RING_SLOTS) c.depth = 0;    // Torn pair or reset ring
+    if (c.depth > c.depth_max) c.depth_max = c.depth;
+}
+
+static bool sample_status(core_state& c) {
+    if (c.win.read<shm::StatusMagic>() != SHM_STATUS_MAGIC) {
+        c.status_ok = false;
+        return true;
+    }
+    const uint32_t s = c.win.read<shm::StatusSeq>();
+    if (s & 1) return false;
+    barrier::acquire();
+    const uint32_t mode = c.win.read<shm::StatusMode>();
+    const uint32_t frames = c.win.read<shm::StatusFrames>();
+    const uint32_t commands = c.win.read<shm::StatusCommands>();
+    barrier::acquire();
+    if (c.win.read<shm::StatusSeq>() != s) return false;
+
+    c.mode = mode;
+    if (!c.status_ok || s < c.status_seq) {
+        c.frames.restart(frames);
+        c.commands.restart(commands);
+    } else {
+        c.frames.update(frames);
+        c.commands.update(commands);
+    }
+    c.status_seq = s;
+    c.status_ok = true;
+    return true;
+}
+
+static bool sample_stats(core_state& c) {
+    if (c.win.read<shm::StatsMagic>() != SHM_STATS_MAGIC) {
+        c.stats_ok = false;
+        return true;
+    }
+    const uint32_t s = c.win.read<shm::StatsSeq>();
+    if (s & 1) return false;
+    barrier::acquire();
+    const uint32_t tick = c.win.read<shm::StatsTick>();
+    const uint32_t hz = c.win.read<shm::StatsHz>();
+    const uint32_t heap = c.win.read<shm::StatsHeap>();
+    const uint32_t heap_min = c.win.read<shm::StatsHeapMin>();
+    const uint32_t count = std::min<uint32_t>(c.win.read<shm::StatsCount>(), SHM_STATS_MAX_TASKS);
+    rpu_shm_task_stat entries[SHM_STATS_MAX_TASKS];
+    for (uint32_t i = 0; i < count; i++)
+        copy_words(c.win, SHM_STATS_ENTRY(i), &entries[i], SHM_STATS_ENTRY_SIZE);
+    barrier::acquire();
+    if (c.win.read<shm::StatsSeq>() != s) return false;
+
+    // The tick count only goes back when the firmware restarted
+    const bool restarted = !c.stats_ok || tick < c.stats_tick;
+    for (uint32_t i = 0; i < count; i++) {
+        const rpu_shm_task_stat& e = entries[i];
+        task_state& t = c.tasks[e.number];
+        t.name.assign(e.name, strnlen(e.name, SHM_STATS_NAME_LEN));
+        t.priority = e.priority;
+        t.stack_free = e.stack_free;
+        if (restarted) t.run.restart(e.run_time);
+        else t.run.update(e.run_time);
+    }
+    c.stats_tick = tick;
+    c.stats_hz = hz;
+    c.heap = heap;
+    c.heap_min = heap_min;
+    c.stats_ok = true;
+    return true;
+}
+
+static bool sample_irqprof(core_state& c) {
+    if (!c.have_irq || *c.irq.at(IRQPROF_MAGIC_OFFSET) != IRQPROF_MAGIC) {
+        c.irq_ok = false;
+        return true;
+    }
+    const uint32_t s = *c.irq.at(IRQPROF_SEQ_OFFSET);
+    if (s & 1) return false;
+    barrier::acquire();
+    rpu_irqprof_stage stages[IRQPROF_STAGES];
+    const uint32_t hz = *c.irq.at(IRQPROF_HZ_OFFSET);
+    const uint32_t passes = *c.irq.at(IRQPROF_PASSES_OFFSET);
+    for (unsigned i = 0; i < IRQPROF_STAGES; i++)
+        copy_words(c.irq, IRQPROF_STAGE(i), &stages[i], IRQPROF_STAGE_SIZE);
+    barrier::acquire();
+    if (*c.irq.at(IRQPROF_SEQ_OFFSET) != s) return false;
+
+    c.irq_hz = hz;
+    c.passes = passes;
+    std::memcpy(c.stages, stages, sizeof(stages));
+    c.irq_ok = true;
+    return true;
+}
+
+static bool sample_apm(soc_state& soc) {
+    if (!soc.have_apm || *soc.apm.at(APM_MAGIC_OFFSET) != APM_MAGIC) {
+        soc.apm_ok = false;
+        return true;
+    }
+    const uint32_t s = *soc.apm.at(APM_SEQ_OFFSET);
+    if (s & 1) return false;
+    barrier::acquire();
+    rpu_apm_port ports[APM_MAX_PORTS];
+    const uint32_t ticks = *soc.apm.at(APM_TICKS_OFFSET);
+    const uint32_t count = std::min<uint32_t>((uint32_t)*soc.apm.at(APM_COUNT_OFFSET), APM_MAX_PORTS - 1);
+    for (unsigned i = 0; i < count; i++)
+        copy_words(soc.apm, APM_PORT(i), &ports[i], APM_PORT_SIZE);
+    barrier::acquire();
+    if (*soc.apm.at(APM_SEQ_OFFSET) != s) return false;
+
+    soc.apm_ticks = ticks;
+    soc.apm_count = count;
+    std::memcpy(soc.ports, ports, count * sizeof(ports[0]));
+    soc.apm_ok = true;
+    return true;
+}
+
+static bool sample_sysmon(soc_state& soc) {
+    if (!soc.have_sysmon || *soc.sysmon.at(SYSMON_MAGIC_OFFSET) != SYSMON_MAGIC) {
+        soc.sysmon_ok = false;
+        return true;
+    }
+    const uint32_t s = *soc.sysmon.at(SYSMON_SEQ_OFFSET);
+    if (s & 1) return false;
+    barrier::acquire();
+    rpu_sysmon_channel ch[SYSMON_MAX_CHANNELS];
+    const uint32_t count = std::min<uint32_t>((uint32_t)*soc.sysmon.at(SYSMON_COUNT_OFFSET), SYSMON_MAX_CHANNELS);
+    const uint32_t flags = *soc.sysmon.at(SYSMON_FLAGS_OFFSET);
+    const uint32_t alarms = *soc.sysmon.at(SYSMON_ALARMS_OFFSET);
+    for (unsigned i = 0; i < count; i++)
+        copy_words(soc.sysmon, SYSMON_CH(i), &ch[i], SYSMON_CH_SIZE);
+    barrier::acquire();
+    if (*soc.sysmon.at(SYSMON_SEQ_OFFSET) != s) return false;
+
+    soc.sysmon_count = count;
+    soc.sysmon_flags = flags;
+    soc.sysmon_alarms = alarms;
+    std::memcpy(soc.ch, ch, count * sizeof(ch[0]));
+    soc.sysmon_ok = true;
+    return true;
+}
+
+static void sample_all(core_state* cores, soc_state& soc, exporter_stats& st) {
+    unsigned skipped = 0;
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++) {
+        core_state& c = cores[core];
+        sample_ring(c);
+        skipped += !sample_status(c);
+        skipped += !sample_stats(c);
+        skipped += !sample_irqprof(c);
+    }
+    skipped += !sample_apm(soc);
+    skipped += !sample_sysmon(soc);
+    st.samples++;
+    st.skipped += skipped;
+}
+
+// ----------------------------------------------------------------------------
+// Kernel counters: /sys/kernel/debug/rpu_ipi/stats, read per scrape
+// ----------------------------------------------------------------------------
+
+struct kernel_stats {
+    std::map<std::string, unsigned long long> counters;
+    bool attached = false;
+    unsigned long long lat_avg_ns = 0;
+    unsigned long long hist[EXPORTER_KHIST_BUCKETS] = {};
+};
+
+static bool read_kernel_stats(const std::string& path, kernel_stats& ks) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        char key[32];
+        unsigned long long a, b, c;
+        char state[16];
+        if (std::sscanf(line.c_str(), " [%llu, %llu): %llu", &a, &b, &c) == 3) {
+            // Bucket i is [2^i, 2^(i+1)) ns, the first from 0, the last open
+            unsigned i = 0;
+            while (i + 1 < EXPORTER_KHIST_BUCKETS && (2ULL << i) < b) i++;
+            ks.hist[i] = c;
+        } else if (std::sscanf(line.c_str(), "latency_ns min/avg/max: %llu/%llu/%llu", &a, &b, &c) == 3) {
+            ks.lat_avg_ns = b;
+        } else if (std::sscanf(line.c_str(), "firmware: %15s", state) == 1) {
+            ks.attached = std::strcmp(state, "attached") == 0;
+        } else if (std::sscanf(line.c_str(), "%31[a-z_]: %llu", key, &a) == 2) {
+            ks.counters[key] = a;
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Exposition
+// ----------------------------------------------------------------------------
+
+class Exposition {
+public:
+    explicit Exposition(bool openmetrics) : om_(openmetrics) {}
+
+    // Metric family header; counters are named without _total in OpenMetrics
+    void family(const char* name, const char* type, const char* help, const char* unit = nullptr) {
+        std::string base = name;
+        if (om_ && std::strcmp(type, "counter") == 0 && ends_with(base, "_total"))
+            base.resize(base.size() - 6);
+        out_ += "# HELP " + base + " " + help + "\n";
+        out_ += "# TYPE " + base + " " + type + "\n";
+        if (om_ && unit) out_ += "# UNIT " + base + " " + unit + "\n";
+    }
+
+    void sample(const std::string& name, const std::string& labels, double value) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.17g", value);
+        line(name, labels, buf);
+    }
+
+    void sample(const std::string& name, const std::string& labels, uint64_t value) {
+        line(name, labels, std::to_string(value));
+    }
+
+    // Cumulative histogram from per-bucket counts; bounds[i] is the upper
+    // bound of bucket i in the unit of the metric, the last bucket is open
+    void histogram(const std::string& name, const std::string& labels, const double* bounds,
+                   const uint64_t* counts, unsigned buckets, uint64_t count, double sum) {
+        const std::string sep = labels.empty() ? "" : ",";
+        uint64_t cumulative = 0;
+        for (unsigned b = 0; b + 1 < buckets; b++) {
+            cumulative += counts[b];
+            char le[48];
+            std::snprintf(le, sizeof(le), "le=\"%.9g\"", bounds[b]);
+            sample(name + "_bucket", labels + sep + le, cumulative);
+        }
+        sample(name + "_bucket", labels + sep + "le=\"+Inf\"", count);
+        sample(name + "_count", labels, count);
+        sample(name + "_sum", labels, sum);
+    }
+
+    std::string finish() {
+        if (om_) out_ += "# EOF\n";
+        return std::move(out_);
+    }
+
+    const char* content_type() const {
+        return om_ ? "application/openmetrics-text; version=1.0.0; charset=utf-8"
+                   : "text/plain; version=0.0.4; charset=utf-8";
+    }
+
+private:
+    static bool ends_with(const std::string& s, const char* suffix) {
+        const size_t n = std::strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    void line(const std::string& name, const std::string& labels, const std::string& value) {
+        out_ += name;
+        if (!labels.empty()) out_ += "{" + labels + "}";
+        out_ += " " + value + "\n";
+    }
+
+    bool om_;
+    std::string out_;
+};
+
+static std::string label(const char* key, const std::string& value) {
+    std::string s = std::string(key) + "=\"";
+    for (char ch : value) {
+        if (ch == '"' || ch == '\\') s += '\\';
+        if (ch == '\n') {
+            s += "\\n";
+            continue;
+        }
+        s += ch;
+    }
+    return s + "\"";
+}
+
+static std::string core_label(unsigned core) {
+    return label("core", std::to_string(core));
+}
+
+static void export_cores(Exposition& ex, core_state* cores) {
+    ex.family("rpu_ring_queue_depth", "gauge", "Commands in the ring, head - tail");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++)
+        ex.sample("rpu_ring_queue_depth", core_label(core), (uint64_t)cores[core].depth);
+    ex.family("rpu_ring_queue_depth_max", "gauge", "Deepest ring sample since the previous scrape");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++) {
+        ex.sample("rpu_ring_queue_depth_max", core_label(core), (uint64_t)cores[core].depth_max);
+        cores[core].depth_max = cores[core].depth;
+    }
+    ex.family("rpu_ring_commands_total", "counter", "Commands posted to the ring");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++)
+        ex.sample("rpu_ring_commands_total", core_label(core), cores[core].ring_commands.total);
+
+    ex.family("rpu_led_mode", "gauge", "Blink mode (0=SLOW 1=FAST 2=RANDOM 3=PATTERN)");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++)
+        if (cores[core].status_ok) ex.sample("rpu_led_mode", core_label(core), (uint64_t)cores[core].mode);
+    ex.family("rpu_led_frames_total", "counter", "LED frames written");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++)
+        if (cores[core].status_ok) ex.sample("rpu_led_frames_total", core_label(core), cores[core].frames.total);
+    ex.family("rpu_commands_total", "counter", "Commands served on all paths");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++)
+        if (cores[core].status_ok) ex.sample("rpu_commands_total", core_label(core), cores[core].commands.total);
+
+    ex.family("rpu_task_cpu_seconds_total", "counter", "Run time of the FreeRTOS task", "seconds");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++) {
+        const core_state& c = cores[core];
+        if (!c.stats_ok || c.stats_hz == 0) continue;
+        for (const auto& kv : c.tasks)
+            ex.sample("rpu_task_cpu_seconds_total", core_label(core) + "," + label("task", kv.second.name),
+                      (double)kv.second.run.total / c.stats_hz);
+    }
+    ex.family("rpu_task_stack_free_bytes", "gauge", "Stack high water mark of the task", "bytes");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++) {
+        const core_state& c = cores[core];
+        if (!c.stats_ok) continue;
+        for (const auto& kv : c.tasks)
+            ex.sample("rpu_task_stack_free_bytes", core_label(core) + "," + label("task", kv.second.name),
+                      (uint64_t)kv.second.stack_free);
+    }
+    ex.family("rpu_heap_free_bytes", "gauge", "Free FreeRTOS heap", "bytes");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++)
+        if (cores[core].stats_ok) ex.sample("rpu_heap_free_bytes", core_label(core), (uint64_t)cores[core].heap);
+    ex.family("rpu_heap_free_min_bytes", "gauge", "Lowest free FreeRTOS heap so far", "bytes");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++)
+        if (cores[core].stats_ok) ex.sample("rpu_heap_free_min_bytes", core_label(core), (uint64_t)cores[core].heap_min);
+
+    ex.family("rpu_ipi_stage_seconds", "histogram",
+              "IPI_Handler entry to each stage of the IPI task pass", "seconds");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++) {
+        const core_state& c = cores[core];
+        if (!c.irq_ok || c.irq_hz == 0) continue;
+        double bounds[IRQPROF_BUCKETS];
+        for (unsigned b = 0; b < IRQPROF_BUCKETS; b++)
+            bounds[b] = (double)(1ULL << (b + IRQPROF_BUCKET_SHIFT)) / c.irq_hz;
+        for (unsigned i = 0; i < IRQPROF_STAGES; i++) {
+            const rpu_irqprof_stage& s = c.stages[i];
+            uint64_t counts[IRQPROF_BUCKETS];
+            for (unsigned b = 0; b < IRQPROF_BUCKETS; b++) counts[b] = s.hist[b];
+            const uint64_t sum = ((uint64_t)s.sum_hi << 32) | s.sum_lo;
+            ex.histogram("rpu_ipi_stage_seconds", core_label(core) + "," + label("stage", STAGE_NAMES[i]),
+                         bounds, counts, IRQPROF_BUCKETS, s.count, (double)sum / c.irq_hz);
+        }
+    }
+    ex.family("rpu_ipi_passes_total", "counter", "IPI task passes profiled");
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++)
+        if (cores[core].irq_ok) ex.sample("rpu_ipi_passes_total", core_label(core), (uint64_t)cores[core].passes);
+}
+
+static void export_soc(Exposition& ex, const soc_state& soc) {
+    if (soc.apm_ok) {
+        const double hz = (double)kr260hal::counter_freq();
+        ex.family("rpu_apm_bytes_total", "counter", "Bytes through the port since the firmware started", "bytes");
+        for (unsigned i = 0; i < soc.apm_count; i++) {
+            const rpu_apm_port& p = soc.ports[i];
+            const std::string port = label("port", APM_PORT_NAMES[i]);
+            ex.sample("rpu_apm_bytes_total", port + ",dir=\"write\"",
+                      ((uint64_t)p.wr_total_hi << 32) | p.wr_total_lo);
+            ex.sample("rpu_apm_bytes_total", port + ",dir=\"read\"",
+                      ((uint64_t)p.rd_total_hi << 32) | p.rd_total_lo);
+        }
+        ex.family("rpu_apm_bandwidth_bytes_per_second", "gauge", "Port bandwidth over the last APM interval");
+        for (unsigned i = 0; i < soc.apm_count && soc.apm_ticks; i++) {
+            const rpu_apm_port& p = soc.ports[i];
+            const double interval = soc.apm_ticks / hz;
+            const std::string port = label("port", APM_PORT_NAMES[i]);
+            ex.sample("rpu_apm_bandwidth_bytes_per_second", port + ",dir=\"write\"", p.wr_bytes / interval);
+            ex.sample("rpu_apm_bandwidth_bytes_per_second", port + ",dir=\"read\"", p.rd_bytes / interval);
+        }
+        ex.family("rpu_apm_read_latency_max_seconds", "gauge",
+                  "Longest read on the port in the last APM interval", "seconds");
+        for (unsigned i = 0; i < soc.apm_count; i++) {
+            const rpu_apm_port& p = soc.ports[i];
+            if (p.cycles == 0 || soc.apm_ticks == 0) continue;
+            // APM clocks to seconds through the interval both counters span
+            const double apm_hz = p.cycles / (soc.apm_ticks / hz);
+            ex.sample("rpu_apm_read_latency_max_seconds", label("port", APM_PORT_NAMES[i]),
+                      p.rd_lat_max / apm_hz);
+        }
+    }
+
+    if (soc.sysmon_ok) {
+        ex.family("rpu_temperature_celsius", "gauge", "Die temperature", "celsius");
+        if (soc.sysmon_count > SYSMON_CH_TEMP_LPD)
+            ex.sample("rpu_temperature_celsius", "sensor=\"lpd\"", soc.ch[SYSMON_CH_TEMP_LPD].value / 1000.0);
+        if (soc.sysmon_count > SYSMON_CH_TEMP_FPD)
+            ex.sample("rpu_temperature_celsius", "sensor=\"fpd\"", soc.ch[SYSMON_CH_TEMP_FPD].value / 1000.0);
+        ex.family("rpu_supply_volts", "gauge", "PS supply voltage", "volts");
+        for (unsigned i = SYSMON_CH_VCC_PSINTLP; i < soc.sysmon_count && i <= SYSMON_CH_VCC_PSDDR; i++)
+            ex.sample("rpu_supply_volts", label("rail", SUPPLY_NAMES[i - SYSMON_CH_VCC_PSINTLP]),
+                      soc.ch[i].value / 1000.0);
+        ex.family("rpu_thermal_alarm", "gauge", "Temperature alarm active (the RPU sheds load)");
+        ex.sample("rpu_thermal_alarm", "", (uint64_t)((soc.sysmon_flags & SYSMON_FLAG_HOT) != 0));
+        ex.family("rpu_thermal_alarms_total", "counter", "Times the temperature alarm was set");
+        ex.sample("rpu_thermal_alarms_total", "", (uint64_t)soc.sysmon_alarms);
+    }
+}
+
+static void export_kernel(Exposition& ex, const kernel_stats& ks) {
+    static const struct {
+        const char* key;
+        const char* name;
+        const char* help;
+    } COUNTERS[] = {
+        {"messages",         "rpu_ipi_messages_total",         "Commands sent through rpu_ipi"},
+        {"acks",             "rpu_ipi_acks_total",             "Commands acknowledged by the RPU"},
+        {"timeouts",         "rpu_ipi_timeouts_total",         "Commands not acknowledged in time"},
+        {"bad_acks",         "rpu_ipi_bad_acks_total",         "Acknowledgments with a bad magic or echo"},
+        {"ipi_msgs",         "rpu_ipi_msg_total",              "Commands sent in the IPI message buffer"},
+        {"ipi_msg_timeouts", "rpu_ipi_msg_timeouts_total",     "IPI message commands not answered in time"},
+        {"ack_irqs",         "rpu_ipi_ack_irqs_total",         "Reverse IPIs taken"},
+        {"attaches",         "rpu_ipi_firmware_attaches_total", "Times the firmware came up"},
+        {"detaches",         "rpu_ipi_firmware_detaches_total", "Times the firmware went away"},
+        {"ring_failed",      "rpu_ipi_ring_failed_total",      "Ring commands the RPU failed"},
+    };
+    for (const auto& c : COUNTERS) {
+        auto it = ks.counters.find(c.key);
+        if (it == ks.counters.end()) continue;
+        ex.family(c.name, "counter", c.help);
+        ex.sample(c.name, "", (uint64_t)it->second);
+    }
+    ex.family("rpu_ipi_firmware_attached", "gauge", "rpu_ipi sees a running firmware");
+    ex.sample("rpu_ipi_firmware_attached", "", (uint64_t)ks.attached);
+
+    auto acks = ks.counters.find("acks");
+    if (acks == ks.counters.end()) return;
+    double bounds[EXPORTER_KHIST_BUCKETS];
+    uint64_t counts[EXPORTER_KHIST_BUCKETS];
+    for (unsigned i = 0; i < EXPORTER_KHIST_BUCKETS; i++) {
+        bounds[i] = (double)(2ULL << i) / 1e9;
+        counts[i] = ks.hist[i];
+    }
+    // rpu_ipi publishes the mean, not the sum: the product is exact to a
+    // nanosecond per acknowledgment
+    ex.family("rpu_ipi_ack_latency_seconds", "histogram", "Doorbell to ACK time seen by rpu_ipi", "seconds");
+    ex.histogram("rpu_ipi_ack_latency_seconds", "", bounds, counts, EXPORTER_KHIST_BUCKETS, acks->second,
+                 (double)ks.lat_avg_ns * acks->second / 1e9);
+}
+
+static std::string render(bool openmetrics, core_state* cores, const soc_state& soc,
+                          const std::string& kstats_path, exporter_stats& st) {
+    Exposition ex(openmetrics);
+    st.scrapes++;
+    export_cores(ex, cores);
+    export_soc(ex, soc);
+    kernel_stats ks;
+    if (!kstats_path.empty() && read_kernel_stats(kstats_path, ks)) export_kernel(ex, ks);
+
+    ex.family("rpu_exporter_samples_total", "counter", "Samples taken of the RPU blocks");
+    ex.sample("rpu_exporter_samples_total", "", st.samples);
+    ex.family("rpu_exporter_skipped_total", "counter", "Block samples skipped, caught mid-update");
+    ex.sample("rpu_exporter_skipped_total", "", st.skipped);
+    ex.family("rpu_exporter_scrapes_total", "counter", "Scrapes served");
+    ex.sample("rpu_exporter_scrapes_total", "", st.scrapes);
+
+    const char* type = ex.content_type();
+    std::string body = ex.finish();
+    return std::string("HTTP/1.1 200 OK\r\nContent-Type: ") + type +
+           "\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\nConnection: close\r\n\r\n" + body;
+}
+
+// ----------------------------------------------------------------------------
+// HTTP: one request per connection, non-blocking
+// ----------------------------------------------------------------------------
+
+struct client {
+    int fd;
+    double opened;
+    std::string in, out;
+    size_t sent = 0;
+};
+
+static std::string error_response(const char* status) {
+    return std::string("HTTP/1.1 ") + status +
+           "\r\nContent-Type: text/plain\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+}
+
+static bool accepts_openmetrics(const std::string& request) {
+    size_t pos = 0;
+    while ((pos = request.find("\r\n", pos)) != std::string::npos) {
+        pos += 2;
+        if (strncasecmp(request.c_str() + pos, "accept:", 7) != 0) continue;
+        const size_t end = request.find("\r\n", pos);
+        return request.substr(pos, end - pos).find("application/openmetrics-text") != std::string::npos;
+    }
+    return false;
+}
+
+static int open_listener(const char* addr, unsigned port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in sa = {};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    if (inet_pton(AF_INET, addr, &sa.sin_addr) != 1) {
+        errno = EINVAL;
+        close(fd);
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, EXPORTER_MAX_CLIENTS) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned port = EXPORTER_PORT_DEFAULT;
+    const char* listen_addr = "0.0.0.0";
+    unsigned interval_ms = EXPORTER_INTERVAL_DEFAULT;
+    std::string kstats_path = EXPORTER_KSTATS_PATH;
+
+    static const struct option long_opts[] = {
+        {"port",        required_argument, nullptr, 'p'},
+        {"listen",      required_argument, nullptr, 'l'},
+        {"interval-ms", required_argument, nullptr, 'i'},
+        {"ipi-stats",   required_argument, nullptr, 'k'},
+        {"help",        no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:l:i:k:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'p':
+                port = std::strtoul(optarg, nullptr, 0);
+                if (port > 0 && port < 65536) break;
+                goto usage;
+            case 'l': listen_addr = optarg; break;
+            case 'i': interval_ms = std::strtoul(optarg, nullptr, 0); break;
+            case 'k': kstats_path = optarg; break;
+            case 'h':
+            default:
+            usage:
+                std::cerr << "Usage: " << argv[0] << " [--port <n>] [--listen <addr>] [--interval-ms <ms>]"
+                          << " [--ipi-stats <path>]" << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (interval_ms == 0) interval_ms = EXPORTER_INTERVAL_DEFAULT;
+
+    core_state cores[RPU_CORE_COUNT];
+    soc_state soc;
+    for (unsigned core = 0; core < RPU_CORE_COUNT; core++) {
+        core_state& c = cores[core];
+        if (!c.win.map_phys(kr260hal::shm_window_addr(core), SHARED_MEM_SIZE, false)) {
+            std::perror("Error mapping the shared window");
+            return 1;
+        }
+        c.have_irq = c.irq.map_phys(IRQPROF_ADDR(core), IRQPROF_SIZE, false);
+    }
+    soc.have_apm = soc.apm.map_phys(APM_ADDR, APM_SIZE, false);
+    soc.have_sysmon = soc.sysmon.map_phys(SYSMON_ADDR, SYSMON_SIZE, false);
+
+    int listen_fd = open_listener(listen_addr, port);
+    if (listen_fd < 0) {
+        std::perror("Error opening the HTTP socket");
+        return 1;
+    }
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec its = {};
+    its.it_interval.tv_sec = interval_ms / 1000;
+    its.it_interval.tv_nsec = (interval_ms % 1000) * 1000000L;
+    its.it_value = its.it_interval;
+    if (timer_fd < 0 || timerfd_settime(timer_fd, 0, &its, nullptr) != 0) {
+        std::perror("Error creating the sample timer");
+        return 1;
+    }
+
+    kr260hal::EventLoop loop;
+    if (!loop.open()) {
+        std::perror("Error creating the event loop");
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    std::signal(SIGTERM, handle_sigint);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    exporter_stats st;
+    std::map<int, std::unique_ptr<client>> clients;
+
+    auto drop = [&](int fd) {
+        loop.remove(fd);
+        close(fd);
+        clients.erase(fd);
+    };
+
+    auto on_client = [&](int fd, uint32_t revents) {
+        client& cl = *clients[fd];
+        if (revents & (EPOLLERR | EPOLLHUP)) {
+            drop(fd);
+            return;
+        }
+        if (cl.out.empty() && (revents & EPOLLIN)) {
+            char buf[1024];
+            ssize_t n;
+            while ((n = read(fd, buf, sizeof(buf))) > 0) cl.in.append(buf, n);
+            if (n == 0 || (n < 0 && errno != EAGAIN)) {
+                drop(fd);
+                return;
+            }
+            if (cl.in.find("\r\n\r\n") == std::string::npos) {
+                if (cl.in.size() > EXPORTER_REQUEST_MAX) {
+                    cl.out = error_response("431 Request Header Fields Too Large");
+                } else {
+                    return;
+                }
+            } else if (cl.in.compare(0, 4, "GET ") != 0) {
+                cl.out = error_response("405 Method Not Allowed");
+            } else if (cl.in.compare(4, 9, "/metrics ") != 0 && cl.in.compare(4, 9, "/metrics?") != 0) {
+                cl.out = error_response("404 Not Found");
+            } else {
+                cl.out = render(accepts_openmetrics(cl.in), cores, soc, kstats_path, st);
+            }
+            loop.modify(fd, EPOLLOUT);
+        }
+        if (!cl.out.empty()) {
+            while (cl.sent < cl.out.size()) {
+                ssize_t n = write(fd, cl.out.data() + cl.sent, cl.out.size() - cl.sent);
+                if (n < 0) {
+                    if (errno == EAGAIN) return;
+                    break;
+                }
+                cl.sent += n;
+            }
+            drop(fd);
+        }
+    };
+
+    loop.add(listen_fd, EPOLLIN, [&](uint32_t) {
+        int fd;
+        while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            if (clients.size() >= EXPORTER_MAX_CLIENTS) {
+                close(fd);
+                continue;
+            }
+            auto cl = std::make_unique<client>();
+            cl->fd = fd;
+            cl->opened = now_s();
+            clients[fd] = std::move(cl);
+            loop.add(fd, EPOLLIN, [&, fd](uint32_t revents) { on_client(fd, revents); });
+        }
+    });
+
+    loop.add(timer_fd, EPOLLIN, [&](uint32_t) {
+        uint64_t expirations;
+        if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+        sample_all(cores, soc, st);
+
+        // Clients that never finish a request
+        const double now = now_s();
+        for (auto it = clients.begin(); it != clients.end();) {
+            const int fd = (it++)->first;
+            if (now - clients[fd]->opened > EXPORTER_CLIENT_TIMEOUT_S) drop(fd);
+        }
+    });
+
+    sample_all(cores, soc, st);
+    std::cout << "rpu_exporter: serving http://" << listen_addr << ":" << port << "/metrics, sampling every "
+              << interval_ms << " ms" << std::endl;
+
+    while (!stop_requested) {
+        if (loop.run_once(-1) < 0) {
+            std::perror("epoll_wait");
+            break;
+        }
+    }
+
+    for (auto& kv : clients) close(kv.first);
+    close(timer_fd);
+    close(listen_fd);
+    return 0;
+}
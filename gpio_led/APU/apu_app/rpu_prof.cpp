@@ -0,0 +1,308 @@
+/*
+ * APU tool to profile the RPU firmware live from its PC-sampling histogram.
+ *
+ * Usage: ./rpu_prof            (sample 10 s, print the top 20 functions)
+ *        ./rpu_prof --duration-s <s>   (length of the window, default 10)
+ *        ./rpu_prof --syms <file>      (nm -n output of the firmware ELF)
+ *        ./rpu_prof --top <n>          (lines of the top list, default 20)
+ *        ./rpu_prof --gmon <file>      (write a gprof gmon.out)
+ *        ./rpu_prof --folded <file>    (write folded stacks, needs --syms)
+ *        ./rpu_prof --core 1           (RPU1 firmware in split mode)
+ *
+ * The firmware built with RPU_PC_PROF=1 counts the interrupted PC of a TTC
+ * interrupt in the bins of its PCPROF block (see common/rpu_shm.h). The
+ * counters are free-running, so the tool reads the block twice, the window
+ * apart, and works on the difference:
+ *   samples 9970 at 997 Hz over 10.0 s, 3.1% in handlers, 0 outside the code
+ *   %       samples  function
+ *   91.82   9154     prvIdleTask
+ *   2.41    240      prvIpiTask
+ *
+ * Symbols come from the host, so the board needs no ELF or binutils:
+ *   arm-none-eabi-nm -n --defined-only gpio_app.elf > gpio_app.sym
+ * A bin, 1 << shift bytes of code, is charged to the symbol it starts in.
+ * Without --syms the top list shows bin addresses instead.
+ *
+ * --gmon writes the histogram records of a gmon.out, one per code range,
+ * for the usual report on the host (no call graph: the firmware is not built
+ * with -pg):
+ *   arm-none-eabi-gprof -b -p gpio_app.elf gmon.out
+ * --folded writes one "RPU0;function count" line per function for
+ * flamegraph.pl; PC samples have no stack, so the graph is one level deep.
+ *
+ * Memory Map:
+ *   0xFFFC8000: PC profile block (RPU1 at 0xFFFCC000)
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "rpu_shm.h"
+#include "kr260hal/mem_map.h"
+
+#define PROF_DURATION_S_DEFAULT 10
+#define PROF_TOP_DEFAULT        20
+#define PROF_READ_RETRIES       100
+
+struct prof_snapshot {
+    uint32_t seq;
+    uint32_t hz;
+    uint32_t shift;
+    uint32_t samples;
+    uint32_t outside;
+    uint32_t handler;
+    rpu_pcprof_range range[PCPROF_RANGES];
+    std::vector<uint32_t> bins;
+};
+
+struct prof_symbol {
+    uint32_t addr;
+    std::string name;
+};
+
+// The layout is written once under the seq word; the counters change under us
+static bool read_prof(const kr260hal::MemMap& blk, prof_snapshot& out) {
+    for (int tries = 0; tries < PROF_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(PCPROF_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        kr260hal::barrier::acquire();
+        out.hz      = *blk.at(PCPROF_HZ_OFFSET);
+        out.shift   = *blk.at(PCPROF_SHIFT_OFFSET);
+        out.samples = *blk.at(PCPROF_SAMPLES_OFFSET);
+        out.outside = *blk.at(PCPROF_OUTSIDE_OFFSET);
+        out.handler = *blk.at(PCPROF_HANDLER_OFFSET);
+        uint32_t total = 0;
+        for (unsigned i = 0; i < PCPROF_RANGES; i++) {
+            volatile uint32_t* src = blk.at(PCPROF_RANGE(i));
+            out.range[i].low = src[0];
+            out.range[i].bins = src[1];
+            out.range[i].first = src[2];
+            out.range[i].reserved = 0;
+            total = std::max(total, out.range[i].first + out.range[i].bins);
+        }
+        if (total > PCPROF_MAX_BINS || out.shift >= 32) return false;
+        out.bins.resize(total);
+        for (uint32_t b = 0; b < total; b++) out.bins[b] = *blk.at(PCPROF_BIN(b));
+        kr260hal::barrier::acquire();
+        if (*blk.at(PCPROF_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Code symbols of "nm -n" output, sorted by address
+static bool load_symbols(const char* path, std::vector<prof_symbol>& syms) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        char type;
+        char name[256];
+        unsigned long addr;
+        if (std::sscanf(line.c_str(), "%lx %c %255s", &addr, &type, name) != 3) continue;
+        if (std::strchr("tTwW", type) == nullptr || name[0] == '$') continue;
+        // Thumb functions have bit 0 set
+        syms.push_back({ (uint32_t)addr & ~1U, name });
+    }
+    std::stable_sort(syms.begin(), syms.end(),
+                     [](const prof_symbol& a, const prof_symbol& b) { return a.addr < b.addr; });
+    return true;
+}
+
+static std::string symbol_at(const std::vector<prof_symbol>& syms, uint32_t addr) {
+    auto it = std::upper_bound(syms.begin(), syms.end(), addr,
+                               [](uint32_t a, const prof_symbol& s) { return a < s.addr; });
+    if (it == syms.begin()) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "[0x%08x]", addr);
+        return buf;
+    }
+    return (it - 1)->name;
+}
+
+static void put_le32(std::ofstream& out, uint32_t v) {
+    const char b[4] = { (char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24) };
+    out.write(b, 4);
+}
+
+// gmon.out of the BSD/binutils format: header, then a GMON_TAG_TIME_HIST
+// record per range with 16-bit bins of 32-bit addresses
+static bool write_gmon(const char* path, const prof_snapshot& p, const std::vector<uint32_t>& bins) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    const char hdr[20] = { 'g', 'm', 'o', 'n', 1, 0, 0, 0 };
+    out.write(hdr, sizeof(hdr));
+
+    unsigned saturated = 0;
+    for (const rpu_pcprof_range& r : p.range) {
+        if (r.bins == 0) continue;
+        char dimen[15] = {};
+        std::strncpy(dimen, "seconds", sizeof(dimen));
+        out.put(0);     // GMON_TAG_TIME_HIST
+        put_le32(out, r.low);
+        put_le32(out, r.low + (r.bins << p.shift));
+        put_le32(out, r.bins);
+        put_le32(out, p.hz);
+        out.write(dimen, sizeof(dimen));
+        out.put('s');
+        for (uint32_t b = 0; b < r.bins; b++) {
+            uint32_t count = bins[r.first + b];
+            if (count > 0xFFFF) {
+                count = 0xFFFF;
+                saturated++;
+            }
+            const char c[2] = { (char)count, (char)(count >> 8) };
+            out.write(c, 2);
+        }
+    }
+    if (saturated) {
+        std::cerr << saturated << " bins saturated at 65535 samples; use a shorter --duration-s"
+                  << std::endl;
+    }
+    return (bool)out;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned duration_s = PROF_DURATION_S_DEFAULT;
+    unsigned top = PROF_TOP_DEFAULT;
+    unsigned core = 0;
+    const char* syms_path = nullptr;
+    const char* gmon_path = nullptr;
+    const char* folded_path = nullptr;
+
+    static const struct option long_opts[] = {
+        {"duration-s", required_argument, nullptr, 'd'},
+        {"syms",       required_argument, nullptr, 's'},
+        {"top",        required_argument, nullptr, 't'},
+        {"gmon",       required_argument, nullptr, 'g'},
+        {"folded",     required_argument, nullptr, 'f'},
+        {"core",       required_argument, nullptr, 'c'},
+        {"help",       no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "d:s:t:g:f:c:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'd': duration_s = std::strtoul(optarg, nullptr, 0); break;
+            case 's': syms_path = optarg; break;
+            case 't': top = std::strtoul(optarg, nullptr, 0); break;
+            case 'g': gmon_path = optarg; break;
+            case 'f': folded_path = optarg; break;
+            case 'c':
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core < RPU_CORE_COUNT) break;
+                // fall through
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--duration-s <s>] [--syms <nm file>]"
+                          << " [--top <n>] [--gmon <file>] [--folded <file>] [--core <0|1>]"
+                          << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (duration_s == 0) duration_s = 1;
+    if (folded_path && !syms_path) {
+        std::cerr << "--folded needs --syms" << std::endl;
+        return 1;
+    }
+
+    std::vector<prof_symbol> syms;
+    if (syms_path && !load_symbols(syms_path, syms)) {
+        std::perror("Error reading the symbol file");
+        return 1;
+    }
+
+    // Map through /dev/mem, read-only: the RPU owns the block
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(PCPROF_ADDR(core), PCPROF_SIZE, false)) {
+        std::perror("Error mapping the PC profile block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(PCPROF_MAGIC_OFFSET);
+    if (magic != PCPROF_MAGIC) {
+        std::cerr << "No RPU PC profile found (magic 0x" << std::hex << magic
+                  << "); is the firmware built with RPU_PC_PROF=1?" << std::endl;
+        return 1;
+    }
+
+    prof_snapshot start, end;
+    if (!read_prof(blk, start)) {
+        std::cerr << "RPU PC profile is not settling" << std::endl;
+        return 1;
+    }
+    std::cerr << "Sampling RPU" << core << " for " << duration_s << " s..." << std::endl;
+    sleep(duration_s);
+    if (!read_prof(blk, end) || end.seq != start.seq) {
+        std::cerr << "RPU firmware restarted during the window" << std::endl;
+        return 1;
+    }
+
+    // Free-running counters: the differences are right across a wrap
+    std::vector<uint32_t> bins(end.bins.size());
+    for (size_t b = 0; b < bins.size(); b++) bins[b] = end.bins[b] - start.bins[b];
+    const uint32_t samples = end.samples - start.samples;
+    const uint32_t outside = end.outside - start.outside;
+    const uint32_t handler = end.handler - start.handler;
+
+    std::printf("samples %u at %u Hz over %.1f s, %.1f%% in handlers, %u outside the code\n",
+                samples, end.hz, end.hz ? (double)samples / end.hz : 0.0,
+                samples ? 100.0 * handler / samples : 0.0, outside);
+
+    // Samples per function, or per bin without symbols
+    std::map<std::string, uint64_t> funcs;
+    for (const rpu_pcprof_range& r : end.range) {
+        for (uint32_t b = 0; b < r.bins; b++) {
+            uint32_t count = bins[r.first + b];
+            if (count == 0) continue;
+            uint32_t addr = r.low + (b << end.shift);
+            if (syms.empty()) {
+                char buf[16];
+                snprintf(buf, sizeof(buf), "0x%08x", addr);
+                funcs[buf] += count;
+            } else {
+                funcs[symbol_at(syms, addr)] += count;
+            }
+        }
+    }
+
+    if (folded_path) {
+        std::ofstream out(folded_path);
+        for (const auto& f : funcs) out << "RPU" << core << ";" << f.first << " " << f.second << "\n";
+        if (outside) out << "RPU" << core << ";[outside] " << outside << "\n";
+        if (!out) {
+            std::perror("Error writing the folded stacks");
+            return 1;
+        }
+    }
+    if (gmon_path && !write_gmon(gmon_path, end, bins)) {
+        std::perror("Error writing gmon.out");
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> ranked(funcs.begin(), funcs.end());
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const std::pair<std::string, uint64_t>& a,
+                        const std::pair<std::string, uint64_t>& b) { return a.second > b.second; });
+    std::printf("%-7s %-8s %s\n", "%", "samples", syms.empty() ? "bin" : "function");
+    for (size_t i = 0; i < ranked.size() && i < top; i++) {
+        std::printf("%-7.2f %-8llu %s\n", samples ? 100.0 * ranked[i].second / samples : 0.0,
+                    (unsigned long long)ranked[i].second, ranked[i].first.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,457 @@
+/*
+ * APU tool to record APU -> RPU command streams and replay them as load.
+ *
+ * Usage: ./rpu_replay trace.txt                  (replay at the recorded pace)
+ *        ./rpu_replay trace.txt --speed 10       (ten times faster)
+ *        ./rpu_replay trace.txt --speed 0        (back to back, as fast as possible)
+ *        ./rpu_replay trace.txt --repeat 5 --backend uio --core 1
+ *        ./rpu_replay --capture trace.txt --duration-s 60
+ * Options:
+ *   --speed <x>             Time scale of the replay, 0 for none (default 1)
+ *   --repeat <n>            Replay the trace n times (default 1)
+ *   --backend <b>           auto, dev, uio, mem or host (default auto)
+ *   --core <0|1>            RPU core (RPU1 firmware in split mode)
+ *   --spin-ns, --max-sleep-us, --timeout-ms   Wait policy, as for ipi_app
+ *   --capture <file>        Record from the rpu_ipi tracepoints instead
+ *   --duration-s <s>        Length of the capture, Ctrl-C ends it earlier (default 10)
+ *
+ * Traces (kr260hal/cmd_trace.h) come from the APU library, which records
+ * what a program sends when it runs with KR260_IPI_RECORD=<file>:
+ *
+ *   KR260_IPI_RECORD=/tmp/prod.txt ./my_controller ...
+ *
+ * or from the rpu_ipi module's tracepoints with --capture, which sees the
+ * legacy commands of every writer of the module (sysfs, the chardev, the
+ * ioctls) and its messages; the message events carry no parameters, so
+ * those replay as zeros. Captures use the tracefs clock mono_raw, the
+ * library's clock, so both kinds of file can be merged.
+ *
+ * The replay sends each line through IpiTransport on its own path (legacy
+ * words, one ring batch, one message) at its time in the trace divided by
+ * --speed, after the previous line completed. It reports per path the
+ * response time, from the time the trace schedules a line to its
+ * completion, so a backlog the RPU cannot drain shows up as latency rather
+ * than as a slower replay; svc_p99_us is the send call alone. A line with a
+ * status other than OK is "failed", one left unanswered for the whole
+ * timeout "dropped":
+ *   path  n      p50_us    p99_us    p99.9_us  max_us    svc_p99_us  failed  dropped
+ *   ring  12000  7.120     41.880    96.200    310.450   12.310      0       0
+ *
+ * The RPU's load during the replay comes from the run-time stats block
+ * (rpu_stats): the share of the counter its IDLE task did not get, and the
+ * busiest other task.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rpu_shm.h"
+#include "kr260hal/cmd_trace.h"
+#include "kr260hal/ipi_transport.h"
+#include "kr260hal/sysfs.h"
+
+namespace shm = kr260hal::shm;
+
+#define REPLAY_CAPTURE_S_DEFAULT 10
+#define REPLAY_INSTANCE          "rpu_replay"
+#define REPLAY_SPIN_WAKE_NS      200000  // Sleep until this close to a send time, then spin
+#define REPLAY_LATE_NS           1000000 // A line sent later than this is counted late
+#define REPLAY_STATS_RETRIES     10
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+/*-----------------------------------------------------------*/
+/* Capture from the rpu_ipi tracepoints, in a tracefs instance of its own */
+static int capture(const std::string& path, unsigned duration_s) {
+    std::string dir;
+    for (const char* root : {"/sys/kernel/tracing", "/sys/kernel/debug/tracing"}) {
+        if (kr260hal::path_exists(std::string(root) + "/instances")) {
+            dir = std::string(root) + "/instances/" REPLAY_INSTANCE;
+            break;
+        }
+    }
+    if (dir.empty() || (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)) {
+        std::perror("Error creating the tracefs instance");
+        return 1;
+    }
+    int out = kr260hal::open_trace(path);
+    int fd = -1;
+    if (out == -1 || !kr260hal::sysfs_write(dir + "/trace_clock", "mono_raw") ||
+        !kr260hal::sysfs_write(dir + "/events/rpu_ipi/rpu_ipi_cmd_send/enable", "1") ||
+        !kr260hal::sysfs_write(dir + "/events/rpu_ipi/rpu_ipi_msg_send/enable", "1") ||
+        (fd = ::open((dir + "/trace_pipe").c_str(), O_RDONLY | O_NONBLOCK)) == -1) {
+        std::perror("Error setting up the capture (rpu_ipi module, tracefs, output file)");
+        if (out != -1) ::close(out);
+        rmdir(dir.c_str());
+        return 1;
+    }
+
+    std::printf("Capturing rpu_ipi commands to %s for %u s; Ctrl-C to stop\n", path.c_str(), duration_s);
+    std::fflush(stdout);
+    const uint64_t end = kr260hal::now_ns() + (uint64_t)duration_s * 1000000000ULL;
+    std::string pending;
+    unsigned count = 0;
+    char buf[4096];
+    while (!stop_requested && kr260hal::now_ns() < end) {
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            usleep(10000);
+            continue;
+        }
+        pending.append(buf, n);
+        size_t eol;
+        while ((eol = pending.find('\n')) != std::string::npos) {
+            const std::string line = pending.substr(0, eol);
+            pending.erase(0, eol + 1);
+
+            // "<task>-<pid> [cpu] <flags> <seconds>: rpu_ipi_<event>: <fields>"
+            size_t ev = line.find(": rpu_ipi_");
+            size_t ts = ev == std::string::npos ? ev : line.rfind(' ', ev);
+            if (ts == std::string::npos) continue;
+            kr260hal::TraceRecord rec;
+            rec.t_ns = (uint64_t)(std::strtod(line.c_str() + ts + 1, nullptr) * 1e9);
+
+            size_t field;
+            if (line.compare(ev + 2, 17, "rpu_ipi_cmd_send:") == 0 &&
+                (field = line.find(" mode=")) != std::string::npos) {
+                rec.path = kr260hal::TRACE_CMD;
+                rec.opcode = std::strtoul(line.c_str() + field + 6, nullptr, 10);
+            } else if (line.compare(ev + 2, 17, "rpu_ipi_msg_send:") == 0 &&
+                       (field = line.find(" opcode=")) != std::string::npos) {
+                rec.path = kr260hal::TRACE_MSG;
+                rec.opcode = std::strtoul(line.c_str() + field + 8, nullptr, 10);
+                size_t len = line.find(" len=");
+                if (len != std::string::npos) {
+                    rec.params.assign(std::min<unsigned long>(std::strtoul(line.c_str() + len + 5, nullptr, 10),
+                                                              SHM_IPI_MSG_DATA_WORDS), 0);
+                }
+            } else {
+                continue;
+            }
+            if (kr260hal::append_trace(out, rec)) count++;
+        }
+    }
+
+    ::close(fd);
+    ::close(out);
+    kr260hal::sysfs_write(dir + "/events/rpu_ipi/enable", "0");
+    rmdir(dir.c_str());
+    std::printf("%u command(s) captured\n", count);
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+/* Counter of the IDLE task and of the busiest other task, from the stats block */
+struct StatsSample {
+    bool valid = false;
+    uint32_t seq = 0;
+    uint32_t total = 0;
+    uint32_t hz = 0;
+    uint32_t idle = 0;
+    std::vector<std::pair<std::string, uint32_t>> tasks;
+};
+
+// Seqlock read as rpu_stats does it: even and unchanged across the copy
+static StatsSample read_stats(const kr260hal::MemMap& win) {
+    StatsSample s;
+    if (win.read<shm::StatsMagic>() != SHM_STATS_MAGIC) return s;
+
+    for (int tries = 0; tries < REPLAY_STATS_RETRIES; tries++) {
+        const uint32_t seq = win.read<shm::StatsSeq>();
+        if (seq & 1) {
+            usleep(100);
+            continue;
+        }
+        kr260hal::barrier::acquire();
+        s.total = win.read<shm::StatsTotal>();
+        s.hz = win.read<shm::StatsHz>();
+        s.tasks.clear();
+        const uint32_t count = std::min<uint32_t>(win.read<shm::StatsCount>(), SHM_STATS_MAX_TASKS);
+        for (uint32_t i = 0; i < count; i++) {
+            volatile uint32_t* src = win.at(SHM_STATS_ENTRY(i));
+            uint32_t words[SHM_STATS_ENTRY_SIZE / 4];
+            for (unsigned w = 0; w < SHM_STATS_ENTRY_SIZE / 4; w++) words[w] = src[w];
+            rpu_shm_task_stat t;
+            std::memcpy(&t, words, sizeof(t));
+            t.name[SHM_STATS_NAME_LEN - 1] = '\0';
+            s.tasks.emplace_back(t.name, t.run_time);
+        }
+        kr260hal::barrier::acquire();
+        if (win.read<shm::StatsSeq>() == seq) {
+            s.seq = seq;
+            s.valid = true;
+            return s;
+        }
+    }
+    return s;
+}
+
+static void print_rpu_load(const StatsSample& before, const StatsSample& after) {
+    if (!before.valid || !after.valid) {
+        std::printf("RPU load: no run-time stats block in the window\n");
+        return;
+    }
+    const uint32_t span = after.total - before.total;
+    if (after.seq == before.seq || span == 0) {
+        std::printf("RPU load: stats not refreshed during the replay, run it longer\n");
+        return;
+    }
+
+    double idle = 0;
+    std::string busiest;
+    double busiest_pct = 0;
+    for (const auto& t : after.tasks) {
+        uint32_t prev = 0;
+        for (const auto& b : before.tasks) {
+            if (b.first == t.first) prev = b.second;
+        }
+        const double pct = 100.0 * (uint32_t)(t.second - prev) / span;
+        if (t.first == "IDLE") {
+            idle = pct;
+        } else if (pct > busiest_pct) {
+            busiest = t.first;
+            busiest_pct = pct;
+        }
+    }
+    std::printf("RPU load: %.2f%% busy over %.3f s of stats", 100.0 - idle,
+                after.hz ? (double)span / after.hz : 0.0);
+    if (!busiest.empty()) std::printf(", busiest task %s %.2f%%", busiest.c_str(), busiest_pct);
+    std::printf("\n");
+}
+
+/*-----------------------------------------------------------*/
+struct PathStats {
+    std::vector<double> response_us;
+    std::vector<double> service_us;
+    unsigned failed = 0;
+    unsigned dropped = 0;
+};
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const std::vector<double>& sorted, double pct) {
+    size_t rank = (size_t)(pct / 100.0 * sorted.size() + 0.999999);
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+// Until t: sleep while it is far, spin for the last stretch
+static void wait_until_ns(uint64_t t) {
+    for (;;) {
+        uint64_t now = kr260hal::now_ns();
+        if (now >= t || stop_requested) return;
+        if (t - now > REPLAY_SPIN_WAKE_NS) {
+            struct timespec ts = {0, (long)(t - now - REPLAY_SPIN_WAKE_NS)};
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec = ts.tv_nsec / 1000000000L;
+                ts.tv_nsec %= 1000000000L;
+            }
+            nanosleep(&ts, nullptr);
+        } else {
+            kr260hal::cpu_relax();
+        }
+    }
+}
+
+static kr260hal::IpiResult send(kr260hal::IpiTransport& ipi, const kr260hal::TraceRecord& rec) {
+    uint32_t results[RPU_MSG_MAX_RESULTS];
+    kr260hal::RingTicket ticket;
+
+    switch (rec.path) {
+        case kr260hal::TRACE_CMD:
+            return ipi.send_mode(rec.opcode);
+        case kr260hal::TRACE_MSG:
+            return ipi.send_msg(rec.opcode, rec.params, results);
+        case kr260hal::TRACE_RING:
+        default:
+            if (!ipi.submit(rec.ring, &ticket)) {
+                kr260hal::IpiResult result;
+                result.rtt_us = (kr260hal::now_ns() - ticket.start_ns) / 1000.0;
+                return result;
+            }
+            return ipi.wait_done(ticket);
+    }
+}
+
+static bool parse_backend(const std::string& name, kr260hal::IpiBackend& backend) {
+    for (kr260hal::IpiBackend b : {kr260hal::IPI_BACKEND_AUTO, kr260hal::IPI_BACKEND_DEV,
+                                   kr260hal::IPI_BACKEND_UIO, kr260hal::IPI_BACKEND_MEM,
+                                   kr260hal::IPI_BACKEND_HOST}) {
+        if (name == kr260hal::backend_name(b)) {
+            backend = b;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <trace> [--speed <x>] [--repeat <n>]"
+              << " [--backend auto|dev|uio|mem|host] [--core <0|1>] [--spin-ns <ns>]"
+              << " [--max-sleep-us <us>] [--timeout-ms <ms>]" << std::endl;
+    std::cerr << "       " << prog << " --capture <trace> [--duration-s <s>]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    enum { OPT_SPIN_NS = 256, OPT_MAX_SLEEP_US, OPT_TIMEOUT_MS, OPT_CORE, OPT_BACKEND };
+    static const struct option long_opts[] = {
+        {"speed",        required_argument, nullptr, 's'},
+        {"repeat",       required_argument, nullptr, 'r'},
+        {"capture",      required_argument, nullptr, 'c'},
+        {"duration-s",   required_argument, nullptr, 'd'},
+        {"backend",      required_argument, nullptr, OPT_BACKEND},
+        {"core",         required_argument, nullptr, OPT_CORE},
+        {"spin-ns",      required_argument, nullptr, OPT_SPIN_NS},
+        {"max-sleep-us", required_argument, nullptr, OPT_MAX_SLEEP_US},
+        {"timeout-ms",   required_argument, nullptr, OPT_TIMEOUT_MS},
+        {"help",         no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    double speed = 1.0;
+    unsigned repeat = 1;
+    std::string capture_path;
+    unsigned duration_s = REPLAY_CAPTURE_S_DEFAULT;
+    kr260hal::IpiBackend backend = kr260hal::IPI_BACKEND_AUTO;
+    unsigned core = 0;
+    kr260hal::WaitPolicy wait;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:r:c:d:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 's': speed = std::max(0.0, std::strtod(optarg, nullptr)); break;
+            case 'r': repeat = std::max(1UL, std::strtoul(optarg, nullptr, 0)); break;
+            case 'c': capture_path = optarg; break;
+            case 'd': duration_s = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_SPIN_NS: wait.spin_ns = std::strtoull(optarg, nullptr, 10); break;
+            case OPT_MAX_SLEEP_US:
+                wait.max_sleep_us = std::max<uint32_t>(kr260hal::WAIT_MIN_SLEEP_US, std::strtoul(optarg, nullptr, 10));
+                break;
+            case OPT_TIMEOUT_MS: wait.timeout_ms = std::max(1UL, std::strtoul(optarg, nullptr, 10)); break;
+            case OPT_BACKEND:
+                if (!parse_backend(optarg, backend)) {
+                    std::cerr << "Unknown backend " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            case OPT_CORE:
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core < RPU_CORE_COUNT) break;
+                std::cerr << "Invalid core " << optarg << " (0-" << RPU_CORE_COUNT - 1 << ")" << std::endl;
+                return 1;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    std::signal(SIGINT, handle_sigint);
+
+    if (!capture_path.empty()) return capture(capture_path, duration_s);
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<kr260hal::TraceRecord> trace;
+    std::string error;
+    if (!kr260hal::load_trace(argv[optind], trace, error)) {
+        std::cerr << "Error in " << argv[optind] << ": " << error << std::endl;
+        return 1;
+    }
+    if (trace.empty()) {
+        std::cerr << argv[optind] << " holds no commands" << std::endl;
+        return 1;
+    }
+
+    kr260hal::IpiTransport ipi;
+    ipi.wait = wait;
+    // The replay must not record itself into the trace it reads
+    unsetenv("KR260_IPI_RECORD");
+    if (!ipi.open(core, backend)) {
+        std::perror("Error opening the RPU transport");
+        return 1;
+    }
+
+    const char* const PATH_NAMES[] = {"cmd", "ring", "msg"};
+    PathStats paths[3];
+    std::vector<double> lag_us;
+    unsigned late = 0;
+    uint64_t commands = 0;
+    const double span_s = trace.back().t_ns / 1e9;
+    const double drop_us = wait.timeout_ms * 1000.0;
+
+    std::printf("RPU%u (%s), %zu line(s) over %.3f s, %u time(s) at ", core,
+                kr260hal::backend_name(ipi.backend()), trace.size(), span_s, repeat);
+    if (speed > 0) std::printf("%gx\n", speed);
+    else std::printf("full speed\n");
+    const StatsSample before = read_stats(ipi.shm());
+    const uint64_t run_start = kr260hal::now_ns();
+
+    for (unsigned r = 0; r < repeat && !stop_requested; r++) {
+        const uint64_t base = kr260hal::now_ns();
+        for (const kr260hal::TraceRecord& rec : trace) {
+            if (stop_requested) break;
+            uint64_t sched = speed > 0 ? base + (uint64_t)(rec.t_ns / speed) : kr260hal::now_ns();
+            wait_until_ns(sched);
+
+            const uint64_t start = kr260hal::now_ns();
+            kr260hal::IpiResult result = send(ipi, rec);
+            const uint64_t end = kr260hal::now_ns();
+
+            PathStats& p = paths[rec.path];
+            p.response_us.push_back((end - std::min(sched, start)) / 1000.0);
+            p.service_us.push_back((end - start) / 1000.0);
+            if (!result.acked) {
+                if (result.rtt_us >= drop_us) p.dropped++;
+                else p.failed++;
+            }
+            if (start > sched) {
+                lag_us.push_back((start - sched) / 1000.0);
+                if (start - sched > REPLAY_LATE_NS) late++;
+            } else {
+                lag_us.push_back(0);
+            }
+            commands += rec.path == kr260hal::TRACE_RING ? rec.ring.size() : 1;
+        }
+    }
+
+    const double run_s = (kr260hal::now_ns() - run_start) / 1e9;
+    const StatsSample after = read_stats(ipi.shm());
+
+    int ret = 0;
+    std::printf("\n%-5s %-6s %-9s %-9s %-9s %-9s %-11s %-7s %s\n", "path", "n", "p50_us", "p99_us",
+                "p99.9_us", "max_us", "svc_p99_us", "failed", "dropped");
+    for (int i = 0; i < 3; i++) {
+        PathStats& p = paths[i];
+        if (p.response_us.empty()) continue;
+        std::sort(p.response_us.begin(), p.response_us.end());
+        std::sort(p.service_us.begin(), p.service_us.end());
+        std::printf("%-5s %-6zu %-9.3f %-9.3f %-9.3f %-9.3f %-11.3f %-7u %u\n", PATH_NAMES[i],
+                    p.response_us.size(), percentile(p.response_us, 50), percentile(p.response_us, 99),
+                    percentile(p.response_us, 99.9), p.response_us.back(), percentile(p.service_us, 99),
+                    p.failed, p.dropped);
+        if (p.failed != 0 || p.dropped != 0) ret = 1;
+    }
+
+    std::sort(lag_us.begin(), lag_us.end());
+    std::printf("\n%llu command(s) in %.3f s, %.1f commands/s; send lag p50 %.3f us, p99 %.3f us,"
+                " max %.3f us, %u line(s) over %u us late\n",
+                (unsigned long long)commands, run_s, run_s > 0 ? commands / run_s : 0.0,
+                percentile(lag_us, 50), percentile(lag_us, 99), lag_us.back(), late,
+                REPLAY_LATE_NS / 1000);
+    print_rpu_load(before, after);
+    return ret;
+}
@@ -0,0 +1,201 @@
+/*
+ * APU tool to read the RPU sensor samples from their ring in OCM.
+ *
+ * Usage: ./rpu_sensor                 (print samples until Ctrl-C)
+ *        ./rpu_sensor --interval-ms <ms>   (poll period, default 10)
+ *        ./rpu_sensor --imu           (decode as MPU-6050 style registers)
+ *        ./rpu_sensor --monotonic     (time column in CLOCK_MONOTONIC seconds)
+ *        ./rpu_sensor --stats         (only the rates and counters, every second)
+ *
+ * A firmware built with RPU_SENSOR=1 reads a register block from an I2C or
+ * SPI sensor at a fixed rate and publishes every sample, stamped with the
+ * system counter at its trigger, into an rpu_ring.h ring of the SENSOR block
+ * (see common/rpu_shm.h). The tool is its consumer: it drains the ring every
+ * poll period, so the period only has to stay below the SENSOR_RING_SLOTS
+ * samples the ring holds (256 ms at the default 1 kHz):
+ *   seq       time_us         delta_us  data
+ *   81234     81234000.120    +1000.002 fe 10 00 2c 40 08 f1 c0 00 12 ff f6 00 03
+ * With --imu the data columns are the accelerometer, temperature and
+ * gyroscope words, big-endian as the IMU sends them:
+ *   seq       time_us         delta_us  ax     ay     az     temp   gx     gy     gz
+ * A gap in seq is a trigger without a sample: skipped by the RPU while its
+ * two buffers were busy, or a failed read; samples the tool was too slow for
+ * are counted by the RPU as ring overflows (full). --monotonic needs the
+ * offset published by rpu_clock.
+ *
+ * Memory Map:
+ *   0xFF990000: Shared memory window (counter frequency, clock offset)
+ *   0xFFFD0000: SENSOR block (ring at SENSOR_RING_OFFSET)
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <csignal>
+#include <ctime>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "rpu_shm.h"
+#include "rpu_ring.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/shm_regs.h"
+#include "kr260hal/timebase.h"
+
+#define SENSOR_POLL_MS_DEFAULT  10
+#define SENSOR_BATCH            32
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+static double now_s() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_data(const rpu_sensor_sample& s, bool imu) {
+    uint32_t len = s.len < SENSOR_MAX_BYTES ? s.len : SENSOR_MAX_BYTES;
+    if (imu) {
+        for (uint32_t i = 0; i + 1 < len && i < 14; i += 2) {
+            std::printf(" %-6d", (int16_t)((s.data[i] << 8) | s.data[i + 1]));
+        }
+    } else {
+        for (uint32_t i = 0; i < len; i++) std::printf(" %02x", s.data[i]);
+    }
+    std::printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    unsigned interval_ms = SENSOR_POLL_MS_DEFAULT;
+    bool imu = false;
+    bool monotonic = false;
+    bool stats_only = false;
+
+    static const struct option long_opts[] = {
+        {"interval-ms", required_argument, nullptr, 'i'},
+        {"imu",         no_argument,       nullptr, 'u'},
+        {"monotonic",   no_argument,       nullptr, 'm'},
+        {"stats",       no_argument,       nullptr, 's'},
+        {"help",        no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "i:umsh", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'i': interval_ms = std::strtoul(optarg, nullptr, 0); break;
+            case 'u': imu = true; break;
+            case 'm': monotonic = true; break;
+            case 's': stats_only = true; break;
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--interval-ms <ms>] [--imu] [--monotonic]"
+                          << " [--stats]" << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // Read-only window for the time base; the SENSOR block is written (ring tail)
+    kr260hal::MemMap win;
+    kr260hal::MemMap blk;
+    if (!win.map_phys(kr260hal::shm_window_addr(0), SHARED_MEM_SIZE, false) ||
+        !blk.map_phys(SENSOR_ADDR, SENSOR_SIZE)) {
+        std::perror("Error mapping shared memory");
+        return 1;
+    }
+
+    uint32_t magic = *blk.at(SENSOR_MAGIC_OFFSET);
+    if (magic != SENSOR_MAGIC) {
+        std::cerr << "No sensor samples found (magic 0x" << std::hex << magic
+                  << "); is the firmware built with RPU_SENSOR=1?" << std::endl;
+        return 1;
+    }
+
+    rpu_ring_t ring;
+    if (rpu_ring_attach(&ring, blk.base() + SENSOR_RING_OFFSET, RPU_RING_CONSUMER) != 0 ||
+        ring.words * 4 != SENSOR_SAMPLE_SIZE) {
+        std::cerr << "Sensor ring not formatted as expected" << std::endl;
+        return 1;
+    }
+
+    kr260hal::ClockSync sync;
+    const uint64_t hz = kr260hal::window_counter_freq(win);
+    if (monotonic && !kr260hal::read_clock_sync(win, sync)) {
+        std::cerr << "No clock offset published; run rpu_clock first" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    std::signal(SIGTERM, handle_sigint);
+
+    std::fprintf(stderr, "%s sensor 0x%02x, register 0x%02x, %u bytes at %u Hz\n",
+                 *blk.at(SENSOR_BUS_OFFSET) == SENSOR_BUS_SPI ? "SPI" : "I2C",
+                 *blk.at(SENSOR_DEV_OFFSET), *blk.at(SENSOR_REG_OFFSET),
+                 *blk.at(SENSOR_LEN_OFFSET), *blk.at(SENSOR_HZ_OFFSET));
+    if (!stats_only) {
+        std::printf("%-9s %-15s %-9s %s\n", "seq", monotonic ? "mono_s" : "time_us", "delta_us",
+                    imu ? "ax     ay     az     temp   gx     gy     gz" : "data");
+    }
+
+    rpu_sensor_sample batch[SENSOR_BATCH];
+    uint64_t prev_ts = 0;
+    uint32_t prev_seq = 0;
+    uint64_t received = 0;
+    uint64_t gaps = 0;
+    uint64_t window_count = 0;
+    double window_start = now_s();
+
+    while (!stop_requested) {
+        uint32_t n;
+        while ((n = rpu_ring_pop(&ring, batch, SENSOR_BATCH)) != 0) {
+            for (uint32_t i = 0; i < n; i++) {
+                const rpu_sensor_sample& s = batch[i];
+                uint64_t ts = ((uint64_t)s.ts_hi << 32) | s.ts_lo;
+                if (received && s.seq != prev_seq + 1) gaps += s.seq - prev_seq - 1;
+                received++;
+                window_count++;
+
+                if (!stats_only) {
+                    char delta[16] = "-";
+                    if (prev_ts) {
+                        std::snprintf(delta, sizeof(delta), "+%.3f",
+                                      (kr260hal::ticks_to_ns(ts, hz) - kr260hal::ticks_to_ns(prev_ts, hz)) / 1e3);
+                    }
+                    if (monotonic) {
+                        kr260hal::read_clock_sync(win, sync);
+                        std::printf("%-9u %-15.6f %-9s", s.seq,
+                                    ((int64_t)kr260hal::ticks_to_ns(ts, hz) + sync.offset_ns) / 1e9, delta);
+                    } else {
+                        std::printf("%-9u %-15.3f %-9s", s.seq, kr260hal::ticks_to_ns(ts, hz) / 1e3, delta);
+                    }
+                    print_data(s, imu);
+                }
+                prev_ts = ts;
+                prev_seq = s.seq;
+            }
+        }
+
+        double t = now_s();
+        if (stats_only && t - window_start >= 1.0) {
+            std::printf("rate %.1f/s  samples %u  skipped %u  errors %u  full %u  latency_max_us %.1f  gaps %llu\n",
+                        window_count / (t - window_start), *blk.at(SENSOR_SAMPLES_OFFSET),
+                        *blk.at(SENSOR_SKIPPED_OFFSET), *blk.at(SENSOR_ERRORS_OFFSET),
+                        *blk.at(SENSOR_FULL_OFFSET), *blk.at(SENSOR_XFER_MAX_OFFSET) / 1e3,
+                        (unsigned long long)gaps);
+            std::fflush(stdout);
+            window_start = t;
+            window_count = 0;
+        }
+        usleep(interval_ms * 1000);
+    }
+
+    std::fprintf(stderr, "%llu samples, %llu triggers without one, %u lost to a full ring, %u read errors\n",
+                 (unsigned long long)received, (unsigned long long)gaps,
+                 *blk.at(SENSOR_FULL_OFFSET), *blk.at(SENSOR_ERRORS_OFFSET));
+    return 0;
+}
@@ -0,0 +1,1345 @@
+/*
+ * APU tool to display the RPU per-task CPU accounting from shared memory.
+ *
+ * Usage: ./rpu_stats            (refresh every second until Ctrl-C)
+ *        ./rpu_stats --once     (print one snapshot and exit)
+ *        ./rpu_stats --interval-ms <ms>   (refresh period, default 1000)
+ *        ./rpu_stats --core 1      (RPU1 firmware in split mode)
+ *        ./rpu_stats --irq         (IPI path profile, firmware with RPU_IRQ_PROF=1)
+ *        ./rpu_stats --irq-reset   (clear the IPI path profile)
+ *        ./rpu_stats --apm         (interconnect monitors, RPU0 firmware with RPU_APM=1)
+ *        ./rpu_stats --apm-capture <ocm|lpd|cci> [--apm-id <id> --apm-id-mask <mask>]
+ *                    [--apm-interval-us <us>] [--apm-records <n>]   (timeline of one port)
+ *        ./rpu_stats --sysmon      (temperatures and supplies, RPU0 firmware with RPU_SYSMON=1)
+ *        ./rpu_stats --gov [--gov-power <file>]   (clock governor, RPU0 firmware with RPU_GOVERNOR=1)
+ *        ./rpu_stats --wdog        (deadline supervision, RPU0 firmware with RPU_WATCHDOG=1)
+ *        ./rpu_stats --bench       (kernel latency benchmark, RPU0 firmware with RPU_BENCH=1)
+ *        ./rpu_stats --plintr      (PL interrupt_gen latencies, RPU0 firmware with RPU_PL_INTR=1)
+ *        ./rpu_stats --mem         (stack and heap watermarks, with --core)
+ *
+ * The RPU firmware publishes a FreeRTOS uxTaskGetSystemState() snapshot into
+ * the task stats block of the shared window (see common/rpu_shm.h) once per
+ * second. Run time counters are free-running, so the tool shows the CPU share
+ * of each task between two snapshots; the first table (and --once) shows the
+ * share since the counter last wrapped:
+ *   task        num  prio  state      cpu%     stack_free
+ *   IPI         3    3     Blocked    0.12     588
+ *   IDLE        5    0     Ready      99.61    364
+ *
+ * Interrupt handlers are charged to the task they interrupted.
+ *
+ * --irq prints the IRQ profile block instead: for every stage of an IPI
+ * task pass, the time from the IPI_Handler entry measured with the R5 cycle
+ * counter, and the occupied log2 buckets of its histogram:
+ *   stage      count    min_us   mean_us  max_us   last_us  histogram
+ *   isr_exit   1200     0.270    0.291    0.842    0.281    <0.48us:1183 <0.96us:17
+ *   ack        1200     2.102    2.350    9.730    2.214    ...
+ *
+ * --apm prints the AXI performance monitor samples instead, the latest
+ * interval (100 ms) at every refresh: the bandwidth of each monitored port,
+ * the longest read latency converted from APM clocks, and the byte totals:
+ *   port  wr_MB/s   rd_MB/s   max_rd_ns  apm_MHz  total_wr_MB total_rd_MB
+ *   ocm   12.41     30.02     412        133.3    1.2         3.0
+ *
+ * --apm-capture asks the RPU for a timeline of one port instead: the same
+ * counters over short hardware-timed intervals (default 10 us), counting
+ * only the AXI IDs that match --apm-id under --apm-id-mask if one is given.
+ * The records land in the RPU0 bulk carveout, so no bulk transfer may run
+ * meanwhile. Gaps longer than an interval and a half are marked as lost:
+ *   t_us        wr_MB/s   rd_MB/s   max_rd_ns
+ *   10.02       0.00      412.30    388
+ *
+ * --sysmon prints the PS SYSMON block instead: the averaged die temperatures
+ * and PS supplies the RPU read last, their extremes since it started, and
+ * the temperature alarm a load-shedding script can act on (exit status 2
+ * with --once while it is set):
+ *   channel      value     min       max
+ *   temp_lpd     52.341    48.102    53.870    C
+ *   vcc_psintlp  0.851     0.849     0.853     V
+ *
+ * --gov prints the workload governor block instead: the R5 clock in each
+ * state, the share of the last interval spent at the low clock, and the
+ * wake-up latencies from the IPI handler entry to the full clock:
+ *   state LOW   R5 533.3 MHz, idle 133.3 MHz, 0 clock(s) gated
+ *   low 100.0% (interval), 81.4% (run)  entries 12  wakes 11
+ *   wake_us last 1.210  mean 1.232  max 1.870
+ * --gov-power names a power reading of the board in microwatts (a hwmon
+ * power*_input file); it is sampled at every refresh and averaged by the
+ * governor state of that refresh, which gives the saving:
+ *   power full 3120.4 mW (40), low 2988.1 mW (160), saving 132.3 mW (4.2%)
+ *
+ * --wdog prints the watchdog supervision block instead: the windows closed
+ * and how many of them restarted the LPD watchdog, and the deadlines each
+ * supervised task met and missed, with its worst lateness:
+ *   window 500 ms, timeout 2013 ms  windows 240  kicks 238  failed 2 (last: rx)
+ *   task  met       missed    stalls    worst_us
+ *   tx    48012     3         0         20000
+ *
+ * --bench prints the benchmark block of a firmware built with RPU_BENCH=1
+ * instead, one row per test in the layout of --irq, accumulated since the
+ * firmware started:
+ *   bench rounds 12, 1000 samples per test and round, cycle counter 533.3 MHz
+ *   test       count    min_us   mean_us  max_us   last_us  histogram
+ *   yield      12000    0.731    0.752    2.410    0.741    <0.96us:11988 ...
+ *
+ * --plintr prints the PL interrupt block instead: per interrupt_gen channel
+ * the events, the interrupts the R5 took for them, the events they lost,
+ * and the latency from the event's hardware timestamp to the handler,
+ * converted from PL clocks. The columns are those of the /dev/pl_intr
+ * counters, so the R5 and the Linux handler can be compared run for run:
+ *   irqs 120000  spurious 0  PL clock 100.0 MHz
+ *   ch  events     irqs       lost       last_ns  min_ns   mean_ns  max_ns
+ *   0   60000      60000      0          410      380      402.7    890
+ *
+ * --mem prints the core's memory watermark block instead: for every task and
+ * exception mode stack its size, the most it ever used, the least it had
+ * free, and a size with MEM_MARGIN_PERCENT above the peak (rounded up to 16
+ * bytes). The free space only goes down, so run the real workload long
+ * enough to hit its worst paths first. All figures are bytes; FreeRTOS
+ * stack depths are in words of 4 bytes:
+ *   stack      size     used     min_free suggest
+ *   Tx         800      352      448      448
+ *   svc        2048     416      1632     528
+ *
+ * Memory Map:
+ *   0xFF990000: Shared memory window (stats at SHM_STATS_HDR_OFFSET)
+ *   0xFFFC0000: Shared memory window of RPU1 (--core 1)
+ *   0xFFFC3000: IRQ profile block (--irq; RPU1 at 0xFFFC4000)
+ *   0xFFFC5000: APM block (--apm, --apm-capture)
+ *   0xFFFC6000: SYSMON block (--sysmon)
+ *   0xFFFD4000: Governor block (--gov)
+ *   0xFFFD5000: Watchdog block (--wdog)
+ *   0xFFFD6000: Benchmark block (--bench)
+ *   0xFFFD7000: Memory watermark block (--mem; RPU1 at 0xFFFD8000)
+ *   0xFFFDE000: PL interrupt block (--plintr)
+ *   0x3F100000: RPU0 bulk carveout (--apm-capture records)
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <csignal>
+#include <getopt.h>
+#include <unistd.h>
+
+// Shared Memory Layout (following OpenAMP pattern)
+#include "rpu_shm.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/shm_regs.h"
+#include "kr260hal/timebase.h"
+
+namespace shm = kr260hal::shm;
+namespace barrier = kr260hal::barrier;
+using kr260hal::counter_freq;
+
+#define STATS_POLL_MS_DEFAULT  1000
+#define STATS_READ_RETRIES     100
+#define APM_CAP_INTERVAL_US_DEFAULT 10
+#define APM_CAP_RECORDS_DEFAULT     1000
+#define MEM_MARGIN_PERCENT     25
+
+struct stats_snapshot {
+    uint32_t seq;
+    uint32_t count;
+    uint32_t total;
+    uint32_t hz;
+    uint32_t tick;
+    uint32_t heap_free;
+    uint32_t heap_min;
+    rpu_shm_task_stat task[SHM_STATS_MAX_TASKS];
+};
+
+struct irqprof_snapshot {
+    uint32_t seq;
+    uint32_t hz;
+    uint32_t passes;
+    rpu_irqprof_stage stage[IRQPROF_STAGES];
+};
+
+static const char* const IRQPROF_STAGE_NAMES[IRQPROF_STAGES] = {
+    "isr_exit", "task", "ack", "done"
+};
+
+struct bench_snapshot {
+    uint32_t seq;
+    uint32_t hz;
+    uint32_t rounds;
+    uint32_t iterations;
+    rpu_irqprof_stage test[BENCH_TESTS];
+};
+
+// Indexed by BENCH_TEST_*
+static const char* const BENCH_TEST_NAMES[BENCH_TESTS] = {
+    "yield", "sem", "queue", "notify", "irq", "isr_task"
+};
+
+struct mem_snapshot {
+    uint32_t seq;
+    uint32_t count;
+    uint32_t heap_size;
+    uint32_t heap_free;
+    uint32_t heap_min;
+    rpu_mem_stack mode[MEM_MODES];
+    rpu_mem_task task[MEM_MAX_TASKS];
+};
+
+// Indexed by MEM_MODE_*
+static const char* const MEM_MODE_NAMES[MEM_MODES] = {
+    "svc", "irq", "fiq", "abort", "undef"
+};
+
+struct apm_snapshot {
+    uint32_t seq;
+    uint32_t samples;
+    uint32_t period_ms;
+    uint32_t ticks;
+    uint32_t count;
+    uint32_t qos_ports;
+    uint32_t qos_level;
+    rpu_apm_port port[APM_MAX_PORTS];
+};
+
+// Indexed by APM_PORT_*
+static const char* const APM_PORT_NAMES[APM_MAX_PORTS] = {
+    "ocm", "lpd", "cci", "?"
+};
+
+// Bits of APM_QOS_PORTS (RPU_QOS_*, RPU/gpio_app/src/rpu_qos.h)
+static const char* const QOS_PORT_NAMES[] = {
+    "HPC0", "HPC1", "HP0", "HP1", "HP2", "HP3", "LPD"
+};
+
+struct sysmon_snapshot {
+    uint32_t seq;
+    uint32_t samples;
+    uint32_t period_ms;
+    uint32_t count;
+    uint32_t flags;
+    uint32_t alarms;
+    int32_t hot;
+    int32_t cool;
+    rpu_sysmon_channel ch[SYSMON_MAX_CHANNELS];
+};
+
+// Indexed by SYSMON_CH_*; the first two are temperatures
+static const char* const SYSMON_CH_NAMES[] = {
+    "temp_lpd", "temp_fpd", "vcc_psintlp", "vcc_psintfp", "vcc_psaux", "vcc_psddr"
+};
+#define SYSMON_NAMED_CHANNELS (sizeof(SYSMON_CH_NAMES) / sizeof(SYSMON_CH_NAMES[0]))
+
+struct gov_snapshot {
+    uint32_t seq;
+    uint32_t state;
+    uint32_t full_hz;
+    uint32_t low_hz;
+    uint32_t gated;
+    uint32_t entries;
+    uint32_t wakes;
+    uint32_t wake_last;
+    uint32_t wake_max;
+    uint64_t wake_sum;
+    uint64_t low_time;
+    uint64_t now;
+};
+
+struct wdog_snapshot {
+    uint32_t seq;
+    uint32_t window_ms;
+    uint32_t timeout_ms;
+    uint32_t windows;
+    uint32_t kicks;
+    uint32_t failed;
+    uint32_t last_fail;
+    uint32_t count;
+    rpu_wdog_task task[WDOG_MAX_TASKS];
+};
+
+struct plintr_snapshot {
+    uint32_t seq;
+    uint32_t channels;
+    uint32_t irqs;
+    uint32_t spurious;
+    uint32_t clk_hz;
+    rpu_plintr_channel ch[PLINTR_MAX_CHANNELS];
+};
+
+// Indexed by WDOG_TASK_*
+static const char* const WDOG_TASK_NAMES[] = { "tx", "rx", "cmd" };
+#define WDOG_NAMED_TASKS (sizeof(WDOG_TASK_NAMES) / sizeof(WDOG_TASK_NAMES[0]))
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+// eTaskState values of FreeRTOS
+static const char* state_name(uint8_t state) {
+    switch (state) {
+        case 0:  return "Running";
+        case 1:  return "Ready";
+        case 2:  return "Blocked";
+        case 3:  return "Suspended";
+        case 4:  return "Deleted";
+        default: return "?";
+    }
+}
+
+/*
+ * Copy the stats block while no update is in progress.
+ * The sequence number is even and unchanged across the copy (seqlock style).
+ */
+static bool read_snapshot(const kr260hal::MemMap& win, stats_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = win.read<shm::StatsSeq>();
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.count     = win.read<shm::StatsCount>();
+        out.total     = win.read<shm::StatsTotal>();
+        out.hz        = win.read<shm::StatsHz>();
+        out.tick      = win.read<shm::StatsTick>();
+        out.heap_free = win.read<shm::StatsHeap>();
+        out.heap_min  = win.read<shm::StatsHeapMin>();
+        if (out.count > SHM_STATS_MAX_TASKS) out.count = SHM_STATS_MAX_TASKS;
+        for (uint32_t i = 0; i < out.count; i++) {
+            volatile uint32_t* src = win.at(SHM_STATS_ENTRY(i));
+            uint32_t words[SHM_STATS_ENTRY_SIZE / 4];
+            for (unsigned w = 0; w < SHM_STATS_ENTRY_SIZE / 4; w++) words[w] = src[w];
+            std::memcpy(&out.task[i], words, sizeof(out.task[i]));
+            out.task[i].name[SHM_STATS_NAME_LEN - 1] = '\0';
+        }
+        barrier::acquire();
+        if (win.read<shm::StatsSeq>() == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Same seqlock protocol for the IRQ profile block
+static bool read_irqprof(const kr260hal::MemMap& blk, irqprof_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(IRQPROF_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.hz     = *blk.at(IRQPROF_HZ_OFFSET);
+        out.passes = *blk.at(IRQPROF_PASSES_OFFSET);
+        for (unsigned i = 0; i < IRQPROF_STAGES; i++) {
+            volatile uint32_t* src = blk.at(IRQPROF_STAGE(i));
+            uint32_t words[IRQPROF_STAGE_SIZE / 4];
+            for (unsigned w = 0; w < IRQPROF_STAGE_SIZE / 4; w++) words[w] = src[w];
+            std::memcpy(&out.stage[i], words, sizeof(out.stage[i]));
+        }
+        barrier::acquire();
+        if (*blk.at(IRQPROF_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Same seqlock protocol for the APM block
+static bool read_apm(const kr260hal::MemMap& blk, apm_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(APM_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.samples   = *blk.at(APM_SAMPLES_OFFSET);
+        out.period_ms = *blk.at(APM_PERIOD_OFFSET);
+        out.ticks     = *blk.at(APM_TICKS_OFFSET);
+        out.count     = *blk.at(APM_COUNT_OFFSET);
+        if (out.count > APM_MAX_PORTS) out.count = APM_MAX_PORTS;
+        out.qos_ports = *blk.at(APM_QOS_PORTS_OFFSET);
+        out.qos_level = *blk.at(APM_QOS_LEVEL_OFFSET);
+        for (unsigned i = 0; i < out.count; i++) {
+            volatile uint32_t* src = blk.at(APM_PORT(i));
+            uint32_t words[APM_PORT_SIZE / 4];
+            for (unsigned w = 0; w < APM_PORT_SIZE / 4; w++) words[w] = src[w];
+            std::memcpy(&out.port[i], words, sizeof(out.port[i]));
+        }
+        barrier::acquire();
+        if (*blk.at(APM_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_apm(const apm_snapshot& a) {
+    // The interval is timed with the system counter on the RPU
+    const double secs = a.ticks ? (double)a.ticks / counter_freq() : a.period_ms / 1e3;
+
+    std::printf("\nAPM sample %u, interval %.1f ms\n", a.samples, secs * 1e3);
+    // The DDR QoS profile the counts were taken under, to compare runs
+    if (a.qos_ports) {
+        std::printf("QoS %u on", a.qos_level);
+        for (unsigned b = 0; b < sizeof(QOS_PORT_NAMES) / sizeof(QOS_PORT_NAMES[0]); b++)
+            if (a.qos_ports & (1u << b)) std::printf(" %s", QOS_PORT_NAMES[b]);
+        std::printf("\n");
+    } else {
+        std::printf("QoS: PS defaults\n");
+    }
+    std::printf("%-5s %-9s %-9s %-10s %-8s %-11s %s\n",
+                "port", "wr_MB/s", "rd_MB/s", "max_rd_ns", "apm_MHz", "total_wr_MB", "total_rd_MB");
+    for (unsigned i = 0; i < a.count; i++) {
+        const rpu_apm_port& p = a.port[i];
+        double hz = secs > 0 ? p.cycles / secs : 0.0;
+        uint64_t wr_total = ((uint64_t)p.wr_total_hi << 32) | p.wr_total_lo;
+        uint64_t rd_total = ((uint64_t)p.rd_total_hi << 32) | p.rd_total_lo;
+        std::printf("%-5s %-9.2f %-9.2f %-10.0f %-8.1f %-11.1f %.1f\n", APM_PORT_NAMES[i],
+                    secs > 0 ? p.wr_bytes / secs / 1e6 : 0.0,
+                    secs > 0 ? p.rd_bytes / secs / 1e6 : 0.0,
+                    hz > 0 ? p.rd_lat_max * 1e9 / hz : 0.0, hz / 1e6,
+                    wr_total / 1e6, rd_total / 1e6);
+    }
+    std::fflush(stdout);
+}
+
+static int run_apm(bool once, unsigned interval_ms) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(APM_ADDR, APM_SIZE, false)) {
+        std::perror("Error mapping the APM block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(APM_MAGIC_OFFSET);
+    if (magic != APM_MAGIC) {
+        std::cerr << "No APM samples found (magic 0x" << std::hex << magic
+                  << "); is the RPU0 firmware built with RPU_APM=1?" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    apm_snapshot snap = {};
+    uint32_t last_seq = 0;
+    bool printed = false;
+    while (!stop_requested) {
+        if (!read_apm(blk, snap)) {
+            std::cerr << "RPU APM samples are not settling; retrying" << std::endl;
+        } else if (snap.samples != 0 && (!printed || snap.seq != last_seq)) {
+            print_apm(snap);
+            printed = true;
+            last_seq = snap.seq;
+            if (once) break;
+        }
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+// Same seqlock protocol for the SYSMON block
+static bool read_sysmon(const kr260hal::MemMap& blk, sysmon_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(SYSMON_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.samples   = *blk.at(SYSMON_SAMPLES_OFFSET);
+        out.period_ms = *blk.at(SYSMON_PERIOD_OFFSET);
+        out.count     = *blk.at(SYSMON_COUNT_OFFSET);
+        out.flags     = *blk.at(SYSMON_FLAGS_OFFSET);
+        out.alarms    = *blk.at(SYSMON_ALARMS_OFFSET);
+        out.hot       = (int32_t)*blk.at(SYSMON_HOT_OFFSET);
+        out.cool      = (int32_t)*blk.at(SYSMON_COOL_OFFSET);
+        if (out.count > SYSMON_MAX_CHANNELS) out.count = SYSMON_MAX_CHANNELS;
+        for (unsigned i = 0; i < out.count; i++) {
+            volatile uint32_t* src = blk.at(SYSMON_CH(i));
+            uint32_t words[SYSMON_CH_SIZE / 4];
+            for (unsigned w = 0; w < SYSMON_CH_SIZE / 4; w++) words[w] = src[w];
+            std::memcpy(&out.ch[i], words, sizeof(out.ch[i]));
+        }
+        barrier::acquire();
+        if (*blk.at(SYSMON_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_sysmon(const sysmon_snapshot& m) {
+    std::printf("\nSYSMON sample %u (every %u ms), alarm %s at %.1f C / %.1f C, set %u times\n",
+                m.samples, m.period_ms, (m.flags & SYSMON_FLAG_HOT) ? "HOT" : "clear",
+                m.hot / 1e3, m.cool / 1e3, m.alarms);
+    std::printf("%-12s %-9s %-9s %-9s\n", "channel", "value", "min", "max");
+    for (unsigned i = 0; i < m.count; i++) {
+        const rpu_sysmon_channel& c = m.ch[i];
+        bool temp = i == SYSMON_CH_TEMP_LPD || i == SYSMON_CH_TEMP_FPD;
+        std::printf("%-12s %-9.3f %-9.3f %-9.3f %s\n",
+                    i < SYSMON_NAMED_CHANNELS ? SYSMON_CH_NAMES[i] : "?",
+                    c.value / 1e3, c.min / 1e3, c.max / 1e3, temp ? "C" : "V");
+    }
+    std::fflush(stdout);
+}
+
+static int run_sysmon(bool once, unsigned interval_ms) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(SYSMON_ADDR, SYSMON_SIZE, false)) {
+        std::perror("Error mapping the SYSMON block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(SYSMON_MAGIC_OFFSET);
+    if (magic != SYSMON_MAGIC) {
+        std::cerr << "No SYSMON samples found (magic 0x" << std::hex << magic
+                  << "); is the RPU0 firmware built with RPU_SYSMON=1?" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    sysmon_snapshot snap = {};
+    uint32_t last_seq = 0;
+    bool printed = false;
+    while (!stop_requested) {
+        if (!read_sysmon(blk, snap)) {
+            std::cerr << "RPU SYSMON samples are not settling; retrying" << std::endl;
+        } else if (snap.samples != 0 && (!printed || snap.seq != last_seq)) {
+            print_sysmon(snap);
+            printed = true;
+            last_seq = snap.seq;
+            if (once) return (snap.flags & SYSMON_FLAG_HOT) ? 2 : 0;
+        }
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+// Same seqlock protocol for the governor block
+static bool read_gov(const kr260hal::MemMap& blk, gov_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(GOV_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.state     = *blk.at(GOV_STATE_OFFSET);
+        out.full_hz   = *blk.at(GOV_FULL_HZ_OFFSET);
+        out.low_hz    = *blk.at(GOV_LOW_HZ_OFFSET);
+        out.gated     = *blk.at(GOV_GATED_OFFSET);
+        out.entries   = *blk.at(GOV_ENTRIES_OFFSET);
+        out.wakes     = *blk.at(GOV_WAKES_OFFSET);
+        out.wake_last = *blk.at(GOV_WAKE_LAST_OFFSET);
+        out.wake_max  = *blk.at(GOV_WAKE_MAX_OFFSET);
+        out.wake_sum  = ((uint64_t)*blk.at(GOV_WAKE_SUM_HI) << 32) | *blk.at(GOV_WAKE_SUM_LO);
+        out.low_time  = ((uint64_t)*blk.at(GOV_LOW_TIME_HI) << 32) | *blk.at(GOV_LOW_TIME_LO);
+        out.now       = ((uint64_t)*blk.at(GOV_NOW_HI) << 32) | *blk.at(GOV_NOW_LO);
+        barrier::acquire();
+        if (*blk.at(GOV_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Power reading in microwatts, as hwmon power*_input files give it
+static bool read_power_uw(const char* path, double& uw) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) return false;
+    bool ok = std::fscanf(f, "%lf", &uw) == 1;
+    std::fclose(f);
+    return ok;
+}
+
+// Power samples averaged per GOV_STATE_*
+struct gov_power {
+    double sum_uw[2] = { 0.0, 0.0 };
+    unsigned count[2] = { 0, 0 };
+};
+
+static void print_gov(const gov_snapshot& g, const gov_snapshot& prev, const gov_snapshot& first,
+                      const char* power_path, const gov_power& pw) {
+    auto share = [](uint64_t low, uint64_t span) { return span ? 100.0 * low / span : 0.0; };
+
+    std::printf("\nstate %-5s R5 %.1f MHz, idle %.1f MHz, %u clock(s) gated\n",
+                g.state == GOV_STATE_LOW ? "LOW" : "FULL", g.full_hz / 1e6, g.low_hz / 1e6, g.gated);
+    std::printf("low %.1f%% (interval), %.1f%% (run)  entries %u  wakes %u\n",
+                share(g.low_time - prev.low_time, g.now - prev.now),
+                share(g.low_time - first.low_time, g.now - first.now), g.entries, g.wakes);
+    std::printf("wake_us last %.3f  mean %.3f  max %.3f\n", g.wake_last / 1e3,
+                g.wakes ? g.wake_sum / 1e3 / g.wakes : 0.0, g.wake_max / 1e3);
+    if (power_path) {
+        double full = pw.count[GOV_STATE_FULL] ? pw.sum_uw[GOV_STATE_FULL] / pw.count[GOV_STATE_FULL] / 1e3 : 0.0;
+        double low = pw.count[GOV_STATE_LOW] ? pw.sum_uw[GOV_STATE_LOW] / pw.count[GOV_STATE_LOW] / 1e3 : 0.0;
+        std::printf("power full %.1f mW (%u), low %.1f mW (%u)", full, pw.count[GOV_STATE_FULL],
+                    low, pw.count[GOV_STATE_LOW]);
+        if (pw.count[GOV_STATE_FULL] && pw.count[GOV_STATE_LOW] && full > 0.0) {
+            std::printf(", saving %.1f mW (%.1f%%)", full - low, 100.0 * (full - low) / full);
+        }
+        std::printf("\n");
+    }
+    std::fflush(stdout);
+}
+
+static int run_gov(bool once, unsigned interval_ms, const char* power_path) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(GOV_ADDR, GOV_SIZE, false)) {
+        std::perror("Error mapping the governor block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(GOV_MAGIC_OFFSET);
+    if (magic != GOV_MAGIC) {
+        std::cerr << "No governor found (magic 0x" << std::hex << magic
+                  << "); is the RPU0 firmware built with RPU_GOVERNOR=1?" << std::endl;
+        return 1;
+    }
+    double uw;
+    if (power_path && !read_power_uw(power_path, uw)) {
+        std::perror("Error reading the power sensor");
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    gov_snapshot first = {}, prev = {}, cur = {};
+    gov_power pw;
+    bool have_first = false;
+    while (!stop_requested) {
+        if (!read_gov(blk, cur)) {
+            std::cerr << "RPU governor block is not settling; retrying" << std::endl;
+        } else {
+            if (!have_first) {
+                first = prev = cur;
+                have_first = true;
+            }
+            if (power_path && cur.state <= GOV_STATE_LOW && read_power_uw(power_path, uw)) {
+                pw.sum_uw[cur.state] += uw;
+                pw.count[cur.state]++;
+            }
+            print_gov(cur, prev, first, power_path, pw);
+            prev = cur;
+            if (once) return 0;
+        }
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+// Same seqlock protocol for the watchdog block
+static bool read_wdog(const kr260hal::MemMap& blk, wdog_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(WDOG_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.window_ms  = *blk.at(WDOG_WINDOW_MS_OFFSET);
+        out.timeout_ms = *blk.at(WDOG_TIMEOUT_MS_OFFSET);
+        out.windows    = *blk.at(WDOG_WINDOWS_OFFSET);
+        out.kicks      = *blk.at(WDOG_KICKS_OFFSET);
+        out.failed     = *blk.at(WDOG_FAILED_OFFSET);
+        out.last_fail  = *blk.at(WDOG_LAST_FAIL_OFFSET);
+        out.count      = *blk.at(WDOG_COUNT_OFFSET);
+        if (out.count > WDOG_MAX_TASKS) out.count = WDOG_MAX_TASKS;
+        for (uint32_t i = 0; i < out.count; i++) {
+            const volatile uint32_t* e = blk.at(WDOG_TASK(i));
+            out.task[i].met      = e[0];
+            out.task[i].missed   = e[1];
+            out.task[i].stalls   = e[2];
+            out.task[i].worst_us = e[3];
+        }
+        barrier::acquire();
+        if (*blk.at(WDOG_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_wdog(const wdog_snapshot& w) {
+    std::printf("\nwindow %u ms, timeout %u ms  windows %u  kicks %u  failed %u",
+                w.window_ms, w.timeout_ms, w.windows, w.kicks, w.failed);
+    if (w.failed) {
+        const char* sep = " (last:";
+        for (uint32_t i = 0; i < w.count; i++) {
+            if (!(w.last_fail & (1U << i))) continue;
+            std::printf("%s %s", sep, i < WDOG_NAMED_TASKS ? WDOG_TASK_NAMES[i] : "?");
+            sep = ",";
+        }
+        std::printf(")");
+    }
+    std::printf("\n%-5s %-9s %-9s %-9s %s\n", "task", "met", "missed", "stalls", "worst_us");
+    for (uint32_t i = 0; i < w.count; i++) {
+        const rpu_wdog_task& t = w.task[i];
+        std::printf("%-5s %-9u %-9u %-9u %u\n", i < WDOG_NAMED_TASKS ? WDOG_TASK_NAMES[i] : "?",
+                    t.met, t.missed, t.stalls, t.worst_us);
+    }
+    std::fflush(stdout);
+}
+
+static int run_wdog(bool once, unsigned interval_ms) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(WDOG_ADDR, WDOG_SIZE, false)) {
+        std::perror("Error mapping the watchdog block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(WDOG_MAGIC_OFFSET);
+    if (magic != WDOG_MAGIC) {
+        std::cerr << "No watchdog supervision found (magic 0x" << std::hex << magic
+                  << "); is the RPU0 firmware built with RPU_WATCHDOG=1?" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    wdog_snapshot snap = {};
+    uint32_t last_seq = 0;
+    bool printed = false;
+    while (!stop_requested) {
+        if (!read_wdog(blk, snap)) {
+            std::cerr << "RPU watchdog block is not settling; retrying" << std::endl;
+        } else if (!printed || snap.seq != last_seq) {
+            print_wdog(snap);
+            printed = true;
+            last_seq = snap.seq;
+            if (once) break;
+        }
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+// Same seqlock protocol for the PL interrupt block
+static bool read_plintr(const kr260hal::MemMap& blk, plintr_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(PLINTR_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.channels = *blk.at(PLINTR_CHANNELS_OFFSET);
+        out.irqs     = *blk.at(PLINTR_IRQS_OFFSET);
+        out.spurious = *blk.at(PLINTR_SPURIOUS_OFFSET);
+        out.clk_hz   = *blk.at(PLINTR_CLK_HZ_OFFSET);
+        if (out.channels > PLINTR_MAX_CHANNELS) out.channels = PLINTR_MAX_CHANNELS;
+        for (uint32_t i = 0; i < out.channels; i++) {
+            const volatile uint32_t* e = blk.at(PLINTR_CH(i));
+            out.ch[i].events         = e[0];
+            out.ch[i].irqs           = e[1];
+            out.ch[i].lost           = e[2];
+            out.ch[i].latency_last   = e[3];
+            out.ch[i].latency_min    = e[4];
+            out.ch[i].latency_max    = e[5];
+            out.ch[i].latency_sum_lo = e[6];
+            out.ch[i].latency_sum_hi = e[7];
+        }
+        barrier::acquire();
+        if (*blk.at(PLINTR_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_plintr(const plintr_snapshot& p) {
+    // PL clocks to ns
+    const double ns = p.clk_hz ? 1e9 / p.clk_hz : 0.0;
+
+    std::printf("\nirqs %u  spurious %u  PL clock %.1f MHz\n", p.irqs, p.spurious, p.clk_hz / 1e6);
+    std::printf("%-3s %-10s %-10s %-10s %-8s %-8s %-8s %s\n", "ch", "events", "irqs", "lost",
+                "last_ns", "min_ns", "mean_ns", "max_ns");
+    for (uint32_t i = 0; i < p.channels; i++) {
+        const rpu_plintr_channel& c = p.ch[i];
+        uint64_t sum = ((uint64_t)c.latency_sum_hi << 32) | c.latency_sum_lo;
+        double mean = c.irqs ? (double)sum / c.irqs * ns : 0.0;
+        std::printf("%-3u %-10u %-10u %-10u %-8.0f %-8.0f %-8.1f %.0f\n", i, c.events, c.irqs,
+                    c.lost, c.latency_last * ns, c.latency_min * ns, mean, c.latency_max * ns);
+    }
+    std::fflush(stdout);
+}
+
+static int run_plintr(bool once, unsigned interval_ms) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(PLINTR_ADDR, PLINTR_SIZE, false)) {
+        std::perror("Error mapping the PL interrupt block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(PLINTR_MAGIC_OFFSET);
+    if (magic != PLINTR_MAGIC) {
+        std::cerr << "No PL interrupt block found (magic 0x" << std::hex << magic
+                  << "); is the RPU0 firmware built with RPU_PL_INTR=1?" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    static plintr_snapshot snap;
+    uint32_t last_seq = 0;
+    bool printed = false;
+    while (!stop_requested) {
+        if (!read_plintr(blk, snap)) {
+            std::cerr << "RPU PL interrupt block is not settling; retrying" << std::endl;
+        } else if (!printed || snap.seq != last_seq) {
+            print_plintr(snap);
+            printed = true;
+            last_seq = snap.seq;
+            if (once) break;
+        }
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+struct apm_capture {
+    unsigned port = APM_MAX_PORTS;    // APM_MAX_PORTS: no capture requested
+    uint32_t id = 0;
+    uint32_t id_mask = 0;
+    unsigned interval_us = APM_CAP_INTERVAL_US_DEFAULT;
+    unsigned records = APM_CAP_RECORDS_DEFAULT;
+};
+
+static void print_capture(const volatile uint32_t* rec, uint32_t count, uint64_t start,
+                          uint32_t interval, double apm_hz) {
+    const double ticks_per_us = counter_freq() / 1e6;
+    const double secs = interval / apm_hz;
+    const double gap_ticks = 1.5 * secs * counter_freq();
+    uint64_t prev = start;
+    uint32_t lost = 0;
+
+    std::printf("%-11s %-9s %-9s %s\n", "t_us", "wr_MB/s", "rd_MB/s", "max_rd_ns");
+    for (uint32_t i = 0; i < count; i++) {
+        const volatile uint32_t* r = rec + i * (APM_RECORD_SIZE / 4);
+        // The timestamps are the low halves: unwrap against the previous one
+        uint64_t ts = prev + (uint32_t)(r[0] - (uint32_t)prev);
+
+        if (i != 0 && ts - prev > gap_ticks) {
+            uint32_t n = (uint32_t)((ts - prev) / (secs * counter_freq()) + 0.5) - 1;
+            std::printf("-- %u interval(s) lost --\n", n);
+            lost += n;
+        }
+        std::printf("%-11.2f %-9.2f %-9.2f %.0f\n", (ts - start) / ticks_per_us,
+                    r[1] / secs / 1e6, r[2] / secs / 1e6, r[3] * 1e9 / apm_hz);
+        prev = ts;
+    }
+    std::printf("%u record(s), %u lost, interval %.2f us at %.1f MHz\n",
+                count, lost, secs * 1e6, apm_hz / 1e6);
+}
+
+static int run_apm_capture(const apm_capture& cap) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(APM_ADDR, APM_SIZE)) {
+        std::perror("Error mapping the APM block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(APM_MAGIC_OFFSET);
+    if (magic != APM_MAGIC) {
+        std::cerr << "No APM samples found (magic 0x" << std::hex << magic
+                  << "); is the RPU0 firmware built with RPU_APM=1?" << std::endl;
+        return 1;
+    }
+    if (cap.records == 0 || cap.records > BULK_DDR_CORE_SIZE / APM_RECORD_SIZE) {
+        std::cerr << "--apm-records must be 1.." << BULK_DDR_CORE_SIZE / APM_RECORD_SIZE << std::endl;
+        return 1;
+    }
+    kr260hal::MemMap ddr;
+    if (!ddr.map_phys(BULK_DDR_ADDR_CORE(0), BULK_DDR_CORE_SIZE, false)) {
+        std::perror("Error mapping the bulk carveout");
+        return 1;
+    }
+
+    // The APM clock follows from a periodic sample of the same port
+    apm_snapshot snap = {};
+    if (!read_apm(blk, snap) || snap.samples == 0 || cap.port >= snap.count || snap.ticks == 0 ||
+        snap.port[cap.port].cycles == 0) {
+        std::cerr << "No APM sample of port " << APM_PORT_NAMES[cap.port] << " yet" << std::endl;
+        return 1;
+    }
+    const double apm_hz = snap.port[cap.port].cycles * (double)counter_freq() / snap.ticks;
+    uint64_t interval = (uint64_t)(cap.interval_us * apm_hz / 1e6 + 0.5);
+    if (interval < APM_CAP_MIN_INTERVAL) interval = APM_CAP_MIN_INTERVAL;
+    if (interval > UINT32_MAX) interval = UINT32_MAX;
+
+    *blk.at(APM_CAP_PORT_OFFSET) = cap.port;
+    *blk.at(APM_CAP_ID_OFFSET) = cap.id;
+    *blk.at(APM_CAP_ID_MASK_OFFSET) = cap.id_mask;
+    *blk.at(APM_CAP_INTERVAL_OFFSET) = (uint32_t)interval;
+    *blk.at(APM_CAP_BUF_OFFSET) = 0;
+    *blk.at(APM_CAP_RECORDS_OFFSET) = cap.records;
+    // The request must be visible before the generation that publishes it
+    uint32_t gen = *blk.at(APM_CAP_GEN_OFFSET) + 1;
+    barrier::release();
+    *blk.at(APM_CAP_GEN_OFFSET) = gen;
+
+    // The task polls at its sample period; allow for that and the capture itself
+    std::signal(SIGINT, handle_sigint);
+    const double capture_ms = cap.records * (interval / apm_hz) * 1e3;
+    const uint64_t timeout_ms = (uint64_t)capture_ms + 4 * snap.period_ms + 3000;
+    uint64_t waited_ms = 0;
+    while (*blk.at(APM_CAP_DONE_OFFSET) != gen) {
+        if (stop_requested || waited_ms >= timeout_ms) {
+            std::cerr << "APM capture did not complete" << std::endl;
+            return 1;
+        }
+        usleep(1000);
+        waited_ms++;
+    }
+    barrier::acquire();
+
+    uint32_t status = *blk.at(APM_CAP_STATUS_OFFSET);
+    uint32_t count = *blk.at(APM_CAP_COUNT_OFFSET);
+    uint64_t start = ((uint64_t)*blk.at(APM_CAP_START_HI_OFFSET) << 32) |
+                     *blk.at(APM_CAP_START_LO_OFFSET);
+    if (count > cap.records) count = cap.records;
+    if (status == RPU_CMD_STATUS_BADARG) {
+        std::cerr << "The RPU rejected the capture request" << std::endl;
+        return 1;
+    }
+
+    std::printf("APM capture of %s", APM_PORT_NAMES[cap.port]);
+    if (cap.id_mask != 0) std::printf(", ID 0x%X mask 0x%X", cap.id, cap.id_mask);
+    std::printf("\n");
+    print_capture(ddr.at(0), count, start, (uint32_t)interval, apm_hz);
+    if (status != RPU_CMD_STATUS_OK) {
+        std::cerr << "Capture stopped early (status " << status << ")" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// One row of --irq or --bench: the statistics and the occupied buckets
+static void print_stage_row(const char* name, const rpu_irqprof_stage& s, double us_per_cycle) {
+    if (s.count == 0) {
+        std::printf("%-10s 0\n", name);
+        return;
+    }
+    uint64_t sum = ((uint64_t)s.sum_hi << 32) | s.sum_lo;
+    std::printf("%-10s %-8u %-8.3f %-8.3f %-8.3f %-8.3f", name, s.count,
+                s.min * us_per_cycle, (double)sum / s.count * us_per_cycle,
+                s.max * us_per_cycle, s.last * us_per_cycle);
+    // Bucket n holds samples below 2^(n + IRQPROF_BUCKET_SHIFT) cycles; the last is open
+    for (unsigned b = 0; b < IRQPROF_BUCKETS; b++) {
+        if (s.hist[b] == 0) continue;
+        if (b == IRQPROF_BUCKETS - 1) {
+            std::printf(" >=%.2fus:%u", (double)(1U << (b + IRQPROF_BUCKET_SHIFT - 1)) * us_per_cycle,
+                        s.hist[b]);
+        } else {
+            std::printf(" <%.2fus:%u", (double)(1U << (b + IRQPROF_BUCKET_SHIFT)) * us_per_cycle,
+                        s.hist[b]);
+        }
+    }
+    std::printf("\n");
+}
+
+static void print_irqprof(const irqprof_snapshot& p) {
+    const double us_per_cycle = p.hz ? 1e6 / p.hz : 0.0;
+
+    std::printf("\nIPI passes %u, cycle counter %.1f MHz\n", p.passes, p.hz / 1e6);
+    std::printf("%-10s %-8s %-8s %-8s %-8s %-8s %s\n",
+                "stage", "count", "min_us", "mean_us", "max_us", "last_us", "histogram");
+    for (unsigned i = 0; i < IRQPROF_STAGES; i++) {
+        print_stage_row(IRQPROF_STAGE_NAMES[i], p.stage[i], us_per_cycle);
+    }
+    std::fflush(stdout);
+}
+
+// Same seqlock protocol for the benchmark block
+static bool read_bench(const kr260hal::MemMap& blk, bench_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(BENCH_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.hz         = *blk.at(BENCH_HZ_OFFSET);
+        out.rounds     = *blk.at(BENCH_ROUNDS_OFFSET);
+        out.iterations = *blk.at(BENCH_ITERATIONS_OFFSET);
+        for (unsigned i = 0; i < BENCH_TESTS; i++) {
+            volatile uint32_t* src = blk.at(BENCH_TEST(i));
+            uint32_t words[IRQPROF_STAGE_SIZE / 4];
+            for (unsigned w = 0; w < IRQPROF_STAGE_SIZE / 4; w++) words[w] = src[w];
+            std::memcpy(&out.test[i], words, sizeof(out.test[i]));
+        }
+        barrier::acquire();
+        if (*blk.at(BENCH_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_bench(const bench_snapshot& p) {
+    const double us_per_cycle = p.hz ? 1e6 / p.hz : 0.0;
+
+    std::printf("\nbench rounds %u, %u samples per test and round, cycle counter %.1f MHz\n",
+                p.rounds, p.iterations, p.hz / 1e6);
+    std::printf("%-10s %-8s %-8s %-8s %-8s %-8s %s\n",
+                "test", "count", "min_us", "mean_us", "max_us", "last_us", "histogram");
+    for (unsigned i = 0; i < BENCH_TESTS; i++) {
+        print_stage_row(BENCH_TEST_NAMES[i], p.test[i], us_per_cycle);
+    }
+    std::fflush(stdout);
+}
+
+static int run_bench(bool once, unsigned interval_ms) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(BENCH_ADDR, BENCH_SIZE, false)) {
+        std::perror("Error mapping the benchmark block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(BENCH_MAGIC_OFFSET);
+    if (magic != BENCH_MAGIC) {
+        std::cerr << "No RPU benchmark found (magic 0x" << std::hex << magic
+                  << "); is the RPU0 firmware built with RPU_BENCH=1?" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    bench_snapshot snap = {};
+    uint32_t last_seq = 0;
+    bool printed = false;
+    while (!stop_requested) {
+        if (!read_bench(blk, snap)) {
+            std::cerr << "RPU benchmark block is not settling; retrying" << std::endl;
+        } else if (!printed || snap.seq != last_seq) {
+            print_bench(snap);
+            printed = true;
+            last_seq = snap.seq;
+            if (once) break;
+        }
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+// Same seqlock protocol for the memory watermark block
+static bool read_mem(const kr260hal::MemMap& blk, mem_snapshot& out) {
+    for (int tries = 0; tries < STATS_READ_RETRIES; tries++) {
+        uint32_t s = *blk.at(MEM_SEQ_OFFSET);
+        if (s & 1) {
+            usleep(100);
+            continue;
+        }
+        barrier::acquire();
+        out.count     = *blk.at(MEM_COUNT_OFFSET);
+        out.heap_size = *blk.at(MEM_HEAP_SIZE_OFFSET);
+        out.heap_free = *blk.at(MEM_HEAP_FREE_OFFSET);
+        out.heap_min  = *blk.at(MEM_HEAP_MIN_OFFSET);
+        if (out.count > MEM_MAX_TASKS) out.count = MEM_MAX_TASKS;
+        for (unsigned i = 0; i < MEM_MODES; i++) {
+            out.mode[i].size     = blk.at(MEM_MODE(i))[0];
+            out.mode[i].min_free = blk.at(MEM_MODE(i))[1];
+        }
+        for (unsigned i = 0; i < out.count; i++) {
+            volatile uint32_t* src = blk.at(MEM_TASK(i));
+            uint32_t words[MEM_TASK_SIZE / 4];
+            for (unsigned w = 0; w < MEM_TASK_SIZE / 4; w++) words[w] = src[w];
+            std::memcpy(&out.task[i], words, sizeof(out.task[i]));
+            out.task[i].name[SHM_STATS_NAME_LEN - 1] = '\0';
+        }
+        barrier::acquire();
+        if (*blk.at(MEM_SEQ_OFFSET) == s) {
+            out.seq = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+// One row of --mem: the peak use and a size with the margin above it
+static void print_mem_row(const char* name, uint32_t size, uint32_t min_free) {
+    if (size == 0) {
+        // More tasks than the firmware keeps stack sizes for
+        std::printf("%-10s %-8s %-8s %-8u %s\n", name, "?", "?", min_free, "?");
+        return;
+    }
+    uint32_t used = min_free < size ? size - min_free : 0;
+    uint32_t suggest = (used + used * MEM_MARGIN_PERCENT / 100 + 15) & ~15U;
+    std::printf("%-10s %-8u %-8u %-8u %u%s\n", name, size, used, min_free, suggest,
+                min_free == 0 ? "  (exhausted)" : "");
+}
+
+static void print_mem(const mem_snapshot& p) {
+    std::printf("\n");
+    if (p.heap_size != 0) {
+        std::printf("heap %u bytes, free %u, min free %u (peak used %u)\n", p.heap_size,
+                    p.heap_free, p.heap_min, p.heap_size - p.heap_min);
+    } else {
+        std::printf("no heap (static allocation)\n");
+    }
+    std::printf("%-10s %-8s %-8s %-8s %s\n", "stack", "size", "used", "min_free", "suggest");
+    for (unsigned i = 0; i < p.count; i++) {
+        print_mem_row(p.task[i].name, p.task[i].size, p.task[i].min_free);
+    }
+    for (unsigned i = 0; i < MEM_MODES; i++) {
+        print_mem_row(MEM_MODE_NAMES[i], p.mode[i].size, p.mode[i].min_free);
+    }
+    std::fflush(stdout);
+}
+
+static int run_mem(unsigned core, bool once, unsigned interval_ms) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(MEM_ADDR(core), MEM_SIZE, false)) {
+        std::perror("Error mapping the memory watermark block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(MEM_MAGIC_OFFSET);
+    if (magic != MEM_MAGIC) {
+        std::cerr << "No RPU memory watermarks found (magic 0x" << std::hex << magic
+                  << "); is the RPU firmware running?" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    mem_snapshot snap = {};
+    uint32_t last_seq = 0;
+    bool printed = false;
+    while (!stop_requested) {
+        if (!read_mem(blk, snap)) {
+            std::cerr << "RPU memory watermarks are not settling; retrying" << std::endl;
+        } else if (!printed || snap.seq != last_seq) {
+            print_mem(snap);
+            printed = true;
+            last_seq = snap.seq;
+            if (once) break;
+        }
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+static int run_irqprof(unsigned core, bool once, unsigned interval_ms, bool reset) {
+    kr260hal::MemMap blk;
+    if (!blk.map_phys(IRQPROF_ADDR(core), IRQPROF_SIZE, reset)) {
+        std::perror("Error mapping the IRQ profile block");
+        return 1;
+    }
+    uint32_t magic = *blk.at(IRQPROF_MAGIC_OFFSET);
+    if (magic != IRQPROF_MAGIC) {
+        std::cerr << "No RPU IRQ profile found (magic 0x" << std::hex << magic
+                  << "); is the firmware built with RPU_IRQ_PROF=1?" << std::endl;
+        return 1;
+    }
+    if (reset) {
+        // The RPU clears the statistics at the end of its next IPI pass
+        *blk.at(IRQPROF_RESET_OFFSET) = 1;
+        barrier::complete();
+        std::cout << "IRQ profile reset requested" << std::endl;
+        return 0;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+    irqprof_snapshot snap = {};
+    uint32_t last_seq = 0;
+    bool printed = false;
+    while (!stop_requested) {
+        if (!read_irqprof(blk, snap)) {
+            std::cerr << "RPU IRQ profile is not settling; retrying" << std::endl;
+        } else if (!printed || snap.seq != last_seq) {
+            print_irqprof(snap);
+            printed = true;
+            last_seq = snap.seq;
+            if (once) break;
+        }
+        usleep(interval_ms * 1000);
+    }
+    return 0;
+}
+
+// Run time of task number 'number' in the previous snapshot, if it was there
+static bool prev_run_time(const stats_snapshot& prev, uint8_t number, uint32_t& run_time) {
+    for (uint32_t i = 0; i < prev.count; i++) {
+        if (prev.task[i].number == number) {
+            run_time = prev.task[i].run_time;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_snapshot(const stats_snapshot& cur, const stats_snapshot* prev) {
+    uint32_t span = prev ? cur.total - prev->total : cur.total;
+
+    std::printf("\nRPU tick %u, %s %.3f s, ", cur.tick, prev ? "interval" : "since start",
+                cur.hz ? (double)span / cur.hz : 0.0);
+    // A firmware without a FreeRTOS heap (static allocation only) reports 0
+    if (cur.heap_min != 0) {
+        std::printf("heap free %u (min %u) bytes\n", cur.heap_free, cur.heap_min);
+    } else {
+        std::printf("no heap (static allocation)\n");
+    }
+    std::printf("%-11s %-4s %-5s %-10s %-8s %s\n",
+                "task", "num", "prio", "state", "cpu%", "stack_free");
+
+    for (uint32_t i = 0; i < cur.count; i++) {
+        const rpu_shm_task_stat& t = cur.task[i];
+        uint32_t base_run = 0;
+        uint32_t run = t.run_time;
+        if (prev && prev_run_time(*prev, t.number, base_run)) run -= base_run;
+        double pct = span ? 100.0 * run / span : 0.0;
+
+        std::printf("%-11s %-4u %-5u %-10s %-8.2f %u\n",
+                    t.name, t.number, t.priority, state_name(t.state), pct, t.stack_free);
+    }
+    std::fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    bool once = false;
+    unsigned interval_ms = STATS_POLL_MS_DEFAULT;
+    unsigned core = 0;
+    bool irq = false;
+    bool irq_reset = false;
+    bool apm = false;
+    bool sysmon = false;
+    bool gov = false;
+    bool wdog = false;
+    bool bench = false;
+    bool plintr = false;
+    bool mem = false;
+    const char* power_path = nullptr;
+    apm_capture cap;
+
+    enum { OPT_APM_CAPTURE = 256, OPT_APM_ID, OPT_APM_ID_MASK, OPT_APM_INTERVAL_US,
+           OPT_APM_RECORDS, OPT_SYSMON, OPT_GOV, OPT_GOV_POWER, OPT_WDOG, OPT_BENCH,
+           OPT_PLINTR, OPT_MEM };
+    static const struct option long_opts[] = {
+        {"once",        no_argument,       nullptr, 'o'},
+        {"irq",         no_argument,       nullptr, 'q'},
+        {"irq-reset",   no_argument,       nullptr, 'r'},
+        {"apm",         no_argument,       nullptr, 'a'},
+        {"apm-capture", required_argument, nullptr, OPT_APM_CAPTURE},
+        {"apm-id",      required_argument, nullptr, OPT_APM_ID},
+        {"apm-id-mask", required_argument, nullptr, OPT_APM_ID_MASK},
+        {"apm-interval-us", required_argument, nullptr, OPT_APM_INTERVAL_US},
+        {"apm-records", required_argument, nullptr, OPT_APM_RECORDS},
+        {"sysmon",      no_argument,       nullptr, OPT_SYSMON},
+        {"gov",         no_argument,       nullptr, OPT_GOV},
+        {"gov-power",   required_argument, nullptr, OPT_GOV_POWER},
+        {"wdog",        no_argument,       nullptr, OPT_WDOG},
+        {"bench",       no_argument,       nullptr, OPT_BENCH},
+        {"plintr",      no_argument,       nullptr, OPT_PLINTR},
+        {"mem",         no_argument,       nullptr, OPT_MEM},
+        {"interval-ms", required_argument, nullptr, 'i'},
+        {"core",        required_argument, nullptr, 'c'},
+        {"help",        no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "oqrai:c:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'o': once = true; break;
+            case 'q': irq = true; break;
+            case 'r': irq_reset = true; break;
+            case 'a': apm = true; break;
+            case 'i': interval_ms = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_APM_ID: cap.id = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_APM_ID_MASK: cap.id_mask = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_APM_INTERVAL_US: cap.interval_us = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_APM_RECORDS: cap.records = std::strtoul(optarg, nullptr, 0); break;
+            case OPT_SYSMON: sysmon = true; break;
+            case OPT_GOV: gov = true; break;
+            case OPT_GOV_POWER: gov = true; power_path = optarg; break;
+            case OPT_WDOG: wdog = true; break;
+            case OPT_BENCH: bench = true; break;
+            case OPT_PLINTR: plintr = true; break;
+            case OPT_MEM: mem = true; break;
+            case OPT_APM_CAPTURE:
+                // The last name is the placeholder of an unknown port
+                for (cap.port = 0; cap.port < APM_MAX_PORTS - 1; cap.port++) {
+                    if (std::strcmp(optarg, APM_PORT_NAMES[cap.port]) == 0) break;
+                }
+                break;
+            case 'c':
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core < RPU_CORE_COUNT) break;
+                // fall through
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--once] [--interval-ms <ms>] [--core <0|1>]"
+                          << " [--irq | --irq-reset | --apm | --apm-capture <ocm|lpd|cci>"
+                          << " [--apm-id <id> --apm-id-mask <mask>] [--apm-interval-us <us>]"
+                          << " [--apm-records <n>] | --sysmon | --gov [--gov-power <file>]"
+                          << " | --wdog | --bench | --plintr | --mem]" << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (cap.port == APM_MAX_PORTS - 1) {
+        std::cerr << "Unknown APM port; use ocm, lpd or cci" << std::endl;
+        return 1;
+    }
+    if (cap.port < APM_MAX_PORTS) {
+        return run_apm_capture(cap);
+    }
+    if (apm) {
+        return run_apm(once, interval_ms);
+    }
+    if (sysmon) {
+        return run_sysmon(once, interval_ms);
+    }
+    if (gov) {
+        return run_gov(once, interval_ms, power_path);
+    }
+    if (wdog) {
+        return run_wdog(once, interval_ms);
+    }
+    if (bench) {
+        return run_bench(once, interval_ms);
+    }
+    if (plintr) {
+        return run_plintr(once, interval_ms);
+    }
+    if (mem) {
+        return run_mem(core, once, interval_ms);
+    }
+    if (irq || irq_reset) {
+        return run_irqprof(core, once, interval_ms, irq_reset);
+    }
+
+    // Map through /dev/mem, read-only: the RPU owns the stats
+    kr260hal::MemMap win;
+    if (!win.map_phys(kr260hal::shm_window_addr(core), SHARED_MEM_SIZE, false)) {
+        std::perror("Error mapping shared memory");
+        return 1;
+    }
+
+    uint32_t magic = win.read<shm::StatsMagic>();
+    if (magic != SHM_STATS_MAGIC) {
+        std::cerr << "No RPU task stats found (magic 0x" << std::hex << magic
+                  << "); is the RPU firmware running?" << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_sigint);
+
+    static stats_snapshot snap[2];
+    int cur = 0;
+    bool have_prev = false;
+
+    while (!stop_requested) {
+        if (!read_snapshot(win, snap[cur])) {
+            std::cerr << "RPU task stats are not settling; retrying" << std::endl;
+        } else if (have_prev && snap[cur].seq == snap[cur ^ 1].seq) {
+            // No new snapshot yet
+        } else {
+            // A sequence number that went backwards means the firmware restarted
+            bool restarted = have_prev && (int32_t)(snap[cur].seq - snap[cur ^ 1].seq) < 0;
+            print_snapshot(snap[cur], (have_prev && !restarted) ? &snap[cur ^ 1] : nullptr);
+            have_prev = true;
+            cur ^= 1;
+            if (once) break;
+        }
+        usleep(interval_ms * 1000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,538 @@
+/*
+ * APU tool to decode the RPU event trace live from shared memory.
+ *
+ * Usage: ./rpu_trace            (follow new events until Ctrl-C)
+ *        ./rpu_trace --once     (dump the buffered events and exit)
+ *        ./rpu_trace --interval-ms <ms>   (follow poll period, default 10)
+ *        ./rpu_trace --core 1      (RPU1 firmware in split mode)
+ *        ./rpu_trace --monotonic   (time column in CLOCK_MONOTONIC seconds)
+ *        ./rpu_trace --record <file>  (copy /dev/rpu_trace to a file until Ctrl-C)
+ *        ./rpu_trace --input <file>   (decode a recording, or /dev/rpu_trace)
+ *
+ * The RPU firmware records timestamped events (IPI received, ACK written,
+ * ring drained, mode change, GPIO write and input, waveform start/end) into the trace buffer of the shared
+ * window (see common/rpu_shm.h). Timestamps are system counter ticks, the
+ * same time base as the A53 generic timer, so the tool prints each event both
+ * relative to the previous one and as its age against the APU clock:
+ *   idx     time_us      delta_us  age_us     event        args
+ *   1042    81234.512    +3.210    910.400    ACK          seq=17 ack=0xDEADBE01
+ * With --monotonic the time column is the APU's CLOCK_MONOTONIC in seconds,
+ * comparable with clock_gettime() timestamps of APU programs; it needs the
+ * offset published by rpu_clock.
+ *
+ * The buffer is a flight recorder; if the RPU laps the reader between two
+ * polls, the number of lost events is reported.
+ *
+ * A firmware built with RPU_TRACE_COMPACT=1 writes the delta/varint records
+ * of common/rpu_trace_compact.h instead of fixed entries; the tool tells the
+ * two apart by the trace magic and prints the same columns. The compact
+ * trace is read a block at a time: each poll copies only the words past the
+ * last record decoded and continues from the coding state it left, and a
+ * block is checked by its SEQ before and after the copy.
+ *
+ * For long captures the rpu_ipi module streams the trace itself
+ * (/dev/rpu_trace, common/rpu_ipi_ioctl.h): it copies the events out of the
+ * window while the device is open, and --record splice()s its pages through
+ * a pipe into the file without copying them through this process. The file
+ * holds struct rpu_shm_trace records, compact traces included; --input
+ * decodes it with the same columns, or follows the device live.
+ *
+ * Memory Map:
+ *   0xFF990000: Shared memory window (trace at SHM_TRACE_HDR_OFFSET)
+ *   0xFFFC0000: Shared memory window of RPU1 (--core 1)
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+// Shared Memory Layout (following OpenAMP pattern)
+#include "rpu_shm.h"
+#include "rpu_trace_compact.h"
+#include "rpu_ipi_ioctl.h"
+#include "kr260hal/mem_map.h"
+#include "kr260hal/shm_regs.h"
+#include "kr260hal/timebase.h"
+
+namespace shm = kr260hal::shm;
+namespace barrier = kr260hal::barrier;
+using kr260hal::counter_freq;
+using kr260hal::counter_now;
+
+#define TRACE_POLL_MS_DEFAULT  10
+#define RECORD_CHUNK           (1 << 20)  /* Bytes per splice() of --record */
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int) {
+    stop_requested = 1;
+}
+
+static const char* event_name(uint32_t event) {
+    switch (event) {
+        case RPU_TRACE_IPI_RX:     return "IPI_RX";
+        case RPU_TRACE_CMD_START:  return "CMD_START";
+        case RPU_TRACE_RING_DRAIN: return "RING_DRAIN";
+        case RPU_TRACE_ACK:        return "ACK";
+        case RPU_TRACE_MODE:       return "MODE";
+        case RPU_TRACE_GPIO_WRITE: return "GPIO_WRITE";
+        case RPU_TRACE_WAVE:       return "WAVE";
+        case RPU_TRACE_MSG:        return "MSG";
+        case RPU_TRACE_MBOX:       return "MBOX";
+        case RPU_TRACE_BULK:       return "BULK";
+        case RPU_TRACE_GPIO_IN:    return "GPIO_IN";
+        case RPU_TRACE_MPCMD:      return "MPCMD";
+        case RPU_TRACE_EDGE:       return "EDGE";
+        case RPU_TRACE_TIMED:      return "TIMED";
+        case RPU_TRACE_URGENT:     return "URGENT";
+        default:                   return "UNKNOWN";
+    }
+}
+
+static void format_args(const rpu_shm_trace& e, char* buf, size_t len) {
+    switch (e.event) {
+        case RPU_TRACE_IPI_RX:
+            if (e.arg1 != 0) {
+                snprintf(buf, len, "isr=0x%X unclaimed=0x%X", e.arg0, e.arg1);
+            } else {
+                snprintf(buf, len, "isr=0x%X", e.arg0);
+            }
+            break;
+        case RPU_TRACE_RING_DRAIN:
+        case RPU_TRACE_URGENT:
+            snprintf(buf, len, "count=%u tail=%u", e.arg0, e.arg1);
+            break;
+        case RPU_TRACE_ACK:
+            snprintf(buf, len, "seq=%u ack=0x%08X", e.arg0, e.arg1);
+            break;
+        case RPU_TRACE_MODE:
+            snprintf(buf, len, "mode=%u override=%u", e.arg0, e.arg1);
+            break;
+        case RPU_TRACE_GPIO_WRITE:
+            snprintf(buf, len, "value=0x%X src=%s", e.arg0, e.arg1 ? "burst" : "single");
+            break;
+        case RPU_TRACE_WAVE:
+            if (e.arg0 == 0) snprintf(buf, len, "ended");
+            else snprintf(buf, len, "samples=%u period_ns=%u", e.arg0, e.arg1);
+            break;
+        case RPU_TRACE_MSG:
+            snprintf(buf, len, "opcode=%u len=%u seq=%u status=%u", RPU_MSG_HDR_OPCODE(e.arg0),
+                     RPU_MSG_HDR_LEN(e.arg0), RPU_MSG_HDR_SEQ(e.arg0), e.arg1);
+            break;
+        case RPU_TRACE_MBOX:
+            snprintf(buf, len, "gen=%u mode=%u", e.arg0, e.arg1);
+            break;
+        case RPU_TRACE_BULK:
+            snprintf(buf, len, "op=%s length=%u status=%u",
+                     (e.arg0 & 0xFF) == BULK_OP_WRITE ? "write" :
+                     (e.arg0 & 0xFF) == BULK_OP_READ ? "read" :
+                     (e.arg0 & 0xFF) == BULK_OP_CHECKSUM ? "checksum" : "?", e.arg1, e.arg0 >> 8);
+            break;
+        case RPU_TRACE_GPIO_IN:
+            // The event is stamped in the task; arg1 is the time since the edge
+            snprintf(buf, len, "value=0x%X changed=0x%X edge_us=-%.3f", e.arg0 & 0xFFFF,
+                     e.arg0 >> 16, e.arg1 / (counter_freq() / 1e6));
+            break;
+        case RPU_TRACE_MPCMD:
+            snprintf(buf, len, "source=0x%X opcode=%u status=%u", e.arg0, e.arg1 & 0xFFFF,
+                     e.arg1 >> 16);
+            break;
+        case RPU_TRACE_EDGE:
+            snprintf(buf, len, "deadline_tick=%u error_us=%.3f", e.arg0, (int32_t)e.arg1 / 1e3);
+            break;
+        case RPU_TRACE_TIMED:
+            snprintf(buf, len, "opcode=%u status=%u error_us=%.3f", e.arg0 & 0xFFFF, e.arg0 >> 16,
+                     (int32_t)e.arg1 / 1e3);
+            break;
+        case RPU_TRACE_CMD_START:
+            buf[0] = '\0';
+            break;
+        default:
+            snprintf(buf, len, "event=%u arg0=0x%X arg1=0x%X", e.event, e.arg0, e.arg1);
+            break;
+    }
+}
+
+/*
+ * Copy entry idx if it is still the one the RPU wrote for that index.
+ * The sequence number is checked before and after the copy (seqlock style).
+ */
+static bool read_entry(const kr260hal::MemMap& win, uint32_t idx, rpu_shm_trace& out) {
+    volatile uint32_t* entry = win.at(SHM_TRACE_ENTRY(idx));
+
+    if (entry[SHM_TRACE_SEQ / 4] != idx + 1) return false;
+    barrier::acquire();
+    out.event = entry[SHM_TRACE_EVENT / 4];
+    out.arg0  = entry[SHM_TRACE_ARG0 / 4];
+    out.arg1  = entry[SHM_TRACE_ARG1 / 4];
+    out.ts_lo = entry[SHM_TRACE_TS_LO / 4];
+    out.ts_hi = entry[SHM_TRACE_TS_HI / 4];
+    barrier::acquire();
+    out.seq = entry[SHM_TRACE_SEQ / 4];
+    return out.seq == idx + 1;
+}
+
+// Prints events in the columns of the header line
+struct EventPrinter {
+    const kr260hal::MemMap& win;
+    bool monotonic;
+    uint64_t hz;
+    double ticks_per_us;
+    kr260hal::ClockSync sync;
+    uint64_t prev_ts = 0;
+
+    void print(uint32_t idx, const rpu_shm_trace& e) {
+        uint64_t ts = ((uint64_t)e.ts_hi << 32) | e.ts_lo;
+        uint64_t now = counter_now();
+        char delta[16] = "-";
+        char age[16] = "-";
+        char args[64];
+        if (prev_ts) snprintf(delta, sizeof(delta), "+%.3f", (ts - prev_ts) / ticks_per_us);
+        if (now >= ts) snprintf(age, sizeof(age), "%.3f", (now - ts) / ticks_per_us);
+        format_args(e, args, sizeof(args));
+
+        if (monotonic) {
+            kr260hal::read_clock_sync(win, sync);
+            double mono_s = ((int64_t)kr260hal::ticks_to_ns(ts, hz) + sync.offset_ns) / 1e9;
+            std::printf("%-8u %-14.6f %-10s %-12s %-12s %s\n",
+                        idx, mono_s, delta, age, event_name(e.event), args);
+        } else {
+            std::printf("%-8u %-14.3f %-10s %-12s %-12s %s\n",
+                        idx, ts / ticks_per_us, delta, age, event_name(e.event), args);
+        }
+        prev_ts = ts;
+    }
+};
+
+// Copy of a compact trace block
+struct CompactBlock {
+    uint32_t used;
+    uint32_t first;
+    uint64_t base;
+    uint8_t data[SHM_TRACEZ_DATA_SIZE];
+};
+
+/*
+ * Copy block n, its record bytes from offset from on, if the block still
+ * holds n. USED is read before the records it publishes, and SEQ is checked
+ * before and after the copy.
+ */
+static bool read_block(const kr260hal::MemMap& win, uint32_t n, uint32_t from, CompactBlock& b) {
+    volatile uint32_t* blk = win.at(SHM_TRACEZ_BLOCK(n));
+
+    if (blk[SHM_TRACEZ_SEQ / 4] != n) return false;
+    barrier::acquire();
+    b.used = blk[SHM_TRACEZ_USED / 4];
+    b.first = blk[SHM_TRACEZ_FIRST / 4];
+    b.base = ((uint64_t)blk[SHM_TRACEZ_BASE_HI / 4] << 32) | blk[SHM_TRACEZ_BASE_LO / 4];
+    if (b.used > SHM_TRACEZ_DATA_SIZE) return false;
+    barrier::acquire();
+    for (uint32_t w = from / 4; w < (b.used + 3) / 4; w++) {
+        uint32_t word = blk[SHM_TRACEZ_DATA / 4 + w];
+        std::memcpy(&b.data[w * 4], &word, 4);
+    }
+    barrier::acquire();
+    return blk[SHM_TRACEZ_SEQ / 4] == n;
+}
+
+// Follow a trace written with RPU_TRACE_COMPACT=1
+static void follow_compact(const kr260hal::MemMap& win, EventPrinter& out, bool once,
+                           unsigned interval_ms) {
+    uint32_t h = win.read<shm::TraceHead>();
+    uint32_t blk = (h > SHM_TRACEZ_BLOCKS) ? h - SHM_TRACEZ_BLOCKS + 1 : 1;
+    bool begun = false;       // st holds the coding state of blk
+    bool decoded = false;     // expect is the index of the next event
+    uint32_t expect = 0;
+    rpu_tracez_state st{};
+    CompactBlock b{};
+
+    while (!stop_requested) {
+        h = win.read_acquire<shm::TraceHead>();
+
+        // Head went backwards: the RPU firmware restarted its trace
+        if (h < blk && !(h == 0 && blk == 1)) {
+            std::printf("-- trace restarted --\n");
+            blk = (h > SHM_TRACEZ_BLOCKS) ? h - SHM_TRACEZ_BLOCKS + 1 : 1;
+            begun = decoded = false;
+            out.prev_ts = 0;
+        }
+
+        while (h != 0 && blk <= h) {
+            if (h - blk >= SHM_TRACEZ_BLOCKS || !read_block(win, blk, begun ? st.pos : 0, b)) {
+                // Lapped, or overwritten while we read it: go on at the oldest block
+                h = win.read<shm::TraceHead>();
+                if (h - blk >= SHM_TRACEZ_BLOCKS) {
+                    blk = h - SHM_TRACEZ_BLOCKS + 1;
+                    begun = false;
+                    continue;
+                }
+                break;
+            }
+            if (!begun) {
+                if (decoded && b.first != expect) {
+                    std::printf("-- %u event(s) lost --\n", b.first - expect);
+                }
+                rpu_tracez_begin(&st, b.base, b.first);
+                begun = true;
+            }
+
+            rpu_shm_trace e;
+            int r;
+            while ((r = rpu_tracez_decode(&st, b.data, b.used, &e)) == 1) {
+                out.print(e.seq - 1, e);
+            }
+            if (r < 0) {
+                // Not a record: the events after it show up as lost
+                std::printf("-- block %u unreadable at byte %u --\n", blk, st.pos);
+                st.pos = SHM_TRACEZ_DATA_SIZE;
+            }
+            expect = st.index;
+            decoded = true;
+
+            // The block being written may still grow
+            if (blk == h) break;
+            blk++;
+            begun = false;
+        }
+        std::fflush(stdout);
+
+        if (once) break;
+        usleep(interval_ms * 1000);
+    }
+}
+
+/*
+ * Move the stream of /dev/rpu_trace into path. splice() passes the module's
+ * pages into the pipe and from it into the file by reference; the only copy
+ * left is the file system's own, into its page cache.
+ */
+static int record_stream(const char* path) {
+    int in = open("/dev/" RPU_TRACE_DEV_NAME, O_RDONLY);
+    if (in < 0) {
+        std::perror("Error opening /dev/" RPU_TRACE_DEV_NAME);
+        return 1;
+    }
+    int out = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int pipefd[2];
+    if (out < 0 || pipe(pipefd) != 0) {
+        std::perror(out < 0 ? path : "pipe");
+        close(in);
+        if (out >= 0) close(out);
+        return 1;
+    }
+    fcntl(pipefd[1], F_SETPIPE_SZ, RECORD_CHUNK);  // Fewer round trips; best effort
+
+    uint64_t bytes = 0;
+    int ret = 0;
+    while (!stop_requested && ret == 0) {
+        ssize_t n = splice(in, nullptr, pipefd[1], nullptr, RECORD_CHUNK, SPLICE_F_MOVE);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::perror("splice from /dev/" RPU_TRACE_DEV_NAME);
+            ret = 1;
+        }
+        while (n > 0) {
+            ssize_t m = splice(pipefd[0], nullptr, out, nullptr, n, SPLICE_F_MOVE);
+            if (m < 0 && errno == EINTR) continue;
+            if (m <= 0) {
+                std::perror(path);
+                ret = 1;
+                break;
+            }
+            n -= m;
+            bytes += m;
+        }
+    }
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+    close(out);
+    close(in);
+    std::fprintf(stderr, "%llu events recorded to %s\n",
+                 (unsigned long long)(bytes / sizeof(rpu_shm_trace)), path);
+    return ret;
+}
+
+// Print a stream of records: a --record file, or /dev/rpu_trace live
+static int print_stream(const char* path, EventPrinter& out) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        std::perror(path);
+        return 1;
+    }
+
+    uint8_t buf[256 * sizeof(rpu_shm_trace)];
+    size_t have = 0;
+    bool first = true;
+    uint32_t expect = 0;
+    int ret = 0;
+
+    while (!stop_requested) {
+        ssize_t n = read(fd, buf + have, sizeof(buf) - have);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::perror(path);
+            ret = 1;
+            break;
+        }
+        if (n == 0) break;
+        have += n;
+
+        // Reads may end inside a record; the rest comes with the next one
+        size_t pos = 0;
+        for (; have - pos >= sizeof(rpu_shm_trace); pos += sizeof(rpu_shm_trace)) {
+            rpu_shm_trace e;
+            std::memcpy(&e, buf + pos, sizeof(e));
+            if (!first && e.seq != expect) {
+                if ((int32_t)(e.seq - expect) > 0) {
+                    std::printf("-- %u event(s) lost --\n", e.seq - expect);
+                } else {
+                    std::printf("-- trace restarted --\n");
+                    out.prev_ts = 0;
+                }
+            }
+            out.print(e.seq - 1, e);
+            expect = e.seq + 1;
+            first = false;
+        }
+        std::memmove(buf, buf + pos, have - pos);
+        have -= pos;
+        std::fflush(stdout);
+    }
+
+    close(fd);
+    return ret;
+}
+
+int main(int argc, char* argv[]) {
+    bool once = false;
+    bool monotonic = false;
+    unsigned interval_ms = TRACE_POLL_MS_DEFAULT;
+    unsigned core = 0;
+    const char* record_path = nullptr;
+    const char* input_path = nullptr;
+
+    static const struct option long_opts[] = {
+        {"once",        no_argument,       nullptr, 'o'},
+        {"interval-ms", required_argument, nullptr, 'i'},
+        {"core",        required_argument, nullptr, 'c'},
+        {"monotonic",   no_argument,       nullptr, 'm'},
+        {"record",      required_argument, nullptr, 'r'},
+        {"input",       required_argument, nullptr, 'f'},
+        {"help",        no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "oi:c:mr:f:h", long_opts, nullptr)) != -1) {
+        switch (opt) {
+            case 'o': once = true; break;
+            case 'm': monotonic = true; break;
+            case 'r': record_path = optarg; break;
+            case 'f': input_path = optarg; break;
+            case 'i': interval_ms = std::strtoul(optarg, nullptr, 0); break;
+            case 'c':
+                core = std::strtoul(optarg, nullptr, 0);
+                if (core < RPU_CORE_COUNT) break;
+                // fall through
+            case 'h':
+            default:
+                std::cerr << "Usage: " << argv[0] <<  " [--once] [--interval-ms <ms>] [--core <0|1>] [--monotonic]"
+                          " [--record <file> | --input <file>]" << std::endl;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // Without SA_RESTART, so Ctrl-C ends a blocking read or splice() of the stream
+    struct sigaction sa = {};
+    sa.sa_handler = handle_sigint;
+    sigaction(SIGINT, &sa, nullptr);
+
+    if (record_path) return record_stream(record_path);
+    if (input_path) {
+        if (monotonic) {
+            std::cerr << "--monotonic needs the live window, not --input" << std::endl;
+            return 1;
+        }
+        kr260hal::MemMap none;
+        EventPrinter out{none, false, 0, counter_freq() / 1e6, {}};
+        std::printf("%-8s %-14s %-10s %-12s %-12s %s\n",
+                    "idx", "time_us", "delta_us", "age_us", "event", "args");
+        return print_stream(input_path, out);
+    }
+
+    // Map through /dev/mem, read-only: the RPU owns the trace
+    kr260hal::MemMap win;
+    if (!win.map_phys(kr260hal::shm_window_addr(core), SHARED_MEM_SIZE, false)) {
+        std::perror("Error mapping shared memory");
+        return 1;
+    }
+
+    uint32_t magic = win.read<shm::TraceMagic>();
+    if (magic != SHM_TRACE_MAGIC && magic != SHM_TRACE_MAGIC_COMPACT) {
+        std::cerr << "No RPU trace found (magic 0x" << std::hex << magic
+                  << "); is the RPU firmware running?" << std::endl;
+        return 1;
+    }
+
+    // CLOCK_MONOTONIC = ticks_to_ns(ticks) + offset (rpu_clock keeps it fresh)
+    EventPrinter out{win, monotonic, kr260hal::window_counter_freq(win), counter_freq() / 1e6, {}};
+    if (monotonic && !kr260hal::read_clock_sync(win, out.sync)) {
+        std::cerr << "No clock offset published; run rpu_clock first" << std::endl;
+        return 1;
+    }
+
+    std::printf("%-8s %-14s %-10s %-12s %-12s %s\n",
+                "idx", monotonic ? "mono_s" : "time_us", "delta_us", "age_us", "event", "args");
+    if (magic == SHM_TRACE_MAGIC_COMPACT) {
+        follow_compact(win, out, once, interval_ms);
+        return 0;
+    }
+
+    uint32_t h = win.read<shm::TraceHead>();
+    uint32_t next = (h > SHM_TRACE_SLOTS) ? h - SHM_TRACE_SLOTS : 0;
+
+    while (!stop_requested) {
+        h = win.read_acquire<shm::TraceHead>();
+
+        // Head went backwards: the RPU firmware restarted its trace
+        if ((int32_t)(h - next) < 0) {
+            std::printf("-- trace restarted --\n");
+            next = (h > SHM_TRACE_SLOTS) ? h - SHM_TRACE_SLOTS : 0;
+            out.prev_ts = 0;
+        }
+
+        // Lapped: skip to the oldest entry still in the buffer
+        if ((uint32_t)(h - next) > SHM_TRACE_SLOTS) {
+            uint32_t oldest = h - SHM_TRACE_SLOTS;
+            std::printf("-- %u event(s) lost --\n", oldest - next);
+            next = oldest;
+        }
+
+        for (; next != h; next++) {
+            rpu_shm_trace e;
+            if (!read_entry(win, next, e)) {
+                // Overwritten while we read it, or still being written
+                if ((uint32_t)(win.read<shm::TraceHead>() - next) > SHM_TRACE_SLOTS) {
+                    std::printf("-- event %u lost --\n", next);
+                    continue;
+                }
+                break;
+            }
+            out.print(next, e);
+        }
+        std::fflush(stdout);
+
+        if (once) break;
+        usleep(interval_ms * 1000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * KR260 AXI GPIO Kernel Module
+ *
+ * Registers the AXI GPIO of the gpio_led design (axi_gpio_0 at 0x80000000)
+ * as a Linux gpio_chip, so libgpiod clients (gpioset, gpioget, the
+ * character device API) drive the LEDs instead of PYNQ MMIO or /dev/mem.
+ * The lines are:
+ * - 0 .. out_width-1: channel 1, outputs (LED0, LED1)
+ * - out_width .. out_width+in_width-1: channel 2, inputs (PMOD1 pins 1, 2)
+ *
+ * Output values are cached in a shadow of the DATA register: reading an
+ * output line costs no MMIO access, and set_multiple() changes any number of
+ * output lines with a single posted write, so a libgpiod request that sets
+ * several lines is one ioctl and one bus write. get_multiple() reads DATA2
+ * once, and only if an input line is asked for.
+ *
+ * The shadow assumes this driver is the only writer of channel 1: while the
+ * RPU firmware also drives the LEDs, a write here puts back the cached value
+ * of the lines it did not change. The dual-channel layout follows the
+ * design, so no device tree node is needed; the mainline gpio-xilinx driver
+ * needs one, and must not be bound to the same IP at the same time.
+ * Interrupts of the input channel are not used.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/io.h>
+#include <linux/bitmap.h>
+#include <linux/spinlock.h>
+#include <linux/gpio/driver.h>
+
+#define MODULE_NAME "kr260_gpio"
+#define MODULE_VERSION_STR "1.0"
+
+#include "kr260_regs.h"
+
+/* Address of the gpio_led design (gpio_led/PL/README.md) */
+#define GPIO_BASE_DEFAULT      0x80000000UL
+#define GPIO_MAX_WIDTH         32
+
+/* Module parameters */
+static unsigned long base = GPIO_BASE_DEFAULT;
+module_param(base, ulong, 0444);
+MODULE_PARM_DESC(base, "Physical address of axi_gpio_0");
+
+static unsigned int out_width = 2;
+module_param(out_width, uint, 0444);
+MODULE_PARM_DESC(out_width, "Output lines of channel 1 (1-32, default 2)");
+
+static unsigned int in_width = 2;
+module_param(in_width, uint, 0444);
+MODULE_PARM_DESC(in_width, "Input lines of channel 2 (0-32, 0 without channel 2, default 2)");
+
+/* Line names of the default design */
+static const char *const kr260_gpio_names[] = { "LED0", "LED1", "INPUT0", "INPUT1" };
+
+/* Module state */
+static void __iomem *regs;
+static u32 shadow;                 /* Channel 1 DATA, under gpio_lock */
+static DEFINE_SPINLOCK(gpio_lock);
+
+static bool kr260_gpio_is_output(unsigned int offset)
+{
+    return offset < out_width;
+}
+
+static int kr260_gpio_get_direction(struct gpio_chip *gc, unsigned int offset)
+{
+    return kr260_gpio_is_output(offset) ? GPIO_LINE_DIRECTION_OUT : GPIO_LINE_DIRECTION_IN;
+}
+
+/* The directions are fixed by the IP configuration (C_ALL_OUTPUTS, C_ALL_INPUTS_2) */
+static int kr260_gpio_direction_input(struct gpio_chip *gc, unsigned int offset)
+{
+    return kr260_gpio_is_output(offset) ? -EINVAL : 0;
+}
+
+static void kr260_gpio_set(struct gpio_chip *gc, unsigned int offset, int value)
+{
+    unsigned long flags;
+
+    if (!kr260_gpio_is_output(offset))
+        return;
+
+    spin_lock_irqsave(&gpio_lock, flags);
+    if (value)
+        shadow |= BIT(offset);
+    else
+        shadow &= ~BIT(offset);
+    iowrite32(shadow, regs + AXI_GPIO_DATA_OFFSET);
+    spin_unlock_irqrestore(&gpio_lock, flags);
+}
+
+static int kr260_gpio_direction_output(struct gpio_chip *gc, unsigned int offset, int value)
+{
+    if (!kr260_gpio_is_output(offset))
+        return -EINVAL;
+    kr260_gpio_set(gc, offset, value);
+    return 0;
+}
+
+static int kr260_gpio_get(struct gpio_chip *gc, unsigned int offset)
+{
+    if (kr260_gpio_is_output(offset))
+        return !!(READ_ONCE(shadow) & BIT(offset));
+    return !!(ioread32(regs + AXI_GPIO_DATA2_OFFSET) & BIT(offset - out_width));
+}
+
+/* One shadow update and one DATA write for all lines of the mask */
+static void kr260_gpio_set_multiple(struct gpio_chip *gc, unsigned long *mask,
+                                    unsigned long *bits)
+{
+    u32 m = bitmap_read(mask, 0, out_width);
+    u32 v = bitmap_read(bits, 0, out_width);
+    unsigned long flags;
+
+    if (!m)
+        return;
+
+    spin_lock_irqsave(&gpio_lock, flags);
+    shadow = (shadow & ~m) | (v & m);
+    iowrite32(shadow, regs + AXI_GPIO_DATA_OFFSET);
+    spin_unlock_irqrestore(&gpio_lock, flags);
+}
+
+static int kr260_gpio_get_multiple(struct gpio_chip *gc, unsigned long *mask,
+                                   unsigned long *bits)
+{
+    u32 out_mask = bitmap_read(mask, 0, out_width);
+    u32 in_mask = in_width ? bitmap_read(mask, out_width, in_width) : 0;
+
+    bitmap_write(bits, READ_ONCE(shadow) & out_mask, 0, out_width);
+    if (in_mask)
+        bitmap_write(bits, ioread32(regs + AXI_GPIO_DATA2_OFFSET) & in_mask,
+                     out_width, in_width);
+    return 0;
+}
+
+static struct gpio_chip kr260_gpio_chip = {
+    .label = MODULE_NAME,
+    .owner = THIS_MODULE,
+    .base = -1,
+    .get_direction = kr260_gpio_get_direction,
+    .direction_input = kr260_gpio_direction_input,
+    .direction_output = kr260_gpio_direction_output,
+    .get = kr260_gpio_get,
+    .set = kr260_gpio_set,
+    .get_multiple = kr260_gpio_get_multiple,
+    .set_multiple = kr260_gpio_set_multiple,
+    .can_sleep = false,
+};
+
+/*
+ * Module initialization
+ */
+static int __init kr260_gpio_init(void)
+{
+    int ret;
+
+    pr_info("%s: Initializing AXI GPIO module v%s\n", MODULE_NAME, MODULE_VERSION_STR);
+
+    if (out_width < 1 || out_width > GPIO_MAX_WIDTH || in_width > GPIO_MAX_WIDTH) {
+        pr_err("%s: out_width must be 1-%d and in_width 0-%d\n",
+               MODULE_NAME, GPIO_MAX_WIDTH, GPIO_MAX_WIDTH);
+        return -EINVAL;
+    }
+
+    regs = ioremap(base, AXI_GPIO_SIZE);
+    if (!regs) {
+        pr_err("%s: Failed to map the AXI GPIO at 0x%lX\n", MODULE_NAME, base);
+        return -ENOMEM;
+    }
+
+    /* Start from the pins as they are, so loading the module changes no LED */
+    shadow = ioread32(regs + AXI_GPIO_DATA_OFFSET) & GENMASK(out_width - 1, 0);
+    iowrite32(0, regs + AXI_GPIO_TRI_OFFSET);
+
+    kr260_gpio_chip.ngpio = out_width + in_width;
+    if (out_width == 2 && in_width == 2)
+        kr260_gpio_chip.names = kr260_gpio_names;
+
+    ret = gpiochip_add_data(&kr260_gpio_chip, NULL);
+    if (ret) {
+        pr_err("%s: Failed to register the gpio_chip (%d)\n", MODULE_NAME, ret);
+        iounmap(regs);
+        return ret;
+    }
+
+    pr_info("%s: %u output(s) and %u input(s) at 0x%lX, GPIO base %d\n", MODULE_NAME,
+            out_width, in_width, base, kr260_gpio_chip.base);
+    return 0;
+}
+
+/*
+ * Module cleanup
+ */
+static void __exit kr260_gpio_exit(void)
+{
+    gpiochip_remove(&kr260_gpio_chip);
+    iounmap(regs);
+}
+
+module_init(kr260_gpio_init);
+module_exit(kr260_gpio_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("William Stanislaus");
+MODULE_DESCRIPTION("KR260 AXI GPIO gpio_chip Module");
+MODULE_VERSION(MODULE_VERSION_STR);
@@ -0,0 +1,360 @@
+/*
+ * PL Interrupt Generator Kernel Module
+ *
+ * Services the interrupt_gen IP of the myhdl interrupt_demo design
+ * (myhdl/PL) in kernel context instead of through PYNQ's UIO path, where
+ * every interrupt is a Python wake-up. The module takes the interrupt of the
+ * design's AXI interrupt controller (axi_intc_0), whose input n is channel n
+ * of the generator. For every channel that fired, the handler reads the
+ * event counter and timestamp, clears the channel's ISR bit and then
+ * acknowledges the controller. It exposes:
+ * - /dev/pl_intr: per-channel event, interrupt and latency counters with
+ *   poll()-able reads, and an eventfd per channel signalled on every
+ *   interrupt (see common/pl_intr_ioctl.h)
+ *
+ * The registers of the generator (period, enable, coalescing) stay with
+ * user space, over PYNQ MMIO or /dev/mem: the module only enables the
+ * channels in the interrupt controller. Latencies are PL clocks from the
+ * event's hardware timestamp to the handler, so they include the GIC and the
+ * kernel's interrupt entry but no scheduling.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/io.h>
+#include <linux/interrupt.h>
+#include <linux/miscdevice.h>
+#include <linux/fs.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/eventfd.h>
+#include <linux/uaccess.h>
+
+#define MODULE_NAME "pl_intr"
+#define MODULE_VERSION_STR "1.0"
+
+#include "kr260_regs.h"
+#include "pl_intr_ioctl.h"
+
+/* Addresses of the interrupt_demo design (myhdl/PL/README.md) */
+#define GEN_BASE_DEFAULT       0xB0000000UL
+#define INTC_BASE_DEFAULT      0xB0010000UL
+#define REG_SIZE               0x1000
+
+/* Register reg of the bank of channel n (registers in kr260_regs.h) */
+#define GEN_CH(n, reg)         (INTERRUPT_GEN_CHANNEL_OFFSET(n) + INTERRUPT_GEN_CH_##reg##_OFFSET)
+
+/* Module parameters */
+static int irq = -1;
+module_param(irq, int, 0444);
+MODULE_PARM_DESC(irq, "Linux IRQ of the axi_intc_0 output (required)");
+
+static unsigned long gen_base = GEN_BASE_DEFAULT;
+module_param(gen_base, ulong, 0444);
+MODULE_PARM_DESC(gen_base, "Physical address of interrupt_generator_0");
+
+static unsigned long intc_base = INTC_BASE_DEFAULT;
+module_param(intc_base, ulong, 0444);
+MODULE_PARM_DESC(intc_base, "Physical address of axi_intc_0");
+
+/* Channel state, under pl_lock */
+struct pl_intr_state {
+    struct pl_intr_channel count;
+    u32 hw_events;                 /* Event counter at the last interrupt */
+    struct eventfd_ctx *efd;
+};
+
+/* Reader position */
+struct pl_intr_file {
+    u64 seen;                      /* irq_seq at the last read */
+};
+
+/* Module state */
+static void __iomem *gen;
+static void __iomem *intc;
+static unsigned int channels;
+static u32 chan_mask;
+static struct pl_intr_state chan[PL_INTR_MAX_CHANNELS];
+static u64 irq_seq;                /* Interrupts handled, all channels */
+static DEFINE_SPINLOCK(pl_lock);
+static DECLARE_WAIT_QUEUE_HEAD(pl_wq);
+
+/* HI, LO, HI: retry if the low word carried into the high one meanwhile */
+static u64 gen_read64(unsigned int offset)
+{
+    u32 hi, lo;
+
+    do {
+        hi = ioread32(gen + offset + 4);
+        lo = ioread32(gen + offset);
+    } while (ioread32(gen + offset + 4) != hi);
+
+    return ((u64)hi << 32) | lo;
+}
+
+static void pl_intr_service(unsigned int n, u64 now)
+{
+    struct pl_intr_state *s = &chan[n];
+    u64 stamp = gen_read64(GEN_CH(n, TIMESTAMP_LO));
+    u32 events = ioread32(gen + GEN_CH(n, EVENTS));
+    u32 delta = events - s->hw_events;
+    u64 latency = now - stamp;
+
+    /* The timestamp holds until the bit is cleared */
+    iowrite32(BIT(n), gen + INTERRUPT_GEN_ISR_OFFSET);
+
+    s->hw_events = events;
+    s->count.events += delta;
+    s->count.irqs++;
+    if (delta > 1)
+        s->count.lost += delta - 1;
+    s->count.latency_last = min_t(u64, latency, U32_MAX);
+    if (s->count.latency_last > s->count.latency_max)
+        s->count.latency_max = s->count.latency_last;
+    if (s->efd)
+        eventfd_signal(s->efd);
+}
+
+static irqreturn_t pl_intr_isr(int irq_num, void *dev_id)
+{
+    u32 pending, fired;
+    u64 now;
+    unsigned int n;
+
+    spin_lock(&pl_lock);
+
+    /* Both views must agree: the controller may re-latch a level input
+     * that was still high when the previous interrupt was acknowledged */
+    pending = ioread32(intc + AXI_INTC_IPR_OFFSET) & chan_mask;
+    if (!pending) {
+        spin_unlock(&pl_lock);
+        return IRQ_NONE;
+    }
+    fired = pending & ioread32(gen + INTERRUPT_GEN_ISR_OFFSET);
+    now = gen_read64(INTERRUPT_GEN_COUNTER_LO_OFFSET);
+    for (n = 0; n < channels; n++) {
+        if (fired & BIT(n))
+            pl_intr_service(n, now);
+    }
+    /* Read back so the ISR clears reach the IP before the acknowledgment */
+    ioread32(gen + INTERRUPT_GEN_ISR_OFFSET);
+    iowrite32(pending, intc + AXI_INTC_IAR_OFFSET);
+    irq_seq++;
+
+    spin_unlock(&pl_lock);
+
+    wake_up_interruptible(&pl_wq);
+    return IRQ_HANDLED;
+}
+
+/*
+ * /dev/pl_intr
+ */
+static int pl_intr_open(struct inode *inode, struct file *file)
+{
+    struct pl_intr_file *f = kzalloc(sizeof(*f), GFP_KERNEL);
+
+    if (!f)
+        return -ENOMEM;
+    f->seen = READ_ONCE(irq_seq);
+    file->private_data = f;
+    return 0;
+}
+
+static int pl_intr_release(struct inode *inode, struct file *file)
+{
+    kfree(file->private_data);
+    return 0;
+}
+
+static ssize_t pl_intr_read(struct file *file, char __user *buf,
+                            size_t count, loff_t *ppos)
+{
+    struct pl_intr_file *f = file->private_data;
+    struct pl_intr_channel snap[PL_INTR_MAX_CHANNELS];
+    unsigned int n = min_t(size_t, count / sizeof(snap[0]), channels);
+    unsigned long flags;
+    unsigned int i;
+    int ret;
+
+    if (n == 0)
+        return -EINVAL;
+
+    while (READ_ONCE(irq_seq) == f->seen) {
+        if (file->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        ret = wait_event_interruptible(pl_wq, READ_ONCE(irq_seq) != f->seen);
+        if (ret)
+            return ret;
+    }
+
+    spin_lock_irqsave(&pl_lock, flags);
+    for (i = 0; i < n; i++)
+        snap[i] = chan[i].count;
+    f->seen = irq_seq;
+    spin_unlock_irqrestore(&pl_lock, flags);
+
+    if (copy_to_user(buf, snap, n * sizeof(snap[0])))
+        return -EFAULT;
+    return n * sizeof(snap[0]);
+}
+
+static __poll_t pl_intr_poll(struct file *file, poll_table *wait)
+{
+    struct pl_intr_file *f = file->private_data;
+
+    poll_wait(file, &pl_wq, wait);
+
+    return READ_ONCE(irq_seq) != f->seen ? EPOLLIN | EPOLLRDNORM : 0;
+}
+
+static long pl_intr_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    struct pl_intr_eventfd req;
+    struct eventfd_ctx *ctx = NULL, *old;
+    unsigned long flags;
+
+    if (cmd != PL_INTR_IOC_EVENTFD)
+        return -ENOTTY;
+    if (copy_from_user(&req, (void __user *)arg, sizeof(req)))
+        return -EFAULT;
+    if (req.channel >= channels)
+        return -EINVAL;
+
+    if (req.fd >= 0) {
+        ctx = eventfd_ctx_fdget(req.fd);
+        if (IS_ERR(ctx))
+            return PTR_ERR(ctx);
+    }
+
+    spin_lock_irqsave(&pl_lock, flags);
+    old = chan[req.channel].efd;
+    chan[req.channel].efd = ctx;
+    spin_unlock_irqrestore(&pl_lock, flags);
+
+    if (old)
+        eventfd_ctx_put(old);
+    return 0;
+}
+
+static const struct file_operations pl_intr_fops = {
+    .owner = THIS_MODULE,
+    .open = pl_intr_open,
+    .release = pl_intr_release,
+    .read = pl_intr_read,
+    .poll = pl_intr_poll,
+    .unlocked_ioctl = pl_intr_ioctl,
+    .compat_ioctl = compat_ptr_ioctl,
+    .llseek = noop_llseek,
+};
+
+static struct miscdevice pl_intr_miscdev = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = PL_INTR_DEV_NAME,
+    .fops = &pl_intr_fops,
+    .mode = 0660,
+};
+
+/*
+ * Module initialization
+ */
+static int __init pl_intr_init(void)
+{
+    unsigned int n;
+    int ret;
+
+    pr_info("%s: Initializing PL interrupt module v%s\n", MODULE_NAME, MODULE_VERSION_STR);
+
+    if (irq < 0) {
+        pr_err("%s: The irq parameter is required (axi_intc_0 in /proc/interrupts)\n", MODULE_NAME);
+        return -EINVAL;
+    }
+
+    gen = ioremap(gen_base, REG_SIZE);
+    if (!gen) {
+        pr_err("%s: Failed to map the interrupt generator at 0x%lX\n", MODULE_NAME, gen_base);
+        return -ENOMEM;
+    }
+    intc = ioremap(intc_base, REG_SIZE);
+    if (!intc) {
+        pr_err("%s: Failed to map the interrupt controller at 0x%lX\n", MODULE_NAME, intc_base);
+        ret = -ENOMEM;
+        goto err_unmap_gen;
+    }
+
+    channels = ioread32(gen + INTERRUPT_GEN_CHANNELS_OFFSET);
+    if (channels == 0 || channels > PL_INTR_MAX_CHANNELS)
+        channels = 2;
+    chan_mask = GENMASK(channels - 1, 0);
+
+    /* Count from here: drop a pending bit, it is in the event counter */
+    for (n = 0; n < channels; n++)
+        chan[n].hw_events = ioread32(gen + GEN_CH(n, EVENTS));
+    iowrite32(chan_mask, gen + INTERRUPT_GEN_ISR_OFFSET);
+    ioread32(gen + INTERRUPT_GEN_ISR_OFFSET);
+    iowrite32(chan_mask, intc + AXI_INTC_IAR_OFFSET);
+
+    ret = request_irq(irq, pl_intr_isr, 0, MODULE_NAME, NULL);
+    if (ret) {
+        pr_err("%s: Failed to request IRQ %d (%d); is it still bound to UIO?\n",
+               MODULE_NAME, irq, ret);
+        goto err_unmap_intc;
+    }
+
+    iowrite32(ioread32(intc + AXI_INTC_IER_OFFSET) | chan_mask, intc + AXI_INTC_IER_OFFSET);
+    iowrite32(AXI_INTC_MER_ME_MASK | AXI_INTC_MER_HIE_MASK, intc + AXI_INTC_MER_OFFSET);
+
+    ret = misc_register(&pl_intr_miscdev);
+    if (ret) {
+        pr_err("%s: Failed to register /dev/%s\n", MODULE_NAME, PL_INTR_DEV_NAME);
+        goto err_free_irq;
+    }
+
+    pr_info("%s: %u channel(s) on IRQ %d\n", MODULE_NAME, channels, irq);
+    return 0;
+
+err_free_irq:
+    iowrite32(ioread32(intc + AXI_INTC_IER_OFFSET) & ~chan_mask, intc + AXI_INTC_IER_OFFSET);
+    free_irq(irq, NULL);
+err_unmap_intc:
+    iounmap(intc);
+err_unmap_gen:
+    iounmap(gen);
+    return ret;
+}
+
+/*
+ * Module cleanup
+ */
+static void __exit pl_intr_exit(void)
+{
+    unsigned int n;
+
+    misc_deregister(&pl_intr_miscdev);
+
+    iowrite32(ioread32(intc + AXI_INTC_IER_OFFSET) & ~chan_mask, intc + AXI_INTC_IER_OFFSET);
+    free_irq(irq, NULL);
+
+    for (n = 0; n < channels; n++) {
+        if (chan[n].efd)
+            eventfd_ctx_put(chan[n].efd);
+        if (chan[n].count.irqs)
+            pr_info("%s: channel %u: %llu events in %llu interrupts, max latency %u clocks\n",
+                    MODULE_NAME, n, chan[n].count.events, chan[n].count.irqs,
+                    chan[n].count.latency_max);
+    }
+
+    iounmap(intc);
+    iounmap(gen);
+}
+
+module_init(pl_intr_init);
+module_exit(pl_intr_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("William Stanislaus");
+MODULE_DESCRIPTION("PL Interrupt Generator Module");
+MODULE_VERSION(MODULE_VERSION_STR);
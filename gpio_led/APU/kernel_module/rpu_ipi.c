@@ -3,12 +3,63 @@
  *
  * Provides a sysfs interface for APU-to-RPU communication via shared memory
  * and IPI (Inter-Processor Interrupt). The module exposes:
- * - /sys/kernel/rpu_ipi/write: Write mode value (0, 1, or 2) to send to RPU
- * - /sys/kernel/rpu_ipi/status: Read acknowledgment status (format: "mode,ACK" or "mode,NOACK")
+ * - /sys/kernel/rpu_ipi/write: Write mode value (0-3) to send to RPU, or several
+ *   separated by whitespace to send them as one batch on the command ring
+ * - /sys/kernel/rpu_ipi/status: Read acknowledgment status (format: "mode,ACK" or "mode,NOACK"),
+ *   then the status block the firmware publishes (rpu_shm.h), read without a command
+ * - /sys/kernel/rpu_ipi/submit: Queue a mode value (0-3) without waiting for the RPU
+ * - /sys/kernel/rpu_ipi/completions: Drain results of queued submissions (pollable)
+ * - /sys/kernel/debug/rpu_ipi/stats: Counters and doorbell-to-ACK latency histogram
+ * - Tracepoints (events/rpu_ipi/): doorbells, ACKs, timeouts, messages, reverse
+ *   IPIs and ring dispatch/completion, see rpu_ipi_trace.h
+ * - /dev/rpu_ipi: Binary command batches on the shared command ring with
+ *   poll()-able completions, mmap() of the shared window for zero-copy
+ *   producers, or single commands with parameters and results in the IPI
+ *   message buffer (see common/rpu_ipi_ioctl.h). Every open file is a client
+ *   with its own submission and completion queues; the module fills the ring
+ *   from them in turn, each client holding at most client_inflight slots,
+ *   and with firmware that grants ring credits (rpu_shm.h, "Ring credits")
+ *   no further than the RPU's credit limit: commands beyond it stay queued
+ *   and go out together as credit comes back.
+ * - /dev/rpu_trace: The RPU event trace as a stream of records for read()
+ *   and splice(), so recorders move it to files or sockets without copying
+ *   it through user space (see common/rpu_ipi_ioctl.h, "Trace stream")
  *
  * The module uses non-cached memory mappings to ensure cache coherency between
  * APU and RPU processors. Messages are sent via shared memory at 0xFF990000
- * and IPI interrupts are triggered via IPI registers at 0xFF300000.
+ * and IPI interrupts are triggered via IPI registers at 0xFF300000. When the
+ * firmware publishes the redirect of its TCM variant (rpu_shm.h), the window
+ * is its BTCM at 0xFFE20000 and only the IPI message buffers stay at
+ * 0xFF990000.
+ *
+ * With an "rproc" phandle to RPU0's remoteproc node, the channel follows the
+ * firmware as a remoteproc subdevice: it attaches once a started image
+ * publishes its ready word (rpu_shm.h, "Ready word"), mapping the window
+ * that image uses and taking its sequence numbers and ring indices, and
+ * detaches before the core stops or after a crash. While detached, writes
+ * and messages wait up to ack_timeout_ms for the next attach and then fail
+ * with -ENODEV, ring commands stay queued until then, and commands the
+ * stopped image had not consumed complete with RPU_CMD_STATUS_FAILED.
+ * Without the phandle the firmware is assumed to run from probe on.
+ *
+ * Acknowledgments are either polled from the shared ACK_SEQ word or, when the
+ * ack_irq parameter names the Linux IRQ of the APU IPI channel, signalled by a
+ * reverse IPI from the RPU. In interrupt mode writers sleep on a completion,
+ * so the ACK latency is a single interrupt instead of a poll quantum. The
+ * interrupt is threaded (ack_irq_thread): the hard handler clears the IPI
+ * and, with ack_irq_fast, wakes the waiters at once; the IRQ thread, at
+ * SCHED_FIFO priority ack_irq_prio and on the CPU of ack_irq_cpu, moves
+ * queued ring commands into the slots the RPU freed, so that work does not
+ * wait behind the system workqueue on a loaded or PREEMPT_RT kernel.
+ *
+ * It is a platform driver for a "wstanislaus,rpu-ipi" node (APU/dts/rpu_ipi.dtso):
+ * reg 0 is the APU IPI channel, reg 1 the shared window, the interrupt is the
+ * reverse IPI, and an optional memory-region (the bulk carveout of
+ * rpu_bulk.dtsi) is mapped to user space with mmap() at
+ * RPU_IPI_MMAP_REGION_OFFSET. A "bulk" DMA channel of the node (dmas/dma-names,
+ * an FPD DMA channel) copies between user memory and the region for the
+ * RPU_IPI_IOC_DMA ioctl. Without such a node the module creates the
+ * device itself with the fixed addresses below and the ack_irq parameter.
  */
 
 #include <linux/module.h>
@@ -20,244 +71,2857 @@
 #include <linux/delay.h>
 #include <linux/uaccess.h>
 #include <linux/pgtable.h>
+#include <linux/interrupt.h>
+#include <linux/completion.h>
+#include <linux/miscdevice.h>
+#include <linux/fs.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/kfifo.h>
+#include <linux/workqueue.h>
+#include <linux/mm.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/platform_device.h>
+#include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/remoteproc.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/scatterlist.h>
+#include <linux/sched.h>
+#include <linux/splice.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/cpumask.h>
+#include <uapi/linux/sched/types.h>
 
 #define MODULE_NAME "rpu_ipi"
-#define MODULE_VERSION_STR "1.0"
+#define MODULE_VERSION_STR "1.2"
+
+/* Shared Memory Layout (common/rpu_shm.h, shared with the RPU firmware) */
+#include "kr260_regs.h"
+#include "rpu_shm.h"
+#include "rpu_trace_compact.h"
+#include "rpu_ipi_ioctl.h"
 
-/* Memory addresses */
-#define SHARED_MEM_ADDR    0xFF990000UL
-#define SHARED_MEM_SIZE    0x1000
-#define IPI_APU_BASE       0xFF300000UL
-#define IPI_SIZE           0x1000
+#define CREATE_TRACE_POINTS
+#include "rpu_ipi_trace.h"
 
-/* Shared Memory Layout */
-#define SHM_CMD_OFFSET     0x00  /* Command/Mode (APU writes, RPU reads) */
-#define SHM_ACK_OFFSET     0x04  /* Acknowledgment (RPU writes, APU reads) */
-#define SHM_ACK_MAGIC      0xDEADBEEF
+#define RPU_IPI_COMPATIBLE "wstanislaus,rpu-ipi"
 
-/* IPI Register Offsets */
-#define IPI_TRIG_OFFSET    0x00  /* Trigger register (write-only on source side) */
+/*
+ * IPI registers, and IPI_APU_BASE/IPI_SIZE used without a device tree node,
+ * are in kr260_regs.h
+ */
 
 /* IPI Masks */
-#define MASK_CH1_RPU0      0x100  /* Bit 8 - IPI1 to RPU0 */
+#define MASK_CH1_RPU0      0x100  /* Bit 8 - IPI1 to RPU0 (also RPU0 as source in ISR) */
+
+/* Acknowledgment wait defaults (see module parameters) */
+#define ACK_TIMEOUT_MS     1500  /* Timeout for acknowledgment (milliseconds) */
+#define ACK_SETTLE_US      100   /* Initial sleep before the first poll */
+#define ACK_POLL_MIN_US    50    /* Poll interval (usleep_range bounds) */
+#define ACK_POLL_MAX_US    100
+#define ACK_SPIN_MAX_US    1000  /* Upper bound for the busy-poll window */
+
+/* Reverse-IPI thread defaults (see module parameters) */
+#define ACK_IRQ_PRIO       50    /* SCHED_FIFO priority, the kernel's for IRQ threads */
+
+/* Attach to a started firmware (see attach_timeout_ms) */
+#define ATTACH_TIMEOUT_MS  2000  /* Ready word wait before attaching anyway */
+#define ATTACH_POLL_MS     1
+#define STATUS_READ_TRIES  1000  /* Seqlock retries of the status block */
+#define STATUS_WORD(st, off)  ((st)[((off) - SHM_STATUS_OFFSET) / 4])
+
+/* Latency histogram: bucket i counts round trips in [2^i, 2^(i+1)) ns */
+#define LAT_HIST_BUCKETS     32
+
+/* Asynchronous sysfs submissions in flight / completions buffered (powers of two) */
+#define ASYNC_FIFO_SIZE      64
+#define COMPLETION_LINE_MAX  32  /* "4294967295,3,TIMEOUT\n" plus margin */
+
+/* Per-client queues of /dev/rpu_ipi (powers of two) */
+#define CLIENT_SQ_SIZE       (2 * SHM_RING_SLOTS)  /* Submitted, not yet on the ring */
+#define CLIENT_CQ_SIZE       (2 * SHM_RING_SLOTS)  /* Completed, not yet read */
+#define CLIENT_INFLIGHT      (SHM_RING_SLOTS / 2)  /* Default ring slots per client */
+#define WRITE_BATCH_MAX      CLIENT_SQ_SIZE        /* Modes in one sysfs write */
+
+/* Trace stream of /dev/rpu_trace (see trace_poll_ms, trace_pages) */
+#define TRACE_POLL_MS        10    /* Drain period of the window's trace */
+#define TRACE_PAGES          64    /* Pages of records buffered per reader */
+#define TRACE_PAGES_MAX      4096
+
+/* Module parameters */
+static int ack_irq = -1;
+module_param(ack_irq, int, 0444);
+MODULE_PARM_DESC(ack_irq, "Linux IRQ of the APU IPI channel for RPU->APU acknowledgments (-1: poll, or the DT interrupt); reads back the IRQ in use");
+
+static unsigned int ack_timeout_ms = ACK_TIMEOUT_MS;
+module_param(ack_timeout_ms, uint, 0644);
+MODULE_PARM_DESC(ack_timeout_ms, "Acknowledgment timeout in milliseconds");
+
+static unsigned int ack_spin_us;
+module_param(ack_spin_us, uint, 0644);
+MODULE_PARM_DESC(ack_spin_us, "Busy-poll window before sleeping, in microseconds (0: sleep only, max 1000)");
+
+static unsigned int ack_settle_us = ACK_SETTLE_US;
+module_param(ack_settle_us, uint, 0644);
+MODULE_PARM_DESC(ack_settle_us, "Initial sleep before polling, in microseconds (poll mode only)");
+
+static unsigned int ack_poll_min_us = ACK_POLL_MIN_US;
+module_param(ack_poll_min_us, uint, 0644);
+MODULE_PARM_DESC(ack_poll_min_us, "Minimum poll interval in microseconds (poll mode only)");
+
+static unsigned int ack_poll_max_us = ACK_POLL_MAX_US;
+module_param(ack_poll_max_us, uint, 0644);
+MODULE_PARM_DESC(ack_poll_max_us, "Maximum poll interval in microseconds (poll mode only)");
+
+static bool shm_wc;
+module_param(shm_wc, bool, 0444);
+MODULE_PARM_DESC(shm_wc, "Map the shared window write-combining (Normal non-cacheable) instead of Device memory");
+
+static unsigned int client_inflight = CLIENT_INFLIGHT;
+module_param(client_inflight, uint, 0644);
+MODULE_PARM_DESC(client_inflight, "Ring slots one /dev/rpu_ipi client may hold at a time (1-32, new clients)");
+
+static unsigned int attach_timeout_ms = ATTACH_TIMEOUT_MS;
+module_param(attach_timeout_ms, uint, 0644);
+MODULE_PARM_DESC(attach_timeout_ms, "Wait for a started firmware's ready word before attaching without it, in milliseconds (rproc only)");
+
+static bool ack_irq_thread = true;
+module_param(ack_irq_thread, bool, 0444);
+MODULE_PARM_DESC(ack_irq_thread, "Serve the reverse IPI from an IRQ thread (N: hard IRQ and the system workqueue only)");
+
+static bool ack_irq_fast = true;
+module_param(ack_irq_fast, bool, 0644);
+MODULE_PARM_DESC(ack_irq_fast, "Wake waiting writers and ring clients from the hard IRQ, before the IRQ thread runs");
+
+/* ack_irq_prio and ack_irq_cpu apply to a running IRQ; under ack_irq_mutex */
+static DEFINE_MUTEX(ack_irq_mutex);
+static int ack_irq_set_affinity(void);
+
+static int ack_irq_prio = ACK_IRQ_PRIO;
+
+static int ack_irq_prio_set(const char *val, const struct kernel_param *kp)
+{
+    int prio;
+    int ret = kstrtoint(val, 0, &prio);
+
+    if (ret)
+        return ret;
+    if (prio < 1 || prio > MAX_RT_PRIO - 1)
+        return -EINVAL;
+    WRITE_ONCE(ack_irq_prio, prio);
+    return 0;
+}
+
+static const struct kernel_param_ops ack_irq_prio_ops = {
+    .set = ack_irq_prio_set,
+    .get = param_get_int,
+};
+module_param_cb(ack_irq_prio, &ack_irq_prio_ops, &ack_irq_prio, 0644);
+MODULE_PARM_DESC(ack_irq_prio, "SCHED_FIFO priority of the reverse-IPI thread (1-99), from its next run");
+
+static int ack_irq_cpu = -1;
+
+static int ack_irq_cpu_set(const char *val, const struct kernel_param *kp)
+{
+    int cpu;
+    int ret = kstrtoint(val, 0, &cpu);
+
+    if (ret)
+        return ret;
+    if (cpu < -1 || (cpu >= 0 && (cpu >= nr_cpu_ids || !cpu_online(cpu))))
+        return -EINVAL;
+
+    mutex_lock(&ack_irq_mutex);
+    ack_irq_cpu = cpu;
+    ret = ack_irq_set_affinity();
+    mutex_unlock(&ack_irq_mutex);
+    return ret;
+}
+
+static const struct kernel_param_ops ack_irq_cpu_ops = {
+    .set = ack_irq_cpu_set,
+    .get = param_get_int,
+};
+module_param_cb(ack_irq_cpu, &ack_irq_cpu_ops, &ack_irq_cpu, 0644);
+MODULE_PARM_DESC(ack_irq_cpu, "CPU of the reverse IPI and its thread (-1: leave the IRQ affinity as it is)");
+
+static unsigned int trace_poll_ms = TRACE_POLL_MS;
+module_param(trace_poll_ms, uint, 0644);
+MODULE_PARM_DESC(trace_poll_ms, "Period /dev/rpu_trace copies new RPU events from the window at, in milliseconds");
 
-/* Timeout for acknowledgment (milliseconds) */
-#define ACK_TIMEOUT_MS     1500
+static unsigned int trace_pages = TRACE_PAGES;
+module_param(trace_pages, uint, 0644);
+MODULE_PARM_DESC(trace_pages, "Pages of events /dev/rpu_trace buffers for a slow reader (2-4096, at open)");
 
 /* Module state */
 static struct kobject *rpu_ipi_kobj;
 static void __iomem *shared_mem_base;
+static void __iomem *msg_mem_base;  /* IPI message buffers: reg 1 */
 static void __iomem *ipi_base;
+static phys_addr_t shm_phys;
+static phys_addr_t msg_phys;
+static struct resource region_res;  /* memory-region, empty without one */
+static struct device *rpu_ipi_dev;  /* Bound device, for the DMA channel */
+static bool rpu_ipi_bound;          /* The RPU0 channel exists once */
+static struct platform_device *rpu_ipi_fallback_pdev;
 static int last_sent_mode = -1;
 static bool last_ack_received = false;
+static u32 rpu_seq;  /* Sequence number of the last legacy command */
+static u16 msg_seq;  /* Sequence number of the last IPI message */
+static bool ack_irq_enabled;
+static u64 ack_irq_ns;       /* Time of the last hard IRQ, for the thread */
+static int ack_thread_prio;  /* Priority the IRQ thread set, 0 before its first run */
+static DECLARE_COMPLETION(ack_done);
 static DEFINE_MUTEX(rpu_ipi_mutex);
 
+/*
+ * Firmware state. rpu_up is set under rpu_ipi_mutex and rpu_ring_mutex, and
+ * cleared before taking them so that waiters holding them give up at once.
+ */
+static struct rproc *rpu_rproc;     /* RPU0's remoteproc, NULL without "rproc" */
+static struct rproc_subdev rpu_subdev;
+static bool rpu_up;                 /* Attached to a running firmware */
+static DECLARE_WAIT_QUEUE_HEAD(rpu_up_wq);
+static unsigned long attach_deadline;
+static void attach_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(attach_work, attach_work_fn);
+
+/* Legacy and message path statistics, protected by rpu_ipi_mutex (ack_*: IRQ-side) */
+static struct {
+    u64 messages;     /* Commands sent */
+    u64 acks;         /* Matching ACKs */
+    u64 timeouts;     /* No ACK_SEQ echo within ack_timeout_ms */
+    u64 bad_acks;     /* ACK_SEQ echoed but ACK value does not match the command */
+    u64 ipi_msgs;     /* IPI message buffer commands sent (round trips also count as acks) */
+    u64 ipi_msg_timeouts;
+    atomic64_t ack_irqs;  /* Reverse IPIs taken */
+    atomic64_t ack_thread_runs;  /* IRQ thread runs (ack_irq_thread) */
+    u64 ack_thread_max_ns;       /* Longest hard IRQ to thread wakeup, thread-side */
+    u64 attaches;     /* Firmware images attached to */
+    u64 detaches;
+    u64 ring_failed;  /* Ring commands failed by a detach */
+    u64 lat_min_ns;
+    u64 lat_max_ns;
+    u64 lat_sum_ns;
+    u64 hist[LAT_HIST_BUCKETS];
+} stats;
+static struct dentry *rpu_ipi_debugfs;
+
+/* Bulk DMA into the memory-region (RPU_IPI_IOC_DMA), under bulk_dma_mutex */
+#define BULK_DMA_TIMEOUT_MS 1000
+static struct dma_chan *bulk_dma_chan;  /* "bulk" channel, requested on first use */
+static DEFINE_MUTEX(bulk_dma_mutex);
+static struct {
+    u64 copies;
+    u64 bytes;
+    u64 errors;       /* Mapping, submission or transfer failures and timeouts */
+} bulk_dma_stats;
+
+/*
+ * /dev/rpu_ipi client. Commands wait in sq until ring_dispatch() gives the
+ * client a slot, and come back through cq; a client is only dispatched to
+ * while cq can take all of its in-flight commands, so reaping never drops.
+ */
+struct rpu_ipi_client {
+    struct list_head node;   /* ring_clients, in round-robin order */
+    DECLARE_KFIFO(sq, struct rpu_ipi_cmd, CLIENT_SQ_SIZE);
+    DECLARE_KFIFO(cq, struct rpu_ipi_cmd, CLIENT_CQ_SIZE);
+    u32 in_flight;           /* Descriptors on the ring, not yet reaped */
+    u32 max_in_flight;
+    u32 next_seq;            /* Sequence number of the client's next command */
+    pid_t tgid;
+    u64 submitted;
+    u64 completed;
+};
+
+/* Command ring state (char device), under rpu_ring_mutex */
+static u32 ring_head;    /* Next ring index to fill */
+static u32 ring_reaped;  /* Next ring index to hand back to its client */
+static struct rpu_ipi_client *ring_owner[SHM_RING_SLOTS];  /* Client of each slot */
+static LIST_HEAD(ring_clients);
+static u32 ring_backlog; /* Commands in all submission queues */
+static DECLARE_WAIT_QUEUE_HEAD(ring_wq);
+static DEFINE_MUTEX(rpu_ring_mutex);
+static struct rpu_ipi_client *ring_mapper;  /* Client that owns the ring producer side */
+static bool ring_credit;  /* The firmware publishes credits (SHM_FEAT_CREDIT) */
+
+/* Asynchronous submit path (sysfs submit/completions) */
+struct rpu_ipi_async_req {
+    u32 id;
+    int mode;
+};
+
+struct rpu_ipi_async_done {
+    u32 id;
+    int mode;
+    int result;  /* send_message_to_rpu() return value */
+};
+
+static DEFINE_KFIFO(async_pending, struct rpu_ipi_async_req, ASYNC_FIFO_SIZE);
+static DEFINE_KFIFO(async_done, struct rpu_ipi_async_done, ASYNC_FIFO_SIZE);
+static DEFINE_SPINLOCK(async_lock);
+static u32 async_last_id;
+static u32 async_overflows;  /* Completions dropped because nobody read them */
+static struct workqueue_struct *rpu_ipi_wq;
+
+static void async_work_fn(struct work_struct *work);
+static DECLARE_WORK(async_work, async_work_fn);
+
+static void ring_poll_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(ring_poll_work, ring_poll_work_fn);
+static bool ring_service(void);
+
+static inline u32 shm_read(unsigned int offset)
+{
+    return *(volatile u32 __force *)(shared_mem_base + offset);
+}
+
+static inline void shm_write(unsigned int offset, u32 val)
+{
+    *(volatile u32 __force *)(shared_mem_base + offset) = val;
+}
+
+static inline u32 msg_read(unsigned int offset)
+{
+    return *(volatile u32 __force *)(msg_mem_base + offset);
+}
+
+static inline void msg_write(unsigned int offset, u32 val)
+{
+    *(volatile u32 __force *)(msg_mem_base + offset) = val;
+}
+
+/* Trigger the APU->RPU0 IPI; traced first, so the event precedes the IPI */
+static inline void rpu_ipi_doorbell(unsigned int source)
+{
+    trace_rpu_ipi_doorbell(source);
+    iowrite32(MASK_CH1_RPU0, ipi_base + IPI_TRIG_OFFSET);
+}
+
+/*
+ * Reverse IPI handler - the RPU raises it after writing an acknowledgment.
+ * Threaded, it wakes the waiters here only with ack_irq_fast, and on
+ * PREEMPT_RT only the writers: ring_wq takes a sleeping lock there.
+ */
+static irqreturn_t rpu_ipi_ack_isr(int irq, void *dev_id)
+{
+    u32 isr = ioread32(ipi_base + IPI_ISR_OFFSET);
+
+    if (!(isr & MASK_CH1_RPU0))
+        return IRQ_NONE;
+
+    /* Clear the RPU0 source bit and wake the waiting writer and ring users */
+    iowrite32(MASK_CH1_RPU0, ipi_base + IPI_ISR_OFFSET);
+    trace_rpu_ipi_ack_irq(isr);
+    atomic64_inc(&stats.ack_irqs);
+
+    if (ack_irq_thread) {
+        if (READ_ONCE(ack_irq_fast)) {
+            complete(&ack_done);
+            if (!IS_ENABLED(CONFIG_PREEMPT_RT))
+                wake_up_interruptible(&ring_wq);
+        }
+        WRITE_ONCE(ack_irq_ns, ktime_get_ns());
+        return IRQ_WAKE_THREAD;
+    }
+
+    complete(&ack_done);
+    wake_up_interruptible(&ring_wq);
+    /* Freed slots can take queued commands, even if no client is reading */
+    if (READ_ONCE(ring_backlog))
+        mod_delayed_work(system_wq, &ring_poll_work, 0);
+
+    return IRQ_HANDLED;
+}
+
+/* Switch the running IRQ thread to ack_irq_prio when that changed */
+static void ack_thread_set_prio(void)
+{
+    int prio = READ_ONCE(ack_irq_prio);
+    struct sched_attr attr = {
+        .size = sizeof(attr),
+        .sched_policy = SCHED_FIFO,
+        .sched_priority = prio,
+    };
+    int ret;
+
+    if (prio == ack_thread_prio)
+        return;
+    ret = sched_setattr_nocheck(current, &attr);
+    if (ret)
+        pr_warn("%s: IRQ thread priority %d not set (%d)\n", MODULE_NAME, prio, ret);
+    ack_thread_prio = prio;
+}
+
+/*
+ * Reverse IPI thread: the rest of the hard handler's work, at a priority of
+ * its own instead of behind the system workqueue
+ */
+static irqreturn_t rpu_ipi_ack_thread(int irq, void *dev_id)
+{
+    u64 ns = ktime_get_ns() - READ_ONCE(ack_irq_ns);
+    bool fast = READ_ONCE(ack_irq_fast);
+
+    ack_thread_set_prio();
+    atomic64_inc(&stats.ack_thread_runs);
+    if (ns > READ_ONCE(stats.ack_thread_max_ns))
+        WRITE_ONCE(stats.ack_thread_max_ns, ns);
+
+    if (!fast)
+        complete(&ack_done);
+    if (!fast || IS_ENABLED(CONFIG_PREEMPT_RT))
+        wake_up_interruptible(&ring_wq);
+    /* Freed slots can take queued commands, even if no client is reading */
+    if (READ_ONCE(ring_backlog))
+        ring_service();
+
+    return IRQ_HANDLED;
+}
+
+/*
+ * Wait until the RPU echoes seq in the shared word at offset (ACK_SEQ, or
+ * the IPI response header) or the timeout expires.
+ * Busy-polls for ack_spin_us first (hybrid mode), then sleeps on the
+ * reverse-IPI completion when available or polls every
+ * ack_poll_min_us..ack_poll_max_us otherwise. Gives up early when the
+ * channel detaches (rpu_up).
+ * On success *end_ns holds the time the echo was observed.
+ */
+static bool wait_for_echo(void __iomem *base, unsigned int offset, u32 seq, u64 *end_ns)
+{
+    unsigned long deadline = jiffies + msecs_to_jiffies(max(READ_ONCE(ack_timeout_ms), 1U));
+    unsigned int spin_us = min(READ_ONCE(ack_spin_us), (unsigned int)ACK_SPIN_MAX_US);
+    unsigned int settle_us = READ_ONCE(ack_settle_us);
+    unsigned int poll_min_us = max(READ_ONCE(ack_poll_min_us), 1U);
+    unsigned int poll_max_us = max(READ_ONCE(ack_poll_max_us), poll_min_us);
+
+    if (spin_us) {
+        /* The RPU usually answers within microseconds; spinning avoids a sleep quantum */
+        u64 spin_end = ktime_get_ns() + (u64)spin_us * NSEC_PER_USEC;
+
+        do {
+            rmb();
+            if (*(volatile u32 __force *)(base + offset) == seq) {
+                *end_ns = ktime_get_ns();
+                return true;
+            }
+            cpu_relax();
+        } while (ktime_get_ns() < spin_end);
+    }
+
+    if (!ack_irq_enabled && settle_us) {
+        /* Initial delay to allow RPU to process interrupt */
+        usleep_range(settle_us, 2 * settle_us);
+    }
+
+    for (;;) {
+        rmb();
+        if (*(volatile u32 __force *)(base + offset) == seq) {
+            *end_ns = ktime_get_ns();
+            return true;
+        }
+        if (!time_before(jiffies, deadline) || !READ_ONCE(rpu_up))
+            return false;
+
+        if (ack_irq_enabled) {
+            /* A completion may belong to an earlier ACK, so always recheck */
+            wait_for_completion_timeout(&ack_done, deadline - jiffies);
+        } else {
+            usleep_range(poll_min_us, poll_max_us);
+        }
+    }
+}
+
+/*
+ * Wait up to ack_timeout_ms for the channel to attach; called before taking
+ * rpu_ipi_mutex, which the caller then rechecks rpu_up under.
+ * Returns 0 once attached, -ENODEV otherwise.
+ */
+static int rpu_ipi_wait_up(void)
+{
+    unsigned long timeout = msecs_to_jiffies(max(READ_ONCE(ack_timeout_ms), 1U));
+
+    if (!wait_event_timeout(rpu_up_wq, READ_ONCE(rpu_up), timeout))
+        return -ENODEV;
+    return 0;
+}
+
+/* Account one acknowledged round trip. Caller holds rpu_ipi_mutex. */
+static void stats_record_latency(u64 ns)
+{
+    stats.acks++;
+    stats.lat_sum_ns += ns;
+    if (ns < stats.lat_min_ns)
+        stats.lat_min_ns = ns;
+    if (ns > stats.lat_max_ns)
+        stats.lat_max_ns = ns;
+    stats.hist[ns ? min_t(unsigned int, ilog2(ns), LAT_HIST_BUCKETS - 1) : 0]++;
+}
+
 /*
  * Send message to RPU via shared memory and IPI
  *
  * Following OpenAMP/libmetal pattern:
- * 1. Clear previous acknowledgment
- * 2. Write message to shared memory
+ * 1. Write message to shared memory
+ * 2. Publish a new sequence number (SEQ)
  * 3. Memory barrier
  * 4. Trigger IPI interrupt
- * 5. Poll for acknowledgment with timeout
+ * 5. Wait until the RPU echoes the sequence number (ACK_SEQ), with timeout
+ *
+ * Matching on the sequence number means a late ACK for an earlier command
+ * can never complete this one, so no clear-then-settle delays are needed.
  *
  * Returns 0 on success, negative on error
  */
 static int send_message_to_rpu(int mode)
 {
-    unsigned long timeout;
-    u32 ack_val;
-    
-    if (mode < 0 || mode > 2) {
-        pr_err("%s: Invalid mode %d (must be 0-2)\n", MODULE_NAME, mode);
+    u64 start_ns, end_ns;
+    u32 ack_val = 0;
+    u32 seq;
+
+    if (mode < 0 || mode > 3) {
+        pr_err("%s: Invalid mode %d (must be 0-3)\n", MODULE_NAME, mode);
         return -EINVAL;
     }
-    
+    if (rpu_ipi_wait_up())
+        return -ENODEV;
+
     mutex_lock(&rpu_ipi_mutex);
-    
-    /* Clear previous acknowledgment */
-    *(volatile u32 __force *)(shared_mem_base + SHM_ACK_OFFSET) = 0;
+    if (!rpu_up) {
+        mutex_unlock(&rpu_ipi_mutex);
+        return -ENODEV;
+    }
+
+    /* Write message to shared memory, then publish it with a new sequence number */
+    seq = ++rpu_seq;
+    shm_write(SHM_CMD_OFFSET, (u32)mode);
     wmb();
-    
-    /* Small delay to ensure RPU sees the cleared acknowledgment */
-    udelay(10);
-    
-    /* Write message to shared memory */
-    *(volatile u32 __force *)(shared_mem_base + SHM_CMD_OFFSET) = (u32)mode;
+    shm_write(SHM_SEQ_OFFSET, seq);
     wmb();
-    
+
     /* Trigger IPI to RPU0 */
-    iowrite32(MASK_CH1_RPU0, ipi_base + IPI_TRIG_OFFSET);
-    wmb(); /* Ensure IPI trigger completes */
-    
-    /* Small delay to allow IPI to propagate to RPU */
-    udelay(10);
-    
-    /* Poll for acknowledgment */
-    timeout = jiffies + msecs_to_jiffies(ACK_TIMEOUT_MS);
-    
-    /* Initial delay to allow RPU to process interrupt */
-    usleep_range(100, 200);
-    
-    while (time_before(jiffies, timeout)) {
+    reinit_completion(&ack_done);
+    stats.messages++;
+    trace_rpu_ipi_cmd_send(seq, mode);
+    start_ns = ktime_get_ns();
+    rpu_ipi_doorbell(RPU_IPI_DB_CMD);
+
+    if (wait_for_echo(shared_mem_base, SHM_ACK_SEQ_OFFSET, seq, &end_ns)) {
         rmb();
-        ack_val = *(volatile u32 __force *)(shared_mem_base + SHM_ACK_OFFSET);
-        
-        /* Check if acknowledgment contains magic value */
-        /* RPU writes: SHM_ACK_MAGIC | (cmd_val & 0xFF) */
-        /* Accept any value with magic in upper 24 bits as valid acknowledgment */
-        if ((ack_val & 0xFFFFFF00) == (SHM_ACK_MAGIC & 0xFFFFFF00)) {
-            last_sent_mode = mode;
-            last_ack_received = true;
-            mutex_unlock(&rpu_ipi_mutex);
-            return 0;
+        ack_val = shm_read(SHM_ACK_OFFSET);
+        last_sent_mode = mode;
+        last_ack_received = SHM_ACK_IS_VALID(ack_val) &&
+                            (ack_val & 0xFF) == (u32)mode;
+        trace_rpu_ipi_cmd_ack(seq, ack_val, last_ack_received, end_ns - start_ns);
+        if (last_ack_received)
+            stats_record_latency(end_ns - start_ns);
+        else
+            stats.bad_acks++;
+        mutex_unlock(&rpu_ipi_mutex);
+        if (!last_ack_received) {
+            pr_warn("%s: Unexpected ACK 0x%X for mode %d (seq %u)\n",
+                    MODULE_NAME, ack_val, mode, seq);
+            return -EIO;
         }
-        
-        usleep_range(50, 100);
+        return 0;
     }
-    
-    /* Timeout */
+
     last_sent_mode = mode;
     last_ack_received = false;
-    pr_warn("%s: Timeout waiting for RPU acknowledgment (mode %d, ACK=0x%X)\n",
-           MODULE_NAME, mode, ack_val);
+    if (!READ_ONCE(rpu_up)) {
+        /* The firmware stopped under the command */
+        mutex_unlock(&rpu_ipi_mutex);
+        return -ENODEV;
+    }
+
+    /* Timeout */
+    ack_val = shm_read(SHM_ACK_OFFSET);
+    stats.timeouts++;
+    trace_rpu_ipi_cmd_timeout(RPU_IPI_DB_CMD, seq, shm_read(SHM_ACK_SEQ_OFFSET),
+                              READ_ONCE(ack_timeout_ms));
+    pr_warn("%s: Timeout waiting for RPU acknowledgment (mode %d, seq %u, ACK=0x%X, %u ms)\n",
+           MODULE_NAME, mode, seq, ack_val, READ_ONCE(ack_timeout_ms));
     mutex_unlock(&rpu_ipi_mutex);
     return -ETIMEDOUT;
 }
 
 /*
- * Sysfs write handler - accepts mode value (0, 1, or 2)
+ * Send one command in the IPI message buffer and wait for the response
+ *
+ * The parameters are written first and published by the request header,
+ * which carries a new sequence number; the RPU echoes the header into the
+ * response header after writing the status and results (see rpu_shm.h).
+ * Serialized with the legacy path, which shares the reverse-IPI completion.
+ *
+ * Returns 0 on success (msg->status and msg->result filled in), negative on error
+ */
+static int send_ipi_msg(struct rpu_ipi_msg *msg)
+{
+    u64 start_ns, end_ns;
+    u32 hdr;
+    u32 i;
+
+    BUILD_BUG_ON(RPU_IPI_MSG_MAX_DATA != SHM_IPI_MSG_DATA_WORDS);
+    BUILD_BUG_ON(RPU_IPI_MSG_MAX_RESULTS != RPU_MSG_MAX_RESULTS);
+
+    if (msg->len > RPU_IPI_MSG_MAX_DATA || msg->opcode > 0xFF)
+        return -EINVAL;
+    if (rpu_ipi_wait_up())
+        return -ENODEV;
+
+    mutex_lock(&rpu_ipi_mutex);
+    if (!rpu_up) {
+        mutex_unlock(&rpu_ipi_mutex);
+        return -ENODEV;
+    }
+
+    hdr = RPU_MSG_HDR(msg->opcode, msg->len, ++msg_seq);
+    for (i = 0; i < msg->len; i++)
+        msg_write(SHM_IPI_REQ_OFFSET + 4 * (i + 1), msg->data[i]);
+    wmb();
+    msg_write(SHM_IPI_REQ_OFFSET, hdr);
+    wmb();
+
+    reinit_completion(&ack_done);
+    stats.ipi_msgs++;
+    trace_rpu_ipi_msg_send(msg->opcode, msg->len, RPU_MSG_HDR_SEQ(hdr));
+    start_ns = ktime_get_ns();
+    rpu_ipi_doorbell(RPU_IPI_DB_MSG);
+
+    if (!wait_for_echo(msg_mem_base, SHM_IPI_RESP_OFFSET, hdr, &end_ns)) {
+        if (!READ_ONCE(rpu_up)) {
+            mutex_unlock(&rpu_ipi_mutex);
+            return -ENODEV;
+        }
+        stats.ipi_msg_timeouts++;
+        trace_rpu_ipi_cmd_timeout(RPU_IPI_DB_MSG, RPU_MSG_HDR_SEQ(hdr),
+                                  msg_read(SHM_IPI_RESP_OFFSET), READ_ONCE(ack_timeout_ms));
+        mutex_unlock(&rpu_ipi_mutex);
+        pr_warn("%s: Timeout waiting for RPU message response (opcode %u, seq %u, %u ms)\n",
+                MODULE_NAME, msg->opcode, RPU_MSG_HDR_SEQ(hdr), READ_ONCE(ack_timeout_ms));
+        return -ETIMEDOUT;
+    }
+
+    rmb();
+    msg->status = msg_read(SHM_IPI_RESP_OFFSET + 4);
+    for (i = 0; i < RPU_IPI_MSG_MAX_RESULTS; i++)
+        msg->result[i] = msg_read(SHM_IPI_RESP_OFFSET + 4 * (i + 2));
+    stats_record_latency(end_ns - start_ns);
+    trace_rpu_ipi_msg_done(msg->opcode, RPU_MSG_HDR_SEQ(hdr), msg->status, end_ns - start_ns);
+    mutex_unlock(&rpu_ipi_mutex);
+
+    return 0;
+}
+
+static int send_mode_batch(const int *modes, unsigned int n);
+
+/*
+ * Sysfs write handler - accepts mode value (0-3), or up to WRITE_BATCH_MAX
+ * of them separated by whitespace. A single value takes the legacy round
+ * trip; a list goes out as one ring batch (send_mode_batch()). Either fails
+ * with -ENODEV while no firmware is attached, after waiting ack_timeout_ms.
  */
 static ssize_t write_store(struct kobject *kobj, struct kobj_attribute *attr,
                           const char *buf, size_t count)
 {
+    int modes[WRITE_BATCH_MAX];
+    unsigned int n = 0;
+    char *copy, *p, *tok;
     int mode;
-    int ret;
-    
-    ret = kstrtoint(buf, 10, &mode);
-    if (ret) {
-        pr_err("%s: Invalid input, expected integer\n", MODULE_NAME);
-        return ret;
+    int ret = 0;
+
+    copy = kstrndup(buf, count, GFP_KERNEL);
+    if (!copy)
+        return -ENOMEM;
+
+    p = copy;
+    while ((tok = strsep(&p, " \t\n")) != NULL) {
+        if (*tok == '\0')
+            continue;
+        if (n == WRITE_BATCH_MAX) {
+            pr_err("%s: More than %d modes in one write\n", MODULE_NAME, WRITE_BATCH_MAX);
+            ret = -E2BIG;
+            break;
+        }
+        ret = kstrtoint(tok, 10, &mode);
+        if (ret) {
+            pr_err("%s: Invalid input, expected integer\n", MODULE_NAME);
+            break;
+        }
+        if (mode < 0 || mode > 3) {
+            pr_err("%s: Invalid mode %d (must be 0-3)\n", MODULE_NAME, mode);
+            ret = -EINVAL;
+            break;
+        }
+        modes[n++] = mode;
     }
-    if (mode < 0 || mode > 3) {
-        pr_err("%s: Invalid mode %d (must be 0-3)\n", MODULE_NAME, mode);
+    kfree(copy);
+    if (ret)
+        return ret;
+    if (n == 0) {
+        pr_err("%s: Invalid input, expected integer\n", MODULE_NAME);
         return -EINVAL;
     }
-    
-    ret = send_message_to_rpu(mode);
+
+    ret = (n == 1) ? send_message_to_rpu(modes[0]) : send_mode_batch(modes, n);
     if (ret) {
         return ret;
     }
-    
+
     return count;
 }
 
 /*
- * Sysfs read handler - returns "mode,ACK" or "mode,NOACK"
+ * Copy the firmware's status block (rpu_shm.h, "Status block") while its seq
+ * is even and unchanged; under rpu_ipi_mutex, which keeps the window mapped.
+ * The RPU holds the seq odd for a dozen stores, so the retries spin.
+ */
+static bool rpu_status_read(u32 *words)
+{
+    unsigned int tries, i;
+    u32 seq;
+
+    if (!rpu_up || shm_read(SHM_STATUS_MAGIC_OFFSET) != SHM_STATUS_MAGIC)
+        return false;
+
+    for (tries = 0; tries < STATUS_READ_TRIES; tries++) {
+        seq = shm_read(SHM_STATUS_SEQ_OFFSET);
+        if (seq & 1) {
+            cpu_relax();
+            continue;
+        }
+        rmb();
+        for (i = 0; i < SHM_STATUS_SIZE / 4; i++)
+            words[i] = shm_read(SHM_STATUS_OFFSET + i * 4);
+        rmb();
+        if (shm_read(SHM_STATUS_SEQ_OFFSET) == seq)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Sysfs read handler - returns "mode,ACK" or "mode,NOACK", then a line with the
+ * firmware's status block (mode, flags, LED, step and counters) when it
+ * publishes one
  */
 static ssize_t status_show(struct kobject *kobj, struct kobj_attribute *attr,
                            char *buf)
 {
+    u32 st[SHM_STATUS_SIZE / 4];
+    u32 flags;
     int len;
-    
+
     mutex_lock(&rpu_ipi_mutex);
-    
+
     if (last_sent_mode == -1) {
         len = sprintf(buf, "NONE,NONE\n");
     } else {
         len = sprintf(buf, "%d,%s\n", last_sent_mode,
                      last_ack_received ? "ACK" : "NOACK");
     }
-    
+    if (rpu_status_read(st)) {
+        flags = STATUS_WORD(st, SHM_STATUS_FLAGS_OFFSET);
+        len += sysfs_emit_at(buf, len,
+                             "mode=%u override=%d pattern=%d wave=%d led=0x%x step=%u frames=%u commands=%u\n",
+                             STATUS_WORD(st, SHM_STATUS_MODE_OFFSET),
+                             !!(flags & SHM_STATUS_F_OVERRIDE),
+                             !!(flags & SHM_STATUS_F_PATTERN),
+                             !!(flags & SHM_STATUS_F_WAVE),
+                             STATUS_WORD(st, SHM_STATUS_LED_OFFSET),
+                             STATUS_WORD(st, SHM_STATUS_STEP_OFFSET),
+                             STATUS_WORD(st, SHM_STATUS_FRAMES_OFFSET),
+                             STATUS_WORD(st, SHM_STATUS_COMMANDS_OFFSET));
+    }
+
     mutex_unlock(&rpu_ipi_mutex);
-    
+
     return len;
 }
 
-/* Sysfs attribute declarations */
-static struct kobj_attribute write_attr = __ATTR(write, 0220, NULL, write_store);
-static struct kobj_attribute status_attr = __ATTR(status, 0444, status_show, NULL);
-
-static struct attribute *rpu_ipi_attrs[] = {
-    &write_attr.attr,
-    &status_attr.attr,
-    NULL,
-};
-
-static struct attribute_group rpu_ipi_attr_group = {
-    .attrs = rpu_ipi_attrs,
-};
-
 /*
- * Module initialization
+ * Asynchronous submit path - submissions are queued and sent by an ordered
+ * workqueue, so writers never wait on rpu_ipi_mutex or the RPU.
  */
-static int __init rpu_ipi_init(void)
+static void async_work_fn(struct work_struct *work)
 {
-    int ret;
-    
-    pr_info("%s: Initializing RPU IPI module v%s\n", MODULE_NAME, MODULE_VERSION_STR);
-    
-    /* Map shared memory region with non-cached protection for cache coherency */
-    shared_mem_base = ioremap_prot(SHARED_MEM_ADDR, SHARED_MEM_SIZE,
-                                   pgprot_val(pgprot_noncached(PAGE_KERNEL)));
-    if (!shared_mem_base) {
-        /* Fallback to regular ioremap */
-        pr_info("%s: Failed to map shared memory at 0x%lX with non-cached protection, falling back to regular ioremap\n", MODULE_NAME, SHARED_MEM_ADDR);
-        shared_mem_base = ioremap(SHARED_MEM_ADDR, SHARED_MEM_SIZE);
-        if (!shared_mem_base) {
-            pr_err("%s: Failed to map shared memory at 0x%lX\n", MODULE_NAME, SHARED_MEM_ADDR);
-            return -ENOMEM;
+    struct rpu_ipi_async_req req;
+    struct rpu_ipi_async_done done;
+
+    while (kfifo_out_spinlocked(&async_pending, &req, 1, &async_lock)) {
+        done.id = req.id;
+        done.mode = req.mode;
+        done.result = send_message_to_rpu(req.mode);
+
+        spin_lock(&async_lock);
+        if (kfifo_is_full(&async_done)) {
+            /* Nobody is reading completions; keep the newest */
+            kfifo_skip(&async_done);
+            async_overflows++;
         }
+        kfifo_put(&async_done, done);
+        spin_unlock(&async_lock);
+
+        sysfs_notify(rpu_ipi_kobj, NULL, "completions");
     }
-    
-    /* Map IPI register region */
-    ipi_base = ioremap(IPI_APU_BASE, IPI_SIZE);
-    if (!ipi_base) {
-        pr_err("%s: Failed to map IPI registers at 0x%lX\n", MODULE_NAME, IPI_APU_BASE);
-        iounmap(shared_mem_base);
-        return -ENOMEM;
-    }
-    
-    /* Create sysfs interface */
-    rpu_ipi_kobj = kobject_create_and_add("rpu_ipi", kernel_kobj);
-    if (!rpu_ipi_kobj) {
-        pr_err("%s: Failed to create sysfs kobject\n", MODULE_NAME);
-        iounmap(ipi_base);
-        iounmap(shared_mem_base);
-        return -ENOMEM;
-    }
-    
-    ret = sysfs_create_group(rpu_ipi_kobj, &rpu_ipi_attr_group);
-    if (ret) {
-        pr_err("%s: Failed to create sysfs attributes\n", MODULE_NAME);
-        kobject_put(rpu_ipi_kobj);
-        iounmap(ipi_base);
-        iounmap(shared_mem_base);
-        return ret;
-    }
-    
-    pr_info("%s: Module loaded successfully\n", MODULE_NAME);
-    
-    return 0;
 }
 
 /*
- * Module cleanup
+ * Sysfs submit handler - queues a mode value (0-3) and returns immediately
  */
-static void __exit rpu_ipi_exit(void)
+static ssize_t submit_store(struct kobject *kobj, struct kobj_attribute *attr,
+                            const char *buf, size_t count)
 {
-    pr_info("%s: Unloading module\n", MODULE_NAME);
-    
-    sysfs_remove_group(rpu_ipi_kobj, &rpu_ipi_attr_group);
-    kobject_put(rpu_ipi_kobj);
-    
-    if (ipi_base)
-        iounmap(ipi_base);
-    if (shared_mem_base)
-        iounmap(shared_mem_base);
-    
-    pr_info("%s: Module unloaded\n", MODULE_NAME);
+    struct rpu_ipi_async_req req;
+    int mode;
+    int ret;
+
+    ret = kstrtoint(buf, 10, &mode);
+    if (ret) {
+        pr_err("%s: Invalid input, expected integer\n", MODULE_NAME);
+        return ret;
+    }
+    if (mode < 0 || mode > 3) {
+        pr_err("%s: Invalid mode %d (must be 0-3)\n", MODULE_NAME, mode);
+        return -EINVAL;
+    }
+
+    spin_lock(&async_lock);
+    if (kfifo_is_full(&async_pending)) {
+        spin_unlock(&async_lock);
+        return -EAGAIN;
+    }
+    req.id = ++async_last_id;
+    req.mode = mode;
+    kfifo_put(&async_pending, req);
+    spin_unlock(&async_lock);
+
+    queue_work(rpu_ipi_wq, &async_work);
+
+    return count;
+}
+
+/*
+ * Sysfs submit read handler - returns "last_id,pending"
+ */
+static ssize_t submit_show(struct kobject *kobj, struct kobj_attribute *attr,
+                           char *buf)
+{
+    u32 last_id;
+    unsigned int pending;
+
+    spin_lock(&async_lock);
+    last_id = async_last_id;
+    pending = kfifo_len(&async_pending);
+    spin_unlock(&async_lock);
+
+    return sysfs_emit(buf, "%u,%u\n", last_id, pending);
+}
+
+/*
+ * Sysfs completions handler - drains queued completions, one
+ * "id,mode,ACK|NOACK|TIMEOUT|OFFLINE" line each
+ */
+static ssize_t completions_show(struct kobject *kobj, struct kobj_attribute *attr,
+                                char *buf)
+{
+    struct rpu_ipi_async_done done;
+    int len = 0;
+
+    spin_lock(&async_lock);
+    while (len + COMPLETION_LINE_MAX <= PAGE_SIZE &&
+           kfifo_get(&async_done, &done)) {
+        len += sysfs_emit_at(buf, len, "%u,%d,%s\n", done.id, done.mode,
+                             done.result == 0 ? "ACK" :
+                             done.result == -ETIMEDOUT ? "TIMEOUT" :
+                             done.result == -ENODEV ? "OFFLINE" : "NOACK");
+    }
+    spin_unlock(&async_lock);
+
+    return len;
+}
+
+/* Sysfs attribute declarations */
+static struct kobj_attribute write_attr = __ATTR(write, 0220, NULL, write_store);
+static struct kobj_attribute status_attr = __ATTR(status, 0444, status_show, NULL);
+static struct kobj_attribute submit_attr = __ATTR(submit, 0644, submit_show, submit_store);
+static struct kobj_attribute completions_attr = __ATTR(completions, 0444, completions_show, NULL);
+
+static struct attribute *rpu_ipi_attrs[] = {
+    &write_attr.attr,
+    &status_attr.attr,
+    &submit_attr.attr,
+    &completions_attr.attr,
+    NULL,
+};
+
+static struct attribute_group rpu_ipi_attr_group = {
+    .attrs = rpu_ipi_attrs,
+};
+
+/*
+ * Character device - binary command batches on the shared command ring
+ */
+
+/*
+ * Free ring slots; a slot is reused only after its completion is reaped,
+ * and filled only within the RPU's credits
+ */
+static u32 ring_space(void)
+{
+    u32 space = SHM_RING_SLOTS - (ring_head - ring_reaped);
+    u32 credits;
+
+    if (!ring_credit)
+        return space;
+    credits = SHM_RING_CREDITS(shm_read(SHM_RING_CREDIT_OFFSET), ring_head,
+                               shm_read(SHM_RING_TAIL_OFFSET));
+    return min(space, credits);
+}
+
+/*
+ * Descriptors consumed by the RPU but not yet reaped. A tail outside
+ * [ring_reaped, ring_head] (e.g. left over from before an RPU restart)
+ * counts as nothing completed, as does any tail while detached.
+ */
+static u32 ring_completed(void)
+{
+    u32 head = READ_ONCE(ring_head);
+    u32 reaped = READ_ONCE(ring_reaped);
+    u32 done;
+
+    if (!READ_ONCE(rpu_up))
+        return 0;
+    rmb();
+    done = shm_read(SHM_RING_TAIL_OFFSET) - reaped;
+
+    return (done <= head - reaped) ? done : 0;
+}
+
+/*
+ * Hand the next count descriptors back to the clients that queued them.
+ * Only a detach reaps descriptors the RPU has not consumed, which still
+ * read RPU_CMD_STATUS_PENDING: they complete as failed.
+ * Caller holds rpu_ring_mutex.
+ */
+static void ring_reap_slots(u32 count)
+{
+    u32 n;
+
+    for (n = 0; n < count; n++) {
+        u32 idx = ring_reaped++;
+        unsigned int desc = SHM_RING_DESC(idx);
+        struct rpu_ipi_client *c = ring_owner[idx & SHM_RING_MASK];
+        struct rpu_ipi_cmd cmd;
+
+        ring_owner[idx & SHM_RING_MASK] = NULL;
+        if (!c)
+            continue;  /* The client has closed its fd */
+
+        cmd.opcode = shm_read(desc + SHM_DESC_OPCODE);
+        cmd.arg = shm_read(desc + SHM_DESC_ARG);
+        cmd.seq = shm_read(desc + SHM_DESC_SEQ);
+        cmd.status = shm_read(desc + SHM_DESC_STATUS);
+        if (cmd.status == RPU_CMD_STATUS_PENDING)
+            cmd.status = RPU_CMD_STATUS_FAILED;
+        trace_rpu_ipi_ring_complete(c->tgid, idx, cmd.opcode, cmd.seq, cmd.status);
+        kfifo_put(&c->cq, cmd);
+        c->in_flight--;
+        c->completed++;
+    }
+}
+
+/*
+ * Hand descriptors consumed by the RPU back to the clients that queued them.
+ * Returns the number of completions. Caller holds rpu_ring_mutex.
+ */
+static unsigned int ring_reap(void)
+{
+    u32 done;
+
+    done = ring_completed();
+    rmb();
+    ring_reap_slots(done);
+
+    return done;
+}
+
+static bool client_can_dispatch(struct rpu_ipi_client *c)
+{
+    return !kfifo_is_empty(&c->sq) && c->in_flight < c->max_in_flight &&
+           c->in_flight + kfifo_len(&c->cq) < CLIENT_CQ_SIZE;
+}
+
+/*
+ * Move queued commands onto the ring, one per client in turn, and ring the
+ * doorbell once for all of them. A client that got a slot goes to the back
+ * of the list, so no client waits behind another one's whole queue.
+ * While detached commands stay queued. Caller holds rpu_ring_mutex.
+ */
+static void ring_dispatch(void)
+{
+    u32 first = ring_head;
+    u32 space;
+
+    if (!rpu_up)
+        return;
+
+    for (space = ring_space(); space != 0; space--) {
+        struct rpu_ipi_client *c, *pick = NULL;
+        unsigned int desc = SHM_RING_DESC(ring_head);
+        struct rpu_ipi_cmd cmd;
+
+        list_for_each_entry(c, &ring_clients, node) {
+            if (client_can_dispatch(c)) {
+                pick = c;
+                break;
+            }
+        }
+        if (!pick || !kfifo_get(&pick->sq, &cmd))
+            break;
+
+        shm_write(desc + SHM_DESC_OPCODE, cmd.opcode);
+        shm_write(desc + SHM_DESC_ARG, cmd.arg);
+        shm_write(desc + SHM_DESC_SEQ, cmd.seq);
+        shm_write(desc + SHM_DESC_STATUS, RPU_CMD_STATUS_PENDING);
+        ring_owner[ring_head & SHM_RING_MASK] = pick;
+        ring_head++;
+        pick->in_flight++;
+        ring_backlog--;
+        list_move_tail(&pick->node, &ring_clients);
+    }
+
+    /*
+     * Publish the new descriptors, one doorbell per dispatch, none while the
+     * RPU still polls the ring. Head must reach the window before the state
+     * is read (mb(), pairing with the RPU's re-arm).
+     */
+    if (ring_head != first) {
+        bool doorbell;
+
+        wmb();
+        shm_write(SHM_RING_HEAD_OFFSET, ring_head);
+        mb();
+        doorbell = SHM_RING_NEED_DOORBELL(shm_read(SHM_RING_STATE_OFFSET));
+        trace_rpu_ipi_ring_dispatch(ring_head, ring_head - first, ring_backlog, doorbell);
+        if (doorbell)
+            rpu_ipi_doorbell(RPU_IPI_DB_RING);
+
+        if (!ack_irq_enabled)
+            schedule_delayed_work(&ring_poll_work, 1);
+    }
+}
+
+/* Lockless wait conditions; the caller rechecks under rpu_ring_mutex */
+static bool ring_has_completions(struct rpu_ipi_client *c)
+{
+    return READ_ONCE(ring_mapper) || !kfifo_is_empty(&c->cq) ||
+           (READ_ONCE(c->in_flight) && ring_completed() != 0);
+}
+
+static bool ring_has_space(struct rpu_ipi_client *c)
+{
+    return READ_ONCE(ring_mapper) || !kfifo_is_full(&c->sq) || ring_completed() != 0;
+}
+
+/*
+ * Reap completions, dispatch queued commands and wake the clients; returns
+ * whether commands are still outstanding
+ */
+static bool ring_service(void)
+{
+    bool outstanding;
+
+    mutex_lock(&rpu_ring_mutex);
+    if (ring_mapper) {
+        rmb();
+        outstanding = shm_read(SHM_RING_TAIL_OFFSET) != shm_read(SHM_RING_HEAD_OFFSET);
+    } else {
+        ring_reap();
+        ring_dispatch();
+        outstanding = ring_reaped != ring_head;
+    }
+    mutex_unlock(&rpu_ring_mutex);
+
+    wake_up_interruptible(&ring_wq);
+    return outstanding;
+}
+
+/*
+ * Without a reverse IPI nothing signals completions, so poll the ring tail
+ * once per jiffy while commands are outstanding. The reverse IPI queues it
+ * too while commands wait for a slot (its IRQ thread serves the ring itself).
+ */
+static void ring_poll_work_fn(struct work_struct *work)
+{
+    if (ring_service() && !ack_irq_enabled)
+        schedule_delayed_work(&ring_poll_work, 1);
+}
+
+/*
+ * Queue up to count commands from user space in the client's submission
+ * queue and dispatch what the ring and the client's limits allow.
+ * Sequence numbers are written back when writeback is set.
+ * Returns the number of commands queued, or negative on error.
+ */
+static long ring_submit(struct rpu_ipi_client *c, struct rpu_ipi_cmd __user *ucmds,
+                        u32 count, bool writeback, bool nonblock)
+{
+    u32 n, i;
+    int ret = 0;
+
+    if (count == 0)
+        return 0;
+
+    for (;;) {
+        mutex_lock(&rpu_ring_mutex);
+        if (ring_mapper) {
+            mutex_unlock(&rpu_ring_mutex);
+            return -EBUSY;
+        }
+        ring_reap();
+        ring_dispatch();
+        if (!kfifo_is_full(&c->sq))
+            break;
+        mutex_unlock(&rpu_ring_mutex);
+
+        if (nonblock)
+            return -EAGAIN;
+        ret = wait_event_interruptible(ring_wq, ring_has_space(c));
+        if (ret)
+            return ret;
+    }
+
+    n = min(count, kfifo_avail(&c->sq));
+    for (i = 0; i < n; i++) {
+        struct rpu_ipi_cmd cmd;
+
+        if (copy_from_user(&cmd, &ucmds[i], sizeof(cmd))) {
+            ret = -EFAULT;
+            break;
+        }
+
+        cmd.seq = c->next_seq;
+        cmd.status = RPU_CMD_STATUS_PENDING;
+        if (writeback && copy_to_user(&ucmds[i], &cmd, sizeof(cmd))) {
+            ret = -EFAULT;
+            break;
+        }
+
+        kfifo_put(&c->sq, cmd);
+        c->next_seq++;
+        c->submitted++;
+        ring_backlog++;
+    }
+    ret = (i != 0) ? (int)i : ret;
+
+    /* Whatever was queued goes out, sharing the doorbell with other clients */
+    ring_dispatch();
+    mutex_unlock(&rpu_ring_mutex);
+
+    return ret;
+}
+
+static int rpu_ipi_open(struct inode *inode, struct file *file)
+{
+    struct rpu_ipi_client *c = kzalloc(sizeof(*c), GFP_KERNEL);
+
+    if (!c)
+        return -ENOMEM;
+
+    INIT_KFIFO(c->sq);
+    INIT_KFIFO(c->cq);
+    c->max_in_flight = clamp(READ_ONCE(client_inflight), 1U, (unsigned int)SHM_RING_SLOTS);
+    c->tgid = task_tgid_nr(current);
+
+    mutex_lock(&rpu_ring_mutex);
+    list_add_tail(&c->node, &ring_clients);
+    mutex_unlock(&rpu_ring_mutex);
+
+    file->private_data = c;
+    return nonseekable_open(inode, file);
+}
+
+/*
+ * Take a client off the ring; its descriptors still on it complete into
+ * nothing. Caller holds rpu_ring_mutex.
+ */
+static void ring_client_remove(struct rpu_ipi_client *c)
+{
+    u32 idx;
+
+    if (ring_mapper == c) {
+        /* Take the producer side back from where user space left it */
+        ring_head = shm_read(SHM_RING_HEAD_OFFSET);
+        ring_reaped = ring_head;
+        ring_mapper = NULL;
+    }
+    /* Its descriptors on the ring complete into nothing */
+    for (idx = ring_reaped; idx != ring_head; idx++) {
+        if (ring_owner[idx & SHM_RING_MASK] == c)
+            ring_owner[idx & SHM_RING_MASK] = NULL;
+    }
+    ring_backlog -= kfifo_len(&c->sq);
+    list_del(&c->node);
+}
+
+static int rpu_ipi_release(struct inode *inode, struct file *file)
+{
+    struct rpu_ipi_client *c = file->private_data;
+
+    mutex_lock(&rpu_ring_mutex);
+    ring_client_remove(c);
+    mutex_unlock(&rpu_ring_mutex);
+
+    /* Clients that waited for the ring may run now */
+    wake_up_interruptible(&ring_wq);
+
+    kfree(c);
+    return 0;
+}
+
+static bool ring_batch_done(struct rpu_ipi_client *c, unsigned int n)
+{
+    return READ_ONCE(ring_mapper) || kfifo_len(&c->cq) == n || ring_completed() != 0;
+}
+
+/*
+ * Several modes written to /sys/kernel/rpu_ipi/write at once: RPU_CMD_SET_MODE
+ * commands of a client of the writer's own on the command ring, dispatched
+ * with one doorbell (more only beyond client_inflight or the RPU's credits)
+ * and acknowledged together by their completions. Returns 0 once all
+ * completed with RPU_CMD_STATUS_OK, -EIO if one did not, -ETIMEDOUT if they
+ * are not all back within ack_timeout_ms, and like send_message_to_rpu()
+ * -ENODEV if no firmware is attached within ack_timeout_ms.
+ */
+static int send_mode_batch(const int *modes, unsigned int n)
+{
+    unsigned long deadline = jiffies + msecs_to_jiffies(max(READ_ONCE(ack_timeout_ms), 1U));
+    struct rpu_ipi_client *c = kzalloc(sizeof(*c), GFP_KERNEL);
+    struct rpu_ipi_cmd cmd;
+    unsigned int i, ok = 0;
+    long left;
+    int ret = 0;
+
+    if (!c)
+        return -ENOMEM;
+    if (rpu_ipi_wait_up()) {
+        kfree(c);
+        return -ENODEV;
+    }
+
+    INIT_KFIFO(c->sq);
+    INIT_KFIFO(c->cq);
+    c->max_in_flight = clamp(READ_ONCE(client_inflight), 1U, (unsigned int)SHM_RING_SLOTS);
+    c->tgid = task_tgid_nr(current);
+
+    mutex_lock(&rpu_ring_mutex);
+    if (ring_mapper || !rpu_up) {
+        ret = ring_mapper ? -EBUSY : -ENODEV;
+        mutex_unlock(&rpu_ring_mutex);
+        kfree(c);
+        return ret;
+    }
+    for (i = 0; i < n; i++) {
+        cmd.opcode = RPU_CMD_SET_MODE;
+        cmd.arg = modes[i];
+        cmd.seq = c->next_seq++;
+        cmd.status = RPU_CMD_STATUS_PENDING;
+        kfifo_put(&c->sq, cmd);
+    }
+    c->submitted = n;
+    ring_backlog += n;
+    list_add_tail(&c->node, &ring_clients);
+    ring_dispatch();
+    mutex_unlock(&rpu_ring_mutex);
+
+    /* Leaves the loop with rpu_ring_mutex held */
+    for (;;) {
+        mutex_lock(&rpu_ring_mutex);
+        if (ring_mapper) {
+            ret = -EBUSY;
+            break;
+        }
+        ring_reap();
+        if (kfifo_len(&c->cq) == n)
+            break;
+        ring_dispatch();
+        if (time_after_eq(jiffies, deadline)) {
+            ret = -ETIMEDOUT;
+            break;
+        }
+        mutex_unlock(&rpu_ring_mutex);
+
+        left = wait_event_interruptible_timeout(ring_wq, ring_batch_done(c, n),
+                                                max_t(long, (long)(deadline - jiffies), 1));
+        if (left < 0) {
+            /* Not -ERESTARTSYS: a restarted write would send the batch again */
+            ret = -EINTR;
+            mutex_lock(&rpu_ring_mutex);
+            break;
+        }
+    }
+
+    while (kfifo_get(&c->cq, &cmd)) {
+        if (cmd.status == RPU_CMD_STATUS_OK)
+            ok++;
+    }
+    ring_client_remove(c);
+    mutex_unlock(&rpu_ring_mutex);
+    wake_up_interruptible(&ring_wq);
+    kfree(c);
+
+    mutex_lock(&rpu_ipi_mutex);
+    last_sent_mode = modes[n - 1];
+    last_ack_received = ret == 0 && ok == n;
+    mutex_unlock(&rpu_ipi_mutex);
+
+    if (ret == -ETIMEDOUT)
+        pr_warn("%s: Timeout waiting for a batch of %u modes (%u applied, %u ms)\n",
+                MODULE_NAME, n, ok, READ_ONCE(ack_timeout_ms));
+    if (ret == 0 && ok != n) {
+        pr_err("%s: %u of a batch of %u modes not applied\n", MODULE_NAME, n - ok, n);
+        ret = -EIO;
+    }
+    return ret;
+}
+
+static ssize_t rpu_ipi_read(struct file *file, char __user *buf,
+                            size_t count, loff_t *ppos)
+{
+    struct rpu_ipi_client *c = file->private_data;
+    unsigned int copied;
+    int ret;
+
+    if (count < sizeof(struct rpu_ipi_cmd))
+        return -EINVAL;
+    count -= count % sizeof(struct rpu_ipi_cmd);
+
+    for (;;) {
+        mutex_lock(&rpu_ring_mutex);
+        if (ring_mapper) {
+            mutex_unlock(&rpu_ring_mutex);
+            return -EBUSY;
+        }
+        ring_reap();
+        if (!kfifo_is_empty(&c->cq))
+            break;
+        ring_dispatch();
+        mutex_unlock(&rpu_ring_mutex);
+
+        if (file->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        ret = wait_event_interruptible(ring_wq, ring_has_completions(c));
+        if (ret)
+            return ret;
+    }
+
+    ret = kfifo_to_user(&c->cq, buf, count, &copied);
+    /* Room in cq may unblock this client's queued commands */
+    ring_dispatch();
+    mutex_unlock(&rpu_ring_mutex);
+
+    /* Reaped slots may have become free for a blocked submitter */
+    wake_up_interruptible(&ring_wq);
+
+    return ret ? ret : copied;
+}
+
+static ssize_t rpu_ipi_write(struct file *file, const char __user *buf,
+                             size_t count, loff_t *ppos)
+{
+    long ret;
+
+    if (count == 0 || count % sizeof(struct rpu_ipi_cmd))
+        return -EINVAL;
+
+    ret = ring_submit(file->private_data, (struct rpu_ipi_cmd __user *)buf,
+                      min_t(size_t, count / sizeof(struct rpu_ipi_cmd), CLIENT_SQ_SIZE),
+                      false, file->f_flags & O_NONBLOCK);
+
+    return (ret < 0) ? ret : ret * sizeof(struct rpu_ipi_cmd);
+}
+
+static __poll_t rpu_ipi_poll(struct file *file, poll_table *wait)
+{
+    struct rpu_ipi_client *c = file->private_data;
+    __poll_t mask = 0;
+
+    poll_wait(file, &ring_wq, wait);
+
+    mutex_lock(&rpu_ring_mutex);
+    if (ring_mapper) {
+        /* Readable once the RPU has consumed everything user space published */
+        rmb();
+        if (shm_read(SHM_RING_TAIL_OFFSET) == shm_read(SHM_RING_HEAD_OFFSET))
+            mask |= EPOLLIN | EPOLLRDNORM;
+        mask |= EPOLLOUT | EPOLLWRNORM;
+    } else {
+        ring_reap();
+        ring_dispatch();
+        if (!kfifo_is_empty(&c->cq))
+            mask |= EPOLLIN | EPOLLRDNORM;
+        if (!kfifo_is_full(&c->sq))
+            mask |= EPOLLOUT | EPOLLWRNORM;
+    }
+    mutex_unlock(&rpu_ring_mutex);
+
+    return mask;
+}
+
+/*
+ * The "bulk" channel of the node. Requested on first use rather than at
+ * probe, so a DMA driver that binds after this module is still found. Only
+ * the channel the device tree names: the LPD DMA channels belong to the RPU
+ * firmware (wave, bulk and copy DMA), and one taken by capability could be
+ * one of them.
+ */
+static struct dma_chan *bulk_dma_get(void)
+{
+    struct dma_chan *chan;
+
+    if (bulk_dma_chan)
+        return bulk_dma_chan;
+    if (!rpu_ipi_dev || !rpu_ipi_dev->of_node)
+        return NULL;
+
+    chan = dma_request_chan(rpu_ipi_dev, "bulk");
+    if (IS_ERR(chan))
+        return NULL;
+    if (!dma_has_cap(DMA_MEMCPY, chan->device->cap_mask)) {
+        pr_warn("%s: DMA channel %s cannot copy memory\n", MODULE_NAME, dma_chan_name(chan));
+        dma_release_channel(chan);
+        return NULL;
+    }
+    pr_info("%s: Bulk DMA on %s\n", MODULE_NAME, dma_chan_name(chan));
+    bulk_dma_chan = chan;
+    return chan;
+}
+
+static void bulk_dma_done(void *arg)
+{
+    complete(arg);
+}
+
+/*
+ * Copy between the user pages of sgt (mapped for the channel) and the region
+ * at region_dma, one memcpy descriptor per DMA segment; only the last
+ * interrupts, the channel completes them in order. -EINVAL before anything
+ * is queued if a segment does not suit the channel's alignment.
+ */
+static int bulk_dma_run(struct dma_chan *chan, struct sg_table *sgt,
+                        dma_addr_t region_dma, bool read)
+{
+    struct dma_device *dd = chan->device;
+    struct dma_async_tx_descriptor *tx;
+    DECLARE_COMPLETION_ONSTACK(done);
+    struct scatterlist *sg;
+    dma_cookie_t cookie = -EINVAL;
+    dma_addr_t region = region_dma;
+    unsigned long flags;
+    unsigned int i;
+
+    for_each_sgtable_dma_sg(sgt, sg, i) {
+        if (!is_dma_copy_aligned(dd, sg_dma_address(sg), region, sg_dma_len(sg)))
+            return -EINVAL;
+        region += sg_dma_len(sg);
+    }
+
+    region = region_dma;
+    for_each_sgtable_dma_sg(sgt, sg, i) {
+        flags = DMA_CTRL_ACK;
+        if (i == sgt->nents - 1)
+            flags |= DMA_PREP_INTERRUPT;
+        tx = read ? dmaengine_prep_dma_memcpy(chan, sg_dma_address(sg), region,
+                                              sg_dma_len(sg), flags)
+                  : dmaengine_prep_dma_memcpy(chan, region, sg_dma_address(sg),
+                                              sg_dma_len(sg), flags);
+        if (!tx)
+            goto err_terminate;
+        if (flags & DMA_PREP_INTERRUPT) {
+            tx->callback = bulk_dma_done;
+            tx->callback_param = &done;
+        }
+        cookie = dmaengine_submit(tx);
+        if (dma_submit_error(cookie))
+            goto err_terminate;
+        region += sg_dma_len(sg);
+    }
+
+    dma_async_issue_pending(chan);
+    if (!wait_for_completion_timeout(&done, msecs_to_jiffies(BULK_DMA_TIMEOUT_MS))) {
+        pr_err("%s: Bulk DMA timed out\n", MODULE_NAME);
+        dmaengine_terminate_sync(chan);
+        return -ETIMEDOUT;
+    }
+    if (dma_async_is_tx_complete(chan, cookie, NULL, NULL) != DMA_COMPLETE)
+        return -EIO;
+    return 0;
+
+err_terminate:
+    /* Descriptors already submitted must not run on unmapped pages */
+    dmaengine_terminate_sync(chan);
+    return -ENOMEM;
+}
+
+/*
+ * RPU_IPI_IOC_DMA: pin the user buffer, map it and the region range for the
+ * channel, copy, and hand the pages back (dirty when the region was read)
+ */
+static long bulk_dma_copy(const struct rpu_ipi_dma *dma)
+{
+    bool read = dma->flags & RPU_IPI_DMA_F_READ;
+    enum dma_data_direction user_dir = read ? DMA_FROM_DEVICE : DMA_TO_DEVICE;
+    enum dma_data_direction region_dir = read ? DMA_TO_DEVICE : DMA_FROM_DEVICE;
+    unsigned long start = dma->user;
+    struct dma_chan *chan;
+    struct device *dev;
+    struct page **pages;
+    struct sg_table sgt;
+    dma_addr_t region_dma;
+    unsigned int nr_pages;
+    int pinned;
+    int ret;
+
+    if ((dma->flags & ~RPU_IPI_DMA_F_READ) || dma->reserved || !dma->len)
+        return -EINVAL;
+    if (dma->offset > resource_size(&region_res) ||
+        dma->len > resource_size(&region_res) - dma->offset)
+        return resource_size(&region_res) ? -EINVAL : -ENODEV;
+    if (dma->user != start || !access_ok(u64_to_user_ptr(dma->user), dma->len))
+        return -EFAULT;
+
+    mutex_lock(&bulk_dma_mutex);
+    chan = bulk_dma_get();
+    if (!chan) {
+        ret = -ENODEV;
+        goto out_unlock;
+    }
+    dev = chan->device->dev;
+
+    nr_pages = DIV_ROUND_UP(offset_in_page(start) + dma->len, PAGE_SIZE);
+    pages = kvmalloc_array(nr_pages, sizeof(*pages), GFP_KERNEL);
+    if (!pages) {
+        ret = -ENOMEM;
+        goto out_unlock;
+    }
+    pinned = pin_user_pages_fast(start & PAGE_MASK, nr_pages, read ? FOLL_WRITE : 0, pages);
+    if (pinned != nr_pages) {
+        ret = pinned < 0 ? pinned : -EFAULT;
+        goto out_unpin;
+    }
+
+    ret = sg_alloc_table_from_pages(&sgt, pages, nr_pages, offset_in_page(start),
+                                    dma->len, GFP_KERNEL);
+    if (ret)
+        goto out_unpin;
+    ret = dma_map_sgtable(dev, &sgt, user_dir, 0);
+    if (ret)
+        goto out_free_table;
+    region_dma = dma_map_resource(dev, region_res.start + dma->offset, dma->len, region_dir, 0);
+    if (dma_mapping_error(dev, region_dma)) {
+        ret = -ENOMEM;
+        goto out_unmap_sg;
+    }
+
+    ret = bulk_dma_run(chan, &sgt, region_dma, read);
+
+    dma_unmap_resource(dev, region_dma, dma->len, region_dir, 0);
+out_unmap_sg:
+    dma_unmap_sgtable(dev, &sgt, user_dir, 0);
+out_free_table:
+    sg_free_table(&sgt);
+out_unpin:
+    if (pinned > 0)
+        unpin_user_pages_dirty_lock(pages, pinned, read && !ret);
+    kvfree(pages);
+    if (!ret) {
+        bulk_dma_stats.copies++;
+        bulk_dma_stats.bytes += dma->len;
+    } else if (ret != -EINVAL) {
+        bulk_dma_stats.errors++;
+    }
+out_unlock:
+    mutex_unlock(&bulk_dma_mutex);
+    return ret;
+}
+
+static long rpu_ipi_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    struct rpu_ipi_client *c = file->private_data;
+    struct rpu_ipi_batch batch;
+    struct rpu_ipi_msg msg;
+    u32 limit;
+    int ret;
+
+    switch (cmd) {
+    case RPU_IPI_IOC_SUBMIT:
+        if (copy_from_user(&batch, (void __user *)arg, sizeof(batch)))
+            return -EFAULT;
+        if (batch.flags != 0)
+            return -EINVAL;
+        return ring_submit(c, u64_to_user_ptr(batch.cmds),
+                           min_t(u32, batch.count, CLIENT_SQ_SIZE),
+                           true, file->f_flags & O_NONBLOCK);
+    case RPU_IPI_IOC_DOORBELL:
+        if (!READ_ONCE(rpu_up))
+            return -ENODEV;
+        /* Order the producer's stores through the mapping before the IPI */
+        wmb();
+        rpu_ipi_doorbell(RPU_IPI_DB_USER);
+        if (!ack_irq_enabled)
+            schedule_delayed_work(&ring_poll_work, 1);
+        return 0;
+    case RPU_IPI_IOC_MSG:
+        if (copy_from_user(&msg, (void __user *)arg, sizeof(msg)))
+            return -EFAULT;
+        ret = send_ipi_msg(&msg);
+        if (ret)
+            return ret;
+        if (copy_to_user((void __user *)arg, &msg, sizeof(msg)))
+            return -EFAULT;
+        return 0;
+    case RPU_IPI_IOC_REGION: {
+        struct rpu_ipi_region region = {
+            .phys = region_res.start,
+            .size = resource_size(&region_res),
+        };
+
+        if (copy_to_user((void __user *)arg, &region, sizeof(region)))
+            return -EFAULT;
+        return 0;
+    }
+    case RPU_IPI_IOC_DMA: {
+        struct rpu_ipi_dma dma;
+
+        if (copy_from_user(&dma, (void __user *)arg, sizeof(dma)))
+            return -EFAULT;
+        return bulk_dma_copy(&dma);
+    }
+    case RPU_IPI_IOC_INFLIGHT:
+        if (get_user(limit, (u32 __user *)arg))
+            return -EFAULT;
+        /* Clients may lower their share, not raise it beyond the module's */
+        if (limit < 1 || limit > clamp(READ_ONCE(client_inflight), 1U, (unsigned int)SHM_RING_SLOTS))
+            return -EINVAL;
+        mutex_lock(&rpu_ring_mutex);
+        c->max_in_flight = limit;
+        ring_dispatch();
+        mutex_unlock(&rpu_ring_mutex);
+        return 0;
+    default:
+        return -ENOTTY;
+    }
+}
+
+/*
+ * DDR memory-region at RPU_IPI_MMAP_REGION_OFFSET: Normal non-cacheable, as
+ * the RPU and its DMA engine do not snoop the A53 caches, but unlike the
+ * Device mapping of the window loads and stores may be merged and burst
+ */
+static int rpu_ipi_mmap_region(struct vm_area_struct *vma)
+{
+    if (!resource_size(&region_res))
+        return -ENXIO;
+
+    vma->vm_pgoff -= RPU_IPI_MMAP_REGION_OFFSET >> PAGE_SHIFT;
+    vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+    return vm_iomap_memory(vma, region_res.start, resource_size(&region_res));
+}
+
+/*
+ * Map the shared OCM window non-cached so user space sees the same memory
+ * as the RPU. The kernel stops producing on the ring while it is mapped, so
+ * the ring must be idle: no client may have commands queued or in flight.
+ * The mapping is of the window of the firmware attached at the time; a
+ * later image may use another one (TCM variant), so map again after it.
+ */
+static int rpu_ipi_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    struct rpu_ipi_client *c = file->private_data;
+    int ret;
+
+    if (vma->vm_pgoff >= (RPU_IPI_MMAP_REGION_OFFSET >> PAGE_SHIFT))
+        return rpu_ipi_mmap_region(vma);
+
+    vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+    mutex_lock(&rpu_ring_mutex);
+    if (!rpu_up) {
+        mutex_unlock(&rpu_ring_mutex);
+        return -ENODEV;
+    }
+    ring_reap();
+    if ((ring_mapper && ring_mapper != c) || ring_backlog || ring_reaped != ring_head) {
+        mutex_unlock(&rpu_ring_mutex);
+        return -EBUSY;
+    }
+    ret = vm_iomap_memory(vma, shm_phys, SHARED_MEM_SIZE);
+    if (!ret)
+        ring_mapper = c;
+    mutex_unlock(&rpu_ring_mutex);
+
+    /* Blocked submitters and readers must observe -EBUSY */
+    wake_up_interruptible(&ring_wq);
+
+    return ret;
+}
+
+static const struct file_operations rpu_ipi_fops = {
+    .owner = THIS_MODULE,
+    .open = rpu_ipi_open,
+    .release = rpu_ipi_release,
+    .read = rpu_ipi_read,
+    .write = rpu_ipi_write,
+    .poll = rpu_ipi_poll,
+    .unlocked_ioctl = rpu_ipi_ioctl,
+    .mmap = rpu_ipi_mmap,
+    .compat_ioctl = compat_ptr_ioctl,
+};
+
+static struct miscdevice rpu_ipi_miscdev = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = RPU_IPI_DEV_NAME,
+    .fops = &rpu_ipi_fops,
+    .mode = 0660,
+};
+
+/*
+ * Trace stream - /dev/rpu_trace
+ *
+ * The trace lives in the window, IPI message RAM or TCM without struct
+ * pages, and its entries are only valid if their seq holds across the copy,
+ * so they cannot be handed out in place. While the device is open a delayed
+ * work copies the new events every trace_poll_ms, checked like rpu_trace
+ * does and compact traces decoded to the same records, into pages of
+ * records. splice() passes those pages to the pipe by reference and never
+ * writes them again; read() copies them. One reader at a time; under
+ * trace_mutex, and rpu_ring_mutex around the window.
+ */
+struct trace_page {
+    struct page *page;
+    unsigned int len;  /* Record bytes */
+};
+
+static struct {
+    bool active;               /* Open */
+    struct trace_page *pages;  /* Ring of nr pages, count from first */
+    unsigned int nr;
+    unsigned int first;
+    unsigned int count;
+    unsigned int off;          /* Bytes of the first page consumed */
+    bool sealed;               /* The last page went to a pipe: no more records on it */
+    bool synced;               /* next (and the compact state) follow the window;
+                                  cleared by an attach, under rpu_ring_mutex */
+    bool compact;              /* SHM_TRACE_MAGIC_COMPACT */
+    u32 next;                  /* Next entry, or compact block */
+    bool begun;                /* st holds the coding state of block next */
+    bool decoded;              /* expect is the index of the next event */
+    u32 expect;
+    struct rpu_tracez_state st;
+    struct {
+        u32 used;
+        u32 first;
+        u64 base;
+        u8 data[SHM_TRACEZ_DATA_SIZE];
+    } blk;
+    u64 events;                /* Records buffered */
+    u64 lost;                  /* Events the RPU overwrote before they were copied */
+} trace;
+static DEFINE_MUTEX(trace_mutex);
+static DECLARE_WAIT_QUEUE_HEAD(trace_wq);
+static void trace_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(trace_work, trace_work_fn);
+
+static inline struct trace_page *trace_page_at(unsigned int i)
+{
+    return &trace.pages[(trace.first + i) % trace.nr];
+}
+
+static bool trace_readable(void)
+{
+    return trace.count && trace_page_at(0)->len > trace.off;
+}
+
+/* Room for another record: on the last page, or for a new one */
+static bool trace_room(void)
+{
+    struct trace_page *tp;
+
+    if (trace.count < trace.nr)
+        return true;
+    tp = trace_page_at(trace.count - 1);
+    return !trace.sealed && tp->len + sizeof(struct rpu_shm_trace) <= PAGE_SIZE;
+}
+
+static void trace_put(const struct rpu_shm_trace *e)
+{
+    struct trace_page *tp = trace.count ? trace_page_at(trace.count - 1) : NULL;
+
+    if (!tp || trace.sealed || tp->len + sizeof(*e) > PAGE_SIZE) {
+        struct page *page = alloc_page(GFP_KERNEL);
+
+        if (!page) {
+            trace.lost++;
+            return;
+        }
+        tp = trace_page_at(trace.count++);
+        tp->page = page;
+        tp->len = 0;
+        trace.sealed = false;
+    }
+    memcpy(page_address(tp->page) + tp->len, e, sizeof(*e));
+    tp->len += sizeof(*e);
+    trace.events++;
+}
+
+/* Drop n bytes from the front; pages read to the end go, unless still being filled */
+static void trace_consume(size_t n)
+{
+    while (n && trace.count) {
+        struct trace_page *tp = trace_page_at(0);
+        size_t k = min_t(size_t, n, tp->len - trace.off);
+
+        trace.off += k;
+        n -= k;
+        if (trace.off < tp->len || (trace.count == 1 && !trace.sealed))
+            break;
+        put_page(tp->page);
+        trace.first = (trace.first + 1) % trace.nr;
+        trace.count--;
+        trace.off = 0;
+    }
+}
+
+/* Start at the oldest event the window holds, e.g. of a newly attached image */
+static void trace_sync(void)
+{
+    u32 magic = shm_read(SHM_TRACE_MAGIC_OFFSET);
+    u32 h = shm_read(SHM_TRACE_HEAD_OFFSET);
+
+    trace.synced = magic == SHM_TRACE_MAGIC || magic == SHM_TRACE_MAGIC_COMPACT;
+    trace.compact = magic == SHM_TRACE_MAGIC_COMPACT;
+    if (trace.compact)
+        trace.next = (h > SHM_TRACEZ_BLOCKS) ? h - SHM_TRACEZ_BLOCKS + 1 : 1;
+    else
+        trace.next = (h > SHM_TRACE_SLOTS) ? h - SHM_TRACE_SLOTS : 0;
+    trace.begun = false;
+    trace.decoded = false;
+}
+
+/* Copy entry idx if it is still the one the RPU wrote for that index */
+static bool trace_read_entry(u32 idx, struct rpu_shm_trace *e)
+{
+    unsigned int off = SHM_TRACE_ENTRY(idx);
+
+    if (shm_read(off + SHM_TRACE_SEQ) != idx + 1)
+        return false;
+    rmb();
+    e->event = shm_read(off + SHM_TRACE_EVENT);
+    e->arg0 = shm_read(off + SHM_TRACE_ARG0);
+    e->arg1 = shm_read(off + SHM_TRACE_ARG1);
+    e->ts_lo = shm_read(off + SHM_TRACE_TS_LO);
+    e->ts_hi = shm_read(off + SHM_TRACE_TS_HI);
+    rmb();
+    e->seq = shm_read(off + SHM_TRACE_SEQ);
+    return e->seq == idx + 1;
+}
+
+static void trace_drain_fixed(void)
+{
+    struct rpu_shm_trace e;
+    u32 h = shm_read(SHM_TRACE_HEAD_OFFSET);
+
+    rmb();
+    /* Head went backwards: the firmware restarted its trace */
+    if ((s32)(h - trace.next) < 0)
+        trace.next = (h > SHM_TRACE_SLOTS) ? h - SHM_TRACE_SLOTS : 0;
+    if (h - trace.next > SHM_TRACE_SLOTS) {
+        trace.lost += h - SHM_TRACE_SLOTS - trace.next;
+        trace.next = h - SHM_TRACE_SLOTS;
+    }
+
+    for (; trace.next != h && trace_room(); trace.next++) {
+        if (!trace_read_entry(trace.next, &e)) {
+            /* Overwritten while copied, or still being written */
+            if (shm_read(SHM_TRACE_HEAD_OFFSET) - trace.next > SHM_TRACE_SLOTS) {
+                trace.lost++;
+                continue;
+            }
+            break;
+        }
+        trace_put(&e);
+    }
+}
+
+/* Copy compact block n from record byte from on, if the block still holds n */
+static bool trace_read_block(u32 n, u32 from)
+{
+    unsigned int off = SHM_TRACEZ_BLOCK(n);
+    u32 w, word;
+
+    if (shm_read(off + SHM_TRACEZ_SEQ) != n)
+        return false;
+    rmb();
+    trace.blk.used = shm_read(off + SHM_TRACEZ_USED);
+    trace.blk.first = shm_read(off + SHM_TRACEZ_FIRST);
+    trace.blk.base = ((u64)shm_read(off + SHM_TRACEZ_BASE_HI) << 32) |
+                     shm_read(off + SHM_TRACEZ_BASE_LO);
+    if (trace.blk.used > SHM_TRACEZ_DATA_SIZE)
+        return false;
+    rmb();
+    for (w = from / 4; w < (trace.blk.used + 3) / 4; w++) {
+        word = shm_read(off + SHM_TRACEZ_DATA + w * 4);
+        memcpy(&trace.blk.data[w * 4], &word, 4);
+    }
+    rmb();
+    return shm_read(off + SHM_TRACEZ_SEQ) == n;
+}
+
+static void trace_drain_compact(void)
+{
+    struct rpu_tracez_state st;
+    struct rpu_shm_trace e;
+    u32 h = shm_read(SHM_TRACE_HEAD_OFFSET);
+    int r;
+
+    rmb();
+    if (h < trace.next && !(h == 0 && trace.next == 1)) {
+        trace.next = (h > SHM_TRACEZ_BLOCKS) ? h - SHM_TRACEZ_BLOCKS + 1 : 1;
+        trace.begun = false;
+        trace.decoded = false;
+    }
+
+    while (h != 0 && trace.next <= h) {
+        if (h - trace.next >= SHM_TRACEZ_BLOCKS ||
+            !trace_read_block(trace.next, trace.begun ? trace.st.pos : 0)) {
+            /* Lapped, or overwritten while copied: go on at the oldest block */
+            h = shm_read(SHM_TRACE_HEAD_OFFSET);
+            if (h - trace.next >= SHM_TRACEZ_BLOCKS) {
+                trace.next = h - SHM_TRACEZ_BLOCKS + 1;
+                trace.begun = false;
+                continue;
+            }
+            break;
+        }
+        if (!trace.begun) {
+            if (trace.decoded && trace.blk.first != trace.expect)
+                trace.lost += trace.blk.first - trace.expect;
+            rpu_tracez_begin(&trace.st, trace.blk.base, trace.blk.first);
+            trace.begun = true;
+        }
+
+        for (;;) {
+            if (!trace_room())
+                return;
+            st = trace.st;
+            r = rpu_tracez_decode(&st, trace.blk.data, trace.blk.used, &e);
+            if (r != 1)
+                break;
+            trace.st = st;
+            trace_put(&e);
+        }
+        /* Not a record: the rest of the block is unusable, its events lost */
+        if (r < 0)
+            trace.st.pos = SHM_TRACEZ_DATA_SIZE;
+        trace.expect = trace.st.index;
+        trace.decoded = true;
+
+        /* The block being written may still grow */
+        if (trace.next == h)
+            break;
+        trace.next++;
+        trace.begun = false;
+    }
+}
+
+static void trace_work_fn(struct work_struct *work)
+{
+    bool readable;
+
+    mutex_lock(&trace_mutex);
+    if (!trace.active) {
+        mutex_unlock(&trace_mutex);
+        return;
+    }
+
+    mutex_lock(&rpu_ring_mutex);
+    if (READ_ONCE(rpu_up)) {
+        if (!trace.synced)
+            trace_sync();
+        if (trace.synced && trace.compact)
+            trace_drain_compact();
+        else if (trace.synced)
+            trace_drain_fixed();
+    }
+    mutex_unlock(&rpu_ring_mutex);
+
+    readable = trace_readable();
+    schedule_delayed_work(&trace_work, msecs_to_jiffies(max(READ_ONCE(trace_poll_ms), 1U)));
+    mutex_unlock(&trace_mutex);
+
+    if (readable)
+        wake_up_interruptible(&trace_wq);
+}
+
+static int rpu_trace_open(struct inode *inode, struct file *file)
+{
+    unsigned int nr = clamp(READ_ONCE(trace_pages), 2U, (unsigned int)TRACE_PAGES_MAX);
+    struct trace_page *pages = kcalloc(nr, sizeof(*pages), GFP_KERNEL);
+
+    if (!pages)
+        return -ENOMEM;
+
+    mutex_lock(&trace_mutex);
+    if (trace.active) {
+        mutex_unlock(&trace_mutex);
+        kfree(pages);
+        return -EBUSY;
+    }
+    memset(&trace, 0, sizeof(trace));
+    trace.pages = pages;
+    trace.nr = nr;
+    trace.active = true;
+    schedule_delayed_work(&trace_work, 0);
+    mutex_unlock(&trace_mutex);
+
+    return nonseekable_open(inode, file);
+}
+
+static int rpu_trace_release(struct inode *inode, struct file *file)
+{
+    /* Pages still in a pipe hold their own reference */
+    cancel_delayed_work_sync(&trace_work);
+
+    mutex_lock(&trace_mutex);
+    while (trace.count) {
+        put_page(trace_page_at(0)->page);
+        trace.first = (trace.first + 1) % trace.nr;
+        trace.count--;
+    }
+    kfree(trace.pages);
+    trace.pages = NULL;
+    trace.active = false;
+    mutex_unlock(&trace_mutex);
+    return 0;
+}
+
+/* Wait for records; returns 0 with trace_mutex held */
+static int rpu_trace_wait(bool nonblock)
+{
+    int ret;
+
+    for (;;) {
+        mutex_lock(&trace_mutex);
+        if (trace_readable())
+            return 0;
+        mutex_unlock(&trace_mutex);
+
+        if (nonblock)
+            return -EAGAIN;
+        ret = wait_event_interruptible(trace_wq, trace_readable());
+        if (ret)
+            return ret;
+    }
+}
+
+static ssize_t rpu_trace_read(struct file *file, char __user *buf,
+                              size_t count, loff_t *ppos)
+{
+    size_t done = 0;
+    int ret = rpu_trace_wait(file->f_flags & O_NONBLOCK);
+
+    if (ret)
+        return ret;
+
+    while (done < count && trace_readable()) {
+        struct trace_page *tp = trace_page_at(0);
+        size_t k = min_t(size_t, count - done, tp->len - trace.off);
+
+        if (copy_to_user(buf + done, page_address(tp->page) + trace.off, k)) {
+            ret = -EFAULT;
+            break;
+        }
+        done += k;
+        trace_consume(k);
+    }
+    mutex_unlock(&trace_mutex);
+
+    return done ? done : ret;
+}
+
+static void rpu_trace_buf_release(struct pipe_inode_info *pipe, struct pipe_buffer *buf)
+{
+    put_page(buf->page);
+}
+
+static const struct pipe_buf_operations rpu_trace_buf_ops = {
+    .release = rpu_trace_buf_release,
+    .get = generic_pipe_buf_get,
+};
+
+static void rpu_trace_spd_release(struct splice_pipe_desc *spd, unsigned int i)
+{
+    put_page(spd->pages[i]);
+}
+
+/*
+ * Hand the buffered pages to the pipe, each with a reference of its own.
+ * The last page is sealed first: records that follow go to a new page, so
+ * nothing a pipe holds changes under it.
+ */
+static ssize_t rpu_trace_splice_read(struct file *file, loff_t *ppos,
+                                     struct pipe_inode_info *pipe, size_t len,
+                                     unsigned int flags)
+{
+    struct page *pages[PIPE_DEF_BUFFERS];
+    struct partial_page partial[PIPE_DEF_BUFFERS];
+    struct splice_pipe_desc spd = {
+        .pages = pages,
+        .partial = partial,
+        .nr_pages_max = PIPE_DEF_BUFFERS,
+        .ops = &rpu_trace_buf_ops,
+        .spd_release = rpu_trace_spd_release,
+    };
+    unsigned int i, off;
+    ssize_t ret;
+
+    ret = rpu_trace_wait((file->f_flags & O_NONBLOCK) || (flags & SPLICE_F_NONBLOCK));
+    if (ret)
+        return ret;
+
+    trace.sealed = true;
+    off = trace.off;
+    for (i = 0; i < trace.count && spd.nr_pages < PIPE_DEF_BUFFERS && len; i++) {
+        struct trace_page *tp = trace_page_at(i);
+        size_t k = min_t(size_t, len, tp->len - off);
+
+        get_page(tp->page);
+        pages[spd.nr_pages] = tp->page;
+        partial[spd.nr_pages].offset = off;
+        partial[spd.nr_pages].len = k;
+        spd.nr_pages++;
+        len -= k;
+        off = 0;
+    }
+
+    ret = splice_to_pipe(pipe, &spd);
+    if (ret > 0)
+        trace_consume(ret);
+    mutex_unlock(&trace_mutex);
+
+    return ret;
+}
+
+static __poll_t rpu_trace_poll(struct file *file, poll_table *wait)
+{
+    __poll_t mask = 0;
+
+    poll_wait(file, &trace_wq, wait);
+
+    mutex_lock(&trace_mutex);
+    if (trace_readable())
+        mask |= EPOLLIN | EPOLLRDNORM;
+    mutex_unlock(&trace_mutex);
+
+    return mask;
+}
+
+static const struct file_operations rpu_trace_fops = {
+    .owner = THIS_MODULE,
+    .open = rpu_trace_open,
+    .release = rpu_trace_release,
+    .read = rpu_trace_read,
+    .splice_read = rpu_trace_splice_read,
+    .poll = rpu_trace_poll,
+};
+
+static struct miscdevice rpu_trace_miscdev = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = RPU_TRACE_DEV_NAME,
+    .fops = &rpu_trace_fops,
+    .mode = 0440,
+};
+
+/*
+ * Debugfs statistics - /sys/kernel/debug/rpu_ipi/
+ */
+static int stats_show(struct seq_file *m, void *v)
+{
+    u64 lo;
+    int i;
+
+    mutex_lock(&rpu_ipi_mutex);
+
+    seq_printf(m, "messages:  %llu\n", stats.messages);
+    seq_printf(m, "acks:      %llu\n", stats.acks);
+    seq_printf(m, "timeouts:  %llu\n", stats.timeouts);
+    seq_printf(m, "bad_acks:  %llu\n", stats.bad_acks);
+    seq_printf(m, "ipi_msgs:  %llu\n", stats.ipi_msgs);
+    seq_printf(m, "ipi_msg_timeouts: %llu\n", stats.ipi_msg_timeouts);
+    seq_printf(m, "ack_irqs:  %llu\n", (u64)atomic64_read(&stats.ack_irqs));
+    if (ack_irq_enabled && ack_irq_thread)
+        seq_printf(m, "ack_thread: runs %llu, wakeup max %llu ns, prio %d, cpu %d\n",
+                   (u64)atomic64_read(&stats.ack_thread_runs),
+                   READ_ONCE(stats.ack_thread_max_ns), ack_thread_prio, ack_irq_cpu);
+    seq_printf(m, "firmware:  %s\n", rpu_up ? "attached" : "detached");
+    seq_printf(m, "attaches:  %llu\n", stats.attaches);
+    seq_printf(m, "detaches:  %llu\n", stats.detaches);
+    mutex_lock(&trace_mutex);
+    if (trace.active)
+        seq_printf(m, "trace_stream: events %llu, lost %llu, pages %u/%u\n",
+                   trace.events, trace.lost, trace.count, trace.nr);
+    mutex_unlock(&trace_mutex);
+    seq_printf(m, "ring_failed: %llu\n", stats.ring_failed);
+
+    if (stats.acks) {
+        seq_printf(m, "latency_ns min/avg/max: %llu/%llu/%llu\n",
+                   stats.lat_min_ns, div64_u64(stats.lat_sum_ns, stats.acks),
+                   stats.lat_max_ns);
+    }
+
+    seq_puts(m, "histogram (doorbell to ACK, ns):\n");
+    for (i = 0; i < LAT_HIST_BUCKETS; i++) {
+        if (!stats.hist[i])
+            continue;
+        lo = i ? 1ULL << i : 0;
+        seq_printf(m, "  [%11llu, %11llu): %llu\n", lo, 2ULL << i, stats.hist[i]);
+    }
+
+    mutex_unlock(&rpu_ipi_mutex);
+
+    mutex_lock(&bulk_dma_mutex);
+    seq_printf(m, "bulk_dma:  %s\n", bulk_dma_chan ? dma_chan_name(bulk_dma_chan) : "none");
+    seq_printf(m, "bulk_dma copies/bytes/errors: %llu/%llu/%llu\n", bulk_dma_stats.copies,
+               bulk_dma_stats.bytes, bulk_dma_stats.errors);
+    mutex_unlock(&bulk_dma_mutex);
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stats);
+
+/* Any write to "reset" clears the counters and the histogram */
+static ssize_t reset_write(struct file *file, const char __user *buf,
+                           size_t count, loff_t *ppos)
+{
+    mutex_lock(&rpu_ipi_mutex);
+    memset(&stats, 0, sizeof(stats));
+    stats.lat_min_ns = U64_MAX;
+    mutex_unlock(&rpu_ipi_mutex);
+
+    mutex_lock(&bulk_dma_mutex);
+    memset(&bulk_dma_stats, 0, sizeof(bulk_dma_stats));
+    mutex_unlock(&bulk_dma_mutex);
+
+    return count;
+}
+
+static const struct file_operations reset_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .write = reset_write,
+};
+
+/* One line per /dev/rpu_ipi client */
+static int clients_show(struct seq_file *m, void *v)
+{
+    struct rpu_ipi_client *c;
+
+    mutex_lock(&rpu_ring_mutex);
+    seq_printf(m, "ring: head %u reaped %u backlog %u%s\n", ring_head, ring_reaped,
+               ring_backlog, ring_mapper ? " (mapped)" : "");
+    if (ring_credit && rpu_up)
+        seq_printf(m, "credit: limit %u window %u rate %u/s\n",
+                   shm_read(SHM_RING_CREDIT_OFFSET),
+                   shm_read(SHM_RING_CREDIT_OFFSET) - shm_read(SHM_RING_TAIL_OFFSET),
+                   shm_read(SHM_RING_RATE_OFFSET));
+    seq_puts(m, "pid        queued in_flight max completions submitted  completed\n");
+    list_for_each_entry(c, &ring_clients, node) {
+        seq_printf(m, "%-10d %-6u %-9u %-3u %-11u %-10llu %llu\n", c->tgid,
+                   kfifo_len(&c->sq), c->in_flight, c->max_in_flight, kfifo_len(&c->cq),
+                   c->submitted, c->completed);
+    }
+    mutex_unlock(&rpu_ring_mutex);
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(clients);
+
+/* Debugfs is optional; failures are ignored as the debugfs API expects */
+static void rpu_ipi_debugfs_init(void)
+{
+    stats.lat_min_ns = U64_MAX;
+
+    rpu_ipi_debugfs = debugfs_create_dir(MODULE_NAME, NULL);
+    debugfs_create_file("stats", 0444, rpu_ipi_debugfs, NULL, &stats_fops);
+    debugfs_create_file("reset", 0200, rpu_ipi_debugfs, NULL, &reset_fops);
+    debugfs_create_file("clients", 0444, rpu_ipi_debugfs, NULL, &clients_fops);
+}
+
+/*
+ * Register the reverse-IPI handler; rpu_ipi_attach() asks the RPU to raise it
+ */
+static int rpu_ipi_setup_ack_irq(void)
+{
+    int ret;
+
+    if (ack_irq < 0) {
+        pr_info("%s: No ack_irq given, polling for acknowledgments\n", MODULE_NAME);
+        return 0;
+    }
+
+    /* Drop any stale RPU0 request before enabling the source */
+    iowrite32(MASK_CH1_RPU0, ipi_base + IPI_ISR_OFFSET);
+
+    ret = request_threaded_irq(ack_irq, rpu_ipi_ack_isr,
+                               ack_irq_thread ? rpu_ipi_ack_thread : NULL,
+                               IRQF_SHARED, MODULE_NAME, &ack_done);
+    if (ret) {
+        pr_err("%s: Failed to request IRQ %d (%d)\n", MODULE_NAME, ack_irq, ret);
+        return ret;
+    }
+
+    iowrite32(MASK_CH1_RPU0, ipi_base + IPI_IER_OFFSET);
+    mutex_lock(&ack_irq_mutex);
+    ack_irq_enabled = true;
+    ret = ack_irq_set_affinity();
+    mutex_unlock(&ack_irq_mutex);
+    if (ret)
+        pr_warn("%s: IRQ %d not moved to CPU %d (%d)\n", MODULE_NAME, ack_irq, ack_irq_cpu, ret);
+
+    pr_info("%s: Using IRQ %d for RPU acknowledgments%s\n", MODULE_NAME, ack_irq,
+            ack_irq_thread ? " (threaded)" : "");
+    return 0;
+}
+
+/* Move the reverse IPI, and so its thread, to ack_irq_cpu. Caller holds ack_irq_mutex. */
+static int ack_irq_set_affinity(void)
+{
+    if (!ack_irq_enabled || ack_irq_cpu < 0)
+        return 0;
+    return irq_set_affinity(ack_irq, cpumask_of(ack_irq_cpu));
+}
+
+static void rpu_ipi_teardown_ack_irq(void)
+{
+    if (!ack_irq_enabled)
+        return;
+
+    shm_write(SHM_APU_FLAGS_OFFSET, shm_read(SHM_APU_FLAGS_OFFSET) & ~SHM_APU_FLAG_ACK_IRQ);
+    wmb();
+    iowrite32(MASK_CH1_RPU0, ipi_base + IPI_IDR_OFFSET);
+    mutex_lock(&ack_irq_mutex);
+    ack_irq_enabled = false;
+    mutex_unlock(&ack_irq_mutex);
+    free_irq(ack_irq, &ack_done);
+    ack_thread_prio = 0;
+}
+
+/*
+ * The optional memory-region, e.g. the bulk carveout: only its address is
+ * needed, the no-map region is mapped on demand by mmap()
+ */
+static void rpu_ipi_region_init(struct device *dev)
+{
+    struct device_node *np;
+    int ret;
+
+    memset(&region_res, 0, sizeof(region_res));
+    np = dev->of_node ? of_parse_phandle(dev->of_node, "memory-region", 0) : NULL;
+    if (!np)
+        return;
+
+    ret = of_address_to_resource(np, 0, &region_res);
+    of_node_put(np);
+    if (ret) {
+        pr_warn("%s: Ignoring unusable memory-region (%d)\n", MODULE_NAME, ret);
+        memset(&region_res, 0, sizeof(region_res));
+        return;
+    }
+    pr_info("%s: memory-region %pR at mmap offset 0x%X\n", MODULE_NAME, &region_res,
+            RPU_IPI_MMAP_REGION_OFFSET);
+}
+
+/*
+ * Map shared memory region with non-cached protection for cache coherency.
+ * The window cannot be cached coherently: RPU accesses to the LPD memories
+ * do not go through the CCI (rpu_shm.h). Write-combining keeps it
+ * uncached but lets the interconnect merge and burst accesses. Every
+ * publish is already ordered by wmb()/rmb().
+ */
+static void __iomem *rpu_ipi_map_shm(phys_addr_t phys)
+{
+    void __iomem *base;
+
+    if (shm_wc)
+        base = ioremap_wc(phys, SHARED_MEM_SIZE);
+    else
+        base = ioremap_prot(phys, SHARED_MEM_SIZE,
+                            pgprot_val(pgprot_noncached(PAGE_KERNEL)));
+    if (!base) {
+        /* Fallback to regular ioremap */
+        pr_info("%s: Failed to map shared memory at %pa with non-cached protection, falling back to regular ioremap\n", MODULE_NAME, &phys);
+        base = ioremap(phys, SHARED_MEM_SIZE);
+        if (!base)
+            pr_err("%s: Failed to map shared memory at %pa\n", MODULE_NAME, &phys);
+    }
+    return base;
+}
+
+/* Back to the default window, which holds the IPI message buffers */
+static void rpu_ipi_release_window(void)
+{
+    if (shared_mem_base && shared_mem_base != msg_mem_base)
+        iounmap(shared_mem_base);
+    shared_mem_base = msg_mem_base;
+    shm_phys = msg_phys;
+}
+
+/*
+ * Map the window the firmware publishes: its BTCM when it redirects there
+ * (TCM variant, rpu_shm.h), the default window otherwise
+ */
+static int rpu_ipi_select_window(void)
+{
+    phys_addr_t phys = msg_phys;
+    void __iomem *base;
+
+    if (msg_read(SHM_REDIRECT_MAGIC_OFFSET) == SHM_REDIRECT_MAGIC &&
+        msg_read(SHM_REDIRECT_ADDR_OFFSET) == SHARED_MEM_TCM_ADDR_CORE(0))
+        phys = SHARED_MEM_TCM_ADDR_CORE(0);
+    if (phys == shm_phys)
+        return 0;
+
+    rpu_ipi_release_window();
+    if (phys == msg_phys)
+        return 0;
+    base = rpu_ipi_map_shm(phys);
+    if (!base)
+        return -ENOMEM;
+    shared_mem_base = base;
+    shm_phys = phys;
+    pr_info("%s: Shared window in RPU0 TCM at %pa\n", MODULE_NAME, &shm_phys);
+    return 0;
+}
+
+static void rpu_ipi_unmap_shm(void)
+{
+    rpu_ipi_release_window();
+    iounmap(msg_mem_base);
+    shared_mem_base = NULL;
+    msg_mem_base = NULL;
+}
+
+/*
+ * Attach to the running firmware: its window, and the sequence numbers and
+ * ring indices where it starts, then send what was queued meanwhile
+ */
+static void rpu_ipi_attach(void)
+{
+    int ret;
+
+    mutex_lock(&rpu_ipi_mutex);
+    mutex_lock(&rpu_ring_mutex);
+
+    ret = rpu_ipi_select_window();
+    if (ret) {
+        pr_err("%s: Cannot map the firmware's window (%d), staying detached\n",
+               MODULE_NAME, ret);
+        goto out;
+    }
+
+    /* Continue the sequence where the previous sender stopped */
+    rpu_seq = shm_read(SHM_SEQ_OFFSET);
+    msg_seq = RPU_MSG_HDR_SEQ(msg_read(SHM_IPI_REQ_OFFSET));
+    ring_head = shm_read(SHM_RING_HEAD_OFFSET);
+    ring_reaped = ring_head;
+    ring_credit = shm_read(SHM_ABI_MAGIC_OFFSET) == SHM_ABI_MAGIC &&
+                  (shm_read(SHM_ABI_FEATURES_OFFSET) & SHM_FEAT_CREDIT);
+
+    /* A new image, or another window, has not seen the flag yet */
+    if (ack_irq_enabled) {
+        shm_write(SHM_APU_FLAGS_OFFSET, shm_read(SHM_APU_FLAGS_OFFSET) | SHM_APU_FLAG_ACK_IRQ);
+        wmb();
+    }
+
+    WRITE_ONCE(rpu_up, true);
+    stats.attaches++;
+    /* The trace stream goes on at the oldest event of this image */
+    trace.synced = false;
+    ring_dispatch();
+out:
+    mutex_unlock(&rpu_ring_mutex);
+    mutex_unlock(&rpu_ipi_mutex);
+
+    wake_up(&rpu_up_wq);
+    wake_up_interruptible(&ring_wq);
+}
+
+/*
+ * Detach before the core stops, while its window is still accessible: the
+ * commands it has not consumed fail, and the TCM window is given up
+ */
+static void rpu_ipi_detach(bool crashed)
+{
+    u32 failed = 0;
+
+    /* Waiters holding the mutexes give up at once instead of timing out */
+    WRITE_ONCE(rpu_up, false);
+    complete(&ack_done);
+    wake_up_interruptible(&ring_wq);
+
+    mutex_lock(&rpu_ipi_mutex);
+    mutex_lock(&rpu_ring_mutex);
+    if (!ring_mapper) {
+        failed = ring_head - ring_reaped;
+        ring_reap_slots(failed);
+    }
+    rpu_ipi_release_window();
+    stats.detaches++;
+    stats.ring_failed += failed;
+    mutex_unlock(&rpu_ring_mutex);
+    mutex_unlock(&rpu_ipi_mutex);
+
+    /* Clients blocked on completions read the failed ones */
+    wake_up_interruptible(&ring_wq);
+
+    pr_info("%s: RPU0 %s, channel detached (%u ring commands failed)\n", MODULE_NAME,
+            crashed ? "crashed" : "stopping", failed);
+}
+
+/*
+ * Attach once the started image publishes its ready word, or without it
+ * after attach_timeout_ms (firmware that predates the word)
+ */
+static void attach_work_fn(struct work_struct *work)
+{
+    bool ready = msg_read(SHM_READY_OFFSET) == SHM_READY_MAGIC;
+    u32 version;
+
+    if (!ready && time_before(jiffies, READ_ONCE(attach_deadline))) {
+        schedule_delayed_work(&attach_work, msecs_to_jiffies(ATTACH_POLL_MS));
+        return;
+    }
+
+    rmb();
+    version = msg_read(SHM_READY_VERSION_OFFSET);
+    rpu_ipi_attach();
+    if (ready)
+        pr_info("%s: RPU0 firmware ready (ABI %u.%u, features 0x%x), channel attached\n",
+                MODULE_NAME, SHM_ABI_VERSION_MAJOR(version), version & 0xFFFF,
+                msg_read(SHM_READY_FEATURES_OFFSET));
+    else
+        pr_warn("%s: RPU0 firmware not ready after %u ms, channel attached anyway\n",
+                MODULE_NAME, READ_ONCE(attach_timeout_ms));
+}
+
+/*
+ * Remoteproc subdevice of RPU0: called under the rproc lock around the
+ * core's start and stop
+ */
+static int rpu_ipi_rproc_prepare(struct rproc_subdev *subdev)
+{
+    /* The image loaded but not started; the previous one's word must not count */
+    msg_write(SHM_READY_OFFSET, 0);
+    wmb();
+    return 0;
+}
+
+static int rpu_ipi_rproc_start(struct rproc_subdev *subdev)
+{
+    /* The core left reset; its firmware has its setup to run first */
+    WRITE_ONCE(attach_deadline, jiffies + msecs_to_jiffies(READ_ONCE(attach_timeout_ms)));
+    mod_delayed_work(system_wq, &attach_work, 0);
+    return 0;
+}
+
+static void rpu_ipi_rproc_stop(struct rproc_subdev *subdev, bool crashed)
+{
+    cancel_delayed_work_sync(&attach_work);
+    rpu_ipi_detach(crashed);
+}
+
+/*
+ * Follow the firmware through the remoteproc of the "rproc" phandle; without
+ * one, attach now. The state is read under the rproc lock together with the
+ * subdevice registration, so no start or stop falls in between.
+ */
+static int rpu_ipi_rproc_init(struct device *dev)
+{
+    bool running;
+    u32 ph;
+
+    if (!dev->of_node || of_property_read_u32(dev->of_node, "rproc", &ph)) {
+        rpu_ipi_attach();
+        return 0;
+    }
+
+    rpu_rproc = rproc_get_by_phandle(ph);
+    if (!rpu_rproc)
+        return -EPROBE_DEFER;
+
+    rpu_subdev.prepare = rpu_ipi_rproc_prepare;
+    rpu_subdev.start = rpu_ipi_rproc_start;
+    rpu_subdev.stop = rpu_ipi_rproc_stop;
+
+    mutex_lock(&rpu_rproc->lock);
+    rproc_add_subdev(rpu_rproc, &rpu_subdev);
+    running = rpu_rproc->state == RPROC_RUNNING || rpu_rproc->state == RPROC_ATTACHED;
+    if (running)
+        rpu_ipi_attach();
+    mutex_unlock(&rpu_rproc->lock);
+
+    pr_info("%s: Following %s, firmware %s\n", MODULE_NAME, rpu_rproc->name,
+            running ? "running" : "not running");
+    return 0;
+}
+
+static void rpu_ipi_rproc_exit(void)
+{
+    if (!rpu_rproc)
+        return;
+
+    mutex_lock(&rpu_rproc->lock);
+    rproc_remove_subdev(rpu_rproc, &rpu_subdev);
+    mutex_unlock(&rpu_rproc->lock);
+    cancel_delayed_work_sync(&attach_work);
+    rproc_put(rpu_rproc);
+    rpu_rproc = NULL;
+}
+
+/*
+ * Bind to the device tree node, or to the fallback device of the module
+ */
+static int rpu_ipi_probe(struct platform_device *pdev)
+{
+    struct resource *ipi_res, *shm_res;
+    int irq;
+    int ret;
+
+    if (rpu_ipi_bound) {
+        pr_err("%s: Only one RPU IPI channel is supported\n", MODULE_NAME);
+        return -EBUSY;
+    }
+
+    pr_info("%s: Initializing RPU IPI module v%s\n", MODULE_NAME, MODULE_VERSION_STR);
+
+    ipi_res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+    shm_res = platform_get_resource(pdev, IORESOURCE_MEM, 1);
+    if (!ipi_res || resource_size(ipi_res) < IPI_SIZE ||
+        !shm_res || resource_size(shm_res) < SHARED_MEM_SIZE) {
+        pr_err("%s: Need the IPI registers (reg 0) and the shared window (reg 1)\n", MODULE_NAME);
+        return -EINVAL;
+    }
+    msg_phys = shm_res->start;
+    shm_phys = msg_phys;
+
+    /* The parameter wins; otherwise the DT interrupt, and it reads back */
+    if (ack_irq < 0) {
+        irq = platform_get_irq_optional(pdev, 0);
+        if (irq == -EPROBE_DEFER)
+            return irq;
+        if (irq > 0)
+            ack_irq = irq;
+    }
+
+    msg_mem_base = rpu_ipi_map_shm(msg_phys);
+    if (!msg_mem_base)
+        return -ENOMEM;
+    shared_mem_base = msg_mem_base;
+    rpu_up = false;
+
+    /* Map IPI register region */
+    ipi_base = ioremap(ipi_res->start, IPI_SIZE);
+    if (!ipi_base) {
+        pr_err("%s: Failed to map IPI registers at %pR\n", MODULE_NAME, ipi_res);
+        ret = -ENOMEM;
+        goto err_unmap_shm;
+    }
+
+    rpu_ipi_region_init(&pdev->dev);
+    rpu_ipi_dev = &pdev->dev;
+
+    ret = rpu_ipi_setup_ack_irq();
+    if (ret)
+        goto err_unmap_ipi;
+
+    /* Ordered so asynchronous submissions reach the RPU in submission order */
+    rpu_ipi_wq = alloc_ordered_workqueue(MODULE_NAME, 0);
+    if (!rpu_ipi_wq) {
+        ret = -ENOMEM;
+        goto err_free_irq;
+    }
+
+    /* Create sysfs interface */
+    rpu_ipi_kobj = kobject_create_and_add("rpu_ipi", kernel_kobj);
+    if (!rpu_ipi_kobj) {
+        pr_err("%s: Failed to create sysfs kobject\n", MODULE_NAME);
+        ret = -ENOMEM;
+        goto err_destroy_wq;
+    }
+
+    ret = sysfs_create_group(rpu_ipi_kobj, &rpu_ipi_attr_group);
+    if (ret) {
+        pr_err("%s: Failed to create sysfs attributes\n", MODULE_NAME);
+        goto err_put_kobj;
+    }
+
+    /* Create /dev/rpu_ipi for binary command batches */
+    ret = misc_register(&rpu_ipi_miscdev);
+    if (ret) {
+        pr_err("%s: Failed to register /dev/%s\n", MODULE_NAME, RPU_IPI_DEV_NAME);
+        goto err_remove_group;
+    }
+
+    /* And /dev/rpu_trace for the event trace */
+    ret = misc_register(&rpu_trace_miscdev);
+    if (ret) {
+        pr_err("%s: Failed to register /dev/%s\n", MODULE_NAME, RPU_TRACE_DEV_NAME);
+        goto err_deregister_ipi;
+    }
+
+    rpu_ipi_debugfs_init();
+
+    /* Last: the subdevice may attach from here on */
+    ret = rpu_ipi_rproc_init(&pdev->dev);
+    if (ret)
+        goto err_remove_debugfs;
+
+    rpu_ipi_bound = true;
+    pr_info("%s: Module loaded successfully\n", MODULE_NAME);
+
+    return 0;
+
+err_remove_debugfs:
+    debugfs_remove_recursive(rpu_ipi_debugfs);
+    misc_deregister(&rpu_trace_miscdev);
+err_deregister_ipi:
+    misc_deregister(&rpu_ipi_miscdev);
+err_remove_group:
+    sysfs_remove_group(rpu_ipi_kobj, &rpu_ipi_attr_group);
+err_put_kobj:
+    kobject_put(rpu_ipi_kobj);
+err_destroy_wq:
+    destroy_workqueue(rpu_ipi_wq);
+err_free_irq:
+    rpu_ipi_teardown_ack_irq();
+err_unmap_ipi:
+    iounmap(ipi_base);
+err_unmap_shm:
+    rpu_ipi_unmap_shm();
+    ipi_base = NULL;
+    return ret;
+}
+
+/*
+ * Unbind
+ */
+static void rpu_ipi_remove(struct platform_device *pdev)
+{
+    pr_info("%s: Unloading module\n", MODULE_NAME);
+
+    /* No attach or detach from here on */
+    rpu_ipi_rproc_exit();
+
+    debugfs_remove_recursive(rpu_ipi_debugfs);
+
+    misc_deregister(&rpu_trace_miscdev);
+    cancel_delayed_work_sync(&trace_work);
+    misc_deregister(&rpu_ipi_miscdev);
+    cancel_delayed_work_sync(&ring_poll_work);
+
+    mutex_lock(&bulk_dma_mutex);
+    if (bulk_dma_chan)
+        dma_release_channel(bulk_dma_chan);
+    bulk_dma_chan = NULL;
+    rpu_ipi_dev = NULL;
+    mutex_unlock(&bulk_dma_mutex);
+
+    sysfs_remove_group(rpu_ipi_kobj, &rpu_ipi_attr_group);
+
+    /* Pending asynchronous submissions are sent before the IRQ goes away */
+    destroy_workqueue(rpu_ipi_wq);
+    if (async_overflows)
+        pr_info("%s: %u asynchronous completions were dropped unread\n",
+                MODULE_NAME, async_overflows);
+
+    kobject_put(rpu_ipi_kobj);
+
+    rpu_ipi_teardown_ack_irq();
+
+    iounmap(ipi_base);
+    rpu_ipi_unmap_shm();
+    rpu_ipi_bound = false;
+
+    pr_info("%s: Module unloaded\n", MODULE_NAME);
+}
+
+static const struct of_device_id rpu_ipi_of_match[] = {
+    { .compatible = RPU_IPI_COMPATIBLE },
+    { }
+};
+MODULE_DEVICE_TABLE(of, rpu_ipi_of_match);
+
+static struct platform_driver rpu_ipi_driver = {
+    .probe = rpu_ipi_probe,
+    .remove = rpu_ipi_remove,
+    .driver = {
+        .name = MODULE_NAME,
+        .of_match_table = rpu_ipi_of_match,
+    },
+};
+
+/*
+ * Module initialization: without a device tree node, create the device with
+ * the fixed addresses so "insmod rpu_ipi.ko ack_irq=<n>" keeps working
+ */
+static int __init rpu_ipi_init(void)
+{
+    static const struct resource fallback_res[] = {
+        DEFINE_RES_MEM(IPI_APU_BASE, IPI_SIZE),
+        DEFINE_RES_MEM(SHARED_MEM_ADDR, SHARED_MEM_SIZE),
+    };
+    struct device_node *np;
+    int ret;
+
+    ret = platform_driver_register(&rpu_ipi_driver);
+    if (ret)
+        return ret;
+
+    np = of_find_compatible_node(NULL, NULL, RPU_IPI_COMPATIBLE);
+    if (np) {
+        of_node_put(np);
+        return 0;
+    }
+
+    rpu_ipi_fallback_pdev = platform_device_register_simple(MODULE_NAME, PLATFORM_DEVID_NONE,
+                                                            fallback_res,
+                                                            ARRAY_SIZE(fallback_res));
+    if (IS_ERR(rpu_ipi_fallback_pdev)) {
+        ret = PTR_ERR(rpu_ipi_fallback_pdev);
+        platform_driver_unregister(&rpu_ipi_driver);
+        return ret;
+    }
+    if (!rpu_ipi_bound) {
+        /* The probe failed; its error is in the log */
+        platform_device_unregister(rpu_ipi_fallback_pdev);
+        platform_driver_unregister(&rpu_ipi_driver);
+        return -ENODEV;
+    }
+    return 0;
+}
+
+static void __exit rpu_ipi_exit(void)
+{
+    if (rpu_ipi_fallback_pdev)
+        platform_device_unregister(rpu_ipi_fallback_pdev);
+    platform_driver_unregister(&rpu_ipi_driver);
 }
 
 module_init(rpu_ipi_init);
@@ -0,0 +1,217 @@
+/*
+ * Tracepoints of the rpu_ipi module (system "rpu_ipi").
+ *
+ * Every path to the RPU records the doorbell and its outcome, so IPI
+ * latency can be broken down next to the scheduler events of the A53:
+ *
+ *   trace-cmd record -e rpu_ipi -e sched:sched_switch -e sched:sched_wakeup
+ *   perf trace -e 'rpu_ipi:*'
+ *
+ * Legacy commands emit cmd_send, doorbell and then cmd_ack or cmd_timeout,
+ * IPI messages msg_send, doorbell and msg_done (or cmd_timeout), and the
+ * ring ring_dispatch (with a doorbell unless the RPU polls) and one
+ * ring_complete per descriptor handed back. ack_irq marks each reverse IPI.
+ * Latencies are doorbell to observed echo, in ns. cmd_send, doorbell,
+ * ack_irq and cmd_ack also carry cnt, the system counter (CNTVCT) the RPU
+ * stamps its trace with, so the APU's rpu_e2e tool can put them on one time
+ * line with the firmware's events whatever the trace clock.
+ */
+
+#ifndef _RPU_IPI_TRACE_COUNTER
+#define _RPU_IPI_TRACE_COUNTER
+#ifdef CONFIG_ARM_ARCH_TIMER
+#include <clocksource/arm_arch_timer.h>
+static inline u64 rpu_ipi_trace_counter(void) { return arch_timer_read_counter(); }
+#else
+static inline u64 rpu_ipi_trace_counter(void) { return 0; }
+#endif
+#endif /* _RPU_IPI_TRACE_COUNTER */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rpu_ipi
+
+#if !defined(_RPU_IPI_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _RPU_IPI_TRACE_H
+
+#include <linux/tracepoint.h>
+
+/* Doorbell sources */
+#define RPU_IPI_DB_CMD   0  /* Legacy CMD/ACK words */
+#define RPU_IPI_DB_MSG   1  /* IPI message buffer */
+#define RPU_IPI_DB_RING  2  /* Ring, produced by the module */
+#define RPU_IPI_DB_USER  3  /* RPU_IPI_IOC_DOORBELL of a mapping producer */
+
+#define show_doorbell_source(src)                       \
+    __print_symbolic(src,                               \
+                     { RPU_IPI_DB_CMD,  "cmd" },        \
+                     { RPU_IPI_DB_MSG,  "msg" },        \
+                     { RPU_IPI_DB_RING, "ring" },       \
+                     { RPU_IPI_DB_USER, "user" })
+
+TRACE_EVENT(rpu_ipi_cmd_send,
+    TP_PROTO(u32 seq, int mode),
+    TP_ARGS(seq, mode),
+    TP_STRUCT__entry(
+        __field(u32, seq)
+        __field(int, mode)
+        __field(u64, cnt)
+    ),
+    TP_fast_assign(
+        __entry->seq = seq;
+        __entry->mode = mode;
+        __entry->cnt = rpu_ipi_trace_counter();
+    ),
+    TP_printk("seq=%u mode=%d cnt=%llu", __entry->seq, __entry->mode, __entry->cnt)
+);
+
+TRACE_EVENT(rpu_ipi_cmd_ack,
+    TP_PROTO(u32 seq, u32 ack, bool valid, u64 latency_ns),
+    TP_ARGS(seq, ack, valid, latency_ns),
+    TP_STRUCT__entry(
+        __field(u32, seq)
+        __field(u32, ack)
+        __field(bool, valid)
+        __field(u64, latency_ns)
+        __field(u64, cnt)
+    ),
+    TP_fast_assign(
+        __entry->seq = seq;
+        __entry->ack = ack;
+        __entry->valid = valid;
+        __entry->latency_ns = latency_ns;
+        __entry->cnt = rpu_ipi_trace_counter();
+    ),
+    TP_printk("seq=%u ack=0x%08x%s latency_ns=%llu cnt=%llu", __entry->seq, __entry->ack,
+              __entry->valid ? "" : " (mismatch)", __entry->latency_ns, __entry->cnt)
+);
+
+TRACE_EVENT(rpu_ipi_cmd_timeout,
+    TP_PROTO(unsigned int source, u32 seq, u32 echo, unsigned int timeout_ms),
+    TP_ARGS(source, seq, echo, timeout_ms),
+    TP_STRUCT__entry(
+        __field(unsigned int, source)
+        __field(u32, seq)
+        __field(u32, echo)
+        __field(unsigned int, timeout_ms)
+    ),
+    TP_fast_assign(
+        __entry->source = source;
+        __entry->seq = seq;
+        __entry->echo = echo;
+        __entry->timeout_ms = timeout_ms;
+    ),
+    TP_printk("%s seq=%u echo=0x%x timeout_ms=%u", show_doorbell_source(__entry->source),
+              __entry->seq, __entry->echo, __entry->timeout_ms)
+);
+
+TRACE_EVENT(rpu_ipi_msg_send,
+    TP_PROTO(u32 opcode, u32 len, u32 seq),
+    TP_ARGS(opcode, len, seq),
+    TP_STRUCT__entry(
+        __field(u32, opcode)
+        __field(u32, len)
+        __field(u32, seq)
+    ),
+    TP_fast_assign(
+        __entry->opcode = opcode;
+        __entry->len = len;
+        __entry->seq = seq;
+    ),
+    TP_printk("opcode=%u len=%u seq=%u", __entry->opcode, __entry->len, __entry->seq)
+);
+
+TRACE_EVENT(rpu_ipi_msg_done,
+    TP_PROTO(u32 opcode, u32 seq, u32 status, u64 latency_ns),
+    TP_ARGS(opcode, seq, status, latency_ns),
+    TP_STRUCT__entry(
+        __field(u32, opcode)
+        __field(u32, seq)
+        __field(u32, status)
+        __field(u64, latency_ns)
+    ),
+    TP_fast_assign(
+        __entry->opcode = opcode;
+        __entry->seq = seq;
+        __entry->status = status;
+        __entry->latency_ns = latency_ns;
+    ),
+    TP_printk("opcode=%u seq=%u status=%u latency_ns=%llu", __entry->opcode,
+              __entry->seq, __entry->status, __entry->latency_ns)
+);
+
+TRACE_EVENT(rpu_ipi_doorbell,
+    TP_PROTO(unsigned int source),
+    TP_ARGS(source),
+    TP_STRUCT__entry(
+        __field(unsigned int, source)
+        __field(u64, cnt)
+    ),
+    TP_fast_assign(
+        __entry->source = source;
+        __entry->cnt = rpu_ipi_trace_counter();
+    ),
+    TP_printk("%s cnt=%llu", show_doorbell_source(__entry->source), __entry->cnt)
+);
+
+TRACE_EVENT(rpu_ipi_ack_irq,
+    TP_PROTO(u32 isr),
+    TP_ARGS(isr),
+    TP_STRUCT__entry(
+        __field(u32, isr)
+        __field(u64, cnt)
+    ),
+    TP_fast_assign(
+        __entry->isr = isr;
+        __entry->cnt = rpu_ipi_trace_counter();
+    ),
+    TP_printk("isr=0x%08x cnt=%llu", __entry->isr, __entry->cnt)
+);
+
+TRACE_EVENT(rpu_ipi_ring_dispatch,
+    TP_PROTO(u32 head, u32 count, u32 backlog, bool doorbell),
+    TP_ARGS(head, count, backlog, doorbell),
+    TP_STRUCT__entry(
+        __field(u32, head)
+        __field(u32, count)
+        __field(u32, backlog)
+        __field(bool, doorbell)
+    ),
+    TP_fast_assign(
+        __entry->head = head;
+        __entry->count = count;
+        __entry->backlog = backlog;
+        __entry->doorbell = doorbell;
+    ),
+    TP_printk("head=%u count=%u backlog=%u doorbell=%d", __entry->head, __entry->count,
+              __entry->backlog, __entry->doorbell)
+);
+
+TRACE_EVENT(rpu_ipi_ring_complete,
+    TP_PROTO(pid_t tgid, u32 idx, u32 opcode, u32 seq, u32 status),
+    TP_ARGS(tgid, idx, opcode, seq, status),
+    TP_STRUCT__entry(
+        __field(pid_t, tgid)
+        __field(u32, idx)
+        __field(u32, opcode)
+        __field(u32, seq)
+        __field(u32, status)
+    ),
+    TP_fast_assign(
+        __entry->tgid = tgid;
+        __entry->idx = idx;
+        __entry->opcode = opcode;
+        __entry->seq = seq;
+        __entry->status = status;
+    ),
+    TP_printk("client=%d idx=%u opcode=%u seq=%u status=%u", __entry->tgid, __entry->idx,
+              __entry->opcode, __entry->seq, __entry->status)
+);
+
+#endif /* _RPU_IPI_TRACE_H */
+
+/* Outside the guard: define_trace.h includes this file again */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE rpu_ipi_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,43 @@
+#!/usr/bin/python
+#
+# FILE:
+#   pattern_out_regs.py
+#
+# DESCRIPTION:
+#   Register map of pattern_out (myhdl/PL/MyHDL/src/pattern_out/pattern_out.py),
+#   GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py,
+#   do not edit. PATTERN_OUT_<REG> is the 32-bit register index,
+#   PATTERN_OUT_<REG>_OFFSET the byte offset.
+#
+
+# Register indices
+PATTERN_OUT_CTRL = 0
+PATTERN_OUT_DIVIDER = 1  # Sample period in clock cycles
+PATTERN_OUT_STATUS = 2
+PATTERN_OUT_ISR = 3  # Write 1 to clear
+PATTERN_OUT_IER = 4
+PATTERN_OUT_COUNT = 5  # Samples output since ENABLE was set
+PATTERN_OUT_UNDERRUNS = 6  # Ticks without a sample
+# Register byte offsets
+PATTERN_OUT_CTRL_OFFSET = 0x00
+PATTERN_OUT_DIVIDER_OFFSET = 0x04
+PATTERN_OUT_STATUS_OFFSET = 0x08
+PATTERN_OUT_ISR_OFFSET = 0x0C
+PATTERN_OUT_IER_OFFSET = 0x10
+PATTERN_OUT_COUNT_OFFSET = 0x14
+PATTERN_OUT_UNDERRUNS_OFFSET = 0x18
+# Register bit fields
+PATTERN_OUT_CTRL_ENABLE_B = 0
+PATTERN_OUT_CTRL_ENABLE_W = 1
+PATTERN_OUT_STATUS_RUNNING_B = 0
+PATTERN_OUT_STATUS_RUNNING_W = 1
+PATTERN_OUT_STATUS_TVALID_B = 1
+PATTERN_OUT_STATUS_TVALID_W = 1
+PATTERN_OUT_ISR_DONE_B = 0
+PATTERN_OUT_ISR_DONE_W = 1
+PATTERN_OUT_ISR_UNDERRUN_B = 1
+PATTERN_OUT_ISR_UNDERRUN_W = 1
+PATTERN_OUT_IER_DONE_B = 0
+PATTERN_OUT_IER_DONE_W = 1
+PATTERN_OUT_IER_UNDERRUN_B = 1
+PATTERN_OUT_IER_UNDERRUN_W = 1
@@ -0,0 +1,29 @@
+# Lean crossbar variant of the gpio_led block design
+#
+# Replaces the SmartConnect between the PS (M_AXI_HPM0_LPD) and the AXI-Lite
+# blocks with an AXI Interconnect in its shared-address, shared-data mode,
+# without register slices (build_utils/axi_xbar.tcl): fewer PL clocks per
+# single-beat register access from the APU and the RPU. Masters, slaves and
+# the address map stay as they are, so the software is unchanged.
+#
+# Run it on the default design or after the other variants; pattern_out_bd.tcl
+# and pwm_seq_bd.tcl add their slaves to axi_smc, so run it after them (the
+# DMA data path of the pattern output keeps its own SmartConnect, axi_smc_hp).
+#
+# Usage, from gpio_led/PL:
+#   make axi_xbar_bd         (or: vivado -mode batch -source axi_xbar_bd.tcl)
+# The variant goes into a copy of the project (build_utils/bd_variant.tcl);
+# build that copy with PL_VARIANT=ON.
+
+set script_dir [file dirname [file normalize [info script]]]
+set project_file "$script_dir/gpio_led/gpio_led.xpr"
+source [file normalize "$script_dir/../../build_utils/bd_variant.tcl"]
+source [file normalize "$script_dir/../../build_utils/axi_xbar.tcl"]
+
+open_bd_variant $project_file gpio_led.bd
+
+set num_mi [get_property CONFIG.NUM_MI [get_bd_cells axi_smc]]
+replace_smartconnect axi_smc axi_xbar
+
+save_bd_variant
+puts "gpio_led.bd: lean crossbar variant (axi_xbar in place of axi_smc, $num_mi slave(s))"
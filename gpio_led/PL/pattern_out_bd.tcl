@@ -0,0 +1,107 @@
+# Pattern output variant of the gpio_led block design
+#
+# Adds a DMA-fed pattern generator in front of the LED pins:
+#   PS HP0 <- AXI DMA (MM2S) -> AXI4-Stream FIFO -> pattern_out_0 -> led_output_tri_o
+# pattern_out_0 (myhdl/PL/MyHDL/src/pattern_out) outputs one stream sample
+# every DIVIDER clocks of pl_clk0; while it is disabled the pins follow the
+# AXI GPIO channel 1 as before, so the existing firmware keeps working.
+# The external port keeps its name, so gpio_led.xdc applies unchanged.
+#
+# Usage (after 'make build' in myhdl/), from gpio_led/PL:
+#   make pattern_out_bd      (or: vivado -mode batch -source pattern_out_bd.tcl)
+# The variant goes into a copy of the project (build_utils/bd_variant.tcl);
+# build that copy with PL_VARIANT=ON.
+
+set script_dir [file dirname [file normalize [info script]]]
+set verilog_file [file normalize "$script_dir/../../myhdl/build/pattern_out_ip.v"]
+set project_file "$script_dir/gpio_led/gpio_led.xpr"
+source [file normalize "$script_dir/../../build_utils/bd_variant.tcl"]
+
+if {![file exists $verilog_file]} {
+    error "$verilog_file not found: run 'make build' in myhdl/ first"
+}
+
+open_bd_variant $project_file gpio_led.bd
+add_files -norecurse $verilog_file
+update_compile_order -fileset sources_1
+
+# PS: 128-bit HP0 slave port for the DMA reads
+set_property -dict [list \
+    CONFIG.PSU__USE__S_AXI_GP2 {1} \
+    CONFIG.PSU__SAXIGP2__DATA_WIDTH {128} \
+] [get_bd_cells zynq_ultra_ps_e_0]
+
+# AXI DMA, simple mode, MM2S only
+set axi_dma_0 [create_bd_cell -type ip -vlnv xilinx.com:ip:axi_dma:7.1 axi_dma_0]
+set_property -dict [list \
+    CONFIG.c_include_sg {0} \
+    CONFIG.c_include_s2mm {0} \
+    CONFIG.c_sg_length_width {26} \
+    CONFIG.c_m_axi_mm2s_data_width {128} \
+    CONFIG.c_m_axis_mm2s_tdata_width {32} \
+    CONFIG.c_mm2s_burst_size {64} \
+    CONFIG.c_addr_width {40} \
+] $axi_dma_0
+
+# FIFO between the DMA and the pattern generator: absorbs DDR latency
+set axis_fifo_0 [create_bd_cell -type ip -vlnv xilinx.com:ip:axis_data_fifo:2.0 axis_data_fifo_0]
+set_property -dict [list CONFIG.FIFO_DEPTH {4096}] $axis_fifo_0
+
+# Pattern generator (MyHDL module reference)
+set pattern_out_0 [create_bd_cell -type module -reference pattern_out_ip pattern_out_0]
+set_property CONFIG.ASSOCIATED_BUSIF {s00_axi:s00_axis} [get_bd_pins pattern_out_0/clk]
+set_property CONFIG.ASSOCIATED_RESET {resetn} [get_bd_pins pattern_out_0/clk]
+
+# Control: two more masters on the existing SmartConnect
+set_property CONFIG.NUM_MI {3} [get_bd_cells axi_smc]
+connect_bd_intf_net [get_bd_intf_pins axi_smc/M01_AXI] [get_bd_intf_pins axi_dma_0/S_AXI_LITE]
+connect_bd_intf_net [get_bd_intf_pins axi_smc/M02_AXI] [get_bd_intf_pins pattern_out_0/s00_axi]
+
+# Data: DMA -> HP0 through its own SmartConnect, DMA -> FIFO -> pattern_out_0
+set axi_smc_hp [create_bd_cell -type ip -vlnv xilinx.com:ip:smartconnect:1.0 axi_smc_hp]
+set_property -dict [list CONFIG.NUM_SI {1} CONFIG.NUM_MI {1}] $axi_smc_hp
+connect_bd_intf_net [get_bd_intf_pins axi_dma_0/M_AXI_MM2S] [get_bd_intf_pins axi_smc_hp/S00_AXI]
+connect_bd_intf_net [get_bd_intf_pins axi_smc_hp/M00_AXI] [get_bd_intf_pins zynq_ultra_ps_e_0/S_AXI_HP0_FPD]
+connect_bd_intf_net [get_bd_intf_pins axi_dma_0/M_AXIS_MM2S] [get_bd_intf_pins axis_data_fifo_0/S_AXIS]
+connect_bd_intf_net [get_bd_intf_pins axis_data_fifo_0/M_AXIS] [get_bd_intf_pins pattern_out_0/s00_axis]
+
+# Everything on pl_clk0 and the peripheral reset
+set clk_pins [list \
+    axi_dma_0/s_axi_lite_aclk axi_dma_0/m_axi_mm2s_aclk \
+    axis_data_fifo_0/s_axis_aclk pattern_out_0/clk axi_smc_hp/aclk \
+    zynq_ultra_ps_e_0/saxihp0_fpd_aclk]
+foreach pin $clk_pins {
+    connect_bd_net [get_bd_pins zynq_ultra_ps_e_0/pl_clk0] [get_bd_pins $pin]
+}
+set rst_pins [list \
+    axi_dma_0/axi_resetn axis_data_fifo_0/s_axis_aresetn \
+    pattern_out_0/resetn axi_smc_hp/aresetn]
+foreach pin $rst_pins {
+    connect_bd_net [get_bd_pins rst_ps8_0_99M/peripheral_aresetn] [get_bd_pins $pin]
+}
+
+# LED pins: AXI GPIO channel 1 -> pattern_out_0/gpio_in, pattern_out_0 -> pins
+delete_bd_objs [get_bd_intf_nets axi_gpio_0_GPIO] [get_bd_intf_ports led_output]
+create_bd_port -dir O -from 1 -to 0 led_output_tri_o
+connect_bd_net [get_bd_pins axi_gpio_0/gpio_io_o] [get_bd_pins pattern_out_0/gpio_in]
+connect_bd_net [get_bd_pins pattern_out_0/pattern_o] [get_bd_ports led_output_tri_o]
+
+# Interrupts: pl_ps_irq0[0] AXI GPIO (121), [1] DMA MM2S (122), [2] pattern_out_0 (123)
+delete_bd_objs [get_bd_nets axi_gpio_0_ip2intc_irpt]
+set irq_concat [create_bd_cell -type ip -vlnv xilinx.com:ip:xlconcat:2.1 irq_concat]
+set_property CONFIG.NUM_PORTS {3} $irq_concat
+connect_bd_net [get_bd_pins axi_gpio_0/ip2intc_irpt] [get_bd_pins irq_concat/In0]
+connect_bd_net [get_bd_pins axi_dma_0/mm2s_introut] [get_bd_pins irq_concat/In1]
+connect_bd_net [get_bd_pins pattern_out_0/interrupt_out] [get_bd_pins irq_concat/In2]
+connect_bd_net [get_bd_pins irq_concat/dout] [get_bd_pins zynq_ultra_ps_e_0/pl_ps_irq0]
+
+# Address map: next to the AXI GPIO at 0x80000000; the DMA reads all of low DDR
+assign_bd_address -offset 0x80010000 -range 64K -target_address_space \
+    [get_bd_addr_spaces zynq_ultra_ps_e_0/Data] [get_bd_addr_segs axi_dma_0/S_AXI_LITE/Reg]
+assign_bd_address -offset 0x80020000 -range 4K -target_address_space \
+    [get_bd_addr_spaces zynq_ultra_ps_e_0/Data] [get_bd_addr_segs pattern_out_0/s00_axi/reg0]
+assign_bd_address -target_address_space [get_bd_addr_spaces axi_dma_0/Data_MM2S] \
+    [get_bd_addr_segs zynq_ultra_ps_e_0/SAXIGP2/HP0_DDR_LOW]
+
+save_bd_variant
+puts "gpio_led.bd: pattern output variant added (pattern_out_0 at 0x80020000, axi_dma_0 at 0x80010000)"
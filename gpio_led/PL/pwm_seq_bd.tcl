@@ -0,0 +1,77 @@
+# PWM/sequencer variant of the gpio_led block design
+#
+# Adds a PWM generator with a step sequencer per LED in front of the pins:
+#   AXI GPIO channel 1 [-> pattern_out_0] -> pwm_seq_0 -> led_output_tri_o
+# pwm_seq_0 (myhdl/PL/MyHDL/src/pwm_seq) drives each LED with a duty of
+# its own, or plays a brightness sequence from its step memory, with no
+# processor involvement once loaded; while it is disabled the pins follow the
+# block in front of it, so the existing firmware keeps working. Runs on the
+# default design or after pattern_out_bd.tcl, which it then chains behind.
+# The external port keeps its name, so gpio_led.xdc applies unchanged.
+#
+# Usage (after 'make build' in myhdl/), from gpio_led/PL:
+#   make pwm_seq_bd          (or: vivado -mode batch -source pwm_seq_bd.tcl)
+# The variant goes into a copy of the project (build_utils/bd_variant.tcl);
+# build that copy with PL_VARIANT=ON.
+
+set script_dir [file dirname [file normalize [info script]]]
+set verilog_file [file normalize "$script_dir/../../myhdl/build/pwm_seq_ip.v"]
+set project_file "$script_dir/gpio_led/gpio_led.xpr"
+source [file normalize "$script_dir/../../build_utils/bd_variant.tcl"]
+
+if {![file exists $verilog_file]} {
+    error "$verilog_file not found: run 'make build' in myhdl/ first"
+}
+
+open_bd_variant $project_file gpio_led.bd
+add_files -norecurse $verilog_file
+update_compile_order -fileset sources_1
+
+set have_pattern_out [expr {[get_bd_cells -quiet pattern_out_0] ne ""}]
+
+# PWM sequencer (MyHDL module reference)
+set pwm_seq_0 [create_bd_cell -type module -reference pwm_seq_ip pwm_seq_0]
+set_property CONFIG.ASSOCIATED_BUSIF {s00_axi} [get_bd_pins pwm_seq_0/clk]
+set_property CONFIG.ASSOCIATED_RESET {resetn} [get_bd_pins pwm_seq_0/clk]
+
+# Control: one more master on the existing SmartConnect
+set num_mi [get_property CONFIG.NUM_MI [get_bd_cells axi_smc]]
+set_property CONFIG.NUM_MI [expr {$num_mi + 1}] [get_bd_cells axi_smc]
+connect_bd_intf_net [get_bd_intf_pins [format "axi_smc/M%02d_AXI" $num_mi]] \
+    [get_bd_intf_pins pwm_seq_0/s00_axi]
+
+connect_bd_net [get_bd_pins zynq_ultra_ps_e_0/pl_clk0] [get_bd_pins pwm_seq_0/clk]
+connect_bd_net [get_bd_pins rst_ps8_0_99M/peripheral_aresetn] [get_bd_pins pwm_seq_0/resetn]
+
+# LED pins: the block driving them so far -> pwm_seq_0/gpio_in, pwm_seq_0 -> pins
+if {$have_pattern_out} {
+    delete_bd_objs [get_bd_nets -of_objects [get_bd_ports led_output_tri_o]]
+    connect_bd_net [get_bd_pins pattern_out_0/pattern_o] [get_bd_pins pwm_seq_0/gpio_in]
+} else {
+    delete_bd_objs [get_bd_intf_nets axi_gpio_0_GPIO] [get_bd_intf_ports led_output]
+    create_bd_port -dir O -from 1 -to 0 led_output_tri_o
+    connect_bd_net [get_bd_pins axi_gpio_0/gpio_io_o] [get_bd_pins pwm_seq_0/gpio_in]
+}
+connect_bd_net [get_bd_pins pwm_seq_0/pwm_o] [get_bd_ports led_output_tri_o]
+
+# Interrupts: the next input of irq_concat, pl_ps_irq0[3] (124) after the
+# pattern output variant, otherwise [1] (122) next to the AXI GPIO at [0]
+if {[get_bd_cells -quiet irq_concat] ne ""} {
+    set irq_index [get_property CONFIG.NUM_PORTS [get_bd_cells irq_concat]]
+    set_property CONFIG.NUM_PORTS [expr {$irq_index + 1}] [get_bd_cells irq_concat]
+} else {
+    delete_bd_objs [get_bd_nets axi_gpio_0_ip2intc_irpt]
+    set irq_concat [create_bd_cell -type ip -vlnv xilinx.com:ip:xlconcat:2.1 irq_concat]
+    set_property CONFIG.NUM_PORTS {2} $irq_concat
+    connect_bd_net [get_bd_pins axi_gpio_0/ip2intc_irpt] [get_bd_pins irq_concat/In0]
+    connect_bd_net [get_bd_pins irq_concat/dout] [get_bd_pins zynq_ultra_ps_e_0/pl_ps_irq0]
+    set irq_index 1
+}
+connect_bd_net [get_bd_pins pwm_seq_0/interrupt_out] [get_bd_pins irq_concat/In$irq_index]
+
+# Address map: after the AXI GPIO (0x80000000) and the pattern output variant
+assign_bd_address -offset 0x80030000 -range 4K -target_address_space \
+    [get_bd_addr_spaces zynq_ultra_ps_e_0/Data] [get_bd_addr_segs pwm_seq_0/s00_axi/reg0]
+
+save_bd_variant
+puts "gpio_led.bd: PWM sequencer variant added (pwm_seq_0 at 0x80030000, pl_ps_irq0\[$irq_index\])"
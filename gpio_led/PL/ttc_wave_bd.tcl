@@ -0,0 +1,104 @@
+# TTC waveform variant of the gpio_led block design
+#
+# Puts a 2:1 mux in front of the LED pins, between the block driving them so
+# far and the waveform output of TTC0 counter 1 (emio_ttc0_wave_o[1]):
+#   AXI GPIO channel 1 [-> pattern_out_0 -> pwm_seq_0] -+
+#                                                        +-> mux -> led_output_tri_o
+#   TTC0 wave 1 -> {~wave, wave} -----------------------+
+# EMIO GPIO <sel_pin> (95 by default, RPU_TTC_WAVE_SEL_PIN) selects the wave,
+# which the firmware built with RPU_TTC_WAVE=1 (rpu_ttcwave.h) raises while a
+# SLOW or FAST blink runs on the counter; low, the pins follow the block in
+# front as before. Runs on the default design or after the other variants;
+# run it last, so the wave is the last stage before the pins. The external
+# port keeps its name, so gpio_led.xdc applies unchanged.
+#
+# Usage, from gpio_led/PL:
+#   make ttc_wave_bd          (or: vivado -mode batch -source ttc_wave_bd.tcl
+#                              [-tclargs <sel_pin>])
+# The variant goes into a copy of the project (build_utils/bd_variant.tcl);
+# build that copy with PL_VARIANT=ON.
+
+set script_dir [file dirname [file normalize [info script]]]
+set project_file "$script_dir/gpio_led/gpio_led.xpr"
+source [file normalize "$script_dir/../../build_utils/bd_variant.tcl"]
+set sel_pin [expr {$argc > 0 ? [lindex $argv 0] : 95}]
+
+if {$sel_pin < 0 || $sel_pin > 95} {
+    error "select pin $sel_pin: must be an EMIO GPIO, 0..95"
+}
+
+open_bd_variant $project_file gpio_led.bd
+
+# TTC0 waveforms and the 96 EMIO GPIOs out of the PS
+set_property -dict [list \
+    CONFIG.PSU__TTC0__PERIPHERAL__ENABLE {1} \
+    CONFIG.PSU__TTC0__WAVEOUT__ENABLE {1} \
+    CONFIG.PSU__TTC0__WAVEOUT__IO {EMIO} \
+    CONFIG.PSU__GPIO_EMIO__PERIPHERAL__ENABLE {1} \
+    CONFIG.PSU__GPIO_EMIO__PERIPHERAL__IO {96} \
+] [get_bd_cells zynq_ultra_ps_e_0]
+
+proc slice_cell {name width bit} {
+    set cell [create_bd_cell -type ip -vlnv xilinx.com:ip:xlslice:1.0 $name]
+    set_property -dict [list CONFIG.DIN_WIDTH $width CONFIG.DIN_FROM $bit CONFIG.DIN_TO $bit] $cell
+    return $cell
+}
+
+proc logic_cell {name op} {
+    set cell [create_bd_cell -type ip -vlnv xilinx.com:ip:util_vector_logic:2.0 $name]
+    set width [expr {$op eq "not" ? 1 : 2}]
+    set_property -dict [list CONFIG.C_OPERATION $op CONFIG.C_SIZE $width] $cell
+    return $cell
+}
+
+proc concat_cell {name} {
+    set cell [create_bd_cell -type ip -vlnv xilinx.com:ip:xlconcat:2.1 $name]
+    set_property CONFIG.NUM_PORTS {2} $cell
+    return $cell
+}
+
+# Wave: LED 0 = wave, LED 1 = ~wave
+slice_cell ttc_wave_bit 3 1
+logic_cell ttc_wave_inv not
+concat_cell ttc_wave_leds
+connect_bd_net [get_bd_pins zynq_ultra_ps_e_0/emio_ttc0_wave_o] [get_bd_pins ttc_wave_bit/Din]
+connect_bd_net [get_bd_pins ttc_wave_bit/Dout] [get_bd_pins ttc_wave_inv/Op1] \
+    [get_bd_pins ttc_wave_leds/In0]
+connect_bd_net [get_bd_pins ttc_wave_inv/Res] [get_bd_pins ttc_wave_leds/In1]
+
+# Select on both bits, and its inverse
+slice_cell ttc_wave_sel 96 $sel_pin
+logic_cell ttc_wave_nsel not
+concat_cell ttc_wave_sel2
+concat_cell ttc_wave_nsel2
+connect_bd_net [get_bd_pins zynq_ultra_ps_e_0/emio_gpio_o] [get_bd_pins ttc_wave_sel/Din]
+connect_bd_net [get_bd_pins ttc_wave_sel/Dout] [get_bd_pins ttc_wave_nsel/Op1] \
+    [get_bd_pins ttc_wave_sel2/In0] [get_bd_pins ttc_wave_sel2/In1]
+connect_bd_net [get_bd_pins ttc_wave_nsel/Res] [get_bd_pins ttc_wave_nsel2/In0] \
+    [get_bd_pins ttc_wave_nsel2/In1]
+
+# pins = (front & ~sel) | (wave & sel)
+logic_cell ttc_wave_front_and and
+logic_cell ttc_wave_wave_and and
+logic_cell ttc_wave_mux or
+connect_bd_net [get_bd_pins ttc_wave_nsel2/dout] [get_bd_pins ttc_wave_front_and/Op2]
+connect_bd_net [get_bd_pins ttc_wave_leds/dout] [get_bd_pins ttc_wave_wave_and/Op1]
+connect_bd_net [get_bd_pins ttc_wave_sel2/dout] [get_bd_pins ttc_wave_wave_and/Op2]
+connect_bd_net [get_bd_pins ttc_wave_front_and/Res] [get_bd_pins ttc_wave_mux/Op1]
+connect_bd_net [get_bd_pins ttc_wave_wave_and/Res] [get_bd_pins ttc_wave_mux/Op2]
+
+# LED pins: the block driving them so far -> the mux, the mux -> pins
+if {[get_bd_intf_ports -quiet led_output] ne ""} {
+    delete_bd_objs [get_bd_intf_nets axi_gpio_0_GPIO] [get_bd_intf_ports led_output]
+    create_bd_port -dir O -from 1 -to 0 led_output_tri_o
+    set front [get_bd_pins axi_gpio_0/gpio_io_o]
+} else {
+    set led_net [get_bd_nets -of_objects [get_bd_ports led_output_tri_o]]
+    set front [get_bd_pins -of_objects $led_net -filter {DIR == O}]
+    delete_bd_objs $led_net
+}
+connect_bd_net $front [get_bd_pins ttc_wave_front_and/Op1]
+connect_bd_net [get_bd_pins ttc_wave_mux/Res] [get_bd_ports led_output_tri_o]
+
+save_bd_variant
+puts "gpio_led.bd: TTC waveform variant added (emio_ttc0_wave_o\[1\], select EMIO GPIO $sel_pin)"
@@ -10,8 +10,146 @@ enable_language(C ASM CXX)
 # -----------------------------------------
 # Add any compiler definitions, they will be added as extra definitions
 # Example : Adding VERBOSE=1 will pass -DVERBOSE=1 to the compiler.
+# RPU_PROFILE selects the power/latency profile (rpu_power.h):
+#   0 = default (100 Hz tick), 1 = power (tickless idle, needs the BSP built
+#   with freertos_tickless_idle 2),
+#   2 = latency (1 kHz tick, needs the BSP built with freertos_tick_rate 1000)
+# RPU_CORE selects the core (rpu_core.h): 0 = RPU0, 1 = RPU1 in split mode
+#   (freertos_psu_cortexr5_1 domain; the linker script follows, see
+#   RPU_SPLIT below)
+# LEGACY_POLL_MS=<ms> overrides the poll period of the legacy DDR mailbox
+#   (main.c; 0 = doorbell only)
+# RPU_RPMSG=1 replaces the IPI message path with an RPMsg endpoint (rpu_rpmsg.h;
+#   needs the openamp and libmetal BSP libraries and dynamic allocation)
+# RPU_IRQ_PROF=1 times the IPI path with the PMU cycle counter (rpu_irqprof.h;
+#   read with apu_app/rpu_stats --irq)
+# RPU_INTR_IPI_LEVEL, RPU_INTR_GPIO_LEVEL, RPU_INTR_DMA_LEVEL, RPU_INTR_WAVE_LEVEL,
+#   RPU_INTR_TIMER_LEVEL, RPU_INTR_SYSMON_LEVEL, RPU_INTR_UART_LEVEL,
+#   RPU_INTR_TICK_LEVEL, RPU_INTR_PCPROF_LEVEL
+#   =<0..30> override the GIC priority plan (rpu_intr.h; lower is more urgent)
+# RPU_IPI_FIQ=1 takes the APU doorbell as an FIQ that acknowledges legacy
+#   commands in the handler (rpu_fiq.h)
+# RPU_APM=1 samples the OCM, LPD and CCI performance monitors (rpu_apm.h; RPU0
+#   only, read with apu_app/rpu_stats --apm)
+# RPU_QOS=1 raises the AXI QoS of the HP0 and S_AXI_LPD ports (rpu_qos.h; RPU0
+#   only); RPU_QOS_PORTS=<RPU_QOS_* mask> / RPU_QOS_LEVEL=<0..15> pick them
+# RPU_PCAP=1 serves BULK_OP_PCAP: partial bitstreams staged in the bulk
+#   carveout go to the PL through the CSU DMA and the PCAP (rpu_csum.h; RPU0
+#   only, fw_loader --rpu-pcap on the APU)
+# RPU_GPIO_IN=1 takes channel 2 of the AXI GPIO as interrupt-driven inputs
+#   (rpu_gpioin.h; RPU0 only, needs the XSA of the current PL design)
+# RPU_UART_TX=1 buffers xil_printf output in a ring drained by the UART
+#   TX-empty interrupt (rpu_uart.h; RPU0 only, the UART must not be shared)
+# RPU_UART_BAUD=<bps> sets the console rate with RPU_UART_TX=1 (0 = BSP rate)
+# RPU_UART_TELEMETRY=1 sends stats, trace and queue depths as COBS frames on
+#   the console (rpu_telem.h; needs RPU_UART_TX=1, decode with
+#   RPU/tools/rpu_telem.py; use with RPU_UART_BAUD=921600)
+# RPU_TRACE_COMPACT=1 writes the event trace as delta/varint records of a few
+#   bytes instead of 24-byte entries, about three times the history in the
+#   same window (rpu_trace.h, common/rpu_trace_compact.h; apu_app/rpu_trace
+#   decodes both; not with RPU_LOG_DCC or RPU_UART_TELEMETRY)
+# RPU_HWTIMER=1 runs the 10 s mode rotation on a TTC-driven timer wheel
+#   instead of the FreeRTOS timer service (rpu_hwtimer.h)
+# RPU_SYSMON=1 publishes die temperatures and PS supplies from the SYSMON
+#   (rpu_sysmon.h; RPU0 only, read with apu_app/rpu_stats --sysmon);
+#   RPU_SYSMON_HOT_C / RPU_SYSMON_COOL_C=<degrees> set the alarm (85 / 75)
+# RPU_MPCMD=1 serves RPU_CMD_* commands from any number of APU processes and
+#   the RPU1 firmware in the OCM block at MPCMD_ADDR (rpu_mpcmd.h; RPU0
+#   consumes, RPU1 posts; ipi_app --mp on the APU)
+# RPU_EDGE_STATS=1 measures each LED edge against its scheduled tick and
+#   traces the error (rpu_edge.h; RPU_TRACE_EDGE, with a log summary)
+# RPU_PC_PROF=1 samples the PC from a TTC interrupt into a histogram in OCM
+#   (rpu_pcprof.h; read with apu_app/rpu_prof); RPU_PC_PROF_HZ=<hz> sets the
+#   rate (997)
+# RPU_LOG_DCC=1 sends RPU_LOG records and the trace as binary frames over the
+#   CoreSight DCC instead of the UART (rpu_dcc.h; read with a JTAG debugger or
+#   apu_app/rpu_dcc, decode with RPU/tools/rpu_dcc.py)
+# RPU_SENSOR=1 reads a sensor register block over the PS I2C or SPI at a
+#   TTC-triggered rate into a ring in OCM (rpu_sensor.h; RPU0 only, read with
+#   apu_app/rpu_sensor); RPU_SENSOR_BUS, _DEV, _REG, _LEN and _HZ select the
+#   device and the read (MPU-6050 style IMU at 0x68 on I2C, 1000 Hz)
+# RPU_LED_PS_GPIO=1 writes the LEDs through the PS GPIO (MIO/EMIO) in one
+#   masked store instead of the PL AXI GPIO (rpu_led.h; RPU_LED_PS_BANK and
+#   RPU_LED_PS_SHIFT select the pins, EMIO 0 by default; the write cycles are
+#   logged with RPU_EDGE_STATS=1)
+# RPU_LED_BANKS=1 drives a bitset of output channels over several banks in one
+#   pass per frame, storing only the banks that changed (rpu_bank.h): the LEDs,
+#   then RPU_BANK_AXI2_WIDTH=<n> outputs of AXI GPIO channel 2,
+#   RPU_BANK_EMIO_PINS=<n> EMIO pins and RPU_BANK_ATOMIC_BASE=<addr> for a
+#   gpio_atomic block (all 0 by default; the PL design must provide them)
+# RPU_TTC_WAVE=1 draws the SLOW and FAST blink with the waveform output of
+#   TTC0 counter 1 instead of frame writes (rpu_ttcwave.h; RPU0 only, not with
+#   RPU_PC_PROF; needs PL/ttc_wave_bd.tcl, RPU_TTC_WAVE_SEL_PIN=<n> selects
+#   the EMIO GPIO of the mux, 95)
+# RPU_SLEEP_YIELD=1 makes usleep()/msleep()/sleep() block in tasks: whole
+#   ticks with vTaskDelay(), the rest on a TTC one-shot (rpu_sleep.h; the BSP
+#   busy-wait stays in interrupts, critical sections and before the scheduler)
+# RPU_XCORE=1 passes messages between RPU0 and RPU1 in split mode: a ring per
+#   direction in OCM and an SGI doorbell (rpu_xcore.h; set it in both
+#   firmwares; RPU_XCORE_SGI=<n> selects the SGI, 12)
+# RPU_PL_INTR=1 handles the interrupt_gen channels of the myhdl interrupt_demo
+#   IP on the R5 through its AXI interrupt controller, with per-channel
+#   counters and latencies in OCM (rpu_plintr.h; RPU0 only, read with
+#   apu_app/rpu_stats --plintr; RPU_PL_INTR_GEN_BASE, _INTC_BASE and _IRQ
+#   select the blocks, 0xB0000000, 0xB0010000 and GIC ID 121)
+# RPU_GOVERNOR=1 lowers the R5 clock by RPU_GOV_LOW_DIV (4) and gates the
+#   RPU_GOV_GATE_CLOCKS while only the SLOW blink runs, back up on an IPI
+#   (rpu_gov.h; RPU0 only, read with apu_app/rpu_stats --gov)
+# RPU_WATCHDOG=1 restarts the LPD watchdog only in windows where the Tx, Rx
+#   and command tasks met their deadlines, with per-task miss counters in OCM
+#   (rpu_wdog.h; RPU0 only, read with apu_app/rpu_stats --wdog);
+#   RPU_WDOG_TIMEOUT_MS=<ms> sets the expiry (2000)
+# RPU_BENCH=1 builds the kernel latency benchmark instead of the LED
+#   application: yield, semaphore, queue, notification and SGI-to-task times
+#   with the PMU cycle counter (rpu_bench.h; RPU0 only, logged every round and
+#   read with apu_app/rpu_stats --bench); RPU_BENCH_ITERATIONS=<n> sets the
+#   samples per test and round (1000)
+# RPU_MEMBENCH=1 builds the memory hierarchy benchmark instead: latency,
+#   bandwidth and single-word cost of TCM, OCM, DDR and PL under each MPU memory
+#   type (rpu_membench.h; RPU0 only, read with apu_app/mem_bench)
+# RPU_EXEC=1 runs the LED application without the scheduler: a run-to-
+#   completion loop of interrupt-posted events and periodic slots on the
+#   system counter (rpu_exec.h; RPU0 only, no bulk channel and none of the
+#   options that run in tasks of their own)
+# RPU_FAST_BOOT=1 logs the boot messages through the deferred log instead of
+#   the polled UART and sets the waveform engines up on their first start
+#   (rpu_boot.h; the boot time breakdown is logged either way)
+# RPU_SHM_TCM=1 places the APU shared window in the first 4 KB of BTCM, which
+#   the APU reaches at 0xFFE20000 (rpu_core.h; rpu_shm.h, "TCM variant")
 set(USER_COMPILE_DEFINITIONS
-""
+"RPU_PROFILE=0"
+"RPU_CORE=0"
+"RPU_RPMSG=0"
+"RPU_IRQ_PROF=0"
+"RPU_IPI_FIQ=0"
+"RPU_APM=0"
+"RPU_QOS=0"
+"RPU_PCAP=0"
+"RPU_GPIO_IN=0"
+"RPU_UART_TX=0"
+"RPU_UART_BAUD=0"
+"RPU_UART_TELEMETRY=0"
+"RPU_TRACE_COMPACT=0"
+"RPU_HWTIMER=0"
+"RPU_SYSMON=0"
+"RPU_MPCMD=0"
+"RPU_EDGE_STATS=0"
+"RPU_PC_PROF=0"
+"RPU_LOG_DCC=0"
+"RPU_SENSOR=0"
+"RPU_LED_PS_GPIO=0"
+"RPU_LED_BANKS=0"
+"RPU_TTC_WAVE=0"
+"RPU_SLEEP_YIELD=0"
+"RPU_XCORE=0"
+"RPU_PL_INTR=0"
+"RPU_GOVERNOR=0"
+"RPU_WATCHDOG=0"
+"RPU_BENCH=0"
+"RPU_MEMBENCH=0"
+"RPU_EXEC=0"
+"RPU_FAST_BOOT=0"
+"RPU_SHM_TCM=0"
 )
 
 # Undefine any previously specified compiler definitions, either built in or provided with a -D option
@@ -27,6 +165,7 @@ set(USER_UNDEFINED_SYMBOLS
 # Example 3: Adding ${CMAKE_SOURCE_DIR}/data/include to add data/include from this project.
 
 set(USER_INCLUDE_DIRECTORIES
+"${CMAKE_SOURCE_DIR}/../../../common"
 )
 
 #Add any source below, they will be added as Compile sources.
@@ -35,6 +174,53 @@ set(USER_INCLUDE_DIRECTORIES
 #Example 3: Adding ${MY_ENV}/data/helloworld.c are expanded using project-specific environment settings.
 set(USER_COMPILE_SOURCES
 "main.c"
+"rpu_abi.c"
+"rpu_apm.c"
+"rpu_bench.c"
+"rpu_boot.c"
+"rpu_bulk.c"
+"rpu_config.c"
+"rpu_credit.c"
+"rpu_csum.c"
+"rpu_dcc.c"
+"rpu_dmacopy.c"
+"rpu_dmaq.c"
+"rpu_edge.c"
+"rpu_exec.c"
+"rpu_fiq.c"
+"rpu_gpioin.c"
+"rpu_gov.c"
+"rpu_handoff.c"
+"rpu_hwtimer.c"
+"rpu_intr.c"
+"rpu_ipisrc.c"
+"rpu_irqprof.c"
+"rpu_led.c"
+"rpu_log.c"
+"rpu_membench.c"
+"rpu_mpcmd.c"
+"rpu_pattern.c"
+"rpu_pcprof.c"
+"rpu_plintr.c"
+"rpu_pool.c"
+"rpu_power.c"
+"rpu_qos.c"
+"rpu_rpmsg.c"
+"rpu_sensor.c"
+"rpu_stackguard.c"
+"rpu_stats.c"
+"rpu_status.c"
+"rpu_sysmon.c"
+"rpu_tcm.c"
+"rpu_telem.c"
+"rpu_time.c"
+"rpu_timed.c"
+"rpu_trace.c"
+"rpu_ttcwave.c"
+"rpu_uart.c"
+"rpu_wave.c"
+"rpu_wave_dma.c"
+"rpu_wdog.c"
 )
 
 # -----------------------------------------
@@ -62,11 +248,34 @@ set(USER_COMPILE_WARNINGS_INHIBIT_ALL )
 
 # -----------------------------------------
 
+# Build profile: debug (-O0, as the IDE default), speed (-O2 with LTO) or
+# size (-Os with LTO); -mcpu=cortex-r5 -mfpu=vfpv3-d16 come from the BSP
+# toolchain flags in every profile (cmake -DRPU_PROFILE=speed)
+set(RPU_PROFILE "debug" CACHE STRING "gpio_app build profile: debug, speed or size")
+set_property(CACHE RPU_PROFILE PROPERTY STRINGS debug speed size)
+
 # Optimization level   "-O0" [None], "-O1" [Optimize] , "-O2" [Optimize More], "-O3" [Optimize Most] or "-Os" [Optimize Size]
-set(USER_COMPILE_OPTIMIZATION_LEVEL -O0)
+if(RPU_PROFILE STREQUAL "debug")
+    set(USER_COMPILE_OPTIMIZATION_LEVEL -O0)
+elseif(RPU_PROFILE STREQUAL "speed")
+    set(USER_COMPILE_OPTIMIZATION_LEVEL -O2)
+elseif(RPU_PROFILE STREQUAL "size")
+    set(USER_COMPILE_OPTIMIZATION_LEVEL -Os)
+else()
+    message(FATAL_ERROR "Unknown RPU_PROFILE '${RPU_PROFILE}': debug, speed or size")
+endif()
 
 # Other flags related to optimization
-set(USER_COMPILE_OPTIMIZATION_OTHER_FLAGS )
+# One section per function and object, so --gc-sections below drops what
+# the selected build options leave unreferenced from the loaded image
+set(USER_COMPILE_OPTIMIZATION_OTHER_FLAGS "-ffunction-sections -fdata-sections")
+# Link-time optimization across the modules (the BSP libraries are linked as
+# they are); what only the linker script or the APU refers to, such as the
+# resource table and the shared memory block, is marked used
+if(NOT RPU_PROFILE STREQUAL "debug")
+    string(APPEND USER_COMPILE_OPTIMIZATION_OTHER_FLAGS " -flto")
+    set(RPU_LINK_LTO_FLAGS " -flto ${USER_COMPILE_OPTIMIZATION_LEVEL}")
+endif()
 
 # -----------------------------------------
 
@@ -126,11 +335,29 @@ set(USER_LINK_DIRECTORIES
 
 # -----------------------------------------
 
-set(USER_LINKER_SCRIPT "${CMAKE_SOURCE_DIR}/lscript.ld")
+# DDR image of the core, configured into lscript.ld.in: a lone RPU0 keeps
+# the 32 MB of the platform at 0x3ED00000; with the R5s in split mode
+# (cmake -DRPU_SPLIT=ON for RPU0, implied by RPU_CORE=1) each core gets
+# 2 MB, RPU1 at 0x3EF00000
+option(RPU_SPLIT "RPU0 shares the DDR image region with an RPU1 worker" OFF)
+if("RPU_CORE=1" IN_LIST USER_COMPILE_DEFINITIONS)
+    set(RPU_DDR_ORIGIN 0x3ef00000)
+    set(RPU_DDR_LENGTH 0x200000)
+elseif(RPU_SPLIT)
+    set(RPU_DDR_ORIGIN 0x3ed00000)
+    set(RPU_DDR_LENGTH 0x200000)
+else()
+    set(RPU_DDR_ORIGIN 0x3ed00000)
+    set(RPU_DDR_LENGTH 0x2000000)
+endif()
+configure_file("${CMAKE_SOURCE_DIR}/lscript.ld.in" "${CMAKE_BINARY_DIR}/lscript.ld" @ONLY)
+set(USER_LINKER_SCRIPT "${CMAKE_BINARY_DIR}/lscript.ld")
 
 # Add linker options to be passed, they will be added as extra linker options
 # Example : Adding -s will pass -s to the linker.
 set(USER_LINK_OTHER_FLAGS
+"-Wl,--gc-sections"
+${RPU_LINK_LTO_FLAGS}
 )
 
 # -----------------------------------------
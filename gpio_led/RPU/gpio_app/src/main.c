@@ -16,9 +16,28 @@
  * This application demonstrates a FreeRTOS-based LED Blinking system on a Xilinx RPU.
  *
  * It consists of three main components:
- * 1. Tx Task: Generates LED blink patterns based on the current mode and sends them to a queue.
- * 2. Rx Task: Receives the LED status from the queue and writes it to the AXI GPIO hardware.
- * 3. Timer Callback: Periodically changes the blink mode (Slow -> Fast -> Random).
+ * 1. Tx Task: Generates LED blink patterns based on the current mode. Single values are
+ *    passed to the Rx task as a direct-to-task notification; RANDOM mode bursts are sent
+ *    as one message on a message buffer.
+ * 2. Rx Task: Writes the received LED values to the AXI GPIO hardware.
+ * 3. Timer Callback: Periodically changes the blink mode (Slow -> Fast -> Random),
+ *    from the FreeRTOS timer service or, with RPU_HWTIMER=1, from the hardware
+ *    timer wheel interrupt (rpu_hwtimer.c).
+ *    On RPU0 a second timer polls the legacy DDR mailbox (rpu_shm.h) every
+ *    LEGACY_POLL_MS and hands changes to the IPI task.
+ * 4. IPI Task: Processes APU commands (IPI message buffer, command ring and legacy
+ *    CMD word); the IPI interrupt handler only clears the interrupt and notifies
+ *    this task. With RPU_IPI_FIQ=1 the doorbell is an FIQ whose handler
+ *    acknowledges the legacy CMD word itself (rpu_fiq.h). In echo mode
+ *    (SHM_APU_FLAG_ECHO, APU ipi_bench) legacy commands are acknowledged without
+ *    changing the mode and commands are not logged.
+ * 5. Log Task: Prints messages queued with RPU_LOG() at idle priority (rpu_log.c).
+ * 6. Waveform engine: Plays APU-uploaded GPIO sample tables from a TTC interrupt
+ *    (rpu_wave.c) or an LPD DMA channel (rpu_wave_dma.c); the Rx task does not
+ *    touch the GPIO while a waveform plays.
+ * 7. Hot-swap: RPU_CMD_HANDOFF saves the mode, the LED value and the pattern
+ *    schedule for the next image and freezes them (rpu_handoff.h); an image
+ *    that finds such a state at boot continues from it.
  *
  * The AXI GPIO is accessed directly from the RPU after configuring the MPU to allow access
  * to the PL address space.
@@ -27,8 +46,8 @@
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
 #include "timers.h"
+#include "message_buffer.h"
 /* Xilinx includes. */
 #include "xil_printf.h"
 #include "xparameters.h"
@@ -39,129 +58,502 @@
 #include "xreg_cortexr5.h"
 #include "sleep.h"
 #include "xinterrupt_wrap.h"
+#include "xgpio.h"
+#include "xipipsu.h"
 #include <stdlib.h>
 
+#include "kr260_regs.h"
+#include "rpu_abi.h"
+#include "rpu_apm.h"
+#include "rpu_bench.h"
+#include "rpu_boot.h"
+#include "rpu_bulk.h"
+#include "rpu_config.h"
+#include "rpu_dmacopy.h"
+#include "rpu_core.h"
+#include "rpu_credit.h"
+#include "rpu_csum.h"
+#include "rpu_edge.h"
+#include "rpu_exec.h"
+#include "rpu_fiq.h"
+#include "rpu_gpioin.h"
+#include "rpu_gov.h"
+#include "rpu_handoff.h"
+#include "rpu_hwtimer.h"
+#include "rpu_intr.h"
+#include "rpu_ipisrc.h"
+#include "rpu_irqprof.h"
+#include "rpu_led.h"
+#include "rpu_log.h"
+#include "rpu_membench.h"
+#include "rpu_mpcmd.h"
+#include "rpu_pattern.h"
+#include "rpu_pcprof.h"
+#include "rpu_plintr.h"
+#include "rpu_power.h"
+#include "rpu_qos.h"
+#include "rpu_rand.h"
+#include "rpu_rpmsg.h"
+#include "rpu_sensor.h"
+#include "rpu_sleep.h"
+#include "rpu_stackguard.h"
+#include "rpu_stats.h"
+#include "rpu_status.h"
+#include "rpu_sysmon.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_timed.h"
+#include "rpu_trace.h"
+#include "rpu_ttcwave.h"
+#include "rpu_uart.h"
+#include "rpu_telem.h"
+#include "rpu_wave.h"
+#include "rpu_wdog.h"
+#include "rpu_xcore.h"
+
+// The legacy DDR command word is RPU0's only (rpu_core.h)
+#if RPU_CORE == 0
 #define LEGACY_MODE 1
+#endif
 #define IPI_MODE 1
 
 // Base address for the AXI GPIO IP (Check your .hwh file!)
 #define AXI_GPIO_BASE_ADDR 0x80000000
-#define GPIO_DATA_OFFSET   0x00 // Data Register Offset
-#define GPIO_TRI_OFFSET    0x04      // Tri-State Register Offset (Set direction)
+// Channel 2 input events (RPU_GPIO_IN=1): as urgent as the commands
+#define GPIO_IN_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define GPIO_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_GPIO_LEVEL)
+#define UART_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_UART_LEVEL)
+#define SLEEP_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_SLEEP_LEVEL)
+// Inter-R5 messages (RPU_XCORE=1): received as urgently as the commands
+#define XCORE_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define XCORE_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_XCORE_LEVEL)
+// interrupt_gen channels through the AXI interrupt controller (RPU_PL_INTR=1)
+#define PL_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_PL_LEVEL)
 
 #ifdef IPI_MODE
-// IPI and Shared Memory Configuration
-#define IPI_CH1_BASE       0xFF310000 // RPU0 IPI Channel 1
-#define IPI_ISR_OFFSET     0x10  // Interrupt Status Register
-#define IPI_IMR_OFFSET     0x14  // Interrupt Mask Register
-#define IPI_IER_OFFSET     0x18  // Interrupt Enable Register
-#define IPI_IDR_OFFSET     0x1C  // Interrupt Disable Register
-#define IPI_INT_ID         65  // GIC_SPI 33 -> ID 65 (Standard for IPI1/RPU0)
+// IPI and Shared Memory Configuration; the channel base and interrupt ID
+// of this core are in rpu_core.h, the register offsets in kr260_regs.h
 #define IPI_INTC_PARENT    0xF9000000 // GIC Base Address
 #define APU_MASK           0x01
+// Doorbell sources: the APU and, on RPU0, the RPU1 producers of the
+// multi-producer command channel (rpu_mpcmd.h); the FIQ path is APU-only
+#if RPU_MPCMD && RPU_CORE == 0 && !RPU_IPI_FIQ
+#define IPI_SRC_MASK       (APU_MASK | RPU_MPCMD_IPI_RPU1)
+#else
+#define IPI_SRC_MASK       APU_MASK
+#endif
+// GIC priorities from the plan in rpu_intr.h: the IPI preempts the DMA
+// completions and the tick, the waveform sample preempts everything
+#define IPI_INTR_PRIORITY  RPU_INTR_PRIORITY(RPU_INTR_IPI_LEVEL)
+#define TIMED_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_TIMED_LEVEL)
+#define DMA_INTR_PRIORITY  RPU_INTR_PRIORITY(RPU_INTR_DMA_LEVEL)
+#define WAVE_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_WAVE_LEVEL)
+#define TIMER_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_TIMER_LEVEL)
+#define SYSMON_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_SYSMON_LEVEL)
+#define PCPROF_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_PCPROF_LEVEL)
+#define SENSOR_INTR_PRIORITY RPU_INTR_PRIORITY(RPU_INTR_SENSOR_LEVEL)
+#define IPI_TASK_PRIORITY  (configMAX_PRIORITIES - 2)  // Above Tx/Rx, below the timer service task
+#define BULK_TASK_PRIORITY (tskIDLE_PRIORITY + 2)      // Above Tx/Rx, below commands
+#define RPMSG_TASK_PRIORITY (tskIDLE_PRIORITY + 1)     // Only waits for the vdev at boot
+#define APM_TASK_PRIORITY  (tskIDLE_PRIORITY + 1)      // A sample every 100 ms, below commands
+#define SYSMON_TASK_PRIORITY (tskIDLE_PRIORITY + 1)    // A sample every 250 ms, below commands
+#define TELEM_TASK_PRIORITY (tskIDLE_PRIORITY + 1)     // A set of frames every 100 ms, below commands
+#define HWTIMER_TASK_PRIORITY (configMAX_PRIORITIES - 2)  // Deferred timer callbacks, with commands
+#define SENSOR_TASK_PRIORITY (configMAX_PRIORITIES - 2)   // Publishes each sample within its period
+#define BENCH_TASK_PRIORITY (configMAX_PRIORITIES - 2)    // Benchmark driver, receivers one above
 
-// APU to RPU0 message passing interface
-#define SHARED_MEM_ADDR    0xFF990000
-#define SHM_CMD_OFFSET     0x00  // Command/Mode (APU writes, RPU reads)
-#define SHM_ACK_OFFSET     0x04  // Acknowledgment (RPU writes, APU reads)
-#define SHM_ACK_MAGIC      0xDEADBEEF  // Magic value to indicate acknowledgment
+// APU to RPU message passing interface (rpu_shm.h, included by rpu_core.h)
 
 #endif /* IPI_MODE */
 
 #ifdef LEGACY_MODE
-// Legacy Shared Memory
-#define LEGACY_SHARED_MEM_ADDR 0x40000000
+// Legacy DDR mailbox (rpu_shm.h); a doorbell on the IPI channel is served at once
+#define LEGACY_SHARED_MEM_ADDR LEGACY_MBOX_ADDR
+// Poll period of the mailbox for writers that do not ring the doorbell, in ms
+// (UserConfig.cmake); 0 leaves them to the 10 s mode timer. Rounded up to one tick.
+#ifndef LEGACY_POLL_MS
+#if RPU_PROFILE == RPU_PROFILE_POWER
+#define LEGACY_POLL_MS     0   // Periodic wake-ups would defeat tickless idle
+#elif RPU_PROFILE == RPU_PROFILE_LATENCY
+#define LEGACY_POLL_MS     1
+#else
+#define LEGACY_POLL_MS     10
+#endif
+#endif
+#define LEGACY_POLL_TICKS  ((pdMS_TO_TICKS(LEGACY_POLL_MS) > 0) ? pdMS_TO_TICKS(LEGACY_POLL_MS) : 1)
 #endif /* LEGACY_MODE */
 
 
 
 #define TIMER_ID           1
 #define DELAY_10_SECONDS    10000UL
+
+// Tx -> Rx notification value: flag bits plus, for a single frame, the LED value
+#define RX_NOTIFY_FRAME     0x80000000UL  // Notification value carries one LED value
+#define RX_NOTIFY_BATCH     0x40000000UL  // A burst was sent on xFrameBuffer
+#define RX_FRAME_MASK       0x3FFFFFFFUL
+#define RANDOM_BURST_FRAMES 4
+#define RANDOM_FRAME_MS     200
+// Room for two bursts (each message also stores a size_t length word)
+#define FRAME_BUFFER_SIZE   (2 * (RANDOM_BURST_FRAMES * sizeof(LedFrame_t) + sizeof(size_t)))
+// Executive build (RPU_EXEC=1, rpu_exec.h): release period of the LED slot and the log slot
+#define EXEC_LED_PERIOD_US  1000
+#define EXEC_LOG_PERIOD_US  1000
 /*-----------------------------------------------------------*/
 
 typedef enum {
     BLINK_SLOW,
     BLINK_FAST,
-    BLINK_RANDOM
+    BLINK_RANDOM,
+    BLINK_PATTERN       // RPU_PATTERN_MODE: a program of rpu_pattern.h runs
 } BlinkMode_t;
 
-volatile BlinkMode_t current_blink_mode = BLINK_SLOW;
-volatile int apu_override_active = 0;
+/* Blink mode and APU override: double-buffered, flipped by the Tx task at
+ * each frame (rpu_config.h) */
+
+/* One GPIO value and how long to hold it before the next one; with
+ * RPU_LED_BANKS=1 also every output channel (rpu_bank.h), value being the LEDs */
+typedef struct {
+    u32 value;
+    u32 hold_ms;
+#if RPU_LED_BANKS
+    RpuBankFrame_t bits;
+#endif /* RPU_LED_BANKS */
+} LedFrame_t;
+
+#if RPU_LED_BANKS
+#define LED_FRAME_BITS(f)   (&(f)->bits)
+#else
+#define LED_FRAME_BITS(f)   NULL
+#endif /* RPU_LED_BANKS */
 
 
 /* The Tx and Rx tasks as described at the top of this file. */
+#if !RPU_EXEC
 static void prvTxTask( void *pvParameters );
 static void prvRxTask( void *pvParameters );
+#endif /* !RPU_EXEC */
+static void prvLedWrite(u32 value, const RpuBankFrame_t *bits, u32 src, TickType_t deadline);
+static int prvTtcWaveFrame(u32 half_ms, u32 led);
+static void prvTtcWaveRelease(void);
+static void prvRotateMode(void);
+#if RPU_HWTIMER
+static void vModeTimerCallback( RpuHwTimer_t *pxTimer, void *pvArg );
+#elif !RPU_EXEC
 static void vTimerCallback( TimerHandle_t pxTimer );
+#endif /* RPU_HWTIMER */
 
 #ifdef IPI_MODE
 static void IPI_Handler(void *CallbackRef);
+#if RPU_IPI_FIQ
+static void IPI_FiqHandler(void *CallbackRef);
+#else
+static void prvIpiSrcTask(u32 src, void *arg, BaseType_t *pxWoken);
+#endif /* RPU_IPI_FIQ */
+#if !RPU_EXEC
+static void prvIpiTask( void *pvParameters );
+#endif /* !RPU_EXEC */
+static void prvIpiPass(void);
+static void prvSetMode(u32 cmd_val);
+static void prvLogMode(u32 cmd_val);
+static void prvApplyMode(u32 cmd_val);
+static u32 prvHandleLegacyWord(u32 flags, u32 *seq, u32 *cmd_val);
+static u32 prvExecCommand(u32 opcode, const u32 *args, u32 nargs, u32 *results);
+static u32 prvHandleMessage(void);
+static u32 prvDrainCommandRing(u32 *urgent);
+static u32 prvDrainUrgentRing(void);
+static u32 prvExecMpCmd(u32 opcode, u32 arg);
+static u32 prvHandoff(void);
+static u32 prvPattern(u32 arg);
+static void prvPatternEnd(void);
+static void prvWaveInit(void);
+static int prvGovIdle(void);
+static void prvIpiPollBegin(void);
+static BaseType_t prvIpiRearm(void);
 #endif /* IPI_MODE */
+#ifdef LEGACY_MODE
+#if !RPU_EXEC
+static void vLegacyPollCallback( TimerHandle_t pxTimer );
+#endif /* !RPU_EXEC */
+static u32 prvHandleLegacyMailbox(void);
+#endif /* LEGACY_MODE */
+#if RPU_EXEC
+static void prvExecLedSlot(void);
+#ifdef LEGACY_MODE
+static void prvExecLegacyPoll(void);
+#endif /* LEGACY_MODE */
+#endif /* RPU_EXEC */
 
 /*-----------------------------------------------------------*/
 
-/* The queue used by the Tx and Rx tasks.
- * The Tx task sends a u32 led_status value to the Rx task.
+/* The Tx task notifies the Rx task (xRxTask) directly for single values and
+ * uses xFrameBuffer for bursts that must be written back to back.
  */
+#if !RPU_EXEC
 static TaskHandle_t xTxTask;
 static TaskHandle_t xRxTask;
-static QueueHandle_t xQueue = NULL;
-static TimerHandle_t xTimer = NULL;
+#endif /* !RPU_EXEC */
+/* Tick the frame last sent by the Tx task was due at (Tx writes, Rx reads) */
+static volatile TickType_t xTxDeadline;
+/* Tick the Tx task sends its next frame at, and the last mode rotation */
+static volatile TickType_t xTxNextWake;
+static volatile TickType_t xRotateStart;
+/* Last value on the LEDs (Rx writes; Tx too while a TTC wave draws them) */
+static volatile u32 ulLedLast;
+/* Hot-swap (rpu_handoff.h): state taken from the previous image at boot, and
+ * set once this image handed its own over; outputs and mode then stay put */
+static RpuHandoff_t xResume;
+static int xResumed;
+static volatile u32 ulHandedOff;
+/* LED outputs; writes go through its data shadow and never read the PL bus */
+static XGpio xGpio RPU_BTCM_NOINIT;
+#ifdef IPI_MODE
+static TaskHandle_t xIpiTask;
+/* RPU_CMD_SEED for the Tx task's generator (rpu_rand.h) */
+static volatile u32 ulRandSeed;
+static volatile u32 ulRandReseed;
+static XIpiPsu xIpiInst;  /* Message buffer access only; registers are written directly */
+static u32 ulApuFlags;    /* SHM_APU_FLAG_* sampled at the start of each IPI task pass */
+#if RPU_IPI_FIQ
+/* Legacy commands acknowledged by IPI_FiqHandler, logged by the IPI task */
+static volatile u32 ulFiqCmdCount;
+static volatile u32 ulFiqCmdVal;
+static volatile u32 ulFiqCmdSeq;
+static u32 ulLoggedFiqCount;
+#endif /* RPU_IPI_FIQ */
 
-#if (configSUPPORT_STATIC_ALLOCATION == 1)
-#define QUEUE_BUFFER_SIZE		100
+/* Command log of the IPI path, silenced in echo mode so measured round trips
+ * do not include log formatting */
+#define IPI_LOG(...) \
+    do { \
+        if ((ulApuFlags & SHM_APU_FLAG_ECHO) == 0) { \
+            RPU_LOG(__VA_ARGS__); \
+        } \
+    } while (0)
+#endif /* IPI_MODE */
+#if RPU_HWTIMER
+static RpuHwTimer_t xModeTimer RPU_BTCM_BSS;  /* On the hardware timer wheel (rpu_hwtimer.h) */
+#elif !RPU_EXEC
+static TimerHandle_t xTimer = NULL;
+#endif /* RPU_HWTIMER */
+#ifdef LEGACY_MODE
+static u32 ulLegacyMode = 3;  /* Mailbox mode applied last (3 = released) */
+#endif /* LEGACY_MODE */
+#if !RPU_EXEC
+static MessageBufferHandle_t xFrameBuffer = NULL;
+#ifdef LEGACY_MODE
+static TimerHandle_t xLegacyPollTimer = NULL;
+#endif /* LEGACY_MODE */
+#endif /* !RPU_EXEC */
 
-uint8_t ucQueueStorageArea[ QUEUE_BUFFER_SIZE ];
-StackType_t xStack1[ configMINIMAL_STACK_SIZE ];
-StackType_t xStack2[ configMINIMAL_STACK_SIZE ];
-StaticTask_t xTxBuffer,xRxBuffer;
-StaticTimer_t xTimerBuffer;
-static StaticQueue_t xStaticQueue;
+/* All kernel objects are created statically (the BSP is built without a
+ * FreeRTOS heap); their buffers and the task stacks live in BTCM.
+ */
+#if (configSUPPORT_STATIC_ALLOCATION != 1)
+#error "gpio_app needs a BSP built with freertos_support_static_allocation"
 #endif
 
+#if !RPU_EXEC
+static StaticTask_t xTxTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xTxStack, configMINIMAL_STACK_SIZE) RPU_BTCM_NOINIT;
+static StaticTask_t xRxTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xRxStack, configMINIMAL_STACK_SIZE) RPU_BTCM_NOINIT;
+#ifdef IPI_MODE
+static StaticTask_t xIpiTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xIpiStack, configMINIMAL_STACK_SIZE) RPU_BTCM_NOINIT;
+#endif /* IPI_MODE */
+static StaticMessageBuffer_t xFrameBufferStruct RPU_BTCM_NOINIT;
+static uint8_t ucFrameBufferStorage[ FRAME_BUFFER_SIZE ] RPU_BTCM_NOINIT;
+#if !RPU_HWTIMER
+static StaticTimer_t xTimerBuffer RPU_BTCM_NOINIT;
+#endif /* !RPU_HWTIMER */
+#ifdef LEGACY_MODE
+static StaticTimer_t xLegacyPollTimerBuffer RPU_BTCM_NOINIT;
+#endif /* LEGACY_MODE */
+#endif /* !RPU_EXEC */
+
+/* Idle and timer service tasks, handed to the kernel below */
+static StaticTask_t xIdleTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xIdleStack, configMINIMAL_STACK_SIZE) RPU_BTCM_NOINIT;
+static StaticTask_t xTimerTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xTimerTaskStack, configTIMER_TASK_STACK_DEPTH) RPU_BTCM_NOINIT;
+
+/* Override the port's weak defaults so these stacks are in BTCM as well */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
+                                    StackType_t **ppxIdleTaskStackBuffer,
+                                    uint32_t *pulIdleTaskStackSize )
+{
+	*ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+	*ppxIdleTaskStackBuffer = RPU_TASK_STACK_BUF(xIdleStack);
+	*pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer,
+                                     StackType_t **ppxTimerTaskStackBuffer,
+                                     uint32_t *pulTimerTaskStackSize )
+{
+	*ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+	*ppxTimerTaskStackBuffer = RPU_TASK_STACK_BUF(xTimerTaskStack);
+	*pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
 int main( void )
 {
 	const TickType_t x10seconds = pdMS_TO_TICKS( DELAY_10_SECONDS );
+	u32 ulFirstRotationMs = DELAY_10_SECONDS;
+#ifdef IPI_MODE
+	RpuConfig_t *pxCfg;
+	u32 ulCfgKey;
+#endif /* IPI_MODE */
+
+	/* Zero-initialised TCM data is not part of the image (rpu_tcm.h) */
+	vRpuTcmInit();
+
+	/* Boot time breakdown (rpu_boot.h), logged when the IPI task first runs */
+	vRpuBootInit();
+
+	/* Runtime messages go through the deferred log (rpu_log.h) so hot paths
+	never wait for the UART; boot messages below still print directly, with
+	RPU_FAST_BOOT=1 only the failures do. */
+	vRpuLogInit();
+
+	RPU_BOOT_PRINT( "LED blink example main (%s)\r\n", RPU_CORE_NAME );
+	RPU_BOOT_PRINT( "Profile: %s, tick %d Hz\r\n", pcRpuProfileName(), configTICK_RATE_HZ );
+
+	/* MPU guard below the running task's stack (configUSE_MPU_STACK_GUARD,
+	rpu_stackguard.h), before the first task is switched in */
+	if (xRpuStackGuardInit() != XST_SUCCESS) {
+		xil_printf("Stack guard setup failed, tasks run unguarded\r\n");
+	}
+	vRpuBootMark(RPU_BOOT_LOG);
+
+#if RPU_BENCH
+	/* Benchmark build (rpu_bench.h): its tasks replace the LED application,
+	so only the tick and the log task share the core with them. */
+	(void)x10seconds;
+	if (xRpuBenchInit(BENCH_TASK_PRIORITY, IPI_INTR_PRIORITY) != XST_SUCCESS) {
+		xil_printf("Benchmark setup failed\r\n");
+	}
+	vTaskStartScheduler();
+	for( ;; );
+#endif /* RPU_BENCH */
 
-	xil_printf( "LED blink example main\r\n" );
+#if RPU_MEMBENCH
+	/* Memory benchmark build (rpu_membench.h): the same, with its one task */
+	(void)x10seconds;
+	if (xRpuMemBenchInit(BENCH_TASK_PRIORITY) != XST_SUCCESS) {
+		xil_printf("Memory benchmark setup failed\r\n");
+	}
+	vTaskStartScheduler();
+	for( ;; );
+#endif /* RPU_MEMBENCH */
+
+#ifdef IPI_MODE
+	/* State of the image this one replaces (RPU_CMD_HANDOFF, rpu_handoff.h):
+	the LEDs still show its last value, so nothing is written to them here. */
+	if (xRpuHandoffResume(&xResume) == XST_SUCCESS && xResume.mode <= BLINK_RANDOM) {
+		xResumed = 1;
+		pxCfg = pxRpuConfigBegin(&ulCfgKey);
+		pxCfg->mode = xResume.mode;
+		pxCfg->override = xResume.override != 0;
+		vRpuConfigCommit(ulCfgKey, 1);
+		ulLedLast = xResume.led;
+#ifdef LEGACY_MODE
+		ulLegacyMode = xResume.legacy_mode;
+#endif /* LEGACY_MODE */
+		// The mode rotation keeps its schedule as well
+		if (xResume.rotate_ms < DELAY_10_SECONDS) {
+			ulFirstRotationMs = xResume.rotate_ms;
+		}
+	}
+	vRpuBootMark(RPU_BOOT_HANDOFF);
+#endif /* IPI_MODE */
+	xRotateStart = pdMS_TO_TICKS(ulFirstRotationMs) - x10seconds;
 
+#if RPU_EXEC
+	/* Executive build (rpu_exec.h): the tasks, the message buffer and the
+	mode timer become slots and event handlers of one loop, registered here
+	and released once vRpuExecRun() starts it. */
+	vRpuExecOn(RPU_EXEC_EV_CMD, prvIpiPass);
+	if (xRpuExecSlot(prvExecLedSlot, xResumed ? xResume.frame_ms * 1000 : 0,
+	                 EXEC_LED_PERIOD_US) != XST_SUCCESS ||
+	    xRpuExecSlot(prvRotateMode, ulFirstRotationMs * 1000,
+	                 DELAY_10_SECONDS * 1000) != XST_SUCCESS ||
+	    xRpuExecSlot(vRpuLogPoll, 0, EXEC_LOG_PERIOD_US) != XST_SUCCESS) {
+		xil_printf("Executive slot table full\r\n");
+	}
+#if RPU_UART_TELEMETRY
+	if (xRpuExecSlot(vRpuTelemPoll, 0, RPU_TELEM_PERIOD_MS * 1000) != XST_SUCCESS) {
+		xil_printf("Executive slot table full\r\n");
+	}
+#endif /* RPU_UART_TELEMETRY */
+	(void)x10seconds;
+#else
 	/* Create the two tasks.  The Tx task is given a lower priority than the
 	Rx task, so the Rx task will leave the Blocked state and pre-empt the Tx
-	task as soon as the Tx task places an item in the queue. */
-	xTaskCreate( 	prvTxTask, 					/* The function that implements the task. */
+	task as soon as the Tx task notifies it. */
+	xTxTask = xTaskCreateStatic( prvTxTask, 		/* The function that implements the task. */
 					( const char * ) "Tx", 		/* Text name for the task, provided to assist debugging only. */
 					configMINIMAL_STACK_SIZE, 	/* The stack allocated to the task. */
 					NULL, 						/* The task parameter is not used, so set to NULL. */
 					tskIDLE_PRIORITY,			/* The task runs at the idle priority. */
-					&xTxTask );
+					RPU_TASK_STACK_BUF(xTxStack),
+					&xTxTaskBuffer );
 
-	xTaskCreate( prvRxTask,
+	xRxTask = xTaskCreateStatic( prvRxTask,
 				 ( const char * ) "GB",
 				 configMINIMAL_STACK_SIZE,
 				 NULL,
 				 tskIDLE_PRIORITY + 1,
-				 &xRxTask );
+				 RPU_TASK_STACK_BUF(xRxStack),
+				 &xRxTaskBuffer );
 
-	/* Create the queue used by the tasks.  The Rx task has a higher priority
-	than the Tx task, so will preempt the Tx task and remove values from the
-	queue as soon as the Tx task writes to the queue - therefore the queue can
-	never have more than one item in it. */
-	xQueue = xQueueCreate( 	1,						/* There is only one space in the queue. */
-							sizeof( u32 ) );	/* Each space in the queue is large enough to hold a uint32_t. */
+#ifdef IPI_MODE
+	/* Create the IPI command task before the IPI is connected, so the handler
+	always has a task to notify. */
+	xIpiTask = xTaskCreateStatic( prvIpiTask,
+				 ( const char * ) "IPI",
+				 configMINIMAL_STACK_SIZE,
+				 NULL,
+				 IPI_TASK_PRIORITY,
+				 RPU_TASK_STACK_BUF(xIpiStack),
+				 &xIpiTaskBuffer );
+#endif /* IPI_MODE */
+
+	/* Create the message buffer used for RANDOM mode bursts. A message is
+	received whole or not at all, so the Rx task never sees part of a burst. */
+	xFrameBuffer = xMessageBufferCreateStatic( FRAME_BUFFER_SIZE,
+											   ucFrameBufferStorage,
+											   &xFrameBufferStruct );
 
-	/* Check the queue was created. */
-	configASSERT( xQueue );
+	/* Check the message buffer was created. */
+	configASSERT( xFrameBuffer );
 
+#if RPU_HWTIMER
+	/* The mode rotation runs on the hardware timer wheel (RPU_HWTIMER=1):
+	 * vModeTimerCallback expires every 10 seconds in the wheel interrupt,
+	 * independent of the timer service task and of the tick.
+	 */
+	if (xRpuHwTimerInit(HWTIMER_TASK_PRIORITY, TIMER_INTR_PRIORITY) != XST_SUCCESS) {
+		xil_printf("Hardware timer setup failed\r\n");
+	} else {
+		vRpuHwTimerSetup(&xModeTimer, vModeTimerCallback, NULL, 0);
+		vRpuHwTimerStart(&xModeTimer, RPU_HWTIMER_MS(ulFirstRotationMs), RPU_HWTIMER_MS(DELAY_10_SECONDS));
+	}
+#else
 	/* Create a timer that manages the LED Blink Mode state machine.
      * The timer expires every 10 seconds and triggers vTimerCallback to
      * switch between SLOW, FAST, and RANDOM modes.
-     * pdTRUE enables auto-reload, so the timer runs indefinitely.
+     * pdTRUE enables auto-reload, so the timer runs indefinitely. After a
+     * handoff the first period is what was left of the previous image's;
+     * vTimerCallback sets the 10 seconds again.
      */
-	xTimer = xTimerCreate( (const char *) "Timer",
-							x10seconds,
+	xTimer = xTimerCreateStatic( (const char *) "Timer",
+							pdMS_TO_TICKS(ulFirstRotationMs) > 0 ? pdMS_TO_TICKS(ulFirstRotationMs) : 1,
 							pdTRUE,
 							(void *) TIMER_ID,
-							vTimerCallback);
+							vTimerCallback,
+							&xTimerBuffer );
 	/* Check the timer was created. */
 	configASSERT( xTimer );
 
@@ -169,23 +561,96 @@ int main( void )
 	   as the schedule starts the timer will start running and will expire after
 	   10 seconds */
 	xTimerStart( xTimer, 0 );
+#endif /* RPU_HWTIMER */
+#endif /* RPU_EXEC */
+	vRpuBootMark(RPU_BOOT_TASKS);
 
 	// --- RPU Peripheral Initialization ---
     // Configure MPU for PL access (AXI GPIO)
     Xil_SetTlbAttributes(AXI_GPIO_BASE_ADDR, STRONG_ORDERD_SHARED | PRIV_RW_USER_RW);
+    if (XGpio_Initialize(&xGpio, AXI_GPIO_BASE_ADDR) != XST_SUCCESS) {
+        xil_printf("AXI GPIO not found at 0x%08x\r\n", AXI_GPIO_BASE_ADDR);
+    }
 
 #ifdef LEGACY_MODE
     // Configure MPU for Legacy Shared Memory Access (DDR) at 0x40000000
     Xil_SetTlbAttributes(LEGACY_SHARED_MEM_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
-    // Initialize Legacy Shared Memory
-    Xil_Out32(LEGACY_SHARED_MEM_ADDR, 3);
+    // Initialize the mailbox: mode released, every earlier generation processed
+    Xil_Out32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_MODE_OFFSET, ulLegacyMode);
+    Xil_Out32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_ACK_OFFSET,
+              Xil_In32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_GEN_OFFSET));
+    Xil_Out32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_POLL_OFFSET,
+              LEGACY_POLL_MS ? LEGACY_POLL_TICKS * 1000 / configTICK_RATE_HZ : 0);
+    __sync_synchronize();
+    Xil_Out32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_MAGIC_OFFSET, LEGACY_MBOX_MAGIC);
+
+#if RPU_EXEC
+    if (LEGACY_POLL_MS != 0) {
+        if (xRpuExecSlot(prvExecLegacyPoll, 0, LEGACY_POLL_MS * 1000) != XST_SUCCESS) {
+            xil_printf("Executive slot table full\r\n");
+        }
+    }
+#else
+    if (LEGACY_POLL_MS != 0) {
+        xLegacyPollTimer = xTimerCreateStatic( (const char *) "Mbox",
+                                               LEGACY_POLL_TICKS,
+                                               pdTRUE,
+                                               NULL,
+                                               vLegacyPollCallback,
+                                               &xLegacyPollTimerBuffer );
+        configASSERT( xLegacyPollTimer );
+        xTimerStart( xLegacyPollTimer, 0 );
+    }
+#endif /* RPU_EXEC */
 #endif /* LEGACY_MODE */
 
 #ifdef IPI_MODE
-    // Configure MPU for Shared Memory Access (OCM/DDR) at 0xFF990000
+    // Configure MPU for Shared Memory Access (OCM) at this core's window;
+    // with RPU_SHM_TCM it only holds the redirect, the TCM needs no entry
+    Xil_SetTlbAttributes(RPU_SHM_DEFAULT_BASE, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+#if RPU_CORE != 0
+    // The IPI message buffers stay in the IPI message RAM
     Xil_SetTlbAttributes(SHARED_MEM_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+#endif
     // Configure MPU for IPI Access (Map all relevant channels)
-    Xil_SetTlbAttributes(IPI_CH1_BASE, STRONG_ORDERD_SHARED | PRIV_RW_USER_RW);
+    Xil_SetTlbAttributes(IPI_CH_BASE, STRONG_ORDERD_SHARED | PRIV_RW_USER_RW);
+
+    // Reset the shared memory protocol state:
+    // - Mark the legacy slot as acknowledged so the first ring doorbell does
+    //   not replay whatever CMD word was left behind
+    // - Discard ring entries queued before this firmware instance started
+    Xil_Out32(RPU_SHM_BASE + SHM_ACK_SEQ_OFFSET,
+              Xil_In32(RPU_SHM_BASE + SHM_SEQ_OFFSET));
+    Xil_Out32(RPU_SHM_BASE + SHM_ACK_OFFSET, SHM_ACK_MAGIC);
+    Xil_Out32(RPU_SHM_BASE + SHM_RING_TAIL_OFFSET,
+              Xil_In32(RPU_SHM_BASE + SHM_RING_HEAD_OFFSET));
+    Xil_Out32(RPU_SHM_BASE + SHM_URING_TAIL_OFFSET,
+              Xil_In32(RPU_SHM_BASE + SHM_URING_HEAD_OFFSET));
+    // - Offer the whole ring until the first batch is measured
+    vRpuCreditInit();
+    // - Ask ring producers for a doorbell until the IPI task polls
+    Xil_Out32(RPU_SHM_BASE + SHM_RING_STATE_OFFSET, SHM_RING_STATE_IDLE);
+    // - Answer the last IPI message so it is not processed again
+    Xil_Out32(RPU_IPI_RESP_ADDR, Xil_In32(RPU_IPI_REQ_ADDR));
+    // - Publish the ABI header and the fast paths of this build (rpu_abi.h)
+    vRpuAbiInit();
+    vRpuTimeInit();
+    vRpuTraceInit();
+    vRpuStatsInit();
+    vRpuStatusInit();
+    vRpuIrqProfInit();    // RPU_IRQ_PROF only (rpu_irqprof.h)
+    // Multi-producer command channel (RPU_MPCMD=1, rpu_mpcmd.h)
+    if (xRpuMpCmdInit() != XST_SUCCESS) {
+        xil_printf("Multi-producer command channel setup failed\r\n");
+    }
+    // Where the APU finds the window, published once it is set up; cleared
+    // by a build without RPU_SHM_TCM (rpu_shm.h, "TCM variant")
+    Xil_Out32(RPU_SHM_DEFAULT_BASE + SHM_REDIRECT_ADDR_OFFSET,
+              RPU_SHM_TCM ? RPU_TCM_GLOBAL(RPU_SHM_BASE) : 0);
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_DEFAULT_BASE + SHM_REDIRECT_MAGIC_OFFSET,
+              RPU_SHM_TCM ? SHM_REDIRECT_MAGIC : 0);
+    vRpuBootMark(RPU_BOOT_SHM);
 
     // Initialize IPI following OpenAMP/libmetal pattern:
     // 1. Disable IPI interrupt (IDR)
@@ -193,40 +658,68 @@ int main( void )
     // 3. Register handler
     // 4. Enable interrupt (IER)
     
+    // The driver maps agent masks to their message buffers (xparameters.h)
+    XIpiPsu_Config *IpiCfg = XIpiPsu_LookupConfig(XPAR_XIPIPSU_0_BASEADDR);
+    if (IpiCfg == NULL ||
+        XIpiPsu_CfgInitialize(&xIpiInst, IpiCfg, IpiCfg->BaseAddress) != XST_SUCCESS) {
+        xil_printf("IPI message buffer setup failed\r\n");
+    }
+
+#if !RPU_IPI_FIQ
+    // Doorbells of the sources the IPI task serves; other peers register
+    // handlers of their own (rpu_ipisrc.h)
+    if (xRpuIpiSrcRegister(IPI_SRC_MASK, prvIpiSrcTask, NULL) != XST_SUCCESS) {
+        xil_printf("IPI source handler setup failed\r\n");
+    }
+#endif /* !RPU_IPI_FIQ */
+
     // Step 1: Disable IPI interrupt from APU (disable before setup)
-    Xil_Out32(IPI_CH1_BASE + IPI_IDR_OFFSET, APU_MASK);
+    Xil_Out32(IPI_CH_BASE + IPI_IDR_OFFSET, IPI_SRC_MASK);
     
     // Step 2: Clear any old IPI interrupt (clear all possible sources)
-    Xil_Out32(IPI_CH1_BASE + IPI_ISR_OFFSET, 0xFFFFFFFF);
+    Xil_Out32(IPI_CH_BASE + IPI_ISR_OFFSET, 0xFFFFFFFF);
     
     // Small delay to ensure registers settle
     volatile int delay;
     for(delay=0; delay<1000; delay++);
     
     // Step 3: Connect IPI Interrupt using Wrapper
-    // Encoded ID for Level Sensitive High (Trigger = 4)
-    // ID 65 | (4 << 12) = 0x4041
-    u32 IpiIntrId = IPI_INT_ID | (4 << 12);
+    // Encoded ID for Level Sensitive High (Trigger = 4); the wrapper takes the
+    // SPI number and adds 32 itself: ID 65 = SPI 33 -> 0x4021 (as xipipsu_g.c)
+    u32 IpiIntrId = (IPI_INT_ID - 32) | (4 << 12);
     
-    xil_printf("Connecting IPI Interrupt (ID %d, Encoded: 0x%X)...\r\n", IPI_INT_ID, IpiIntrId);
+    RPU_BOOT_PRINT("Connecting IPI Interrupt (ID %d, Encoded: 0x%X)...\r\n", IPI_INT_ID, IpiIntrId);
     
+#if RPU_IPI_FIQ
+    // The doorbell goes to IPI_FiqHandler; IPI_Handler becomes the IRQ side,
+    // woken by the SGI the FIQ handler pends (rpu_fiq.h)
+    u32 WakeIntrId = RPU_FIQ_WAKE_SGI | XINTC_IS_SGI_INTR_MASK;
+    int Status = XSetupInterruptSystem(NULL, (Xil_ExceptionHandler)IPI_Handler,
+                                       WakeIntrId, IPI_INTC_PARENT, IPI_INTR_PRIORITY);
+    if (Status == XST_SUCCESS) {
+        XEnableIntrId(WakeIntrId, IPI_INTC_PARENT);
+        Status = xRpuFiqInit(IpiIntrId, IPI_INTC_PARENT,
+                             (Xil_ExceptionHandler)IPI_FiqHandler, NULL);
+    }
+#else
     int Status = XSetupInterruptSystem(NULL, (Xil_ExceptionHandler)IPI_Handler, 
-                                     IpiIntrId, IPI_INTC_PARENT, 0x00);
+                                     IpiIntrId, IPI_INTC_PARENT, IPI_INTR_PRIORITY);
+#endif /* RPU_IPI_FIQ */
     
     if (Status != XST_SUCCESS) {
         xil_printf("IPI Interrupt Connect Failed (Status: %d)\r\n", Status);
     } else {
-        xil_printf("IPI Interrupt Connected successfully (ID %d)\r\n", IPI_INT_ID);
+        RPU_BOOT_PRINT("IPI Interrupt Connected successfully (ID %d)\r\n", IPI_INT_ID);
         
         // Step 4: Enable IPI Interrupt from APU in the IPI Controller (IER)
         // Note: IER is write-only, so we can't read it back
-        Xil_Out32(IPI_CH1_BASE + IPI_IER_OFFSET, APU_MASK);
+        Xil_Out32(IPI_CH_BASE + IPI_IER_OFFSET, IPI_SRC_MASK | ulRpuIpiSrcMask());
         
         // Verify interrupt is enabled by checking IMR (Interrupt Mask Register)
         // IMR bit 0 = 0 means interrupt is enabled (not masked)
-        u32 imr_val = Xil_In32(IPI_CH1_BASE + IPI_IMR_OFFSET);
+        u32 imr_val = Xil_In32(IPI_CH_BASE + IPI_IMR_OFFSET);
         if ((imr_val & APU_MASK) == 0) {
-            xil_printf("IPI Enabled successfully\r\n");
+            RPU_BOOT_PRINT("IPI Enabled successfully\r\n");
         } else {
             xil_printf("WARNING: IPI may not be enabled\r\n");
         }
@@ -234,22 +727,141 @@ int main( void )
         // Explicitly enable in GIC
         XEnableIntrId(IpiIntrId, IPI_INTC_PARENT);
         
-        // Clear any pending interrupts
-        u32 isr_final = Xil_In32(IPI_CH1_BASE + IPI_ISR_OFFSET);
+        // Clear pending interrupts of sources nobody serves; a doorbell of
+        // a served one since step 2 is taken once the scheduler runs
+        u32 isr_final = Xil_In32(IPI_CH_BASE + IPI_ISR_OFFSET) &
+                        ~(IPI_SRC_MASK | ulRpuIpiSrcMask());
         if (isr_final != 0) {
-            Xil_Out32(IPI_CH1_BASE + IPI_ISR_OFFSET, 0xFFFFFFFF);
+            Xil_Out32(IPI_CH_BASE + IPI_ISR_OFFSET, isr_final);
         }
     }
+
+    // Time-triggered commands (RPU_CMD_AT, rpu_timed.h) wake the IPI task
+    Status = xRpuTimedInit(xIpiTask, TIMED_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Timed command setup failed (Status: %d)\r\n", Status);
+    }
+
+    vRpuBootMark(RPU_BOOT_IPI);
+
+    // Waveform engine: TTC counter for GPIO sample playback (RPU_CMD_WAVE);
+    // with RPU_FAST_BOOT=1 the first start sets it up (prvWaveInit)
+#if RPU_BOOT_LAZY_WAVE
+    Xil_Out32(RPU_SHM_BASE + SHM_WAVE_STATE_OFFSET, RPU_WAVE_STATE_IDLE);
+#else
+    prvWaveInit();
+#endif /* RPU_BOOT_LAZY_WAVE */
+
+#if !RPU_EXEC
+    // Bulk channel: DMA between the DDR carveout and TCM (rpu_bulk.h); the
+    // executive build does not serve it, its DMA completions notify tasks
+    Status = xRpuBulkInit(BULK_TASK_PRIORITY, DMA_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Bulk channel setup failed (Status: %d)\r\n", Status);
+    }
+    // CSU DMA checksums of BULK_OP_CHECKSUM (rpu_csum.h); they fail without it
+    Status = xRpuCsumInit(DMA_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        xil_printf("CSU DMA checksum setup failed (Status: %d)\r\n", Status);
+    }
+    // Striped DMA copies over the copy channels of this core (rpu_dmacopy.h)
+    Status = xRpuDmaCopyInit(DMA_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        xil_printf("DMA copy setup failed (Status: %d)\r\n", Status);
+    }
+#endif /* !RPU_EXEC */
+    // Interconnect monitors (RPU_APM=1, rpu_apm.h)
+    Status = xRpuApmInit(APM_TASK_PRIORITY, DMA_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        xil_printf("APM setup failed (Status: %d)\r\n", Status);
+    }
+    // DDR QoS profile of the PL ports (RPU_QOS=1, rpu_qos.h)
+    Status = xRpuQosInit();
+    if (Status != XST_SUCCESS) {
+        xil_printf("QoS setup failed (Status: %d)\r\n", Status);
+    }
+    // Temperature and supply monitoring (RPU_SYSMON=1, rpu_sysmon.h)
+    Status = xRpuSysmonInit(SYSMON_TASK_PRIORITY, SYSMON_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        xil_printf("SYSMON setup failed (Status: %d)\r\n", Status);
+    }
+    // Sensor acquisition over I2C or SPI (RPU_SENSOR=1, rpu_sensor.h)
+    Status = xRpuSensorInit(SENSOR_TASK_PRIORITY, SENSOR_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Sensor setup failed (Status: %d)\r\n", Status);
+    }
+    // Clock scaling while only the SLOW blink runs (RPU_GOVERNOR=1, rpu_gov.h)
+    Status = xRpuGovInit(prvGovIdle);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Governor setup failed (Status: %d)\r\n", Status);
+    }
+    // Deadline supervision with the LPD watchdog (RPU_WATCHDOG=1, rpu_wdog.h)
+    Status = xRpuWdogInit();
+    if (Status != XST_SUCCESS) {
+        xil_printf("Watchdog setup failed (Status: %d)\r\n", Status);
+    }
+
+    // RPMsg transport (RPU_RPMSG=1, rpu_rpmsg.h): same executor as the messages
+    Status = xRpuRpmsgInit(prvExecCommand, RPMSG_TASK_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        xil_printf("RPMsg setup failed (Status: %d)\r\n", Status);
+    }
+    vRpuBootMark(RPU_BOOT_DRIVERS);
 #endif /* IPI_MODE */
 
 
     // 1. Set the GPIO direction to OUTPUT (clear the tri-state register)
-    Xil_Out32(AXI_GPIO_BASE_ADDR + GPIO_TRI_OFFSET, 0x0);
+    XGpio_SetDataDirection(&xGpio, 1, 0x0);
+    // 2. Channel 2 input events (RPU_GPIO_IN=1, rpu_gpioin.h)
+    if (xRpuGpioInInit(&xGpio, GPIO_IN_TASK_PRIORITY, GPIO_INTR_PRIORITY) != XST_SUCCESS) {
+        xil_printf("GPIO input setup failed\r\n");
+    }
+    // 3. LED output backend of the Rx task (RPU_LED_PS_GPIO=1 for the PS GPIO, rpu_led.h)
+    if (xRpuLedInit(&xGpio) != XST_SUCCESS) {
+        xil_printf("PS GPIO LED output setup failed\r\n");
+    }
+    // 4. SLOW/FAST on a TTC waveform output (RPU_TTC_WAVE=1, rpu_ttcwave.h)
+    if (xRpuTtcWaveInit(xGpio.BaseAddress + XGPIO_DATA_OFFSET) != XST_SUCCESS) {
+        xil_printf("TTC waveform output setup failed\r\n");
+    }
 
-    xil_printf( "GPIO initialized. Starting scheduler.\r\n" );
+    // Buffered console (RPU_UART_TX=1, rpu_uart.h): output stays polled until the scheduler runs
+    if (xRpuUartTxInit(UART_INTR_PRIORITY) != XST_SUCCESS) {
+        xil_printf("Console TX interrupt setup failed\r\n");
+    }
+    // Binary telemetry frames on the console (RPU_UART_TELEMETRY=1, rpu_telem.h)
+    if (xRpuTelemInit(TELEM_TASK_PRIORITY) != XST_SUCCESS) {
+        xil_printf("Telemetry setup failed\r\n");
+    }
+    // PC-sampling profiler (RPU_PC_PROF=1, rpu_pcprof.h): samples once the scheduler runs
+    if (xRpuPcProfInit(PCPROF_INTR_PRIORITY) != XST_SUCCESS) {
+        xil_printf("PC profiler setup failed\r\n");
+    }
+    // usleep()/msleep() that block instead of spinning (RPU_SLEEP_YIELD=1, rpu_sleep.h)
+    if (xRpuSleepInit(SLEEP_INTR_PRIORITY) != XST_SUCCESS) {
+        xil_printf("Sleep timer setup failed\r\n");
+    }
+    // Messages to and from the other R5 in split mode (RPU_XCORE=1, rpu_xcore.h)
+    if (xRpuXcoreInit(XCORE_TASK_PRIORITY, XCORE_INTR_PRIORITY) != XST_SUCCESS) {
+        xil_printf("Inter-R5 messaging setup failed\r\n");
+    }
+    // interrupt_gen events handled on the R5 (RPU_PL_INTR=1, rpu_plintr.h)
+    if (xRpuPlIntrInit(PL_INTR_PRIORITY) != XST_SUCCESS) {
+        xil_printf("PL interrupt setup failed\r\n");
+    }
 
+    RPU_BOOT_PRINT( "GPIO initialized. Starting scheduler.\r\n" );
+    vRpuBootMark(RPU_BOOT_GPIO);
+
+#if RPU_EXEC
+	/* No scheduler: the IPI task's start-up report, then the loop */
+	vRpuBootReport();
+	vRpuAbiReady();
+	vRpuExecRun();
+#else
 	/* Start the tasks and timer running. */
 	vTaskStartScheduler();
+#endif /* RPU_EXEC */
 
 	/* If all is well, the scheduler will now be running, and the following line
 	will never be reached. */
@@ -257,160 +869,1260 @@ int main( void )
 }
 
 
+#if !RPU_EXEC
 /*-----------------------------------------------------------*/
 /* The Tx Task:
- * - Generates LED patterns based on the current `current_blink_mode`.
+ * - Generates LED patterns based on the blink mode of the active config block
+ *   (rpu_config.h), flipped to the latest one before each frame.
+ * - Runs on absolute deadlines (xTaskDelayUntil()): the next frame is computed
+ *   before the task sleeps, so it goes out as soon as its tick comes and the
+ *   edges stay phase-locked however long the pattern runs.
  */
 static void prvTxTask( void *pvParameters )
 {
 	(void)pvParameters;
-	TickType_t xDelay;
+	TickType_t xLastWake;
+	TickType_t xPeriod = 0;
     u32 led_val = 0x1;
+    u32 notify = 0;
+    u32 wave_ms;
+    LedFrame_t burst[RANDOM_BURST_FRAMES];
+    size_t burst_len = sizeof(burst);
+    TickType_t xLead = portMAX_DELAY;
+    TickType_t xPatternHold = 0;
+    TickType_t xHeld;
+    const RpuConfig_t *pxCfg;
+    RpuRand_t xRng;
+    int i;
 
-    xil_printf("Tx Task Started\r\n");
+    RPU_LOG("Tx Task Started\r\n");
 
+    vRpuRandSeed(&xRng, RPU_RAND_SEED);
+    xLastWake = xTaskGetTickCount();
+    vRpuEdgeRestart();
+#ifdef IPI_MODE
+    if (xResumed) {
+        // Continue the previous image's pattern: from the value on the LEDs,
+        // with the first frame due when its next one was
+        led_val = xResume.led;
+        xLead = pdMS_TO_TICKS(xResume.frame_ms);
+    }
+#endif /* IPI_MODE */
 	for( ;; )
 	{
-        switch (current_blink_mode) {
+#ifdef IPI_MODE
+        if (ulRandReseed) {
+            // RPU_CMD_SEED (IPI task): the frames computed from here on
+            taskENTER_CRITICAL();
+            vRpuRandSeed(&xRng, ulRandSeed);
+            ulRandReseed = 0;
+            taskEXIT_CRITICAL();
+        }
+#endif /* IPI_MODE */
+        // Next frame, from the config in force now; it is sent at xLastWake + xPeriod
+        pxCfg = pxRpuConfigFlip();
+        xHeld = xPatternHold;
+        xPatternHold = 0;
+        wave_ms = 0;
+        switch ((BlinkMode_t)pxCfg->mode) {
             case BLINK_SLOW:
-                xDelay = pdMS_TO_TICKS(1000);
+                wave_ms = 1000;
+                xPeriod = pdMS_TO_TICKS(1000);
                 led_val = (led_val == 0x1) ? 0x2 : 0x1;
+                notify = RX_NOTIFY_FRAME | (led_val & RX_FRAME_MASK);
                 break;
             case BLINK_FAST:
-                xDelay = pdMS_TO_TICKS(200);
+                wave_ms = 200;
+                xPeriod = pdMS_TO_TICKS(200);
                 led_val = (led_val == 0x1) ? 0x2 : 0x1;
+                notify = RX_NOTIFY_FRAME | (led_val & RX_FRAME_MASK);
                 break;
             case BLINK_RANDOM:
-                xDelay = pdMS_TO_TICKS(200);
-                led_val = rand() % 4;
+                // A whole burst, with the next deadline at its end
+                for (i = 0; i < RANDOM_BURST_FRAMES; i++) {
+#if RPU_LED_BANKS
+                    vRpuBankRandom(&burst[i].bits, &xRng);
+                    burst[i].value = ulRpuBankLeds(&burst[i].bits);
+#else
+                    burst[i].value = ulRpuRandBelow(&xRng, 4);
+#endif /* RPU_LED_BANKS */
+                    burst[i].hold_ms = RANDOM_FRAME_MS;
+                }
+                xPeriod = pdMS_TO_TICKS(RANDOM_BURST_FRAMES * RANDOM_FRAME_MS);
+                burst_len = sizeof(burst);
+                notify = RX_NOTIFY_BATCH;
                 break;
+#ifdef IPI_MODE
+            case BLINK_PATTERN:
+                // Due once the burst sent last was held; the first one goes
+                // out at the next tick
+                xPeriod = (xHeld != 0) ? xHeld : 1;
+                for (i = 0; i < RANDOM_BURST_FRAMES &&
+                            xRpuPatternNext(&xRng, &burst[i].value, &burst[i].hold_ms); i++) {
+                    xPatternHold += pdMS_TO_TICKS(burst[i].hold_ms);
+#if RPU_LED_BANKS
+                    vRpuBankFill(&burst[i].bits, burst[i].value);
+#endif /* RPU_LED_BANKS */
+                }
+                if (i == 0) {
+                    // END (or stop): back to the mode from before the start
+                    prvPatternEnd();
+                    notify = 0;
+                } else {
+                    burst_len = i * sizeof(LedFrame_t);
+                    notify = RX_NOTIFY_BATCH;
+                }
+                break;
+#endif /* IPI_MODE */
             default:
-                xDelay = pdMS_TO_TICKS(1000);
+                xPeriod = pdMS_TO_TICKS(1000);
+                notify = 0;
                 break;
         }
+        if (xLead < xPeriod) {
+            xLastWake -= xPeriod - xLead;
+        }
+        xLead = portMAX_DELAY;
+        xTxNextWake = xLastWake + xPeriod;
 
-		vTaskDelay( xDelay );
+        BaseType_t xOnTime = xTaskDelayUntil(&xLastWake, xPeriod);
+        vRpuWdogTicks(WDOG_TASK_TX, xLastWake);
+        if (xOnTime == pdFALSE) {
+            // Deadline already missed (the task was starved): re-anchor rather
+            // than send the frames that are late back to back
+            xLastWake = xTaskGetTickCount();
+            vRpuEdgeRestart();
+        }
+        xTxDeadline = xLastWake;
 
-		xQueueSend( xQueue, &led_val, 0UL );
+        if (ulHandedOff) {
+            // The next image continues the pattern (rpu_handoff.h)
+            continue;
+        }
+        if (prvTtcWaveFrame(wave_ms, led_val)) {
+            // The counter draws the frame: nothing for the Rx task
+            notify = 0;
+        }
+        if (notify == RX_NOTIFY_BATCH) {
+            if (xMessageBufferSend(xFrameBuffer, burst, burst_len, 0) == burst_len) {
+                xTaskNotify(xRxTask, RX_NOTIFY_BATCH, eSetBits);
+            }
+        } else if (notify != 0) {
+            // A newer value simply replaces one the Rx task has not taken yet
+            xTaskNotify(xRxTask, notify, eSetValueWithOverwrite);
+        }
 	}
 }
 
 /*-----------------------------------------------------------*/
 /* The Rx Task:
- * - Writes the received LED status value directly to the AXI GPIO hardware.
+ * - Writes single LED values from its notification value and bursts from
+ *   xFrameBuffer directly to the AXI GPIO hardware.
  */
 static void prvRxTask( void *pvParameters )
 {
 	(void)pvParameters;
-    u32 received_led_status;
+    uint32_t notify;
+    LedFrame_t burst[RANDOM_BURST_FRAMES];
+    TickType_t xWake;
+    size_t len, i;
 
-    xil_printf("Rx Task Started\r\n");
+    RPU_LOG("Rx Task Started\r\n");
 
 	for( ;; )
 	{
-		xQueueReceive( 	xQueue,
-						&received_led_status,
-						portMAX_DELAY );
+		xTaskNotifyWait( 0, 0xFFFFFFFFUL, &notify, portMAX_DELAY );
+
+        if (notify & RX_NOTIFY_FRAME) {
+            prvLedWrite(notify & RX_FRAME_MASK, NULL, 0, xTxDeadline);
+        }
 
-        Xil_Out32(AXI_GPIO_BASE_ADDR + GPIO_DATA_OFFSET, received_led_status);
+        // Drain bursts on every wake-up: a single-frame notification sent with
+        // eSetValueWithOverwrite may have replaced the RX_NOTIFY_BATCH bit.
+        // Frames are held on absolute deadlines from the Tx task's.
+        xWake = xTxDeadline;
+        while ((len = xMessageBufferReceive(xFrameBuffer, burst, sizeof(burst), 0)) != 0) {
+            for (i = 0; i < len / sizeof(LedFrame_t); i++) {
+                prvLedWrite(burst[i].value, LED_FRAME_BITS(&burst[i]), 1, xWake);
+                xTaskDelayUntil(&xWake, pdMS_TO_TICKS(burst[i].hold_ms));
+            }
+        }
 	}
 }
+#endif /* !RPU_EXEC */
+
+#if RPU_EXEC
+/*-----------------------------------------------------------*/
+/* The LED slot of the executive (RPU_EXEC=1): the Tx and Rx tasks in one
+ * - Released every EXEC_LED_PERIOD_US; writes only when the next frame or
+ *   the next value of a burst is due, on absolute system counter deadlines
+ *   as the tasks' xTaskDelayUntil(), re-anchored when one was missed
+ * - The same modes, pattern programs and RPU_CMD_SEED as prvTxTask
+ */
+static void prvExecLedSlot(void)
+{
+    static LedFrame_t burst[RANDOM_BURST_FRAMES];
+    static u32 count, next;
+    static u32 led_val = 0x1;
+    static u64 due;
+    static int started;
+    static RpuRand_t xRng;
+    const u64 ms = ulRpuTimeHz() / 1000;
+    const RpuConfig_t *pxCfg;
+    u64 now = ullRpuTimeNow();
+    u32 period_ms;
+
+    if (!started) {
+        started = 1;
+        vRpuRandSeed(&xRng, RPU_RAND_SEED);
+        if (xResumed) {
+            led_val = xResume.led;
+        }
+        due = now;
+    }
+    if ((s64)(now - due) < 0) {
+        return;
+    }
+    if ((s64)(now - due) >= (s64)(RANDOM_FRAME_MS * ms)) {
+        // Too late for the frame: its successors keep their spacing from now
+        due = now;
+    }
+
+    // The rest of a burst first; the Rx task held it the same way
+    if (next < count) {
+        prvLedWrite(burst[next].value, LED_FRAME_BITS(&burst[next]), 1, 0);
+        due += burst[next].hold_ms * ms;
+        next++;
+        return;
+    }
+    count = 0;
+    next = 0;
+
+    if (ulRandReseed) {
+        // RPU_CMD_SEED, from an IPI pass: never during this slot
+        vRpuRandSeed(&xRng, ulRandSeed);
+        ulRandReseed = 0;
+    }
+    pxCfg = pxRpuConfigFlip();
+    if (pxCfg->mode != BLINK_SLOW && pxCfg->mode != BLINK_FAST) {
+        prvTtcWaveRelease();
+    }
+    switch ((BlinkMode_t)pxCfg->mode) {
+        case BLINK_SLOW:
+        case BLINK_FAST:
+            period_ms = (pxCfg->mode == BLINK_SLOW) ? 1000 : 200;
+            led_val = (led_val == 0x1) ? 0x2 : 0x1;
+            if (!prvTtcWaveFrame(period_ms, led_val)) {
+                prvLedWrite(led_val, NULL, 0, 0);
+            }
+            break;
+        case BLINK_RANDOM:
+            for (count = 0; count < RANDOM_BURST_FRAMES; count++) {
+#if RPU_LED_BANKS
+                vRpuBankRandom(&burst[count].bits, &xRng);
+                burst[count].value = ulRpuBankLeds(&burst[count].bits);
+#else
+                burst[count].value = ulRpuRandBelow(&xRng, 4);
+#endif /* RPU_LED_BANKS */
+                burst[count].hold_ms = RANDOM_FRAME_MS;
+            }
+            period_ms = 0;
+            break;
+        case BLINK_PATTERN:
+            while (count < RANDOM_BURST_FRAMES &&
+                   xRpuPatternNext(&xRng, &burst[count].value, &burst[count].hold_ms)) {
+#if RPU_LED_BANKS
+                vRpuBankFill(&burst[count].bits, burst[count].value);
+#endif /* RPU_LED_BANKS */
+                count++;
+            }
+            if (count == 0) {
+                // END (or stop): the previous mode from the next release
+                prvPatternEnd();
+            }
+            period_ms = 0;
+            break;
+        default:
+            period_ms = 1000;
+            break;
+    }
+    if (count != 0) {
+        prvLedWrite(burst[0].value, LED_FRAME_BITS(&burst[0]), 1, 0);
+        due += burst[0].hold_ms * ms;
+        next = 1;
+    } else {
+        due += period_ms * ms;
+    }
+}
+#endif /* RPU_EXEC */
+
+/*-----------------------------------------------------------*/
+/* Write one Rx task value to the LEDs (src: 0 = single, 1 = burst), due at
+ * tick deadline; the backend is the AXI GPIO or the PS GPIO (rpu_led.h)
+ * - With RPU_LED_BANKS=1, bits are all the channels of the frame, NULL to
+ *   repeat value on every group of them (rpu_bank.h)
+ * - Skipped while the waveform engine owns the GPIO
+ */
+RPU_ATCM_TEXT static void prvLedWrite(u32 value, const RpuBankFrame_t *bits, u32 src, TickType_t deadline)
+{
+    vRpuWdogTicks(WDOG_TASK_RX, deadline);
+#ifdef IPI_MODE
+    if (xRpuWaveActive()) {
+        return;
+    }
+    // A handoff (IPI task, higher priority) must not come between the check
+    // and the write, or the saved value would not be the one on the LEDs
+    taskENTER_CRITICAL();
+    if (ulHandedOff) {
+        taskEXIT_CRITICAL();
+        return;
+    }
+    vRpuLedWriteFrame(value, bits);
+    ulLedLast = value;
+    taskEXIT_CRITICAL();
+    vRpuStatusFrame(value);
+#else
+    vRpuLedWriteFrame(value, bits);
+    ulLedLast = value;
+#endif /* IPI_MODE */
+    vRpuEdgeRecord(deadline);
+#ifdef IPI_MODE
+    vRpuTrace(RPU_TRACE_GPIO_WRITE, value, src);
+#endif /* IPI_MODE */
+}
+
+/*-----------------------------------------------------------*/
+/* SLOW/FAST frame on the TTC waveform output (RPU_TTC_WAVE=1, rpu_ttcwave.h):
+ * 1 if the counter draws it, half_ms per value from led on; 0 if it is to be
+ * written, with the pins back on the AXI GPIO (half_ms 0: another mode) */
+static int prvTtcWaveFrame(u32 half_ms, u32 led)
+{
+#if RPU_TTC_WAVE
+    int drawn = 0;
+
+    if (half_ms != 0) {
+#ifdef IPI_MODE
+        drawn = !ulHandedOff && !xRpuWaveActive() && xRpuTtcWaveSet(half_ms, led) == XST_SUCCESS;
+#else
+        drawn = xRpuTtcWaveSet(half_ms, led) == XST_SUCCESS;
+#endif /* IPI_MODE */
+    }
+    if (drawn) {
+        ulLedLast = led;
+#ifdef IPI_MODE
+        vRpuStatusFrame(led);
+#endif /* IPI_MODE */
+        return 1;
+    }
+    prvTtcWaveRelease();
+#else
+    (void)half_ms;
+    (void)led;
+#endif /* RPU_TTC_WAVE */
+    return 0;
+}
+
+/* Give the LED pins back to the AXI GPIO at the level the wave left */
+static void prvTtcWaveRelease(void)
+{
+    u32 value;
+
+    if (xRpuTtcWaveRelease(&value)) {
+        ulLedLast = value;
+    }
+}
 
 /*-----------------------------------------------------------*/
 /* The Timer Callback:
  * - Manages internal state machine if APU override is not active.
+ * - With RPU_HWTIMER=1 it runs in the wheel interrupt; RPU_LOG() and the
+ *   legacy mailbox read are safe there.
  */
+#if RPU_HWTIMER
+RPU_ATCM_TEXT static void vModeTimerCallback( RpuHwTimer_t *pxTimer, void *pvArg )
+{
+    (void)pxTimer;
+    (void)pvArg;
+    prvRotateMode();
+}
+#elif !RPU_EXEC
 static void vTimerCallback( TimerHandle_t pxTimer )
 {
-    u32 legacy_val;
 	configASSERT( pxTimer );
+    if (xTimerGetPeriod(pxTimer) != pdMS_TO_TICKS(DELAY_10_SECONDS)) {
+        // First, shortened period after a handoff
+        xTimerChangePeriod(pxTimer, pdMS_TO_TICKS(DELAY_10_SECONDS), 0);
+    }
+    prvRotateMode();
+}
+#endif /* RPU_HWTIMER */
+
+static void prvRotateMode(void)
+{
+    static const char * const pcModeName[] = { "SLOW", "FAST", "RANDOM" };
+    RpuConfig_t *cfg;
+    u32 key, mode;
+    int changed = 0;
+#if defined(LEGACY_MODE)
+    u32 legacy_val;
+#endif /* LEGACY_MODE */
+
+#if RPU_HWTIMER
+    xRotateStart = xTaskGetTickCountFromISR();
+#else
+    xRotateStart = xTaskGetTickCount();
+#endif /* RPU_HWTIMER */
 
-    // Only rotate modes if APU IPI override is NOT active
-    if (!apu_override_active) {
+    if (ulHandedOff) {
+        return;
+    }
+#if defined(LEGACY_MODE)
+    // Check Legacy Shared Memory (non-cacheable, no maintenance needed)
+    legacy_val = Xil_In32(LEGACY_SHARED_MEM_ADDR);
+#endif /* LEGACY_MODE */
+
+    // Only rotate modes if APU IPI override is NOT active; the logging
+    // waits until the config is committed
+    cfg = pxRpuConfigBegin(&key);
+    if (!cfg->override) {
 #if defined(LEGACY_MODE)
-        // Check Legacy Shared Memory
-        Xil_DCacheInvalidateRange(LEGACY_SHARED_MEM_ADDR, 32);
-        legacy_val = Xil_In32(LEGACY_SHARED_MEM_ADDR);
         if (legacy_val <= 2) {
-             if ((BlinkMode_t)legacy_val != current_blink_mode) {
-                 current_blink_mode = (BlinkMode_t)legacy_val;
-                 xil_printf("Timer: Legacy Shared Mem set mode to %d\r\n", current_blink_mode);
-             }
+            if (legacy_val != cfg->mode) {
+                cfg->mode = legacy_val;
+                changed = 2;
+            }
+        } else
 #endif /* LEGACY_MODE */
-        } else {
+        {
             // No legacy override, proceed with rotation
-            if (current_blink_mode == BLINK_SLOW) {
-                current_blink_mode = BLINK_FAST;
-                xil_printf("Timer: Switching to FAST mode\r\n");
-            } else if (current_blink_mode == BLINK_FAST) {
-                current_blink_mode = BLINK_RANDOM;
-                xil_printf("Timer: Switching to RANDOM mode\r\n");
+            if (cfg->mode == BLINK_SLOW) {
+                cfg->mode = BLINK_FAST;
+            } else if (cfg->mode == BLINK_FAST) {
+                cfg->mode = BLINK_RANDOM;
             } else {
-                current_blink_mode = BLINK_SLOW;
-                xil_printf("Timer: Switching to SLOW mode\r\n");
+                cfg->mode = BLINK_SLOW;
             }
+            changed = 1;
         }
     }
+    mode = cfg->mode;
+    vRpuConfigCommit(key, changed);
+
+    if (changed == 2) {
+        RPU_LOG("Timer: Legacy Shared Mem set mode to %d\r\n", mode);
+    } else if (changed) {
+        RPU_LOG("Timer: Switching to %s mode\r\n", pcModeName[mode]);
+    }
 }
 
 #ifdef IPI_MODE
 /*-----------------------------------------------------------*/
-/* IPI Interrupt Handler - Following OpenAMP/libmetal pattern */
-static void IPI_Handler(void *CallbackRef) {
+/* IPI Interrupt Handler - Following OpenAMP/libmetal pattern
+ * - Only masks the doorbell and defers the command to prvIpiTask, so IRQ
+ *   latency does not depend on UART output or command parsing. The task
+ *   clears and unmasks it once everything is drained (prvIpiRearm)
+ * - Runs from ATCM (rpu_tcm.h) with the rest of the interrupt entry
+ * - With RPU_IPI_FIQ=1 it serves the wake SGI of IPI_FiqHandler instead
+ */
+RPU_ATCM_TEXT static void IPI_Handler(void *CallbackRef) {
+    u32 entry = ulRpuIrqProfCycles();  // RPU_IRQ_PROF: first thing in the handler
     (void)CallbackRef;
-    
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    // RPU_GOVERNOR: full clock back before the command is looked at
+    vRpuGovWakeFromIsr();
+
+#if RPU_IPI_FIQ
+    // The wake SGI: IPI_FiqHandler took and cleared the doorbell already
+    (void)entry;
+    vRpuWdogArmFromIsr(WDOG_TASK_CMD);
+    vTaskNotifyGiveFromISR(xIpiTask, &xHigherPriorityTaskWoken);
+#else
     // Read ISR IMMEDIATELY (before any other operations) to check if interrupt is pending
     // Use memory barrier to ensure we read the actual hardware state
     __sync_synchronize();
-    u32 isr = Xil_In32(IPI_CH1_BASE + IPI_ISR_OFFSET);
-    
-    // If ISR is 0, this is a spurious interrupt - clear and return immediately
-    // This can happen at startup or from other interrupt sources sharing the same ID
-    if (isr == 0) {
-        // Don't print for spurious interrupts to avoid console spam
-        // Just clear any potential stuck state and return
-        Xil_Out32(IPI_CH1_BASE + IPI_ISR_OFFSET, 0xFFFFFFFF);
-        return;
+    u32 isr = Xil_In32(IPI_CH_BASE + IPI_ISR_OFFSET);
+
+    // ISR 0 is a spurious interrupt, e.g. at startup
+    if (isr != 0) {
+        vRpuTrace(RPU_TRACE_IPI_RX, isr, isr & ~ulRpuIpiSrcMask());
     }
-    
-    xil_printf("*** IPI Handler Called! ISR=0x%X ***\r\n", isr);
-    
-    // Check if APU (Bit 0) triggered the interrupt
+    // Each pending source to its handler: APU and RPU1 go to prvIpiSrcTask,
+    // bits without a handler are cleared alone
+    if (ulRpuIpiSrcDispatch(isr, &xHigherPriorityTaskWoken) & IPI_SRC_MASK) {
+        vRpuIrqProfIsr(entry);
+    }
+#endif /* RPU_IPI_FIQ */
+
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+#if !RPU_IPI_FIQ
+/*-----------------------------------------------------------*/
+/* Doorbell of a source the IPI task serves (IPI_SRC_MASK), from
+ * ulRpuIpiSrcDispatch()
+ * - Masks rather than clears: doorbells arriving while the task polls only
+ *   latch ISR, and the task clears it on each pass
+ */
+RPU_ATCM_TEXT static void prvIpiSrcTask(u32 src, void *arg, BaseType_t *pxWoken) {
+    (void)src;
+    (void)arg;
+
+    Xil_Out32(IPI_CH_BASE + IPI_IDR_OFFSET, IPI_SRC_MASK);
+
+    // Doorbells arriving before the task runs coalesce into one pass,
+    // which drains everything pending anyway
+    vRpuWdogArmFromIsr(WDOG_TASK_CMD);  // RPU_WATCHDOG: served by the end of the pass
+    vRpuExecNotifyFromIsr(xIpiTask, pxWoken);
+}
+#endif /* !RPU_IPI_FIQ */
+
+#if RPU_IPI_FIQ
+/*-----------------------------------------------------------*/
+/* IPI FIQ Handler (RPU_IPI_FIQ=1, rpu_fiq.h)
+ * - Entered from the FIQ vector without the FreeRTOS interrupt entry, even
+ *   inside critical sections: no FreeRTOS calls, no logging, no FPU
+ * - Acknowledges the legacy CMD word at once; the ring and the messages go
+ *   to prvIpiTask through the SGI, whose IRQ handler is IPI_Handler
+ */
+RPU_ATCM_TEXT static void IPI_FiqHandler(void *CallbackRef) {
+    u32 entry = ulRpuIrqProfCycles();  // RPU_IRQ_PROF: first thing in the handler
+    u32 iar = ulRpuFiqAck();
+    (void)CallbackRef;
+
+    u32 isr = Xil_In32(IPI_CH_BASE + IPI_ISR_OFFSET);
     if (isr & APU_MASK) {
-        // Clear the interrupt by writing mask to ISR (following OpenAMP pattern)
-        Xil_Out32(IPI_CH1_BASE + IPI_ISR_OFFSET, APU_MASK);
-        
-        // Invalidate Cache for Shared Mem to ensure fresh read from DDR
-        Xil_DCacheInvalidateRange(SHARED_MEM_ADDR, 32);
-        
-        // Read command/mode from shared memory (offset 0x00)
-        u32 cmd_val = Xil_In32(SHARED_MEM_ADDR + SHM_CMD_OFFSET);
-        xil_printf("IPI Received! Command Value: %d\r\n", cmd_val);
-        
-        // Process the message
-        if (cmd_val <= 2) {
-            // Valid mode: Set blink mode and activate APU override
-            current_blink_mode = (BlinkMode_t)cmd_val;
-            apu_override_active = 1;
-            xil_printf("Mode set to %d (APU Override Active)\r\n", current_blink_mode);
-        } else {
-            // Invalid mode (>2): Release control, let timer resume
-            apu_override_active = 0;
-            xil_printf("APU released control. Timer resuming.\r\n");
+        vRpuTrace(RPU_TRACE_IPI_RX, isr, 0);
+        Xil_Out32(IPI_CH_BASE + IPI_ISR_OFFSET, APU_MASK);
+
+        u32 flags = Xil_In32(RPU_SHM_BASE + SHM_APU_FLAGS_OFFSET);
+        u32 seq, cmd_val;
+        if (prvHandleLegacyWord(flags, &seq, &cmd_val) != 0) {
+            ulFiqCmdVal = cmd_val;
+            ulFiqCmdSeq = seq;
+            ulFiqCmdCount++;
+            if (flags & SHM_APU_FLAG_ACK_IRQ) {
+                Xil_Out32(IPI_CH_BASE + IPI_TRIG_OFFSET, APU_MASK);
+            }
         }
-        
-        // Write acknowledgment to shared memory (offset 0x04)
-        // Use magic value + mode to confirm we processed it
-        Xil_Out32(SHARED_MEM_ADDR + SHM_ACK_OFFSET, SHM_ACK_MAGIC | (cmd_val & 0xFF));
-        
-        // Flush cache to ensure APU sees the acknowledgment
-        Xil_DCacheFlushRange(SHARED_MEM_ADDR + SHM_ACK_OFFSET, 4);
-        
-        xil_printf("Acknowledgment written (0x%X)\r\n", SHM_ACK_MAGIC | (cmd_val & 0xFF));
+
+        vRpuFiqWake();
+        vRpuIrqProfIsr(entry);
+    } else if (isr != 0) {
+        // Only the bits read: an APU doorbell latched since stays pending
+        Xil_Out32(IPI_CH_BASE + IPI_ISR_OFFSET, isr);
+    }
+
+    vRpuFiqEnd(iar);
+}
+#endif /* RPU_IPI_FIQ */
+
+#if !RPU_EXEC
+/*-----------------------------------------------------------*/
+/* The IPI Task:
+ * - Processes APU commands (command ring and legacy CMD/ACK words) and
+ *   acknowledges them, woken by IPI_Handler through a task notification.
+ * - Repeats its pass with the doorbell masked until nothing is pending, so
+ *   a sustained command stream costs one interrupt (rpu_shm.h, "Ring path")
+ */
+static void prvIpiTask( void *pvParameters )
+{
+    (void)pvParameters;
+
+    RPU_LOG("IPI Task Started\r\n");
+
+    // The tick interrupt exists from vTaskStartScheduler() on
+    if (xRpuIntrSetTickPriority() != XST_SUCCESS) {
+        RPU_LOG("Tick interrupt priority not set\r\n");
+    }
+    // First IPI pass possible from here on (rpu_boot.h), which the loader
+    // waits for (rpu_shm.h, "Ready word")
+    vRpuBootReport();
+    vRpuAbiReady();
+
+    for( ;; )
+    {
+        ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        prvIpiPass();
+    }
+}
+#endif /* !RPU_EXEC */
+
+/* One wake-up of the IPI task, or an RPU_EXEC_EV_CMD event of the executive
+ * (rpu_exec.h): passes until nothing is pending and the doorbell is unmasked */
+static void prvIpiPass(void)
+{
+    do {
+        // Acknowledge the doorbells this pass serves
+        prvIpiPollBegin();
+        vRpuTrace(RPU_TRACE_CMD_START, 0, 0);
+
+        // Timed commands first: the match interrupt woke the task for one
+        ulRpuTimedRun(prvExecMpCmd);
+
+        // The window is mapped non-cacheable (NORM_SHARED_NCACHE, rpu_shm.h), so
+        // reads always reach the memory and need no cache invalidation
+        ulApuFlags = Xil_In32(RPU_SHM_BASE + SHM_APU_FLAGS_OFFSET);
+        vRpuIrqProfMark(RPU_IRQPROF_TASK);
+
+        // Urgent ring ahead of every other path (rpu_shm.h, "Urgent ring")
+        u32 drained = prvDrainUrgentRing();
+
+        // Feature request of a client (rpu_shm.h, "ABI header")
+        drained += ulRpuAbiPoll();
+
+        // A message in the IPI buffer first: its sender is waiting on it.
+        // With RPMsg, Linux's IPI mailbox owns that buffer and a doorbell
+        // means the vrings have work instead
+        drained += RPU_RPMSG ? ulRpuRpmsgPoll() : prvHandleMessage();
+
+        // Drain all descriptors queued behind the doorbell(s), and urgent
+        // entries that arrive meanwhile before each of them
+        u32 urgent = 0;
+        u32 ring = prvDrainCommandRing(&urgent);
+        if (ring != 0) {
+            IPI_LOG("IPI Received! Drained %d ring command(s)\r\n", ring);
+        }
+        drained += ring + urgent;
+
+        // Commands of the other producers (RPU_MPCMD=1, rpu_mpcmd.h)
+        drained += ulRpuMpCmdDrain(prvExecMpCmd);
+
+        // Bulk descriptors run in their own task; the reverse IPI follows there
+        vRpuBulkKick();
+
+#ifdef LEGACY_MODE
+        // Legacy DDR mailbox, on a doorbell or a poll timer notification
+        drained += prvHandleLegacyMailbox();
+#endif /* LEGACY_MODE */
+
+        // Legacy single-word command. With RPU_IPI_FIQ the FIQ handler
+        // acknowledges it on the doorbell; this pass logs those and catches
+        // a word written without one, with the FIQ masked so both never
+        // take the same command
+        u32 seq, cmd_val, acked;
+#if RPU_IPI_FIQ
+        u32 fiq_count = ulFiqCmdCount;
+        Xil_ExceptionDisableMask(XIL_EXCEPTION_FIQ);
+        acked = prvHandleLegacyWord(ulApuFlags, &seq, &cmd_val);
+        Xil_ExceptionEnableMask(XIL_EXCEPTION_FIQ);
+        if (fiq_count != ulLoggedFiqCount) {
+            ulLoggedFiqCount = fiq_count;
+            IPI_LOG("IPI Received (FIQ)! Command Value: %d (seq %d)\r\n",
+                    ulFiqCmdVal, ulFiqCmdSeq);
+            if ((ulApuFlags & SHM_APU_FLAG_ECHO) == 0) {
+                prvLogMode(ulFiqCmdVal);
+            }
+        }
+#else
+        acked = prvHandleLegacyWord(ulApuFlags, &seq, &cmd_val);
+#endif /* RPU_IPI_FIQ */
+        if (acked != 0) {
+            vRpuIrqProfMark(RPU_IRQPROF_ACK);
+            IPI_LOG("IPI Received! Command Value: %d (seq %d)\r\n", cmd_val, seq);
+            if ((ulApuFlags & SHM_APU_FLAG_ECHO) == 0) {
+                prvLogMode(cmd_val);
+            }
+            IPI_LOG("Acknowledgment written (0x%X)\r\n", SHM_ACK_VALUE(cmd_val));
+            drained++;
+        }
+
+        // The status block first, so a waiter woken below reads it current
+        vRpuStatusCommands(drained);
+
+        // Reverse IPI so an interrupt-driven APU waiter wakes without polling
+        if (drained != 0 && (ulApuFlags & SHM_APU_FLAG_ACK_IRQ)) {
+            __sync_synchronize();
+            Xil_Out32(IPI_CH_BASE + IPI_TRIG_OFFSET, APU_MASK);
+        }
+        vRpuIrqProfCommit();
+        vRpuWdogServed(WDOG_TASK_CMD);
+    } while (prvIpiRearm() == pdFALSE);
+}
+
+/*-----------------------------------------------------------*/
+/* Doorbell moderation, NAPI style (rpu_shm.h, "Ring path")
+ * - IPI_Handler masks the doorbell; each task pass first clears it and tells
+ *   ring producers that the task polls, so they stop ringing
+ * - With RPU_IPI_FIQ the FIQ handler owns the doorbell and the state stays
+ *   SHM_RING_STATE_IDLE: every batch rings, as before
+ */
+static void prvIpiPollBegin(void) {
+#if !RPU_IPI_FIQ
+    Xil_Out32(IPI_CH_BASE + IPI_ISR_OFFSET, IPI_SRC_MASK);
+    Xil_Out32(RPU_SHM_BASE + SHM_RING_STATE_OFFSET, SHM_RING_STATE_POLLING);
+    vRpuMpCmdSetState(SHM_RING_STATE_POLLING);
+    // Cleared and published before this pass reads the window
+    __sync_synchronize();
+#endif /* !RPU_IPI_FIQ */
+}
+
+/* End of a pass: pdFALSE if work arrived meanwhile and another pass runs,
+ * pdTRUE once the doorbell is unmasked again */
+static BaseType_t prvIpiRearm(void) {
+#if !RPU_IPI_FIQ
+    Xil_Out32(RPU_SHM_BASE + SHM_RING_STATE_OFFSET, SHM_RING_STATE_IDLE);
+    vRpuMpCmdSetState(SHM_RING_STATE_IDLE);
+    // The state before the head read: a producer writes head before reading
+    // the state, so either it rings or this sees its descriptors
+    __sync_synchronize();
+    if (Xil_In32(RPU_SHM_BASE + SHM_RING_HEAD_OFFSET) !=
+            Xil_In32(RPU_SHM_BASE + SHM_RING_TAIL_OFFSET) ||
+        Xil_In32(RPU_SHM_BASE + SHM_URING_HEAD_OFFSET) !=
+            Xil_In32(RPU_SHM_BASE + SHM_URING_TAIL_OFFSET) ||
+        xRpuMpCmdPending() ||
+        (Xil_In32(IPI_CH_BASE + IPI_ISR_OFFSET) & IPI_SRC_MASK) != 0) {
+        return pdFALSE;
+    }
+    // A doorbell after the ISR read latches and interrupts at once
+    Xil_Out32(IPI_CH_BASE + IPI_IER_OFFSET, IPI_SRC_MASK);
+#endif /* !RPU_IPI_FIQ */
+    return pdTRUE;
+}
+
+/*-----------------------------------------------------------*/
+/* Legacy single-word command: pending while SEQ is ahead of ACK_SEQ (or ACK
+ * was cleared by a sender that predates sequence numbers)
+ * - Applies and acknowledges it; returns 1 with its seq and value if there
+ *   was one. No logging, so IPI_FiqHandler can use it too
+ */
+RPU_ATCM_TEXT static u32 prvHandleLegacyWord(u32 flags, u32 *seq, u32 *cmd_val) {
+    *seq = Xil_In32(RPU_SHM_BASE + SHM_SEQ_OFFSET);
+    if (*seq == Xil_In32(RPU_SHM_BASE + SHM_ACK_SEQ_OFFSET) &&
+        Xil_In32(RPU_SHM_BASE + SHM_ACK_OFFSET) != 0) {
+        return 0;
+    }
+    // SEQ publishes CMD, so read it before the command word
+    __sync_synchronize();
+
+    // Read command/mode from shared memory (offset 0x00)
+    *cmd_val = Xil_In32(RPU_SHM_BASE + SHM_CMD_OFFSET);
+
+    // Echo mode acknowledges the command without acting on it
+    if ((flags & SHM_APU_FLAG_ECHO) == 0) {
+        prvSetMode(*cmd_val);
+    }
+
+    // Echo the sequence number first, then write acknowledgment
+    // (magic + mode) to confirm we processed it; with SHM_FEAT_ACK_LINE
+    // into the RPU's own line of the window too
+    if (ulRpuAbiActive() & SHM_FEAT_ACK_LINE) {
+        Xil_Out32(RPU_SHM_BASE + SHM_ABI_ACK_SEQ_OFFSET, *seq);
+        Xil_Out32(RPU_SHM_BASE + SHM_ABI_ACK_OFFSET, SHM_ACK_VALUE(*cmd_val));
+    }
+    Xil_Out32(RPU_SHM_BASE + SHM_ACK_SEQ_OFFSET, *seq);
+    Xil_Out32(RPU_SHM_BASE + SHM_ACK_OFFSET, SHM_ACK_VALUE(*cmd_val));
+    vRpuTrace(RPU_TRACE_ACK, *seq, SHM_ACK_VALUE(*cmd_val));
+
+    // Drain the write buffer so the APU sees the acknowledgment
+    __sync_synchronize();
+    return 1;
+}
+
+/*-----------------------------------------------------------*/
+/* Set the blink mode from an APU command; no logging (see prvApplyMode) */
+RPU_ATCM_TEXT static void prvSetMode(u32 cmd_val) {
+    RpuConfig_t *cfg;
+    u32 key;
+
+    if (ulHandedOff) {
+        // The saved mode is the one the next image resumes
+        return;
+    }
+    // Any mode command ends a pattern program
+    vRpuPatternStop();
+    cfg = pxRpuConfigBegin(&key);
+    if (cmd_val <= 2) {
+        // Valid mode: Set blink mode and activate APU override
+        cfg->mode = cmd_val;
+        cfg->override = 1;
+    } else {
+        // Invalid mode (>2): Release control, let timer resume
+        cfg->override = 0;
+    }
+    vRpuConfigCommit(key, 1);
+    vRpuTrace(RPU_TRACE_MODE, cmd_val, cmd_val <= 2);
+}
+
+static void prvLogMode(u32 cmd_val) {
+    if (cmd_val <= 2) {
+        RPU_LOG("Mode set to %d (APU Override Active)\r\n", cmd_val);
+    } else {
+        RPU_LOG("APU released control. Timer resuming.\r\n");
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Apply a blink mode command from the APU (legacy word or ring descriptor) */
+static void prvApplyMode(u32 cmd_val) {
+    prvSetMode(cmd_val);
+    prvLogMode(cmd_val);
+}
+
+/*-----------------------------------------------------------*/
+/* Command of the multi-producer channel: one argument, as on the ring */
+static u32 prvExecMpCmd(u32 opcode, u32 arg) {
+    return prvExecCommand(opcode, &arg, 1, NULL);
+}
+
+/*-----------------------------------------------------------*/
+/* Governor workload check: nothing but the SLOW blink is running */
+static int prvGovIdle(void) {
+    return pxRpuConfigActive()->mode == BLINK_SLOW && !xRpuWaveActive();
+}
+
+/*-----------------------------------------------------------*/
+/* Set up both waveform engines, once: from main() or, with RPU_FAST_BOOT=1,
+ * from the first RPU_CMD_WAVE start (rpu_boot.h), where the log takes the
+ * failures
+ */
+static void prvWaveInit(void) {
+    static u32 ulWaveInitDone;
+    int Status;
+
+    if (ulWaveInitDone) {
+        return;
+    }
+    ulWaveInitDone = 1;
+
+    Status = xRpuWaveInit(AXI_GPIO_BASE_ADDR + AXI_GPIO_DATA_OFFSET, WAVE_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        RPU_BOOT_PRINT("Waveform timer setup failed (Status: %d)\r\n", Status);
+    }
+    Status = xRpuWaveDmaInit(AXI_GPIO_BASE_ADDR + AXI_GPIO_DATA_OFFSET, DMA_INTR_PRIORITY);
+    if (Status != XST_SUCCESS) {
+        RPU_BOOT_PRINT("Waveform DMA setup failed (Status: %d)\r\n", Status);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Execute one command from the ring or the IPI message buffer
+ * - args: nargs parameters (the ring passes its single argument)
+ * - results: RPU_MSG_MAX_RESULTS words for the message response, or NULL
+ * - Returns the RPU_CMD_STATUS_* of the command
+ */
+static u32 prvExecCommand(u32 opcode, const u32 *args, u32 nargs, u32 *results) {
+    u32 status = RPU_CMD_STATUS_OK;
+    RpuConfig_t cfg;
+    u32 i;
+
+    // Commands that take an argument need at least one
+    if (nargs == 0 && (opcode == RPU_CMD_SET_MODE || opcode == RPU_CMD_WAVE)) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+    // Nothing changes the state once it is handed over
+    if (ulHandedOff && (opcode == RPU_CMD_SET_MODE || opcode == RPU_CMD_WAVE)) {
+        return RPU_CMD_STATUS_FAILED;
+    }
+
+    switch (opcode) {
+        case RPU_CMD_NOP:
+            if (results != NULL) {
+                for (i = 0; i < nargs && i < RPU_MSG_MAX_RESULTS; i++) {
+                    results[i] = args[i];
+                }
+            }
+            break;
+        case RPU_CMD_SET_MODE:
+            prvApplyMode(args[0]);
+            break;
+        case RPU_CMD_WAVE:
+            switch (args[0]) {
+                case RPU_WAVE_START:
+                    prvWaveInit();
+                    prvTtcWaveRelease();
+                    status = ulRpuWaveStart();
+                    break;
+                case RPU_WAVE_START_DMA:
+                    prvWaveInit();
+                    prvTtcWaveRelease();
+                    status = ulRpuWaveDmaStart();
+                    break;
+                case RPU_WAVE_START_STREAM:
+                    prvWaveInit();
+                    prvTtcWaveRelease();
+                    status = ulRpuWaveStreamStart();
+                    break;
+                case RPU_WAVE_STOP:
+                    vRpuWaveStop();
+                    break;
+                default:
+                    status = RPU_CMD_STATUS_BADARG;
+                    break;
+            }
+            break;
+        case RPU_CMD_PATTERN:
+            status = prvPattern(args[0]);
+            break;
+        case RPU_CMD_SEED:
+            // Picked up by the Tx task before it computes its next frame
+            ulRandSeed = args[0];
+            ulRandReseed = 1;
+            break;
+        case RPU_CMD_AT:
+            // Message form (opcode, arg, tick low, tick high); the ring's
+            // prefix descriptor is taken by prvDrainCommandRing()
+            if (nargs < 4) {
+                status = RPU_CMD_STATUS_BADARG;
+            } else {
+                status = ulRpuTimedQueue(((u64)args[3] << 32) | args[2], args[0], args[1]);
+            }
+            break;
+        case RPU_CMD_QUERY:
+            if (results != NULL) {
+                // The latest requested mode, also before the Tx task's next frame
+                vRpuConfigGet(&cfg);
+                results[0] = cfg.mode;
+                results[1] = cfg.override;
+                results[2] = Xil_In32(RPU_SHM_BASE + SHM_WAVE_STATE_OFFSET);
+            }
+            break;
+        case RPU_CMD_HANDOFF:
+            status = prvHandoff();
+            break;
+        default:
+            status = RPU_CMD_STATUS_BADOP;
+            break;
+    }
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+/* Mode and override a pattern program restores when it ends */
+static BlinkMode_t xPatternPrevMode;
+static int xPatternPrevOverride;
+
+/* RPU_CMD_PATTERN (rpu_pattern.h)
+ * - START loads the staged program; the Tx task runs it as BLINK_PATTERN from
+ *   its next frame, under APU override
+ * - STOP ends it and, as its END does, restores the mode and override in
+ *   force before the start
+ */
+static u32 prvPattern(u32 arg) {
+    u32 status = RPU_CMD_STATUS_OK;
+    RpuConfig_t *cfg;
+    u32 key;
+
+    switch (arg) {
+        case RPU_PATTERN_START:
+            if (ulHandedOff) {
+                return RPU_CMD_STATUS_FAILED;
+            }
+            status = ulRpuPatternLoad();
+            if (status != RPU_CMD_STATUS_OK) {
+                return status;
+            }
+            cfg = pxRpuConfigBegin(&key);
+            if (cfg->mode != BLINK_PATTERN) {
+                xPatternPrevMode = (BlinkMode_t)cfg->mode;
+                xPatternPrevOverride = cfg->override;
+            }
+            cfg->mode = BLINK_PATTERN;
+            cfg->override = 1;
+            vRpuConfigCommit(key, 1);
+            vRpuTrace(RPU_TRACE_MODE, BLINK_PATTERN, 1);
+            break;
+        case RPU_PATTERN_STOP:
+            vRpuPatternStop();
+            prvPatternEnd();
+            break;
+        default:
+            status = RPU_CMD_STATUS_BADARG;
+            break;
+    }
+    return status;
+}
+
+/* Program stopped or ended (Tx task): the mode from before its start, unless
+ * a new program was loaded in the meantime
+ */
+static void prvPatternEnd(void) {
+    RpuConfig_t *cfg;
+    u32 key;
+    int restored = 0;
+
+    cfg = pxRpuConfigBegin(&key);
+    if (cfg->mode == BLINK_PATTERN && !xRpuPatternActive()) {
+        cfg->mode = xPatternPrevMode;
+        cfg->override = xPatternPrevOverride;
+        restored = 1;
+    }
+    vRpuConfigCommit(key, restored);
+    if (restored) {
+        vRpuTrace(RPU_TRACE_MODE, xPatternPrevMode, xPatternPrevOverride);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Ticks from now until tick 'at' in ms, 0 if it has passed */
+static u32 prvMsUntil(TickType_t at, TickType_t now) {
+    TickType_t left = at - now;
+
+    if (left > pdMS_TO_TICKS(DELAY_10_SECONDS)) {
+        return 0;
+    }
+    return (u32)(((u64)left * 1000) / configTICK_RATE_HZ);
+}
+
+/*-----------------------------------------------------------*/
+/* RPU_CMD_HANDOFF: save the state for the next image and freeze it
+ * (rpu_handoff.h); again after a handoff it saves the same state
+ * - Refused while a waveform plays: the table is not carried over
+ */
+static u32 prvHandoff(void) {
+    RpuHandoff_t state;
+    RpuConfig_t cfg;
+    TickType_t now, rotate_at;
+
+    if (xRpuWaveActive()) {
+        return RPU_CMD_STATUS_FAILED;
+    }
+
+    // One snapshot against the Rx task's write and the mode timer
+    taskENTER_CRITICAL();
+    ulHandedOff = 1;
+    now = xTaskGetTickCount();
+    rotate_at = xRotateStart + pdMS_TO_TICKS(DELAY_10_SECONDS);
+    vRpuConfigGet(&cfg);
+    state.mode = cfg.mode;
+    state.override = cfg.override;
+#ifdef LEGACY_MODE
+    state.legacy_mode = ulLegacyMode;
+#else
+    state.legacy_mode = 3;
+#endif /* LEGACY_MODE */
+    // The next image's first write continues from the level on the pins
+    prvTtcWaveRelease();
+    state.led = ulLedLast;
+    state.frame_ms = prvMsUntil(xTxNextWake, now);
+    state.rotate_ms = prvMsUntil(rotate_at, now);
+    taskEXIT_CRITICAL();
+
+    vRpuHandoffSave(&state);
+    return RPU_CMD_STATUS_OK;
+}
+
+/*-----------------------------------------------------------*/
+/* Process the IPI message buffer (see rpu_shm.h)
+ * - Pending while the request header differs from the response header
+ * - Returns 1 if a message was answered, 0 otherwise
+ */
+static u32 prvHandleMessage(void) {
+    u32 req[SHM_IPI_MSG_WORDS];
+    u32 resp[SHM_IPI_MSG_WORDS] = { 0 };
+    u32 hdr = Xil_In32(RPU_IPI_REQ_ADDR);
+    u32 nargs;
+
+    if (hdr == Xil_In32(RPU_IPI_RESP_ADDR)) {
+        return 0;
+    }
+
+    // The header publishes the parameters, so read it before them
+    __sync_synchronize();
+    if (XIpiPsu_ReadMessage(&xIpiInst, APU_MASK, req, SHM_IPI_MSG_WORDS,
+                            XIPIPSU_BUF_TYPE_MSG) != XST_SUCCESS || req[0] != hdr) {
+        // Rewritten while being read: the sender's doorbell brings it back
+        return 0;
+    }
+
+    nargs = RPU_MSG_HDR_LEN(hdr);
+    if (nargs > SHM_IPI_MSG_DATA_WORDS) {
+        resp[1] = RPU_CMD_STATUS_BADARG;
     } else {
-        // Interrupt not for us - clear it and return
-        // Clear all bits in ISR to prevent stuck interrupt
-        Xil_Out32(IPI_CH1_BASE + IPI_ISR_OFFSET, 0xFFFFFFFF);
+        resp[1] = prvExecCommand(RPU_MSG_HDR_OPCODE(hdr), &req[1], nargs, &resp[2]);
+    }
+    vRpuTrace(RPU_TRACE_MSG, hdr, resp[1]);
+
+    // Status and results first (response header unchanged), then the header
+    resp[0] = Xil_In32(RPU_IPI_RESP_ADDR);
+    XIpiPsu_WriteMessage(&xIpiInst, APU_MASK, resp, SHM_IPI_MSG_WORDS,
+                         XIPIPSU_BUF_TYPE_RESP);
+    __sync_synchronize();
+    Xil_Out32(RPU_IPI_RESP_ADDR, hdr);
+    vRpuIrqProfMark(RPU_IRQPROF_ACK);
+
+    IPI_LOG("IPI message: opcode %d, %d parameter(s), status %d\r\n",
+            RPU_MSG_HDR_OPCODE(hdr), nargs, resp[1]);
+    return 1;
+}
+
+/*-----------------------------------------------------------*/
+/* Drain the urgent ring (rpu_shm.h, "Urgent ring")
+ * - As the command ring, without timed commands; tail is published and the
+ *   reverse IPI raised at once, ahead of the rest of the pass
+ * - Returns the number of descriptors consumed
+ */
+static u32 prvDrainUrgentRing(void) {
+    u32 tail = Xil_In32(RPU_SHM_BASE + SHM_URING_TAIL_OFFSET);
+    u32 head = Xil_In32(RPU_SHM_BASE + SHM_URING_HEAD_OFFSET);
+    u32 count = 0;
+
+    if (head == tail) {
+        return 0;
     }
+    // Head must be observed before the descriptors it publishes
+    __sync_synchronize();
+
+    if ((u32)(head - tail) > SHM_URING_SLOTS) {
+        Xil_Out32(RPU_SHM_BASE + SHM_URING_TAIL_OFFSET, head);
+        return 0;
+    }
+
+    while (tail != head) {
+        UINTPTR desc = RPU_SHM_BASE + SHM_URING_DESC(tail);
+        u32 opcode = Xil_In32(desc + SHM_DESC_OPCODE);
+        u32 arg = Xil_In32(desc + SHM_DESC_ARG);
+        u32 status = opcode == RPU_CMD_AT ? RPU_CMD_STATUS_BADOP
+                                          : prvExecCommand(opcode, &arg, 1, NULL);
+
+        Xil_Out32(desc + SHM_DESC_STATUS, status);
+        tail++;
+        count++;
+    }
+
+    // Descriptor status must be visible before the slots are released
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_URING_TAIL_OFFSET, tail);
+    vRpuIrqProfMark(RPU_IRQPROF_ACK);
+    vRpuTrace(RPU_TRACE_URGENT, count, tail);
+    if (ulApuFlags & SHM_APU_FLAG_ACK_IRQ) {
+        __sync_synchronize();
+        Xil_Out32(IPI_CH_BASE + IPI_TRIG_OFFSET, APU_MASK);
+    }
+    IPI_LOG("IPI Received! Drained %d urgent command(s)\r\n", count);
+    return count;
+}
+
+/*-----------------------------------------------------------*/
+/* Drain the SPSC command ring (see rpu_shm.h)
+ * - Read head once, process every descriptor up to it, publish tail once
+ * - A descriptor after RPU_CMD_AT is held for its tick (rpu_timed.h), also
+ *   when it comes in a later batch
+ * - The urgent ring is drained before each descriptor, counted in *urgent
+ * - The time the batch took sets the ring credits (rpu_credit.h)
+ * - Returns the number of descriptors consumed
+ */
+static u32 prvDrainCommandRing(u32 *urgent) {
+    static u64 ullRingAt;
+    static u32 ulRingAtPending;
+    u32 tail = Xil_In32(RPU_SHM_BASE + SHM_RING_TAIL_OFFSET);
+    u32 head = Xil_In32(RPU_SHM_BASE + SHM_RING_HEAD_OFFSET);
+    u32 count = 0;
+    u64 start = ullRpuTimeNow();
+
+    // Head must be observed before the descriptors it publishes
+    __sync_synchronize();
+
+    // A corrupted head (more than a ring ahead) is discarded rather than replayed
+    if ((u32)(head - tail) > SHM_RING_SLOTS) {
+        Xil_Out32(RPU_SHM_BASE + SHM_RING_TAIL_OFFSET, head);
+        vRpuCreditUpdate(head, 0, 0);
+        return 0;
+    }
+
+    while (tail != head) {
+        UINTPTR desc = RPU_SHM_BASE + SHM_RING_DESC(tail);
+        u32 opcode, arg, status;
+
+        *urgent += prvDrainUrgentRing();
+        opcode = Xil_In32(desc + SHM_DESC_OPCODE);
+        arg = Xil_In32(desc + SHM_DESC_ARG);
+
+        if (ulRingAtPending) {
+            ulRingAtPending = 0;
+            status = ulRpuTimedQueue(ullRingAt, opcode, arg);
+        } else if (opcode == RPU_CMD_AT) {
+            ullRingAt = ullRpuTimedFromLow(arg);
+            ulRingAtPending = 1;
+            status = RPU_CMD_STATUS_OK;
+        } else {
+            status = prvExecCommand(opcode, &arg, 1, NULL);
+        }
+
+        Xil_Out32(desc + SHM_DESC_STATUS, status);
+        tail++;
+        count++;
+    }
+
+    if (count != 0) {
+        // Descriptor status must be visible before the slots are released
+        __sync_synchronize();
+        Xil_Out32(RPU_SHM_BASE + SHM_RING_TAIL_OFFSET, tail);
+        vRpuCreditUpdate(tail, count, ullRpuTimeNow() - start);
+        vRpuIrqProfMark(RPU_IRQPROF_ACK);
+        vRpuTrace(RPU_TRACE_RING_DRAIN, count, tail);
+    }
+    return count;
+}
+#endif /* IPI_MODE */
+
+#ifdef LEGACY_MODE
+/*-----------------------------------------------------------*/
+/* Mailbox change not processed yet: new generation, or a bare MODE write */
+static BaseType_t prvLegacyMailboxPending(void) {
+    return Xil_In32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_GEN_OFFSET) !=
+               Xil_In32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_ACK_OFFSET) ||
+           Xil_In32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_MODE_OFFSET) != ulLegacyMode;
+}
+
+#if !RPU_EXEC
+/*-----------------------------------------------------------*/
+/* Poll timer: wake the IPI task, the mailbox's only consumer, on a change */
+static void vLegacyPollCallback( TimerHandle_t pxTimer )
+{
+    (void)pxTimer;
+
+    if (prvLegacyMailboxPending()) {
+        xTaskNotifyGive(xIpiTask);
+    }
+}
+#else
+/*-----------------------------------------------------------*/
+/* Poll slot of the executive: an IPI pass on a change, as the timer's wake-up */
+static void prvExecLegacyPoll(void)
+{
+    if (prvLegacyMailboxPending()) {
+        vRpuExecPost(RPU_EXEC_EV_CMD);
+    }
+}
+#endif /* RPU_EXEC */
+
+/*-----------------------------------------------------------*/
+/* Process the legacy DDR mailbox (see rpu_shm.h)
+ * - A mode up to 2 pins the blink mode, 3+ lets the mode timer rotate again;
+ *   an active IPI override still takes precedence
+ * - Returns 1 if a change was processed, 0 otherwise
+ */
+static u32 prvHandleLegacyMailbox(void) {
+    RpuConfig_t *cfg;
+    u32 gen, mode, key;
+
+    // Left for the next image once the state is handed over
+    if (ulHandedOff || !prvLegacyMailboxPending()) {
+        return 0;
+    }
+
+    // GEN publishes MODE, so read it first
+    gen = Xil_In32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_GEN_OFFSET);
+    __sync_synchronize();
+    mode = Xil_In32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_MODE_OFFSET);
+
+    if ((ulApuFlags & SHM_APU_FLAG_ECHO) == 0 && mode <= 2) {
+        cfg = pxRpuConfigBegin(&key);
+        if (!cfg->override && mode != cfg->mode) {
+            cfg->mode = mode;
+            vRpuConfigCommit(key, 1);
+            vRpuTrace(RPU_TRACE_MODE, mode, 0);
+        } else {
+            vRpuConfigCommit(key, 0);
+        }
+    }
+    ulLegacyMode = mode;
+
+    __sync_synchronize();
+    Xil_Out32(LEGACY_SHARED_MEM_ADDR + LEGACY_MBOX_ACK_OFFSET, gen);
+    vRpuTrace(RPU_TRACE_MBOX, gen, mode);
+    IPI_LOG("Legacy mailbox: mode %d (gen %d)\r\n", mode, gen);
+    return 1;
 }
-#endif /* IPI_MODE */
\ No newline at end of file
+#endif /* LEGACY_MODE */
@@ -0,0 +1,84 @@
+/*
+ * ABI header and feature negotiation (see rpu_abi.h, rpu_shm.h).
+ *
+ * The granted set lives in BTCM as well as in the window, so the legacy
+ * ACK path (prvHandleLegacyWord, also run by the FIQ handler) tests it
+ * without an interconnect read.
+ */
+
+#include <xil_io.h>
+
+#include "rpu_abi.h"
+#include "rpu_core.h"
+#include "rpu_fiq.h"
+#include "rpu_rpmsg.h"
+#include "rpu_tcm.h"
+
+/* Fast paths of this build */
+#define ABI_FEATURES  (SHM_FEAT_RING | SHM_FEAT_ACK_IRQ | SHM_FEAT_AT | SHM_FEAT_ACK_LINE | \
+                       SHM_FEAT_URGENT | SHM_FEAT_CREDIT | \
+                       (RPU_IPI_FIQ ? 0 : SHM_FEAT_RING_POLL) | \
+                       (RPU_RPMSG ? 0 : SHM_FEAT_MSG))
+
+static volatile u32 ulAbiActive RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* Add the requested features, then echo the request that was served */
+static void prvAbiGrant(u32 seq)
+{
+    // The sequence number publishes the request word
+    __sync_synchronize();
+    ulAbiActive |= Xil_In32(RPU_SHM_BASE + SHM_ABI_REQ_OFFSET) & ABI_FEATURES;
+    Xil_Out32(RPU_SHM_BASE + SHM_ABI_ACTIVE_OFFSET, ulAbiActive);
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_ABI_GRANT_SEQ_OFFSET, seq);
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT void vRpuAbiInit(void)
+{
+    // Hide the header of the previous image while it changes, and its ready
+    // word until vRpuAbiReady()
+    Xil_Out32(RPU_SHM_DEFAULT_BASE + SHM_READY_OFFSET, 0);
+    Xil_Out32(RPU_SHM_BASE + SHM_ABI_MAGIC_OFFSET, 0);
+    __sync_synchronize();
+    ulAbiActive = 0;
+    Xil_Out32(RPU_SHM_BASE + SHM_ABI_VERSION_OFFSET, SHM_ABI_VERSION);
+    Xil_Out32(RPU_SHM_BASE + SHM_ABI_FEATURES_OFFSET, ABI_FEATURES);
+    Xil_Out32(RPU_SHM_BASE + SHM_ABI_ACK_SEQ_OFFSET,
+              Xil_In32(RPU_SHM_BASE + SHM_ACK_SEQ_OFFSET));
+    Xil_Out32(RPU_SHM_BASE + SHM_ABI_ACK_OFFSET,
+              Xil_In32(RPU_SHM_BASE + SHM_ACK_OFFSET));
+    // Clients of the previous image keep what they negotiated
+    prvAbiGrant(Xil_In32(RPU_SHM_BASE + SHM_ABI_REQ_SEQ_OFFSET));
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_ABI_MAGIC_OFFSET, SHM_ABI_MAGIC);
+}
+
+/*-----------------------------------------------------------*/
+void vRpuAbiReady(void)
+{
+    Xil_Out32(RPU_SHM_DEFAULT_BASE + SHM_READY_VERSION_OFFSET, SHM_ABI_VERSION);
+    Xil_Out32(RPU_SHM_DEFAULT_BASE + SHM_READY_FEATURES_OFFSET, ABI_FEATURES);
+    // The magic publishes the words before it
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_DEFAULT_BASE + SHM_READY_OFFSET, SHM_READY_MAGIC);
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuAbiPoll(void)
+{
+    u32 seq = Xil_In32(RPU_SHM_BASE + SHM_ABI_REQ_SEQ_OFFSET);
+
+    if (seq == Xil_In32(RPU_SHM_BASE + SHM_ABI_GRANT_SEQ_OFFSET)) {
+        return 0;
+    }
+    prvAbiGrant(seq);
+    return 1;
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT u32 ulRpuAbiActive(void)
+{
+    return ulAbiActive;
+}
@@ -0,0 +1,27 @@
+/*
+ * Versioned ABI header of the shared window and feature negotiation
+ * (rpu_shm.h, "ABI header").
+ *
+ * vRpuAbiInit() publishes the layout version and the SHM_FEAT_* fast paths
+ * this build serves, and grants again what a client asked for before the
+ * core restarted. vRpuAbiReady() sets the ready word once the IPI task
+ * takes commands (rpu_shm.h, "Ready word"). The IPI task calls
+ * ulRpuAbiPoll() on every pass to serve a new request. ulRpuAbiActive() is the granted set, callable from any
+ * context including the FIQ handler.
+ */
+
+#ifndef RPU_ABI_H
+#define RPU_ABI_H
+
+#include "xil_types.h"
+
+/* Once the shared window is mapped in the MPU, before the first IPI pass */
+void vRpuAbiInit(void);
+/* Before the first IPI pass, with the doorbell enabled */
+void vRpuAbiReady(void);
+/* IPI task: grant a new request; returns 1 if there was one */
+u32 ulRpuAbiPoll(void);
+/* SHM_FEAT_* granted */
+u32 ulRpuAbiActive(void);
+
+#endif /* RPU_ABI_H */
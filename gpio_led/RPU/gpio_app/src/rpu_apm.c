@@ -0,0 +1,368 @@
+/*
+ * AXI performance monitor sampling (see rpu_apm.h, rpu_shm.h).
+ *
+ * The counters run free and are never read directly: a read of the sample
+ * register copies them into the sampled counters, resets them and returns
+ * the APM clocks since the previous sample, so no transaction falls between
+ * two intervals. The byte totals are kept in BTCM.
+ *
+ * A capture hands its port to the monitor's sample interval timer instead:
+ * the timer latches and resets the counters each time it lapses and reloads
+ * itself, and the lapse interrupt copies the sampled counters into the next
+ * record. The task starts, watches and ends captures between its periodic
+ * samples. An interrupt taken more than an interval late loses a record; the
+ * timestamps show the gap.
+ */
+
+#include "rpu_apm.h"
+
+#if RPU_APM
+
+#include <string.h>
+#include <xil_io.h>
+#include "xil_cache.h"
+#include "xil_mpu.h"
+#include "xaxipmon.h"
+#include "xinterrupt_wrap.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_seqlock.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_trace.h"
+
+#define APM_TASK_STACK_SIZE    configMINIMAL_STACK_SIZE
+#define APM_SLOT               0   // The OCM, LPD and CCI monitors have one slot
+#define APM_COUNTER_WR_BYTES   XAPM_METRIC_COUNTER_0
+#define APM_COUNTER_RD_BYTES   XAPM_METRIC_COUNTER_1
+#define APM_COUNTER_RD_LAT     XAPM_METRIC_COUNTER_2
+#define APM_CAP_NONE           0xFFFFFFFFU
+// A capture without a new record for this long has a stuck timer
+#define APM_CAP_STALL_MS       2000
+
+// Indexed by APM_PORT_*
+static const UINTPTR ulApmBase[] = {
+    XPAR_PERF_MONITOR_OCM_BASEADDR,
+    XPAR_PERF_MONITOR_LPD_BASEADDR,
+    XPAR_PERF_MONITOR_CCI_BASEADDR,
+};
+#define APM_PORTS              (sizeof(ulApmBase) / sizeof(ulApmBase[0]))
+
+static XAxiPmon xApm[APM_PORTS];
+static u64 ullApmWrTotal[APM_PORTS] RPU_BTCM_BSS;
+static u64 ullApmRdTotal[APM_PORTS] RPU_BTCM_BSS;
+static u32 ulApmSamples RPU_BTCM_BSS;
+static u32 ulApmSeq RPU_BTCM_BSS;
+
+// Capture state; the record fields are shared with the lapse interrupt
+static u32 ulApmCapPort = APM_CAP_NONE;   /* Port of the running capture */
+static u32 ulApmCapGen;                   /* Its generation */
+static volatile u32 *pulApmCapRec;
+static u32 ulApmCapRecords;
+static volatile u32 ulApmCapCount;
+static u32 ulApmCapSeen;                  /* Count at the last progress check */
+static TickType_t xApmCapProgress;        /* Tick of the last progress */
+
+static StaticTask_t xApmTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xApmStack, APM_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* Sample interval lapse of the capture port: take the next record
+ * (interrupt context) */
+static void prvApmCaptureIntr(void *CallBackRef)
+{
+    XAxiPmon *apm = CallBackRef;
+    u32 status = XAxiPmon_IntrGetStatus(apm);
+    u32 count = ulApmCapCount;
+    volatile u32 *rec;
+
+    XAxiPmon_IntrClear(apm, status);
+    if ((status & XAPM_IXR_SIC_OVERFLOW_MASK) == 0 || ulApmCapPort >= APM_PORTS ||
+        apm != &xApm[ulApmCapPort] || count >= ulApmCapRecords) {
+        return;
+    }
+
+    rec = pulApmCapRec + count * (APM_RECORD_SIZE / 4);
+    rec[0] = (u32)ullRpuTimeNow();
+    rec[1] = XAxiPmon_GetSampledMetricCounter(apm, APM_COUNTER_WR_BYTES);
+    rec[2] = XAxiPmon_GetSampledMetricCounter(apm, APM_COUNTER_RD_BYTES);
+    rec[3] = XAxiPmon_GetSampledMetricCounter(apm, APM_COUNTER_RD_LAT);
+    ulApmCapCount = ++count;
+    if (count == ulApmCapRecords) {
+        XAxiPmon_IntrDisable(apm, XAPM_IXR_SIC_OVERFLOW_MASK);
+        XAxiPmon_DisableSampleIntervalCounter(apm);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Periodic mode: counters of every master, latched by the task's samples */
+static void prvApmPeriodic(XAxiPmon *apm)
+{
+    XAxiPmon_DisableMetricsCounter(apm);
+    XAxiPmon_IntrDisable(apm, XAPM_IXR_ALL_MASK);
+    XAxiPmon_DisableIDFilter(apm);
+    // Sampling resets the counters; the sample interval timer stays off
+    XAxiPmon_DisableSampleIntervalCounter(apm);
+    XAxiPmon_EnableMetricCounterReset(apm);
+    (void)XAxiPmon_ResetMetricCounter(apm);
+    XAxiPmon_EnableMetricsCounter(apm);
+    (void)XAxiPmon_SampleMetrics(apm);
+}
+
+/*-----------------------------------------------------------*/
+/* Count write bytes, read bytes and the longest read of slot 0 */
+static int prvApmSetup(XAxiPmon *apm, UINTPTR base, u16 intr_priority)
+{
+    XAxiPmon_Config *cfg;
+    int Status;
+
+    cfg = XAxiPmon_LookupConfig(base);
+    if (cfg == NULL || cfg->HaveSampledCounters == 0 || cfg->NumberofCounters < 3) {
+        return XST_FAILURE;
+    }
+    Status = XAxiPmon_CfgInitialize(apm, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    XAxiPmon_DisableMetricsCounter(apm);
+    (void)XAxiPmon_SetMetrics(apm, APM_SLOT, XAPM_METRIC_SET_2, APM_COUNTER_WR_BYTES);
+    (void)XAxiPmon_SetMetrics(apm, APM_SLOT, XAPM_METRIC_SET_3, APM_COUNTER_RD_BYTES);
+    (void)XAxiPmon_SetMetrics(apm, APM_SLOT, XAPM_METRIC_SET_15, APM_COUNTER_RD_LAT);
+    XAxiPmon_SetRdLatencyStart(apm, XAPM_LATENCY_ADDR_ISSUE);
+    XAxiPmon_SetRdLatencyEnd(apm, XAPM_LATENCY_LASTRD);
+    XAxiPmon_EnableGlobalClkCounter(apm);
+
+    // The lapse interrupt only fires during a capture
+    XAxiPmon_IntrDisable(apm, XAPM_IXR_ALL_MASK);
+    XAxiPmon_IntrClear(apm, XAPM_IXR_ALL_MASK);
+    Status = XSetupInterruptSystem(apm, (Xil_ExceptionHandler)prvApmCaptureIntr,
+                                   cfg->IntId, cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XAxiPmon_IntrGlobalEnable(apm);
+    XEnableIntrId(cfg->IntId, cfg->IntrParent);
+
+    prvApmPeriodic(apm);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Report the end of a capture request */
+static void prvApmCaptureDone(u32 gen, u32 status, u32 count)
+{
+    Xil_Out32(APM_ADDR + APM_CAP_COUNT_OFFSET, count);
+    Xil_Out32(APM_ADDR + APM_CAP_STATUS_OFFSET, status);
+    __sync_synchronize();
+    Xil_Out32(APM_ADDR + APM_CAP_DONE_OFFSET, gen);
+}
+
+/*-----------------------------------------------------------*/
+/* Check the request of generation gen and hand its port to the timer */
+static void prvApmCaptureStart(u32 gen)
+{
+    u32 port = Xil_In32(APM_ADDR + APM_CAP_PORT_OFFSET);
+    u32 id = Xil_In32(APM_ADDR + APM_CAP_ID_OFFSET);
+    u32 mask = Xil_In32(APM_ADDR + APM_CAP_ID_MASK_OFFSET);
+    u32 interval = Xil_In32(APM_ADDR + APM_CAP_INTERVAL_OFFSET);
+    u32 off = Xil_In32(APM_ADDR + APM_CAP_BUF_OFFSET);
+    u32 records = Xil_In32(APM_ADDR + APM_CAP_RECORDS_OFFSET);
+    XAxiPmon *apm;
+    UINTPTR base;
+    u64 start;
+
+    if (port >= APM_PORTS || interval < APM_CAP_MIN_INTERVAL || records == 0 ||
+        (off % APM_RECORD_SIZE) != 0 || off > BULK_DDR_CORE_SIZE ||
+        records > (BULK_DDR_CORE_SIZE - off) / APM_RECORD_SIZE) {
+        prvApmCaptureDone(gen, RPU_CMD_STATUS_BADARG, 0);
+        return;
+    }
+    apm = &xApm[port];
+    base = apm->Config.BaseAddress;
+
+    XAxiPmon_DisableMetricsCounter(apm);
+    if (mask != 0) {
+        XAxiPmon_SetWriteId(apm, (u16)id);
+        XAxiPmon_SetReadId(apm, (u16)id);
+        XAxiPmon_SetWriteIdMask(apm, (u16)mask);
+        XAxiPmon_SetReadIdMask(apm, (u16)mask);
+        XAxiPmon_EnableIDFilter(apm);
+    }
+    XAxiPmon_SetSampleInterval(apm, interval);
+
+    pulApmCapRec = (volatile u32 *)(BULK_DDR_ADDR_CORE(0) + off);
+    ulApmCapRecords = records;
+    ulApmCapCount = 0;
+    ulApmCapSeen = 0;
+    ulApmCapGen = gen;
+    ulApmCapPort = port;
+    xApmCapProgress = xTaskGetTickCount();
+
+    start = ullRpuTimeNow();
+    Xil_Out32(APM_ADDR + APM_CAP_START_LO_OFFSET, (u32)start);
+    Xil_Out32(APM_ADDR + APM_CAP_START_HI_OFFSET, (u32)(start >> 32));
+
+    (void)XAxiPmon_ResetMetricCounter(apm);
+    XAxiPmon_IntrClear(apm, XAPM_IXR_ALL_MASK);
+    XAxiPmon_IntrEnable(apm, XAPM_IXR_SIC_OVERFLOW_MASK);
+    XAxiPmon_EnableMetricsCounter(apm);
+    // The driver's load and enable calls would clear the counter reset bit
+    XAxiPmon_WriteReg(base, XAPM_SICR_OFFSET, XAPM_SICR_MCNTR_RST_MASK | XAPM_SICR_LOAD_MASK);
+    XAxiPmon_WriteReg(base, XAPM_SICR_OFFSET, XAPM_SICR_MCNTR_RST_MASK | XAPM_SICR_ENABLE_MASK);
+}
+
+/*-----------------------------------------------------------*/
+/* Stop the running capture, publish its records and give the port back */
+static void prvApmCaptureEnd(u32 status)
+{
+    XAxiPmon *apm = &xApm[ulApmCapPort];
+    u32 count;
+
+    taskENTER_CRITICAL();
+    XAxiPmon_IntrDisable(apm, XAPM_IXR_SIC_OVERFLOW_MASK);
+    XAxiPmon_DisableSampleIntervalCounter(apm);
+    count = ulApmCapCount;
+    ulApmCapRecords = 0;
+    ulApmCapPort = APM_CAP_NONE;
+    taskEXIT_CRITICAL();
+
+    // The handler wrote the records through the data cache
+    if (count != 0) {
+        Xil_DCacheFlushRange((INTPTR)pulApmCapRec, count * APM_RECORD_SIZE);
+    }
+    prvApmPeriodic(apm);
+    prvApmCaptureDone(ulApmCapGen, status, count);
+}
+
+/*-----------------------------------------------------------*/
+/* Between two samples: end a full, stalled or superseded capture, then start
+ * a new request */
+static void prvApmCapturePoll(void)
+{
+    u32 gen = Xil_In32(APM_ADDR + APM_CAP_GEN_OFFSET);
+
+    if (ulApmCapPort != APM_CAP_NONE) {
+        TickType_t now = xTaskGetTickCount();
+        u32 count = ulApmCapCount;
+
+        if (gen != ulApmCapGen) {
+            prvApmCaptureEnd(RPU_CMD_STATUS_FAILED);
+        } else if (count == ulApmCapRecords) {
+            prvApmCaptureEnd(RPU_CMD_STATUS_OK);
+            return;
+        } else if (count != ulApmCapSeen) {
+            ulApmCapSeen = count;
+            xApmCapProgress = now;
+            return;
+        } else if ((now - xApmCapProgress) >= pdMS_TO_TICKS(APM_CAP_STALL_MS)) {
+            prvApmCaptureEnd(RPU_CMD_STATUS_FAILED);
+            return;
+        } else {
+            return;
+        }
+    }
+
+    if (gen != Xil_In32(APM_ADDR + APM_CAP_DONE_OFFSET)) {
+        prvApmCaptureStart(gen);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Sample every port and publish the interval under the seq word */
+static void prvApmTask(void *pvParameters)
+{
+    TickType_t xLastWake = xTaskGetTickCount();
+    u64 ullLast = ullRpuTimeNow();
+
+    (void)pvParameters;
+    for (;;) {
+        struct rpu_apm_port sample[APM_PORTS];
+        u64 now;
+        u32 i;
+
+        vTaskDelayUntil(&xLastWake, pdMS_TO_TICKS(RPU_APM_PERIOD_MS));
+
+        now = ullRpuTimeNow();
+        for (i = 0; i < APM_PORTS; i++) {
+            if (i == ulApmCapPort) {
+                // A sample now would cut the capture's interval short
+                memset(&sample[i], 0, sizeof(sample[i]));
+                continue;
+            }
+            sample[i].cycles = XAxiPmon_SampleMetrics(&xApm[i]);
+            sample[i].wr_bytes = XAxiPmon_GetSampledMetricCounter(&xApm[i], APM_COUNTER_WR_BYTES);
+            sample[i].rd_bytes = XAxiPmon_GetSampledMetricCounter(&xApm[i], APM_COUNTER_RD_BYTES);
+            sample[i].rd_lat_max = XAxiPmon_GetSampledMetricCounter(&xApm[i], APM_COUNTER_RD_LAT);
+            ullApmWrTotal[i] += sample[i].wr_bytes;
+            ullApmRdTotal[i] += sample[i].rd_bytes;
+        }
+        ulApmSamples++;
+
+        vRpuSeqBegin(APM_ADDR + APM_SEQ_OFFSET, &ulApmSeq);
+        for (i = 0; i < APM_PORTS; i++) {
+            UINTPTR port = APM_ADDR + APM_PORT(i);
+
+            Xil_Out32(port + 0x00, sample[i].wr_bytes);
+            Xil_Out32(port + 0x04, sample[i].rd_bytes);
+            Xil_Out32(port + 0x08, sample[i].rd_lat_max);
+            Xil_Out32(port + 0x0C, sample[i].cycles);
+            Xil_Out32(port + 0x10, (u32)ullApmWrTotal[i]);
+            Xil_Out32(port + 0x14, (u32)(ullApmWrTotal[i] >> 32));
+            Xil_Out32(port + 0x18, (u32)ullApmRdTotal[i]);
+            Xil_Out32(port + 0x1C, (u32)(ullApmRdTotal[i] >> 32));
+        }
+        Xil_Out32(APM_ADDR + APM_TICKS_OFFSET, (u32)(now - ullLast));
+        Xil_Out32(APM_ADDR + APM_SAMPLES_OFFSET, ulApmSamples);
+        vRpuSeqEnd(APM_ADDR + APM_SEQ_OFFSET, &ulApmSeq);
+        ullLast = now;
+
+        prvApmCapturePoll();
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Program the monitors and start sampling; announces the block */
+RPU_INIT_TEXT int xRpuApmInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    u32 i;
+    int Status;
+
+    Xil_SetTlbAttributes(APM_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(APM_ADDR + APM_MAGIC_OFFSET, 0);
+
+    for (i = 0; i < APM_PORTS; i++) {
+        Status = prvApmSetup(&xApm[i], ulApmBase[i], intr_priority);
+        if (Status != XST_SUCCESS) {
+            return Status;
+        }
+    }
+
+    ulApmSeq = ulRpuSeqInit(APM_ADDR + APM_SEQ_OFFSET);
+    ulApmSamples = 0;
+    Xil_Out32(APM_ADDR + APM_SAMPLES_OFFSET, 0);
+    Xil_Out32(APM_ADDR + APM_PERIOD_OFFSET, RPU_APM_PERIOD_MS);
+    Xil_Out32(APM_ADDR + APM_TICKS_OFFSET, 0);
+    Xil_Out32(APM_ADDR + APM_COUNT_OFFSET, APM_PORTS);
+    // Filled in by xRpuQosInit() when the firmware has a QoS profile
+    Xil_Out32(APM_ADDR + APM_QOS_PORTS_OFFSET, 0);
+    Xil_Out32(APM_ADDR + APM_QOS_LEVEL_OFFSET, 0);
+    // A request left by a previous instance is not replayed
+    Xil_Out32(APM_ADDR + APM_CAP_DONE_OFFSET, Xil_In32(APM_ADDR + APM_CAP_GEN_OFFSET));
+
+    (void)xTaskCreateStatic( prvApmTask,
+                             ( const char * ) "APM",
+                             APM_TASK_STACK_SIZE,
+                             NULL,
+                             task_priority,
+                             RPU_TASK_STACK_BUF(xApmStack),
+                             &xApmTaskBuffer );
+
+    __sync_synchronize();
+    Xil_Out32(APM_ADDR + APM_MAGIC_OFFSET, APM_MAGIC);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_APM */
@@ -0,0 +1,54 @@
+/*
+ * Interconnect bandwidth and latency from the PS AXI performance monitors
+ * (build option RPU_APM=1, UserConfig.cmake; RPU0 firmware only).
+ *
+ * xRpuApmInit() programs the single-slot APMs of the OCM, the LPD main switch
+ * and the CCI (APM_PORT_*, rpu_shm.h) with three metric counters each: write
+ * bytes, read bytes and the longest read latency, from address issue to the
+ * last data beat. A low priority task samples all of them every
+ * RPU_APM_PERIOD_MS through their sample registers, which latch and restart
+ * the counters at once, and publishes the interval into the APM block in OCM;
+ * apu_app/rpu_stats --apm prints it. The DDR APM is left alone: with six
+ * slots it is the one Linux tools (perf, uio) usually program.
+ *
+ * The monitors see the traffic of every master on their port, not only the
+ * RPU's. Write latency is not measured: the small APMs have three counters.
+ *
+ * rpu_stats --apm-capture asks for a finer look at one port through the
+ * APM_CAP_* words: the same counters over hardware-timed intervals down to
+ * APM_CAP_MIN_INTERVAL APM clocks, optionally of one AXI ID only, recorded
+ * into the RPU0 bulk carveout (struct rpu_apm_record). The PS monitors are
+ * built without the event log FIFO, so per-transaction logs are not possible;
+ * these records are the closest thing. No bulk transfer may run meanwhile.
+ */
+
+#ifndef RPU_APM_H
+#define RPU_APM_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_APM
+#define RPU_APM 0
+#endif
+
+#define RPU_APM_PERIOD_MS       100   // 32-bit byte counts hold 4 GB per interval
+
+#if RPU_APM
+#if RPU_CORE != 0
+#error "RPU_APM is for the RPU0 firmware: the monitors are shared by both cores"
+#endif
+
+int xRpuApmInit(UBaseType_t task_priority, u16 intr_priority);
+#else
+static inline int xRpuApmInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    (void)task_priority;
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_APM */
+
+#endif /* RPU_APM_H */
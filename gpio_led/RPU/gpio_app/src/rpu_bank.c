@@ -0,0 +1,197 @@
+/*
+ * Multi-bank output engine (see rpu_bank.h).
+ *
+ * The table is built once at init from the build options and kept in BTCM
+ * with each bank's last field, so a pass is a load, a compare and, for a
+ * changed bank, one store per entry. A bank's field is taken from the frame
+ * with a shift and a mask (two words when it straddles one), never bit by
+ * bit.
+ */
+
+#include "rpu_led.h"
+
+#if RPU_LED_BANKS
+
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xstatus.h"
+#include "xparameters.h"
+#if RPU_BANK_EMIO_PINS > 0
+#include "xgpiops.h"
+#endif
+
+#include "kr260_regs.h"
+#include "rpu_boot.h"
+#include "rpu_tcm.h"
+
+#if RPU_BANK_AXI2_WIDTH > 0 && !XPAR_AXI_GPIO_0_IS_DUAL
+#error "RPU_BANK_AXI2_WIDTH needs the AXI GPIO with channel 2: re-export the XSA and regenerate the BSP"
+#endif
+
+#define BANK_EMIO_FIRST         3       // PS GPIO bank of EMIO pin 0
+#define BANK_MAX                (2 + (RPU_BANK_EMIO_PINS + 15) / 16 + 1)
+#define BANK_FIELD(width)       (((width) < 32) ? ((1U << (width)) - 1) : ~0U)
+
+typedef struct {
+    UINTPTR addr;       /* Register the bank is stored to */
+    u32 mask;           /* ORed into every store (MASK_DATA upper half) */
+    u32 last;           /* Field of the last store */
+    u8 first;           /* First channel of the frame */
+    u8 width;
+    u8 shift;           /* Register bit of the first channel */
+} RpuBank_t;
+
+static RpuBank_t xBanks[BANK_MAX] RPU_BTCM_BSS;
+static u32 ulBankCount RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT static void prvBankAdd(UINTPTR addr, u32 mask, u32 first, u32 width, u32 shift)
+{
+    RpuBank_t *bank = &xBanks[ulBankCount++];
+
+    bank->addr = addr;
+    bank->mask = mask;
+    bank->last = 0;
+    bank->first = (u8)first;
+    bank->width = (u8)width;
+    bank->shift = (u8)shift;
+    // All channels low before the frames start
+    Xil_Out32(addr, mask);
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuBankInit(XGpio *gpio, UINTPTR led_addr, u32 led_mask, u32 led_shift)
+{
+    u32 first = 0;
+
+    ulBankCount = 0;
+    prvBankAdd(led_addr, led_mask, first, RPU_LED_WIDTH, led_shift);
+    first += RPU_LED_WIDTH;
+
+#if RPU_BANK_AXI2_WIDTH > 0
+    XGpio_SetDataDirection(gpio, 2, 0x0);
+    prvBankAdd(gpio->BaseAddress + AXI_GPIO_DATA2_OFFSET, 0, first, RPU_BANK_AXI2_WIDTH, 0);
+    first += RPU_BANK_AXI2_WIDTH;
+#else
+    (void)gpio;
+#endif /* RPU_BANK_AXI2_WIDTH */
+
+#if RPU_BANK_EMIO_PINS > 0
+    {
+        static XGpioPs xBankGpioPs;
+        XGpioPs_Config *cfg = XGpioPs_LookupConfig(XPAR_XGPIOPS_0_BASEADDR);
+        u32 pin, n, half, pins;
+
+        if (cfg == NULL || XGpioPs_CfgInitialize(&xBankGpioPs, cfg, cfg->BaseAddr) != XST_SUCCESS) {
+            return XST_FAILURE;
+        }
+        // One bank per 16-pin half: MASK_DATA_LSW for pins 0-15, _MSW for 16-31
+        for (pin = 0; pin < RPU_BANK_EMIO_PINS; pin += n) {
+            n = RPU_BANK_EMIO_PINS - pin;
+            if (n > 16) {
+                n = 16;
+            }
+            half = pin / 16;
+            prvBankAdd(cfg->BaseAddr + XGPIOPS_DATA_LSW_OFFSET +
+                           (BANK_EMIO_FIRST + half / 2) * XGPIOPS_DATA_MASK_OFFSET + (half % 2) * 4,
+                       (~BANK_FIELD(n) & 0xFFFFU) << 16, first + pin, n, 0);
+        }
+        for (half = 0; half < (RPU_BANK_EMIO_PINS + 31) / 32; half++) {
+            n = RPU_BANK_EMIO_PINS - half * 32;
+            pins = BANK_FIELD((n < 32) ? n : 32);
+            XGpioPs_SetDirection(&xBankGpioPs, BANK_EMIO_FIRST + half,
+                                 XGpioPs_GetDirection(&xBankGpioPs, BANK_EMIO_FIRST + half) | pins);
+            XGpioPs_SetOutputEnable(&xBankGpioPs, BANK_EMIO_FIRST + half,
+                                    XGpioPs_GetOutputEnable(&xBankGpioPs, BANK_EMIO_FIRST + half) | pins);
+        }
+        first += RPU_BANK_EMIO_PINS;
+    }
+#endif /* RPU_BANK_EMIO_PINS */
+
+#if RPU_BANK_ATOMIC_WIDTH > 0
+    Xil_SetTlbAttributes(RPU_BANK_ATOMIC_BASE, STRONG_ORDERD_SHARED | PRIV_RW_USER_RW);
+    if (Xil_In32(RPU_BANK_ATOMIC_BASE + GPIO_ATOMIC_WIDTH_OFFSET) < RPU_BANK_ATOMIC_WIDTH) {
+        RPU_BOOT_PRINT("gpio_atomic at 0x%08x: %u outputs, %u channels mapped\r\n",
+                       (unsigned)RPU_BANK_ATOMIC_BASE,
+                       (unsigned)Xil_In32(RPU_BANK_ATOMIC_BASE + GPIO_ATOMIC_WIDTH_OFFSET),
+                       (unsigned)RPU_BANK_ATOMIC_WIDTH);
+    }
+    prvBankAdd(RPU_BANK_ATOMIC_BASE + GPIO_ATOMIC_DATA_OFFSET, 0, first, RPU_BANK_ATOMIC_WIDTH, 0);
+    first += RPU_BANK_ATOMIC_WIDTH;
+#endif /* RPU_BANK_ATOMIC_WIDTH */
+
+    RPU_BOOT_PRINT("LED banks: %u banks, %u channels\r\n", (unsigned)ulBankCount, (unsigned)first);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+void vRpuBankFill(RpuBankFrame_t *frame, u32 value)
+{
+    u32 group = value & BANK_FIELD(RPU_LED_WIDTH);
+    u32 word = 0;
+    u32 ch, w;
+
+    if (32 % RPU_LED_WIDTH == 0) {
+        // Every word holds the same whole groups
+        for (ch = 0; ch < 32; ch += RPU_LED_WIDTH) {
+            word |= group << ch;
+        }
+        for (w = 0; w < RPU_BANK_WORDS; w++) {
+            frame->bits[w] = word;
+        }
+    } else {
+        for (w = 0; w < RPU_BANK_WORDS; w++) {
+            frame->bits[w] = 0;
+        }
+        for (ch = 0; ch < RPU_BANK_CHANNELS; ch += RPU_LED_WIDTH) {
+            w = ch / 32;
+            frame->bits[w] |= group << (ch % 32);
+            if (ch % 32 + RPU_LED_WIDTH > 32 && w + 1 < RPU_BANK_WORDS) {
+                frame->bits[w + 1] |= group >> (32 - ch % 32);
+            }
+        }
+    }
+    if (RPU_BANK_CHANNELS % 32 != 0) {
+        frame->bits[RPU_BANK_WORDS - 1] &= BANK_FIELD(RPU_BANK_CHANNELS % 32);
+    }
+}
+
+/*-----------------------------------------------------------*/
+void vRpuBankRandom(RpuBankFrame_t *frame, RpuRand_t *rng)
+{
+    u32 w;
+
+    for (w = 0; w < RPU_BANK_WORDS; w++) {
+        frame->bits[w] = ulRpuRandNext(rng);
+    }
+    if (RPU_BANK_CHANNELS % 32 != 0) {
+        frame->bits[RPU_BANK_WORDS - 1] &= BANK_FIELD(RPU_BANK_CHANNELS % 32);
+    }
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT u32 ulRpuBankWrite(const RpuBankFrame_t *frame)
+{
+    RpuBank_t *bank = xBanks;
+    RpuBank_t *end = xBanks + ulBankCount;
+    u32 stores = 0;
+    u32 word, bit, field;
+
+    for (; bank < end; bank++) {
+        word = bank->first / 32;
+        bit = bank->first % 32;
+        field = frame->bits[word] >> bit;
+        if (bit + bank->width > 32) {
+            field |= frame->bits[word + 1] << (32 - bit);
+        }
+        field &= BANK_FIELD(bank->width);
+        if (field != bank->last) {
+            Xil_Out32(bank->addr, bank->mask | (field << bank->shift));
+            bank->last = field;
+            stores++;
+        }
+    }
+    return stores;
+}
+
+#endif /* RPU_LED_BANKS */
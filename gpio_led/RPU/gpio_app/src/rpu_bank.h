@@ -0,0 +1,105 @@
+/*
+ * Multi-bank output engine of the Rx task (build option RPU_LED_BANKS=1,
+ * UserConfig.cmake).
+ *
+ * A frame is a bitset of RPU_BANK_CHANNELS output channels instead of one
+ * LED value. The channels are laid out over a table of banks, each a
+ * register that one store updates:
+ *
+ *   channels                       bank
+ *   0 .. RPU_LED_WIDTH-1           the LEDs (rpu_led.h: AXI GPIO channel 1,
+ *                                  or the PS GPIO field with RPU_LED_PS_GPIO=1)
+ *   next RPU_BANK_AXI2_WIDTH       AXI GPIO channel 2 (DATA2)
+ *   next RPU_BANK_EMIO_PINS        PS GPIO EMIO pins 0.. (banks 3-5), one bank
+ *                                  per 16-pin half, through MASK_DATA_LSW/MSW
+ *   next RPU_BANK_ATOMIC_WIDTH     DATA of a gpio_atomic block at
+ *                                  RPU_BANK_ATOMIC_BASE (kr260_regs.h)
+ *
+ * vRpuBankWrite() walks the table once per frame and stores only the banks
+ * whose field changed since the last frame, so a tick that moves a few
+ * channels costs a few stores, and dozens of channels need no task, queue
+ * or message of their own. Each bank keeps its last value in BTCM; nothing
+ * is read back from the bus.
+ *
+ * The blink modes still produce one LED value: vRpuBankFill() repeats its
+ * low RPU_LED_WIDTH bits over every group of channels, so SLOW and FAST
+ * alternate the even and odd channels and pattern programs drive each group
+ * alike. BLINK_RANDOM draws every channel (vRpuBankRandom()).
+ *
+ * The PL design must bring the channels out: a dual-channel AXI GPIO whose
+ * channel 2 is an output (not with RPU_GPIO_IN=1), the EMIO pins routed to
+ * the pins, a gpio_atomic block in the address map. None of them is in the
+ * current design, so all three default to 0 channels.
+ */
+
+#ifndef RPU_BANK_H
+#define RPU_BANK_H
+
+#include "xil_types.h"
+#include "xgpio.h"
+#include "rpu_rand.h"
+
+#ifndef RPU_LED_BANKS
+#define RPU_LED_BANKS 0
+#endif
+
+#ifndef RPU_BANK_AXI2_WIDTH
+#define RPU_BANK_AXI2_WIDTH     0       // AXI GPIO channel 2 outputs
+#endif
+#ifndef RPU_BANK_EMIO_PINS
+#define RPU_BANK_EMIO_PINS      0       // EMIO GPIO 0.. outputs, up to 96
+#endif
+#ifndef RPU_BANK_ATOMIC_BASE
+#define RPU_BANK_ATOMIC_BASE    0       // gpio_atomic block, 0: none
+#endif
+#ifndef RPU_BANK_ATOMIC_WIDTH
+#define RPU_BANK_ATOMIC_WIDTH   ((RPU_BANK_ATOMIC_BASE != 0) ? 32 : 0)
+#endif
+
+#if RPU_LED_BANKS
+#if RPU_BANK_AXI2_WIDTH > 32 || RPU_BANK_ATOMIC_WIDTH > 32
+#error "An AXI GPIO channel or a gpio_atomic block has at most 32 outputs"
+#endif
+#if RPU_BANK_EMIO_PINS > 96
+#error "RPU_BANK_EMIO_PINS must be 0..96 (PS GPIO banks 3-5)"
+#endif
+#if RPU_BANK_AXI2_WIDTH > 0 && RPU_GPIO_IN
+#error "RPU_BANK_AXI2_WIDTH takes AXI GPIO channel 2, which RPU_GPIO_IN=1 reads"
+#endif
+#if RPU_BANK_EMIO_PINS > 0 && RPU_LED_PS_GPIO && RPU_LED_PS_BANK >= 3
+#error "The EMIO banks would drive the RPU_LED_PS_GPIO pins"
+#endif
+#endif /* RPU_LED_BANKS */
+
+#if RPU_LED_BANKS
+#define RPU_BANK_CHANNELS       (RPU_LED_WIDTH + RPU_BANK_AXI2_WIDTH + \
+                                 RPU_BANK_EMIO_PINS + RPU_BANK_ATOMIC_WIDTH)
+#else
+#define RPU_BANK_CHANNELS       RPU_LED_WIDTH
+#endif /* RPU_LED_BANKS */
+#define RPU_BANK_WORDS          ((RPU_BANK_CHANNELS + 31) / 32)
+
+/* Channel n is bit n % 32 of bits[n / 32]; bits past the last channel are 0 */
+typedef struct {
+    u32 bits[RPU_BANK_WORDS];
+} RpuBankFrame_t;
+
+/* The LED value of a frame: its first RPU_LED_WIDTH channels */
+static inline u32 ulRpuBankLeds(const RpuBankFrame_t *frame)
+{
+    return frame->bits[0] & ((RPU_LED_WIDTH < 32) ? ((1U << RPU_LED_WIDTH) - 1) : ~0U);
+}
+
+#if RPU_LED_BANKS
+/* Build the table and drive every channel low; the LED bank is the store
+ * value = mask | (field << shift) to led_addr (rpu_led.c) */
+int xRpuBankInit(XGpio *gpio, UINTPTR led_addr, u32 led_mask, u32 led_shift);
+/* The low RPU_LED_WIDTH bits of value on every group of channels */
+void vRpuBankFill(RpuBankFrame_t *frame, u32 value);
+/* Every channel from rng */
+void vRpuBankRandom(RpuBankFrame_t *frame, RpuRand_t *rng);
+/* Store the banks whose channels changed (Rx task only); returns the stores */
+u32 ulRpuBankWrite(const RpuBankFrame_t *frame);
+#endif /* RPU_LED_BANKS */
+
+#endif /* RPU_BANK_H */
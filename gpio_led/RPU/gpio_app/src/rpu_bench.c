@@ -0,0 +1,341 @@
+/*
+ * Kernel latency benchmark (see rpu_bench.h, rpu_shm.h).
+ *
+ * The tests run one after the other and every sample is recorded by exactly
+ * one context (the driver, a receiver or the SGI handler), so the statistics
+ * need no lock: when the driver publishes them at the end of a round, every
+ * receiver is blocked again. The cycle counter is enabled without a reset,
+ * as in rpu_led.c; only deltas are taken.
+ */
+
+#include "rpu_bench.h"
+
+#if RPU_BENCH
+
+#include <string.h>
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexr5.h"
+#include "xpm_counter.h"
+#include "xscugic_hw.h"
+#include "xinterrupt_wrap.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "rpu_log.h"
+#include "rpu_seqlock.h"
+#include "rpu_shm.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+
+#define BENCH_PMCR_ENABLE      (1U << 0)   // PMCR.E: counters enabled
+#define BENCH_PMCR_CCNT_DIV    (1U << 3)   // PMCR.D: count every 64 cycles
+#define BENCH_CCNT_ENABLE      (1U << 31)  // PMCNTENSET.C
+#define BENCH_GICD_BASE        0xF9000000U // Distributor (IPI_INTC_PARENT)
+#define BENCH_SGI_SELF         (0x2U << 24) // SGIR target list filter: this core only
+
+/* Indexed by BENCH_TEST_* */
+static const char * const pcBenchName[BENCH_TESTS] = {
+    "yield", "sem", "queue", "notify", "irq", "isr_task"
+};
+
+static struct rpu_irqprof_stage xBenchStat[BENCH_TESTS] RPU_BTCM_BSS;
+static u64 ullBenchSum[BENCH_TESTS] RPU_BTCM_BSS;
+static volatile u32 ulBenchStamp RPU_BTCM_BSS;     /* Start of a yield or irq sample */
+static volatile u32 ulBenchIsrSeen RPU_BTCM_BSS;   /* isr_task samples taken */
+static u32 ulBenchRounds;
+static u32 ulBenchSeq;
+
+static TaskHandle_t xBenchYieldTask;
+static TaskHandle_t xBenchNotifyTask;
+static TaskHandle_t xBenchIsrTask;
+static SemaphoreHandle_t xBenchPing;
+static SemaphoreHandle_t xBenchPong;
+static QueueHandle_t xBenchQueue;
+
+static StaticTask_t xBenchTaskBuffer[6] RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xBenchStack[6], configMINIMAL_STACK_SIZE) RPU_BTCM_NOINIT;
+static StaticSemaphore_t xBenchPingBuffer RPU_BTCM_NOINIT;
+static StaticSemaphore_t xBenchPongBuffer RPU_BTCM_NOINIT;
+static StaticQueue_t xBenchQueueBuffer RPU_BTCM_NOINIT;
+static uint8_t ucBenchQueueStorage[sizeof(u32)] RPU_BTCM_NOINIT;
+
+static inline u32 ulBenchCycles(void)
+{
+    return Xpm_ReadCycleCounterVal();
+}
+
+/*-----------------------------------------------------------*/
+static u32 prvBenchBucket(u32 cycles)
+{
+    u32 bits = 32 - __builtin_clz(cycles | 1);
+
+    if (bits <= IRQPROF_BUCKET_SHIFT) {
+        return 0;
+    }
+    bits -= IRQPROF_BUCKET_SHIFT;
+    return bits < IRQPROF_BUCKETS ? bits : IRQPROF_BUCKETS - 1;
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT static void prvBenchRecord(u32 test, u32 cycles)
+{
+    struct rpu_irqprof_stage *s = &xBenchStat[test];
+
+    s->count++;
+    s->last = cycles;
+    if (cycles < s->min) {
+        s->min = cycles;
+    }
+    if (cycles > s->max) {
+        s->max = cycles;
+    }
+    ullBenchSum[test] += cycles;
+    s->hist[prvBenchBucket(cycles)]++;
+}
+
+/*-----------------------------------------------------------*/
+/* Upper bound of the bucket holding the 99th percentile (the maximum in the
+ * open last bucket) */
+static u32 prvBenchP99(const struct rpu_irqprof_stage *s)
+{
+    u32 want = s->count - s->count / 100;
+    u32 seen = 0;
+    u32 b;
+
+    for (b = 0; b < IRQPROF_BUCKETS - 1; b++) {
+        seen += s->hist[b];
+        if (seen >= want) {
+            return 1U << (b + IRQPROF_BUCKET_SHIFT);
+        }
+    }
+    return s->max;
+}
+
+/*-----------------------------------------------------------*/
+/* The receivers: each records the time from the driver's stamp to its wake-up */
+static void prvBenchYieldTask(void *pvParameters)
+{
+    u32 i;
+
+    (void)pvParameters;
+    for (;;) {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        for (i = 0; i < RPU_BENCH_ITERATIONS; i++) {
+            prvBenchRecord(BENCH_TEST_YIELD, ulBenchCycles() - ulBenchStamp);
+            // The last sample leaves the driver to finish its loop
+            if (i + 1 < RPU_BENCH_ITERATIONS) {
+                taskYIELD();
+            }
+        }
+    }
+}
+
+static void prvBenchSemTask(void *pvParameters)
+{
+    (void)pvParameters;
+    for (;;) {
+        (void)xSemaphoreTake(xBenchPing, portMAX_DELAY);
+        (void)xSemaphoreGive(xBenchPong);
+    }
+}
+
+static void prvBenchQueueTask(void *pvParameters)
+{
+    u32 stamp;
+
+    (void)pvParameters;
+    for (;;) {
+        if (xQueueReceive(xBenchQueue, &stamp, portMAX_DELAY) == pdPASS) {
+            prvBenchRecord(BENCH_TEST_QUEUE, ulBenchCycles() - stamp);
+        }
+    }
+}
+
+static void prvBenchNotifyTask(void *pvParameters)
+{
+    uint32_t stamp;
+
+    (void)pvParameters;
+    for (;;) {
+        if (xTaskNotifyWait(0, 0xFFFFFFFFUL, &stamp, portMAX_DELAY) == pdTRUE) {
+            prvBenchRecord(BENCH_TEST_NOTIFY, ulBenchCycles() - stamp);
+        }
+    }
+}
+
+static void prvBenchIsrTask(void *pvParameters)
+{
+    uint32_t entry;
+
+    (void)pvParameters;
+    for (;;) {
+        if (xTaskNotifyWait(0, 0xFFFFFFFFUL, &entry, portMAX_DELAY) == pdTRUE) {
+            prvBenchRecord(BENCH_TEST_ISR_TASK, ulBenchCycles() - entry);
+            ulBenchIsrSeen++;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT static void prvBenchSgi(void *CallbackRef)
+{
+    u32 entry = ulBenchCycles();
+    BaseType_t xWoken = pdFALSE;
+
+    (void)CallbackRef;
+    prvBenchRecord(BENCH_TEST_IRQ, entry - ulBenchStamp);
+    xTaskNotifyFromISR(xBenchIsrTask, entry, eSetValueWithOverwrite, &xWoken);
+    portYIELD_FROM_ISR(xWoken);
+}
+
+/*-----------------------------------------------------------*/
+/* Copy every test into the block under the seq word */
+static void prvBenchPublish(void)
+{
+    u32 i, w;
+
+    vRpuSeqBegin(BENCH_ADDR + BENCH_SEQ_OFFSET, &ulBenchSeq);
+    for (i = 0; i < BENCH_TESTS; i++) {
+        const struct rpu_irqprof_stage *s = &xBenchStat[i];
+        UINTPTR base = BENCH_ADDR + BENCH_TEST(i);
+
+        Xil_Out32(base + 0x00, s->count);
+        Xil_Out32(base + 0x04, s->min);
+        Xil_Out32(base + 0x08, s->max);
+        Xil_Out32(base + 0x0C, s->last);
+        Xil_Out32(base + 0x10, (u32)ullBenchSum[i]);
+        Xil_Out32(base + 0x14, (u32)(ullBenchSum[i] >> 32));
+        for (w = 0; w < IRQPROF_BUCKETS; w++) {
+            Xil_Out32(base + IRQPROF_STAGE_HIST + w * 4, s->hist[w]);
+        }
+    }
+    Xil_Out32(BENCH_ADDR + BENCH_ROUNDS_OFFSET, ulBenchRounds);
+    vRpuSeqEnd(BENCH_ADDR + BENCH_SEQ_OFFSET, &ulBenchSeq);
+}
+
+/*-----------------------------------------------------------*/
+/* The driver: one round of every test, then the report */
+static void prvBenchTask(void *pvParameters)
+{
+    u32 i, t, start;
+
+    (void)pvParameters;
+    for (;;) {
+        xTaskNotifyGive(xBenchYieldTask);
+        for (i = 0; i < RPU_BENCH_ITERATIONS; i++) {
+            ulBenchStamp = ulBenchCycles();
+            taskYIELD();
+        }
+
+        for (i = 0; i < RPU_BENCH_ITERATIONS; i++) {
+            start = ulBenchCycles();
+            (void)xSemaphoreGive(xBenchPing);
+            (void)xSemaphoreTake(xBenchPong, portMAX_DELAY);
+            prvBenchRecord(BENCH_TEST_SEM, ulBenchCycles() - start);
+        }
+
+        for (i = 0; i < RPU_BENCH_ITERATIONS; i++) {
+            start = ulBenchCycles();
+            (void)xQueueSend(xBenchQueue, &start, portMAX_DELAY);
+        }
+
+        for (i = 0; i < RPU_BENCH_ITERATIONS; i++) {
+            xTaskNotify(xBenchNotifyTask, ulBenchCycles(), eSetValueWithOverwrite);
+        }
+
+        ulBenchIsrSeen = 0;
+        for (i = 0; i < RPU_BENCH_ITERATIONS; i++) {
+            ulBenchStamp = ulBenchCycles();
+            Xil_Out32(BENCH_GICD_BASE + XSCUGIC_SFI_TRIG_OFFSET, BENCH_SGI_SELF | RPU_BENCH_SGI);
+            // The receiver preempts this task from the handler exit
+            while (ulBenchIsrSeen != i + 1) {
+            }
+        }
+
+        ulBenchRounds++;
+        prvBenchPublish();
+        RPU_LOG("Bench round %u, %u samples per test, cycles at %u Hz\r\n",
+                (unsigned)ulBenchRounds, (unsigned)RPU_BENCH_ITERATIONS,
+                (unsigned)XPAR_CPU_CORE_CLOCK_FREQ_HZ);
+        for (t = 0; t < BENCH_TESTS; t++) {
+            const struct rpu_irqprof_stage *s = &xBenchStat[t];
+
+            RPU_LOG("  %s: mean %u, p99 < %u, max %u cycles\r\n", pcBenchName[t],
+                    (unsigned)(ullBenchSum[t] / s->count), (unsigned)prvBenchP99(s),
+                    (unsigned)s->max);
+        }
+        vTaskDelay(pdMS_TO_TICKS(RPU_BENCH_PERIOD_MS));
+    }
+}
+
+/*-----------------------------------------------------------*/
+static TaskHandle_t prvBenchCreate(u32 idx, TaskFunction_t fn, const char *name,
+                                   UBaseType_t priority)
+{
+    return xTaskCreateStatic(fn, name, configMINIMAL_STACK_SIZE, NULL, priority,
+                             RPU_TASK_STACK_BUF(xBenchStack[idx]), &xBenchTaskBuffer[idx]);
+}
+
+/*-----------------------------------------------------------*/
+/* Start the cycle counter, announce the block, create the tasks and the SGI */
+RPU_INIT_TEXT int xRpuBenchInit(UBaseType_t priority, u32 intr_priority)
+{
+    u32 sgi = RPU_BENCH_SGI | XINTC_IS_SGI_INTR_MASK;
+    u32 pmcr;
+    u32 i;
+    int Status;
+
+    if (priority + 1 >= configMAX_PRIORITIES) {
+        return XST_INVALID_PARAM;
+    }
+
+    pmcr = mfcp(XREG_CP15_PERF_MONITOR_CTRL);
+    mtcp(XREG_CP15_PERF_MONITOR_CTRL, (pmcr & ~BENCH_PMCR_CCNT_DIV) | BENCH_PMCR_ENABLE);
+    mtcp(XREG_CP15_COUNT_ENABLE_SET, BENCH_CCNT_ENABLE);
+    isb();
+
+    Xil_SetTlbAttributes(BENCH_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(BENCH_ADDR + BENCH_MAGIC_OFFSET, 0);
+    memset(xBenchStat, 0, sizeof(xBenchStat));
+    memset(ullBenchSum, 0, sizeof(ullBenchSum));
+    for (i = 0; i < BENCH_TESTS; i++) {
+        xBenchStat[i].min = 0xFFFFFFFF;
+    }
+    ulBenchSeq = ulRpuSeqInit(BENCH_ADDR + BENCH_SEQ_OFFSET);
+    Xil_Out32(BENCH_ADDR + BENCH_HZ_OFFSET, XPAR_CPU_CORE_CLOCK_FREQ_HZ);
+    Xil_Out32(BENCH_ADDR + BENCH_ITERATIONS_OFFSET, RPU_BENCH_ITERATIONS);
+    Xil_Out32(BENCH_ADDR + BENCH_COUNT_OFFSET, BENCH_TESTS);
+    prvBenchPublish();
+    Xil_Out32(BENCH_ADDR + BENCH_MAGIC_OFFSET, BENCH_MAGIC);
+
+    // Before the tasks: without the SGI the driver would wait for it forever
+    Status = XSetupInterruptSystem(NULL, (Xil_ExceptionHandler)prvBenchSgi, sgi,
+                                   BENCH_GICD_BASE, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(sgi, BENCH_GICD_BASE);
+
+    xBenchPing = xSemaphoreCreateBinaryStatic(&xBenchPingBuffer);
+    xBenchPong = xSemaphoreCreateBinaryStatic(&xBenchPongBuffer);
+    xBenchQueue = xQueueCreateStatic(1, sizeof(u32), ucBenchQueueStorage, &xBenchQueueBuffer);
+    configASSERT(xBenchPing && xBenchPong && xBenchQueue);
+
+    // The yield partner shares the driver's priority, the receivers preempt it
+    (void)prvBenchCreate(0, prvBenchTask, "Bench", priority);
+    xBenchYieldTask = prvBenchCreate(1, prvBenchYieldTask, "BYield", priority);
+    (void)prvBenchCreate(2, prvBenchSemTask, "BSem", priority + 1);
+    (void)prvBenchCreate(3, prvBenchQueueTask, "BQueue", priority + 1);
+    xBenchNotifyTask = prvBenchCreate(4, prvBenchNotifyTask, "BNotify", priority + 1);
+    xBenchIsrTask = prvBenchCreate(5, prvBenchIsrTask, "BIsr", priority + 1);
+
+    xil_printf("Benchmark: %u samples per test every %u ms, results at 0x%08x\r\n",
+               (unsigned)RPU_BENCH_ITERATIONS, (unsigned)RPU_BENCH_PERIOD_MS,
+               (unsigned)BENCH_ADDR);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_BENCH */
@@ -0,0 +1,64 @@
+/*
+ * Kernel latency benchmark (build option RPU_BENCH=1, UserConfig.cmake; RPU0
+ * firmware only).
+ *
+ * The benchmark build runs these tasks instead of the LED application:
+ * main() starts them and the scheduler only, so the tick and the log task
+ * are all that share the core with them. A driver task takes
+ * RPU_BENCH_ITERATIONS samples of every test in a round, publishes the
+ * statistics, logs one line per test and sleeps RPU_BENCH_PERIOD_MS:
+ *
+ *   yield     taskYIELD() until a task of the same priority runs
+ *   sem       binary semaphore given to a higher-priority task until its
+ *             answer is taken back (round trip, two context switches)
+ *   queue     xQueueSend() until the higher-priority receiver runs
+ *   notify    xTaskNotify() until the notified task runs
+ *   irq       SGI written to the distributor until its handler runs
+ *   isr_task  handler entry, through xTaskNotifyFromISR(), until the task runs
+ *
+ * Times are PMU cycle counter deltas (as rpu_irqprof.h). Every test keeps
+ * count, min, max, sum and a log2 histogram in the BENCH block in OCM
+ * (rpu_shm.h), read with apu_app/rpu_stats --bench; the log line has the
+ * mean, the 99th percentile bound from the histogram and the maximum. The
+ * SGI is at the IPI priority (RPU_INTR_IPI_LEVEL), so irq and isr_task are
+ * the doorbell path without the IPI controller.
+ */
+
+#ifndef RPU_BENCH_H
+#define RPU_BENCH_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_BENCH
+#define RPU_BENCH 0
+#endif
+
+#ifndef RPU_BENCH_ITERATIONS
+#define RPU_BENCH_ITERATIONS    1000
+#endif
+#ifndef RPU_BENCH_PERIOD_MS
+#define RPU_BENCH_PERIOD_MS     1000
+#endif
+#define RPU_BENCH_SGI           13    // Software interrupt of the irq and isr_task tests
+
+#if RPU_BENCH
+#if RPU_CORE != 0
+#error "RPU_BENCH is for the RPU0 firmware: there is one benchmark block"
+#endif
+
+/* Create the benchmark tasks (the driver at priority, the receivers above it)
+ * and connect the SGI at intr_priority; called before the scheduler starts */
+int xRpuBenchInit(UBaseType_t priority, u32 intr_priority);
+#else
+static inline int xRpuBenchInit(UBaseType_t priority, u32 intr_priority)
+{
+    (void)priority;
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_BENCH */
+
+#endif /* RPU_BENCH_H */
@@ -0,0 +1,84 @@
+/*
+ * Boot time breakdown from the PMU cycle counter (see rpu_boot.h).
+ *
+ * Stamps are the cycles since __cpu_init reset the counter: the count read
+ * at main() entry is in 64-cycle units, so it is scaled once and the
+ * difference is added to every later reading at the CPU clock.
+ */
+
+#include "rpu_boot.h"
+
+#include "xparameters.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexr5.h"
+#include "xpm_counter.h"
+
+#include "rpu_tcm.h"
+
+#define BOOT_PMCR_ENABLE       (1U << 0)   // PMCR.E: counters enabled
+#define BOOT_PMCR_CCNT_DIV     (1U << 3)   // PMCR.D: count every 64 cycles
+#define BOOT_CCNT_ENABLE       (1U << 31)  // PMCNTENSET.C
+#define BOOT_CCNT_DIVIDER      64U
+
+static const char * const pcBootStage[RPU_BOOT_STAGES] = {
+    "crt0", "log", "handoff", "tasks", "shm", "ipi", "drivers", "gpio", "scheduler",
+};
+
+static u32 ulBootStamp[RPU_BOOT_STAGES];
+static u32 ulBootMarked;
+static u32 ulBootOffset;
+
+/*-----------------------------------------------------------*/
+static u32 prvBootUs(u32 cycles)
+{
+    return (u32)(((u64)cycles * 1000000U) / XPAR_CPU_CORE_CLOCK_FREQ_HZ);
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT void vRpuBootInit(void)
+{
+    u32 pmcr = mfcp(XREG_CP15_PERF_MONITOR_CTRL);
+    u32 count = Xpm_ReadCycleCounterVal();
+
+    // Running since __cpu_init; a loader that left D clear counted cycles
+    if (pmcr & BOOT_PMCR_CCNT_DIV) {
+        ulBootOffset = count * (BOOT_CCNT_DIVIDER - 1);
+    }
+    mtcp(XREG_CP15_PERF_MONITOR_CTRL, (pmcr & ~BOOT_PMCR_CCNT_DIV) | BOOT_PMCR_ENABLE);
+    mtcp(XREG_CP15_COUNT_ENABLE_SET, BOOT_CCNT_ENABLE);
+    isb();
+
+    ulBootStamp[RPU_BOOT_CRT0] = count + ulBootOffset;
+    ulBootMarked = 1U << RPU_BOOT_CRT0;
+}
+
+/*-----------------------------------------------------------*/
+void vRpuBootMark(u32 stage)
+{
+    if (stage < RPU_BOOT_STAGES && (ulBootMarked & (1U << stage)) == 0) {
+        ulBootStamp[stage] = Xpm_ReadCycleCounterVal() + ulBootOffset;
+        ulBootMarked |= 1U << stage;
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Stages not marked (an early exit of main()) count into the next one */
+void vRpuBootReport(void)
+{
+    u32 last = 0;
+    u32 i;
+
+    if (ulBootMarked & (1U << RPU_BOOT_READY)) {
+        return;
+    }
+    vRpuBootMark(RPU_BOOT_READY);
+
+    for (i = 0; i < RPU_BOOT_STAGES; i++) {
+        if (ulBootMarked & (1U << i)) {
+            RPU_LOG("Boot %s: %u us\r\n", pcBootStage[i], prvBootUs(ulBootStamp[i] - last));
+            last = ulBootStamp[i];
+        }
+    }
+    RPU_LOG("Boot: IPI ready %u us after the C runtime start (%u cycles)\r\n",
+            prvBootUs(last), last);
+}
@@ -0,0 +1,74 @@
+/*
+ * Boot time breakdown and the fast boot option (build option
+ * RPU_FAST_BOOT=1, UserConfig.cmake).
+ *
+ * The BSP's __cpu_init (cpu_init.S, first call of _startup) resets the PMU
+ * cycle counter and starts it with PMCR.D set, one count per 64 cycles, so
+ * the counter holds the time since the C runtime started. vRpuBootInit() at
+ * the top of main() scales that count and sets the counter to the CPU clock;
+ * vRpuBootMark() then stamps the stages of main() and vRpuBootReport(),
+ * called by the IPI task on its first run, logs each stage and the total to
+ * "IPI ready" with RPU_LOG:
+ *
+ *   crt0        BSS clear, TTC time base, constructors (before main)
+ *   log         deferred log and stack guard
+ *   handoff     resume of a handed-off state (rpu_handoff.h)
+ *   tasks       tasks, message buffer, mode timer
+ *   shm         AXI GPIO, mailboxes, shared memory protocol state
+ *   ipi         IPI message buffers and interrupt
+ *   drivers     waveform engines, DMA, monitors and the optional modules
+ *   gpio        GPIO direction, LED backend, console and profilers
+ *   scheduler   vTaskStartScheduler() to the IPI task's first run
+ *
+ * The reset vector, MPU and cache setup of boot.S run before the counter
+ * starts and are not included; the gap from the remoteproc start is the
+ * ELF load, mostly proportional to its loaded size. The counter is 32-bit,
+ * which covers 8 s at 533 MHz.
+ *
+ * With RPU_FAST_BOOT=1:
+ * - RPU_BOOT_PRINT() messages of the boot path (banner, IPI setup, LED
+ *   backend) go to the deferred log instead of the polled UART, about 87 us
+ *   per character at 115200 baud; failures still print directly
+ * - The waveform engines are initialized by the first RPU_CMD_WAVE start
+ *   instead of in main() (RPU_BOOT_LAZY_WAVE)
+ */
+
+#ifndef RPU_BOOT_H
+#define RPU_BOOT_H
+
+#include "xil_types.h"
+#include "xil_printf.h"
+#include "rpu_log.h"
+
+#ifndef RPU_FAST_BOOT
+#define RPU_FAST_BOOT 0
+#endif
+
+// Stages, in boot order; the IPI task marks RPU_BOOT_READY
+#define RPU_BOOT_CRT0        0
+#define RPU_BOOT_LOG         1
+#define RPU_BOOT_HANDOFF     2
+#define RPU_BOOT_TASKS       3
+#define RPU_BOOT_SHM         4
+#define RPU_BOOT_IPI         5
+#define RPU_BOOT_DRIVERS     6
+#define RPU_BOOT_GPIO        7
+#define RPU_BOOT_READY       8
+#define RPU_BOOT_STAGES      9
+
+#if RPU_FAST_BOOT
+#define RPU_BOOT_PRINT(fmt, ...)  RPU_LOG(fmt, ##__VA_ARGS__)
+#define RPU_BOOT_LAZY_WAVE        1
+#else
+#define RPU_BOOT_PRINT(fmt, ...)  xil_printf(fmt, ##__VA_ARGS__)
+#define RPU_BOOT_LAZY_WAVE        0
+#endif /* RPU_FAST_BOOT */
+
+/* First thing in main(): stamps RPU_BOOT_CRT0, counter to the CPU clock */
+void vRpuBootInit(void);
+/* End of a stage; each stage is stamped once */
+void vRpuBootMark(u32 stage);
+/* Stamps RPU_BOOT_READY and logs the breakdown, once */
+void vRpuBootReport(void);
+
+#endif /* RPU_BOOT_H */
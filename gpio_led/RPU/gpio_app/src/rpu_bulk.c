@@ -0,0 +1,356 @@
+/*
+ * Bulk APU <-> RPU data channel (see rpu_bulk.h, rpu_shm.h).
+ *
+ * One LPD DMA channel per core moves the descriptors between the DDR
+ * carveout and the BTCM buffer, seen by the DMA through the global TCM
+ * alias. The bulk task queues the valid descriptors pending in the ring as
+ * jobs of the DMA queue (rpu_dmaq.h), which chains them into back-to-back
+ * passes, and sleeps until their completion notifications, so the R5 is
+ * free for the other tasks while the data moves. With a hook registered the
+ * descriptors run one at a time, as the hook must see each one before or
+ * after its transfer. Neither side of the transfer goes through the R5 data
+ * cache: the TCM is never cached and the RPU does not access the carveout
+ * itself.
+ *
+ * A descriptor with BULK_OP_F_CRC closes its batch: its CRC32C is taken on
+ * the buffer once the batch completed, when no later descriptor can have
+ * overwritten the payload yet. The R5 computes it from the table of
+ * rpu_crc32c.h, a few cycles a byte.
+ */
+
+#include <string.h>
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xzdma.h"
+#include "xstatus.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "kr260_regs.h"
+#include "rpu_bulk.h"
+#include "rpu_crc32c.h"
+#include "rpu_csum.h"
+#include "rpu_dmaq.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_trace.h"
+
+// LPD DMA (ADMA) channel of this core (rpu_core.h)
+#define BULK_DMA_BASEADDR      RPU_CORE_BULK_DMA
+#define BULK_DMA_BURST_LEN     16    // Longest ADMA burst
+#define BULK_DMA_ISSUE         16    // Outstanding source reads
+// 16 KB take about 20 us; this long without a completion is a stuck channel
+#define BULK_DMA_TIMEOUT_MS    100
+#define BULK_TASK_STACK_SIZE   (2 * configMINIMAL_STACK_SIZE)
+
+// Task notification bits of the bulk task
+#define BULK_NOTIFY_KICK       0x01  // vRpuBulkKick()
+#define BULK_NOTIFY_DMA        0x02  // A DMA job completed
+
+#if BULK_SLOTS > RPU_DMAQ_DEPTH
+#error "The DMA queue must take a full bulk ring"
+#endif
+
+// Reverse IPI to the APU channel (main.c raises it the same way)
+#define BULK_APU_MASK          0x01
+
+// In DDR: the DMA reads the descriptor chain of the queue
+static RpuDmaq_t xBulkQueue;
+static RpuDmaqJob_t xBulkJob[BULK_SLOTS];
+static TaskHandle_t xBulkTask;
+static RpuBulkHook_t xBulkHook;
+
+static StaticTask_t xBulkTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xBulkStack, BULK_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+static u8 ucBulkBuf[ RPU_BULK_BUF_SIZE ] RPU_BTCM_NOINIT __attribute__((aligned(64)));
+
+/*-----------------------------------------------------------*/
+/* Check one descriptor and fill its DMA job
+ * - Returns an RPU_CMD_STATUS_* value; the job is only valid for OK
+ */
+static u32 prvBulkPrepare(u32 op, u32 ddr_off, u32 buf_off, u32 len, RpuDmaqJob_t *job)
+{
+    UINTPTR ddr, buf;
+
+    op &= ~BULK_OP_F_CRC;
+    if (op != BULK_OP_WRITE && op != BULK_OP_READ) {
+        return RPU_CMD_STATUS_BADOP;
+    }
+    if (len == 0 || ((ddr_off | buf_off | len) & (BULK_ALIGN - 1)) != 0 ||
+        len > RPU_BULK_BUF_SIZE || buf_off > RPU_BULK_BUF_SIZE - len ||
+        ddr_off > BULK_DDR_CORE_SIZE - len) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+
+    ddr = RPU_BULK_DDR_BASE + ddr_off;
+    buf = RPU_TCM_GLOBAL(&ucBulkBuf[buf_off]);
+
+    // A producer fills the buffer before it goes out
+    if (op == BULK_OP_READ && xBulkHook != NULL) {
+        xBulkHook(op, &ucBulkBuf[buf_off], len);
+    }
+
+    memset(&job->xfer, 0, sizeof(job->xfer));
+    job->xfer.SrcAddr = (op == BULK_OP_WRITE) ? ddr : buf;
+    job->xfer.DstAddr = (op == BULK_OP_WRITE) ? buf : ddr;
+    job->xfer.Size = len;
+    job->fill = NULL;
+    job->task = xBulkTask;
+    job->notify_bits = BULK_NOTIFY_DMA;
+    job->status = RPU_DMAQ_FAILED;  // Until the queue takes it
+    return RPU_CMD_STATUS_OK;
+}
+
+/*-----------------------------------------------------------*/
+/* Run a BULK_OP_CHECKSUM descriptor
+ * - Returns an RPU_CMD_STATUS_* value; *sum is the word sum, *ticks the time
+ */
+static u32 prvBulkChecksum(u32 ddr_off, u32 len, u32 *sum, u32 *ticks)
+{
+    u64 start;
+    int Status;
+
+    *sum = 0;
+    *ticks = 0;
+    if (len == 0 || ((ddr_off | len) & (BULK_ALIGN - 1)) != 0 ||
+        len > BULK_DDR_CORE_SIZE || ddr_off > BULK_DDR_CORE_SIZE - len) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+    start = ullRpuTimeNow();
+    Status = xRpuCsumRange(RPU_BULK_DDR_BASE + ddr_off, len, sum);
+    *ticks = (u32)(ullRpuTimeNow() - start);
+    return (Status == XST_SUCCESS) ? RPU_CMD_STATUS_OK : RPU_CMD_STATUS_FAILED;
+}
+
+/*-----------------------------------------------------------*/
+/* Run a BULK_OP_PCAP descriptor
+ * - Returns an RPU_CMD_STATUS_* value; *ticks is the time
+ */
+static u32 prvBulkPcap(u32 ddr_off, u32 len, u32 flags, u32 *ticks)
+{
+    u64 start;
+    int Status;
+
+    *ticks = 0;
+    if (len == 0 || ((ddr_off | len) & (BULK_ALIGN - 1)) != 0 ||
+        len > BULK_DDR_CORE_SIZE || ddr_off > BULK_DDR_CORE_SIZE - len ||
+        (flags & ~BULK_PCAP_SWAP) != 0) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+    start = ullRpuTimeNow();
+    Status = xRpuPcapWrite(RPU_BULK_DDR_BASE + ddr_off, len,
+                           (flags & BULK_PCAP_SWAP) ? pdTRUE : pdFALSE);
+    *ticks = (u32)(ullRpuTimeNow() - start);
+    if (Status == XST_NO_FEATURE) {
+        return RPU_CMD_STATUS_BADOP;
+    }
+    return (Status == XST_SUCCESS) ? RPU_CMD_STATUS_OK : RPU_CMD_STATUS_FAILED;
+}
+
+/*-----------------------------------------------------------*/
+/* Sleep until the first count jobs completed; a channel that stays silent
+ * for BULK_DMA_TIMEOUT_MS is aborted, which fails the pass in flight */
+static void prvBulkWait(u32 count)
+{
+    u32 i = 0;
+
+    while (i < count) {
+        if (xBulkJob[i].status != RPU_DMAQ_PENDING) {
+            i++;
+            continue;
+        }
+        // Kicks meanwhile need no wake: the ring is read again afterwards
+        if (xTaskNotifyWait(0, BULK_NOTIFY_KICK | BULK_NOTIFY_DMA, NULL,
+                            pdMS_TO_TICKS(BULK_DMA_TIMEOUT_MS)) != pdTRUE) {
+            vRpuDmaqAbort(&xBulkQueue);
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* The Bulk Task:
+ * - Drains the bulk descriptor ring, woken by the IPI task through
+ *   vRpuBulkKick(); the valid descriptors pending at a time go to the DMA
+ *   queue together (one at a time with a hook), then complete in ring order.
+ */
+static void prvBulkTask( void *pvParameters )
+{
+    (void)pvParameters;
+
+    for( ;; )
+    {
+        (void)xTaskNotifyWait(0, BULK_NOTIFY_KICK | BULK_NOTIFY_DMA, NULL, portMAX_DELAY);
+
+        u32 tail = Xil_In32(RPU_BULK_CTRL_BASE + BULK_TAIL_OFFSET);
+        u32 drained = 0;
+
+        for( ;; )
+        {
+            u32 head = Xil_In32(RPU_BULK_CTRL_BASE + BULK_HEAD_OFFSET);
+            u32 status[BULK_SLOTS];
+            u32 job_of[BULK_SLOTS];
+            u32 limit = (xBulkHook != NULL) ? 1 : BULK_SLOTS;
+            u32 sum = 0;
+            u32 sum_ticks = 0;
+            u32 count, jobs, i;
+
+            if (head == tail) {
+                break;
+            }
+            // A head more than a ring ahead is a producer bug: drop the batch
+            if ((u32)(head - tail) > BULK_SLOTS) {
+                Xil_Out32(RPU_BULK_CTRL_BASE + BULK_TAIL_OFFSET, head);
+                break;
+            }
+            // Head publishes the descriptors, so read it before them
+            __sync_synchronize();
+
+            for (count = 0, jobs = 0; count < limit && tail + count != head; count++) {
+                UINTPTR desc = RPU_BULK_CTRL_BASE + BULK_DESC(tail + count);
+                u32 op = Xil_In32(desc + BULK_DESC_OP);
+
+                // A checksum or PCAP load runs on its own, after the transfers before it
+                if (op == BULK_OP_CHECKSUM || op == BULK_OP_PCAP) {
+                    if (count == 0 && op == BULK_OP_CHECKSUM) {
+                        status[count++] = prvBulkChecksum(Xil_In32(desc + BULK_DESC_DDR_OFFSET),
+                                                          Xil_In32(desc + BULK_DESC_LENGTH),
+                                                          &sum, &sum_ticks);
+                    } else if (count == 0) {
+                        status[count++] = prvBulkPcap(Xil_In32(desc + BULK_DESC_DDR_OFFSET),
+                                                      Xil_In32(desc + BULK_DESC_LENGTH),
+                                                      Xil_In32(desc + BULK_DESC_BUF_OFFSET),
+                                                      &sum_ticks);
+                    }
+                    break;
+                }
+                status[count] = prvBulkPrepare(op, Xil_In32(desc + BULK_DESC_DDR_OFFSET),
+                                               Xil_In32(desc + BULK_DESC_BUF_OFFSET),
+                                               Xil_In32(desc + BULK_DESC_LENGTH),
+                                               &xBulkJob[jobs]);
+                job_of[count] = jobs;
+                if (status[count] == RPU_CMD_STATUS_OK) {
+                    jobs++;
+                }
+                // Checked on the buffer after the batch: nothing may follow it
+                if (op & BULK_OP_F_CRC) {
+                    count++;
+                    break;
+                }
+            }
+            // The queue serves the bulk channel only, so a full ring fits
+            if (jobs != 0 && xRpuDmaqSubmit(&xBulkQueue, xBulkJob, jobs) == XST_SUCCESS) {
+                prvBulkWait(jobs);
+            }
+
+            for (i = 0; i < count; i++, tail++) {
+                UINTPTR desc = RPU_BULK_CTRL_BASE + BULK_DESC(tail);
+                u32 op = Xil_In32(desc + BULK_DESC_OP);
+                u32 len = Xil_In32(desc + BULK_DESC_LENGTH);
+                u32 ticks = 0;
+                u32 result = 0;
+
+                if (op == BULK_OP_CHECKSUM || op == BULK_OP_PCAP) {
+                    ticks = sum_ticks;
+                    result = (op == BULK_OP_CHECKSUM) ? sum : 0;
+                } else if (status[i] == RPU_CMD_STATUS_OK) {
+                    RpuDmaqJob_t *job = &xBulkJob[job_of[i]];
+                    u8 *buf = &ucBulkBuf[Xil_In32(desc + BULK_DESC_BUF_OFFSET)];
+
+                    ticks = job->ticks;
+                    if (op & BULK_OP_F_CRC) {
+                        result = rpu_crc32c(buf, len);
+                    }
+                    if (job->status != RPU_DMAQ_OK) {
+                        status[i] = RPU_CMD_STATUS_FAILED;
+                    } else if (op == (BULK_OP_WRITE | BULK_OP_F_CRC) &&
+                               result != Xil_In32(desc + BULK_DESC_RESULT)) {
+                        status[i] = RPU_CMD_STATUS_CRC;
+                    } else if ((op & BULK_OP_MASK) == BULK_OP_WRITE && xBulkHook != NULL) {
+                        // A consumer sees the payload before the next descriptor overwrites it
+                        xBulkHook(BULK_OP_WRITE, buf, len);
+                    }
+                }
+                Xil_Out32(desc + BULK_DESC_DMA_TICKS, ticks);
+                // A checked WRITE keeps the APU's CRC
+                if (op != (BULK_OP_WRITE | BULK_OP_F_CRC)) {
+                    Xil_Out32(desc + BULK_DESC_RESULT, result);
+                }
+                Xil_Out32(desc + BULK_DESC_STATUS, status[i]);
+                vRpuTrace(RPU_TRACE_BULK, (op & BULK_OP_MASK) | (status[i] << 8), len);
+
+                // Status before the tail that completes the descriptor
+                __sync_synchronize();
+                Xil_Out32(RPU_BULK_CTRL_BASE + BULK_TAIL_OFFSET, tail + 1);
+                drained++;
+            }
+        }
+
+        // Reverse IPI so an interrupt-driven APU waiter wakes without polling
+        if (drained != 0 &&
+            (Xil_In32(RPU_SHM_BASE + SHM_APU_FLAGS_OFFSET) & SHM_APU_FLAG_ACK_IRQ)) {
+            __sync_synchronize();
+            Xil_Out32(IPI_CH_BASE + IPI_TRIG_OFFSET, BULK_APU_MASK);
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Hand pending descriptors to the bulk task (IPI task context) */
+void vRpuBulkKick(void)
+{
+    if (xBulkTask != NULL &&
+        Xil_In32(RPU_BULK_CTRL_BASE + BULK_HEAD_OFFSET) !=
+        Xil_In32(RPU_BULK_CTRL_BASE + BULK_TAIL_OFFSET)) {
+        (void)xTaskNotify(xBulkTask, BULK_NOTIFY_KICK, eSetBits);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Register the firmware consumer/producer of the buffer (NULL: loopback) */
+void vRpuBulkSetHook(RpuBulkHook_t hook)
+{
+    xBulkHook = hook;
+}
+
+/*-----------------------------------------------------------*/
+/* Set up the DMA queue, the bulk task and the control block; the channel
+ * is announced (BULK_MAGIC) only once all of it works */
+RPU_INIT_TEXT int xRpuBulkInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    XZDma_DataConfig data = { 0 };
+    int Status;
+
+    // Control block in OCM: non-cacheable like the shared window (rpu_shm.h)
+    Xil_SetTlbAttributes(RPU_BULK_CTRL_BASE, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(RPU_BULK_CTRL_BASE + BULK_MAGIC_OFFSET, 0);
+    // Discard descriptors queued before this firmware instance started
+    Xil_Out32(RPU_BULK_CTRL_BASE + BULK_TAIL_OFFSET,
+              Xil_In32(RPU_BULK_CTRL_BASE + BULK_HEAD_OFFSET));
+
+    // Plain memory to memory copy: long incrementing bursts on both sides
+    data.OverFetch = 0;
+    data.SrcIssue = BULK_DMA_ISSUE;
+    data.SrcBurstType = XZDMA_INCR_BURST;
+    data.SrcBurstLen = BULK_DMA_BURST_LEN;
+    data.DstBurstType = XZDMA_INCR_BURST;
+    data.DstBurstLen = BULK_DMA_BURST_LEN;
+    Status = xRpuDmaqInit(&xBulkQueue, BULK_DMA_BASEADDR, &data, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    xBulkTask = xTaskCreateStatic( prvBulkTask,
+                                   ( const char * ) "Bulk",
+                                   BULK_TASK_STACK_SIZE,
+                                   NULL,
+                                   task_priority,
+                                   RPU_TASK_STACK_BUF(xBulkStack),
+                                   &xBulkTaskBuffer );
+
+    Xil_Out32(RPU_BULK_CTRL_BASE + BULK_BUF_SIZE_OFFSET, RPU_BULK_BUF_SIZE);
+    __sync_synchronize();
+    Xil_Out32(RPU_BULK_CTRL_BASE + BULK_MAGIC_OFFSET, BULK_MAGIC);
+    return XST_SUCCESS;
+}
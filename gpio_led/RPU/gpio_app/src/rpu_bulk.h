@@ -0,0 +1,40 @@
+/*
+ * Bulk APU <-> RPU data channel.
+ *
+ * Moves payloads between the DDR carveout of this core (RPU_BULK_DDR_BASE)
+ * and a buffer in BTCM with an LPD DMA channel, so sensor and waveform
+ * buffers of KB to MB cross over without the R5 copying them. The APU
+ * queues descriptors in the bulk control block in OCM and rings the IPI
+ * doorbell (layout and protocol in rpu_shm.h); the IPI task hands the ring
+ * to the bulk task with vRpuBulkKick(), which hands the pending descriptors
+ * to the DMA queue (rpu_dmaq.h) and sleeps until they complete.
+ *
+ * Payloads larger than RPU_BULK_BUF_SIZE are split by the APU into one
+ * descriptor per buffer-full. Firmware that consumes or produces the data
+ * registers a hook: it runs in the bulk task after each BULK_OP_WRITE and
+ * before each BULK_OP_READ, with the part of the buffer the descriptor
+ * covers. Without a hook the buffer keeps the data until the next write,
+ * so a write followed by a read is a loopback.
+ *
+ * BULK_OP_CHECKSUM sums a carveout range with the CSU DMA (rpu_csum.h) and
+ * moves no data, so the APU can verify an image it placed in the carveout.
+ * BULK_OP_PCAP streams a carveout range into the PCAP the same way
+ * (xRpuPcapWrite(), RPU_PCAP=1), to load a partial bitstream.
+ */
+
+#ifndef RPU_BULK_H
+#define RPU_BULK_H
+
+#include "xil_types.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#define RPU_BULK_BUF_SIZE  0x4000  // 16 KB of BTCM
+
+typedef void (*RpuBulkHook_t)(u32 op, u8 *buf, u32 length);
+
+int xRpuBulkInit(UBaseType_t task_priority, u16 intr_priority);
+void vRpuBulkKick(void);      /* IPI task: descriptors may be pending */
+void vRpuBulkSetHook(RpuBulkHook_t hook);
+
+#endif /* RPU_BULK_H */
@@ -0,0 +1,67 @@
+/*
+ * Double-buffered blink configuration (see rpu_config.h).
+ *
+ * Both blocks start zeroed, BLINK_SLOW without override. The staged block
+ * is always the one the active index does not select; after a flip it is
+ * refilled from the new active one, so writers keep starting from the
+ * latest state.
+ */
+
+#include "xpseudo_asm.h"
+
+#include "rpu_config.h"
+#include "rpu_tcm.h"
+
+static RpuConfig_t xConfig[2] RPU_BTCM_BSS;
+static volatile u32 ulConfigActive RPU_BTCM_BSS;   /* Index of the active block */
+static volatile u32 ulConfigPending RPU_BTCM_BSS;  /* Staged block committed */
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT RpuConfig_t *pxRpuConfigBegin(u32 *key)
+{
+    *key = mfcpsr();
+    __asm volatile ("cpsid if" ::: "memory");
+    return &xConfig[ulConfigActive ^ 1];
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuConfigCommit(u32 key, int changed)
+{
+    if (changed) {
+        ulConfigPending = 1;
+    }
+    __asm volatile ("" ::: "memory");
+    mtcpsr(key);
+}
+
+/*-----------------------------------------------------------*/
+void vRpuConfigGet(RpuConfig_t *out)
+{
+    u32 key;
+
+    *out = *pxRpuConfigBegin(&key);
+    vRpuConfigCommit(key, 0);
+}
+
+/*-----------------------------------------------------------*/
+/* A commit after the pending check is taken by the next flip */
+RPU_ATCM_TEXT const RpuConfig_t *pxRpuConfigFlip(void)
+{
+    u32 key, next;
+
+    if (ulConfigPending) {
+        (void)pxRpuConfigBegin(&key);
+        next = ulConfigActive ^ 1;
+        ulConfigActive = next;
+        xConfig[next ^ 1] = xConfig[next];
+        ulConfigPending = 0;
+        vRpuConfigCommit(key, 0);
+    }
+    return &xConfig[ulConfigActive];
+}
+
+/*-----------------------------------------------------------*/
+const RpuConfig_t *pxRpuConfigActive(void)
+{
+    return &xConfig[ulConfigActive];
+}
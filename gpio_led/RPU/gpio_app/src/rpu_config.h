@@ -0,0 +1,42 @@
+/*
+ * Double-buffered blink configuration.
+ *
+ * The fields the Tx task builds its frames from are one block, kept twice:
+ * the active block, which the Tx task runs, and the staged block, which
+ * holds the latest requested state. Writers (the IPI task, the FIQ handler,
+ * the mode timer, the Tx task itself when a pattern ends) change the staged
+ * block between pxRpuConfigBegin() and vRpuConfigCommit(); the Tx task calls
+ * pxRpuConfigFlip() once per frame, which makes a committed staged block the
+ * active one with a single index store, so a frame never sees a change half
+ * applied and the Tx task reads the active block without any lock.
+ *
+ * Writers hold IRQ and FIQ masked (CPSR), which works the same from a task,
+ * an interrupt handler or the FIQ handler and excludes the flip; it is only
+ * held for a few stores. Other readers copy the staged block with
+ * vRpuConfigGet(), or read one field of the active one.
+ */
+
+#ifndef RPU_CONFIG_H
+#define RPU_CONFIG_H
+
+#include "xil_types.h"
+
+typedef struct {
+    u32 mode;       /* BlinkMode_t of main.c */
+    u32 override;   /* APU override: the mode timer does not rotate */
+} RpuConfig_t;
+
+/* Mask IRQ and FIQ and return the staged block; *key for vRpuConfigCommit() */
+RpuConfig_t *pxRpuConfigBegin(u32 *key);
+/* Publish the staged block for the next flip and restore the interrupt mask;
+ * changed = 0 for a writer that only read it */
+void vRpuConfigCommit(u32 key, int changed);
+/* Copy of the staged block, the latest requested state */
+void vRpuConfigGet(RpuConfig_t *out);
+/* Tx task, at a frame boundary: switch to a committed staged block and
+ * return the active one, unchanged until the next flip */
+const RpuConfig_t *pxRpuConfigFlip(void);
+/* The active block, for single fields outside the Tx task */
+const RpuConfig_t *pxRpuConfigActive(void);
+
+#endif /* RPU_CONFIG_H */
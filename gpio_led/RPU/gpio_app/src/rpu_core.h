@@ -0,0 +1,130 @@
+/*
+ * Per-core resources of the gpio_app firmware.
+ *
+ * The same sources build the RPU0 firmware and, with the R5s in split mode,
+ * a second worker for RPU1: set RPU_CORE=1 in UserConfig.cmake, which also
+ * links it at the RPU1 DDR image, and build on a freertos_psu_cortexr5_1
+ * domain. Each core owns its IPI channel, shared memory window (rpu_shm.h),
+ * timers and DMA channel so the two firmwares never touch each other's state:
+ *
+ *                  RPU0                    RPU1
+ *   IPI channel    IPI1 0xFF310000, ID 65  IPI2 0xFF320000, ID 66
+ *   Shared window  0xFF990000 (IPI RAM)    0xFFFC0000 (OCM bank 0)
+ *   Tick (BSP)     TTC0 counter 0          TTC2 counter 0
+ *   Waveform       TTC1 counter 0          TTC3 counter 0
+ *   Run-time stats TTC1 counter 1          TTC3 counter 1
+ *   Timer wheel    TTC1 counter 2          TTC3 counter 2
+ *   PC sampling    TTC0 counter 1          TTC2 counter 1
+ *   TTC LED wave   TTC0 counter 1 (2)      -
+ *   Sensor trigger TTC0 counter 2          -
+ *   Sleep one-shot TTC0 counter 2 (1)      TTC2 counter 2
+ *   Waveform DMA   LPD DMA channel 1       LPD DMA channel 2
+ *   Bulk DMA       LPD DMA channel 3       LPD DMA channel 4
+ *   Copy DMA       LPD DMA channels 5, 6   LPD DMA channels 7, 8
+ *   Bulk control   0xFFFC1000 (OCM)        0xFFFC2000 (OCM)
+ *   Bulk carveout  0x3F100000 (2 MB)       0x3F300000 (2 MB)
+ *   RPMsg vrings   0x3F500000 (1 MB)       0x3F600000 (1 MB)
+ *   IRQ profile    0xFFFC3000 (OCM)        0xFFFC4000 (OCM)
+ *   PC profile     0xFFFC8000 (OCM)        0xFFFCC000 (OCM)
+ *   Sensor samples 0xFFFD0000 (OCM)        -
+ *   Inter-R5 inbox 0xFFFDC000 (OCM)        0xFFFDD000 (OCM)
+ *   PL interrupts  0xFFFDE000 (OCM)        -
+ *   TCM (global)   0xFFE00000              0xFFE90000
+ *   DDR image      0x3ED00000 (2 MB)       0x3EF00000 (2 MB)
+ *
+ * (1) Shared with the sensor trigger: with RPU_SENSOR=1 the scheduler-aware
+ * sleeps (rpu_sleep.h) leave it alone.
+ * (2) The PC sampling counter: RPU_TTC_WAVE=1 and RPU_PC_PROF=1 exclude each
+ * other, as the waveform output pin of TTC0 is the one the PL routes.
+ *
+ * With RPU_SHM_TCM=1 the shared window moves to the first 4 KB of the
+ * core's BTCM (0x20000, global 0xFFE20000 / 0xFFEB0000) and the window above
+ * only holds the redirect to it (rpu_shm.h, "TCM variant"): the command path
+ * reads the ring and the command words in one cycle instead of crossing the
+ * interconnect. That BTCM is then not available to the rest of the image.
+ *
+ * The FreeRTOS tick timer is a BSP setting (configTIMER_BASEADDR), so the
+ * RPU1 domain has to select TTC2 itself. Both cores drive the same AXI GPIO;
+ * the legacy DDR command word at 0x40000000 belongs to RPU0 only.
+ */
+
+#ifndef RPU_CORE_H
+#define RPU_CORE_H
+
+#include "xparameters.h"
+#include "rpu_shm.h"
+
+#ifndef RPU_CORE
+#define RPU_CORE 0
+#endif
+
+#ifndef RPU_SHM_TCM
+#define RPU_SHM_TCM 0
+#endif
+
+#if RPU_CORE == 0
+#define RPU_CORE_NAME           "RPU0"
+#define IPI_CH_BASE             0xFF310000  // IPI channel 1
+#define IPI_INT_ID              65          // GIC_SPI 33 -> ID 65
+#define RPU_CORE_TICK_TTC       XPAR_XTTCPS_0_BASEADDR   // TTC0 counter 0 (BSP setting)
+#define RPU_CORE_WAVE_TTC       XPAR_XTTCPS_3_BASEADDR   // TTC1 counter 0
+#define RPU_CORE_STATS_TTC      XPAR_XTTCPS_4_BASEADDR   // TTC1 counter 1
+#define RPU_CORE_TIMER_TTC      XPAR_XTTCPS_5_BASEADDR   // TTC1 counter 2
+#define RPU_CORE_PCPROF_TTC     XPAR_XTTCPS_1_BASEADDR   // TTC0 counter 1
+#define RPU_CORE_TTCWAVE_TTC    XPAR_XTTCPS_1_BASEADDR   // TTC0 counter 1, without RPU_PC_PROF (rpu_ttcwave.h)
+#define RPU_CORE_SENSOR_TTC     XPAR_XTTCPS_2_BASEADDR   // TTC0 counter 2 (RPU0 only, rpu_sensor.h)
+#define RPU_CORE_SLEEP_TTC      XPAR_XTTCPS_2_BASEADDR   // TTC0 counter 2, unless RPU_SENSOR (rpu_sleep.h)
+#define RPU_CORE_WAVE_DMA       XPAR_XZDMA_8_BASEADDR    // LPD DMA channel 1
+#define RPU_CORE_BULK_DMA       XPAR_XZDMA_10_BASEADDR   // LPD DMA channel 3
+#define RPU_CORE_COPY_DMA       { XPAR_XZDMA_12_BASEADDR, XPAR_XZDMA_13_BASEADDR }  // LPD DMA channels 5, 6
+#define RPU_CORE_TCM_GLOBAL     0xFFE00000  // ATCM0, BTCM0 at +0x20000
+#elif RPU_CORE == 1
+#define RPU_CORE_NAME           "RPU1"
+#define IPI_CH_BASE             0xFF320000  // IPI channel 2
+#define IPI_INT_ID              66          // GIC_SPI 34 -> ID 66
+#define RPU_CORE_TICK_TTC       XPAR_XTTCPS_6_BASEADDR   // TTC2 counter 0 (BSP setting)
+#define RPU_CORE_WAVE_TTC       XPAR_XTTCPS_9_BASEADDR   // TTC3 counter 0
+#define RPU_CORE_STATS_TTC      XPAR_XTTCPS_10_BASEADDR  // TTC3 counter 1
+#define RPU_CORE_TIMER_TTC      XPAR_XTTCPS_11_BASEADDR  // TTC3 counter 2
+#define RPU_CORE_PCPROF_TTC     XPAR_XTTCPS_7_BASEADDR   // TTC2 counter 1
+#define RPU_CORE_SLEEP_TTC      XPAR_XTTCPS_8_BASEADDR   // TTC2 counter 2 (rpu_sleep.h)
+#define RPU_CORE_WAVE_DMA       XPAR_XZDMA_9_BASEADDR    // LPD DMA channel 2
+#define RPU_CORE_BULK_DMA       XPAR_XZDMA_11_BASEADDR   // LPD DMA channel 4
+#define RPU_CORE_COPY_DMA       { XPAR_XZDMA_14_BASEADDR, XPAR_XZDMA_15_BASEADDR }  // LPD DMA channels 7, 8
+#define RPU_CORE_TCM_GLOBAL     0xFFE90000  // ATCM1, BTCM1 at +0x20000
+#else
+#error "RPU_CORE must be 0 or 1"
+#endif
+
+// Shared window and APU message buffers of this core; the default window
+// is where the APU looks first
+#define RPU_SHM_DEFAULT_BASE    SHARED_MEM_ADDR_CORE(RPU_CORE)
+#if RPU_SHM_TCM
+#define RPU_SHM_BASE            0x00020000  // BTCM, .btcm_shm (lscript.ld)
+#else
+#define RPU_SHM_BASE            RPU_SHM_DEFAULT_BASE
+#endif /* RPU_SHM_TCM */
+#define RPU_IPI_REQ_ADDR        SHM_IPI_REQ_ADDR(RPU_CORE)
+#define RPU_IPI_RESP_ADDR       SHM_IPI_RESP_ADDR(RPU_CORE)
+
+// Bulk channel of this core
+#define RPU_BULK_CTRL_BASE      BULK_CTRL_ADDR(RPU_CORE)
+#define RPU_BULK_DDR_BASE       BULK_DDR_ADDR_CORE(RPU_CORE)
+
+// IRQ profile block of this core
+#define RPU_IRQPROF_BASE        IRQPROF_ADDR(RPU_CORE)
+
+// PC profile block of this core
+#define RPU_PCPROF_BASE         PCPROF_ADDR(RPU_CORE)
+
+// Memory watermark block of this core
+#define RPU_MEM_BASE            MEM_ADDR(RPU_CORE)
+
+// Hot-swap state block of this core
+#define RPU_HANDOFF_BASE        HANDOFF_ADDR(RPU_CORE)
+
+// Address of a TCM object for other bus masters (DMA): the R5 sees its TCMs
+// at 0x0 (ATCM) and 0x20000 (BTCM), the rest of the system in the global map
+#define RPU_TCM_GLOBAL(local)   (RPU_CORE_TCM_GLOBAL + (UINTPTR)(local))
+
+#endif /* RPU_CORE_H */
@@ -0,0 +1,69 @@
+/*
+ * Ring credits (see rpu_credit.h, rpu_shm.h).
+ *
+ * The average is an EWMA with weight 1/2^CREDIT_EWMA_SHIFT per batch, in
+ * ticks scaled by 2^CREDIT_FRAC_BITS so that sub-tick averages of fast
+ * commands keep their precision. Both words are written after the tail, so
+ * a producer never sees credits for slots not freed yet.
+ */
+
+#include <xil_io.h>
+
+#include "rpu_core.h"
+#include "rpu_credit.h"
+#include "rpu_shm.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+
+#define CREDIT_EWMA_SHIFT      3
+#define CREDIT_FRAC_BITS       4
+
+/* Ticks per descriptor << CREDIT_FRAC_BITS, 0 until the first batch */
+static u32 ulCreditTicks RPU_BTCM_BSS;
+static u32 ulCreditWindow RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT void vRpuCreditInit(void)
+{
+    ulCreditTicks = 0;
+    ulCreditWindow = SHM_RING_SLOTS;
+    Xil_Out32(RPU_SHM_BASE + SHM_RING_RATE_OFFSET, 0);
+    Xil_Out32(RPU_SHM_BASE + SHM_RING_CREDIT_OFFSET,
+              Xil_In32(RPU_SHM_BASE + SHM_RING_TAIL_OFFSET) + SHM_RING_SLOTS);
+}
+
+/*-----------------------------------------------------------*/
+/* New average and window from a batch */
+static void prvCreditSample(u32 count, u64 ticks)
+{
+    u64 sample = (ticks << CREDIT_FRAC_BITS) / count;
+    u64 hz = (u64)ulRpuTimeHz() << CREDIT_FRAC_BITS;
+    u64 fit;
+
+    if (sample == 0) {
+        sample = 1;
+    } else if (sample > 0xFFFFFFFFULL) {
+        sample = 0xFFFFFFFFULL;
+    }
+    if (ulCreditTicks == 0) {
+        ulCreditTicks = (u32)sample;
+    } else {
+        ulCreditTicks = (u32)((((u64)ulCreditTicks << CREDIT_EWMA_SHIFT) -
+                               ulCreditTicks + sample) >> CREDIT_EWMA_SHIFT);
+    }
+
+    // Descriptors served within the budget at the average cost
+    fit = hz * RPU_CREDIT_BUDGET_US / 1000000U / ulCreditTicks;
+    ulCreditWindow = fit < SHM_CREDIT_MIN_SLOTS ? SHM_CREDIT_MIN_SLOTS :
+                     fit > SHM_RING_SLOTS ? SHM_RING_SLOTS : (u32)fit;
+    Xil_Out32(RPU_SHM_BASE + SHM_RING_RATE_OFFSET, (u32)(hz / ulCreditTicks));
+}
+
+/*-----------------------------------------------------------*/
+void vRpuCreditUpdate(u32 tail, u32 count, u64 ticks)
+{
+    if (count != 0) {
+        prvCreditSample(count, ticks);
+    }
+    Xil_Out32(RPU_SHM_BASE + SHM_RING_CREDIT_OFFSET, tail + ulCreditWindow);
+}
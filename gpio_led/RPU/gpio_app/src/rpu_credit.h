@@ -0,0 +1,30 @@
+/*
+ * Ring credits (rpu_shm.h, "Ring credits").
+ *
+ * After each batch drained from the command ring the IPI task hands the
+ * ring tail, the number of descriptors and the counter ticks they took to
+ * vRpuCreditUpdate(). It keeps an average of the ticks per descriptor and
+ * publishes the service rate and a credit limit of tail plus as many slots
+ * as that rate serves in RPU_CREDIT_BUDGET_US, between SHM_CREDIT_MIN_SLOTS
+ * and the whole ring: slow commands (waveform uploads, a blocked LED bank)
+ * shrink the window, and producers hold back instead of timing out on a
+ * full ring.
+ */
+
+#ifndef RPU_CREDIT_H
+#define RPU_CREDIT_H
+
+#include "xil_types.h"
+
+/* Queueing delay the credit window aims for */
+#ifndef RPU_CREDIT_BUDGET_US
+#define RPU_CREDIT_BUDGET_US   1000
+#endif
+
+/* Full window, rate unknown; after the ring tail is reset at boot */
+void vRpuCreditInit(void);
+/* IPI task: count descriptors up to tail took ticks; count 0 releases
+ * slots without a sample (a discarded head) */
+void vRpuCreditUpdate(u32 tail, u32 count, u64 ticks);
+
+#endif /* RPU_CREDIT_H */
@@ -0,0 +1,221 @@
+/*
+ * CSU DMA checksums (see rpu_csum.h).
+ *
+ * The channels are programmed through their registers: XCsuDma_Transfer()
+ * cleans the range from the data cache first, with interrupts masked, which
+ * for a multi-MB image would hold off every interrupt for milliseconds. The
+ * ranges summed here are not touched by the R5 (the bulk carveout), so
+ * there is nothing to clean.
+ *
+ * A PCAP load runs the source channel only, and ends on its DONE interrupt,
+ * which is enabled for the load only; the PCAP has taken the last word once
+ * it reports write idle, shortly after.
+ */
+
+#include <xil_io.h>
+#include "xcsudma.h"
+#include "xinterrupt_wrap.h"
+#include "xstatus.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "rpu_csum.h"
+#include "rpu_tcm.h"
+
+#define CSUM_DMA_BASEADDR      XPAR_XCSUDMA_0_BASEADDR
+// Secure stream switch: the DMA destination channel takes the DMA stream
+#define CSU_SSS_CFG            0xFFCA0008U
+#define CSU_SSS_DMA_MASK       0x000000F0U
+#define CSU_SSS_DMA_FROM_DMA   0x00000050U
+#define CSU_SSS_PCAP_MASK      0x0000000FU
+#define CSU_SSS_PCAP_FROM_DMA  0x00000005U
+// PCAP interface of the CSU
+#define CSU_PCAP_RDWR          0xFFCA3004U   // 0: write to the PL
+#define CSU_PCAP_CTRL          0xFFCA3008U
+#define CSU_PCAP_CTRL_PR       0x00000001U   // PCAP drives partial reconfiguration
+#define CSU_PCAP_RESET         0xFFCA300CU
+#define CSU_PCAP_RESET_MASK    0x00000001U
+#define CSU_PCAP_STATUS        0xFFCA3010U
+#define CSU_PCAP_STATUS_WR_IDLE 0x00000001U
+#define PCAP_IDLE_POLLS        10000
+#define CSUM_SRC_ERRORS        (XCSUDMA_IXR_INVALID_APB_MASK | XCSUDMA_IXR_TIMEOUT_MEM_MASK | \
+                                XCSUDMA_IXR_TIMEOUT_STRM_MASK | XCSUDMA_IXR_AXI_WRERR_MASK)
+// Bit 0 is MEM_DONE on the source channel, FIFO_OVERFLOW on the destination
+#define CSUM_DST_ERRORS        (CSUM_SRC_ERRORS | XCSUDMA_IXR_FIFO_OVERFLOW_MASK)
+#define CSUM_MAX_LEN           0x1FFFFFFCU  // SIZE register, bits [28:2]
+// Multi-MB ranges take milliseconds; this long is a stuck channel
+#define CSUM_TIMEOUT_MS        100
+
+static XCsuDma xCsuDma;
+static SemaphoreHandle_t xCsumDone;
+static SemaphoreHandle_t xCsumLock;
+static volatile u32 ulCsumError;        /* Error interrupts of the last range */
+static volatile BaseType_t xCsuPcapRun; /* A PCAP load: the source channel ends the run */
+
+static StaticSemaphore_t xCsumDoneBuffer RPU_BTCM_NOINIT;
+static StaticSemaphore_t xCsumLockBuffer RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* Destination done or an error on either channel (interrupt context) */
+static void prvCsumIntr(void *CallBackRef)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    u32 src = XCsuDma_IntrGetStatus(&xCsuDma, XCSUDMA_SRC_CHANNEL);
+    u32 dst = XCsuDma_IntrGetStatus(&xCsuDma, XCSUDMA_DST_CHANNEL);
+    u32 done = xCsuPcapRun ? src : dst;
+
+    (void)CallBackRef;
+    XCsuDma_IntrClear(&xCsuDma, XCSUDMA_SRC_CHANNEL, src);
+    XCsuDma_IntrClear(&xCsuDma, XCSUDMA_DST_CHANNEL, dst);
+    src &= CSUM_SRC_ERRORS;
+    if ((src | (dst & CSUM_DST_ERRORS)) != 0 || (done & XCSUDMA_IXR_DONE_MASK) != 0) {
+        ulCsumError = src | (dst & CSUM_DST_ERRORS);
+        xSemaphoreGiveFromISR(xCsumDone, &xHigherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+/* Start one channel over len bytes at addr; writing the size starts it */
+static void prvCsumStart(XCsuDma_Channel Channel, UINTPTR addr, u32 len)
+{
+    u32 off = (u32)Channel * XCSUDMA_OFFSET_DIFF;
+
+    XCsuDma_WriteReg(CSUM_DMA_BASEADDR, XCSUDMA_ADDR_OFFSET + off, (u32)addr & XCSUDMA_ADDR_MASK);
+    XCsuDma_WriteReg(CSUM_DMA_BASEADDR, XCSUDMA_ADDR_MSB_OFFSET + off, 0);
+    XCsuDma_WriteReg(CSUM_DMA_BASEADDR, XCSUDMA_SIZE_OFFSET + off, len);
+}
+
+/*-----------------------------------------------------------*/
+int xRpuCsumRange(UINTPTR addr, u32 len, u32 *sum)
+{
+    u32 sss;
+    int Status = XST_SUCCESS;
+
+    *sum = 0;
+    if (xCsumLock == NULL) {
+        return XST_FAILURE;
+    }
+    if (len == 0 || (len & 3) != 0 || (addr & 3) != 0 || len > CSUM_MAX_LEN) {
+        return XST_INVALID_PARAM;
+    }
+    (void)xSemaphoreTake(xCsumLock, portMAX_DELAY);
+
+    // A completion left over from a timed out range must not end this one
+    (void)xSemaphoreTake(xCsumDone, 0);
+    ulCsumError = 0;
+
+    sss = Xil_In32(CSU_SSS_CFG);
+    Xil_Out32(CSU_SSS_CFG, (sss & ~CSU_SSS_DMA_MASK) | CSU_SSS_DMA_FROM_DMA);
+    XCsuDma_ClearCheckSum(&xCsuDma);
+
+    // The destination first, so the stream has somewhere to go
+    prvCsumStart(XCSUDMA_DST_CHANNEL, addr, len);
+    prvCsumStart(XCSUDMA_SRC_CHANNEL, addr, len);
+
+    if (xSemaphoreTake(xCsumDone, pdMS_TO_TICKS(CSUM_TIMEOUT_MS)) != pdTRUE ||
+        ulCsumError != 0) {
+        Status = XST_FAILURE;
+    } else {
+        *sum = XCsuDma_GetCheckSum(&xCsuDma);
+    }
+
+    Xil_Out32(CSU_SSS_CFG, sss);
+    (void)xSemaphoreGive(xCsumLock);
+    return Status;
+}
+
+#if RPU_PCAP
+/*-----------------------------------------------------------*/
+int xRpuPcapWrite(UINTPTR addr, u32 len, BaseType_t swap)
+{
+    u32 off = (u32)XCSUDMA_SRC_CHANNEL * XCSUDMA_OFFSET_DIFF;
+    u32 sss, ctrl;
+    u32 polls = 0;
+    int Status = XST_SUCCESS;
+
+    if (xCsumLock == NULL) {
+        return XST_FAILURE;
+    }
+    if (len == 0 || (len & 3) != 0 || (addr & 3) != 0 || len > CSUM_MAX_LEN) {
+        return XST_INVALID_PARAM;
+    }
+    (void)xSemaphoreTake(xCsumLock, portMAX_DELAY);
+
+    (void)xSemaphoreTake(xCsumDone, 0);
+    ulCsumError = 0;
+    xCsuPcapRun = pdTRUE;
+
+    // Out of reset, partial reconfiguration, write direction
+    Xil_Out32(CSU_PCAP_RESET, Xil_In32(CSU_PCAP_RESET) & ~CSU_PCAP_RESET_MASK);
+    Xil_Out32(CSU_PCAP_CTRL, CSU_PCAP_CTRL_PR);
+    Xil_Out32(CSU_PCAP_RDWR, 0);
+
+    sss = Xil_In32(CSU_SSS_CFG);
+    Xil_Out32(CSU_SSS_CFG, (sss & ~CSU_SSS_PCAP_MASK) | CSU_SSS_PCAP_FROM_DMA);
+    ctrl = XCsuDma_ReadReg(CSUM_DMA_BASEADDR, XCSUDMA_CTRL_OFFSET + off);
+    XCsuDma_WriteReg(CSUM_DMA_BASEADDR, XCSUDMA_CTRL_OFFSET + off,
+                     swap ? (ctrl | XCSUDMA_CTRL_ENDIAN_MASK) : (ctrl & ~XCSUDMA_CTRL_ENDIAN_MASK));
+
+    XCsuDma_IntrClear(&xCsuDma, XCSUDMA_SRC_CHANNEL, XCSUDMA_IXR_DONE_MASK);
+    XCsuDma_EnableIntr(&xCsuDma, XCSUDMA_SRC_CHANNEL, XCSUDMA_IXR_DONE_MASK);
+    prvCsumStart(XCSUDMA_SRC_CHANNEL, addr, len);
+
+    if (xSemaphoreTake(xCsumDone, pdMS_TO_TICKS(CSUM_TIMEOUT_MS)) != pdTRUE ||
+        ulCsumError != 0) {
+        Status = XST_FAILURE;
+    } else {
+        while ((Xil_In32(CSU_PCAP_STATUS) & CSU_PCAP_STATUS_WR_IDLE) == 0) {
+            if (++polls == PCAP_IDLE_POLLS) {
+                Status = XST_FAILURE;
+                break;
+            }
+        }
+    }
+
+    XCsuDma_DisableIntr(&xCsuDma, XCSUDMA_SRC_CHANNEL, XCSUDMA_IXR_DONE_MASK);
+    XCsuDma_WriteReg(CSUM_DMA_BASEADDR, XCSUDMA_CTRL_OFFSET + off, ctrl);
+    Xil_Out32(CSU_SSS_CFG, sss);
+    xCsuPcapRun = pdFALSE;
+    (void)xSemaphoreGive(xCsumLock);
+    return Status;
+}
+#endif /* RPU_PCAP */
+
+/*-----------------------------------------------------------*/
+/* Set up the CSU DMA and connect its interrupt */
+RPU_INIT_TEXT int xRpuCsumInit(u16 intr_priority)
+{
+    XCsuDma_Config *cfg;
+    int Status;
+
+    cfg = XCsuDma_LookupConfig(CSUM_DMA_BASEADDR);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    Status = XCsuDma_CfgInitialize(&xCsuDma, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    xCsumDone = xSemaphoreCreateBinaryStatic(&xCsumDoneBuffer);
+    configASSERT( xCsumDone );
+
+    Status = XSetupInterruptSystem(&xCsuDma, (Xil_ExceptionHandler)prvCsumIntr,
+                                   cfg->IntrId, cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XCsuDma_IntrClear(&xCsuDma, XCSUDMA_SRC_CHANNEL, XCSUDMA_IXR_SRC_MASK);
+    XCsuDma_IntrClear(&xCsuDma, XCSUDMA_DST_CHANNEL, XCSUDMA_IXR_DST_MASK);
+    XCsuDma_EnableIntr(&xCsuDma, XCSUDMA_SRC_CHANNEL, CSUM_SRC_ERRORS);
+    XCsuDma_EnableIntr(&xCsuDma, XCSUDMA_DST_CHANNEL, CSUM_DST_ERRORS | XCSUDMA_IXR_DONE_MASK);
+    XEnableIntrId(cfg->IntrId, cfg->IntrParent);
+
+    // Only announced (xCsumLock) once the interrupt works
+    xCsumLock = xSemaphoreCreateMutexStatic(&xCsumLockBuffer);
+    configASSERT( xCsumLock );
+    return XST_SUCCESS;
+}
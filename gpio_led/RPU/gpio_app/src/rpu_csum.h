@@ -0,0 +1,63 @@
+/*
+ * Checksums of memory ranges, and PCAP loads, by the CSU DMA.
+ *
+ * The CSU DMA source channel adds up every 32-bit word it reads
+ * (CSUDMA_SRC_CRC). xRpuCsumRange() routes the secure stream switch from
+ * the DMA back to the DMA and runs both channels over the range, the
+ * destination writing each word back where it was read, so a checksum takes
+ * no CPU loop: the calling task sleeps on the DONE interrupt meanwhile.
+ * Nothing may modify the range until it returns.
+ *
+ * The result is a plain sum of the little-endian 32-bit words, the one
+ * kr260hal::word_sum() computes on the APU; it catches corruption, not
+ * tampering. The stream switch is shared with the CSU crypto engines, which
+ * the APU reaches through the PMU firmware: its route is restored after each
+ * range, and such requests must not run at the same time.
+ *
+ * xRpuPcapWrite() (build option RPU_PCAP=1, UserConfig.cmake; RPU0 firmware
+ * only) routes the stream switch from the DMA to the PCAP instead and runs
+ * the source channel alone, which loads a partial bitstream, or the next
+ * piece of one, into the PL. The PCAP is put in partial reconfiguration
+ * write mode and never reset here, so a bitstream may come in pieces; the
+ * static logic keeps running and decoupling the reconfigured region is up
+ * to the PL design. Linux fpga_manager must not load at the same time: the
+ * PCAP has no owner arbitration.
+ */
+
+#ifndef RPU_CSUM_H
+#define RPU_CSUM_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_PCAP
+#define RPU_PCAP 0
+#endif
+
+#if RPU_PCAP && RPU_CORE != 0
+#error "RPU_PCAP is for the RPU0 firmware: there is one PCAP"
+#endif
+
+int xRpuCsumInit(u16 intr_priority);
+/* Sum len bytes (a multiple of 4) at addr, a DDR or OCM address (task
+ * context); returns an XST_* value */
+int xRpuCsumRange(UINTPTR addr, u32 len, u32 *sum);
+
+#if RPU_PCAP
+/* Stream len bytes (a multiple of 4) at addr, a DDR or OCM address, into the
+ * PCAP (task context); swap: the bytes of each word are swapped on the way,
+ * for data in .bit file order. Returns an XST_* value */
+int xRpuPcapWrite(UINTPTR addr, u32 len, BaseType_t swap);
+#else
+static inline int xRpuPcapWrite(UINTPTR addr, u32 len, BaseType_t swap)
+{
+    (void)addr;
+    (void)len;
+    (void)swap;
+    return XST_NO_FEATURE;
+}
+#endif /* RPU_PCAP */
+
+#endif /* RPU_CSUM_H */
@@ -0,0 +1,143 @@
+/*
+ * Log and trace transport over the DCC (see rpu_dcc.h).
+ *
+ * The BSP driver (xcoresightpsdcc.c) waits forever for the reader; these
+ * accessors are the same CP14 operations with a bounded wait, so a board
+ * without a reader only loses the frames.
+ */
+
+#include <xil_io.h>
+#include "xpseudo_asm.h"
+
+#include "rpu_core.h"
+#include "rpu_dcc.h"
+#include "rpu_time.h"
+#include "rpu_trace.h"
+
+#if RPU_LOG_DCC
+
+#if RPU_TRACE_COMPACT
+#error "RPU_LOG_DCC reads the fixed trace entries: build it with RPU_TRACE_COMPACT=0"
+#endif
+
+#define DCC_STATUS_TXFULL      (1U << 29)  // DBGDSCR.TXfull
+#define DCC_TRACE_WORDS        6
+#define DCC_MAX_WORDS          0xFF
+
+static u32 ulDccSeq;
+static u32 ulDccOffline;
+static u32 ulDccTraceNext;
+static u32 ulDccTraceLost;
+
+/*-----------------------------------------------------------*/
+static inline u32 prvDccStatus(void)
+{
+    u32 status;
+
+    __asm__ volatile("mrc p14, 0, %0, c0, c1, 0" : "=r"(status) : : "cc");
+    return status;
+}
+
+static inline void prvDccWrite(u32 word)
+{
+    __asm__ volatile("mcr p14, 0, %0, c0, c5, 0" : : "r"(word));
+    isb();
+}
+
+/*-----------------------------------------------------------*/
+/* One word, once the reader has taken the previous one */
+static int prvDccPut(u32 word)
+{
+    u64 start = ullRpuTimeNow();
+
+    while (prvDccStatus() & DCC_STATUS_TXFULL) {
+        if (ullRpuTimeToUs(ullRpuTimeNow() - start) >= RPU_DCC_WAIT_US) {
+            ulDccOffline = 1;
+            return XST_FAILURE;
+        }
+    }
+    prvDccWrite(word);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuDccSendFrame(u32 type, const u32 *words, u32 count)
+{
+    u32 seq = ulDccSeq++;
+    u32 i;
+
+    if (count > DCC_MAX_WORDS) {
+        return XST_FAILURE;
+    }
+    // Offline until the reader has taken the last word
+    if (ulDccOffline) {
+        if (prvDccStatus() & DCC_STATUS_TXFULL) {
+            return XST_FAILURE;
+        }
+        ulDccOffline = 0;
+    }
+
+    if (prvDccPut(((u32)RPU_DCC_MAGIC << 24) | (type << 16) | ((seq & 0xFF) << 8) | count) != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+    for (i = 0; i < count; i++) {
+        if (prvDccPut(words[i]) != XST_SUCCESS) {
+            return XST_FAILURE;
+        }
+    }
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Same walk as the telemetry task (rpu_telem.c): entries still being
+ * written wait for the next call, overwritten ones are skipped and counted */
+void vRpuDccForwardTrace(void)
+{
+    u32 head = Xil_In32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET);
+    u32 words[DCC_TRACE_WORDS];
+
+    // Restarted trace, or lapped: resume at the oldest entry still there
+    if ((s32)(head - ulDccTraceNext) < 0) {
+        ulDccTraceNext = head > SHM_TRACE_SLOTS ? head - SHM_TRACE_SLOTS : 0;
+    } else if (head - ulDccTraceNext > SHM_TRACE_SLOTS) {
+        ulDccTraceLost += head - SHM_TRACE_SLOTS - ulDccTraceNext;
+        ulDccTraceNext = head - SHM_TRACE_SLOTS;
+    }
+
+    while (ulDccTraceNext != head) {
+        UINTPTR entry = RPU_SHM_BASE + SHM_TRACE_ENTRY(ulDccTraceNext);
+
+        if (Xil_In32(entry + SHM_TRACE_SEQ) != ulDccTraceNext + 1) {
+            // Still being written: next call. Overwritten: skip ahead
+            head = Xil_In32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET);
+            if (head - ulDccTraceNext <= SHM_TRACE_SLOTS) {
+                return;
+            }
+            ulDccTraceLost += head - SHM_TRACE_SLOTS - ulDccTraceNext;
+            ulDccTraceNext = head - SHM_TRACE_SLOTS;
+            continue;
+        }
+        words[0] = ulDccTraceNext;
+        words[1] = Xil_In32(entry + SHM_TRACE_EVENT);
+        words[2] = Xil_In32(entry + SHM_TRACE_ARG0);
+        words[3] = Xil_In32(entry + SHM_TRACE_ARG1);
+        words[4] = Xil_In32(entry + SHM_TRACE_TS_LO);
+        words[5] = Xil_In32(entry + SHM_TRACE_TS_HI);
+        if (Xil_In32(entry + SHM_TRACE_SEQ) != ulDccTraceNext + 1) {
+            continue;   // Rewritten meanwhile: handled above on the next pass
+        }
+        (void)xRpuDccSendFrame(RPU_DCC_TRACE, words, DCC_TRACE_WORDS);
+        ulDccTraceNext++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuDccTakeTraceLost(void)
+{
+    u32 lost = ulDccTraceLost;
+
+    ulDccTraceLost = 0;
+    return lost;
+}
+
+#endif /* RPU_LOG_DCC */
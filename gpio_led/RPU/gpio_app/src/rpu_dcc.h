@@ -0,0 +1,58 @@
+/*
+ * Log and trace transport over the CoreSight debug communications channel
+ * (build option RPU_LOG_DCC=1, UserConfig.cmake).
+ *
+ * The R5's DCC transmit register (DBGDTRTX, the word the BSP's
+ * XCoresightPs_DccSendByte() writes one byte at a time) is read by a JTAG
+ * debugger or, through the memory-mapped debug registers, by the APU
+ * (apu_app/rpu_dcc). It moves a whole 32-bit word per access, so with this
+ * option the RPU_LOG task (rpu_log.h) sends its records there as binary
+ * frames instead of formatting them to the UART, and forwards the trace
+ * entries (rpu_trace.h) as they are written. RPU_LOG() call sites do not
+ * change; xil_printf() keeps going to the UART.
+ *
+ * Wire format: 32-bit words, each frame a header word and count payload
+ * words:
+ *   header  RPU_DCC_MAGIC << 24 | type << 16 | seq << 8 | count
+ * with seq counting frames (a gap is frames lost to a missing reader):
+ *   RPU_DCC_LOG      format string address, RPU_LOG_MAX_ARGS arguments
+ *                    (the host formats it with the firmware ELF)
+ *   RPU_DCC_TRACE    trace index, event, arg0, arg1, timestamp lo, hi
+ *   RPU_DCC_DROPPED  log records lost to a full ring, trace entries
+ *                    overwritten before they were forwarded
+ * Decode with RPU/tools/rpu_dcc.py.
+ *
+ * Only the log task writes the channel. A word the reader has not taken
+ * within RPU_DCC_WAIT_US takes the channel offline: later frames are dropped
+ * at once until the reader has drained it, and every frame starts with a
+ * header, so the decoder resynchronises on the next one.
+ */
+
+#ifndef RPU_DCC_H
+#define RPU_DCC_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#ifndef RPU_LOG_DCC
+#define RPU_LOG_DCC 0
+#endif
+
+#define RPU_DCC_WAIT_US        1000
+#define RPU_DCC_MAGIC          0xDC
+
+/* Frame types */
+#define RPU_DCC_LOG            1
+#define RPU_DCC_TRACE          2
+#define RPU_DCC_DROPPED        3
+
+#if RPU_LOG_DCC
+/* XST_SUCCESS once the frame is sent, XST_FAILURE if it was dropped */
+int xRpuDccSendFrame(u32 type, const u32 *words, u32 count);
+/* Forward the trace entries written since the last call */
+void vRpuDccForwardTrace(void);
+/* Trace entries overwritten before they were forwarded, since the last call */
+u32 ulRpuDccTakeTraceLost(void);
+#endif /* RPU_LOG_DCC */
+
+#endif /* RPU_DCC_H */
@@ -0,0 +1,216 @@
+/*
+ * Striped DMA copies (see rpu_dmacopy.h).
+ *
+ * Each channel is a DMA queue of its own with one job per copy; a mutex
+ * serializes the copies, so a stripe never waits behind another copy's.
+ * Stripes are whole cache lines but the last, so the channels never write
+ * the same line.
+ */
+
+#include <string.h>
+#include "xil_cache.h"
+#include "xstatus.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "rpu_core.h"
+#include "rpu_dmacopy.h"
+#include "rpu_dmaq.h"
+#include "rpu_tcm.h"
+
+#define DMACOPY_BURST_LEN      16       // Longest ADMA burst
+#define DMACOPY_ISSUE          16       // Outstanding source reads
+#define DMACOPY_MAX_STRIPE     0x3FFFFFC0  // 30-bit size field, whole lines
+#define DMACOPY_CACHE_SIZE     0x8000   // R5 data cache
+// Longest time without a completion: a stuck channel
+#define DMACOPY_TIMEOUT_MS     100
+
+static const UINTPTR ulCopyDmaBase[] = RPU_CORE_COPY_DMA;
+#define DMACOPY_CHANNELS       (sizeof(ulCopyDmaBase) / sizeof(ulCopyDmaBase[0]))
+
+// In DDR: the DMA reads the descriptor chains of the queues
+static RpuDmaq_t xCopyQueue[DMACOPY_CHANNELS];
+static SemaphoreHandle_t xCopyLock;
+static StaticSemaphore_t xCopyLockBuffer RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* Set up one DMA queue per copy channel of this core */
+RPU_INIT_TEXT int xRpuDmaCopyInit(u16 intr_priority)
+{
+    XZDma_DataConfig data = { 0 };
+    u32 i;
+    int Status;
+
+    // Plain memory to memory copy: long incrementing bursts on both sides
+    data.OverFetch = 0;
+    data.SrcIssue = DMACOPY_ISSUE;
+    data.SrcBurstType = XZDMA_INCR_BURST;
+    data.SrcBurstLen = DMACOPY_BURST_LEN;
+    data.DstBurstType = XZDMA_INCR_BURST;
+    data.DstBurstLen = DMACOPY_BURST_LEN;
+    for (i = 0; i < DMACOPY_CHANNELS; i++) {
+        Status = xRpuDmaqInit(&xCopyQueue[i], ulCopyDmaBase[i], &data, intr_priority);
+        if (Status != XST_SUCCESS) {
+            return Status;
+        }
+    }
+
+    xCopyLock = xSemaphoreCreateMutexStatic(&xCopyLockBuffer);
+    configASSERT( xCopyLock );
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Split len bytes at dst (and src) into one job per channel
+ * - Returns the number of stripes, 0 when one would not fit a job
+ */
+static u32 prvDmaCopyStripes(RpuDmaqJob_t *job, UINTPTR dst, UINTPTR src, u32 len,
+                             u32 *fill)
+{
+    u32 stripes = (len < RPU_DMACOPY_STRIPE_MIN) ? 1 : DMACOPY_CHANNELS;
+    u32 stripe = ((len / stripes) + XIL_CACHE_LINE_SIZE - 1) & ~(XIL_CACHE_LINE_SIZE - 1);
+    u32 i;
+
+    if (stripe > DMACOPY_MAX_STRIPE) {
+        return 0;
+    }
+    for (i = 0; i < stripes; i++) {
+        u32 off = i * stripe;
+
+        if (off >= len) {
+            return i;
+        }
+        memset(&job[i].xfer, 0, sizeof(job[i].xfer));
+        job[i].xfer.SrcAddr = src + off;
+        job[i].xfer.DstAddr = dst + off;
+        job[i].xfer.Size = (len - off < stripe) ? len - off : stripe;
+        job[i].fill = fill;
+        job[i].task = xTaskGetCurrentTaskHandle();
+        job[i].notify_bits = RPU_DMACOPY_NOTIFY;
+    }
+    return stripes;
+}
+
+/*-----------------------------------------------------------*/
+/* Run the stripes on their channels and sleep until all complete (lock held)
+ * - Returns the notification bits taken that were not RPU_DMACOPY_NOTIFY
+ */
+static u32 prvDmaCopyRun(RpuDmaqJob_t *job, u32 stripes, int *status)
+{
+    u32 notified = 0;
+    u32 i;
+
+    for (i = 0; i < stripes; i++) {
+        if (xRpuDmaqSubmit(&xCopyQueue[i], &job[i], 1) != XST_SUCCESS) {
+            job[i].status = RPU_DMAQ_FAILED;
+        }
+    }
+
+    *status = XST_SUCCESS;
+    i = 0;
+    while (i < stripes) {
+        u32 value;
+
+        if (job[i].status != RPU_DMAQ_PENDING) {
+            if (job[i].status != RPU_DMAQ_OK) {
+                *status = XST_FAILURE;
+            }
+            i++;
+            continue;
+        }
+        if (xTaskNotifyWait(0, RPU_DMACOPY_NOTIFY, &value,
+                            pdMS_TO_TICKS(DMACOPY_TIMEOUT_MS)) == pdTRUE) {
+            notified |= value;
+        } else {
+            vRpuDmaqAbort(&xCopyQueue[i]);
+        }
+    }
+    return notified & ~RPU_DMACOPY_NOTIFY;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuDmaCopy(UINTPTR dst, UINTPTR src, u32 len)
+{
+    RpuDmaqJob_t job[DMACOPY_CHANNELS];
+    u32 stripes;
+    u32 notified;
+    int Status;
+
+    if (len == 0) {
+        return XST_SUCCESS;
+    }
+    if (xCopyLock == NULL) {
+        return XST_FAILURE;
+    }
+    stripes = prvDmaCopyStripes(job, dst, src, len, NULL);
+    if (stripes == 0) {
+        return XST_INVALID_PARAM;
+    }
+    (void)xSemaphoreTake(xCopyLock, portMAX_DELAY);
+
+    // No dirty line may land on either buffer during the copy; the R5 does
+    // not fill lines speculatively, so dst stays out of the cache until read.
+    // Above the cache size one clean of the whole cache beats walking the range
+    if (len > DMACOPY_CACHE_SIZE) {
+        Xil_DCacheFlush();
+    } else {
+        Xil_DCacheFlushRange(src, len);
+        Xil_DCacheFlushRange(dst, len);
+    }
+
+    notified = prvDmaCopyRun(job, stripes, &Status);
+    (void)xSemaphoreGive(xCopyLock);
+
+    // The waits took the notification: hand back what was meant for the caller
+    if (notified != 0) {
+        (void)xTaskNotify(xTaskGetCurrentTaskHandle(), 0, eNoAction);
+    }
+    return Status;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuDmaFill(UINTPTR dst, const u32 pattern[RPU_DMAFILL_WORDS], u32 len)
+{
+    RpuDmaqJob_t job[DMACOPY_CHANNELS];
+    // The queues hold on to the pattern until the fill completes
+    u32 fill[RPU_DMAFILL_WORDS];
+    u32 stripes;
+    u32 notified;
+    u32 i;
+    int Status;
+
+    if (len == 0) {
+        return XST_SUCCESS;
+    }
+    if (xCopyLock == NULL) {
+        return XST_FAILURE;
+    }
+    if (((dst | len) & (RPU_DMAFILL_ALIGN - 1)) != 0) {
+        return XST_INVALID_PARAM;
+    }
+    for (i = 0; i < RPU_DMAFILL_WORDS; i++) {
+        fill[i] = pattern[i];
+    }
+    // Stripes are whole cache lines, so each starts on a pattern boundary
+    stripes = prvDmaCopyStripes(job, dst, 0, len, fill);
+    if (stripes == 0) {
+        return XST_INVALID_PARAM;
+    }
+    (void)xSemaphoreTake(xCopyLock, portMAX_DELAY);
+
+    if (len > DMACOPY_CACHE_SIZE) {
+        Xil_DCacheFlush();
+    } else {
+        Xil_DCacheFlushRange(dst, len);
+    }
+
+    notified = prvDmaCopyRun(job, stripes, &Status);
+    (void)xSemaphoreGive(xCopyLock);
+
+    if (notified != 0) {
+        (void)xTaskNotify(xTaskGetCurrentTaskHandle(), 0, eNoAction);
+    }
+    return Status;
+}
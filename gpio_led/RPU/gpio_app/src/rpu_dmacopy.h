@@ -0,0 +1,40 @@
+/*
+ * Large memory copies striped over several LPD DMA channels.
+ *
+ * One channel is limited by its outstanding transactions, far below what
+ * the interconnect takes, so xRpuDmaCopy() splits a copy into one stripe
+ * per channel of this core (RPU_CORE_COPY_DMA, rpu_core.h), runs them in
+ * parallel on DMA queues (rpu_dmaq.h) and sleeps until all of them
+ * complete. Copies below RPU_DMACOPY_STRIPE_MIN use one channel: the extra
+ * setup would cost more than it saves.
+ *
+ * Source and destination are DDR or OCM addresses (TCM objects through
+ * RPU_TCM_GLOBAL()) that no one touches during the copy; the cache
+ * maintenance is done here. The calling task is woken with its notification
+ * bit RPU_DMACOPY_NOTIFY, so it must not use that bit for anything else.
+ *
+ * xRpuDmaFill() covers a range with a 16-byte pattern the same way, on the
+ * same channels in their write-only mode (rpu_dmaq.h): nothing is read, so
+ * clearing a large shared buffer, a frame buffer or a trace region costs
+ * the DMA writes only and no CPU time.
+ */
+
+#ifndef RPU_DMACOPY_H
+#define RPU_DMACOPY_H
+
+#include "xil_types.h"
+#include "FreeRTOS.h"
+
+#define RPU_DMACOPY_STRIPE_MIN  0x10000     // 64 KB
+#define RPU_DMACOPY_NOTIFY      0x80000000  // Task notification bit of the caller
+#define RPU_DMAFILL_WORDS       4           // Pattern of a fill, 16 bytes
+#define RPU_DMAFILL_ALIGN       16          // Of the address and size of a fill
+
+int xRpuDmaCopyInit(u16 intr_priority);
+/* Copy len bytes from src to dst (task context); returns an XST_* value */
+int xRpuDmaCopy(UINTPTR dst, UINTPTR src, u32 len);
+/* Fill len bytes at dst with the pattern repeated (task context); dst and
+ * len are multiples of RPU_DMAFILL_ALIGN; returns an XST_* value */
+int xRpuDmaFill(UINTPTR dst, const u32 pattern[RPU_DMAFILL_WORDS], u32 len);
+
+#endif /* RPU_DMACOPY_H */
@@ -0,0 +1,264 @@
+/*
+ * ZDMA job queue (see rpu_dmaq.h).
+ *
+ * The waiting jobs and the pass in flight are shared with the DMA interrupt
+ * and change in critical sections only; the DMA completion level is one the
+ * FreeRTOS API may use (rpu_intr.h), so a critical section masks it.
+ * XZDma_IntrHandler() masks the channel interrupts before the done callback
+ * and clears the pending ones after it, so each pass enables them again
+ * before XZDma_Start(); a pass cannot end within those few instructions, as
+ * the channel first fetches its descriptors from DDR.
+ */
+
+#include "xinterrupt_wrap.h"
+#include "xstatus.h"
+
+#include "rpu_dmaq.h"
+#include "rpu_time.h"
+#include "rpu_trace.h"
+
+#define DMAQ_INTR  (XZDMA_IXR_DMA_DONE_MASK | XZDMA_IXR_ERR_MASK)
+
+/*-----------------------------------------------------------*/
+/* Complete the pass in flight: split its time over the jobs by size */
+static void prvDmaqFinish(RpuDmaq_t *q, u32 status)
+{
+    u64 ticks = ullRpuTimeNow() - q->run_start;
+    u64 total = 0;
+    u32 i;
+
+    for (i = 0; i < q->run_count; i++) {
+        total += q->run[i]->xfer.Size;
+    }
+    for (i = 0; i < q->run_count; i++) {
+        RpuDmaqJob_t *job = q->run[i];
+
+        job->ticks = (total != 0) ? (u32)((ticks * job->xfer.Size) / total) : 0;
+        job->status = status;
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Start a fill job alone in write-only simple mode (interrupt masked) */
+static void prvDmaqStartFill(RpuDmaq_t *q, RpuDmaqJob_t *job)
+{
+    q->run[0] = job;
+    q->xfer[0] = job->xfer;
+    q->run_count = 1;
+    if (q->dma.Mode != XZDMA_WRONLY_MODE &&
+        XZDma_SetMode(&q->dma, FALSE, XZDMA_WRONLY_MODE) != XST_SUCCESS) {
+        q->run_count = 0;
+        job->status = RPU_DMAQ_FAILED;
+        return;
+    }
+    XZDma_WOData(&q->dma, job->fill);
+    XZDma_EnableIntr(&q->dma, DMAQ_INTR);
+    q->run_start = ullRpuTimeNow();
+    (void)XZDma_Start(&q->dma, q->xfer, 1);
+}
+
+/*-----------------------------------------------------------*/
+/* Chain the waiting jobs into one pass and start it (interrupt masked)
+ * - A fill job is a pass of its own; a job that cannot start fails, and the
+ *   owner learns it from the status, polling or at its next timeout
+ */
+static void prvDmaqStartPass(RpuDmaq_t *q)
+{
+    u32 n = 0;
+
+    while (q->wait_tail != q->wait_head && n < RPU_DMAQ_DEPTH) {
+        RpuDmaqJob_t *job = q->wait[q->wait_tail % RPU_DMAQ_DEPTH];
+
+        if (job->fill != NULL) {
+            if (n == 0) {
+                q->wait_tail++;
+                prvDmaqStartFill(q, job);
+                return;
+            }
+            break;
+        }
+        q->wait_tail++;
+        q->run[n] = job;
+        q->xfer[n] = job->xfer;
+        q->xfer[n].Pause = FALSE;  // A pause would end the pass early
+        n++;
+    }
+    q->run_count = n;
+    if (n == 0) {
+        return;
+    }
+    // Back to linked-list mode after a fill; the descriptor list is kept
+    if (q->dma.IsSgDma != TRUE &&
+        XZDma_SetMode(&q->dma, TRUE, XZDMA_NORMAL_MODE) != XST_SUCCESS) {
+        prvDmaqFinish(q, RPU_DMAQ_FAILED);
+        q->run_count = 0;
+        return;
+    }
+    XZDma_EnableIntr(&q->dma, DMAQ_INTR);
+    q->run_start = ullRpuTimeNow();
+    (void)XZDma_Start(&q->dma, q->xfer, n);
+}
+
+/*-----------------------------------------------------------*/
+/* Notify the owners of the jobs of a completed pass (interrupt context) */
+static void prvDmaqNotifyFromISR(RpuDmaq_t *q, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    u32 i;
+
+    for (i = 0; i < q->run_count; i++) {
+        if (q->run[i]->task != NULL) {
+            xTaskNotifyFromISR(q->run[i]->task, q->run[i]->notify_bits, eSetBits,
+                               pxHigherPriorityTaskWoken);
+        }
+    }
+    q->run_count = 0;
+}
+
+/*-----------------------------------------------------------*/
+/* Stop the channel after an error or a stuck pass */
+static void prvDmaqHalt(RpuDmaq_t *q)
+{
+    XZDma_DisableIntr(&q->dma, XZDMA_IXR_ALL_INTR_MASK);
+    XZDma_DisableCh(&q->dma);
+    XZDma_IntrClear(&q->dma, XZDMA_IXR_ALL_INTR_MASK);
+    q->dma.ChannelState = XZDMA_IDLE;
+}
+
+/*-----------------------------------------------------------*/
+/* End of a pass (interrupt context): complete it, start the next one */
+static void prvDmaqDone(void *CallBackRef)
+{
+    RpuDmaq_t *q = CallBackRef;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    // An error in the same interrupt fails the pass; prvDmaqError() restarts
+    u32 errors = XZDma_IntrGetStatus(&q->dma) & XZDMA_IXR_ERR_MASK;
+
+    if (q->run_count == 0) {
+        return;
+    }
+    prvDmaqFinish(q, (errors != 0) ? RPU_DMAQ_FAILED : RPU_DMAQ_OK);
+    prvDmaqNotifyFromISR(q, &xHigherPriorityTaskWoken);
+    if (errors == 0) {
+        prvDmaqStartPass(q);
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+/* Channel error (interrupt context): fail the pass, go on with the next */
+static void prvDmaqError(void *CallBackRef, u32 ErrorMask)
+{
+    RpuDmaq_t *q = CallBackRef;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    (void)ErrorMask;
+    prvDmaqHalt(q);
+    if (q->run_count != 0) {
+        prvDmaqFinish(q, RPU_DMAQ_FAILED);
+        prvDmaqNotifyFromISR(q, &xHigherPriorityTaskWoken);
+    }
+    prvDmaqStartPass(q);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+int xRpuDmaqSubmit(RpuDmaq_t *q, RpuDmaqJob_t *jobs, u32 count)
+{
+    u32 i;
+
+    taskENTER_CRITICAL();
+    if (count > RPU_DMAQ_DEPTH - (q->wait_head - q->wait_tail)) {
+        taskEXIT_CRITICAL();
+        return XST_DEVICE_BUSY;
+    }
+    for (i = 0; i < count; i++) {
+        jobs[i].status = RPU_DMAQ_PENDING;
+        jobs[i].ticks = 0;
+        q->wait[q->wait_head % RPU_DMAQ_DEPTH] = &jobs[i];
+        q->wait_head++;
+    }
+    // An idle channel starts now, a busy one from its done interrupt
+    if (q->run_count == 0) {
+        prvDmaqStartPass(q);
+    }
+    taskEXIT_CRITICAL();
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+void vRpuDmaqAbort(RpuDmaq_t *q)
+{
+    TaskHandle_t task[RPU_DMAQ_DEPTH];
+    u32 bits[RPU_DMAQ_DEPTH];
+    u32 count;
+    u32 i;
+
+    taskENTER_CRITICAL();
+    count = q->run_count;
+    for (i = 0; i < count; i++) {
+        task[i] = q->run[i]->task;
+        bits[i] = q->run[i]->notify_bits;
+    }
+    if (count != 0) {
+        prvDmaqHalt(q);
+        prvDmaqFinish(q, RPU_DMAQ_FAILED);
+        q->run_count = 0;
+        prvDmaqStartPass(q);
+    }
+    taskEXIT_CRITICAL();
+
+    // Outside the critical section: a notification may switch tasks
+    for (i = 0; i < count; i++) {
+        if (task[i] != NULL) {
+            xTaskNotify(task[i], bits[i], eSetBits);
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+int xRpuDmaqInit(RpuDmaq_t *q, UINTPTR base, XZDma_DataConfig *data, u16 intr_priority)
+{
+    XZDma_Config *cfg;
+    XZDma_DscrConfig dscr = { 0 };
+    int Status;
+
+    q->wait_head = 0;
+    q->wait_tail = 0;
+    q->run_count = 0;
+
+    cfg = XZDma_LookupConfig(base);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    Status = XZDma_CfgInitialize(&q->dma, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    Status = XZDma_SetMode(&q->dma, TRUE, XZDMA_NORMAL_MODE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    if (XZDma_CreateBDList(&q->dma, XZDMA_LINKEDLIST, (UINTPTR)q->dscr,
+                           sizeof(q->dscr)) < RPU_DMAQ_DEPTH) {
+        return XST_FAILURE;
+    }
+    Status = XZDma_SetChDataConfig(&q->dma, data);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    Status = XZDma_SetChDscrConfig(&q->dma, &dscr);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    XZDma_SetCallBack(&q->dma, XZDMA_HANDLER_DONE, (void *)prvDmaqDone, q);
+    XZDma_SetCallBack(&q->dma, XZDMA_HANDLER_ERROR, (void *)prvDmaqError, q);
+
+    Status = XSetupInterruptSystem(&q->dma, (Xil_ExceptionHandler)XZDma_IntrHandler,
+                                   cfg->IntrId, cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId, cfg->IntrParent);
+    return XST_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/*
+ * ZDMA job queue: back-to-back transfers on one channel.
+ *
+ * XZDma_Start() runs one transfer, or one descriptor chain, and refuses the
+ * next while the channel is busy. The queue takes XZDma_Transfer jobs from
+ * tasks, chains the jobs waiting when the channel goes idle into one
+ * linked-list pass and starts the next pass from the done interrupt, so the
+ * channel stays busy for as long as jobs keep coming. A job completes with
+ * a task notification (eSetBits) to the task named in it.
+ *
+ * Jobs belong to the caller and must stay untouched until they complete.
+ * The channel reports the end of a pass only: its time is split over its
+ * jobs by size, so the ticks of the jobs of a pass add up to its DMA time,
+ * and an AXI error fails every job of the pass.
+ *
+ * A job with a fill pattern is a write-only transfer: the channel writes
+ * the four pattern words over its destination again and again, reading
+ * nothing. The channel has that mode in simple (one transfer) mode only, so
+ * a fill job runs as a pass of its own and the queue switches the channel
+ * between the two modes while it is idle.
+ *
+ * The driver links the descriptors by their R5 address, so a queue must not
+ * live in TCM; it flushes each descriptor it writes.
+ */
+
+#ifndef RPU_DMAQ_H
+#define RPU_DMAQ_H
+
+#include "xil_types.h"
+#include "xzdma.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define RPU_DMAQ_DEPTH    16  // Jobs waiting, and jobs in one pass
+
+/* Job status */
+#define RPU_DMAQ_PENDING  0
+#define RPU_DMAQ_OK       1
+#define RPU_DMAQ_FAILED   2
+
+typedef struct {
+    XZDma_Transfer xfer;
+    u32 *fill;              /* Write-only job: 4 pattern words, NULL: copy */
+    TaskHandle_t task;      /* Notified on completion, NULL: poll status */
+    u32 notify_bits;        /* eSetBits value of the notification */
+    volatile u32 status;    /* RPU_DMAQ_* */
+    u32 ticks;              /* DMA time in system counter ticks (rpu_trace.h) */
+} RpuDmaqJob_t;
+
+typedef struct {
+    XZDma dma;
+    RpuDmaqJob_t *wait[RPU_DMAQ_DEPTH];   /* Submitted, not started yet */
+    u32 wait_head;
+    u32 wait_tail;
+    RpuDmaqJob_t *run[RPU_DMAQ_DEPTH];    /* The pass in flight */
+    u32 run_count;
+    u64 run_start;
+    XZDma_Transfer xfer[RPU_DMAQ_DEPTH];
+    // Linked-list mode needs one source and one destination descriptor per job
+    XZDma_LlDscr dscr[2 * RPU_DMAQ_DEPTH] __attribute__((aligned(64)));
+} RpuDmaq_t;
+
+/* Set up the channel at base in linked-list mode with the given data
+ * configuration and connect its interrupt */
+int xRpuDmaqInit(RpuDmaq_t *q, UINTPTR base, XZDma_DataConfig *data, u16 intr_priority);
+/* Queue count jobs (task context); XST_DEVICE_BUSY when they do not fit */
+int xRpuDmaqSubmit(RpuDmaq_t *q, RpuDmaqJob_t *jobs, u32 count);
+/* Stop a pass that never completed: its jobs fail, the waiting ones start */
+void vRpuDmaqAbort(RpuDmaq_t *q);
+
+#endif /* RPU_DMAQ_H */
@@ -0,0 +1,71 @@
+/*
+ * LED edge timing measurement (see rpu_edge.h).
+ *
+ * Called from the Rx task only; vRpuEdgeRestart() from the Tx task just
+ * drops the anchor, which the next edge sets again.
+ */
+
+#include "rpu_edge.h"
+
+#if RPU_EDGE_STATS
+
+#include "rpu_log.h"
+#include "rpu_shm.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_trace.h"
+
+static volatile u32 ulEdgeAnchored RPU_BTCM_BSS;
+static u64 ullEdgeAnchorTime RPU_BTCM_BSS;         /* Counter at the first edge */
+static TickType_t xEdgeAnchorTick RPU_BTCM_BSS;    /* Its deadline */
+static s32 lEdgeMin RPU_BTCM_BSS;
+static s32 lEdgeMax RPU_BTCM_BSS;
+static u32 ulEdgeCount RPU_BTCM_BSS;               /* Edges in the log window */
+
+/*-----------------------------------------------------------*/
+void vRpuEdgeRestart(void)
+{
+    ulEdgeAnchored = 0;
+}
+
+/*-----------------------------------------------------------*/
+/* The GPIO was just written for the edge due at tick deadline */
+void vRpuEdgeRecord(TickType_t deadline)
+{
+    u64 now = ullRpuTimeNow();
+    u64 due;
+    s32 err;
+
+    if (!ulEdgeAnchored) {
+        ullEdgeAnchorTime = now;
+        xEdgeAnchorTick = deadline;
+        lEdgeMin = 0;
+        lEdgeMax = 0;
+        ulEdgeCount = 0;
+        ulEdgeAnchored = 1;
+    }
+
+    due = ullEdgeAnchorTime +
+          (u64)(TickType_t)(deadline - xEdgeAnchorTick) * ulRpuTimeHz() / configTICK_RATE_HZ;
+    if (now >= due) {
+        err = (s32)ullRpuTimeToNs(now - due);
+    } else {
+        err = -(s32)ullRpuTimeToNs(due - now);
+    }
+
+    vRpuTrace(RPU_TRACE_EDGE, (u32)deadline, (u32)err);
+
+    if (ulEdgeCount == 0 || err < lEdgeMin) {
+        lEdgeMin = err;
+    }
+    if (ulEdgeCount == 0 || err > lEdgeMax) {
+        lEdgeMax = err;
+    }
+    if (++ulEdgeCount == RPU_EDGE_LOG_EDGES) {
+        RPU_LOG("Edge: last %d ns, min %d ns, max %d ns over %u edges\r\n",
+                err, lEdgeMin, lEdgeMax, (unsigned)ulEdgeCount);
+        ulEdgeCount = 0;
+    }
+}
+
+#endif /* RPU_EDGE_STATS */
@@ -0,0 +1,46 @@
+/*
+ * LED edge timing measurement (build option RPU_EDGE_STATS=1,
+ * UserConfig.cmake).
+ *
+ * The Tx task schedules the blink pattern on absolute tick deadlines
+ * (xTaskDelayUntil()), so an edge is due at a known tick. The Rx task calls
+ * vRpuEdgeRecord() with that deadline right after it wrote the GPIO; the
+ * first edge of a run anchors the deadline tick to the system counter
+ * (rpu_time.h) and every later edge is compared with anchor + ticks elapsed.
+ * The error, in ns and positive when late, goes into the trace as
+ * RPU_TRACE_EDGE, so apu_app/rpu_trace shows the drift over a long run; every
+ * RPU_EDGE_LOG_EDGES edges the last, minimum and maximum error of the window
+ * are logged as well (maximum - minimum is the jitter).
+ *
+ * vRpuEdgeRestart() begins a new run when the Tx task re-anchors its
+ * schedule after a missed deadline, since the old anchor no longer applies.
+ */
+
+#ifndef RPU_EDGE_H
+#define RPU_EDGE_H
+
+#include "xil_types.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_EDGE_STATS
+#define RPU_EDGE_STATS 0
+#endif
+
+#define RPU_EDGE_LOG_EDGES      32
+
+#if RPU_EDGE_STATS
+void vRpuEdgeRestart(void);
+void vRpuEdgeRecord(TickType_t deadline);
+#else
+static inline void vRpuEdgeRestart(void)
+{
+}
+
+static inline void vRpuEdgeRecord(TickType_t deadline)
+{
+    (void)deadline;
+}
+#endif /* RPU_EDGE_STATS */
+
+#endif /* RPU_EDGE_H */
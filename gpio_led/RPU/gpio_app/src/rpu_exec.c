@@ -0,0 +1,143 @@
+/*
+ * Run-to-completion executive (see rpu_exec.h).
+ *
+ * Posted events are one word taken with an atomic exchange, so a post from
+ * an interrupt handler between the exchange and the handler call is kept
+ * for the next round rather than lost. Slot releases are absolute counter
+ * ticks: due += period after each run keeps the phase whatever the run
+ * took, and a release already past its next one is re-anchored to now.
+ *
+ * The loop spins rather than waiting for an interrupt: without the tick
+ * nothing would wake it for the next slot, and the spin is what keeps the
+ * event latency at a few loop iterations.
+ */
+
+#include "rpu_exec.h"
+
+#if RPU_EXEC
+
+#include "xil_exception.h"
+
+#include "rpu_log.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+
+typedef struct {
+    RpuExecFn_t fn;
+    u32 first_us;
+    u32 period_us;
+    u64 due;             /* Next release, system counter ticks */
+    u64 period;          /* System counter ticks */
+    u32 overruns;        /* Releases re-anchored; the first is logged */
+} RpuExecSlot_t;
+
+static RpuExecFn_t xExecHandlers[RPU_EXEC_EVENTS] RPU_BTCM_BSS;
+static RpuExecSlot_t xExecSlots[RPU_EXEC_SLOTS] RPU_BTCM_BSS;
+static u32 ulExecSlotCount RPU_BTCM_BSS;
+static volatile u32 ulExecEvents;
+
+/* Interrupt masking of the port before vTaskStartScheduler() (port.c) */
+extern volatile uint32_t ulCriticalNesting;
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT void vRpuExecOn(u32 ev, RpuExecFn_t fn)
+{
+    u32 i;
+
+    for (i = 0; i < RPU_EXEC_EVENTS; i++) {
+        if (ev & (1U << i)) {
+            xExecHandlers[i] = fn;
+        }
+    }
+}
+
+RPU_INIT_TEXT int xRpuExecSlot(RpuExecFn_t fn, u32 first_us, u32 period_us)
+{
+    RpuExecSlot_t *slot;
+
+    if (ulExecSlotCount == RPU_EXEC_SLOTS || period_us == 0) {
+        return XST_FAILURE;
+    }
+    slot = &xExecSlots[ulExecSlotCount++];
+    slot->fn = fn;
+    slot->first_us = first_us;
+    slot->period_us = period_us;
+    return XST_SUCCESS;
+}
+
+RPU_ATCM_TEXT void vRpuExecPost(u32 events)
+{
+    __atomic_fetch_or(&ulExecEvents, events, __ATOMIC_RELEASE);
+}
+
+/*-----------------------------------------------------------*/
+static u64 prvUsToTicks(u32 us)
+{
+    return (u64)us * ulRpuTimeHz() / 1000000U;
+}
+
+/* Run the handlers of the events posted so far */
+RPU_ATCM_TEXT static void prvExecEvents(void)
+{
+    u32 events = __atomic_exchange_n(&ulExecEvents, 0, __ATOMIC_ACQUIRE);
+    u32 i;
+
+    while (events != 0) {
+        i = (u32)__builtin_ctz(events);
+        events &= events - 1;
+        if (i < RPU_EXEC_EVENTS && xExecHandlers[i] != NULL) {
+            xExecHandlers[i]();
+        }
+    }
+}
+
+void vRpuExecRun(void)
+{
+    RpuExecSlot_t *slot;
+    u64 now;
+    u32 i;
+
+    // The counter vTaskStartScheduler() would start (rpu_stats.h): timed
+    // commands and the telemetry time stamps use it
+    portCONFIGURE_TIMER_FOR_RUN_TIME_STATS();
+
+    now = ullRpuTimeNow();
+    for (i = 0; i < ulExecSlotCount; i++) {
+        slot = &xExecSlots[i];
+        slot->period = prvUsToTicks(slot->period_us);
+        slot->due = now + prvUsToTicks(slot->first_us);
+    }
+    RPU_LOG("Executive: %d slot(s), no scheduler\r\n", ulExecSlotCount);
+
+    // Critical sections before this point kept the interrupts masked (the
+    // nesting count starts at 9999); from here they nest from zero as in a task
+    ulCriticalNesting = 0;
+    portENABLE_INTERRUPTS();
+    Xil_ExceptionEnable();
+
+    for (;;) {
+        prvExecEvents();
+
+        now = ullRpuTimeNow();
+        for (i = 0; i < ulExecSlotCount; i++) {
+            slot = &xExecSlots[i];
+            if ((s64)(now - slot->due) < 0) {
+                continue;
+            }
+            slot->fn();
+            slot->due += slot->period;
+            if ((s64)(now - slot->due) >= 0) {
+                // Released a whole period late: skip what was missed
+                slot->due = now + slot->period;
+                if (slot->overruns++ == 0) {
+                    RPU_LOG("Executive: slot %d late, re-anchored\r\n", i);
+                }
+            }
+            // Events first again: a slot never delays a doorbell by more
+            // than its own run
+            prvExecEvents();
+        }
+    }
+}
+
+#endif /* RPU_EXEC */
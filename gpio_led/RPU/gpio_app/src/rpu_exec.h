@@ -0,0 +1,105 @@
+/*
+ * Run-to-completion executive (build option RPU_EXEC=1, UserConfig.cmake;
+ * RPU0 firmware only).
+ *
+ * The same firmware without the scheduler: main() sets up the drivers, the
+ * shared window and the interrupts as in the FreeRTOS build, then calls
+ * vRpuExecRun() instead of vTaskStartScheduler(). From there one loop runs
+ * everything to completion on the stack of main():
+ *
+ *   - events: interrupt handlers post bits with vRpuExecPost(), and
+ *     the loop runs the handler of each posted bit, lowest bit first, before
+ *     it looks at the slots again. A command doorbell runs the IPI pass with
+ *     no task switch in between, so the command latency is the interrupt
+ *     entry plus the loop's current step;
+ *   - slots: a static table of periodic functions on the 64-bit system
+ *     counter (rpu_time.h), phase-locked to their first release. A slot
+ *     released late is re-anchored rather than run back to back, and counted.
+ *
+ * Nothing blocks and nothing is preempted except by interrupts, so a handler
+ * or slot must return within the latency the others can stand (the longest
+ * is the LED burst slot, well under 10 us). The FreeRTOS BSP stays the
+ * platform: its drivers, the interrupt wrapper and the critical section
+ * macros work without the scheduler once vRpuExecRun() has reset the port's
+ * critical nesting count. Task and timer APIs must not be called.
+ *
+ * The command protocol, the pattern engine, the deferred log and the
+ * telemetry frames are those of the FreeRTOS build; ipi_bench and rpu_e2e
+ * measure both the same way. The interrupt handlers that notify a task in
+ * the FreeRTOS build use vRpuExecNotifyFromIsr(), which posts
+ * RPU_EXEC_EV_CMD here instead. Options whose modules depend on their own
+ * tasks are refused below; the bulk channel is not set up.
+ */
+
+#ifndef RPU_EXEC_H
+#define RPU_EXEC_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "rpu_core.h"
+
+#ifndef RPU_EXEC
+#define RPU_EXEC 0
+#endif
+
+#if RPU_EXEC
+#if RPU_CORE != 0
+#error "RPU_EXEC is for the RPU0 firmware: RPU1 keeps the FreeRTOS build"
+#endif
+#if RPU_BENCH || RPU_MEMBENCH
+#error "RPU_EXEC replaces the scheduler the benchmark builds measure"
+#endif
+#if RPU_IPI_FIQ || RPU_HWTIMER || RPU_RPMSG || RPU_GOVERNOR || RPU_WATCHDOG
+#error "RPU_EXEC: RPU_IPI_FIQ, RPU_HWTIMER, RPU_RPMSG, RPU_GOVERNOR and RPU_WATCHDOG need the scheduler"
+#endif
+#if RPU_APM || RPU_SYSMON || RPU_SENSOR || RPU_GPIO_IN || RPU_EDGE_STATS || RPU_XCORE
+#error "RPU_EXEC: RPU_APM, RPU_SYSMON, RPU_SENSOR, RPU_GPIO_IN, RPU_EDGE_STATS and RPU_XCORE depend on tasks or the tick"
+#endif
+#endif /* RPU_EXEC */
+
+/* Event bits; a handler runs once per set of posts before it runs */
+#define RPU_EXEC_EV_CMD     (1U << 0)   /* Doorbell or timed command: the IPI pass */
+#define RPU_EXEC_EVENTS     8
+
+#define RPU_EXEC_SLOTS      8
+
+typedef void (*RpuExecFn_t)(void);
+
+#if RPU_EXEC
+/* Handler of event bit ev (one of RPU_EXEC_EV_*) */
+void vRpuExecOn(u32 ev, RpuExecFn_t fn);
+/* Periodic slot: first release first_us after vRpuExecRun(), then every
+ * period_us; XST_FAILURE once the table is full */
+int xRpuExecSlot(RpuExecFn_t fn, u32 first_us, u32 period_us);
+/* Post events, from an interrupt handler or the loop itself */
+void vRpuExecPost(u32 events);
+/* Enable the interrupts and run the loop; never returns */
+void vRpuExecRun(void) __attribute__((noreturn));
+#endif /* RPU_EXEC */
+
+/* Wake the consumer of a command doorbell: the task in the FreeRTOS build,
+ * the RPU_EXEC_EV_CMD handler in the executive */
+static inline void vRpuExecNotifyFromIsr(TaskHandle_t task, BaseType_t *pxWoken)
+{
+#if RPU_EXEC
+    (void)task;
+    (void)pxWoken;
+    vRpuExecPost(RPU_EXEC_EV_CMD);
+#else
+    vTaskNotifyGiveFromISR(task, pxWoken);
+#endif /* RPU_EXEC */
+}
+
+static inline void vRpuExecNotify(TaskHandle_t task)
+{
+#if RPU_EXEC
+    (void)task;
+    vRpuExecPost(RPU_EXEC_EV_CMD);
+#else
+    xTaskNotifyGive(task);
+#endif /* RPU_EXEC */
+}
+
+#endif /* RPU_EXEC_H */
@@ -0,0 +1,63 @@
+/*
+ * FIQ fast path of the APU doorbell (see rpu_fiq.h).
+ *
+ * The RPU GIC (GICv1 with security extensions) sees the R5 as secure, so
+ * group 0 is the secure group: with FIQEn it is signalled on FIQ, group 1 on
+ * IRQ. The CPU interface already runs with EnableS, EnableNS and AckCtl
+ * (CPUInitialize() in xscugic.c), so the FreeRTOS handler keeps acknowledging
+ * the group 1 lines; SBPR makes them use the secure binary point, which the
+ * port checks to be 0.
+ */
+
+#include "rpu_fiq.h"
+
+#if RPU_IPI_FIQ
+
+#include "xstatus.h"
+#include "xinterrupt_wrap.h"
+
+#include "rpu_tcm.h"
+
+#define RPU_GICD_EN_GROUPS  0x03U  // EnableS | EnableNS
+
+/*-----------------------------------------------------------*/
+/* Route intr_id (wrapper encoding) to handler on FIQ; enable it afterwards
+ * with XEnableIntrId() */
+RPU_INIT_TEXT int xRpuFiqInit(u32 intr_id, UINTPTR intc_parent, Xil_ExceptionHandler handler, void *ref)
+{
+    u32 id = XGet_IntrId(intr_id) + XGet_IntrOffset(intr_id);
+    u32 ctl;
+    u32 reg;
+    int Status;
+
+    if (id >= XSCUGIC_MAX_NUM_INTR_INPUTS) {
+        return XST_INVALID_PARAM;
+    }
+    Status = XConfigInterruptCntrl(intc_parent);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XSetPriorityTriggerType(intr_id, RPU_FIQ_PRIORITY, intc_parent);
+    Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_FIQ_INT, handler, ref);
+
+    // Everything group 1 (IRQ) but this line
+    for (reg = 0; reg < (XSCUGIC_MAX_NUM_INTR_INPUTS + 31) / 32; reg++) {
+        u32 groups = 0xFFFFFFFFU;
+
+        if (reg == id / 32) {
+            groups &= ~(1U << (id % 32));
+        }
+        Xil_Out32(RPU_GICD_BASE + XSCUGIC_SECURITY_OFFSET + reg * 4, groups);
+    }
+    Xil_Out32(RPU_GICD_BASE + XSCUGIC_DIST_EN_OFFSET, RPU_GICD_EN_GROUPS);
+
+    ctl = Xil_In32(RPU_GICC_BASE + XSCUGIC_CONTROL_OFFSET);
+    Xil_Out32(RPU_GICC_BASE + XSCUGIC_CONTROL_OFFSET,
+              ctl | XSCUGIC_CNTR_FIQEN_MASK | XSCUGIC_CNTR_SBPR_MASK |
+              XSCUGIC_CNTR_ACKCTL_MASK | XSCUGIC_CNTR_EN_NS_MASK | XSCUGIC_CNTR_EN_S_MASK);
+
+    Xil_ExceptionEnableMask(XIL_EXCEPTION_FIQ);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_IPI_FIQ */
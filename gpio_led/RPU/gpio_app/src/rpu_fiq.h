@@ -0,0 +1,63 @@
+/*
+ * FIQ fast path of the APU doorbell (build option RPU_IPI_FIQ=1,
+ * UserConfig.cmake).
+ *
+ * xRpuFiqInit() makes the IPI a GIC group 0 interrupt at the top priority
+ * and has the CPU interface signal group 0 on FIQ (FIQEn); every other line
+ * becomes group 1 and keeps reaching the FreeRTOS IRQ handler as before.
+ * The doorbell then enters through the FIQ vector straight into one
+ * handler: no FreeRTOS interrupt entry (FPU save, nesting count) and no
+ * XScuGic table dispatch.
+ *
+ * The FIQ handler must stay away from the kernel: it preempts critical
+ * sections, which only raise the GIC priority mask. The standalone FIQ vector
+ * saves r0-r3, r12 and lr only, so the handler must not use the FPU either.
+ * Work that needs the kernel is handed over with vRpuFiqWake(), which pends
+ * RPU_FIQ_WAKE_SGI, a group 1 software interrupt to this core, served on IRQ.
+ *
+ * XConnectToFastInterruptCntrl() of the interrupt wrapper serves the AXI
+ * INTC fast interrupt mode only, hence the direct GIC programming here.
+ */
+
+#ifndef RPU_FIQ_H
+#define RPU_FIQ_H
+
+#include "xil_types.h"
+
+#ifndef RPU_IPI_FIQ
+#define RPU_IPI_FIQ 0
+#endif
+
+#define RPU_FIQ_WAKE_SGI   14    // SGI pended by the FIQ handler for the IRQ side
+#define RPU_FIQ_PRIORITY   0x00  // Above every IRQ, whatever the priority mask
+
+#if RPU_IPI_FIQ
+#include <xil_io.h>
+#include "xil_exception.h"
+#include "xscugic_hw.h"
+
+#define RPU_GICD_BASE      0xF9000000U  // Distributor (IPI_INTC_PARENT)
+#define RPU_GICC_BASE      0xF9001000U  // CPU interface
+
+int xRpuFiqInit(u32 intr_id, UINTPTR intc_parent, Xil_ExceptionHandler handler, void *ref);
+
+/* Acknowledge the FIQ: returns the IAR value vRpuFiqEnd() takes back */
+static inline u32 ulRpuFiqAck(void)
+{
+    return Xil_In32(RPU_GICC_BASE + XSCUGIC_INT_ACK_OFFSET);
+}
+
+static inline void vRpuFiqEnd(u32 iar)
+{
+    Xil_Out32(RPU_GICC_BASE + XSCUGIC_EOI_OFFSET, iar);
+}
+
+/* Pend RPU_FIQ_WAKE_SGI on this core; SATT selects the group 1 SGI */
+static inline void vRpuFiqWake(void)
+{
+    Xil_Out32(RPU_GICD_BASE + XSCUGIC_SFI_TRIG_OFFSET,
+              (0x2U << 24) | XSCUGIC_SFI_TRIG_SATT_MASK | RPU_FIQ_WAKE_SGI);
+}
+#endif /* RPU_IPI_FIQ */
+
+#endif /* RPU_FIQ_H */
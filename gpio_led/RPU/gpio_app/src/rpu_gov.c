@@ -0,0 +1,232 @@
+/*
+ * Workload governor (see rpu_gov.h, rpu_shm.h).
+ *
+ * The state and the measurements are changed by the timer callback inside a
+ * critical section and by the IPI handler, which the critical section masks
+ * (RPU_INTR_IPI_LEVEL is at the API call ceiling), so the two never
+ * interleave. The handler only keeps counter ticks; the callback converts
+ * them when it publishes the block.
+ */
+
+#include "rpu_gov.h"
+
+#if RPU_GOVERNOR
+
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xclockps.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "rpu_log.h"
+#include "rpu_seqlock.h"
+#include "rpu_shm.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+
+#ifdef RPU_GOV_GATE_CLOCKS
+static const XClock_OutputClks xGovGate[] = { RPU_GOV_GATE_CLOCKS };
+#define GOV_GATED              (sizeof(xGovGate) / sizeof(xGovGate[0]))
+#else
+#define GOV_GATED              0
+#endif
+
+static XClock xGovClock;
+static RpuGovIdleFn_t pxGovIdle;
+static XClockRate xGovFullHz;
+static XClockRate xGovLowHz;
+static u32 ulGovLastHead;
+static u32 ulGovIdleMs;
+static u32 ulGovSeq;
+static TimerHandle_t xGovTimer;
+static StaticTimer_t xGovTimerBuffer RPU_BTCM_NOINIT;
+
+/* Shared with the IPI handler */
+static volatile u32 ulGovState RPU_BTCM_BSS;
+static u32 ulGovEntries RPU_BTCM_BSS;
+static u32 ulGovWakes RPU_BTCM_BSS;
+static u64 ullGovLowStart RPU_BTCM_BSS;
+static u64 ullGovLowTime RPU_BTCM_BSS;
+static u64 ullGovWakeLast RPU_BTCM_BSS;
+static u64 ullGovWakeMax RPU_BTCM_BSS;
+static u64 ullGovWakeSum RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* Gate (on = 0) or enable the RPU_GOV_GATE_CLOCKS */
+RPU_ATCM_TEXT static void prvGovGate(int on)
+{
+#ifdef RPU_GOV_GATE_CLOCKS
+    u32 i;
+
+    for (i = 0; i < GOV_GATED; i++) {
+        (void)(on ? XClock_EnableClock(xGovGate[i]) : XClock_DisableClock(xGovGate[i]));
+    }
+#else
+    (void)on;
+#endif
+}
+
+/*-----------------------------------------------------------*/
+/* Full R5 clock and the gated clocks back on */
+RPU_ATCM_TEXT static void prvGovRaise(void)
+{
+    XClockRate rate;
+
+    (void)XClock_SetRate(CPU_R5, xGovFullHz, &rate);
+    prvGovGate(1);
+    ullGovLowTime += ullRpuTimeNow() - ullGovLowStart;
+    ulGovState = GOV_STATE_FULL;
+}
+
+/*-----------------------------------------------------------*/
+static void prvGovLower(void)
+{
+    XClockRate rate;
+
+    if (XClock_SetRate(CPU_R5, xGovFullHz / RPU_GOV_LOW_DIV, &rate) != XST_SUCCESS) {
+        return;
+    }
+    xGovLowHz = rate;   /* What the divider could do */
+    prvGovGate(0);
+    ullGovLowStart = ullRpuTimeNow();
+    ulGovEntries++;
+    ulGovState = GOV_STATE_LOW;
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuGovWakeFromIsr(void)
+{
+    u64 entry;
+
+    if (ulGovState != GOV_STATE_LOW) {
+        return;
+    }
+    entry = ullRpuTimeNow();
+    prvGovRaise();
+    ullGovWakeLast = ullRpuTimeNow() - entry;
+    if (ullGovWakeLast > ullGovWakeMax) {
+        ullGovWakeMax = ullGovWakeLast;
+    }
+    ullGovWakeSum += ullGovWakeLast;
+    ulGovWakes++;
+    ulGovIdleMs = 0;
+}
+
+/*-----------------------------------------------------------*/
+/* Copy the measurements into the block under the seq word */
+static void prvGovPublish(void)
+{
+    u32 state, entries, wakes;
+    u64 now, low_time, wake_last, wake_max, wake_sum;
+
+    taskENTER_CRITICAL();
+    now = ullRpuTimeNow();
+    state = ulGovState;
+    entries = ulGovEntries;
+    wakes = ulGovWakes;
+    low_time = ullGovLowTime + (state == GOV_STATE_LOW ? now - ullGovLowStart : 0);
+    wake_last = ullGovWakeLast;
+    wake_max = ullGovWakeMax;
+    wake_sum = ullGovWakeSum;
+    taskEXIT_CRITICAL();
+
+    wake_sum = ullRpuTimeToNs(wake_sum);
+    vRpuSeqBegin(GOV_ADDR + GOV_SEQ_OFFSET, &ulGovSeq);
+    Xil_Out32(GOV_ADDR + GOV_STATE_OFFSET, state);
+    Xil_Out32(GOV_ADDR + GOV_LOW_HZ_OFFSET, (u32)xGovLowHz);
+    Xil_Out32(GOV_ADDR + GOV_ENTRIES_OFFSET, entries);
+    Xil_Out32(GOV_ADDR + GOV_WAKES_OFFSET, wakes);
+    Xil_Out32(GOV_ADDR + GOV_WAKE_LAST_OFFSET, (u32)ullRpuTimeToNs(wake_last));
+    Xil_Out32(GOV_ADDR + GOV_WAKE_MAX_OFFSET, (u32)ullRpuTimeToNs(wake_max));
+    Xil_Out32(GOV_ADDR + GOV_WAKE_SUM_LO, (u32)wake_sum);
+    Xil_Out32(GOV_ADDR + GOV_WAKE_SUM_HI, (u32)(wake_sum >> 32));
+    Xil_Out32(GOV_ADDR + GOV_LOW_TIME_LO, (u32)low_time);
+    Xil_Out32(GOV_ADDR + GOV_LOW_TIME_HI, (u32)(low_time >> 32));
+    Xil_Out32(GOV_ADDR + GOV_NOW_LO, (u32)now);
+    Xil_Out32(GOV_ADDR + GOV_NOW_HI, (u32)(now >> 32));
+    vRpuSeqEnd(GOV_ADDR + GOV_SEQ_OFFSET, &ulGovSeq);
+}
+
+/*-----------------------------------------------------------*/
+/* Timer callback: follow the workload, then publish the block */
+static void prvGovCheck(TimerHandle_t xTimer)
+{
+    u32 head = Xil_In32(RPU_SHM_BASE + SHM_RING_HEAD_OFFSET);
+    int idle;
+
+    (void)xTimer;
+    idle = pxGovIdle() && head == ulGovLastHead &&
+           head == Xil_In32(RPU_SHM_BASE + SHM_RING_TAIL_OFFSET) &&
+           ulRpuLogPending() == 0;
+    ulGovLastHead = head;
+
+    taskENTER_CRITICAL();
+    if (!idle) {
+        ulGovIdleMs = 0;
+        if (ulGovState == GOV_STATE_LOW) {
+            prvGovRaise();
+        }
+    } else if (ulGovState == GOV_STATE_FULL) {
+        ulGovIdleMs += RPU_GOV_PERIOD_MS;
+        if (ulGovIdleMs >= RPU_GOV_IDLE_MS) {
+            prvGovLower();
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    prvGovPublish();
+}
+
+/*-----------------------------------------------------------*/
+/* Look up the clocks, announce the block and start the periodic check */
+RPU_INIT_TEXT int xRpuGovInit(RpuGovIdleFn_t idle)
+{
+    XClockPs_Config *cfg;
+    int Status;
+
+    if (idle == NULL) {
+        return XST_INVALID_PARAM;
+    }
+    pxGovIdle = idle;
+
+    Xil_SetTlbAttributes(GOV_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(GOV_ADDR + GOV_MAGIC_OFFSET, 0);
+
+    cfg = XClock_LookupConfig(XPAR_XCLOCKPS_0_BASEADDR);
+    if (cfg == NULL) {
+        return XST_DEVICE_NOT_FOUND;
+    }
+    Status = XClock_CfgInitialize(&xGovClock, cfg);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    Status = XClock_GetRate(CPU_R5, &xGovFullHz);
+    if (Status != XST_SUCCESS || xGovFullHz == 0) {
+        return XST_FAILURE;
+    }
+    xGovLowHz = xGovFullHz / RPU_GOV_LOW_DIV;
+
+    ulGovSeq = ulRpuSeqInit(GOV_ADDR + GOV_SEQ_OFFSET);
+    ulGovState = GOV_STATE_FULL;
+    ulGovLastHead = Xil_In32(RPU_SHM_BASE + SHM_RING_HEAD_OFFSET);
+    Xil_Out32(GOV_ADDR + GOV_FULL_HZ_OFFSET, (u32)xGovFullHz);
+    Xil_Out32(GOV_ADDR + GOV_GATED_OFFSET, GOV_GATED);
+    prvGovPublish();
+    Xil_Out32(GOV_ADDR + GOV_MAGIC_OFFSET, GOV_MAGIC);
+
+    xGovTimer = xTimerCreateStatic((const char *)"Gov",
+                                   pdMS_TO_TICKS(RPU_GOV_PERIOD_MS),
+                                   pdTRUE,
+                                   NULL,
+                                   prvGovCheck,
+                                   &xGovTimerBuffer);
+    configASSERT(xGovTimer);
+    xTimerStart(xGovTimer, 0);
+
+    RPU_LOG("Governor: R5 at %u Hz, %u Hz when idle, %u clock(s) gated\r\n",
+            (unsigned)xGovFullHz, (unsigned)xGovLowHz, (unsigned)GOV_GATED);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_GOVERNOR */
@@ -0,0 +1,79 @@
+/*
+ * Workload governor: clock scaling and gating while the RPU is idle (build
+ * option RPU_GOVERNOR=1, UserConfig.cmake; RPU0 firmware only).
+ *
+ * A software timer checks the workload every RPU_GOV_PERIOD_MS. Once for
+ * RPU_GOV_IDLE_MS in a row the command ring has been empty with no new
+ * descriptor, the log ring has been drained and the application callback
+ * (main.c: SLOW blink, waveform engine stopped) agrees, the governor enters
+ * the low state with the BSP clockps driver: it divides the R5 clock by
+ * RPU_GOV_LOW_DIV and gates the peripheral clocks listed in
+ * RPU_GOV_GATE_CLOCKS (XClock_OutputClks names). vRpuGovWakeFromIsr(),
+ * first thing in the IPI handler, restores both before the command is
+ * looked at; the periodic check also restores them as soon as the
+ * application callback objects (a mode change by the rotation timer).
+ *
+ * The system counter and the TTCs run from their own reference clocks, so
+ * ticks, timestamps and the run-time stats keep their rate at the low
+ * clock; the PMU cycle counter does not (RPU_IRQ_PROF, the LED write timing
+ * of rpu_led.h). The R5 clock is shared by both cores in split mode.
+ *
+ * The GOV block in OCM (rpu_shm.h) has the state, the time spent at the low
+ * clock and the wake-up latencies; apu_app/rpu_stats --gov prints it and,
+ * given a hwmon power sensor of the board, the power drawn in each state.
+ *
+ * RPU_GOV_GATE_CLOCKS is empty by default: the PS controllers the KR260
+ * design enables (UART1, I2C0, SPI1) all serve Linux, and the TTCs have no
+ * gate of their own. List only clocks no one on the board needs, e.g.
+ * -DRPU_GOV_GATE_CLOCKS=CAN0_REF,CAN1_REF; a listed clock is enabled again
+ * on every wake-up even if it was off before.
+ */
+
+#ifndef RPU_GOV_H
+#define RPU_GOV_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_GOVERNOR
+#define RPU_GOVERNOR 0
+#endif
+
+#define RPU_GOV_PERIOD_MS       100
+#ifndef RPU_GOV_IDLE_MS
+#define RPU_GOV_IDLE_MS         1000
+#endif
+#ifndef RPU_GOV_LOW_DIV
+#define RPU_GOV_LOW_DIV         4
+#endif
+
+/* Nonzero while the application allows the low state (timer service task) */
+typedef int (*RpuGovIdleFn_t)(void);
+
+#if RPU_GOVERNOR
+#if RPU_CORE != 0
+#error "RPU_GOVERNOR is for the RPU0 firmware: the R5 clock is shared by both cores"
+#endif
+#if RPU_GOV_LOW_DIV < 2
+#error "RPU_GOV_LOW_DIV must be 2 or more"
+#endif
+
+/* Start the governor; called once the scheduler objects exist */
+int xRpuGovInit(RpuGovIdleFn_t idle);
+/* IPI handler entry: back to the full clock if the governor lowered it */
+void vRpuGovWakeFromIsr(void);
+#else
+static inline int xRpuGovInit(RpuGovIdleFn_t idle)
+{
+    (void)idle;
+    return XST_SUCCESS;
+}
+
+static inline void vRpuGovWakeFromIsr(void)
+{
+}
+#endif /* RPU_GOVERNOR */
+
+#endif /* RPU_GOV_H */
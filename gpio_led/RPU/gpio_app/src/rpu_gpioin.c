@@ -0,0 +1,172 @@
+/*
+ * AXI GPIO input events (see rpu_gpioin.h).
+ *
+ * The interrupt status is cleared before the data register is read: an edge
+ * that comes after the read raises the interrupt again, so a change is never
+ * lost, only merged with the next one. The handler runs from ATCM and uses
+ * the register macros of xgpio_l.h, so it makes no call into DDR code.
+ *
+ * The events go through an rpu_ring.h ring in BTCM rather than a FreeRTOS
+ * queue: the handler is its only producer and the task its only consumer,
+ * so a push is four word stores and a head write, with no critical section,
+ * memcpy() or event list. The task arms the event index before it sleeps and
+ * the handler notifies it only for the event that crosses it. A burst of
+ * edges is taken GPIO_IN_BATCH at a time, behind one head read and one tail
+ * write, without a block and unblock per event.
+ */
+
+#include "rpu_gpioin.h"
+
+#if RPU_GPIO_IN
+
+#include "xparameters.h"
+#include "xinterrupt_wrap.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_log.h"
+#include "rpu_ring.h"
+#include "rpu_shm.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_trace.h"
+
+#if !XPAR_AXI_GPIO_0_IS_DUAL || !XPAR_AXI_GPIO_0_INTERRUPT_PRESENT
+#error "RPU_GPIO_IN needs the AXI GPIO with channel 2 and its interrupt: re-export the XSA from PL/gpio_led and regenerate the BSP"
+#endif
+
+#define GPIO_IN_CHANNEL        2
+#define GPIO_IN_QUEUE_LEN      32    /* Power of two */
+#define GPIO_IN_BATCH          4     /* Events taken per ring read (task stack) */
+#define GPIO_IN_TASK_STACK_SIZE configMINIMAL_STACK_SIZE
+
+typedef struct {
+    u64 timestamp;     /* System counter at the handler entry */
+    u32 value;         /* Channel 2 inputs after the change */
+    u32 changed;       /* Bits that differ from the previous event */
+} GpioInEvent_t;
+
+static UINTPTR ulGpioInBase RPU_BTCM_BSS;
+static TaskHandle_t xGpioInTask;
+static rpu_ring_t xGpioInProd RPU_BTCM_BSS;        /* Handler side */
+static rpu_ring_t xGpioInCons;                      /* Task side */
+static u32 ulGpioInLast RPU_BTCM_BSS;             /* Value of the last event */
+static volatile u32 ulGpioInDropped RPU_BTCM_BSS;  /* Events the ring had no room for */
+
+static u32 ulGpioInRing[ RPU_RING_BYTES(GPIO_IN_QUEUE_LEN, sizeof(GpioInEvent_t)) / 4 ]
+    RPU_BTCM_NOINIT __attribute__((aligned(RPU_RING_LINE)));
+static StaticTask_t xGpioInTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xGpioInStack, GPIO_IN_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* Channel 2 changed (interrupt context) */
+RPU_ATCM_TEXT static void prvGpioInIntr(void *CallBackRef)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    GpioInEvent_t ev;
+    u32 status;
+
+    (void)CallBackRef;
+    ev.timestamp = ullRpuTimeNow();
+    status = XGpio_ReadReg(ulGpioInBase, XGPIO_ISR_OFFSET);
+    XGpio_WriteReg(ulGpioInBase, XGPIO_ISR_OFFSET, status);    // Toggle-on-write
+    if ((status & XGPIO_IR_CH2_MASK) == 0) {
+        return;
+    }
+
+    ev.value = XGpio_ReadReg(ulGpioInBase, XGPIO_CHAN_OFFSET + XGPIO_DATA_OFFSET);
+    ev.changed = ev.value ^ ulGpioInLast;
+    if (ev.changed == 0) {
+        return;    // Pulse shorter than the handler latency
+    }
+    ulGpioInLast = ev.value;
+    if (rpu_ring_push(&xGpioInProd, &ev, 1) == 0) {
+        ulGpioInDropped++;
+        return;
+    }
+    if (rpu_ring_commit(&xGpioInProd, 1)) {
+        vTaskNotifyGiveFromISR(xGpioInTask, &xHigherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+static void prvGpioInTask(void *pvParameters)
+{
+    u32 ulReported = 0;
+
+    (void)pvParameters;
+    for (;;) {
+        GpioInEvent_t ev[GPIO_IN_BATCH];
+        u32 n, i, dropped;
+        u64 now;
+
+        while ((n = rpu_ring_pop(&xGpioInCons, ev, GPIO_IN_BATCH)) == 0) {
+            if (rpu_ring_arm(&xGpioInCons) == 0) {
+                (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+        }
+        // The whole batch was taken by the task at once
+        now = ullRpuTimeNow();
+        for (i = 0; i < n; i++) {
+            vRpuTrace(RPU_TRACE_GPIO_IN, (ev[i].value & 0xFFFF) | (ev[i].changed << 16),
+                      (u32)(now - ev[i].timestamp));
+        }
+
+        dropped = ulGpioInDropped;
+        if (dropped != ulReported) {
+            RPU_LOG("GPIO in: %u event(s) dropped\r\n", (unsigned)(dropped - ulReported));
+            ulReported = dropped;
+        }
+        for (i = 0; i < n; i++) {
+            RPU_LOG("GPIO in: 0x%x (changed 0x%x)\r\n", (unsigned)ev[i].value, (unsigned)ev[i].changed);
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuGpioInInit(XGpio *gpio, UBaseType_t task_priority, u16 intr_priority)
+{
+    XGpio_Config *cfg;
+    int Status;
+
+    cfg = XGpio_LookupConfig(gpio->BaseAddress);
+    if (cfg == NULL || gpio->IsDual != TRUE || gpio->InterruptPresent != TRUE) {
+        return XST_FAILURE;
+    }
+    ulGpioInBase = gpio->BaseAddress;
+
+    if (rpu_ring_format(ulGpioInRing, GPIO_IN_QUEUE_LEN, sizeof(GpioInEvent_t),
+                        RPU_RING_F_EVENT) != 0 ||
+        rpu_ring_attach(&xGpioInProd, ulGpioInRing, RPU_RING_PRODUCER) != 0 ||
+        rpu_ring_attach(&xGpioInCons, ulGpioInRing, RPU_RING_CONSUMER) != 0) {
+        return XST_FAILURE;
+    }
+    xGpioInTask = xTaskCreateStatic( prvGpioInTask,
+                             ( const char * ) "GpioIn",
+                             GPIO_IN_TASK_STACK_SIZE,
+                             NULL,
+                             task_priority,
+                             RPU_TASK_STACK_BUF(xGpioInStack),
+                             &xGpioInTaskBuffer );
+
+    XGpio_SetDataDirection(gpio, GPIO_IN_CHANNEL, 0xFFFFFFFFU);
+    XGpio_InterruptDisable(gpio, XGPIO_IR_MASK);
+    XGpio_InterruptClear(gpio, XGPIO_IR_MASK);
+    Status = XSetupInterruptSystem(gpio, (Xil_ExceptionHandler)prvGpioInIntr,
+                                   cfg->IntrId, cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    // Changes before this point are not events
+    ulGpioInLast = XGpio_DiscreteRead(gpio, GPIO_IN_CHANNEL);
+    ulGpioInDropped = 0;
+    XGpio_InterruptEnable(gpio, XGPIO_IR_CH2_MASK);
+    XGpio_InterruptGlobalEnable(gpio);
+    XEnableIntrId(cfg->IntrId, cfg->IntrParent);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_GPIO_IN */
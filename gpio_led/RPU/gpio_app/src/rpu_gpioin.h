@@ -0,0 +1,49 @@
+/*
+ * Interrupt-driven inputs on channel 2 of the AXI GPIO (build option
+ * RPU_GPIO_IN=1, UserConfig.cmake; RPU0 firmware only).
+ *
+ * The PL design makes channel 2 an input-only port (PMOD1 pins 1 and 2,
+ * gpio_input in gpio_led.bd) and routes the AXI GPIO interrupt to
+ * pl_ps_irq0. The handler timestamps each change with the system counter,
+ * reads the new input value and queues {timestamp, value, changed bits}
+ * on an rpu_ring.h ring; a task takes the events off it, records them in the trace
+ * (RPU_TRACE_GPIO_IN, with the edge-to-task latency) and logs them. Two
+ * edges closer than the handler latency show up as one change. Events that
+ * find the ring full are counted and reported with the next one.
+ *
+ * The exported hardware (XSA, and from it xparameters.h) must come from the
+ * updated PL design; the build stops if it still has a single channel or no
+ * interrupt.
+ */
+
+#ifndef RPU_GPIOIN_H
+#define RPU_GPIOIN_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xgpio.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_GPIO_IN
+#define RPU_GPIO_IN 0
+#endif
+
+#if RPU_GPIO_IN
+#if RPU_CORE != 0
+#error "RPU_GPIO_IN is for the RPU0 firmware: both cores share the AXI GPIO"
+#endif
+
+/* Takes over channel 2 and the interrupt of gpio, an initialized instance */
+int xRpuGpioInInit(XGpio *gpio, UBaseType_t task_priority, u16 intr_priority);
+#else
+static inline int xRpuGpioInInit(XGpio *gpio, UBaseType_t task_priority, u16 intr_priority)
+{
+    (void)gpio;
+    (void)task_priority;
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_GPIO_IN */
+
+#endif /* RPU_GPIOIN_H */
@@ -0,0 +1,85 @@
+/*
+ * Firmware hot-swap state block (see rpu_handoff.h, rpu_shm.h).
+ *
+ * Both sides are single writers at different times: the outgoing image
+ * writes the state and then the magic, the next one reads the magic and then
+ * the state. The system counter keeps running while remoteproc restarts the
+ * core, so the two stamps give the gap. The resume runs before
+ * vRpuTimeInit(), so the gap is converted with the design counter frequency,
+ * the one the FSBL programs.
+ */
+
+#include <xil_io.h>
+#include "xil_mpu.h"
+
+#include "rpu_boot.h"
+#include "rpu_handoff.h"
+#include "rpu_log.h"
+#include "rpu_shm.h"
+#include "rpu_time.h"
+
+/*-----------------------------------------------------------*/
+static u32 prvHandoffLeft(u32 ms, u32 gap_ms)
+{
+    return ms > gap_ms ? ms - gap_ms : 0;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuHandoffResume(RpuHandoff_t *state)
+{
+    UINTPTR base = RPU_HANDOFF_BASE;
+    u64 stamp, gap;
+    u32 gap_ms;
+
+    Xil_SetTlbAttributes(base, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    if (Xil_In32(base + HANDOFF_MAGIC_OFFSET) != HANDOFF_MAGIC ||
+        Xil_In32(base + HANDOFF_VERSION_OFFSET) != HANDOFF_VERSION) {
+        return XST_FAILURE;
+    }
+    __sync_synchronize();
+
+    stamp = ((u64)Xil_In32(base + HANDOFF_STAMP_HI) << 32) | Xil_In32(base + HANDOFF_STAMP_LO);
+    gap = ullRpuTimeNow() - stamp;
+    gap_ms = (u32)(ullRpuTimeToUs(gap) / 1000);
+
+    state->mode = Xil_In32(base + HANDOFF_MODE_OFFSET);
+    state->override = Xil_In32(base + HANDOFF_OVERRIDE_OFFSET);
+    state->legacy_mode = Xil_In32(base + HANDOFF_LEGACY_OFFSET);
+    state->led = Xil_In32(base + HANDOFF_LED_OFFSET);
+    state->frame_ms = prvHandoffLeft(Xil_In32(base + HANDOFF_FRAME_MS_OFFSET), gap_ms);
+    state->rotate_ms = prvHandoffLeft(Xil_In32(base + HANDOFF_ROTATE_MS_OFFSET), gap_ms);
+
+    // Taken: a later cold start must not resume the same state again
+    Xil_Out32(base + HANDOFF_GAP_US_OFFSET, (u32)ullRpuTimeToUs(gap));
+    __sync_synchronize();
+    Xil_Out32(base + HANDOFF_MAGIC_OFFSET, HANDOFF_RESUMED);
+
+    RPU_BOOT_PRINT("Resuming the previous image's state after %d ms (mode %d%s)\r\n",
+                   gap_ms, state->mode, state->override ? ", APU override" : "");
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+void vRpuHandoffSave(const RpuHandoff_t *state)
+{
+    UINTPTR base = RPU_HANDOFF_BASE;
+    u64 now = ullRpuTimeNow();
+
+    Xil_Out32(base + HANDOFF_MAGIC_OFFSET, 0);
+    __sync_synchronize();
+    Xil_Out32(base + HANDOFF_VERSION_OFFSET, HANDOFF_VERSION);
+    Xil_Out32(base + HANDOFF_STAMP_LO, (u32)now);
+    Xil_Out32(base + HANDOFF_STAMP_HI, (u32)(now >> 32));
+    Xil_Out32(base + HANDOFF_MODE_OFFSET, state->mode);
+    Xil_Out32(base + HANDOFF_OVERRIDE_OFFSET, state->override);
+    Xil_Out32(base + HANDOFF_LEGACY_OFFSET, state->legacy_mode);
+    Xil_Out32(base + HANDOFF_LED_OFFSET, state->led);
+    Xil_Out32(base + HANDOFF_FRAME_MS_OFFSET, state->frame_ms);
+    Xil_Out32(base + HANDOFF_ROTATE_MS_OFFSET, state->rotate_ms);
+    Xil_Out32(base + HANDOFF_GAP_US_OFFSET, 0);
+    __sync_synchronize();
+    Xil_Out32(base + HANDOFF_MAGIC_OFFSET, HANDOFF_MAGIC);
+
+    RPU_LOG("Handoff: state saved (mode %d, LEDs 0x%x), outputs frozen\r\n",
+            state->mode, state->led);
+}
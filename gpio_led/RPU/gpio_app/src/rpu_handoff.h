@@ -0,0 +1,39 @@
+/*
+ * Firmware hot-swap: application state carried to the next image (see
+ * rpu_shm.h, HANDOFF_ADDR).
+ *
+ * apu_app/fw_loader sends RPU_CMD_HANDOFF before it stops the core for a
+ * new image. The application fills an RpuHandoff_t, publishes it with
+ * vRpuHandoffSave() and from then on leaves its outputs and its mode alone,
+ * so the saved state is the one the pins keep while the core restarts.
+ *
+ * At boot, before the state is initialized, xRpuHandoffResume() takes a
+ * block of this layout version left by the previous image: the times to the
+ * next frame and rotation come back shortened by the gap between the save
+ * and the resume (0 if it was that long already), so the pattern continues
+ * on its old schedule. The block is marked taken, with the gap, so a later
+ * cold start initializes as usual.
+ */
+
+#ifndef RPU_HANDOFF_H
+#define RPU_HANDOFF_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "rpu_core.h"
+
+typedef struct {
+    u32 mode;         /* BlinkMode_t */
+    u32 override;     /* Mode set by the APU, no rotation */
+    u32 legacy_mode;  /* Legacy mailbox mode applied last */
+    u32 led;          /* Value on the LEDs */
+    u32 frame_ms;     /* Time left to the next frame */
+    u32 rotate_ms;    /* Time left to the next mode rotation */
+} RpuHandoff_t;
+
+/* Maps the block; XST_SUCCESS with *state filled if a handoff was left for
+ * this image, XST_FAILURE (block untouched) otherwise */
+int xRpuHandoffResume(RpuHandoff_t *state);
+void vRpuHandoffSave(const RpuHandoff_t *state);
+
+#endif /* RPU_HANDOFF_H */
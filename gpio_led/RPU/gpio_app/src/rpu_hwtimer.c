@@ -0,0 +1,300 @@
+/*
+ * Hardware timer wheel (see rpu_hwtimer.h).
+ *
+ * Each slot is a doubly-linked list of the armed timers whose expiry tick
+ * maps to it. The counter interrupt advances the wheel by one tick and
+ * unlinks the timers of the current slot that are due, re-linking periodic
+ * ones at their next expiry. All list updates, from the interrupt and from
+ * the API, happen under the API-level critical section; the callbacks run
+ * after it is left, so they never extend it.
+ *
+ * A missed counter interrupt would skip a slot: no critical section in this
+ * firmware comes near one RPU_HWTIMER_TICK_US.
+ */
+
+#include "xttcps.h"
+#include "xinterrupt_wrap.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_hwtimer.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+
+#if RPU_HWTIMER
+
+#define HWTIMER_SLOT_MASK      (RPU_HWTIMER_SLOTS - 1)
+#define HWTIMER_TASK_STACK_SIZE configMINIMAL_STACK_SIZE
+
+#if (RPU_HWTIMER_SLOTS & HWTIMER_SLOT_MASK) != 0
+#error "RPU_HWTIMER_SLOTS must be a power of two"
+#endif
+
+// Everything the counter interrupt touches is in TCM (rpu_tcm.h)
+static XTtcPs xHwTimerTtc RPU_BTCM_BSS;
+static RpuHwTimer_t *pxHwTimerSlots[ RPU_HWTIMER_SLOTS ] RPU_BTCM_BSS;
+static volatile u32 ulHwTimerNow RPU_BTCM_BSS;
+static u32 ulHwTimerArmed RPU_BTCM_BSS;               /* Timers in the wheel */
+static RpuHwTimer_t *pxHwTimerPendHead RPU_BTCM_BSS;  /* Deferred expiries, FIFO */
+static RpuHwTimer_t *pxHwTimerPendTail RPU_BTCM_BSS;
+static volatile u32 ulHwTimerOverruns RPU_BTCM_BSS;
+static TaskHandle_t xHwTimerTask RPU_BTCM_BSS;
+static StaticTask_t xHwTimerTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xHwTimerStack, HWTIMER_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* Slot list helpers (in the critical section) */
+RPU_ATCM_TEXT static void prvLink(RpuHwTimer_t *timer)
+{
+    RpuHwTimer_t **slot = &pxHwTimerSlots[timer->expiry & HWTIMER_SLOT_MASK];
+
+    timer->prev = NULL;
+    timer->next = *slot;
+    if (*slot != NULL) {
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+}
+
+RPU_ATCM_TEXT static void prvUnlink(RpuHwTimer_t *timer)
+{
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        pxHwTimerSlots[timer->expiry & HWTIMER_SLOT_MASK] = timer->next;
+    }
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/*-----------------------------------------------------------*/
+/* Counter interrupt: one wheel tick */
+RPU_ATCM_TEXT static void prvHwTimerHandler(void *CallbackRef)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    RpuHwTimer_t *due = NULL;
+    RpuHwTimer_t *timer, *next;
+    UBaseType_t saved;
+    u32 now;
+
+    (void)CallbackRef;
+
+    // Reading the status register clears it
+    (void)XTtcPs_GetInterruptStatus(&xHwTimerTtc);
+
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    now = ++ulHwTimerNow;
+    for (timer = pxHwTimerSlots[now & HWTIMER_SLOT_MASK]; timer != NULL; timer = next) {
+        next = timer->next;
+        if (timer->expiry != now) {
+            continue;   // A later turn of the wheel
+        }
+
+        prvUnlink(timer);
+        if (timer->period != 0) {
+            timer->expiry += timer->period;
+            prvLink(timer);
+        } else {
+            timer->armed = 0;
+            ulHwTimerArmed--;
+        }
+
+        if ((timer->flags & RPU_HWTIMER_DEFER) == 0) {
+            timer->pend_next = due;
+            due = timer;
+        } else if (timer->pending) {
+            ulHwTimerOverruns++;
+        } else {
+            timer->pending = 1;
+            timer->pend_next = NULL;
+            if (pxHwTimerPendTail != NULL) {
+                pxHwTimerPendTail->pend_next = timer;
+            } else {
+                pxHwTimerPendHead = timer;
+            }
+            pxHwTimerPendTail = timer;
+            vTaskNotifyGiveFromISR(xHwTimerTask, &xHigherPriorityTaskWoken);
+        }
+    }
+    if (ulHwTimerArmed == 0) {
+        XTtcPs_Stop(&xHwTimerTtc);
+    }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+
+    // Expiries of the same tick run in no particular order
+    for (timer = due; timer != NULL; timer = next) {
+        next = timer->pend_next;
+        timer->callback(timer, timer->arg);
+    }
+
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+/* The Timer Task:
+ * - Runs the callbacks of RPU_HWTIMER_DEFER timers in expiry order.
+ */
+static void prvHwTimerTask(void *pvParameters)
+{
+    RpuHwTimer_t *timer;
+    UBaseType_t saved;
+
+    (void)pvParameters;
+
+    for (;;) {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        for (;;) {
+            saved = taskENTER_CRITICAL_FROM_ISR();
+            timer = pxHwTimerPendHead;
+            if (timer != NULL) {
+                pxHwTimerPendHead = timer->pend_next;
+                if (pxHwTimerPendHead == NULL) {
+                    pxHwTimerPendTail = NULL;
+                }
+                timer->pending = 0;
+            }
+            taskEXIT_CRITICAL_FROM_ISR(saved);
+
+            if (timer == NULL) {
+                break;
+            }
+            timer->callback(timer, timer->arg);
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+void vRpuHwTimerSetup(RpuHwTimer_t *timer, RpuHwTimerCallback_t callback, void *arg, u32 flags)
+{
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->pend_next = NULL;
+    timer->expiry = 0;
+    timer->period = 0;
+    timer->flags = flags;
+    timer->armed = 0;
+    timer->pending = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+/*-----------------------------------------------------------*/
+void vRpuHwTimerStart(RpuHwTimer_t *timer, u32 delay, u32 period)
+{
+    UBaseType_t saved;
+
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    if (timer->armed) {
+        prvUnlink(timer);
+    } else {
+        timer->armed = 1;
+        if (ulHwTimerArmed++ == 0) {
+            // First timer: the first tick comes a full interval from now
+            XTtcPs_ResetCounterValue(&xHwTimerTtc);
+            XTtcPs_Start(&xHwTimerTtc);
+        }
+    }
+    timer->expiry = ulHwTimerNow + (delay != 0 ? delay : 1);
+    timer->period = period;
+    prvLink(timer);
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/*-----------------------------------------------------------*/
+void vRpuHwTimerStop(RpuHwTimer_t *timer)
+{
+    UBaseType_t saved;
+
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    if (timer->armed) {
+        prvUnlink(timer);
+        timer->armed = 0;
+        if (--ulHwTimerArmed == 0) {
+            XTtcPs_Stop(&xHwTimerTtc);
+        }
+    }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuHwTimerNow(void)
+{
+    return ulHwTimerNow;
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuHwTimerTakeOverruns(void)
+{
+    return __atomic_exchange_n(&ulHwTimerOverruns, 0, __ATOMIC_RELAXED);
+}
+
+/*-----------------------------------------------------------*/
+/* Set up the counter, its interrupt and the deferral task; the counter stays
+ * stopped until the first timer is armed */
+RPU_INIT_TEXT int xRpuHwTimerInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    XTtcPs_Config *cfg;
+    u64 interval;
+    int Status;
+    u32 i;
+
+    cfg = XTtcPs_LookupConfig(RPU_HWTIMER_TTC_BASEADDR);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+
+    Status = XTtcPs_CfgInitialize(&xHwTimerTtc, cfg, cfg->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        // Left running by a previous firmware instance
+        XTtcPs_Stop(&xHwTimerTtc);
+        Status = XTtcPs_CfgInitialize(&xHwTimerTtc, cfg, cfg->BaseAddress);
+    }
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    Status = XTtcPs_SetOptions(&xHwTimerTtc, XTTCPS_OPTION_INTERVAL_MODE | XTTCPS_OPTION_WAVE_DISABLE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    // Interval mode counts 0..interval, i.e. interval + 1 clocks per tick
+    interval = ((u64)cfg->InputClockHz * RPU_HWTIMER_TICK_US) / 1000000ULL;
+    if (interval < 2 || interval > XTTCPS_MAX_INTERVAL_COUNT) {
+        return XST_FAILURE;
+    }
+    XTtcPs_SetInterval(&xHwTimerTtc, (XInterval)(interval - 1));
+    XTtcPs_ClearInterruptStatus(&xHwTimerTtc, XTtcPs_GetInterruptStatus(&xHwTimerTtc));
+    XTtcPs_EnableInterrupts(&xHwTimerTtc, XTTCPS_IXR_INTERVAL_MASK);
+
+    for (i = 0; i < RPU_HWTIMER_SLOTS; i++) {
+        pxHwTimerSlots[i] = NULL;
+    }
+    ulHwTimerNow = 0;
+    ulHwTimerArmed = 0;
+    pxHwTimerPendHead = NULL;
+    pxHwTimerPendTail = NULL;
+    ulHwTimerOverruns = 0;
+
+    xHwTimerTask = xTaskCreateStatic( prvHwTimerTask,
+                                      ( const char * ) "HwTmr",
+                                      HWTIMER_TASK_STACK_SIZE,
+                                      NULL,
+                                      task_priority,
+                                      RPU_TASK_STACK_BUF(xHwTimerStack),
+                                      &xHwTimerTaskBuffer );
+
+    Status = XSetupInterruptSystem(&xHwTimerTtc, (Xil_ExceptionHandler)prvHwTimerHandler,
+                                   cfg->IntrId[0], cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId[0], cfg->IntrParent);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_HWTIMER */
@@ -0,0 +1,87 @@
+/*
+ * Hardware timer wheel (build option RPU_HWTIMER=1, UserConfig.cmake).
+ *
+ * FreeRTOS software timers run their callbacks in the timer service task,
+ * so an expiry waits for every higher-priority task and for the other
+ * daemon commands, and resolves only the 10 ms tick. This service instead
+ * multiplexes any number of timers on one TTC counter (RPU_CORE_TIMER_TTC,
+ * rpu_core.h) ticking every RPU_HWTIMER_TICK_US:
+ *
+ * - Hashed wheel of RPU_HWTIMER_SLOTS lists indexed by expiry tick: starting
+ *   and stopping a timer is O(1), and each tick only walks the timers of one
+ *   slot (those due, plus any a whole number of wheel turns later)
+ * - Callbacks run in the counter interrupt (RPU_INTR_TIMER_LEVEL, below the
+ *   API mask, so the FromISR API is allowed) unless the timer is set up
+ *   with RPU_HWTIMER_DEFER; those expiries go to a task of their own at the
+ *   priority given to xRpuHwTimerInit(), not to the timer daemon
+ * - Periodic timers are re-armed from their previous expiry, so the period
+ *   does not drift with handler latency
+ * - The counter only runs while a timer is armed, so an idle wheel costs no
+ *   interrupts in the power profile
+ *
+ * The timer objects belong to the caller (static allocation, as everywhere
+ * in this firmware). vRpuHwTimerStart()/Stop() may be called from tasks,
+ * from interrupt handlers below the API mask and from timer callbacks.
+ * Stopping a deferred timer does not cancel an expiry already handed to the
+ * task. A deferred expiry that finds the previous one still queued is
+ * counted (ulRpuHwTimerTakeOverruns()) instead of queued twice.
+ */
+
+#ifndef RPU_HWTIMER_H
+#define RPU_HWTIMER_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_HWTIMER
+#define RPU_HWTIMER 0
+#endif
+
+#define RPU_HWTIMER_TTC_BASEADDR  RPU_CORE_TIMER_TTC
+#define RPU_HWTIMER_TICK_US       1000
+#define RPU_HWTIMER_SLOTS         64     /* Must be a power of two */
+
+/* Wheel ticks from milliseconds (at least one tick) */
+#define RPU_HWTIMER_MS(ms) \
+    ((((u32)(ms) * 1000U) / RPU_HWTIMER_TICK_US) ? (((u32)(ms) * 1000U) / RPU_HWTIMER_TICK_US) : 1U)
+
+/* vRpuHwTimerSetup() flags */
+#define RPU_HWTIMER_DEFER         0x1    /* Run the callback in the timer task */
+
+typedef struct RpuHwTimer RpuHwTimer_t;
+typedef void (*RpuHwTimerCallback_t)(RpuHwTimer_t *timer, void *arg);
+
+struct RpuHwTimer {
+    RpuHwTimer_t *next;          /* Wheel slot list */
+    RpuHwTimer_t *prev;
+    RpuHwTimer_t *pend_next;     /* Deferred expiries */
+    u32 expiry;                  /* Wheel tick of the next expiry */
+    u32 period;                  /* Ticks, 0 = one shot */
+    u32 flags;
+    volatile u32 armed;
+    volatile u32 pending;
+    RpuHwTimerCallback_t callback;
+    void *arg;
+};
+
+#if RPU_HWTIMER
+int xRpuHwTimerInit(UBaseType_t task_priority, u16 intr_priority);
+void vRpuHwTimerSetup(RpuHwTimer_t *timer, RpuHwTimerCallback_t callback, void *arg, u32 flags);
+/* First expiry after delay ticks, then every period ticks (0 = one shot);
+ * restarting an armed timer re-arms it */
+void vRpuHwTimerStart(RpuHwTimer_t *timer, u32 delay, u32 period);
+void vRpuHwTimerStop(RpuHwTimer_t *timer);
+u32 ulRpuHwTimerNow(void);       /* Wheel ticks counted so far */
+u32 ulRpuHwTimerTakeOverruns(void);
+#else
+static inline int xRpuHwTimerInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    (void)task_priority;
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_HWTIMER */
+
+#endif /* RPU_HWTIMER_H */
@@ -0,0 +1,24 @@
+/*
+ * GIC interrupt priority plan (see rpu_intr.h).
+ */
+
+#include "rpu_intr.h"
+
+#include "xstatus.h"
+#include "xttcps.h"
+#include "xinterrupt_wrap.h"
+
+#include "rpu_core.h"
+
+/*-----------------------------------------------------------*/
+int xRpuIntrSetTickPriority(void)
+{
+    XTtcPs_Config *cfg = XTtcPs_LookupConfig(RPU_CORE_TICK_TTC);
+
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    XSetPriorityTriggerType(cfg->IntrId[0], RPU_INTR_PRIORITY(RPU_INTR_TICK_LEVEL),
+                            cfg->IntrParent);
+    return XST_SUCCESS;
+}
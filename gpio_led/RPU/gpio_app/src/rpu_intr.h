@@ -0,0 +1,125 @@
+/*
+ * GIC interrupt priority plan of the firmware.
+ *
+ * Levels are GIC priorities 0..31 (configUNIQUE_INTERRUPT_PRIORITIES), lower
+ * is more urgent; RPU_INTR_PRIORITY() shifts one into the register field.
+ * The port requires a binary point that makes all five bits preemption
+ * bits and FreeRTOS_IRQ_Handler re-enables IRQs around the handler, so every
+ * level preempts all the ones below it:
+ *
+ *   Level  Source                                  FreeRTOS API
+ *   16     Waveform sample (TTC)                   no, above the API mask
+ *   17     PC sampling (TTC, RPU_PC_PROF)          no, above the API mask
+ *   18     APU IPI (or its FIQ wake SGI),          yes
+ *          timed commands (stats TTC match),
+ *          inter-R5 doorbell SGI (RPU_XCORE),
+ *          PL interrupt_gen events (RPU_PL_INTR)
+ *   19     AXI GPIO inputs (RPU_GPIO_IN)           yes
+ *   20     Waveform / bulk / copy / CSU DMA / APM  yes
+ *   21     Timer wheel (TTC, RPU_HWTIMER)          yes
+ *   22     Sensor trigger (TTC) and I2C/SPI        yes
+ *          completion (RPU_SENSOR)
+ *   23     Sleep one-shot (TTC, RPU_SLEEP_YIELD)   yes
+ *   28     SYSMON temperature alarm (RPU_SYSMON)   yes
+ *   29     Console TX (RPU_UART_TX)                yes
+ *   30     FreeRTOS tick (TTC, BSP)                yes
+ *
+ * By default the UART is polled (xil_printf, RPU_LOG task at idle priority)
+ * and takes no interrupt; the buffered console of RPU_UART_TX=1 drains below
+ * everything but the tick, so logging never delays the others. Each level can be
+ * overridden with RPU_INTR_<source>_LEVEL in USER_COMPILE_DEFINITIONS
+ * (UserConfig.cmake); the checks below keep the FreeRTOS rules.
+ * With RPU_IPI_FIQ=1 the doorbell itself is at RPU_FIQ_PRIORITY (rpu_fiq.h).
+ * RPU_INTR_PL_LEVEL may go above the API mask, like the waveform sample, for
+ * PL reactions that must not wait for a critical section; the handler
+ * registered with vRpuPlIntrRegister() then must not call FreeRTOS.
+ */
+
+#ifndef RPU_INTR_H
+#define RPU_INTR_H
+
+#include "FreeRTOS.h"
+
+#define RPU_INTR_PRIORITY(level)  ((level) << portPRIORITY_SHIFT)
+// portLOWEST_USABLE_INTERRUPT_PRIORITY, usable in #if
+#define RPU_INTR_LOWEST_LEVEL     (configUNIQUE_INTERRUPT_PRIORITIES - 2)
+
+#ifndef RPU_INTR_WAVE_LEVEL
+#define RPU_INTR_WAVE_LEVEL  (configMAX_API_CALL_INTERRUPT_PRIORITY - 2)
+#endif
+#ifndef RPU_INTR_PCPROF_LEVEL
+#define RPU_INTR_PCPROF_LEVEL (configMAX_API_CALL_INTERRUPT_PRIORITY - 1)
+#endif
+#ifndef RPU_INTR_IPI_LEVEL
+#define RPU_INTR_IPI_LEVEL   configMAX_API_CALL_INTERRUPT_PRIORITY
+#endif
+#ifndef RPU_INTR_TIMED_LEVEL
+#define RPU_INTR_TIMED_LEVEL RPU_INTR_IPI_LEVEL
+#endif
+#ifndef RPU_INTR_XCORE_LEVEL
+#define RPU_INTR_XCORE_LEVEL RPU_INTR_IPI_LEVEL
+#endif
+#ifndef RPU_INTR_PL_LEVEL
+#define RPU_INTR_PL_LEVEL    RPU_INTR_IPI_LEVEL
+#endif
+#ifndef RPU_INTR_GPIO_LEVEL
+#define RPU_INTR_GPIO_LEVEL  (configMAX_API_CALL_INTERRUPT_PRIORITY + 1)
+#endif
+#ifndef RPU_INTR_DMA_LEVEL
+#define RPU_INTR_DMA_LEVEL   (configMAX_API_CALL_INTERRUPT_PRIORITY + 2)
+#endif
+#ifndef RPU_INTR_TIMER_LEVEL
+#define RPU_INTR_TIMER_LEVEL (configMAX_API_CALL_INTERRUPT_PRIORITY + 3)
+#endif
+#ifndef RPU_INTR_SENSOR_LEVEL
+#define RPU_INTR_SENSOR_LEVEL (configMAX_API_CALL_INTERRUPT_PRIORITY + 4)
+#endif
+#ifndef RPU_INTR_SLEEP_LEVEL
+#define RPU_INTR_SLEEP_LEVEL (configMAX_API_CALL_INTERRUPT_PRIORITY + 5)
+#endif
+#ifndef RPU_INTR_SYSMON_LEVEL
+#define RPU_INTR_SYSMON_LEVEL (RPU_INTR_LOWEST_LEVEL - 2)
+#endif
+#ifndef RPU_INTR_UART_LEVEL
+#define RPU_INTR_UART_LEVEL  (RPU_INTR_LOWEST_LEVEL - 1)
+#endif
+#ifndef RPU_INTR_TICK_LEVEL
+#define RPU_INTR_TICK_LEVEL  RPU_INTR_LOWEST_LEVEL
+#endif
+
+// Handlers that call the FreeRTOS API must be masked by critical sections
+#if (RPU_INTR_IPI_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_TIMED_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_XCORE_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_GPIO_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_DMA_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_TIMER_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_SENSOR_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_SLEEP_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_SYSMON_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_UART_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY) || \
+    (RPU_INTR_TICK_LEVEL < configMAX_API_CALL_INTERRUPT_PRIORITY)
+#error "RPU_INTR_IPI/TIMED/XCORE/GPIO/DMA/TIMER/SENSOR/SLEEP/SYSMON/UART/TICK_LEVEL must not be below configMAX_API_CALL_INTERRUPT_PRIORITY"
+#endif
+#if (RPU_INTR_WAVE_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_PCPROF_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_IPI_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_TIMED_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_XCORE_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_PL_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_GPIO_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_DMA_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_TIMER_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_SENSOR_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_SLEEP_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_SYSMON_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_UART_LEVEL > RPU_INTR_LOWEST_LEVEL) || \
+    (RPU_INTR_TICK_LEVEL > RPU_INTR_LOWEST_LEVEL)
+#error "RPU_INTR_*_LEVEL must not exceed the lowest usable level (portLOWEST_USABLE_INTERRUPT_PRIORITY)"
+#endif
+
+/* Move the tick interrupt to RPU_INTR_TICK_LEVEL; the port installs it at
+ * vTaskStartScheduler(), so call this from a task */
+int xRpuIntrSetTickPriority(void);
+
+#endif /* RPU_INTR_H */
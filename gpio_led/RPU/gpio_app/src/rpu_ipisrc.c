@@ -0,0 +1,64 @@
+/*
+ * IPI source demultiplexer (see rpu_ipisrc.h).
+ */
+
+#include <xil_io.h>
+#include "xstatus.h"
+
+#include "kr260_regs.h"
+#include "rpu_core.h"
+#include "rpu_ipisrc.h"
+#include "rpu_tcm.h"
+
+typedef struct {
+    RpuIpiSrcHandler_t handler;
+    void *arg;
+} RpuIpiSrc_t;
+
+static RpuIpiSrc_t xIpiSrc[32] RPU_BTCM_BSS;
+static u32 ulIpiSrcMask RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+int xRpuIpiSrcRegister(u32 srcs, RpuIpiSrcHandler_t handler, void *arg)
+{
+    u32 bits = srcs;
+
+    if (handler == NULL || srcs == 0 || (srcs & ulIpiSrcMask) != 0) {
+        return XST_INVALID_PARAM;
+    }
+    while (bits != 0) {
+        u32 n = (u32)__builtin_ctz(bits);
+
+        bits &= bits - 1;
+        xIpiSrc[n].handler = handler;
+        xIpiSrc[n].arg = arg;
+    }
+    ulIpiSrcMask |= srcs;
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuIpiSrcMask(void)
+{
+    return ulIpiSrcMask;
+}
+
+/*-----------------------------------------------------------*/
+/* RBIT + CLZ per set bit; a source that rings again while its handler runs
+ * is taken by the next interrupt */
+RPU_ATCM_TEXT u32 ulRpuIpiSrcDispatch(u32 isr, BaseType_t *pxWoken)
+{
+    u32 claimed = isr & ulIpiSrcMask;
+    u32 bits = claimed;
+
+    if (isr & ~ulIpiSrcMask) {
+        Xil_Out32(IPI_CH_BASE + IPI_ISR_OFFSET, isr & ~ulIpiSrcMask);
+    }
+    while (bits != 0) {
+        u32 n = (u32)__builtin_ctz(bits);
+
+        bits &= bits - 1;
+        xIpiSrc[n].handler(1U << n, xIpiSrc[n].arg, pxWoken);
+    }
+    return claimed;
+}
@@ -0,0 +1,45 @@
+/*
+ * IPI source demultiplexer: a handler per source bit of this core's IPI
+ * channel.
+ *
+ * Each source agent of the Zynq UltraScale+ IPI (APU bit 0, RPU0 bit 8,
+ * RPU1 bit 9, PMU bits 16-19, PL bits 24-27) latches its own ISR bit.
+ * ulRpuIpiSrcDispatch(), called by IPI_Handler, walks the set bits of ISR
+ * that have a handler with CTZ, lowest first, so an interrupt costs one call
+ * per pending source and no source hides another. A handler either clears
+ * its bit or masks it (IDR) and leaves the clear to whoever serves it.
+ * Only the pending bits without a handler are cleared, never the whole
+ * register, so a doorbell latched meanwhile stays; they show in the
+ * RPU_TRACE_IPI_RX event.
+ *
+ * Handlers are registered before the doorbell is enabled (main()); the
+ * enable mask of the channel is ulRpuIpiSrcMask().
+ */
+
+#ifndef RPU_IPISRC_H
+#define RPU_IPISRC_H
+
+#include "xil_types.h"
+#include "FreeRTOS.h"
+
+// Source bits of IPI channels Ch0 (APU), Ch1 (RPU0), Ch2 (RPU1), PMU, PL
+#define RPU_IPI_SRC_APU        0x00000001U
+#define RPU_IPI_SRC_RPU0       0x00000100U
+#define RPU_IPI_SRC_RPU1       0x00000200U
+#define RPU_IPI_SRC_PMU(n)     (0x00010000U << (n))   /* n = 0..3 */
+#define RPU_IPI_SRC_PL(n)      (0x01000000U << (n))   /* n = 0..3 */
+
+/* In the IPI interrupt: src is the single bit served; *pxWoken as for the
+ * FreeRTOS FromISR API */
+typedef void (*RpuIpiSrcHandler_t)(u32 src, void *arg, BaseType_t *pxWoken);
+
+/* One handler for each bit of srcs; XST_INVALID_PARAM for a bit that has one */
+int xRpuIpiSrcRegister(u32 srcs, RpuIpiSrcHandler_t handler, void *arg);
+/* Bits with a handler, for IER/IDR */
+u32 ulRpuIpiSrcMask(void);
+/* Serve the bits of isr: handlers for the registered ones, the others are
+ * cleared; returns the bits that had a handler. No FreeRTOS calls of its
+ * own */
+u32 ulRpuIpiSrcDispatch(u32 isr, BaseType_t *pxWoken);
+
+#endif /* RPU_IPISRC_H */
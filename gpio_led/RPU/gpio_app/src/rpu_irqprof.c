@@ -0,0 +1,178 @@
+/*
+ * Interrupt-to-acknowledgment profile of the IPI path (see rpu_irqprof.h,
+ * rpu_shm.h).
+ *
+ * The statistics are kept in BTCM and the stages a pass touched are copied
+ * into the OCM block under the seq word, so the APU never sees a
+ * half-updated stage. 64-bit sums do not wrap in practice: at 533 MHz even
+ * one-second samples would take centuries.
+ */
+
+#include "rpu_irqprof.h"
+
+#if RPU_IRQ_PROF
+
+#include <string.h>
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xreg_cortexr5.h"
+#include "xpseudo_asm.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_seqlock.h"
+#include "rpu_tcm.h"
+
+#define IRQPROF_PMCR_ENABLE    (1U << 0)   // PMCR.E: counters enabled
+#define IRQPROF_PMCR_CCNT_DIV  (1U << 3)   // PMCR.D: count every 64 cycles
+#define IRQPROF_CCNT_ENABLE    (1U << 31)  // PMCNTENSET.C
+
+volatile u32 ulRpuIrqProfStamp[RPU_IRQPROF_MARKS] RPU_BTCM_BSS;
+volatile u32 ulRpuIrqProfIsrMask RPU_BTCM_BSS;
+u32 ulRpuIrqProfTaskMask RPU_BTCM_BSS;
+
+static struct rpu_irqprof_stage xIrqProfStage[IRQPROF_STAGES] RPU_BTCM_BSS;
+static u64 ullIrqProfSum[IRQPROF_STAGES] RPU_BTCM_BSS;
+static u32 ulIrqProfPasses RPU_BTCM_BSS;
+static u32 ulIrqProfSeq RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+static u32 prvIrqProfBucket(u32 cycles)
+{
+    u32 bits = 32 - __builtin_clz(cycles | 1);
+
+    if (bits <= IRQPROF_BUCKET_SHIFT) {
+        return 0;
+    }
+    bits -= IRQPROF_BUCKET_SHIFT;
+    return bits < IRQPROF_BUCKETS ? bits : IRQPROF_BUCKETS - 1;
+}
+
+/*-----------------------------------------------------------*/
+/* Copy a stage and the histogram buckets [first, last] into the block */
+static void prvIrqProfWriteStage(u32 idx, u32 first, u32 last)
+{
+    const struct rpu_irqprof_stage *stage = &xIrqProfStage[idx];
+    UINTPTR base = RPU_IRQPROF_BASE + IRQPROF_STAGE(idx);
+    u32 i;
+
+    Xil_Out32(base + 0x00, stage->count);
+    Xil_Out32(base + 0x04, stage->min);
+    Xil_Out32(base + 0x08, stage->max);
+    Xil_Out32(base + 0x0C, stage->last);
+    Xil_Out32(base + 0x10, (u32)ullIrqProfSum[idx]);
+    Xil_Out32(base + 0x14, (u32)(ullIrqProfSum[idx] >> 32));
+    for (i = first; i <= last; i++) {
+        Xil_Out32(base + IRQPROF_STAGE_HIST + i * 4, stage->hist[i]);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Clear the statistics here and in the block */
+static void prvIrqProfClear(void)
+{
+    u32 i;
+
+    memset(xIrqProfStage, 0, sizeof(xIrqProfStage));
+    memset(ullIrqProfSum, 0, sizeof(ullIrqProfSum));
+    ulIrqProfPasses = 0;
+
+    vRpuSeqBegin(RPU_IRQPROF_BASE + IRQPROF_SEQ_OFFSET, &ulIrqProfSeq);
+    for (i = 0; i < IRQPROF_STAGES; i++) {
+        xIrqProfStage[i].min = 0xFFFFFFFF;
+        prvIrqProfWriteStage(i, 0, IRQPROF_BUCKETS - 1);
+    }
+    Xil_Out32(RPU_IRQPROF_BASE + IRQPROF_PASSES_OFFSET, 0);
+    vRpuSeqEnd(RPU_IRQPROF_BASE + IRQPROF_SEQ_OFFSET, &ulIrqProfSeq);
+}
+
+/*-----------------------------------------------------------*/
+/* Run the cycle counter at the CPU clock and announce the block; it is not
+ * reset, so the boot stamps (rpu_boot.h) stay valid */
+RPU_INIT_TEXT void vRpuIrqProfInit(void)
+{
+    u32 pmcr;
+
+    Xil_SetTlbAttributes(RPU_IRQPROF_BASE, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+
+    pmcr = mfcp(XREG_CP15_PERF_MONITOR_CTRL);
+    pmcr &= ~IRQPROF_PMCR_CCNT_DIV;
+    mtcp(XREG_CP15_PERF_MONITOR_CTRL, pmcr | IRQPROF_PMCR_ENABLE);
+    mtcp(XREG_CP15_COUNT_ENABLE_SET, IRQPROF_CCNT_ENABLE);
+    isb();
+
+    Xil_Out32(RPU_IRQPROF_BASE + IRQPROF_MAGIC_OFFSET, 0);
+    ulIrqProfSeq = ulRpuSeqInit(RPU_IRQPROF_BASE + IRQPROF_SEQ_OFFSET);
+    Xil_Out32(RPU_IRQPROF_BASE + IRQPROF_HZ_OFFSET, XPAR_CPU_CORE_CLOCK_FREQ_HZ);
+    Xil_Out32(RPU_IRQPROF_BASE + IRQPROF_RESET_OFFSET, 0);
+    prvIrqProfClear();
+    __sync_synchronize();
+    Xil_Out32(RPU_IRQPROF_BASE + IRQPROF_MAGIC_OFFSET, IRQPROF_MAGIC);
+}
+
+/*-----------------------------------------------------------*/
+/* End of an IPI task pass: account its marks (IPI task context) */
+void vRpuIrqProfCommit(void)
+{
+    u32 stamp[RPU_IRQPROF_MARKS];
+    u32 task_mask = ulRpuIrqProfTaskMask;
+    u32 mask;
+    u32 i;
+
+    stamp[RPU_IRQPROF_DONE] = ulRpuIrqProfCycles();
+    ulRpuIrqProfTaskMask = 0;
+
+    // Take the handler marks unless a doorbell after the task started
+    // left them: they time the next pass
+    taskENTER_CRITICAL();
+    mask = ulRpuIrqProfIsrMask;
+    for (i = 0; i < RPU_IRQPROF_DONE; i++) {
+        stamp[i] = ulRpuIrqProfStamp[i];
+    }
+    if (mask != 0 && (task_mask & (1U << RPU_IRQPROF_TASK)) != 0 &&
+        (s32)(stamp[RPU_IRQPROF_TASK] - stamp[RPU_IRQPROF_ENTRY]) < 0) {
+        mask = 0;
+    } else {
+        ulRpuIrqProfIsrMask = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    if (Xil_In32(RPU_IRQPROF_BASE + IRQPROF_RESET_OFFSET) != 0) {
+        prvIrqProfClear();
+        Xil_Out32(RPU_IRQPROF_BASE + IRQPROF_RESET_OFFSET, 0);
+    }
+    // Passes without a doorbell (legacy poll timer) have no entry
+    if (mask == 0) {
+        return;
+    }
+    mask |= task_mask | (1U << RPU_IRQPROF_DONE);
+    ulIrqProfPasses++;
+
+    vRpuSeqBegin(RPU_IRQPROF_BASE + IRQPROF_SEQ_OFFSET, &ulIrqProfSeq);
+    for (i = 0; i < IRQPROF_STAGES; i++) {
+        struct rpu_irqprof_stage *stage = &xIrqProfStage[i];
+        u32 cycles;
+        u32 bucket;
+
+        if ((mask & (1U << (i + 1))) == 0) {
+            continue;
+        }
+        cycles = stamp[i + 1] - stamp[RPU_IRQPROF_ENTRY];
+        stage->count++;
+        stage->last = cycles;
+        if (cycles < stage->min) {
+            stage->min = cycles;
+        }
+        if (cycles > stage->max) {
+            stage->max = cycles;
+        }
+        ullIrqProfSum[i] += cycles;
+        bucket = prvIrqProfBucket(cycles);
+        stage->hist[bucket]++;
+        prvIrqProfWriteStage(i, bucket, bucket);
+    }
+    Xil_Out32(RPU_IRQPROF_BASE + IRQPROF_PASSES_OFFSET, ulIrqProfPasses);
+    vRpuSeqEnd(RPU_IRQPROF_BASE + IRQPROF_SEQ_OFFSET, &ulIrqProfSeq);
+}
+
+#endif /* RPU_IRQ_PROF */
@@ -0,0 +1,81 @@
+/*
+ * Interrupt-to-acknowledgment profile of the IPI path (build option
+ * RPU_IRQ_PROF=1, UserConfig.cmake).
+ *
+ * Timestamps come from the R5 PMU cycle counter (Xpm_ReadCycleCounterVal(),
+ * xpm_counter.h), a single coprocessor read at the CPU clock:
+ *
+ *   IPI_Handler  vRpuIrqProfIsr(entry)   entry (read first thing) and exit
+ *   prvIpiTask   vRpuIrqProfMark()       task running, first ACK written
+ *                vRpuIrqProfCommit()     end of the pass
+ *
+ * The commit turns the marks of a pass into the IRQPROF_STAGE_* deltas from
+ * the handler entry and adds them to the core's profile block in OCM
+ * (rpu_shm.h); apu_app/rpu_stats --irq prints it. Handler marks that come
+ * after the task started belong to the next pass and are kept for it.
+ * The cycle counter stops in WFI, so a pass must not span an idle sleep:
+ * the IPI task is woken straight from the handler, which is the case.
+ *
+ * Without RPU_IRQ_PROF every call is an empty inline function.
+ */
+
+#ifndef RPU_IRQPROF_H
+#define RPU_IRQPROF_H
+
+#include "xil_types.h"
+#include "rpu_core.h"
+
+#ifndef RPU_IRQ_PROF
+#define RPU_IRQ_PROF 0
+#endif
+
+// Marks of one pass
+#define RPU_IRQPROF_ENTRY       0
+#define RPU_IRQPROF_ISR_EXIT    (IRQPROF_STAGE_ISR_EXIT + 1)
+#define RPU_IRQPROF_TASK        (IRQPROF_STAGE_TASK + 1)
+#define RPU_IRQPROF_ACK         (IRQPROF_STAGE_ACK + 1)
+#define RPU_IRQPROF_DONE        (IRQPROF_STAGE_DONE + 1)
+#define RPU_IRQPROF_MARKS       (IRQPROF_STAGES + 1)
+
+#if RPU_IRQ_PROF
+#include "xpm_counter.h"
+
+extern volatile u32 ulRpuIrqProfStamp[RPU_IRQPROF_MARKS];
+extern volatile u32 ulRpuIrqProfIsrMask;   /* Written by IPI_Handler */
+extern u32 ulRpuIrqProfTaskMask;           /* Written by the IPI task */
+
+void vRpuIrqProfInit(void);
+void vRpuIrqProfCommit(void);
+
+static inline u32 ulRpuIrqProfCycles(void)
+{
+    return Xpm_ReadCycleCounterVal();
+}
+
+/* Handler entry and exit; the first interrupt of a pass wins */
+static inline void vRpuIrqProfIsr(u32 entry)
+{
+    if (ulRpuIrqProfIsrMask == 0) {
+        ulRpuIrqProfStamp[RPU_IRQPROF_ENTRY] = entry;
+        ulRpuIrqProfStamp[RPU_IRQPROF_ISR_EXIT] = ulRpuIrqProfCycles();
+        ulRpuIrqProfIsrMask = (1U << RPU_IRQPROF_ENTRY) | (1U << RPU_IRQPROF_ISR_EXIT);
+    }
+}
+
+/* A task-side mark; the first of the pass wins */
+static inline void vRpuIrqProfMark(u32 mark)
+{
+    if ((ulRpuIrqProfTaskMask & (1U << mark)) == 0) {
+        ulRpuIrqProfStamp[mark] = ulRpuIrqProfCycles();
+        ulRpuIrqProfTaskMask |= 1U << mark;
+    }
+}
+#else
+static inline void vRpuIrqProfInit(void) {}
+static inline void vRpuIrqProfCommit(void) {}
+static inline u32 ulRpuIrqProfCycles(void) { return 0; }
+static inline void vRpuIrqProfIsr(u32 entry) { (void)entry; }
+static inline void vRpuIrqProfMark(u32 mark) { (void)mark; }
+#endif /* RPU_IRQ_PROF */
+
+#endif /* RPU_IRQPROF_H */
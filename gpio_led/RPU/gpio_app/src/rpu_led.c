@@ -0,0 +1,161 @@
+/*
+ * LED output backend of the Rx task (see rpu_led.h).
+ *
+ * The PS GPIO path keeps the address and the mask half of its MASK_DATA word
+ * in BTCM, so a write is one OR and one store. The write timing enables the
+ * cycle counter without resetting it: RPU_IRQ_PROF may use it as well, and
+ * only deltas are taken here.
+ *
+ * With RPU_LED_BANKS=1 the backend only sets the LED pins up and hands their
+ * store to the bank table (rpu_bank.c) as its first entry.
+ */
+
+#include "rpu_led.h"
+
+#include <xil_io.h>
+#include "xstatus.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexr5.h"
+#include "xpm_counter.h"
+#if RPU_LED_PS_GPIO
+#include "xgpiops.h"
+#endif
+
+#include "rpu_boot.h"
+#include "rpu_log.h"
+#include "rpu_tcm.h"
+
+#define LED_PMCR_ENABLE         (1U << 0)   // PMCR.E: counters enabled
+#define LED_PMCR_CCNT_DIV       (1U << 3)   // PMCR.D: count every 64 cycles
+#define LED_CCNT_ENABLE         (1U << 31)  // PMCNTENSET.C
+
+#if RPU_LED_BANKS && RPU_LED_PS_GPIO
+#define LED_BACKEND             "PS GPIO banks"
+#elif RPU_LED_BANKS
+#define LED_BACKEND             "AXI GPIO banks"
+#elif RPU_LED_PS_GPIO
+#define LED_BACKEND             "PS GPIO"
+#else
+#define LED_BACKEND             "AXI GPIO"
+#endif
+
+#if RPU_LED_PS_GPIO
+#define LED_FIELD               ((1U << RPU_LED_WIDTH) - 1)
+#define LED_HALF_SHIFT          (RPU_LED_PS_SHIFT % 16)
+/* MASK_DATA_LSW for pins 0-15 of the bank, MASK_DATA_MSW for 16-31 */
+#define LED_MASK_DATA_OFFSET    (RPU_LED_PS_BANK * XGPIOPS_DATA_MASK_OFFSET + \
+                                 (RPU_LED_PS_SHIFT / 16) * 4)
+
+static XGpioPs xGpioPs RPU_BTCM_NOINIT;
+static UINTPTR xLedMaskData RPU_BTCM_BSS;
+static u32 ulLedMask RPU_BTCM_BSS;         /* Upper half: 0 for the LED pins */
+#else
+static XGpio *pxLedGpio RPU_BTCM_BSS;
+#endif /* RPU_LED_PS_GPIO */
+
+#if RPU_EDGE_STATS
+static u32 ulLedMin RPU_BTCM_BSS;
+static u32 ulLedMax RPU_BTCM_BSS;
+static u32 ulLedSum RPU_BTCM_BSS;
+static u32 ulLedCount RPU_BTCM_BSS;        /* Writes in the log window */
+#endif /* RPU_EDGE_STATS */
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuLedInit(XGpio *gpio)
+{
+#if RPU_LED_PS_GPIO
+    XGpioPs_Config *cfg;
+    u32 pins = LED_FIELD << RPU_LED_PS_SHIFT;
+
+    (void)gpio;
+    cfg = XGpioPs_LookupConfig(XPAR_XGPIOPS_0_BASEADDR);
+    if (cfg == NULL || XGpioPs_CfgInitialize(&xGpioPs, cfg, cfg->BaseAddr) != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    xLedMaskData = cfg->BaseAddr + XGPIOPS_DATA_LSW_OFFSET + LED_MASK_DATA_OFFSET;
+    ulLedMask = (~(LED_FIELD << LED_HALF_SHIFT) & 0xFFFFU) << 16;
+
+    // LEDs off before the pins are driven
+    Xil_Out32(xLedMaskData, ulLedMask);
+    XGpioPs_SetDirection(&xGpioPs, RPU_LED_PS_BANK,
+                         XGpioPs_GetDirection(&xGpioPs, RPU_LED_PS_BANK) | pins);
+    XGpioPs_SetOutputEnable(&xGpioPs, RPU_LED_PS_BANK,
+                            XGpioPs_GetOutputEnable(&xGpioPs, RPU_LED_PS_BANK) | pins);
+#else
+    pxLedGpio = gpio;
+#endif /* RPU_LED_PS_GPIO */
+
+#if RPU_LED_BANKS
+    // The LED store is bank 0 of the table
+#if RPU_LED_PS_GPIO
+    if (xRpuBankInit(gpio, xLedMaskData, ulLedMask, LED_HALF_SHIFT) != XST_SUCCESS) {
+#else
+    if (xRpuBankInit(gpio, gpio->BaseAddress + XGPIO_DATA_OFFSET, 0, 0) != XST_SUCCESS) {
+#endif /* RPU_LED_PS_GPIO */
+        return XST_FAILURE;
+    }
+#endif /* RPU_LED_BANKS */
+
+#if RPU_EDGE_STATS
+    {
+        u32 pmcr = mfcp(XREG_CP15_PERF_MONITOR_CTRL);
+
+        mtcp(XREG_CP15_PERF_MONITOR_CTRL, (pmcr & ~LED_PMCR_CCNT_DIV) | LED_PMCR_ENABLE);
+        mtcp(XREG_CP15_COUNT_ENABLE_SET, LED_CCNT_ENABLE);
+    }
+#endif /* RPU_EDGE_STATS */
+
+    RPU_BOOT_PRINT("LED output: %s\r\n", LED_BACKEND);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuLedWrite(u32 value)
+{
+    vRpuLedWriteFrame(value, NULL);
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuLedWriteFrame(u32 value, const RpuBankFrame_t *bits)
+{
+#if RPU_EDGE_STATS
+    u32 start = Xpm_ReadCycleCounterVal();
+    u32 cycles;
+#endif
+
+#if RPU_LED_BANKS
+    RpuBankFrame_t frame;
+
+    if (bits == NULL) {
+        vRpuBankFill(&frame, value);
+        bits = &frame;
+    }
+    (void)ulRpuBankWrite(bits);
+#elif RPU_LED_PS_GPIO
+    (void)bits;
+    Xil_Out32(xLedMaskData, ulLedMask | ((value & LED_FIELD) << LED_HALF_SHIFT));
+#else
+    (void)bits;
+    XGpio_DiscreteWrite(pxLedGpio, 1, value);
+#endif /* RPU_LED_BANKS */
+
+#if RPU_EDGE_STATS
+    dsb();
+    cycles = Xpm_ReadCycleCounterVal() - start;
+
+    if (ulLedCount == 0 || cycles < ulLedMin) {
+        ulLedMin = cycles;
+    }
+    if (ulLedCount == 0 || cycles > ulLedMax) {
+        ulLedMax = cycles;
+    }
+    ulLedSum += cycles;
+    if (++ulLedCount == RPU_EDGE_LOG_EDGES) {
+        RPU_LOG("LED write (" LED_BACKEND "): min %u, max %u, mean %u cycles\r\n",
+                (unsigned)ulLedMin, (unsigned)ulLedMax, (unsigned)(ulLedSum / ulLedCount));
+        ulLedSum = 0;
+        ulLedCount = 0;
+    }
+#endif /* RPU_EDGE_STATS */
+}
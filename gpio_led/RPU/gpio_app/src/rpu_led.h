@@ -0,0 +1,68 @@
+/*
+ * LED output backend of the Rx task (build option RPU_LED_PS_GPIO=1,
+ * UserConfig.cmake).
+ *
+ * By default the LED values go to channel 1 of the PL AXI GPIO, a store that
+ * crosses the LPD to PL AXI interconnect. With RPU_LED_PS_GPIO=1 they go to
+ * the PS GPIO controller instead (BSP xgpiops driver, in the LPD): the
+ * RPU_LED_WIDTH pins from bit RPU_LED_PS_SHIFT of bank RPU_LED_PS_BANK are
+ * written through that bank's MASK_DATA_LSW or MASK_DATA_MSW register, whose
+ * upper half masks the lower, so one store updates just the LED pins without
+ * a read-modify-write. The field must not straddle the two halves. Banks 0-2
+ * are MIO pins, 3-5 EMIO (the default is EMIO GPIO 0, pin 78): the PL design
+ * must route those EMIO pins to the LEDs, the current one drives them from
+ * the AXI GPIO. The waveform engine and the channel 2 inputs stay on the AXI
+ * GPIO with either backend.
+ *
+ * With RPU_EDGE_STATS=1 each write is timed with the PMU cycle counter, from
+ * before the store to the end of a DSB (the strongly ordered store has then
+ * been acknowledged by the GPIO), and every RPU_EDGE_LOG_EDGES writes the
+ * minimum, maximum and mean cycles are logged next to the edge summary, so
+ * builds with either backend can be compared.
+ *
+ * With RPU_LED_BANKS=1 the LEDs become the first bank of the multi-bank
+ * engine (rpu_bank.h): vRpuLedWriteFrame() stores every bank whose channels
+ * changed, and the timing covers the whole pass.
+ */
+
+#ifndef RPU_LED_H
+#define RPU_LED_H
+
+#include "xil_types.h"
+#include "xgpio.h"
+#include "rpu_edge.h"
+
+#ifndef RPU_LED_PS_GPIO
+#define RPU_LED_PS_GPIO 0
+#endif
+
+#ifndef RPU_LED_WIDTH
+#define RPU_LED_WIDTH           XPAR_XGPIO_0_GPIO_WIDTH
+#endif
+#ifndef RPU_LED_PS_BANK
+#define RPU_LED_PS_BANK         3       // EMIO pins 78..109
+#endif
+#ifndef RPU_LED_PS_SHIFT
+#define RPU_LED_PS_SHIFT        0       // First LED pin within the bank
+#endif
+
+#if RPU_LED_PS_GPIO
+#if RPU_LED_PS_BANK > 5
+#error "RPU_LED_PS_BANK must be 0..5"
+#endif
+#if RPU_LED_WIDTH < 1 || (RPU_LED_PS_SHIFT % 16) + RPU_LED_WIDTH > 16
+#error "The PS GPIO LED pins must sit in one 16-bit half of the bank"
+#endif
+#endif /* RPU_LED_PS_GPIO */
+
+#include "rpu_bank.h"
+
+/* Set up the backend; gpio is the AXI GPIO, channel 1 already an output */
+int xRpuLedInit(XGpio *gpio);
+/* Write the low RPU_LED_WIDTH bits of value to the LEDs (Rx task only) */
+void vRpuLedWrite(u32 value);
+/* Write a frame (Rx task only): with RPU_LED_BANKS=1 every channel of bits,
+ * or value on every group if bits is NULL; otherwise value to the LEDs */
+void vRpuLedWriteFrame(u32 value, const RpuBankFrame_t *bits);
+
+#endif /* RPU_LED_H */
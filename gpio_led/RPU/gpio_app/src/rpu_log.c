@@ -0,0 +1,205 @@
+/*
+ * Deferred logging for the RPU firmware (see rpu_log.h).
+ *
+ * Ring protocol: producers reserve a slot by advancing ulLogHead with a
+ * compare-and-swap, fill the record and then publish it by storing the
+ * slot's sequence number (index + 1). The drain task consumes slots in
+ * order while their sequence number matches, so a record that is still
+ * being written by an interrupted producer is never printed half-filled.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+/* Xilinx includes. */
+#include "xil_printf.h"
+
+#include "rpu_dcc.h"
+#include "rpu_exec.h"
+#include "rpu_log.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+#include "rpu_uart.h"
+
+#define RPU_LOG_MASK           (RPU_LOG_SLOTS - 1)
+#define RPU_LOG_IDLE_DELAY_MS  10
+
+typedef struct {
+    volatile u32 seq;          /* Index + 1 once the record is complete */
+    const char *fmt;
+    u32 args[RPU_LOG_MAX_ARGS];
+} RpuLogRecord_t;
+
+static RpuLogRecord_t xLogRing[RPU_LOG_SLOTS];
+static volatile u32 ulLogHead;     /* Next slot to reserve (producers) */
+static volatile u32 ulLogTail;     /* Next slot to print (drain task) */
+static volatile u32 ulLogDropped;  /* Records lost to a full ring */
+#if !RPU_EXEC
+static StaticTask_t xLogTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xLogStack, configMINIMAL_STACK_SIZE) RPU_BTCM_NOINIT;
+
+static void prvLogTask( void *pvParameters );
+#endif /* !RPU_EXEC */
+
+/*-----------------------------------------------------------*/
+/* Create the drain task. Records written before the scheduler starts are
+ * kept and printed once it runs; the executive build polls instead
+ * (vRpuLogPoll()).
+ */
+RPU_INIT_TEXT void vRpuLogInit(void)
+{
+#if !RPU_EXEC
+	xTaskCreateStatic( prvLogTask,
+				 ( const char * ) "Log",
+				 configMINIMAL_STACK_SIZE,
+				 NULL,
+				 tskIDLE_PRIORITY,
+				 RPU_TASK_STACK_BUF(xLogStack),
+				 &xLogTaskBuffer );
+#endif /* !RPU_EXEC */
+}
+
+/*-----------------------------------------------------------*/
+/* Queue one record; a few tens of cycles, never blocks */
+void vRpuLogWrite(const char *fmt, u32 a0, u32 a1, u32 a2, u32 a3)
+{
+    u32 head = __atomic_load_n(&ulLogHead, __ATOMIC_RELAXED);
+    RpuLogRecord_t *rec;
+
+    do {
+        if ((u32)(head - __atomic_load_n(&ulLogTail, __ATOMIC_ACQUIRE)) >= RPU_LOG_SLOTS) {
+            __atomic_fetch_add(&ulLogDropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&ulLogHead, &head, head + 1, 1,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    rec = &xLogRing[head & RPU_LOG_MASK];
+    rec->fmt = fmt;
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+    rec->args[3] = a3;
+    __atomic_store_n(&rec->seq, head + 1, __ATOMIC_RELEASE);
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuLogPending(void)
+{
+    return __atomic_load_n(&ulLogHead, __ATOMIC_RELAXED) -
+           __atomic_load_n(&ulLogTail, __ATOMIC_RELAXED);
+}
+
+#if RPU_LOG_DCC
+/*-----------------------------------------------------------*/
+/* Nothing queued: forward the trace and report losses (rpu_dcc.h) */
+static void prvLogIdle(void)
+{
+    u32 words[2];
+
+    vRpuDccForwardTrace();
+    words[0] = __atomic_exchange_n(&ulLogDropped, 0, __ATOMIC_RELAXED);
+    words[1] = ulRpuDccTakeTraceLost();
+    if (words[0] != 0 || words[1] != 0) {
+        (void)xRpuDccSendFrame(RPU_DCC_DROPPED, words, 2);
+    }
+}
+
+/* The record as a frame; the host formats it */
+static void prvLogEmit(const RpuLogRecord_t *rec)
+{
+    u32 words[1 + RPU_LOG_MAX_ARGS];
+    u32 i;
+
+    words[0] = (u32)(UINTPTR)rec->fmt;
+    for (i = 0; i < RPU_LOG_MAX_ARGS; i++) {
+        words[1 + i] = rec->args[i];
+    }
+    (void)xRpuDccSendFrame(RPU_DCC_LOG, words, 1 + RPU_LOG_MAX_ARGS);
+}
+
+static BaseType_t prvLogRoom(void)
+{
+    return pdTRUE;
+}
+#else
+/*-----------------------------------------------------------*/
+/* Nothing queued: report losses on the console */
+static void prvLogIdle(void)
+{
+    u32 dropped = __atomic_exchange_n(&ulLogDropped, 0, __ATOMIC_RELAXED);
+    if (dropped != 0) {
+        xil_printf("[log] %d message(s) dropped\r\n", dropped);
+    }
+    dropped = ulRpuUartTxTakeDropped();
+    if (dropped != 0) {
+        xil_printf("[log] %d console character(s) dropped\r\n", dropped);
+    }
+}
+
+static void prvLogEmit(const RpuLogRecord_t *rec)
+{
+    xil_printf(rec->fmt, rec->args[0], rec->args[1], rec->args[2], rec->args[3]);
+}
+
+// With the buffered console (rpu_uart.h) wait for room rather than drop
+static BaseType_t prvLogRoom(void)
+{
+    return ulRpuUartTxFree() >= RPU_UART_TX_LINE_MAX ? pdTRUE : pdFALSE;
+}
+#endif /* RPU_LOG_DCC */
+
+/*-----------------------------------------------------------*/
+/* Print the next record: 1 if one went out, 0 if none is queued, -1 while
+ * the console has no room for it */
+static int prvLogStep(void)
+{
+    u32 tail = __atomic_load_n(&ulLogTail, __ATOMIC_RELAXED);
+    RpuLogRecord_t *rec = &xLogRing[tail & RPU_LOG_MASK];
+
+    if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != tail + 1) {
+        prvLogIdle();
+        return 0;
+    }
+    if (!prvLogRoom()) {
+        return -1;
+    }
+    prvLogEmit(rec);
+
+    // Release the slot only after the record has been printed
+    __atomic_store_n(&ulLogTail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+#if RPU_EXEC
+/*-----------------------------------------------------------*/
+/* One record per call, from a slot of the executive (rpu_exec.h) */
+void vRpuLogPoll(void)
+{
+    (void)prvLogStep();
+}
+#else
+/*-----------------------------------------------------------*/
+/* The Log Task:
+ * - Formats queued records to the UART at idle priority, or sends them over
+ *   the DCC with RPU_LOG_DCC=1.
+ */
+static void prvLogTask( void *pvParameters )
+{
+	(void)pvParameters;
+
+	for( ;; )
+	{
+        switch (prvLogStep()) {
+            case 0:
+                vTaskDelay( pdMS_TO_TICKS( RPU_LOG_IDLE_DELAY_MS ) );
+                break;
+            case -1:
+                vTaskDelay( 1 );
+                break;
+            default:
+                break;
+        }
+	}
+}
+#endif /* RPU_EXEC */
@@ -0,0 +1,42 @@
+/*
+ * Deferred logging for the RPU firmware.
+ *
+ * xil_printf() formats and busy-writes every character to the UART, which
+ * stalls the caller for milliseconds at 115200 baud. RPU_LOG() instead stores
+ * a binary record (format string pointer + up to four 32-bit arguments) in a
+ * lock-free ring and returns. An idle-priority task formats pending records
+ * with xil_printf() when the CPU has nothing else to do. With RPU_UART_TX=1
+ * (rpu_uart.h) the characters then go to an interrupt-drained ring, so the
+ * task no longer waits for the UART either. With RPU_LOG_DCC=1 (rpu_dcc.h)
+ * the task sends the records unformatted over the debug channel instead.
+ *
+ * - Safe from tasks and interrupt handlers (multi-producer, one consumer)
+ * - The format string and any %s argument must stay valid (string literals)
+ * - Arguments are passed as u32; 64-bit and floating point values are not
+ *   supported
+ * - When the ring is full new records are dropped and counted; the drain
+ *   task reports the count once space is available again
+ */
+
+#ifndef RPU_LOG_H
+#define RPU_LOG_H
+
+#include "xil_types.h"
+
+#define RPU_LOG_SLOTS          64  /* Must be a power of two */
+#define RPU_LOG_MAX_ARGS       4
+
+/* Log a message with up to RPU_LOG_MAX_ARGS integer arguments */
+#define RPU_LOG(fmt, ...) \
+    RPU_LOG_(fmt, ##__VA_ARGS__, 0, 0, 0, 0)
+#define RPU_LOG_(fmt, a0, a1, a2, a3, ...) \
+    vRpuLogWrite(fmt, (u32)(a0), (u32)(a1), (u32)(a2), (u32)(a3))
+
+void vRpuLogInit(void);
+void vRpuLogWrite(const char *fmt, u32 a0, u32 a1, u32 a2, u32 a3);
+/* Records queued and not printed yet (telemetry, rpu_telem.h) */
+u32 ulRpuLogPending(void);
+/* Print one queued record (RPU_EXEC=1 builds, which have no log task) */
+void vRpuLogPoll(void);
+
+#endif /* RPU_LOG_H */
@@ -0,0 +1,317 @@
+/*
+ * Memory hierarchy benchmark (see rpu_membench.h, rpu_shm.h).
+ *
+ * The tests of an entry run back to back on the range as the MPU region
+ * maps it; the region is given the next memory type only between entries,
+ * through the BSP, which cleans and invalidates the whole data cache first.
+ * The cycle counter is enabled without a reset, as in rpu_bench.c; only
+ * deltas are taken, and a timed test stays well below the 32-bit wrap even
+ * on strongly ordered DDR.
+ *
+ * The chase order is the full-period LCG of MEMBENCH_CHASE_NEXT(): it visits
+ * every line of a power-of-two range once per lap in a scattered order, and
+ * each line's link is computed from its own index, so the chain is written
+ * in one pass without a permutation table. It is rebuilt for every entry,
+ * since the sweeps overwrite it.
+ */
+
+#include "rpu_membench.h"
+
+#if RPU_MEMBENCH
+
+#include <xil_io.h>
+#include "xil_cache.h"
+#include "xil_mpu.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexr5.h"
+#include "xpm_counter.h"
+#include "task.h"
+
+#include "rpu_log.h"
+#include "rpu_seqlock.h"
+#include "rpu_shm.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+
+#define MEMB_PMCR_ENABLE       (1U << 0)   // PMCR.E: counters enabled
+#define MEMB_PMCR_CCNT_DIV     (1U << 3)   // PMCR.D: count every 64 cycles
+#define MEMB_CCNT_ENABLE       (1U << 31)  // PMCNTENSET.C
+#define MEMB_PL_SPAN           0x1000      // MPU region over the AXI GPIO registers
+#define MEMB_TASK_STACK_SIZE   configMINIMAL_STACK_SIZE
+
+struct memb_range {
+    u32 region;            /* MEMBENCH_REGION_* */
+    UINTPTR base;
+    u32 bytes;             /* Power of two; 0: single-word tests only */
+    u32 attrs;             /* Bits of the MEMBENCH_ATTR_* to run, 0 = no MPU region (TCM) */
+};
+
+#define MEMB_ALL_ATTRS         ((1U << MEMBENCH_ATTR_CACHED) | (1U << MEMBENCH_ATTR_NCACHE) | \
+                                (1U << MEMBENCH_ATTR_STRONG))
+
+static u64 ullMembTcm[MEMBENCH_TCM_SIZE / 8] RPU_BTCM_NOINIT;
+
+static const struct memb_range xMembRange[] = {
+    { MEMBENCH_REGION_TCM, (UINTPTR)ullMembTcm, MEMBENCH_TCM_SIZE, 0 },
+    { MEMBENCH_REGION_OCM, MEMBENCH_OCM_ADDR, MEMBENCH_OCM_SIZE, MEMB_ALL_ATTRS },
+    { MEMBENCH_REGION_DDR, MEMBENCH_DDR_ADDR, MEMBENCH_DDR_SIZE, MEMB_ALL_ATTRS },
+    { MEMBENCH_REGION_PL, MEMBENCH_PL_ADDR, 0, 1U << MEMBENCH_ATTR_STRONG },
+};
+#define MEMB_RANGES            (sizeof(xMembRange) / sizeof(xMembRange[0]))
+
+/* Indexed by MEMBENCH_REGION_* and MEMBENCH_ATTR_* */
+static const char * const pcMembRegion[] = { "tcm", "ocm", "ddr", "pl" };
+static const char * const pcMembAttr[] = { "cached", "ncache", "strong" };
+static const u32 ulMembMpuAttr[] = {
+    NORM_NSHARED_WB_WA | PRIV_RW_USER_RW | EXECUTE_NEVER,
+    NORM_SHARED_NCACHE | PRIV_RW_USER_RW | EXECUTE_NEVER,
+    STRONG_ORDERD_SHARED | PRIV_RW_USER_RW | EXECUTE_NEVER,
+};
+
+static struct rpu_membench_entry xMembEntry[MEMBENCH_MAX_ENTRIES] RPU_BTCM_BSS;
+static u32 ulMembSeq;
+
+static StaticTask_t xMembTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xMembStack, MEMB_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+
+static inline u32 ulMembCycles(void)
+{
+    return Xpm_ReadCycleCounterVal();
+}
+
+/*-----------------------------------------------------------*/
+/* Lines of a cached range leave the cache before a timed test */
+static void prvMembClean(const struct memb_range *r, u32 attr)
+{
+    if (r->attrs && attr == MEMBENCH_ATTR_CACHED) {
+        Xil_DCacheFlushRange(r->base, r->bytes);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Map the range with one memory type through the benchmark's MPU region */
+static int prvMembMap(const struct memb_range *r, u32 attr)
+{
+    u32 span = r->bytes ? r->bytes : MEMB_PL_SPAN;
+
+    (void)Xil_DisableMPURegionByRegNum(RPU_MEMBENCH_REGION);
+    return (int)Xil_SetMPURegionByRegNum(RPU_MEMBENCH_REGION, r->base, span, ulMembMpuAttr[attr]);
+}
+
+/*-----------------------------------------------------------*/
+/* Dependent loads through every line: the time to use of a load */
+static void prvMembChase(const struct memb_range *r, u32 attr, struct rpu_membench_entry *e)
+{
+    u32 lines = r->bytes / RPU_MEMBENCH_STRIDE;
+    u32 i, start, end;
+    UINTPTR p;
+
+    for (i = 0; i < lines; i++) {
+        Xil_Out32(r->base + i * RPU_MEMBENCH_STRIDE,
+                  (u32)(r->base + MEMBENCH_CHASE_NEXT(i, lines) * RPU_MEMBENCH_STRIDE));
+    }
+    prvMembClean(r, attr);
+
+    p = r->base;
+    taskENTER_CRITICAL();
+    start = ulMembCycles();
+    for (i = 0; i < lines; i++) {
+        p = *(volatile u32 *)p;
+    }
+    end = ulMembCycles();
+    taskEXIT_CRITICAL();
+
+    // The lap ends where it started, which keeps the loads from being dropped
+    configASSERT(p == r->base);
+    e->chase_loads = lines;
+    e->chase_cycles = end - start;
+}
+
+/*-----------------------------------------------------------*/
+/* 64-bit load and store sweeps, four accesses per iteration */
+static void prvMembSweep(const struct memb_range *r, u32 attr, struct rpu_membench_entry *e)
+{
+    volatile u64 *p = (volatile u64 *)r->base;
+    u32 n = r->bytes / 8;
+    u64 sum = 0;
+    u32 i, start, end;
+
+    prvMembClean(r, attr);
+    taskENTER_CRITICAL();
+    start = ulMembCycles();
+    for (i = 0; i < n; i += 4) {
+        sum += p[i] ^ p[i + 1] ^ p[i + 2] ^ p[i + 3];
+    }
+    end = ulMembCycles();
+    taskEXIT_CRITICAL();
+    e->rd_cycles = end - start;
+
+    prvMembClean(r, attr);
+    taskENTER_CRITICAL();
+    start = ulMembCycles();
+    for (i = 0; i < n; i += 4) {
+        p[i] = sum;
+        p[i + 1] = sum;
+        p[i + 2] = sum;
+        p[i + 3] = sum;
+    }
+    // Written back: the clean is part of a cached write
+    prvMembClean(r, attr);
+    end = ulMembCycles();
+    taskEXIT_CRITICAL();
+    e->wr_cycles = end - start;
+    e->sweep_bytes = r->bytes;
+}
+
+/*-----------------------------------------------------------*/
+/* One word read, then written back unchanged: safe on the GPIO as well */
+static void prvMembWord(const struct memb_range *r, struct rpu_membench_entry *e)
+{
+    u32 v = 0;
+    u32 i, start, end;
+
+    taskENTER_CRITICAL();
+    start = ulMembCycles();
+    for (i = 0; i < RPU_MEMBENCH_WORD_OPS; i++) {
+        v |= Xil_In32(r->base);
+    }
+    end = ulMembCycles();
+    e->word_rd_cycles = end - start;
+
+    v = Xil_In32(r->base);
+    start = ulMembCycles();
+    for (i = 0; i < RPU_MEMBENCH_WORD_OPS; i++) {
+        Xil_Out32(r->base, v);
+    }
+    dsb();
+    end = ulMembCycles();
+    taskEXIT_CRITICAL();
+    e->word_wr_cycles = end - start;
+    e->word_ops = RPU_MEMBENCH_WORD_OPS;
+}
+
+/*-----------------------------------------------------------*/
+static void prvMembLog(const struct rpu_membench_entry *e)
+{
+    const u64 hz = XPAR_CPU_CORE_CLOCK_FREQ_HZ;
+
+    if (e->chase_loads) {
+        RPU_LOG("  %s %s: chase %u ns, rd %u MB/s, wr %u MB/s, word rd %u wr %u cycles\r\n",
+                pcMembRegion[e->region], pcMembAttr[e->attr],
+                (unsigned)((u64)e->chase_cycles * 1000000000ULL / hz / e->chase_loads),
+                (unsigned)(e->rd_cycles ? (u64)e->sweep_bytes * hz / e->rd_cycles / 1000000 : 0),
+                (unsigned)(e->wr_cycles ? (u64)e->sweep_bytes * hz / e->wr_cycles / 1000000 : 0),
+                (unsigned)(e->word_rd_cycles / e->word_ops),
+                (unsigned)(e->word_wr_cycles / e->word_ops));
+    } else {
+        RPU_LOG("  %s %s: word rd %u wr %u cycles\r\n",
+                pcMembRegion[e->region], pcMembAttr[e->attr],
+                (unsigned)(e->word_rd_cycles / e->word_ops),
+                (unsigned)(e->word_wr_cycles / e->word_ops));
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Every range under every memory type, then the entries under the seq word */
+static void prvMembPass(void)
+{
+    u32 count = 0;
+    u32 i, a, w;
+
+    vRpuSeqBegin(MEMBENCH_ADDR + MEMBENCH_SEQ_OFFSET, &ulMembSeq);
+
+    for (i = 0; i < MEMB_RANGES; i++) {
+        const struct memb_range *r = &xMembRange[i];
+
+        for (a = 0; a <= MEMBENCH_ATTR_STRONG; a++) {
+            struct rpu_membench_entry *e = &xMembEntry[count];
+
+            if (r->attrs ? !(r->attrs & (1U << a)) : a != MEMBENCH_ATTR_NCACHE) {
+                continue;
+            }
+            if (r->attrs && prvMembMap(r, a) != XST_SUCCESS) {
+                RPU_LOG("Membench: MPU region %u taken, %s skipped\r\n",
+                        (unsigned)RPU_MEMBENCH_REGION, pcMembRegion[r->region]);
+                break;
+            }
+            *e = (struct rpu_membench_entry){ .region = r->region, .attr = a, .bytes = r->bytes };
+            if (r->bytes) {
+                prvMembChase(r, a, e);
+                prvMembSweep(r, a, e);
+            }
+            prvMembWord(r, e);
+            prvMembLog(e);
+            count++;
+        }
+    }
+    (void)Xil_DisableMPURegionByRegNum(RPU_MEMBENCH_REGION);
+
+    for (i = 0; i < count; i++) {
+        const u32 *src = (const u32 *)&xMembEntry[i];
+
+        for (w = 0; w < MEMBENCH_ENTRY_SIZE / 4; w++) {
+            Xil_Out32(MEMBENCH_ADDR + MEMBENCH_ENTRY(i) + w * 4, src[w]);
+        }
+    }
+    Xil_Out32(MEMBENCH_ADDR + MEMBENCH_COUNT_OFFSET, count);
+    vRpuSeqEnd(MEMBENCH_ADDR + MEMBENCH_SEQ_OFFSET, &ulMembSeq);
+}
+
+/*-----------------------------------------------------------*/
+/* A pass at start, then one for every new generation the APU writes */
+static void prvMembTask(void *pvParameters)
+{
+    u32 done = ~Xil_In32(MEMBENCH_ADDR + MEMBENCH_GEN_OFFSET);
+    u32 gen;
+
+    (void)pvParameters;
+    for (;;) {
+        gen = Xil_In32(MEMBENCH_ADDR + MEMBENCH_GEN_OFFSET);
+        if (gen != done) {
+            RPU_LOG("Membench pass %u, cycles at %u Hz\r\n", (unsigned)gen,
+                    (unsigned)XPAR_CPU_CORE_CLOCK_FREQ_HZ);
+            prvMembPass();
+            done = gen;
+            Xil_Out32(MEMBENCH_ADDR + MEMBENCH_DONE_OFFSET, done);
+        }
+        vTaskDelay(pdMS_TO_TICKS(RPU_MEMBENCH_POLL_MS));
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Start the cycle counter, announce the block and create the task */
+RPU_INIT_TEXT int xRpuMemBenchInit(UBaseType_t priority)
+{
+    u32 pmcr;
+
+    pmcr = mfcp(XREG_CP15_PERF_MONITOR_CTRL);
+    mtcp(XREG_CP15_PERF_MONITOR_CTRL, (pmcr & ~MEMB_PMCR_CCNT_DIV) | MEMB_PMCR_ENABLE);
+    mtcp(XREG_CP15_COUNT_ENABLE_SET, MEMB_CCNT_ENABLE);
+    isb();
+
+    Xil_SetTlbAttributes(MEMBENCH_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(MEMBENCH_ADDR + MEMBENCH_MAGIC_OFFSET, 0);
+    ulMembSeq = ulRpuSeqInit(MEMBENCH_ADDR + MEMBENCH_SEQ_OFFSET);
+    Xil_Out32(MEMBENCH_ADDR + MEMBENCH_HZ_OFFSET, XPAR_CPU_CORE_CLOCK_FREQ_HZ);
+    Xil_Out32(MEMBENCH_ADDR + MEMBENCH_COUNT_OFFSET, 0);
+    Xil_Out32(MEMBENCH_ADDR + MEMBENCH_TCM_OFFSET, (u32)RPU_TCM_GLOBAL(ullMembTcm));
+    // The boot pass answers no request: DONE moves only once it is written
+    Xil_Out32(MEMBENCH_ADDR + MEMBENCH_DONE_OFFSET,
+              ~Xil_In32(MEMBENCH_ADDR + MEMBENCH_GEN_OFFSET));
+    __sync_synchronize();
+    Xil_Out32(MEMBENCH_ADDR + MEMBENCH_MAGIC_OFFSET, MEMBENCH_MAGIC);
+
+    (void)xTaskCreateStatic( prvMembTask,
+                             ( const char * ) "MemBench",
+                             MEMB_TASK_STACK_SIZE,
+                             NULL,
+                             priority,
+                             RPU_TASK_STACK_BUF(xMembStack),
+                             &xMembTaskBuffer );
+
+    xil_printf("Memory benchmark: a pass at start and per request, results at 0x%08x\r\n",
+               (unsigned)MEMBENCH_ADDR);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_MEMBENCH */
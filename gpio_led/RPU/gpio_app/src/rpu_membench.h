@@ -0,0 +1,70 @@
+/*
+ * Memory hierarchy benchmark (build option RPU_MEMBENCH=1, UserConfig.cmake;
+ * RPU0 firmware only).
+ *
+ * Like RPU_BENCH, the benchmark build runs its task instead of the LED
+ * application. A pass measures every region the firmware places data in,
+ * under every MPU memory type the R5 can give it (MEMBENCH_ATTR_*):
+ *
+ *   tcm   a BTCM scratch buffer (MEMBENCH_TCM_SIZE; no memory type)
+ *   ocm   MEMBENCH_OCM_ADDR, cached, normal non-cacheable, strongly ordered
+ *   ddr   MEMBENCH_DDR_ADDR (the RPU0 bulk carveout), the same three
+ *   pl    the AXI GPIO DATA register, strongly ordered, single words only
+ *
+ * and for each of them takes, with the PMU cycle counter and interrupts
+ * masked:
+ *
+ *   chase  one lap of dependent loads through a random cyclic permutation of
+ *          the range's cache lines (load-to-use latency, no prefetch helps)
+ *   rd/wr  a 64-bit load and a 64-bit store sweep of the range (bandwidth)
+ *   word   RPU_MEMBENCH_WORD_OPS reads, then as many writes, of one word
+ *
+ * A cached range is cleaned and invalidated before each test, so chase and
+ * sweeps are line fills from the memory, not hits; the write sweep includes
+ * the clean that writes it back. The word test of a cached range is the hit.
+ * One MPU region, RPU_MEMBENCH_REGION, is reprogrammed over the range for
+ * each memory type and disabled after the pass.
+ *
+ * The results go to the MEMBENCH block in OCM (rpu_shm.h) and to the log. A
+ * pass runs at boot and again when the APU writes a new MEMBENCH_GEN, which
+ * is how apu_app/mem_bench runs its own measurements of the same ranges from
+ * the A53 first and then collects both tables.
+ */
+
+#ifndef RPU_MEMBENCH_H
+#define RPU_MEMBENCH_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_MEMBENCH
+#define RPU_MEMBENCH 0
+#endif
+
+#define RPU_MEMBENCH_STRIDE     32    // R5 cache line: one chase load per line
+#define RPU_MEMBENCH_WORD_OPS   1000
+#define RPU_MEMBENCH_POLL_MS    100   // MEMBENCH_GEN check between passes
+#define RPU_MEMBENCH_REGION     14U   // Below the stack guard's region
+
+#if RPU_MEMBENCH
+#if RPU_CORE != 0
+#error "RPU_MEMBENCH is for the RPU0 firmware: there is one benchmark block"
+#endif
+#if defined(RPU_BENCH) && RPU_BENCH
+#error "RPU_MEMBENCH and RPU_BENCH are separate benchmark builds"
+#endif
+
+/* Start the cycle counter, announce the block and create the benchmark task;
+ * called before the scheduler starts */
+int xRpuMemBenchInit(UBaseType_t priority);
+#else
+static inline int xRpuMemBenchInit(UBaseType_t priority)
+{
+    (void)priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_MEMBENCH */
+
+#endif /* RPU_MEMBENCH_H */
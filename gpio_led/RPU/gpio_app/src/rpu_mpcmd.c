@@ -0,0 +1,116 @@
+/*
+ * Multi-producer command channel (see rpu_mpcmd.h).
+ *
+ * The block is mapped Normal non-cacheable, so the R5's LDREX/STREX of a
+ * claim reach the OCM exclusive monitor rather than the local one only.
+ */
+
+#include "xil_io.h"
+#include "xil_mmu.h"
+#include "xreg_cortexr5.h"
+
+#include "rpu_mpcmd.h"
+#include "rpu_mpcmd_queue.h"
+#include "rpu_tcm.h"
+#include "rpu_trace.h"
+
+#if RPU_MPCMD
+
+#define MPCMD_BASE              ((volatile void *)MPCMD_ADDR)
+
+#if RPU_CORE == 0
+static u32 ulMpCmdTail;
+
+/*-----------------------------------------------------------*/
+/* Format the block: every slot free for its first position */
+RPU_INIT_TEXT int xRpuMpCmdInit(void)
+{
+    u32 i;
+
+    Xil_SetTlbAttributes(MPCMD_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+
+    Xil_Out32(MPCMD_ADDR + MPCMD_MAGIC_OFFSET, 0);
+    __sync_synchronize();
+    Xil_Out32(MPCMD_ADDR + MPCMD_SLOTS_OFFSET, MPCMD_SLOTS);
+    Xil_Out32(MPCMD_ADDR + MPCMD_HEAD_OFFSET, 0);
+    Xil_Out32(MPCMD_ADDR + MPCMD_TAIL_OFFSET, 0);
+    Xil_Out32(MPCMD_ADDR + MPCMD_STATE_OFFSET, SHM_RING_STATE_IDLE);
+    for (i = 0; i < MPCMD_SLOTS; i++) {
+        Xil_Out32(MPCMD_ADDR + MPCMD_ENTRY(i) + MPCMD_ENT_SEQ, i);
+        Xil_Out32(MPCMD_ADDR + MPCMD_DONE_WORD(i), 0);
+    }
+    ulMpCmdTail = 0;
+    __sync_synchronize();
+    Xil_Out32(MPCMD_ADDR + MPCMD_MAGIC_OFFSET, MPCMD_MAGIC);
+    __sync_synchronize();
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* IPI task: run the published commands in position order, at most a queue
+ * full per pass; returns the number consumed */
+u32 ulRpuMpCmdDrain(RpuMpCmdExec_t exec)
+{
+    u32 opcode, arg, source;
+    u32 count = 0;
+
+    while (count < MPCMD_SLOTS &&
+           rpu_mpcmd_peek(MPCMD_BASE, ulMpCmdTail, &opcode, &arg, &source)) {
+        u32 status = exec(opcode, arg);
+
+        vRpuTrace(RPU_TRACE_MPCMD, source, opcode | (status << 16));
+        ulMpCmdTail = rpu_mpcmd_complete(MPCMD_BASE, ulMpCmdTail, status);
+        count++;
+    }
+    return count;
+}
+
+/*-----------------------------------------------------------*/
+BaseType_t xRpuMpCmdPending(void)
+{
+    return Xil_In32(MPCMD_ADDR + MPCMD_ENTRY(ulMpCmdTail) + MPCMD_ENT_SEQ) == ulMpCmdTail + 1
+        ? pdTRUE : pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+void vRpuMpCmdSetState(u32 state)
+{
+    Xil_Out32(MPCMD_ADDR + MPCMD_STATE_OFFSET, state);
+}
+
+#else /* RPU_CORE != 0 */
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuMpCmdInit(void)
+{
+    Xil_SetTlbAttributes(MPCMD_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuMpCmdPost(u32 opcode, u32 arg, u32 *pos)
+{
+    int ret;
+
+    if (Xil_In32(MPCMD_ADDR + MPCMD_MAGIC_OFFSET) != MPCMD_MAGIC) {
+        return XST_FAILURE;
+    }
+    ret = rpu_mpcmd_post(MPCMD_BASE, opcode, arg, MPCMD_SOURCE_RPU1, pos);
+    if (ret != RPU_MPCMD_OK) {
+        return XST_DEVICE_BUSY;
+    }
+    if (rpu_mpcmd_need_doorbell(MPCMD_BASE)) {
+        Xil_Out32(IPI_CH_BASE, RPU_MPCMD_IPI_RPU0);   // Trigger register
+    }
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuMpCmdStatus(u32 pos)
+{
+    return rpu_mpcmd_status(MPCMD_BASE, pos);
+}
+
+#endif /* RPU_CORE */
+
+#endif /* RPU_MPCMD */
@@ -0,0 +1,73 @@
+/*
+ * Multi-producer command channel (build option RPU_MPCMD=1, UserConfig.cmake).
+ *
+ * RPU0 serves RPU_CMD_* commands that any number of APU processes and the
+ * RPU1 firmware queue in a block of OCM at MPCMD_ADDR (protocol in
+ * rpu_shm.h, queue operations in common/rpu_mpcmd_queue.h): producers claim
+ * a slot with one compare-and-swap, so they never funnel through a single
+ * process or hold a lock while they copy.
+ *
+ * On RPU0, xRpuMpCmdInit() formats the block and the IPI task drains it on
+ * every pass with ulRpuMpCmdDrain(), under the same doorbell moderation as
+ * the command ring. On RPU1 it only maps the block; xRpuMpCmdPost() queues a
+ * command and rings RPU0 through the RPU1 IPI channel, which RPU0 accepts as
+ * a doorbell source (RPU_MPCMD_IPI_RPU1) besides the APU.
+ */
+
+#ifndef RPU_MPCMD_H
+#define RPU_MPCMD_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_MPCMD
+#define RPU_MPCMD 0
+#endif
+
+#define RPU_MPCMD_IPI_RPU0      0x100  /* IPI channel 1 (RPU0) as a target */
+#define RPU_MPCMD_IPI_RPU1      0x200  /* IPI channel 2 (RPU1) as a source */
+
+/* Runs one command for the consumer; returns its RPU_CMD_STATUS_* */
+typedef u32 (*RpuMpCmdExec_t)(u32 opcode, u32 arg);
+
+#if RPU_MPCMD
+int xRpuMpCmdInit(void);
+#if RPU_CORE == 0
+u32 ulRpuMpCmdDrain(RpuMpCmdExec_t exec);
+BaseType_t xRpuMpCmdPending(void);
+void vRpuMpCmdSetState(u32 state);
+#else
+/* XST_SUCCESS with the position in *pos, XST_DEVICE_BUSY when the queue is
+ * full or contended, XST_FAILURE while RPU0 does not serve it */
+int xRpuMpCmdPost(u32 opcode, u32 arg, u32 *pos);
+/* RPU_CMD_STATUS_* of a posted command, PENDING until RPU0 consumed it */
+u32 ulRpuMpCmdStatus(u32 pos);
+#endif /* RPU_CORE */
+#else
+static inline int xRpuMpCmdInit(void)
+{
+    return XST_SUCCESS;
+}
+#endif /* RPU_MPCMD */
+
+#if !RPU_MPCMD || RPU_CORE != 0
+static inline u32 ulRpuMpCmdDrain(RpuMpCmdExec_t exec)
+{
+    (void)exec;
+    return 0;
+}
+
+static inline BaseType_t xRpuMpCmdPending(void)
+{
+    return pdFALSE;
+}
+
+static inline void vRpuMpCmdSetState(u32 state)
+{
+    (void)state;
+}
+#endif
+
+#endif /* RPU_MPCMD_H */
@@ -0,0 +1,184 @@
+/*
+ * LED pattern interpreter (see rpu_pattern.h, common/rpu_pattern_prog.h).
+ */
+
+#include <string.h>
+
+#include <xil_io.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_core.h"
+#include "rpu_log.h"
+#include "rpu_pattern.h"
+#include "rpu_tcm.h"
+
+typedef struct {
+    u32 insn[RPU_PAT_MAX_WORDS];
+    u32 count;
+} RpuPattern_t;
+
+static RpuPattern_t xPatternBuf[2] RPU_BTCM_BSS;
+static u16 usLoopLeft[RPU_PAT_MAX_WORDS] RPU_BTCM_BSS;  /* Per LOOP, 0 = not entered */
+static volatile u32 ulPatternPending RPU_BTCM_BSS;      /* Buffer + 1 to switch to, 0 = none */
+static volatile u32 ulPatternRun RPU_BTCM_BSS;          /* Buffer + 1 running, 0 = none */
+static volatile u32 ulPatternLast RPU_BTCM_BSS;         /* Buffer the Tx task switched to last */
+static u32 ulPatternPc RPU_BTCM_BSS;
+static u32 ulPatternLed RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* Operands in range, loops backwards, waits of at least one tick */
+static u32 prvPatternCheck(const RpuPattern_t *p)
+{
+    u32 i;
+
+    for (i = 0; i < p->count; i++) {
+        u32 insn = p->insn[i];
+        u32 arg = RPU_PAT_OPERAND(insn);
+
+        switch (RPU_PAT_OP(insn)) {
+            case RPU_PAT_END:
+                break;
+            case RPU_PAT_SET:
+            case RPU_PAT_TOGGLE:
+            case RPU_PAT_RAND:
+                if (arg > RPU_PAT_VALUE_MASK) {
+                    return RPU_CMD_STATUS_BADARG;
+                }
+                break;
+            case RPU_PAT_WAIT:
+                if (arg > RPU_PAT_MAX_WAIT_MS || pdMS_TO_TICKS(arg) == 0) {
+                    return RPU_CMD_STATUS_BADARG;
+                }
+                break;
+            case RPU_PAT_LOOP:
+                if (RPU_PAT_LOOP_PC(insn) > i) {
+                    return RPU_CMD_STATUS_BADARG;
+                }
+                break;
+            default:
+                return RPU_CMD_STATUS_BADARG;
+        }
+    }
+    return RPU_CMD_STATUS_OK;
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuPatternLoad(void)
+{
+    u32 count = Xil_In32(RPU_SHM_BASE + SHM_WAVE_COUNT_OFFSET);
+    RpuPattern_t *p;
+    u32 buf, status, i;
+
+    if (count == 0 || count > RPU_PAT_MAX_WORDS) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+
+    // Not the buffer the Tx task may be in the middle of, even after a stop;
+    // a pending program that was never switched to is simply replaced
+    taskENTER_CRITICAL();
+    buf = 1 - ulPatternLast;
+    ulPatternPending = 0;
+    taskEXIT_CRITICAL();
+
+    p = &xPatternBuf[buf];
+    for (i = 0; i < count; i++) {
+        p->insn[i] = Xil_In32(RPU_SHM_BASE + SHM_WAVE_SAMPLE_OFFSET + i * 4);
+    }
+    p->count = count;
+
+    status = prvPatternCheck(p);
+    if (status == RPU_CMD_STATUS_OK) {
+        ulPatternPending = buf + 1;
+    }
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+/* No critical section, so that prvSetMode() can call it from the FIQ handler:
+ * a stop that comes in the middle of the Tx task's switch may be lost, but
+ * every caller also takes the blink mode off BLINK_PATTERN, after which the
+ * Tx task no longer runs the program
+ */
+RPU_ATCM_TEXT void vRpuPatternStop(void)
+{
+    ulPatternPending = 0;
+    ulPatternRun = 0;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuPatternActive(void)
+{
+    return ulPatternPending != 0 || ulPatternRun != 0;
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuPatternStep(void)
+{
+    return ulPatternPc;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuPatternNext(RpuRand_t *rng, u32 *led, u32 *hold_ms)
+{
+    const RpuPattern_t *p;
+    u32 steps, next;
+
+    taskENTER_CRITICAL();
+    next = ulPatternPending;
+    if (next != 0) {
+        ulPatternRun = next;
+        ulPatternLast = next - 1;
+        ulPatternPending = 0;
+        ulPatternPc = 0;
+        memset(usLoopLeft, 0, sizeof(usLoopLeft));
+    }
+    p = (ulPatternRun != 0) ? &xPatternBuf[ulPatternRun - 1] : NULL;
+    taskEXIT_CRITICAL();
+
+    for (steps = 0; p != NULL && steps < RPU_PATTERN_STEP_LIMIT; steps++) {
+        u32 insn = (ulPatternPc < p->count) ? p->insn[ulPatternPc] : RPU_PAT_INSN(RPU_PAT_END, 0);
+        u32 arg = RPU_PAT_OPERAND(insn);
+
+        ulPatternPc++;
+        switch (RPU_PAT_OP(insn)) {
+            case RPU_PAT_SET:
+                ulPatternLed = arg;
+                break;
+            case RPU_PAT_TOGGLE:
+                ulPatternLed ^= arg;
+                break;
+            case RPU_PAT_RAND:
+                ulPatternLed = ulRpuRandNext(rng) & arg;
+                break;
+            case RPU_PAT_WAIT:
+                *led = ulPatternLed;
+                *hold_ms = arg;
+                return 1;
+            case RPU_PAT_LOOP: {
+                u16 *left = &usLoopLeft[ulPatternPc - 1];
+                u32 n = RPU_PAT_LOOP_COUNT(insn);
+
+                if (n == 0) {
+                    ulPatternPc = RPU_PAT_LOOP_PC(insn);
+                    break;
+                }
+                if (*left == 0) {
+                    *left = (u16)n;
+                }
+                if (--*left != 0) {
+                    ulPatternPc = RPU_PAT_LOOP_PC(insn);
+                }
+                break;
+            }
+            default:  // END
+                ulPatternRun = 0;
+                return 0;
+        }
+    }
+    if (p != NULL) {
+        RPU_LOG("Pattern stopped: %u instructions without a WAIT\r\n", RPU_PATTERN_STEP_LIMIT);
+        ulPatternRun = 0;
+    }
+    return 0;
+}
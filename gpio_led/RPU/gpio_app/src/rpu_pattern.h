@@ -0,0 +1,34 @@
+/*
+ * LED pattern interpreter (common/rpu_pattern_prog.h).
+ *
+ * ulRpuPatternLoad() validates the program the APU staged in the waveform
+ * area of the shared window and copies it into the buffer the blink task is
+ * not running; the Tx task switches to it at its next frame and then calls
+ * xRpuPatternNext() for each frame, which runs the program up to its next
+ * WAIT. Loading runs in the IPI task, which has the higher priority, so it
+ * can only come between two instructions of the Tx task: it always writes
+ * the buffer the Tx task did not switch to last, and only the switch needs
+ * a critical section.
+ */
+
+#ifndef RPU_PATTERN_H
+#define RPU_PATTERN_H
+
+#include "xil_types.h"
+#include "rpu_pattern_prog.h"
+#include "rpu_rand.h"
+
+/* Copy and validate the staged program; RPU_CMD_STATUS_* for the descriptor */
+u32 ulRpuPatternLoad(void);
+/* End the program at its next frame; safe in the FIQ handler */
+void vRpuPatternStop(void);
+/* A program is loaded and has not ended */
+int xRpuPatternActive(void);
+/* Program counter of the running program, for the status block */
+u32 ulRpuPatternStep(void);
+/* Run to the next WAIT: LED value and hold time of the frame it closes, RAND
+ * values from rng. 0 once the program ended (END, stop or runaway), *led
+ * then untouched */
+int xRpuPatternNext(RpuRand_t *rng, u32 *led, u32 *hold_ms);
+
+#endif /* RPU_PATTERN_H */
@@ -0,0 +1,209 @@
+/*
+ * Statistical PC-sampling profiler (see rpu_pcprof.h, rpu_shm.h).
+ *
+ * FreeRTOS_IRQ_Handler (portASM.S) pushes the return address and the SPSR
+ * on the IRQ stack, then runs the handler in SVC mode: [SP_irq] is the SPSR
+ * and [SP_irq + 4] the interrupted PC. An interrupt that nests into the
+ * sampler pops its own frame before the sampler resumes, so the top frame is
+ * always the sampler's. The bins are counted straight in OCM; at the default
+ * rate the read-modify-write costs well under 0.1% of the CPU.
+ */
+
+#include "rpu_pcprof.h"
+
+#if RPU_PC_PROF
+
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xttcps.h"
+#include "xinterrupt_wrap.h"
+
+#include "rpu_seqlock.h"
+#include "rpu_tcm.h"
+
+#define PCPROF_MIN_SHIFT        2     // One bin per instruction
+#define PCPROF_MODE_MASK        0x1F  // CPSR.M
+#define PCPROF_MODE_USR         0x10
+#define PCPROF_MODE_SYS         0x1F  // Tasks run in System mode
+
+// Linker script symbols (lscript.ld)
+extern char __atcm_text_end[];
+extern char __text_start[];
+extern char __text_end[];
+
+struct pcprof_range {
+    u32 low;
+    u32 span;      // Bytes covered, bins << shift
+    u32 first;     // Offset of the first bin in the block
+};
+
+// Everything the sampler touches is in TCM (rpu_tcm.h)
+static XTtcPs xPcProfTtc RPU_BTCM_BSS;
+static struct pcprof_range xPcProfRange[PCPROF_RANGES] RPU_BTCM_BSS;
+static u32 ulPcProfShift RPU_BTCM_BSS;
+static u32 ulPcProfSamples RPU_BTCM_BSS;
+static u32 ulPcProfOutside RPU_BTCM_BSS;
+static u32 ulPcProfHandler RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* Frame of the current interrupt on the IRQ stack: switch to IRQ mode with
+ * interrupts off just to read the banked SP, then restore mode and mask */
+RPU_ATCM_TEXT static inline const volatile u32 *prvPcProfFrame(void)
+{
+    u32 frame;
+
+    __asm__ volatile("mrs   r12, cpsr\n\t"
+                     "cpsid i, #0x12\n\t"
+                     "mov   r3, sp\n\t"
+                     "msr   cpsr_c, r12\n\t"
+                     "mov   %0, r3"
+                     : "=r"(frame) : : "r3", "r12", "memory");
+    return (const volatile u32 *)(UINTPTR)frame;
+}
+
+/*-----------------------------------------------------------*/
+/* Counter interrupt: one sample */
+RPU_ATCM_TEXT static void prvPcProfHandler(void *CallbackRef)
+{
+    const volatile u32 *frame = prvPcProfFrame();
+    u32 spsr = frame[0];
+    u32 pc = frame[1];
+    u32 mode = spsr & PCPROF_MODE_MASK;
+    u32 i;
+
+    (void)CallbackRef;
+
+    // Reading the status register clears it
+    (void)XTtcPs_GetInterruptStatus(&xPcProfTtc);
+
+    for (i = 0; i < PCPROF_RANGES; i++) {
+        const struct pcprof_range *range = &xPcProfRange[i];
+
+        if (pc - range->low < range->span) {
+            UINTPTR bin = RPU_PCPROF_BASE + range->first + (((pc - range->low) >> ulPcProfShift) << 2);
+
+            Xil_Out32(bin, Xil_In32(bin) + 1);
+            break;
+        }
+    }
+    if (i == PCPROF_RANGES) {
+        Xil_Out32(RPU_PCPROF_BASE + PCPROF_OUTSIDE_OFFSET, ++ulPcProfOutside);
+    }
+    if (mode != PCPROF_MODE_SYS && mode != PCPROF_MODE_USR) {
+        Xil_Out32(RPU_PCPROF_BASE + PCPROF_HANDLER_OFFSET, ++ulPcProfHandler);
+    }
+    Xil_Out32(RPU_PCPROF_BASE + PCPROF_SAMPLES_OFFSET, ++ulPcProfSamples);
+}
+
+/*-----------------------------------------------------------*/
+/* Smallest bin size that fits both code ranges in the block; returns the
+ * number of bins used */
+static u32 prvPcProfLayout(void)
+{
+    const u32 low[PCPROF_RANGES] = { 0, (u32)(UINTPTR)__text_start };
+    const u32 high[PCPROF_RANGES] = { (u32)(UINTPTR)__atcm_text_end, (u32)(UINTPTR)__text_end };
+    u32 bins[PCPROF_RANGES];
+    u32 total;
+    u32 i;
+
+    for (ulPcProfShift = PCPROF_MIN_SHIFT; ; ulPcProfShift++) {
+        u32 size = 1U << ulPcProfShift;
+
+        total = 0;
+        for (i = 0; i < PCPROF_RANGES; i++) {
+            u32 start = low[i] & ~(size - 1);
+
+            bins[i] = (high[i] - start + size - 1) >> ulPcProfShift;
+            total += bins[i];
+        }
+        if (total <= PCPROF_MAX_BINS) {
+            break;
+        }
+    }
+
+    total = 0;
+    for (i = 0; i < PCPROF_RANGES; i++) {
+        xPcProfRange[i].low = low[i] & ~((1U << ulPcProfShift) - 1);
+        xPcProfRange[i].span = bins[i] << ulPcProfShift;
+        xPcProfRange[i].first = PCPROF_BIN(total);
+        Xil_Out32(RPU_PCPROF_BASE + PCPROF_RANGE(i) + 0x0, xPcProfRange[i].low);
+        Xil_Out32(RPU_PCPROF_BASE + PCPROF_RANGE(i) + 0x4, bins[i]);
+        Xil_Out32(RPU_PCPROF_BASE + PCPROF_RANGE(i) + 0x8, total);
+        Xil_Out32(RPU_PCPROF_BASE + PCPROF_RANGE(i) + 0xC, 0);
+        total += bins[i];
+    }
+    return total;
+}
+
+/*-----------------------------------------------------------*/
+/* Lay out and clear the block, then start sampling */
+RPU_INIT_TEXT int xRpuPcProfInit(u16 intr_priority)
+{
+    XTtcPs_Config *cfg;
+    u64 interval;
+    u32 seq;
+    u32 bins;
+    u32 i;
+    int Status;
+
+    cfg = XTtcPs_LookupConfig(RPU_CORE_PCPROF_TTC);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+
+    Status = XTtcPs_CfgInitialize(&xPcProfTtc, cfg, cfg->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        // Left running by a previous firmware instance
+        XTtcPs_Stop(&xPcProfTtc);
+        Status = XTtcPs_CfgInitialize(&xPcProfTtc, cfg, cfg->BaseAddress);
+    }
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    Status = XTtcPs_SetOptions(&xPcProfTtc, XTTCPS_OPTION_INTERVAL_MODE | XTTCPS_OPTION_WAVE_DISABLE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    // Interval mode counts 0..interval, i.e. interval + 1 clocks per sample
+    interval = cfg->InputClockHz / RPU_PC_PROF_HZ;
+    if (interval < 2 || interval > XTTCPS_MAX_INTERVAL_COUNT) {
+        return XST_FAILURE;
+    }
+    XTtcPs_SetInterval(&xPcProfTtc, (XInterval)(interval - 1));
+    XTtcPs_ClearInterruptStatus(&xPcProfTtc, XTtcPs_GetInterruptStatus(&xPcProfTtc));
+    XTtcPs_EnableInterrupts(&xPcProfTtc, XTTCPS_IXR_INTERVAL_MASK);
+
+    Xil_SetTlbAttributes(RPU_PCPROF_BASE, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+
+    Xil_Out32(RPU_PCPROF_BASE + PCPROF_MAGIC_OFFSET, 0);
+    seq = ulRpuSeqInit(RPU_PCPROF_BASE + PCPROF_SEQ_OFFSET);
+    vRpuSeqBegin(RPU_PCPROF_BASE + PCPROF_SEQ_OFFSET, &seq);
+    Xil_Out32(RPU_PCPROF_BASE + PCPROF_HZ_OFFSET, cfg->InputClockHz / (u32)interval);
+    bins = prvPcProfLayout();
+    Xil_Out32(RPU_PCPROF_BASE + PCPROF_SHIFT_OFFSET, ulPcProfShift);
+    for (i = 0; i < bins; i++) {
+        Xil_Out32(RPU_PCPROF_BASE + PCPROF_BIN(i), 0);
+    }
+    ulPcProfSamples = 0;
+    ulPcProfOutside = 0;
+    ulPcProfHandler = 0;
+    Xil_Out32(RPU_PCPROF_BASE + PCPROF_SAMPLES_OFFSET, 0);
+    Xil_Out32(RPU_PCPROF_BASE + PCPROF_OUTSIDE_OFFSET, 0);
+    Xil_Out32(RPU_PCPROF_BASE + PCPROF_HANDLER_OFFSET, 0);
+    vRpuSeqEnd(RPU_PCPROF_BASE + PCPROF_SEQ_OFFSET, &seq);
+    Xil_Out32(RPU_PCPROF_BASE + PCPROF_MAGIC_OFFSET, PCPROF_MAGIC);
+    __sync_synchronize();
+
+    Status = XSetupInterruptSystem(&xPcProfTtc, (Xil_ExceptionHandler)prvPcProfHandler,
+                                   cfg->IntrId[0], cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId[0], cfg->IntrParent);
+    XTtcPs_Start(&xPcProfTtc);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_PC_PROF */
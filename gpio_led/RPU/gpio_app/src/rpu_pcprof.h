@@ -0,0 +1,49 @@
+/*
+ * Statistical PC-sampling profiler (build option RPU_PC_PROF=1,
+ * UserConfig.cmake).
+ *
+ * A spare TTC counter of the core (rpu_core.h) interrupts RPU_PC_PROF_HZ
+ * times a second; the handler takes the interrupted PC from the frame
+ * FreeRTOS_IRQ_Handler pushed on the IRQ stack and counts it in a histogram
+ * of the ATCM and DDR code in the core's PCPROF block in OCM (rpu_shm.h).
+ * apu_app/rpu_prof turns the difference of two readings into a gprof
+ * gmon.out, folded stacks for flamegraph.pl or a top list, so the firmware
+ * is profiled live without JTAG or a -pg build (the BSP's mcount profiler
+ * needs both).
+ *
+ * The sampler sits above the FreeRTOS API mask (rpu_intr.h), so it also
+ * lands in critical sections and in every handler but the waveform sample
+ * above it; code that runs with IRQs disabled is charged to the instruction
+ * that enables them again.
+ * The default rate is prime, so it never locks to the tick or the LED
+ * schedule.
+ *
+ * Without RPU_PC_PROF the call is an empty inline function.
+ */
+
+#ifndef RPU_PCPROF_H
+#define RPU_PCPROF_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "rpu_core.h"
+
+#ifndef RPU_PC_PROF
+#define RPU_PC_PROF 0
+#endif
+
+#ifndef RPU_PC_PROF_HZ
+#define RPU_PC_PROF_HZ          997
+#endif
+
+#if RPU_PC_PROF
+int xRpuPcProfInit(u16 intr_priority);
+#else
+static inline int xRpuPcProfInit(u16 intr_priority)
+{
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_PC_PROF */
+
+#endif /* RPU_PCPROF_H */
@@ -0,0 +1,201 @@
+/*
+ * PL interrupts of the interrupt_gen IP (see rpu_plintr.h).
+ *
+ * The handler is the only writer of the counters: it keeps them in BTCM and
+ * copies the entries it changed to the OCM block inside one odd sequence, so
+ * the APU never waits on it and the handler never reads OCM. It runs from
+ * ATCM and touches the PL only for the registers pl_intr.ko reads as well,
+ * so the two latencies cost the same bus accesses.
+ */
+
+#include "rpu_plintr.h"
+
+#if RPU_PL_INTR
+
+#include <xil_io.h>
+#include "xil_mmu.h"
+#include "xinterrupt_wrap.h"
+
+#include "kr260_regs.h"
+#include "rpu_boot.h"
+#include "rpu_shm.h"
+#include "rpu_tcm.h"
+
+#define PLINTR_GICD_BASE       0xF9000000U   // RPU GIC distributor
+#define PLINTR_INTR_ID         ((RPU_PL_INTR_IRQ - 32) | (4 << 12))  // SPI, level high
+#define PLINTR_GEN_CH(n, reg)  (RPU_PL_INTR_GEN_BASE + INTERRUPT_GEN_CHANNEL_OFFSET(n) + \
+                                INTERRUPT_GEN_CH_##reg##_OFFSET)
+#define PLINTR_WORDS           (PLINTR_CH_SIZE / 4)
+
+typedef union {
+    struct rpu_plintr_channel c;
+    u32 w[PLINTR_WORDS];
+} PlIntrEntry_t;
+
+static PlIntrEntry_t xPlIntrCh[PLINTR_MAX_CHANNELS] RPU_BTCM_BSS;
+static u32 ulPlIntrHwEvents[PLINTR_MAX_CHANNELS] RPU_BTCM_BSS;  /* Event counter at the last interrupt */
+static u32 ulPlIntrChannels RPU_BTCM_BSS;
+static u32 ulPlIntrMask RPU_BTCM_BSS;
+static u32 ulPlIntrSeq RPU_BTCM_BSS;
+static u32 ulPlIntrIrqs RPU_BTCM_BSS;
+static u32 ulPlIntrSpurious RPU_BTCM_BSS;
+static RpuPlIntrHandler_t xPlIntrFn RPU_BTCM_BSS;
+static void *pvPlIntrArg RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* HI, LO, HI: retry if the low word carried into the high one meanwhile */
+RPU_ATCM_TEXT static u64 prvPlIntrRead64(UINTPTR addr)
+{
+    u32 hi, lo;
+
+    do {
+        hi = Xil_In32(addr + 4);
+        lo = Xil_In32(addr);
+    } while (Xil_In32(addr + 4) != hi);
+    return ((u64)hi << 32) | lo;
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT static void prvPlIntrService(u32 n, u64 now)
+{
+    struct rpu_plintr_channel *c = &xPlIntrCh[n].c;
+    u64 stamp = prvPlIntrRead64(PLINTR_GEN_CH(n, TIMESTAMP_LO));
+    u32 events = Xil_In32(PLINTR_GEN_CH(n, EVENTS));
+    u32 delta = events - ulPlIntrHwEvents[n];
+    u64 latency = now - stamp;
+    u64 sum;
+
+    // The timestamp holds until the bit is cleared
+    Xil_Out32(RPU_PL_INTR_GEN_BASE + INTERRUPT_GEN_ISR_OFFSET, 1U << n);
+    if (xPlIntrFn != NULL) {
+        xPlIntrFn(n, stamp, pvPlIntrArg);
+    }
+
+    ulPlIntrHwEvents[n] = events;
+    c->events += delta;
+    c->irqs++;
+    if (delta > 1) {
+        c->lost += delta - 1;
+    }
+    c->latency_last = (latency > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (u32)latency;
+    if (c->irqs == 1 || c->latency_last < c->latency_min) {
+        c->latency_min = c->latency_last;
+    }
+    if (c->latency_last > c->latency_max) {
+        c->latency_max = c->latency_last;
+    }
+    sum = (((u64)c->latency_sum_hi << 32) | c->latency_sum_lo) + c->latency_last;
+    c->latency_sum_lo = (u32)sum;
+    c->latency_sum_hi = (u32)(sum >> 32);
+}
+
+/*-----------------------------------------------------------*/
+/* Output of the AXI interrupt controller (interrupt context) */
+RPU_ATCM_TEXT static void prvPlIntrHandler(void *CallbackRef)
+{
+    u32 pending, fired, n, i;
+    u64 now;
+
+    (void)CallbackRef;
+
+    // Both views must agree: the controller re-latches a level input that
+    // was still high when the previous interrupt was acknowledged
+    pending = Xil_In32(RPU_PL_INTR_INTC_BASE + AXI_INTC_IPR_OFFSET) & ulPlIntrMask;
+    ulPlIntrIrqs++;
+    if (pending == 0) {
+        ulPlIntrSpurious++;
+        Xil_Out32(PLINTR_ADDR + PLINTR_SPURIOUS_OFFSET, ulPlIntrSpurious);
+        Xil_Out32(PLINTR_ADDR + PLINTR_IRQS_OFFSET, ulPlIntrIrqs);
+        return;
+    }
+    fired = pending & Xil_In32(RPU_PL_INTR_GEN_BASE + INTERRUPT_GEN_ISR_OFFSET);
+    now = prvPlIntrRead64(RPU_PL_INTR_GEN_BASE + INTERRUPT_GEN_COUNTER_LO_OFFSET);
+    for (n = 0; n < ulPlIntrChannels; n++) {
+        if (fired & (1U << n)) {
+            prvPlIntrService(n, now);
+        }
+    }
+    // Read back so the ISR clears reach the IP before the acknowledgment
+    (void)Xil_In32(RPU_PL_INTR_GEN_BASE + INTERRUPT_GEN_ISR_OFFSET);
+    Xil_Out32(RPU_PL_INTR_INTC_BASE + AXI_INTC_IAR_OFFSET, pending);
+
+    Xil_Out32(PLINTR_ADDR + PLINTR_SEQ_OFFSET, ++ulPlIntrSeq);
+    __sync_synchronize();
+    for (n = 0; n < ulPlIntrChannels; n++) {
+        if (fired & (1U << n)) {
+            for (i = 0; i < PLINTR_WORDS; i++) {
+                Xil_Out32(PLINTR_ADDR + PLINTR_CH(n) + i * 4, xPlIntrCh[n].w[i]);
+            }
+        }
+    }
+    Xil_Out32(PLINTR_ADDR + PLINTR_IRQS_OFFSET, ulPlIntrIrqs);
+    __sync_synchronize();
+    Xil_Out32(PLINTR_ADDR + PLINTR_SEQ_OFFSET, ++ulPlIntrSeq);
+}
+
+/*-----------------------------------------------------------*/
+void vRpuPlIntrRegister(RpuPlIntrHandler_t fn, void *arg)
+{
+    // The handler reads fn without a lock: no call through a half-set pair
+    if (ulPlIntrChannels != 0) {
+        XDisableIntrId(PLINTR_INTR_ID, PLINTR_GICD_BASE);
+    }
+    pvPlIntrArg = arg;
+    xPlIntrFn = fn;
+    if (ulPlIntrChannels != 0) {
+        XEnableIntrId(PLINTR_INTR_ID, PLINTR_GICD_BASE);
+    }
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuPlIntrInit(u16 intr_priority)
+{
+    u32 n, i;
+    int Status;
+
+    Xil_SetTlbAttributes(RPU_PL_INTR_GEN_BASE, STRONG_ORDERD_SHARED | PRIV_RW_USER_RW);
+    Xil_SetTlbAttributes(RPU_PL_INTR_INTC_BASE, STRONG_ORDERD_SHARED | PRIV_RW_USER_RW);
+    Xil_SetTlbAttributes(PLINTR_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+
+    ulPlIntrChannels = Xil_In32(RPU_PL_INTR_GEN_BASE + INTERRUPT_GEN_CHANNELS_OFFSET);
+    if (ulPlIntrChannels == 0 || ulPlIntrChannels > PLINTR_MAX_CHANNELS) {
+        // 0: the two-channel block
+        ulPlIntrChannels = 2;
+    }
+    ulPlIntrMask = (1U << ulPlIntrChannels) - 1;
+
+    // Count from here: drop a pending bit, it is in the event counter
+    for (n = 0; n < ulPlIntrChannels; n++) {
+        ulPlIntrHwEvents[n] = Xil_In32(PLINTR_GEN_CH(n, EVENTS));
+    }
+    Xil_Out32(RPU_PL_INTR_GEN_BASE + INTERRUPT_GEN_ISR_OFFSET, ulPlIntrMask);
+    (void)Xil_In32(RPU_PL_INTR_GEN_BASE + INTERRUPT_GEN_ISR_OFFSET);
+    Xil_Out32(RPU_PL_INTR_INTC_BASE + AXI_INTC_IAR_OFFSET, ulPlIntrMask);
+
+    // Magic last: the APU only trusts the block once it is complete
+    Xil_Out32(PLINTR_ADDR + PLINTR_MAGIC_OFFSET, 0);
+    for (i = 4; i < PLINTR_CH(PLINTR_MAX_CHANNELS); i += 4) {
+        Xil_Out32(PLINTR_ADDR + i, 0);
+    }
+    Xil_Out32(PLINTR_ADDR + PLINTR_CHANNELS_OFFSET, ulPlIntrChannels);
+    Xil_Out32(PLINTR_ADDR + PLINTR_CLK_HZ_OFFSET, RPU_PL_INTR_CLK_HZ);
+    __sync_synchronize();
+    Xil_Out32(PLINTR_ADDR + PLINTR_MAGIC_OFFSET, PLINTR_MAGIC);
+
+    Status = XSetupInterruptSystem(NULL, (Xil_ExceptionHandler)prvPlIntrHandler, PLINTR_INTR_ID,
+                                   PLINTR_GICD_BASE, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(PLINTR_INTR_ID, PLINTR_GICD_BASE);
+
+    Xil_Out32(RPU_PL_INTR_INTC_BASE + AXI_INTC_IER_OFFSET,
+              Xil_In32(RPU_PL_INTR_INTC_BASE + AXI_INTC_IER_OFFSET) | ulPlIntrMask);
+    Xil_Out32(RPU_PL_INTR_INTC_BASE + AXI_INTC_MER_OFFSET, AXI_INTC_MER_ME_MASK | AXI_INTC_MER_HIE_MASK);
+
+    RPU_BOOT_PRINT("PL interrupts: %u channel(s) on GIC ID %u\r\n",
+                   (unsigned)ulPlIntrChannels, (unsigned)RPU_PL_INTR_IRQ);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_PL_INTR */
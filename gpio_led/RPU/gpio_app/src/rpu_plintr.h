@@ -0,0 +1,77 @@
+/*
+ * PL interrupts of the interrupt_gen IP on the R5 (build option
+ * RPU_PL_INTR=1, UserConfig.cmake; RPU0 firmware only).
+ *
+ * The R5 takes the output of the AXI interrupt controller whose input n is
+ * channel n of the generator, as pl_intr.ko does on Linux (the myhdl
+ * interrupt_demo design: interrupt_generator_0 at RPU_PL_INTR_GEN_BASE,
+ * axi_intc_0 at RPU_PL_INTR_INTC_BASE, its irq on pl_ps_irq0[0], GIC ID
+ * RPU_PL_INTR_IRQ). The PL-to-PS interrupts reach the RPU GIC as well as the
+ * APU's, so the handler is connected with XSetupInterruptSystem() like every
+ * other source, at RPU_INTR_PL_LEVEL (rpu_intr.h).
+ *
+ * The handler stays short: it reads the pending channels and the
+ * generator's free-running counter once, then for each channel its event
+ * counter and hardware timestamp, clears its ISR bit, calls the reaction
+ * registered with xRpuPlIntrRegister() and updates its counters in the OCM
+ * block (PLINTR_ADDR, rpu_shm.h); the controller is acknowledged last.
+ * The latency is PL clocks from the timestamp to the counter read after the
+ * pending registers, the point pl_intr.ko reads it at for Linux: compare
+ * apu_app/rpu_stats --plintr with the /dev/pl_intr counters under the same
+ * generator settings.
+ *
+ * Only one side may own the controller: do not load pl_intr.ko or let
+ * PYNQ's UIO driver enable the interrupt while the R5 does. The generator's
+ * registers (period, IER, coalescing) stay with whoever drives the test; the
+ * firmware only enables the channels in the controller. The PL design must
+ * also keep the gpio_led AXI GPIO at 0x80000000 for the LED tasks.
+ */
+
+#ifndef RPU_PLINTR_H
+#define RPU_PLINTR_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "rpu_core.h"
+
+#ifndef RPU_PL_INTR
+#define RPU_PL_INTR 0
+#endif
+
+#ifndef RPU_PL_INTR_GEN_BASE
+#define RPU_PL_INTR_GEN_BASE    0xB0000000U  // interrupt_generator_0 (myhdl/PL/README.md)
+#endif
+#ifndef RPU_PL_INTR_INTC_BASE
+#define RPU_PL_INTR_INTC_BASE   0xB0010000U  // axi_intc_0
+#endif
+#ifndef RPU_PL_INTR_IRQ
+#define RPU_PL_INTR_IRQ         121          // pl_ps_irq0[0]: GIC_SPI 89 -> ID 121
+#endif
+#ifndef RPU_PL_INTR_CLK_HZ
+#define RPU_PL_INTR_CLK_HZ      100000000U   // pl_clk0 of the generator, published for the APU
+#endif
+
+/* Reaction to an interrupt of channel, in the interrupt; stamp is the
+ * generator's counter at the event */
+typedef void (*RpuPlIntrHandler_t)(u32 channel, u64 stamp, void *arg);
+
+#if RPU_PL_INTR
+#if RPU_CORE != 0
+#error "RPU_PL_INTR is for the RPU0 firmware: one core owns the controller"
+#endif
+
+/* Map the blocks, publish the OCM block and enable the channels in the
+ * controller behind a handler at intr_priority */
+int xRpuPlIntrInit(u16 intr_priority);
+/* Call fn for every interrupt of every channel (NULL: none); at a level
+ * above configMAX_API_CALL_INTERRUPT_PRIORITY it must not use FreeRTOS */
+void vRpuPlIntrRegister(RpuPlIntrHandler_t fn, void *arg);
+#else
+static inline int xRpuPlIntrInit(u16 intr_priority)
+{
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_PL_INTR */
+
+#endif /* RPU_PLINTR_H */
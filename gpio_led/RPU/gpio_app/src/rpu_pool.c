@@ -0,0 +1,78 @@
+/*
+ * Fixed-size block pools (see rpu_pool.h).
+ *
+ * A free block stores the pointer to the next free one in its first word, so
+ * the pool needs no memory beyond the blocks. Alloc and free run from ATCM:
+ * they are called on interrupt paths.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_pool.h"
+#include "rpu_tcm.h"
+
+/*-----------------------------------------------------------*/
+void vRpuPoolInit(RpuPool_t *pool, void *storage, u32 size, u32 count)
+{
+    u32 block_size = RPU_POOL_BLOCK_SIZE(size);
+    u8 *block = storage;
+    u32 i;
+
+    configASSERT(((UINTPTR)storage & (RPU_POOL_ALIGN - 1U)) == 0);
+
+    // Thread the blocks in address order, the first one on top
+    pool->free = NULL;
+    for (i = count; i > 0; i--) {
+        void **link = (void **)(block + (i - 1) * block_size);
+
+        *link = pool->free;
+        pool->free = link;
+    }
+    pool->base = block;
+    pool->block_size = block_size;
+    pool->count = count;
+    pool->used = 0;
+    pool->used_max = 0;
+    pool->failed = 0;
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void *pvRpuPoolAlloc(RpuPool_t *pool)
+{
+    UBaseType_t saved;
+    void **block;
+
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    block = pool->free;
+    if (block != NULL) {
+        pool->free = *block;
+        if (++pool->used > pool->used_max) {
+            pool->used_max = pool->used;
+        }
+    } else {
+        pool->failed++;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    return block;
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuPoolFree(RpuPool_t *pool, void *block)
+{
+    UBaseType_t saved;
+
+    if (block == NULL) {
+        return;
+    }
+    // A block of another pool, or a pointer into one, would corrupt the list
+    configASSERT((u8 *)block >= pool->base &&
+                 (u32)((u8 *)block - pool->base) < pool->count * pool->block_size &&
+                 (u32)((u8 *)block - pool->base) % pool->block_size == 0);
+
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    *(void **)block = pool->free;
+    pool->free = block;
+    pool->used--;
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
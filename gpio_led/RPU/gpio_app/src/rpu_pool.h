@@ -0,0 +1,59 @@
+/*
+ * Fixed-size block pools for message objects (commands, trace records, bulk
+ * descriptors and the like).
+ *
+ * The firmware has no FreeRTOS heap (configSUPPORT_DYNAMIC_ALLOCATION 0,
+ * README "Static Allocation"), so objects whose number varies at run time
+ * come from a pool instead: an array of equal blocks threaded on a free
+ * list. Allocation and release are O(1), never fragment and may be called
+ * from tasks and from interrupt handlers below the API mask; a pool protects
+ * its list with the API-level critical section for a few instructions.
+ *
+ * The caller owns the storage and chooses where it lives, which is how TCM
+ * and DDR are used side by side: declare it with RPU_POOL_STORAGE() and a
+ * section (RPU_BTCM_NOINIT for a pool on an interrupt path, nothing for
+ * DDR), or hand vRpuPoolInit() any other suitably aligned region, such as a
+ * reserved OCM range.
+ *
+ *   RPU_POOL_STORAGE(ucCmdPool, sizeof(Cmd_t), 32, RPU_BTCM_NOINIT);
+ *   static RpuPool_t xCmdPool;
+ *   vRpuPoolInit(&xCmdPool, ucCmdPool, sizeof(Cmd_t), 32);
+ *   Cmd_t *cmd = pvRpuPoolAlloc(&xCmdPool);   // NULL when exhausted
+ *   vRpuPoolFree(&xCmdPool, cmd);
+ */
+
+#ifndef RPU_POOL_H
+#define RPU_POOL_H
+
+#include "xil_types.h"
+
+/* Blocks are rounded up to 8 bytes, so any object keeps its alignment */
+#define RPU_POOL_ALIGN          8U
+#define RPU_POOL_BLOCK_SIZE(size) \
+    ((((u32)(size) < sizeof(void *) ? sizeof(void *) : (u32)(size)) + RPU_POOL_ALIGN - 1U) & ~(RPU_POOL_ALIGN - 1U))
+
+/* Storage for count blocks of size bytes, in section (may be empty) */
+#define RPU_POOL_STORAGE(name, size, count, section) \
+    static u8 name[RPU_POOL_BLOCK_SIZE(size) * (count)] __attribute__((aligned(RPU_POOL_ALIGN))) section
+
+typedef struct {
+    void *free;          /* Free list, linked through the first word of each block */
+    u8 *base;
+    u32 block_size;      /* RPU_POOL_BLOCK_SIZE() of the object size */
+    u32 count;
+    u32 used;
+    u32 used_max;        /* High water mark, to size the pool */
+    u32 failed;          /* Allocations that found the pool empty */
+} RpuPool_t;
+
+/* storage holds count blocks of RPU_POOL_BLOCK_SIZE(size) bytes */
+void vRpuPoolInit(RpuPool_t *pool, void *storage, u32 size, u32 count);
+void *pvRpuPoolAlloc(RpuPool_t *pool);
+void vRpuPoolFree(RpuPool_t *pool, void *block);
+
+static inline u32 ulRpuPoolAvailable(const RpuPool_t *pool)
+{
+    return pool->count - pool->used;
+}
+
+#endif /* RPU_POOL_H */
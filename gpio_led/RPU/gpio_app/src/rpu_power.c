@@ -0,0 +1,115 @@
+/*
+ * Tickless idle for the Cortex-R5 port (see rpu_power.h).
+ *
+ * The FreeRTOS tick comes from TTC0 counter 0 in interval mode
+ * (configTIMER_BASEADDR, programmed by xiltimer). To sleep for N ticks the
+ * counter is reloaded with the rest of the current tick plus N - 1 whole
+ * ticks, the core waits in WFI with IRQs masked at the CPU, and on wake-up
+ * the kernel tick count is stepped by the time that actually passed. The
+ * counter is then restarted with the normal tick interval.
+ *
+ * The counter restarts from zero after a sleep, so the fraction of a tick
+ * that had passed before a wake-up is dropped: the tick count loses less
+ * than one tick per sleep. This is the usual trade-off of interval timers
+ * for tickless idle and does not affect interrupt latency.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xttcps_hw.h"
+
+#include "rpu_power.h"
+
+#define TICK_TTC_BASEADDR   (configTIMER_BASEADDR + 4U * configTIMER_SELECT_CNTR)
+
+#define TICK_TTC_RD(reg)        XTtcPs_ReadReg(TICK_TTC_BASEADDR, (reg))
+#define TICK_TTC_WR(reg, val)   XTtcPs_WriteReg(TICK_TTC_BASEADDR, (reg), (val))
+
+/*-----------------------------------------------------------*/
+const char *pcRpuProfileName(void)
+{
+#if RPU_PROFILE == RPU_PROFILE_POWER
+    return "power (tickless idle)";
+#elif RPU_PROFILE == RPU_PROFILE_LATENCY
+    return "latency (1 kHz tick)";
+#else
+    return "default";
+#endif
+}
+
+/*-----------------------------------------------------------*/
+/* portSUPPRESS_TICKS_AND_SLEEP(), called by the idle task with the scheduler
+ * suspended */
+void vApplicationSleep(TickType_t xExpectedIdleTime)
+{
+#if RPU_PROFILE == RPU_PROFILE_POWER
+    u32 ctrl, per_tick, count, reload, now, total;
+    TickType_t ticks;
+
+    __asm volatile ("cpsid i" ::: "memory");
+    __asm volatile ("dsb" ::: "memory");
+    __asm volatile ("isb" ::: "memory");
+
+    // A task may have been readied between the idle check and cpsid
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        __asm volatile ("cpsie i" ::: "memory");
+        return;
+    }
+
+    ctrl = TICK_TTC_RD(XTTCPS_CNT_CNTRL_OFFSET) &
+           ~(XTTCPS_CNT_CNTRL_DIS_MASK | XTTCPS_CNT_CNTRL_RST_MASK);
+    per_tick = TICK_TTC_RD(XTTCPS_INTERVAL_VAL_OFFSET) + 1U;
+
+    // The reload value must fit the 32-bit counter
+    if (xExpectedIdleTime > 0xFFFFFFFFUL / per_tick) {
+        xExpectedIdleTime = 0xFFFFFFFFUL / per_tick;
+    }
+
+    TICK_TTC_WR(XTTCPS_CNT_CNTRL_OFFSET, ctrl | XTTCPS_CNT_CNTRL_DIS_MASK);
+    count = TICK_TTC_RD(XTTCPS_COUNT_VALUE_OFFSET);
+
+    // The tick expired after cpsid: account for it and skip this sleep.
+    // Reading the status register clears it, so the tick interrupt won't run.
+    if (TICK_TTC_RD(XTTCPS_ISR_OFFSET) & XTTCPS_IXR_INTERVAL_MASK) {
+        TICK_TTC_WR(XTTCPS_CNT_CNTRL_OFFSET, ctrl);
+        vTaskStepTick(1);
+        __asm volatile ("cpsie i" ::: "memory");
+        return;
+    }
+
+    // Interval mode counts 0..interval, so the current tick ends in
+    // per_tick - count counts
+    reload = (per_tick - count) + (u32)(xExpectedIdleTime - 1U) * per_tick;
+    TICK_TTC_WR(XTTCPS_INTERVAL_VAL_OFFSET, reload - 1U);
+    TICK_TTC_WR(XTTCPS_CNT_CNTRL_OFFSET, ctrl | XTTCPS_CNT_CNTRL_RST_MASK);
+
+    // Wakes on any pending IRQ, even with the I bit set
+    __asm volatile ("dsb" ::: "memory");
+    __asm volatile ("wfi");
+    __asm volatile ("isb" ::: "memory");
+
+    TICK_TTC_WR(XTTCPS_CNT_CNTRL_OFFSET, ctrl | XTTCPS_CNT_CNTRL_DIS_MASK);
+    now = TICK_TTC_RD(XTTCPS_COUNT_VALUE_OFFSET);
+
+    if (TICK_TTC_RD(XTTCPS_ISR_OFFSET) & XTTCPS_IXR_INTERVAL_MASK) {
+        // Slept until the timeout; vTaskStepTick() pends the final tick
+        ticks = xExpectedIdleTime;
+    } else {
+        // Woken early by another interrupt
+        total = count + now;
+        ticks = total / per_tick;
+    }
+
+    TICK_TTC_WR(XTTCPS_INTERVAL_VAL_OFFSET, per_tick - 1U);
+    TICK_TTC_WR(XTTCPS_CNT_CNTRL_OFFSET, ctrl | XTTCPS_CNT_CNTRL_RST_MASK);
+
+    if (ticks != 0) {
+        vTaskStepTick(ticks);
+    }
+
+    // The interrupt that woke the core runs now
+    __asm volatile ("cpsie i" ::: "memory");
+#else
+    (void)xExpectedIdleTime;
+#endif
+}
@@ -0,0 +1,44 @@
+/*
+ * Power / latency build profiles for the RPU firmware.
+ *
+ * The profile is picked per product with RPU_PROFILE in USER_COMPILE_DEFINITIONS
+ * (UserConfig.cmake):
+ *
+ * - RPU_PROFILE_DEFAULT: 100 Hz tick, the idle task spins
+ * - RPU_PROFILE_POWER:   tickless idle; the idle task stops the tick timer and
+ *                        sleeps in WFI until the next task timeout or interrupt;
+ *                        needs the BSP regenerated with freertos_tickless_idle 2
+ * - RPU_PROFILE_LATENCY: 1 kHz tick, no sleep; needs the BSP regenerated with
+ *                        freertos_tick_rate 1000 (bsp.yaml)
+ * Both BSP settings are checked at build time.
+ *
+ * With configUSE_TICKLESS_IDLE 2 the kernel calls vApplicationSleep()
+ * (portSUPPRESS_TICKS_AND_SLEEP) whenever it expects to be idle for at least
+ * configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks. The BSP default is 0, so the
+ * other profiles do not pay for the idle-time check.
+ */
+
+#ifndef RPU_POWER_H
+#define RPU_POWER_H
+
+#include "FreeRTOS.h"
+
+#define RPU_PROFILE_DEFAULT  0
+#define RPU_PROFILE_POWER    1
+#define RPU_PROFILE_LATENCY  2
+
+#ifndef RPU_PROFILE
+#define RPU_PROFILE          RPU_PROFILE_DEFAULT
+#endif
+
+#if (RPU_PROFILE == RPU_PROFILE_LATENCY) && (configTICK_RATE_HZ != 1000)
+#error "RPU_PROFILE_LATENCY needs the BSP rebuilt with freertos_tick_rate 1000 (the SDT tick timer is limited to 1 kHz)"
+#endif
+
+#if (RPU_PROFILE == RPU_PROFILE_POWER) && (configUSE_TICKLESS_IDLE != 2)
+#error "RPU_PROFILE_POWER needs the BSP rebuilt with freertos_tickless_idle 2 (configUSE_TICKLESS_IDLE 2)"
+#endif
+
+const char *pcRpuProfileName(void);
+
+#endif /* RPU_POWER_H */
@@ -0,0 +1,103 @@
+/*
+ * DDR QoS profile (see rpu_qos.h).
+ *
+ * The AFIFM RDQOS and WRQOS registers replace the AxQOS of the PL master
+ * on every transaction of their port, and may be written at any time; a
+ * transaction already queued keeps the QoS it was issued with. The DDR
+ * controller port each AFIFM drains into is fixed by the PS: HPC0/1 reach
+ * it through the CCI (ports 1 and 2), HP0 on port 3, HP1 and HP2 on port 4,
+ * HP3 on port 5 and S_AXI_LPD through the LPD on the RPU port 0.
+ */
+
+#include "rpu_qos.h"
+
+#if RPU_QOS
+
+#include <xil_io.h>
+#include "xil_printf.h"
+
+#include "rpu_apm.h"
+#include "rpu_shm.h"
+#include "rpu_tcm.h"
+
+#define AFIFM_RDQOS            0x08
+#define AFIFM_WRQOS            0x1C
+#define AFIFM_QOS_MASK         0xFU
+
+// DDRC PCFGQOS0_n: QoS 0..level1 is region 0, up to level2 region 1 (when
+// the port has three regions), the rest the last region
+#define DDRC_PCFGQOS0(port)    (0xFD070494U + (port) * 0xB0U)
+#define DDRC_QOS_LEVEL1(v)     ((v) & 0xFU)
+#define DDRC_QOS_LEVEL2(v)     (((v) >> 8) & 0xFU)
+#define DDRC_QOS_REGION(v, r)  (((v) >> (16 + 4 * (r))) & 0x3U)
+
+struct qos_port {
+    const char *name;
+    UINTPTR afifm;
+    u32 ddrc_port;
+};
+
+// Indexed by the bit of RPU_QOS_*
+static const struct qos_port xQosPort[] = {
+    { "HPC0", 0xFD360000U, 1 },
+    { "HPC1", 0xFD370000U, 2 },
+    { "HP0",  0xFD380000U, 3 },
+    { "HP1",  0xFD390000U, 4 },
+    { "HP2",  0xFD3A0000U, 4 },
+    { "HP3",  0xFD3B0000U, 5 },
+    { "LPD",  0xFF9B0000U, 0 },
+};
+#define QOS_PORTS              (sizeof(xQosPort) / sizeof(xQosPort[0]))
+
+static const char *const pcQosClass[] = { "LPR", "VPR", "HPR", "?" };
+
+#if (RPU_QOS_PORTS) & ~((1U << 7) - 1U)
+#error "RPU_QOS_PORTS has bits of no AFIFM port (RPU_QOS_*)"
+#endif
+
+/*-----------------------------------------------------------*/
+/* DDR controller class of a QoS value on one of its ports */
+static const char *prvQosClass(u32 ddrc_port, u32 qos)
+{
+    u32 cfg = Xil_In32(DDRC_PCFGQOS0(ddrc_port));
+    u32 level1 = DDRC_QOS_LEVEL1(cfg);
+    u32 level2 = DDRC_QOS_LEVEL2(cfg);
+    u32 region;
+
+    if (qos <= level1) {
+        region = 0;
+    } else if (level2 > level1) {
+        region = (qos <= level2) ? 1 : 2;
+    } else {
+        region = 1;
+    }
+    return pcQosClass[DDRC_QOS_REGION(cfg, region)];
+}
+
+/*-----------------------------------------------------------*/
+/* Apply the profile and report where it lands */
+RPU_INIT_TEXT int xRpuQosInit(void)
+{
+    u32 i;
+
+    for (i = 0; i < QOS_PORTS; i++) {
+        const struct qos_port *p = &xQosPort[i];
+
+        if (!((RPU_QOS_PORTS) & (1U << i))) {
+            continue;
+        }
+        Xil_Out32(p->afifm + AFIFM_RDQOS, RPU_QOS_LEVEL & AFIFM_QOS_MASK);
+        Xil_Out32(p->afifm + AFIFM_WRQOS, RPU_QOS_LEVEL & AFIFM_QOS_MASK);
+        xil_printf("QoS: %s at %d, DDR port %d %s\r\n", p->name, RPU_QOS_LEVEL,
+                   (int)p->ddrc_port, prvQosClass(p->ddrc_port, RPU_QOS_LEVEL));
+    }
+
+#if RPU_APM
+    // The APM block is mapped and announced by xRpuApmInit()
+    Xil_Out32(APM_ADDR + APM_QOS_PORTS_OFFSET, RPU_QOS_PORTS);
+    Xil_Out32(APM_ADDR + APM_QOS_LEVEL_OFFSET, RPU_QOS_LEVEL);
+#endif
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_QOS */
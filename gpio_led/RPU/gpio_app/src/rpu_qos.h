@@ -0,0 +1,65 @@
+/*
+ * DDR QoS profile for the RPU-facing PL ports (build option RPU_QOS=1,
+ * UserConfig.cmake; RPU0 firmware only).
+ *
+ * xRpuQosInit() raises the AXI QoS that the PS AXI FIFO interfaces (AFIFM)
+ * of the ports in RPU_QOS_PORTS put on the reads and writes of their PL
+ * masters to RPU_QOS_LEVEL. By default these are HP0, which carries the
+ * pattern_out DMA, and S_AXI_LPD. The DDR controller maps each port's QoS onto
+ * its traffic classes through the
+ * PCFGQOS registers programmed by psu_init: on the HP ports QoS above 3 is
+ * video (VPR, bounded latency), on the RPU port QoS above 11 is high
+ * priority (HPR). The class every promoted port lands in is logged.
+ *
+ * The DDR controller itself is left as psu_init programmed it: its port and
+ * class registers may only change while it is held idle. The R5 cores issue
+ * their own AXI QoS, and no register of the BSP overrides it, so the RPU's
+ * own DDR traffic keeps its class. With RPU_APM=1 the applied profile is
+ * published in the APM block (APM_QOS_*, rpu_shm.h), so that
+ * apu_app/rpu_stats --apm runs with and without the profile can be compared.
+ */
+
+#ifndef RPU_QOS_H
+#define RPU_QOS_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "rpu_core.h"
+
+#ifndef RPU_QOS
+#define RPU_QOS 0
+#endif
+
+/* AFIFM ports, bits of RPU_QOS_PORTS */
+#define RPU_QOS_HPC0            (1U << 0)
+#define RPU_QOS_HPC1            (1U << 1)
+#define RPU_QOS_HP0             (1U << 2)
+#define RPU_QOS_HP1             (1U << 3)
+#define RPU_QOS_HP2             (1U << 4)
+#define RPU_QOS_HP3             (1U << 5)
+#define RPU_QOS_LPD             (1U << 6)   // S_AXI_LPD
+
+#ifndef RPU_QOS_PORTS
+#define RPU_QOS_PORTS           (RPU_QOS_HP0 | RPU_QOS_LPD)
+#endif
+#ifndef RPU_QOS_LEVEL
+#define RPU_QOS_LEVEL           15          // 0..15, AxQOS of the promoted ports
+#endif
+
+#if RPU_QOS
+#if RPU_CORE != 0
+#error "RPU_QOS is for the RPU0 firmware: the PS ports are shared by both cores"
+#endif
+#if RPU_QOS_LEVEL < 0 || RPU_QOS_LEVEL > 15
+#error "RPU_QOS_LEVEL must be 0..15"
+#endif
+
+int xRpuQosInit(void);
+#else
+static inline int xRpuQosInit(void)
+{
+    return XST_SUCCESS;
+}
+#endif /* RPU_QOS */
+
+#endif /* RPU_QOS_H */
@@ -0,0 +1,48 @@
+/*
+ * Pseudo-random values of the blink task (BLINK_RANDOM and the pattern RAND
+ * instruction).
+ *
+ * An xorshift32 generator whose state belongs to the task using it: a few
+ * ALU instructions per value, no newlib reentrancy state and no division,
+ * and the same sequence from the same seed. The APU reseeds it with
+ * RPU_CMD_SEED (common/rpu_shm.h) to replay a random mode in a benchmark;
+ * until then it starts from RPU_RAND_SEED, so every boot repeats it too.
+ */
+
+#ifndef RPU_RAND_H
+#define RPU_RAND_H
+
+#include "xil_types.h"
+
+#ifndef RPU_RAND_SEED
+#define RPU_RAND_SEED 0x2545F491U
+#endif
+
+typedef struct {
+    u32 state;
+} RpuRand_t;
+
+/* xorshift32 must not start from 0, which would be a fixed point */
+static inline void vRpuRandSeed(RpuRand_t *rng, u32 seed)
+{
+    rng->state = (seed != 0) ? seed : RPU_RAND_SEED;
+}
+
+static inline u32 ulRpuRandNext(RpuRand_t *rng)
+{
+    u32 x = rng->state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng->state = x;
+    return x;
+}
+
+/* Value in [0, n), from the high bits by a multiply instead of a modulo */
+static inline u32 ulRpuRandBelow(RpuRand_t *rng, u32 n)
+{
+    return (u32)(((u64)ulRpuRandNext(rng) * n) >> 32);
+}
+
+#endif /* RPU_RAND_H */
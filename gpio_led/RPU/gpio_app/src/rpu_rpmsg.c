@@ -0,0 +1,301 @@
+/*
+ * RPMsg/OpenAMP transport (see rpu_rpmsg.h, rpu_shm.h).
+ *
+ * The remoteproc ops are the minimal set of a virtio device that Linux
+ * boots: the memories are identity mapped (the R5 has no MMU), notify
+ * raises the IPI to the APU channel, and there is no IPI interrupt of our
+ * own to register because IPI_Handler already wakes the IPI task for every
+ * doorbell. The memory descriptors are static, like every other kernel
+ * object of this firmware; only OpenAMP's virtio objects come from the heap.
+ */
+
+#include "rpu_rpmsg.h"
+
+#if RPU_RPMSG
+
+#include <stddef.h>
+#include <string.h>
+#include <xil_io.h>
+#include "xil_mpu.h"
+
+#include <metal/sys.h>
+#include <metal/io.h>
+#include <openamp/remoteproc.h>
+#include <openamp/rpmsg_virtio.h>
+
+#include "task.h"
+
+#include "kr260_regs.h"
+#include "rpu_log.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+#include "rpu_trace.h"
+
+#if configSUPPORT_DYNAMIC_ALLOCATION == 0
+#error "RPU_RPMSG needs configSUPPORT_DYNAMIC_ALLOCATION in the BSP (OpenAMP allocates its virtio objects)"
+#endif
+
+#define RPMSG_SHM_BASE         RPMSG_SHM_ADDR_CORE(RPU_CORE)
+#define RPMSG_VRING_ALIGN      0x1000
+#define RPMSG_VRING_SIZE       256   // Buffers per direction
+#define RPMSG_VIRTIO_ID        7     // VIRTIO_ID_RPMSG
+#define RPMSG_READY_POLL_MS    10
+#define RPMSG_MAX_MEMS         2     // Resource table and the vring memory
+#define RPMSG_TASK_STACK_SIZE  (2 * configMINIMAL_STACK_SIZE)
+
+// IPI to the APU channel (main.c raises it the same way)
+#define RPMSG_APU_MASK         0x01
+
+/* Resource table: one RPMsg vdev with two vrings placed by Linux */
+struct rpu_rsc_table {
+    u32 version;
+    u32 num;
+    u32 reserved[2];
+    u32 offset[1];
+    struct fw_rsc_vdev vdev;
+    struct fw_rsc_vdev_vring vring0;  /* RPU -> APU */
+    struct fw_rsc_vdev_vring vring1;  /* APU -> RPU */
+} __attribute__((packed));
+
+static struct rpu_rsc_table xRscTable
+    __attribute__((section(".resource_table"), used, aligned(8))) = {
+    .version = 1,
+    .num = 1,
+    .reserved = { 0, 0 },
+    .offset = { offsetof(struct rpu_rsc_table, vdev) },
+    .vdev = { RSC_VDEV, RPMSG_VIRTIO_ID, 0, 1U << VIRTIO_RPMSG_F_NS, 0, 0, 0, 2, { 0, 0 } },
+    .vring0 = { FW_RSC_U32_ADDR_ANY, RPMSG_VRING_ALIGN, RPMSG_VRING_SIZE, 1, 0 },
+    .vring1 = { FW_RSC_U32_ADDR_ANY, RPMSG_VRING_ALIGN, RPMSG_VRING_SIZE, 2, 0 },
+};
+
+static struct remoteproc xRproc;
+static struct rpmsg_virtio_device xRpmsgVdev;
+static struct rpmsg_endpoint xCmdEpt;
+static struct remoteproc_mem xRprocMem[RPMSG_MAX_MEMS];
+static struct metal_io_region xRprocIo[RPMSG_MAX_MEMS];
+static u32 ulRprocMemCount;
+static volatile u32 ulRpmsgReady;
+static u32 ulRpmsgAnswered;
+static RpuRpmsgExec_t xRpmsgExec;
+
+static StaticTask_t xRpmsgTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xRpmsgStack, RPMSG_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+static struct remoteproc *prvRprocInit(struct remoteproc *rproc,
+                                       const struct remoteproc_ops *ops, void *arg)
+{
+    (void)arg;
+    rproc->ops = ops;
+    return rproc;
+}
+
+static void prvRprocRemove(struct remoteproc *rproc)
+{
+    (void)rproc;
+}
+
+/*-----------------------------------------------------------*/
+/* Identity mapping: physical, device and virtual addresses are the same */
+static void *prvRprocMmap(struct remoteproc *rproc, metal_phys_addr_t *pa,
+                          metal_phys_addr_t *da, size_t size,
+                          unsigned int attribute, struct metal_io_region **io)
+{
+    struct remoteproc_mem *mem;
+    struct metal_io_region *region;
+    metal_phys_addr_t lpa = *pa;
+    metal_phys_addr_t lda = *da;
+
+    if (lpa == METAL_BAD_PHYS && lda == METAL_BAD_PHYS) {
+        return NULL;
+    }
+    if (lpa == METAL_BAD_PHYS) {
+        lpa = lda;
+    }
+    if (lda == METAL_BAD_PHYS) {
+        lda = lpa;
+    }
+    if (ulRprocMemCount >= RPMSG_MAX_MEMS) {
+        return NULL;
+    }
+
+    mem = &xRprocMem[ulRprocMemCount];
+    region = &xRprocIo[ulRprocMemCount];
+    ulRprocMemCount++;
+
+    remoteproc_init_mem(mem, NULL, lpa, lda, size, region);
+    metal_io_init(region, (void *)lpa, &mem->pa, size, (unsigned int)-1, attribute, NULL);
+    remoteproc_add_mem(rproc, mem);
+
+    *pa = lpa;
+    *da = lda;
+    if (io != NULL) {
+        *io = region;
+    }
+    return metal_io_phys_to_virt(region, mem->pa);
+}
+
+/*-----------------------------------------------------------*/
+/* Kick Linux: an IPI to the APU channel, taken by its IPI mailbox */
+static int prvRprocNotify(struct remoteproc *rproc, uint32_t id)
+{
+    (void)rproc;
+    (void)id;
+    __sync_synchronize();
+    Xil_Out32(IPI_CH_BASE + IPI_TRIG_OFFSET, RPMSG_APU_MASK);
+    return 0;
+}
+
+static const struct remoteproc_ops xRprocOps = {
+    .init = prvRprocInit,
+    .remove = prvRprocRemove,
+    .mmap = prvRprocMmap,
+    .notify = prvRprocNotify,
+};
+
+/*-----------------------------------------------------------*/
+/* A batch of command messages on the endpoint (IPI task context)
+ * - The request is read in place; the responses go straight into a TX
+ *   buffer, which is sent back to the requesting address
+ */
+static int prvRpmsgCommand(struct rpmsg_endpoint *ept, void *data, size_t len,
+                           uint32_t src, void *priv)
+{
+    const u32 *req = (const u32 *)data;
+    u32 count = len / RPU_RPMSG_MSG_SIZE;
+    uint32_t room;
+    u32 *resp;
+    u32 i;
+
+    (void)priv;
+    if (count == 0 || count > RPU_RPMSG_BATCH_MAX || len % RPU_RPMSG_MSG_SIZE != 0) {
+        RPU_LOG("RPMsg: dropped a %d-byte payload\r\n", (int)len);
+        return RPMSG_SUCCESS;
+    }
+
+    // Blocks until Linux returns a buffer; the IPI task waits, not spins
+    resp = (u32 *)rpmsg_get_tx_payload_buffer(ept, &room, 1);
+    if (resp == NULL) {
+        return RPMSG_SUCCESS;
+    }
+    if (room < count * RPU_RPMSG_MSG_SIZE) {
+        (void)rpmsg_release_tx_buffer(ept, resp);
+        return RPMSG_SUCCESS;
+    }
+
+    for (i = 0; i < count; i++) {
+        const u32 *msg = &req[i * SHM_IPI_MSG_WORDS];
+        u32 *out = &resp[i * SHM_IPI_MSG_WORDS];
+        u32 hdr = msg[0];
+        u32 nargs = RPU_MSG_HDR_LEN(hdr);
+
+        memset(out, 0, RPU_RPMSG_MSG_SIZE);
+        out[0] = hdr;
+        if (nargs > SHM_IPI_MSG_DATA_WORDS) {
+            out[1] = RPU_CMD_STATUS_BADARG;
+        } else {
+            out[1] = xRpmsgExec(RPU_MSG_HDR_OPCODE(hdr), &msg[1], nargs, &out[2]);
+        }
+        vRpuTrace(RPU_TRACE_MSG, hdr, out[1]);
+    }
+
+    (void)rpmsg_sendto_nocopy(ept, resp, count * RPU_RPMSG_MSG_SIZE, src);
+    ulRpmsgAnswered += count;
+    return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* The RPMsg Task:
+ * - Waits for Linux to bring the vdev up, creates the endpoint and ends.
+ *   OpenAMP would busy-wait for DRIVER_OK; polling it here lets the lower
+ *   priority tasks and the idle task run meanwhile.
+ */
+static void prvRpmsgTask( void *pvParameters )
+{
+    volatile struct fw_rsc_vdev *vdev_rsc = &xRscTable.vdev;
+    struct virtio_device *vdev;
+    struct metal_io_region *shm_io;
+    struct rpmsg_device *rdev;
+
+    (void)pvParameters;
+
+    while ((vdev_rsc->status & VIRTIO_CONFIG_STATUS_DRIVER_OK) == 0) {
+        vTaskDelay(pdMS_TO_TICKS(RPMSG_READY_POLL_MS));
+    }
+
+    vdev = remoteproc_create_virtio(&xRproc, 0, VIRTIO_DEV_DEVICE, NULL);
+    shm_io = remoteproc_get_io_with_pa(&xRproc, RPMSG_SHM_BASE);
+    if (vdev == NULL || shm_io == NULL ||
+        rpmsg_init_vdev(&xRpmsgVdev, vdev, NULL, shm_io, NULL) != 0) {
+        RPU_LOG("RPMsg: virtio device setup failed\r\n");
+        vTaskDelete(NULL);
+    }
+
+    rdev = rpmsg_virtio_get_rpmsg_device(&xRpmsgVdev);
+    if (rpmsg_create_ept(&xCmdEpt, rdev, RPU_RPMSG_CMD_NAME, RPU_RPMSG_CMD_ADDR,
+                         RPMSG_ADDR_ANY, prvRpmsgCommand, NULL) != RPMSG_SUCCESS) {
+        RPU_LOG("RPMsg: endpoint creation failed\r\n");
+        vTaskDelete(NULL);
+    }
+
+    ulRpmsgReady = 1;
+    RPU_LOG("RPMsg endpoint %s at 0x%x\r\n", RPU_RPMSG_CMD_NAME, RPU_RPMSG_CMD_ADDR);
+    vTaskDelete(NULL);
+}
+
+/*-----------------------------------------------------------*/
+/* Process the vrings after a doorbell (IPI task context) */
+u32 ulRpuRpmsgPoll(void)
+{
+    u32 before = ulRpmsgAnswered;
+
+    if (ulRpmsgReady) {
+        (void)remoteproc_get_notification(&xRproc, RSC_NOTIFY_ID_ANY);
+    }
+    return ulRpmsgAnswered - before;
+}
+
+/*-----------------------------------------------------------*/
+/* Set up libmetal and the remoteproc instance, and start the RPMsg task */
+RPU_INIT_TEXT int xRpuRpmsgInit(RpuRpmsgExec_t exec, UBaseType_t task_priority)
+{
+    struct metal_init_params metal_param = METAL_INIT_DEFAULTS;
+    metal_phys_addr_t pa;
+
+    xRpmsgExec = exec;
+    if (metal_init(&metal_param) != 0) {
+        return XST_FAILURE;
+    }
+
+    // Vrings and buffers: non-cacheable like the other shared memories
+    Xil_SetTlbAttributes(RPMSG_SHM_BASE, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+
+    if (remoteproc_init(&xRproc, &xRprocOps, NULL) == NULL) {
+        return XST_FAILURE;
+    }
+    // The resource table is in BTCM, never cached
+    pa = (metal_phys_addr_t)(UINTPTR)&xRscTable;
+    if (remoteproc_mmap(&xRproc, &pa, NULL, sizeof(xRscTable), 0, &xRproc.rsc_io) == NULL) {
+        return XST_FAILURE;
+    }
+    pa = RPMSG_SHM_BASE;
+    if (remoteproc_mmap(&xRproc, &pa, NULL, RPMSG_SHM_SIZE,
+                        NORM_SHARED_NCACHE | PRIV_RW_USER_RW, NULL) == NULL) {
+        return XST_FAILURE;
+    }
+    if (remoteproc_set_rsc_table(&xRproc, (struct resource_table *)&xRscTable,
+                                 sizeof(xRscTable)) != 0) {
+        return XST_FAILURE;
+    }
+
+    (void)xTaskCreateStatic( prvRpmsgTask,
+                             ( const char * ) "RPMsg",
+                             RPMSG_TASK_STACK_SIZE,
+                             NULL,
+                             task_priority,
+                             RPU_TASK_STACK_BUF(xRpmsgStack),
+                             &xRpmsgTaskBuffer );
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_RPMSG */
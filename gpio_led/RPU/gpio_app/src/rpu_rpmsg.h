@@ -0,0 +1,59 @@
+/*
+ * RPMsg/OpenAMP transport (build option RPU_RPMSG=1, UserConfig.cmake).
+ *
+ * The firmware becomes a virtio device of Linux remoteproc: a resource table
+ * (.resource_table, BTCM) announces one RPMsg vdev, Linux allocates its
+ * vrings and buffers in RPMSG_SHM_ADDR_CORE (rpu_shm.h) and kicks over the
+ * same IPI channel as the custom protocol, through its IPI mailbox driver.
+ * The RPU announces the endpoint RPU_RPMSG_CMD_NAME, which rpmsg_char
+ * exports as /dev/rpmsgN (kr260hal RpmsgChannel).
+ *
+ * Each RPMsg payload is a batch of command messages, executed by the same
+ * function as the IPI message path, and answered zero-copy: the responses
+ * are written straight into a vring buffer (rpmsg_get_tx_payload_buffer)
+ * and sent with rpmsg_sendto_nocopy(). The request is read in place in its
+ * vring buffer as well.
+ *
+ * - xRpuRpmsgInit() starts a task that waits for Linux to bring the vdev up
+ *   (DRIVER_OK in the resource table) and creates the endpoint
+ * - ulRpuRpmsgPoll() processes the vrings; the IPI task calls it for every
+ *   doorbell, since a kick is an ordinary IPI from the APU channel
+ *
+ * Needs the BSP built with the openamp and libmetal libraries and
+ * configSUPPORT_DYNAMIC_ALLOCATION (OpenAMP allocates its virtio objects).
+ * Without RPU_RPMSG both functions are empty and no OpenAMP code is linked.
+ */
+
+#ifndef RPU_RPMSG_H
+#define RPU_RPMSG_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_RPMSG
+#define RPU_RPMSG 0
+#endif
+
+// Command executor of the message path (main.c)
+typedef u32 (*RpuRpmsgExec_t)(u32 opcode, const u32 *args, u32 nargs, u32 *results);
+
+#if RPU_RPMSG
+int xRpuRpmsgInit(RpuRpmsgExec_t exec, UBaseType_t task_priority);
+u32 ulRpuRpmsgPoll(void);     /* Returns the number of messages answered */
+#else
+static inline int xRpuRpmsgInit(RpuRpmsgExec_t exec, UBaseType_t task_priority)
+{
+    (void)exec;
+    (void)task_priority;
+    return XST_SUCCESS;
+}
+
+static inline u32 ulRpuRpmsgPoll(void)
+{
+    return 0;
+}
+#endif /* RPU_RPMSG */
+
+#endif /* RPU_RPMSG_H */
@@ -0,0 +1,458 @@
+/*
+ * TTC-triggered sensor reads over the PS I2C or SPI (see rpu_sensor.h,
+ * rpu_shm.h).
+ *
+ * The trigger and the bus interrupt are at the same level, so neither
+ * preempts the other and the read state needs no lock. A buffer is FREE,
+ * FILLING (a read in flight, owned by the interrupts) or READY (owned by the
+ * task until it has published it); the interrupts fill the buffers in turn
+ * and the task publishes them in the same order. A read whose completion
+ * never comes is aborted after SENSOR_STUCK_TRIGGERS periods and counted as
+ * an error, so a wedged bus costs samples, not the pipeline.
+ */
+
+#include "rpu_sensor.h"
+
+#if RPU_SENSOR
+
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xttcps.h"
+#include "xinterrupt_wrap.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#if RPU_SENSOR_BUS == SENSOR_BUS_I2C
+#include "xiicps.h"
+#else
+#include "xspips.h"
+#endif
+
+#include "rpu_ring.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+
+#define SENSOR_TASK_STACK_SIZE configMINIMAL_STACK_SIZE
+#define SENSOR_STUCK_TRIGGERS  8
+#define SENSOR_BUF_FREE        0
+#define SENSOR_BUF_FILLING     1
+#define SENSOR_BUF_READY       2
+
+// SPI clocks the register byte out first and receives a dummy byte for it
+#if RPU_SENSOR_BUS == SENSOR_BUS_SPI
+#define SENSOR_SKIP            1
+#else
+#define SENSOR_SKIP            0
+#endif
+#define SENSOR_XFER_BYTES      (SENSOR_SKIP + RPU_SENSOR_LEN)
+
+struct sensor_buf {
+    u64 ts;
+    u32 seq;
+    u32 state;        // SENSOR_BUF_*
+    u8 rx[SENSOR_XFER_BYTES];
+};
+
+static const u8 xSensorInitWrites[][2] = RPU_SENSOR_INIT_WRITES;
+
+// Everything the interrupts touch is in TCM (rpu_tcm.h)
+static XTtcPs xSensorTtc RPU_BTCM_BSS;
+#if RPU_SENSOR_BUS == SENSOR_BUS_I2C
+static XIicPs xSensorIic RPU_BTCM_BSS;
+static u8 ucSensorReg RPU_BTCM_BSS;
+#else
+static XSpiPs xSensorSpi RPU_BTCM_BSS;
+static u8 ucSensorTx[SENSOR_XFER_BYTES] RPU_BTCM_BSS;
+#endif
+static struct sensor_buf xSensorBuf[2] RPU_BTCM_BSS;
+static u32 ulSensorFill RPU_BTCM_BSS;       /* Buffer of the next read */
+static u32 ulSensorBusy RPU_BTCM_BSS;       /* A read is in flight */
+static u32 ulSensorStuck RPU_BTCM_BSS;      /* Triggers since it started */
+static u32 ulSensorTriggers RPU_BTCM_BSS;
+static u32 ulSensorSkipped RPU_BTCM_BSS;
+static u32 ulSensorErrors RPU_BTCM_BSS;
+static TaskHandle_t xSensorTask RPU_BTCM_BSS;
+static rpu_ring_t xSensorRing;
+static StaticTask_t xSensorTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xSensorStack, SENSOR_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* End of the read in the fill buffer: hand it to the task, or free it again
+ * after an error (interrupt context) */
+RPU_ATCM_TEXT static void prvSensorDone(int ok)
+{
+    struct sensor_buf *buf = &xSensorBuf[ulSensorFill];
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    ulSensorBusy = 0;
+    if (ok) {
+        __atomic_store_n(&buf->state, SENSOR_BUF_READY, __ATOMIC_RELEASE);
+        ulSensorFill ^= 1;
+    } else {
+        ulSensorErrors++;
+        buf->state = SENSOR_BUF_FREE;
+    }
+    vTaskNotifyGiveFromISR(xSensorTask, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+#if RPU_SENSOR_BUS == SENSOR_BUS_I2C
+/*-----------------------------------------------------------*/
+/* Register address sent with the bus held: read with a repeated start, which
+ * ends with a stop since the option is cleared (interrupt context) */
+RPU_ATCM_TEXT static void prvSensorBusEvent(void *CallBackRef, u32 StatusEvent)
+{
+    UINTPTR base = xSensorIic.Config.BaseAddress;
+
+    (void)CallBackRef;
+    if ((StatusEvent & ~(u32)(XIICPS_EVENT_COMPLETE_SEND | XIICPS_EVENT_COMPLETE_RECV)) != 0) {
+        // The driver keeps the bus held after a failed repeated-start phase
+        XIicPs_ClearOptions(&xSensorIic, XIICPS_REP_START_OPTION);
+        XIicPs_WriteReg(base, XIICPS_CR_OFFSET, XIicPs_ReadReg(base, XIICPS_CR_OFFSET) & ~XIICPS_CR_HOLD_MASK);
+        prvSensorDone(0);
+    } else if (StatusEvent & XIICPS_EVENT_COMPLETE_SEND) {
+        XIicPs_ClearOptions(&xSensorIic, XIICPS_REP_START_OPTION);
+        XIicPs_MasterRecv(&xSensorIic, xSensorBuf[ulSensorFill].rx, RPU_SENSOR_LEN, RPU_SENSOR_DEV);
+    } else if (StatusEvent & XIICPS_EVENT_COMPLETE_RECV) {
+        prvSensorDone(1);
+    }
+}
+
+RPU_ATCM_TEXT static void prvSensorStart(struct sensor_buf *buf)
+{
+    (void)buf;
+    XIicPs_SetOptions(&xSensorIic, XIICPS_REP_START_OPTION);
+    XIicPs_MasterSend(&xSensorIic, &ucSensorReg, 1, RPU_SENSOR_DEV);
+}
+
+static void prvSensorAbort(void)
+{
+    XIicPs_ClearOptions(&xSensorIic, XIICPS_REP_START_OPTION);
+    XIicPs_Abort(&xSensorIic);
+}
+#else
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT static void prvSensorBusEvent(const void *CallBackRef, u32 StatusEvent, u32 ByteCount)
+{
+    (void)CallBackRef;
+    (void)ByteCount;
+    prvSensorDone(StatusEvent == XST_SPI_TRANSFER_DONE);
+}
+
+RPU_ATCM_TEXT static void prvSensorStart(struct sensor_buf *buf)
+{
+    if (XSpiPs_Transfer(&xSensorSpi, ucSensorTx, buf->rx, SENSOR_XFER_BYTES) != XST_SUCCESS) {
+        prvSensorDone(0);
+    }
+}
+
+static void prvSensorAbort(void)
+{
+    XSpiPs_Abort(&xSensorSpi);
+}
+#endif /* RPU_SENSOR_BUS */
+
+/*-----------------------------------------------------------*/
+/* Counter interrupt: start a read into the fill buffer if it is free */
+RPU_ATCM_TEXT static void prvSensorTrigger(void *CallbackRef)
+{
+    struct sensor_buf *buf = &xSensorBuf[ulSensorFill];
+
+    (void)CallbackRef;
+    // Reading the status register clears it
+    (void)XTtcPs_GetInterruptStatus(&xSensorTtc);
+    ulSensorTriggers++;
+
+    if (ulSensorBusy) {
+        ulSensorSkipped++;
+        if (++ulSensorStuck >= SENSOR_STUCK_TRIGGERS) {
+            prvSensorAbort();
+            prvSensorDone(0);
+        }
+        return;
+    }
+    if (__atomic_load_n(&buf->state, __ATOMIC_ACQUIRE) != SENSOR_BUF_FREE) {
+        ulSensorSkipped++;   // The task still has both buffers
+        return;
+    }
+
+    buf->seq = ulSensorTriggers;
+    buf->ts = ullRpuTimeNow();
+    buf->state = SENSOR_BUF_FILLING;
+    ulSensorBusy = 1;
+    ulSensorStuck = 0;
+    prvSensorStart(buf);
+}
+
+/*-----------------------------------------------------------*/
+/* Write a ready buffer as a struct rpu_sensor_sample into a ring slot, in
+ * words (the APU maps OCM as Device memory, see rpu_ring.h) */
+static void prvSensorFillSlot(volatile u32 *slot, const struct sensor_buf *buf)
+{
+    const u8 *rx = &buf->rx[SENSOR_SKIP];
+    u32 i, w;
+
+    slot[0] = buf->seq;
+    slot[1] = (u32)buf->ts;
+    slot[2] = (u32)(buf->ts >> 32);
+    slot[3] = RPU_SENSOR_LEN;
+    for (w = 0; w < SENSOR_MAX_BYTES / 4; w++) {
+        u32 word = 0;
+
+        // Little-endian, as data[] of the struct on both sides
+        for (i = 0; i < 4; i++) {
+            if (w * 4 + i < RPU_SENSOR_LEN) {
+                word |= (u32)rx[w * 4 + i] << (8 * i);
+            }
+        }
+        slot[4 + w] = word;
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Publish the ready buffers in the order they were filled, then the
+ * counters; sleeps until the next completion */
+static void prvSensorTask(void *pvParameters)
+{
+    u32 next = 0;
+    u32 samples = 0;
+    u32 full = 0;
+    u64 xfer_max = 0;
+
+    (void)pvParameters;
+    for (;;) {
+        u32 pushed = 0;
+
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (__atomic_load_n(&xSensorBuf[next].state, __ATOMIC_ACQUIRE) == SENSOR_BUF_READY) {
+            struct sensor_buf *buf = &xSensorBuf[next];
+            volatile u32 *slot;
+            u64 xfer = ullRpuTimeNow() - buf->ts;
+
+            // Straight into the next free slot: no sample is built and copied
+            if (rpu_ring_reserve(&xSensorRing, 1, &slot) == 1) {
+                prvSensorFillSlot(slot, buf);
+                (void)rpu_ring_commit(&xSensorRing, 1);
+                pushed++;
+            } else {
+                full++;
+            }
+            __atomic_store_n(&buf->state, SENSOR_BUF_FREE, __ATOMIC_RELEASE);
+            next ^= 1;
+
+            if (xfer > xfer_max) {
+                xfer_max = xfer;
+            }
+        }
+        samples += pushed;
+
+        Xil_Out32(SENSOR_ADDR + SENSOR_TRIGGERS_OFFSET, ulSensorTriggers);
+        Xil_Out32(SENSOR_ADDR + SENSOR_SAMPLES_OFFSET, samples);
+        Xil_Out32(SENSOR_ADDR + SENSOR_SKIPPED_OFFSET, ulSensorSkipped);
+        Xil_Out32(SENSOR_ADDR + SENSOR_ERRORS_OFFSET, ulSensorErrors);
+        Xil_Out32(SENSOR_ADDR + SENSOR_FULL_OFFSET, full);
+        Xil_Out32(SENSOR_ADDR + SENSOR_XFER_MAX_OFFSET, (u32)ullRpuTimeToNs(xfer_max));
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Controller setup and the device's start-up writes, polled before the
+ * interrupts are connected */
+#if RPU_SENSOR_BUS == SENSOR_BUS_I2C
+static int prvSensorBusSetup(u16 intr_priority)
+{
+    XIicPs_Config *cfg;
+    u32 i;
+    int Status;
+
+    cfg = XIicPs_LookupConfig(XPAR_XIICPS_0_BASEADDR);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    Status = XIicPs_CfgInitialize(&xSensorIic, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    Status = XIicPs_SetSClk(&xSensorIic, RPU_SENSOR_I2C_HZ);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    for (i = 0; i < sizeof(xSensorInitWrites) / sizeof(xSensorInitWrites[0]); i++) {
+        u8 msg[2] = { xSensorInitWrites[i][0], xSensorInitWrites[i][1] };
+
+        Status = XIicPs_MasterSendPolled(&xSensorIic, msg, 2, RPU_SENSOR_DEV);
+        if (Status != XST_SUCCESS) {
+            return Status;
+        }
+        while (XIicPs_BusIsBusy(&xSensorIic)) {
+        }
+    }
+    ucSensorReg = RPU_SENSOR_REG;
+
+    XIicPs_SetStatusHandler(&xSensorIic, NULL, prvSensorBusEvent);
+    Status = XSetupInterruptSystem(&xSensorIic, (Xil_ExceptionHandler)XIicPs_MasterInterruptHandler,
+                                   cfg->IntrId, cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId, cfg->IntrParent);
+    return XST_SUCCESS;
+}
+#else
+static int prvSensorBusSetup(u16 intr_priority)
+{
+    XSpiPs_Config *cfg;
+    u32 options = XSPIPS_MASTER_OPTION | XSPIPS_FORCE_SSELECT_OPTION;
+    u8 prescaler = XSPIPS_CLK_PRESCALE_4;
+    u32 i;
+    int Status;
+
+    cfg = XSpiPs_LookupConfig(XPAR_XSPIPS_0_BASEADDR);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    Status = XSpiPs_CfgInitialize(&xSensorSpi, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    if (RPU_SENSOR_SPI_MODE & 2) {
+        options |= XSPIPS_CLK_ACTIVE_LOW_OPTION;
+    }
+    if (RPU_SENSOR_SPI_MODE & 1) {
+        options |= XSPIPS_CLK_PHASE_1_OPTION;
+    }
+    Status = XSpiPs_SetOptions(&xSensorSpi, options);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    // Divider 2^(prescaler + 1)
+    while ((4U << (prescaler - XSPIPS_CLK_PRESCALE_4)) < RPU_SENSOR_SPI_DIV &&
+           prescaler < XSPIPS_CLK_PRESCALE_256) {
+        prescaler++;
+    }
+    Status = XSpiPs_SetClkPrescaler(&xSensorSpi, prescaler);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    Status = XSpiPs_SetSlaveSelect(&xSensorSpi, RPU_SENSOR_DEV);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    for (i = 0; i < sizeof(xSensorInitWrites) / sizeof(xSensorInitWrites[0]); i++) {
+        u8 msg[2] = { xSensorInitWrites[i][0] & (u8)~RPU_SENSOR_SPI_READ, xSensorInitWrites[i][1] };
+
+        Status = XSpiPs_PolledTransfer(&xSensorSpi, msg, NULL, 2);
+        if (Status != XST_SUCCESS) {
+            return Status;
+        }
+    }
+    ucSensorTx[0] = RPU_SENSOR_REG | RPU_SENSOR_SPI_READ;
+    for (i = 1; i < SENSOR_XFER_BYTES; i++) {
+        ucSensorTx[i] = 0;
+    }
+
+    XSpiPs_SetStatusHandler(&xSensorSpi, NULL, prvSensorBusEvent);
+    Status = XSetupInterruptSystem(&xSensorSpi, (Xil_ExceptionHandler)XSpiPs_InterruptHandler,
+                                   cfg->IntrId, cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId, cfg->IntrParent);
+    return XST_SUCCESS;
+}
+#endif /* RPU_SENSOR_BUS */
+
+/*-----------------------------------------------------------*/
+/* Bus and device, ring, task, then the trigger; announces the block */
+RPU_INIT_TEXT int xRpuSensorInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    XTtcPs_Config *cfg;
+    u64 interval;
+    int Status;
+
+    Xil_SetTlbAttributes(SENSOR_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(SENSOR_ADDR + SENSOR_MAGIC_OFFSET, 0);
+
+    cfg = XTtcPs_LookupConfig(RPU_CORE_SENSOR_TTC);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    Status = XTtcPs_CfgInitialize(&xSensorTtc, cfg, cfg->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        // Left running by a previous firmware instance
+        XTtcPs_Stop(&xSensorTtc);
+        Status = XTtcPs_CfgInitialize(&xSensorTtc, cfg, cfg->BaseAddress);
+    }
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    Status = XTtcPs_SetOptions(&xSensorTtc, XTTCPS_OPTION_INTERVAL_MODE | XTTCPS_OPTION_WAVE_DISABLE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    // Interval mode counts 0..interval, i.e. interval + 1 clocks per trigger
+    interval = cfg->InputClockHz / RPU_SENSOR_HZ;
+    if (interval < 2 || interval > XTTCPS_MAX_INTERVAL_COUNT) {
+        return XST_FAILURE;
+    }
+    XTtcPs_SetInterval(&xSensorTtc, (XInterval)(interval - 1));
+    XTtcPs_ClearInterruptStatus(&xSensorTtc, XTtcPs_GetInterruptStatus(&xSensorTtc));
+    XTtcPs_EnableInterrupts(&xSensorTtc, XTTCPS_IXR_INTERVAL_MASK);
+
+    Status = prvSensorBusSetup(intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    if (rpu_ring_format((volatile void *)(SENSOR_ADDR + SENSOR_RING_OFFSET), SENSOR_RING_SLOTS,
+                        SENSOR_SAMPLE_SIZE, 0) != 0 ||
+        rpu_ring_attach(&xSensorRing, (volatile void *)(SENSOR_ADDR + SENSOR_RING_OFFSET),
+                        RPU_RING_PRODUCER) != 0) {
+        return XST_FAILURE;
+    }
+
+    xSensorBuf[0].state = SENSOR_BUF_FREE;
+    xSensorBuf[1].state = SENSOR_BUF_FREE;
+    ulSensorFill = 0;
+    ulSensorBusy = 0;
+    ulSensorTriggers = 0;
+    ulSensorSkipped = 0;
+    ulSensorErrors = 0;
+    Xil_Out32(SENSOR_ADDR + SENSOR_HZ_OFFSET, cfg->InputClockHz / (u32)interval);
+    Xil_Out32(SENSOR_ADDR + SENSOR_BUS_OFFSET, RPU_SENSOR_BUS);
+    Xil_Out32(SENSOR_ADDR + SENSOR_DEV_OFFSET, RPU_SENSOR_DEV);
+    Xil_Out32(SENSOR_ADDR + SENSOR_REG_OFFSET, RPU_SENSOR_REG);
+    Xil_Out32(SENSOR_ADDR + SENSOR_LEN_OFFSET, RPU_SENSOR_LEN);
+    Xil_Out32(SENSOR_ADDR + SENSOR_TRIGGERS_OFFSET, 0);
+    Xil_Out32(SENSOR_ADDR + SENSOR_SAMPLES_OFFSET, 0);
+    Xil_Out32(SENSOR_ADDR + SENSOR_SKIPPED_OFFSET, 0);
+    Xil_Out32(SENSOR_ADDR + SENSOR_ERRORS_OFFSET, 0);
+    Xil_Out32(SENSOR_ADDR + SENSOR_FULL_OFFSET, 0);
+    Xil_Out32(SENSOR_ADDR + SENSOR_XFER_MAX_OFFSET, 0);
+
+    xSensorTask = xTaskCreateStatic( prvSensorTask,
+                                     ( const char * ) "Sensor",
+                                     SENSOR_TASK_STACK_SIZE,
+                                     NULL,
+                                     task_priority,
+                                     RPU_TASK_STACK_BUF(xSensorStack),
+                                     &xSensorTaskBuffer );
+
+    Status = XSetupInterruptSystem(&xSensorTtc, (Xil_ExceptionHandler)prvSensorTrigger,
+                                   cfg->IntrId[0], cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId[0], cfg->IntrParent);
+
+    __sync_synchronize();
+    Xil_Out32(SENSOR_ADDR + SENSOR_MAGIC_OFFSET, SENSOR_MAGIC);
+    XTtcPs_Start(&xSensorTtc);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_SENSOR */
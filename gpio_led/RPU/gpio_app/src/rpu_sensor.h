@@ -0,0 +1,92 @@
+/*
+ * Sensor acquisition over the PS I2C or SPI controller (build option
+ * RPU_SENSOR=1, UserConfig.cmake; RPU0 firmware only).
+ *
+ * A TTC counter (RPU_CORE_SENSOR_TTC) triggers a read of RPU_SENSOR_LEN
+ * bytes from register RPU_SENSOR_REG of the device RPU_SENSOR_HZ times a
+ * second: on I2C a register-address write and a repeated-start read of the
+ * slave at RPU_SENSOR_DEV, on SPI one transfer on chip select RPU_SENSOR_DEV
+ * with the register byte (ORed with RPU_SENSOR_SPI_READ) in front. Both are
+ * driven by the driver's interrupt handler, not polled. Reads alternate
+ * between two buffers: while a task publishes the last sample into the ring
+ * of the SENSOR block in OCM (rpu_shm.h), the next one fills the other
+ * buffer, so the task has a whole period to run. A trigger that finds no
+ * free buffer is skipped and counted; the APU sees it as a gap in the
+ * trigger counts of the samples (apu_app/rpu_sensor reads the ring).
+ *
+ * The defaults read the accelerometer, temperature and gyroscope registers of
+ * an MPU-6050 style IMU; RPU_SENSOR_INIT_WRITES lists the register writes
+ * made once, polled, before sampling starts (the default wakes the IMU).
+ *
+ * The firmware must own the controller: disable the Linux cdns-i2c or
+ * cdns-spi node of that controller on a board running with this option.
+ */
+
+#ifndef RPU_SENSOR_H
+#define RPU_SENSOR_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_SENSOR
+#define RPU_SENSOR 0
+#endif
+
+#ifndef RPU_SENSOR_BUS
+#define RPU_SENSOR_BUS          SENSOR_BUS_I2C
+#endif
+#ifndef RPU_SENSOR_DEV
+#define RPU_SENSOR_DEV          0x68    // I2C slave address or SPI chip select
+#endif
+#ifndef RPU_SENSOR_REG
+#define RPU_SENSOR_REG          0x3B    // ACCEL_XOUT_H
+#endif
+#ifndef RPU_SENSOR_LEN
+#define RPU_SENSOR_LEN          14      // Accelerometer, temperature, gyroscope
+#endif
+#ifndef RPU_SENSOR_HZ
+#define RPU_SENSOR_HZ           1000
+#endif
+#ifndef RPU_SENSOR_I2C_HZ
+#define RPU_SENSOR_I2C_HZ       400000
+#endif
+#ifndef RPU_SENSOR_SPI_DIV
+#define RPU_SENSOR_SPI_DIV      256     // SPI reference clock divider, 4..256
+#endif
+#ifndef RPU_SENSOR_SPI_MODE
+#define RPU_SENSOR_SPI_MODE     3       // CPOL << 1 | CPHA
+#endif
+#ifndef RPU_SENSOR_SPI_READ
+#define RPU_SENSOR_SPI_READ     0x80    // Read flag of the register byte
+#endif
+/* { register, value } pairs written at start-up */
+#ifndef RPU_SENSOR_INIT_WRITES
+#define RPU_SENSOR_INIT_WRITES  { { 0x6B, 0x00 } }  // PWR_MGMT_1: wake, internal clock
+#endif
+
+#if RPU_SENSOR
+#if RPU_CORE != 0
+#error "RPU_SENSOR is for the RPU0 firmware: the SENSOR block and the trigger TTC are RPU0's"
+#endif
+#if RPU_SENSOR_BUS != SENSOR_BUS_I2C && RPU_SENSOR_BUS != SENSOR_BUS_SPI
+#error "RPU_SENSOR_BUS must be SENSOR_BUS_I2C or SENSOR_BUS_SPI"
+#endif
+#if RPU_SENSOR_LEN < 1 || RPU_SENSOR_LEN > SENSOR_MAX_BYTES
+#error "RPU_SENSOR_LEN must be 1..SENSOR_MAX_BYTES"
+#endif
+
+/* Set up the bus and the device, then start the trigger; intr_priority is
+ * for both the trigger and the bus interrupt */
+int xRpuSensorInit(UBaseType_t task_priority, u16 intr_priority);
+#else
+static inline int xRpuSensorInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    (void)task_priority;
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_SENSOR */
+
+#endif /* RPU_SENSOR_H */
@@ -0,0 +1,43 @@
+/*
+ * Seq word of the blocks the RPU publishes to the APU (rpu_shm.h).
+ *
+ * The word is odd while the writer updates the block and even once the block
+ * is consistent again; a reader copies the block between two reads of the
+ * word and retries when they differ or are odd. The writer keeps its own copy
+ * of the word in local memory, so publishing costs no read of the shared
+ * window.
+ *
+ * ulRpuSeqInit() continues the seq of a previous firmware instance instead
+ * of restarting at 0, so a reader never sees a value repeat across a reload.
+ */
+
+#ifndef RPU_SEQLOCK_H
+#define RPU_SEQLOCK_H
+
+#include <xil_io.h>
+#include "xil_types.h"
+
+/* Take over the word at 'addr': returns the even value to count on from */
+static inline u32 ulRpuSeqInit(UINTPTR addr)
+{
+    u32 seq = Xil_In32(addr) & ~1U;
+
+    Xil_Out32(addr, seq);
+    return seq;
+}
+
+/* Mark the block as being updated (seq goes odd) */
+static inline void vRpuSeqBegin(UINTPTR addr, u32 *seq)
+{
+    Xil_Out32(addr, ++*seq);
+    __sync_synchronize();
+}
+
+/* Publish the update (seq goes even) */
+static inline void vRpuSeqEnd(UINTPTR addr, u32 *seq)
+{
+    __sync_synchronize();
+    Xil_Out32(addr, ++*seq);
+}
+
+#endif /* RPU_SEQLOCK_H */
@@ -0,0 +1,203 @@
+/*
+ * Scheduler-aware sleeps (see rpu_sleep.h).
+ *
+ * The deadline is taken on the system counter at entry, and every step
+ * sleeps at most what is left of it: vTaskDelay(n) returns after n - 1 to n
+ * ticks, so n is the whole ticks left, and the one-shot's interval is the
+ * rest. A wake-up that comes early (the semaphore given by a one-shot that
+ * timed out earlier) just goes round the loop again.
+ */
+
+#include "rpu_sleep.h"
+
+#if RPU_SLEEP_YIELD
+
+#include "xttcps.h"
+#include "xinterrupt_wrap.h"
+#include "xiltimer.h"
+#include "sleep.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "rpu_sensor.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+
+// On RPU0 the one-shot counter is the sensor trigger's (rpu_core.h)
+#define SLEEP_ONESHOT          (RPU_CORE != 0 || !RPU_SENSOR)
+#define SLEEP_ONESHOT_WAIT     2       // Ticks before a lost interrupt is given up
+
+/* The BSP's busy-wait (xiltimer.c) */
+void XilTimer_Sleep(unsigned long delay, XTimer_DelayType DelayType);
+
+#if SLEEP_ONESHOT
+static XTtcPs xSleepTtc RPU_BTCM_BSS;
+static u32 ulSleepTtcHz RPU_BTCM_BSS;      /* 0 until xRpuSleepInit() */
+static u32 ulSleepBusy RPU_BTCM_BSS;       /* A task owns the counter */
+static SemaphoreHandle_t xSleepSem RPU_BTCM_BSS;
+static StaticSemaphore_t xSleepSemBuffer RPU_BTCM_NOINIT;
+#endif /* SLEEP_ONESHOT */
+
+/*-----------------------------------------------------------*/
+/* A task, with the scheduler running and outside a critical section */
+static int prvCanBlock(void)
+{
+    return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING &&
+           ulPortInterruptNesting == 0 && ulCriticalNesting == 0 &&
+           ulRpuTimeHz() != 0;
+}
+
+#if SLEEP_ONESHOT
+/*-----------------------------------------------------------*/
+/* Counter interrupt: the one-shot expired */
+RPU_ATCM_TEXT static void prvSleepHandler(void *CallbackRef)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    (void)CallbackRef;
+
+    // Reading the status register clears it
+    (void)XTtcPs_GetInterruptStatus(&xSleepTtc);
+    XTtcPs_Stop(&xSleepTtc);
+    xSemaphoreGiveFromISR(xSleepSem, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+/* Block for left counter ticks on the one-shot; 0 if the caller has to spin
+ * (not set up, taken by another task, or too short to be worth it) */
+static int prvSleepOneShot(u64 left)
+{
+    u64 interval;
+
+    if (ulSleepTtcHz == 0 || left < (u64)ulRpuTimeHz() * RPU_SLEEP_SPIN_US / 1000000U) {
+        return 0;
+    }
+    interval = left * ulSleepTtcHz / ulRpuTimeHz();
+    if (interval < 2) {
+        return 0;
+    }
+
+    taskENTER_CRITICAL();
+    if (ulSleepBusy) {
+        taskEXIT_CRITICAL();
+        return 0;
+    }
+    ulSleepBusy = 1;
+    taskEXIT_CRITICAL();
+
+    // Interval mode counts 0..interval: the interrupt comes interval + 1 clocks on
+    XTtcPs_SetInterval(&xSleepTtc, (XInterval)(interval - 1));
+    XTtcPs_ResetCounterValue(&xSleepTtc);
+    XTtcPs_Start(&xSleepTtc);
+    (void)xSemaphoreTake(xSleepSem, SLEEP_ONESHOT_WAIT);
+    XTtcPs_Stop(&xSleepTtc);
+    (void)xSemaphoreTake(xSleepSem, 0);
+
+    ulSleepBusy = 0;
+    return 1;
+}
+#else
+static int prvSleepOneShot(u64 left)
+{
+    (void)left;
+    return 0;
+}
+#endif /* SLEEP_ONESHOT */
+
+/*-----------------------------------------------------------*/
+/* Sleep for ticks of the system counter */
+static void prvSleep(u64 ticks)
+{
+    const u64 tick = ulRpuTimeHz() / configTICK_RATE_HZ;
+    u64 deadline = ullRpuTimeNow() + ticks;
+    s64 left;
+
+    while ((left = (s64)(deadline - ullRpuTimeNow())) > 0) {
+        if ((u64)left >= tick) {
+            vTaskDelay((TickType_t)((u64)left / tick));
+        } else if (!prvSleepOneShot((u64)left)) {
+            while ((s64)(deadline - ullRpuTimeNow()) > 0) {
+            }
+            break;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* The BSP's versions are weak (xiltimer.c) */
+void usleep(unsigned long useconds)
+{
+    if (!prvCanBlock()) {
+        XilTimer_Sleep(useconds, XTIMER_DELAY_USEC);
+        return;
+    }
+    prvSleep((u64)useconds * ulRpuTimeHz() / 1000000U);
+}
+
+void msleep(unsigned long mseconds)
+{
+    if (!prvCanBlock()) {
+        XilTimer_Sleep(mseconds, XTIMER_DELAY_MSEC);
+        return;
+    }
+    prvSleep((u64)mseconds * ulRpuTimeHz() / 1000U);
+}
+
+void sleep(unsigned int seconds)
+{
+    if (!prvCanBlock()) {
+        XilTimer_Sleep(seconds, XTIMER_DELAY_SEC);
+        return;
+    }
+    prvSleep((u64)seconds * ulRpuTimeHz());
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuSleepInit(u16 intr_priority)
+{
+#if SLEEP_ONESHOT
+    XTtcPs_Config *cfg;
+    int Status;
+
+    cfg = XTtcPs_LookupConfig(RPU_CORE_SLEEP_TTC);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+
+    Status = XTtcPs_CfgInitialize(&xSleepTtc, cfg, cfg->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        // Left running by a previous firmware instance
+        XTtcPs_Stop(&xSleepTtc);
+        Status = XTtcPs_CfgInitialize(&xSleepTtc, cfg, cfg->BaseAddress);
+    }
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    Status = XTtcPs_SetOptions(&xSleepTtc, XTTCPS_OPTION_INTERVAL_MODE | XTTCPS_OPTION_WAVE_DISABLE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XTtcPs_ClearInterruptStatus(&xSleepTtc, XTtcPs_GetInterruptStatus(&xSleepTtc));
+    XTtcPs_EnableInterrupts(&xSleepTtc, XTTCPS_IXR_INTERVAL_MASK);
+
+    xSleepSem = xSemaphoreCreateBinaryStatic(&xSleepSemBuffer);
+    ulSleepBusy = 0;
+
+    Status = XSetupInterruptSystem(&xSleepTtc, (Xil_ExceptionHandler)prvSleepHandler,
+                                   cfg->IntrId[0], cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId[0], cfg->IntrParent);
+    // A tick is at most a few million counts: no prescaler needed
+    ulSleepTtcHz = cfg->InputClockHz;
+#else
+    (void)intr_priority;
+#endif /* SLEEP_ONESHOT */
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_SLEEP_YIELD */
@@ -0,0 +1,52 @@
+/*
+ * Scheduler-aware usleep()/msleep()/sleep() (build option RPU_SLEEP_YIELD=1,
+ * UserConfig.cmake).
+ *
+ * The BSP's versions (xiltimer.c) spin on the sleep timer, so a driver that
+ * waits with usleep() under FreeRTOS burns the R5 and holds off every task
+ * below it. With RPU_SLEEP_YIELD=1 the firmware supplies its own, the BSP
+ * ones being weak:
+ *
+ * - Whole ticks of the delay are slept with vTaskDelay(), each time only as
+ *   many as are left to the deadline on the system counter (rpu_time.h), so
+ *   the call never returns early and oversleeps by the wake-up latency only
+ * - The sub-tick rest blocks on a one-shot of RPU_CORE_SLEEP_TTC
+ *   (rpu_core.h) whose interrupt (RPU_INTR_SLEEP_LEVEL) gives a semaphore;
+ *   one task owns the counter at a time, another one meanwhile spins on the
+ *   system counter, as does a rest under RPU_SLEEP_SPIN_US, which a block
+ *   and a wake-up would not beat
+ * - Before the scheduler runs, in interrupt handlers and critical sections,
+ *   and in the executive build (RPU_EXEC=1), the BSP's busy-wait is used
+ *
+ * On RPU0 the counter is the sensor trigger's: with RPU_SENSOR=1 sub-tick
+ * rests always spin.
+ */
+
+#ifndef RPU_SLEEP_H
+#define RPU_SLEEP_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "rpu_core.h"
+
+#ifndef RPU_SLEEP_YIELD
+#define RPU_SLEEP_YIELD 0
+#endif
+
+#ifndef RPU_SLEEP_SPIN_US
+#define RPU_SLEEP_SPIN_US       20      // Shorter rests spin on the counter
+#endif
+
+#if RPU_SLEEP_YIELD
+/* Set up the one-shot counter and its interrupt; the sleeps work (spinning
+ * below a tick) without it */
+int xRpuSleepInit(u16 intr_priority);
+#else
+static inline int xRpuSleepInit(u16 intr_priority)
+{
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_SLEEP_YIELD */
+
+#endif /* RPU_SLEEP_H */
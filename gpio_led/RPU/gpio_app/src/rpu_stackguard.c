@@ -0,0 +1,89 @@
+/*
+ * MPU stack guard of the tasks (see rpu_stackguard.h).
+ *
+ * vApplicationTaskSwitchedIn() is the kernel's traceTASK_SWITCHED_IN(),
+ * called from vTaskSwitchContext() with interrupts masked and once when the
+ * scheduler starts. It only rewrites the base of the reserved region: size,
+ * attributes and enable were set by xRpuStackGuardInit(). The region
+ * number register is saved and restored around it, so a task preempted
+ * inside Xil_SetTlbAttributes() finds its own selection again.
+ */
+
+#include "rpu_stackguard.h"
+
+#if ( configUSE_MPU_STACK_GUARD == 1 )
+
+#include "task.h"
+#include "xil_exception.h"
+#include "xil_mpu.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexr5.h"
+
+#include "rpu_tcm.h"
+
+#define GUARD_ATTRIB    (NORM_NSHARED_WB_WA | NO_ACCESS | EXECUTE_NEVER)
+
+/* Guard target until the scheduler switches in the first task */
+static StackType_t xParkedGuard[RPU_STACK_GUARD_WORDS] RPU_STACK_ALIGN RPU_BTCM_NOINIT;
+
+static u32 ulGuardActive RPU_BTCM_BSS;
+static XExc_VectorTableEntry xPrevDataAbort;
+
+/* The port's hook (portZynqUltrascale.c); task.h declares it only with the
+ * kernel check enabled */
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName);
+
+/*-----------------------------------------------------------*/
+/* traceTASK_SWITCHED_IN() of the BSP (FreeRTOSConfig.h) */
+RPU_ATCM_TEXT void vApplicationTaskSwitchedIn(void *pvStack)
+{
+    u32 rgnr;
+
+    if (!ulGuardActive) {
+        return;
+    }
+    rgnr = mfcp(XREG_CP15_MPU_MEMORY_REG_NUMBER);
+    mtcp(XREG_CP15_MPU_MEMORY_REG_NUMBER, RPU_STACK_GUARD_REGION);
+    isb();
+    mtcp(XREG_CP15_MPU_REG_BASEADDR, (UINTPTR)pvStack - RPU_STACK_GUARD_SIZE);
+    mtcp(XREG_CP15_MPU_MEMORY_REG_NUMBER, rgnr);
+    isb();
+}
+
+/*-----------------------------------------------------------*/
+/* Data abort: a fault address inside the guard is the running task's
+ * overflow; anything else is left to the previous handler */
+static void prvGuardDataAbort(void *ref)
+{
+    u32 base;
+    u32 far = mfcp(XREG_CP15_DATA_FAULT_ADDRESS);
+    u32 rgnr = mfcp(XREG_CP15_MPU_MEMORY_REG_NUMBER);
+
+    mtcp(XREG_CP15_MPU_MEMORY_REG_NUMBER, RPU_STACK_GUARD_REGION);
+    isb();
+    base = mfcp(XREG_CP15_MPU_REG_BASEADDR);
+    mtcp(XREG_CP15_MPU_MEMORY_REG_NUMBER, rgnr);
+    isb();
+
+    if (far - base < RPU_STACK_GUARD_SIZE) {
+        vApplicationStackOverflowHook(xTaskGetCurrentTaskHandle(), pcTaskGetName(NULL));
+    }
+    (void)ref;
+    xPrevDataAbort.Handler(xPrevDataAbort.Data);
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuStackGuardInit(void)
+{
+    if (Xil_SetMPURegionByRegNum(RPU_STACK_GUARD_REGION, (UINTPTR)xParkedGuard,
+                                 RPU_STACK_GUARD_SIZE, GUARD_ATTRIB) != XST_SUCCESS) {
+        return XST_FAILURE;   // Region taken, the tasks run unguarded
+    }
+
+    xPrevDataAbort = XExc_VectorTable[XIL_EXCEPTION_ID_DATA_ABORT_INT];
+    Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_DATA_ABORT_INT, prvGuardDataAbort, NULL);
+    ulGuardActive = 1U;
+    return XST_SUCCESS;
+}
+
+#endif /* configUSE_MPU_STACK_GUARD */
@@ -0,0 +1,75 @@
+/*
+ * MPU stack guard of the tasks (BSP setting configUSE_MPU_STACK_GUARD=1,
+ * FreeRTOSConfig.h).
+ *
+ * Instead of the kernel comparing the end of the outgoing task's stack
+ * against its fill pattern at every switch (configCHECK_FOR_STACK_OVERFLOW
+ * 2), one MPU region, RPU_STACK_GUARD_REGION, makes the RPU_STACK_GUARD_SIZE
+ * bytes below the running task's stack no-access. The kernel's
+ * traceTASK_SWITCHED_IN() hook moves it to the task switched in, which is
+ * a single base register write, so an overflow faults on the first store
+ * past the stack instead of being found, possibly too late, at the next
+ * switch. The data abort handler turns a fault inside the guard into the
+ * usual vApplicationStackOverflowHook() call; other aborts go to the
+ * handler installed before.
+ *
+ * The guard bytes are not part of the stack the kernel sees: task stacks
+ * are declared with RPU_TASK_STACK(), which aligns them and adds the guard
+ * below, and handed to the kernel with RPU_TASK_STACK_BUF(). Stack depths
+ * must be multiples of RPU_STACK_GUARD_SIZE bytes so every stack of an
+ * array stays aligned; vRpuStackGuardCheck() asserts it at creation.
+ * The exception mode stacks (IRQ, FIQ, SVC, abort) are not guarded.
+ *
+ * The BSP's own Init_MPU() takes regions 0-9 and every
+ * Xil_SetTlbAttributes() call the next free one; region 15, the highest
+ * priority, is reserved here so it overrides the BTCM region. Without
+ * configUSE_MPU_STACK_GUARD the macros reduce to plain arrays and the
+ * kernel check stays in place.
+ */
+
+#ifndef RPU_STACKGUARD_H
+#define RPU_STACKGUARD_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+
+#ifndef configUSE_MPU_STACK_GUARD
+#define configUSE_MPU_STACK_GUARD 0
+#endif
+
+#define RPU_STACK_GUARD_SIZE    32U     // Smallest R5 MPU region
+#define RPU_STACK_GUARD_REGION  15U     // Highest priority region
+
+#if ( configUSE_MPU_STACK_GUARD == 1 )
+#define RPU_STACK_GUARD_WORDS   (RPU_STACK_GUARD_SIZE / sizeof(StackType_t))
+#define RPU_STACK_ALIGN         __attribute__((aligned(RPU_STACK_GUARD_SIZE)))
+#else
+#define RPU_STACK_GUARD_WORDS   0U
+#define RPU_STACK_ALIGN
+#endif
+
+/* Task stack of 'depth' words with its guard below; 'name' may carry an
+ * array dimension, e.g. RPU_TASK_STACK(xStacks[4], STACK_SIZE) */
+#define RPU_TASK_STACK(name, depth) \
+    StackType_t name[(depth) + RPU_STACK_GUARD_WORDS] RPU_STACK_ALIGN
+
+/* The part of an RPU_TASK_STACK() handed to xTaskCreateStatic() */
+#define RPU_TASK_STACK_BUF(name)    (&(name)[RPU_STACK_GUARD_WORDS])
+
+#if ( configUSE_MPU_STACK_GUARD == 1 )
+/* Reserves the guard region and hooks the data abort; call before the
+ * scheduler starts */
+int xRpuStackGuardInit(void);
+
+/* From traceTASK_CREATE(): the stack must come from RPU_TASK_STACK_BUF() */
+static inline void vRpuStackGuardCheck(const void *pvStack)
+{
+    configASSERT(((UINTPTR)pvStack % RPU_STACK_GUARD_SIZE) == 0U);
+}
+#else
+static inline int xRpuStackGuardInit(void) { return XST_SUCCESS; }
+static inline void vRpuStackGuardCheck(const void *pvStack) { (void)pvStack; }
+#endif /* configUSE_MPU_STACK_GUARD */
+
+#endif /* RPU_STACKGUARD_H */
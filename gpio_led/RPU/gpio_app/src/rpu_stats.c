@@ -0,0 +1,291 @@
+/*
+ * Run-time stats and per-task CPU accounting (see rpu_stats.h, rpu_shm.h).
+ *
+ * xCONFIGURE_TIMER_FOR_RUN_TIME_STATS() and xGET_RUN_TIME_COUNTER_VALUE() are
+ * the kernel's portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() and
+ * portGET_RUN_TIME_COUNTER_VALUE(); the BSP is built with
+ * configRUN_TIME_STATS_USE_TICK_TIMER 0 so the port leaves them to the
+ * application. The counter is read at every context switch, so reading it
+ * is a single register load.
+ *
+ * The memory watermarks are published with the stats. Task stack sizes come
+ * from the traceTASK_CREATE() hook of the BSP (vApplicationTaskCreated()),
+ * the free space from the kernel's own stack painting. The exception mode
+ * stacks are painted here, before the scheduler first uses them, and
+ * scanned from their low end at every publication: they grow down, so the
+ * painted words left at the bottom are the space never used.
+ */
+
+#include <string.h>
+#include <xil_io.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+#include "xttcps.h"
+#include "xil_mpu.h"
+#include "xpseudo_asm.h"
+
+#include "rpu_seqlock.h"
+#include "rpu_stackguard.h"
+#include "rpu_stats.h"
+#include "rpu_tcm.h"
+
+static XTtcPs xStatsTtc;
+static u32 ulStatsHz;
+static u32 ulStatsSeq;
+static TaskStatus_t xStatsStatus[SHM_STATS_MAX_TASKS];
+static TimerHandle_t xStatsTimer;
+static StaticTimer_t xStatsTimerBuffer RPU_BTCM_NOINIT;
+
+// tskSTACK_FILL_BYTE, as the kernel paints the task stacks
+#define STATS_STACK_FILL        0xA5A5A5A5U
+
+/* Stack bounds of the exception modes (lscript.ld) */
+extern u32 _supervisor_stack_end[], __supervisor_stack[];
+extern u32 _irq_stack_end[], __irq_stack[];
+extern u32 _fiq_stack_end[], __fiq_stack[];
+extern u32 _abort_stack_end[], __abort_stack[];
+extern u32 _undef_stack_end[], __undef_stack[];
+
+static const struct {
+    u32 *low;
+    u32 *high;
+} xStatsModeStacks[MEM_MODES] = {
+    [MEM_MODE_SVC]   = { _supervisor_stack_end, __supervisor_stack },
+    [MEM_MODE_IRQ]   = { _irq_stack_end, __irq_stack },
+    [MEM_MODE_FIQ]   = { _fiq_stack_end, __fiq_stack },
+    [MEM_MODE_ABORT] = { _abort_stack_end, __abort_stack },
+    [MEM_MODE_UNDEF] = { _undef_stack_end, __undef_stack },
+};
+
+/* Stack size of every task created, by handle; tasks are never deleted */
+static struct {
+    void *task;
+    u32 bytes;
+} xStatsStacks[MEM_MAX_TASKS];
+static u32 ulStatsStackCount;
+static u32 ulMemSeq;
+
+/*-----------------------------------------------------------*/
+/* Start the free-running counter; called by vTaskStartScheduler() */
+void xCONFIGURE_TIMER_FOR_RUN_TIME_STATS(void)
+{
+    XTtcPs_Config *cfg;
+    int Status;
+
+    cfg = XTtcPs_LookupConfig(RPU_STATS_TTC_BASEADDR);
+    configASSERT(cfg);
+
+    Status = XTtcPs_CfgInitialize(&xStatsTtc, cfg, cfg->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        // Left running by a previous firmware instance
+        XTtcPs_Stop(&xStatsTtc);
+        Status = XTtcPs_CfgInitialize(&xStatsTtc, cfg, cfg->BaseAddress);
+    }
+    configASSERT(Status == XST_SUCCESS);
+
+    // Overflow mode: counts 0..0xFFFFFFFF and wraps, no interrupt
+    XTtcPs_SetOptions(&xStatsTtc, XTTCPS_OPTION_WAVE_DISABLE);
+    XTtcPs_SetPrescaler(&xStatsTtc, RPU_STATS_PRESCALER);
+    XTtcPs_ResetCounterValue(&xStatsTtc);
+    XTtcPs_Start(&xStatsTtc);
+
+    ulStatsHz = cfg->InputClockHz >> (RPU_STATS_PRESCALER + 1);
+}
+
+/*-----------------------------------------------------------*/
+uint32_t xGET_RUN_TIME_COUNTER_VALUE(void)
+{
+    return XTtcPs_ReadReg(RPU_STATS_TTC_BASEADDR, XTTCPS_COUNT_VALUE_OFFSET);
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuStatsHz(void)
+{
+    return ulStatsHz;
+}
+
+/*-----------------------------------------------------------*/
+/* traceTASK_CREATE() of the BSP (FreeRTOSConfig.h), in the kernel's critical
+ * section: pvEndOfStack is the highest word of the stack */
+void vApplicationTaskCreated(void *pvTask, void *pvStack, void *pvEndOfStack)
+{
+    vRpuStackGuardCheck(pvStack);
+    if (ulStatsStackCount < MEM_MAX_TASKS) {
+        xStatsStacks[ulStatsStackCount].task = pvTask;
+        xStatsStacks[ulStatsStackCount].bytes =
+            (u32)((u8 *)pvEndOfStack - (u8 *)pvStack) + sizeof(StackType_t);
+        ulStatsStackCount++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+static u32 prvStatsStackSize(TaskHandle_t task)
+{
+    u32 i;
+
+    for (i = 0; i < ulStatsStackCount; i++) {
+        if (xStatsStacks[i].task == (void *)task) {
+            return xStatsStacks[i].bytes;
+        }
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+/* Painted words left at the low end of a mode stack, in bytes */
+static u32 prvStatsModeFree(u32 idx)
+{
+    const u32 *p = xStatsModeStacks[idx].low;
+
+    while (p < xStatsModeStacks[idx].high && *p == STATS_STACK_FILL) {
+        p++;
+    }
+    return (u32)(p - xStatsModeStacks[idx].low) * 4;
+}
+
+/*-----------------------------------------------------------*/
+/* Paint the mode stacks; main() runs in SYS mode on its own stack, and no
+ * exception may take one of them while it is painted */
+static void prvStatsPaintModeStacks(void)
+{
+    u32 cpsr = mfcpsr();
+    u32 i, *p;
+
+    __asm volatile ("cpsid if" ::: "memory");
+    for (i = 0; i < MEM_MODES; i++) {
+        for (p = xStatsModeStacks[i].low; p < xStatsModeStacks[i].high; p++) {
+            *p = STATS_STACK_FILL;
+        }
+    }
+    mtcpsr(cpsr);
+}
+
+/*-----------------------------------------------------------*/
+/* Copy the watermarks of one snapshot into the memory block */
+static void prvStatsPublishMem(UBaseType_t count)
+{
+    UINTPTR entry;
+    char name[SHM_STATS_NAME_LEN];
+    u32 words[SHM_STATS_NAME_LEN / 4];
+    UBaseType_t i;
+    u32 j;
+
+    vRpuSeqBegin(RPU_MEM_BASE + MEM_SEQ_OFFSET, &ulMemSeq);
+
+    for (i = 0; i < MEM_MODES; i++) {
+        entry = RPU_MEM_BASE + MEM_MODE(i);
+        Xil_Out32(entry + 0, (u32)((u8 *)xStatsModeStacks[i].high -
+                                   (u8 *)xStatsModeStacks[i].low));
+        Xil_Out32(entry + 4, prvStatsModeFree(i));
+    }
+    for (i = 0; i < count; i++) {
+        entry = RPU_MEM_BASE + MEM_TASK(i);
+        memset(name, 0, sizeof(name));
+        strncpy(name, xStatsStatus[i].pcTaskName, SHM_STATS_NAME_LEN - 1);
+        memcpy(words, name, sizeof(words));
+        for (j = 0; j < SHM_STATS_NAME_LEN / 4; j++) {
+            Xil_Out32(entry + j * 4, words[j]);
+        }
+        Xil_Out32(entry + 12, prvStatsStackSize(xStatsStatus[i].xHandle));
+        Xil_Out32(entry + 16, xStatsStatus[i].usStackHighWaterMark * sizeof(StackType_t));
+        Xil_Out32(entry + 20, xStatsStatus[i].xTaskNumber);
+    }
+    Xil_Out32(RPU_MEM_BASE + MEM_COUNT_OFFSET, count);
+#if (configSUPPORT_DYNAMIC_ALLOCATION == 1)
+    Xil_Out32(RPU_MEM_BASE + MEM_HEAP_SIZE_OFFSET, configTOTAL_HEAP_SIZE);
+    Xil_Out32(RPU_MEM_BASE + MEM_HEAP_FREE_OFFSET, xPortGetFreeHeapSize());
+    Xil_Out32(RPU_MEM_BASE + MEM_HEAP_MIN_OFFSET, xPortGetMinimumEverFreeHeapSize());
+#else
+    // No heap is linked (heap_4.c needs dynamic allocation)
+    Xil_Out32(RPU_MEM_BASE + MEM_HEAP_SIZE_OFFSET, 0);
+    Xil_Out32(RPU_MEM_BASE + MEM_HEAP_FREE_OFFSET, 0);
+    Xil_Out32(RPU_MEM_BASE + MEM_HEAP_MIN_OFFSET, 0);
+#endif
+
+    vRpuSeqEnd(RPU_MEM_BASE + MEM_SEQ_OFFSET, &ulMemSeq);
+}
+
+/*-----------------------------------------------------------*/
+/* Copy one task into its shared-memory entry */
+static void prvStatsWriteEntry(u32 idx, const TaskStatus_t *task)
+{
+    UINTPTR entry = RPU_SHM_BASE + SHM_STATS_ENTRY(idx);
+    char name[SHM_STATS_NAME_LEN] = { 0 };
+    u32 words[SHM_STATS_NAME_LEN / 4];
+    u32 i;
+
+    strncpy(name, task->pcTaskName, SHM_STATS_NAME_LEN - 1);
+    memcpy(words, name, sizeof(words));
+    for (i = 0; i < SHM_STATS_NAME_LEN / 4; i++) {
+        Xil_Out32(entry + i * 4, words[i]);
+    }
+    Xil_Out32(entry + 12, task->ulRunTimeCounter);
+    Xil_Out32(entry + 16, task->usStackHighWaterMark * sizeof(StackType_t));
+    Xil_Out32(entry + 20, (task->xTaskNumber & 0xFF) |
+                          ((task->uxCurrentPriority & 0xFF) << 8) |
+                          (((u32)task->eCurrentState & 0xFF) << 16));
+}
+
+/*-----------------------------------------------------------*/
+/* Timer callback: publish a snapshot under the header sequence number */
+static void prvStatsPublish(TimerHandle_t xTimer)
+{
+    configRUN_TIME_COUNTER_TYPE total;
+    UBaseType_t count, i;
+
+    (void)xTimer;
+
+    // Returns 0 if there are more tasks than entries
+    count = uxTaskGetSystemState(xStatsStatus, SHM_STATS_MAX_TASKS, &total);
+
+    vRpuSeqBegin(RPU_SHM_BASE + SHM_STATS_SEQ_OFFSET, &ulStatsSeq);
+
+    for (i = 0; i < count; i++) {
+        prvStatsWriteEntry(i, &xStatsStatus[i]);
+    }
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_COUNT_OFFSET, count);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_TOTAL_OFFSET, total);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_HZ_OFFSET, ulStatsHz);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_TICK_OFFSET, xTaskGetTickCount());
+#if (configSUPPORT_DYNAMIC_ALLOCATION == 1)
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_HEAP_OFFSET, xPortGetFreeHeapSize());
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_HEAP_MIN_OFFSET, xPortGetMinimumEverFreeHeapSize());
+#else
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_HEAP_OFFSET, 0);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_HEAP_MIN_OFFSET, 0);
+#endif
+
+    vRpuSeqEnd(RPU_SHM_BASE + SHM_STATS_SEQ_OFFSET, &ulStatsSeq);
+
+    prvStatsPublishMem(count);
+}
+
+/*-----------------------------------------------------------*/
+/* Clear the stats and memory blocks and start publishing; called once the
+ * shared window is mapped in the MPU, before the scheduler starts */
+RPU_INIT_TEXT void vRpuStatsInit(void)
+{
+    ulStatsSeq = 0;
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_SEQ_OFFSET, 0);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_COUNT_OFFSET, 0);
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_STATS_MAGIC_OFFSET, SHM_STATS_MAGIC);
+
+    prvStatsPaintModeStacks();
+    Xil_SetTlbAttributes(RPU_MEM_BASE, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(RPU_MEM_BASE + MEM_MAGIC_OFFSET, 0);
+    ulMemSeq = ulRpuSeqInit(RPU_MEM_BASE + MEM_SEQ_OFFSET);
+    Xil_Out32(RPU_MEM_BASE + MEM_COUNT_OFFSET, 0);
+    __sync_synchronize();
+    Xil_Out32(RPU_MEM_BASE + MEM_MAGIC_OFFSET, MEM_MAGIC);
+
+    xStatsTimer = xTimerCreateStatic((const char *)"Stats",
+                                     pdMS_TO_TICKS(RPU_STATS_PERIOD_MS),
+                                     pdTRUE,
+                                     NULL,
+                                     prvStatsPublish,
+                                     &xStatsTimerBuffer);
+    configASSERT(xStatsTimer);
+    xTimerStart(xStatsTimer, 0);
+}
@@ -0,0 +1,40 @@
+/*
+ * Run-time stats and per-task CPU accounting.
+ *
+ * The kernel's run-time counter (configGENERATE_RUN_TIME_STATS) is TTC1
+ * counter 1 (TTC3 counter 1 on RPU1, rpu_core.h), free-running at the TTC
+ * clock / 16 (160 ns per count at 100 MHz, wrapping after about 11 minutes).
+ * It keeps counting while the core sleeps in WFI, so idle time is accounted
+ * correctly in the power profile (rpu_power.h), unlike the R5 PMU cycle
+ * counter.
+ *
+ * vRpuStatsInit() starts a software timer that publishes a
+ * uxTaskGetSystemState() snapshot into the task stats block of the shared
+ * window (rpu_shm.h) every RPU_STATS_PERIOD_MS; decode it on Linux with
+ * APU/apu_app/rpu_stats. Interrupt handlers are not accounted separately:
+ * their time is charged to the task they interrupted.
+ *
+ * The same timer publishes the memory watermarks into the core's block at
+ * MEM_ADDR (rpu_shm.h, apu_app/rpu_stats --mem): the stack size and lowest
+ * free space of every task and exception mode stack, and the heap figures
+ * when the BSP has a FreeRTOS heap (configSUPPORT_DYNAMIC_ALLOCATION; this
+ * one is static only, so configTOTAL_HEAP_SIZE takes no memory).
+ */
+
+#ifndef RPU_STATS_H
+#define RPU_STATS_H
+
+#include "xil_types.h"
+#include "xparameters.h"
+#include "rpu_core.h"
+
+// TTC1 counter 1 on RPU0; TTC1 counter 0 is the waveform timer (rpu_wave.h)
+#define RPU_STATS_TTC_BASEADDR  RPU_CORE_STATS_TTC
+#define RPU_STATS_PRESCALER     3      // Divide the TTC clock by 2^(3+1)
+#define RPU_STATS_PERIOD_MS     1000
+
+void vRpuStatsInit(void);
+/* Run time counter frequency, once the scheduler has started it */
+u32 ulRpuStatsHz(void);
+
+#endif /* RPU_STATS_H */
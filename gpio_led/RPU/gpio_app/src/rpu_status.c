@@ -0,0 +1,99 @@
+/*
+ * Status block (see rpu_status.h).
+ *
+ * The counters live here and the block is written from them whole, so a
+ * reader that retries on a changed seq always gets one consistent update.
+ * An update is ten stores to the window and two barriers.
+ */
+
+#include <xil_io.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_config.h"
+#include "rpu_pattern.h"
+#include "rpu_shm.h"
+#include "rpu_status.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_wave.h"
+
+static u32 ulStatusSeq RPU_BTCM_BSS;
+static u32 ulStatusLed RPU_BTCM_BSS;
+static u32 ulStatusFrames RPU_BTCM_BSS;
+static u32 ulStatusCommands RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* Rewrite the block; in the caller's critical section */
+RPU_ATCM_TEXT static void prvStatusPublish(void)
+{
+    RpuConfig_t cfg;
+    u32 flags = 0;
+    u64 now = ullRpuTimeNow();
+
+    vRpuConfigGet(&cfg);
+    if (cfg.override) {
+        flags |= SHM_STATUS_F_OVERRIDE;
+    }
+    if (xRpuPatternActive()) {
+        flags |= SHM_STATUS_F_PATTERN;
+    }
+    if (xRpuWaveActive()) {
+        flags |= SHM_STATUS_F_WAVE;
+    }
+
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_SEQ_OFFSET, ++ulStatusSeq);
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_MODE_OFFSET, cfg.mode);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_FLAGS_OFFSET, flags);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_LED_OFFSET, ulStatusLed);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_STEP_OFFSET, ulRpuPatternStep());
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_FRAMES_OFFSET, ulStatusFrames);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_COMMANDS_OFFSET, ulStatusCommands);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_STAMP_LO_OFFSET, (u32)now);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_STAMP_HI_OFFSET, (u32)(now >> 32));
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_SEQ_OFFSET, ++ulStatusSeq);
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuStatusFrame(u32 led)
+{
+    taskENTER_CRITICAL();
+    ulStatusLed = led;
+    ulStatusFrames++;
+    prvStatusPublish();
+    taskEXIT_CRITICAL();
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuStatusCommands(u32 count)
+{
+    if (count == 0) {
+        return;
+    }
+    taskENTER_CRITICAL();
+    ulStatusCommands += count;
+    prvStatusPublish();
+    taskEXIT_CRITICAL();
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT void vRpuStatusInit(void)
+{
+    u32 off;
+
+    ulStatusSeq = 0;
+    ulStatusLed = 0;
+    ulStatusFrames = 0;
+    ulStatusCommands = 0;
+
+    // A reader sees the magic only over a cleared block
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_MAGIC_OFFSET, 0);
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_SEQ_OFFSET, 0);
+    for (off = SHM_STATUS_MODE_OFFSET; off < SHM_STATUS_OFFSET + SHM_STATUS_SIZE; off += 4) {
+        Xil_Out32(RPU_SHM_BASE + off, 0);
+    }
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_STATUS_MAGIC_OFFSET, SHM_STATUS_MAGIC);
+}
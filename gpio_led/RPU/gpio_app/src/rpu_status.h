@@ -0,0 +1,27 @@
+/*
+ * Status block (rpu_shm.h, "Status block").
+ *
+ * The blink state and the frame and command counters, published into the
+ * window under a seq word so the APU reads them with a few loads instead of
+ * an RPU_CMD_QUERY round trip. The Rx task (the LED slot of the executive)
+ * calls vRpuStatusFrame() after each LED write and the IPI task calls
+ * vRpuStatusCommands() at the end of each pass; both rewrite the whole
+ * block, in a critical section, so the two writers never interleave their
+ * seq updates. The mode and override are those of the latest committed
+ * configuration (vRpuConfigGet()), which the Tx task runs from its next
+ * frame.
+ */
+
+#ifndef RPU_STATUS_H
+#define RPU_STATUS_H
+
+#include "xil_types.h"
+
+/* Clear the block and publish the magic; before the tasks start */
+void vRpuStatusInit(void);
+/* led was written to the LEDs */
+void vRpuStatusFrame(u32 led);
+/* An IPI task pass served count commands; nothing to publish for 0 */
+void vRpuStatusCommands(u32 count);
+
+#endif /* RPU_STATUS_H */
@@ -0,0 +1,257 @@
+/*
+ * PS SYSMON sampling (see rpu_sysmon.h, rpu_shm.h).
+ *
+ * The sequencer keeps the averaged result of every enabled channel in its
+ * data registers, so a pass of the task is a handful of register reads. The
+ * alarm interrupt is left disabled from the moment it fires until the next
+ * periodic pass, which bounds the interrupt rate while the die stays hot.
+ */
+
+#include "rpu_sysmon.h"
+
+#if RPU_SYSMON
+
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xsysmonpsu.h"
+#include "xinterrupt_wrap.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_log.h"
+#include "rpu_seqlock.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+
+#define SYSMON_TASK_STACK_SIZE configMINIMAL_STACK_SIZE
+// AMS interrupt, GIC ID 88 = SPI 56, level sensitive (encoded as in main.c)
+#define SYSMON_INTR_ID         (56 | (4 << 12))
+#define SYSMON_INTC_PARENT     0xF9000000
+#define SYSMON_ALARM_INTR      ((u64)XSYSMONPSU_IER_0_PS_ALM_0_MASK)
+
+// Channels sampled, in the order of the block
+#define SYSMON_SEQ_CHANNELS    (XSYSMONPSU_SEQ_CH0_TEMP_MASK | XSYSMONPSU_SEQ_CH0_SUP1_MASK | \
+                                XSYSMONPSU_SEQ_CH0_SUP2_MASK | XSYSMONPSU_SEQ_CH0_SUP3_MASK | \
+                                XSYSMONPSU_SEQ_CH0_SUP4_MASK | \
+                                ((u64)XSYSMONPSU_SEQ_CH2_TEMP_RMT_MASK << XSM_SEQ_CH2_SHIFT))
+
+// Indexed by SYSMON_CH_*, at most SYSMON_MAX_CHANNELS
+static const struct {
+    u8 channel;
+    u8 is_temp;
+} xSysmonChannels[] = {
+    { XSM_CH_TEMP,       1 },   /* LPD */
+    { XSM_CH_TEMP_REMTE, 1 },   /* FPD */
+    { XSM_CH_SUPPLY1,    0 },   /* VCC_PSINTLP */
+    { XSM_CH_SUPPLY2,    0 },   /* VCC_PSINTFP */
+    { XSM_CH_SUPPLY3,    0 },   /* VCC_PSAUX */
+    { XSM_CH_SUPPLY4,    0 },   /* VCC_PSDDR_504 */
+};
+#define SYSMON_CHANNELS        (sizeof(xSysmonChannels) / sizeof(xSysmonChannels[0]))
+
+static XSysMonPsu xSysmon;
+static TaskHandle_t xSysmonTask;
+static s32 lSysmonMin[SYSMON_CHANNELS];
+static s32 lSysmonMax[SYSMON_CHANNELS];
+static u32 ulSysmonSamples;
+static u32 ulSysmonAlarms;
+static u32 ulSysmonSeq;
+
+static StaticTask_t xSysmonTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xSysmonStack, SYSMON_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* ADC codes <-> mC and mV, the driver's RawTo* formulas in integers */
+static s32 prvSysmonTempMilliC(u32 raw)
+{
+    return (s32)(((u64)raw * 509314U) >> 16) - 280231;
+}
+
+static u16 prvSysmonTempRaw(s32 milli_c)
+{
+    return (u16)((((u64)(milli_c + 280231)) << 16) / 509314U);
+}
+
+static s32 prvSysmonSupplyMilliV(u32 raw)
+{
+    return (s32)((raw * 3000U) >> 16);
+}
+
+/*-----------------------------------------------------------*/
+/* Temperature alarm: wake the task, which re-arms the interrupt later
+ * (interrupt context) */
+static void prvSysmonIntr(void *CallBackRef)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    XSysMonPsu *sysmon = CallBackRef;
+
+    XSysMonPsu_IntrDisable(sysmon, SYSMON_ALARM_INTR);
+    XSysMonPsu_IntrClear(sysmon, SYSMON_ALARM_INTR);
+    vTaskNotifyGiveFromISR(xSysmonTask, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+/* Read the averages and publish them under the seq word */
+static void prvSysmonTask(void *pvParameters)
+{
+    const s32 hot = RPU_SYSMON_HOT_C * 1000;
+    const s32 cool = RPU_SYSMON_COOL_C * 1000;
+    u32 flags = 0;
+    u32 intr_off = 0;
+
+    (void)pvParameters;
+    for (;;) {
+        struct rpu_sysmon_channel sample[SYSMON_CHANNELS];
+        u32 alarm;
+        u32 i;
+
+        alarm = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RPU_SYSMON_PERIOD_MS));
+        if (alarm != 0) {
+            intr_off = 1;
+        } else if (intr_off) {
+            XSysMonPsu_IntrClear(&xSysmon, SYSMON_ALARM_INTR);
+            XSysMonPsu_IntrEnable(&xSysmon, SYSMON_ALARM_INTR);
+            intr_off = 0;
+        }
+
+        for (i = 0; i < SYSMON_CHANNELS; i++) {
+            u32 raw = XSysMonPsu_GetAdcData(&xSysmon, xSysmonChannels[i].channel, XSYSMON_PS);
+            s32 value = xSysmonChannels[i].is_temp ? prvSysmonTempMilliC(raw) : prvSysmonSupplyMilliV(raw);
+
+            if (ulSysmonSamples == 0 || value < lSysmonMin[i]) {
+                lSysmonMin[i] = value;
+            }
+            if (ulSysmonSamples == 0 || value > lSysmonMax[i]) {
+                lSysmonMax[i] = value;
+            }
+            sample[i].value = value;
+            sample[i].min = lSysmonMin[i];
+            sample[i].max = lSysmonMax[i];
+            sample[i].raw = raw;
+        }
+        ulSysmonSamples++;
+
+        // Same hysteresis as the hardware alarm, which may have seen it first
+        if ((flags & SYSMON_FLAG_HOT) == 0) {
+            if (alarm != 0 || sample[SYSMON_CH_TEMP_LPD].value >= hot) {
+                flags |= SYSMON_FLAG_HOT;
+                ulSysmonAlarms++;
+                RPU_LOG("SYSMON: LPD at %d mC, over %d C\r\n",
+                        sample[SYSMON_CH_TEMP_LPD].value, RPU_SYSMON_HOT_C);
+            }
+        } else if (sample[SYSMON_CH_TEMP_LPD].value < cool) {
+            flags &= ~SYSMON_FLAG_HOT;
+            RPU_LOG("SYSMON: LPD at %d mC, below %d C again\r\n",
+                    sample[SYSMON_CH_TEMP_LPD].value, RPU_SYSMON_COOL_C);
+        }
+
+        vRpuSeqBegin(SYSMON_ADDR + SYSMON_SEQ_OFFSET, &ulSysmonSeq);
+        for (i = 0; i < SYSMON_CHANNELS; i++) {
+            UINTPTR ch = SYSMON_ADDR + SYSMON_CH(i);
+
+            Xil_Out32(ch + 0x00, (u32)sample[i].value);
+            Xil_Out32(ch + 0x04, (u32)sample[i].min);
+            Xil_Out32(ch + 0x08, (u32)sample[i].max);
+            Xil_Out32(ch + 0x0C, sample[i].raw);
+        }
+        Xil_Out32(SYSMON_ADDR + SYSMON_FLAGS_OFFSET, flags);
+        Xil_Out32(SYSMON_ADDR + SYSMON_ALARMS_OFFSET, ulSysmonAlarms);
+        Xil_Out32(SYSMON_ADDR + SYSMON_SAMPLES_OFFSET, ulSysmonSamples);
+        vRpuSeqEnd(SYSMON_ADDR + SYSMON_SEQ_OFFSET, &ulSysmonSeq);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Averaged continuous sequence over the channels, temperature alarm in
+ * hysteresis mode (the mode bit of the lower threshold resets to it) */
+static int prvSysmonSetup(void)
+{
+    XSysMonPsu_Config *cfg;
+    int Status;
+
+    cfg = XSysMonPsu_LookupConfig(XPAR_XSYSMONPSU_0_BASEADDR);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    Status = XSysMonPsu_CfgInitialize(&xSysmon, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    XSysMonPsu_IntrDisable(&xSysmon, ~0ULL);
+    XSysMonPsu_IntrClear(&xSysmon, ~0ULL);
+
+    // Channels can only be changed in safe mode
+    XSysMonPsu_SetSequencerMode(&xSysmon, XSM_SEQ_MODE_SAFE, XSYSMON_PS);
+    XSysMonPsu_SetAvg(&xSysmon, XSM_AVG_256_SAMPLES, XSYSMON_PS);
+    Status = XSysMonPsu_SetSeqAvgEnables(&xSysmon, SYSMON_SEQ_CHANNELS, XSYSMON_PS);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    // Keep the calibration channel in the sequence, as the driver examples do
+    Status = XSysMonPsu_SetSeqChEnables(&xSysmon, SYSMON_SEQ_CHANNELS | XSYSMONPSU_SEQ_CH0_CALIBRTN_MASK,
+                                        XSYSMON_PS);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    XSysMonPsu_SetAlarmThreshold(&xSysmon, XSM_ATR_TEMP_UPPER,
+                                 prvSysmonTempRaw(RPU_SYSMON_HOT_C * 1000), XSYSMON_PS);
+    XSysMonPsu_SetAlarmThreshold(&xSysmon, XSM_ATR_TEMP_LOWER,
+                                 prvSysmonTempRaw(RPU_SYSMON_COOL_C * 1000) & XSYSMONPSU_ALRM_TEMP_LWR_MASK,
+                                 XSYSMON_PS);
+    XSysMonPsu_SetAlarmEnables(&xSysmon, XSysMonPsu_GetAlarmEnables(&xSysmon, XSYSMON_PS) |
+                               XSM_CFR_ALM_TEMP_MASK, XSYSMON_PS);
+
+    XSysMonPsu_SetSequencerMode(&xSysmon, XSM_SEQ_MODE_CONTINPASS, XSYSMON_PS);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Start the sequencer and the sampling task; announces the block */
+RPU_INIT_TEXT int xRpuSysmonInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    int Status;
+
+    Xil_SetTlbAttributes(SYSMON_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(SYSMON_ADDR + SYSMON_MAGIC_OFFSET, 0);
+
+    Status = prvSysmonSetup();
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    ulSysmonSeq = ulRpuSeqInit(SYSMON_ADDR + SYSMON_SEQ_OFFSET);
+    ulSysmonSamples = 0;
+    ulSysmonAlarms = 0;
+    Xil_Out32(SYSMON_ADDR + SYSMON_SAMPLES_OFFSET, 0);
+    Xil_Out32(SYSMON_ADDR + SYSMON_PERIOD_OFFSET, RPU_SYSMON_PERIOD_MS);
+    Xil_Out32(SYSMON_ADDR + SYSMON_COUNT_OFFSET, SYSMON_CHANNELS);
+    Xil_Out32(SYSMON_ADDR + SYSMON_FLAGS_OFFSET, 0);
+    Xil_Out32(SYSMON_ADDR + SYSMON_ALARMS_OFFSET, 0);
+    Xil_Out32(SYSMON_ADDR + SYSMON_HOT_OFFSET, (u32)(RPU_SYSMON_HOT_C * 1000));
+    Xil_Out32(SYSMON_ADDR + SYSMON_COOL_OFFSET, (u32)(RPU_SYSMON_COOL_C * 1000));
+
+    xSysmonTask = xTaskCreateStatic( prvSysmonTask,
+                                     ( const char * ) "SysMon",
+                                     SYSMON_TASK_STACK_SIZE,
+                                     NULL,
+                                     task_priority,
+                                     RPU_TASK_STACK_BUF(xSysmonStack),
+                                     &xSysmonTaskBuffer );
+
+    Status = XSetupInterruptSystem(&xSysmon, (Xil_ExceptionHandler)prvSysmonIntr,
+                                   SYSMON_INTR_ID, SYSMON_INTC_PARENT, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XSysMonPsu_IntrEnable(&xSysmon, SYSMON_ALARM_INTR);
+    XEnableIntrId(SYSMON_INTR_ID, SYSMON_INTC_PARENT);
+
+    __sync_synchronize();
+    Xil_Out32(SYSMON_ADDR + SYSMON_MAGIC_OFFSET, SYSMON_MAGIC);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_SYSMON */
@@ -0,0 +1,65 @@
+/*
+ * Die temperature and PS supply monitoring with the PS SYSMON (build option
+ * RPU_SYSMON=1, UserConfig.cmake; RPU0 firmware only).
+ *
+ * xRpuSysmonInit() runs the PS SYSMON sequencer continuously over the LPD
+ * and FPD temperature sensors and the main PS supplies (SYSMON_CH_*,
+ * rpu_shm.h), with the sequencer's own 256-conversion averaging on every
+ * channel, so the firmware never starts or waits for a conversion. A low
+ * priority task reads the latest averages every RPU_SYSMON_PERIOD_MS and
+ * publishes them, with their extremes, into the SYSMON block in OCM; the APU
+ * can shed load on SYSMON_FLAG_HOT without going through sysfs
+ * (apu_app/rpu_stats --sysmon prints the block).
+ *
+ * The temperature alarm of the PS SYSMON is programmed in hysteresis mode:
+ * it sets above RPU_SYSMON_HOT_C and clears below RPU_SYSMON_COOL_C on the
+ * LPD sensor. Its interrupt wakes the task at once, so the flag is published
+ * within one averaged conversion of crossing the threshold; the flag clears
+ * at the next periodic pass below RPU_SYSMON_COOL_C.
+ *
+ * The driver resets the AMS block at initialization. Disable the Linux
+ * xilinx-ams driver (the ams node of the device tree) on a board running
+ * this firmware, or the two will reprogram the sequencer under each other.
+ * The over-temperature shutdown alarm stays as configured.
+ */
+
+#ifndef RPU_SYSMON_H
+#define RPU_SYSMON_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_SYSMON
+#define RPU_SYSMON 0
+#endif
+
+#define RPU_SYSMON_PERIOD_MS    250
+
+#ifndef RPU_SYSMON_HOT_C
+#define RPU_SYSMON_HOT_C        85
+#endif
+#ifndef RPU_SYSMON_COOL_C
+#define RPU_SYSMON_COOL_C       75
+#endif
+
+#if RPU_SYSMON
+#if RPU_CORE != 0
+#error "RPU_SYSMON is for the RPU0 firmware: there is one SYSMON for both cores"
+#endif
+#if RPU_SYSMON_COOL_C >= RPU_SYSMON_HOT_C
+#error "RPU_SYSMON_COOL_C must be below RPU_SYSMON_HOT_C"
+#endif
+
+int xRpuSysmonInit(UBaseType_t task_priority, u16 intr_priority);
+#else
+static inline int xRpuSysmonInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    (void)task_priority;
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_SYSMON */
+
+#endif /* RPU_SYSMON_H */
@@ -0,0 +1,31 @@
+/*
+ * Boot-time setup of the TCM sections (see rpu_tcm.h, lscript.ld).
+ */
+
+#include <string.h>
+
+#include "xil_types.h"
+
+#include "rpu_core.h"
+#include "rpu_tcm.h"
+
+extern char __btcm_bss_start[];
+extern char __btcm_bss_end[];
+
+#if RPU_SHM_TCM
+/* The shared window (rpu_core.h): first in BTCM, at RPU_SHM_BASE */
+static u32 ulShmTcm[SHARED_MEM_SIZE / 4] __attribute__((section(".btcm_shm"), used));
+#endif /* RPU_SHM_TCM */
+
+/*-----------------------------------------------------------*/
+/* .btcm_bss is NOLOAD, like .bss: remoteproc zero-fills it as part of the
+ * BTCM segment, a JTAG download leaves whatever was there. So is the TCM
+ * window, which starts from zero like a freshly powered IPI message RAM;
+ * the APU does not use it before the firmware publishes the redirect */
+RPU_INIT_TEXT void vRpuTcmInit(void)
+{
+    memset(__btcm_bss_start, 0, (size_t)(__btcm_bss_end - __btcm_bss_start));
+#if RPU_SHM_TCM
+    memset(ulShmTcm, 0, sizeof(ulShmTcm));
+#endif /* RPU_SHM_TCM */
+}
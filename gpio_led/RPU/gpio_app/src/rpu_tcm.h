@@ -0,0 +1,46 @@
+/*
+ * Placement of RPU objects in the R5 tightly coupled memories (lscript.ld).
+ *
+ * The TCMs are single-cycle and never go through the caches, so code and
+ * data placed there have the same access time on every interrupt, whatever
+ * the tasks did to the caches in between. Each bank is 64 KB:
+ *
+ *   ATCM 0x00000  Vectors and boot code, then .atcm_text: RPU_ATCM_TEXT
+ *                 functions, the FreeRTOS interrupt entry (portASM.S,
+ *                 portZynqUltrascale.c and port.c from libfreertos.a) and
+ *                 the scheduler's tick and switch path (tasks.c, list.c)
+ *   BTCM 0x20000  .btcm_data (RPU_BTCM_DATA), .btcm_bss (RPU_BTCM_BSS), the
+ *                 exception mode stacks including the IRQ stack, then
+ *                 .btcm_noinit
+ *
+ * - RPU_ATCM_TEXT: code on an interrupt or real-time path. Calls into DDR
+ *   code still work (the linker adds long-branch veneers) but take a DDR
+ *   fetch, so hot helpers should be static inline or tagged as well
+ * - RPU_BTCM_DATA: data read or written on those paths with a non-zero
+ *   initialiser. Loaded with the image like .data
+ * - RPU_BTCM_BSS: the same for zero-initialised data. Not in the image file,
+ *   so remoteproc does not copy it; vRpuTcmInit() clears it at the top of
+ *   main(), before anything uses it
+ * - RPU_BTCM_NOINIT: BTCM, neither loaded nor zeroed at boot. Only for
+ *   objects that are fully set up at run time, such as the StaticTask_t,
+ *   stack and StaticTimer_t buffers handed to the *CreateStatic() functions
+ * - RPU_INIT_TEXT: code that runs once at boot (the module init functions).
+ *   Kept in DDR in .init_text, after .text, so the code the tasks run stays
+ *   together in the I-cache
+ *
+ * Overflowing a bank is a link error, not a silent spill to DDR.
+ */
+
+#ifndef RPU_TCM_H
+#define RPU_TCM_H
+
+#define RPU_ATCM_TEXT    __attribute__((section(".atcm_text")))
+#define RPU_BTCM_DATA    __attribute__((section(".btcm_data")))
+#define RPU_BTCM_BSS     __attribute__((section(".btcm_bss")))
+#define RPU_BTCM_NOINIT  __attribute__((section(".btcm_noinit")))
+#define RPU_INIT_TEXT    __attribute__((section(".init_text")))
+
+/* Clears .btcm_bss; first thing in main() */
+void vRpuTcmInit(void);
+
+#endif /* RPU_TCM_H */
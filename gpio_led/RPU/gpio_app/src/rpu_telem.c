@@ -0,0 +1,345 @@
+/*
+ * Binary telemetry on the console UART (see rpu_telem.h).
+ *
+ * Frames are built in one buffer, closed with the CRC and COBS-encoded into
+ * a second one together with both delimiters, which then goes to the
+ * console ring in a single xRpuUartTxWrite(). Trace entries are read from
+ * the shared window with the same sequence-number check as the APU reader
+ * (apu_app/rpu_trace), so an entry overwritten while it is copied is
+ * skipped, not sent torn.
+ */
+
+#include <string.h>
+#include <xil_io.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_exec.h"
+#include "rpu_log.h"
+#include "rpu_stackguard.h"
+#include "rpu_stats.h"
+#include "rpu_tcm.h"
+#include "rpu_telem.h"
+#include "rpu_trace.h"
+
+#if RPU_UART_TELEMETRY
+
+#if RPU_TRACE_COMPACT
+#error "RPU_UART_TELEMETRY reads the fixed trace entries: build it with RPU_TRACE_COMPACT=0"
+#endif
+
+#define TELEM_TASK_STACK_SIZE  configMINIMAL_STACK_SIZE
+#define TELEM_FRAME_MAX        288   /* Largest frame: a full trace frame */
+#define TELEM_WIRE_MAX         (TELEM_FRAME_MAX + TELEM_FRAME_MAX / 254 + 3)
+#define TELEM_TRACE_ENTRY_SIZE 17
+
+#if (2 + 5 + RPU_TELEM_TRACE_MAX * TELEM_TRACE_ENTRY_SIZE + 2) > TELEM_FRAME_MAX
+#error "RPU_TELEM_TRACE_MAX trace entries do not fit TELEM_FRAME_MAX"
+#endif
+#if (2 + 21 + SHM_STATS_MAX_TASKS * 12 + 2) > TELEM_FRAME_MAX || \
+    (2 + SHM_STATS_MAX_TASKS * (1 + SHM_STATS_NAME_LEN) + 2) > TELEM_FRAME_MAX
+#error "SHM_STATS_MAX_TASKS tasks do not fit TELEM_FRAME_MAX"
+#endif
+
+static u8 ucTelemFrame[ TELEM_FRAME_MAX ] RPU_BTCM_NOINIT;
+static u8 ucTelemWire[ TELEM_WIRE_MAX ] RPU_BTCM_NOINIT;
+static u32 ulTelemLen;
+static u8 ucTelemSeq;
+static u32 ulTelemDropped;
+static u32 ulTelemTraceNext;
+static TaskStatus_t xTelemStatus[ SHM_STATS_MAX_TASKS ];
+#if !RPU_EXEC
+static StaticTask_t xTelemTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xTelemStack, TELEM_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+#endif /* !RPU_EXEC */
+
+/*-----------------------------------------------------------*/
+static void prvPut8(u32 v)
+{
+    ucTelemFrame[ulTelemLen++] = (u8)v;
+}
+
+static void prvPut16(u32 v)
+{
+    prvPut8(v);
+    prvPut8(v >> 8);
+}
+
+static void prvPut32(u32 v)
+{
+    prvPut16(v);
+    prvPut16(v >> 16);
+}
+
+/*-----------------------------------------------------------*/
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), bitwise: frames are small */
+static u16 prvCrc16(const u8 *data, u32 len)
+{
+    u16 crc = 0xFFFF;
+    u32 bit;
+
+    while (len-- != 0) {
+        crc ^= (u16)(*data++ << 8);
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (u16)((crc << 1) ^ 0x1021) : (u16)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*-----------------------------------------------------------*/
+/* COBS-encode len bytes into out; returns the encoded length */
+static u32 prvCobsEncode(const u8 *in, u32 len, u8 *out)
+{
+    u32 code_pos = 0;
+    u32 pos = 1;
+    u8 code = 1;
+    u32 i;
+
+    for (i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+            continue;
+        }
+        out[pos++] = in[i];
+        if (++code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return pos;
+}
+
+/*-----------------------------------------------------------*/
+static void prvFrameBegin(u32 type)
+{
+    ulTelemLen = 0;
+    prvPut8(type);
+    prvPut8(ucTelemSeq);
+}
+
+/*-----------------------------------------------------------*/
+/* Close the frame and queue it; the sequence number advances either way so
+ * the decoder sees dropped frames as gaps */
+static void prvFrameSend(void)
+{
+    u32 len;
+
+    prvPut16(prvCrc16(ucTelemFrame, ulTelemLen));
+    ucTelemWire[0] = 0;
+    len = 1 + prvCobsEncode(ucTelemFrame, ulTelemLen, &ucTelemWire[1]);
+    ucTelemWire[len++] = 0;
+
+    if (xRpuUartTxWrite(ucTelemWire, len) != XST_SUCCESS) {
+        ulTelemDropped++;
+    }
+    ucTelemSeq++;
+}
+
+/*-----------------------------------------------------------*/
+/* Task stats and, every RPU_TELEM_NAMES_EVERY periods, the task names */
+static void prvSendStats(int names)
+{
+    configRUN_TIME_COUNTER_TYPE total;
+    char name[SHM_STATS_NAME_LEN];
+    UBaseType_t count, i;
+    u32 c;
+
+    count = uxTaskGetSystemState(xTelemStatus, SHM_STATS_MAX_TASKS, &total);
+
+    prvFrameBegin(RPU_TELEM_STATS);
+    prvPut32(xTaskGetTickCount());
+    prvPut32(total);
+    prvPut32(ulRpuStatsHz());
+#if (configSUPPORT_DYNAMIC_ALLOCATION == 1)
+    prvPut32(xPortGetFreeHeapSize());
+    prvPut32(xPortGetMinimumEverFreeHeapSize());
+#else
+    prvPut32(0);
+    prvPut32(0);
+#endif
+    prvPut8(count);
+    for (i = 0; i < count; i++) {
+        prvPut32(xTelemStatus[i].ulRunTimeCounter);
+        prvPut32(xTelemStatus[i].usStackHighWaterMark * sizeof(StackType_t));
+        prvPut8(xTelemStatus[i].xTaskNumber);
+        prvPut8(xTelemStatus[i].uxCurrentPriority);
+        prvPut8(xTelemStatus[i].eCurrentState);
+        prvPut8(0);
+    }
+    prvFrameSend();
+
+    if (!names) {
+        return;
+    }
+    prvFrameBegin(RPU_TELEM_TASKS);
+    for (i = 0; i < count; i++) {
+        memset(name, 0, sizeof(name));
+        strncpy(name, xTelemStatus[i].pcTaskName, SHM_STATS_NAME_LEN - 1);
+        prvPut8(xTelemStatus[i].xTaskNumber);
+        for (c = 0; c < SHM_STATS_NAME_LEN; c++) {
+            prvPut8(name[c]);
+        }
+    }
+    prvFrameSend();
+}
+
+/*-----------------------------------------------------------*/
+/* Copy trace entry idx into the frame if it is still the one written for
+ * that index (seqlock style, as apu_app/rpu_trace) */
+static int prvPutTraceEntry(u32 idx)
+{
+    UINTPTR entry = RPU_SHM_BASE + SHM_TRACE_ENTRY(idx);
+    u32 event, arg0, arg1, ts_lo, ts_hi;
+
+    if (Xil_In32(entry + SHM_TRACE_SEQ) != idx + 1) {
+        return 0;
+    }
+    __sync_synchronize();
+    event = Xil_In32(entry + SHM_TRACE_EVENT);
+    arg0 = Xil_In32(entry + SHM_TRACE_ARG0);
+    arg1 = Xil_In32(entry + SHM_TRACE_ARG1);
+    ts_lo = Xil_In32(entry + SHM_TRACE_TS_LO);
+    ts_hi = Xil_In32(entry + SHM_TRACE_TS_HI);
+    __sync_synchronize();
+    if (Xil_In32(entry + SHM_TRACE_SEQ) != idx + 1) {
+        return 0;
+    }
+
+    prvPut8(event);
+    prvPut32(arg0);
+    prvPut32(arg1);
+    prvPut32(ts_lo);
+    prvPut32(ts_hi);
+    return 1;
+}
+
+/*-----------------------------------------------------------*/
+/* Trace entries written since the last period, RPU_TELEM_TRACE_MAX per frame */
+static void prvSendTrace(void)
+{
+    u32 head = Xil_In32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET);
+    u32 count_pos, count;
+
+    // Restarted trace, or lapped: resume at the oldest entry still there
+    if ((s32)(head - ulTelemTraceNext) < 0 ||
+        head - ulTelemTraceNext > SHM_TRACE_SLOTS) {
+        ulTelemTraceNext = head > SHM_TRACE_SLOTS ? head - SHM_TRACE_SLOTS : 0;
+    }
+
+    while (ulTelemTraceNext != head) {
+        prvFrameBegin(RPU_TELEM_TRACE);
+        prvPut32(ulTelemTraceNext);
+        count_pos = ulTelemLen;
+        prvPut8(0);
+        for (count = 0; count < RPU_TELEM_TRACE_MAX && ulTelemTraceNext != head; count++) {
+            if (!prvPutTraceEntry(ulTelemTraceNext)) {
+                break;
+            }
+            ulTelemTraceNext++;
+        }
+
+        if (count != 0) {
+            ucTelemFrame[count_pos] = (u8)count;
+            prvFrameSend();
+        }
+        if (ulTelemTraceNext != head && count < RPU_TELEM_TRACE_MAX) {
+            // Still being written: next period. Overwritten: skip ahead
+            head = Xil_In32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET);
+            if (head - ulTelemTraceNext <= SHM_TRACE_SLOTS) {
+                return;
+            }
+            ulTelemTraceNext = head - SHM_TRACE_SLOTS;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+static void prvSendQueues(void)
+{
+    u32 bulk = 0;
+
+    if (Xil_In32(RPU_BULK_CTRL_BASE + BULK_MAGIC_OFFSET) == BULK_MAGIC) {
+        bulk = Xil_In32(RPU_BULK_CTRL_BASE + BULK_HEAD_OFFSET) -
+               Xil_In32(RPU_BULK_CTRL_BASE + BULK_TAIL_OFFSET);
+    }
+
+    prvFrameBegin(RPU_TELEM_QUEUES);
+    prvPut32(xTaskGetTickCount());
+    prvPut16(Xil_In32(RPU_SHM_BASE + SHM_RING_HEAD_OFFSET) -
+             Xil_In32(RPU_SHM_BASE + SHM_RING_TAIL_OFFSET));
+    prvPut16(bulk);
+    prvPut16(ulRpuLogPending());
+    prvPut16(RPU_UART_TX_SIZE - ulRpuUartTxFree());
+    prvPut32(Xil_In32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET));
+    prvPut32(ulTelemDropped);
+    prvFrameSend();
+}
+
+/*-----------------------------------------------------------*/
+/* One set of frames; the task names every RPU_TELEM_NAMES_EVERY periods */
+static void prvTelemSend(void)
+{
+    static u32 period;
+
+    prvSendStats(period % RPU_TELEM_NAMES_EVERY == 0);
+    prvSendTrace();
+    prvSendQueues();
+    period++;
+}
+
+#if RPU_EXEC
+/*-----------------------------------------------------------*/
+/* From a slot of the executive every RPU_TELEM_PERIOD_MS (rpu_exec.h) */
+void vRpuTelemPoll(void)
+{
+    prvTelemSend();
+}
+#else
+/*-----------------------------------------------------------*/
+/* The Telemetry Task:
+ * - Sends one set of frames every RPU_TELEM_PERIOD_MS.
+ */
+static void prvTelemTask(void *pvParameters)
+{
+    TickType_t xLastWake = xTaskGetTickCount();
+
+    (void)pvParameters;
+
+    for (;;) {
+        prvTelemSend();
+        vTaskDelayUntil(&xLastWake, pdMS_TO_TICKS(RPU_TELEM_PERIOD_MS));
+    }
+}
+#endif /* RPU_EXEC */
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuTelemInit(UBaseType_t task_priority)
+{
+    u32 head = Xil_In32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET);
+
+    // Start with whatever the trace still holds from the boot
+    ulTelemTraceNext = head > SHM_TRACE_SLOTS ? head - SHM_TRACE_SLOTS : 0;
+    ulTelemLen = 0;
+    ucTelemSeq = 0;
+    ulTelemDropped = 0;
+
+#if RPU_EXEC
+    (void)task_priority;
+#else
+    (void)xTaskCreateStatic( prvTelemTask,
+                             ( const char * ) "Telem",
+                             TELEM_TASK_STACK_SIZE,
+                             NULL,
+                             task_priority,
+                             RPU_TASK_STACK_BUF(xTelemStack),
+                             &xTelemTaskBuffer );
+#endif /* RPU_EXEC */
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_UART_TELEMETRY */
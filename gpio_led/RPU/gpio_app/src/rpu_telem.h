@@ -0,0 +1,77 @@
+/*
+ * Binary telemetry on the console UART (build option RPU_UART_TELEMETRY=1,
+ * UserConfig.cmake; needs RPU_UART_TX=1, RPU0 firmware only).
+ *
+ * Every RPU_TELEM_PERIOD_MS a low-priority task samples the task stats,
+ * the new trace entries and the queue depths and sends them as COBS-encoded
+ * frames through the buffered console (xRpuUartTxWrite(), rpu_uart.h).
+ * A frame is a few hundred bytes where the same data as text would be
+ * several times that; built with RPU_UART_BAUD=921600 the link carries
+ * well over ten times the information of the 115200-baud text console.
+ * Decode it on the host with RPU/tools/rpu_telem.py.
+ *
+ * Wire format: 0x00, COBS(frame), 0x00. COBS output contains no zero byte
+ * and neither does console text, so text between frames passes through and
+ * the decoder prints it as before. A frame is
+ *   u8 type, u8 seq (per frame, wraps), payload, u16 CRC-16/CCITT-FALSE
+ * over type, seq and payload; all fields little-endian.
+ *
+ * Payloads:
+ *   RPU_TELEM_STATS   u32 tick, u32 run time total, u32 run time Hz,
+ *                     u32 free heap, u32 minimum free heap, u8 count, then
+ *                     count x { u32 run time, u32 stack free (bytes),
+ *                     u8 task number, u8 priority, u8 state, u8 0 }
+ *   RPU_TELEM_TASKS   count x { u8 task number, char name[SHM_STATS_NAME_LEN] }
+ *                     (first period and every RPU_TELEM_NAMES_EVERY periods)
+ *   RPU_TELEM_TRACE   u32 index of the first entry, u8 count, then count x
+ *                     { u8 event, u32 arg0, u32 arg1, u64 timestamp }
+ *                     (a gap in the indices counts lost trace entries)
+ *   RPU_TELEM_QUEUES  u32 tick, u16 command ring depth, u16 bulk ring depth,
+ *                     u16 log records pending, u16 console ring bytes used,
+ *                     u32 trace head, u32 frames dropped so far
+ *
+ * A frame that does not fit the console ring is dropped and counted, never
+ * truncated; text keeps its own drop accounting (rpu_log.h).
+ */
+
+#ifndef RPU_TELEM_H
+#define RPU_TELEM_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+#include "rpu_uart.h"
+
+#ifndef RPU_UART_TELEMETRY
+#define RPU_UART_TELEMETRY 0
+#endif
+
+#define RPU_TELEM_PERIOD_MS      100
+#define RPU_TELEM_NAMES_EVERY    50    /* Periods between task name frames */
+#define RPU_TELEM_TRACE_MAX      16    /* Trace entries per frame */
+
+/* Frame types */
+#define RPU_TELEM_STATS          1
+#define RPU_TELEM_TASKS          2
+#define RPU_TELEM_TRACE          3
+#define RPU_TELEM_QUEUES         4
+
+#if RPU_UART_TELEMETRY
+#if !RPU_UART_TX
+#error "RPU_UART_TELEMETRY needs the buffered console (RPU_UART_TX=1)"
+#endif
+
+/* Start the telemetry task; call after vRpuTraceInit() */
+int xRpuTelemInit(UBaseType_t task_priority);
+/* One set of frames (RPU_EXEC=1 builds, which have no telemetry task) */
+void vRpuTelemPoll(void);
+#else
+static inline int xRpuTelemInit(UBaseType_t task_priority)
+{
+    (void)task_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_UART_TELEMETRY */
+
+#endif /* RPU_TELEM_H */
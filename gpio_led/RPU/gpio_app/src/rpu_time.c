@@ -0,0 +1,72 @@
+/*
+ * System counter timestamps and the APU clock offset (see rpu_time.h,
+ * rpu_shm.h).
+ */
+
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+
+static u32 ulTimeHz RPU_BTCM_DATA = XPAR_CPU_TIMESTAMP_CLK_FREQ;
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT void vRpuTimeInit(void)
+{
+    u32 hz = Xil_In32(SCNTRS_BASE + SCNTRS_BASE_FREQ_OFFSET);
+
+    // Not programmed (JTAG boot without the FSBL): assume the design value
+    if (hz == 0) {
+        hz = XPAR_CPU_TIMESTAMP_CLK_FREQ;
+    }
+    ulTimeHz = hz;
+
+    Xil_Out32(RPU_SHM_BASE + SHM_TIME_HZ_OFFSET, hz);
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_TIME_MAGIC_OFFSET, SHM_TIME_MAGIC);
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuTimeHz(void)
+{
+    return ulTimeHz;
+}
+
+/*-----------------------------------------------------------*/
+/* Whole seconds and remainder separately: ticks * 10^9 alone overflows */
+u64 ullRpuTimeToNs(u64 ticks)
+{
+    u64 sec = ticks / ulTimeHz;
+    u64 rem = ticks - sec * ulTimeHz;
+
+    return sec * 1000000000ULL + rem * 1000000000ULL / ulTimeHz;
+}
+
+/*-----------------------------------------------------------*/
+u64 ullRpuTimeToUs(u64 ticks)
+{
+    u64 sec = ticks / ulTimeHz;
+    u64 rem = ticks - sec * ulTimeHz;
+
+    return sec * 1000000ULL + rem * 1000000ULL / ulTimeHz;
+}
+
+/*-----------------------------------------------------------*/
+/* Copy the offset under the APU's sequence number, as readers of the stats do */
+int xRpuTimeMonotonicNs(u64 ticks, u64 *ns)
+{
+    UINTPTR base = RPU_SHM_BASE;
+    u32 seq, lo, hi;
+
+    if (Xil_In32(base + SHM_SYNC_MAGIC_OFFSET) != SHM_SYNC_MAGIC) {
+        return XST_FAILURE;
+    }
+    do {
+        seq = Xil_In32(base + SHM_SYNC_SEQ_OFFSET);
+        __sync_synchronize();
+        lo = Xil_In32(base + SHM_SYNC_OFFSET_LO);
+        hi = Xil_In32(base + SHM_SYNC_OFFSET_HI);
+        __sync_synchronize();
+    } while ((seq & 1) != 0 || seq != Xil_In32(base + SHM_SYNC_SEQ_OFFSET));
+
+    *ns = ullRpuTimeToNs(ticks) + (u64)(((u64)hi << 32) | lo);
+    return XST_SUCCESS;
+}
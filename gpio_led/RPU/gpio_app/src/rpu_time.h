@@ -0,0 +1,59 @@
+/*
+ * Microsecond (and finer) timestamps for the RPU firmware.
+ *
+ * The FreeRTOS tick only resolves 10 ms and the BSP's usleep()/msleep()
+ * block. ullRpuTimeNow() instead reads the 64-bit ZynqMP system counter
+ * (IOU_SCNTRS, ~100 MHz, never wraps in practice): free-running, a few
+ * register reads, callable from any context and from both cores. It is
+ * the counter the A53 generic timer (CNTVCT_EL0) reads, so it is also the
+ * time base of the trace (rpu_trace.h) and of every APU tool.
+ *
+ * Linux CLOCK_MONOTONIC is a different origin and rate (NTP slews it):
+ * apu_app/rpu_clock measures its offset against the counter and publishes it
+ * in the time base block of the shared window (rpu_shm.h).
+ * xRpuTimeMonotonicNs() converts a timestamp with it, so RPU events can be
+ * logged on the APU's timeline directly.
+ */
+
+#ifndef RPU_TIME_H
+#define RPU_TIME_H
+
+#include <xil_io.h>
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xparameters.h"
+#include "rpu_core.h"
+
+// ZynqMP system counter (IOU_SCNTRS), shared with the A53 generic timer
+#define SCNTRS_BASE            XPAR_PSU_IOU_SCNTRS_BASEADDR
+#define SCNTRS_CNTCV_LO_OFFSET 0x08  // Current counter value, lower 32 bits
+#define SCNTRS_CNTCV_HI_OFFSET 0x0C  // Current counter value, upper 32 bits
+#define SCNTRS_BASE_FREQ_OFFSET 0x20 // Base frequency ID (programmed by the FSBL)
+
+/* Read the 64-bit system counter consistently (upper word may tick over) */
+static inline u64 ullRpuTimeNow(void)
+{
+    u32 hi, lo;
+
+    do {
+        hi = Xil_In32(SCNTRS_BASE + SCNTRS_CNTCV_HI_OFFSET);
+        lo = Xil_In32(SCNTRS_BASE + SCNTRS_CNTCV_LO_OFFSET);
+    } while (hi != Xil_In32(SCNTRS_BASE + SCNTRS_CNTCV_HI_OFFSET));
+
+    return ((u64)hi << 32) | lo;
+}
+
+/* Read the counter frequency and publish it; called once the shared window is
+ * mapped in the MPU */
+void vRpuTimeInit(void);
+u32 ulRpuTimeHz(void);
+
+/* Counter ticks to ns / us (64-bit, no overflow for any counter value) */
+u64 ullRpuTimeToNs(u64 ticks);
+u64 ullRpuTimeToUs(u64 ticks);
+
+/* Ticks to APU CLOCK_MONOTONIC ns; XST_FAILURE (and *ns unchanged) until
+ * apu_app/rpu_clock has published an offset */
+int xRpuTimeMonotonicNs(u64 ticks, u64 *ns);
+
+#endif /* RPU_TIME_H */
@@ -0,0 +1,165 @@
+/*
+ * Time-triggered commands (see rpu_timed.h, rpu_shm.h).
+ *
+ * The stats counter is in overflow mode; setting its match mode bit only
+ * adds the compare, the count goes on unchanged. The compare is for
+ * equality, so a match value the counter has passed by the time it is
+ * written would only fire a full wrap later: ulRpuTimedRun() reads the
+ * counter back after arming and handles that case itself.
+ */
+
+#include <xil_io.h>
+#include "xttcps.h"
+#include "xinterrupt_wrap.h"
+#include "xstatus.h"
+
+#include "rpu_exec.h"
+#include "rpu_shm.h"
+#include "rpu_stats.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_timed.h"
+#include "rpu_trace.h"
+
+#define TIMED_TTC_BASEADDR  RPU_STATS_TTC_BASEADDR
+#define TIMED_TTC_RD(reg)       XTtcPs_ReadReg(TIMED_TTC_BASEADDR, (reg))
+#define TIMED_TTC_WR(reg, val)  XTtcPs_WriteReg(TIMED_TTC_BASEADDR, (reg), (val))
+
+typedef struct {
+    u64 tick;
+    u32 opcode;
+    u32 arg;
+} RpuTimedCmd_t;
+
+/* Sorted by tick, earliest first; equal ticks in queueing order */
+static RpuTimedCmd_t xTimedCmds[RPU_CMD_AT_SLOTS] RPU_BTCM_BSS;
+static u32 ulTimedCount RPU_BTCM_BSS;
+static TaskHandle_t xTimedTask;
+
+/*-----------------------------------------------------------*/
+static void prvTimedHandler(void *CallbackRef)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    (void)CallbackRef;
+
+    // Clear on read
+    if (TIMED_TTC_RD(XTTCPS_ISR_OFFSET) & XTTCPS_IXR_MATCH_0_MASK) {
+        vRpuExecNotifyFromIsr(xTimedTask, &xHigherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+/* Match interrupt at system counter tick 'at' (ahead of now); pdFALSE if
+ * the stats counter already passed the match value when it was written */
+static BaseType_t prvTimedArm(u64 at, u64 now)
+{
+    u64 ticks = ((at - now) * ulRpuStatsHz() + ulRpuTimeHz() - 1) / ulRpuTimeHz();
+    u32 match = TIMED_TTC_RD(XTTCPS_COUNT_VALUE_OFFSET) + (u32)ticks;
+
+    TIMED_TTC_WR(XTTCPS_MATCH_0_OFFSET, match);
+    TIMED_TTC_WR(XTTCPS_CNT_CNTRL_OFFSET,
+                 TIMED_TTC_RD(XTTCPS_CNT_CNTRL_OFFSET) | XTTCPS_CNT_CNTRL_MATCH_MASK);
+    TIMED_TTC_WR(XTTCPS_IER_OFFSET, XTTCPS_IXR_MATCH_0_MASK);
+    return (s32)(match - TIMED_TTC_RD(XTTCPS_COUNT_VALUE_OFFSET)) > 0 ? pdTRUE : pdFALSE;
+}
+
+static void prvTimedDisarm(void)
+{
+    TIMED_TTC_WR(XTTCPS_IER_OFFSET, 0);
+    (void)TIMED_TTC_RD(XTTCPS_ISR_OFFSET);
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuTimedInit(TaskHandle_t task, u16 intr_priority)
+{
+    XTtcPs_Config *cfg = XTtcPs_LookupConfig(TIMED_TTC_BASEADDR);
+    int Status;
+
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    xTimedTask = task;
+
+    // The counter itself is started with the scheduler (rpu_stats.c)
+    Status = XSetupInterruptSystem(NULL, (Xil_ExceptionHandler)prvTimedHandler,
+                                   cfg->IntrId[0], cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId[0], cfg->IntrParent);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+u64 ullRpuTimedFromLow(u32 tick_lo)
+{
+    u64 now = ullRpuTimeNow();
+
+    return now + (s64)(s32)(tick_lo - (u32)now);
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuTimedQueue(u64 tick, u32 opcode, u32 arg)
+{
+    s64 ahead = (s64)(tick - ullRpuTimeNow());
+    u32 i;
+
+    if (opcode == RPU_CMD_AT || ahead > (s64)RPU_CMD_AT_MAX_AHEAD) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+    if (ahead <= 0) {
+        return RPU_CMD_STATUS_LATE;
+    }
+    if (ulTimedCount == RPU_CMD_AT_SLOTS) {
+        return RPU_CMD_STATUS_FAILED;
+    }
+
+    for (i = ulTimedCount; i > 0 && (s64)(xTimedCmds[i - 1].tick - tick) > 0; i--) {
+        xTimedCmds[i] = xTimedCmds[i - 1];
+    }
+    xTimedCmds[i].tick = tick;
+    xTimedCmds[i].opcode = opcode;
+    xTimedCmds[i].arg = arg;
+    ulTimedCount++;
+
+    // A new earliest command: the next pass arms for it (or runs it)
+    if (i == 0) {
+        vRpuExecNotify(xTimedTask);
+    }
+    return RPU_CMD_STATUS_OK;
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuTimedRun(RpuMpCmdExec_t exec)
+{
+    u64 lead = ((u64)RPU_TIMED_LEAD_NS * ulRpuTimeHz()) / 1000000000ULL;
+    u32 count = 0;
+
+    while (ulTimedCount != 0) {
+        RpuTimedCmd_t cmd = xTimedCmds[0];
+        u64 now = ullRpuTimeNow();
+        u32 status, i;
+
+        if ((s64)(cmd.tick - now) > (s64)lead) {
+            if (prvTimedArm(cmd.tick - lead, now)) {
+                return count;
+            }
+            continue;
+        }
+
+        while ((s64)(cmd.tick - (now = ullRpuTimeNow())) > 0) {
+        }
+        status = exec(cmd.opcode, cmd.arg);
+        vRpuTrace(RPU_TRACE_TIMED, cmd.opcode | (status << 16),
+                  (u32)(s32)ullRpuTimeToNs(now - cmd.tick));
+
+        ulTimedCount--;
+        for (i = 0; i < ulTimedCount; i++) {
+            xTimedCmds[i] = xTimedCmds[i + 1];
+        }
+        count++;
+    }
+    prvTimedDisarm();
+    return count;
+}
@@ -0,0 +1,41 @@
+/*
+ * Time-triggered commands (RPU_CMD_AT, rpu_shm.h "Timed commands").
+ *
+ * Commands held for a system counter tick wait in a list sorted by tick.
+ * There is no TTC counter left for them (rpu_core.h), so the wake-up uses
+ * match register 0 of the run-time stats counter (rpu_stats.h), which runs
+ * free at 160 ns per count and keeps doing so: the match interrupt
+ * notifies the IPI task RPU_TIMED_LEAD_NS before the earliest tick, and
+ * ulRpuTimedRun() at the start of its pass spins on the system counter for
+ * the rest, so the command runs within a few counter ticks of its target
+ * however long the interrupt and the task switch took. It runs with the
+ * same executor as the multi-producer channel, in the IPI task, like any
+ * other command.
+ *
+ * Both functions that touch the list are for the IPI task only; the
+ * interrupt handler just notifies it. The stats counter must be running,
+ * i.e. the scheduler started, before the first command is queued.
+ */
+
+#ifndef RPU_TIMED_H
+#define RPU_TIMED_H
+
+#include "xil_types.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "rpu_mpcmd.h"
+
+#ifndef RPU_TIMED_LEAD_NS
+#define RPU_TIMED_LEAD_NS   5000    /* Interrupt this far ahead, then spin */
+#endif
+
+/* Connect the match interrupt of the stats counter; the IPI task is notified */
+int xRpuTimedInit(TaskHandle_t task, u16 intr_priority);
+/* System counter tick nearest to now with these low 32 bits */
+u64 ullRpuTimedFromLow(u32 tick_lo);
+/* Hold a command for tick; RPU_CMD_STATUS_OK, _LATE, _BADARG or _FAILED */
+u32 ulRpuTimedQueue(u64 tick, u32 opcode, u32 arg);
+/* Run the commands due and re-arm for the next one; returns the number run */
+u32 ulRpuTimedRun(RpuMpCmdExec_t exec);
+
+#endif /* RPU_TIMED_H */
@@ -0,0 +1,145 @@
+/*
+ * Event trace for RPU -> APU telemetry (see rpu_trace.h, rpu_shm.h).
+ *
+ * Writers reserve an index with an atomic increment, invalidate the slot's
+ * sequence number, fill it and then store index + 1 as the sequence number.
+ * The shared head is a hint for readers: an interrupted writer that finishes
+ * after a nested one does not move it backwards, and readers validate every
+ * entry by its sequence number anyway.
+ *
+ * The compact writer (RPU_TRACE_COMPACT) encodes into a local buffer with
+ * the interrupts, FIQ included, masked: records are appended in order, so
+ * timestamp deltas are never negative. The record's bytes are stored before
+ * the block's USED word that publishes them; a record that does not fit
+ * opens the next block, whose SEQ is cleared while its header is rewritten.
+ */
+
+#include <xil_io.h>
+#include "xpseudo_asm.h"
+
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_trace.h"
+
+#if RPU_TRACE_COMPACT
+
+#include "rpu_trace_compact.h"
+
+static struct rpu_tracez_state xTraceZ RPU_BTCM_BSS;
+static u32 ulTraceBlock RPU_BTCM_BSS;           /* Number of the block written, 0 before the first */
+static u32 ulTraceUsed RPU_BTCM_BSS;            /* Its record bytes */
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT void vRpuTraceInit(void)
+{
+    u32 n;
+
+    rpu_tracez_begin(&xTraceZ, 0, 0);
+    ulTraceBlock = 0;
+    ulTraceUsed = 0;
+    for (n = 1; n <= SHM_TRACEZ_BLOCKS; n++) {
+        Xil_Out32(RPU_SHM_BASE + SHM_TRACEZ_BLOCK(n) + SHM_TRACEZ_SEQ, 0);
+    }
+    Xil_Out32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET, 0);
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_TRACE_MAGIC_OFFSET, SHM_TRACE_MAGIC_COMPACT);
+}
+
+/*-----------------------------------------------------------*/
+/* Start the next block with its first event at ts */
+RPU_ATCM_TEXT static void prvTraceOpen(u64 ts)
+{
+    UINTPTR blk;
+
+    ulTraceBlock++;
+    ulTraceUsed = 0;
+    blk = RPU_SHM_BASE + SHM_TRACEZ_BLOCK(ulTraceBlock);
+    rpu_tracez_begin(&xTraceZ, ts, xTraceZ.index);
+
+    Xil_Out32(blk + SHM_TRACEZ_SEQ, 0);
+    __sync_synchronize();
+    Xil_Out32(blk + SHM_TRACEZ_USED, 0);
+    Xil_Out32(blk + SHM_TRACEZ_FIRST, xTraceZ.index);
+    Xil_Out32(blk + SHM_TRACEZ_BASE_LO, (u32)ts);
+    Xil_Out32(blk + SHM_TRACEZ_BASE_HI, (u32)(ts >> 32));
+    __sync_synchronize();
+    Xil_Out32(blk + SHM_TRACEZ_SEQ, ulTraceBlock);
+    Xil_Out32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET, ulTraceBlock);
+}
+
+/*-----------------------------------------------------------*/
+/* Append one event; safe from tasks and interrupt handlers */
+RPU_ATCM_TEXT void vRpuTrace(u32 event, u32 arg0, u32 arg1)
+{
+    u8 rec[RPU_TRACEZ_MAX_RECORD];
+    UINTPTR data;
+    u32 cpsr, len, i;
+    u64 ts;
+
+    cpsr = mfcpsr();
+    __asm volatile ("cpsid if" ::: "memory");
+    ts = ullRpuTimeNow();
+    len = rpu_tracez_encode(&xTraceZ, rec, event, arg0, arg1, ts);
+    if (len != 0) {
+        if (ulTraceBlock == 0 || ulTraceUsed + len > SHM_TRACEZ_DATA_SIZE) {
+            prvTraceOpen(ts);
+            len = rpu_tracez_encode(&xTraceZ, rec, event, arg0, arg1, ts);
+        }
+        data = RPU_SHM_BASE + SHM_TRACEZ_BLOCK(ulTraceBlock) + SHM_TRACEZ_DATA + ulTraceUsed;
+        for (i = 0; i < len; i++) {
+            Xil_Out8(data + i, rec[i]);
+        }
+        rpu_tracez_commit(&xTraceZ, event, arg0, arg1, ts);
+        ulTraceUsed += len;
+        __sync_synchronize();
+        Xil_Out32(RPU_SHM_BASE + SHM_TRACEZ_BLOCK(ulTraceBlock) + SHM_TRACEZ_USED, ulTraceUsed);
+    }
+    mtcpsr(cpsr);
+}
+
+#else
+
+static volatile u32 ulTraceNext RPU_BTCM_BSS;  /* Next index to reserve */
+
+/*-----------------------------------------------------------*/
+/* Start a new trace; called once the shared window is mapped in the MPU */
+RPU_INIT_TEXT void vRpuTraceInit(void)
+{
+    u32 idx;
+
+    ulTraceNext = 0;
+    for (idx = 0; idx < SHM_TRACE_SLOTS; idx++) {
+        Xil_Out32(RPU_SHM_BASE + SHM_TRACE_ENTRY(idx) + SHM_TRACE_SEQ, 0);
+    }
+    Xil_Out32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET, 0);
+    __sync_synchronize();
+    Xil_Out32(RPU_SHM_BASE + SHM_TRACE_MAGIC_OFFSET, SHM_TRACE_MAGIC);
+}
+
+/*-----------------------------------------------------------*/
+/* Append one event; safe from tasks and interrupt handlers */
+RPU_ATCM_TEXT void vRpuTrace(u32 event, u32 arg0, u32 arg1)
+{
+    u32 idx = __atomic_fetch_add(&ulTraceNext, 1, __ATOMIC_RELAXED);
+    UINTPTR entry = RPU_SHM_BASE + SHM_TRACE_ENTRY(idx);
+    u64 ts = ullRpuTimeNow();
+
+    // Readers must not accept the slot while it is being rewritten
+    Xil_Out32(entry + SHM_TRACE_SEQ, 0);
+    __sync_synchronize();
+
+    Xil_Out32(entry + SHM_TRACE_EVENT, event);
+    Xil_Out32(entry + SHM_TRACE_ARG0, arg0);
+    Xil_Out32(entry + SHM_TRACE_ARG1, arg1);
+    Xil_Out32(entry + SHM_TRACE_TS_LO, (u32)ts);
+    Xil_Out32(entry + SHM_TRACE_TS_HI, (u32)(ts >> 32));
+    __sync_synchronize();
+    Xil_Out32(entry + SHM_TRACE_SEQ, idx + 1);
+
+    // Publish the head unless a nested writer already moved it further
+    if ((s32)(idx + 1 - Xil_In32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET)) > 0) {
+        Xil_Out32(RPU_SHM_BASE + SHM_TRACE_HEAD_OFFSET, idx + 1);
+    }
+}
+
+#endif /* RPU_TRACE_COMPACT */
@@ -0,0 +1,33 @@
+/*
+ * Event trace for RPU -> APU telemetry.
+ *
+ * vRpuTrace() appends a timestamped event to the trace buffer in the
+ * APU/RPU shared window (layout and event IDs in rpu_shm.h). The buffer is a
+ * flight recorder: the oldest entries are overwritten, nothing blocks and no
+ * UART output is involved. Events can be written from tasks and interrupt
+ * handlers. Timestamps are ullRpuTimeNow() ticks (rpu_time.h). The APU tool
+ * apu_app/rpu_trace decodes the buffer live.
+ *
+ * With RPU_TRACE_COMPACT=1 (UserConfig.cmake) the same area holds the
+ * compact coding of rpu_trace_compact.h instead of 24-byte entries: a
+ * timestamp delta and the arguments as varints behind a header byte, a few
+ * bytes an event, so the buffer keeps about three times the history and an
+ * event costs a handful of byte stores. Writers are then serialized with
+ * the interrupts masked. The DCC and UART telemetry transports read the
+ * fixed entries and are not built with it.
+ */
+
+#ifndef RPU_TRACE_H
+#define RPU_TRACE_H
+
+#include "xil_types.h"
+#include "rpu_core.h"
+
+#ifndef RPU_TRACE_COMPACT
+#define RPU_TRACE_COMPACT 0
+#endif
+
+void vRpuTraceInit(void);
+void vRpuTrace(u32 event, u32 arg0, u32 arg1);
+
+#endif /* RPU_TRACE_H */
@@ -0,0 +1,169 @@
+/*
+ * SLOW and FAST blink on a TTC waveform output (see rpu_ttcwave.h).
+ *
+ * The output is high from the interval start to the match with the polarity
+ * option set, low without it, so the value a square wave starts with is
+ * only the polarity. The level at a release comes from the counter against
+ * the match; the wave may toggle between that read and the select store, a
+ * few bus cycles, which moves the edge of that one release by as much.
+ * The Tx task and the IPI task (handoff, waveform start) both call in, so
+ * every call is one critical section.
+ */
+
+#include "rpu_ttcwave.h"
+
+#if RPU_TTC_WAVE
+
+#include <xil_io.h>
+#include "xttcps.h"
+#include "xgpiops.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_tcm.h"
+
+#define TTCWAVE_HIGH_FIRST      XTTCPS_OPTION_WAVE_POLARITY  // High up to the match
+#define TTCWAVE_SEL_BANK        (3 + RPU_TTC_WAVE_SEL_PIN / 32)  // EMIO banks 3..5
+#define TTCWAVE_SEL_BIT         (RPU_TTC_WAVE_SEL_PIN % 32)
+// MASK_DATA_LSW/MSW word of the pin: upper half masks the other 15 pins out
+#define TTCWAVE_SEL_MASK_DATA   (XGPIOPS_DATA_LSW_OFFSET + TTCWAVE_SEL_BANK * XGPIOPS_DATA_MASK_OFFSET + \
+                                 (TTCWAVE_SEL_BIT / 16) * 4)
+#define TTCWAVE_SEL_HIGH        (~(1U << (TTCWAVE_SEL_BIT % 16 + 16)) | (1U << (TTCWAVE_SEL_BIT % 16)))
+#define TTCWAVE_SEL_LOW         (~(1U << (TTCWAVE_SEL_BIT % 16 + 16)) & 0xFFFF0000U)
+#define TTCWAVE_MAX_PRESCALER   15    // Divide by 2^16
+
+static XTtcPs xTtcWave RPU_BTCM_NOINIT;
+static XGpioPs xTtcWaveGpio RPU_BTCM_NOINIT;
+static UINTPTR xTtcWaveSel RPU_BTCM_BSS;    /* Select pin's MASK_DATA word */
+static UINTPTR xTtcWaveData RPU_BTCM_BSS;   /* AXI GPIO channel 1 data */
+static u32 ulTtcWaveHz RPU_BTCM_BSS;        /* 0 until xRpuTtcWaveInit() */
+static u32 ulTtcWaveHalfMs RPU_BTCM_BSS;    /* Half period running, 0 = released */
+static u32 ulTtcWaveFirst RPU_BTCM_BSS;     /* LED value up to the match */
+static u32 ulTtcWaveMatch RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* Program a period of 2 * half_ms starting with led, from a stopped counter */
+static int prvTtcWaveProgram(u32 half_ms, u32 led)
+{
+    u64 ticks = (u64)ulTtcWaveHz * half_ms * 2 / 1000;
+    u8 prescaler = XTTCPS_CLK_CNTRL_PS_DISABLE;
+    u8 p;
+
+    if (ticks > XTTCPS_MAX_INTERVAL_COUNT) {
+        // 2^(p + 1) per count: the smallest that fits
+        for (p = 0; p <= TTCWAVE_MAX_PRESCALER && (ticks >> (p + 1)) > XTTCPS_MAX_INTERVAL_COUNT; p++) {
+        }
+        if (p > TTCWAVE_MAX_PRESCALER) {
+            return XST_INVALID_PARAM;
+        }
+        prescaler = p;
+        ticks >>= p + 1;
+    }
+    if (ticks < 2) {
+        return XST_INVALID_PARAM;
+    }
+
+    if (XTtcPs_SetOptions(&xTtcWave, XTTCPS_OPTION_INTERVAL_MODE | XTTCPS_OPTION_MATCH_MODE |
+                                     (led == 0x1 ? TTCWAVE_HIGH_FIRST : 0)) != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+    XTtcPs_SetPrescaler(&xTtcWave, prescaler);
+    // Interval mode counts 0..interval: one period is interval + 1 counts
+    XTtcPs_SetInterval(&xTtcWave, (XInterval)(ticks - 1));
+    ulTtcWaveMatch = (u32)(ticks / 2);
+    XTtcPs_SetMatchValue(&xTtcWave, 0, ulTtcWaveMatch);
+    XTtcPs_ResetCounterValue(&xTtcWave);
+    XTtcPs_Start(&xTtcWave);
+    ulTtcWaveFirst = led;
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuTtcWaveSet(u32 half_ms, u32 led)
+{
+    int Status = XST_SUCCESS;
+
+    if (ulTtcWaveHz == 0 || half_ms == 0) {
+        return XST_NO_FEATURE;
+    }
+    taskENTER_CRITICAL();
+    if (ulTtcWaveHalfMs != half_ms) {
+        XTtcPs_Stop(&xTtcWave);
+        Status = prvTtcWaveProgram(half_ms, led);
+        if (Status == XST_SUCCESS && ulTtcWaveHalfMs == 0) {
+            // The wave runs before the pins switch to it
+            __sync_synchronize();
+            Xil_Out32(xTtcWaveSel, TTCWAVE_SEL_HIGH);
+        }
+        ulTtcWaveHalfMs = (Status == XST_SUCCESS) ? half_ms : 0;
+    }
+    taskEXIT_CRITICAL();
+    return Status;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuTtcWaveRelease(u32 *led)
+{
+    u32 value;
+
+    taskENTER_CRITICAL();
+    if (ulTtcWaveHalfMs == 0) {
+        taskEXIT_CRITICAL();
+        return 0;
+    }
+    value = (XTtcPs_GetCounterValue(&xTtcWave) < ulTtcWaveMatch) ? ulTtcWaveFirst
+                                                                  : (ulTtcWaveFirst ^ 0x3);
+    // The AXI GPIO takes over at the level on the pins
+    Xil_Out32(xTtcWaveData, value);
+    __sync_synchronize();
+    Xil_Out32(xTtcWaveSel, TTCWAVE_SEL_LOW);
+    XTtcPs_Stop(&xTtcWave);
+    ulTtcWaveHalfMs = 0;
+    taskEXIT_CRITICAL();
+
+    *led = value;
+    return 1;
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuTtcWaveInit(UINTPTR gpio_data)
+{
+    XTtcPs_Config *cfg;
+    XGpioPs_Config *gcfg;
+    int Status;
+
+    xTtcWaveData = gpio_data;
+    ulTtcWaveHalfMs = 0;
+
+    gcfg = XGpioPs_LookupConfig(XPAR_XGPIOPS_0_BASEADDR);
+    if (gcfg == NULL || XGpioPs_CfgInitialize(&xTtcWaveGpio, gcfg, gcfg->BaseAddr) != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+    // The AXI GPIO keeps the pins until a periodic mode starts
+    xTtcWaveSel = gcfg->BaseAddr + TTCWAVE_SEL_MASK_DATA;
+    Xil_Out32(xTtcWaveSel, TTCWAVE_SEL_LOW);
+    XGpioPs_SetDirection(&xTtcWaveGpio, TTCWAVE_SEL_BANK,
+                         XGpioPs_GetDirection(&xTtcWaveGpio, TTCWAVE_SEL_BANK) | (1U << TTCWAVE_SEL_BIT));
+    XGpioPs_SetOutputEnable(&xTtcWaveGpio, TTCWAVE_SEL_BANK,
+                            XGpioPs_GetOutputEnable(&xTtcWaveGpio, TTCWAVE_SEL_BANK) | (1U << TTCWAVE_SEL_BIT));
+
+    cfg = XTtcPs_LookupConfig(RPU_CORE_TTCWAVE_TTC);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    Status = XTtcPs_CfgInitialize(&xTtcWave, cfg, cfg->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        // Left running by a previous firmware instance
+        XTtcPs_Stop(&xTtcWave);
+        Status = XTtcPs_CfgInitialize(&xTtcWave, cfg, cfg->BaseAddress);
+    }
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    // No interrupts: the counter only draws the wave
+    XTtcPs_DisableInterrupts(&xTtcWave, XTTCPS_IXR_ALL_MASK);
+    ulTtcWaveHz = cfg->InputClockHz;
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_TTC_WAVE */
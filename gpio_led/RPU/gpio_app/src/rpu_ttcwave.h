@@ -0,0 +1,84 @@
+/*
+ * SLOW and FAST blink on a TTC waveform output (build option RPU_TTC_WAVE=1,
+ * UserConfig.cmake; RPU0 firmware only).
+ *
+ * A TTC counter in interval and match mode toggles its waveform output
+ * twice per interval, at the match and at the interval end, without the CPU.
+ * With RPU_TTC_WAVE=1 the Tx task hands the periodic modes to the PC
+ * sampling counter (RPU_CORE_TTCWAVE_TTC, TTC0 counter 1, rpu_core.h): the
+ * interval is two frame periods and the match one, so the output is the
+ * square wave the alternating 0x1/0x2 frames draw, with edges exact to the
+ * TTC clock and no frame for the Rx task to write. The task still wakes once
+ * a period to follow mode changes, and only writes the interval and match
+ * registers when the period changes.
+ *
+ * The PL design (PL/ttc_wave_bd.tcl) routes emio_ttc0_wave_o[1] to LED 0,
+ * its inverse to LED 1, and switches the pins from the AXI GPIO to the wave
+ * while EMIO GPIO RPU_TTC_WAVE_SEL_PIN is high. Releasing the wave (another
+ * mode, a waveform play, a handoff) first writes the level it has to the AXI
+ * GPIO, then drops the select, so the pins never glitch and the next writer
+ * continues from the value on them.
+ */
+
+#ifndef RPU_TTCWAVE_H
+#define RPU_TTCWAVE_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "rpu_core.h"
+
+#ifndef RPU_TTC_WAVE
+#define RPU_TTC_WAVE 0
+#endif
+
+#ifndef RPU_TTC_WAVE_SEL_PIN
+#define RPU_TTC_WAVE_SEL_PIN    95      // EMIO GPIO 95 (bank 5, pin 31): the select
+#endif
+
+#if RPU_TTC_WAVE
+#if RPU_CORE != 0
+#error "RPU_TTC_WAVE is for the RPU0 firmware: the PL routes TTC0's output"
+#endif
+#if RPU_PC_PROF
+#error "RPU_TTC_WAVE takes the counter of the PC profiler (rpu_core.h)"
+#endif
+#if RPU_LED_PS_GPIO
+#error "RPU_TTC_WAVE switches the AXI GPIO LED pins, not the PS GPIO ones"
+#endif
+#if RPU_TTC_WAVE_SEL_PIN > 95
+#error "RPU_TTC_WAVE_SEL_PIN must be an EMIO GPIO, 0..95"
+#endif
+#if defined(RPU_BANK_EMIO_PINS) && RPU_BANK_EMIO_PINS > RPU_TTC_WAVE_SEL_PIN
+#error "The EMIO output banks would drive the RPU_TTC_WAVE_SEL_PIN select"
+#endif
+
+/* Set the counter and the select pin up, the pins on the AXI GPIO;
+ * gpio_data is its channel 1 data register */
+int xRpuTtcWaveInit(UINTPTR gpio_data);
+/* Drive the LEDs with a square wave of half_ms per half, starting with led
+ * (0x1 or 0x2) if it is not running with that period already; XST_SUCCESS
+ * while the counter drives the LEDs */
+int xRpuTtcWaveSet(u32 half_ms, u32 led);
+/* Hand the LEDs back to the AXI GPIO at the value on them; 1 with *led set
+ * if the wave was running */
+int xRpuTtcWaveRelease(u32 *led);
+#else
+static inline int xRpuTtcWaveInit(UINTPTR gpio_data)
+{
+    (void)gpio_data;
+    return XST_SUCCESS;
+}
+static inline int xRpuTtcWaveSet(u32 half_ms, u32 led)
+{
+    (void)half_ms;
+    (void)led;
+    return XST_NO_FEATURE;
+}
+static inline int xRpuTtcWaveRelease(u32 *led)
+{
+    (void)led;
+    return 0;
+}
+#endif /* RPU_TTC_WAVE */
+
+#endif /* RPU_TTCWAVE_H */
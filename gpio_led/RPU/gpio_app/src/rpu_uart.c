@@ -0,0 +1,241 @@
+/*
+ * Interrupt-driven console output (see rpu_uart.h).
+ *
+ * The ring holds the characters from ulUartTxTail to ulUartTxHead. While
+ * ulUartTxBusy is non-zero, the driver owns that many characters from the
+ * tail; XUARTPS_EVENT_SENT_DATA releases them and hands the driver the next
+ * contiguous run. Producers and the handler update the indices under the
+ * API-level critical section, so the handler (below the API mask) never
+ * sees a half-updated ring.
+ *
+ * The driver counts as in interrupt mode only with an RX interrupt enabled,
+ * so the RX trigger interrupt is on as well; input is read and discarded.
+ */
+
+#include "rpu_uart.h"
+
+#if RPU_UART_TX
+
+#include <string.h>
+
+#include "bspconfig.h"
+#include "xuartps.h"
+#include "xinterrupt_wrap.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexr5.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_tcm.h"
+
+#ifndef XPAR_STDIN_IS_UARTPS
+#error "RPU_UART_TX needs a PS UART as stdout"
+#endif
+
+#define RPU_UART_TX_MASK       (RPU_UART_TX_SIZE - 1)
+
+static XUartPs xUart RPU_BTCM_NOINIT;
+static u8 ucUartTxRing[ RPU_UART_TX_SIZE ] RPU_BTCM_NOINIT;
+static u32 ulUartTxHead RPU_BTCM_BSS;             /* Next free slot (producers) */
+static volatile u32 ulUartTxTail RPU_BTCM_BSS;    /* Oldest character not sent yet */
+static u32 ulUartTxBusy RPU_BTCM_BSS;             /* Characters handed to XUartPs_Send() */
+static volatile u32 ulUartTxDropped RPU_BTCM_BSS; /* Characters lost to a full ring */
+static u32 ulUartTxPriority RPU_BTCM_BSS;         /* GIC priority of the UART interrupt */
+static volatile u32 ulUartTxReady RPU_BTCM_BSS;
+
+void outbyte(char c);
+
+/*-----------------------------------------------------------*/
+/* Hand the next contiguous run of the ring to the driver (in the critical section) */
+static void prvUartTxStart(void)
+{
+    u32 tail = ulUartTxTail;
+    u32 run = RPU_UART_TX_SIZE - (tail & RPU_UART_TX_MASK);
+
+    if (run > ulUartTxHead - tail) {
+        run = ulUartTxHead - tail;
+    }
+    ulUartTxBusy = run;
+    (void)XUartPs_Send(&xUart, &ucUartTxRing[tail & RPU_UART_TX_MASK], run);
+}
+
+/*-----------------------------------------------------------*/
+/* Take the ring back from the driver and write it out polled (in the critical section) */
+static void prvUartTxDrainPolled(void)
+{
+    u32 tail = ulUartTxTail;
+
+    XUartPs_WriteReg(xUart.Config.BaseAddress, XUARTPS_IDR_OFFSET,
+                     XUARTPS_IXR_TXEMPTY | XUARTPS_IXR_TXFULL);
+    if (ulUartTxBusy != 0) {
+        // What the driver already put in the FIFO is sent
+        tail += xUart.SendBuffer.RequestedBytes - xUart.SendBuffer.RemainingBytes;
+        ulUartTxBusy = 0;
+    }
+    for (; tail != ulUartTxHead; tail++) {
+        XUartPs_SendByte(xUart.Config.BaseAddress, ucUartTxRing[tail & RPU_UART_TX_MASK]);
+    }
+    ulUartTxTail = tail;
+}
+
+/*-----------------------------------------------------------*/
+/* Driver callback (interrupt context) */
+static void prvUartTxHandler(void *CallBackRef, u32 Event, u32 EventData)
+{
+    UBaseType_t saved;
+
+    (void)CallBackRef;
+    if (Event == XUARTPS_EVENT_RECV_DATA) {
+        // No console input: the RX interrupt only selects interrupt mode
+        while (XUartPs_IsReceiveData(xUart.Config.BaseAddress)) {
+            (void)XUartPs_ReadReg(xUart.Config.BaseAddress, XUARTPS_FIFO_OFFSET);
+        }
+        return;
+    }
+    if (Event != XUARTPS_EVENT_SENT_DATA) {
+        return;
+    }
+
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    if (ulUartTxBusy != 0) {
+        ulUartTxTail += EventData;
+        ulUartTxBusy = 0;
+        if (ulUartTxHead != ulUartTxTail) {
+            prvUartTxStart();
+        }
+    }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/*-----------------------------------------------------------*/
+/* Replaces the polled outbyte() of the UART driver (xil_printf backend) */
+void outbyte(char c)
+{
+    UBaseType_t saved;
+    int masked;
+
+    if (!ulUartTxReady) {
+        XUartPs_SendByte(STDOUT_BASEADDRESS, (u8)c);
+        return;
+    }
+
+    // The drain interrupt cannot run if the caller masks it
+    masked = (mfcpsr() & XREG_CPSR_IRQ_ENABLE) != 0 ||
+             portICCPMR_PRIORITY_MASK_REGISTER <= ulUartTxPriority;
+
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    if (masked) {
+        prvUartTxDrainPolled();
+        XUartPs_SendByte(xUart.Config.BaseAddress, (u8)c);
+    } else if (ulUartTxHead - ulUartTxTail >= RPU_UART_TX_SIZE) {
+        ulUartTxDropped++;
+    } else {
+        ucUartTxRing[ulUartTxHead & RPU_UART_TX_MASK] = (u8)c;
+        ulUartTxHead++;
+        if (ulUartTxBusy == 0) {
+            prvUartTxStart();
+        }
+    }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/*-----------------------------------------------------------*/
+int xRpuUartTxWrite(const u8 *data, u32 len)
+{
+    UBaseType_t saved;
+    u32 head, first;
+    int Status = XST_SUCCESS;
+    int masked;
+
+    if (!ulUartTxReady) {
+        for (; len != 0; len--) {
+            XUartPs_SendByte(STDOUT_BASEADDRESS, *data++);
+        }
+        return XST_SUCCESS;
+    }
+
+    masked = (mfcpsr() & XREG_CPSR_IRQ_ENABLE) != 0 ||
+             portICCPMR_PRIORITY_MASK_REGISTER <= ulUartTxPriority;
+
+    saved = taskENTER_CRITICAL_FROM_ISR();
+    if (masked) {
+        prvUartTxDrainPolled();
+        for (; len != 0; len--) {
+            XUartPs_SendByte(xUart.Config.BaseAddress, *data++);
+        }
+    } else if (len > RPU_UART_TX_SIZE - (ulUartTxHead - ulUartTxTail)) {
+        Status = XST_FAILURE;
+    } else {
+        // At most two copies: up to the end of the ring, then from its start
+        head = ulUartTxHead & RPU_UART_TX_MASK;
+        first = RPU_UART_TX_SIZE - head;
+        if (first > len) {
+            first = len;
+        }
+        memcpy(&ucUartTxRing[head], data, first);
+        memcpy(ucUartTxRing, data + first, len - first);
+        ulUartTxHead += len;
+        if (ulUartTxBusy == 0 && len != 0) {
+            prvUartTxStart();
+        }
+    }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    return Status;
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuUartTxFree(void)
+{
+    return RPU_UART_TX_SIZE - (ulUartTxHead - ulUartTxTail);
+}
+
+/*-----------------------------------------------------------*/
+u32 ulRpuUartTxTakeDropped(void)
+{
+    return __atomic_exchange_n(&ulUartTxDropped, 0, __ATOMIC_RELAXED);
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuUartTxInit(u16 intr_priority)
+{
+    XUartPs_Config *cfg;
+    int Status;
+
+    cfg = XUartPs_LookupConfig(STDOUT_BASEADDRESS);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+
+    // CfgInitialize reprograms the baud rate: let the boot messages out first
+    XUartPs_WaitTransmitDone(STDOUT_BASEADDRESS);
+    Status = XUartPs_CfgInitialize(&xUart, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+#if RPU_UART_BAUD != 0
+    Status = XUartPs_SetBaudRate(&xUart, RPU_UART_BAUD);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+#endif
+    XUartPs_SetHandler(&xUart, prvUartTxHandler, NULL);
+    // XUartPs_Send() only arms the TX-empty interrupt if an RX interrupt is on
+    XUartPs_SetInterruptMask(&xUart, XUARTPS_IXR_RXOVR);
+
+    Status = XSetupInterruptSystem(&xUart, (Xil_ExceptionHandler)XUartPs_InterruptHandler,
+                                   cfg->IntrId, cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    ulUartTxHead = 0;
+    ulUartTxTail = 0;
+    ulUartTxBusy = 0;
+    ulUartTxDropped = 0;
+    ulUartTxPriority = intr_priority;
+    XEnableIntrId(cfg->IntrId, cfg->IntrParent);
+    __atomic_store_n(&ulUartTxReady, 1, __ATOMIC_RELEASE);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_UART_TX */
@@ -0,0 +1,71 @@
+/*
+ * Interrupt-driven console output (build option RPU_UART_TX=1,
+ * UserConfig.cmake; RPU0 firmware only).
+ *
+ * The BSP's outbyte() busy-waits on the UART FIFO for every character of
+ * xil_printf(). This backend replaces it: characters go into a TX ring and
+ * return at once, and the UART driver's interrupt mode (XUartPs_Send(), the
+ * TX-empty interrupt through XUartPs_InterruptHandler()) drains the ring in
+ * the background. Printing from a task then costs the formatting only.
+ *
+ * - Before xRpuUartTxInit(), and whenever the caller has the UART interrupt
+ *   masked (critical sections, the boot code before the scheduler starts,
+ *   fatal paths such as vApplicationAssert()), outbyte() first drains the
+ *   ring and then writes polled, so output keeps its order and is never
+ *   stranded in the ring
+ * - Not for handlers above the FreeRTOS API mask: the ring is protected by
+ *   the API-level critical section
+ * - A full ring drops characters and counts them; the RPU_LOG task waits
+ *   for room before each record instead (ulRpuUartTxFree()) and reports the
+ *   count (ulRpuUartTxTakeDropped())
+ *
+ * The UART (STDOUT_BASEADDRESS) must belong to the RPU: CfgInitialize takes
+ * it over, and its interrupt status is shared with any other driver of it.
+ *
+ * RPU_UART_BAUD=<bps> reprograms the line rate in xRpuUartTxInit(), e.g.
+ * 921600 for the binary telemetry (rpu_telem.h); the boot messages before
+ * it still go out at the BSP rate. 0 keeps the BSP rate.
+ * xRpuUartTxWrite() queues a block of bytes as a whole or not at all, so a
+ * binary frame never interleaves with another producer's output.
+ */
+
+#ifndef RPU_UART_H
+#define RPU_UART_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "rpu_core.h"
+
+#ifndef RPU_UART_TX
+#define RPU_UART_TX 0
+#endif
+
+#ifndef RPU_UART_BAUD
+#define RPU_UART_BAUD 0
+#endif
+
+#define RPU_UART_TX_SIZE       4096  /* Must be a power of two; ~350 ms at 115200 baud */
+#define RPU_UART_TX_LINE_MAX   128   /* Room the log task waits for per record */
+
+#if RPU_UART_TX
+#if RPU_CORE != 0
+#error "RPU_UART_TX is for the RPU0 firmware: both cores print to the same UART"
+#endif
+
+int xRpuUartTxInit(u16 intr_priority);
+u32 ulRpuUartTxFree(void);
+u32 ulRpuUartTxTakeDropped(void);
+/* XST_SUCCESS once all len bytes are queued, XST_FAILURE (nothing queued) if they do not fit */
+int xRpuUartTxWrite(const u8 *data, u32 len);
+#else
+static inline int xRpuUartTxInit(u16 intr_priority)
+{
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+// Polled output never runs out of room
+static inline u32 ulRpuUartTxFree(void) { return RPU_UART_TX_SIZE; }
+static inline u32 ulRpuUartTxTakeDropped(void) { return 0; }
+#endif /* RPU_UART_TX */
+
+#endif /* RPU_UART_H */
@@ -0,0 +1,313 @@
+/*
+ * TTC-driven GPIO waveform engine (see rpu_wave.h, rpu_shm.h).
+ *
+ * The counter runs in interval mode with the period of one sample. Its
+ * interrupt first writes the sample that is due, then clears the interrupt
+ * and prepares the next one, so the edge jitter is only the interrupt entry
+ * latency. Task code changes the playback state only while the counter is
+ * stopped and its interrupt disabled.
+ *
+ * A streamed table plays the same way from pulWavePlay, one TCM half at a
+ * time. At the end of a half the interrupt switches to the other one if its
+ * fetch has landed and starts the fetch of the chunk after it into the half
+ * just played; otherwise it plays a one-sample buffer holding the last
+ * sample and checks again every period. Loops are counted where the fetches
+ * wrap around the table, and the stream ends when a half comes up empty.
+ */
+
+#include <xil_io.h>
+#include "xttcps.h"
+#include "xinterrupt_wrap.h"
+#include "xstatus.h"
+
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+#include "rpu_trace.h"
+#include "rpu_wave.h"
+
+#define WAVE_STREAM_FIRST_US  1000  // Wait for the first chunk before the counter starts
+
+// Everything the sample interrupt touches is in TCM (rpu_tcm.h)
+static XTtcPs xWaveTtc RPU_BTCM_BSS;
+static UINTPTR ulGpioData RPU_BTCM_BSS;                        /* AXI GPIO data register */
+static u32 ulWaveSamples[SHM_WAVE_MAX_SAMPLES] RPU_BTCM_BSS;   /* Private copy of the table */
+static volatile u32 ulWaveCount RPU_BTCM_BSS;
+static volatile u32 ulWaveIndex RPU_BTCM_BSS;                  /* Next sample to write */
+static volatile u32 ulWaveLoopsLeft RPU_BTCM_BSS;              /* 0 = repeat until stopped */
+static volatile u32 ulWaveActive RPU_BTCM_BSS;
+static const u32 *pulWavePlay RPU_BTCM_BSS;                    /* Samples the interrupt plays */
+
+// Streaming (RPU_WAVE_START_STREAM): the DMA fills the halves, never the cache
+static u32 ulStreamBuf[2][RPU_WAVE_STREAM_CHUNK] RPU_BTCM_NOINIT __attribute__((aligned(64)));
+static volatile u32 ulWaveStream RPU_BTCM_BSS;                 /* Playing a streamed table */
+static UINTPTR ulStreamSrc RPU_BTCM_BSS;                       /* Table in the bulk carveout */
+static u32 ulStreamCount RPU_BTCM_BSS;
+static u32 ulStreamNext RPU_BTCM_BSS;                          /* Next sample to fetch */
+static u32 ulStreamHalf RPU_BTCM_BSS;                          /* Half playing, or played last */
+static u32 ulStreamFetchHalf RPU_BTCM_BSS;                     /* Half of the fetch in flight */
+static u32 ulStreamLen[2] RPU_BTCM_BSS;                        /* Samples of each half, 0 = end */
+static volatile u32 ulStreamFilled[2] RPU_BTCM_BSS;
+static volatile u32 ulStreamError RPU_BTCM_BSS;                /* A fetch failed */
+static u32 ulStreamHold RPU_BTCM_BSS;                          /* Last sample, while a chunk is late */
+static u32 ulStreamHolding RPU_BTCM_BSS;
+static u32 ulStreamUnderrun RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* Stop the counter and mark the engine idle; safe from the interrupt */
+RPU_ATCM_TEXT static void prvWaveHalt(void)
+{
+    XTtcPs_Stop(&xWaveTtc);
+    XTtcPs_DisableInterrupts(&xWaveTtc, XTTCPS_IXR_INTERVAL_MASK);
+    XTtcPs_ClearInterruptStatus(&xWaveTtc, XTtcPs_GetInterruptStatus(&xWaveTtc));
+    ulWaveActive = 0;
+    ulWaveStream = 0;
+    Xil_Out32(RPU_SHM_BASE + SHM_WAVE_STATE_OFFSET, RPU_WAVE_STATE_IDLE);
+}
+
+/*-----------------------------------------------------------*/
+/* Fetch the next chunk of the streamed table into half; an empty half once
+ * the last loop has been fetched */
+RPU_ATCM_TEXT static void prvStreamFetch(u32 half)
+{
+    u32 len;
+
+    ulStreamFilled[half] = 0;
+    if (ulStreamNext == ulStreamCount) {
+        if (ulWaveLoopsLeft != 0 && --ulWaveLoopsLeft == 0) {
+            ulStreamLen[half] = 0;
+            return;
+        }
+        ulStreamNext = 0;
+    }
+    len = ulStreamCount - ulStreamNext;
+    if (len > RPU_WAVE_STREAM_CHUNK) {
+        len = RPU_WAVE_STREAM_CHUNK;
+    }
+    ulStreamLen[half] = len;
+    ulStreamFetchHalf = half;
+    vRpuWaveDmaFetch(RPU_TCM_GLOBAL(ulStreamBuf[half]), ulStreamSrc + ulStreamNext * 4, len * 4);
+    ulStreamNext += len;
+}
+
+/*-----------------------------------------------------------*/
+/* End of a half, or of a held period: play the other half if it landed */
+RPU_ATCM_TEXT static void prvStreamNext(void)
+{
+    u32 next = ulStreamHalf ^ 1;
+
+    if (!ulStreamHolding) {
+        ulStreamHold = ulStreamBuf[ulStreamHalf][ulStreamLen[ulStreamHalf] - 1];
+    }
+    if (ulStreamError || ulStreamLen[next] == 0) {
+        prvWaveHalt();
+        vRpuTrace(RPU_TRACE_WAVE, 0, 0);
+        return;
+    }
+    if (!ulStreamFilled[next]) {
+        ulStreamHolding = 1;
+        pulWavePlay = &ulStreamHold;
+        ulWaveCount = 1;
+        Xil_Out32(RPU_SHM_BASE + SHM_WAVE_UNDERRUN_OFFSET, ++ulStreamUnderrun);
+        return;
+    }
+    ulStreamHolding = 0;
+    ulStreamHalf = next;
+    pulWavePlay = ulStreamBuf[next];
+    ulWaveCount = ulStreamLen[next];
+    prvStreamFetch(next ^ 1);
+}
+
+/*-----------------------------------------------------------*/
+/* Done interrupt of a fetch (rpu_wave_dma.c) */
+RPU_ATCM_TEXT void vRpuWaveStreamFetched(int ok)
+{
+    if (ok) {
+        ulStreamFilled[ulStreamFetchHalf] = 1;
+    } else {
+        ulStreamError = 1;
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Sample interrupt: output first, bookkeeping after */
+RPU_ATCM_TEXT static void prvWaveHandler(void *CallbackRef)
+{
+    (void)CallbackRef;
+
+    Xil_Out32(ulGpioData, pulWavePlay[ulWaveIndex]);
+
+    // Reading the status register clears it
+    (void)XTtcPs_GetInterruptStatus(&xWaveTtc);
+
+    if (++ulWaveIndex == ulWaveCount) {
+        ulWaveIndex = 0;
+        if (ulWaveStream) {
+            prvStreamNext();
+        } else if (ulWaveLoopsLeft != 0 && --ulWaveLoopsLeft == 0) {
+            prvWaveHalt();
+            vRpuTrace(RPU_TRACE_WAVE, 0, 0);
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Set up the TTC counter and connect its interrupt; the counter stays stopped */
+RPU_INIT_TEXT int xRpuWaveInit(UINTPTR gpio_data_addr, u16 intr_priority)
+{
+    XTtcPs_Config *cfg;
+    int Status;
+
+    ulGpioData = gpio_data_addr;
+
+    cfg = XTtcPs_LookupConfig(RPU_WAVE_TTC_BASEADDR);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+
+    Status = XTtcPs_CfgInitialize(&xWaveTtc, cfg, cfg->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        // Left running by a previous firmware instance
+        XTtcPs_Stop(&xWaveTtc);
+        Status = XTtcPs_CfgInitialize(&xWaveTtc, cfg, cfg->BaseAddress);
+    }
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    Status = XTtcPs_SetOptions(&xWaveTtc, XTTCPS_OPTION_INTERVAL_MODE | XTTCPS_OPTION_WAVE_DISABLE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    prvWaveHalt();
+
+    Status = XSetupInterruptSystem(&xWaveTtc, (Xil_ExceptionHandler)prvWaveHandler,
+                                   cfg->IntrId[0], cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId[0], cfg->IntrParent);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Load the table from shared memory and start playback
+ * - Returns an RPU_CMD_STATUS_* value for the ring descriptor
+ */
+u32 ulRpuWaveStart(void)
+{
+    u32 period_ns = Xil_In32(RPU_SHM_BASE + SHM_WAVE_PERIOD_OFFSET);
+    u32 count = Xil_In32(RPU_SHM_BASE + SHM_WAVE_COUNT_OFFSET);
+    u32 loops = Xil_In32(RPU_SHM_BASE + SHM_WAVE_LOOPS_OFFSET);
+    u64 ticks = ((u64)period_ns * xWaveTtc.Config.InputClockHz) / 1000000000ULL;
+    u32 i;
+
+    if (count == 0 || count > SHM_WAVE_MAX_SAMPLES ||
+        period_ns < RPU_WAVE_MIN_PERIOD_NS || ticks > XTTCPS_MAX_INTERVAL_COUNT) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+
+    vRpuWaveStop();
+
+    for (i = 0; i < count; i++) {
+        ulWaveSamples[i] = Xil_In32(RPU_SHM_BASE + SHM_WAVE_SAMPLE_OFFSET + i * 4);
+    }
+    pulWavePlay = ulWaveSamples;
+    ulWaveCount = count;
+    ulWaveIndex = 0;
+    ulWaveLoopsLeft = loops;
+    ulWaveActive = 1;
+    Xil_Out32(RPU_SHM_BASE + SHM_WAVE_STATE_OFFSET, RPU_WAVE_STATE_RUNNING);
+
+    // Interval mode counts 0..interval, i.e. interval + 1 clocks per sample
+    XTtcPs_SetInterval(&xWaveTtc, (XInterval)(ticks - 1));
+    XTtcPs_ResetCounterValue(&xWaveTtc);
+    XTtcPs_EnableInterrupts(&xWaveTtc, XTTCPS_IXR_INTERVAL_MASK);
+
+    // First sample now, the rest on the counter interrupt
+    Xil_Out32(ulGpioData, ulWaveSamples[0]);
+    ulWaveIndex = (count > 1) ? 1 : 0;
+    XTtcPs_Start(&xWaveTtc);
+
+    vRpuTrace(RPU_TRACE_WAVE, count, period_ns);
+    return RPU_CMD_STATUS_OK;
+}
+
+/*-----------------------------------------------------------*/
+/* Start playback of a table in the bulk carveout (SHM_WAVE_DDR_OFFSET)
+ * - The first chunk is in TCM before the counter starts, the second on its
+ *   way; the first sample goes out one period after the start
+ * - Returns an RPU_CMD_STATUS_* value for the ring descriptor
+ */
+u32 ulRpuWaveStreamStart(void)
+{
+    u32 period_ns = Xil_In32(RPU_SHM_BASE + SHM_WAVE_PERIOD_OFFSET);
+    u32 count = Xil_In32(RPU_SHM_BASE + SHM_WAVE_COUNT_OFFSET);
+    u32 loops = Xil_In32(RPU_SHM_BASE + SHM_WAVE_LOOPS_OFFSET);
+    u32 ddr_off = Xil_In32(RPU_SHM_BASE + SHM_WAVE_DDR_OFFSET);
+    u64 ticks = ((u64)period_ns * xWaveTtc.Config.InputClockHz) / 1000000000ULL;
+    u64 deadline;
+
+    if (count == 0 || count > RPU_WAVE_STREAM_MAX_SAMPLES || ddr_off % BULK_ALIGN != 0 ||
+        ddr_off > BULK_DDR_CORE_SIZE || count > (BULK_DDR_CORE_SIZE - ddr_off) / 4 ||
+        period_ns < RPU_WAVE_MIN_PERIOD_NS || ticks > XTTCPS_MAX_INTERVAL_COUNT) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+
+    vRpuWaveStop();
+    if (xRpuWaveDmaFetchSetup() != XST_SUCCESS) {
+        return RPU_CMD_STATUS_FAILED;
+    }
+
+    ulStreamSrc = RPU_BULK_DDR_BASE + ddr_off;
+    ulStreamCount = count;
+    ulStreamNext = 0;
+    ulStreamError = 0;
+    ulStreamHolding = 0;
+    ulStreamUnderrun = 0;
+    Xil_Out32(RPU_SHM_BASE + SHM_WAVE_UNDERRUN_OFFSET, 0);
+    ulWaveLoopsLeft = loops;
+
+    prvStreamFetch(0);
+    deadline = ullRpuTimeNow() + (u64)ulRpuTimeHz() * WAVE_STREAM_FIRST_US / 1000000U;
+    while (!ulStreamFilled[0]) {
+        if (ulStreamError || ullRpuTimeNow() > deadline) {
+            vRpuWaveDmaStop();
+            return RPU_CMD_STATUS_FAILED;
+        }
+    }
+    prvStreamFetch(1);
+
+    ulStreamHalf = 0;
+    pulWavePlay = ulStreamBuf[0];
+    ulWaveCount = ulStreamLen[0];
+    ulWaveIndex = 0;
+    ulWaveStream = 1;
+    ulWaveActive = 1;
+    Xil_Out32(RPU_SHM_BASE + SHM_WAVE_STATE_OFFSET, RPU_WAVE_STATE_STREAM);
+
+    XTtcPs_SetInterval(&xWaveTtc, (XInterval)(ticks - 1));
+    XTtcPs_ResetCounterValue(&xWaveTtc);
+    XTtcPs_EnableInterrupts(&xWaveTtc, XTTCPS_IXR_INTERVAL_MASK);
+    XTtcPs_Start(&xWaveTtc);
+
+    vRpuTrace(RPU_TRACE_WAVE, count, period_ns);
+    return RPU_CMD_STATUS_OK;
+}
+
+/*-----------------------------------------------------------*/
+/* Stop playback of either engine; the GPIO keeps the last sample written */
+void vRpuWaveStop(void)
+{
+    if (ulWaveActive) {
+        prvWaveHalt();
+        vRpuTrace(RPU_TRACE_WAVE, 0, 0);
+    }
+    vRpuWaveDmaStop();
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT int xRpuWaveActive(void)
+{
+    return ulWaveActive != 0 || xRpuWaveDmaActive();
+}
@@ -0,0 +1,58 @@
+/*
+ * TTC-driven GPIO waveform engine.
+ *
+ * vTaskDelay() limits blink timing to the FreeRTOS tick (10 ms at 100 Hz,
+ * plus tick jitter). The waveform engine instead runs a TTC counter in
+ * interval mode and writes one precomputed sample to the AXI GPIO data
+ * register from the counter interrupt, so edges sit on the 10 ns TTC clock
+ * grid and sample rates reach 1000000000 / RPU_WAVE_MIN_PERIOD_NS Hz.
+ *
+ * - The APU uploads a table into the waveform area of the shared window
+ *   (rpu_shm.h) and starts it with an RPU_CMD_WAVE ring command
+ * - The table is copied into RPU memory on start, so the APU can prepare the
+ *   next table while the current one plays
+ * - The interrupt runs above configMAX_API_CALL_INTERRUPT_PRIORITY so FreeRTOS
+ *   critical sections do not delay edges; it must not call the FreeRTOS API
+ * - While a waveform plays the Rx task leaves the GPIO alone
+ *
+ * DMA playback (rpu_wave_dma.c) plays the same tables from an LPD DMA
+ * channel instead, for periods from RPU_WAVE_DMA_MIN_PERIOD_NS up, without
+ * any CPU work per sample. Only one engine plays at a time; starting one
+ * stops the other.
+ *
+ * Streaming (RPU_WAVE_START_STREAM) plays a table of up to
+ * RPU_WAVE_STREAM_MAX_SAMPLES from the bulk carveout with the timer engine:
+ * the interrupt reads a TCM ping-pong buffer while the waveform DMA channel,
+ * idle as DMA playback is not running, fetches the next chunk from DDR into
+ * the half just played. A chunk lasts RPU_WAVE_STREAM_CHUNK periods, at least
+ * 2.5 ms, against a few microseconds to fetch it.
+ */
+
+#ifndef RPU_WAVE_H
+#define RPU_WAVE_H
+
+#include "xil_types.h"
+#include "xparameters.h"
+#include "rpu_core.h"
+
+// TTC1 counter 0 on RPU0; TTC0 counter 0 is the FreeRTOS tick source (bsp.yaml)
+#define RPU_WAVE_TTC_BASEADDR  RPU_CORE_WAVE_TTC
+
+int xRpuWaveInit(UINTPTR gpio_data_addr, u16 intr_priority);
+u32 ulRpuWaveStart(void);
+u32 ulRpuWaveStreamStart(void);
+void vRpuWaveStop(void);      /* Stops either engine */
+int xRpuWaveActive(void);     /* Either engine owns the GPIO */
+
+int xRpuWaveDmaInit(UINTPTR gpio_data_addr, u16 intr_priority);
+u32 ulRpuWaveDmaStart(void);
+void vRpuWaveDmaStop(void);
+int xRpuWaveDmaActive(void);
+
+/* Streaming fetches on the waveform DMA channel (rpu_wave_dma.c), and their
+ * completion back to the timer engine from the DMA interrupt (rpu_wave.c) */
+int xRpuWaveDmaFetchSetup(void);
+void vRpuWaveDmaFetch(UINTPTR dst, UINTPTR src, u32 size);
+void vRpuWaveStreamFetched(int ok);
+
+#endif /* RPU_WAVE_H */
@@ -0,0 +1,320 @@
+/*
+ * DMA-fed GPIO pattern playback (see rpu_wave.h, rpu_shm.h).
+ *
+ * The waveform table is expanded into a word pattern in RPU memory and an
+ * LPD DMA (ADMA) channel streams it into the AXI GPIO data register through
+ * a linked-list descriptor chain, one descriptor per table sample. The AXI
+ * GPIO has no DMA request line and ZDMA cannot be triggered by a timer, so
+ * the channel's rate control paces the output instead: it spaces source
+ * read transactions RATE_CNTL DMA clocks apart, and with single-beat bursts
+ * and one outstanding read every GPIO write follows one read. Sample periods
+ * longer than the largest rate interval repeat each sample in the pattern.
+ *
+ * The CPU only runs at the end of a pass (done interrupt) to restart the
+ * chain for the next loop.
+ *
+ * A streamed table (rpu_wave.c) borrows the idle channel instead: in simple
+ * mode with plain incrementing bursts and no rate control it copies one
+ * chunk at a time from the bulk carveout into TCM, and its done interrupt
+ * hands the chunk to the timer engine. DMA playback sets the channel back
+ * up for itself at every start.
+ */
+
+#include <xil_io.h>
+#include "xil_cache.h"
+#include "xzdma.h"
+#include "xzdma_hw.h"
+#include "xinterrupt_wrap.h"
+#include "xstatus.h"
+
+#include "rpu_tcm.h"
+#include "rpu_trace.h"
+#include "rpu_wave.h"
+
+// LPD DMA (ADMA) channel of this core (rpu_core.h): on the same switch as the
+// RPU and M_AXI_HPM0_LPD
+#define WAVE_DMA_BASEADDR       RPU_CORE_WAVE_DMA
+// LPD_DMA_REF clock of the PS configuration; not exported to xparameters.h
+#define WAVE_DMA_CLOCK_HZ       500000000ULL
+#define WAVE_DMA_MAX_INTERVAL   0xFFFU  // RATE_CNTL is 12 bits wide
+#define WAVE_DMA_PATTERN_WORDS  4096    // Expanded pattern (16 KB)
+#define WAVE_DMA_DONE_INTR      (XZDMA_IXR_DMA_DONE_MASK | XZDMA_IXR_ERR_MASK)
+#define WAVE_DMA_FETCH_BURST    16      // Longest ADMA burst, as the bulk channel
+#define WAVE_DMA_FETCH_ISSUE    16      // Outstanding source reads
+
+static XZDma xWaveDma;
+static UINTPTR ulGpioData;
+static u32 ulDmaPattern[WAVE_DMA_PATTERN_WORDS] __attribute__((aligned(64)));
+// Linked-list mode needs one source and one destination descriptor per transfer
+static XZDma_LlDscr xDmaDscr[2 * SHM_WAVE_MAX_SAMPLES] __attribute__((aligned(64)));
+static XZDma_Transfer xDmaXfer[SHM_WAVE_MAX_SAMPLES];
+static volatile u32 ulDmaXferCount;
+static volatile u32 ulDmaInterval;
+static volatile u32 ulDmaLoopsLeft;  /* 0 = repeat until stopped */
+static volatile u32 ulDmaActive RPU_BTCM_BSS;
+static volatile u32 ulDmaFetching RPU_BTCM_BSS;  /* A streaming fetch is in flight */
+static XZDma_Transfer xDmaFetch RPU_BTCM_BSS;
+
+/*-----------------------------------------------------------*/
+/* Program rate control and start one pass over the descriptor chain */
+static void prvDmaStartPass(void)
+{
+    XZDma_WriteReg(WAVE_DMA_BASEADDR, XZDMA_CH_RATE_CNTL_OFFSET, ulDmaInterval);
+    XZDma_WriteReg(WAVE_DMA_BASEADDR, XZDMA_CH_CTRL0_OFFSET,
+                   XZDma_ReadReg(WAVE_DMA_BASEADDR, XZDMA_CH_CTRL0_OFFSET) |
+                   XZDMA_CTRL0_RATE_CNTL_MASK);
+    XZDma_EnableIntr(&xWaveDma, WAVE_DMA_DONE_INTR);
+    (void)XZDma_Start(&xWaveDma, xDmaXfer, ulDmaXferCount);
+}
+
+/*-----------------------------------------------------------*/
+/* Abort whatever the channel runs */
+static void prvDmaAbort(void)
+{
+    XZDma_DisableIntr(&xWaveDma, XZDMA_IXR_ALL_INTR_MASK);
+    XZDma_DisableCh(&xWaveDma);
+    XZDma_IntrClear(&xWaveDma, XZDMA_IXR_ALL_INTR_MASK);
+    xWaveDma.ChannelState = XZDMA_IDLE;
+}
+
+/*-----------------------------------------------------------*/
+/* Abort the channel and mark the engine idle */
+static void prvDmaHalt(void)
+{
+    prvDmaAbort();
+    ulDmaActive = 0;
+    Xil_Out32(RPU_SHM_BASE + SHM_WAVE_STATE_OFFSET, RPU_WAVE_STATE_IDLE);
+}
+
+/*-----------------------------------------------------------*/
+/* End of a pass (interrupt context): next loop or done */
+static void prvDmaDone(void *CallBackRef)
+{
+    (void)CallBackRef;
+
+    if (ulDmaFetching) {
+        ulDmaFetching = 0;
+        vRpuWaveStreamFetched(1);
+        return;
+    }
+    if (!ulDmaActive) {
+        return;
+    }
+    if (ulDmaLoopsLeft == 0 || --ulDmaLoopsLeft != 0) {
+        prvDmaStartPass();
+        return;
+    }
+    ulDmaActive = 0;
+    Xil_Out32(RPU_SHM_BASE + SHM_WAVE_STATE_OFFSET, RPU_WAVE_STATE_IDLE);
+    vRpuTrace(RPU_TRACE_WAVE, 0, 0);
+}
+
+/*-----------------------------------------------------------*/
+/* AXI error: stop rather than replay a broken chain */
+static void prvDmaError(void *CallBackRef, u32 ErrorMask)
+{
+    (void)CallBackRef;
+
+    if (ulDmaFetching) {
+        ulDmaFetching = 0;
+        prvDmaAbort();
+        vRpuWaveStreamFetched(0);
+        vRpuTrace(RPU_TRACE_WAVE, 0, ErrorMask);
+        return;
+    }
+    if (ulDmaActive) {
+        prvDmaHalt();
+        vRpuTrace(RPU_TRACE_WAVE, 0, ErrorMask);
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Linked-list mode, paced single-beat writes to the GPIO (channel idle) */
+static int prvDmaPlaySetup(void)
+{
+    XZDma_DataConfig data = { 0 };
+    int Status;
+
+    // The descriptor list of xRpuWaveDmaInit() is kept across mode changes
+    Status = XZDma_SetMode(&xWaveDma, TRUE, XZDMA_NORMAL_MODE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    // One outstanding single-beat read per GPIO write keeps the rate exact;
+    // the destination address stays on the GPIO data register
+    data.OverFetch = 0;
+    data.SrcIssue = 1;
+    data.SrcBurstType = XZDMA_INCR_BURST;
+    data.SrcBurstLen = 1;
+    data.DstBurstType = XZDMA_FIXED_BURST;
+    data.DstBurstLen = 1;
+    return XZDma_SetChDataConfig(&xWaveDma, &data);
+}
+
+/*-----------------------------------------------------------*/
+/* Set up the DMA channel in linked-list mode and connect its interrupt */
+RPU_INIT_TEXT int xRpuWaveDmaInit(UINTPTR gpio_data_addr, u16 intr_priority)
+{
+    XZDma_Config *cfg;
+    XZDma_DscrConfig dscr = { 0 };
+    int Status;
+
+    ulGpioData = gpio_data_addr;
+
+    cfg = XZDma_LookupConfig(WAVE_DMA_BASEADDR);
+    if (cfg == NULL) {
+        return XST_FAILURE;
+    }
+    Status = XZDma_CfgInitialize(&xWaveDma, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    Status = XZDma_SetMode(&xWaveDma, TRUE, XZDMA_NORMAL_MODE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    if (XZDma_CreateBDList(&xWaveDma, XZDMA_LINKEDLIST, (UINTPTR)xDmaDscr,
+                           sizeof(xDmaDscr)) < SHM_WAVE_MAX_SAMPLES) {
+        return XST_FAILURE;
+    }
+    Status = prvDmaPlaySetup();
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    Status = XZDma_SetChDscrConfig(&xWaveDma, &dscr);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+
+    XZDma_SetCallBack(&xWaveDma, XZDMA_HANDLER_DONE, (void *)prvDmaDone, NULL);
+    XZDma_SetCallBack(&xWaveDma, XZDMA_HANDLER_ERROR, (void *)prvDmaError, NULL);
+
+    Status = XSetupInterruptSystem(&xWaveDma, (Xil_ExceptionHandler)XZDma_IntrHandler,
+                                   cfg->IntrId, cfg->IntrParent, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(cfg->IntrId, cfg->IntrParent);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Load the table from shared memory and start DMA playback
+ * - Returns an RPU_CMD_STATUS_* value for the ring descriptor
+ */
+u32 ulRpuWaveDmaStart(void)
+{
+    u32 period_ns = Xil_In32(RPU_SHM_BASE + SHM_WAVE_PERIOD_OFFSET);
+    u32 count = Xil_In32(RPU_SHM_BASE + SHM_WAVE_COUNT_OFFSET);
+    u32 loops = Xil_In32(RPU_SHM_BASE + SHM_WAVE_LOOPS_OFFSET);
+    u64 cycles = ((u64)period_ns * WAVE_DMA_CLOCK_HZ) / 1000000000ULL;
+    u32 repeat, i, j;
+
+    if (count == 0 || count > SHM_WAVE_MAX_SAMPLES || period_ns < RPU_WAVE_DMA_MIN_PERIOD_NS) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+
+    // Split long periods into equal rate intervals, one pattern word each
+    repeat = (u32)((cycles + WAVE_DMA_MAX_INTERVAL - 1) / WAVE_DMA_MAX_INTERVAL);
+    if ((u64)repeat * count > WAVE_DMA_PATTERN_WORDS) {
+        return RPU_CMD_STATUS_BADARG;
+    }
+
+    vRpuWaveStop();
+    if (prvDmaPlaySetup() != XST_SUCCESS) {
+        return RPU_CMD_STATUS_FAILED;
+    }
+
+    for (i = 0; i < count; i++) {
+        u32 sample = Xil_In32(RPU_SHM_BASE + SHM_WAVE_SAMPLE_OFFSET + i * 4);
+        for (j = 0; j < repeat; j++) {
+            ulDmaPattern[i * repeat + j] = sample;
+        }
+        xDmaXfer[i].SrcAddr = (UINTPTR)&ulDmaPattern[i * repeat];
+        xDmaXfer[i].DstAddr = ulGpioData;
+        xDmaXfer[i].Size = repeat * sizeof(u32);
+        xDmaXfer[i].SrcCoherent = 0;
+        xDmaXfer[i].DstCoherent = 0;
+        xDmaXfer[i].Pause = 0;
+    }
+    // The DMA reads memory, not the R5 data cache. The pattern is line
+    // aligned and a whole number of lines long, so the rounded-up range
+    // needs none of the edge handling of Xil_DCacheFlushRange()
+    Xil_DCacheFlushAlignedRange((INTPTR)ulDmaPattern,
+                                (count * repeat * sizeof(u32) + XIL_CACHE_LINE_SIZE - 1) &
+                                ~(XIL_CACHE_LINE_SIZE - 1));
+
+    ulDmaXferCount = count;
+    ulDmaInterval = (u32)(cycles / repeat);
+    ulDmaLoopsLeft = loops;
+    ulDmaActive = 1;
+    Xil_Out32(RPU_SHM_BASE + SHM_WAVE_STATE_OFFSET, RPU_WAVE_STATE_DMA);
+
+    prvDmaStartPass();
+
+    vRpuTrace(RPU_TRACE_WAVE, count, period_ns);
+    return RPU_CMD_STATUS_OK;
+}
+
+/*-----------------------------------------------------------*/
+/* Stop DMA playback or a streaming fetch; the GPIO keeps the last word written */
+void vRpuWaveDmaStop(void)
+{
+    if (ulDmaActive) {
+        prvDmaHalt();
+        vRpuTrace(RPU_TRACE_WAVE, 0, 0);
+    }
+    if (ulDmaFetching) {
+        ulDmaFetching = 0;
+        prvDmaAbort();
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Simple mode, plain copies at full rate (channel idle, task context) */
+int xRpuWaveDmaFetchSetup(void)
+{
+    XZDma_DataConfig data = { 0 };
+    int Status;
+
+    Status = XZDma_SetMode(&xWaveDma, FALSE, XZDMA_NORMAL_MODE);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XZDma_WriteReg(WAVE_DMA_BASEADDR, XZDMA_CH_CTRL0_OFFSET,
+                   XZDma_ReadReg(WAVE_DMA_BASEADDR, XZDMA_CH_CTRL0_OFFSET) &
+                   ~XZDMA_CTRL0_RATE_CNTL_MASK);
+
+    data.OverFetch = 0;
+    data.SrcIssue = WAVE_DMA_FETCH_ISSUE;
+    data.SrcBurstType = XZDMA_INCR_BURST;
+    data.SrcBurstLen = WAVE_DMA_FETCH_BURST;
+    data.DstBurstType = XZDMA_INCR_BURST;
+    data.DstBurstLen = WAVE_DMA_FETCH_BURST;
+    return XZDma_SetChDataConfig(&xWaveDma, &data);
+}
+
+/*-----------------------------------------------------------*/
+/* Copy size bytes from src to dst (bus addresses); the done interrupt calls
+ * vRpuWaveStreamFetched(). From the sample interrupt, or from the task that
+ * starts the stream before the counter runs; the channel is idle either way
+ */
+RPU_ATCM_TEXT void vRpuWaveDmaFetch(UINTPTR dst, UINTPTR src, u32 size)
+{
+    xDmaFetch.SrcAddr = src;
+    xDmaFetch.DstAddr = dst;
+    xDmaFetch.Size = size;
+    xDmaFetch.SrcCoherent = 0;
+    xDmaFetch.DstCoherent = 0;
+    xDmaFetch.Pause = 0;
+    ulDmaFetching = 1;
+    XZDma_EnableIntr(&xWaveDma, WAVE_DMA_DONE_INTR);
+    (void)XZDma_Start(&xWaveDma, &xDmaFetch, 1);
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT int xRpuWaveDmaActive(void)
+{
+    return ulDmaActive != 0;
+}
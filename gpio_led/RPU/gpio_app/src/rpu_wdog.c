@@ -0,0 +1,235 @@
+/*
+ * Deadline supervision with the LPD watchdog (see rpu_wdog.h, rpu_shm.h).
+ *
+ * Reports and the window check update the same per-task state inside
+ * critical sections; the doorbell arm runs in the IPI handler, which they
+ * mask. The published entries are copies taken at the end of a window.
+ */
+
+#include "rpu_wdog.h"
+
+#if RPU_WATCHDOG
+
+#include <xil_io.h>
+#include "xil_mpu.h"
+#include "xwdtps.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "rpu_log.h"
+#include "rpu_seqlock.h"
+#include "rpu_shm.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+
+#define WDOG_TASKS             3
+#define WDOG_PRESCALE          4096
+// One counter reset value step is 4096 counts of the prescaled clock
+#define WDOG_CRV               (RPU_WDOG_TIMEOUT_MS * (XPAR_XWDTPS_1_WDT_CLK_FREQ_HZ / 1000ULL) / \
+                                (4096ULL * WDOG_PRESCALE) - 1)
+
+#if WDOG_CRV < 1 || WDOG_CRV > 0xFFF
+#error "RPU_WDOG_TIMEOUT_MS is out of the watchdog range"
+#endif
+
+typedef struct {
+    struct rpu_wdog_task pub;   /* Free-running counters */
+    u32 window_missed;          /* A deadline missed in this window */
+    TickType_t last;            /* Tick of the last report */
+    u32 reported;               /* A report since the start */
+    u32 armed;                  /* Work pending since armed_at */
+    u64 armed_at;
+} WdogTask_t;
+
+static XWdtPs xWdt;
+static WdogTask_t xWdogTask[WDOG_TASKS] RPU_BTCM_BSS;
+static u32 ulWdogWindows;
+static u32 ulWdogKicks;
+static u32 ulWdogFailed;
+static u32 ulWdogLastFail;
+static u32 ulWdogSeq;
+static TimerHandle_t xWdogTimer;
+static StaticTimer_t xWdogTimerBuffer RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* Count one deadline of task, late_us after it was due */
+static void prvWdogCount(WdogTask_t *t, u32 late_us, int missed)
+{
+    if (missed) {
+        t->pub.missed++;
+        t->window_missed = 1;
+    } else {
+        t->pub.met++;
+    }
+    if (late_us > t->pub.worst_us) {
+        t->pub.worst_us = late_us;
+    }
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuWdogTicks(u32 task, TickType_t deadline)
+{
+    WdogTask_t *t = &xWdogTask[task];
+    TickType_t now = xTaskGetTickCount();
+    TickType_t late = (TickType_t)(now - deadline);
+
+    // Work done ahead of its tick (a burst frame written early) is on time
+    if (late > portMAX_DELAY / 2) {
+        late = 0;
+    }
+
+    taskENTER_CRITICAL();
+    prvWdogCount(t, (u32)(late * (1000000U / configTICK_RATE_HZ)), late > RPU_WDOG_SLACK_TICKS);
+    t->last = now;
+    t->reported = 1;
+    taskEXIT_CRITICAL();
+}
+
+/*-----------------------------------------------------------*/
+RPU_ATCM_TEXT void vRpuWdogArmFromIsr(u32 task)
+{
+    WdogTask_t *t = &xWdogTask[task];
+
+    if (!t->armed) {
+        t->armed_at = ullRpuTimeNow();
+        t->armed = 1;
+    }
+}
+
+/*-----------------------------------------------------------*/
+void vRpuWdogServed(u32 task)
+{
+    WdogTask_t *t = &xWdogTask[task];
+    u64 elapsed_us;
+
+    taskENTER_CRITICAL();
+    if (t->armed) {
+        t->armed = 0;
+        elapsed_us = ullRpuTimeToNs(ullRpuTimeNow() - t->armed_at) / 1000;
+        prvWdogCount(t, elapsed_us > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (u32)elapsed_us,
+                     elapsed_us > RPU_WDOG_CMD_US);
+    }
+    taskEXIT_CRITICAL();
+}
+
+/*-----------------------------------------------------------*/
+/* Timer callback: close the window, restart the watchdog if it passed */
+static void prvWdogWindow(TimerHandle_t xTimer)
+{
+    struct rpu_wdog_task pub[WDOG_TASKS];
+    TickType_t now = xTaskGetTickCount();
+    u64 counter = ullRpuTimeNow();
+    u32 fail = 0;
+    u32 i;
+
+    (void)xTimer;
+    taskENTER_CRITICAL();
+    for (i = 0; i < WDOG_TASKS; i++) {
+        WdogTask_t *t = &xWdogTask[i];
+        int stalled = 0;
+
+        if (i == WDOG_TASK_CMD) {
+            stalled = t->armed &&
+                      ullRpuTimeToNs(counter - t->armed_at) / 1000 > RPU_WDOG_CMD_US;
+        } else {
+            stalled = t->reported &&
+                      (TickType_t)(now - t->last) > pdMS_TO_TICKS(RPU_WDOG_SILENT_MS);
+        }
+        if (stalled) {
+            t->pub.stalls++;
+        }
+        if (stalled || t->window_missed) {
+            fail |= 1U << i;
+        }
+        t->window_missed = 0;
+        pub[i] = t->pub;
+    }
+    taskEXIT_CRITICAL();
+
+    ulWdogWindows++;
+    if (fail == 0) {
+        XWdtPs_RestartWdt(&xWdt);
+        ulWdogKicks++;
+    } else {
+        // Logged on a change only: a sustained overload must not flood the log
+        if (fail != ulWdogLastFail || ulWdogFailed == 0) {
+            RPU_LOG("Watchdog: window %u failed (tasks 0x%x), not restarted\r\n",
+                    (unsigned)ulWdogWindows, (unsigned)fail);
+        }
+        ulWdogFailed++;
+        ulWdogLastFail = fail;
+    }
+
+    vRpuSeqBegin(WDOG_ADDR + WDOG_SEQ_OFFSET, &ulWdogSeq);
+    Xil_Out32(WDOG_ADDR + WDOG_WINDOWS_OFFSET, ulWdogWindows);
+    Xil_Out32(WDOG_ADDR + WDOG_KICKS_OFFSET, ulWdogKicks);
+    Xil_Out32(WDOG_ADDR + WDOG_FAILED_OFFSET, ulWdogFailed);
+    Xil_Out32(WDOG_ADDR + WDOG_LAST_FAIL_OFFSET, ulWdogLastFail);
+    for (i = 0; i < WDOG_TASKS; i++) {
+        UINTPTR e = WDOG_ADDR + WDOG_TASK(i);
+
+        Xil_Out32(e + 0x0, pub[i].met);
+        Xil_Out32(e + 0x4, pub[i].missed);
+        Xil_Out32(e + 0x8, pub[i].stalls);
+        Xil_Out32(e + 0xC, pub[i].worst_us);
+    }
+    vRpuSeqEnd(WDOG_ADDR + WDOG_SEQ_OFFSET, &ulWdogSeq);
+}
+
+/*-----------------------------------------------------------*/
+/* Announce the block, start the watchdog and the supervision windows */
+RPU_INIT_TEXT int xRpuWdogInit(void)
+{
+    XWdtPs_Config *cfg;
+    int Status;
+    u32 i;
+
+    Xil_SetTlbAttributes(WDOG_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_Out32(WDOG_ADDR + WDOG_MAGIC_OFFSET, 0);
+
+    cfg = XWdtPs_LookupConfig(XPAR_XWDTPS_1_BASEADDR);
+    if (cfg == NULL) {
+        return XST_DEVICE_NOT_FOUND;
+    }
+    Status = XWdtPs_CfgInitialize(&xWdt, cfg, cfg->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XWdtPs_Stop(&xWdt);
+    XWdtPs_SetControlValue(&xWdt, XWDTPS_CLK_PRESCALE, XWDTPS_CCR_PSCALE_4096);
+    XWdtPs_SetControlValue(&xWdt, XWDTPS_COUNTER_RESET, (u32)WDOG_CRV);
+    XWdtPs_DisableOutput(&xWdt, XWDTPS_IRQ_SIGNAL);
+    XWdtPs_EnableOutput(&xWdt, XWDTPS_RESET_SIGNAL);
+
+    ulWdogSeq = ulRpuSeqInit(WDOG_ADDR + WDOG_SEQ_OFFSET);
+    Xil_Out32(WDOG_ADDR + WDOG_WINDOW_MS_OFFSET, RPU_WDOG_WINDOW_MS);
+    Xil_Out32(WDOG_ADDR + WDOG_TIMEOUT_MS_OFFSET,
+              (u32)((WDOG_CRV + 1) * 4096 * WDOG_PRESCALE * 1000 / XPAR_XWDTPS_1_WDT_CLK_FREQ_HZ));
+    Xil_Out32(WDOG_ADDR + WDOG_WINDOWS_OFFSET, 0);
+    Xil_Out32(WDOG_ADDR + WDOG_KICKS_OFFSET, 0);
+    Xil_Out32(WDOG_ADDR + WDOG_FAILED_OFFSET, 0);
+    Xil_Out32(WDOG_ADDR + WDOG_LAST_FAIL_OFFSET, 0);
+    Xil_Out32(WDOG_ADDR + WDOG_COUNT_OFFSET, WDOG_TASKS);
+    for (i = 0; i < WDOG_TASKS * WDOG_TASK_SIZE; i += 4) {
+        Xil_Out32(WDOG_ADDR + WDOG_TASK_OFFSET + i, 0);
+    }
+    __sync_synchronize();
+    Xil_Out32(WDOG_ADDR + WDOG_MAGIC_OFFSET, WDOG_MAGIC);
+
+    xWdogTimer = xTimerCreateStatic((const char *)"Wdog",
+                                    pdMS_TO_TICKS(RPU_WDOG_WINDOW_MS),
+                                    pdTRUE,
+                                    NULL,
+                                    prvWdogWindow,
+                                    &xWdogTimerBuffer);
+    configASSERT(xWdogTimer);
+    xTimerStart(xWdogTimer, 0);
+
+    // Runs from here: the scheduler start is within the first timeout
+    XWdtPs_Start(&xWdt);
+    XWdtPs_RestartWdt(&xWdt);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_WATCHDOG */
@@ -0,0 +1,93 @@
+/*
+ * Deadline supervision with the LPD watchdog (build option RPU_WATCHDOG=1,
+ * UserConfig.cmake; RPU0 firmware only).
+ *
+ * The supervised tasks (WDOG_TASK_*, rpu_shm.h) report their deadlines:
+ *
+ *   prvTxTask    vRpuWdogTicks()       each frame, against its tick deadline
+ *   prvLedWrite  vRpuWdogTicks()       each LED write, against the same
+ *   IPI_Handler  vRpuWdogArmFromIsr()  a doorbell that wakes the IPI task
+ *   prvIpiTask   vRpuWdogServed()      end of each pass
+ *
+ * A tick deadline is missed when the work ran more than
+ * RPU_WDOG_SLACK_TICKS after its tick; a command when the pass ended more
+ * than RPU_WDOG_CMD_US after the doorbell. A software timer closes a
+ * supervision window every RPU_WDOG_WINDOW_MS and restarts the watchdog
+ * (XWdtPs, the LPD SWDT) only if no task missed a deadline in it, neither
+ * periodic task (Tx, Rx) was silent for RPU_WDOG_SILENT_MS and no command
+ * stayed armed past its deadline: sustained overload, not only a hang,
+ * stops the restarts. The watchdog expires RPU_WDOG_TIMEOUT_MS after the
+ * last restart, so a few failed windows in a row are needed; its reset
+ * output goes to the PMU error manager, which takes the action configured
+ * for the LPD SWDT error (an RPU or system reset).
+ *
+ * The counters go into the WDOG block in OCM every window; apu_app/rpu_stats
+ * --wdog prints them. The Linux cdns-wdt driver must not own the LPD
+ * watchdog (disable its device tree node) on a board running this option.
+ */
+
+#ifndef RPU_WDOG_H
+#define RPU_WDOG_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_WATCHDOG
+#define RPU_WATCHDOG 0
+#endif
+
+#define RPU_WDOG_WINDOW_MS      500
+#ifndef RPU_WDOG_TIMEOUT_MS
+#define RPU_WDOG_TIMEOUT_MS     2000
+#endif
+#ifndef RPU_WDOG_SLACK_TICKS
+#define RPU_WDOG_SLACK_TICKS    1
+#endif
+#ifndef RPU_WDOG_CMD_US
+#define RPU_WDOG_CMD_US         10000
+#endif
+/* Longest gap between two reports of Tx or Rx (SLOW blink: 1 s) */
+#define RPU_WDOG_SILENT_MS      2500
+
+#if RPU_WATCHDOG
+#if RPU_CORE != 0
+#error "RPU_WATCHDOG is for the RPU0 firmware: there is one LPD watchdog"
+#endif
+#if RPU_WDOG_TIMEOUT_MS < 2 * RPU_WDOG_WINDOW_MS
+#error "RPU_WDOG_TIMEOUT_MS must cover at least two supervision windows"
+#endif
+
+/* Start the watchdog and the supervision windows */
+int xRpuWdogInit(void);
+/* Task task did the work due at tick deadline */
+void vRpuWdogTicks(u32 task, TickType_t deadline);
+/* Work for task arrived; the first arrival of a pass counts */
+void vRpuWdogArmFromIsr(u32 task);
+/* The work armed for task is done */
+void vRpuWdogServed(u32 task);
+#else
+static inline int xRpuWdogInit(void)
+{
+    return XST_SUCCESS;
+}
+
+static inline void vRpuWdogTicks(u32 task, TickType_t deadline)
+{
+    (void)task;
+    (void)deadline;
+}
+
+static inline void vRpuWdogArmFromIsr(u32 task)
+{
+    (void)task;
+}
+
+static inline void vRpuWdogServed(u32 task)
+{
+    (void)task;
+}
+#endif /* RPU_WATCHDOG */
+
+#endif /* RPU_WDOG_H */
@@ -0,0 +1,253 @@
+/*
+ * Inter-R5 messages (see rpu_xcore.h).
+ *
+ * The inbox is consumed only by the XCore task and filled only by the other
+ * core, whose senders take a critical section of their own around the push
+ * and the commit, so both ends of the ring keep a single owner. The task
+ * arms the event index before it sleeps, and the sender raises the SGI only
+ * for the commit that crosses it; the SGI handler just notifies the task.
+ *
+ * Both cores see the same system counter, so the stamp of a message is also
+ * its one-way latency at the receiver.
+ */
+
+#include "rpu_xcore.h"
+
+#if RPU_XCORE
+
+#include <xil_io.h>
+#include "xil_mmu.h"
+#include "xinterrupt_wrap.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rpu_log.h"
+#include "rpu_ring.h"
+#include "rpu_shm.h"
+#include "rpu_stackguard.h"
+#include "rpu_tcm.h"
+#include "rpu_time.h"
+
+#define XCORE_GICD_BASE        0xF9000000U  // Distributor, shared by both cores
+#define XCORE_SGI_ID           (RPU_XCORE_SGI | XINTC_IS_SGI_INTR_MASK)
+#define XCORE_PEER_CPU         (1U << RPU_XCORE_PEER)  // SGI target list
+#define XCORE_BATCH            4     /* Messages taken per ring read (task stack) */
+#define XCORE_PING_MS          100   /* PING again until the first PONG */
+#define XCORE_TASK_STACK_SIZE  (configMINIMAL_STACK_SIZE + 64)
+
+typedef struct {
+    RpuXcoreHandler_t fn;
+    void *arg;
+} XcoreHandler_t;
+
+static TaskHandle_t xXcoreTask RPU_BTCM_BSS;
+static rpu_ring_t xXcoreIn RPU_BTCM_BSS;          /* This core's inbox, task side */
+static rpu_ring_t xXcoreOut RPU_BTCM_BSS;         /* The other core's inbox, senders */
+static u32 ulXcoreOutUp RPU_BTCM_BSS;             /* xXcoreOut attached */
+static u32 ulXcorePonged RPU_BTCM_BSS;
+static XcoreHandler_t xXcoreHandlers[RPU_XCORE_TYPES] RPU_BTCM_BSS;
+static StaticTask_t xXcoreTaskBuffer RPU_BTCM_NOINIT;
+static RPU_TASK_STACK(xXcoreStack, XCORE_TASK_STACK_SIZE) RPU_BTCM_NOINIT;
+
+/*-----------------------------------------------------------*/
+/* Doorbell from the other core */
+RPU_ATCM_TEXT static void prvXcoreSgi(void *CallbackRef)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    (void)CallbackRef;
+    vTaskNotifyGiveFromISR(xXcoreTask, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/*-----------------------------------------------------------*/
+/* Queue msg in the other core's inbox, in the caller's critical section;
+ * *ring is set when the receiver needs a doorbell */
+RPU_ATCM_TEXT static int prvXcorePost(const RpuXcoreMsg_t *msg, int *ring)
+{
+    // Only this side writes head: another value is a ring formatted anew
+    if (!ulXcoreOutUp || xXcoreOut.ctrl->head != xXcoreOut.pos) {
+        ulXcoreOutUp = 0;
+        if (rpu_ring_attach(&xXcoreOut, (volatile void *)XCORE_RING_ADDR(RPU_XCORE_PEER),
+                            RPU_RING_PRODUCER) != 0) {
+            return XST_DEVICE_NOT_FOUND;
+        }
+        ulXcoreOutUp = 1;
+    }
+    if (rpu_ring_push(&xXcoreOut, msg, 1) == 0) {
+        return XST_DEVICE_BUSY;
+    }
+    *ring = rpu_ring_commit(&xXcoreOut, 1);
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+static int prvXcoreBuild(RpuXcoreMsg_t *msg, u32 type, const u32 *args, u32 nargs)
+{
+    u32 i;
+
+    if (type >= RPU_XCORE_TYPES || nargs > RPU_XCORE_ARGS || (nargs != 0 && args == NULL)) {
+        return XST_INVALID_PARAM;
+    }
+    msg->type = type;
+    for (i = 0; i < RPU_XCORE_ARGS; i++) {
+        msg->arg[i] = (i < nargs) ? args[i] : 0;
+    }
+    msg->stamp = ullRpuTimeNow();
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuXcoreSend(u32 type, const u32 *args, u32 nargs)
+{
+    RpuXcoreMsg_t msg;
+    int ring = 0;
+    int Status;
+
+    Status = prvXcoreBuild(&msg, type, args, nargs);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    taskENTER_CRITICAL();
+    Status = prvXcorePost(&msg, &ring);
+    taskEXIT_CRITICAL();
+    if (ring) {
+        (void)XTriggerSoftwareIntr(XCORE_SGI_ID, XCORE_GICD_BASE, XCORE_PEER_CPU);
+    }
+    return Status;
+}
+
+int xRpuXcoreSendFromISR(u32 type, const u32 *args, u32 nargs)
+{
+    RpuXcoreMsg_t msg;
+    UBaseType_t uxSaved;
+    int ring = 0;
+    int Status;
+
+    Status = prvXcoreBuild(&msg, type, args, nargs);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    uxSaved = taskENTER_CRITICAL_FROM_ISR();
+    Status = prvXcorePost(&msg, &ring);
+    taskEXIT_CRITICAL_FROM_ISR(uxSaved);
+    if (ring) {
+        (void)XTriggerSoftwareIntr(XCORE_SGI_ID, XCORE_GICD_BASE, XCORE_PEER_CPU);
+    }
+    return Status;
+}
+
+/*-----------------------------------------------------------*/
+int xRpuXcoreRegister(u32 type, RpuXcoreHandler_t fn, void *arg)
+{
+    if (type < RPU_XCORE_MSG_USER || type >= RPU_XCORE_TYPES) {
+        return XST_INVALID_PARAM;
+    }
+    taskENTER_CRITICAL();
+    xXcoreHandlers[type].fn = fn;
+    xXcoreHandlers[type].arg = arg;
+    taskEXIT_CRITICAL();
+    return XST_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* System counter ticks in ns */
+static u32 prvXcoreNs(u64 ticks)
+{
+    return (u32)(ticks * 1000000000ULL / ulRpuTimeHz());
+}
+
+/*-----------------------------------------------------------*/
+static void prvXcoreDispatch(const RpuXcoreMsg_t *msg, u64 now)
+{
+    const XcoreHandler_t *h;
+
+    switch (msg->type) {
+    case RPU_XCORE_MSG_PING:
+        // Sent back as it came, with the sender's stamp for the round trip
+        if (xRpuXcoreSend(RPU_XCORE_MSG_PONG, msg->arg, RPU_XCORE_ARGS) == XST_SUCCESS) {
+            RPU_LOG("XCore: PING in %u ns\r\n", (unsigned)prvXcoreNs(now - msg->stamp));
+        }
+        break;
+    case RPU_XCORE_MSG_PONG:
+        if (!ulXcorePonged) {
+            ulXcorePonged = 1;
+            RPU_LOG("XCore: RPU%u up, round trip %u ns\r\n",
+                    (unsigned)RPU_XCORE_PEER, (unsigned)prvXcoreNs(now - msg->stamp));
+        }
+        break;
+    default:
+        if (msg->type >= RPU_XCORE_TYPES) {
+            break;
+        }
+        h = &xXcoreHandlers[msg->type];
+        if (h->fn != NULL) {
+            h->fn(msg, h->arg);
+        }
+        break;
+    }
+}
+
+/*-----------------------------------------------------------*/
+static void prvXcoreTask(void *pvParameters)
+{
+    RpuXcoreMsg_t msg[XCORE_BATCH];
+    TickType_t wait;
+    u32 n, i;
+    u64 now;
+
+    (void)pvParameters;
+    (void)xRpuXcoreSend(RPU_XCORE_MSG_PING, NULL, 0);
+    for (;;) {
+        while ((n = rpu_ring_pop(&xXcoreIn, msg, XCORE_BATCH)) == 0) {
+            if (rpu_ring_arm(&xXcoreIn) != 0) {
+                continue;
+            }
+            wait = ulXcorePonged ? portMAX_DELAY : pdMS_TO_TICKS(XCORE_PING_MS);
+            // Until the other core answers it may not have had its inbox yet
+            if (ulTaskNotifyTake(pdTRUE, wait) == 0 && !ulXcorePonged) {
+                (void)xRpuXcoreSend(RPU_XCORE_MSG_PING, NULL, 0);
+            }
+        }
+        now = ullRpuTimeNow();
+        for (i = 0; i < n; i++) {
+            prvXcoreDispatch(&msg[i], now);
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+RPU_INIT_TEXT int xRpuXcoreInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    volatile void *inbox = (volatile void *)XCORE_RING_ADDR(RPU_CORE);
+    int Status;
+
+    configASSERT(sizeof(RpuXcoreMsg_t) == XCORE_SLOT_SIZE);
+    Xil_SetTlbAttributes(XCORE_ADDR, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+
+    // Entries a previous instance left are dropped with the format
+    if (rpu_ring_format(inbox, XCORE_SLOTS, XCORE_SLOT_SIZE, RPU_RING_F_EVENT) != 0 ||
+        rpu_ring_attach(&xXcoreIn, inbox, RPU_RING_CONSUMER) != 0) {
+        return XST_FAILURE;
+    }
+    ulXcoreOutUp = 0;
+    ulXcorePonged = 0;
+
+    xXcoreTask = xTaskCreateStatic( prvXcoreTask,
+                             ( const char * ) "XCore",
+                             XCORE_TASK_STACK_SIZE,
+                             NULL,
+                             task_priority,
+                             RPU_TASK_STACK_BUF(xXcoreStack),
+                             &xXcoreTaskBuffer );
+
+    Status = XSetupInterruptSystem(NULL, (Xil_ExceptionHandler)prvXcoreSgi, XCORE_SGI_ID,
+                                   XCORE_GICD_BASE, intr_priority);
+    if (Status != XST_SUCCESS) {
+        return Status;
+    }
+    XEnableIntrId(XCORE_SGI_ID, XCORE_GICD_BASE);
+    return XST_SUCCESS;
+}
+
+#endif /* RPU_XCORE */
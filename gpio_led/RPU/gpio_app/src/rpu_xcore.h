@@ -0,0 +1,84 @@
+/*
+ * Inter-R5 messages (build option RPU_XCORE=1 in both firmwares,
+ * UserConfig.cmake; split mode, rpu_core.h).
+ *
+ * RPU0 and RPU1 pass fixed-size messages to each other without going through
+ * the APU's IPI channels: each core has an inbox at XCORE_RING_ADDR(core) in
+ * OCM (rpu_shm.h), an rpu_ring.h ring that it formats itself and the other
+ * core fills, and the doorbell is software interrupt RPU_XCORE_SGI raised
+ * on the other core's GIC CPU interface with XTriggerSoftwareIntr(). A
+ * message costs eight word stores, a head write and, only when the receiver
+ * armed the ring before it slept, one SGI; a burst is drained behind one
+ * doorbell, so work can be pipelined over the two cores (acquisition on one,
+ * output on the other) at the cost of a few OCM accesses per message.
+ *
+ * The receiving side is a task of its own (XCore, at the priority given to
+ * xRpuXcoreInit()) woken by the SGI handler: it takes the messages in
+ * batches and calls the handler registered for each type. Types below
+ * RPU_XCORE_MSG_USER are the layer's: PING is answered with a PONG, and the
+ * round trip of the PING each core sends once the other one is up is logged.
+ *
+ * Senders on one core are serialized by a critical section, so any task (or
+ * interrupt handler, with the FromISR variant) may send; the producer side
+ * attaches to the other core's inbox on the first send after that core
+ * formatted it, and again when it finds the ring formatted anew (the other
+ * firmware restarted). Messages sent meanwhile are refused, not queued.
+ */
+
+#ifndef RPU_XCORE_H
+#define RPU_XCORE_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "FreeRTOS.h"
+#include "rpu_core.h"
+
+#ifndef RPU_XCORE
+#define RPU_XCORE 0
+#endif
+
+#ifndef RPU_XCORE_SGI
+#define RPU_XCORE_SGI           12    // Doorbell software interrupt (13, 14: rpu_bench.h, rpu_fiq.h)
+#endif
+
+#define RPU_XCORE_PEER          (1 - RPU_CORE)
+#define RPU_XCORE_ARGS          5
+#define RPU_XCORE_TYPES         16
+
+/* Message types */
+#define RPU_XCORE_MSG_PING      0     /* Answered with a PONG carrying arg[] and stamp back */
+#define RPU_XCORE_MSG_PONG      1
+#define RPU_XCORE_MSG_USER      2     /* First type for xRpuXcoreRegister() */
+
+/* One ring slot (XCORE_SLOT_SIZE bytes) */
+typedef struct {
+    u32 type;                   /* RPU_XCORE_MSG_* */
+    u32 arg[RPU_XCORE_ARGS];
+    u64 stamp;                  /* System counter at the send (rpu_time.h) */
+} RpuXcoreMsg_t;
+
+/* Runs in the XCore task for each message of its type */
+typedef void (*RpuXcoreHandler_t)(const RpuXcoreMsg_t *msg, void *arg);
+
+#if RPU_XCORE
+/* Format this core's inbox, connect the SGI at intr_priority and create the
+ * receiving task */
+int xRpuXcoreInit(UBaseType_t task_priority, u16 intr_priority);
+/* Call fn for each message of type (RPU_XCORE_MSG_USER..RPU_XCORE_TYPES-1);
+ * before the other core sends it */
+int xRpuXcoreRegister(u32 type, RpuXcoreHandler_t fn, void *arg);
+/* Queue a message of type with nargs of args for the other core (task
+ * context); XST_SUCCESS, XST_DEVICE_BUSY when the inbox is full,
+ * XST_DEVICE_NOT_FOUND while the other core has not formatted it */
+int xRpuXcoreSend(u32 type, const u32 *args, u32 nargs);
+int xRpuXcoreSendFromISR(u32 type, const u32 *args, u32 nargs);
+#else
+static inline int xRpuXcoreInit(UBaseType_t task_priority, u16 intr_priority)
+{
+    (void)task_priority;
+    (void)intr_priority;
+    return XST_SUCCESS;
+}
+#endif /* RPU_XCORE */
+
+#endif /* RPU_XCORE_H */
@@ -1 +1,9 @@
 set(DRIVER_LIST avbuf;axipmon;clockps;common;coresightps_dcc;csudma;ddrcpsu;dpdma;dppsu;gpio;gpiops;iicps;ipipsu;resetps;rtcpsu;scugic;spips;sysmonpsu;ttcps;uartps;video_common;wdtps;zdma)
+
+# Minimal BSP profile (default): drop the drivers no gpio_app build option
+# uses; their peripherals stay in xparameters.h. Configure the BSP with
+# -DRPU_BSP_MINIMAL=OFF for the full list Vitis generated above.
+option(RPU_BSP_MINIMAL "Build only the drivers gpio_app uses" ON)
+if(RPU_BSP_MINIMAL)
+    list(REMOVE_ITEM DRIVER_LIST avbuf ddrcpsu dpdma dppsu resetps rtcpsu video_common)
+endif()
@@ -100,10 +100,20 @@ extern uint32_t ulPortSetInterruptMask( void );
 extern void vPortClearInterruptMask( uint32_t ulNewMaskValue );
 extern void vPortInstallFreeRTOSVectorTable( void );
 
+#ifndef configUSE_PORT_INLINE_CRITICAL
+	#define configUSE_PORT_INLINE_CRITICAL 0
+#endif
+
 /* These macros do not globally disable/enable interrupts.  They do mask off
 interrupts that have a priority below configMAX_API_CALL_INTERRUPT_PRIORITY. */
-#define portENTER_CRITICAL()		vPortEnterCritical();
-#define portEXIT_CRITICAL()			vPortExitCritical();
+#if ( configUSE_PORT_INLINE_CRITICAL == 1 ) && !defined(ARMR52)
+	/* Expanded at the call site, see vPortEnterCriticalInline() below. */
+	#define portENTER_CRITICAL()		vPortEnterCriticalInline();
+	#define portEXIT_CRITICAL()			vPortExitCriticalInline();
+#else
+	#define portENTER_CRITICAL()		vPortEnterCritical();
+	#define portEXIT_CRITICAL()			vPortExitCritical();
+#endif
 #define portDISABLE_INTERRUPTS()	ulPortSetInterruptMask()
 #define portENABLE_INTERRUPTS()		vPortClearInterruptMask( 0 )
 
@@ -190,6 +200,14 @@ void vPortTaskUsesFPU( void );
 #define portLOWEST_INTERRUPT_PRIORITY ( ( ( uint32_t ) configUNIQUE_INTERRUPT_PRIORITIES ) - 1UL )
 #define portLOWEST_USABLE_INTERRUPT_PRIORITY ( portLOWEST_INTERRUPT_PRIORITY - 1UL )
 
+/* Run time stats time base. When 1 the tick timer runs 10 times faster and
+its interrupt count is the run time counter (Xilinx default). When 0 the
+application defines xCONFIGURE_TIMER_FOR_RUN_TIME_STATS() and
+xGET_RUN_TIME_COUNTER_VALUE() and the tick runs at configTICK_RATE_HZ. */
+#ifndef configRUN_TIME_STATS_USE_TICK_TIMER
+	#define configRUN_TIME_STATS_USE_TICK_TIMER 1
+#endif
+
 /* Architecture specific optimisations. */
 #ifndef configUSE_PORT_OPTIMISED_TASK_SELECTION
 	#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
@@ -270,6 +288,58 @@ number of bits implemented by the interrupt controller. */
 #define portICCRPR_RUNNING_PRIORITY_REGISTER 				( *( ( const volatile uint32_t * ) ( portINTERRUPT_CONTROLLER_CPU_INTERFACE_ADDRESS + portICCRPR_RUNNING_PRIORITY_OFFSET ) ) )
 #define portICCBPR_BINARY_POINT_REGISTER_ADDRESS			( portINTERRUPT_CONTROLLER_CPU_INTERFACE_ADDRESS + portICCBPR_BINARY_POINT_OFFSET )
 #define portICCRPR_RUNNING_PRIORITY_REGISTER_ADDRESS		( portINTERRUPT_CONTROLLER_CPU_INTERFACE_ADDRESS + portICCRPR_RUNNING_PRIORITY_OFFSET )
+
+#if ( configUSE_PORT_INLINE_CRITICAL == 1 )
+/* Inline versions of vPortEnterCritical()/vPortExitCritical() (port.c), for
+task context only.  ulCriticalNesting is saved with the task context, so it can
+be read before the mask is set: a nested entry only counts and does not touch
+the GIC, and the outermost one writes the mask without reading it back first
+as ulPortSetInterruptMask() does.  CPS is self-synchronising for the I bit on
+the R5, so no barrier follows it; the barriers after the mask write remain.
+Until the scheduler starts the count is 9999 (port.c) and every entry sets the
+mask, the same as vPortEnterCritical(). */
+#define portFORCE_INLINE					inline __attribute__( ( always_inline ) )
+#define portCRITICAL_NESTING_BEFORE_START	( 9999UL )
+
+extern volatile uint32_t ulCriticalNesting;
+extern uint32_t ulPortInterruptNesting;
+
+static portFORCE_INLINE void vPortEnterCriticalInline( void )
+{
+	if( ( ulCriticalNesting == 0UL ) || ( ulCriticalNesting >= portCRITICAL_NESTING_BEFORE_START ) )
+	{
+		__asm volatile ( "CPSID	i" ::: "memory" );
+		portICCPMR_PRIORITY_MASK_REGISTER = ( uint32_t ) ( configMAX_API_CALL_INTERRUPT_PRIORITY << portPRIORITY_SHIFT );
+		__asm volatile ( "DSB		\n"
+						 "ISB		\n"
+						 "CPSIE	i	\n" ::: "memory" );
+	}
+	ulCriticalNesting++;
+
+	#ifdef configASSERT
+		if( ulCriticalNesting == 1UL )
+		{
+			configASSERT( ulPortInterruptNesting == 0 );
+		}
+	#endif
+}
+
+static portFORCE_INLINE void vPortExitCriticalInline( void )
+{
+	if( ulCriticalNesting > 0UL )
+	{
+		ulCriticalNesting--;
+		if( ulCriticalNesting == 0UL )
+		{
+			__asm volatile ( "CPSID	i" ::: "memory" );
+			portICCPMR_PRIORITY_MASK_REGISTER = 0xFFUL;
+			__asm volatile ( "DSB		\n"
+							 "ISB		\n"
+							 "CPSIE	i	\n" ::: "memory" );
+		}
+	}
+}
+#endif /* configUSE_PORT_INLINE_CRITICAL */
 #endif
 #define portMEMORY_BARRIER()    __asm volatile ( "" ::: "memory" )
 
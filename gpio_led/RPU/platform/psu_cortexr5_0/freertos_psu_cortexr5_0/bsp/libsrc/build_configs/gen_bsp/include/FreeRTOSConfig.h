@@ -11,8 +11,9 @@
 #define	configUSE_TIME_SLICING			  1
 #define	configUSE_PORT_OPTIMIZED_TASK_SELECTION	  1
 #define	configSTREAM_BUFFER			 0
-#define	configMESSAGE_BUFFER			 0
-#define	configSUPPORT_STATIC_ALLOCATION		 0
+#define	configMESSAGE_BUFFER			 1
+#define	configSUPPORT_STATIC_ALLOCATION		 1
+#define	configSUPPORT_DYNAMIC_ALLOCATION	 0
 #define	configUSE_FREERTOS_ASSERTS		 0
 #define	configUSE_MUTEXES			  1
 #define	INCLUDE_xSemaphoreGetMutexHolder	  1
@@ -22,7 +23,7 @@
 #define	configUSE_NEWLIB_REENTRANT		 0
 #define	configUSE_QUEUE_SETS			  1
 #define	configUSE_TASK_NOTIFICATIONS		  1
-#define	configUSE_STATS_FORMATTING_FUNCTIONS	  1
+#define	configUSE_STATS_FORMATTING_FUNCTIONS	  0
 #define	configUSE_IDLE_HOOK			 0
 #define	configUSE_TICK_HOOK			 0
 #define	configUSE_MALLOC_FAILED_HOOK		  1
@@ -43,7 +44,7 @@
 #define	configTIMER_TASK_PRIORITY		(configMAX_PRIORITIES-1)
 #define	configTIMER_QUEUE_LENGTH		10
 #define	configTIMER_TASK_STACK_DEPTH		((configMINIMAL_STACK_SIZE * 2))
-#define	configGENERATE_RUN_TIME_STATS		0x0
+#define	configGENERATE_RUN_TIME_STATS		0x1
 #define	configMAX_CO_ROUTINE_PRIORITIES		2
 #define	configTIMER_BASEADDR			0xff110000
 #define	configTIMER_SELECT_CNTR			0x0
@@ -52,7 +53,11 @@
 #define	configUSE_16_BIT_TICKS			0x0
 #define	configUSE_APPLICATION_TASK_TAG		0x0
 #define	configUSE_CO_ROUTINES			0x0
-#define	configUSE_TICKLESS_IDLE			0x0
+/* #undef configUSE_TICKLESS_IDLE */
+#define	configUSE_PORT_OPTIMISED_TASK_SELECTION	1
+#define	configUSE_PORT_INLINE_CRITICAL		1
+#define	configRECORD_STACK_HIGH_ADDRESS		1
+#define	configUSE_MPU_STACK_GUARD		1
 #define	INCLUDE_vTaskPrioritySet		1
 #define	INCLUDE_uxTaskPriorityGet		1
 #define	INCLUDE_vTaskDelete			1
@@ -72,14 +77,37 @@
 
 #define configASSERT( x ) if( ( x ) == 0 ) vApplicationAssert( __FILE__, __LINE__ )
 
-#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+void xCONFIGURE_TIMER_FOR_RUN_TIME_STATS(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() xCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+uint32_t xGET_RUN_TIME_COUNTER_VALUE(void);
+#define portGET_RUN_TIME_COUNTER_VALUE() xGET_RUN_TIME_COUNTER_VALUE()
 
-#define portGET_RUN_TIME_COUNTER_VALUE()
+/* Run time stats counter supplied by the application (gpio_app rpu_stats.c) */
+#define configRUN_TIME_STATS_USE_TICK_TIMER 0
 
 void vApplicationAssert( const char *pcFile, uint32_t ulLine );
 void FreeRTOS_SetupTickInterrupt(void);
 #define configSETUP_TICK_INTERRUPT() FreeRTOS_SetupTickInterrupt()
 
+/* Tickless idle: the application supplies the sleep function (gpio_app rpu_power.c) */
+void vApplicationSleep( uint32_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vApplicationSleep( xExpectedIdleTime )
+
+/* Task creation hook: the application records every task's stack bounds
+   (gpio_app rpu_stats.c); pxEndOfStack needs configRECORD_STACK_HIGH_ADDRESS */
+void vApplicationTaskCreated( void *pvTask, void *pvStack, void *pvEndOfStack );
+#define traceTASK_CREATE( pxNewTCB ) vApplicationTaskCreated( ( pxNewTCB ), ( pxNewTCB )->pxStack, ( pxNewTCB )->pxEndOfStack )
+
+/* MPU stack guard in place of the stack check at every switch: the
+   application moves one no-access MPU region below the stack of the task
+   switched in (gpio_app rpu_stackguard.c) */
+#if ( configUSE_MPU_STACK_GUARD == 1 )
+#undef	configCHECK_FOR_STACK_OVERFLOW
+#define	configCHECK_FOR_STACK_OVERFLOW		0
+void vApplicationTaskSwitchedIn( void *pvStack );
+#define traceTASK_SWITCHED_IN() vApplicationTaskSwitchedIn( pxCurrentTCB->pxStack )
+#endif
+
 
 #define configCOMMAND_INT_MAX_OUTPUT_SIZE 2096
 #define recmuCONTROLLING_TASK_PRIORITY ( configMAX_PRIORITIES - 2 )
@@ -42,6 +42,39 @@ extern "C" {
 
 /***************** Macros (Inline Functions) Definitions *********************/
 
+/****************************************************************************/
+/**
+* Writes Value to the data register of Channel, then writes the shadow again
+* until the two agree. A caller preempted between its shadow update and its
+* register write by another update (task or interrupt) therefore never leaves
+* its older value in the device: whichever write comes last is followed by
+* a check against the latest shadow.
+*
+* @param	InstancePtr Pointer to the XGpio instance.
+* @param	Channel Channel of the GPIO (1 or 2).
+* @param	Value Shadow value the caller just stored.
+*
+* @return	None.
+*
+*****************************************************************************/
+static inline void XGpio_ShadowPublish(XGpio *InstancePtr, unsigned Channel,
+				       u32 Value)
+{
+	unsigned DataOffset = ((Channel - 1) * XGPIO_CHAN_OFFSET) +
+			      XGPIO_DATA_OFFSET;
+	u32 Latest;
+
+	for (;;) {
+		XGpio_WriteReg(InstancePtr->BaseAddress, DataOffset, Value);
+		Latest = __atomic_load_n(&InstancePtr->DataShadow[Channel - 1],
+					 __ATOMIC_ACQUIRE);
+		if (Latest == Value) {
+			break;
+		}
+		Value = Latest;
+	}
+}
+
 
 /************************** Function Prototypes ******************************/
 
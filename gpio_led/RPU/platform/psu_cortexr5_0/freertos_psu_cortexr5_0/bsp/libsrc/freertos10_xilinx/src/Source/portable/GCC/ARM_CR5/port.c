@@ -277,7 +277,7 @@ uint32_t ulPortInterruptNesting = 0UL;
  * Global counter used for calculation of run time statistics of tasks.
  * Defined only when the relevant option is turned on
  */
-#if (configGENERATE_RUN_TIME_STATS==1)
+#if ( configGENERATE_RUN_TIME_STATS == 1 ) && ( configRUN_TIME_STATS_USE_TICK_TIMER == 1 )
 volatile uint32_t ulHighFrequencyTimerTicks;
 #endif
 
@@ -706,7 +706,7 @@ void FreeRTOS_Tick_Handler( void )
 	 * For handling generation of run time stats, it increments a pre-defined counter every time the
 	 * interrupt handler executes.
 	 */
-#if (configGENERATE_RUN_TIME_STATS == 1)
+#if ( configGENERATE_RUN_TIME_STATS == 1 ) && ( configRUN_TIME_STATS_USE_TICK_TIMER == 1 )
 	ulHighFrequencyTimerTicks++;
 	if (!(ulHighFrequencyTimerTicks % 10))
 #endif
@@ -849,7 +849,7 @@ uint32_t ulPmr;
 
 #endif /* configASSERT_DEFINED */
 
-#if( configGENERATE_RUN_TIME_STATS == 1 )
+#if ( configGENERATE_RUN_TIME_STATS == 1 ) && ( configRUN_TIME_STATS_USE_TICK_TIMER == 1 )
 /*
  * For Xilinx implementation this is a dummy function that does a redundant operation
  * of zeroing out the global counter.
@@ -127,7 +127,7 @@ XScuGic_Config *pxInterruptControllerConfig;
 	 * FreeRTOS ticks. In case user decides to generate run time stats the timer time out interval is changed
 	 * as "configured tick rate * 10". The multiplying factor of 10 is hard coded for Xilinx FreeRTOS ports.
 	 */
-#if (configGENERATE_RUN_TIME_STATS == 1)
+#if ( configGENERATE_RUN_TIME_STATS == 1 ) && ( configRUN_TIME_STATS_USE_TICK_TIMER == 1 )
 	XTtcPs_CalcIntervalFromFreq( &xTimerInstance, configTICK_RATE_HZ*10, &usInterval, &ucPrescaler );
 #else
 	XTtcPs_CalcIntervalFromFreq( &xTimerInstance, configTICK_RATE_HZ, &usInterval, &ucPrescaler );
@@ -160,7 +160,7 @@ void FreeRTOS_SetupTickInterrupt( void )
          * FreeRTOS ticks. In case user decides to generate run time stats the timer time out interval is changed
          * as "configured tick rate * 10". The multiplying factor of 10 is hard coded for Xilinx FreeRTOS ports.
          */
-#if (configGENERATE_RUN_TIME_STATS == 1)
+#if ( configGENERATE_RUN_TIME_STATS == 1 ) && ( configRUN_TIME_STATS_USE_TICK_TIMER == 1 )
         /* XTimer_SetInterval() API expects delay in milli seconds
          * Convert the user provided tick rate to milli seconds.
          */
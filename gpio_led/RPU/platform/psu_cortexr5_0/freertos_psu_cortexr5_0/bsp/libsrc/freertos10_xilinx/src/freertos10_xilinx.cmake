@@ -10,6 +10,8 @@ priority from which interrupt safe FreeRTOS API calls can be made.")
 option(freertos_use_preemption "The maximum interrupt priority from which interrupt \
 safe FreeRTOS API calls can be made." ON)
 set(freertos_tick_rate 100 CACHE STRING "Number of RTOS ticks per sec")
+set(freertos_tickless_idle 0 CACHE STRING "0 keeps the tick running while idle, \
+2 has the idle task call vApplicationSleep() to stop it (tickless idle).")
 option(freertos_idle_yield "Set to true if the Idle task should yield if another \
 idle priority task is able to run, or false if the idle task should \
 always use its entire time slice unless it is preempted." ON)
@@ -38,6 +40,8 @@ option(freertos_message_buffer "Set to true to include message buffer functional
 or false to exclude message buffer functionality." OFF)
 option(freertos_support_static_allocation "Set to true to allocate memory statically, \
 or false to allocate memory dynamically." OFF)
+option(freertos_support_dynamic_allocation "Set to true to allow the creation of \
+RTOS objects from the FreeRTOS heap (heap_4.c), or false to build without a heap." ON)
 option(freertos_use_freertos_asserts "Defines configASSERT() to assist \
 development and debugging.  The application can override the \
 default implementation of \
@@ -215,7 +219,14 @@ set(configUSE_16_BIT_TICKS 0x0)
 set(configUSE_APPLICATION_TASK_TAG 0x0)
 set(configUSE_CO_ROUTINES 0x0)
 set(configMAX_CO_ROUTINE_PRIORITIES 2)
-set(configUSE_TICKLESS_IDLE 0x0)
+set(configUSE_TICKLESS_IDLE ${freertos_tickless_idle})
+# Ready list selection with CLZ, critical sections inlined (portmacro.h)
+set(configUSE_PORT_OPTIMISED_TASK_SELECTION 1)
+set(configUSE_PORT_INLINE_CRITICAL 1)
+# Stack end in the TCB for the task creation hook (FreeRTOSConfig.h.in)
+set(configRECORD_STACK_HIGH_ADDRESS 1)
+# MPU stack guard of gpio_app instead of the per-switch check (FreeRTOSConfig.h.in)
+set(configUSE_MPU_STACK_GUARD 1)
 set(configTASK_RETURN_ADDRESS	NULL)
 set(INCLUDE_vTaskPrioritySet 1)
 set(INCLUDE_uxTaskPriorityGet 1)
@@ -284,6 +295,9 @@ endif()
 if (${freertos_support_static_allocation})
     set(configSUPPORT_STATIC_ALLOCATION " ")
 endif()
+if (${freertos_support_dynamic_allocation})
+    set(configSUPPORT_DYNAMIC_ALLOCATION " ")
+endif()
 if (${freertos_use_freertos_asserts})
     set(FREERTOS_ASSERTS "#define configASSERT( x ) \
 if( ( x ) == 0 ) vApplicationAssert( __FILE__, __LINE__ )")
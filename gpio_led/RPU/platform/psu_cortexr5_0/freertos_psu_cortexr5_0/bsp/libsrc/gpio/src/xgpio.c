@@ -45,6 +45,7 @@
 /***************************** Include Files ********************************/
 
 #include "xgpio.h"
+#include "xgpio_i.h"
 #include "xstatus.h"
 
 /************************** Constant Definitions ****************************/
@@ -103,6 +104,17 @@ int XGpio_CfgInitialize(XGpio * InstancePtr, XGpio_Config * Config,
 	InstancePtr->InterruptPresent = Config->InterruptPresent;
 	InstancePtr->IsDual = Config->IsDual;
 
+	/*
+	 * Seed the shadows with the outputs the device drives now; this is
+	 * the only read of the data registers the shadow APIs depend on.
+	 */
+	InstancePtr->DataShadow[0] = XGpio_ReadReg(EffectiveAddr,
+						   XGPIO_DATA_OFFSET);
+	InstancePtr->DataShadow[1] = (Config->IsDual == TRUE) ?
+				     XGpio_ReadReg(EffectiveAddr,
+						   XGPIO_CHAN_OFFSET +
+						   XGPIO_DATA_OFFSET) : 0U;
+
 	/*
 	 * Indicate the instance is now ready to use, initialized without error
 	 */
@@ -211,7 +223,9 @@ u32 XGpio_DiscreteRead(XGpio * InstancePtr, unsigned Channel)
 * @note		The hardware must be built for dual channels if this function
 *		is  used with any channel other than 1.  If it is not, this
 *		function will assert. See also XGpio_DiscreteSet() and
-*		XGpio_DiscreteClear().
+*		XGpio_DiscreteClear(). The value is also stored as the shadow
+*		of the channel, so it can be mixed with
+*		XGpio_DiscreteShadowSet() and XGpio_DiscreteShadowClear().
 *
 *****************************************************************************/
 void XGpio_DiscreteWrite(XGpio * InstancePtr, unsigned Channel, u32 Mask)
@@ -221,8 +235,8 @@ void XGpio_DiscreteWrite(XGpio * InstancePtr, unsigned Channel, u32 Mask)
 	Xil_AssertVoid((Channel == 1) ||
 		     ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
 
-	XGpio_WriteReg(InstancePtr->BaseAddress,
-			((Channel - 1) * XGPIO_CHAN_OFFSET) + XGPIO_DATA_OFFSET,
-			Mask);
+	__atomic_store_n(&InstancePtr->DataShadow[Channel - 1], Mask,
+			 __ATOMIC_RELEASE);
+	XGpio_ShadowPublish(InstancePtr, Channel, Mask);
 }
 /** @} */
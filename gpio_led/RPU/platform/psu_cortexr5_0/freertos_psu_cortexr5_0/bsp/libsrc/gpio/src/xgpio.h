@@ -59,6 +59,8 @@
 * 4.8	sne  02/10/21 Fixed doxygen warnings.
 * 4.10  gm   07/11/23 Added SDT support.
 * 4.10  gm   08/28/23 Added Width member to XGpio_Config in SDT flow.
+* 4.10  kr   10/14/26 Added DataShadow and the XGpio_DiscreteShadow* APIs,
+*                     which update output bits without reading the device.
 *
 * </pre>
 *****************************************************************************/
@@ -110,6 +112,8 @@ typedef struct {
 	u32 IsReady;		/**< Device is initialized and ready */
 	int InterruptPresent;	/**< Are interrupts supported in h/w */
 	int IsDual;		/**< Are 2 channels supported in h/w */
+	u32 DataShadow[2];	/**< Last value written to the data register
+				  *  of each channel */
 } XGpio;
 
 /***************** Macros (Inline Functions) Definitions ********************/
@@ -145,6 +149,9 @@ void XGpio_DiscreteWrite(XGpio *InstancePtr, unsigned Channel, u32 Mask);
  */
 void XGpio_DiscreteSet(XGpio *InstancePtr, unsigned Channel, u32 Mask);
 void XGpio_DiscreteClear(XGpio *InstancePtr, unsigned Channel, u32 Mask);
+void XGpio_DiscreteShadowSet(XGpio *InstancePtr, unsigned Channel, u32 Mask);
+void XGpio_DiscreteShadowClear(XGpio *InstancePtr, unsigned Channel, u32 Mask);
+u32 XGpio_DiscreteShadowRead(XGpio *InstancePtr, unsigned Channel);
 
 /*
  * API Functions implemented in xgpio_selftest.c
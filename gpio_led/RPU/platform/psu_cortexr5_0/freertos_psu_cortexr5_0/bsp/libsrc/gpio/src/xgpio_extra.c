@@ -31,6 +31,9 @@
 * 3.00a sv   11/21/09 Updated to use HAL Processor APIs. Renamed the macros
 *		      XGpio_mWriteReg to XGpio_WriteReg, and XGpio_mReadReg
 *		      to XGpio_ReadReg.
+*		      DiscreteSet/Clear keep DataShadow up to date. Added
+*		      XGpio_DiscreteShadowSet, XGpio_DiscreteShadowClear and
+*		      XGpio_DiscreteShadowRead.
 * </pre>
 *
 *****************************************************************************/
@@ -91,6 +94,7 @@ void XGpio_DiscreteSet(XGpio * InstancePtr, unsigned Channel, u32 Mask)
 	 */
 	Current = XGpio_ReadReg(InstancePtr->BaseAddress, DataOffset);
 	Current |= Mask;
+	InstancePtr->DataShadow[Channel - 1] = Current;
 	XGpio_WriteReg(InstancePtr->BaseAddress, DataOffset, Current);
 }
 
@@ -134,6 +138,95 @@ void XGpio_DiscreteClear(XGpio * InstancePtr, unsigned Channel, u32 Mask)
 	 */
 	Current = XGpio_ReadReg(InstancePtr->BaseAddress, DataOffset);
 	Current &= ~Mask;
+	InstancePtr->DataShadow[Channel - 1] = Current;
 	XGpio_WriteReg(InstancePtr->BaseAddress, DataOffset, Current);
 }
+
+/****************************************************************************/
+/**
+* Set output discrete(s) to logic 1 for the specified GPIO channel without
+* reading the device.
+*
+* The new value is computed from the shadow of the channel (the last value
+* written through this driver) with an atomic OR, then written to the data
+* register. Tasks and interrupt handlers on the same CPU may call this,
+* XGpio_DiscreteShadowClear() and XGpio_DiscreteWrite() concurrently without
+* a lock: each update is kept and the register ends up equal to the shadow.
+*
+* @param	InstancePtr Pointer to an XGpio instance to be worked on.
+* @param	Channel Contains the channel of the GPIO (1 or 2) to operate on.
+* @param	Mask Set of bits that will be set to 1 in the discrete
+*		data register. All other bits in the data register are
+*		unaffected.
+*
+* @return	None.
+*
+* @note		Writes to the data register that bypass the driver are not
+*		seen by the shadow. Input bits read back as the shadow, not as
+*		their pins; use XGpio_DiscreteRead() for those.
+*
+*****************************************************************************/
+void XGpio_DiscreteShadowSet(XGpio * InstancePtr, unsigned Channel, u32 Mask)
+{
+	u32 Value;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((Channel == 1) ||
+		     ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	Value = __atomic_or_fetch(&InstancePtr->DataShadow[Channel - 1], Mask,
+				  __ATOMIC_ACQ_REL);
+	XGpio_ShadowPublish(InstancePtr, Channel, Value);
+}
+
+/****************************************************************************/
+/**
+* Set output discrete(s) to logic 0 for the specified GPIO channel without
+* reading the device. See XGpio_DiscreteShadowSet().
+*
+* @param	InstancePtr Pointer to an XGpio instance to be worked on.
+* @param	Channel Contains the channel of the GPIO (1 or 2) to operate on.
+* @param	Mask Set of bits that will be set to 0 in the discrete
+*		data register. All other bits in the data register are
+*		unaffected.
+*
+* @return	None.
+*
+*****************************************************************************/
+void XGpio_DiscreteShadowClear(XGpio * InstancePtr, unsigned Channel, u32 Mask)
+{
+	u32 Value;
+
+	Xil_AssertVoid(InstancePtr != NULL);
+	Xil_AssertVoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertVoid((Channel == 1) ||
+		     ((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	Value = __atomic_and_fetch(&InstancePtr->DataShadow[Channel - 1], ~Mask,
+				   __ATOMIC_ACQ_REL);
+	XGpio_ShadowPublish(InstancePtr, Channel, Value);
+}
+
+/****************************************************************************/
+/**
+* Returns the shadow of the data register of the specified GPIO channel, the
+* outputs as last written through this driver, without a bus access.
+*
+* @param	InstancePtr Pointer to an XGpio instance to be worked on.
+* @param	Channel Contains the channel of the GPIO (1 or 2) to operate on.
+*
+* @return	Shadow of the discretes register.
+*
+*****************************************************************************/
+u32 XGpio_DiscreteShadowRead(XGpio * InstancePtr, unsigned Channel)
+{
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid((Channel == 1) ||
+			((Channel == 2) && (InstancePtr->IsDual == TRUE)));
+
+	return __atomic_load_n(&InstancePtr->DataShadow[Channel - 1],
+			       __ATOMIC_ACQUIRE);
+}
 /** @} */
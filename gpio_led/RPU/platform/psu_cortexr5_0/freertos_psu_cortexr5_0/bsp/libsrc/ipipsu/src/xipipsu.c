@@ -40,6 +40,11 @@
 * 2.17	ht	11/08/24	Update description of Msglength for XIpiPsu_ReadMessage
 * 				and XIpiPsu_WriteMessage.
 * 2.18  an	08/07/25	Fix pointer to integer cast warning
+*				Added XIpiPsu_BroadcastMessage and
+*				XIpiPsu_PollForAckMask for multi-target IPIs
+*				Build the buffer index map in XIpiPsu_CfgInitialize
+*				XIpiPsu_BroadcastMessage does not trigger targets
+*				whose message write failed and reports them
 * </pre>
 *
 *****************************************************************************/
@@ -70,6 +75,7 @@ XStatus XIpiPsu_CfgInitialize(XIpiPsu *InstancePtr, XIpiPsu_Config *CfgPtr,
 			      UINTPTR EffectiveAddress)
 {
 	u32 Index;
+	u32 Mask;
 
 	/* Validate the input arguments */
 	Xil_AssertNonvoid(InstancePtr != NULL);
@@ -96,6 +102,21 @@ XStatus XIpiPsu_CfgInitialize(XIpiPsu *InstancePtr, XIpiPsu_Config *CfgPtr,
 			CfgPtr->TargetList[Index].BufferIndex;
 	}
 
+	/*
+	 * Build the mask to buffer index map. The first target with a given
+	 * mask wins, as in the TargetList search it replaces.
+	 */
+	for (Index = 0U; Index < (u32)sizeof(InstancePtr->BufferIndexMap); Index++) {
+		InstancePtr->BufferIndexMap[Index] = (u8)(XIPIPSU_MAX_BUFF_INDEX + 1U);
+	}
+	for (Index = CfgPtr->TargetCount; Index > 0U; Index--) {
+		Mask = CfgPtr->TargetList[Index - 1U].Mask;
+		if ((Mask != 0U) && ((Mask & (Mask - 1U)) == 0U)) {
+			InstancePtr->BufferIndexMap[__builtin_ctz(Mask)] =
+				(u8)CfgPtr->TargetList[Index - 1U].BufferIndex;
+		}
+	}
+
 	/* Mark the component as Ready */
 	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
 	return (XStatus) XST_SUCCESS;
@@ -190,6 +211,149 @@ XStatus XIpiPsu_PollForAck(const XIpiPsu *InstancePtr, u32 DestCpuMask,
 	return Status;
 }
 
+/**
+ * @brief	Sends one Message to several Destinations and triggers all of
+ * 		them with a single write of the Trigger register
+ *
+ * @param	InstancePtr Pointer to current IPI instance
+ * @param	DestCpuMask OR of the masks of the destination CPUs
+ * @param	MsgPtr Pointer to Buffer which contains the message to be sent
+ * @param	MsgLength Number of messages (each message is 4bytes)
+ * @param	SentMaskPtr Receives the bits of DestCpuMask that were
+ * 		triggered (may be NULL)
+ *
+ * @return	XST_SUCCESS if successful
+ * 			XST_FAILURE if DestCpuMask has a bit that is not one of the
+ * 			targets of this instance (nothing is written or triggered
+ * 			in that case), or if the message could not be written for
+ * 			some targets; those are not triggered and are missing
+ * 			from *SentMaskPtr, the others are
+ *
+ * @note	Targets sharing a message buffer (for example the PMU channels)
+ * 		get the message written once. Targets without a message
+ * 		buffer (such as PL masters) are only triggered. Collect the
+ * 		acknowledgements of *SentMaskPtr with XIpiPsu_PollForAckMask().
+ */
+
+XStatus XIpiPsu_BroadcastMessage(XIpiPsu *InstancePtr, u32 DestCpuMask,
+				 const u32 *MsgPtr, u32 MsgLength,
+				 u32 *SentMaskPtr)
+{
+	u32 KnownMask = 0U;
+	u32 WrittenIndexMask = 0U;
+	u32 FailedIndexMask = 0U;
+	u32 FailedMask = 0U;
+	u32 SentMask;
+	u32 Index;
+	u32 BufferIndex;
+	XStatus Status;
+
+	/* Validate the input arguments */
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(MsgPtr != NULL);
+	Xil_AssertNonvoid(MsgLength <= XIPIPSU_MAX_MSG_LEN);
+
+	for (Index = 0U; Index < InstancePtr->Config.TargetCount; Index++) {
+		KnownMask |= InstancePtr->Config.TargetList[Index].Mask;
+	}
+	if (SentMaskPtr != NULL) {
+		*SentMaskPtr = 0U;
+	}
+	if ((DestCpuMask == 0U) || ((DestCpuMask & ~KnownMask) != 0U)) {
+		return (XStatus)XST_FAILURE;
+	}
+
+	/* Copy the Message to the buffer of every distinct target */
+	for (Index = 0U; Index < InstancePtr->Config.TargetCount; Index++) {
+		if ((InstancePtr->Config.TargetList[Index].Mask & DestCpuMask) == 0U) {
+			continue;
+		}
+		BufferIndex = InstancePtr->Config.TargetList[Index].BufferIndex;
+		if ((BufferIndex > XIPIPSU_MAX_BUFF_INDEX) ||
+		    (((WrittenIndexMask | FailedIndexMask) &
+		      ((u32)1U << BufferIndex)) != 0U)) {
+			continue;
+		}
+		if (XIpiPsu_WriteMessage(InstancePtr,
+					 InstancePtr->Config.TargetList[Index].Mask,
+					 MsgPtr, MsgLength,
+					 XIPIPSU_BUF_TYPE_MSG) == (XStatus)XST_SUCCESS) {
+			WrittenIndexMask |= (u32)1U << BufferIndex;
+		} else {
+			FailedIndexMask |= (u32)1U << BufferIndex;
+		}
+	}
+
+	/* Leave out every Target whose buffer did not get the Message */
+	if (FailedIndexMask != 0U) {
+		for (Index = 0U; Index < InstancePtr->Config.TargetCount; Index++) {
+			BufferIndex = InstancePtr->Config.TargetList[Index].BufferIndex;
+			if ((BufferIndex <= XIPIPSU_MAX_BUFF_INDEX) &&
+			    ((FailedIndexMask & ((u32)1U << BufferIndex)) != 0U)) {
+				FailedMask |= InstancePtr->Config.TargetList[Index].Mask;
+			}
+		}
+	}
+	SentMask = DestCpuMask & ~FailedMask;
+
+	/* One doorbell for all the remaining Targets */
+	if (SentMask != 0U) {
+		Status = XIpiPsu_TriggerIpi(InstancePtr, SentMask);
+		if (Status != (XStatus)XST_SUCCESS) {
+			return Status;
+		}
+	}
+	if (SentMaskPtr != NULL) {
+		*SentMaskPtr = SentMask;
+	}
+
+	return (FailedMask != 0U) ? (XStatus)XST_FAILURE : (XStatus)XST_SUCCESS;
+}
+
+/**
+ * @brief	Polls for the acknowledgements of several Destinations using
+ * 		the Observation Register
+ *
+ * @param	InstancePtr Pointer to current IPI instance
+ * @param	DestCpuMask OR of the masks of the destination CPUs
+ * @param	TimeOutCount Count after which the routines returns failure
+ * @param	AckMaskPtr Receives the bits of DestCpuMask that acknowledged
+ * 		(may be NULL)
+ *
+ * @return	XST_SUCCESS if every destination acknowledged
+ * 			XST_FAILURE if a timeout occurred; *AckMaskPtr then tells
+ * 			which destinations did
+ *
+ * @note	Unlike calling XIpiPsu_PollForAck() once per target, all the
+ * 		destinations are watched in one loop, so the time spent is
+ * 		that of the slowest one instead of the sum.
+ */
+
+XStatus XIpiPsu_PollForAckMask(const XIpiPsu *InstancePtr, u32 DestCpuMask,
+			       u32 TimeOutCount, u32 *AckMaskPtr)
+{
+	u32 Pending, PollCount;
+
+	/* Validate the input arguments */
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	PollCount = 0U;
+	/* Poll the OBS register until all the DestCpu bits are cleared */
+	do {
+		Pending = (XIpiPsu_ReadReg(InstancePtr->Config.BaseAddress,
+					   XIPIPSU_OBS_OFFSET)) & (DestCpuMask);
+		PollCount++;
+	} while ((0x00000000U != Pending) && (PollCount < TimeOutCount));
+
+	if (AckMaskPtr != NULL) {
+		*AckMaskPtr = DestCpuMask & ~Pending;
+	}
+
+	return (0x00000000U != Pending) ? (XStatus)XST_FAILURE : (XStatus)XST_SUCCESS;
+}
+
 
 /**
  * @brief	Read an Incoming Message from a Source.
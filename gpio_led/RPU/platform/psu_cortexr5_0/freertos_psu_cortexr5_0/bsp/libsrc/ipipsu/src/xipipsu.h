@@ -48,6 +48,10 @@
  * 2.17 ht 11/25/24  Update Max Message length to accommodate for CRC bytes
  *                   when IPI CRC is enabled
  *	jb 12/26/24 Fixed misrac warnings
+ *      	    Added multi-target XIpiPsu_BroadcastMessage and
+ *      	    XIpiPsu_PollForAckMask
+ *      	    Added BufferIndexMap for O(1) buffer index lookup
+ *      	    XIpiPsu_BroadcastMessage reports the triggered targets
  * </pre>
  *
  *****************************************************************************/
@@ -161,6 +165,8 @@ typedef struct {
 	XIpiPsu_Config Config; /**< Configuration structure */
 	u32 IsReady; /**< Device is initialized and ready */
 	u32 Options; /**< Options set in the device */
+	u8 BufferIndexMap[32]; /**< Buffer Index of the single-bit target mask
+				 *  (1 << n) at [n], built by CfgInitialize */
 } XIpiPsu;
 
 /***************** Macros (Inline Functions) Definitions *********************/
@@ -330,6 +336,13 @@ XStatus XIpiPsu_ReadMessage(XIpiPsu *InstancePtr, u32 SrcCpuMask, u32 *MsgPtr,
 XStatus XIpiPsu_WriteMessage(XIpiPsu *InstancePtr, u32 DestCpuMask, const u32 *MsgPtr,
 			     u32 MsgLength, u8 BufferType);
 
+XStatus XIpiPsu_BroadcastMessage(XIpiPsu *InstancePtr, u32 DestCpuMask,
+				 const u32 *MsgPtr, u32 MsgLength,
+				 u32 *SentMaskPtr);
+
+XStatus XIpiPsu_PollForAckMask(const XIpiPsu *InstancePtr, u32 DestCpuMask,
+			       u32 TimeOutCount, u32 *AckMaskPtr);
+
 void XIpiPsu_SetConfigTable(u32 DeviceId, XIpiPsu_Config *ConfigTblPtr);
 
 #ifdef __cplusplus
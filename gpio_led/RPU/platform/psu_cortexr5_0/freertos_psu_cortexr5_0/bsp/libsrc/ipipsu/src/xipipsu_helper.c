@@ -22,6 +22,8 @@
 * 2.14	ht	06/13/23 Restructured the code for more modularity
 *     	ht	07/28/23 Fix MISRA-C warnings
 * 2.17	ma	04/05/25 Read always in 4 bytes from IPI buffer
+*      	 	         Table-driven CRC16, one lookup per byte
+*      	 	         Buffer index lookup through BufferIndexMap
 *
 * </pre>
 *
@@ -44,6 +46,48 @@
 #endif
 
 /************************** Variable Definitions *****************************/
+#if defined(ENABLE_IPI_CRC) && !defined(XIPIPSU_CRC_BITWISE)
+/*
+ * CRC16 of each byte value i shifted into the high byte (i << 8), POLYNOM,
+ * MSB first. Generated with the bit-serial loop below; define
+ * XIPIPSU_CRC_BITWISE to build that loop instead, which gives identical
+ * results.
+ */
+static const u16 XIpiPsu_Crc16Table[256] = {
+	0x0000U, 0x8005U, 0x800FU, 0x000AU, 0x801BU, 0x001EU, 0x0014U, 0x8011U,
+	0x8033U, 0x0036U, 0x003CU, 0x8039U, 0x0028U, 0x802DU, 0x8027U, 0x0022U,
+	0x8063U, 0x0066U, 0x006CU, 0x8069U, 0x0078U, 0x807DU, 0x8077U, 0x0072U,
+	0x0050U, 0x8055U, 0x805FU, 0x005AU, 0x804BU, 0x004EU, 0x0044U, 0x8041U,
+	0x80C3U, 0x00C6U, 0x00CCU, 0x80C9U, 0x00D8U, 0x80DDU, 0x80D7U, 0x00D2U,
+	0x00F0U, 0x80F5U, 0x80FFU, 0x00FAU, 0x80EBU, 0x00EEU, 0x00E4U, 0x80E1U,
+	0x00A0U, 0x80A5U, 0x80AFU, 0x00AAU, 0x80BBU, 0x00BEU, 0x00B4U, 0x80B1U,
+	0x8093U, 0x0096U, 0x009CU, 0x8099U, 0x0088U, 0x808DU, 0x8087U, 0x0082U,
+	0x8183U, 0x0186U, 0x018CU, 0x8189U, 0x0198U, 0x819DU, 0x8197U, 0x0192U,
+	0x01B0U, 0x81B5U, 0x81BFU, 0x01BAU, 0x81ABU, 0x01AEU, 0x01A4U, 0x81A1U,
+	0x01E0U, 0x81E5U, 0x81EFU, 0x01EAU, 0x81FBU, 0x01FEU, 0x01F4U, 0x81F1U,
+	0x81D3U, 0x01D6U, 0x01DCU, 0x81D9U, 0x01C8U, 0x81CDU, 0x81C7U, 0x01C2U,
+	0x0140U, 0x8145U, 0x814FU, 0x014AU, 0x815BU, 0x015EU, 0x0154U, 0x8151U,
+	0x8173U, 0x0176U, 0x017CU, 0x8179U, 0x0168U, 0x816DU, 0x8167U, 0x0162U,
+	0x8123U, 0x0126U, 0x012CU, 0x8129U, 0x0138U, 0x813DU, 0x8137U, 0x0132U,
+	0x0110U, 0x8115U, 0x811FU, 0x011AU, 0x810BU, 0x010EU, 0x0104U, 0x8101U,
+	0x8303U, 0x0306U, 0x030CU, 0x8309U, 0x0318U, 0x831DU, 0x8317U, 0x0312U,
+	0x0330U, 0x8335U, 0x833FU, 0x033AU, 0x832BU, 0x032EU, 0x0324U, 0x8321U,
+	0x0360U, 0x8365U, 0x836FU, 0x036AU, 0x837BU, 0x037EU, 0x0374U, 0x8371U,
+	0x8353U, 0x0356U, 0x035CU, 0x8359U, 0x0348U, 0x834DU, 0x8347U, 0x0342U,
+	0x03C0U, 0x83C5U, 0x83CFU, 0x03CAU, 0x83DBU, 0x03DEU, 0x03D4U, 0x83D1U,
+	0x83F3U, 0x03F6U, 0x03FCU, 0x83F9U, 0x03E8U, 0x83EDU, 0x83E7U, 0x03E2U,
+	0x83A3U, 0x03A6U, 0x03ACU, 0x83A9U, 0x03B8U, 0x83BDU, 0x83B7U, 0x03B2U,
+	0x0390U, 0x8395U, 0x839FU, 0x039AU, 0x838BU, 0x038EU, 0x0384U, 0x8381U,
+	0x0280U, 0x8285U, 0x828FU, 0x028AU, 0x829BU, 0x029EU, 0x0294U, 0x8291U,
+	0x82B3U, 0x02B6U, 0x02BCU, 0x82B9U, 0x02A8U, 0x82ADU, 0x82A7U, 0x02A2U,
+	0x82E3U, 0x02E6U, 0x02ECU, 0x82E9U, 0x02F8U, 0x82FDU, 0x82F7U, 0x02F2U,
+	0x02D0U, 0x82D5U, 0x82DFU, 0x02DAU, 0x82CBU, 0x02CEU, 0x02C4U, 0x82C1U,
+	0x8243U, 0x0246U, 0x024CU, 0x8249U, 0x0258U, 0x825DU, 0x8257U, 0x0252U,
+	0x0270U, 0x8275U, 0x827FU, 0x027AU, 0x826BU, 0x026EU, 0x0264U, 0x8261U,
+	0x0220U, 0x8225U, 0x822FU, 0x022AU, 0x823BU, 0x023EU, 0x0234U, 0x8231U,
+	0x8213U, 0x0216U, 0x021CU, 0x8219U, 0x0208U, 0x820DU, 0x8207U, 0x0202U,
+};
+#endif
 
 /****************************************************************************/
 #ifdef ENABLE_IPI_CRC
@@ -55,6 +99,28 @@
  *
  * @return	Checksum - 16 bit CRC value
  */
+#ifndef XIPIPSU_CRC_BITWISE
+u32 XIpiPsu_CalculateCRC(u32 BufAddr, u32 BufSize)
+{
+	u32 Crc16 = INITIAL_CRC_VAL;
+	u32 Idx;
+	u32 Data;
+	u32 ByteIdx;
+
+	for (Idx = 0U; Idx < BufSize; Idx = Idx + WORD_LEN_IN_BYTES) {
+		Data = Xil_In32(BufAddr + Idx);
+		/* Bytes in memory order, as the bit-serial version */
+		for (ByteIdx = 0U; ByteIdx < WORD_LEN_IN_BYTES; ByteIdx++) {
+			Crc16 = ((Crc16 << NUM_BITS_IN_BYTE) ^
+				 XIpiPsu_Crc16Table[((Crc16 >> NUM_BITS_IN_BYTE) ^ Data) & BYTE_MASK]) &
+				CRC16_MASK;
+			Data >>= NUM_BITS_IN_BYTE;
+		}
+	}
+
+	return Crc16;
+}
+#else
 u32 XIpiPsu_CalculateCRC(u32 BufAddr, u32 BufSize)
 {
 	u32 Crc16 = INITIAL_CRC_VAL;
@@ -90,6 +156,7 @@ u32 XIpiPsu_CalculateCRC(u32 BufAddr, u32 BufSize)
 
 	return Crc16;
 }
+#endif /* XIPIPSU_CRC_BITWISE */
 #endif
 
 
@@ -108,10 +175,16 @@ u32 XIpiPsu_GetBufferIndex(const XIpiPsu *InstancePtr, u32 CpuMask)
 {
 	u32 BufferIndex;
 	u32 Index;
+
+	/* Every IPI target has a single-bit mask: one lookup in the map */
+	if ((CpuMask != 0U) && ((CpuMask & (CpuMask - 1U)) == 0U)) {
+		return InstancePtr->BufferIndexMap[__builtin_ctz(CpuMask)];
+	}
+
 	/* Init Index with an invalid value */
 	BufferIndex = XIPIPSU_MAX_BUFF_INDEX + 1U;
 
-	/*Search for CPU in the List */
+	/* Search for a multi-bit mask in the List */
 	for (Index = 0U; Index < InstancePtr->Config.TargetCount; Index++) {
 		/*If we find the CPU , then set the Index and break the loop*/
 		if (InstancePtr->Config.TargetList[Index].Mask == CpuMask) {
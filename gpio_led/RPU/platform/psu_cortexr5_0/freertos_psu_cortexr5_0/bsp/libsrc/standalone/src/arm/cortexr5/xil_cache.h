@@ -24,6 +24,8 @@
 * ----- ---- -------- -----------------------------------------------
 * 5.00 	pkp  02/20/14 First release
 * 6.2   mus  01/27/17 Updated to support IAR compiler
+* 6.2   kr   10/14/26 Added inline single line and aligned range variants
+*                     without interrupt masking
 * </pre>
 *
 ******************************************************************************/
@@ -31,6 +33,7 @@
 #define XIL_CACHE_H
 
 #include "xil_types.h"
+#include "xpseudo_asm.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -97,6 +100,64 @@ void Xil_DCacheStoreLine(INTPTR adr);
 void Xil_ICacheInvalidateRange(INTPTR adr, u32 len);
 void Xil_ICacheInvalidateLine(INTPTR adr);
 
+/**
+ *@cond nocomments
+ */
+#define XIL_CACHE_LINE_SIZE	32U
+/**
+ *@endcond
+ */
+
+/*****************************************************************************/
+/**
+* @brief	Fast data cache operations for hot shared memory protocols: one
+*		line, or a range whose address and length are multiples of
+*		XIL_CACHE_LINE_SIZE. Unlike the functions above they do not mask
+*		IRQ/FIQ, select the cache level or fix up partial edge lines:
+*		each line takes one MVA-to-PoC operation, which does not depend
+*		on CSSELR and is never left half done. They are therefore safe in
+*		any context, including interrupt handlers. The caller owns the
+*		alignment: an invalidate discards the whole line of the address
+*		it is given.
+*
+* @param	adr: Address of the line or start of the range.
+* @param	len: Length of the range in bytes.
+*
+* @return	None.
+*
+****************************************************************************/
+static inline void Xil_DCacheFlushLineFast(INTPTR adr)
+{
+	asm_clean_inval_dc_line_mva_poc(adr & ~(INTPTR)(XIL_CACHE_LINE_SIZE - 1U));
+	dsb();
+}
+
+static inline void Xil_DCacheInvalidateLineFast(INTPTR adr)
+{
+	asm_inval_dc_line_mva_poc(adr & ~(INTPTR)(XIL_CACHE_LINE_SIZE - 1U));
+	dsb();
+}
+
+static inline void Xil_DCacheFlushAlignedRange(INTPTR adr, u32 len)
+{
+	INTPTR end = adr + (INTPTR)len;
+
+	for (; adr < end; adr += (INTPTR)XIL_CACHE_LINE_SIZE) {
+		asm_clean_inval_dc_line_mva_poc(adr);
+	}
+	dsb();
+}
+
+static inline void Xil_DCacheInvalidateAlignedRange(INTPTR adr, u32 len)
+{
+	INTPTR end = adr + (INTPTR)len;
+
+	for (; adr < end; adr += (INTPTR)XIL_CACHE_LINE_SIZE) {
+		asm_inval_dc_line_mva_poc(adr);
+	}
+	dsb();
+}
+
 #ifdef __cplusplus
 }
 #endif
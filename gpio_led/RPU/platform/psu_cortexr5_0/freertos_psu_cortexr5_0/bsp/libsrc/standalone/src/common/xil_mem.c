@@ -22,6 +22,8 @@
 * 			  violations.
 * 7.7	sk	 01/10/22 Include xil_mem.h header file to fix Xil_MemCpy
 * 			  prototype misra_c_2012_rule_8_4 violation.
+* 7.7	kr	 10/14/26 Copy 32-byte blocks with LDM/STM on Cortex-R5 after
+* 			  aligning the destination, byte loop for short copies.
 *
 * </pre>
 *
@@ -32,7 +34,36 @@
 #include "xil_types.h"
 #include "xil_mem.h"
 
+/************************** Constant Definitions ****************************/
+
+#if defined (ARMR5)
+#define XIL_MEMCPY_BLOCK	32U	/**< Bytes per LDM/STM pair */
+#define XIL_MEMCPY_SMALL	16U	/**< Below this, copy bytes directly */
+#endif
+
 /***************** Inline Functions Definitions ********************/
+
+#if defined (ARMR5)
+/*****************************************************************************/
+/**
+* @brief       Copies Blocks blocks of 32 bytes, one eight-register LDM/STM
+*              pair each. Both pointers must be word aligned; they are
+*              advanced past the copied data.
+*
+*****************************************************************************/
+static inline void Xil_MemCpyBlocks(char **d, const char **s, u32 Blocks)
+{
+	__asm__ __volatile__(
+		"1:	ldmia	%1!, {r3-r6, r8-r10, r12}\n"
+		"	subs	%2, %2, #1\n"
+		"	stmia	%0!, {r3-r6, r8-r10, r12}\n"
+		"	bne	1b\n"
+		: "+r" (*d), "+r" (*s), "+r" (Blocks)
+		:
+		: "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory");
+}
+#endif
+
 /*****************************************************************************/
 /**
 * @brief       This  function copies memory from once location to other.
@@ -49,6 +80,36 @@ void Xil_MemCpy(void* dst, const void* src, u32 cnt)
 	char *d = (char*)(void *)dst;
 	const char *s = src;
 
+#if defined (ARMR5)
+	if (cnt < XIL_MEMCPY_SMALL) {
+		while ((cnt) > 0U) {
+			*d = *s;
+			d += 1U;
+			s += 1U;
+			cnt -= 1U;
+		}
+		return;
+	}
+
+	/* Align the destination so that no store splits */
+	while (((UINTPTR)d & 3U) != 0U) {
+		*d = *s;
+		d += 1U;
+		s += 1U;
+		cnt -= 1U;
+	}
+
+	/*
+	 * LDM needs a word aligned source too. Otherwise the word loop below
+	 * does the bulk with unaligned loads, which the R5 supports on Normal
+	 * memory.
+	 */
+	if ((((UINTPTR)s & 3U) == 0U) && (cnt >= XIL_MEMCPY_BLOCK)) {
+		Xil_MemCpyBlocks(&d, &s, cnt / XIL_MEMCPY_BLOCK);
+		cnt %= XIL_MEMCPY_BLOCK;
+	}
+#endif
+
 	while (cnt >= sizeof (s32)) {
 		*(s32*)d = *(s32*)s;
 		d += sizeof (s32);
@@ -22,6 +22,7 @@
 
 static void padding( const s32 l_flag, const struct params_s *par);
 static void outs(const charptr lp, struct params_s *par);
+static void outconv(const char8 *p, const char8 *end, struct params_s *par);
 static s32 getnum( charptr *linep);
 
 /**************************** Type Definitions *******************************/
@@ -109,6 +110,96 @@ static void outs(const charptr lp, struct params_s *par)
 	padding( par->left_flag, par);
 }
 
+/*****************************************************************************/
+/**
+* Digit pairs "00" to "99" of the decimal conversions, so each division by
+* 100 gives two digits.
+*
+******************************************************************************/
+static const char8 digit_pairs[201] =
+	"00010203040506070809101112131415161718192021222324"
+	"25262728293031323334353637383940414243444546474849"
+	"50515253545556575859606162636465666768697071727374"
+	"75767778798081828384858687888990919293949596979899";
+
+static const char8 digits[] = "0123456789ABCDEF";
+
+/*****************************************************************************/
+/**
+* num / 100 for any 32-bit num: a multiply by the reciprocal (2^37 / 100,
+* rounded up) and a shift instead of a divide.
+*
+******************************************************************************/
+static inline u32 div100(u32 num)
+{
+	return (u32)(((u64)num * 0x51EB851FU) >> 37);
+}
+
+/*****************************************************************************/
+/**
+* This routine writes num in base 10 or 16 backwards from end and returns
+* the first character. Bases 10 and 16 take no divide instruction: pairs of
+* decimal digits from digit_pairs, hex digits by shift and mask.
+*
+******************************************************************************/
+static char8 *fmtnum(char8 *end, u32 num, const s32 base)
+{
+	char8 *p = end;
+	u32 q;
+	u32 r;
+
+	if (base == 16) {
+		do {
+			p--;
+			*p = digits[num & 0xFU];
+			num >>= 4;
+		} while (num > 0U);
+	} else if (base == 10) {
+		while (num >= 100U) {
+			q = div100(num);
+			r = num - (q * 100U);
+			p -= 2;
+			p[0] = digit_pairs[2U * r];
+			p[1] = digit_pairs[(2U * r) + 1U];
+			num = q;
+		}
+		if (num >= 10U) {
+			p -= 2;
+			p[0] = digit_pairs[2U * num];
+			p[1] = digit_pairs[(2U * num) + 1U];
+		} else {
+			p--;
+			*p = (char8)('0' + num);
+		}
+	} else {
+		do {
+			p--;
+			*p = digits[num % (u32)base];
+			num /= (u32)base;
+		} while (num > 0U);
+	}
+	return p;
+}
+
+/*****************************************************************************/
+/**
+* This routine outputs the converted number from p to end as directed by the
+* padding and positioning flags.
+*
+******************************************************************************/
+static void outconv(const char8 *p, const char8 *end, struct params_s *par)
+{
+	par->len = (s32)(end - p);
+	padding( !(par->left_flag), par);
+	while (p < end) {
+#if defined(STDOUT_BASEADDRESS) || defined(VERSAL_PLM) || defined(SDT) || defined(SPARTANUP_PLM) || defined(ASUFW)
+		outbyte( *p );
+#endif
+		p++;
+	}
+	padding( par->left_flag, par);
+}
+
 /*****************************************************************************/
 /**
 *
@@ -118,51 +209,27 @@ static void outs(const charptr lp, struct params_s *par)
 ******************************************************************************/
 static void outnum( const s32 n, const s32 base, struct params_s *par)
 {
-	s32 negative;
-	s32 i;
-	char8 outbuf[32];
-	const char8 digits[] = "0123456789ABCDEF";
+	char8 outbuf[36];
+	char8 *end = &outbuf[sizeof(outbuf)];
+	char8 *p;
 	u32 num;
-	for (i = 0; i < 32; i++) {
-		outbuf[i] = '0';
-	}
+	s32 negative;
 
 	/* Check if number is negative                   */
 	if ((par->unsigned_flag == 0) && (base == 10) && (n < 0L)) {
 		negative = 1;
-		num = (-(n));
+		num = -((u32)n);
 	} else {
-		num = n;
+		num = (u32)n;
 		negative = 0;
 	}
 
-	/* Build number (backwards) in outbuf            */
-	i = 0;
-	do {
-		outbuf[i] = digits[(num % (u32)base)];
-		i++;
-		num /= base;
-	} while (num > 0U);
-
+	p = fmtnum(end, num, base);
 	if (negative != 0) {
-		outbuf[i] = '-';
-		i++;
+		p--;
+		*p = '-';
 	}
-
-	outbuf[i] = '\0';
-	i--;
-
-	/* Move the converted number to the buffer and   */
-	/* add in the padding where needed.              */
-	par->len = (s32)strlen(outbuf);
-	padding( !(par->left_flag), par);
-	while (&outbuf[i] >= outbuf) {
-#if defined(STDOUT_BASEADDRESS) || defined(VERSAL_PLM) || defined(SDT) || defined(SPARTANUP_PLM) || defined(ASUFW)
-		outbyte( outbuf[i] );
-#endif
-		i--;
-	}
-	padding( par->left_flag, par);
+	outconv(p, end, par);
 }
 /*---------------------------------------------------*/
 /*                                                   */
@@ -171,51 +238,89 @@ static void outnum( const s32 n, const s32 base, struct params_s *par)
 /* flags. 											 */
 /*                                                   */
 #if defined (SUPPORT_64BIT_PRINT)
+/*****************************************************************************/
+/**
+* num / 10^8 for any 64-bit num without the library's 64-bit division:
+* (num >> 8) / 390625 as the high half of a multiply by the reciprocal
+* (2^74 / 390625, rounded up), built from 32 x 32 bit products.
+*
+******************************************************************************/
+static inline u64 div1e8(u64 num)
+{
+	const u64 m = 0xABCC77118461CFULL;
+	u64 n = num >> 8;
+	u64 n_lo = (u32)n;
+	u64 n_hi = n >> 32;
+	u64 m_lo = (u32)m;
+	u64 m_hi = m >> 32;
+	u64 mid1;
+	u64 mid2;
+
+	mid1 = (n_lo * m_hi) + ((n_lo * m_lo) >> 32);
+	mid2 = (n_hi * m_lo) + (u32)mid1;
+	/* High 64 bits of n * m, then the rest of the shift */
+	return ((n_hi * m_hi) + (mid1 >> 32) + (mid2 >> 32)) >> 10;
+}
+
 static void outnum1( const s64 n, const s32 base, params_t *par)
 {
+	char8 outbuf[68];
+	char8 *end = &outbuf[sizeof(outbuf)];
+	char8 *p = end;
+	u64 num;
+	u64 q;
+	u32 chunk;
+	u32 pair;
 	s32 negative;
 	s32 i;
-	char8 outbuf[64];
-	const char8 digits[] = "0123456789ABCDEF";
-	u64 num;
-	for (i = 0; i < 64; i++) {
-		outbuf[i] = '0';
-	}
 
 	/* Check if number is negative                   */
 	if ((par->unsigned_flag == 0) && (base == 10) && (n < 0L)) {
 		negative = 1;
-		num = (-(n));
+		num = -((u64)n);
 	} else {
-		num = (n);
+		num = (u64)n;
 		negative = 0;
 	}
 
-	/* Build number (backwards) in outbuf            */
-	i = 0;
-	do {
-		outbuf[i] = digits[(num % base)];
-		i++;
-		num /= (u64)base;
-	} while (num > 0U);
-
-	if (negative != 0) {
-		outbuf[i] = '-';
-		i++;
+	if (base == 16) {
+		/* Low word first, zero-filled, while the high one is not 0 */
+		if ((num >> 32) != 0U) {
+			for (i = 0; i < 8; i++) {
+				p--;
+				*p = digits[num & 0xFU];
+				num >>= 4;
+			}
+		}
+		p = fmtnum(p, (u32)num, base);
+	} else if (base == 10) {
+		/* Eight digits at a time until the rest fits 32 bits */
+		while ((num >> 32) != 0U) {
+			q = div1e8(num);
+			chunk = (u32)(num - (q * 100000000U));
+			for (i = 0; i < 4; i++) {
+				pair = chunk - (div100(chunk) * 100U);
+				chunk = div100(chunk);
+				p -= 2;
+				p[0] = digit_pairs[2U * pair];
+				p[1] = digit_pairs[(2U * pair) + 1U];
+			}
+			num = q;
+		}
+		p = fmtnum(p, (u32)num, base);
+	} else {
+		do {
+			p--;
+			*p = digits[num % (u64)base];
+			num /= (u64)base;
+		} while (num > 0U);
 	}
 
-	outbuf[i] = '\0';
-	i--;
-
-	/* Move the converted number to the buffer and   */
-	/* add in the padding where needed.              */
-	par->len = (s32)strlen(outbuf);
-	padding( !(par->left_flag), par);
-	while (&outbuf[i] >= outbuf) {
-		outbyte( outbuf[i] );
-		i--;
+	if (negative != 0) {
+		p--;
+		*p = '-';
 	}
-	padding( par->left_flag, par);
+	outconv(p, end, par);
 }
 #endif
 
@@ -21,6 +21,8 @@
 * 1.05a hk     08/22/13 Added reset function
 * 3.00  kvn    02/13/15 Modified code for MISRA-C:2012 compliance.
 * 4.00  sd     02/02/24 Added wait for transmission done function
+*		      outbyte() is weak, so an application console backend
+*		      can replace it.
 * </pre>
 *
 *****************************************************************************/
@@ -179,7 +181,7 @@ void XUartPs_WaitTransmitDone(u32 BaseAddress)
 
 #ifdef SDT
 #ifdef XPAR_STDIN_IS_UARTPS
-void outbyte(char c) {
+__attribute__((weak)) void outbyte(char c) {
          XUartPs_SendByte(STDOUT_BASEADDRESS, c);
 }
 
@@ -28,6 +28,8 @@
 *  1.3  gm	 21/07/23 Added Timer Release Callback function.
 *  2.0  ml       28/03/24 added description and removed comments to
 *                         fix doxygen warnings.
+*                         sleep(), msleep() and usleep() are weak, so an
+*                         application can supply scheduler-aware ones.
 * </pre>
 ******************************************************************************/
 
@@ -49,10 +51,10 @@ void XilTimer_Sleep(unsigned long delay, XTimer_DelayType DelayType);
 *
 * @return           none
 *
-* @note             none
+* @note             Weak: the application may replace it.
 *
 *****************************************************************************/
-void sleep(unsigned int seconds) {
+__attribute__((weak)) void sleep(unsigned int seconds) {
 	XilTimer_Sleep(seconds, XTIMER_DELAY_SEC);
 }
 
@@ -65,10 +67,10 @@ void sleep(unsigned int seconds) {
 *
 * @return           none
 *
-* @note             none
+* @note             Weak: the application may replace it.
 *
 *****************************************************************************/
-void msleep(unsigned long mseconds) {
+__attribute__((weak)) void msleep(unsigned long mseconds) {
 	XilTimer_Sleep(mseconds, XTIMER_DELAY_MSEC);
 }
 
@@ -81,10 +83,10 @@ void msleep(unsigned long mseconds) {
 *
 * @return           none
 *
-* @note             none
+* @note             Weak: the application may replace it.
 *
 *****************************************************************************/
-void usleep(unsigned long useconds) {
+__attribute__((weak)) void usleep(unsigned long useconds) {
 	XilTimer_Sleep(useconds, XTIMER_DELAY_USEC);
 }
 
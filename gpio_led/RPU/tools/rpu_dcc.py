@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Host-side decoder for the RPU log and trace sent over the debug channel
+(firmware built with RPU_LOG_DCC=1, gpio_app/src/rpu_dcc.h has the frame
+layout).
+
+Reads the DCC words, little-endian, from a capture or from stdin: the APU
+reader (apu_app/rpu_dcc) or a debugger's DCC output saved as raw words. Log
+records arrive unformatted; their format strings are read from the firmware
+ELF they were built with:
+
+    sudo ./rpu_dcc | python3 rpu_dcc.py --elf gpio_app.elf
+    python3 rpu_dcc.py --elf gpio_app.elf --file dcc.bin
+
+Sample output:
+    [log]    Wave mode 2, 1000 Hz
+    [trace]  1042  t=81234.512 us  ACK          0x00000011 0xDEADBE01
+    -- 3 log message(s) dropped, 0 trace event(s) overwritten --
+
+Without --elf a log record prints as its format address and arguments.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from rpu_telem import SYSTEM_COUNTER_HZ, TRACE_EVENTS
+
+DCC_MAGIC = 0xDC
+DCC_LOG = 1
+DCC_TRACE = 2
+DCC_DROPPED = 3
+
+# Payload words per frame type
+DCC_WORDS = {DCC_LOG: 5, DCC_TRACE: 6, DCC_DROPPED: 2}
+
+# xil_printf() conversions (flags, width, length modifiers are accepted)
+PRINTF_SPEC = re.compile(r"%([-0 +#]*)(\d*)(?:\.(\d+))?(?:l{1,2}|h{1,2})?([diuxXcsp%])")
+
+
+class Elf32:
+    """Just enough of ELF32 to read the firmware's loaded sections"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("%s: not a little-endian ELF32 file" % path)
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            sh_type, sh_flags, addr, offset, size = struct.unpack_from(
+                "<IIIII", data, shoff + i * shentsize + 4)
+            # SHT_PROGBITS, SHF_ALLOC
+            if sh_type == 1 and sh_flags & 0x2 and size:
+                self.sections.append((addr, data[offset:offset + size]))
+
+    def string(self, addr):
+        for base, blob in self.sections:
+            if base <= addr < base + len(blob):
+                end = blob.find(b"\0", addr - base)
+                if end < 0:
+                    end = len(blob)
+                return blob[addr - base:end].decode("latin-1")
+        return None
+
+
+def format_log(elf, fmt_addr, args):
+    """Format a record the way xil_printf() would on the UART"""
+    fmt = elf.string(fmt_addr) if elf else None
+    if fmt is None:
+        return "fmt 0x%08X  %s" % (fmt_addr, " ".join("0x%08X" % a for a in args))
+
+    queue = list(args)
+
+    def conv(m):
+        flags, width, prec, spec = m.groups()
+        if spec == "%":
+            return "%"
+        arg = queue.pop(0) if queue else 0
+        if spec in "di":
+            value = arg - (1 << 32) if arg & 0x80000000 else arg
+        elif spec == "c":
+            value = chr(arg & 0xFF)
+        elif spec == "s":
+            value = elf.string(arg)
+            if value is None:
+                value = "<0x%08X>" % arg
+        elif spec == "p":
+            return "0x%08x" % arg
+        else:
+            value = arg
+        py = "%" + flags + width + ("." + prec if prec else "") + ("d" if spec in "iu" else spec)
+        return py % value
+
+    return PRINTF_SPEC.sub(conv, fmt).rstrip("\r\n")
+
+
+class Decoder:
+    def __init__(self, elf=None, counter_hz=SYSTEM_COUNTER_HZ):
+        self.elf = elf
+        self.counter_hz = counter_hz
+        self.pending = b""
+        self.words = []
+        self.seq = None
+        self.trace_next = None
+        self.frames = 0
+        self.lost = 0
+        self.resync = 0
+
+    def feed(self, data):
+        data = self.pending + data
+        usable = len(data) & ~3
+        self.pending = data[usable:]
+        self.words.extend(struct.unpack("<%dI" % (usable // 4), data[:usable]))
+        self.decode()
+
+    def decode(self):
+        pos = 0
+        while pos < len(self.words):
+            header = self.words[pos]
+            ftype = (header >> 16) & 0xFF
+            count = header & 0xFF
+            if header >> 24 != DCC_MAGIC or DCC_WORDS.get(ftype) != count:
+                # Not a header: a frame cut short by a timeout, skip to the next
+                self.resync += 1
+                pos += 1
+                continue
+            if pos + 1 + count > len(self.words):
+                break
+            payload = self.words[pos + 1:pos + 1 + count]
+            # A payload word that looks like a header means this frame was cut
+            cut = next((i for i, w in enumerate(payload)
+                        if w >> 24 == DCC_MAGIC and
+                        DCC_WORDS.get((w >> 16) & 0xFF) == w & 0xFF), None)
+            if cut is not None:
+                self.resync += 1
+                pos += 1 + cut
+                continue
+            self.frame((header >> 8) & 0xFF, ftype, payload)
+            pos += 1 + count
+        del self.words[:pos]
+
+    def frame(self, seq, ftype, payload):
+        if self.seq is not None and seq != (self.seq + 1) & 0xFF:
+            lost = (seq - self.seq - 1) & 0xFF
+            self.lost += lost
+            print("-- %u frame(s) lost --" % lost)
+        self.seq = seq
+        self.frames += 1
+
+        if ftype == DCC_LOG:
+            print("[log]    %s" % format_log(self.elf, payload[0], payload[1:]))
+        elif ftype == DCC_TRACE:
+            idx, event, arg0, arg1, ts_lo, ts_hi = payload
+            if self.trace_next is not None and idx != self.trace_next:
+                if (idx - self.trace_next) & 0xFFFFFFFF >= 0x80000000:
+                    print("-- trace restarted --")
+            ts = ts_hi << 32 | ts_lo
+            print("[trace]  %-6u t=%.3f us  %-12s 0x%08X 0x%08X" % (
+                idx, ts * 1e6 / self.counter_hz,
+                TRACE_EVENTS.get(event, "UNKNOWN"), arg0, arg1))
+            self.trace_next = (idx + 1) & 0xFFFFFFFF
+        elif ftype == DCC_DROPPED:
+            print("-- %u log message(s) dropped, %u trace event(s) overwritten --" % tuple(payload))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the RPU log and trace sent over the DCC")
+    parser.add_argument("--file", help="Raw capture to decode (default: stdin)")
+    parser.add_argument("--elf", help="Firmware ELF, for the log format strings")
+    parser.add_argument("--counter-hz", type=int, default=SYSTEM_COUNTER_HZ,
+                        help="System counter frequency for the trace timestamps")
+    args = parser.parse_args()
+
+    dec = Decoder(elf=Elf32(args.elf) if args.elf else None, counter_hz=args.counter_hz)
+
+    try:
+        src = open(args.file, "rb") if args.file else sys.stdin.buffer
+        with src:
+            while True:
+                data = src.read1(4096) if hasattr(src, "read1") else src.read(4096)
+                if not data:
+                    break
+                dec.feed(data)
+                sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+    print("-- %u frame(s), %u lost, %u resync(s) --" % (dec.frames, dec.lost, dec.resync),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
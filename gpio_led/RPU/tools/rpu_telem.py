@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""
+Host-side decoder for the RPU binary telemetry (firmware built with
+RPU_UART_TELEMETRY=1, gpio_app/src/rpu_telem.h has the frame layout).
+
+Reads the RPU console from a serial port (pyserial) or from a raw capture,
+prints console text as it arrives and decodes the telemetry frames between
+the 0x00 delimiters:
+
+    python3 rpu_telem.py --port /dev/ttyUSB1 --baud 921600
+    python3 rpu_telem.py --file capture.bin --no-text
+
+Sample output:
+    [stats]  tick 12400  heap 0/0
+             Tx          #1  prio 1  Blocked     0.02%  stack 412
+    [trace]  1042  t=81234.512 us  ACK          0x00000011 0xDEADBE01
+    [queues] tick 12400  ring 0  bulk 0  log 0  console 37  trace 1043  dropped 0
+
+--raw-out saves everything received for a later --file run.
+"""
+
+import argparse
+import struct
+import sys
+
+TELEM_STATS = 1
+TELEM_TASKS = 2
+TELEM_TRACE = 3
+TELEM_QUEUES = 4
+
+# RPU_TRACE_* (common/rpu_shm.h)
+TRACE_EVENTS = {
+    1: "IPI_RX",
+    2: "CMD_START",
+    3: "RING_DRAIN",
+    4: "ACK",
+    5: "MODE",
+    6: "GPIO_WRITE",
+    7: "WAVE",
+    8: "MSG",
+    9: "MBOX",
+    10: "BULK",
+    11: "GPIO_IN",
+    12: "MPCMD",
+    13: "EDGE",
+}
+
+# eTaskState
+TASK_STATES = {0: "Running", 1: "Ready", 2: "Blocked", 3: "Suspended", 4: "Deleted"}
+
+# ZynqMP system counter (IOU_SCNTRS): CNTFRQ_EL0 on the APU, from the PS
+# configuration; override with --counter-hz
+SYSTEM_COUNTER_HZ = 100000000
+
+STATS_HDR = struct.Struct("<IIIIIB")
+STATS_TASK = struct.Struct("<IIBBBx")
+TASK_NAME = struct.Struct("<B12s")
+TRACE_HDR = struct.Struct("<IB")
+TRACE_ENTRY = struct.Struct("<BIIQ")
+QUEUES = struct.Struct("<IHHHHII")
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as prvCrc16() in rpu_telem.c"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Decode one COBS block (without delimiters); None if it is malformed"""
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            return None
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code != 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self, show_text=True, counter_hz=SYSTEM_COUNTER_HZ):
+        self.show_text = show_text
+        self.counter_hz = counter_hz
+        self.chunk = bytearray()
+        self.names = {}
+        self.seq = None
+        self.frames = 0
+        self.lost = 0
+        self.bad = 0
+        self.trace_next = None
+        self.total_prev = None
+        self.runtime_prev = {}
+
+    def feed(self, data):
+        for byte in data:
+            if byte != 0:
+                self.chunk.append(byte)
+                continue
+            if self.chunk:
+                self.handle_chunk(bytes(self.chunk))
+                self.chunk.clear()
+
+    def flush(self):
+        if self.chunk:
+            self.text(bytes(self.chunk))
+            self.chunk.clear()
+
+    def text(self, data):
+        if self.show_text:
+            sys.stdout.write(data.decode("ascii", errors="replace"))
+            sys.stdout.flush()
+
+    def handle_chunk(self, chunk):
+        # Console text never contains 0x00, so a chunk is either text or one
+        # frame; only a frame decodes with a matching CRC
+        frame = cobs_decode(chunk)
+        if frame is None or len(frame) < 4 or crc16(frame[:-2]) != struct.unpack_from("<H", frame, len(frame) - 2)[0]:
+            self.text(chunk)
+            return
+
+        ftype, seq = frame[0], frame[1]
+        if self.seq is not None and seq != (self.seq + 1) & 0xFF:
+            self.lost += (seq - self.seq - 1) & 0xFF
+            print("-- %d frame(s) lost --" % ((seq - self.seq - 1) & 0xFF))
+        self.seq = seq
+        self.frames += 1
+
+        payload = frame[2:-2]
+        try:
+            if ftype == TELEM_STATS:
+                self.stats(payload)
+            elif ftype == TELEM_TASKS:
+                self.tasks(payload)
+            elif ftype == TELEM_TRACE:
+                self.trace(payload)
+            elif ftype == TELEM_QUEUES:
+                self.queues(payload)
+            else:
+                print("[frame] unknown type %d, %d bytes" % (ftype, len(payload)))
+        except struct.error:
+            self.bad += 1
+            print("[frame] type %d: short payload (%d bytes)" % (ftype, len(payload)))
+
+    def stats(self, payload):
+        tick, total, _hz, heap, heap_min, count = STATS_HDR.unpack_from(payload)
+        print("[stats]  tick %u  heap %u/%u" % (tick, heap, heap_min))
+        elapsed = None
+        if self.total_prev is not None:
+            elapsed = (total - self.total_prev) & 0xFFFFFFFF
+        self.total_prev = total
+
+        for i in range(count):
+            runtime, stack, number, prio, state = STATS_TASK.unpack_from(
+                payload, STATS_HDR.size + i * STATS_TASK.size)
+            # CPU share over the last period, from the run time deltas
+            pct = 0.0
+            prev = self.runtime_prev.get(number)
+            if elapsed and prev is not None:
+                pct = 100.0 * ((runtime - prev) & 0xFFFFFFFF) / elapsed
+            self.runtime_prev[number] = runtime
+            print("         %-11s #%-2u prio %-2u %-10s %6.2f%%  stack %u" % (
+                self.names.get(number, "?"), number, prio,
+                TASK_STATES.get(state, str(state)), pct, stack))
+
+    def tasks(self, payload):
+        for pos in range(0, len(payload) - TASK_NAME.size + 1, TASK_NAME.size):
+            number, name = TASK_NAME.unpack_from(payload, pos)
+            self.names[number] = name.split(b"\0", 1)[0].decode("ascii", errors="replace")
+
+    def trace(self, payload):
+        first, count = TRACE_HDR.unpack_from(payload)
+        if self.trace_next is not None and first != self.trace_next:
+            if (first - self.trace_next) & 0xFFFFFFFF < 0x80000000:
+                print("-- %u trace event(s) lost --" % ((first - self.trace_next) & 0xFFFFFFFF))
+            else:
+                print("-- trace restarted --")
+        for i in range(count):
+            event, arg0, arg1, ts = TRACE_ENTRY.unpack_from(
+                payload, TRACE_HDR.size + i * TRACE_ENTRY.size)
+            print("[trace]  %-6u t=%.3f us  %-12s 0x%08X 0x%08X" % (
+                first + i, ts * 1e6 / self.counter_hz,
+                TRACE_EVENTS.get(event, "UNKNOWN"), arg0, arg1))
+        self.trace_next = (first + count) & 0xFFFFFFFF
+
+    def queues(self, payload):
+        tick, ring, bulk, log, console, trace_head, dropped = QUEUES.unpack(payload)
+        print("[queues] tick %u  ring %u  bulk %u  log %u  console %u  trace %u  dropped %u" % (
+            tick, ring, bulk, log, console, trace_head, dropped))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode RPU telemetry frames on the console UART")
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--port", help="Serial port, e.g. /dev/ttyUSB1")
+    src.add_argument("--file", help="Raw capture to decode")
+    parser.add_argument("--baud", type=int, default=921600,
+                        help="Line rate, RPU_UART_BAUD of the firmware (default 921600)")
+    parser.add_argument("--counter-hz", type=int, default=SYSTEM_COUNTER_HZ,
+                        help="System counter frequency for the trace timestamps")
+    parser.add_argument("--no-text", action="store_true", help="Do not print console text")
+    parser.add_argument("--raw-out", help="Also save the received bytes to this file")
+    args = parser.parse_args()
+
+    dec = Decoder(show_text=not args.no_text, counter_hz=args.counter_hz)
+    raw = open(args.raw_out, "wb") if args.raw_out else None
+
+    try:
+        if args.file:
+            with open(args.file, "rb") as f:
+                dec.feed(f.read())
+            dec.flush()
+        else:
+            import serial  # pyserial
+            with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+                while True:
+                    data = port.read(4096)
+                    if raw:
+                        raw.write(data)
+                    dec.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if raw:
+            raw.close()
+
+    print("-- %u frame(s), %u lost, %u malformed --" % (dec.frames, dec.lost, dec.bad),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,201 @@
+/*
+ * Register maps of the KR260 designs: the MyHDL blocks of the PL and the
+ * PS and AXI IP registers used by the RPU firmware, the kernel modules and
+ * the APU tools. Offsets are bytes from the base of the block.
+ *
+ * GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py,
+ * do not edit: change the description and run "make regmap" in myhdl/.
+ */
+
+#ifndef KR260_REGS_H
+#define KR260_REGS_H
+
+/* interrupt_gen (myhdl/PL/MyHDL/src/interrupt_gen/interrupt_gen.py) */
+#define INTERRUPT_GEN_SIZE                     0x1000U
+#define INTERRUPT_GEN_MAX_CHANNELS             16U     /* Channels of the interrupt_out variant */
+#define INTERRUPT_GEN_PERIOD1_OFFSET           0x000U  /* PERIOD of channel 0 */
+#define INTERRUPT_GEN_PERIOD2_OFFSET           0x004U  /* PERIOD of channel 1 */
+#define INTERRUPT_GEN_ISR_OFFSET               0x008U  /* Bit n: channel n pending, write 1 to clear */
+#define INTERRUPT_GEN_IER_OFFSET               0x00CU  /* Bit n: channel n enabled */
+#define INTERRUPT_GEN_TRIGGER_OFFSET           0x010U  /* Write 1 to bit n to raise channel n */
+#define INTERRUPT_GEN_COUNTER_LO_OFFSET        0x014U  /* Free-running PL clock count */
+#define INTERRUPT_GEN_COUNTER_HI_OFFSET        0x018U
+#define INTERRUPT_GEN_CHANNELS_OFFSET          0x01CU  /* Number of channels, 0 on the two-channel block */
+#define INTERRUPT_GEN_COMPARE_ARMED_OFFSET     0x020U  /* Bit n: channel n compare armed, write 1 to disarm */
+#define INTERRUPT_GEN_ISR_INTERRUPT1_SHIFT     0U
+#define INTERRUPT_GEN_ISR_INTERRUPT1_MASK      0x00000001U
+#define INTERRUPT_GEN_ISR_INTERRUPT2_SHIFT     1U
+#define INTERRUPT_GEN_ISR_INTERRUPT2_MASK      0x00000002U
+#define INTERRUPT_GEN_IER_INTERRUPT1_SHIFT     0U
+#define INTERRUPT_GEN_IER_INTERRUPT1_MASK      0x00000001U
+#define INTERRUPT_GEN_IER_INTERRUPT2_SHIFT     1U
+#define INTERRUPT_GEN_IER_INTERRUPT2_MASK      0x00000002U
+#define INTERRUPT_GEN_TRIGGER_INTERRUPT1_SHIFT 0U
+#define INTERRUPT_GEN_TRIGGER_INTERRUPT1_MASK  0x00000001U
+#define INTERRUPT_GEN_TRIGGER_INTERRUPT2_SHIFT 1U
+#define INTERRUPT_GEN_TRIGGER_INTERRUPT2_MASK  0x00000002U
+/* Bank n of 16 at INTERRUPT_GEN_CHANNEL_OFFSET(n); registers relative to it */
+#define INTERRUPT_GEN_CHANNEL_COUNT            16U
+#define INTERRUPT_GEN_CHANNEL_STRIDE           0x020U
+#define INTERRUPT_GEN_CHANNEL_OFFSET(n)        (0x080U + (n) * 0x020U)
+#define INTERRUPT_GEN_CH_PERIOD_OFFSET         0x000U  /* Clocks between events, 0 stops the channel */
+#define INTERRUPT_GEN_CH_TIMESTAMP_LO_OFFSET   0x004U  /* Counter when the ISR bit was set */
+#define INTERRUPT_GEN_CH_TIMESTAMP_HI_OFFSET   0x008U
+#define INTERRUPT_GEN_CH_EVENTS_OFFSET         0x00CU  /* Free-running 32-bit event count */
+#define INTERRUPT_GEN_CH_COALESCE_COUNT_OFFSET 0x010U  /* Events per ISR bit, 0 or 1: every event */
+#define INTERRUPT_GEN_CH_COALESCE_TIME_OFFSET  0x014U  /* Clocks from the first pending event, 0: off */
+#define INTERRUPT_GEN_CH_COMPARE_LO_OFFSET     0x018U  /* COUNTER value of a one-shot event, disarms */
+#define INTERRUPT_GEN_CH_COMPARE_HI_OFFSET     0x01CU  /* Bits 63:32 of COMPARE; a write arms it */
+
+/* pattern_out (myhdl/PL/MyHDL/src/pattern_out/pattern_out.py) */
+#define PATTERN_OUT_SIZE                 0x1000U
+#define PATTERN_OUT_CTRL_OFFSET          0x000U
+#define PATTERN_OUT_DIVIDER_OFFSET       0x004U  /* Sample period in clock cycles */
+#define PATTERN_OUT_STATUS_OFFSET        0x008U
+#define PATTERN_OUT_ISR_OFFSET           0x00CU  /* Write 1 to clear */
+#define PATTERN_OUT_IER_OFFSET           0x010U
+#define PATTERN_OUT_COUNT_OFFSET         0x014U  /* Samples output since ENABLE was set */
+#define PATTERN_OUT_UNDERRUNS_OFFSET     0x018U  /* Ticks without a sample */
+#define PATTERN_OUT_CTRL_ENABLE_SHIFT    0U
+#define PATTERN_OUT_CTRL_ENABLE_MASK     0x00000001U
+#define PATTERN_OUT_STATUS_RUNNING_SHIFT 0U
+#define PATTERN_OUT_STATUS_RUNNING_MASK  0x00000001U
+#define PATTERN_OUT_STATUS_TVALID_SHIFT  1U
+#define PATTERN_OUT_STATUS_TVALID_MASK   0x00000002U
+#define PATTERN_OUT_ISR_DONE_SHIFT       0U
+#define PATTERN_OUT_ISR_DONE_MASK        0x00000001U
+#define PATTERN_OUT_ISR_UNDERRUN_SHIFT   1U
+#define PATTERN_OUT_ISR_UNDERRUN_MASK    0x00000002U
+#define PATTERN_OUT_IER_DONE_SHIFT       0U
+#define PATTERN_OUT_IER_DONE_MASK        0x00000001U
+#define PATTERN_OUT_IER_UNDERRUN_SHIFT   1U
+#define PATTERN_OUT_IER_UNDERRUN_MASK    0x00000002U
+
+/* stream_accel (myhdl/PL/MyHDL/src/stream_accel/stream_accel.py) */
+#define STREAM_ACCEL_SIZE              0x1000U
+#define STREAM_ACCEL_CTRL_OFFSET       0x000U
+#define STREAM_ACCEL_XOR_OFFSET        0x004U  /* out = (in ^ XOR) + ADD while ENABLE is set */
+#define STREAM_ACCEL_ADD_OFFSET        0x008U
+#define STREAM_ACCEL_BEATS_OFFSET      0x00CU  /* Samples handed to the sink */
+#define STREAM_ACCEL_PACKETS_OFFSET    0x010U  /* TLASTs handed to the sink */
+#define STREAM_ACCEL_CTRL_ENABLE_SHIFT 0U
+#define STREAM_ACCEL_CTRL_ENABLE_MASK  0x00000001U
+#define STREAM_ACCEL_CTRL_CLEAR_SHIFT  1U
+#define STREAM_ACCEL_CTRL_CLEAR_MASK   0x00000002U
+
+/* pwm_seq (myhdl/PL/MyHDL/src/pwm_seq/pwm_seq.py) */
+#define PWM_SEQ_SIZE              0x1000U
+#define PWM_SEQ_MAX_CHANNELS      8U         /* Channels of the largest variant */
+#define PWM_SEQ_STEP_DUTY_MASK    0xFFFFFFU  /* Sequence entry: high clocks of the period */
+#define PWM_SEQ_STEP_HOLD_SHIFT   24U        /* Sequence entry: periods the step lasts, minus 1 */
+#define PWM_SEQ_CTRL_OFFSET       0x000U
+#define PWM_SEQ_ISR_OFFSET        0x004U     /* Bit n: sequence of channel n done, write 1 to clear */
+#define PWM_SEQ_IER_OFFSET        0x008U
+#define PWM_SEQ_CHANNELS_OFFSET   0x00CU     /* Number of channels */
+#define PWM_SEQ_SEQ_DEPTH_OFFSET  0x010U     /* Sequence entries per channel */
+#define PWM_SEQ_SEQ_ADDR_OFFSET   0x014U     /* Entry SEQ_DATA writes: channel * SEQ_DEPTH + step */
+#define PWM_SEQ_SEQ_DATA_OFFSET   0x018U     /* Write an entry at SEQ_ADDR, which then increments */
+#define PWM_SEQ_CTRL_ENABLE_SHIFT 0U
+#define PWM_SEQ_CTRL_ENABLE_MASK  0x00000001U
+/* Bank n of 8 at PWM_SEQ_CHANNEL_OFFSET(n); registers relative to it */
+#define PWM_SEQ_CHANNEL_COUNT       8U
+#define PWM_SEQ_CHANNEL_STRIDE      0x020U
+#define PWM_SEQ_CHANNEL_OFFSET(n)   (0x040U + (n) * 0x020U)
+#define PWM_SEQ_CH_PERIOD_OFFSET    0x000U  /* PL clocks per PWM period, 0 holds the pin low */
+#define PWM_SEQ_CH_DUTY_OFFSET      0x004U  /* High clocks per period without a sequence */
+#define PWM_SEQ_CH_SEQ_LEN_OFFSET   0x008U  /* Steps of the sequence; a write restarts it, 0 stops it */
+#define PWM_SEQ_CH_SEQ_LOOPS_OFFSET 0x00CU  /* Passes of the sequence, 0: until stopped */
+#define PWM_SEQ_CH_SEQ_STEP_OFFSET  0x010U  /* Step playing, bit 31 while the sequence runs */
+
+/* mailbox (myhdl/PL/MyHDL/src/mailbox/mailbox.py) */
+#define MAILBOX_SIZE                   0x1000U
+#define MAILBOX_MAX_DEPTH              1024U   /* Largest FIFO depth, in messages */
+#define MAILBOX_A2R_DATA_OFFSET        0x000U  /* APU -> RPU: write pushes, read is the oldest message */
+#define MAILBOX_A2R_POP_OFFSET         0x004U  /* Any write drops the oldest APU -> RPU message */
+#define MAILBOX_A2R_COUNT_OFFSET       0x008U  /* Messages in the APU -> RPU FIFO */
+#define MAILBOX_A2R_THRESHOLD_OFFSET   0x00CU  /* A2R_DATA pending while COUNT >= THRESHOLD (0: 1) */
+#define MAILBOX_R2A_DATA_OFFSET        0x010U  /* RPU -> APU: write pushes, read is the oldest message */
+#define MAILBOX_R2A_POP_OFFSET         0x014U  /* Any write drops the oldest RPU -> APU message */
+#define MAILBOX_R2A_COUNT_OFFSET       0x018U  /* Messages in the RPU -> APU FIFO */
+#define MAILBOX_R2A_THRESHOLD_OFFSET   0x01CU  /* R2A_DATA pending while COUNT >= THRESHOLD (0: 1) */
+#define MAILBOX_ISR_OFFSET             0x020U  /* Write 1 to clear */
+#define MAILBOX_IER_OFFSET             0x024U
+#define MAILBOX_CTRL_OFFSET            0x028U  /* Write 1 to a FLUSH bit to empty that FIFO */
+#define MAILBOX_DEPTH_OFFSET           0x02CU  /* FIFO depth in messages */
+#define MAILBOX_ISR_A2R_DATA_SHIFT     0U
+#define MAILBOX_ISR_A2R_DATA_MASK      0x00000001U
+#define MAILBOX_ISR_R2A_DATA_SHIFT     1U
+#define MAILBOX_ISR_R2A_DATA_MASK      0x00000002U
+#define MAILBOX_ISR_A2R_OVERFLOW_SHIFT 2U
+#define MAILBOX_ISR_A2R_OVERFLOW_MASK  0x00000004U
+#define MAILBOX_ISR_R2A_OVERFLOW_SHIFT 3U
+#define MAILBOX_ISR_R2A_OVERFLOW_MASK  0x00000008U
+#define MAILBOX_IER_A2R_DATA_SHIFT     0U
+#define MAILBOX_IER_A2R_DATA_MASK      0x00000001U
+#define MAILBOX_IER_R2A_DATA_SHIFT     1U
+#define MAILBOX_IER_R2A_DATA_MASK      0x00000002U
+#define MAILBOX_IER_A2R_OVERFLOW_SHIFT 2U
+#define MAILBOX_IER_A2R_OVERFLOW_MASK  0x00000004U
+#define MAILBOX_IER_R2A_OVERFLOW_SHIFT 3U
+#define MAILBOX_IER_R2A_OVERFLOW_MASK  0x00000008U
+#define MAILBOX_CTRL_FLUSH_A2R_SHIFT   0U
+#define MAILBOX_CTRL_FLUSH_A2R_MASK    0x00000001U
+#define MAILBOX_CTRL_FLUSH_R2A_SHIFT   1U
+#define MAILBOX_CTRL_FLUSH_R2A_MASK    0x00000002U
+
+/* gpio_atomic (myhdl/PL/MyHDL/src/gpio_atomic/gpio_atomic.py) */
+#define GPIO_ATOMIC_SIZE          0x1000U
+#define GPIO_ATOMIC_MAX_WIDTH     32U     /* Pins of the largest variant */
+#define GPIO_ATOMIC_DATA_OFFSET   0x000U  /* Output pins; a write replaces the bytes it strobes */
+#define GPIO_ATOMIC_SET_OFFSET    0x004U  /* Write 1 to drive a pin high */
+#define GPIO_ATOMIC_CLEAR_OFFSET  0x008U  /* Write 1 to drive a pin low */
+#define GPIO_ATOMIC_TOGGLE_OFFSET 0x00CU  /* Write 1 to invert a pin */
+#define GPIO_ATOMIC_INPUT_OFFSET  0x010U  /* Input pins, synchronised to the PL clock */
+#define GPIO_ATOMIC_WIDTH_OFFSET  0x014U  /* Number of output pins */
+
+/* Zynq UltraScale+ IPI channel (UG1087, IPI module) */
+#define IPI_SIZE        0x1000U
+#define IPI_APU_BASE    0xFF300000U  /* APU IPI channel (source of the doorbell) */
+#define IPI_TRIG_OFFSET 0x000U       /* Write target bits to raise an IPI */
+#define IPI_OBS_OFFSET  0x004U       /* Target bits still pending */
+#define IPI_ISR_OFFSET  0x010U       /* Source bits pending, write 1 to clear */
+#define IPI_IMR_OFFSET  0x014U       /* Masked source bits */
+#define IPI_IER_OFFSET  0x018U       /* Write 1 to unmask a source */
+#define IPI_IDR_OFFSET  0x01CU       /* Write 1 to mask a source */
+
+/* AXI GPIO (PG144) */
+#define AXI_GPIO_SIZE              0x1000U
+#define AXI_GPIO_DATA_OFFSET       0x000U  /* Channel 1 data */
+#define AXI_GPIO_TRI_OFFSET        0x004U  /* Channel 1 direction, 1: input */
+#define AXI_GPIO_DATA2_OFFSET      0x008U  /* Channel 2 data */
+#define AXI_GPIO_TRI2_OFFSET       0x00CU  /* Channel 2 direction, 1: input */
+#define AXI_GPIO_GIER_OFFSET       0x11CU  /* Global interrupt enable */
+#define AXI_GPIO_IP_ISR_OFFSET     0x120U  /* Channel interrupt status, write 1 to clear */
+#define AXI_GPIO_IP_IER_OFFSET     0x128U  /* Channel interrupt enable */
+#define AXI_GPIO_GIER_ENABLE_SHIFT 31U
+#define AXI_GPIO_GIER_ENABLE_MASK  0x80000000U
+#define AXI_GPIO_IP_ISR_CH1_SHIFT  0U
+#define AXI_GPIO_IP_ISR_CH1_MASK   0x00000001U
+#define AXI_GPIO_IP_ISR_CH2_SHIFT  1U
+#define AXI_GPIO_IP_ISR_CH2_MASK   0x00000002U
+#define AXI_GPIO_IP_IER_CH1_SHIFT  0U
+#define AXI_GPIO_IP_IER_CH1_MASK   0x00000001U
+#define AXI_GPIO_IP_IER_CH2_SHIFT  1U
+#define AXI_GPIO_IP_IER_CH2_MASK   0x00000002U
+
+/* AXI interrupt controller (PG099) */
+#define AXI_INTC_SIZE          0x1000U
+#define AXI_INTC_ISR_OFFSET    0x000U  /* Pending */
+#define AXI_INTC_IPR_OFFSET    0x004U  /* Pending and enabled */
+#define AXI_INTC_IER_OFFSET    0x008U
+#define AXI_INTC_IAR_OFFSET    0x00CU  /* Write 1 to acknowledge */
+#define AXI_INTC_SIE_OFFSET    0x010U  /* Write 1 to set IER bits */
+#define AXI_INTC_CIE_OFFSET    0x014U  /* Write 1 to clear IER bits */
+#define AXI_INTC_IVR_OFFSET    0x018U  /* Lowest pending and enabled input */
+#define AXI_INTC_MER_OFFSET    0x01CU
+#define AXI_INTC_MER_ME_SHIFT  0U
+#define AXI_INTC_MER_ME_MASK   0x00000001U
+#define AXI_INTC_MER_HIE_SHIFT 1U
+#define AXI_INTC_MER_HIE_MASK  0x00000002U
+
+#endif /* KR260_REGS_H */
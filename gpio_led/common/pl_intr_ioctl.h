@@ -0,0 +1,52 @@
+/*
+ * pl_intr character device interface (/dev/pl_intr)
+ *
+ * Shared between the APU kernel module (pl_intr) and user-space programs.
+ * The module services the interrupt_gen IP of the myhdl interrupt_demo
+ * design in kernel context: it takes the interrupt of the design's AXI
+ * interrupt controller, reads the event counter and timestamp of every
+ * channel that fired, clears its ISR bit and acknowledges the controller.
+ * User space only learns the totals, as often as it likes:
+ *
+ *   poll(fd) -> POLLIN                  an interrupt since this fd last read
+ *   read(fd, ch, n * sizeof(struct pl_intr_channel))
+ *                                       counters of channels 0..n-1, blocking
+ *                                       until POLLIN (-EAGAIN with O_NONBLOCK)
+ *   ioctl(fd, PL_INTR_IOC_EVENTFD, &efd)
+ *                                       signal an eventfd on every interrupt
+ *                                       of one channel (fd -1 detaches it)
+ *
+ * Counters only grow, so a reader takes the difference from its last read;
+ * several readers each keep their own position. An eventfd is incremented
+ * once per interrupt and stays attached until detached or the module goes;
+ * read() gives the events the interrupts stood for.
+ */
+
+#ifndef PL_INTR_IOCTL_H
+#define PL_INTR_IOCTL_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define PL_INTR_DEV_NAME       "pl_intr"
+#define PL_INTR_MAX_CHANNELS   16    /* INTERRUPT_GEN_MAX_CHANNELS */
+
+/* Counters of one channel (32 bytes) */
+struct pl_intr_channel {
+    __u64 events;        /* Events (period expiries, triggers) since the module loaded */
+    __u64 irqs;          /* Interrupts handled */
+    __u64 lost;          /* Events beyond the first of an interrupt: lost unless coalescing */
+    __u32 latency_last;  /* PL clocks from the event to the kernel handler */
+    __u32 latency_max;
+};
+
+/* Eventfd attachment */
+struct pl_intr_eventfd {
+    __u32 channel;
+    __s32 fd;            /* eventfd(2) descriptor, -1 to detach */
+};
+
+#define PL_INTR_IOC_MAGIC      'P'
+#define PL_INTR_IOC_EVENTFD    _IOW(PL_INTR_IOC_MAGIC, 1, struct pl_intr_eventfd)
+
+#endif /* PL_INTR_IOCTL_H */
@@ -0,0 +1,174 @@
+/*
+ * rpu_ipi character device interface (/dev/rpu_ipi, /dev/rpu_trace)
+ *
+ * Shared between the APU kernel module (rpu_ipi) and user-space programs.
+ * Commands are binary struct rpu_ipi_cmd records that the module places on
+ * the shared command ring (see rpu_shm.h) and announces with one IPI per
+ * batch:
+ *
+ *   write(fd, cmds, n * sizeof(struct rpu_ipi_cmd))   queue n commands
+ *   ioctl(fd, RPU_IPI_IOC_SUBMIT, &batch)             queue a batch, seq
+ *                                                     numbers written back
+ *   poll(fd) -> POLLIN                                completions available
+ *   read(fd, cmds, n * sizeof(struct rpu_ipi_cmd))    fetch completions
+ *
+ * Every open file is a client with its own queues: submissions go to the
+ * file's submission queue (64 commands) and the module moves
+ * them onto the ring one client at a time, round robin, with at most the
+ * module's client_inflight descriptors per client on the ring. Completions
+ * come back only to the file that submitted them, in its order. Submissions
+ * return the number of commands (write: bytes) queued, which can be less
+ * than requested when the submission queue is nearly full. With O_NONBLOCK
+ * a full submission queue or an empty completion queue returns -EAGAIN
+ * instead of sleeping.
+ *
+ *   ioctl(fd, RPU_IPI_IOC_INFLIGHT, &limit)           lower this file's share
+ *                                                     of the ring (1 to
+ *                                                     client_inflight)
+ *
+ * Zero-copy producers can instead mmap() the shared window (offset 0,
+ * SHARED_MEM_SIZE bytes, non-cached) and fill the ring themselves:
+ *
+ *   base = mmap(NULL, SHARED_MEM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+ *   ... write descriptors, publish SHM_RING_HEAD_OFFSET ...
+ *   ioctl(fd, RPU_IPI_IOC_DOORBELL)                   ring the doorbell, unless
+ *                                                     SHM_RING_STATE_OFFSET says
+ *                                                     the RPU polls (rpu_shm.h)
+ *   poll(fd) -> POLLIN                                ring drained (tail == head)
+ *
+ * Mapping needs an idle ring (-EBUSY while any client has commands queued
+ * or in flight, or another file holds the mapping). Once the window has been
+ * mapped the kernel no longer produces on the ring: write(), read() and
+ * RPU_IPI_IOC_SUBMIT of every file return -EBUSY until the mapping file is
+ * closed.
+ *
+ * Small commands with parameters can skip the ring and travel in the IPI
+ * message buffer itself; the call returns once the RPU has answered:
+ *
+ *   ioctl(fd, RPU_IPI_IOC_MSG, &msg)                  send, wait for results
+ *
+ * It returns -ETIMEDOUT if the RPU does not answer within the module's
+ * ack_timeout_ms and is not affected by a mapping of the window.
+ *
+ * When the device tree node of the module names a memory-region (e.g. the
+ * bulk carveout, APU/dts/rpu_ipi.dtso), it is mapped Normal non-cacheable at
+ * mmap() offset RPU_IPI_MMAP_REGION_OFFSET, without root and without any
+ * effect on the ring:
+ *
+ *   ioctl(fd, RPU_IPI_IOC_REGION, &region)            physical address and size
+ *                                                     (0 without a region)
+ *   mmap(NULL, region.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+ *        RPU_IPI_MMAP_REGION_OFFSET)
+ *
+ * Filling a MB-sized payload through that mapping costs the A53 an uncached
+ * store per word. When the node also names a "bulk" DMA channel (an FPD DMA
+ * channel; the LPD ones belong to the RPUs), the module copies between user
+ * memory and the region with it instead, from the user pages pinned in
+ * place, and returns once the data is there:
+ *
+ *   ioctl(fd, RPU_IPI_IOC_DMA, &dma)                  copy len bytes, -ENODEV
+ *                                                     without a region or channel
+ *
+ * The user buffer, the region offset and the length must suit the channel's
+ * alignment (RPU_IPI_DMA_ALIGN is enough for the ZynqMP DMA), else -EINVAL;
+ * the caller then falls back to the mapping. The copy does not notify the
+ * RPU: the bulk descriptor that uses the data does (rpu_shm.h).
+ *
+ * Trace stream (/dev/rpu_trace): the RPU event trace of the window
+ * (rpu_shm.h, "Trace") as a stream of struct rpu_shm_trace records, the
+ * fixed layout also for firmware that writes the compact trace:
+ *
+ *   read(fd, buf, len)                                copy records
+ *   splice(fd, NULL, pipe[1], NULL, len, 0)           move them into a pipe
+ *   sendfile(sock, fd, NULL, len)                     or to a socket
+ *
+ * The module copies new events out of the window every trace_poll_ms while
+ * the device is open, starting at the oldest one the window still holds,
+ * and buffers up to trace_pages pages of them. splice() passes those pages
+ * on by reference, so a recorder moves the trace to disk or the network
+ * without copying it through user space. Reads block until events arrive
+ * (-EAGAIN with O_NONBLOCK) and poll() reports POLLIN. Records never
+ * straddle a buffer but a short read or splice can end inside one, so
+ * consumers reassemble them from the byte stream. seq is the event index +
+ * 1: a gap is events lost (the RPU overwrote them first, or the buffer was
+ * full), a step back is a restarted or newly attached firmware. One reader
+ * at a time (-EBUSY).
+ */
+
+#ifndef RPU_IPI_IOCTL_H
+#define RPU_IPI_IOCTL_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define RPU_IPI_DEV_NAME       "rpu_ipi"
+#define RPU_TRACE_DEV_NAME     "rpu_trace"  /* Trace stream */
+
+/* One command; layout matches struct rpu_shm_desc */
+struct rpu_ipi_cmd {
+    __u32 opcode;  /* RPU_CMD_* (rpu_shm.h) */
+    __u32 arg;     /* Opcode argument (e.g. blink mode) */
+    __u32 seq;     /* Sequence number within this file's commands, assigned by the module */
+    __u32 status;  /* RPU_CMD_STATUS_*, valid in completions */
+};
+
+/* Batch submission */
+struct rpu_ipi_batch {
+    __u64 cmds;    /* User pointer to struct rpu_ipi_cmd[count] */
+    __u32 count;   /* Number of commands in cmds */
+    __u32 flags;   /* Reserved, must be 0 */
+};
+
+/* IPI message buffer command (RPU_IPI_IOC_MSG) */
+#define RPU_IPI_MSG_MAX_DATA     7
+#define RPU_IPI_MSG_MAX_RESULTS  6
+
+struct rpu_ipi_msg {
+    __u32 opcode;   /* RPU_CMD_* (rpu_shm.h) */
+    __u32 len;      /* Parameters in data, at most RPU_IPI_MSG_MAX_DATA */
+    __u32 data[RPU_IPI_MSG_MAX_DATA];
+    __u32 status;   /* RPU_CMD_STATUS_*, written back */
+    __u32 result[RPU_IPI_MSG_MAX_RESULTS];  /* Opcode results, written back */
+};
+
+/* memory-region of the device tree node (RPU_IPI_IOC_REGION) */
+struct rpu_ipi_region {
+    __u64 phys;     /* Physical address, as the RPU's DMA engine sees it */
+    __u64 size;     /* Bytes, 0 without a memory-region */
+};
+
+#define RPU_IPI_MMAP_REGION_OFFSET  0x100000U  /* mmap() offset of the memory-region */
+
+/* DMA copy between user memory and the memory-region (RPU_IPI_IOC_DMA) */
+struct rpu_ipi_dma {
+    __u64 user;     /* User pointer */
+    __u64 offset;   /* Offset in the memory-region */
+    __u64 len;      /* Bytes */
+    __u32 flags;    /* RPU_IPI_DMA_F_* */
+    __u32 reserved; /* Must be 0 */
+};
+
+#define RPU_IPI_DMA_F_READ     0x1   /* Region to user memory (default: user memory to region) */
+#define RPU_IPI_DMA_ALIGN      64    /* Alignment of user, offset and len that always works */
+
+#define RPU_IPI_IOC_MAGIC      'r'
+
+/* Queue a batch; returns the number of commands queued */
+#define RPU_IPI_IOC_SUBMIT     _IOWR(RPU_IPI_IOC_MAGIC, 1, struct rpu_ipi_batch)
+
+/* Trigger the APU->RPU0 IPI for commands written through the mapping */
+#define RPU_IPI_IOC_DOORBELL   _IO(RPU_IPI_IOC_MAGIC, 2)
+
+/* Send one command in the IPI message buffer and wait for the response */
+#define RPU_IPI_IOC_MSG        _IOWR(RPU_IPI_IOC_MAGIC, 3, struct rpu_ipi_msg)
+
+/* Ring descriptors this file may have in flight (__u32) */
+#define RPU_IPI_IOC_INFLIGHT   _IOW(RPU_IPI_IOC_MAGIC, 4, __u32)
+
+/* Where the memory-region is */
+#define RPU_IPI_IOC_REGION     _IOR(RPU_IPI_IOC_MAGIC, 5, struct rpu_ipi_region)
+
+/* Copy to or from the memory-region with the DMA channel; returns once done */
+#define RPU_IPI_IOC_DMA        _IOW(RPU_IPI_IOC_MAGIC, 6, struct rpu_ipi_dma)
+
+#endif /* RPU_IPI_IOCTL_H */
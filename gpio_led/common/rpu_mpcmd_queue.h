@@ -0,0 +1,134 @@
+/*
+ * Multi-producer command channel: queue operations
+ *
+ * Header-only, shared between the firmware (RPU0 consumer, RPU1 producer)
+ * and the APU HAL (kr260hal/mpcmd.h), on the block at MPCMD_ADDR whose
+ * layout and protocol are in rpu_shm.h. base is the mapping of the block:
+ * non-cached on both sides, as every window (rpu_ring.h for the barriers).
+ *
+ * The claim is a compare-and-swap on HEAD, built from LDREX/STREX on the R5
+ * and LDXR/STXR on the A53 (__atomic builtins, relaxed; the ordering comes
+ * from the explicit barriers around it). It is the only read-modify-write
+ * in the protocol and the only point where producers contend, so nobody
+ * spins while another one copies its entry. A claim that keeps losing to
+ * other producers gives up after RPU_MPCMD_RETRIES attempts instead of
+ * spinning without bound.
+ */
+
+#ifndef RPU_MPCMD_QUEUE_H
+#define RPU_MPCMD_QUEUE_H
+
+#include <stdint.h>
+
+#include "rpu_shm.h"
+#include "rpu_ring.h"
+
+#define RPU_MPCMD_OK             0
+#define RPU_MPCMD_FULL          -1   /* Every slot holds an unconsumed command */
+#define RPU_MPCMD_BUSY          -2   /* Lost the claim RPU_MPCMD_RETRIES times */
+#define RPU_MPCMD_RETRIES        64
+
+/* rpu_mpcmd_status() of a command whose done word was already reused */
+#define RPU_MPCMD_STATUS_UNKNOWN 0x100
+
+#define RPU_MPCMD_WORD(base, off) \
+    (*(volatile uint32_t *)((volatile uint8_t *)(base) + (off)))
+
+/*-----------------------------------------------------------*/
+/* Producers */
+
+/* Queue one command; *pos receives its position for rpu_mpcmd_status() */
+static inline int rpu_mpcmd_post(volatile void *base, uint32_t opcode, uint32_t arg,
+                                 uint32_t source, uint32_t *pos)
+{
+    volatile uint32_t *head = &RPU_MPCMD_WORD(base, MPCMD_HEAD_OFFSET);
+    uint32_t claim = *head;
+    uint32_t tries;
+    int32_t diff;
+
+    for (tries = 0; ; tries++) {
+        if (tries == RPU_MPCMD_RETRIES) {
+            return RPU_MPCMD_BUSY;
+        }
+        diff = (int32_t)(RPU_MPCMD_WORD(base, MPCMD_ENTRY(claim) + MPCMD_ENT_SEQ) - claim);
+        if (diff < 0) {
+            // The slot still holds the command of claim - MPCMD_SLOTS
+            return RPU_MPCMD_FULL;
+        }
+        if (diff > 0) {
+            // Claimed by another producer since head was read
+            claim = *head;
+            continue;
+        }
+        // On failure claim becomes the current head
+        if (__atomic_compare_exchange_n(head, &claim, claim + 1, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    // The claim before the entry writes, the entry before its sequence
+    RPU_RING_MB();
+    RPU_MPCMD_WORD(base, MPCMD_ENTRY(claim) + MPCMD_ENT_OPCODE) = opcode;
+    RPU_MPCMD_WORD(base, MPCMD_ENTRY(claim) + MPCMD_ENT_ARG) = arg;
+    RPU_MPCMD_WORD(base, MPCMD_ENTRY(claim) + MPCMD_ENT_SOURCE) = source;
+    RPU_RING_WMB();
+    RPU_MPCMD_WORD(base, MPCMD_ENTRY(claim) + MPCMD_ENT_SEQ) = claim + 1;
+    *pos = claim;
+    return RPU_MPCMD_OK;
+}
+
+/* After posting: non-zero if the consumer needs a doorbell */
+static inline int rpu_mpcmd_need_doorbell(volatile void *base)
+{
+    // The sequence write before the state read, pairing with the consumer's re-arm
+    RPU_RING_MB();
+    return SHM_RING_NEED_DOORBELL(RPU_MPCMD_WORD(base, MPCMD_STATE_OFFSET));
+}
+
+/* RPU_CMD_STATUS_* of the command at pos: PENDING until RPU0 consumed it,
+ * RPU_MPCMD_STATUS_UNKNOWN if its done word was already reused */
+static inline uint32_t rpu_mpcmd_status(volatile void *base, uint32_t pos)
+{
+    uint32_t tail = RPU_MPCMD_WORD(base, MPCMD_TAIL_OFFSET);
+    uint32_t done;
+
+    // The consumer writes the done word before it advances tail
+    RPU_RING_RMB();
+    done = RPU_MPCMD_WORD(base, MPCMD_DONE_WORD(pos));
+    if (MPCMD_DONE_MATCH(done, pos)) {
+        return MPCMD_DONE_STATUS(done);
+    }
+    return (int32_t)(tail - pos) > 0 ? RPU_MPCMD_STATUS_UNKNOWN : RPU_CMD_STATUS_PENDING;
+}
+
+/*-----------------------------------------------------------*/
+/* Consumer */
+
+/* Command at tail, if it is published: returns 1 and its fields */
+static inline int rpu_mpcmd_peek(volatile void *base, uint32_t tail, uint32_t *opcode,
+                                 uint32_t *arg, uint32_t *source)
+{
+    if (RPU_MPCMD_WORD(base, MPCMD_ENTRY(tail) + MPCMD_ENT_SEQ) != tail + 1) {
+        return 0;
+    }
+    // Entry reads after the sequence
+    RPU_RING_RMB();
+    *opcode = RPU_MPCMD_WORD(base, MPCMD_ENTRY(tail) + MPCMD_ENT_OPCODE);
+    *arg = RPU_MPCMD_WORD(base, MPCMD_ENTRY(tail) + MPCMD_ENT_ARG);
+    *source = RPU_MPCMD_WORD(base, MPCMD_ENTRY(tail) + MPCMD_ENT_SOURCE);
+    return 1;
+}
+
+/* Complete the command at tail and free its slot; returns the new tail */
+static inline uint32_t rpu_mpcmd_complete(volatile void *base, uint32_t tail, uint32_t status)
+{
+    RPU_MPCMD_WORD(base, MPCMD_DONE_WORD(tail)) = MPCMD_DONE(tail, status);
+    // Entry reads and done word before the slot goes back to the producers
+    RPU_RING_MB();
+    RPU_MPCMD_WORD(base, MPCMD_ENTRY(tail) + MPCMD_ENT_SEQ) = tail + MPCMD_SLOTS;
+    RPU_MPCMD_WORD(base, MPCMD_TAIL_OFFSET) = tail + 1;
+    return tail + 1;
+}
+
+#endif /* RPU_MPCMD_QUEUE_H */
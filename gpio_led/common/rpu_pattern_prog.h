@@ -0,0 +1,67 @@
+/*
+ * LED pattern programs (shared by the RPU firmware and the APU tools)
+ *
+ * A pattern is a short program of 32-bit instructions that the RPU's blink
+ * task interprets (gpio_app/src/rpu_pattern.h), so new blink sequences need
+ * no firmware rebuild and run without any APU traffic per step. The APU
+ * assembles it (kr260hal/pattern.h), writes the words into the waveform
+ * sample area of the shared window with their number in the waveform count
+ * word, and sends RPU_CMD_PATTERN with RPU_PATTERN_START on the ring. As for
+ * waveforms, the RPU validates and copies the program before it completes
+ * the descriptor, so the area may be rewritten once the status is
+ * RPU_CMD_STATUS_OK. RPU_PATTERN_STOP, or any RPU_CMD_SET_MODE, ends it.
+ *
+ * Instructions: opcode in 31:28, operand in 27:0.
+ *
+ *   END               stop; the blink mode in force before the start resumes
+ *   SET value         LEDs = value
+ *   TOGGLE mask       LEDs ^= mask
+ *   WAIT ms           hold the LEDs for ms (at least one RTOS tick)
+ *   LOOP count, pc    jump back to instruction pc until the instructions
+ *                     from pc ran count times; count 0 loops forever
+ *   RAND mask         LEDs = random value & mask
+ *
+ * Each WAIT closes one frame: the LEDs show the value set last, on the blink
+ * task's absolute deadlines, for that long. LOOP must jump backwards; a
+ * program that runs RPU_PATTERN_STEP_LIMIT instructions without a WAIT is
+ * stopped as a runaway. Zeroed words are END.
+ */
+
+#ifndef RPU_PATTERN_PROG_H
+#define RPU_PATTERN_PROG_H
+
+#include <stdint.h>
+
+#include "rpu_shm.h"
+
+/* RPU_CMD_PATTERN arguments */
+#define RPU_PATTERN_STOP        0
+#define RPU_PATTERN_START       1
+
+/* Blink mode RPU_CMD_QUERY reports while a program runs */
+#define RPU_PATTERN_MODE        3
+
+/* Opcodes */
+#define RPU_PAT_END             0
+#define RPU_PAT_SET             1
+#define RPU_PAT_TOGGLE          2
+#define RPU_PAT_WAIT            3
+#define RPU_PAT_LOOP            4
+#define RPU_PAT_RAND            5
+
+#define RPU_PAT_INSN(op, operand)   ((((uint32_t)(op) & 0xF) << 28) | ((uint32_t)(operand) & 0x0FFFFFFF))
+#define RPU_PAT_LOOP_INSN(count, pc) RPU_PAT_INSN(RPU_PAT_LOOP, (((uint32_t)(count) & 0xFFF) << 16) | \
+                                                                ((uint32_t)(pc) & 0xFFFF))
+#define RPU_PAT_OP(insn)            ((insn) >> 28)
+#define RPU_PAT_OPERAND(insn)       ((insn) & 0x0FFFFFFF)
+#define RPU_PAT_LOOP_COUNT(insn)    (((insn) >> 16) & 0xFFF)
+#define RPU_PAT_LOOP_PC(insn)       ((insn) & 0xFFFF)
+
+/* Limits */
+#define RPU_PAT_MAX_WORDS       SHM_WAVE_MAX_SAMPLES
+#define RPU_PAT_MAX_LOOP        0xFFF
+#define RPU_PAT_MAX_WAIT_MS     60000
+#define RPU_PAT_VALUE_MASK      0xFFFF
+#define RPU_PATTERN_STEP_LIMIT  256
+
+#endif /* RPU_PATTERN_PROG_H */
@@ -0,0 +1,406 @@
+/*
+ * Single-producer / single-consumer ring in shared memory
+ *
+ * Header-only, shared between the RPU firmware (C, ARMv7-R) and the APU
+ * user-space applications (C++, ARMv8-A), for new channels between two
+ * agents that see the same memory: APU <-> RPU through OCM or a DDR
+ * carveout, or two tasks or threads on one side. The existing command and
+ * bulk rings of rpu_shm.h keep their own layouts.
+ *
+ * A ring is one contiguous block: a control area of three lines (geometry,
+ * head, tail), each on its own RPU_RING_LINE so producer and consumer
+ * never write the same line, followed by the slots:
+ *
+ *   0x00  Geometry          (owner writes once: slot count, size, flags)
+ *   0x40  Head              (producer writes)
+ *   0x80  Tail, event index (consumer writes)
+ *   0xC0  Slots             (slot count x slot size, producer writes)
+ *
+ * The owner formats the block with rpu_ring_format() before either side
+ * attaches; each side then keeps a rpu_ring_t handle of its own. Indices are
+ * free-running 32-bit counters and the slot count a power of two, as in the
+ * command ring. Each handle caches the peer's index and reads it from shared
+ * memory only when the cached value says the ring is full (producer) or
+ * empty (consumer), so a batch costs one uncached read and one write of an
+ * index per side.
+ *
+ * Slots are copied in 32-bit words, never with memcpy(): the APU maps the
+ * windows as Device memory, where the unaligned and DC ZVA accesses of the
+ * library routines fault. The zero-copy calls leave the copy to the caller:
+ * rpu_ring_reserve() lends the producer a run of contiguous free slots to
+ * write or DMA into before rpu_ring_commit(), rpu_ring_peek() the consumer a
+ * run of contiguous entries to read in place before rpu_ring_release();
+ * rpu_ring_slot() addresses any single slot. A run ends at the end of the
+ * slot array, so a wrapped batch takes two calls.
+ *
+ * Barriers: the windows are uncached on both sides (rpu_shm.h, "Memory
+ * attributes"), so ordering is all that is needed, and it has to hold
+ * for an observer outside the A53 inner shareable domain: the A53 uses
+ * outer shareable DMBs, the R5 a full-system DMB. A producer publishes head
+ * only after the slot writes (write barrier); a consumer reads slots only
+ * after head (read barrier) and frees them with tail only after its slot
+ * reads (full barrier).
+ *
+ * Doorbell coalescing (RPU_RING_F_EVENT): the consumer writes, before it
+ * sleeps, the index it has consumed up to into the event word
+ * (rpu_ring_arm()); rpu_ring_commit() then asks for a doorbell only for the
+ * batch that crosses that index, the scheme of the virtio event index. A
+ * consumer that is still draining is not interrupted again. Without the
+ * flag every non-empty commit asks for a doorbell. rpu_ring_arm() returns
+ * the entries that arrived meanwhile, so the consumer only sleeps on an
+ * empty ring.
+ *
+ *   Producer:                             Consumer:
+ *     n = rpu_ring_push(&r, items, k);      for (;;) {
+ *     if (rpu_ring_commit(&r, n))               while ((n = rpu_ring_pop(&r, buf, k)) != 0)
+ *         ring_doorbell();                          handle(buf, n);
+ *                                               if (rpu_ring_arm(&r) == 0)
+ *                                                   wait_doorbell();
+ *                                           }
+ *
+ * rpu_ring_push() only fills slots; rpu_ring_commit() publishes them, so
+ * several pushes can go out behind one head write and one doorbell.
+ *
+ * Integrity check (RPU_RING_F_CRC): the last word of every slot carries the
+ * CRC32C of the others (rpu_crc32c.h; the A53 instructions on the APU, a
+ * table on the R5). rpu_ring_push() writes it in place of the item's last
+ * word; rpu_ring_pop() checks it and hands the item over with a last word of
+ * 0 when it matched and 1 when not, counting the misses in crc_errors. The
+ * zero-copy calls leave it to the caller: rpu_ring_seal() before the commit,
+ * rpu_ring_check() before the release. It costs a word per slot and a pass
+ * over each slot on both sides, so it is meant for payloads that cross a
+ * DDR or PL path, not for the command words of the OCM rings.
+ */
+
+#ifndef RPU_RING_H
+#define RPU_RING_H
+
+#include <stdint.h>
+
+#include "rpu_crc32c.h"
+
+#define RPU_RING_MAGIC     0x524E4731U   /* "RNG1" */
+#define RPU_RING_LINE      64U           /* A53 cache line; two R5 lines */
+
+/* Geometry flags */
+#define RPU_RING_F_EVENT   (1U << 0)     /* Doorbell coalescing with the event index */
+#define RPU_RING_F_CRC     (1U << 1)     /* CRC32C in the last word of each slot */
+
+/* Handle roles */
+#define RPU_RING_PRODUCER  0
+#define RPU_RING_CONSUMER  1
+
+#define RPU_RING_WORDS_PER_LINE (RPU_RING_LINE / 4U)
+
+struct rpu_ring_ctrl {
+    /* 0x00: geometry, written by the owner before either side attaches */
+    uint32_t magic;
+    uint32_t slots;          /* Power of two */
+    uint32_t slot_size;      /* Bytes, multiple of 4 */
+    uint32_t flags;          /* RPU_RING_F_* */
+    uint32_t geo_pad[RPU_RING_WORDS_PER_LINE - 4];
+    /* 0x40: producer */
+    uint32_t head;
+    uint32_t head_pad[RPU_RING_WORDS_PER_LINE - 1];
+    /* 0x80: consumer */
+    uint32_t tail;
+    uint32_t event;          /* Doorbell once head passes this index */
+    uint32_t tail_pad[RPU_RING_WORDS_PER_LINE - 2];
+};
+
+/* Bytes of a ring block, control area included */
+#define RPU_RING_BYTES(slots, slot_size) \
+    (sizeof(struct rpu_ring_ctrl) + (uint32_t)(slots) * (uint32_t)(slot_size))
+
+typedef struct {
+    volatile struct rpu_ring_ctrl *ctrl;
+    volatile uint32_t *slot_base;
+    uint32_t mask;
+    uint32_t words;          /* Per slot */
+    uint32_t flags;
+    uint32_t pos;            /* Own index: head for a producer, tail for a consumer */
+    uint32_t peer;           /* Last index read from the other side */
+    uint32_t crc_errors;     /* RPU_RING_F_CRC: entries popped with a bad CRC */
+    int role;
+} rpu_ring_t;
+
+#if defined(__aarch64__)
+#define RPU_RING_MB()      __asm__ volatile ("dmb osh" ::: "memory")
+#define RPU_RING_WMB()     __asm__ volatile ("dmb oshst" ::: "memory")
+#define RPU_RING_RMB()     __asm__ volatile ("dmb oshld" ::: "memory")
+#elif defined(__arm__)
+#define RPU_RING_MB()      __asm__ volatile ("dmb" ::: "memory")
+#define RPU_RING_WMB()     RPU_RING_MB()
+#define RPU_RING_RMB()     RPU_RING_MB()
+#else
+#define RPU_RING_MB()      __sync_synchronize()
+#define RPU_RING_WMB()     RPU_RING_MB()
+#define RPU_RING_RMB()     RPU_RING_MB()
+#endif
+
+/* Format a ring block of RPU_RING_BYTES(slots, slot_size) at base; returns
+ * -1 if slots is not a power of two or slot_size not a multiple of 4 (of at
+ * least 8 with RPU_RING_F_CRC) */
+static inline int rpu_ring_format(volatile void *base, uint32_t slots, uint32_t slot_size,
+                                  uint32_t flags)
+{
+    volatile struct rpu_ring_ctrl *ctrl = (volatile struct rpu_ring_ctrl *)base;
+
+    if (slots == 0 || (slots & (slots - 1)) != 0 || slot_size == 0 || (slot_size & 3U) != 0 ||
+        ((flags & RPU_RING_F_CRC) != 0 && slot_size < 8U)) {
+        return -1;
+    }
+    ctrl->magic = 0;
+    RPU_RING_MB();
+    ctrl->slots = slots;
+    ctrl->slot_size = slot_size;
+    ctrl->flags = flags;
+    ctrl->head = 0;
+    ctrl->tail = 0;
+    ctrl->event = 0;
+    RPU_RING_WMB();
+    // Magic last: a peer attaching meanwhile sees an unformatted ring
+    ctrl->magic = RPU_RING_MAGIC;
+    RPU_RING_MB();
+    return 0;
+}
+
+/* Attach a handle to a formatted ring block; returns -1 if it is not one */
+static inline int rpu_ring_attach(rpu_ring_t *r, volatile void *base, int role)
+{
+    volatile struct rpu_ring_ctrl *ctrl = (volatile struct rpu_ring_ctrl *)base;
+    uint32_t slots;
+
+    if (ctrl->magic != RPU_RING_MAGIC) {
+        return -1;
+    }
+    RPU_RING_RMB();
+    slots = ctrl->slots;
+    if (slots == 0 || (slots & (slots - 1)) != 0 || (ctrl->slot_size & 3U) != 0 ||
+        ((ctrl->flags & RPU_RING_F_CRC) != 0 && ctrl->slot_size < 8U)) {
+        return -1;
+    }
+    r->ctrl = ctrl;
+    r->slot_base = (volatile uint32_t *)((volatile uint8_t *)base + sizeof(struct rpu_ring_ctrl));
+    r->mask = slots - 1;
+    r->words = ctrl->slot_size / 4U;
+    r->flags = ctrl->flags;
+    r->crc_errors = 0;
+    r->role = role;
+    if (role == RPU_RING_PRODUCER) {
+        r->pos = ctrl->head;
+        r->peer = ctrl->tail;
+    } else {
+        r->pos = ctrl->tail;
+        r->peer = ctrl->head;
+    }
+    RPU_RING_MB();
+    return 0;
+}
+
+/* Slot i past the own index: the next free slot for a producer, the next
+ * entry for a consumer */
+static inline volatile uint32_t *rpu_ring_slot(const rpu_ring_t *r, uint32_t i)
+{
+    return r->slot_base + ((r->pos + i) & r->mask) * r->words;
+}
+
+/* RPU_RING_F_CRC: store the CRC32C of a filled slot in its last word */
+static inline void rpu_ring_seal(const rpu_ring_t *r, volatile uint32_t *slot)
+{
+    slot[r->words - 1] = rpu_crc32c_words(slot, r->words - 1);
+}
+
+/* RPU_RING_F_CRC: non-zero if the last word of an entry is the CRC32C of
+ * the others */
+static inline int rpu_ring_check(const rpu_ring_t *r, const volatile uint32_t *slot)
+{
+    return slot[r->words - 1] == rpu_crc32c_words(slot, r->words - 1);
+}
+
+/*-----------------------------------------------------------*/
+/* Producer */
+
+/* Free slots, re-reading tail when fewer than want are known to be free */
+static inline uint32_t rpu_ring_space(rpu_ring_t *r, uint32_t want)
+{
+    uint32_t space = r->mask + 1 - (r->pos - r->peer);
+
+    if (space < want) {
+        r->peer = r->ctrl->tail;
+        // Slot writes after the tail read: the consumer is done with them
+        RPU_RING_MB();
+        space = r->mask + 1 - (r->pos - r->peer);
+    }
+    return space;
+}
+
+/* Copy up to n items of slot_size bytes into free slots without publishing
+ * them; returns the number copied. Slots filled but not committed are
+ * overwritten by the next push, so commit the count returned before that.
+ * With RPU_RING_F_CRC the last word of each item is replaced by the CRC. */
+static inline uint32_t rpu_ring_push(rpu_ring_t *r, const void *items, uint32_t n)
+{
+    const uint32_t *src = (const uint32_t *)items;
+    uint32_t space = rpu_ring_space(r, n);
+    uint32_t i, w;
+
+    if (n > space) {
+        n = space;
+    }
+    for (i = 0; i < n; i++) {
+        volatile uint32_t *slot = rpu_ring_slot(r, i);
+
+        if (r->flags & RPU_RING_F_CRC) {
+            // Computed on the source, not read back from the slot
+            uint32_t crc = RPU_CRC32C_INIT;
+
+            for (w = 0; w < r->words - 1; w++) {
+                crc = rpu_crc32c_word(crc, *src);
+                slot[w] = *src++;
+            }
+            slot[w] = rpu_crc32c_final(crc);
+            src++;
+            continue;
+        }
+        for (w = 0; w < r->words; w++) {
+            slot[w] = *src++;
+        }
+    }
+    return n;
+}
+
+/* Lend up to want contiguous free slots, from the next one to the end of the
+ * slot array, at *slot; returns how many (0: full). Fill any prefix of them,
+ * by CPU or DMA (complete before the commit), and rpu_ring_commit() it. */
+static inline uint32_t rpu_ring_reserve(rpu_ring_t *r, uint32_t want, volatile uint32_t **slot)
+{
+    uint32_t to_end = r->mask + 1 - (r->pos & r->mask);
+    uint32_t n = rpu_ring_space(r, want);
+
+    if (n > want) {
+        n = want;
+    }
+    if (n > to_end) {
+        n = to_end;
+    }
+    *slot = rpu_ring_slot(r, 0);
+    return n;
+}
+
+/* Publish n filled slots; returns non-zero if the consumer needs a doorbell */
+static inline int rpu_ring_commit(rpu_ring_t *r, uint32_t n)
+{
+    uint32_t old = r->pos;
+    uint32_t event;
+
+    if (n == 0) {
+        return 0;
+    }
+    r->pos += n;
+    RPU_RING_WMB();
+    r->ctrl->head = r->pos;
+    if ((r->flags & RPU_RING_F_EVENT) == 0) {
+        return 1;
+    }
+    // The head write before the event read, or both sides may skip the doorbell
+    RPU_RING_MB();
+    event = r->ctrl->event;
+    return (uint32_t)(r->pos - event - 1U) < (uint32_t)(r->pos - old);
+}
+
+/*-----------------------------------------------------------*/
+/* Consumer */
+
+/* Entries ready, re-reading head when the cached value shows none */
+static inline uint32_t rpu_ring_avail(rpu_ring_t *r)
+{
+    uint32_t avail = r->peer - r->pos;
+
+    if (avail == 0) {
+        r->peer = r->ctrl->head;
+        // Slot reads after the head read
+        RPU_RING_RMB();
+        avail = r->peer - r->pos;
+    }
+    return avail;
+}
+
+/* Free n consumed entries */
+static inline void rpu_ring_release(rpu_ring_t *r, uint32_t n)
+{
+    if (n == 0) {
+        return;
+    }
+    // Slot reads complete before the producer may reuse the slots
+    RPU_RING_MB();
+    r->pos += n;
+    r->ctrl->tail = r->pos;
+}
+
+/* Copy up to max entries to items and free their slots; returns the count.
+ * With RPU_RING_F_CRC the last word of each item is 0 if its CRC matched,
+ * 1 if not. */
+static inline uint32_t rpu_ring_pop(rpu_ring_t *r, void *items, uint32_t max)
+{
+    uint32_t *dst = (uint32_t *)items;
+    uint32_t n = rpu_ring_avail(r);
+    uint32_t i, w;
+
+    if (n > max) {
+        n = max;
+    }
+    for (i = 0; i < n; i++) {
+        const volatile uint32_t *slot = rpu_ring_slot(r, i);
+
+        if (r->flags & RPU_RING_F_CRC) {
+            // One read of each word: the CRC covers what the caller gets
+            uint32_t crc = RPU_CRC32C_INIT;
+
+            for (w = 0; w < r->words - 1; w++) {
+                *dst = slot[w];
+                crc = rpu_crc32c_word(crc, *dst++);
+            }
+            *dst = (slot[w] == rpu_crc32c_final(crc)) ? 0U : 1U;
+            r->crc_errors += *dst++;
+            continue;
+        }
+        for (w = 0; w < r->words; w++) {
+            *dst++ = slot[w];
+        }
+    }
+    rpu_ring_release(r, n);
+    return n;
+}
+
+/* Lend up to max contiguous entries, from the next one to the end of the
+ * slot array, at *slot; returns how many (0: empty). Read them in place and
+ * rpu_ring_release() those done with. */
+static inline uint32_t rpu_ring_peek(rpu_ring_t *r, uint32_t max, const volatile uint32_t **slot)
+{
+    uint32_t to_end = r->mask + 1 - (r->pos & r->mask);
+    uint32_t n = rpu_ring_avail(r);
+
+    if (n > max) {
+        n = max;
+    }
+    if (n > to_end) {
+        n = to_end;
+    }
+    *slot = rpu_ring_slot(r, 0);
+    return n;
+}
+
+/* Ask for a doorbell on the next commit before sleeping; returns the entries
+ * that are already there, in which case the consumer must not sleep */
+static inline uint32_t rpu_ring_arm(rpu_ring_t *r)
+{
+    r->ctrl->event = r->pos;
+    // The event write before the head read, pairing with rpu_ring_commit()
+    RPU_RING_MB();
+    r->peer = r->ctrl->head;
+    RPU_RING_RMB();
+    return r->peer - r->pos;
+}
+
+#endif /* RPU_RING_H */
@@ -0,0 +1,1468 @@
+/*
+ * APU <-> RPU shared memory protocol
+ *
+ * Shared between the RPU firmware (gpio_app), the APU kernel module (rpu_ipi)
+ * and the APU user-space applications so the layout of the 4 KB OCM window
+ * at SHARED_MEM_ADDR is defined in a single place.
+ *
+ * The window is the ZynqMP IPI message RAM: one 512-byte group per source
+ * agent, with a 32-byte request and a 32-byte response buffer per target.
+ * The APU -> RPU0 pair at 0x400 is used as such by the message path below;
+ * the rest of the window is plain shared memory.
+ *
+ * With the R5s in split mode RPU1 runs a second firmware build (RPU_CORE=1)
+ * with the same layout in its own window, SHARED_MEM_ADDR_RPU1 in OCM. Its
+ * message path uses the APU -> RPU1 pair of the IPI message RAM, at 0x440
+ * of the RPU0 window (SHM_IPI_REQ_ADDR(1)), as the hardware defines it.
+ *
+ * Window layout:
+ *   0x000  Legacy CMD word  (APU writes, RPU reads)
+ *   0x004  Legacy ACK word  (RPU writes, APU reads)
+ *   0x008  Legacy SEQ word  (APU writes, RPU reads)
+ *   0x00C  Legacy ACK_SEQ   (RPU writes, APU reads)
+ *   0x010  APU flags        (APU writes, RPU reads)
+ *   0x014  ABI request      (APU writes) - features asked for, and its seq
+ *   0x028  Ready word       (RPU writes) - boot done, ABI version and features
+ *   0x040  Ring head        (APU writes) - own cache line
+ *   0x080  Ring tail        (RPU writes) - own cache line
+ *   0x084  Ring state       (RPU writes) - doorbell moderation
+ *   0x088  Ring credit      (RPU writes) - flow control: index limit, rate
+ *   0x090  Status block     (RPU writes) - mode, LEDs, counters, seqlock
+ *   0x0C0  ABI header       (RPU writes) - own cache line
+ *   0x100  Ring descriptors (SHM_RING_SLOTS x 16 bytes)
+ *   0x300  Urgent ring head (APU writes) - own cache line
+ *   0x340  Urgent ring tail (RPU writes) - own cache line
+ *   0x380  Urgent ring descriptors (SHM_URING_SLOTS x 16 bytes)
+ *   0x400  IPI request buffer, APU -> RPU0 (APU writes)
+ *   0x420  IPI response buffer, RPU0 -> APU (RPU writes)
+ *   0x440  IPI request/response buffers, APU <-> RPU1 (RPU0 window only)
+ *   0x500  Waveform header  (APU writes, RPU writes state)
+ *   0x540  Waveform samples (SHM_WAVE_MAX_SAMPLES x 4 bytes, APU writes)
+ *   0x800  Trace header     (RPU writes, APU reads)
+ *   0x840  Trace entries    (SHM_TRACE_SLOTS x 24 bytes, or SHM_TRACEZ_BLOCKS
+ *          compact blocks)
+ *   0xE40  Task stats header (RPU writes, APU reads)
+ *   0xE60  Task stats entries (SHM_STATS_MAX_TASKS x 24 bytes)
+ *   0xFE0  Time base        (RPU writes the frequency, APU the clock offset)
+ *
+ * Legacy path: the APU writes CMD, then publishes a new sequence number in
+ * SEQ and rings the IPI doorbell. The RPU processes CMD while SEQ differs
+ * from ACK_SEQ, then echoes SEQ into ACK_SEQ and writes ACK. A waiter matches
+ * ACK_SEQ against its own sequence number, so a late ACK for an earlier
+ * command can never satisfy it and no clear-then-wait settling is needed.
+ * Senders that predate SEQ clear ACK instead; the RPU also treats ACK == 0
+ * as a pending command, and ring doorbells never replay a stale CMD.
+ * When the APU sets SHM_APU_FLAG_ACK_IRQ the RPU follows every legacy ACK
+ * and every drained ring batch with an IPI back to the APU channel.
+ * SHM_APU_FLAG_ECHO turns the firmware into an echo server for latency
+ * measurements: legacy commands are acknowledged without changing the blink
+ * mode, and no command is logged to the UART. RPU_CMD_NOP echoes its message
+ * parameters in any case.
+ *
+ * ABI header: the RPU publishes at boot, in a cache line only it writes,
+ * the version of this layout (SHM_ABI_VERSION, major 16 bits: incompatible
+ * change, minor: additions) and the SHM_FEAT_* fast paths this build
+ * serves, then the magic. A client asks for features by writing them to
+ * the ABI request word and a new sequence number after it, then rings the
+ * doorbell; the IPI task adds the requested features it offers to the
+ * active set and echoes the sequence number (grant seq). Features are only
+ * ever added, so clients sharing a window cannot take one away from each
+ * other; a new image sets them again from the request word left in the
+ * window. A client uses a feature that changes the protocol
+ * (SHM_FEAT_ACK_LINE) only once it is active, and any other only if it is
+ * offered; firmware without the magic serves SHM_ABI_V0_FEATURES.
+ * With SHM_FEAT_ACK_LINE active the RPU also writes the legacy ACK_SEQ and
+ * ACK words into the ABI line, so a waiter polls a line the RPU owns rather
+ * than the one it writes CMD and SEQ to; the words at 0x004/0x00C are still
+ * written for senders that never asked.
+ *
+ * Ring path: single producer (APU) / single consumer (RPU). The producer
+ * fills descriptors at head, publishes the new head and rings the doorbell
+ * once for the whole batch. The consumer drains every descriptor up to head,
+ * writes the per-descriptor status and advances tail. Indices are free-running
+ * 32-bit counters; the slot is (index & SHM_RING_MASK).
+ * Doorbell moderation: the RPU's first doorbell interrupt masks the IPI, and
+ * the RPU keeps polling, clearing the IPI status on each pass, until a pass
+ * finds nothing new; only then does it unmask the doorbell again. While it
+ * polls, the ring state word reads SHM_RING_STATE_POLLING and a producer
+ * skips the doorbell after publishing head (SHM_RING_NEED_DOORBELL). Each
+ * side writes its own word (head, state) before reading the other's, with a
+ * full barrier in between, so a batch is never left without a doorbell and
+ * an idle consumer. Any other state value, including that of firmware that
+ * predates the word, asks for a doorbell on every batch.
+ *
+ * Ring credits (SHM_FEAT_CREDIT): the tail says which slots are free, not
+ * how fast the RPU frees them, so without credits a producer under overload
+ * fills the ring, waits and finally times out. With credits the RPU
+ * publishes, after each batch it drained, the ring index up to which a
+ * producer may fill (credit limit, never less than tail +
+ * SHM_CREDIT_MIN_SLOTS, never more than tail + SHM_RING_SLOTS) and the
+ * rate it served descriptors at recently (commands per second, 0 until
+ * measured). The consumer sizes the window to what it can serve within its
+ * latency budget, so queued commands wait at most about that long; a
+ * producer publishes no head beyond the limit and keeps the rest of a
+ * batch to itself until more credit comes, to be sent together. The limit
+ * is written after the tail, in the same line; a producer that reads it
+ * stale sees fewer credits, never more than the free slots.
+ *
+ * Urgent ring (SHM_FEAT_URGENT): a second, small ring of the same
+ * descriptors for control commands (a mode change, an override) that must
+ * not wait behind a full command ring. Its head, tail and descriptors work
+ * as on the command ring and it shares the ring state word, so one doorbell
+ * rule covers both. The IPI task drains it at the start of every pass and,
+ * while it drains the command ring, before each command descriptor, so an
+ * urgent command waits for at most one normal command, never for a batch.
+ * It publishes the urgent tail and raises the reverse IPI (under
+ * SHM_APU_FLAG_ACK_IRQ) as soon as the urgent entries are done. Bulk
+ * descriptors run in a task below the IPI task, which preempts them.
+ * RPU_CMD_AT is refused there (RPU_CMD_STATUS_BADOP): timed commands go
+ * through the command ring.
+ *
+ * Message path: one command with up to SHM_IPI_MSG_DATA_WORDS parameters in
+ * the IPI request buffer, answered in the response buffer (XIpiPsu_ReadMessage
+ * and XIpiPsu_WriteMessage on the RPU). The APU writes the parameters, then
+ * the header (RPU_MSG_HDR with a new 16-bit sequence number) and rings the
+ * doorbell. The RPU processes the request while its header differs from the
+ * response header, writes the status and results and then echoes the request
+ * header into the response header. The sender waits for its own header to
+ * come back, as on the legacy path, and SHM_APU_FLAG_ACK_IRQ applies too.
+ * One message is in flight at a time.
+ *
+ * Waveform: the APU fills the samples, period and count, then sends
+ * RPU_CMD_WAVE with RPU_WAVE_START (timer interrupt) or RPU_WAVE_START_DMA
+ * (DMA engine) on the ring. The RPU validates and copies
+ * the table before it completes the descriptor, so the area may be rewritten
+ * as soon as the descriptor status is RPU_CMD_STATUS_OK. Each sample is
+ * written to the AXI GPIO data register for one period.
+ *
+ * A table too long for the window streams from the core's bulk carveout
+ * instead: the APU places up to RPU_WAVE_STREAM_MAX_SAMPLES samples there
+ * (BULK_DDR_ADDR_CORE, at the byte offset in SHM_WAVE_DDR_OFFSET, a
+ * multiple of BULK_ALIGN), fills period, count and loops and sends
+ * RPU_WAVE_START_STREAM. The timer interrupt plays from one half of a TCM
+ * buffer of 2 x RPU_WAVE_STREAM_CHUNK samples while the waveform DMA
+ * channel fetches the next chunk into the other. The table is read while
+ * it plays, so the carveout range must stay untouched (no bulk transfer
+ * over it) until the state is idle again. A chunk that is not in TCM when
+ * its first sample is due holds the last sample until it is, one count of
+ * SHM_WAVE_UNDERRUN_OFFSET per period held. Firmware without streaming
+ * answers RPU_CMD_STATUS_BADARG.
+ *
+ * Pattern programs (rpu_pattern_prog.h) are staged in the same area: the
+ * instruction words in the samples, their number in the count word, started
+ * by RPU_CMD_PATTERN and copied by the RPU before it completes the
+ * descriptor.
+ *
+ * Timed commands: a command can be held until a given tick of the ZynqMP
+ * system counter (CNTVCT_EL0 on the APU) instead of running when it
+ * arrives, so its effect no longer depends on the doorbell and scheduling
+ * latency of either side. On the ring an RPU_CMD_AT descriptor carries the
+ * low 32 bits of the tick and applies to the next descriptor, in the same
+ * or a later batch; the high bits are those that put the tick nearest to
+ * now. As a message RPU_CMD_AT takes the command and the whole tick as
+ * parameters (opcode, arg, tick low, tick high). Either way the status of
+ * the held command is that of its scheduling: OK once queued, LATE if the
+ * tick has passed already (the command is then not run), BADARG beyond
+ * RPU_CMD_AT_MAX_AHEAD ticks or for a held RPU_CMD_AT, and FAILED when
+ * RPU_CMD_AT_SLOTS commands are already waiting. Commands due at the same
+ * tick run in the order they were queued; each appears in the trace as
+ * RPU_TRACE_TIMED when it runs.
+ *
+ * Trace: the RPU records timestamped events into a circular buffer that is
+ * overwritten when full. Each entry carries its own sequence number
+ * (index + 1), written last; a reader accepts an entry only if the sequence
+ * number matches the index it expects before and after copying it. The
+ * header head is the next index to write. Timestamps are ticks of the ZynqMP
+ * system counter (IOU_SCNTRS), the same counter the A53 generic timer
+ * (CNTVCT_EL0) reads, so RPU events line up with APU timestamps.
+ *
+ * Memory attributes: the windows are the IPI message RAM and OCM, both in
+ * the low-power domain, so RPU accesses never pass through the CCI-400 and
+ * cannot snoop the A53 caches; the R5 caches are not snooped either. Both
+ * sides therefore map them non-cacheable, and ordering comes from barriers
+ * (RPU __sync_synchronize(), kernel wmb()/rmb()), not cache maintenance.
+ * The RPU uses Normal non-cacheable (NORM_SHARED_NCACHE), which allows
+ * bursts. The APU uses Device memory by default; with the rpu_ipi parameter
+ * shm_wc the kernel's own mapping is Normal non-cacheable (write-combining)
+ * as well.
+ *
+ * Legacy DDR mailbox: a separate 4 KB region at LEGACY_MBOX_ADDR, RPU0 only.
+ * Its first word is the original bare mode word. The APU writes MODE, then
+ * increments GEN and may ring the RPU0 IPI doorbell. The RPU applies MODE
+ * when GEN differs from ACK, or when MODE differs from the mode it applied
+ * last (writers that predate GEN), then copies GEN to ACK. Without a
+ * doorbell the RPU picks the change up within LEGACY_MBOX_POLL milliseconds.
+ * Both sides map the region non-cacheable (/dev/mem O_SYNC, MPU
+ * NORM_SHARED_NCACHE), so the words need no cache maintenance.
+ *
+ * Bulk channel: payloads of KB to MB, too large for the window, go through a
+ * DDR carveout (BULK_DDR_ADDR, reserved-memory in APU/dts/rpu_bulk.dtsi)
+ * that the RPU moves with an LPD DMA channel to and from a buffer in its
+ * TCM, so the R5 never copies the data itself. Each core has half of the
+ * carveout and its own control block in OCM (BULK_CTRL_ADDR(core)) with a
+ * descriptor ring that works like the command ring: the APU fills
+ * descriptors at head, publishes head and rings the doorbell; the RPU runs
+ * one DMA transfer per descriptor, writes its status and advances tail, and
+ * follows each drained batch with a reverse IPI under SHM_APU_FLAG_ACK_IRQ.
+ * A BULK_OP_WRITE payload can be used by the firmware (rpu_bulk.h) once its
+ * descriptor completes; the buffer is overwritten by the next descriptor.
+ * BULK_OP_CHECKSUM moves no data: the RPU streams the carveout range
+ * through the CSU DMA and returns the 32-bit sum of its little-endian words
+ * in the result field, to verify a payload the APU placed there.
+ * BULK_OP_PCAP (firmware built with RPU_PCAP=1) streams the range through
+ * the same CSU DMA into the PCAP instead: a partial bitstream placed in the
+ * carveout is loaded into the PL by the RPU, a carveout-full at a time, and
+ * its completion comes back like any descriptor's. buf_offset carries the
+ * BULK_PCAP_* flags of the piece.
+ * BULK_OP_F_CRC on a WRITE or READ adds a CRC32C of the payload
+ * (rpu_crc32c.h) in the result field: for a WRITE the APU computes it while
+ * it fills the carveout and the RPU checks it on its buffer after the DMA,
+ * failing the descriptor with RPU_CMD_STATUS_CRC; for a READ the RPU
+ * computes it on its buffer before the DMA and the APU checks it while it
+ * copies the carveout out. Firmware that predates the flag answers BADOP.
+ * The RPU CPU never touches the carveout, and the APU maps it non-cacheable
+ * (/dev/mem O_SYNC), so no cache maintenance is needed on either side.
+ *
+ * RPMsg (firmware built with RPU_RPMSG=1): the same commands as the message
+ * path travel as RPMsg payloads on the endpoint RPU_RPMSG_CMD_NAME at
+ * RPU_RPMSG_CMD_ADDR, over the virtio rings that Linux remoteproc sets up in
+ * RPMSG_SHM_ADDR_CORE(core). A payload carries up to RPU_RPMSG_BATCH_MAX
+ * requests of SHM_IPI_MSG_WORDS words back to back, each laid out like the
+ * IPI request buffer; the reply carries one response per request, laid out
+ * like the IPI response buffer, in the same order. The kernel mailbox then
+ * owns the IPI message buffers, so the message path above is disabled.
+ *
+ * IRQ profile (firmware built with RPU_IRQ_PROF=1): each IPI task pass is
+ * timed with the R5 PMU cycle counter from the IPI_Handler entry to the
+ * IRQPROF_STAGE_* points, and every stage accumulates count, min, max, sum
+ * and a log2 histogram in the core's block at IRQPROF_ADDR(core). Doorbells
+ * coalesced into one pass count once, from the first. The seq word works as
+ * in the task stats; the APU clears the statistics by writing a non-zero
+ * RESET word, which the RPU zeroes when it has done so.
+ *
+ * Status block: the RPU keeps the blink state it runs (mode, override,
+ * pattern program step, LED value) and its frame and command counters in
+ * the ring tail line, and rewrites it after every LED frame and every IPI
+ * task pass that served commands, so a reader needs neither a command nor
+ * a doorbell for them. The seq word works as in the task stats: odd while
+ * the block is written, so a reader copies the words between two reads of
+ * an even, unchanged seq. The counters are free-running; the stamp is the
+ * system counter at the update. Firmware without SHM_STATUS_MAGIC does not
+ * publish the block.
+ *
+ * Task stats: the RPU periodically publishes a uxTaskGetSystemState()
+ * snapshot. The header seq is odd while a snapshot is being written; a reader
+ * copies the block and accepts it if seq was even and unchanged. Run time
+ * counters are free-running 32-bit values in ticks of run_time_hz, so CPU
+ * load is computed from the difference between two snapshots.
+ *
+ * Multi-producer command channel (RPU0 firmware built with RPU_MPCMD=1):
+ * RPU_CMD_* commands from any number of APU processes and from the RPU1
+ * firmware go to RPU0 through a bounded queue in its own OCM block at
+ * MPCMD_ADDR, so several producers need no process to funnel them through.
+ * Every slot carries a sequence word: slot (pos & MPCMD_MASK) is free for
+ * position pos while its sequence is pos, and holds the entry for pos once
+ * it is pos + 1. A producer claims a position by advancing HEAD with one
+ * compare-and-swap, the whole critical section, fills the entry and
+ * publishes it with the sequence word; RPU0 consumes in position order,
+ * writes MPCMD_DONE(pos, status) into the done word of the slot, frees the
+ * slot (sequence pos + MPCMD_SLOTS) and advances TAIL. The queue lives in
+ * OCM because the OCM controller monitors exclusive accesses from all
+ * masters, so LDREX/STREX from the R5 and LDXR/STXR from the A53 work on it
+ * through non-cached mappings. Doorbells follow the ring state word of the
+ * block as on the command ring (SHM_RING_NEED_DOORBELL); RPU1 rings RPU0
+ * through its own IPI channel. A producer that stops between its claim and
+ * its publication stalls the queue until RPU0 restarts.
+ *
+ * PC profile (firmware built with RPU_PC_PROF=1): a TTC interrupt samples
+ * the interrupted PC RPU_PC_PROF_HZ times a second and counts it in the bins
+ * of the core's block at PCPROF_ADDR(core), one histogram per code range.
+ * The seq word covers only the layout, written once at start-up; the
+ * counters are free-running and updated in place, so a reader takes the
+ * difference of two readings and may be off by the one sample in flight.
+ *
+ * Sensor samples (RPU0 firmware built with RPU_SENSOR=1): a TTC interrupt
+ * starts an I2C or SPI register read of the sensor SENSOR_HZ_OFFSET times a
+ * second, the bus interrupt completes it, and a task publishes every sample,
+ * with the system counter at its trigger, into an rpu_ring.h ring in the
+ * block at SENSOR_ADDR (RPU producer, APU consumer, no doorbell: the APU
+ * polls). A sample carries the trigger count, so a gap in it is a trigger
+ * skipped while the previous reads were still outstanding; the counters of
+ * the header are free-running and updated after every batch.
+ *
+ * Workload governor (RPU0 firmware built with RPU_GOVERNOR=1): the RPU
+ * lowers its clock while it has nothing but the SLOW blink to do and raises
+ * it again in the IPI handler. The block at GOV_ADDR is published every
+ * governor period under its seq word, as in the task stats; the wake-up
+ * latencies are measured from the IPI handler entry to the full clock being
+ * back, and the time spent at the low clock is in system counter ticks.
+ *
+ * Watchdog supervision (RPU0 firmware built with RPU_WATCHDOG=1): the LPD
+ * watchdog is restarted at the end of a supervision window only when every
+ * supervised task met its deadlines in it. The block at WDOG_ADDR has the
+ * window counts and, per task, the deadlines met and missed and the stalls
+ * (a periodic task silent for too long, a command left unserved past its
+ * deadline); all counters are free-running, published every window under
+ * the seq word.
+ *
+ * Kernel benchmark (RPU0 firmware built with RPU_BENCH=1, instead of the LED
+ * application): the block at BENCH_ADDR has the cycle counter statistics of
+ * every BENCH_TEST_*, accumulated since the firmware started and published
+ * after every round under the seq word. Each test entry is laid out as an
+ * IRQ profile stage, with the same histogram buckets.
+ *
+ * Memory hierarchy benchmark (RPU0 firmware built with RPU_MEMBENCH=1,
+ * instead of the LED application): the block at MEMBENCH_ADDR has, for every
+ * region (TCM, OCM, DDR, PL) and MPU memory type the R5 can give it, the
+ * cycles of a pointer chase, of a read and a write sweep and of repeated
+ * single-word accesses. A pass runs at boot and again whenever the APU
+ * writes a new MEMBENCH_GEN; MEMBENCH_DONE echoes it once the entries are
+ * written. The scratch ranges are only touched during a pass, so the APU
+ * can measure them itself (apu_app/mem_bench) while DONE equals GEN.
+ *
+ * Memory watermarks: every task stats period each core also publishes, in
+ * its block at MEM_ADDR(core), the stack size and the lowest free stack
+ * space of every task and of the exception mode stacks, with the FreeRTOS
+ * heap figures, under the seq word. Sizes and free space are in bytes; the
+ * free space only goes down, so a long run under the real workload is the
+ * measurement to size the stacks (and the TCM they take) against.
+ *
+ * Firmware hot-swap: before the APU stops a core to load a new image
+ * (apu_app/fw_loader) it sends RPU_CMD_HANDOFF as a message. The firmware
+ * writes its state (blink mode, override flag, legacy mailbox mode, the LED
+ * value on the pins and the time left to the next frame and mode rotation)
+ * to its block at HANDOFF_ADDR(core), stamped with the system counter, then
+ * the magic word, and stops driving the LEDs and taking mode changes; the
+ * pins hold the last value while remoteproc restarts the core. The next
+ * image to start on the core resumes from a block with the magic and its
+ * version instead of initializing the state, shortens the first frame and
+ * rotation by the time the swap took, and marks the block HANDOFF_RESUMED
+ * with that gap. A handoff is refused (RPU_CMD_STATUS_FAILED) while the
+ * waveform engine plays.
+ *
+ * Time base: all timestamps are ticks of the system counter (trace above).
+ * The RPU publishes the counter frequency it uses; the APU (apu_app/rpu_clock)
+ * publishes the offset between its CLOCK_MONOTONIC and the counter, so that
+ *   CLOCK_MONOTONIC ns = ticks * 10^9 / hz + offset_ns
+ * on both sides. The sync seq word works as in the task stats, with the
+ * SYNC magic written once the first offset is in place. CLOCK_MONOTONIC is
+ * slewed by NTP while the counter is not, so the APU refreshes the offset
+ * periodically; error_ns bounds the uncertainty of the last measurement.
+ */
+
+#ifndef RPU_SHM_H
+#define RPU_SHM_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+/* Shared memory window of RPU0 (IPI message RAM) */
+#define SHARED_MEM_ADDR        0xFF990000UL
+#define SHARED_MEM_SIZE        0x1000
+
+/* Split mode: RPU1 has its own window in OCM bank 0, same layout */
+#define RPU_CORE_COUNT         2
+#define SHARED_MEM_ADDR_RPU1   0xFFFC0000UL
+#define SHARED_MEM_ADDR_CORE(core)  ((core) ? SHARED_MEM_ADDR_RPU1 : SHARED_MEM_ADDR)
+
+/*
+ * TCM variant (firmware built with RPU_SHM_TCM=1): the window, same layout,
+ * is the first 4 KB of the core's BTCM, which the R5 reads in one cycle
+ * instead of an interconnect round trip, and the APU reaches through the
+ * global TCM alias. The IPI message buffers stay in the IPI message RAM.
+ * The firmware then publishes the redirect below in the window above, the
+ * only words of it it still writes; any other firmware clears it at boot.
+ * A client maps the window the redirect names (the address must be the
+ * core's SHARED_MEM_TCM_ADDR_CORE()) and the default one otherwise.
+ */
+#define SHARED_MEM_TCM_ADDR_CORE(core)  ((core) ? 0xFFEB0000UL : 0xFFE20000UL)
+#define SHM_REDIRECT_MAGIC_OFFSET  0x20  /* SHM_REDIRECT_MAGIC while redirected (RPU writes) */
+#define SHM_REDIRECT_ADDR_OFFSET   0x24  /* Global address of the window (RPU writes) */
+#define SHM_REDIRECT_MAGIC         0x4D435452  /* "RTCM" */
+
+/*
+ * Ready word: the firmware clears it at the top of main() and publishes it,
+ * with the ABI version and the SHM_FEAT_* it offers, once its IPI task takes
+ * commands; remoteproc reports "running" as soon as the core is released
+ * from reset, before any of the firmware's setup. It lives in the default
+ * window in both variants, next to the redirect, so a loader finds it
+ * without knowing where the image puts its window. A loader clears the
+ * word before it starts the core, so one left by the previous image does
+ * not count.
+ */
+#define SHM_READY_OFFSET           0x28  /* SHM_READY_MAGIC, written last (RPU writes) */
+#define SHM_READY_VERSION_OFFSET   0x2C  /* SHM_ABI_VERSION (RPU writes) */
+#define SHM_READY_FEATURES_OFFSET  0x30  /* SHM_FEAT_* offered (RPU writes) */
+#define SHM_READY_MAGIC            0x59444552  /* "REDY" */
+
+/* IPI channel of each core: RPU0 is IPI1, RPU1 is IPI2 */
+#define RPU_IPI_MASK(core)     (0x100U << (core))  /* Target bit in an APU trigger */
+
+/* Cache line used to keep producer and consumer fields apart (A53: 64 B) */
+#define SHM_CACHE_LINE         64
+
+/* Legacy single-word interface */
+#define SHM_CMD_OFFSET         0x00  /* Command/Mode (APU writes, RPU reads) */
+#define SHM_ACK_OFFSET         0x04  /* Acknowledgment (RPU writes, APU reads) */
+#define SHM_SEQ_OFFSET         0x08  /* Sequence number of CMD (APU writes) */
+#define SHM_ACK_SEQ_OFFSET     0x0C  /* Last sequence number processed (RPU writes) */
+#define SHM_ACK_MAGIC          0xDEADBEEF  /* Magic value to indicate acknowledgment */
+#define SHM_APU_FLAGS_OFFSET   0x10  /* SHM_APU_FLAG_* (APU writes, RPU reads) */
+
+/* ABI request, in the APU's line */
+#define SHM_ABI_REQ_OFFSET     0x14  /* SHM_FEAT_* asked for (APU writes) */
+#define SHM_ABI_REQ_SEQ_OFFSET 0x18  /* Publishes the request (APU writes) */
+
+/* ABI header, in a cache line of its own (RPU writes, APU reads) */
+#define SHM_ABI_OFFSET          0x0C0
+#define SHM_ABI_MAGIC_OFFSET    (SHM_ABI_OFFSET + 0x00)  /* SHM_ABI_MAGIC, written last */
+#define SHM_ABI_VERSION_OFFSET  (SHM_ABI_OFFSET + 0x04)  /* SHM_ABI_VERSION */
+#define SHM_ABI_FEATURES_OFFSET (SHM_ABI_OFFSET + 0x08)  /* SHM_FEAT_* offered */
+#define SHM_ABI_ACTIVE_OFFSET   (SHM_ABI_OFFSET + 0x0C)  /* SHM_FEAT_* granted so far */
+#define SHM_ABI_GRANT_SEQ_OFFSET (SHM_ABI_OFFSET + 0x10) /* Last request served, written after ACTIVE */
+#define SHM_ABI_ACK_SEQ_OFFSET  (SHM_ABI_OFFSET + 0x14)  /* SHM_FEAT_ACK_LINE: copy of ACK_SEQ */
+#define SHM_ABI_ACK_OFFSET      (SHM_ABI_OFFSET + 0x18)  /* SHM_FEAT_ACK_LINE: copy of ACK */
+#define SHM_ABI_MAGIC           0x53414249  /* "SABI" */
+#define SHM_ABI_VERSION_MAKE(major, minor)  (((uint32_t)(major) << 16) | ((minor) & 0xFFFF))
+#define SHM_ABI_VERSION_MAJOR(ver)  ((ver) >> 16)
+#define SHM_ABI_VERSION         SHM_ABI_VERSION_MAKE(1, 2)
+
+/* ABI header (32 bytes) */
+struct rpu_shm_abi {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t features;
+    uint32_t active;
+    uint32_t grant_seq;
+    uint32_t ack_seq;
+    uint32_t ack;
+    uint32_t reserved;
+};
+
+/* Features (fast paths) */
+#define SHM_FEAT_RING          0x01  /* Command ring */
+#define SHM_FEAT_RING_POLL     0x02  /* Doorbell moderation: ring state word, batches without doorbell */
+#define SHM_FEAT_ACK_IRQ       0x04  /* Reverse IPI under SHM_APU_FLAG_ACK_IRQ */
+#define SHM_FEAT_MSG           0x08  /* Message path in the IPI buffers (not with RPMsg) */
+#define SHM_FEAT_AT            0x10  /* Timed commands (RPU_CMD_AT) */
+#define SHM_FEAT_ACK_LINE      0x20  /* Legacy ACK words copied to the ABI line, once active */
+#define SHM_FEAT_URGENT        0x40  /* Urgent ring, drained ahead of everything else (ABI 1.1) */
+#define SHM_FEAT_CREDIT        0x80  /* Ring credit limit and service rate (ABI 1.2) */
+/* What firmware that predates the ABI header serves */
+#define SHM_ABI_V0_FEATURES    (SHM_FEAT_RING | SHM_FEAT_RING_POLL | SHM_FEAT_ACK_IRQ | SHM_FEAT_MSG)
+
+/* APU flags */
+#define SHM_APU_FLAG_ACK_IRQ   0x1   /* Raise a reverse IPI to the APU after each ACK */
+#define SHM_APU_FLAG_ECHO      0x2   /* Echo mode (ipi_bench): ACK without side effects */
+
+/* ACK word: upper 24 bits of the magic, low byte echoes the command */
+#define SHM_ACK_MAGIC_MASK     0xFFFFFF00
+#define SHM_ACK_VALUE(cmd)     ((SHM_ACK_MAGIC & SHM_ACK_MAGIC_MASK) | ((cmd) & 0xFF))
+#define SHM_ACK_IS_VALID(ack)  (((ack) & SHM_ACK_MAGIC_MASK) == (SHM_ACK_MAGIC & SHM_ACK_MAGIC_MASK))
+
+/* Command ring */
+#define SHM_RING_HEAD_OFFSET   0x040
+#define SHM_RING_TAIL_OFFSET   0x080
+#define SHM_RING_STATE_OFFSET  0x084  /* SHM_RING_STATE_* (RPU writes, tail line) */
+#define SHM_RING_CREDIT_OFFSET 0x088  /* SHM_FEAT_CREDIT: index limit of head (RPU writes, tail line) */
+#define SHM_RING_RATE_OFFSET   0x08C  /* SHM_FEAT_CREDIT: descriptors per second, 0 = unknown */
+#define SHM_RING_DESC_OFFSET   0x100
+#define SHM_RING_SLOTS         32    /* Must be a power of two */
+#define SHM_RING_MASK          (SHM_RING_SLOTS - 1)
+
+/* Status block, in the ring tail line (RPU writes, APU reads) */
+#define SHM_STATUS_OFFSET           0x090
+#define SHM_STATUS_SEQ_OFFSET       (SHM_STATUS_OFFSET + 0x00)  /* Odd while the block is written */
+#define SHM_STATUS_MAGIC_OFFSET     (SHM_STATUS_OFFSET + 0x04)  /* SHM_STATUS_MAGIC */
+#define SHM_STATUS_MODE_OFFSET      (SHM_STATUS_OFFSET + 0x08)  /* Blink mode: 0=SLOW 1=FAST 2=RANDOM 3=PATTERN */
+#define SHM_STATUS_FLAGS_OFFSET     (SHM_STATUS_OFFSET + 0x0C)  /* SHM_STATUS_F_* */
+#define SHM_STATUS_LED_OFFSET       (SHM_STATUS_OFFSET + 0x10)  /* Value last written to the LEDs */
+#define SHM_STATUS_STEP_OFFSET      (SHM_STATUS_OFFSET + 0x14)  /* Pattern program counter */
+#define SHM_STATUS_FRAMES_OFFSET    (SHM_STATUS_OFFSET + 0x18)  /* LED frames written */
+#define SHM_STATUS_COMMANDS_OFFSET  (SHM_STATUS_OFFSET + 0x1C)  /* Commands served (all paths) */
+#define SHM_STATUS_STAMP_LO_OFFSET  (SHM_STATUS_OFFSET + 0x20)  /* System counter at the update */
+#define SHM_STATUS_STAMP_HI_OFFSET  (SHM_STATUS_OFFSET + 0x24)
+#define SHM_STATUS_SIZE             0x28
+#define SHM_STATUS_MAGIC            0x54415453  /* "STAT" */
+#define SHM_STATUS_F_OVERRIDE       0x1   /* APU override: the mode timer does not rotate */
+#define SHM_STATUS_F_PATTERN        0x2   /* A pattern program is loaded and running */
+#define SHM_STATUS_F_WAVE           0x4   /* The waveform engine owns the GPIO */
+
+#if SHM_STATUS_OFFSET < SHM_RING_RATE_OFFSET + 4 || \
+    SHM_STATUS_OFFSET + SHM_STATUS_SIZE > SHM_ABI_OFFSET
+#error "Status block overlaps the ring credit words or the ABI header"
+#endif
+
+/* Ring state: whether a producer must ring the doorbell after publishing head */
+#define SHM_RING_STATE_IDLE    0x49444C45  /* "IDLE": consumer waits for a doorbell */
+#define SHM_RING_STATE_POLLING 0x504F4C4C  /* "POLL": consumer drains, no doorbell needed */
+#define SHM_RING_NEED_DOORBELL(state) ((state) != SHM_RING_STATE_POLLING)
+
+/* Ring credits (see "Ring credits" above): slots a producer at head may fill
+ * under credit limit 'credit' with the consumer at 'tail' */
+#define SHM_CREDIT_MIN_SLOTS   4
+#define SHM_RING_FREE(head, tail)  (SHM_RING_SLOTS - (uint32_t)((head) - (tail)))
+#define SHM_RING_CREDITS(credit, head, tail) \
+    ((int32_t)((credit) - (head)) <= 0 ? 0u : \
+     (uint32_t)((credit) - (head)) < SHM_RING_FREE(head, tail) ? \
+         (uint32_t)((credit) - (head)) : SHM_RING_FREE(head, tail))
+
+/* Command descriptor (16 bytes) */
+struct rpu_shm_desc {
+    uint32_t opcode;  /* RPU_CMD_* */
+    uint32_t arg;     /* Opcode argument (e.g. blink mode) */
+    uint32_t seq;     /* Producer-assigned sequence number */
+    uint32_t status;  /* RPU_CMD_STATUS_*, written by the consumer */
+};
+
+#define SHM_RING_DESC_SIZE     16
+#define SHM_RING_DESC(idx)     (SHM_RING_DESC_OFFSET + \
+                                ((idx) & SHM_RING_MASK) * SHM_RING_DESC_SIZE)
+
+/* Urgent ring, same descriptors (see "Urgent ring" above) */
+#define SHM_URING_HEAD_OFFSET  0x300
+#define SHM_URING_TAIL_OFFSET  0x340
+#define SHM_URING_DESC_OFFSET  0x380
+#define SHM_URING_SLOTS        8     /* Must be a power of two */
+#define SHM_URING_MASK         (SHM_URING_SLOTS - 1)
+#define SHM_URING_DESC(idx)    (SHM_URING_DESC_OFFSET + \
+                                ((idx) & SHM_URING_MASK) * SHM_RING_DESC_SIZE)
+
+/* Descriptor field offsets (for ioread32/iowrite32 style accessors) */
+#define SHM_DESC_OPCODE        0x0
+#define SHM_DESC_ARG           0x4
+#define SHM_DESC_SEQ           0x8
+#define SHM_DESC_STATUS        0xC
+
+/* Opcodes */
+#define RPU_CMD_NOP            0  /* Message results echo the parameters */
+#define RPU_CMD_SET_MODE       1  /* arg: 0=SLOW 1=FAST 2=RANDOM 3+=release */
+#define RPU_CMD_WAVE           2  /* arg: RPU_WAVE_STOP, RPU_WAVE_START, _START_DMA or _START_STREAM */
+#define RPU_CMD_QUERY          3  /* Message results: blink mode, override active, waveform state */
+#define RPU_CMD_HANDOFF        4  /* Save the state for the next image and freeze (HANDOFF_ADDR) */
+#define RPU_CMD_PATTERN        5  /* arg: RPU_PATTERN_START (program in the waveform area) or _STOP, rpu_pattern_prog.h */
+#define RPU_CMD_SEED           6  /* arg: seed of the random blink values, from the next frame (0 = boot seed) */
+#define RPU_CMD_AT             7  /* arg: system counter tick (low 32 bits) the next descriptor runs at */
+
+/* Timed commands (RPU_CMD_AT) */
+#define RPU_CMD_AT_MAX_AHEAD   0x7FFFFFFFU  /* System counter ticks, about 21 s at 100 MHz */
+#define RPU_CMD_AT_SLOTS       16           /* Commands waiting at a time, per core */
+
+/* Descriptor status */
+#define RPU_CMD_STATUS_PENDING 0
+#define RPU_CMD_STATUS_OK      1
+#define RPU_CMD_STATUS_BADOP   2
+#define RPU_CMD_STATUS_BADARG  3  /* Opcode known, argument or table rejected */
+#define RPU_CMD_STATUS_FAILED  4  /* Accepted but not completed (bulk DMA error or timeout) */
+#define RPU_CMD_STATUS_LATE    5  /* Timed command whose tick had passed, not run */
+#define RPU_CMD_STATUS_CRC     6  /* Bulk payload failed its CRC32C check (BULK_OP_F_CRC) */
+
+/* IPI message buffers (APU -> RPU0 pair of the IPI message RAM) */
+#define SHM_IPI_REQ_OFFSET     0x400
+#define SHM_IPI_RESP_OFFSET    0x420
+#define SHM_IPI_MSG_WORDS      8     /* 32-byte buffer */
+#define SHM_IPI_MSG_DATA_WORDS (SHM_IPI_MSG_WORDS - 1)
+
+/* APU -> RPU<core> pair: one 64-byte slot per target in the APU group */
+#define SHM_IPI_CORE_STRIDE    0x40
+#define SHM_IPI_REQ_ADDR(core)   (SHARED_MEM_ADDR + SHM_IPI_REQ_OFFSET + (core) * SHM_IPI_CORE_STRIDE)
+#define SHM_IPI_RESP_ADDR(core)  (SHARED_MEM_ADDR + SHM_IPI_RESP_OFFSET + (core) * SHM_IPI_CORE_STRIDE)
+
+/* IPI message (32 bytes); the response carries the status in data[0] and
+ * the results in data[1..] */
+struct rpu_shm_msg {
+    uint32_t hdr;   /* RPU_MSG_HDR(), written last */
+    uint32_t data[SHM_IPI_MSG_DATA_WORDS];
+};
+
+/* Message header: sequence number 31:16, parameter count 11:8, opcode 7:0 */
+#define RPU_MSG_HDR(op, len, seq)  ((((uint32_t)(seq) & 0xFFFF) << 16) | \
+                                    (((uint32_t)(len) & 0xF) << 8) | \
+                                    ((uint32_t)(op) & 0xFF))
+#define RPU_MSG_HDR_OPCODE(hdr)    ((hdr) & 0xFF)
+#define RPU_MSG_HDR_LEN(hdr)       (((hdr) >> 8) & 0xF)
+#define RPU_MSG_HDR_SEQ(hdr)       ((hdr) >> 16)
+#define RPU_MSG_MAX_RESULTS        (SHM_IPI_MSG_DATA_WORDS - 1)
+
+/* GPIO waveform table */
+#define SHM_WAVE_HDR_OFFSET    0x500
+#define SHM_WAVE_PERIOD_OFFSET (SHM_WAVE_HDR_OFFSET + 0x0)  /* Sample period in ns */
+#define SHM_WAVE_COUNT_OFFSET  (SHM_WAVE_HDR_OFFSET + 0x4)  /* Number of samples */
+#define SHM_WAVE_LOOPS_OFFSET  (SHM_WAVE_HDR_OFFSET + 0x8)  /* Table repetitions, 0 = until stopped */
+#define SHM_WAVE_STATE_OFFSET  (SHM_WAVE_HDR_OFFSET + 0xC)  /* RPU_WAVE_STATE_* (RPU writes) */
+#define SHM_WAVE_DDR_OFFSET    (SHM_WAVE_HDR_OFFSET + 0x10) /* RPU_WAVE_START_STREAM: table offset in the bulk carveout */
+#define SHM_WAVE_UNDERRUN_OFFSET (SHM_WAVE_HDR_OFFSET + 0x14) /* Periods a stream held for a late chunk (RPU writes) */
+#define SHM_WAVE_SAMPLE_OFFSET 0x540
+#define SHM_WAVE_MAX_SAMPLES   176
+#define RPU_WAVE_MIN_PERIOD_NS 5000  /* Limited by the sample interrupt cost */
+#define RPU_WAVE_DMA_MIN_PERIOD_NS 100  /* DMA playback, limited by the AXI GPIO write latency */
+#define RPU_WAVE_STREAM_CHUNK  512   /* Samples per TCM half of a streamed table */
+#define RPU_WAVE_STREAM_MAX_SAMPLES (BULK_DDR_CORE_SIZE / 4)
+
+/* RPU_CMD_WAVE arguments */
+#define RPU_WAVE_STOP          0
+#define RPU_WAVE_START         1  /* Timer interrupt playback */
+#define RPU_WAVE_START_DMA     2  /* DMA playback, no CPU per sample */
+#define RPU_WAVE_START_STREAM  3  /* Timer interrupt playback of a table in the bulk carveout */
+
+/* Waveform state */
+#define RPU_WAVE_STATE_IDLE    0
+#define RPU_WAVE_STATE_RUNNING 1
+#define RPU_WAVE_STATE_DMA     2  /* Running from the DMA engine */
+#define RPU_WAVE_STATE_STREAM  3  /* Running (timer), streamed from the bulk carveout */
+
+/* Event trace */
+#define SHM_TRACE_HDR_OFFSET   0x800
+#define SHM_TRACE_MAGIC_OFFSET (SHM_TRACE_HDR_OFFSET + 0x0)  /* SHM_TRACE_MAGIC once initialized */
+#define SHM_TRACE_HEAD_OFFSET  (SHM_TRACE_HDR_OFFSET + 0x4)  /* Next index to write */
+#define SHM_TRACE_ENTRY_OFFSET 0x840
+#define SHM_TRACE_SLOTS        64    /* Must be a power of two */
+#define SHM_TRACE_MASK         (SHM_TRACE_SLOTS - 1)
+#define SHM_TRACE_MAGIC        0x54524345  /* "TRCE" */
+
+/* Trace entry (24 bytes) */
+struct rpu_shm_trace {
+    uint32_t seq;    /* Index + 1, written last */
+    uint32_t event;  /* RPU_TRACE_* */
+    uint32_t arg0;
+    uint32_t arg1;
+    uint32_t ts_lo;  /* System counter ticks */
+    uint32_t ts_hi;
+};
+
+#define SHM_TRACE_ENTRY_SIZE   24
+#define SHM_TRACE_ENTRY(idx)   (SHM_TRACE_ENTRY_OFFSET + \
+                                ((idx) & SHM_TRACE_MASK) * SHM_TRACE_ENTRY_SIZE)
+
+/* Trace entry field offsets */
+#define SHM_TRACE_SEQ          0x00
+#define SHM_TRACE_EVENT        0x04
+#define SHM_TRACE_ARG0         0x08
+#define SHM_TRACE_ARG1         0x0C
+#define SHM_TRACE_TS_LO        0x10
+#define SHM_TRACE_TS_HI        0x14
+
+/* Compact trace (firmware built with RPU_TRACE_COMPACT=1, record coding in
+ * rpu_trace_compact.h): the magic is SHM_TRACE_MAGIC_COMPACT, the entry area
+ * holds SHM_TRACEZ_BLOCKS blocks written one after the other, and the head
+ * is the number of the block being written (1 for the first). A block is
+ * valid while its SEQ holds its number; records are published by USED. */
+#define SHM_TRACE_MAGIC_COMPACT 0x5452435A  /* "TRCZ" */
+#define SHM_TRACEZ_BLOCK_SIZE  128
+#define SHM_TRACEZ_BLOCKS      12
+#define SHM_TRACEZ_BLOCK(n)    (SHM_TRACE_ENTRY_OFFSET + \
+                                (((n) - 1) % SHM_TRACEZ_BLOCKS) * SHM_TRACEZ_BLOCK_SIZE)
+
+/* Compact block field offsets */
+#define SHM_TRACEZ_SEQ         0x00  /* Block number, 0 while it is opened */
+#define SHM_TRACEZ_USED        0x04  /* Record bytes published, written after them */
+#define SHM_TRACEZ_FIRST       0x08  /* Index of the block's first event */
+#define SHM_TRACEZ_BASE_LO     0x0C  /* System counter the first delta counts from */
+#define SHM_TRACEZ_BASE_HI     0x10
+#define SHM_TRACEZ_DATA        0x14  /* Records */
+#define SHM_TRACEZ_DATA_SIZE   (SHM_TRACEZ_BLOCK_SIZE - SHM_TRACEZ_DATA)
+
+/* Trace events (arg0, arg1) */
+#define RPU_TRACE_IPI_RX       1  /* IPI interrupt taken (ISR, bits without a handler) */
+#define RPU_TRACE_CMD_START    2  /* Command task woke up (-, -) */
+#define RPU_TRACE_RING_DRAIN   3  /* Ring descriptors consumed (count, tail) */
+#define RPU_TRACE_ACK          4  /* Legacy ACK written (seq, ack value) */
+#define RPU_TRACE_MODE         5  /* Blink mode applied (mode, override active) */
+#define RPU_TRACE_GPIO_WRITE   6  /* AXI GPIO data written (value, 0 = single / 1 = burst) */
+#define RPU_TRACE_WAVE         7  /* Waveform started or ended (sample count, 0 = ended; period ns) */
+#define RPU_TRACE_MSG          8  /* IPI message answered (header, status) */
+#define RPU_TRACE_MBOX         9  /* Legacy DDR mailbox processed (generation, mode) */
+#define RPU_TRACE_BULK         10 /* Bulk descriptor completed (op | status << 8, length) */
+#define RPU_TRACE_GPIO_IN      11 /* AXI GPIO input change (value | changed << 16, edge-to-task ticks) */
+#define RPU_TRACE_MPCMD        12 /* Multi-producer command run (source, opcode | status << 16) */
+#define RPU_TRACE_EDGE         13 /* LED edge written (deadline tick, signed error ns vs. schedule) */
+#define RPU_TRACE_TIMED        14 /* Timed command run (opcode | status << 16, signed error ns vs. its tick) */
+#define RPU_TRACE_URGENT       15 /* Urgent ring descriptors consumed (count, tail) */
+
+/* Task stats */
+#define SHM_STATS_HDR_OFFSET   0xE40
+#define SHM_STATS_MAGIC_OFFSET (SHM_STATS_HDR_OFFSET + 0x00)  /* SHM_STATS_MAGIC once initialized */
+#define SHM_STATS_SEQ_OFFSET   (SHM_STATS_HDR_OFFSET + 0x04)  /* Odd while an update is in progress */
+#define SHM_STATS_COUNT_OFFSET (SHM_STATS_HDR_OFFSET + 0x08)  /* Valid entries */
+#define SHM_STATS_TOTAL_OFFSET (SHM_STATS_HDR_OFFSET + 0x0C)  /* Run time counter at the snapshot */
+#define SHM_STATS_HZ_OFFSET    (SHM_STATS_HDR_OFFSET + 0x10)  /* Run time counter frequency */
+#define SHM_STATS_TICK_OFFSET  (SHM_STATS_HDR_OFFSET + 0x14)  /* FreeRTOS tick count at the snapshot */
+#define SHM_STATS_HEAP_OFFSET  (SHM_STATS_HDR_OFFSET + 0x18)  /* Free heap bytes (0 without a FreeRTOS heap) */
+#define SHM_STATS_HEAP_MIN_OFFSET (SHM_STATS_HDR_OFFSET + 0x1C)  /* Lowest free heap bytes so far */
+#define SHM_STATS_ENTRY_OFFSET 0xE60
+#define SHM_STATS_MAX_TASKS    16
+#define SHM_STATS_NAME_LEN     12    /* Including the terminating NUL */
+#define SHM_STATS_MAGIC        0x53544154  /* "STAT" */
+
+/* Task stats entry (24 bytes) */
+struct rpu_shm_task_stat {
+    char     name[SHM_STATS_NAME_LEN];
+    uint32_t run_time;    /* Accumulated run time counter ticks */
+    uint32_t stack_free;  /* Stack high water mark in bytes */
+    uint8_t  number;      /* FreeRTOS task number */
+    uint8_t  priority;    /* Current priority */
+    uint8_t  state;       /* eTaskState */
+    uint8_t  reserved;
+};
+
+#define SHM_STATS_ENTRY_SIZE   24
+#define SHM_STATS_ENTRY(idx)   (SHM_STATS_ENTRY_OFFSET + (idx) * SHM_STATS_ENTRY_SIZE)
+
+/* Time base */
+#define SHM_TIME_HDR_OFFSET    0xFE0
+#define SHM_TIME_MAGIC_OFFSET  (SHM_TIME_HDR_OFFSET + 0x00)  /* SHM_TIME_MAGIC once HZ is valid (RPU writes) */
+#define SHM_TIME_HZ_OFFSET     (SHM_TIME_HDR_OFFSET + 0x04)  /* System counter frequency (RPU writes) */
+#define SHM_SYNC_MAGIC_OFFSET  (SHM_TIME_HDR_OFFSET + 0x08)  /* SHM_SYNC_MAGIC once an offset is published (APU writes) */
+#define SHM_SYNC_SEQ_OFFSET    (SHM_TIME_HDR_OFFSET + 0x0C)  /* Odd while the offset is being updated (APU writes) */
+#define SHM_SYNC_OFFSET_LO     (SHM_TIME_HDR_OFFSET + 0x10)  /* CLOCK_MONOTONIC ns at counter 0, signed 64-bit */
+#define SHM_SYNC_OFFSET_HI     (SHM_TIME_HDR_OFFSET + 0x14)
+#define SHM_SYNC_ERROR_OFFSET  (SHM_TIME_HDR_OFFSET + 0x18)  /* Uncertainty of the offset in ns */
+#define SHM_SYNC_TIME_OFFSET   (SHM_TIME_HDR_OFFSET + 0x1C)  /* CLOCK_MONOTONIC seconds at the last update */
+#define SHM_TIME_HDR_SIZE      0x20
+#define SHM_TIME_MAGIC         0x54494D45  /* "TIME" */
+#define SHM_SYNC_MAGIC         0x53594E43  /* "SYNC" */
+
+/* Legacy DDR mailbox (RPU0 only), outside the shared window */
+#define LEGACY_MBOX_ADDR         0x40000000UL
+#define LEGACY_MBOX_SIZE         0x1000
+#define LEGACY_MBOX_MODE_OFFSET  0x00  /* Blink mode, the original control word (APU writes) */
+#define LEGACY_MBOX_GEN_OFFSET   0x04  /* Generation, incremented after MODE (APU writes) */
+#define LEGACY_MBOX_ACK_OFFSET   0x08  /* Generation last processed (RPU writes) */
+#define LEGACY_MBOX_MAGIC_OFFSET 0x0C  /* LEGACY_MBOX_MAGIC while the firmware serves it (RPU writes) */
+#define LEGACY_MBOX_POLL_OFFSET  0x10  /* RPU poll period in ms, 0 = doorbell only (RPU writes) */
+#define LEGACY_MBOX_MAGIC        0x4D424F58  /* "MBOX" */
+
+/* RPMsg: vrings and buffers of each core, allocated by Linux remoteproc
+ * (APU/dts/rpu_rpmsg.dtsi) */
+#define RPMSG_SHM_ADDR         0x3F500000UL  /* After the bulk carveout */
+#define RPMSG_SHM_SIZE         0x00100000    /* Per core */
+#define RPMSG_SHM_ADDR_CORE(core)  (RPMSG_SHM_ADDR + (core) * RPMSG_SHM_SIZE)
+#define RPU_RPMSG_CMD_NAME     "rpmsg-raw"   /* Bound by Linux rpmsg_char */
+#define RPU_RPMSG_CMD_ADDR     0x400
+#define RPU_RPMSG_MSG_SIZE     (SHM_IPI_MSG_WORDS * 4)
+#define RPU_RPMSG_BATCH_MAX    15    /* 496-byte RPMsg payload */
+
+/* Bulk channel: DDR carveout, split evenly between the cores */
+#define BULK_DDR_ADDR          0x3F100000UL  /* After the RPU1 image (lscript.ld.in) */
+#define BULK_DDR_SIZE          0x00400000
+#define BULK_DDR_CORE_SIZE     (BULK_DDR_SIZE / RPU_CORE_COUNT)
+#define BULK_DDR_ADDR_CORE(core)  (BULK_DDR_ADDR + (core) * BULK_DDR_CORE_SIZE)
+
+/* Bulk control block of each core (OCM bank 0, after the RPU1 window) */
+#define BULK_CTRL_ADDR_RPU0    0xFFFC1000UL
+#define BULK_CTRL_SIZE         0x1000
+#define BULK_CTRL_ADDR(core)   (BULK_CTRL_ADDR_RPU0 + (core) * BULK_CTRL_SIZE)
+#define BULK_MAGIC_OFFSET      0x000  /* BULK_MAGIC while the firmware serves the channel (RPU writes) */
+#define BULK_BUF_SIZE_OFFSET   0x004  /* Size of the RPU buffer in bytes (RPU writes) */
+#define BULK_HEAD_OFFSET       0x040  /* APU writes - own cache line */
+#define BULK_TAIL_OFFSET       0x080  /* RPU writes - own cache line */
+#define BULK_DESC_OFFSET       0x100
+#define BULK_SLOTS             16    /* Must be a power of two */
+#define BULK_MASK              (BULK_SLOTS - 1)
+#define BULK_ALIGN             8     /* Offsets and lengths, in bytes */
+#define BULK_MAGIC             0x42554C4B  /* "BULK" */
+
+/* Bulk descriptor (32 bytes) */
+struct rpu_bulk_desc {
+    uint32_t op;          /* BULK_OP_* */
+    uint32_t ddr_offset;  /* In the core's half of the carveout */
+    uint32_t buf_offset;  /* In the RPU buffer */
+    uint32_t length;      /* Bytes */
+    uint32_t seq;         /* Producer-assigned sequence number */
+    uint32_t status;      /* RPU_CMD_STATUS_*, written by the consumer */
+    uint32_t dma_ticks;   /* DMA time in system counter ticks, a share by length of a
+                           * pass that carried several (RPU writes) */
+    uint32_t result;      /* BULK_OP_CHECKSUM: word sum of the range (RPU writes);
+                           * BULK_OP_F_CRC: CRC32C of the payload (WRITE: APU, READ: RPU) */
+};
+
+#define BULK_DESC_SIZE         32
+#define BULK_DESC(idx)         (BULK_DESC_OFFSET + ((idx) & BULK_MASK) * BULK_DESC_SIZE)
+
+/* Bulk descriptor field offsets */
+#define BULK_DESC_OP           0x00
+#define BULK_DESC_DDR_OFFSET   0x04
+#define BULK_DESC_BUF_OFFSET   0x08
+#define BULK_DESC_LENGTH       0x0C
+#define BULK_DESC_SEQ          0x10
+#define BULK_DESC_STATUS       0x14
+#define BULK_DESC_DMA_TICKS    0x18
+#define BULK_DESC_RESULT       0x1C
+
+/* Bulk operations */
+#define BULK_OP_WRITE          1  /* Carveout -> RPU buffer */
+#define BULK_OP_READ           2  /* RPU buffer -> carveout */
+#define BULK_OP_CHECKSUM       3  /* Word sum of a carveout range, up to all of it (CSU DMA) */
+#define BULK_OP_PCAP           4  /* Carveout range -> PCAP, a partial bitstream or a piece (CSU DMA) */
+#define BULK_OP_MASK           0xFF
+#define BULK_OP_F_CRC          0x100  /* WRITE, READ: CRC32C of the payload in result */
+
+/* BULK_OP_PCAP flags (buf_offset) */
+#define BULK_PCAP_SWAP         0x1  /* Swap the bytes of each word: data in .bit file order */
+
+/* IRQ profile block of each core (OCM bank 0, after the bulk control blocks;
+ * firmware built with RPU_IRQ_PROF=1) */
+#define IRQPROF_ADDR_RPU0      0xFFFC3000UL
+#define IRQPROF_SIZE           0x1000  /* A page each, for /dev/mem */
+#define IRQPROF_ADDR(core)     (IRQPROF_ADDR_RPU0 + (core) * IRQPROF_SIZE)
+#define IRQPROF_MAGIC_OFFSET   0x00  /* IRQPROF_MAGIC once initialized (RPU writes) */
+#define IRQPROF_SEQ_OFFSET     0x04  /* Odd while an update is in progress (RPU writes) */
+#define IRQPROF_HZ_OFFSET      0x08  /* Cycle counter frequency (RPU writes) */
+#define IRQPROF_PASSES_OFFSET  0x0C  /* IPI task passes profiled (RPU writes) */
+#define IRQPROF_RESET_OFFSET   0x10  /* Non-zero clears the stats (APU writes, RPU clears) */
+#define IRQPROF_STAGE_OFFSET   0x20
+#define IRQPROF_STAGES         4     /* IRQPROF_STAGE_* */
+#define IRQPROF_BUCKETS        16
+#define IRQPROF_BUCKET_SHIFT   7     /* Bucket 0: < 128 cycles, bucket n: < 2^(n+7) */
+#define IRQPROF_MAGIC          0x50524F46  /* "PROF" */
+
+/* Stages, in cycles from the IPI_Handler entry */
+#define IRQPROF_STAGE_ISR_EXIT 0  /* Interrupt handler done */
+#define IRQPROF_STAGE_TASK     1  /* IPI task running, APU flags read */
+#define IRQPROF_STAGE_ACK      2  /* First acknowledgment of the pass written */
+#define IRQPROF_STAGE_DONE     3  /* Pass complete, reverse IPI raised */
+
+/* Stage statistics (96 bytes) */
+struct rpu_irqprof_stage {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t last;
+    uint32_t sum_lo;      /* 64-bit sum of the samples, for the mean */
+    uint32_t sum_hi;
+    uint32_t reserved[2];
+    uint32_t hist[IRQPROF_BUCKETS];
+};
+
+#define IRQPROF_STAGE_SIZE     96
+#define IRQPROF_STAGE(idx)     (IRQPROF_STAGE_OFFSET + (idx) * IRQPROF_STAGE_SIZE)
+#define IRQPROF_STAGE_HIST     0x20  /* Offset of hist[] in a stage */
+
+/* AXI performance monitor block (OCM bank 0, after the IRQ profile blocks;
+ * RPU0 firmware built with RPU_APM=1). One port per PS APM, sampled every
+ * APM_PERIOD_OFFSET ms; counts are of the last interval */
+#define APM_ADDR               0xFFFC5000UL
+#define APM_SIZE               0x1000
+#define APM_MAGIC_OFFSET       0x00  /* APM_MAGIC once initialized (RPU writes) */
+#define APM_SEQ_OFFSET         0x04  /* Odd while an update is in progress (RPU writes) */
+#define APM_SAMPLES_OFFSET     0x08  /* Intervals sampled (RPU writes) */
+#define APM_PERIOD_OFFSET      0x0C  /* Sample interval in ms (RPU writes) */
+#define APM_TICKS_OFFSET       0x10  /* Last interval in system counter ticks (RPU writes) */
+#define APM_COUNT_OFFSET       0x14  /* Valid ports (RPU writes) */
+#define APM_QOS_PORTS_OFFSET   0x18  /* RPU_QOS_* ports raised by RPU_QOS=1, 0 = PS defaults (RPU writes) */
+#define APM_QOS_LEVEL_OFFSET   0x1C  /* AXI QoS they were given (RPU writes) */
+#define APM_PORT_OFFSET        0x20
+#define APM_MAX_PORTS          4
+#define APM_MAGIC              0x41504D30  /* "APM0" */
+
+/* Capture: the APU fills in the request and then bumps APM_CAP_GEN; the RPU
+ * samples one port every APM_CAP_INTERVAL APM clocks, counting only the
+ * masters whose AXI ID matches, into records in the RPU0 bulk carveout, and
+ * echoes the generation in APM_CAP_DONE once they are written. A new
+ * generation aborts a running capture. The port's periodic samples pause
+ * meanwhile */
+#define APM_CAP_GEN_OFFSET     0x100  /* A new value requests a capture (APU writes) */
+#define APM_CAP_PORT_OFFSET    0x104  /* APM_PORT_* (APU writes) */
+#define APM_CAP_ID_OFFSET      0x108  /* AXI ID of the masters to count (APU writes) */
+#define APM_CAP_ID_MASK_OFFSET 0x10C  /* ID bits compared, 0 = every master (APU writes) */
+#define APM_CAP_INTERVAL_OFFSET 0x110 /* APM clocks per record, >= APM_CAP_MIN_INTERVAL (APU writes) */
+#define APM_CAP_BUF_OFFSET     0x114  /* Records, at this offset of the RPU0 carveout (APU writes) */
+#define APM_CAP_RECORDS_OFFSET 0x118  /* Records to take (APU writes) */
+#define APM_CAP_DONE_OFFSET    0x140  /* Generation of the last capture ended (RPU writes) - own cache line */
+#define APM_CAP_STATUS_OFFSET  0x144  /* RPU_CMD_STATUS_* of it (RPU writes) */
+#define APM_CAP_COUNT_OFFSET   0x148  /* Records written (RPU writes) */
+#define APM_CAP_START_LO_OFFSET 0x14C /* System counter when the capture started (RPU writes) */
+#define APM_CAP_START_HI_OFFSET 0x150
+#define APM_CAP_MIN_INTERVAL   1000   /* Keeps the record interrupts ~10 us apart */
+
+/* Capture record (16 bytes), one per interval */
+struct rpu_apm_record {
+    uint32_t timestamp;   /* System counter, low 32 bits, when the record was taken */
+    uint32_t wr_bytes;    /* Bytes written by the matching masters in the interval */
+    uint32_t rd_bytes;
+    uint32_t rd_lat_max;  /* Longest read of theirs, APM clocks */
+};
+
+#define APM_RECORD_SIZE        16
+
+/* Ports (the PS APM each one is read from) */
+#define APM_PORT_OCM           0  /* OCM switch to the OCM */
+#define APM_PORT_LPD           1  /* LPD main switch (LPD <-> FPD) */
+#define APM_PORT_CCI           2  /* CCI (APU coherent traffic) */
+
+/* Port sample (32 bytes) */
+struct rpu_apm_port {
+    uint32_t wr_bytes;    /* Bytes written in the interval */
+    uint32_t rd_bytes;    /* Bytes read in the interval */
+    uint32_t rd_lat_max;  /* Longest read (address to last data) in the interval, APM clocks */
+    uint32_t cycles;      /* APM clocks in the interval */
+    uint32_t wr_total_lo; /* 64-bit byte totals since the firmware started */
+    uint32_t wr_total_hi;
+    uint32_t rd_total_lo;
+    uint32_t rd_total_hi;
+};
+
+#define APM_PORT_SIZE          32
+#define APM_PORT(idx)          (APM_PORT_OFFSET + (idx) * APM_PORT_SIZE)
+
+/* System monitor block (OCM bank 0, after the APM block; RPU0 firmware built
+ * with RPU_SYSMON=1). The PS SYSMON sequencer converts the channels below
+ * continuously and averages each over 256 conversions itself; the RPU
+ * publishes the latest averages every SYSMON_PERIOD_OFFSET ms, and at once
+ * when the temperature alarm sets */
+#define SYSMON_ADDR            0xFFFC6000UL
+#define SYSMON_SIZE            0x1000
+#define SYSMON_MAGIC_OFFSET    0x00  /* SYSMON_MAGIC once initialized (RPU writes) */
+#define SYSMON_SEQ_OFFSET      0x04  /* Odd while an update is in progress (RPU writes) */
+#define SYSMON_SAMPLES_OFFSET  0x08  /* Updates published (RPU writes) */
+#define SYSMON_PERIOD_OFFSET   0x0C  /* Update interval in ms (RPU writes) */
+#define SYSMON_COUNT_OFFSET    0x10  /* Valid channels (RPU writes) */
+#define SYSMON_FLAGS_OFFSET    0x14  /* SYSMON_FLAG_* (RPU writes) */
+#define SYSMON_ALARMS_OFFSET   0x18  /* Times the temperature alarm was set (RPU writes) */
+#define SYSMON_HOT_OFFSET      0x1C  /* Alarm set above this LPD temperature in mC (RPU writes) */
+#define SYSMON_COOL_OFFSET     0x20  /* ...and cleared below this one (RPU writes) */
+#define SYSMON_CH_OFFSET       0x40
+#define SYSMON_MAX_CHANNELS    8
+#define SYSMON_MAGIC           0x534D4F4E  /* "SMON" */
+
+#define SYSMON_FLAG_HOT        0x1   /* Temperature alarm active: shed load */
+
+/* Channels; temperatures are in millidegrees C (mC), supplies in mV */
+#define SYSMON_CH_TEMP_LPD     0  /* LPD (RPU side) die temperature, the alarm's */
+#define SYSMON_CH_TEMP_FPD     1  /* FPD (APU side) die temperature */
+#define SYSMON_CH_VCC_PSINTLP  2
+#define SYSMON_CH_VCC_PSINTFP  3
+#define SYSMON_CH_VCC_PSAUX    4
+#define SYSMON_CH_VCC_PSDDR    5
+
+/* Channel sample (16 bytes) */
+struct rpu_sysmon_channel {
+    int32_t  value;       /* Latest average */
+    int32_t  min;         /* Extremes of the published values since the firmware started */
+    int32_t  max;
+    uint32_t raw;         /* ADC code of the latest average */
+};
+
+#define SYSMON_CH_SIZE         16
+#define SYSMON_CH(idx)         (SYSMON_CH_OFFSET + (idx) * SYSMON_CH_SIZE)
+
+/* Multi-producer command channel (OCM bank 0, after the SYSMON block; RPU0
+ * firmware built with RPU_MPCMD=1) */
+#define MPCMD_ADDR             0xFFFC7000UL
+#define MPCMD_SIZE             0x1000
+#define MPCMD_MAGIC_OFFSET     0x000  /* MPCMD_MAGIC while RPU0 serves the channel (RPU writes) */
+#define MPCMD_SLOTS_OFFSET     0x004  /* MPCMD_SLOTS (RPU writes) */
+#define MPCMD_HEAD_OFFSET      0x040  /* Next position to claim (producers, CAS) - own cache line */
+#define MPCMD_TAIL_OFFSET      0x080  /* Next position to consume (RPU writes) - own cache line */
+#define MPCMD_STATE_OFFSET     0x084  /* SHM_RING_STATE_* (RPU writes) */
+#define MPCMD_ENTRY_OFFSET     0x100
+#define MPCMD_SLOTS            64    /* Must be a power of two */
+#define MPCMD_MASK             (MPCMD_SLOTS - 1)
+#define MPCMD_MAGIC            0x4D504344  /* "MPCD" */
+
+/* Entry (16 bytes) */
+struct rpu_mpcmd_entry {
+    uint32_t seq;     /* Slot sequence: pos free, pos + 1 published */
+    uint32_t opcode;  /* RPU_CMD_* */
+    uint32_t arg;
+    uint32_t source;  /* Producer id (APU: process id; RPU1: MPCMD_SOURCE_RPU1), traced */
+};
+
+#define MPCMD_ENTRY_SIZE       16
+#define MPCMD_ENTRY(pos)       (MPCMD_ENTRY_OFFSET + ((pos) & MPCMD_MASK) * MPCMD_ENTRY_SIZE)
+#define MPCMD_ENT_SEQ          0x0
+#define MPCMD_ENT_OPCODE       0x4
+#define MPCMD_ENT_ARG          0x8
+#define MPCMD_ENT_SOURCE       0xC
+
+/* Done words, one per slot (RPU writes): the low 24 bits of the position and
+ * the RPU_CMD_STATUS_* of its command. A producer reads its status before
+ * the slot is consumed again, MPCMD_SLOTS positions later */
+#define MPCMD_DONE_OFFSET      (MPCMD_ENTRY_OFFSET + MPCMD_SLOTS * MPCMD_ENTRY_SIZE)
+#define MPCMD_DONE_WORD(pos)   (MPCMD_DONE_OFFSET + ((pos) & MPCMD_MASK) * 4)
+#define MPCMD_DONE(pos, status) (((uint32_t)(pos) << 8) | ((status) & 0xFF))
+#define MPCMD_DONE_MATCH(done, pos) (((done) >> 8) == ((uint32_t)(pos) & 0xFFFFFF))
+#define MPCMD_DONE_STATUS(done) ((done) & 0xFF)
+
+#define MPCMD_SOURCE_RPU1      0x80000001
+
+/* PC-sampling profile (OCM bank 0, after the MPCMD block; firmware built
+ * with RPU_PC_PROF=1) */
+#define PCPROF_ADDR_RPU0       0xFFFC8000UL
+#define PCPROF_SIZE            0x4000
+#define PCPROF_ADDR(core)      (PCPROF_ADDR_RPU0 + (core) * PCPROF_SIZE)
+#define PCPROF_MAGIC_OFFSET    0x00  /* PCPROF_MAGIC while sampling (RPU writes) */
+#define PCPROF_SEQ_OFFSET      0x04  /* Odd while the layout is written (RPU writes) */
+#define PCPROF_HZ_OFFSET       0x08  /* Sampling rate (RPU writes) */
+#define PCPROF_SHIFT_OFFSET    0x0C  /* log2 of the bin size in bytes (RPU writes) */
+#define PCPROF_SAMPLES_OFFSET  0x10  /* Samples taken, free-running (RPU writes) */
+#define PCPROF_OUTSIDE_OFFSET  0x14  /* Samples outside every range (RPU writes) */
+#define PCPROF_HANDLER_OFFSET  0x18  /* Samples that interrupted a handler, not a task (RPU writes) */
+#define PCPROF_RANGE_OFFSET    0x20
+#define PCPROF_RANGES          2     /* PCPROF_RANGE_* */
+#define PCPROF_BIN_OFFSET      0x40  /* uint32_t counters, free-running */
+#define PCPROF_MAX_BINS        ((PCPROF_SIZE - PCPROF_BIN_OFFSET) / 4)
+#define PCPROF_MAGIC           0x50435046  /* "PCPF" */
+
+#define PCPROF_RANGE_ATCM      0  /* Vectors and .atcm_text */
+#define PCPROF_RANGE_TEXT      1  /* .text in DDR */
+
+/* Code range (16 bytes): bins [first, first + bins) of the block count
+ * [low, low + (bins << shift)) */
+struct rpu_pcprof_range {
+    uint32_t low;     /* Aligned to the bin size */
+    uint32_t bins;
+    uint32_t first;
+    uint32_t reserved;
+};
+
+#define PCPROF_RANGE_SIZE      16
+#define PCPROF_RANGE(idx)      (PCPROF_RANGE_OFFSET + (idx) * PCPROF_RANGE_SIZE)
+#define PCPROF_BIN(idx)        (PCPROF_BIN_OFFSET + (idx) * 4)
+
+/* Sensor acquisition (OCM bank 0, after the PC profile blocks; RPU0 firmware
+ * built with RPU_SENSOR=1) */
+#define SENSOR_ADDR            0xFFFD0000UL
+#define SENSOR_SIZE            0x4000
+#define SENSOR_MAGIC_OFFSET    0x00  /* SENSOR_MAGIC while sampling (RPU writes) */
+#define SENSOR_HZ_OFFSET       0x04  /* Trigger rate (RPU writes) */
+#define SENSOR_BUS_OFFSET      0x08  /* SENSOR_BUS_* (RPU writes) */
+#define SENSOR_DEV_OFFSET      0x0C  /* I2C slave address or SPI chip select (RPU writes) */
+#define SENSOR_REG_OFFSET      0x10  /* First register of the read (RPU writes) */
+#define SENSOR_LEN_OFFSET      0x14  /* Bytes per sample (RPU writes) */
+#define SENSOR_TRIGGERS_OFFSET 0x18  /* Timer triggers, free-running (RPU writes) */
+#define SENSOR_SAMPLES_OFFSET  0x1C  /* Samples published (RPU writes) */
+#define SENSOR_SKIPPED_OFFSET  0x20  /* Triggers with no free buffer (RPU writes) */
+#define SENSOR_ERRORS_OFFSET   0x24  /* Failed reads: NACK, arbitration, timeout (RPU writes) */
+#define SENSOR_FULL_OFFSET     0x28  /* Samples dropped to a full ring (RPU writes) */
+#define SENSOR_XFER_MAX_OFFSET 0x2C  /* Longest trigger to publication in ns (RPU writes) */
+#define SENSOR_RING_OFFSET     0x100 /* rpu_ring.h block of struct rpu_sensor_sample */
+#define SENSOR_RING_SLOTS      256
+#define SENSOR_MAGIC           0x53454E53  /* "SENS" */
+
+#define SENSOR_BUS_I2C         1
+#define SENSOR_BUS_SPI         2
+
+#define SENSOR_MAX_BYTES       32
+
+/* Ring slot (48 bytes) */
+struct rpu_sensor_sample {
+    uint32_t seq;       /* Trigger count of the sample */
+    uint32_t ts_lo;     /* System counter at the trigger */
+    uint32_t ts_hi;
+    uint32_t len;       /* Bytes of data */
+    uint8_t  data[SENSOR_MAX_BYTES];  /* Register contents, in bus order */
+};
+
+#define SENSOR_SAMPLE_SIZE     48
+
+/* Workload governor (OCM bank 0, after the sensor block; RPU0 firmware built
+ * with RPU_GOVERNOR=1) */
+#define GOV_ADDR               0xFFFD4000UL
+#define GOV_SIZE               0x1000
+#define GOV_MAGIC_OFFSET       0x00  /* GOV_MAGIC once initialized (RPU writes) */
+#define GOV_SEQ_OFFSET         0x04  /* Odd while an update is in progress (RPU writes) */
+#define GOV_STATE_OFFSET       0x08  /* GOV_STATE_* (RPU writes) */
+#define GOV_FULL_HZ_OFFSET     0x0C  /* R5 clock at full rate (RPU writes) */
+#define GOV_LOW_HZ_OFFSET      0x10  /* R5 clock in the low state (RPU writes) */
+#define GOV_GATED_OFFSET       0x14  /* Peripheral clocks gated in the low state (RPU writes) */
+#define GOV_ENTRIES_OFFSET     0x18  /* Times the low state was entered (RPU writes) */
+#define GOV_WAKES_OFFSET       0x1C  /* Times an IPI brought the full rate back (RPU writes) */
+#define GOV_WAKE_LAST_OFFSET   0x20  /* Last wake-up latency in ns (RPU writes) */
+#define GOV_WAKE_MAX_OFFSET    0x24  /* Longest wake-up latency in ns (RPU writes) */
+#define GOV_WAKE_SUM_LO        0x28  /* Sum of the wake-up latencies in ns (RPU writes) */
+#define GOV_WAKE_SUM_HI        0x2C
+#define GOV_LOW_TIME_LO        0x30  /* System counter ticks spent in the low state (RPU writes) */
+#define GOV_LOW_TIME_HI        0x34
+#define GOV_NOW_LO             0x38  /* System counter at the update (RPU writes) */
+#define GOV_NOW_HI             0x3C
+#define GOV_MAGIC              0x474F5652  /* "GOVR" */
+
+#define GOV_STATE_FULL         0
+#define GOV_STATE_LOW          1
+
+/* Watchdog supervision (OCM bank 0, after the governor block; RPU0 firmware
+ * built with RPU_WATCHDOG=1) */
+#define WDOG_ADDR              0xFFFD5000UL
+#define WDOG_SIZE              0x1000
+#define WDOG_MAGIC_OFFSET      0x00  /* WDOG_MAGIC once initialized (RPU writes) */
+#define WDOG_SEQ_OFFSET        0x04  /* Odd while an update is in progress (RPU writes) */
+#define WDOG_WINDOW_MS_OFFSET  0x08  /* Supervision window (RPU writes) */
+#define WDOG_TIMEOUT_MS_OFFSET 0x0C  /* Watchdog expiry without a restart (RPU writes) */
+#define WDOG_WINDOWS_OFFSET    0x10  /* Windows evaluated (RPU writes) */
+#define WDOG_KICKS_OFFSET      0x14  /* Windows that restarted the watchdog (RPU writes) */
+#define WDOG_FAILED_OFFSET     0x18  /* Windows that did not (RPU writes) */
+#define WDOG_LAST_FAIL_OFFSET  0x1C  /* Mask of the tasks of the last failed window (RPU writes) */
+#define WDOG_COUNT_OFFSET      0x20  /* Supervised tasks (RPU writes) */
+#define WDOG_TASK_OFFSET       0x40
+#define WDOG_MAX_TASKS         8
+#define WDOG_MAGIC             0x57444F47  /* "WDOG" */
+
+/* Supervised tasks, indexed as the entries */
+#define WDOG_TASK_TX           0
+#define WDOG_TASK_RX           1
+#define WDOG_TASK_CMD          2
+
+/* Per-task entry (16 bytes) */
+struct rpu_wdog_task {
+    uint32_t met;       /* Deadlines met */
+    uint32_t missed;    /* Deadlines missed */
+    uint32_t stalls;    /* Windows failed by silence or an overdue command */
+    uint32_t worst_us;  /* Latest completion relative to its due time */
+};
+
+#define WDOG_TASK_SIZE         16
+#define WDOG_TASK(idx)         (WDOG_TASK_OFFSET + (idx) * WDOG_TASK_SIZE)
+
+/* Kernel latency benchmark (OCM bank 0, after the watchdog block; RPU0
+ * firmware built with RPU_BENCH=1) */
+#define BENCH_ADDR             0xFFFD6000UL
+#define BENCH_SIZE             0x1000
+#define BENCH_MAGIC_OFFSET     0x00  /* BENCH_MAGIC once initialized (RPU writes) */
+#define BENCH_SEQ_OFFSET       0x04  /* Odd while an update is in progress (RPU writes) */
+#define BENCH_HZ_OFFSET        0x08  /* Cycle counter frequency (RPU writes) */
+#define BENCH_ROUNDS_OFFSET    0x0C  /* Rounds completed (RPU writes) */
+#define BENCH_ITERATIONS_OFFSET 0x10 /* Samples of every test in a round (RPU writes) */
+#define BENCH_COUNT_OFFSET     0x14  /* Tests (RPU writes) */
+#define BENCH_TEST_OFFSET      0x20
+#define BENCH_MAGIC            0x424E4348  /* "BNCH" */
+
+/* Tests, in cycles */
+#define BENCH_TEST_YIELD       0  /* taskYIELD() until a task of the same priority runs */
+#define BENCH_TEST_SEM         1  /* Semaphore to a higher-priority task and back (round trip) */
+#define BENCH_TEST_QUEUE       2  /* xQueueSend() until the higher-priority receiver runs */
+#define BENCH_TEST_NOTIFY      3  /* xTaskNotify() until the notified task runs */
+#define BENCH_TEST_IRQ         4  /* SGI written until its handler runs */
+#define BENCH_TEST_ISR_TASK    5  /* Handler entry until the task it notified runs */
+#define BENCH_TESTS            6
+
+/* A test entry is a struct rpu_irqprof_stage */
+#define BENCH_TEST(idx)        (BENCH_TEST_OFFSET + (idx) * IRQPROF_STAGE_SIZE)
+
+/* Memory watermarks of each core (OCM bank 0, after the benchmark block;
+ * published with the task stats) */
+#define MEM_ADDR_RPU0          0xFFFD7000UL
+#define MEM_SIZE               0x1000  /* A page each, for /dev/mem */
+#define MEM_ADDR(core)         (MEM_ADDR_RPU0 + (core) * MEM_SIZE)
+#define MEM_MAGIC_OFFSET       0x00  /* MEM_MAGIC once initialized (RPU writes) */
+#define MEM_SEQ_OFFSET         0x04  /* Odd while an update is in progress (RPU writes) */
+#define MEM_COUNT_OFFSET       0x08  /* Valid task entries (RPU writes) */
+#define MEM_HEAP_SIZE_OFFSET   0x0C  /* FreeRTOS heap bytes, 0 without a heap (RPU writes) */
+#define MEM_HEAP_FREE_OFFSET   0x10  /* Free heap bytes (RPU writes) */
+#define MEM_HEAP_MIN_OFFSET    0x14  /* Lowest free heap bytes so far (RPU writes) */
+#define MEM_MODE_OFFSET        0x20
+#define MEM_TASK_OFFSET        0x80
+#define MEM_MAX_TASKS          SHM_STATS_MAX_TASKS
+#define MEM_MAGIC              0x4D454D57  /* "MEMW" */
+
+/* Exception mode stacks, indexed as the mode entries */
+#define MEM_MODE_SVC           0  /* Kernel calls and the nested interrupt handlers */
+#define MEM_MODE_IRQ           1  /* Interrupt entry, before the switch to SVC */
+#define MEM_MODE_FIQ           2
+#define MEM_MODE_ABORT         3
+#define MEM_MODE_UNDEF         4
+#define MEM_MODES              5
+
+/* Mode stack entry (8 bytes) */
+struct rpu_mem_stack {
+    uint32_t size;       /* Bytes */
+    uint32_t min_free;   /* Lowest free bytes since the firmware started */
+};
+
+#define MEM_STACK_SIZE         8
+#define MEM_MODE(idx)          (MEM_MODE_OFFSET + (idx) * MEM_STACK_SIZE)
+
+/* Task entry (24 bytes) */
+struct rpu_mem_task {
+    char     name[SHM_STATS_NAME_LEN];
+    uint32_t size;       /* Stack bytes, 0 if the task was not recorded */
+    uint32_t min_free;   /* Lowest free stack bytes (high-water mark) */
+    uint32_t number;     /* FreeRTOS task number, as in the task stats */
+};
+
+#define MEM_TASK_SIZE          24
+#define MEM_TASK(idx)          (MEM_TASK_OFFSET + (idx) * MEM_TASK_SIZE)
+
+/* Hot-swap state of each core (OCM bank 0, after the memory watermark
+ * blocks; RPU_CMD_HANDOFF) */
+#define HANDOFF_ADDR_RPU0      0xFFFD9000UL
+#define HANDOFF_SIZE           0x1000  /* A page each, for /dev/mem */
+#define HANDOFF_ADDR(core)     (HANDOFF_ADDR_RPU0 + (core) * HANDOFF_SIZE)
+#define HANDOFF_MAGIC_OFFSET   0x00  /* HANDOFF_MAGIC once saved, HANDOFF_RESUMED once taken */
+#define HANDOFF_VERSION_OFFSET 0x04  /* HANDOFF_VERSION of the layout below */
+#define HANDOFF_STAMP_LO       0x08  /* System counter when the state was saved */
+#define HANDOFF_STAMP_HI       0x0C
+#define HANDOFF_MODE_OFFSET    0x10  /* Blink mode, 0=SLOW 1=FAST 2=RANDOM */
+#define HANDOFF_OVERRIDE_OFFSET 0x14 /* Nonzero: mode set by the APU, no rotation */
+#define HANDOFF_LEGACY_OFFSET  0x18  /* Legacy mailbox mode applied last (3 = released) */
+#define HANDOFF_LED_OFFSET     0x1C  /* Value on the LEDs */
+#define HANDOFF_FRAME_MS_OFFSET 0x20 /* Time left to the next frame */
+#define HANDOFF_ROTATE_MS_OFFSET 0x24 /* Time left to the next mode rotation */
+#define HANDOFF_GAP_US_OFFSET  0x28  /* Save to resume, written by the new image */
+#define HANDOFF_MAGIC          0x484F4646  /* "HOFF" */
+#define HANDOFF_RESUMED        0x52534D44  /* "RSMD" */
+#define HANDOFF_VERSION        1
+
+/* Memory hierarchy benchmark (OCM, after the handoff blocks; RPU0 firmware
+ * built with RPU_MEMBENCH=1). Entries are rewritten by every pass */
+#define MEMBENCH_ADDR          0xFFFDB000UL
+#define MEMBENCH_SIZE          0x1000
+#define MEMBENCH_MAGIC_OFFSET  0x00  /* MEMBENCH_MAGIC once initialized (RPU writes) */
+#define MEMBENCH_SEQ_OFFSET    0x04  /* Odd while a pass is in progress (RPU writes) */
+#define MEMBENCH_HZ_OFFSET     0x08  /* Cycle counter frequency (RPU writes) */
+#define MEMBENCH_COUNT_OFFSET  0x0C  /* Entries of the last pass (RPU writes) */
+#define MEMBENCH_TCM_OFFSET    0x10  /* Global address of the TCM scratch (RPU writes) */
+#define MEMBENCH_GEN_OFFSET    0x40  /* A new value requests a pass (APU writes) */
+#define MEMBENCH_DONE_OFFSET   0x80  /* Generation of the last pass ended (RPU writes) - own cache line */
+#define MEMBENCH_ENTRY_OFFSET  0x100
+#define MEMBENCH_MAX_ENTRIES   16
+#define MEMBENCH_MAGIC         0x4D454D42  /* "MEMB" */
+
+/* Scratch ranges, overwritten by a pass (and by apu_app/mem_bench). The OCM
+ * range is below the ATF in OCM bank 2; the DDR range is the start of the
+ * RPU0 bulk carveout, so no bulk transfer may run during a pass */
+#define MEMBENCH_TCM_SIZE      0x1000        /* In the RPU0 BTCM, at MEMBENCH_TCM_OFFSET */
+#define MEMBENCH_OCM_ADDR      0xFFFE0000UL
+#define MEMBENCH_OCM_SIZE      0x8000
+#define MEMBENCH_DDR_ADDR      BULK_DDR_ADDR
+#define MEMBENCH_DDR_SIZE      0x10000
+#define MEMBENCH_PL_ADDR       0x80000000UL  /* AXI GPIO DATA: single-word tests only */
+
+/* Regions */
+#define MEMBENCH_REGION_TCM    0
+#define MEMBENCH_REGION_OCM    1
+#define MEMBENCH_REGION_DDR    2
+#define MEMBENCH_REGION_PL     3
+
+/* Memory types: the R5 MPU attribute of the range during the tests (the TCM
+ * has none, its entry is MEMBENCH_ATTR_NCACHE) */
+#define MEMBENCH_ATTR_CACHED   0  /* NORM_NSHARED_WB_WA */
+#define MEMBENCH_ATTR_NCACHE   1  /* NORM_SHARED_NCACHE */
+#define MEMBENCH_ATTR_STRONG   2  /* STRONG_ORDERD_SHARED */
+
+/* Entry (48 bytes); a test that does not apply has 0 operations */
+struct rpu_membench_entry {
+    uint32_t region;        /* MEMBENCH_REGION_* */
+    uint32_t attr;          /* MEMBENCH_ATTR_* */
+    uint32_t bytes;         /* Range swept by the chase and the sweeps */
+    uint32_t chase_loads;   /* Dependent loads of the pointer chase */
+    uint32_t chase_cycles;
+    uint32_t sweep_bytes;   /* Bytes read and written by the sweeps */
+    uint32_t rd_cycles;
+    uint32_t wr_cycles;
+    uint32_t word_ops;      /* Single-word reads, and as many writes, of one address */
+    uint32_t word_rd_cycles;
+    uint32_t word_wr_cycles;
+    uint32_t reserved;
+};
+
+#define MEMBENCH_ENTRY_SIZE    48
+#define MEMBENCH_ENTRY(idx)    (MEMBENCH_ENTRY_OFFSET + (idx) * MEMBENCH_ENTRY_SIZE)
+
+/* Line after line idx in the pointer chase of a range of lines lines (a power
+ * of two): a full-period LCG, so one lap visits every line once, scattered */
+#define MEMBENCH_CHASE_NEXT(idx, lines) (((uint32_t)(idx) * 1103515245U + 12345U) & ((lines) - 1U))
+
+/* Inter-R5 messages (OCM bank 0, after the memory benchmark; both firmwares
+ * built with RPU_XCORE=1, rpu_xcore.h). One rpu_ring.h ring per direction,
+ * each formatted by the core that consumes it and filled by the other */
+#define XCORE_ADDR             0xFFFDC000UL
+#define XCORE_RING_SIZE        0x1000
+#define XCORE_RING_ADDR(core)  (XCORE_ADDR + (core) * XCORE_RING_SIZE)  /* Inbox of core */
+#define XCORE_SLOTS            64
+#define XCORE_SLOT_SIZE        32
+
+/* PL interrupts (OCM bank 0, after the inter-R5 rings; RPU0 firmware built
+ * with RPU_PL_INTR=1, rpu_plintr.h). Counters of the interrupt_gen channels
+ * the R5 serviced, in the terms of struct pl_intr_channel (pl_intr_ioctl.h)
+ * so the two paths compare directly; latencies are PL clocks from the
+ * event's hardware timestamp to the handler. The handler updates them under
+ * PLINTR_SEQ_OFFSET */
+#define PLINTR_ADDR            0xFFFDE000UL
+#define PLINTR_SIZE            0x1000
+#define PLINTR_MAGIC_OFFSET    0x00  /* PLINTR_MAGIC once initialized (RPU writes) */
+#define PLINTR_SEQ_OFFSET      0x04  /* Odd while an update is in progress (RPU writes) */
+#define PLINTR_CHANNELS_OFFSET 0x08  /* Channels of the generator (RPU writes) */
+#define PLINTR_IRQS_OFFSET     0x0C  /* Controller interrupts taken (RPU writes) */
+#define PLINTR_SPURIOUS_OFFSET 0x10  /* ...with no channel pending (RPU writes) */
+#define PLINTR_CLK_HZ_OFFSET   0x14  /* PL clock of the timestamps, RPU_PL_INTR_CLK_HZ (RPU writes) */
+#define PLINTR_CH_OFFSET       0x40
+#define PLINTR_MAX_CHANNELS    16    /* INTERRUPT_GEN_MAX_CHANNELS */
+#define PLINTR_MAGIC           0x504C4952  /* "PLIR" */
+
+/* Per-channel entry (32 bytes) */
+struct rpu_plintr_channel {
+    uint32_t events;        /* Events (period expiries, triggers) since the firmware started */
+    uint32_t irqs;          /* Interrupts handled */
+    uint32_t lost;          /* Events beyond the first of an interrupt: lost unless coalescing */
+    uint32_t latency_last;  /* PL clocks from the event to the R5 handler */
+    uint32_t latency_min;
+    uint32_t latency_max;
+    uint32_t latency_sum_lo;  /* Sum over irqs, for the mean */
+    uint32_t latency_sum_hi;
+};
+
+#define PLINTR_CH_SIZE         32
+#define PLINTR_CH(idx)         (PLINTR_CH_OFFSET + (idx) * PLINTR_CH_SIZE)
+
+#if (SHM_RING_DESC_OFFSET + SHM_RING_SLOTS * SHM_RING_DESC_SIZE) > SHM_IPI_REQ_OFFSET
+#error "Command ring overlaps the IPI message buffers"
+#endif
+
+#if (SHM_RING_DESC_OFFSET + SHM_RING_SLOTS * SHM_RING_DESC_SIZE) > SHM_URING_HEAD_OFFSET || \
+    (SHM_URING_DESC_OFFSET + SHM_URING_SLOTS * SHM_RING_DESC_SIZE) > SHM_IPI_REQ_OFFSET
+#error "Urgent ring overlaps the command ring or the IPI message buffers"
+#endif
+
+#if (SHM_IPI_RESP_OFFSET + (RPU_CORE_COUNT - 1) * SHM_IPI_CORE_STRIDE + SHM_IPI_MSG_WORDS * 4) > SHM_WAVE_HDR_OFFSET
+#error "IPI message buffers overlap the waveform table"
+#endif
+
+#if (SHM_WAVE_SAMPLE_OFFSET + SHM_WAVE_MAX_SAMPLES * 4) > SHM_TRACE_HDR_OFFSET
+#error "Waveform table overlaps the trace buffer"
+#endif
+
+#if (SHM_TRACE_ENTRY_OFFSET + SHM_TRACE_SLOTS * SHM_TRACE_ENTRY_SIZE) > SHM_STATS_HDR_OFFSET
+#error "Trace buffer overlaps the task stats"
+#endif
+
+#if (SHM_TRACEZ_BLOCKS * SHM_TRACEZ_BLOCK_SIZE) > (SHM_TRACE_SLOTS * SHM_TRACE_ENTRY_SIZE)
+#error "Compact trace blocks overflow the trace buffer"
+#endif
+
+/* 0xC0: control area of an rpu_ring.h block */
+#if (0xC0 + XCORE_SLOTS * XCORE_SLOT_SIZE) > XCORE_RING_SIZE
+#error "Inter-R5 ring overflows its block"
+#endif
+
+#if (MEMBENCH_ADDR + MEMBENCH_SIZE) > XCORE_ADDR || \
+    (XCORE_ADDR + RPU_CORE_COUNT * XCORE_RING_SIZE) > MEMBENCH_OCM_ADDR
+#error "Inter-R5 rings overlap the memory benchmark block or its scratch"
+#endif
+
+#if (XCORE_ADDR + RPU_CORE_COUNT * XCORE_RING_SIZE) > PLINTR_ADDR || \
+    (PLINTR_ADDR + PLINTR_SIZE) > MEMBENCH_OCM_ADDR
+#error "PL interrupt block overlaps the inter-R5 rings or the memory benchmark scratch"
+#endif
+
+#if PLINTR_CH(PLINTR_MAX_CHANNELS) > PLINTR_SIZE
+#error "PL interrupt channels overflow the block"
+#endif
+
+#if (BULK_DESC_OFFSET + BULK_SLOTS * BULK_DESC_SIZE) > BULK_CTRL_SIZE
+#error "Bulk descriptors overflow the control block"
+#endif
+
+#if (BULK_DDR_ADDR + BULK_DDR_SIZE) > RPMSG_SHM_ADDR
+#error "Bulk carveout overlaps the RPMsg memory"
+#endif
+
+#if (SHARED_MEM_ADDR_RPU1 + SHARED_MEM_SIZE) > BULK_CTRL_ADDR_RPU0
+#error "Bulk control blocks overlap the RPU1 window"
+#endif
+
+#if (BULK_CTRL_ADDR_RPU0 + RPU_CORE_COUNT * BULK_CTRL_SIZE) > IRQPROF_ADDR_RPU0
+#error "IRQ profile blocks overlap the bulk control blocks"
+#endif
+
+#if (IRQPROF_ADDR_RPU0 + RPU_CORE_COUNT * IRQPROF_SIZE) > APM_ADDR
+#error "APM block overlaps the IRQ profile blocks"
+#endif
+
+#if (APM_ADDR + APM_SIZE) > SYSMON_ADDR
+#error "SYSMON block overlaps the APM block"
+#endif
+
+#if (SYSMON_CH_OFFSET + SYSMON_MAX_CHANNELS * SYSMON_CH_SIZE) > SYSMON_SIZE
+#error "SYSMON channels overflow the block"
+#endif
+
+#if (SYSMON_ADDR + SYSMON_SIZE) > MPCMD_ADDR
+#error "Multi-producer command block overlaps the SYSMON block"
+#endif
+
+#if (MPCMD_DONE_OFFSET + MPCMD_SLOTS * 4) > MPCMD_SIZE
+#error "Multi-producer command slots overflow the block"
+#endif
+
+#if (MPCMD_ADDR + MPCMD_SIZE) > PCPROF_ADDR_RPU0
+#error "PC profile blocks overlap the multi-producer command block"
+#endif
+
+#if (PCPROF_ADDR_RPU0 + RPU_CORE_COUNT * PCPROF_SIZE) > SENSOR_ADDR
+#error "Sensor block overlaps the PC profile blocks"
+#endif
+
+#if (SENSOR_ADDR + SENSOR_SIZE) > GOV_ADDR
+#error "Governor block overlaps the sensor block"
+#endif
+
+#if (GOV_ADDR + GOV_SIZE) > WDOG_ADDR
+#error "Watchdog block overlaps the governor block"
+#endif
+
+#if (WDOG_TASK_OFFSET + WDOG_MAX_TASKS * WDOG_TASK_SIZE) > WDOG_SIZE
+#error "Watchdog task entries overflow the block"
+#endif
+
+#if (WDOG_ADDR + WDOG_SIZE) > BENCH_ADDR
+#error "Benchmark block overlaps the watchdog block"
+#endif
+
+#if BENCH_TEST(BENCH_TESTS) > BENCH_SIZE
+#error "Benchmark tests overflow the block"
+#endif
+
+#if (BENCH_ADDR + BENCH_SIZE) > MEM_ADDR_RPU0
+#error "Memory watermark blocks overlap the benchmark block"
+#endif
+
+#if MEM_MODE(MEM_MODES) > MEM_TASK_OFFSET
+#error "Memory watermark mode stacks overlap the task entries"
+#endif
+
+#if MEM_TASK(MEM_MAX_TASKS) > MEM_SIZE
+#error "Memory watermark task entries overflow the block"
+#endif
+
+#if (MEM_ADDR_RPU0 + RPU_CORE_COUNT * MEM_SIZE) > HANDOFF_ADDR_RPU0
+#error "Handoff blocks overlap the memory watermark blocks"
+#endif
+
+#if (HANDOFF_ADDR_RPU0 + RPU_CORE_COUNT * HANDOFF_SIZE) > MEMBENCH_ADDR
+#error "Memory benchmark block overlaps the handoff blocks"
+#endif
+
+#if MEMBENCH_ENTRY(MEMBENCH_MAX_ENTRIES) > MEMBENCH_SIZE
+#error "Memory benchmark entries overflow the block"
+#endif
+
+#if (MEMBENCH_ADDR + MEMBENCH_SIZE) > MEMBENCH_OCM_ADDR
+#error "Memory benchmark OCM scratch overlaps its block"
+#endif
+
+/* 0xC0: control area of the rpu_ring.h block */
+#if (SENSOR_RING_OFFSET + 0xC0 + SENSOR_RING_SLOTS * SENSOR_SAMPLE_SIZE) > SENSOR_SIZE
+#error "Sensor ring overflows the block"
+#endif
+
+#if (PCPROF_RANGE_OFFSET + PCPROF_RANGES * PCPROF_RANGE_SIZE) > PCPROF_BIN_OFFSET
+#error "PC profile ranges overlap the bins"
+#endif
+
+#if (IRQPROF_STAGE_OFFSET + IRQPROF_STAGES * IRQPROF_STAGE_SIZE) > IRQPROF_SIZE
+#error "IRQ profile stages overflow the block"
+#endif
+
+#if (SHM_STATS_ENTRY_OFFSET + SHM_STATS_MAX_TASKS * SHM_STATS_ENTRY_SIZE) > SHM_TIME_HDR_OFFSET
+#error "Task stats overlap the time base"
+#endif
+
+#if (SHM_TIME_HDR_OFFSET + SHM_TIME_HDR_SIZE) > SHARED_MEM_SIZE
+#error "Time base does not fit in the shared memory window"
+#endif
+
+#endif /* RPU_SHM_H */
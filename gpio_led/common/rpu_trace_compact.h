@@ -0,0 +1,230 @@
+/*
+ * Compact encoding of the RPU event trace
+ *
+ * Header-only, shared between the RPU firmware (C, the encoder, built with
+ * RPU_TRACE_COMPACT=1) and the APU side (the decoder: the C++ tools, and
+ * rpu_ipi for /dev/rpu_trace). The fixed
+ * trace spends 24 bytes and six uncached word stores on every event, most
+ * of them on the 64-bit timestamp and on arguments that are small or close
+ * to the previous ones; this coding keeps the same events in a few bytes.
+ *
+ * The trace area of the window holds SHM_TRACEZ_BLOCKS blocks
+ * (rpu_shm.h). A block starts with the full timestamp of its first event
+ * and the index of that event, followed by records of variable length:
+ *
+ *   u8      header   bits 0-3 event (RPU_TRACE_*), bit 4 arg0 follows,
+ *                    bit 5 arg1 follows, bits 6-7 zero
+ *   varint  delta    system counter ticks since the previous event of
+ *                    the block (the block's base for the first)
+ *   varint  arg0     if bit 4, coded as the dictionary says
+ *   varint  arg1     if bit 5
+ *
+ * Varints are LEB128: 7 bits a byte, least significant first, bit 7 set on
+ * all bytes but the last. A coded argument of 0 is left out, its header bit
+ * clear. The dictionary gives per event type how each argument is coded:
+ * as is, zigzag (a signed value, small either side of 0) or as the zigzag
+ * difference to the same argument of the previous event of that type in
+ * the block (sequence numbers, deadlines, ring indices). A block never
+ * depends on another one, so a reader that lost blocks resumes at the next.
+ *
+ * Event types are 4 bits: RPU_TRACE_* past 15 need another header layout.
+ */
+
+#ifndef RPU_TRACE_COMPACT_H
+#define RPU_TRACE_COMPACT_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+#include "rpu_shm.h"
+
+#define RPU_TRACEZ_EVENTS      16
+#define RPU_TRACEZ_MAX_RECORD  21    /* Header, 10-byte delta, two 5-byte arguments */
+
+/* Header bits */
+#define RPU_TRACEZ_H_EVENT     0x0FU
+#define RPU_TRACEZ_H_ARG0      0x10U
+#define RPU_TRACEZ_H_ARG1      0x20U
+#define RPU_TRACEZ_H_RESERVED  0xC0U
+
+/* Dictionary: coding of each argument, per event type */
+#define RPU_TRACEZ_SIGNED0     0x01U  /* arg0 zigzag */
+#define RPU_TRACEZ_SIGNED1     0x02U  /* arg1 zigzag */
+#define RPU_TRACEZ_DELTA0      0x04U  /* arg0 as the zigzag difference to the previous one */
+#define RPU_TRACEZ_DELTA1      0x08U  /* arg1 likewise */
+
+static const uint8_t rpu_tracez_dict[RPU_TRACEZ_EVENTS] = {
+    0,
+    0,                                          /* IPI_RX: ISR bits */
+    0,                                          /* CMD_START: none */
+    RPU_TRACEZ_DELTA1,                          /* RING_DRAIN: count, tail */
+    RPU_TRACEZ_DELTA0 | RPU_TRACEZ_DELTA1,      /* ACK: seq, ack value */
+    0,                                          /* MODE */
+    0,                                          /* GPIO_WRITE */
+    0,                                          /* WAVE */
+    RPU_TRACEZ_DELTA0,                          /* MSG: header with its seq, status */
+    RPU_TRACEZ_DELTA0,                          /* MBOX: generation, mode */
+    0,                                          /* BULK */
+    0,                                          /* GPIO_IN */
+    0,                                          /* MPCMD */
+    RPU_TRACEZ_DELTA0 | RPU_TRACEZ_SIGNED1,     /* EDGE: deadline tick, signed error */
+    RPU_TRACEZ_SIGNED1,                         /* TIMED: opcode | status, signed error */
+    RPU_TRACEZ_DELTA1,                          /* URGENT: count, tail */
+};
+
+/* Coding state of one block, on either side */
+struct rpu_tracez_state {
+    uint64_t ts;                              /* Timestamp of the previous event */
+    uint32_t index;                           /* Index of the next event */
+    uint32_t pos;                             /* Decoder: next record byte */
+    uint32_t prev[2][RPU_TRACEZ_EVENTS];      /* DELTA arguments of the previous event */
+};
+
+/* Start a block whose first event has index first, at base */
+static inline void rpu_tracez_begin(struct rpu_tracez_state *s, uint64_t base, uint32_t first)
+{
+    uint32_t e;
+
+    s->ts = base;
+    s->index = first;
+    s->pos = 0;
+    for (e = 0; e < RPU_TRACEZ_EVENTS; e++) {
+        s->prev[0][e] = 0;
+        s->prev[1][e] = 0;
+    }
+}
+
+static inline uint32_t rpu_tracez_zigzag(uint32_t v)
+{
+    return (v << 1) ^ (uint32_t)((int32_t)v >> 31);
+}
+
+static inline uint32_t rpu_tracez_unzigzag(uint32_t v)
+{
+    return (v >> 1) ^ (0U - (v & 1U));
+}
+
+static inline uint32_t rpu_tracez_put(uint8_t *buf, uint64_t v)
+{
+    uint32_t n = 0;
+
+    while (v >= 0x80U) {
+        buf[n++] = (uint8_t)(v | 0x80U);
+        v >>= 7;
+    }
+    buf[n++] = (uint8_t)v;
+    return n;
+}
+
+/* Coded value of argument a (0 or 1) of event */
+static inline uint32_t rpu_tracez_code(const struct rpu_tracez_state *s, uint32_t event,
+                                       uint32_t a, uint32_t v)
+{
+    uint8_t d = rpu_tracez_dict[event] >> a;
+
+    if (d & RPU_TRACEZ_DELTA0) {
+        return rpu_tracez_zigzag(v - s->prev[a][event]);
+    }
+    return (d & RPU_TRACEZ_SIGNED0) ? rpu_tracez_zigzag(v) : v;
+}
+
+/* Encode an event at ts into buf (RPU_TRACEZ_MAX_RECORD bytes) without
+ * changing the state; returns its length, 0 for an event that has no code */
+static inline uint32_t rpu_tracez_encode(const struct rpu_tracez_state *s, uint8_t *buf,
+                                         uint32_t event, uint32_t arg0, uint32_t arg1, uint64_t ts)
+{
+    uint32_t c0, c1, n = 1;
+
+    if (event == 0 || event >= RPU_TRACEZ_EVENTS) {
+        return 0;
+    }
+    c0 = rpu_tracez_code(s, event, 0, arg0);
+    c1 = rpu_tracez_code(s, event, 1, arg1);
+    buf[0] = (uint8_t)(event | (c0 ? RPU_TRACEZ_H_ARG0 : 0) | (c1 ? RPU_TRACEZ_H_ARG1 : 0));
+    n += rpu_tracez_put(&buf[n], ts - s->ts);
+    if (c0) {
+        n += rpu_tracez_put(&buf[n], c0);
+    }
+    if (c1) {
+        n += rpu_tracez_put(&buf[n], c1);
+    }
+    return n;
+}
+
+/* Account for an event written with rpu_tracez_encode() */
+static inline void rpu_tracez_commit(struct rpu_tracez_state *s, uint32_t event, uint32_t arg0,
+                                     uint32_t arg1, uint64_t ts)
+{
+    s->ts = ts;
+    s->index++;
+    s->prev[0][event & RPU_TRACEZ_H_EVENT] = arg0;
+    s->prev[1][event & RPU_TRACEZ_H_EVENT] = arg1;
+}
+
+static inline int rpu_tracez_get(const uint8_t *rec, uint32_t used, uint32_t *pos, uint64_t *v)
+{
+    uint32_t shift;
+
+    *v = 0;
+    for (shift = 0; shift < 64 && *pos < used; shift += 7) {
+        uint8_t b = rec[(*pos)++];
+
+        *v |= (uint64_t)(b & 0x7FU) << shift;
+        if ((b & 0x80U) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Decode the record at s->pos of the used record bytes of a block; returns
+ * 1 with the event in *out (seq: index + 1), 0 at the end, -1 on bytes that
+ * are not a record (the rest of the block is then unusable) */
+static inline int rpu_tracez_decode(struct rpu_tracez_state *s, const uint8_t *rec, uint32_t used,
+                                    struct rpu_shm_trace *out)
+{
+    uint32_t pos = s->pos;
+    uint64_t delta, v;
+    uint32_t arg[2] = { 0, 0 };
+    uint32_t event, a;
+    uint8_t h;
+
+    if (pos >= used) {
+        return 0;
+    }
+    h = rec[pos++];
+    event = h & RPU_TRACEZ_H_EVENT;
+    if ((h & RPU_TRACEZ_H_RESERVED) != 0 || event == 0 ||
+        rpu_tracez_get(rec, used, &pos, &delta) != 0) {
+        return -1;
+    }
+    for (a = 0; a < 2; a++) {
+        uint8_t d = rpu_tracez_dict[event] >> a;
+
+        if ((h & (RPU_TRACEZ_H_ARG0 << a)) == 0) {
+            v = 0;
+        } else if (rpu_tracez_get(rec, used, &pos, &v) != 0 || v > 0xFFFFFFFFU) {
+            return -1;
+        }
+        if (d & RPU_TRACEZ_DELTA0) {
+            arg[a] = s->prev[a][event] + rpu_tracez_unzigzag((uint32_t)v);
+        } else {
+            arg[a] = (d & RPU_TRACEZ_SIGNED0) ? rpu_tracez_unzigzag((uint32_t)v) : (uint32_t)v;
+        }
+    }
+
+    out->seq = s->index + 1;
+    out->event = event;
+    out->arg0 = arg[0];
+    out->arg1 = arg[1];
+    out->ts_lo = (uint32_t)(s->ts + delta);
+    out->ts_hi = (uint32_t)((s->ts + delta) >> 32);
+    rpu_tracez_commit(s, event, arg[0], arg[1], s->ts + delta);
+    s->pos = pos;
+    return 1;
+}
+
+#endif /* RPU_TRACE_COMPACT_H */
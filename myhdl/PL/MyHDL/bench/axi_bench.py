@@ -0,0 +1,353 @@
+#!/usr/bin/python
+#
+# FILE:
+#   axi_bench.py
+#
+# DESCRIPTION:
+#   Cycle-accurate MyHDL simulation of interrupt_gen behind each AXI4-Lite
+#   front end of axi_support (axi_connect and axi_connect_pipelined).
+#
+# * A cycle-based AXI4-Lite master drives the five channels independently:
+#    a new address or data beat is offered in the clock after the previous one
+#    was accepted, and BREADY/RREADY are dropped at random (--stall) to add
+#    back-pressure. Register accesses go to random registers of random
+#    channels with random data.
+# * For each front end it reports register accesses per clock for a run of
+#    writes, a run of reads and both at once, and checks every read against
+#    the value last written.
+# * It then runs channel 0 with a period and checks the interrupt timing: the
+#    interrupt output must rise every PERIOD clocks and successive timestamps
+#    must differ by PERIOD.
+# * Last, it arms the one-shot compare of channel 1 PERIOD clocks ahead: the
+#    interrupt must follow, with the compare value as its timestamp, and the
+#    compare must have disarmed itself.
+# * Exit status 1 if a check fails, or if a rate is below --min-rate.
+#
+# Run from the myhdl directory: make bench, or
+#    PYTHONPATH=. python PL/MyHDL/bench/axi_bench.py [options]
+#
+
+import argparse
+import random
+import sys
+
+from myhdl import (
+    always,
+    block,
+    delay,
+    instance,
+    instances,
+    intbv,
+    now,
+    ResetSignal,
+    Signal,
+    StopSimulation,
+)
+
+from PL.MyHDL.src.interfaces.axi_lite import AxiLite
+from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+from PL.MyHDL.src.axi_support.axi_support import axi_connect, axi_connect_pipelined
+from PL.MyHDL.src.axi_support.reg_bank import REG_BANK_READ_LATENCY
+from PL.MyHDL.src.interrupt_gen.interrupt_gen import (
+    INTERRUPT_GEN_CH_COALESCE_COUNT,
+    INTERRUPT_GEN_CH_COALESCE_TIME,
+    INTERRUPT_GEN_CH_COMPARE_HI,
+    INTERRUPT_GEN_CH_COMPARE_LO,
+    INTERRUPT_GEN_CH_PERIOD,
+    INTERRUPT_GEN_CH_TIMESTAMP_LO,
+    INTERRUPT_GEN_CHANNELS,
+    INTERRUPT_GEN_COMPARE_ARMED,
+    INTERRUPT_GEN_COUNTER_HI,
+    INTERRUPT_GEN_COUNTER_LO,
+    INTERRUPT_GEN_IER,
+    INTERRUPT_GEN_ISR,
+    interrupt_gen,
+    interrupt_gen_bank,
+)
+
+LOW, HIGH = bool(0), bool(1)
+
+PL_ADDR_WIDTH = 12
+PL_DATA_WIDTH = 32
+BENCH_CHANNELS = 4
+CLK_PERIOD = 10         # Simulation time units per clock
+BENCH_TIMEOUT = 100000  # Clocks one transfer or interrupt may take
+
+FRONT_ENDS = (("axi_connect", False), ("axi_connect_pipelined", True))
+
+
+class BenchError(Exception):
+    pass
+
+
+def reg_addr(index):
+    """Byte address of register index"""
+    return 4 * index
+
+
+def channel_reg(channel, offset):
+    return reg_addr(interrupt_gen_bank(channel) + offset)
+
+
+def scratch_regs(channels):
+    """Registers without side effects while PERIOD is 0: the coalescing pair"""
+    return [channel_reg(channel, offset) for channel in channels
+            for offset in (INTERRUPT_GEN_CH_COALESCE_COUNT, INTERRUPT_GEN_CH_COALESCE_TIME)]
+
+
+def cycles():
+    return now() // CLK_PERIOD
+
+
+@block
+def bench_dut(clk, resetn, axi, interrupt_out, pipelined):
+    axi_local = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+
+    # interrupt_gen decodes with reg_bank(): read data a clock after raddr
+    if pipelined:
+        connect_inst = axi_connect_pipelined(clk, resetn, axi, axi_local,
+                                             READ_LATENCY=REG_BANK_READ_LATENCY)
+    else:
+        connect_inst = axi_connect(clk, resetn, axi, axi_local, READ_LATENCY=REG_BANK_READ_LATENCY)
+
+    interrupt_gen_inst = interrupt_gen(clk=clk, resetn=resetn, axi_s=axi_local, axi_m=None,
+                                       interrupt_out=interrupt_out, map_base=0)
+
+    return instances()
+
+
+def axi_transfer(clk, axi, writes, reads, stall, rng):
+    """
+    Issue writes [(address, data)] and reads [address] back-to-back and wait
+    for all responses. Returns (clocks, read data in order); clocks run from
+    the first beat offered to the last response taken.
+    """
+    aw = list(writes)
+    w = list(writes)
+    ar = list(reads)
+    responses = 0
+    rdata = []
+    clocks = 0
+
+    def drive():
+        axi.awvalid.next = bool(aw)
+        if aw:
+            axi.awaddr.next = aw[0][0]
+        axi.wvalid.next = bool(w)
+        if w:
+            axi.wdata.next = w[0][1]
+            axi.wstrb.next = 0xF
+        axi.arvalid.next = bool(ar)
+        if ar:
+            axi.araddr.next = ar[0]
+        axi.bready.next = rng.random() >= stall
+        axi.rready.next = rng.random() >= stall
+
+    drive()
+    while responses < len(writes) or len(rdata) < len(reads):
+        # Signals read here hold the values sampled by this edge
+        yield clk.posedge
+        clocks += 1
+        if clocks > BENCH_TIMEOUT:
+            raise BenchError("transfer timed out: %d of %d writes, %d of %d reads answered"
+                             % (responses, len(writes), len(rdata), len(reads)))
+        if axi.awvalid and axi.awready:
+            aw.pop(0)
+        if axi.wvalid and axi.wready:
+            w.pop(0)
+        if axi.bvalid and axi.bready:
+            if axi.bresp != 0:
+                raise BenchError("write response %d" % int(axi.bresp))
+            responses += 1
+        if axi.arvalid and axi.arready:
+            ar.pop(0)
+        if axi.rvalid and axi.rready:
+            if axi.rresp != 0:
+                raise BenchError("read response %d" % int(axi.rresp))
+            rdata.append(int(axi.rdata))
+        drive()
+
+    axi.awvalid.next = LOW
+    axi.wvalid.next = LOW
+    axi.arvalid.next = LOW
+    axi.bready.next = LOW
+    axi.rready.next = LOW
+    return clocks, rdata
+
+
+def check_reads(name, reads, rdata, expected, errors):
+    for address, value in zip(reads, rdata):
+        if value != expected[address]:
+            errors.append("%s: read 0x%03x = 0x%08x, expected 0x%08x"
+                          % (name, address, value, expected[address]))
+
+
+@block
+def bench_top(pipelined, args, results):
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    axi = AxiLite(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    interrupt_out = Signal(intbv(0)[BENCH_CHANNELS:])
+
+    dut = bench_dut(clk, resetn, axi, interrupt_out, pipelined)
+
+    @always(delay(CLK_PERIOD // 2))
+    def clock_gen():
+        clk.next = not clk
+
+    @instance
+    def stimulus():
+        rng = random.Random(args.seed)
+        errors = results["errors"]
+        expected = {reg_addr(INTERRUPT_GEN_CHANNELS): BENCH_CHANNELS}
+        for address in scratch_regs(range(BENCH_CHANNELS)):
+            expected[address] = 0
+
+        resetn.next = LOW
+        for _ in range(4):
+            yield clk.posedge
+        resetn.next = HIGH
+        yield clk.posedge
+
+        try:
+            # Writes only
+            writes = [(rng.choice(scratch_regs(range(BENCH_CHANNELS))), rng.getrandbits(32))
+                      for _ in range(args.accesses)]
+            clocks, _ = yield from axi_transfer(clk, axi, writes, [], args.stall, rng)
+            results["write"] = len(writes) / clocks
+            for address, data in writes:
+                expected[address] = data
+
+            # Reads only
+            reads = [rng.choice(list(expected)) for _ in range(args.accesses)]
+            clocks, rdata = yield from axi_transfer(clk, axi, [], reads, args.stall, rng)
+            results["read"] = len(reads) / clocks
+            check_reads("read run", reads, rdata, expected, errors)
+
+            # Both at once, on disjoint registers so the read values are known
+            half = BENCH_CHANNELS // 2
+            writes = [(rng.choice(scratch_regs(range(half, BENCH_CHANNELS))), rng.getrandbits(32))
+                      for _ in range(args.accesses)]
+            read_pool = scratch_regs(range(half)) + [reg_addr(INTERRUPT_GEN_CHANNELS)]
+            reads = [rng.choice(read_pool) for _ in range(args.accesses)]
+            clocks, rdata = yield from axi_transfer(clk, axi, writes, reads, args.stall, rng)
+            results["mixed"] = (len(writes) + len(reads)) / clocks
+            check_reads("mixed run", reads, rdata, expected, errors)
+            for address, data in writes:
+                expected[address] = data
+
+            # Interrupt timing of channel 0
+            yield from axi_transfer(clk, axi, [
+                (channel_reg(0, INTERRUPT_GEN_CH_COALESCE_COUNT), 0),
+                (channel_reg(0, INTERRUPT_GEN_CH_COALESCE_TIME), 0),
+                (reg_addr(INTERRUPT_GEN_ISR), (1 << BENCH_CHANNELS) - 1),
+                (reg_addr(INTERRUPT_GEN_IER), 1),
+                (channel_reg(0, INTERRUPT_GEN_CH_PERIOD), args.period),
+            ], [], 0.0, rng)
+            rises = []
+            timestamps = []
+            for _ in range(args.interrupts + 1):
+                waited = 0
+                while not interrupt_out[0]:
+                    yield clk.posedge
+                    waited += 1
+                    if waited > BENCH_TIMEOUT:
+                        raise BenchError("no interrupt within %d clocks" % BENCH_TIMEOUT)
+                rises.append(cycles())
+                # Handler: read the timestamp, then clear the ISR bit
+                _, rdata = yield from axi_transfer(
+                    clk, axi, [], [channel_reg(0, INTERRUPT_GEN_CH_TIMESTAMP_LO)], 0.0, rng)
+                timestamps.append(rdata[0])
+                yield from axi_transfer(clk, axi, [(reg_addr(INTERRUPT_GEN_ISR), 1)], [], 0.0, rng)
+                # The handler must finish within a period for the intervals to be exact
+                if cycles() - rises[-1] >= args.period:
+                    raise BenchError("handler took %d clocks, period is %d"
+                                     % (cycles() - rises[-1], args.period))
+
+            intervals = [b - a for a, b in zip(rises, rises[1:])]
+            stamp_intervals = [(b - a) & 0xFFFFFFFF for a, b in zip(timestamps, timestamps[1:])]
+            results["intervals"] = intervals
+            results["timestamp_intervals"] = stamp_intervals
+            if any(i != args.period for i in intervals):
+                errors.append("interrupt_out intervals %s, expected %d" % (intervals, args.period))
+            if any(i != args.period for i in stamp_intervals):
+                errors.append("timestamp intervals %s, expected %d" % (stamp_intervals, args.period))
+
+            # One-shot compare of channel 1, PERIOD clocks after the counter read
+            yield from axi_transfer(clk, axi, [
+                (channel_reg(1, INTERRUPT_GEN_CH_COALESCE_COUNT), 0),
+                (channel_reg(1, INTERRUPT_GEN_CH_COALESCE_TIME), 0),
+                (reg_addr(INTERRUPT_GEN_ISR), 2),
+                (reg_addr(INTERRUPT_GEN_IER), 3),
+            ], [], 0.0, rng)
+            _, rdata = yield from axi_transfer(
+                clk, axi, [], [reg_addr(INTERRUPT_GEN_COUNTER_LO),
+                               reg_addr(INTERRUPT_GEN_COUNTER_HI)], 0.0, rng)
+            compare = (rdata[1] << 32 | rdata[0]) + args.period
+            yield from axi_transfer(clk, axi, [
+                (channel_reg(1, INTERRUPT_GEN_CH_COMPARE_LO), compare & 0xFFFFFFFF),
+                (channel_reg(1, INTERRUPT_GEN_CH_COMPARE_HI), compare >> 32),
+            ], [], 0.0, rng)
+            waited = 0
+            while not interrupt_out[1]:
+                yield clk.posedge
+                waited += 1
+                if waited > BENCH_TIMEOUT:
+                    raise BenchError("no compare interrupt within %d clocks" % BENCH_TIMEOUT)
+            _, rdata = yield from axi_transfer(
+                clk, axi, [], [channel_reg(1, INTERRUPT_GEN_CH_TIMESTAMP_LO),
+                               reg_addr(INTERRUPT_GEN_COMPARE_ARMED)], 0.0, rng)
+            if rdata[0] != compare & 0xFFFFFFFF:
+                errors.append("compare timestamp 0x%08x, expected 0x%08x"
+                              % (rdata[0], compare & 0xFFFFFFFF))
+            if rdata[1] & 2:
+                errors.append("compare of channel 1 still armed after its interrupt")
+        except BenchError as e:
+            errors.append(str(e))
+
+        raise StopSimulation
+
+    return instances()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="AXI4-Lite throughput and interrupt timing bench")
+    parser.add_argument("--accesses", type=int, default=256, help="accesses per run (256)")
+    parser.add_argument("--stall", type=float, default=0.0,
+                        help="probability that BREADY/RREADY is low in a clock (0.0)")
+    parser.add_argument("--period", type=int, default=200, help="interrupt period in clocks (200)")
+    parser.add_argument("--interrupts", type=int, default=8, help="interrupt intervals checked (8)")
+    parser.add_argument("--seed", type=int, default=1, help="random seed (1)")
+    parser.add_argument("--min-rate", type=float, default=0.0,
+                        help="fail if axi_connect_pipelined makes fewer accesses per clock")
+    parser.add_argument("--trace", action="store_true", help="write a VCD file per front end")
+    args = parser.parse_args()
+
+    failed = False
+    print("%-24s %10s %10s %10s  %s" % ("front end", "writes/clk", "reads/clk", "mixed/clk",
+                                        "interrupt intervals"))
+    for name, pipelined in FRONT_ENDS:
+        results = {"errors": []}
+        top = bench_top(pipelined, args, results)
+        if args.trace:
+            top.config_sim(trace=True, name="axi_bench_" + name)
+        top.run_sim()
+        top.quit_sim()
+
+        print("%-24s %10.3f %10.3f %10.3f  %s" % (
+            name, results.get("write", 0.0), results.get("read", 0.0), results.get("mixed", 0.0),
+            results.get("intervals", "-")))
+        for error in results["errors"]:
+            print("  FAIL %s" % error)
+            failed = True
+        if pipelined and args.min_rate:
+            for run in ("write", "read"):
+                if results.get(run, 0.0) < args.min_rate:
+                    print("  FAIL %s rate %.3f below %.3f" % (run, results.get(run, 0.0), args.min_rate))
+                    failed = True
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
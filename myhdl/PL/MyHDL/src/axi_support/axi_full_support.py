@@ -0,0 +1,195 @@
+#!/usr/bin/python
+#
+# FILE:
+#   axi_full_support.py
+#
+# DESCRIPTION:
+#   AXI4 (full) slave with a block RAM buffer, for PL logic that takes
+#   payloads in bursts rather than single AXI4-Lite beats
+#
+import sys
+
+from myhdl import (always, always_comb, always_seq, block, ConcatSignal,
+                   instances, intbv, modbv, ResetSignal, Signal)
+
+from PL.MyHDL.src.interfaces.axi_full import AxiFull
+
+LOW, HIGH = bool(0), bool(1)
+
+AXI_BURST_FIXED = 0
+AXI_BURST_INCR = 1
+AXI_BURST_WRAP = 2
+
+AXI_FULL_DATA_WIDTHS = (32, 64, 128)
+
+
+@block
+def axi_bram_lane(clk, wen, wstrb, waddr, wdata, re, raddr, rdata, user_raddr, user_rdata, DEPTH):
+    """
+    One byte lane of the buffer: a write port and a read port for the AXI
+    side and a read port for the PL logic, all synchronous so the lane maps
+    onto block RAM.
+    """
+    mem = [Signal(intbv(0)[8:]) for _ in range(DEPTH)]
+
+    @always(clk.posedge)
+    def axi_port():
+        if wen and wstrb:
+            mem[waddr].next = wdata
+        if re:
+            rdata.next = mem[raddr]
+
+    @always(clk.posedge)
+    def user_port():
+        user_rdata.next = mem[user_raddr]
+
+    return instances()
+
+
+@block
+def axi_full_bram(clk, resetn, axi, user_raddr, user_rdata, DEPTH=512):
+    """
+    AXI4 slave in front of a DEPTH x DATA_WIDTH buffer.
+
+    Bursts of up to 256 beats, FIXED, INCR or WRAP, run at one beat per
+    clock; a write burst and a read burst can be in progress at the same
+    time. Beats are full width (AxSIZE is not used): beat n of a burst goes
+    to word AxADDR / (DATA_WIDTH / 8) + n, and INCR bursts wrap at the end
+    of the buffer. WSTRB selects the bytes written.
+
+    Parameters:
+    clk             System clock
+    resetn          System reset
+    axi             AxiFull slave interface, 32, 64 or 128 bits of data
+    user_raddr      Word index read by the PL logic
+    user_rdata      Word at user_raddr, one clock later
+    DEPTH           Buffer words, a power of 2 from 16
+    """
+    DATA_WIDTH = len(axi.wdata)
+    STRB_WIDTH = DATA_WIDTH // 8
+    if DATA_WIDTH not in AXI_FULL_DATA_WIDTHS:
+        raise ValueError("axi_full_bram supports %s bit data" % (AXI_FULL_DATA_WIDTHS,))
+    if DEPTH < 16 or DEPTH & (DEPTH - 1):
+        raise ValueError("axi_full_bram DEPTH must be a power of 2 from 16")
+    ADDR_LSB = {32: 2, 64: 3, 128: 4}[DATA_WIDTH]
+    WORD_BITS = DEPTH.bit_length() - 1
+    if len(axi.awaddr) < ADDR_LSB + WORD_BITS:
+        raise ValueError("axi_full_bram needs %d address bits" % (ADDR_LSB + WORD_BITS))
+    WORD_MASK = DEPTH - 1
+
+    # Write burst: word address, wrap mask (address bits that count) and ID
+    wr_active = Signal(LOW)
+    wr_addr = Signal(modbv(0)[WORD_BITS:])
+    wr_mask = Signal(intbv(0)[WORD_BITS:])
+    wr_id = Signal(intbv(0)[len(axi.awid):])
+    w_fire = Signal(LOW)
+    axi_bvalid = Signal(LOW)
+
+    # Read burst: word address, wrap mask, beats left after this one and ID
+    rd_active = Signal(LOW)
+    rd_addr = Signal(modbv(0)[WORD_BITS:])
+    rd_mask = Signal(intbv(0)[WORD_BITS:])
+    rd_count = Signal(modbv(0)[8:])
+    rd_id = Signal(intbv(0)[len(axi.arid):])
+    rd_issue = Signal(LOW)
+    axi_rvalid = Signal(LOW)
+    axi_rlast = Signal(LOW)
+    axi_rid = Signal(intbv(0)[len(axi.arid):])
+
+    lane_rdata = [Signal(intbv(0)[8:]) for _ in range(STRB_WIDTH)]
+    lane_user_rdata = [Signal(intbv(0)[8:]) for _ in range(STRB_WIDTH)]
+    rdata = ConcatSignal(*reversed(lane_rdata))
+    user_data = ConcatSignal(*reversed(lane_user_rdata))
+
+    lanes = [
+        axi_bram_lane(clk, w_fire, axi.wstrb(i), wr_addr, axi.wdata(8 * i + 8, 8 * i), rd_issue, rd_addr,
+                      lane_rdata[i], user_raddr, lane_user_rdata[i], DEPTH)
+        for i in range(STRB_WIDTH)
+    ]
+
+    @always_comb
+    def handshakes():
+        # One write response outstanding: the next burst waits for BREADY
+        axi.awready.next = not wr_active and not axi_bvalid
+        axi.wready.next = wr_active
+        w_fire.next = wr_active and axi.wvalid
+        axi.arready.next = not rd_active
+        rd_issue.next = rd_active and ((not axi_rvalid) or axi.rready)
+
+    @always_seq(clk.posedge, reset=resetn)
+    def write_control():
+        if axi.awvalid and not wr_active and not axi_bvalid:
+            wr_active.next = True
+            wr_addr.next = axi.awaddr[ADDR_LSB + WORD_BITS:ADDR_LSB]
+            wr_id.next = axi.awid
+            if axi.awburst == AXI_BURST_FIXED:
+                wr_mask.next = 0
+            elif axi.awburst == AXI_BURST_WRAP:
+                wr_mask.next = axi.awlen[4:]
+            else:
+                wr_mask.next = WORD_MASK
+        elif w_fire:
+            wr_addr.next = (wr_addr & ~wr_mask) | ((wr_addr + 1) & wr_mask)
+            if axi.wlast:
+                wr_active.next = False
+
+        if w_fire and axi.wlast:
+            axi_bvalid.next = True
+        elif axi.bready:
+            axi_bvalid.next = False
+
+    @always_seq(clk.posedge, reset=resetn)
+    def read_control():
+        if axi.arvalid and not rd_active:
+            rd_active.next = True
+            rd_addr.next = axi.araddr[ADDR_LSB + WORD_BITS:ADDR_LSB]
+            rd_count.next = axi.arlen
+            rd_id.next = axi.arid
+            if axi.arburst == AXI_BURST_FIXED:
+                rd_mask.next = 0
+            elif axi.arburst == AXI_BURST_WRAP:
+                rd_mask.next = axi.arlen[4:]
+            else:
+                rd_mask.next = WORD_MASK
+        elif rd_issue:
+            # The lanes read rd_addr on this edge
+            rd_addr.next = (rd_addr & ~rd_mask) | ((rd_addr + 1) & rd_mask)
+            rd_count.next = rd_count - 1
+            if rd_count == 0:
+                rd_active.next = False
+
+        if rd_issue:
+            axi_rvalid.next = True
+            axi_rlast.next = rd_count == 0
+            axi_rid.next = rd_id
+        elif axi.rready:
+            axi_rvalid.next = False
+
+    @always_comb
+    def output_lines():
+        axi.bid.next = wr_id
+        axi.bresp.next = 0  # 'OKAY' response
+        axi.bvalid.next = axi_bvalid
+        axi.rid.next = axi_rid
+        axi.rdata.next = rdata
+        axi.rresp.next = 0  # 'OKAY' response
+        axi.rlast.next = axi_rlast
+        axi.rvalid.next = axi_rvalid
+        user_rdata.next = user_data
+
+    return instances()
+
+
+if __name__ == "__main__":
+    # Optional argument: data width (32, 64 or 128)
+    data_width = int(sys.argv[1]) if len(sys.argv) > 1 else 64
+    depth = 512
+
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    axi = AxiFull(16, data_width)
+    user_raddr = Signal(intbv(0)[depth.bit_length() - 1:])
+    user_rdata = Signal(intbv(0)[data_width:])
+
+    axi_full_bram(clk=clk, resetn=resetn, axi=axi, user_raddr=user_raddr,
+                  user_rdata=user_rdata, DEPTH=depth).convert(hdl='Verilog')
@@ -7,7 +7,7 @@
 #   Support block which connects programmable logic to an AXI Slave interface
 #
 #
-from myhdl import (always_comb, always_seq, block,
+from myhdl import (always_comb, always_seq, block, ConcatSignal,
                    instances, intbv, Signal)
 LOW, HIGH = bool(0), bool(1)
 
@@ -70,8 +70,13 @@ def axi_support(
     axi_araddr,     # Latched read address
     reg_data,       # Data to be written back to PS
     C_S_AXI_DATA_WIDTH,
-    C_S_AXI_ADDR_WIDTH
+    C_S_AXI_ADDR_WIDTH,
+    # Clocks from axi_araddr to reg_data: 0 for a combinational read mux,
+    # 1 for a registered one (reg_bank)
+    C_S_AXI_READ_LATENCY=0
 ):
+    if C_S_AXI_READ_LATENCY not in (0, 1):
+        raise ValueError("axi_support: read latency %d, 0 or 1 supported" % C_S_AXI_READ_LATENCY)
 
     axi_bresp = Signal(intbv(0)[2:0])
     axi_bvalid = Signal(False)
@@ -79,6 +84,8 @@ def axi_support(
     axi_rdata = Signal(intbv(0)[C_S_AXI_DATA_WIDTH:0])
     axi_rresp = Signal(intbv(0)[2:0])
     axi_rvalid = Signal(False)
+    slv_reg_rden = Signal(False)
+    ar_free = Signal(False)
 
     # Connect output lines to registers
     @always_comb
@@ -92,12 +99,18 @@ def axi_support(
 
     # Implement axi_awready generation
     # axi_awready is asserted for one S_AXI_ACLK clock cycle when both
-    # S_AXI_AWVALID and S_AXI_WVALID are asserted. axi_awready is
+    # S_AXI_AWVALID and S_AXI_WVALID are asserted and the previous write
+    # response has been or is being taken. axi_awready is
     # de-asserted when reset is low.
+    aw_en = Signal(False)
+
+    @always_comb
+    def aw_enable():
+        aw_en.next = (not axi_bvalid) or S_AXI_BREADY
 
     @always_seq(S_AXI_ACLK.posedge, reset=S_AXI_ARESETN)
     def axi_awready_generation():
-        if (not axi_awready) and S_AXI_AWVALID and S_AXI_WVALID:
+        if (not axi_awready) and S_AXI_AWVALID and S_AXI_WVALID and aw_en:
             # slave is ready to accept write address when there is a valid write address and write data
             # on the write address and data bus. This design expects no
             # outstanding transactions.
@@ -110,7 +123,7 @@ def axi_support(
     # S_AXI_AWVALID and S_AXI_WVALID are valid.
     @always_seq(S_AXI_ACLK.posedge, reset=S_AXI_ARESETN)
     def axi_awaddr_latching():
-        if (not axi_awready) and S_AXI_AWVALID and S_AXI_WVALID:
+        if (not axi_awready) and S_AXI_AWVALID and S_AXI_WVALID and aw_en:
             axi_awaddr.next = S_AXI_AWADDR
 
     # Implement axi_wready generation
@@ -119,7 +132,7 @@ def axi_support(
     # de-asserted when reset is low.
     @always_seq(S_AXI_ACLK.posedge, reset=S_AXI_ARESETN)
     def axi_wready_generation():
-        if (not axi_awready) and S_AXI_AWVALID and S_AXI_WVALID:
+        if (not axi_awready) and S_AXI_AWVALID and S_AXI_WVALID and aw_en:
             # slave is ready to accept write data when there is a valid
             # write address and write data on the write address and data
             # bus. This design expects no outstanding transactions.
@@ -147,14 +160,15 @@ def axi_support(
 
     # Implement axi_arready generation
     # axi_arready is asserted for one S_AXI_ACLK clock cycle when
-    # S_AXI_ARVALID is asserted. axi_arready is
+    # S_AXI_ARVALID is asserted and the previous read data has been or is
+    # being taken. axi_arready is
     # de-asserted when reset (active low) is asserted.
     # The read address is also latched when S_AXI_ARVALID is
     # asserted. axi_araddr is reset to zero on reset assertion.
 
     @always_seq(S_AXI_ACLK.posedge, reset=S_AXI_ARESETN)
     def axi_arready_generation():
-        if (not axi_arready) and S_AXI_ARVALID:
+        if (not axi_arready) and S_AXI_ARVALID and ar_free:
             # indicates that the slave has accepted the valid read address
             axi_arready.next = True
             # Read address latching
@@ -170,9 +184,31 @@ def axi_support(
     # bus and axi_rresp indicates the status of read transaction.axi_rvalid
     # is deasserted on reset (active low). axi_rresp and axi_rdata are
     # cleared to zero on reset (active low).
+    # slv_reg_rden is high when reg_data holds the data of the accepted read
+    # address: with the address handshake, or a clock later with a registered
+    # read mux, which also keeps the next address out until then
+    if C_S_AXI_READ_LATENCY == 0:
+
+        @always_comb
+        def read_enable():
+            slv_reg_rden.next = axi_arready and S_AXI_ARVALID and not axi_rvalid
+            ar_free.next = (not axi_rvalid) or S_AXI_RREADY
+
+    else:
+        read_wait = Signal(False)
+
+        @always_seq(S_AXI_ACLK.posedge, reset=S_AXI_ARESETN)
+        def read_delay():
+            read_wait.next = axi_arready and S_AXI_ARVALID and not axi_rvalid
+
+        @always_comb
+        def read_enable():
+            slv_reg_rden.next = read_wait
+            ar_free.next = ((not axi_rvalid) or S_AXI_RREADY) and not read_wait
+
     @always_seq(S_AXI_ACLK.posedge, reset=S_AXI_ARESETN)
     def axi_arvalid_generation():
-        if axi_arready and S_AXI_ARVALID and (not axi_rvalid):
+        if slv_reg_rden:
             # Valid read data is available at the read data bus
             axi_rvalid.next = True
             axi_rresp.next = 0  # 'OKAY' response
@@ -186,7 +222,6 @@ def axi_support(
         # When there is a valid read address (axi_arvalid) with
         # acceptance of read address by the slave (axi_arready),
         # output the read data
-        slv_reg_rden = axi_arready and S_AXI_ARVALID and not axi_rvalid
         if slv_reg_rden:
             axi_rdata.next = reg_data
 
@@ -194,7 +229,11 @@ def axi_support(
 
 
 @block
-def axi_connect(clk, resetn, axi_lite, axi_local, ADDR_WIDTH=12, DATA_WIDTH=32):
+def axi_connect(clk, resetn, axi_lite, axi_local, ADDR_WIDTH=12, DATA_WIDTH=32, READ_LATENCY=0):
+    """
+    READ_LATENCY is the number of clocks the blocks on axi_local take from
+    raddr to rdata: 0, or REG_BANK_READ_LATENCY for blocks built on reg_bank().
+    """
     ADDR_LSB = (DATA_WIDTH // 32) + 1
     OPT_MEM_ADDR_BITS = ADDR_WIDTH - ADDR_LSB  # log2 of number of registers
 
@@ -208,7 +247,7 @@ def axi_connect(clk, resetn, axi_lite, axi_local, ADDR_WIDTH=12, DATA_WIDTH=32):
                        axi_lite.wdata, axi_lite.wstrb, axi_lite.wvalid, axi_wready, axi_lite.bresp, axi_lite.bvalid,
                        axi_lite.bready, axi_lite.araddr, axi_lite.arprot, axi_lite.arvalid, axi_lite.arready, axi_lite.rdata,
                        axi_lite.rresp, axi_lite.rvalid, axi_lite.rready, axi_awaddr, axi_araddr, reg_data,
-                       DATA_WIDTH, ADDR_WIDTH)
+                       DATA_WIDTH, ADDR_WIDTH, READ_LATENCY)
 
     @always_comb
     def axi_helpers():
@@ -224,3 +263,198 @@ def axi_connect(clk, resetn, axi_lite, axi_local, ADDR_WIDTH=12, DATA_WIDTH=32):
         reg_data.next = axi_local.rdata
 
     return instances()
+
+
+@block
+def axi_skid_buffer(clk, resetn, i_valid, o_ready, i_data, o_valid, i_ready, o_data):
+    """
+    Two-entry skid buffer for one AXI channel.
+
+    o_ready comes straight from a register, so the channel can be accepted
+    every cycle without a combinational path from the downstream i_ready back
+    to the AXI bus. A beat accepted while the downstream side stalls is held
+    in the skid register and o_ready drops until it has been taken.
+
+    Parameters:
+    i_valid, o_ready, i_data    Upstream (AXI master) side
+    o_valid, i_ready, o_data    Downstream (slave logic) side
+    """
+    r_valid = Signal(LOW)
+    r_data = Signal(intbv(0)[len(i_data):])
+
+    @always_seq(clk.posedge, reset=resetn)
+    def skid_register():
+        if i_valid and (not r_valid) and (not i_ready):
+            # Accepted, but the downstream side did not take it
+            r_valid.next = True
+        elif i_ready:
+            r_valid.next = False
+        if not r_valid:
+            r_data.next = i_data
+
+    @always_comb
+    def skid_output():
+        o_ready.next = not r_valid
+        o_valid.next = i_valid or r_valid
+        if r_valid:
+            o_data.next = r_data
+        else:
+            o_data.next = i_data
+
+    return instances()
+
+
+@block
+def axi_connect_pipelined(clk, resetn, axi_lite, axi_local, ADDR_WIDTH=12, DATA_WIDTH=32,
+                          READ_LATENCY=0):
+    """
+    Pipelined replacement for axi_connect().
+
+    The AW, W and AR channels go through skid buffers, so awready, wready and
+    arready stay high and one write and one read can be accepted every cycle
+    as long as the master takes the responses. Every AXI output and the
+    AxiLocal waddr/wdata/wstrobe/wen/raddr come from registers:
+
+    write   AW+W accepted -> wen/waddr/wdata/wstrobe and bvalid registered;
+            the block registers update at the end of the cycle bvalid rises
+    read    AR accepted -> raddr registered -> rdata/rvalid registered, with
+            the raddr stage held while rvalid waits for rready
+
+    A register read after a write whose response has been received therefore
+    returns the written value, as with axi_connect().
+
+    With READ_LATENCY 1 (blocks built on reg_bank(), whose rdata is
+    registered) the read path has one more stage: raddr -> the block's rdata
+    register -> rdata/rvalid. While rvalid waits, the block's rdata is held in
+    a skid register so that the raddr stage can still move on, and a read is
+    still accepted every cycle, a clock later.
+    """
+    if READ_LATENCY not in (0, 1):
+        raise ValueError("axi_connect_pipelined: read latency %d, 0 or 1 supported" % READ_LATENCY)
+    ADDR_LSB = (DATA_WIDTH // 32) + 1
+    OPT_MEM_ADDR_BITS = ADDR_WIDTH - ADDR_LSB  # log2 of number of registers
+    STRB_WIDTH = DATA_WIDTH // 8
+
+    # Skid buffer outputs
+    aw_valid = Signal(LOW)
+    aw_addr = Signal(intbv(0)[ADDR_WIDTH:0])
+    w_valid = Signal(LOW)
+    w_in = ConcatSignal(axi_lite.wstrb, axi_lite.wdata)
+    w_beat = Signal(intbv(0)[STRB_WIDTH + DATA_WIDTH:0])
+    ar_valid = Signal(LOW)
+    ar_addr = Signal(intbv(0)[ADDR_WIDTH:0])
+
+    write_fire = Signal(LOW)
+    read_fire = Signal(LOW)
+    raddr_valid = Signal(LOW)   # raddr stage holds an accepted read
+    raddr_advance = Signal(LOW)
+
+    axi_bvalid = Signal(LOW)
+    axi_rvalid = Signal(LOW)
+    axi_rdata = Signal(intbv(0)[DATA_WIDTH:0])
+    local_waddr = Signal(intbv(0)[ADDR_WIDTH:0])
+    local_wdata = Signal(intbv(0)[DATA_WIDTH:0])
+    local_wstrobe = Signal(intbv(0)[STRB_WIDTH:0])
+    local_wen = Signal(LOW)
+    local_raddr = Signal(intbv(0)[ADDR_WIDTH:0])
+
+    aw_skid = axi_skid_buffer(clk, resetn, axi_lite.awvalid, axi_lite.awready, axi_lite.awaddr,
+                              aw_valid, write_fire, aw_addr)
+    w_skid = axi_skid_buffer(clk, resetn, axi_lite.wvalid, axi_lite.wready, w_in,
+                             w_valid, write_fire, w_beat)
+    ar_skid = axi_skid_buffer(clk, resetn, axi_lite.arvalid, axi_lite.arready, axi_lite.araddr,
+                              ar_valid, read_fire, ar_addr)
+
+    @always_comb
+    def write_handshake():
+        # A write needs both beats and room for its response
+        write_fire.next = aw_valid and w_valid and ((not axi_bvalid) or axi_lite.bready)
+
+    @always_seq(clk.posedge, reset=resetn)
+    def write_stage():
+        local_wen.next = write_fire
+        if write_fire:
+            local_waddr.next = aw_addr[ADDR_LSB + OPT_MEM_ADDR_BITS:ADDR_LSB]
+            local_wdata.next = w_beat[DATA_WIDTH:0]
+            local_wstrobe.next = w_beat[STRB_WIDTH + DATA_WIDTH:DATA_WIDTH]
+            axi_bvalid.next = True
+        elif axi_lite.bready:
+            axi_bvalid.next = False
+
+    if READ_LATENCY == 0:
+
+        @always_comb
+        def read_handshake():
+            # The raddr stage moves on when rdata is free or being taken
+            raddr_advance.next = raddr_valid and ((not axi_rvalid) or axi_lite.rready)
+            read_fire.next = ar_valid and ((not raddr_valid) or ((not axi_rvalid) or axi_lite.rready))
+
+        @always_seq(clk.posedge, reset=resetn)
+        def read_stage():
+            if read_fire:
+                raddr_valid.next = True
+                local_raddr.next = ar_addr[ADDR_LSB + OPT_MEM_ADDR_BITS:ADDR_LSB]
+            elif raddr_advance:
+                raddr_valid.next = False
+            if raddr_advance:
+                axi_rvalid.next = True
+                axi_rdata.next = axi_local.rdata
+            elif axi_lite.rready:
+                axi_rvalid.next = False
+
+    else:
+        # The block's rdata register holds the data of the address that left
+        # the raddr stage (data_valid), or data_hold does once it had to wait
+        data_valid = Signal(LOW)
+        data_held = Signal(LOW)
+        data_hold = Signal(intbv(0)[DATA_WIDTH:0])
+        data_advance = Signal(LOW)
+
+        @always_comb
+        def read_handshake():
+            # Each stage moves on when the next one is free or moving on
+            data_advance.next = data_valid and ((not axi_rvalid) or axi_lite.rready)
+            raddr_advance.next = raddr_valid and ((not data_valid) or
+                                                  ((not axi_rvalid) or axi_lite.rready))
+            read_fire.next = ar_valid and ((not raddr_valid) or (not data_valid) or
+                                           ((not axi_rvalid) or axi_lite.rready))
+
+        @always_seq(clk.posedge, reset=resetn)
+        def read_stage():
+            if read_fire:
+                raddr_valid.next = True
+                local_raddr.next = ar_addr[ADDR_LSB + OPT_MEM_ADDR_BITS:ADDR_LSB]
+            elif raddr_advance:
+                raddr_valid.next = False
+            if raddr_advance:
+                data_valid.next = True
+                data_held.next = False
+            elif data_advance:
+                data_valid.next = False
+            elif data_valid and not data_held:
+                # rdata changes with the next raddr: keep it
+                data_held.next = True
+                data_hold.next = axi_local.rdata
+            if data_advance:
+                axi_rvalid.next = True
+                if data_held:
+                    axi_rdata.next = data_hold
+                else:
+                    axi_rdata.next = axi_local.rdata
+            elif axi_lite.rready:
+                axi_rvalid.next = False
+
+    @always_comb
+    def axi_helpers():
+        axi_lite.bresp.next = 0  # 'OKAY' response
+        axi_lite.bvalid.next = axi_bvalid
+        axi_lite.rdata.next = axi_rdata
+        axi_lite.rresp.next = 0  # 'OKAY' response
+        axi_lite.rvalid.next = axi_rvalid
+        axi_local.wen.next = local_wen
+        axi_local.waddr.next = local_waddr
+        axi_local.wdata.next = local_wdata
+        axi_local.wstrobe.next = local_wstrobe
+        axi_local.raddr.next = local_raddr
+
+    return instances()
@@ -0,0 +1,80 @@
+#!/usr/bin/python
+#
+# FILE:
+#   axis_support.py
+#
+# DESCRIPTION:
+#   AXI4-Stream building blocks: skid buffer and register stage, so a stream
+#   can pass a PL block at one beat per clock with registered handshakes
+#
+from myhdl import (always_comb, always_seq, block, ConcatSignal,
+                   instances, intbv, Signal)
+
+from PL.MyHDL.src.axi_support.axi_support import axi_skid_buffer
+
+LOW, HIGH = bool(0), bool(1)
+
+
+@block
+def axis_skid_buffer(clk, resetn, s_axis, m_axis):
+    """
+    Skid buffer between two AxiStream interfaces of the same width.
+
+    s_axis.tready comes from a register, so the upstream side does not see a
+    combinational path from m_axis.tready. m_axis.tvalid/tdata/tlast are
+    combinational from s_axis or the skid register.
+    """
+    width = len(s_axis.tdata)
+    s_beat = ConcatSignal(s_axis.tlast, s_axis.tdata)
+    m_beat = Signal(intbv(0)[width + 1:])
+
+    skid = axi_skid_buffer(clk, resetn, s_axis.tvalid, s_axis.tready, s_beat,
+                           m_axis.tvalid, m_axis.tready, m_beat)
+
+    @always_comb
+    def unpack_beat():
+        m_axis.tdata.next = m_beat[width:]
+        m_axis.tlast.next = m_beat[width]
+
+    return instances()
+
+
+@block
+def axis_register_slice(clk, resetn, s_axis, m_axis):
+    """
+    Full register slice: a skid buffer followed by an output register, so
+    every handshake signal on both sides comes from a register. One beat per
+    clock passes while m_axis.tready is high, with two beats of buffering.
+    """
+    width = len(s_axis.tdata)
+    skid_out_tvalid = Signal(LOW)
+    skid_out_tready = Signal(LOW)
+    out_valid = Signal(LOW)
+    out_data = Signal(intbv(0)[width:])
+    out_last = Signal(LOW)
+
+    s_beat = ConcatSignal(s_axis.tlast, s_axis.tdata)
+    skid_beat = Signal(intbv(0)[width + 1:])
+
+    skid = axi_skid_buffer(clk, resetn, s_axis.tvalid, s_axis.tready, s_beat,
+                           skid_out_tvalid, skid_out_tready, skid_beat)
+
+    @always_comb
+    def output_ready():
+        skid_out_tready.next = (not out_valid) or m_axis.tready
+
+    @always_seq(clk.posedge, reset=resetn)
+    def output_register():
+        if skid_out_tready:
+            out_valid.next = skid_out_tvalid
+            if skid_out_tvalid:
+                out_data.next = skid_beat[width:]
+                out_last.next = skid_beat[width]
+
+    @always_comb
+    def output_lines():
+        m_axis.tvalid.next = out_valid
+        m_axis.tdata.next = out_data
+        m_axis.tlast.next = out_last
+
+    return instances()
@@ -0,0 +1,186 @@
+#!/usr/bin/python
+#
+# FILE:
+#   reg_bank.py
+#
+# DESCRIPTION:
+#   Address decode and read-data mux of the registers of a block on the
+#   AxiLocal daisy-chain
+#
+# * The hand-written decode of a block compares raddr with every register
+#    address in an if/elif chain, which synthesises to a priority mux as deep
+#    as the block has registers, each compare on all address bits; the write
+#    decoders repeat those full compares. With a few blocks on the chain this
+#    path limits the PL clock.
+# * reg_bank() compares the bank bits of the address (those above the span of
+#    the block) once, and each register on the offset bits only, so the
+#    selects of all registers come out of one LUT level in parallel and at
+#    most one is high: a one-hot decode. An address outside the span (an
+#    alias in the window of another block) is compared on all bits.
+# * rdata is the AND-OR of the register values and the read selects, taken
+#    into a register: REG_BANK_READ_LATENCY clocks from raddr to rdata. The
+#    front end waits for it (READ_LATENCY of axi_connect and
+#    axi_connect_pipelined), and every block on one chain needs the same
+#    latency.
+#
+
+from myhdl import (
+    always_comb,
+    always_seq,
+    block,
+    ConcatSignal,
+    instances,
+    intbv,
+    Signal,
+)
+
+LOW, HIGH = bool(0), bool(1)
+
+# Clocks from raddr to rdata of a block that decodes with reg_bank()
+REG_BANK_READ_LATENCY = 1
+
+
+def _addresses(address):
+    return tuple(address) if isinstance(address, (tuple, list)) else (address,)
+
+
+def _read_value(value, data_width):
+    # A read value as data_width bits: a constant, or a signal zero-extended
+    if isinstance(value, int):
+        return intbv(value)[data_width:]
+    if len(value) > data_width:
+        raise ValueError("reg_bank: read value of %d bits on a %d-bit bus" % (len(value), data_width))
+    if len(value) == data_width:
+        return value
+    return ConcatSignal(intbv(0)[data_width - len(value):], value)
+
+
+@block
+def reg_bank_select(hit, addr, select, address, offset_bits, in_bank, enable=None):
+    """
+    Select of one register address.
+
+    Parameters:
+    hit         Address is in the bank (for writes: and wen)
+    addr        raddr or waddr of the chain
+    select      High while addr is address
+    address     Register address (in units of 4 bytes)
+    offset_bits Offset bits of the bank
+    in_bank     address lies in the bank: compared on the offset bits, with hit
+    enable      Outside the bank: wen for a write select, None for a read
+    """
+    offset = address & ((1 << offset_bits) - 1)
+
+    if in_bank:
+
+        @always_comb
+        def decode():
+            select.next = hit and addr[offset_bits:] == offset
+
+    elif enable is not None:
+
+        @always_comb
+        def decode():
+            select.next = enable and addr == address
+
+    else:
+
+        @always_comb
+        def decode():
+            select.next = addr == address
+
+    return instances()
+
+
+@block
+def reg_bank_any(selects, select):
+    """select is high while one of selects is (a register with aliases)"""
+
+    @always_comb
+    def decode():
+        select.next = selects != 0
+
+    return instances()
+
+
+@block
+def reg_bank(clk, resetn, axi_s, rdata, map_base, span, reads, writes):
+    """
+    Parameters:
+    clk         Clock
+    resetn      Reset
+    axi_s       Connection to upstream blocks (raddr, waddr, wen)
+    rdata       Read data of the block, registered; zero for an address not in reads
+    map_base    Base address of the bank, a multiple of span
+    span        Register addresses the bank covers from map_base, a power of two
+    reads       [(address, value)]: value (a signal, a slice of one or a
+                  constant) reads at address, a register address or a tuple
+                  of them
+    writes      [(address, select)]: select goes high for the clock of a
+                  write to address (likewise one or a tuple); the block
+                  qualifies it with the byte strobes
+
+    Addresses are absolute, in units of 4 bytes like map_base.
+    """
+    addr_width = len(axi_s.raddr)
+    data_width = len(rdata)
+    offset_bits = span.bit_length() - 1
+    if span < 2 or span != 1 << offset_bits or offset_bits >= addr_width:
+        raise ValueError("reg_bank: span %d is not a power of two from 2 to %d"
+                         % (span, 1 << (addr_width - 1)))
+    if map_base % span:
+        raise ValueError("reg_bank: base %d is not a multiple of span %d" % (map_base, span))
+    bank = map_base >> offset_bits
+
+    # Bank bits, compared once for all registers of the bank
+    read_hit = Signal(LOW)
+    write_hit = Signal(LOW)
+
+    @always_comb
+    def bank_decode():
+        read_hit.next = axi_s.raddr[addr_width:offset_bits] == bank
+        write_hit.next = axi_s.wen and axi_s.waddr[addr_width:offset_bits] == bank
+
+    def in_bank(address):
+        return map_base <= address < map_base + span
+
+    # Read: a select and a value per address, aliases repeat the value
+    read_selects = []
+    read_values = []
+    decode_insts = []
+    for address, value in reads:
+        value = _read_value(value, data_width)
+        for a in _addresses(address):
+            select = Signal(LOW)
+            decode_insts.append(reg_bank_select(read_hit, axi_s.raddr, select, a, offset_bits,
+                                                in_bank(a)))
+            read_selects.append(select)
+            read_values.append(value)
+    read_count = len(read_selects)
+    read_select = ConcatSignal(*reversed(read_selects))
+    read_value = ConcatSignal(*reversed(read_values))
+
+    # Write: the select of a register with aliases is the OR of its addresses
+    for address, select in writes:
+        addresses = _addresses(address)
+        if len(addresses) == 1:
+            decode_insts.append(reg_bank_select(write_hit, axi_s.waddr, select, addresses[0],
+                                                offset_bits, in_bank(addresses[0]), axi_s.wen))
+            continue
+        alias_selects = [Signal(LOW) for _ in addresses]
+        for a, alias_select in zip(addresses, alias_selects):
+            decode_insts.append(reg_bank_select(write_hit, axi_s.waddr, alias_select, a,
+                                                offset_bits, in_bank(a), axi_s.wen))
+        decode_insts.append(reg_bank_any(ConcatSignal(*reversed(alias_selects)), select))
+
+    # AND-OR of the one-hot selects and the values, into the rdata register
+    @always_seq(clk.posedge, reset=resetn)
+    def read_mux():
+        for bit in range(data_width):
+            bit_value = LOW
+            for index in range(read_count):
+                if read_select[index] and read_value[data_width * index + bit]:
+                    bit_value = HIGH
+            rdata.next[bit] = bit_value
+
+    return instances()
@@ -0,0 +1,166 @@
+#!/usr/bin/python
+#
+# FILE:
+#   gpio_atomic.py
+#
+#
+
+# * GPIO block with one to GPIO_ATOMIC_MAX_WIDTH outputs, one per bit of the
+#    gpio_o port, and as many inputs as the gpio_i port has bits.
+# * The AXI GPIO only has a DATA register, so two masters (the APU and an RPU
+#    task, say) changing different pins both read, modify and write it, and
+#    one can undo the other. Here every change is a single posted write:
+#    a 1 written to SET drives that pin high, to CLEAR drives it low and to
+#    TOGGLE inverts it; 0 bits leave their pins alone, so writers of disjoint
+#    pins need no lock.
+# * DATA reads the outputs; a write replaces the bytes it strobes, for a
+#    single owner that sets all pins at once.
+# * SET, CLEAR and TOGGLE honour the byte strobes as well: a byte not strobed
+#    changes no pin. Each register is write-only and reads as zero.
+# * INPUT reads the gpio_i pins through two flip-flops, as they are
+#    asynchronous to clk.
+
+
+
+from myhdl import (
+    always_comb,
+    always_seq,
+    block,
+    instances,
+    intbv,
+    ResetSignal,
+    Signal,
+)
+from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+# Register indices: generated from build_utils/regmap/kr260_regmap.py, like
+# the C and C++ headers
+from PL.MyHDL.src.gpio_atomic.gpio_atomic_regs import *  # noqa: F401,F403
+
+PL_ADDR_WIDTH = 12
+PL_DATA_WIDTH = 32
+
+LOW, HIGH = bool(0), bool(1)
+
+
+@block
+def gpio_atomic(clk, resetn, axi_s, axi_m, gpio_i, gpio_o, map_base):
+    """
+    Parameters:
+    clk         Clock
+    resetn      Reset
+    axi_s       Connection to upstream blocks
+    axi_m       Connection to downstream blocks
+    gpio_i      Input pins
+    gpio_o      Output pins; its width (1 to GPIO_ATOMIC_MAX_WIDTH) is the output count
+    map_base    Base address
+
+    Registers:
+    GPIO_ATOMIC_DATA    Output pins, a write replaces the strobed bytes
+    GPIO_ATOMIC_SET     Write-only, bit n drives output n high
+    GPIO_ATOMIC_CLEAR   Write-only, bit n drives output n low
+    GPIO_ATOMIC_TOGGLE  Write-only, bit n inverts output n
+    GPIO_ATOMIC_INPUT   Input pins (read-only)
+    GPIO_ATOMIC_WIDTH   Number of outputs (read-only)
+    """
+    width = len(gpio_o)
+    if width < 1 or width > GPIO_ATOMIC_MAX_WIDTH:
+        raise ValueError("gpio_atomic supports 1 to %d outputs" % GPIO_ATOMIC_MAX_WIDTH)
+    input_width = len(gpio_i)
+
+    # Addresses of registers in block (in units of 4 bytes)
+    gpio_atomic_data_addr = map_base + GPIO_ATOMIC_DATA
+    gpio_atomic_set_addr = map_base + GPIO_ATOMIC_SET
+    gpio_atomic_clear_addr = map_base + GPIO_ATOMIC_CLEAR
+    gpio_atomic_toggle_addr = map_base + GPIO_ATOMIC_TOGGLE
+    gpio_atomic_input_addr = map_base + GPIO_ATOMIC_INPUT
+    gpio_atomic_width_addr = map_base + GPIO_ATOMIC_WIDTH
+    rdata = Signal(intbv(0)[32:])
+    data = Signal(intbv(0)[width:])
+
+    # User defined signals and variables
+    # Input synchroniser
+    input_meta = Signal(intbv(0)[input_width:])
+    input_sync = Signal(intbv(0)[input_width:])
+
+    # AxiLocal pass through logic
+    if axi_m is not None:
+
+        @always_comb
+        def axi_passthrough():
+            axi_m.raddr.next = axi_s.raddr
+            axi_m.waddr.next = axi_s.waddr
+            axi_m.wdata.next = axi_s.wdata
+            axi_m.wstrobe.next = axi_s.wstrobe
+            axi_m.wen.next = axi_s.wen
+            axi_s.rdata.next = axi_m.rdata | rdata
+
+    else:
+
+        @always_comb
+        def axi_passthrough():
+            axi_s.rdata.next = rdata
+
+    @always_comb
+    def register_read():
+        # Read access of registers
+        rdata.next = 0
+        if axi_s.raddr == gpio_atomic_data_addr:
+            rdata.next = data
+        elif axi_s.raddr == gpio_atomic_input_addr:
+            rdata.next = input_sync
+        elif axi_s.raddr == gpio_atomic_width_addr:
+            rdata.next = width
+
+    data_write_decode = Signal(LOW)
+    set_write_decode = Signal(LOW)
+    clear_write_decode = Signal(LOW)
+    toggle_write_decode = Signal(LOW)
+
+    @always_comb
+    def data_write_decoder():
+        data_write_decode.next = axi_s.wen and axi_s.waddr == gpio_atomic_data_addr
+        set_write_decode.next = axi_s.wen and axi_s.waddr == gpio_atomic_set_addr
+        clear_write_decode.next = axi_s.wen and axi_s.waddr == gpio_atomic_clear_addr
+        toggle_write_decode.next = axi_s.wen and axi_s.waddr == gpio_atomic_toggle_addr
+
+    # One access per cycle reaches the block, so the four never coincide
+    @always_seq(clk.posedge, reset=resetn)
+    def data_write():
+        for byte_index in range((width + 7) // 8):
+            if axi_s.wstrobe[byte_index]:
+                for bit_index in range(8):
+                    bit = 8 * byte_index + bit_index
+                    if bit < len(data):
+                        if data_write_decode:
+                            data.next[bit] = axi_s.wdata[bit]
+                        elif set_write_decode and axi_s.wdata[bit]:
+                            data.next[bit] = HIGH
+                        elif clear_write_decode and axi_s.wdata[bit]:
+                            data.next[bit] = LOW
+                        elif toggle_write_decode and axi_s.wdata[bit]:
+                            data.next[bit] = not data[bit]
+
+    @always_seq(clk.posedge, reset=resetn)
+    def sync_input():
+        input_meta.next = gpio_i
+        input_sync.next = input_meta
+
+    @always_comb
+    def assign_gpio_o():
+        gpio_o.next = data
+
+    return instances()
+
+
+if __name__ == "__main__":
+    # Define signals for block ports
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    axi_s = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    axi_m = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    gpio_i = Signal(intbv(0)[2:])
+    gpio_o = Signal(intbv(0)[2:])
+    map_base = 0
+
+    gpio_atomic(clk=clk, resetn=resetn, axi_s=axi_s, axi_m=axi_m, gpio_i=gpio_i,
+                gpio_o=gpio_o, map_base=map_base).convert(hdl='Verilog')
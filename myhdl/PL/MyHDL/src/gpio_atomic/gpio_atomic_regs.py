@@ -0,0 +1,28 @@
+#!/usr/bin/python
+#
+# FILE:
+#   gpio_atomic_regs.py
+#
+# DESCRIPTION:
+#   Register map of gpio_atomic (myhdl/PL/MyHDL/src/gpio_atomic/gpio_atomic.py),
+#   GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py,
+#   do not edit. GPIO_ATOMIC_<REG> is the 32-bit register index,
+#   GPIO_ATOMIC_<REG>_OFFSET the byte offset.
+#
+
+GPIO_ATOMIC_MAX_WIDTH = 32  # Pins of the largest variant
+
+# Register indices
+GPIO_ATOMIC_DATA = 0  # Output pins; a write replaces the bytes it strobes
+GPIO_ATOMIC_SET = 1  # Write 1 to drive a pin high
+GPIO_ATOMIC_CLEAR = 2  # Write 1 to drive a pin low
+GPIO_ATOMIC_TOGGLE = 3  # Write 1 to invert a pin
+GPIO_ATOMIC_INPUT = 4  # Input pins, synchronised to the PL clock
+GPIO_ATOMIC_WIDTH = 5  # Number of output pins
+# Register byte offsets
+GPIO_ATOMIC_DATA_OFFSET = 0x00
+GPIO_ATOMIC_SET_OFFSET = 0x04
+GPIO_ATOMIC_CLEAR_OFFSET = 0x08
+GPIO_ATOMIC_TOGGLE_OFFSET = 0x0C
+GPIO_ATOMIC_INPUT_OFFSET = 0x10
+GPIO_ATOMIC_WIDTH_OFFSET = 0x14
@@ -0,0 +1 @@
+# Set/clear/toggle GPIO IP package
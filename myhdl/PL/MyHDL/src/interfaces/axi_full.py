@@ -0,0 +1,52 @@
+#!/usr/bin/python
+#
+# FILE:
+#   axi_full.py
+#
+# DESCRIPTION: Defines signals for AXI4 (full) interface
+#
+
+from myhdl import (Signal, modbv)
+LOW, HIGH = bool(0), bool(1)
+
+
+class AxiFull(object):
+
+    def __init__(self, ADDR_WIDTH=16, DATA_WIDTH=64, ID_WIDTH=1):
+        self.awid = Signal(modbv(0)[ID_WIDTH:])
+        self.awaddr = Signal(modbv(0)[ADDR_WIDTH:])
+        self.awlen = Signal(modbv(0)[8:])
+        self.awsize = Signal(modbv(0)[3:])
+        self.awburst = Signal(modbv(0)[2:])
+        self.awlock = Signal(LOW)
+        self.awcache = Signal(modbv(0)[4:])
+        self.awprot = Signal(modbv(0)[3:])
+        self.awqos = Signal(modbv(0)[4:])
+        self.awvalid = Signal(LOW)
+        self.awready = Signal(LOW)
+        self.wdata = Signal(modbv(0)[DATA_WIDTH:])
+        self.wstrb = Signal(modbv(0)[(DATA_WIDTH // 8):])
+        self.wlast = Signal(LOW)
+        self.wvalid = Signal(LOW)
+        self.wready = Signal(LOW)
+        self.bid = Signal(modbv(0)[ID_WIDTH:])
+        self.bresp = Signal(modbv(0)[2:])
+        self.bvalid = Signal(LOW)
+        self.bready = Signal(LOW)
+        self.arid = Signal(modbv(0)[ID_WIDTH:])
+        self.araddr = Signal(modbv(0)[ADDR_WIDTH:])
+        self.arlen = Signal(modbv(0)[8:])
+        self.arsize = Signal(modbv(0)[3:])
+        self.arburst = Signal(modbv(0)[2:])
+        self.arlock = Signal(LOW)
+        self.arcache = Signal(modbv(0)[4:])
+        self.arprot = Signal(modbv(0)[3:])
+        self.arqos = Signal(modbv(0)[4:])
+        self.arvalid = Signal(LOW)
+        self.arready = Signal(LOW)
+        self.rid = Signal(modbv(0)[ID_WIDTH:])
+        self.rdata = Signal(modbv(0)[DATA_WIDTH:])
+        self.rresp = Signal(modbv(0)[2:])
+        self.rlast = Signal(LOW)
+        self.rvalid = Signal(LOW)
+        self.rready = Signal(LOW)
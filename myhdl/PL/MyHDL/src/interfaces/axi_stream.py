@@ -0,0 +1,19 @@
+#!/usr/bin/python
+#
+# FILE:
+#   axi_stream.py
+#
+# DESCRIPTION: Defines signals for AXI4-Stream interface
+#
+
+from myhdl import (Signal, modbv)
+LOW, HIGH = bool(0), bool(1)
+
+
+class AxiStream(object):
+
+    def __init__(self, DATA_WIDTH=32):
+        self.tdata = Signal(modbv(0)[DATA_WIDTH:])
+        self.tvalid = Signal(LOW)
+        self.tready = Signal(LOW)
+        self.tlast = Signal(LOW)
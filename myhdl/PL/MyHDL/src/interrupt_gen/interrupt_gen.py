@@ -5,18 +5,50 @@
 #
 #
 
-# * This example block has two interrupt outputs. Interrupts can be time-based
-#    or be triggered by writing to a register. 
+# * This example block has one to 16 interrupt outputs (channels), one per bit of
+#    the interrupt_out port. Interrupts can be time-based or be triggered by
+#    writing to a register.
 # * Each interrupt is associated with a period counter, driven by the master clock.
-#    If the value of this register is zero, the counter is reset and no time-based 
+#    If the value of this register is zero, the counter is reset and no time-based
 #    interrupts occur on that output.
+# * PERIOD is double-buffered: a new value is taken at the end of the running
+#    period, so a change never shortens or stretches the period in progress. A
+#    stopped channel takes it at once, and writing 0 stops the channel at once.
 # * A write-only trigger register may be used to force an interrupt by writing a 1
 #    to the appropriate bit.
 # * We have an interrupt enable register (IER) and an interrupt status register (ISR).
+#    Bit n of ISR, IER and TRIGGER belongs to channel n.
 # * When each period counter expires, the corresponding bit in the ISR is set.
 # * An interrupt output goes high if the associated bit in the ISR is high
 #    and the associated bit in the IER is also high.
 # * A bit in the ISR is cleared by writing a 1 to that bit position.
+# * The registers of each channel are in a bank of its own, at
+#    INTERRUPT_GEN_CHANNEL_BASE + n * INTERRUPT_GEN_CHANNEL_STRIDE. The PERIOD
+#    registers of channels 0 and 1 can also be reached at INTERRUPT_GEN_PERIOD1 and
+#    INTERRUPT_GEN_PERIOD2, the addresses of the original two-channel block.
+# * A free-running 64-bit counter counts clk cycles from reset. When a bit in the
+#    ISR goes from clear to set, the counter value is latched into the timestamp
+#    register pair of that interrupt, so software can compute the latency from the
+#    event to its handler in clock cycles. A timestamp holds while its ISR bit
+#    stays set: read it before clearing the bit. Read a 64-bit pair as HI, LO, HI
+#    and retry if the two HI reads differ.
+# * Every event (period expiry or trigger) increments a free-running 32-bit event
+#    counter of its interrupt, so software can tell how many events one interrupt
+#    stood for by the difference from the value it read last time.
+# * Coalescing: with COALESCE_COUNT above 1 the ISR bit is only set once that many
+#    events are pending; with COALESCE_TIME non-zero it is also set that many cycles
+#    after the first pending event, so a slow event stream is not held back. Both
+#    zero (the reset state) sets the ISR bit on every event.
+# * One-shot compare: writing COMPARE_HI arms the channel's COMPARE_LO/HI pair,
+#    and the channel has an event in the cycle the free-running counter reaches
+#    it, which also disarms it; a value already passed fires at once. Write LO
+#    first: writing COMPARE_LO disarms, so a half-written value never fires.
+#    Bit n of COMPARE_ARMED reads whether channel n is armed; writing a 1 to it
+#    disarms. Being an event, a compare match counts in EVENTS, goes through
+#    coalescing, and its timestamp is the compare value when armed in time.
+# * The registers are decoded by reg_bank(): one-hot selects and a registered
+#    read mux, so rdata follows raddr a clock later and the AXI4-Lite front
+#    end needs READ_LATENCY=REG_BANK_READ_LATENCY.
 
 
 
@@ -24,6 +56,7 @@ from myhdl import (
     always_comb,
     always_seq,
     block,
+    ConcatSignal,
     instances,
     intbv,
     modbv,
@@ -31,103 +64,86 @@ from myhdl import (
     Signal,
 )
 from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+from PL.MyHDL.src.axi_support.reg_bank import reg_bank
+# Register indices, bit fields and interrupt_gen_bank(): generated from
+# build_utils/regmap/kr260_regmap.py, like the C and C++ headers
+from PL.MyHDL.src.interrupt_gen.interrupt_gen_regs import *  # noqa: F401,F403
 
 PL_ADDR_WIDTH = 12
 PL_DATA_WIDTH = 32
 PL_REG_WIDTH = 32
-
-# Register indices
-INTERRUPT_GEN_PERIOD1 = 0
-INTERRUPT_GEN_PERIOD2 = 1
-INTERRUPT_GEN_ISR = 2
-INTERRUPT_GEN_IER = 3
-INTERRUPT_GEN_TRIGGER = 4
-# Register bit fields
-INTERRUPT_GEN_ISR_INTERRUPT1_B = 0
-INTERRUPT_GEN_ISR_INTERRUPT1_W = 1
-INTERRUPT_GEN_ISR_INTERRUPT2_B = 1
-INTERRUPT_GEN_ISR_INTERRUPT2_W = 1
-INTERRUPT_GEN_IER_INTERRUPT1_B = 0
-INTERRUPT_GEN_IER_INTERRUPT1_W = 1
-INTERRUPT_GEN_IER_INTERRUPT2_B = 1
-INTERRUPT_GEN_IER_INTERRUPT2_W = 1
-INTERRUPT_GEN_TRIGGER_INTERRUPT1_B = 0
-INTERRUPT_GEN_TRIGGER_INTERRUPT1_W = 1
-INTERRUPT_GEN_TRIGGER_INTERRUPT2_B = 1
-INTERRUPT_GEN_TRIGGER_INTERRUPT2_W = 1
+PL_COUNTER_WIDTH = 64
 
 LOW, HIGH = bool(0), bool(1)
 
 
 @block
-def interrupt_gen(clk, resetn, axi_s, axi_m, interrupt1_out, interrupt2_out, map_base):
+def interrupt_gen_channel(clk, resetn, axi_s, axi_m, cycle_counter, trigger_in, isr_in,
+                          isr_clear, isr_set, compare_disarm, compare_armed, bank_base,
+                          period_alias):
     """
-    Parameters:
-    clk         Clock
-    resetn      Reset
-    axi_s       Connection to upstream blocks
-    axi_m       Connection to downstream blocks
-    interrupt1_out  Goes high if interrupt 1 is asserted and bit in IER is set
-    interrupt2_out  Goes high if interrupt 2 is asserted and bit in IER is set
-    map_base    Base address
+    One channel of interrupt_gen: period counter, one-shot compare, timestamp, event
+    counter and coalescing, with the registers of its bank.
 
-    Registers:
-    INTERRUPT_GEN_PERIOD1   Divisor from clk to generate periodic interrupt 1, set to 0 for no periodic interrupts
-    INTERRUPT_GEN_PERIOD2   Divisor from clk to generate periodic interrupt 2, set to 0 for no periodic interrupts
-    INTERRUPT_GEN_ISR   Interrupt status register whose bits indicate interrupt assertion
-    INTERRUPT_GEN_IER   Interrupt enable register whose bits allow an interrupt assertion to lead
-                          to a high level on the associated interrupt output port
-    INTERRUPT_GEN_TRIGGER   Write-only register allowing interrupt to be triggered
-
-    Fields in INTERRUPT_GEN_ISR:
-    INTERRUPT_GEN_ISR_INTERRUPT1    Indicates interrupt 1 asserted
-    INTERRUPT_GEN_ISR_INTERRUPT2    Indicates interrupt 2 asserted
-
-    Fields in INTERRUPT_GEN_IER:
-    INTERRUPT_GEN_IER_INTERRUPT1    Enables interrupt1_out
-    INTERRUPT_GEN_IER_INTERRUPT2    Enables interrupt2_out
-
-    Fields in INTERRUPT_GEN_TRIGGER:
-    INTERRUPT_GEN_TRIGGER_INTERRUPT1 Triggers interrupt 1
-    INTERRUPT_GEN_TRIGGER_INTERRUPT2 Triggers interrupt 2
+    Parameters:
+    clk             Clock
+    resetn          Reset
+    axi_s           Connection to upstream blocks
+    axi_m           Connection to downstream blocks
+    cycle_counter   Free-running cycle counter of the block
+    trigger_in      TRIGGER bit of the channel
+    isr_in          ISR bit of the channel
+    isr_clear       Goes high while software clears the ISR bit
+    isr_set         Goes high for a cycle to set the ISR bit, after coalescing
+    compare_disarm  Goes high while software clears the COMPARE_ARMED bit
+    compare_armed   COMPARE_ARMED bit of the channel
+    bank_base       Address of the register bank
+    period_alias    Second address of the PERIOD register, or None
+
+    Registers (relative to bank_base):
+    INTERRUPT_GEN_CH_PERIOD         Divisor from clk to generate periodic interrupts, 0 for none;
+                                      taken at the end of the running period
+    INTERRUPT_GEN_CH_TIMESTAMP_LO   Counter when the ISR bit was last set, bits 31:0 (read-only)
+    INTERRUPT_GEN_CH_TIMESTAMP_HI   Counter when the ISR bit was last set, bits 63:32 (read-only)
+    INTERRUPT_GEN_CH_EVENTS         Events since reset, wrapping (read-only)
+    INTERRUPT_GEN_CH_COALESCE_COUNT Pending events that set the ISR bit, 0 or 1 for every event
+    INTERRUPT_GEN_CH_COALESCE_TIME  Cycles from the first pending event to setting the ISR bit,
+                                      0 for no time limit
+    INTERRUPT_GEN_CH_COMPARE_LO     Counter value of the one-shot event, bits 31:0; a write
+                                      disarms it
+    INTERRUPT_GEN_CH_COMPARE_HI     Bits 63:32; a write arms the compare
     """
     # Addresses of registers in block (in units of 4 bytes)
-    interrupt_gen_period1_addr = map_base + INTERRUPT_GEN_PERIOD1
-    interrupt_gen_period2_addr = map_base + INTERRUPT_GEN_PERIOD2
-    interrupt_gen_isr_addr = map_base + INTERRUPT_GEN_ISR
-    interrupt_gen_ier_addr = map_base + INTERRUPT_GEN_IER
-    interrupt_gen_trigger_addr = map_base + INTERRUPT_GEN_TRIGGER
+    period_addr = bank_base + INTERRUPT_GEN_CH_PERIOD
+    period_addrs = period_addr if period_alias is None else (period_addr, period_alias)
+    timestamp_lo_addr = bank_base + INTERRUPT_GEN_CH_TIMESTAMP_LO
+    timestamp_hi_addr = bank_base + INTERRUPT_GEN_CH_TIMESTAMP_HI
+    events_addr = bank_base + INTERRUPT_GEN_CH_EVENTS
+    coalesce_count_addr = bank_base + INTERRUPT_GEN_CH_COALESCE_COUNT
+    coalesce_time_addr = bank_base + INTERRUPT_GEN_CH_COALESCE_TIME
+    compare_lo_addr = bank_base + INTERRUPT_GEN_CH_COMPARE_LO
+    compare_hi_addr = bank_base + INTERRUPT_GEN_CH_COMPARE_HI
     rdata = Signal(intbv(0)[32:])
-    period1 = Signal(intbv(0)[PL_REG_WIDTH:])
-    period2 = Signal(intbv(0)[PL_REG_WIDTH:])
-    isr = Signal(intbv(0)[8:])
-    ier = Signal(intbv(0)[8:])
-    trigger = Signal(intbv(0)[8:])
-
-    # Unpacking ier register
-
-    ier_interrupt1 = Signal(LOW)
-    ier_interrupt2 = Signal(LOW)
-
-    @always_comb
-    def unpack_ier():
-        ier_interrupt1.next = ier[INTERRUPT_GEN_IER_INTERRUPT1_B]
-        ier_interrupt2.next = ier[INTERRUPT_GEN_IER_INTERRUPT2_B]
-
-    # Unpacking trigger register
-
-    trigger_interrupt1 = Signal(LOW)
-    trigger_interrupt2 = Signal(LOW)
-
-    @always_comb
-    def unpack_trigger():
-        trigger_interrupt1.next = trigger[INTERRUPT_GEN_TRIGGER_INTERRUPT1_B]
-        trigger_interrupt2.next = trigger[INTERRUPT_GEN_TRIGGER_INTERRUPT2_B]
+    period = Signal(intbv(0)[PL_REG_WIDTH:])
+    coalesce_count = Signal(intbv(0)[PL_REG_WIDTH:])
+    coalesce_time = Signal(intbv(0)[PL_REG_WIDTH:])
+    compare = Signal(intbv(0)[PL_COUNTER_WIDTH:])
 
     # User defined signals and variables
-    # Counters for periodic interrupts
-    period1_counter = Signal(modbv(0)[PL_REG_WIDTH:])
-    period2_counter = Signal(modbv(0)[PL_REG_WIDTH:])
+    # Counter for periodic interrupts and the PERIOD it counts, updated at its end
+    period_counter = Signal(modbv(0)[PL_REG_WIDTH:])
+    period_active = Signal(intbv(0)[PL_REG_WIDTH:])
+    # The armed compare value is reached
+    compare_hit = Signal(LOW)
+    # Value latched when the ISR bit is set
+    timestamp = Signal(intbv(0)[PL_COUNTER_WIDTH:])
+    # Events since reset, events not yet signalled in the ISR and cycles since the
+    # first of those
+    events = Signal(modbv(0)[PL_REG_WIDTH:])
+    pending = Signal(modbv(0)[PL_REG_WIDTH:])
+    pending_age = Signal(modbv(0)[PL_REG_WIDTH:])
+    # An interrupt event this cycle
+    event = Signal(LOW)
 
     # AxiLocal pass through logic
     if axi_m is not None:
@@ -147,140 +163,333 @@ def interrupt_gen(clk, resetn, axi_s, axi_m, interrupt1_out, interrupt2_out, map
         def axi_passthrough():
             axi_s.rdata.next = rdata
 
-    @always_comb
-    def register_read():
-        # Read access of registers
-        rdata.next = 0
-        if axi_s.raddr == interrupt_gen_period1_addr:
-            rdata.next = period1
-        elif axi_s.raddr == interrupt_gen_period2_addr:
-            rdata.next = period2
-        elif axi_s.raddr == interrupt_gen_isr_addr:
-            rdata.next = isr
-        elif axi_s.raddr == interrupt_gen_ier_addr:
-            rdata.next = ier
-
-    period1_write_decode = Signal(LOW)
-
-    @always_comb
-    def period1_write_decoder():
-        period1_write_decode.next = (
-            axi_s.wen and axi_s.waddr == interrupt_gen_period1_addr
-        )
-
+    period_write_decode = Signal(LOW)
+    coalesce_count_write_decode = Signal(LOW)
+    coalesce_time_write_decode = Signal(LOW)
+    compare_lo_write_decode = Signal(LOW)
+    compare_hi_write_decode = Signal(LOW)
+
+    # Decode and registered read mux of the bank; rdata follows raddr a clock later
+    reg_bank_inst = reg_bank(
+        clk=clk,
+        resetn=resetn,
+        axi_s=axi_s,
+        rdata=rdata,
+        map_base=bank_base,
+        span=INTERRUPT_GEN_CHANNEL_STRIDE,
+        reads=[
+            (period_addrs, period),
+            (timestamp_lo_addr, timestamp(32, 0)),
+            (timestamp_hi_addr, timestamp(64, 32)),
+            (events_addr, events),
+            (coalesce_count_addr, coalesce_count),
+            (coalesce_time_addr, coalesce_time),
+            (compare_lo_addr, compare(32, 0)),
+            (compare_hi_addr, compare(64, 32)),
+        ],
+        writes=[
+            (period_addrs, period_write_decode),
+            (coalesce_count_addr, coalesce_count_write_decode),
+            (coalesce_time_addr, coalesce_time_write_decode),
+            (compare_lo_addr, compare_lo_write_decode),
+            (compare_hi_addr, compare_hi_write_decode),
+        ],
+    )
 
     @always_seq(clk.posedge, reset=resetn)
-    def period1_write():
-        if period1_write_decode:
+    def period_write():
+        if period_write_decode:
             for byte_index in range((PL_REG_WIDTH + 7) // 8):
                 if axi_s.wstrobe[byte_index]:
                     for bit_index in range(8):
                         bit = 8 * byte_index + bit_index
-                        if bit < len(period1):
-                            period1.next[bit] = axi_s.wdata[bit]
-
-    period2_write_decode = Signal(LOW)
+                        if bit < len(period):
+                            period.next[bit] = axi_s.wdata[bit]
 
-    @always_comb
-    def period2_write_decoder():
-        period2_write_decode.next = (
-            axi_s.wen and axi_s.waddr == interrupt_gen_period2_addr
-        )
+    @always_seq(clk.posedge, reset=resetn)
+    def coalesce_count_write():
+        if coalesce_count_write_decode:
+            for byte_index in range((PL_REG_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(coalesce_count):
+                            coalesce_count.next[bit] = axi_s.wdata[bit]
 
     @always_seq(clk.posedge, reset=resetn)
-    def period2_write():
-        if period2_write_decode:
+    def coalesce_time_write():
+        if coalesce_time_write_decode:
             for byte_index in range((PL_REG_WIDTH + 7) // 8):
                 if axi_s.wstrobe[byte_index]:
                     for bit_index in range(8):
                         bit = 8 * byte_index + bit_index
-                        if bit < len(period2):
-                            period2.next[bit] = axi_s.wdata[bit]
+                        if bit < len(coalesce_time):
+                            coalesce_time.next[bit] = axi_s.wdata[bit]
 
-    isr_write_decode = Signal(LOW)
+    @always_seq(clk.posedge, reset=resetn)
+    def compare_write():
+        for byte_index in range(4):
+            if axi_s.wstrobe[byte_index]:
+                for bit_index in range(8):
+                    bit = 8 * byte_index + bit_index
+                    if compare_lo_write_decode:
+                        compare.next[bit] = axi_s.wdata[bit]
+                    elif compare_hi_write_decode:
+                        compare.next[32 + bit] = axi_s.wdata[bit]
+
+    # A COMPARE_HI write arms the compare; a match, a COMPARE_LO write or a 1
+    # written to the COMPARE_ARMED bit disarms it
+    @always_seq(clk.posedge, reset=resetn)
+    def compare_arm():
+        if compare_hi_write_decode:
+            compare_armed.next = HIGH
+        elif compare_hit or compare_lo_write_decode or compare_disarm:
+            compare_armed.next = LOW
+
+    @always_comb
+    def compare_decoder():
+        compare_hit.next = compare_armed and cycle_counter >= compare
+
+    @always_comb
+    def event_decoder():
+        event.next = (
+            (period_active != 0 and period_counter >= period_active - 1)
+            or trigger_in
+            or compare_hit
+        )
 
+    # The ISR bit is set by the event that brings the pending count to
+    # COALESCE_COUNT, or once the oldest pending event is COALESCE_TIME cycles old
     @always_comb
-    def isr_write_decoder():
-        isr_write_decode.next = axi_s.wen and axi_s.waddr == interrupt_gen_isr_addr
+    def coalesce_decoder():
+        isr_set.next = (
+            event and (coalesce_count <= 1 or pending + 1 >= coalesce_count)
+        ) or (
+            coalesce_time != 0 and pending != 0 and pending_age >= coalesce_time - 1
+        )
 
     @always_seq(clk.posedge, reset=resetn)
-    def isr_write():
-        if isr_write_decode:
-            for byte_index in range((8 + 7) // 8):
-                if axi_s.wstrobe[byte_index]:
-                    for bit_index in range(8):
-                        bit = 8 * byte_index + bit_index
-                        if bit < len(isr):
-                            isr.next[bit] = isr[bit] & (~axi_s.wdata[bit])
+    def handle_coalescing():
+        if event:
+            events.next = events + 1
+        if isr_set:
+            pending.next = 0
+            pending_age.next = 0
+        else:
+            if event:
+                pending.next = pending + 1
+            if pending != 0:
+                pending_age.next = pending_age + 1
+
+    @always_seq(clk.posedge, reset=resetn)
+    def handle_period_counter():
+        if period_active == 0:
+            period_counter.next = 0
+        elif period_counter >= period_active - 1:
+            period_counter.next = 0
+        else:
+            period_counter.next = period_counter + 1
+
+    # The written PERIOD takes effect at the end of the running period, at once
+    # on a stopped channel or when it is 0
+    @always_seq(clk.posedge, reset=resetn)
+    def handle_period_load():
+        if period == 0 or period_active == 0 or period_counter >= period_active - 1:
+            period_active.next = period
+
+    # Latch on the clear-to-set transition only (an event as software clears
+    # the bit counts as one), so a timestamp holds until the bit is cleared
+    @always_seq(clk.posedge, reset=resetn)
+    def capture_timestamp():
+        if isr_set and (not isr_in or isr_clear):
+            timestamp.next = cycle_counter
+
+    return instances()
 
-        if (period1 != 0 and period1_counter >= period1 - 1) or trigger_interrupt1:
-            isr.next[INTERRUPT_GEN_ISR_INTERRUPT1_B] = HIGH
 
-        if (period2 != 0 and period2_counter >= period2 - 1) or trigger_interrupt2:
-            isr.next[INTERRUPT_GEN_ISR_INTERRUPT2_B] = HIGH
+@block
+def interrupt_gen(clk, resetn, axi_s, axi_m, interrupt_out, map_base):
+    """
+    Parameters:
+    clk         Clock
+    resetn      Reset
+    axi_s       Connection to upstream blocks
+    axi_m       Connection to downstream blocks
+    interrupt_out   Bit n goes high if interrupt n is asserted and bit n in IER is set;
+                      its width (1 to INTERRUPT_GEN_MAX_CHANNELS) is the channel count
+    map_base    Base address
+
+    Registers:
+    INTERRUPT_GEN_PERIOD1   PERIOD register of channel 0 (also in its bank)
+    INTERRUPT_GEN_PERIOD2   PERIOD register of channel 1 (also in its bank)
+    INTERRUPT_GEN_ISR   Interrupt status register whose bits indicate interrupt assertion
+    INTERRUPT_GEN_IER   Interrupt enable register whose bits allow an interrupt assertion to lead
+                          to a high level on the associated interrupt output bit
+    INTERRUPT_GEN_TRIGGER   Write-only register allowing interrupt to be triggered
+    INTERRUPT_GEN_COUNTER_LO    Free-running clk cycle counter, bits 31:0 (read-only)
+    INTERRUPT_GEN_COUNTER_HI    Free-running clk cycle counter, bits 63:32 (read-only)
+    INTERRUPT_GEN_CHANNELS  Number of channels (read-only)
+    INTERRUPT_GEN_COMPARE_ARMED Compares armed; write 1 to a bit to disarm
+    interrupt_gen_bank(n) + INTERRUPT_GEN_CH_*  Registers of channel n (interrupt_gen_channel)
+
+    Fields in INTERRUPT_GEN_ISR:
+    Bit n       Indicates interrupt n asserted
+
+    Fields in INTERRUPT_GEN_IER:
+    Bit n       Enables bit n of interrupt_out
+
+    Fields in INTERRUPT_GEN_TRIGGER:
+    Bit n       Triggers interrupt n
+
+    Fields in INTERRUPT_GEN_COMPARE_ARMED:
+    Bit n       Compare of channel n armed
+    """
+    num_channels = len(interrupt_out)
+    if num_channels < 1 or num_channels > INTERRUPT_GEN_MAX_CHANNELS:
+        raise ValueError("interrupt_gen supports 1 to %d channels" % INTERRUPT_GEN_MAX_CHANNELS)
 
+    # Addresses of registers in block (in units of 4 bytes)
+    interrupt_gen_isr_addr = map_base + INTERRUPT_GEN_ISR
+    interrupt_gen_ier_addr = map_base + INTERRUPT_GEN_IER
+    interrupt_gen_trigger_addr = map_base + INTERRUPT_GEN_TRIGGER
+    interrupt_gen_counter_lo_addr = map_base + INTERRUPT_GEN_COUNTER_LO
+    interrupt_gen_counter_hi_addr = map_base + INTERRUPT_GEN_COUNTER_HI
+    interrupt_gen_channels_addr = map_base + INTERRUPT_GEN_CHANNELS
+    interrupt_gen_compare_armed_addr = map_base + INTERRUPT_GEN_COMPARE_ARMED
+    rdata = Signal(intbv(0)[32:])
+    isr = Signal(intbv(0)[num_channels:])
+    ier = Signal(intbv(0)[num_channels:])
+    trigger = Signal(intbv(0)[num_channels:])
+
+    # User defined signals and variables
+    # Cycle counter, shared by the timestamps of all channels
+    cycle_counter = Signal(modbv(0)[PL_COUNTER_WIDTH:])
+    # ISR bits cleared by software this cycle, and set by their channel
+    isr_clear = Signal(intbv(0)[num_channels:])
+    isr_set_bits = [Signal(LOW) for _ in range(num_channels)]
+    isr_set = ConcatSignal(*reversed(isr_set_bits))
+    # COMPARE_ARMED bits of the channels, and those software clears this cycle
+    compare_armed_bits = [Signal(LOW) for _ in range(num_channels)]
+    compare_armed = ConcatSignal(*reversed(compare_armed_bits))
+    compare_disarm = Signal(intbv(0)[num_channels:])
+
+    # AxiLocal daisy-chain: this block, then channel 0 to channel N-1
+    axi_chain = [AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH) for _ in range(num_channels)]
+    axi_c = axi_chain[0]
+
+    @always_comb
+    def axi_passthrough():
+        axi_c.raddr.next = axi_s.raddr
+        axi_c.waddr.next = axi_s.waddr
+        axi_c.wdata.next = axi_s.wdata
+        axi_c.wstrobe.next = axi_s.wstrobe
+        axi_c.wen.next = axi_s.wen
+        axi_s.rdata.next = axi_c.rdata | rdata
+
+    channel_insts = []
+    for channel in range(num_channels):
+        channel_insts.append(
+            interrupt_gen_channel(
+                clk=clk,
+                resetn=resetn,
+                axi_s=axi_chain[channel],
+                axi_m=axi_chain[channel + 1] if channel + 1 < num_channels else axi_m,
+                cycle_counter=cycle_counter,
+                trigger_in=trigger(channel),
+                isr_in=isr(channel),
+                isr_clear=isr_clear(channel),
+                isr_set=isr_set_bits[channel],
+                compare_disarm=compare_disarm(channel),
+                compare_armed=compare_armed_bits[channel],
+                bank_base=map_base + interrupt_gen_bank(channel),
+                period_alias=(map_base + INTERRUPT_GEN_PERIOD1 if channel == 0 else
+                              map_base + INTERRUPT_GEN_PERIOD2 if channel == 1 else None),
+            )
+        )
+
+    isr_write_decode = Signal(LOW)
     ier_write_decode = Signal(LOW)
+    trigger_write_decode = Signal(LOW)
+    compare_armed_write_decode = Signal(LOW)
+
+    # Decode and registered read mux of the block registers below the channel
+    # banks; rdata follows raddr a clock later, as in the channels
+    reg_bank_inst = reg_bank(
+        clk=clk,
+        resetn=resetn,
+        axi_s=axi_s,
+        rdata=rdata,
+        map_base=map_base,
+        span=INTERRUPT_GEN_CHANNEL_BASE,
+        reads=[
+            (interrupt_gen_isr_addr, isr),
+            (interrupt_gen_ier_addr, ier),
+            (interrupt_gen_counter_lo_addr, cycle_counter(32, 0)),
+            (interrupt_gen_counter_hi_addr, cycle_counter(64, 32)),
+            (interrupt_gen_channels_addr, num_channels),
+            (interrupt_gen_compare_armed_addr, compare_armed),
+        ],
+        writes=[
+            (interrupt_gen_isr_addr, isr_write_decode),
+            (interrupt_gen_ier_addr, ier_write_decode),
+            (interrupt_gen_trigger_addr, trigger_write_decode),
+            (interrupt_gen_compare_armed_addr, compare_armed_write_decode),
+        ],
+    )
+
+    @always_comb
+    def isr_clear_decoder():
+        for bit in range(num_channels):
+            isr_clear.next[bit] = (
+                isr_write_decode and axi_s.wstrobe[bit // 8] and axi_s.wdata[bit]
+            )
+
+    # A channel setting its bit wins over software clearing it in the same cycle
+    @always_seq(clk.posedge, reset=resetn)
+    def isr_write():
+        for bit in range(num_channels):
+            if isr_clear[bit]:
+                isr.next[bit] = LOW
+            if isr_set[bit]:
+                isr.next[bit] = HIGH
 
     @always_comb
-    def ier_write_decoder():
-        ier_write_decode.next = axi_s.wen and axi_s.waddr == interrupt_gen_ier_addr
+    def compare_disarm_decoder():
+        for bit in range(num_channels):
+            compare_disarm.next[bit] = (
+                compare_armed_write_decode and axi_s.wstrobe[bit // 8] and axi_s.wdata[bit]
+            )
 
     @always_seq(clk.posedge, reset=resetn)
     def ier_write():
         if ier_write_decode:
-            for byte_index in range((8 + 7) // 8):
+            for byte_index in range((num_channels + 7) // 8):
                 if axi_s.wstrobe[byte_index]:
                     for bit_index in range(8):
                         bit = 8 * byte_index + bit_index
                         if bit < len(ier):
                             ier.next[bit] = axi_s.wdata[bit]
 
-    trigger_write_decode = Signal(LOW)
-
-    @always_comb
-    def trigger_write_decoder():
-        trigger_write_decode.next = (
-            axi_s.wen and axi_s.waddr == interrupt_gen_trigger_addr
-        )
-
+    # A trigger bit is high for one cycle, then clears itself
     @always_seq(clk.posedge, reset=resetn)
     def trigger_write():
         if trigger_write_decode:
-            for byte_index in range((8 + 7) // 8):
+            for byte_index in range((num_channels + 7) // 8):
                 if axi_s.wstrobe[byte_index]:
                     for bit_index in range(8):
                         bit = 8 * byte_index + bit_index
                         if bit < len(trigger):
                             trigger.next[bit] = axi_s.wdata[bit]
         else:
-            if trigger_interrupt1:
-                trigger.next[INTERRUPT_GEN_TRIGGER_INTERRUPT1_B] = LOW
-            if trigger_interrupt2:
-                trigger.next[INTERRUPT_GEN_TRIGGER_INTERRUPT2_B] = LOW
+            trigger.next = 0
 
     @always_seq(clk.posedge, reset=resetn)
-    def handle_period1_counter():
-        if period1 == 0:
-            period1_counter.next = 0
-        elif period1_counter >= period1 - 1:
-            period1_counter.next = 0
-        else:
-            period1_counter.next = period1_counter + 1
-
-    @always_seq(clk.posedge, reset=resetn)
-    def handle_period2_counter():
-        if period2 == 0:
-            period2_counter.next = 0
-        elif period2_counter >= period2 - 1:
-            period2_counter.next = 0
-        else:
-            period2_counter.next = period2_counter + 1
-
+    def handle_cycle_counter():
+        cycle_counter.next = cycle_counter + 1
 
     @always_comb
     def assigninterrupt_out():
-        interrupt1_out.next = ier_interrupt1 and isr[INTERRUPT_GEN_ISR_INTERRUPT1_B]
-        interrupt2_out.next = ier_interrupt2 and isr[INTERRUPT_GEN_ISR_INTERRUPT2_B]
+        interrupt_out.next = ier & isr
 
     return instances()
 
@@ -291,10 +500,8 @@ if __name__ == "__main__":
     resetn = ResetSignal(0, active=0, isasync=True)
     axi_s = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
     axi_m = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
-    interrupt1_out = Signal(LOW)
-    interrupt2_out = Signal(LOW)
+    interrupt_out = Signal(intbv(0)[2:])
     map_base = 0
 
     interrupt_gen(clk=clk, resetn=resetn, axi_s=axi_s, axi_m=axi_m,
-                  interrupt1_out=interrupt1_out,
-                  interrupt2_out=interrupt2_out, map_base=map_base).convert(hdl='Verilog')
+                  interrupt_out=interrupt_out, map_base=map_base).convert(hdl='Verilog')
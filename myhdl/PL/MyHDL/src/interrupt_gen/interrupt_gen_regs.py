@@ -0,0 +1,77 @@
+#!/usr/bin/python
+#
+# FILE:
+#   interrupt_gen_regs.py
+#
+# DESCRIPTION:
+#   Register map of interrupt_gen (myhdl/PL/MyHDL/src/interrupt_gen/interrupt_gen.py),
+#   GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py,
+#   do not edit. INTERRUPT_GEN_<REG> is the 32-bit register index,
+#   INTERRUPT_GEN_<REG>_OFFSET the byte offset.
+#
+
+INTERRUPT_GEN_MAX_CHANNELS = 16  # Channels of the interrupt_out variant
+
+# Register indices
+INTERRUPT_GEN_PERIOD1 = 0  # PERIOD of channel 0
+INTERRUPT_GEN_PERIOD2 = 1  # PERIOD of channel 1
+INTERRUPT_GEN_ISR = 2  # Bit n: channel n pending, write 1 to clear
+INTERRUPT_GEN_IER = 3  # Bit n: channel n enabled
+INTERRUPT_GEN_TRIGGER = 4  # Write 1 to bit n to raise channel n
+INTERRUPT_GEN_COUNTER_LO = 5  # Free-running PL clock count
+INTERRUPT_GEN_COUNTER_HI = 6
+INTERRUPT_GEN_CHANNELS = 7  # Number of channels, 0 on the two-channel block
+INTERRUPT_GEN_COMPARE_ARMED = 8  # Bit n: channel n compare armed, write 1 to disarm
+INTERRUPT_GEN_CHANNEL_BASE = 32
+INTERRUPT_GEN_CHANNEL_STRIDE = 8
+# Register byte offsets
+INTERRUPT_GEN_PERIOD1_OFFSET = 0x00
+INTERRUPT_GEN_PERIOD2_OFFSET = 0x04
+INTERRUPT_GEN_ISR_OFFSET = 0x08
+INTERRUPT_GEN_IER_OFFSET = 0x0C
+INTERRUPT_GEN_TRIGGER_OFFSET = 0x10
+INTERRUPT_GEN_COUNTER_LO_OFFSET = 0x14
+INTERRUPT_GEN_COUNTER_HI_OFFSET = 0x18
+INTERRUPT_GEN_CHANNELS_OFFSET = 0x1C
+INTERRUPT_GEN_COMPARE_ARMED_OFFSET = 0x20
+# Register indices within a channel bank
+INTERRUPT_GEN_CH_PERIOD = 0  # Clocks between events, 0 stops the channel
+INTERRUPT_GEN_CH_TIMESTAMP_LO = 1  # Counter when the ISR bit was set
+INTERRUPT_GEN_CH_TIMESTAMP_HI = 2
+INTERRUPT_GEN_CH_EVENTS = 3  # Free-running 32-bit event count
+INTERRUPT_GEN_CH_COALESCE_COUNT = 4  # Events per ISR bit, 0 or 1: every event
+INTERRUPT_GEN_CH_COALESCE_TIME = 5  # Clocks from the first pending event, 0: off
+INTERRUPT_GEN_CH_COMPARE_LO = 6  # COUNTER value of a one-shot event, disarms
+INTERRUPT_GEN_CH_COMPARE_HI = 7  # Bits 63:32 of COMPARE; a write arms it
+# Register byte offsets within a channel bank
+INTERRUPT_GEN_CH_PERIOD_OFFSET = 0x00
+INTERRUPT_GEN_CH_TIMESTAMP_LO_OFFSET = 0x04
+INTERRUPT_GEN_CH_TIMESTAMP_HI_OFFSET = 0x08
+INTERRUPT_GEN_CH_EVENTS_OFFSET = 0x0C
+INTERRUPT_GEN_CH_COALESCE_COUNT_OFFSET = 0x10
+INTERRUPT_GEN_CH_COALESCE_TIME_OFFSET = 0x14
+INTERRUPT_GEN_CH_COMPARE_LO_OFFSET = 0x18
+INTERRUPT_GEN_CH_COMPARE_HI_OFFSET = 0x1C
+# Register bit fields
+INTERRUPT_GEN_ISR_INTERRUPT1_B = 0
+INTERRUPT_GEN_ISR_INTERRUPT1_W = 1
+INTERRUPT_GEN_ISR_INTERRUPT2_B = 1
+INTERRUPT_GEN_ISR_INTERRUPT2_W = 1
+INTERRUPT_GEN_IER_INTERRUPT1_B = 0
+INTERRUPT_GEN_IER_INTERRUPT1_W = 1
+INTERRUPT_GEN_IER_INTERRUPT2_B = 1
+INTERRUPT_GEN_IER_INTERRUPT2_W = 1
+INTERRUPT_GEN_TRIGGER_INTERRUPT1_B = 0
+INTERRUPT_GEN_TRIGGER_INTERRUPT1_W = 1
+INTERRUPT_GEN_TRIGGER_INTERRUPT2_B = 1
+INTERRUPT_GEN_TRIGGER_INTERRUPT2_W = 1
+
+
+def interrupt_gen_bank(channel):
+    """Register index of the bank of channel (0-based)"""
+    return INTERRUPT_GEN_CHANNEL_BASE + channel * INTERRUPT_GEN_CHANNEL_STRIDE
+
+
+def interrupt_gen_bank_offset(channel):
+    """Byte offset of the bank of channel (0-based)"""
+    return 4 * interrupt_gen_bank(channel)
@@ -1,39 +1,50 @@
 #!/usr/bin/python
 
+import sys
+
 from myhdl import (
     always_comb,
     block,
     instances,
+    intbv,
     ResetSignal,
     Signal,
 )
 
 from PL.MyHDL.src.interfaces.axi_lite import AxiLite
 from PL.MyHDL.src.interfaces.axi_local import AxiLocal
-from PL.MyHDL.src.axi_support.axi_support import axi_connect
-from PL.MyHDL.src.interrupt_gen.interrupt_gen import interrupt_gen
+from PL.MyHDL.src.axi_support.axi_support import axi_connect, axi_connect_pipelined
+from PL.MyHDL.src.axi_support.reg_bank import REG_BANK_READ_LATENCY
+from PL.MyHDL.src.interrupt_gen.interrupt_gen import (
+    INTERRUPT_GEN_ISR_INTERRUPT1_B,
+    INTERRUPT_GEN_ISR_INTERRUPT2_B,
+    INTERRUPT_GEN_MAX_CHANNELS,
+    interrupt_gen,
+)
 
 LOW, HIGH = bool(0), bool(1)
 
 PL_ADDR_WIDTH = 12
 PL_DATA_WIDTH = 32
 PL_INTERRUPT_GENERATOR = 0
+# AXI4-Lite front end: axi_connect_pipelined accepts a register access every
+# cycle; False selects the one-transaction-at-a-time axi_connect
+PL_AXI_PIPELINED = True
 
 @block
-def interrupt_generator_ip(
+def interrupt_generator_n_ip(
     clk,
     resetn,
     s00_axi,
-    interrupt1_out,
-    interrupt2_out,
+    interrupt_out,
 ):
     """
     Parameters:
     clk             System clock (50MHz)
     resetn          System reset
     s00_axi         AXI4 slave interface
-    interrupt1_out  Interrupt 1 output
-    interrupt2_out  Interrupt 2 output
+    interrupt_out   Interrupt outputs, one bit per channel; its width (1 to
+                    INTERRUPT_GEN_MAX_CHANNELS) sets the channel count
     """
     # Wrapped interface signal definitions
     _s00_axi = AxiLite(PL_ADDR_WIDTH, PL_DATA_WIDTH)
@@ -61,37 +72,92 @@ def interrupt_generator_ip(
         _s00_axi.rready.next = s00_axi.rready
         return
 
-    # Define AxiLocal daisy-chain
+    # Define AxiLocal daisy-chain; interrupt_gen registers its read data
     axi_local1 = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
 
-    axi_connect_inst = axi_connect(clk, resetn, _s00_axi, axi_local1)
+    if PL_AXI_PIPELINED:
+        axi_connect_inst = axi_connect_pipelined(clk, resetn, _s00_axi, axi_local1,
+                                                 READ_LATENCY=REG_BANK_READ_LATENCY)
+    else:
+        axi_connect_inst = axi_connect(clk, resetn, _s00_axi, axi_local1,
+                                       READ_LATENCY=REG_BANK_READ_LATENCY)
 
     interrupt_gen_inst = interrupt_gen(
         clk=clk,
         resetn=resetn,
         axi_s=axi_local1,
         axi_m=None,
-        interrupt1_out=interrupt1_out,
-        interrupt2_out=interrupt2_out,
+        interrupt_out=interrupt_out,
         map_base=PL_INTERRUPT_GENERATOR,
     )
 
     return instances()
 
+
+@block
+def interrupt_generator_ip(
+    clk,
+    resetn,
+    s00_axi,
+    interrupt1_out,
+    interrupt2_out,
+):
+    """
+    Two-channel interrupt generator with one port per interrupt, as used by the
+    interrupt_demo block design.
+
+    Parameters:
+    clk             System clock (50MHz)
+    resetn          System reset
+    s00_axi         AXI4 slave interface
+    interrupt1_out  Interrupt 1 output
+    interrupt2_out  Interrupt 2 output
+    """
+    interrupt_out = Signal(intbv(0)[2:])
+
+    interrupt_generator_inst = interrupt_generator_n_ip(
+        clk=clk,
+        resetn=resetn,
+        s00_axi=s00_axi,
+        interrupt_out=interrupt_out,
+    )
+
+    @always_comb
+    def split_interrupts():
+        interrupt1_out.next = interrupt_out[INTERRUPT_GEN_ISR_INTERRUPT1_B]
+        interrupt2_out.next = interrupt_out[INTERRUPT_GEN_ISR_INTERRUPT2_B]
+
+    return instances()
+
 if __name__ == "__main__":
-    # Set parameters to defaults
+    # With a channel count as the argument, convert interrupt_generator_n_ip with an
+    # interrupt_out port of that width; otherwise the two-port interrupt_generator_ip
+    channels = int(sys.argv[1]) if len(sys.argv) > 1 else 0
+    if channels and not 1 <= channels <= INTERRUPT_GEN_MAX_CHANNELS:
+        sys.exit("Channel count must be 1 to %d" % INTERRUPT_GEN_MAX_CHANNELS)
 
     # Define signals for block ports
     clk = Signal(LOW)
     resetn = ResetSignal(0, active=0, isasync=True)
     s00_axi = AxiLite(PL_ADDR_WIDTH, PL_DATA_WIDTH)
-    interrupt1_out = Signal(LOW)
-    interrupt2_out = Signal(LOW)
 
-    interrupt_generator_ip(
-        clk=clk,
-        resetn=resetn,
-        s00_axi=s00_axi,
-        interrupt1_out=interrupt1_out,
-        interrupt2_out=interrupt2_out,
-    ).convert(hdl="Verilog", testbench=False, timescale="1ns/1ps")
+    if channels:
+        interrupt_out = Signal(intbv(0)[channels:])
+
+        interrupt_generator_n_ip(
+            clk=clk,
+            resetn=resetn,
+            s00_axi=s00_axi,
+            interrupt_out=interrupt_out,
+        ).convert(hdl="Verilog", testbench=False, timescale="1ns/1ps")
+    else:
+        interrupt1_out = Signal(LOW)
+        interrupt2_out = Signal(LOW)
+
+        interrupt_generator_ip(
+            clk=clk,
+            resetn=resetn,
+            s00_axi=s00_axi,
+            interrupt1_out=interrupt1_out,
+            interrupt2_out=interrupt2_out,
+        ).convert(hdl="Verilog", testbench=False, timescale="1ns/1ps")
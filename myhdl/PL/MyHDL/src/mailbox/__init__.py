@@ -0,0 +1 @@
+# Hardware mailbox package
@@ -0,0 +1,361 @@
+#!/usr/bin/python
+#
+# FILE:
+#   mailbox.py
+#
+#
+
+# * Hardware mailbox between the APU and the RPU: two FIFOs of 32-bit
+#    messages behind one AXI4-Lite slave, APU -> RPU (A2R) and RPU -> APU
+#    (R2A), each `depth` messages deep (a power of two, 2 to
+#    MAILBOX_MAX_DEPTH). Both processors reach the slave through the PL
+#    interconnect, so a message costs the sender one posted write and the
+#    receiver one interrupt, with the buffering in the PL and no shared
+#    memory to keep coherent.
+# * A write to <DIR>_DATA pushes a message. The write is taken whole,
+#    whatever its byte strobes; pushing into a full FIFO drops the message and
+#    sets the <DIR>_OVERFLOW bit of the ISR.
+# * A read of <DIR>_DATA returns the oldest message without removing it
+#    (AxiLocal has no read strobe, and a read with a side effect would lose a
+#    message to a retried or speculative access); any write to <DIR>_POP
+#    removes it. <DIR>_COUNT is the number of messages in the FIFO.
+# * The <DIR>_DATA bit of the ISR is set in every cycle in which COUNT is at
+#    least <DIR>_THRESHOLD (0 counts as 1). As in interrupt_gen, a bit is
+#    cleared by writing a 1 to it, and being set wins over the clear, so the
+#    receiver drains the FIFO, then clears the bit, and a message that arrived
+#    in between raises it again.
+# * interrupt_rpu is the A2R_DATA and R2A_OVERFLOW bits, interrupt_apu the
+#    R2A_DATA and A2R_OVERFLOW bits, each ANDed with its IER bit: a receiver
+#    hears about new messages and a sender about messages it lost.
+# * Writing a 1 to a FLUSH bit of CTRL empties that FIFO.
+# * The FIFO memories are read asynchronously, so they map to distributed
+#    RAM; a depth of a few tens of messages costs a few LUTs per bit.
+
+
+
+from myhdl import (
+    always,
+    always_comb,
+    always_seq,
+    block,
+    instances,
+    intbv,
+    modbv,
+    ResetSignal,
+    Signal,
+)
+from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+# Register indices and bit fields: generated from
+# build_utils/regmap/kr260_regmap.py, like the C and C++ headers
+from PL.MyHDL.src.mailbox.mailbox_regs import *  # noqa: F401,F403
+
+PL_ADDR_WIDTH = 12
+PL_DATA_WIDTH = 32
+PL_REG_WIDTH = 32
+PL_THRESHOLD_WIDTH = 16
+PL_MAILBOX_DEPTH = 16
+
+LOW, HIGH = bool(0), bool(1)
+
+
+@block
+def mailbox_fifo(clk, resetn, push, pop, flush, wdata, head, count, full, depth):
+    """
+    One direction of the mailbox: a FIFO of depth 32-bit messages.
+
+    Parameters:
+    clk         Clock
+    resetn      Reset
+    push        Store wdata, ignored while full
+    pop         Drop the oldest message, ignored while empty
+    flush       Drop all messages
+    wdata       Message pushed
+    head        Oldest message (undefined while count is 0)
+    count       Messages held, 0 to depth
+    full        count is depth
+    depth       Number of messages, a power of two
+    """
+    addr_width = depth.bit_length() - 1
+    mem = [Signal(intbv(0)[PL_DATA_WIDTH:]) for _ in range(depth)]
+    # One bit more than the address, so full and empty differ
+    wr_ptr = Signal(modbv(0)[addr_width + 1:])
+    rd_ptr = Signal(modbv(0)[addr_width + 1:])
+    level = Signal(modbv(0)[addr_width + 1:])
+
+    @always(clk.posedge)
+    def mem_write():
+        if push and not full:
+            mem[wr_ptr[addr_width:]].next = wdata
+
+    @always_seq(clk.posedge, reset=resetn)
+    def pointers():
+        if push and not full:
+            wr_ptr.next = wr_ptr + 1
+        if flush:
+            rd_ptr.next = wr_ptr
+        elif pop and level != 0:
+            rd_ptr.next = rd_ptr + 1
+
+    @always_comb
+    def fifo_level():
+        level.next = wr_ptr - rd_ptr
+
+    @always_comb
+    def fifo_outputs():
+        head.next = mem[rd_ptr[addr_width:]]
+        count.next = level
+        full.next = level == depth
+
+    return instances()
+
+
+@block
+def mailbox(clk, resetn, axi_s, axi_m, interrupt_rpu, interrupt_apu, map_base,
+            depth=PL_MAILBOX_DEPTH):
+    """
+    Parameters:
+    clk             Clock
+    resetn          Reset
+    axi_s           Connection to upstream blocks
+    axi_m           Connection to downstream blocks
+    interrupt_rpu   Interrupt to the RPU: message for it, or one of its lost
+    interrupt_apu   Interrupt to the APU: message for it, or one of its lost
+    map_base        Base address
+    depth           Messages per FIFO, a power of two up to MAILBOX_MAX_DEPTH
+
+    Registers:
+    MAILBOX_A2R_DATA        Push (write) / oldest message (read), APU -> RPU
+    MAILBOX_A2R_POP         Write-only, drops the oldest APU -> RPU message
+    MAILBOX_A2R_COUNT       Read-only number of APU -> RPU messages
+    MAILBOX_A2R_THRESHOLD   Count at which the A2R_DATA bit of the ISR is set
+    MAILBOX_R2A_DATA        Push (write) / oldest message (read), RPU -> APU
+    MAILBOX_R2A_POP         Write-only, drops the oldest RPU -> APU message
+    MAILBOX_R2A_COUNT       Read-only number of RPU -> APU messages
+    MAILBOX_R2A_THRESHOLD   Count at which the R2A_DATA bit of the ISR is set
+    MAILBOX_ISR             Interrupt status register
+    MAILBOX_IER             Interrupt enable register
+    MAILBOX_CTRL            Write-only control register
+    MAILBOX_DEPTH           Read-only depth of each FIFO
+
+    Fields in MAILBOX_ISR and MAILBOX_IER:
+    MAILBOX_ISR_A2R_DATA        A2R_COUNT >= A2R_THRESHOLD
+    MAILBOX_ISR_R2A_DATA        R2A_COUNT >= R2A_THRESHOLD
+    MAILBOX_ISR_A2R_OVERFLOW    An APU -> RPU message was dropped
+    MAILBOX_ISR_R2A_OVERFLOW    An RPU -> APU message was dropped
+
+    Fields in MAILBOX_CTRL:
+    MAILBOX_CTRL_FLUSH_A2R      Writing a 1 empties the APU -> RPU FIFO
+    MAILBOX_CTRL_FLUSH_R2A      Writing a 1 empties the RPU -> APU FIFO
+    """
+    if depth < 2 or depth > MAILBOX_MAX_DEPTH or depth & (depth - 1):
+        raise ValueError("mailbox depth must be a power of two from 2 to %d" %
+                         MAILBOX_MAX_DEPTH)
+
+    # Addresses of registers in block (in units of 4 bytes)
+    mailbox_a2r_data_addr = map_base + MAILBOX_A2R_DATA
+    mailbox_a2r_pop_addr = map_base + MAILBOX_A2R_POP
+    mailbox_a2r_count_addr = map_base + MAILBOX_A2R_COUNT
+    mailbox_a2r_threshold_addr = map_base + MAILBOX_A2R_THRESHOLD
+    mailbox_r2a_data_addr = map_base + MAILBOX_R2A_DATA
+    mailbox_r2a_pop_addr = map_base + MAILBOX_R2A_POP
+    mailbox_r2a_count_addr = map_base + MAILBOX_R2A_COUNT
+    mailbox_r2a_threshold_addr = map_base + MAILBOX_R2A_THRESHOLD
+    mailbox_isr_addr = map_base + MAILBOX_ISR
+    mailbox_ier_addr = map_base + MAILBOX_IER
+    mailbox_ctrl_addr = map_base + MAILBOX_CTRL
+    mailbox_depth_addr = map_base + MAILBOX_DEPTH
+    rdata = Signal(intbv(0)[32:])
+    isr = Signal(intbv(0)[4:])
+    ier = Signal(intbv(0)[4:])
+    a2r_threshold = Signal(intbv(0)[PL_THRESHOLD_WIDTH:])
+    r2a_threshold = Signal(intbv(0)[PL_THRESHOLD_WIDTH:])
+
+    # User defined signals and variables
+    count_width = depth.bit_length()
+    a2r_push = Signal(LOW)
+    a2r_pop = Signal(LOW)
+    a2r_flush = Signal(LOW)
+    a2r_head = Signal(intbv(0)[PL_DATA_WIDTH:])
+    a2r_count = Signal(intbv(0)[count_width:])
+    a2r_full = Signal(LOW)
+    r2a_push = Signal(LOW)
+    r2a_pop = Signal(LOW)
+    r2a_flush = Signal(LOW)
+    r2a_head = Signal(intbv(0)[PL_DATA_WIDTH:])
+    r2a_count = Signal(intbv(0)[count_width:])
+    r2a_full = Signal(LOW)
+    # ISR bits set this cycle, and cleared by software
+    isr_set = Signal(intbv(0)[4:])
+    isr_clear = Signal(intbv(0)[4:])
+
+    a2r_fifo = mailbox_fifo(clk, resetn, a2r_push, a2r_pop, a2r_flush, axi_s.wdata,
+                            a2r_head, a2r_count, a2r_full, depth)
+    r2a_fifo = mailbox_fifo(clk, resetn, r2a_push, r2a_pop, r2a_flush, axi_s.wdata,
+                            r2a_head, r2a_count, r2a_full, depth)
+
+    # AxiLocal pass through logic
+    if axi_m is not None:
+
+        @always_comb
+        def axi_passthrough():
+            axi_m.raddr.next = axi_s.raddr
+            axi_m.waddr.next = axi_s.waddr
+            axi_m.wdata.next = axi_s.wdata
+            axi_m.wstrobe.next = axi_s.wstrobe
+            axi_m.wen.next = axi_s.wen
+            axi_s.rdata.next = axi_m.rdata | rdata
+
+    else:
+
+        @always_comb
+        def axi_passthrough():
+            axi_s.rdata.next = rdata
+
+    @always_comb
+    def register_read():
+        # Read access of registers
+        rdata.next = 0
+        if axi_s.raddr == mailbox_a2r_data_addr:
+            rdata.next = a2r_head
+        elif axi_s.raddr == mailbox_a2r_count_addr:
+            rdata.next = a2r_count
+        elif axi_s.raddr == mailbox_a2r_threshold_addr:
+            rdata.next = a2r_threshold
+        elif axi_s.raddr == mailbox_r2a_data_addr:
+            rdata.next = r2a_head
+        elif axi_s.raddr == mailbox_r2a_count_addr:
+            rdata.next = r2a_count
+        elif axi_s.raddr == mailbox_r2a_threshold_addr:
+            rdata.next = r2a_threshold
+        elif axi_s.raddr == mailbox_isr_addr:
+            rdata.next = isr
+        elif axi_s.raddr == mailbox_ier_addr:
+            rdata.next = ier
+        elif axi_s.raddr == mailbox_depth_addr:
+            rdata.next = depth
+
+    ctrl_write_decode = Signal(LOW)
+
+    # Pushes, pops and flushes are strobes of the write cycle
+    @always_comb
+    def fifo_write_decoder():
+        a2r_push.next = axi_s.wen and axi_s.waddr == mailbox_a2r_data_addr
+        a2r_pop.next = axi_s.wen and axi_s.waddr == mailbox_a2r_pop_addr
+        r2a_push.next = axi_s.wen and axi_s.waddr == mailbox_r2a_data_addr
+        r2a_pop.next = axi_s.wen and axi_s.waddr == mailbox_r2a_pop_addr
+        ctrl_write_decode.next = axi_s.wen and axi_s.waddr == mailbox_ctrl_addr
+
+    @always_comb
+    def ctrl_decoder():
+        a2r_flush.next = (ctrl_write_decode and axi_s.wstrobe[0] and
+                          axi_s.wdata[MAILBOX_CTRL_FLUSH_A2R_B])
+        r2a_flush.next = (ctrl_write_decode and axi_s.wstrobe[0] and
+                          axi_s.wdata[MAILBOX_CTRL_FLUSH_R2A_B])
+
+    a2r_threshold_write_decode = Signal(LOW)
+
+    @always_comb
+    def a2r_threshold_write_decoder():
+        a2r_threshold_write_decode.next = (
+            axi_s.wen and axi_s.waddr == mailbox_a2r_threshold_addr
+        )
+
+    @always_seq(clk.posedge, reset=resetn)
+    def a2r_threshold_write():
+        if a2r_threshold_write_decode:
+            for byte_index in range((PL_THRESHOLD_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(a2r_threshold):
+                            a2r_threshold.next[bit] = axi_s.wdata[bit]
+
+    r2a_threshold_write_decode = Signal(LOW)
+
+    @always_comb
+    def r2a_threshold_write_decoder():
+        r2a_threshold_write_decode.next = (
+            axi_s.wen and axi_s.waddr == mailbox_r2a_threshold_addr
+        )
+
+    @always_seq(clk.posedge, reset=resetn)
+    def r2a_threshold_write():
+        if r2a_threshold_write_decode:
+            for byte_index in range((PL_THRESHOLD_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(r2a_threshold):
+                            r2a_threshold.next[bit] = axi_s.wdata[bit]
+
+    @always_comb
+    def isr_set_decoder():
+        isr_set.next[MAILBOX_ISR_A2R_DATA_B] = (
+            a2r_count != 0 and a2r_count >= a2r_threshold
+        )
+        isr_set.next[MAILBOX_ISR_R2A_DATA_B] = (
+            r2a_count != 0 and r2a_count >= r2a_threshold
+        )
+        isr_set.next[MAILBOX_ISR_A2R_OVERFLOW_B] = a2r_push and a2r_full
+        isr_set.next[MAILBOX_ISR_R2A_OVERFLOW_B] = r2a_push and r2a_full
+
+    isr_write_decode = Signal(LOW)
+
+    @always_comb
+    def isr_write_decoder():
+        isr_write_decode.next = axi_s.wen and axi_s.waddr == mailbox_isr_addr
+
+    @always_comb
+    def isr_clear_decoder():
+        for bit in range(len(isr)):
+            isr_clear.next[bit] = (
+                isr_write_decode and axi_s.wstrobe[0] and axi_s.wdata[bit]
+            )
+
+    # Setting a bit wins over software clearing it in the same cycle
+    @always_seq(clk.posedge, reset=resetn)
+    def isr_write():
+        for bit in range(len(isr)):
+            if isr_clear[bit]:
+                isr.next[bit] = LOW
+            if isr_set[bit]:
+                isr.next[bit] = HIGH
+
+    ier_write_decode = Signal(LOW)
+
+    @always_comb
+    def ier_write_decoder():
+        ier_write_decode.next = axi_s.wen and axi_s.waddr == mailbox_ier_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def ier_write():
+        if ier_write_decode and axi_s.wstrobe[0]:
+            for bit in range(len(ier)):
+                ier.next[bit] = axi_s.wdata[bit]
+
+    @always_comb
+    def assign_interrupts():
+        interrupt_rpu.next = (
+            (isr[MAILBOX_ISR_A2R_DATA_B] and ier[MAILBOX_IER_A2R_DATA_B]) or
+            (isr[MAILBOX_ISR_R2A_OVERFLOW_B] and ier[MAILBOX_IER_R2A_OVERFLOW_B])
+        )
+        interrupt_apu.next = (
+            (isr[MAILBOX_ISR_R2A_DATA_B] and ier[MAILBOX_IER_R2A_DATA_B]) or
+            (isr[MAILBOX_ISR_A2R_OVERFLOW_B] and ier[MAILBOX_IER_A2R_OVERFLOW_B])
+        )
+
+    return instances()
+
+
+if __name__ == "__main__":
+    # Define signals for block ports
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    axi_s = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    axi_m = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    interrupt_rpu = Signal(LOW)
+    interrupt_apu = Signal(LOW)
+    map_base = 0
+
+    mailbox(clk=clk, resetn=resetn, axi_s=axi_s, axi_m=axi_m, interrupt_rpu=interrupt_rpu,
+            interrupt_apu=interrupt_apu, map_base=map_base).convert(hdl='Verilog')
@@ -0,0 +1,61 @@
+#!/usr/bin/python
+#
+# FILE:
+#   mailbox_regs.py
+#
+# DESCRIPTION:
+#   Register map of mailbox (myhdl/PL/MyHDL/src/mailbox/mailbox.py),
+#   GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py,
+#   do not edit. MAILBOX_<REG> is the 32-bit register index,
+#   MAILBOX_<REG>_OFFSET the byte offset.
+#
+
+MAILBOX_MAX_DEPTH = 1024  # Largest FIFO depth, in messages
+
+# Register indices
+MAILBOX_A2R_DATA = 0  # APU -> RPU: write pushes, read is the oldest message
+MAILBOX_A2R_POP = 1  # Any write drops the oldest APU -> RPU message
+MAILBOX_A2R_COUNT = 2  # Messages in the APU -> RPU FIFO
+MAILBOX_A2R_THRESHOLD = 3  # A2R_DATA pending while COUNT >= THRESHOLD (0: 1)
+MAILBOX_R2A_DATA = 4  # RPU -> APU: write pushes, read is the oldest message
+MAILBOX_R2A_POP = 5  # Any write drops the oldest RPU -> APU message
+MAILBOX_R2A_COUNT = 6  # Messages in the RPU -> APU FIFO
+MAILBOX_R2A_THRESHOLD = 7  # R2A_DATA pending while COUNT >= THRESHOLD (0: 1)
+MAILBOX_ISR = 8  # Write 1 to clear
+MAILBOX_IER = 9
+MAILBOX_CTRL = 10  # Write 1 to a FLUSH bit to empty that FIFO
+MAILBOX_DEPTH = 11  # FIFO depth in messages
+# Register byte offsets
+MAILBOX_A2R_DATA_OFFSET = 0x00
+MAILBOX_A2R_POP_OFFSET = 0x04
+MAILBOX_A2R_COUNT_OFFSET = 0x08
+MAILBOX_A2R_THRESHOLD_OFFSET = 0x0C
+MAILBOX_R2A_DATA_OFFSET = 0x10
+MAILBOX_R2A_POP_OFFSET = 0x14
+MAILBOX_R2A_COUNT_OFFSET = 0x18
+MAILBOX_R2A_THRESHOLD_OFFSET = 0x1C
+MAILBOX_ISR_OFFSET = 0x20
+MAILBOX_IER_OFFSET = 0x24
+MAILBOX_CTRL_OFFSET = 0x28
+MAILBOX_DEPTH_OFFSET = 0x2C
+# Register bit fields
+MAILBOX_ISR_A2R_DATA_B = 0
+MAILBOX_ISR_A2R_DATA_W = 1
+MAILBOX_ISR_R2A_DATA_B = 1
+MAILBOX_ISR_R2A_DATA_W = 1
+MAILBOX_ISR_A2R_OVERFLOW_B = 2
+MAILBOX_ISR_A2R_OVERFLOW_W = 1
+MAILBOX_ISR_R2A_OVERFLOW_B = 3
+MAILBOX_ISR_R2A_OVERFLOW_W = 1
+MAILBOX_IER_A2R_DATA_B = 0
+MAILBOX_IER_A2R_DATA_W = 1
+MAILBOX_IER_R2A_DATA_B = 1
+MAILBOX_IER_R2A_DATA_W = 1
+MAILBOX_IER_A2R_OVERFLOW_B = 2
+MAILBOX_IER_A2R_OVERFLOW_W = 1
+MAILBOX_IER_R2A_OVERFLOW_B = 3
+MAILBOX_IER_R2A_OVERFLOW_W = 1
+MAILBOX_CTRL_FLUSH_A2R_B = 0
+MAILBOX_CTRL_FLUSH_A2R_W = 1
+MAILBOX_CTRL_FLUSH_R2A_B = 1
+MAILBOX_CTRL_FLUSH_R2A_W = 1
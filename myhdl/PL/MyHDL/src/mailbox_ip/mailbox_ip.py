@@ -0,0 +1,111 @@
+#!/usr/bin/python
+
+import sys
+
+from myhdl import (
+    always_comb,
+    block,
+    instances,
+    ResetSignal,
+    Signal,
+)
+
+from PL.MyHDL.src.interfaces.axi_lite import AxiLite
+from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+from PL.MyHDL.src.axi_support.axi_support import axi_connect, axi_connect_pipelined
+from PL.MyHDL.src.mailbox.mailbox import mailbox
+
+LOW, HIGH = bool(0), bool(1)
+
+PL_ADDR_WIDTH = 12
+PL_DATA_WIDTH = 32
+PL_MAILBOX = 0
+# Messages per FIFO; the first command line argument overrides it
+PL_MAILBOX_DEPTH = 16
+# AXI4-Lite front end: axi_connect_pipelined accepts a register access every
+# cycle; False selects the one-transaction-at-a-time axi_connect
+PL_AXI_PIPELINED = True
+
+@block
+def mailbox_ip(
+    clk,
+    resetn,
+    s00_axi,
+    interrupt_rpu,
+    interrupt_apu,
+    depth=PL_MAILBOX_DEPTH,
+):
+    """
+    Parameters:
+    clk             System clock (pl_clk0, 100MHz)
+    resetn          System reset
+    s00_axi         AXI4 slave interface, reached by both the APU and the RPU
+    interrupt_rpu   Interrupt output to the RPU GIC (pl_ps_irq)
+    interrupt_apu   Interrupt output to the APU GIC (pl_ps_irq)
+    depth           Messages per FIFO
+    """
+    # Wrapped interface signal definitions
+    _s00_axi = AxiLite(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+
+    @always_comb
+    def wrap_interfaces():
+        _s00_axi.awaddr.next = s00_axi.awaddr
+        _s00_axi.awprot.next = s00_axi.awprot
+        _s00_axi.awvalid.next = s00_axi.awvalid
+        s00_axi.awready.next = _s00_axi.awready
+        _s00_axi.wdata.next = s00_axi.wdata
+        _s00_axi.wstrb.next = s00_axi.wstrb
+        _s00_axi.wvalid.next = s00_axi.wvalid
+        s00_axi.wready.next = _s00_axi.wready
+        s00_axi.bresp.next = _s00_axi.bresp
+        s00_axi.bvalid.next = _s00_axi.bvalid
+        _s00_axi.bready.next = s00_axi.bready
+        _s00_axi.araddr.next = s00_axi.araddr
+        _s00_axi.arprot.next = s00_axi.arprot
+        _s00_axi.arvalid.next = s00_axi.arvalid
+        s00_axi.arready.next = _s00_axi.arready
+        s00_axi.rdata.next = _s00_axi.rdata
+        s00_axi.rresp.next = _s00_axi.rresp
+        s00_axi.rvalid.next = _s00_axi.rvalid
+        _s00_axi.rready.next = s00_axi.rready
+        return
+
+    # Define AxiLocal daisy-chain
+    axi_local1 = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+
+    if PL_AXI_PIPELINED:
+        axi_connect_inst = axi_connect_pipelined(clk, resetn, _s00_axi, axi_local1)
+    else:
+        axi_connect_inst = axi_connect(clk, resetn, _s00_axi, axi_local1)
+
+    mailbox_inst = mailbox(
+        clk=clk,
+        resetn=resetn,
+        axi_s=axi_local1,
+        axi_m=None,
+        interrupt_rpu=interrupt_rpu,
+        interrupt_apu=interrupt_apu,
+        map_base=PL_MAILBOX,
+        depth=depth,
+    )
+
+    return instances()
+
+if __name__ == "__main__":
+    depth = int(sys.argv[1]) if len(sys.argv) > 1 else PL_MAILBOX_DEPTH
+
+    # Define signals for block ports
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    s00_axi = AxiLite(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    interrupt_rpu = Signal(LOW)
+    interrupt_apu = Signal(LOW)
+
+    mailbox_ip(
+        clk=clk,
+        resetn=resetn,
+        s00_axi=s00_axi,
+        interrupt_rpu=interrupt_rpu,
+        interrupt_apu=interrupt_apu,
+        depth=depth,
+    ).convert(hdl="Verilog", testbench=False, timescale="1ns/1ps")
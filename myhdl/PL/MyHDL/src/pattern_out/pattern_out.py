@@ -0,0 +1,300 @@
+#!/usr/bin/python
+#
+# FILE:
+#   pattern_out.py
+#
+#
+
+# * This block plays a stream of output patterns onto GPIO pins at a fixed rate,
+#    without a CPU write per sample. Samples arrive on an AXI4-Stream slave port,
+#    normally from an AXI DMA (MM2S) through an AXI4-Stream FIFO.
+# * The divider register sets the sample period in clock cycles; values below 2
+#    output one sample per clock. Each sample is registered, so the pins change
+#    on the tick clock edge only.
+# * While the ENABLE bit in the control register is clear, the pins follow the
+#    gpio_in port (the AXI GPIO outputs). Setting ENABLE clears the counters and
+#    starts the stream with the next clock; the pins then show the last sample.
+# * A sample with TLAST set is the last one: the block stops and sets DONE in the
+#    ISR. A tick without a sample is an underrun: the last sample is held, the
+#    underrun counter increments and UNDERRUN is set in the ISR.
+# * The interrupt output is high while a bit is set in both the ISR and the IER.
+#    A bit in the ISR is cleared by writing a 1 to that bit position.
+
+
+
+from myhdl import (
+    always_comb,
+    always_seq,
+    block,
+    concat,
+    instances,
+    intbv,
+    modbv,
+    ResetSignal,
+    Signal,
+)
+from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+from PL.MyHDL.src.interfaces.axi_stream import AxiStream
+# Register indices and bit fields: generated from
+# build_utils/regmap/kr260_regmap.py, like the C and C++ headers
+from PL.MyHDL.src.pattern_out.pattern_out_regs import *  # noqa: F401,F403
+
+PL_ADDR_WIDTH = 12
+PL_DATA_WIDTH = 32
+PL_REG_WIDTH = 32
+PL_PATTERN_WIDTH = 2
+
+LOW, HIGH = bool(0), bool(1)
+
+
+@block
+def pattern_out(clk, resetn, axi_s, axi_m, s_axis, gpio_in, pattern_o, interrupt_out, map_base):
+    """
+    Parameters:
+    clk         Clock
+    resetn      Reset
+    axi_s       Connection to upstream blocks
+    axi_m       Connection to downstream blocks
+    s_axis      AXI4-Stream of samples, the low bits of TDATA drive the pins
+    gpio_in     Pin values while the stream is disabled
+    pattern_o   Output pins
+    interrupt_out   Goes high if a bit is set in both ISR and IER
+    map_base    Base address
+
+    Registers:
+    PATTERN_OUT_CTRL    Control register
+    PATTERN_OUT_DIVIDER Clock cycles per sample, values below 2 give one sample per clock
+    PATTERN_OUT_STATUS  Read-only state of the stream engine
+    PATTERN_OUT_ISR     Interrupt status register whose bits indicate events
+    PATTERN_OUT_IER     Interrupt enable register whose bits allow an event to lead
+                          to a high level on the interrupt output port
+    PATTERN_OUT_COUNT   Read-only number of samples output since ENABLE was set
+    PATTERN_OUT_UNDERRUNS   Read-only number of ticks without a sample since ENABLE was set
+
+    Fields in PATTERN_OUT_CTRL:
+    PATTERN_OUT_CTRL_ENABLE     Rising edge starts the stream, the pins show the samples while set
+
+    Fields in PATTERN_OUT_STATUS:
+    PATTERN_OUT_STATUS_RUNNING  Samples are being output
+    PATTERN_OUT_STATUS_TVALID   A sample is waiting on the stream port
+
+    Fields in PATTERN_OUT_ISR:
+    PATTERN_OUT_ISR_DONE        The sample with TLAST was output
+    PATTERN_OUT_ISR_UNDERRUN    A tick found no sample
+
+    Fields in PATTERN_OUT_IER:
+    PATTERN_OUT_IER_DONE        Enables DONE on interrupt_out
+    PATTERN_OUT_IER_UNDERRUN    Enables UNDERRUN on interrupt_out
+    """
+    # Addresses of registers in block (in units of 4 bytes)
+    pattern_out_ctrl_addr = map_base + PATTERN_OUT_CTRL
+    pattern_out_divider_addr = map_base + PATTERN_OUT_DIVIDER
+    pattern_out_status_addr = map_base + PATTERN_OUT_STATUS
+    pattern_out_isr_addr = map_base + PATTERN_OUT_ISR
+    pattern_out_ier_addr = map_base + PATTERN_OUT_IER
+    pattern_out_count_addr = map_base + PATTERN_OUT_COUNT
+    pattern_out_underruns_addr = map_base + PATTERN_OUT_UNDERRUNS
+    rdata = Signal(intbv(0)[32:])
+    ctrl = Signal(intbv(0)[8:])
+    divider = Signal(intbv(0)[PL_REG_WIDTH:])
+    isr = Signal(intbv(0)[8:])
+    ier = Signal(intbv(0)[8:])
+    count = Signal(modbv(0)[PL_REG_WIDTH:])
+    underruns = Signal(modbv(0)[PL_REG_WIDTH:])
+
+    # Unpacking ctrl register
+
+    ctrl_enable = Signal(LOW)
+
+    @always_comb
+    def unpack_ctrl():
+        ctrl_enable.next = ctrl[PATTERN_OUT_CTRL_ENABLE_B]
+
+    # User defined signals and variables
+    pattern_width = len(pattern_o)
+    # Stream engine state
+    enable_d = Signal(LOW)
+    running = Signal(LOW)
+    div_counter = Signal(modbv(0)[PL_REG_WIDTH:])
+    pattern = Signal(intbv(0)[pattern_width:])
+    # Sample tick and what it found on the stream port
+    tick = Signal(LOW)
+    sample_take = Signal(LOW)
+    sample_last = Signal(LOW)
+    sample_miss = Signal(LOW)
+
+    # AxiLocal pass through logic
+    if axi_m is not None:
+
+        @always_comb
+        def axi_passthrough():
+            axi_m.raddr.next = axi_s.raddr
+            axi_m.waddr.next = axi_s.waddr
+            axi_m.wdata.next = axi_s.wdata
+            axi_m.wstrobe.next = axi_s.wstrobe
+            axi_m.wen.next = axi_s.wen
+            axi_s.rdata.next = axi_m.rdata | rdata
+
+    else:
+
+        @always_comb
+        def axi_passthrough():
+            axi_s.rdata.next = rdata
+
+    @always_comb
+    def register_read():
+        # Read access of registers
+        rdata.next = 0
+        if axi_s.raddr == pattern_out_ctrl_addr:
+            rdata.next = ctrl
+        elif axi_s.raddr == pattern_out_divider_addr:
+            rdata.next = divider
+        elif axi_s.raddr == pattern_out_status_addr:
+            rdata.next = concat(s_axis.tvalid, running)
+        elif axi_s.raddr == pattern_out_isr_addr:
+            rdata.next = isr
+        elif axi_s.raddr == pattern_out_ier_addr:
+            rdata.next = ier
+        elif axi_s.raddr == pattern_out_count_addr:
+            rdata.next = count
+        elif axi_s.raddr == pattern_out_underruns_addr:
+            rdata.next = underruns
+
+    ctrl_write_decode = Signal(LOW)
+
+    @always_comb
+    def ctrl_write_decoder():
+        ctrl_write_decode.next = axi_s.wen and axi_s.waddr == pattern_out_ctrl_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def ctrl_write():
+        if ctrl_write_decode:
+            for byte_index in range((8 + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(ctrl):
+                            ctrl.next[bit] = axi_s.wdata[bit]
+
+    divider_write_decode = Signal(LOW)
+
+    @always_comb
+    def divider_write_decoder():
+        divider_write_decode.next = (
+            axi_s.wen and axi_s.waddr == pattern_out_divider_addr
+        )
+
+    @always_seq(clk.posedge, reset=resetn)
+    def divider_write():
+        if divider_write_decode:
+            for byte_index in range((PL_REG_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(divider):
+                            divider.next[bit] = axi_s.wdata[bit]
+
+    isr_write_decode = Signal(LOW)
+
+    @always_comb
+    def isr_write_decoder():
+        isr_write_decode.next = axi_s.wen and axi_s.waddr == pattern_out_isr_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def isr_write():
+        if isr_write_decode:
+            for byte_index in range((8 + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(isr):
+                            isr.next[bit] = isr[bit] & (~axi_s.wdata[bit])
+
+        if sample_last:
+            isr.next[PATTERN_OUT_ISR_DONE_B] = HIGH
+
+        if sample_miss:
+            isr.next[PATTERN_OUT_ISR_UNDERRUN_B] = HIGH
+
+    ier_write_decode = Signal(LOW)
+
+    @always_comb
+    def ier_write_decoder():
+        ier_write_decode.next = axi_s.wen and axi_s.waddr == pattern_out_ier_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def ier_write():
+        if ier_write_decode:
+            for byte_index in range((8 + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(ier):
+                            ier.next[bit] = axi_s.wdata[bit]
+
+    @always_comb
+    def sample_tick():
+        tick.next = running and div_counter == 0
+
+    @always_comb
+    def sample_decode():
+        # The stream is only read on a tick, so TREADY is the tick itself
+        s_axis.tready.next = tick
+        sample_take.next = tick and s_axis.tvalid
+        sample_last.next = tick and s_axis.tvalid and s_axis.tlast
+        sample_miss.next = tick and not s_axis.tvalid
+
+    @always_seq(clk.posedge, reset=resetn)
+    def stream_engine():
+        enable_d.next = ctrl_enable
+        if ctrl_enable and not enable_d:
+            # Start: first tick on the next clock
+            running.next = HIGH
+            div_counter.next = 0
+            count.next = 0
+            underruns.next = 0
+        elif not ctrl_enable:
+            running.next = LOW
+        elif running:
+            if div_counter == 0:
+                if divider > 1:
+                    div_counter.next = divider - 1
+                if sample_take:
+                    pattern.next = s_axis.tdata[pattern_width:]
+                    count.next = count + 1
+                    if sample_last:
+                        running.next = LOW
+                else:
+                    underruns.next = underruns + 1
+            else:
+                div_counter.next = div_counter - 1
+
+    @always_comb
+    def assign_pattern_o():
+        if ctrl_enable:
+            pattern_o.next = pattern
+        else:
+            pattern_o.next = gpio_in
+
+    @always_comb
+    def assign_interrupt_out():
+        interrupt_out.next = (isr & ier) != 0
+
+    return instances()
+
+
+if __name__ == "__main__":
+    # Define signals for block ports
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    axi_s = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    axi_m = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    s_axis = AxiStream(PL_DATA_WIDTH)
+    gpio_in = Signal(intbv(0)[PL_PATTERN_WIDTH:])
+    pattern_o = Signal(intbv(0)[PL_PATTERN_WIDTH:])
+    interrupt_out = Signal(LOW)
+    map_base = 0
+
+    pattern_out(clk=clk, resetn=resetn, axi_s=axi_s, axi_m=axi_m, s_axis=s_axis,
+                gpio_in=gpio_in, pattern_o=pattern_o,
+                interrupt_out=interrupt_out, map_base=map_base).convert(hdl='Verilog')
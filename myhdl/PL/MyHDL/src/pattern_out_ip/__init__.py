@@ -0,0 +1 @@
+# Pattern output IP package
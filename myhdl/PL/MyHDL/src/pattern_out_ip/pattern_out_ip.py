@@ -0,0 +1,122 @@
+#!/usr/bin/python
+
+from myhdl import (
+    always_comb,
+    block,
+    instances,
+    intbv,
+    ResetSignal,
+    Signal,
+)
+
+from PL.MyHDL.src.interfaces.axi_lite import AxiLite
+from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+from PL.MyHDL.src.interfaces.axi_stream import AxiStream
+from PL.MyHDL.src.axi_support.axi_support import axi_connect, axi_connect_pipelined
+from PL.MyHDL.src.pattern_out.pattern_out import pattern_out
+
+LOW, HIGH = bool(0), bool(1)
+
+PL_ADDR_WIDTH = 12
+PL_DATA_WIDTH = 32
+PL_STREAM_WIDTH = 32
+PL_PATTERN_WIDTH = 2
+PL_PATTERN_OUT = 0
+# AXI4-Lite front end: axi_connect_pipelined accepts a register access every
+# cycle; False selects the one-transaction-at-a-time axi_connect
+PL_AXI_PIPELINED = True
+
+@block
+def pattern_out_ip(
+    clk,
+    resetn,
+    s00_axi,
+    s00_axis,
+    gpio_in,
+    pattern_o,
+    interrupt_out,
+):
+    """
+    Parameters:
+    clk             System clock (pl_clk0, 100MHz)
+    resetn          System reset
+    s00_axi         AXI4 slave interface
+    s00_axis        AXI4-Stream slave interface for the samples
+    gpio_in         Pin values while the stream is disabled (AXI GPIO outputs)
+    pattern_o       Output pins
+    interrupt_out   Interrupt output
+    """
+    # Wrapped interface signal definitions
+    _s00_axi = AxiLite(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    _s00_axis = AxiStream(PL_STREAM_WIDTH)
+
+    @always_comb
+    def wrap_interfaces():
+        _s00_axi.awaddr.next = s00_axi.awaddr
+        _s00_axi.awprot.next = s00_axi.awprot
+        _s00_axi.awvalid.next = s00_axi.awvalid
+        s00_axi.awready.next = _s00_axi.awready
+        _s00_axi.wdata.next = s00_axi.wdata
+        _s00_axi.wstrb.next = s00_axi.wstrb
+        _s00_axi.wvalid.next = s00_axi.wvalid
+        s00_axi.wready.next = _s00_axi.wready
+        s00_axi.bresp.next = _s00_axi.bresp
+        s00_axi.bvalid.next = _s00_axi.bvalid
+        _s00_axi.bready.next = s00_axi.bready
+        _s00_axi.araddr.next = s00_axi.araddr
+        _s00_axi.arprot.next = s00_axi.arprot
+        _s00_axi.arvalid.next = s00_axi.arvalid
+        s00_axi.arready.next = _s00_axi.arready
+        s00_axi.rdata.next = _s00_axi.rdata
+        s00_axi.rresp.next = _s00_axi.rresp
+        s00_axi.rvalid.next = _s00_axi.rvalid
+        _s00_axi.rready.next = s00_axi.rready
+        _s00_axis.tdata.next = s00_axis.tdata
+        _s00_axis.tvalid.next = s00_axis.tvalid
+        s00_axis.tready.next = _s00_axis.tready
+        _s00_axis.tlast.next = s00_axis.tlast
+        return
+
+    # Define AxiLocal daisy-chain
+    axi_local1 = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+
+    if PL_AXI_PIPELINED:
+        axi_connect_inst = axi_connect_pipelined(clk, resetn, _s00_axi, axi_local1)
+    else:
+        axi_connect_inst = axi_connect(clk, resetn, _s00_axi, axi_local1)
+
+    pattern_out_inst = pattern_out(
+        clk=clk,
+        resetn=resetn,
+        axi_s=axi_local1,
+        axi_m=None,
+        s_axis=_s00_axis,
+        gpio_in=gpio_in,
+        pattern_o=pattern_o,
+        interrupt_out=interrupt_out,
+        map_base=PL_PATTERN_OUT,
+    )
+
+    return instances()
+
+if __name__ == "__main__":
+    # Set parameters to defaults
+
+    # Define signals for block ports
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    s00_axi = AxiLite(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    s00_axis = AxiStream(PL_STREAM_WIDTH)
+    gpio_in = Signal(intbv(0)[PL_PATTERN_WIDTH:])
+    pattern_o = Signal(intbv(0)[PL_PATTERN_WIDTH:])
+    interrupt_out = Signal(LOW)
+
+    pattern_out_ip(
+        clk=clk,
+        resetn=resetn,
+        s00_axi=s00_axi,
+        s00_axis=s00_axis,
+        gpio_in=gpio_in,
+        pattern_o=pattern_o,
+        interrupt_out=interrupt_out,
+    ).convert(hdl="Verilog", testbench=False, timescale="1ns/1ps")
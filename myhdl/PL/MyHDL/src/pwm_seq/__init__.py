@@ -0,0 +1 @@
+# PWM sequencer package
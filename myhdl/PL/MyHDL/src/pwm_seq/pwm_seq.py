@@ -0,0 +1,502 @@
+#!/usr/bin/python
+#
+# FILE:
+#   pwm_seq.py
+#
+#
+
+# * PWM generator with a step sequencer per channel, one to
+#    PWM_SEQ_MAX_CHANNELS channels, one per bit of the pwm_o port. It takes the
+#    brightness ramps and blink patterns of the LEDs off the processors: once
+#    loaded, a sequence plays without interrupts or register accesses.
+# * Each channel counts clk cycles from 0 to PERIOD - 1 (24 bits); its pin is
+#    high while the count is below the duty of the period, so a duty of 0 keeps
+#    the pin low and a duty of PERIOD or more keeps it high. PERIOD 0 stops the
+#    counter and holds the pin low.
+# * The duty of a period is taken at the start of that period: from DUTY while
+#    no sequence runs, otherwise from the current step of the sequence, so a
+#    change never cuts a period short.
+# * A sequence is up to SEQ_DEPTH 32-bit steps in a memory of the channel:
+#    bits 23:0 the duty, bits 31:24 the number of periods the step lasts minus
+#    one. Steps are written through SEQ_ADDR (channel * SEQ_DEPTH + step) and
+#    SEQ_DATA; each SEQ_DATA write stores one step, whatever its byte strobes,
+#    and increments SEQ_ADDR, so a sequence loads with one address write and a
+#    run of data writes.
+# * Writing SEQ_LEN starts the sequence from step 0 with that many steps, or
+#    stops it with 0. It plays SEQ_LOOPS times (0 until stopped); on the start
+#    of the last period of the last pass the sequence stops, the channel goes
+#    back to DUTY after that period and sets its ISR bit. Write SEQ_LOOPS
+#    before SEQ_LEN. SEQ_STEP shows the step playing, with bit 31 set while
+#    the sequence runs.
+# * Bit n of ISR and IER belongs to channel n. As in interrupt_gen, an ISR bit
+#    is cleared by writing a 1 to it and being set wins over the clear;
+#    interrupt_out goes high if any bit is set in both ISR and IER.
+# * While CTRL.ENABLE is clear the pins follow the gpio_in port (the AXI GPIO
+#    outputs, or pattern_out in front of it); the channels keep running, so
+#    setting ENABLE switches the pins over glitch-free at any time.
+# * The registers of each channel are in a bank of its own, at
+#    PWM_SEQ_CHANNEL_BASE + n * PWM_SEQ_CHANNEL_STRIDE.
+# * The step memories are read asynchronously, so they map to distributed RAM.
+
+
+
+from myhdl import (
+    always,
+    always_comb,
+    always_seq,
+    block,
+    ConcatSignal,
+    instances,
+    intbv,
+    modbv,
+    ResetSignal,
+    Signal,
+)
+from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+# Register indices, bit fields and pwm_seq_bank(): generated from
+# build_utils/regmap/kr260_regmap.py, like the C and C++ headers
+from PL.MyHDL.src.pwm_seq.pwm_seq_regs import *  # noqa: F401,F403
+
+PL_ADDR_WIDTH = 12
+PL_DATA_WIDTH = 32
+PL_REG_WIDTH = 32
+PL_PWM_WIDTH = 24
+PL_HOLD_WIDTH = 8
+PL_SEQ_DEPTH = 64
+
+LOW, HIGH = bool(0), bool(1)
+
+
+@block
+def pwm_seq_channel(clk, resetn, axi_s, axi_m, seq_we, seq_waddr, seq_wdata, pwm_out,
+                    isr_set, bank_base, seq_depth):
+    """
+    One channel of pwm_seq: period counter, step memory and sequencer, with the
+    registers of its bank.
+
+    Parameters:
+    clk             Clock
+    resetn          Reset
+    axi_s           Connection to upstream blocks
+    axi_m           Connection to downstream blocks
+    seq_we          Store seq_wdata at step seq_waddr of this channel
+    seq_waddr       Step written
+    seq_wdata       Step value
+    pwm_out         PWM output of the channel
+    isr_set         Goes high for a cycle when the sequence is done
+    bank_base       Address of the register bank
+    seq_depth       Steps in the memory, a power of two
+
+    Registers (relative to bank_base):
+    PWM_SEQ_CH_PERIOD       Clocks per PWM period, 0 holds the pin low
+    PWM_SEQ_CH_DUTY         High clocks per period while no sequence runs
+    PWM_SEQ_CH_SEQ_LEN      Steps of the sequence; a write restarts it, 0 stops it
+    PWM_SEQ_CH_SEQ_LOOPS    Passes of the sequence, 0 until stopped
+    PWM_SEQ_CH_SEQ_STEP     Step playing, bit 31 while the sequence runs (read-only)
+    """
+    step_width = seq_depth.bit_length() - 1
+
+    # Addresses of registers in block (in units of 4 bytes)
+    period_addr = bank_base + PWM_SEQ_CH_PERIOD
+    duty_addr = bank_base + PWM_SEQ_CH_DUTY
+    seq_len_addr = bank_base + PWM_SEQ_CH_SEQ_LEN
+    seq_loops_addr = bank_base + PWM_SEQ_CH_SEQ_LOOPS
+    seq_step_addr = bank_base + PWM_SEQ_CH_SEQ_STEP
+    rdata = Signal(intbv(0)[32:])
+    period = Signal(intbv(0)[PL_PWM_WIDTH:])
+    duty = Signal(intbv(0)[PL_PWM_WIDTH:])
+    seq_len = Signal(intbv(0)[step_width + 1:])
+    seq_loops = Signal(intbv(0)[PL_REG_WIDTH:])
+
+    # User defined signals and variables
+    # Step memory
+    mem = [Signal(intbv(0)[PL_DATA_WIDTH:]) for _ in range(seq_depth)]
+    # Period counter, its last cycle, and the duty of the period counted
+    counter = Signal(intbv(0)[PL_PWM_WIDTH:])
+    boundary = Signal(LOW)
+    active_duty = Signal(intbv(0)[PL_PWM_WIDTH:])
+    # Sequencer: step playing, periods it has played, passes done
+    running = Signal(LOW)
+    step = Signal(intbv(0)[step_width:])
+    hold = Signal(intbv(0)[PL_HOLD_WIDTH:])
+    loops = Signal(modbv(0)[PL_REG_WIDTH:])
+    entry = Signal(intbv(0)[PL_DATA_WIDTH:])
+    seq_step = ConcatSignal(running, intbv(0)[PL_DATA_WIDTH - 1 - step_width:], step)
+
+    # AxiLocal pass through logic
+    if axi_m is not None:
+
+        @always_comb
+        def axi_passthrough():
+            axi_m.raddr.next = axi_s.raddr
+            axi_m.waddr.next = axi_s.waddr
+            axi_m.wdata.next = axi_s.wdata
+            axi_m.wstrobe.next = axi_s.wstrobe
+            axi_m.wen.next = axi_s.wen
+            axi_s.rdata.next = axi_m.rdata | rdata
+
+    else:
+
+        @always_comb
+        def axi_passthrough():
+            axi_s.rdata.next = rdata
+
+    @always_comb
+    def register_read():
+        # Read access of registers
+        rdata.next = 0
+        if axi_s.raddr == period_addr:
+            rdata.next = period
+        elif axi_s.raddr == duty_addr:
+            rdata.next = duty
+        elif axi_s.raddr == seq_len_addr:
+            rdata.next = seq_len
+        elif axi_s.raddr == seq_loops_addr:
+            rdata.next = seq_loops
+        elif axi_s.raddr == seq_step_addr:
+            rdata.next = seq_step
+
+    period_write_decode = Signal(LOW)
+
+    @always_comb
+    def period_write_decoder():
+        period_write_decode.next = axi_s.wen and axi_s.waddr == period_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def period_write():
+        if period_write_decode:
+            for byte_index in range((PL_PWM_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(period):
+                            period.next[bit] = axi_s.wdata[bit]
+
+    duty_write_decode = Signal(LOW)
+
+    @always_comb
+    def duty_write_decoder():
+        duty_write_decode.next = axi_s.wen and axi_s.waddr == duty_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def duty_write():
+        if duty_write_decode:
+            for byte_index in range((PL_PWM_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(duty):
+                            duty.next[bit] = axi_s.wdata[bit]
+
+    seq_len_write_decode = Signal(LOW)
+
+    @always_comb
+    def seq_len_write_decoder():
+        seq_len_write_decode.next = axi_s.wen and axi_s.waddr == seq_len_addr
+
+    # Values above seq_depth are cut to its width, like any other register
+    @always_seq(clk.posedge, reset=resetn)
+    def seq_len_write():
+        if seq_len_write_decode:
+            for byte_index in range((step_width + 1 + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(seq_len):
+                            seq_len.next[bit] = axi_s.wdata[bit]
+
+    seq_loops_write_decode = Signal(LOW)
+
+    @always_comb
+    def seq_loops_write_decoder():
+        seq_loops_write_decode.next = axi_s.wen and axi_s.waddr == seq_loops_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def seq_loops_write():
+        if seq_loops_write_decode:
+            for byte_index in range((PL_REG_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(seq_loops):
+                            seq_loops.next[bit] = axi_s.wdata[bit]
+
+    @always(clk.posedge)
+    def mem_write():
+        if seq_we:
+            mem[seq_waddr].next = seq_wdata
+
+    @always_comb
+    def step_read():
+        entry.next = mem[step]
+
+    @always_comb
+    def boundary_decoder():
+        boundary.next = period != 0 and counter >= period - 1
+
+    @always_seq(clk.posedge, reset=resetn)
+    def handle_counter():
+        if boundary or period == 0:
+            counter.next = 0
+        else:
+            counter.next = counter + 1
+
+    # The duty of the next period is chosen in the last cycle of this one. A
+    # SEQ_LEN write restarts the sequence and wins over a period boundary
+    @always_seq(clk.posedge, reset=resetn)
+    def handle_sequencer():
+        isr_set.next = LOW
+        if seq_len_write_decode:
+            running.next = axi_s.wdata[step_width + 1:] != 0
+            step.next = 0
+            hold.next = 0
+            loops.next = 0
+        elif boundary:
+            if running:
+                active_duty.next = entry[PL_PWM_WIDTH:]
+                if hold < entry[PWM_SEQ_STEP_HOLD_SHIFT + PL_HOLD_WIDTH:PWM_SEQ_STEP_HOLD_SHIFT]:
+                    hold.next = hold + 1
+                else:
+                    hold.next = 0
+                    if step + 1 < seq_len:
+                        step.next = step + 1
+                    else:
+                        step.next = 0
+                        loops.next = loops + 1
+                        if seq_loops != 0 and loops + 1 >= seq_loops:
+                            running.next = LOW
+                            isr_set.next = HIGH
+            else:
+                active_duty.next = duty
+
+    @always_comb
+    def assign_pwm_out():
+        pwm_out.next = period != 0 and counter < active_duty
+
+    return instances()
+
+
+@block
+def pwm_seq(clk, resetn, axi_s, axi_m, gpio_in, pwm_o, interrupt_out, map_base,
+            seq_depth=PL_SEQ_DEPTH):
+    """
+    Parameters:
+    clk             Clock
+    resetn          Reset
+    axi_s           Connection to upstream blocks
+    axi_m           Connection to downstream blocks
+    gpio_in         Pin values while CTRL.ENABLE is clear
+    pwm_o           Output pins; its width (1 to PWM_SEQ_MAX_CHANNELS) is the
+                      channel count
+    interrupt_out   Goes high if a bit is set in both ISR and IER
+    map_base        Base address
+    seq_depth       Steps per channel, a power of two from 2
+
+    Registers:
+    PWM_SEQ_CTRL        Control register
+    PWM_SEQ_ISR         Interrupt status register, bit n: sequence of channel n done
+    PWM_SEQ_IER         Interrupt enable register, bit n enables ISR bit n
+    PWM_SEQ_CHANNELS    Number of channels (read-only)
+    PWM_SEQ_SEQ_DEPTH   Steps per channel (read-only)
+    PWM_SEQ_SEQ_ADDR    Step written by SEQ_DATA: channel * SEQ_DEPTH + step
+    PWM_SEQ_SEQ_DATA    Write-only, stores a step at SEQ_ADDR and increments it
+    pwm_seq_bank(n) + PWM_SEQ_CH_*  Registers of channel n (pwm_seq_channel)
+
+    Fields in PWM_SEQ_CTRL:
+    PWM_SEQ_CTRL_ENABLE Drive the pins from the channels instead of gpio_in
+    """
+    num_channels = len(pwm_o)
+    if num_channels < 1 or num_channels > PWM_SEQ_MAX_CHANNELS:
+        raise ValueError("pwm_seq supports 1 to %d channels" % PWM_SEQ_MAX_CHANNELS)
+    if seq_depth < 2 or seq_depth & (seq_depth - 1):
+        raise ValueError("pwm_seq sequence depth must be a power of two from 2")
+    step_width = seq_depth.bit_length() - 1
+    # SEQ_ADDR: channel above the step, room for every channel of the largest
+    # variant so the layout does not depend on the build
+    seq_addr_width = step_width + (PWM_SEQ_MAX_CHANNELS - 1).bit_length()
+
+    # Addresses of registers in block (in units of 4 bytes)
+    pwm_seq_ctrl_addr = map_base + PWM_SEQ_CTRL
+    pwm_seq_isr_addr = map_base + PWM_SEQ_ISR
+    pwm_seq_ier_addr = map_base + PWM_SEQ_IER
+    pwm_seq_channels_addr = map_base + PWM_SEQ_CHANNELS
+    pwm_seq_seq_depth_addr = map_base + PWM_SEQ_SEQ_DEPTH
+    pwm_seq_seq_addr_addr = map_base + PWM_SEQ_SEQ_ADDR
+    pwm_seq_seq_data_addr = map_base + PWM_SEQ_SEQ_DATA
+    rdata = Signal(intbv(0)[32:])
+    ctrl = Signal(intbv(0)[PWM_SEQ_CTRL_ENABLE_W:])
+    isr = Signal(intbv(0)[num_channels:])
+    ier = Signal(intbv(0)[num_channels:])
+    seq_addr = Signal(modbv(0)[seq_addr_width:])
+
+    # User defined signals and variables
+    ctrl_enable = Signal(LOW)
+    # Step write of SEQ_DATA, to the channel selected by SEQ_ADDR
+    seq_data_write_decode = Signal(LOW)
+    seq_we_bits = [Signal(LOW) for _ in range(num_channels)]
+    seq_waddr = Signal(intbv(0)[step_width:])
+    seq_wdata = Signal(intbv(0)[PL_DATA_WIDTH:])
+    # Outputs of the channels and ISR bits set by them
+    pwm_bits = [Signal(LOW) for _ in range(num_channels)]
+    pwm = ConcatSignal(*reversed(pwm_bits))
+    isr_set_bits = [Signal(LOW) for _ in range(num_channels)]
+    isr_set = ConcatSignal(*reversed(isr_set_bits))
+
+    # AxiLocal daisy-chain: this block, then channel 0 to channel N-1
+    axi_chain = [AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH) for _ in range(num_channels)]
+    axi_c = axi_chain[0]
+
+    @always_comb
+    def axi_passthrough():
+        axi_c.raddr.next = axi_s.raddr
+        axi_c.waddr.next = axi_s.waddr
+        axi_c.wdata.next = axi_s.wdata
+        axi_c.wstrobe.next = axi_s.wstrobe
+        axi_c.wen.next = axi_s.wen
+        axi_s.rdata.next = axi_c.rdata | rdata
+
+    channel_insts = []
+    for channel in range(num_channels):
+        channel_insts.append(
+            pwm_seq_channel(
+                clk=clk,
+                resetn=resetn,
+                axi_s=axi_chain[channel],
+                axi_m=axi_chain[channel + 1] if channel + 1 < num_channels else axi_m,
+                seq_we=seq_we_bits[channel],
+                seq_waddr=seq_waddr,
+                seq_wdata=seq_wdata,
+                pwm_out=pwm_bits[channel],
+                isr_set=isr_set_bits[channel],
+                bank_base=map_base + pwm_seq_bank(channel),
+                seq_depth=seq_depth,
+            )
+        )
+
+    @always_comb
+    def register_read():
+        # Read access of registers
+        rdata.next = 0
+        if axi_s.raddr == pwm_seq_ctrl_addr:
+            rdata.next = ctrl
+        elif axi_s.raddr == pwm_seq_isr_addr:
+            rdata.next = isr
+        elif axi_s.raddr == pwm_seq_ier_addr:
+            rdata.next = ier
+        elif axi_s.raddr == pwm_seq_channels_addr:
+            rdata.next = num_channels
+        elif axi_s.raddr == pwm_seq_seq_depth_addr:
+            rdata.next = seq_depth
+        elif axi_s.raddr == pwm_seq_seq_addr_addr:
+            rdata.next = seq_addr
+
+    ctrl_write_decode = Signal(LOW)
+
+    @always_comb
+    def ctrl_write_decoder():
+        ctrl_write_decode.next = axi_s.wen and axi_s.waddr == pwm_seq_ctrl_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def ctrl_write():
+        if ctrl_write_decode:
+            for byte_index in range((8 + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(ctrl):
+                            ctrl.next[bit] = axi_s.wdata[bit]
+
+    @always_comb
+    def ctrl_decoder():
+        ctrl_enable.next = ctrl[PWM_SEQ_CTRL_ENABLE_B]
+
+    isr_write_decode = Signal(LOW)
+
+    @always_comb
+    def isr_write_decoder():
+        isr_write_decode.next = axi_s.wen and axi_s.waddr == pwm_seq_isr_addr
+
+    # A channel setting its bit wins over software clearing it in the same cycle
+    @always_seq(clk.posedge, reset=resetn)
+    def isr_write():
+        for bit in range(num_channels):
+            if isr_write_decode and axi_s.wstrobe[bit // 8] and axi_s.wdata[bit]:
+                isr.next[bit] = LOW
+            if isr_set[bit]:
+                isr.next[bit] = HIGH
+
+    ier_write_decode = Signal(LOW)
+
+    @always_comb
+    def ier_write_decoder():
+        ier_write_decode.next = axi_s.wen and axi_s.waddr == pwm_seq_ier_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def ier_write():
+        if ier_write_decode:
+            for byte_index in range((num_channels + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(ier):
+                            ier.next[bit] = axi_s.wdata[bit]
+
+    seq_addr_write_decode = Signal(LOW)
+
+    @always_comb
+    def seq_addr_write_decoder():
+        seq_addr_write_decode.next = axi_s.wen and axi_s.waddr == pwm_seq_seq_addr_addr
+
+    @always_comb
+    def seq_data_write_decoder():
+        seq_data_write_decode.next = axi_s.wen and axi_s.waddr == pwm_seq_seq_data_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def seq_addr_write():
+        if seq_addr_write_decode:
+            for byte_index in range((seq_addr_width + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(seq_addr):
+                            seq_addr.next[bit] = axi_s.wdata[bit]
+        elif seq_data_write_decode:
+            seq_addr.next = seq_addr + 1
+
+    # SEQ_ADDR of a channel the build does not have drops the step
+    @always_comb
+    def seq_step_write():
+        seq_waddr.next = seq_addr[step_width:]
+        seq_wdata.next = axi_s.wdata
+        for channel in range(num_channels):
+            seq_we_bits[channel].next = (
+                seq_data_write_decode and seq_addr[seq_addr_width:step_width] == channel
+            )
+
+    @always_comb
+    def assign_pwm_o():
+        if ctrl_enable:
+            pwm_o.next = pwm
+        else:
+            pwm_o.next = gpio_in
+
+    @always_comb
+    def assign_interrupt_out():
+        interrupt_out.next = (isr & ier) != 0
+
+    return instances()
+
+
+if __name__ == "__main__":
+    # Define signals for block ports
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    axi_s = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    axi_m = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    gpio_in = Signal(intbv(0)[2:])
+    pwm_o = Signal(intbv(0)[2:])
+    interrupt_out = Signal(LOW)
+    map_base = 0
+
+    pwm_seq(clk=clk, resetn=resetn, axi_s=axi_s, axi_m=axi_m, gpio_in=gpio_in,
+            pwm_o=pwm_o, interrupt_out=interrupt_out, map_base=map_base).convert(hdl='Verilog')
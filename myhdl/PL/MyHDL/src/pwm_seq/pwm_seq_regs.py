@@ -0,0 +1,59 @@
+#!/usr/bin/python
+#
+# FILE:
+#   pwm_seq_regs.py
+#
+# DESCRIPTION:
+#   Register map of pwm_seq (myhdl/PL/MyHDL/src/pwm_seq/pwm_seq.py),
+#   GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py,
+#   do not edit. PWM_SEQ_<REG> is the 32-bit register index,
+#   PWM_SEQ_<REG>_OFFSET the byte offset.
+#
+
+PWM_SEQ_MAX_CHANNELS = 8  # Channels of the largest variant
+PWM_SEQ_STEP_DUTY_MASK = 0xFFFFFF  # Sequence entry: high clocks of the period
+PWM_SEQ_STEP_HOLD_SHIFT = 24  # Sequence entry: periods the step lasts, minus 1
+
+# Register indices
+PWM_SEQ_CTRL = 0
+PWM_SEQ_ISR = 1  # Bit n: sequence of channel n done, write 1 to clear
+PWM_SEQ_IER = 2
+PWM_SEQ_CHANNELS = 3  # Number of channels
+PWM_SEQ_SEQ_DEPTH = 4  # Sequence entries per channel
+PWM_SEQ_SEQ_ADDR = 5  # Entry SEQ_DATA writes: channel * SEQ_DEPTH + step
+PWM_SEQ_SEQ_DATA = 6  # Write an entry at SEQ_ADDR, which then increments
+PWM_SEQ_CHANNEL_BASE = 16
+PWM_SEQ_CHANNEL_STRIDE = 8
+# Register byte offsets
+PWM_SEQ_CTRL_OFFSET = 0x00
+PWM_SEQ_ISR_OFFSET = 0x04
+PWM_SEQ_IER_OFFSET = 0x08
+PWM_SEQ_CHANNELS_OFFSET = 0x0C
+PWM_SEQ_SEQ_DEPTH_OFFSET = 0x10
+PWM_SEQ_SEQ_ADDR_OFFSET = 0x14
+PWM_SEQ_SEQ_DATA_OFFSET = 0x18
+# Register indices within a channel bank
+PWM_SEQ_CH_PERIOD = 0  # PL clocks per PWM period, 0 holds the pin low
+PWM_SEQ_CH_DUTY = 1  # High clocks per period without a sequence
+PWM_SEQ_CH_SEQ_LEN = 2  # Steps of the sequence; a write restarts it, 0 stops it
+PWM_SEQ_CH_SEQ_LOOPS = 3  # Passes of the sequence, 0: until stopped
+PWM_SEQ_CH_SEQ_STEP = 4  # Step playing, bit 31 while the sequence runs
+# Register byte offsets within a channel bank
+PWM_SEQ_CH_PERIOD_OFFSET = 0x00
+PWM_SEQ_CH_DUTY_OFFSET = 0x04
+PWM_SEQ_CH_SEQ_LEN_OFFSET = 0x08
+PWM_SEQ_CH_SEQ_LOOPS_OFFSET = 0x0C
+PWM_SEQ_CH_SEQ_STEP_OFFSET = 0x10
+# Register bit fields
+PWM_SEQ_CTRL_ENABLE_B = 0
+PWM_SEQ_CTRL_ENABLE_W = 1
+
+
+def pwm_seq_bank(channel):
+    """Register index of the bank of channel (0-based)"""
+    return PWM_SEQ_CHANNEL_BASE + channel * PWM_SEQ_CHANNEL_STRIDE
+
+
+def pwm_seq_bank_offset(channel):
+    """Byte offset of the bank of channel (0-based)"""
+    return 4 * pwm_seq_bank(channel)
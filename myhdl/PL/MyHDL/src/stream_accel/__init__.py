@@ -0,0 +1 @@
+# Streaming accelerator template package
@@ -0,0 +1,246 @@
+#!/usr/bin/python
+#
+# FILE:
+#   stream_accel.py
+#
+#
+
+# * Template for a streaming accelerator: samples come in on an AXI4-Stream
+#    slave port (normally an AXI DMA MM2S), go through one registered
+#    processing stage and leave on an AXI4-Stream master port (the S2MM side
+#    of the same DMA), one sample per clock while the sink is ready.
+# * The input goes through a skid buffer and the output is the register of
+#    the processing stage, so TREADY towards the source and TVALID/TDATA/TLAST
+#    towards the sink all come from registers. TLAST passes through with its
+#    sample, which ends the S2MM transfer.
+# * The processing here is out = (in ^ XOR) + ADD while the ENABLE bit in the
+#    control register is set, and out = in otherwise. Replace process_sample
+#    with the real operation (up to 32 bits wide); deeper pipelines add a valid
+#    bit per stage that moves on the same stage_advance condition.
+# * BEATS and PACKETS count the samples and TLASTs handed to the sink; writing
+#    a 1 to the CLEAR bit of the control register zeroes them.
+
+
+
+from myhdl import (
+    always_comb,
+    always_seq,
+    block,
+    instances,
+    intbv,
+    modbv,
+    ResetSignal,
+    Signal,
+)
+from PL.MyHDL.src.interfaces.axi_local import AxiLocal
+from PL.MyHDL.src.interfaces.axi_stream import AxiStream
+from PL.MyHDL.src.axi_support.axis_support import axis_skid_buffer
+# Register indices and bit fields: generated from
+# build_utils/regmap/kr260_regmap.py, like the C and C++ headers
+from PL.MyHDL.src.stream_accel.stream_accel_regs import *  # noqa: F401,F403
+
+PL_ADDR_WIDTH = 12
+PL_DATA_WIDTH = 32
+PL_REG_WIDTH = 32
+
+LOW, HIGH = bool(0), bool(1)
+
+
+@block
+def stream_accel(clk, resetn, axi_s, axi_m, s_axis, m_axis, map_base):
+    """
+    Parameters:
+    clk         Clock
+    resetn      Reset
+    axi_s       Connection to upstream blocks
+    axi_m       Connection to downstream blocks
+    s_axis      AXI4-Stream of input samples
+    m_axis      AXI4-Stream of output samples, same width as s_axis
+    map_base    Base address
+
+    Registers:
+    STREAM_ACCEL_CTRL       Control register
+    STREAM_ACCEL_XOR        Mask XORed into each sample
+    STREAM_ACCEL_ADD        Value added to each sample after the XOR
+    STREAM_ACCEL_BEATS      Read-only number of samples output
+    STREAM_ACCEL_PACKETS    Read-only number of samples output with TLAST
+
+    Fields in STREAM_ACCEL_CTRL:
+    STREAM_ACCEL_CTRL_ENABLE    Process the samples, pass them unchanged while clear
+    STREAM_ACCEL_CTRL_CLEAR     Writing a 1 zeroes BEATS and PACKETS, reads as 0
+    """
+    # Addresses of registers in block (in units of 4 bytes)
+    stream_accel_ctrl_addr = map_base + STREAM_ACCEL_CTRL
+    stream_accel_xor_addr = map_base + STREAM_ACCEL_XOR
+    stream_accel_add_addr = map_base + STREAM_ACCEL_ADD
+    stream_accel_beats_addr = map_base + STREAM_ACCEL_BEATS
+    stream_accel_packets_addr = map_base + STREAM_ACCEL_PACKETS
+    rdata = Signal(intbv(0)[32:])
+    ctrl = Signal(intbv(0)[8:])
+    xor_mask = Signal(intbv(0)[PL_REG_WIDTH:])
+    add_value = Signal(intbv(0)[PL_REG_WIDTH:])
+    beats = Signal(modbv(0)[PL_REG_WIDTH:])
+    packets = Signal(modbv(0)[PL_REG_WIDTH:])
+    counter_clear = Signal(LOW)
+
+    # Unpacking ctrl register
+
+    ctrl_enable = Signal(LOW)
+
+    @always_comb
+    def unpack_ctrl():
+        ctrl_enable.next = ctrl[STREAM_ACCEL_CTRL_ENABLE_B]
+
+    # User defined signals and variables
+    stream_width = len(s_axis.tdata)
+    # Input behind the skid buffer
+    in_axis = AxiStream(stream_width)
+    # Processing stage register, drives m_axis
+    stage_valid = Signal(LOW)
+    stage_data = Signal(modbv(0)[stream_width:])
+    stage_last = Signal(LOW)
+    stage_advance = Signal(LOW)
+    sample = Signal(modbv(0)[stream_width:])
+    output_take = Signal(LOW)
+
+    input_skid = axis_skid_buffer(clk, resetn, s_axis, in_axis)
+
+    # AxiLocal pass through logic
+    if axi_m is not None:
+
+        @always_comb
+        def axi_passthrough():
+            axi_m.raddr.next = axi_s.raddr
+            axi_m.waddr.next = axi_s.waddr
+            axi_m.wdata.next = axi_s.wdata
+            axi_m.wstrobe.next = axi_s.wstrobe
+            axi_m.wen.next = axi_s.wen
+            axi_s.rdata.next = axi_m.rdata | rdata
+
+    else:
+
+        @always_comb
+        def axi_passthrough():
+            axi_s.rdata.next = rdata
+
+    @always_comb
+    def register_read():
+        # Read access of registers
+        rdata.next = 0
+        if axi_s.raddr == stream_accel_ctrl_addr:
+            rdata.next = ctrl
+        elif axi_s.raddr == stream_accel_xor_addr:
+            rdata.next = xor_mask
+        elif axi_s.raddr == stream_accel_add_addr:
+            rdata.next = add_value
+        elif axi_s.raddr == stream_accel_beats_addr:
+            rdata.next = beats
+        elif axi_s.raddr == stream_accel_packets_addr:
+            rdata.next = packets
+
+    ctrl_write_decode = Signal(LOW)
+
+    @always_comb
+    def ctrl_write_decoder():
+        ctrl_write_decode.next = axi_s.wen and axi_s.waddr == stream_accel_ctrl_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def ctrl_write():
+        # CLEAR is a strobe: it is never stored
+        counter_clear.next = LOW
+        if ctrl_write_decode:
+            for byte_index in range((8 + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit == STREAM_ACCEL_CTRL_CLEAR_B:
+                            counter_clear.next = axi_s.wdata[bit]
+                        elif bit < len(ctrl):
+                            ctrl.next[bit] = axi_s.wdata[bit]
+
+    xor_write_decode = Signal(LOW)
+
+    @always_comb
+    def xor_write_decoder():
+        xor_write_decode.next = axi_s.wen and axi_s.waddr == stream_accel_xor_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def xor_write():
+        if xor_write_decode:
+            for byte_index in range((PL_REG_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(xor_mask):
+                            xor_mask.next[bit] = axi_s.wdata[bit]
+
+    add_write_decode = Signal(LOW)
+
+    @always_comb
+    def add_write_decoder():
+        add_write_decode.next = axi_s.wen and axi_s.waddr == stream_accel_add_addr
+
+    @always_seq(clk.posedge, reset=resetn)
+    def add_write():
+        if add_write_decode:
+            for byte_index in range((PL_REG_WIDTH + 7) // 8):
+                if axi_s.wstrobe[byte_index]:
+                    for bit_index in range(8):
+                        bit = 8 * byte_index + bit_index
+                        if bit < len(add_value):
+                            add_value.next[bit] = axi_s.wdata[bit]
+
+    @always_comb
+    def process_sample():
+        # The operation of the accelerator, on the sample in front of the stage
+        if ctrl_enable:
+            sample.next = (in_axis.tdata ^ xor_mask[stream_width:]) + add_value[stream_width:]
+        else:
+            sample.next = in_axis.tdata
+
+    @always_comb
+    def stage_handshake():
+        # The stage takes a sample when it is empty or its sample leaves
+        stage_advance.next = (not stage_valid) or m_axis.tready
+        output_take.next = stage_valid and m_axis.tready
+
+    @always_seq(clk.posedge, reset=resetn)
+    def stage_register():
+        if stage_advance:
+            stage_valid.next = in_axis.tvalid
+            if in_axis.tvalid:
+                stage_data.next = sample
+                stage_last.next = in_axis.tlast
+
+    @always_seq(clk.posedge, reset=resetn)
+    def count_output():
+        if counter_clear:
+            beats.next = 0
+            packets.next = 0
+        elif output_take:
+            beats.next = beats + 1
+            if stage_last:
+                packets.next = packets + 1
+
+    @always_comb
+    def assign_m_axis():
+        in_axis.tready.next = stage_advance
+        m_axis.tvalid.next = stage_valid
+        m_axis.tdata.next = stage_data
+        m_axis.tlast.next = stage_last
+
+    return instances()
+
+
+if __name__ == "__main__":
+    # Define signals for block ports
+    clk = Signal(LOW)
+    resetn = ResetSignal(0, active=0, isasync=True)
+    axi_s = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    axi_m = AxiLocal(PL_ADDR_WIDTH, PL_DATA_WIDTH)
+    s_axis = AxiStream(PL_DATA_WIDTH)
+    m_axis = AxiStream(PL_DATA_WIDTH)
+    map_base = 0
+
+    stream_accel(clk=clk, resetn=resetn, axi_s=axi_s, axi_m=axi_m, s_axis=s_axis,
+                 m_axis=m_axis, map_base=map_base).convert(hdl='Verilog')
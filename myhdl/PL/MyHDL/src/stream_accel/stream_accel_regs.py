@@ -0,0 +1,29 @@
+#!/usr/bin/python
+#
+# FILE:
+#   stream_accel_regs.py
+#
+# DESCRIPTION:
+#   Register map of stream_accel (myhdl/PL/MyHDL/src/stream_accel/stream_accel.py),
+#   GENERATED by build_utils/regmap/regmap_gen.py from kr260_regmap.py,
+#   do not edit. STREAM_ACCEL_<REG> is the 32-bit register index,
+#   STREAM_ACCEL_<REG>_OFFSET the byte offset.
+#
+
+# Register indices
+STREAM_ACCEL_CTRL = 0
+STREAM_ACCEL_XOR = 1  # out = (in ^ XOR) + ADD while ENABLE is set
+STREAM_ACCEL_ADD = 2
+STREAM_ACCEL_BEATS = 3  # Samples handed to the sink
+STREAM_ACCEL_PACKETS = 4  # TLASTs handed to the sink
+# Register byte offsets
+STREAM_ACCEL_CTRL_OFFSET = 0x00
+STREAM_ACCEL_XOR_OFFSET = 0x04
+STREAM_ACCEL_ADD_OFFSET = 0x08
+STREAM_ACCEL_BEATS_OFFSET = 0x0C
+STREAM_ACCEL_PACKETS_OFFSET = 0x10
+# Register bit fields
+STREAM_ACCEL_CTRL_ENABLE_B = 0
+STREAM_ACCEL_CTRL_ENABLE_W = 1
+STREAM_ACCEL_CTRL_CLEAR_B = 1
+STREAM_ACCEL_CTRL_CLEAR_W = 1
@@ -0,0 +1 @@
+# Streaming accelerator IP package
@@ -0,0 +1,24 @@
+# Lean crossbar variant of the interrupt_demo block design
+#
+# Replaces the SmartConnect between the PS (M_AXI_HPM0_FPD and HPM1_FPD) and
+# the interrupt generator and AXI INTC with an AXI Interconnect in its
+# shared-address, shared-data mode, without register slices
+# (build_utils/axi_xbar.tcl): fewer PL clocks per single-beat register
+# access. Masters, slaves and the address map stay as they are.
+#
+# Usage, from myhdl/PL/interrupt_demo:
+#   vivado -mode batch -source axi_xbar_bd.tcl
+# The variant goes into a copy of the project (build_utils/bd_variant.tcl),
+# build/variant/interrupt_demo/interrupt_demo.xpr; build that one as usual.
+
+set script_dir [file dirname [file normalize [info script]]]
+set project_file "$script_dir/interrupt_demo/interrupt_demo.xpr"
+source [file normalize "$script_dir/../../../build_utils/bd_variant.tcl"]
+source [file normalize "$script_dir/../../../build_utils/axi_xbar.tcl"]
+
+open_bd_variant $project_file interrupt_demo.bd
+
+replace_smartconnect axi_smc axi_xbar
+
+save_bd_variant
+puts "interrupt_demo.bd: lean crossbar variant (axi_xbar in place of axi_smc)"